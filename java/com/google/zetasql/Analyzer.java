@@ -70,6 +70,37 @@ public class Analyzer implements Serializable {
         catalog, fileDescriptorSetsBuilder, response);
   }
 
+  public StatementSummary analyzeStatementSummary(String sql) {
+    return analyzeStatementSummary(sql, options, catalog);
+  }
+
+  /**
+   * Analyzes a statement like {@link #analyzeStatement}, but returns only its statement-level
+   * information, such as the output columns and the referenced tables. This avoids serializing and
+   * deserializing the full ResolvedStatement tree, which dominates the cost of analyzing large
+   * statements for callers that do not need the tree.
+   */
+  public static StatementSummary analyzeStatementSummary(
+      String sql, AnalyzerOptions options, SimpleCatalog catalog) {
+    AnalyzeRequest.Builder request =
+        AnalyzeRequest.newBuilder().setSqlStatement(sql).setStatementSummaryOnly(true);
+
+    FileDescriptorSetsBuilder fileDescriptorSetsBuilder =
+        AnalyzerHelper.serializeSimpleCatalog(catalog, options, request);
+
+    AnalyzeResponse response;
+    try {
+      response = Client.getStub().analyze(request.build());
+    } catch (StatusRuntimeException e) {
+      throw new SqlException(e);
+    }
+
+    return StatementSummary.deserialize(
+        response.getStatementSummary(),
+        catalog.getTypeFactory(),
+        fileDescriptorSetsBuilder.getDescriptorPools());
+  }
+
   public static ResolvedExpr analyzeExpression(
       String expression, AnalyzerOptions options, SimpleCatalog catalog) {
     AnalyzeRequest.Builder request = AnalyzeRequest.newBuilder().setSqlExpression(expression);
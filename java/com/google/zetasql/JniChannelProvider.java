@@ -18,9 +18,17 @@
 package com.google.zetasql;
 
 import com.google.auto.service.AutoService;
+import com.google.protobuf.CodedOutputStream;
+import com.google.protobuf.InvalidProtocolBufferException;
+import com.google.protobuf.MessageLite;
+import com.google.zetasql.LocalService.EvaluateQueryRequest;
+import com.google.zetasql.LocalService.EvaluateQueryResponse;
+import com.google.zetasql.LocalService.EvaluateRequest;
+import com.google.zetasql.LocalService.EvaluateResponse;
 import io.grpc.Channel;
 import io.grpc.LoadBalancerProvider;
 import io.grpc.LoadBalancerRegistry;
+import io.grpc.Status;
 import io.grpc.netty.NettyChannelBuilder;
 import io.netty.channel.ChannelException;
 import io.netty.channel.nio.NioEventLoopGroup;
@@ -29,6 +37,7 @@ import io.netty.util.concurrent.DefaultThreadFactory;
 import java.io.IOException;
 import java.net.InetSocketAddress;
 import java.net.SocketAddress;
+import java.nio.ByteBuffer;
 import java.nio.channels.SocketChannel;
 
 /** Controller class of the ZetaSQL JniChannelProvider. */
@@ -83,6 +92,80 @@ public class JniChannelProvider implements ClientChannelProvider {
   /** Returns a SocketChannel connected to the server. */
   private static native SocketChannel getSocketChannel() throws IOException;
 
+  /**
+   * Evaluates the serialized EvaluateRequest in the first {@code size} bytes of the direct {@code
+   * request} buffer in process, without gRPC, and returns the serialized EvaluateResponse.
+   */
+  private static native byte[] evaluateDirect(ByteBuffer request, int size);
+
+  /** Like {@link #evaluateDirect}, for an EvaluateQueryRequest. */
+  private static native byte[] evaluateQueryDirect(ByteBuffer request, int size);
+
+  /** Thrown by the direct calls for a failed call, with the canonical status code. */
+  static final class DirectCallException extends RuntimeException {
+    private final int code;
+
+    DirectCallException(int code, String message) {
+      super(message);
+      this.code = code;
+    }
+
+    int getCode() {
+      return code;
+    }
+  }
+
+  // Per thread, so that the direct buffer is only reallocated when a request is larger than all
+  // previous ones of the thread.
+  private static final ThreadLocal<ByteBuffer> requestBuffer =
+      ThreadLocal.withInitial(() -> ByteBuffer.allocateDirect(4096));
+
+  private static ByteBuffer serializeToRequestBuffer(MessageLite request) {
+    int size = request.getSerializedSize();
+    ByteBuffer buffer = requestBuffer.get();
+    if (buffer.capacity() < size) {
+      buffer = ByteBuffer.allocateDirect(Math.max(size, 2 * buffer.capacity()));
+      requestBuffer.set(buffer);
+    }
+    buffer.clear();
+    try {
+      CodedOutputStream output = CodedOutputStream.newInstance(buffer);
+      request.writeTo(output);
+      output.flush();
+    } catch (IOException e) {
+      throw new IllegalStateException(e);
+    }
+    return buffer;
+  }
+
+  /**
+   * Calls Evaluate of the in-process server directly, bypassing gRPC and the socket. Shares the
+   * prepared expressions and registered catalogs of the channels. Failures are thrown as
+   * StatusRuntimeExceptions, as by the gRPC stubs.
+   */
+  public static EvaluateResponse evaluate(EvaluateRequest request) {
+    try {
+      return EvaluateResponse.parseFrom(
+          evaluateDirect(serializeToRequestBuffer(request), request.getSerializedSize()));
+    } catch (DirectCallException e) {
+      throw Status.fromCodeValue(e.getCode()).withDescription(e.getMessage()).asRuntimeException();
+    } catch (InvalidProtocolBufferException e) {
+      throw new IllegalStateException(e);
+    }
+  }
+
+  /** Like {@link #evaluate}, for EvaluateQuery. */
+  public static EvaluateQueryResponse evaluateQuery(EvaluateQueryRequest request) {
+    try {
+      return EvaluateQueryResponse.parseFrom(
+          evaluateQueryDirect(serializeToRequestBuffer(request), request.getSerializedSize()));
+    } catch (DirectCallException e) {
+      throw Status.fromCodeValue(e.getCode()).withDescription(e.getMessage()).asRuntimeException();
+    } catch (InvalidProtocolBufferException e) {
+      throw new IllegalStateException(e);
+    }
+  }
+
   /** Wraps one end of a socketpair for NioSocketChannel. */
   protected static class SocketPairChannel extends NioSocketChannel {
 
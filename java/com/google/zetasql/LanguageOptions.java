@@ -62,6 +62,10 @@ public class LanguageOptions implements Serializable {
 
   private transient LanguageOptionsProto.Builder builder = LanguageOptionsProto.newBuilder();
 
+  // The result of serialize(), reused until the options change, since the options are serialized
+  // into every request that uses them. Cleared by mutableBuilder().
+  private transient LanguageOptionsProto serialized = null;
+
   public LanguageOptions() {
     this(getDefaultFeatures());
   }
@@ -79,12 +83,21 @@ public class LanguageOptions implements Serializable {
   }
 
   protected void assign(LanguageOptions options) {
-    builder.clear();
-    builder.mergeFrom(options.builder.build());
+    mutableBuilder().clear();
+    builder.mergeFrom(options.serialize());
   }
 
   public LanguageOptionsProto serialize() {
-    return builder.build();
+    if (serialized == null) {
+      serialized = builder.build();
+    }
+    return serialized;
+  }
+
+  /** Returns {@link #builder} for modification, discarding the cached serialized proto. */
+  private LanguageOptionsProto.Builder mutableBuilder() {
+    serialized = null;
+    return builder;
   }
 
   public boolean supportsStatementKind(ResolvedNodeKind kind) {
@@ -100,14 +113,14 @@ public class LanguageOptions implements Serializable {
   }
 
   public void setSupportedStatementKinds(Set<ResolvedNodeKind> supportedStatementKinds) {
-    builder.clearSupportedStatementKinds();
+    mutableBuilder().clearSupportedStatementKinds();
     for (ResolvedNodeKind kind : supportedStatementKinds) {
-      builder.addSupportedStatementKinds(kind);
+      mutableBuilder().addSupportedStatementKinds(kind);
     }
   }
 
   public void setSupportsAllStatementKinds() {
-    builder.clearSupportedStatementKinds();
+    mutableBuilder().clearSupportedStatementKinds();
   }
 
   public void setLanguageVersion(LanguageVersion version) {
@@ -136,24 +149,24 @@ public class LanguageOptions implements Serializable {
   }
 
   public void setEnabledLanguageFeatures(Set<LanguageFeature> enabledLanguageFeatures) {
-    builder.clearEnabledLanguageFeatures();
+    mutableBuilder().clearEnabledLanguageFeatures();
     for (LanguageFeature feature : enabledLanguageFeatures) {
-      builder.addEnabledLanguageFeatures(feature);
+      mutableBuilder().addEnabledLanguageFeatures(feature);
     }
   }
 
   public void enableLanguageFeature(LanguageFeature feature) {
     if (!languageFeatureEnabled(feature)) {
-      builder.addEnabledLanguageFeatures(feature);
+      mutableBuilder().addEnabledLanguageFeatures(feature);
     }
   }
 
   public void disableAllLanguageFeatures() {
-    builder.clearEnabledLanguageFeatures();
+    mutableBuilder().clearEnabledLanguageFeatures();
   }
 
   public void setNameResolutionMode(NameResolutionMode mode) {
-    builder.setNameResolutionMode(mode);
+    mutableBuilder().setNameResolutionMode(mode);
   }
 
   public NameResolutionMode getNameResolutionMode() {
@@ -161,7 +174,7 @@ public class LanguageOptions implements Serializable {
   }
 
   public void setProductMode(ProductMode mode) {
-    builder.setProductMode(mode);
+    mutableBuilder().setProductMode(mode);
   }
 
   public ProductMode getProductMode() {
@@ -169,7 +182,7 @@ public class LanguageOptions implements Serializable {
   }
 
   public void setErrorOnDeprecatedSyntax(boolean value) {
-    builder.setErrorOnDeprecatedSyntax(value);
+    mutableBuilder().setErrorOnDeprecatedSyntax(value);
   }
 
   public boolean getErrorOnDeprecatedSyntax() {
@@ -178,7 +191,7 @@ public class LanguageOptions implements Serializable {
 
   public void enableReservableKeyword(String keyword) {
     if (!reservableKeywordEnabled(keyword)) {
-      builder.addReservedKeywords(keyword);
+      mutableBuilder().addReservedKeywords(keyword);
     }
   }
 
@@ -188,7 +201,7 @@ public class LanguageOptions implements Serializable {
 
   private void writeObject(java.io.ObjectOutputStream out) throws IOException {
     out.defaultWriteObject();
-    builder.build().writeTo(out);
+    serialize().writeTo(out);
   }
 
   private void readObject(java.io.ObjectInputStream in) throws IOException, ClassNotFoundException {
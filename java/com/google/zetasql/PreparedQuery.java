@@ -115,6 +115,7 @@ public final class PreparedQuery implements AutoCloseable {
   private EvaluateQueryRequest buildEvaluateRequest(Map<String, Value> parameters) {
     EvaluateQueryRequest.Builder requestBuilder = EvaluateQueryRequest.newBuilder();
     requestBuilder.setPreparedQueryId(preparedQueryId);
+    requestBuilder.setResultFormat(EvaluateQueryRequest.ResultFormat.COLUMNAR);
 
     final ImmutableMap<String, Value> normalizedParameters =
         normalizeAndValidate(parameters, expectedParameters, "query");
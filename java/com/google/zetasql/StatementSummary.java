@@ -0,0 +1,72 @@
+/*
+ * Copyright 2019 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+package com.google.zetasql;
+
+import com.google.auto.value.AutoValue;
+import com.google.common.collect.ImmutableList;
+import com.google.zetasql.LocalService.AnalyzeResponse;
+import com.google.zetasql.ZetaSQLResolvedNodeKind.ResolvedNodeKind;
+import java.util.List;
+
+/**
+ * The statement-level information of a resolved statement, as returned by {@link
+ * Analyzer#analyzeStatementSummary}. Getting only this information is much cheaper than
+ * deserializing the full ResolvedStatement tree.
+ */
+@AutoValue
+public abstract class StatementSummary {
+
+  /** An output column of a query statement. */
+  @AutoValue
+  public abstract static class OutputColumn {
+    public static OutputColumn create(String name, Type type) {
+      return new AutoValue_StatementSummary_OutputColumn(name, type);
+    }
+
+    public abstract String name();
+
+    public abstract Type type();
+  }
+
+  public static StatementSummary create(
+      ResolvedNodeKind nodeKind, List<OutputColumn> outputColumns, List<String> referencedTables) {
+    return new AutoValue_StatementSummary(
+        nodeKind, ImmutableList.copyOf(outputColumns), ImmutableList.copyOf(referencedTables));
+  }
+
+  /** The kind of the statement, e.g. RESOLVED_QUERY_STMT. */
+  public abstract ResolvedNodeKind nodeKind();
+
+  /** The output columns of a query statement, empty for other statements. */
+  public abstract ImmutableList<OutputColumn> outputColumns();
+
+  /** The full names of the tables that the statement scans, without duplicates. */
+  public abstract ImmutableList<String> referencedTables();
+
+  static StatementSummary deserialize(
+      AnalyzeResponse.StatementSummary proto,
+      TypeFactory typeFactory,
+      List<? extends DescriptorPool> pools) {
+    ImmutableList.Builder<OutputColumn> outputColumns = ImmutableList.builder();
+    for (AnalyzeResponse.StatementSummary.OutputColumn column : proto.getOutputColumnList()) {
+      outputColumns.add(
+          OutputColumn.create(column.getName(), typeFactory.deserialize(column.getType(), pools)));
+    }
+    return create(proto.getNodeKind(), outputColumns.build(), proto.getReferencedTableList());
+  }
+}
@@ -23,7 +23,10 @@ import com.google.auto.value.AutoValue;
 import com.google.common.base.Preconditions;
 import com.google.common.collect.ImmutableList;
 import com.google.errorprone.annotations.CheckReturnValue;
+import com.google.zetasql.LocalService.ColumnarTableData;
 import com.google.zetasql.LocalService.TableData;
+import com.google.zetasql.ZetaSQLType.TypeKind;
+import java.util.ArrayList;
 import java.util.List;
 
 /**
@@ -72,6 +75,9 @@ public abstract class TableContent {
       com.google.zetasql.LocalService.TableContent tableContent) {
     Preconditions.checkNotNull(columnsTypes);
     Preconditions.checkNotNull(tableContent);
+    if (tableContent.hasColumnarTableData()) {
+      return deserializeColumnar(columnsTypes, tableContent.getColumnarTableData());
+    }
 
     ImmutableList.Builder<List<Value>> tableDataBuilder = ImmutableList.builder();
     for (int i = 0; i < tableContent.getTableData().getRowCount(); i++) {
@@ -91,4 +97,80 @@ public abstract class TableContent {
 
     return TableContent.create(tableDataBuilder.build());
   }
+
+  private static TableContent deserializeColumnar(
+      ImmutableList<Type> columnsTypes, ColumnarTableData tableData) {
+    Preconditions.checkArgument(
+        tableData.getColumnCount() == columnsTypes.size(),
+        "Unexpected number of columns. Expected: %s, but received: %s.",
+        columnsTypes.size(),
+        tableData.getColumnCount());
+    int numRows = Math.toIntExact(tableData.getNumRows());
+    List<List<Value>> rows = new ArrayList<>(numRows);
+    for (int i = 0; i < numRows; i++) {
+      rows.add(new ArrayList<>(columnsTypes.size()));
+    }
+    for (int j = 0; j < columnsTypes.size(); j++) {
+      Type type = columnsTypes.get(j);
+      ColumnarTableData.Column column = tableData.getColumn(j);
+      // Each distinct string is only decoded once.
+      List<Value> stringValues = new ArrayList<>(column.getStringDictionaryCount());
+      if (type.getKind() == TypeKind.TYPE_STRING) {
+        for (String string : column.getStringDictionaryList()) {
+          stringValues.add(Value.createStringValue(string));
+        }
+      }
+      for (int i = 0; i < numRows; i++) {
+        rows.get(i).add(deserializeColumnValue(type, column, stringValues, i));
+      }
+    }
+    return TableContent.create(rows);
+  }
+
+  private static Value deserializeColumnValue(
+      Type type, ColumnarTableData.Column column, List<Value> stringValues, int row) {
+    switch (type.getKind()) {
+      case TYPE_INT32:
+      case TYPE_INT64:
+      case TYPE_UINT32:
+      case TYPE_UINT64:
+      case TYPE_BOOL:
+      case TYPE_FLOAT:
+      case TYPE_DOUBLE:
+      case TYPE_STRING:
+      case TYPE_BYTES:
+        if (isNull(column, row)) {
+          return Value.createNullValue(type);
+        }
+        break;
+      default:
+        return Value.deserialize(type, column.getValues(row));
+    }
+    switch (type.getKind()) {
+      case TYPE_INT32:
+        return Value.createInt32Value(Math.toIntExact(column.getInt64Values(row)));
+      case TYPE_INT64:
+        return Value.createInt64Value(column.getInt64Values(row));
+      case TYPE_UINT32:
+        return Value.createUint32Value((int) column.getUint64Values(row));
+      case TYPE_UINT64:
+        return Value.createUint64Value(column.getUint64Values(row));
+      case TYPE_BOOL:
+        return Value.createBoolValue(column.getBoolValues(row));
+      case TYPE_FLOAT:
+        return Value.createFloatValue((float) column.getDoubleValues(row));
+      case TYPE_DOUBLE:
+        return Value.createDoubleValue(column.getDoubleValues(row));
+      case TYPE_STRING:
+        return stringValues.get(column.getStringIndexes(row));
+      default:
+        return Value.createBytesValue(column.getBytesValues(row));
+    }
+  }
+
+  private static boolean isNull(ColumnarTableData.Column column, int row) {
+    int index = row / 8;
+    return index < column.getNullBitmap().size()
+        && (column.getNullBitmap().byteAt(index) & (1 << (row % 8))) != 0;
+  }
 }
@@ -51,6 +51,7 @@ import java.util.Collection;
 import java.util.HashMap;
 import java.util.List;
 import java.util.Map;
+import java.util.concurrent.ConcurrentHashMap;
 
 /**
  * A factory for {@link Type} objects.
@@ -244,6 +245,16 @@ public abstract class TypeFactory implements Serializable {
    */
   private abstract static class AbstractTypeFactory extends TypeFactory {
 
+    /** The maximum number of types in {@link #internedTypes}. */
+    private static final int MAX_INTERNED_TYPES = 4096;
+
+    /**
+     * Deserialized array, struct, range and map types that reference no descriptors, keyed by their
+     * TypeProto. Such types do not depend on the factory or the pools, so they are shared by all
+     * factories to avoid rebuilding the same types for every response from the server.
+     */
+    private static final Map<TypeProto, Type> internedTypes = new ConcurrentHashMap<>();
+
     /**
      * Creates a {@link ProtoType} using the given {@link Descriptor}.
      *
@@ -308,6 +319,45 @@ public abstract class TypeFactory implements Serializable {
       if (TypeFactory.isSimpleType(proto.getTypeKind())) {
         return deserializeSimpleType(proto);
       }
+      if (!referencesDescriptors(proto)) {
+        Type type = internedTypes.get(proto);
+        if (type == null) {
+          type = deserializeNonSimpleType(proto, pools);
+          if (internedTypes.size() < MAX_INTERNED_TYPES) {
+            internedTypes.putIfAbsent(proto, type);
+          }
+        }
+        return type;
+      }
+      return deserializeNonSimpleType(proto, pools);
+    }
+
+    /** Returns whether {@code proto} is or contains an enum or a proto type. */
+    private static boolean referencesDescriptors(TypeProto proto) {
+      switch (proto.getTypeKind()) {
+        case TYPE_ENUM:
+        case TYPE_PROTO:
+          return true;
+        case TYPE_ARRAY:
+          return referencesDescriptors(proto.getArrayType().getElementType());
+        case TYPE_STRUCT:
+          for (StructFieldProto field : proto.getStructType().getFieldList()) {
+            if (referencesDescriptors(field.getFieldType())) {
+              return true;
+            }
+          }
+          return false;
+        case TYPE_RANGE:
+          return referencesDescriptors(proto.getRangeType().getElementType());
+        case TYPE_MAP:
+          return referencesDescriptors(proto.getMapType().getKeyType())
+              || referencesDescriptors(proto.getMapType().getValueType());
+        default:
+          return false;
+      }
+    }
+
+    private Type deserializeNonSimpleType(TypeProto proto, List<? extends DescriptorPool> pools) {
       switch (proto.getTypeKind()) {
         case TYPE_ENUM:
           return deserializeEnumType(proto, pools);
@@ -62,6 +62,8 @@ import com.google.zetasql.TypeFactory;
 import com.google.zetasql.TypeParameters;
 import com.google.zetasql.Value;
 import com.google.zetasql.ValueWithTypeProto;
+import java.util.HashMap;
+import java.util.Map;
 import javax.annotation.Nullable;
 
 /** Deserializes objects in the ResolvedAST which require some context. */
@@ -69,6 +71,13 @@ public abstract class AbstractDeserializationHelper {
   private final TypeFactory typeFactory;
   private final ImmutableList<? extends DescriptorPool> pools;
 
+  /**
+   * Deserialized non-simple types, keyed by their TypeProto. The TypeFactory does not intern enum
+   * and proto types because they depend on the pools, which are fixed for this helper, so a tree
+   * that references the same type many times only builds it once.
+   */
+  private final Map<TypeProto, Type> types = new HashMap<>();
+
   public AbstractDeserializationHelper(
       TypeFactory typeFactory, ImmutableList<? extends DescriptorPool> pools) {
     this.typeFactory = checkNotNull(typeFactory);
@@ -137,7 +146,10 @@ public abstract class AbstractDeserializationHelper {
   abstract Table deserialize(TableRefProto proto);
 
   Type deserialize(TypeProto proto) {
-    return typeFactory.deserialize(proto, pools);
+    if (TypeFactory.isSimpleType(proto.getTypeKind())) {
+      return typeFactory.deserialize(proto, pools);
+    }
+    return types.computeIfAbsent(proto, p -> typeFactory.deserialize(p, pools));
   }
 
   Value deserialize(ValueWithTypeProto proto) {
@@ -121,6 +121,33 @@ public class AnalyzerTest {
     assertThat(Analyzer.analyzeStatement(sql, options, catalog)).isNotNull();
   }
 
+  @Test
+  public void testAnalyzeStatementSummary() {
+    SimpleCatalog catalog = new SimpleCatalog("foo");
+    catalog.addSimpleTable(
+        SimpleTable.tableFromProto(catalog.getTypeFactory().createProtoType(KitchenSinkPB.class)));
+
+    AnalyzerOptions options = new AnalyzerOptions();
+    String sql =
+        "select int64_key_1 as key, string_val from KitchenSinkPB "
+            + "where int32_val in (select int32_val from KitchenSinkPB);";
+    StatementSummary summary = Analyzer.analyzeStatementSummary(sql, options, catalog);
+    assertThat(summary.nodeKind()).isEqualTo(ResolvedNodeKind.RESOLVED_QUERY_STMT);
+    assertThat(summary.outputColumns())
+        .containsExactly(
+            StatementSummary.OutputColumn.create(
+                "key", TypeFactory.createSimpleType(TypeKind.TYPE_INT64)),
+            StatementSummary.OutputColumn.create(
+                "string_val", TypeFactory.createSimpleType(TypeKind.TYPE_STRING)))
+        .inOrder();
+    assertThat(summary.referencedTables()).containsExactly("KitchenSinkPB");
+
+    // Try registering the catalog.
+    catalog.register();
+    assertThat(Analyzer.analyzeStatementSummary(sql, options, catalog)).isEqualTo(summary);
+    catalog.unregister();
+  }
+
   void assertOutputColumnType(ResolvedStatement stmt, Type expectedType) {
     assertThat(stmt).isInstanceOf(ResolvedQueryStmt.class);
     assertThat(((ResolvedQueryStmt) stmt).getOutputColumnList().get(0).getColumn().getType())
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2019 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+package com.google.zetasql;
+
+import static com.google.common.truth.Truth.assertThat;
+import static org.junit.Assert.assertThrows;
+
+import com.google.zetasql.LocalService.EvaluateQueryRequest;
+import com.google.zetasql.LocalService.EvaluateQueryResponse;
+import com.google.zetasql.LocalService.EvaluateRequest;
+import com.google.zetasql.LocalService.EvaluateResponse;
+import com.google.zetasql.LocalService.UnprepareRequest;
+import com.google.zetasql.SimpleCatalogProtos.SimpleCatalogProto;
+import io.grpc.Status;
+import io.grpc.StatusRuntimeException;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+import org.junit.runners.JUnit4;
+
+@RunWith(JUnit4.class)
+public class JniChannelProviderTest {
+
+  @Test
+  public void testEvaluate() {
+    EvaluateResponse response =
+        JniChannelProvider.evaluate(EvaluateRequest.newBuilder().setSql("1 + 2").build());
+    assertThat(response.getValue().getInt64Value()).isEqualTo(3);
+    long id = response.getPrepared().getPreparedExpressionId();
+
+    // The direct calls share the prepared expressions of the gRPC server.
+    EvaluateRequest prepared = EvaluateRequest.newBuilder().setPreparedExpressionId(id).build();
+    assertThat(Client.getStub().evaluate(prepared).getValue())
+        .isEqualTo(response.getValue());
+    assertThat(JniChannelProvider.evaluate(prepared).getValue()).isEqualTo(response.getValue());
+
+    Client.getStub().unprepare(UnprepareRequest.newBuilder().setPreparedExpressionId(id).build());
+    StatusRuntimeException e =
+        assertThrows(StatusRuntimeException.class, () -> JniChannelProvider.evaluate(prepared));
+    assertThat(e.getStatus().getCode()).isEqualTo(Status.Code.INVALID_ARGUMENT);
+  }
+
+  @Test
+  public void testEvaluateError() {
+    EvaluateRequest request = EvaluateRequest.newBuilder().setSql("1 +").build();
+    StatusRuntimeException direct =
+        assertThrows(StatusRuntimeException.class, () -> JniChannelProvider.evaluate(request));
+    StatusRuntimeException stub =
+        assertThrows(StatusRuntimeException.class, () -> Client.getStub().evaluate(request));
+    assertThat(direct.getStatus().getCode()).isEqualTo(Status.Code.INVALID_ARGUMENT);
+    assertThat(direct.getStatus().getCode()).isEqualTo(stub.getStatus().getCode());
+  }
+
+  @Test
+  public void testEvaluateQuery() {
+    EvaluateQueryRequest request =
+        EvaluateQueryRequest.newBuilder()
+            .setSql("SELECT x FROM UNNEST([1, 2, 3]) AS x ORDER BY x")
+            .setSimpleCatalog(SimpleCatalogProto.getDefaultInstance())
+            .build();
+    EvaluateQueryResponse response = JniChannelProvider.evaluateQuery(request);
+    assertThat(response.getContent().getTableData().getRowCount()).isEqualTo(3);
+    assertThat(response.getContent().getTableData().getRow(2).getCell(0).getInt64Value())
+        .isEqualTo(3);
+    assertThat(response).isEqualTo(Client.getStub().evaluateQuery(request));
+  }
+}
@@ -21,6 +21,7 @@ import static com.google.common.truth.Truth.assertThat;
 import static org.junit.Assert.fail;
 
 import com.google.zetasql.ZetaSQLOptions.LanguageFeature;
+import com.google.zetasql.ZetaSQLOptions.LanguageOptionsProto;
 import com.google.zetasql.ZetaSQLOptions.LanguageVersion;
 import com.google.zetasql.ZetaSQLOptions.NameResolutionMode;
 import com.google.zetasql.ZetaSQLOptions.ProductMode;
@@ -257,4 +258,15 @@ public class LanguageOptionsTest {
     assertThat(options.reservableKeywordEnabled("QUALIFY")).isTrue();
     assertThat(options.serialize().getReservedKeywordsList()).contains("QUALIFY");
   }
+
+  @Test
+  public void testSerializeReusesProtoUntilModified() {
+    LanguageOptions options = new LanguageOptions();
+    LanguageOptionsProto proto = options.serialize();
+    assertThat(options.serialize()).isSameInstanceAs(proto);
+    options.setProductMode(ProductMode.PRODUCT_EXTERNAL);
+    assertThat(options.serialize()).isNotSameInstanceAs(proto);
+    assertThat(options.serialize().getProductMode()).isEqualTo(ProductMode.PRODUCT_EXTERNAL);
+    assertThat(proto.getProductMode()).isEqualTo(ProductMode.PRODUCT_INTERNAL);
+  }
 }
@@ -184,6 +184,24 @@ public class TypeFactoryTest {
     assertThat(range.getElementType()).isEqualTo(dateType);
   }
 
+  @Test
+  public void testDeserializeInternsTypesWithoutDescriptors() {
+    ArrayList<StructType.StructField> fields = new ArrayList<>();
+    fields.add(
+        new StructType.StructField(
+            "a",
+            TypeFactory.createArrayType(TypeFactory.createSimpleType(TypeKind.TYPE_INT64))));
+    TypeProto proto = TypeFactory.createStructType(fields).serialize();
+    Type type = TypeFactory.nonUniqueNames().deserialize(proto);
+    assertThat(TypeFactory.uniqueNames().deserialize(proto)).isSameInstanceAs(type);
+
+    TypeFactory factory = TypeFactory.nonUniqueNames();
+    ArrayType arrayOfEnum = TypeFactory.createArrayType(factory.createEnumType(TypeKind.class));
+    TypeProto arrayOfEnumProto = arrayOfEnum.serialize();
+    assertThat(factory.deserialize(arrayOfEnumProto))
+        .isNotSameInstanceAs(factory.deserialize(arrayOfEnumProto));
+  }
+
   @Test
   public void testDedupByName() throws Exception {
     TypeFactory factory = TypeFactory.uniqueNames();
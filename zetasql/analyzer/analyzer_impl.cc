@@ -32,6 +32,7 @@
 #include "zetasql/analyzer/rewrite_resolved_ast.h"
 #include "zetasql/common/errors.h"
 #include "zetasql/common/internal_analyzer_options.h"
+#include "zetasql/common/resolver_profile.h"
 #include "zetasql/common/timer_util.h"
 #include "zetasql/parser/parse_tree.h"
 #include "zetasql/parser/parser.h"
@@ -135,9 +136,20 @@ absl::Status InternalAnalyzeExpressionFromParserAST(
 
     std::unique_ptr<const ResolvedExpr> resolved_expr;
     Resolver resolver(catalog, type_factory, &options);
+    ValidatedScans validated_scans;
+    ValidatedScans* validated_input =
+        options.validate_resolved_ast_incrementally() &&
+                InternalAnalyzerOptions::GetValidateResolvedAST(options) &&
+                !options.enabled_rewrites().empty()
+            ? &validated_scans
+            : nullptr;
     {
       auto resolver_timer = internal::MakeScopedTimerStarted(
           &analyzer_runtime_info.resolver_timed_value());
+      internal::ScopedResolverProfileCollector profile_collector(
+          options.collect_resolver_profile()
+              ? &analyzer_runtime_info.resolver_profile()
+              : nullptr);
       ZETASQL_RETURN_IF_ERROR(
           resolver.ResolveStandaloneExpr(sql, &ast_expression, &resolved_expr));
       ZETASQL_VLOG(3) << "Resolved AST:\n" << resolved_expr->DebugString();
@@ -154,7 +166,9 @@ absl::Status InternalAnalyzeExpressionFromParserAST(
     if (InternalAnalyzerOptions::GetValidateResolvedAST(options)) {
       internal::ScopedTimer scoped_validator_timer = MakeScopedTimerStarted(
           &analyzer_runtime_info.validator_timed_value());
-      Validator validator(options.language());
+      ValidatorOptions validator_options;
+      validator_options.validated_scans = validated_input;
+      Validator validator(options.language(), validator_options);
       ZETASQL_RETURN_IF_ERROR(
           validator.ValidateStandaloneResolvedExpr(resolved_expr.get()));
     }
@@ -186,7 +200,8 @@ absl::Status InternalAnalyzeExpressionFromParserAST(
         type_assignments, resolver.undeclared_positional_parameters(),
         resolver.max_column_id());
     ZETASQL_RETURN_IF_ERROR(InternalRewriteResolvedAst(options, sql, catalog,
-                                               type_factory, **output));
+                                               type_factory, **output,
+                                               validated_input));
   }
 
   AnalyzerOutputMutator(*output).mutable_runtime_info().AccumulateAll(
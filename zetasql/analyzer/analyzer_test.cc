@@ -27,6 +27,7 @@
 #include "zetasql/base/logging.h"
 #include "google/protobuf/compiler/importer.h"
 #include "google/protobuf/descriptor.h"
+#include "zetasql/common/resolver_profile.h"
 #include "zetasql/common/status_payload_utils.h"
 #include "zetasql/base/testing/status_matchers.h"  
 #include "zetasql/common/testing/testing_proto_util.h"
@@ -46,9 +47,12 @@
 #include "zetasql/public/literal_remover.h"
 #include "zetasql/public/options.pb.h"
 #include "zetasql/public/parse_resume_location.h"
+#include "zetasql/public/proto/logging.pb.h"
 #include "zetasql/public/rewriter_interface.h"
 #include "zetasql/public/simple_catalog.h"
 #include "zetasql/public/sql_formatter.h"
+#include "zetasql/public/templated_sql_function.h"
+#include "zetasql/public/templated_sql_tvf.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/type.pb.h"
 #include "zetasql/public/types/array_type.h"
@@ -535,6 +539,105 @@ TEST_F(AnalyzerOptionsTest, AnalyzeStatementWithPreRewriteCallback) {
       StatusIs(_, HasSubstr("Pre-rewrite callback called before rewrite")));
 }
 
+// The FLATTEN rewriter introduces a WithExpr, which the WITH expression
+// rewriter, registered later, removes in the same iteration.
+TEST_F(AnalyzerOptionsTest, RewritersApplyToRewrittenNodes) {
+  AnalyzerOptions options;
+  options.mutable_language()->EnableLanguageFeature(
+      FEATURE_V_1_3_UNNEST_AND_FLATTEN_ARRAYS);
+  options.set_enabled_rewrites({REWRITE_FLATTEN, REWRITE_WITH_EXPR});
+  SampleCatalog catalog(options.language());
+  TypeFactory type_factory;
+  std::unique_ptr<const AnalyzerOutput> output;
+
+  ZETASQL_ASSERT_OK(AnalyzeStatement("SELECT FLATTEN([STRUCT([1, 2] AS X)].X)",
+                             options, catalog.catalog(), &type_factory,
+                             &output));
+  const std::string debug_string = output->resolved_statement()->DebugString();
+  EXPECT_THAT(debug_string, Not(HasSubstr("Flatten")));
+  EXPECT_THAT(debug_string, Not(HasSubstr("WithExpr")));
+  EXPECT_EQ(output->runtime_info().rewriters_details(REWRITE_FLATTEN).count, 1);
+  EXPECT_LE(output->runtime_info().rewriters_details(REWRITE_WITH_EXPR).count,
+            1);
+}
+
+// The relevance checker still reports the anonymization rewriter as relevant
+// after it has run; it must not be run again on its own output when other
+// rewriters keep the loop going.
+TEST_F(AnalyzerOptionsTest, AnonymizationRewriterRunsOnce) {
+  AnalyzerOptions options;
+  options.mutable_language()->EnableLanguageFeature(FEATURE_ANONYMIZATION);
+  options.mutable_language()->EnableLanguageFeature(
+      FEATURE_V_1_3_UNNEST_AND_FLATTEN_ARRAYS);
+  options.set_enabled_rewrites(
+      {REWRITE_ANONYMIZATION, REWRITE_FLATTEN, REWRITE_WITH_EXPR});
+  SampleCatalog catalog(options.language());
+  TypeFactory type_factory;
+  std::unique_ptr<const AnalyzerOutput> output;
+
+  ZETASQL_ASSERT_OK(AnalyzeStatement(
+      "SELECT ANON_COUNT(*) FROM KeyValue "
+      "WHERE key IN UNNEST(FLATTEN([STRUCT([1, 2] AS X)].X))",
+      options, catalog.catalog(), &type_factory, &output));
+  const std::string debug_string = output->resolved_statement()->DebugString();
+  EXPECT_THAT(debug_string, Not(HasSubstr("Flatten")));
+  EXPECT_THAT(debug_string, Not(HasSubstr("WithExpr")));
+  EXPECT_EQ(
+      output->runtime_info().rewriters_details(REWRITE_ANONYMIZATION).count,
+      1);
+  EXPECT_EQ(output->runtime_info().rewriters_details(REWRITE_FLATTEN).count, 1);
+}
+
+// Views that read from other views are inlined in a single iteration.
+TEST_F(AnalyzerOptionsTest, NestedViewsInlinedInOneIteration) {
+  AnalyzerOptions options;
+  options.set_enabled_rewrites({REWRITE_INLINE_SQL_VIEWS});
+  SampleCatalog catalog(options.language());
+  TypeFactory type_factory;
+  std::unique_ptr<const AnalyzerOutput> output;
+
+  ZETASQL_ASSERT_OK(AnalyzeStatement("SELECT a, b FROM ScanViewView", options,
+                             catalog.catalog(), &type_factory, &output));
+  const std::string debug_string = output->resolved_statement()->DebugString();
+  EXPECT_THAT(debug_string, Not(HasSubstr("table=ScanViewView")));
+  EXPECT_THAT(debug_string, Not(HasSubstr("table=ScanTableView")));
+  EXPECT_THAT(debug_string, HasSubstr("table=TwoIntegers"));
+  EXPECT_EQ(
+      output->runtime_info().rewriters_details(REWRITE_INLINE_SQL_VIEWS).count,
+      1);
+}
+
+TEST_F(AnalyzerOptionsTest, CollectResolverProfile) {
+  AnalyzerOptions options;
+  SampleCatalog catalog(options.language());
+  TypeFactory type_factory;
+  constexpr absl::string_view kQuery =
+      "SELECT key, (SELECT MAX(value) FROM KeyValue) FROM KeyValue "
+      "WHERE key + 1 > 2";
+  std::unique_ptr<const AnalyzerOutput> output;
+
+  ZETASQL_ASSERT_OK(AnalyzeStatement(kQuery, options, catalog.catalog(),
+                             &type_factory, &output));
+  EXPECT_TRUE(
+      output->runtime_info().log_entry().resolver_stats_by_op().empty());
+
+  options.set_collect_resolver_profile(true);
+  ZETASQL_ASSERT_OK(AnalyzeStatement(kQuery, options, catalog.catalog(),
+                             &type_factory, &output));
+  const internal::ResolverProfile& profile =
+      output->runtime_info().resolver_profile();
+  EXPECT_EQ(profile.details(AnalyzerLogEntry::CATALOG_TABLE_LOOKUP).count, 2);
+  EXPECT_GT(profile.details(AnalyzerLogEntry::CATALOG_FUNCTION_LOOKUP).count,
+            0);
+  EXPECT_GT(
+      profile.details(AnalyzerLogEntry::FUNCTION_SIGNATURE_MATCHING).count, 0);
+  EXPECT_EQ(profile.details(AnalyzerLogEntry::SUBQUERY_RESOLUTION).count, 1);
+  EXPECT_FALSE(
+      output->runtime_info().log_entry().resolver_stats_by_op().empty());
+  EXPECT_THAT(output->runtime_info().DebugString(std::nullopt),
+              HasSubstr("CATALOG_TABLE_LOOKUP"));
+}
+
 TEST_F(AnalyzerOptionsTest, AnalyzeExpressionWithPreRewriteCallback) {
   AnalyzerOptions options;
   options.mutable_language()->EnableLanguageFeature(FEATURE_ANONYMIZATION);
@@ -2077,6 +2180,230 @@ TEST(AnalyzerTest, AnalyzeStatementsOfScript) {
                                "Unrecognized name: garbage [at 2:8]"));
 }
 
+TEST(AnalyzerTest, SharedBuiltinFunctions) {
+  const BuiltinFunctionOptions options =
+      BuiltinFunctionOptions::AllReleasedFunctions();
+  TypeFactory type_factory;
+  SimpleCatalog catalog1("catalog1", &type_factory);
+  SimpleCatalog catalog2("catalog2", &type_factory);
+  ZETASQL_ASSERT_OK(catalog1.AddSharedBuiltinFunctionsAndTypes(options));
+  ZETASQL_ASSERT_OK(catalog2.AddSharedBuiltinFunctionsAndTypes(options));
+
+  // Both catalogs find the same Functions, including those in namespaces.
+  for (const std::vector<std::string>& path :
+       std::vector<std::vector<std::string>>{{"concat"}, {"NET", "HOST"}}) {
+    const Function* function1 = nullptr;
+    const Function* function2 = nullptr;
+    ZETASQL_ASSERT_OK(catalog1.FindFunction(path, &function1));
+    ZETASQL_ASSERT_OK(catalog2.FindFunction(path, &function2));
+    EXPECT_EQ(function1, function2);
+  }
+
+  std::unique_ptr<const AnalyzerOutput> analyzer_output;
+  ZETASQL_ASSERT_OK(AnalyzeStatement("SELECT CONCAT('a', 'b'), NET.HOST('x')",
+                             AnalyzerOptions(), &catalog1, &type_factory,
+                             &analyzer_output));
+}
+
+// A SimpleCatalog that records the paths passed to Prefetch().
+class PrefetchRecordingCatalog : public SimpleCatalog {
+ public:
+  explicit PrefetchRecordingCatalog(TypeFactory* type_factory)
+      : SimpleCatalog("prefetch_recording", type_factory) {}
+
+  absl::Status Prefetch(
+      absl::Span<const std::vector<std::string>> table_paths,
+      absl::Span<const std::vector<std::string>> tvf_paths) override {
+    ++num_prefetch_calls_;
+    table_paths_.assign(table_paths.begin(), table_paths.end());
+    tvf_paths_.assign(tvf_paths.begin(), tvf_paths.end());
+    return absl::OkStatus();
+  }
+
+  int num_prefetch_calls_ = 0;
+  std::vector<std::vector<std::string>> table_paths_;
+  std::vector<std::vector<std::string>> tvf_paths_;
+};
+
+TEST(AnalyzerTest, PrefetchCatalogNames) {
+  TypeFactory type_factory;
+  PrefetchRecordingCatalog catalog(&type_factory);
+  for (const char* name : {"t1", "t2"}) {
+    catalog.AddOwnedTable(std::make_unique<SimpleTable>(
+        name, std::vector<SimpleTable::NameAndType>{
+                  {"a", type_factory.get_int64()}}));
+  }
+  const std::string sql = "SELECT a FROM t1 JOIN T2 USING (a)";
+  AnalyzerOptions analyzer_options;
+  std::unique_ptr<const AnalyzerOutput> analyzer_output;
+  ZETASQL_ASSERT_OK(AnalyzeStatement(sql, analyzer_options, &catalog, &type_factory,
+                             &analyzer_output));
+  EXPECT_EQ(catalog.num_prefetch_calls_, 0);
+
+  analyzer_options.set_prefetch_catalog_names(true);
+  ZETASQL_ASSERT_OK(AnalyzeStatement(sql, analyzer_options, &catalog, &type_factory,
+                             &analyzer_output));
+  EXPECT_EQ(catalog.num_prefetch_calls_, 1);
+  EXPECT_THAT(catalog.table_paths_,
+              ElementsAre(ElementsAre("T2"), ElementsAre("t1")));
+  EXPECT_THAT(catalog.tvf_paths_, IsEmpty());
+}
+
+TEST(AnalyzerTest, SelectStarOverWideTable) {
+  constexpr int kNumColumns = 2000;
+  TypeFactory type_factory;
+  std::vector<SimpleTable::NameAndType> columns;
+  std::vector<std::string> excluded_columns;
+  for (int i = 0; i < kNumColumns; ++i) {
+    columns.emplace_back(absl::StrCat("c", i), type_factory.get_int64());
+    if (i % 2 == 0) {
+      excluded_columns.push_back(absl::StrCat("C", i));
+    }
+  }
+  SimpleTable table("WideTable", columns);
+  SimpleCatalog catalog("wide_tables", &type_factory);
+  catalog.AddTable(&table);
+  AnalyzerOptions options;
+  options.mutable_language()->EnableLanguageFeature(
+      FEATURE_V_1_1_SELECT_STAR_EXCEPT_REPLACE);
+
+  std::unique_ptr<const AnalyzerOutput> analyzer_output;
+  ZETASQL_ASSERT_OK(AnalyzeStatement(
+      absl::StrCat("SELECT * EXCEPT (", absl::StrJoin(excluded_columns, ", "),
+                   ") REPLACE (c1 + 1 AS c1) FROM (SELECT * FROM (SELECT * "
+                   "FROM WideTable))"),
+      options, &catalog, &type_factory, &analyzer_output));
+  EXPECT_EQ(analyzer_output->resolved_statement()
+                ->GetAs<ResolvedQueryStmt>()
+                ->output_column_list_size(),
+            kNumColumns / 2);
+
+  // Names that appear on both sides of the join are still ambiguous.
+  EXPECT_THAT(
+      AnalyzeStatement("SELECT * REPLACE (1 AS c1) FROM WideTable t1, "
+                       "WideTable t2",
+                       options, &catalog, &type_factory, &analyzer_output),
+      StatusIs(absl::StatusCode::kInvalidArgument, HasSubstr("ambiguous")));
+}
+
+// The Coercer memoizes the supertypes of non-literal STRUCTs and whether they
+// coerce, so repeated expressions must resolve the same way.
+TEST(AnalyzerTest, RepeatedStructCoercions) {
+  TypeFactory type_factory;
+  SimpleCatalog catalog("struct_coercions", &type_factory);
+  catalog.AddBuiltinFunctions(BuiltinFunctionOptions::AllReleasedFunctions());
+  const std::string from_clause =
+      " FROM (SELECT STRUCT(CAST(1 AS INT32) AS a) AS s, STRUCT(2 AS a) AS t, "
+      "STRUCT('x' AS a) AS u)";
+
+  std::unique_ptr<const AnalyzerOutput> analyzer_output;
+  ZETASQL_ASSERT_OK(AnalyzeStatement(
+      absl::StrCat("SELECT COALESCE(s, t), COALESCE(s, t), s = t, t = s, "
+                   "s IN (t, t)",
+                   from_clause),
+      AnalyzerOptions(), &catalog, &type_factory, &analyzer_output));
+  const auto& output_columns = analyzer_output->resolved_statement()
+                                   ->GetAs<ResolvedQueryStmt>()
+                                   ->output_column_list();
+  ASSERT_EQ(output_columns.size(), 5);
+  for (int i = 0; i < 2; ++i) {
+    const Type* type = output_columns[i]->column().type();
+    ASSERT_TRUE(type->IsStruct());
+    EXPECT_TRUE(type->AsStruct()->field(0).type->IsInt64());
+  }
+
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_THAT(AnalyzeStatement(absl::StrCat("SELECT s = u", from_clause),
+                                 AnalyzerOptions(), &catalog, &type_factory,
+                                 &analyzer_output),
+                StatusIs(absl::StatusCode::kInvalidArgument));
+  }
+}
+
+// Templated SQL functions and TVFs that cache their resolved calls share them
+// between calls with the same argument types, also across statements.
+TEST(AnalyzerTest, CachedTemplatedSQLFunctionCalls) {
+  TypeFactory type_factory;
+  SimpleCatalog catalog("templated_calls", &type_factory);
+  catalog.AddBuiltinFunctions(BuiltinFunctionOptions::AllReleasedFunctions());
+  auto function = std::make_unique<TemplatedSQLFunction>(
+      std::vector<std::string>{"twice"},
+      FunctionSignature(ARG_TYPE_ARBITRARY, {ARG_TYPE_ANY_1}, -1),
+      std::vector<std::string>{"x"}, ParseResumeLocation::FromString("x + x"));
+  function->set_cache_resolved_calls(true);
+  const TemplatedSQLFunction* twice = function.get();
+  catalog.AddOwnedFunction(std::move(function));
+  auto tvf = std::make_unique<TemplatedSQLTVF>(
+      std::vector<std::string>{"echo"},
+      FunctionSignature(ARG_TYPE_RELATION, {ARG_TYPE_ANY_1}, -1),
+      std::vector<std::string>{"x"},
+      ParseResumeLocation::FromString("SELECT x AS y"));
+  tvf->set_cache_resolved_calls(true);
+  catalog.AddOwnedTableValuedFunction(std::move(tvf));
+
+  auto analyze = [&](absl::string_view sql,
+                     std::unique_ptr<const AnalyzerOutput>* output) {
+    // Each statement gets its own IdStringPool.
+    return AnalyzeStatement(sql, AnalyzerOptions(), &catalog, &type_factory,
+                            output);
+  };
+  std::unique_ptr<const AnalyzerOutput> output;
+  ZETASQL_ASSERT_OK(analyze("SELECT twice(1), twice(2), twice(1.5)", &output));
+  std::vector<const ResolvedNode*> calls;
+  output->resolved_statement()->GetDescendantsWithKinds(
+      {RESOLVED_FUNCTION_CALL}, &calls);
+  std::vector<const ResolvedFunctionCallInfo*> call_infos;
+  for (const ResolvedNode* call : calls) {
+    const auto* function_call = call->GetAs<ResolvedFunctionCall>();
+    if (function_call->function() == twice) {
+      call_infos.push_back(function_call->function_call_info().get());
+    }
+  }
+  ASSERT_EQ(call_infos.size(), 3);
+  EXPECT_EQ(call_infos[0], call_infos[1]);
+  EXPECT_NE(call_infos[0], call_infos[2]);
+  std::shared_ptr<ResolvedFunctionCallInfo> first_call_info =
+      output->resolved_statement()
+          ->GetAs<ResolvedQueryStmt>()
+          ->query()
+          ->GetAs<ResolvedProjectScan>()
+          ->expr_list(0)
+          ->expr()
+          ->GetAs<ResolvedFunctionCall>()
+          ->function_call_info();
+
+  // Later statements reuse the cached calls, which outlive the statement that
+  // resolved them.
+  output.reset();
+  ZETASQL_ASSERT_OK(analyze("SELECT twice(3)", &output));
+  const auto* project = output->resolved_statement()
+                            ->GetAs<ResolvedQueryStmt>()
+                            ->query()
+                            ->GetAs<ResolvedProjectScan>();
+  EXPECT_EQ(project->expr_list(0)
+                ->expr()
+                ->GetAs<ResolvedFunctionCall>()
+                ->function_call_info()
+                .get(),
+            first_call_info.get());
+  EXPECT_THAT(first_call_info->DebugString(), HasSubstr("$add"));
+
+  auto tvf_query = [&](absl::string_view sql) -> const ResolvedQueryStmt* {
+    ZETASQL_EXPECT_OK(analyze(sql, &output));
+    std::vector<const ResolvedNode*> scans;
+    output->resolved_statement()->GetDescendantsWithKinds({RESOLVED_TVFSCAN},
+                                                          &scans);
+    if (scans.size() != 1) return nullptr;
+    return static_cast<const TemplatedSQLTVFSignature*>(
+               scans[0]->GetAs<ResolvedTVFScan>()->signature().get())
+        ->resolved_templated_query();
+  };
+  const ResolvedQueryStmt* int64_query = tvf_query("SELECT * FROM echo(1)");
+  ASSERT_NE(int64_query, nullptr);
+  EXPECT_EQ(tvf_query("SELECT y + 1 FROM echo(2)"), int64_query);
+  EXPECT_NE(tvf_query("SELECT * FROM echo('a')"), int64_query);
+}
+
 class AnalyzeGeneratedColumnTest : public testing::Test {
  public:
   AnalyzeGeneratedColumnTest() : catalog_("test_catalog") {}
@@ -20,6 +20,7 @@
 #include <utility>
 #include <vector>
 
+#include "zetasql/common/resolver_profile.h"
 #include "zetasql/parser/parse_tree_errors.h"
 #include "zetasql/public/annotation/collation.h"
 #include "zetasql/base/status_macros.h"
@@ -53,6 +54,71 @@ void AnnotationPropagator::InitializeAnnotationSpecs(
   for (const auto& annotation_spec : analyzer_options.get_annotation_specs()) {
     annotation_specs_.push_back(annotation_spec);
   }
+
+  // The ZetaSQL annotation specs only derive annotations from the inputs of a
+  // node, but engine specific ones may introduce annotations on their own.
+  propagates_only_from_annotated_inputs_ =
+      analyzer_options.get_annotation_specs().empty();
+}
+
+static bool HasAnnotation(const ResolvedExpr* expr) {
+  return expr != nullptr && expr->type_annotation_map() != nullptr;
+}
+
+// Returns false if none of the inputs that annotations are propagated from
+// into <resolved_node> has an annotation, so that propagating annotations
+// through it can only produce an empty AnnotationMap. Conservatively returns
+// true for inputs it does not know how to inspect.
+static bool MayHaveAnnotatedInputs(const ResolvedNode* resolved_node) {
+  switch (resolved_node->node_kind()) {
+    case RESOLVED_COLUMN_REF:
+      return resolved_node->GetAs<ResolvedColumnRef>()
+                 ->column()
+                 .type_annotation_map() != nullptr;
+    case RESOLVED_GET_STRUCT_FIELD:
+      return HasAnnotation(
+          resolved_node->GetAs<ResolvedGetStructField>()->expr());
+    case RESOLVED_MAKE_STRUCT:
+      for (const auto& field :
+           resolved_node->GetAs<ResolvedMakeStruct>()->field_list()) {
+        if (HasAnnotation(field.get())) return true;
+      }
+      return false;
+    case RESOLVED_FUNCTION_CALL:
+    case RESOLVED_AGGREGATE_FUNCTION_CALL:
+    case RESOLVED_ANALYTIC_FUNCTION_CALL: {
+      auto* function_call = resolved_node->GetAs<ResolvedFunctionCallBase>();
+      for (const auto& argument : function_call->argument_list()) {
+        // FLATTEN looks through its ResolvedFlatten argument.
+        if (argument->node_kind() == RESOLVED_FLATTEN ||
+            HasAnnotation(argument.get())) {
+          return true;
+        }
+      }
+      for (const auto& argument : function_call->generic_argument_list()) {
+        if (argument->expr() == nullptr) {
+          if (argument->inline_lambda() == nullptr ||
+              HasAnnotation(argument->inline_lambda()->body())) {
+            return true;
+          }
+        } else if (HasAnnotation(argument->expr())) {
+          return true;
+        }
+      }
+      return false;
+    }
+    case RESOLVED_SUBQUERY_EXPR: {
+      auto* subquery_expr = resolved_node->GetAs<ResolvedSubqueryExpr>();
+      if (subquery_expr->subquery() == nullptr) return true;
+      for (const ResolvedColumn& column :
+           subquery_expr->subquery()->column_list()) {
+        if (column.type_annotation_map() != nullptr) return true;
+      }
+      return false;
+    }
+    default:
+      return false;
+  }
 }
 
 static absl::Status CheckAndPropagateAnnotationsImpl(
@@ -112,12 +178,22 @@ absl::Status AnnotationPropagator::CheckAndPropagateAnnotations(
           FEATURE_V_1_3_ANNOTATION_FRAMEWORK)) {
     return absl::OkStatus();
   }
+  internal::ScopedResolverOperation profile_operation(
+      AnalyzerLogEntry::ANNOTATION_PROPAGATION);
   if (resolved_node->IsExpression()) {
     auto* expr = resolved_node->GetAs<ResolvedExpr>();
     // TODO: support annotation for Proto and ExtendedType.
     if (expr->type()->IsProto() || expr->type()->IsExtendedType()) {
       return absl::OkStatus();
     }
+    if (annotation_specs_.empty() ||
+        (propagates_only_from_annotated_inputs_ &&
+         !MayHaveAnnotatedInputs(resolved_node))) {
+      // Nothing to propagate. This is the common case for catalogs without
+      // annotated columns, so avoid allocating an AnnotationMap.
+      expr->set_type_annotation_map(nullptr);
+      return absl::OkStatus();
+    }
     std::unique_ptr<AnnotationMap> annotation_map =
         AnnotationMap::Create(expr->type());
     absl::Status status = CheckAndPropagateAnnotationsImpl(
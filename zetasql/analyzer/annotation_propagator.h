@@ -65,6 +65,10 @@ class AnnotationPropagator {
   // <annotation_specs_>.
   // AnnotationSpec* elements in the vector are not owned by this class.
   std::vector<AnnotationSpec*> annotation_specs_;
+  // True if all AnnotationSpecs in <annotation_specs_> only propagate
+  // annotations from annotated inputs, so that expressions without annotated
+  // inputs can skip propagation.
+  bool propagates_only_from_annotated_inputs_ = false;
   const AnalyzerOptions& analyzer_options_;  // Not owned.
   TypeFactory& type_factory_;                // Not owned.
 };
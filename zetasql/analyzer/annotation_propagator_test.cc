@@ -26,6 +26,8 @@
 #include "zetasql/public/catalog.h"
 #include "zetasql/public/simple_catalog.h"
 #include "zetasql/public/types/type_factory.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
 #include "zetasql/resolved_ast/rewrite_utils.h"
 #include "zetasql/resolved_ast/test_utils.h"
 #include "gmock/gmock.h"
@@ -189,6 +191,23 @@ FunctionCall(ZetaSQL:concat(STRING, repeated STRING) -> STRING)
 )"));
 }
 
+TEST_F(CollationAnnotationPropagatorTest,
+       TestNoAnnotationPropagatedWithoutAnnotatedInputs) {
+  AnnotationPropagator annotation_propagator(analyzer_options_, type_factory_);
+
+  std::vector<std::unique_ptr<const ResolvedExpr>> args;
+  args.push_back(MakeResolvedLiteral(Value::String("foo")));
+  args.push_back(MakeResolvedLiteral(Value::String("bar")));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<const ResolvedExpr> concat_fn,
+      ConcatStringForTest(args[0]->type(), args, analyzer_options_, *catalog_,
+                          type_factory_));
+
+  ZETASQL_ASSERT_OK(annotation_propagator.CheckAndPropagateAnnotations(
+      /*error_node=*/nullptr, const_cast<ResolvedExpr*>(concat_fn.get())));
+  EXPECT_EQ(concat_fn->type_annotation_map(), nullptr);
+}
+
 // TODO: Add collation annotation propagation test cases for all
 // remaining functions that uses collation operation -
 // array_min, array_max, array_offset, array_offsets, array_find,
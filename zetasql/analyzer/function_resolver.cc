@@ -38,6 +38,7 @@
 #include "zetasql/analyzer/query_resolver_helper.h"
 #include "zetasql/analyzer/resolver.h"
 #include "zetasql/common/errors.h"
+#include "zetasql/common/resolver_profile.h"
 #include "zetasql/common/status_payload_utils.h"
 #include "zetasql/common/thread_stack.h"
 #include "zetasql/parser/ast_node_kind.h"
@@ -862,6 +863,41 @@ FunctionResolver::GenerateErrorMessageWithSupportedSignatures(
   }
 }
 
+// static
+std::optional<FunctionResolver::MatchedSignatureKey>
+FunctionResolver::GetMatchedSignatureKey(
+    const Function* function, const std::vector<const ASTNode*>& arg_locations,
+    const std::vector<NamedArgumentInfo>& named_arguments,
+    const std::vector<InputArgumentType>& input_arguments,
+    const std::vector<std::string>* mismatch_errors) {
+  // Only builtin functions are known to outlive the resolver, rather than be
+  // freed and have their address reused. Fake AST nodes can match internal
+  // signatures.
+  if (!function->IsZetaSQLBuiltin() || mismatch_errors != nullptr ||
+      !named_arguments.empty() ||
+      (!arg_locations.empty() &&
+       arg_locations[0]->node_kind() == FakeASTNode::kConcreteNodeKind)) {
+    return std::nullopt;
+  }
+  MatchedSignatureKey key(function, {});
+  key.second.reserve(input_arguments.size());
+  for (const InputArgumentType& argument : input_arguments) {
+    // Literals, parameters and NULLs coerce differently than other arguments
+    // of their type, and the other kinds of arguments are not just types.
+    if (argument.type() == nullptr || argument.is_literal() ||
+        argument.is_untyped() || argument.is_query_parameter() ||
+        argument.is_relation() || argument.is_model() ||
+        argument.is_connection() || argument.is_lambda() ||
+        argument.is_sequence() || argument.is_default_argument_value() ||
+        argument.field_types_size() > 0 ||
+        argument.argument_alias().has_value()) {
+      return std::nullopt;
+    }
+    key.second.push_back(argument.type());
+  }
+  return key;
+}
+
 // TODO: Eventually we want to keep track of the closest
 // signature even if there is no match, so that we can provide a good
 // error message.  Currently, this code takes an early exit if a signature
@@ -877,6 +913,8 @@ FunctionResolver::FindMatchingSignature(
     std::vector<FunctionArgumentOverride>* arg_overrides,
     std::vector<ArgIndexEntry>* arg_index_mapping_out,
     std::vector<std::string>* mismatch_errors) const {
+  internal::ScopedResolverOperation profile_operation(
+      AnalyzerLogEntry::FUNCTION_SIGNATURE_MATCHING);
   std::unique_ptr<FunctionSignature> best_result_signature;
   SignatureMatchResult best_result;
   std::vector<FunctionArgumentOverride> best_result_arg_overrides;
@@ -890,6 +928,21 @@ FunctionResolver::FindMatchingSignature(
           << " show_mismatch_details: " << show_mismatch_details;
 
   ZETASQL_RET_CHECK_LE(arg_locations_in.size(), std::numeric_limits<int32_t>::max());
+  std::optional<MatchedSignatureKey> matched_signature_key =
+      GetMatchedSignatureKey(function, arg_locations_in, named_arguments,
+                             *input_arguments, mismatch_errors);
+  if (matched_signature_key.has_value()) {
+    auto it = matched_signatures_.find(*matched_signature_key);
+    if (it != matched_signatures_.end()) {
+      *input_arguments = it->second.input_arguments;
+      *arg_index_mapping_out = it->second.arg_index_mapping;
+      if (arg_overrides != nullptr) {
+        arg_overrides->clear();
+      }
+      return new FunctionSignature(*it->second.signature);
+    }
+  }
+
   const int num_provided_args = static_cast<int>(arg_locations_in.size());
   const int num_signatures = function->NumSignatures();
   std::vector<InputArgumentType> original_input_arguments = *input_arguments;
@@ -1072,6 +1125,14 @@ FunctionResolver::FindMatchingSignature(
     }
   }
 
+  if (matched_signature_key.has_value() && best_result_signature != nullptr &&
+      best_result_arg_overrides.empty()) {
+    matched_signatures_.emplace(
+        std::move(*matched_signature_key),
+        MatchedSignature{
+            std::make_unique<const FunctionSignature>(*best_result_signature),
+            *input_arguments, *arg_index_mapping_out});
+  }
   if (arg_overrides != nullptr) {
     *arg_overrides = std::move(best_result_arg_overrides);
   }
@@ -2420,6 +2481,21 @@ absl::Status FunctionResolver::ResolveTemplatedSQLFunctionCall(
     const AnalyzerOptions& analyzer_options,
     absl::Span<const InputArgumentType> actual_arguments,
     std::shared_ptr<ResolvedFunctionCallInfo>* function_call_info_out) {
+  Catalog* catalog = catalog_;
+  if (function.resolution_catalog() != nullptr) {
+    catalog = function.resolution_catalog();
+  }
+  if (function.cache_resolved_calls()) {
+    std::shared_ptr<ResolvedFunctionCallInfo> cached_call =
+        function.FindResolvedCall(catalog, type_factory_,
+                                  analyzer_options.language(),
+                                  actual_arguments);
+    if (cached_call != nullptr) {
+      *function_call_info_out = std::move(cached_call);
+      return absl::OkStatus();
+    }
+  }
+
   // Check if this function calls itself. If so, return an error. Otherwise, add
   // a pointer to this class to the cycle detector in the analyzer options.
   CycleDetector::ObjectInfo object(
@@ -2476,10 +2552,6 @@ absl::Status FunctionResolver::ResolveTemplatedSQLFunctionCall(
         analyzer_options.error_message_options()));
     expression = parser_output_storage->expression();
   }
-  Catalog* catalog = catalog_;
-  if (function.resolution_catalog() != nullptr) {
-    catalog = function.resolution_catalog();
-  }
 
   // Create a separate new resolver and resolve the function's SQL expression,
   // using the specified function arguments.
@@ -2553,9 +2625,20 @@ absl::Status FunctionResolver::ResolveTemplatedSQLFunctionCall(
     }
   }
 
-  function_call_info_out->reset(new TemplatedSQLFunctionCall(
+  auto call = std::make_unique<TemplatedSQLFunctionCall>(
       std::move(resolved_sql_body),
-      query_resolution_info->release_aggregate_columns_to_compute()));
+      query_resolution_info->release_aggregate_columns_to_compute());
+  if (!function.cache_resolved_calls()) {
+    *function_call_info_out = std::move(call);
+    return absl::OkStatus();
+  }
+  // The call refers to IdStrings of the statement's IdStringPool, which must
+  // live as long as the call, since it may outlive the statement.
+  function_call_info_out->reset(
+      call.release(), [id_string_pool = analyzer_options.id_string_pool()](
+                          ResolvedFunctionCallInfo* info) { delete info; });
+  function.AddResolvedCall(catalog, type_factory_, analyzer_options.language(),
+                           actual_arguments, *function_call_info_out);
 
   return absl::OkStatus();
 }
@@ -19,6 +19,7 @@
 
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -40,6 +41,7 @@
 #include "zetasql/public/types/type_parameters.h"
 #include "zetasql/public/value.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
@@ -354,6 +356,32 @@ class FunctionResolver {
   TypeFactory* type_factory_;  // Not owned.
   Resolver* resolver_;         // Not owned.
 
+  // The result of a FindMatchingSignature() call that depended on nothing but
+  // the Function and the Types of its arguments.
+  struct MatchedSignature {
+    std::unique_ptr<const FunctionSignature> signature;
+    std::vector<InputArgumentType> input_arguments;
+    std::vector<ArgIndexEntry> arg_index_mapping;
+  };
+  using MatchedSignatureKey =
+      std::pair<const Function*, std::vector<const Type*>>;
+
+  // Memo of FindMatchingSignature() for calls of builtin functions, so that a
+  // statement that calls the same overloaded function on the same argument
+  // types many times only scores its signatures once.
+  mutable absl::flat_hash_map<MatchedSignatureKey, MatchedSignature>
+      matched_signatures_;
+
+  // Returns the key of a FindMatchingSignature() call in
+  // 'matched_signatures_', or nullopt if the call cannot be memoized, e.g.
+  // because it has literal, lambda or named arguments.
+  static std::optional<MatchedSignatureKey> GetMatchedSignatureKey(
+      const Function* function,
+      const std::vector<const ASTNode*>& arg_locations,
+      const std::vector<NamedArgumentInfo>& named_arguments,
+      const std::vector<InputArgumentType>& input_arguments,
+      const std::vector<std::string>* mismatch_errors);
+
   // Returns a signature that matches the argument type list, returning
   // a concrete FunctionSignature if found.  If not found, returns NULL.
   // The caller takes ownership of the returned FunctionSignature.
@@ -29,6 +29,7 @@
 
 #include "zetasql/base/logging.h"
 #include "zetasql/analyzer/path_expression_span.h"
+#include "zetasql/common/resolver_profile.h"
 #include "zetasql/parser/parse_tree.h"
 #include "zetasql/parser/parse_tree_errors.h"
 #include "zetasql/public/catalog_helper.h"
@@ -148,6 +149,8 @@ NameScope::NameScope(const NameScope* previous_scope,
                      CorrelatedColumnsSet* correlated_columns_set)
     : previous_scope_(previous_scope),
       correlated_columns_set_(correlated_columns_set) {
+  internal::ScopedResolverOperation profile_operation(
+      AnalyzerLogEntry::NAME_SCOPE_CONSTRUCTION);
   // Copy state_ from the new name targets and value table columns.
   *mutable_names() = name_targets;
   *mutable_value_table_columns() = value_table_columns;
@@ -170,6 +173,20 @@ void NameScope::CopyStateFrom(const NameScope& other) {
   state_ = other.state_;
 }
 
+const NameScope::State& NameScope::state() const {
+  static const auto& empty_state = *new State;
+  return state_ != nullptr ? *state_ : empty_state;
+}
+
+NameScope::State* NameScope::mutable_state() {
+  if (state_ == nullptr) {
+    state_ = std::make_shared<State>();
+  } else if (state_.use_count() > 1) {
+    state_ = std::make_shared<State>(*state_);
+  }
+  return state_.get();
+}
+
 void NameScope::AddNameTarget(IdString name, const NameTarget& target) {
   ABSL_DCHECK(!name.empty()) << "Empty name not expected in NameScope";
   ABSL_DCHECK(!IsInternalAlias(name)) << "Internal names not expected in NameScope";
@@ -752,6 +769,8 @@ void NameScope::ExcludeNameFromValueTableIfPresent(
 absl::Status NameScope::CopyNameScopeWithOverridingNames(
     const std::shared_ptr<NameList>& namelist_with_overriding_names,
     std::unique_ptr<NameScope>* scope_with_new_names) const {
+  internal::ScopedResolverOperation profile_operation(
+      AnalyzerLogEntry::NAME_SCOPE_CONSTRUCTION);
   // The namelist_with_overriding_names cannot currently include
   // value table columns, range variables, or pseudocolumns.
   ZETASQL_RET_CHECK(!namelist_with_overriding_names->HasValueTableColumns());
@@ -790,6 +809,8 @@ absl::Status NameScope::CopyNameScopeWithOverridingNames(
 absl::Status NameScope::CopyNameScopeWithOverridingNameTargets(
     const IdStringHashMapCase<NameTarget>& overriding_name_targets,
     std::unique_ptr<NameScope>* scope_with_new_names) const {
+  internal::ScopedResolverOperation profile_operation(
+      AnalyzerLogEntry::NAME_SCOPE_CONSTRUCTION);
   // We will merge this NameScope's local names with the new NameTargets,
   // where the new NameTargets override the current names (rather
   // than making conflicting names ambiguous).
@@ -1110,6 +1131,8 @@ absl::Status NameScope::CreateNewLocalNameTargetsGivenValidNamePaths(
 absl::Status NameScope::CreateNameScopeGivenValidNamePaths(
     const ValidFieldInfoMap& valid_field_info_map_in,
     std::unique_ptr<NameScope>* new_name_scope) const {
+  internal::ScopedResolverOperation profile_operation(
+      AnalyzerLogEntry::NAME_SCOPE_CONSTRUCTION);
   IdStringHashMapCase<NameTarget> new_name_targets;
   ZETASQL_RETURN_IF_ERROR(
       CreateNewLocalNameTargetsGivenValidNamePaths(valid_field_info_map_in,
@@ -1230,10 +1253,26 @@ NameList::NameList() {
 NameList::~NameList() {
 }
 
+// static
+const std::vector<NamedColumn>& NameList::EmptyColumns() {
+  static const auto& empty_columns = *new std::vector<NamedColumn>;
+  return empty_columns;
+}
+
+std::vector<NamedColumn>* NameList::mutable_columns() {
+  select_star_index_.reset();
+  if (columns_ == nullptr) {
+    columns_ = std::make_shared<std::vector<NamedColumn>>();
+  } else if (columns_.use_count() > 1) {
+    columns_ = std::make_shared<std::vector<NamedColumn>>(*columns_);
+  }
+  return columns_.get();
+}
+
 absl::Status NameList::AddColumn(
     IdString name, const ResolvedColumn& column, bool is_explicit) {
   ZETASQL_RET_CHECK(!is_value_table()) << "Cannot add more columns to a value table";
-  columns_.emplace_back(name, column, is_explicit);
+  mutable_columns()->emplace_back(name, column, is_explicit);
   if (!IsInternalAlias(name)) {
     name_scope_.AddColumn(name, column, is_explicit);
   }
@@ -1269,7 +1308,7 @@ absl::Status NameList::AddValueTableColumn(
   // as a column.  It will never be expanded by SELECT * (without rangevar.*),
   // so excluded_field_names is not actually used, but we fill it in for
   // clarity.
-  value_table_name_list->columns_.emplace_back(
+  value_table_name_list->mutable_columns()->emplace_back(
       kValueTableName, column, false /* is_explicit */, excluded_field_names);
   value_table_name_list->name_scope_
       .mutable_value_table_columns()->push_back(
@@ -1289,8 +1328,8 @@ absl::Status NameList::AddValueTableColumn(
 
   // We put in an implicit column that will expand to the value table column
   // in select star.
-  columns_.emplace_back(range_variable_name, column, false /* is_explicit */,
-                        excluded_field_names);
+  mutable_columns()->emplace_back(range_variable_name, column,
+                                 false /* is_explicit */, excluded_field_names);
 
   if (!IsInternalAlias(range_variable_name)) {
     // Add the value table column as a range variable in the NameScope.
@@ -1391,10 +1430,11 @@ absl::Status NameList::MergeFrom(const NameList& other,
   ABSL_DCHECK_NE(&other, this) << "Merging NameList with itself";
   ABSL_DCHECK(ast_location != nullptr);
 
-  if (columns_.empty() && name_scope_.IsEmpty()) {
+  if (columns().empty() && name_scope_.IsEmpty()) {
     // Optimization: When merging into an empty NameList with no options,
-    // we can just copy the full state.
+    // we can just share the full state, which is copied on write.
     columns_ = other.columns_;
+    select_star_index_.reset();
     name_scope_.CopyStateFrom(other.name_scope_);
     return absl::OkStatus();
   }
@@ -1429,8 +1469,8 @@ absl::Status NameList::MergeFrom(const NameList& other,
     }
 
     if (replacement_column != nullptr) {
-      columns_.push_back(NamedColumn(named_column.name(), *replacement_column,
-                                     /*is_explicit=*/true));
+      mutable_columns()->push_back(NamedColumn(
+          named_column.name(), *replacement_column, /*is_explicit=*/true));
     } else if (excluded_field_names == nullptr ||
                !zetasql_base::ContainsKey(*excluded_field_names, named_column.name())) {
       // For value table columns, we add new excluded_field_names so fields
@@ -1468,11 +1508,11 @@ absl::Status NameList::MergeFrom(const NameList& other,
 
         // Copy the column, but update excluded_field_names with the
         // new list.
-        columns_.emplace_back(new_name, named_column.column(),
-                              named_column.is_explicit(),
-                              new_excluded_field_names);
+        mutable_columns()->emplace_back(new_name, named_column.column(),
+                                        named_column.is_explicit(),
+                                        new_excluded_field_names);
       } else {
-        columns_.push_back(named_column);
+        mutable_columns()->push_back(named_column);
       }
     }
   }
@@ -1599,8 +1639,8 @@ absl::StatusOr<std::shared_ptr<NameList>> NameList::CloneWithNewColumns(
 
 std::vector<ResolvedColumn> NameList::GetResolvedColumns() const {
   std::vector<ResolvedColumn> ret;
-  ret.reserve(columns_.size());
-  for (const NamedColumn& named_column : columns_) {
+  ret.reserve(columns().size());
+  for (const NamedColumn& named_column : columns()) {
     ret.push_back(named_column.column());
   }
   return ret;
@@ -1608,8 +1648,8 @@ std::vector<ResolvedColumn> NameList::GetResolvedColumns() const {
 
 std::vector<IdString> NameList::GetColumnNames() const {
   std::vector<IdString> ret;
-  ret.reserve(columns_.size());
-  for (const NamedColumn& named_column : columns_) {
+  ret.reserve(columns().size());
+  for (const NamedColumn& named_column : columns()) {
     ret.push_back(named_column.name());
   }
   return ret;
@@ -1624,40 +1664,48 @@ bool NameList::LookupName(IdString name, NameTarget* found) const {
 Type::HasFieldResult NameList::SelectStarHasColumn(IdString name) const {
   if (name.empty()) return Type::HAS_NO_FIELD;
 
-  int fields_found = 0;
-  for (const NamedColumn& column : columns_) {
-    // Value table columns *with fields* will be expanded to the list of
-    // fields rather than the column itself in SELECT *.
-    if (!column.is_value_table_column() ||
-        !column.column().type()->HasAnyFields()) {
-      if (IdStringCaseEqual(column.name(), name)) {
-        ++fields_found;
-      }
-    } else {
-      if (zetasql_base::ContainsKey(column.excluded_field_names(), name)) {
-        continue;
-      }
-      switch (
-          column.column().type()->HasField(name.ToString(),
-                                           /*field_id=*/nullptr,
-                                           /*include_pseudo_fields=*/false)) {
-        case Type::HAS_NO_FIELD:
-          break;
-        case Type::HAS_FIELD:
-          ++fields_found;
-          break;
-        case Type::HAS_AMBIGUOUS_FIELD:
-          fields_found += 2;
-          break;
-        case Type::HAS_PSEUDO_FIELD:
-          ABSL_DLOG(FATAL) << "Type::HasField returned unexpected HAS_PSEUDO_FIELD "
-                         "value when "
-                         "called with include_pseudo_fields=false argument";
-          break;
+  if (select_star_index_ == nullptr) {
+    auto index = std::make_unique<SelectStarIndex>();
+    for (int i = 0; i < num_columns(); ++i) {
+      const NamedColumn& column = columns()[i];
+      // Value table columns *with fields* will be expanded to the list of
+      // fields rather than the column itself in SELECT *.
+      if (!column.is_value_table_column() ||
+          !column.column().type()->HasAnyFields()) {
+        ++index->column_name_counts[column.name()];
+      } else {
+        index->value_table_columns_with_fields.push_back(i);
       }
     }
+    select_star_index_ = std::move(index);
+  }
 
+  int fields_found = zetasql_base::FindWithDefault(
+      select_star_index_->column_name_counts, name, 0);
+  for (const int i : select_star_index_->value_table_columns_with_fields) {
     if (fields_found > 1) break;
+
+    const NamedColumn& column = columns()[i];
+    if (zetasql_base::ContainsKey(column.excluded_field_names(), name)) {
+      continue;
+    }
+    switch (column.column().type()->HasField(name.ToString(),
+                                             /*field_id=*/nullptr,
+                                             /*include_pseudo_fields=*/false)) {
+      case Type::HAS_NO_FIELD:
+        break;
+      case Type::HAS_FIELD:
+        ++fields_found;
+        break;
+      case Type::HAS_AMBIGUOUS_FIELD:
+        fields_found += 2;
+        break;
+      case Type::HAS_PSEUDO_FIELD:
+        ABSL_DLOG(FATAL)
+            << "Type::HasField returned unexpected HAS_PSEUDO_FIELD value when "
+               "called with include_pseudo_fields=false argument";
+        break;
+    }
   }
 
   switch (fields_found) {
@@ -1683,7 +1731,7 @@ std::string NameList::DebugString(absl::string_view indent) const {
   // NameList.  If not, they must have been pseudo-columns.
   IdStringSetCase name_list_columns;
 
-  for (const NamedColumn& named_column : columns_) {
+  for (const NamedColumn& named_column : columns()) {
     if (!out.empty()) out += "\n";
     absl::StrAppend(&out, indent, "  ", named_column.DebugString());
 
@@ -765,7 +765,8 @@ class NameScope {
 
   // The local state for this NameScope is stored in this struct which is
   // stored in a CopyOnWrite.  This allows cheap copies when constructing
-  // NameScopes from NameLists and in NameList::MergeFrom.
+  // NameScopes from NameLists and in NameList::MergeFrom, which matters for
+  // very wide tables.
   struct State {
     // This is the main map storing the names visible in this local scope
     // (not including names from parent scopes).
@@ -777,26 +778,28 @@ class NameScope {
     // When looking up a name, we also look for fields of any of these columns
     // (except for fields marked as excluded for each value table column).
     std::vector<ValueTableColumn> value_table_columns;
-
-    void CopyFrom(const State& other) {
-      names = other.names;
-      value_table_columns = other.value_table_columns;
-    }
   };
-  State state_;
+  // Shared with the NameScopes and NameLists that this state was copied from
+  // or to, until one of them is modified. NULL means the state is empty.
+  std::shared_ptr<State> state_;
+
+  // Returns state_, or an empty State if it is NULL.
+  const State& state() const;
+  // Returns state_ for modification, first copying it if it is shared.
+  State* mutable_state();
 
   // Accessors for fields inside the CopyOnWrite state_.
   const IdStringHashMapCase<NameTarget>& names() const {
-    return state_.names;
+    return state().names;
   }
   IdStringHashMapCase<NameTarget>* mutable_names() {
-    return &state_.names;
+    return &mutable_state()->names;
   }
   const std::vector<ValueTableColumn>& value_table_columns() const {
-    return state_.value_table_columns;
+    return state().value_table_columns;
   }
   std::vector<ValueTableColumn>* mutable_value_table_columns() {
-    return &state_.value_table_columns;
+    return &mutable_state()->value_table_columns;
   }
 
   // These are used internally to optimize copying.
@@ -883,7 +886,7 @@ class NameList {
 
   // Prepare this NameList for 'size' new columns. This is for efficiency
   // purposes only.
-  void ReserveColumns(size_t size) { columns_.reserve(size); }
+  void ReserveColumns(size_t size) { mutable_columns()->reserve(size); }
 
   // Add a named column.
   // <is_explicit> should be true if the alias for this column is an explicit
@@ -1014,9 +1017,11 @@ class NameList {
       IdStringPool* id_string_pool) const;
 
   // Get the regular columns in this NameList.  Does not include pseudo-columns.
-  int num_columns() const { return columns_.size(); }
-  const std::vector<NamedColumn>& columns() const { return columns_; }
-  const NamedColumn& column(int i) const { return columns_[i]; }
+  int num_columns() const { return columns().size(); }
+  const std::vector<NamedColumn>& columns() const {
+    return columns_ != nullptr ? *columns_ : EmptyColumns();
+  }
+  const NamedColumn& column(int i) const { return columns()[i]; }
 
   // Return vector of ResolvedColumns contained in columns().
   std::vector<ResolvedColumn> GetResolvedColumns() const;
@@ -1081,7 +1086,26 @@ class NameList {
   // This is the vector of columns that will show up in SELECT *.
   // Some will be marked as value tables; those may be expanded further
   // during SELECT * to show their fields instead of the value itself.
-  std::vector<NamedColumn> columns_;
+  // Like the state of <name_scope_>, this is copy-on-write, and is shared with
+  // the NameLists it was copied from or to in MergeFrom(). NULL means there
+  // are no columns.
+  std::shared_ptr<std::vector<NamedColumn>> columns_;
+
+  // The number of columns with each name in SELECT *, not counting value
+  // table columns with fields, and the positions of those value table columns.
+  // Built by the first call to SelectStarHasColumn(), so that looking up
+  // all the names of a SELECT * EXCEPT list is linear in the number of
+  // columns, and reset whenever the columns change.
+  struct SelectStarIndex {
+    IdStringHashMapCase<int> column_name_counts;
+    std::vector<int> value_table_columns_with_fields;
+  };
+  mutable std::unique_ptr<const SelectStarIndex> select_star_index_;
+
+  static const std::vector<NamedColumn>& EmptyColumns();
+
+  // Returns columns_ for modification, first copying it if it is shared.
+  std::vector<NamedColumn>* mutable_columns();
 
   // This stores all resolvable names in the NameList, including range
   // variables and pseudo-columns, but excluding anonymous columns.
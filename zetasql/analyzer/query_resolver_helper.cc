@@ -38,6 +38,7 @@
 #include "zetasql/public/strings.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/column_id_set.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
 #include "zetasql/resolved_ast/resolved_column.h"
 #include "zetasql/resolved_ast/resolved_node_kind.pb.h"
@@ -58,14 +59,14 @@ namespace {
 // Converts a list of ResolvedComputedColumn to a list ResolvedColumnRef.
 std::vector<std::unique_ptr<const ResolvedColumnRef>> MakeResolvedColumnRefs(
     absl::Span<const ResolvedComputedColumn* const> column_list) {
-  absl::flat_hash_set<ResolvedColumn> distinct_column_set;
+  ColumnIdSet distinct_column_ids;
   std::vector<std::unique_ptr<const ResolvedColumnRef>> column_ref_list;
   for (const ResolvedComputedColumn* computed_column : column_list) {
     std::unique_ptr<ResolvedColumnRef> column_ref = MakeResolvedColumnRef(
         computed_column->column().type(), computed_column->column(),
         /*is_correlated=*/false);
     // Don't duplicate columns in a the grouping set.
-    if (zetasql_base::InsertIfNotPresent(&distinct_column_set, column_ref->column())) {
+    if (distinct_column_ids.insert(column_ref->column().column_id())) {
       column_ref_list.push_back(std::move(column_ref));
     }
   }
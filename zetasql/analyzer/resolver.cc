@@ -44,6 +44,7 @@
 #include "zetasql/analyzer/query_resolver_helper.h"
 #include "zetasql/analyzer/resolver_common_inl.h"
 #include "zetasql/common/errors.h"
+#include "zetasql/common/resolver_profile.h"
 #include "zetasql/common/status_payload_utils.h"
 #include "zetasql/parser/ast_node_kind.h"
 #include "zetasql/parser/parse_tree.h"
@@ -719,10 +720,13 @@ absl::Status Resolver::ResolvePathExpressionAsType(
     single_name = absl::StrJoin(path_expr->ToIdentifierVector(), ".");
   }
 
-  const absl::Status status = catalog_->FindType(
-      (is_single_identifier ? std::vector<std::string>{single_name}
-                            : identifier_path),
-      resolved_type, analyzer_options_.find_options());
+  const absl::Status status = internal::ProfileResolverOperation(
+      AnalyzerLogEntry::CATALOG_TYPE_LOOKUP, [&] {
+        return catalog_->FindType(
+            (is_single_identifier ? std::vector<std::string>{single_name}
+                                  : identifier_path),
+            resolved_type, analyzer_options_.find_options());
+      });
   if (status.code() == absl::StatusCode::kNotFound ||
       // TODO: Ideally, Catalogs should not include unsupported types.
       // As such, we should remove the IsSupportedType() check. But we need to
@@ -2103,8 +2107,11 @@ absl::Status Resolver::FindTable(const ASTPathExpression* name,
   ZETASQL_RET_CHECK(name != nullptr);
   ZETASQL_RET_CHECK(table != nullptr);
 
-  absl::Status status = catalog_->FindTable(name->ToIdentifierVector(), table,
-                                            analyzer_options_.find_options());
+  absl::Status status = internal::ProfileResolverOperation(
+      AnalyzerLogEntry::CATALOG_TABLE_LOOKUP, [&] {
+        return catalog_->FindTable(name->ToIdentifierVector(), table,
+                                   analyzer_options_.find_options());
+      });
   if (status.code() == absl::StatusCode::kNotFound) {
     std::string message;
     absl::StrAppend(&message,
@@ -52,6 +52,7 @@
 #include "zetasql/analyzer/resolver_common_inl.h"
 #include "zetasql/common/errors.h"
 #include "zetasql/common/internal_analyzer_options.h"
+#include "zetasql/common/resolver_profile.h"
 #include "zetasql/parser/ast_node.h"
 #include "zetasql/parser/ast_node_kind.h"
 #include "zetasql/parser/parse_tree.h"
@@ -108,6 +109,7 @@
 #include "zetasql/resolved_ast/resolved_node_kind.pb.h"
 #include "zetasql/base/case.h"
 #include "zetasql/base/string_numbers.h"  
+#include "absl/algorithm/container.h"
 #include "absl/cleanup/cleanup.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
@@ -618,8 +620,11 @@ absl::StatusOr<const google::protobuf::Descriptor*> Resolver::FindMessageTypeFor
   }
 
   const Type* found_type = nullptr;
-  const absl::Status find_type_status = catalog_->FindType(
-      type_name_path, &found_type, analyzer_options_.find_options());
+  const absl::Status find_type_status = internal::ProfileResolverOperation(
+      AnalyzerLogEntry::CATALOG_TYPE_LOOKUP, [&] {
+        return catalog_->FindType(type_name_path, &found_type,
+                                  analyzer_options_.find_options());
+      });
   if (find_type_status.code() == absl::StatusCode::kNotFound) {
     // We don't give an error if it wasn't found.  That will happen in
     // the caller so it has a chance to try generating a better error.
@@ -1744,9 +1749,12 @@ absl::Status Resolver::ResolvePathExpressionAsExpression(
     // possible prefix of <path_expr> to a named constant.
     const Constant* constant = nullptr;
     absl::Status find_constant_with_path_prefix_status =
-        catalog_->FindConstantWithPathPrefix(path_expr.ToIdentifierVector(),
-                                             &num_names_consumed, &constant,
-                                             analyzer_options_.find_options());
+        internal::ProfileResolverOperation(
+            AnalyzerLogEntry::CATALOG_OTHER_LOOKUP, [&] {
+              return catalog_->FindConstantWithPathPrefix(
+                  path_expr.ToIdentifierVector(), &num_names_consumed,
+                  &constant, analyzer_options_.find_options());
+            });
 
     // Handle the case where a constant was found or some internal error
     // occurred. If no constant was found, <num_names_consumed> is set to 0.
@@ -3736,6 +3744,44 @@ absl::Status Resolver::ResolveBetweenExpr(
   return absl::OkStatus();
 }
 
+namespace {
+// Returns the operands of an associative n-ary operator node of NodeType, with
+// operands that are (parenthesized) calls to the same operator replaced by
+// their own operands, recursively. The parser already flattens chains like
+// `a OR b OR c`, but not `(a OR b) OR c`, which generated predicates often look
+// like. Without this, every level of such a chain is another recursion of
+// ResolveExpr and another $and/$or call. Returns <operands> itself if nothing
+// is nested, otherwise the flattened operands, stored in <flattened>.
+template <typename NodeType>
+absl::Span<const ASTExpression* const> FlattenNestedOperands(
+    absl::Span<const ASTExpression* const> operands,
+    std::vector<const ASTExpression*>* flattened) {
+  auto is_nested = [](const ASTExpression* operand) {
+    return operand->node_kind() == NodeType::kConcreteNodeKind;
+  };
+  if (!absl::c_any_of(operands, is_nested)) {
+    return operands;
+  }
+  // The operands still to be flattened, the next one at the back. Uses an
+  // explicit stack so that deeply nested chains do not recurse.
+  std::vector<const ASTExpression*> pending(operands.rbegin(),
+                                            operands.rend());
+  while (!pending.empty()) {
+    const ASTExpression* operand = pending.back();
+    pending.pop_back();
+    if (is_nested(operand)) {
+      // All children of the operator node are operands.
+      for (int i = operand->num_children() - 1; i >= 0; --i) {
+        pending.push_back(operand->child(i)->GetAsOrDie<ASTExpression>());
+      }
+    } else {
+      flattened->push_back(operand);
+    }
+  }
+  return *flattened;
+}
+}  // namespace
+
 // TODO: The noinline attribute is to prevent the stack usage
 // being added to its caller "Resolver::ResolveExpr" which is a recursive
 // function. Now the attribute has to be added for all callees. Hopefully
@@ -3745,9 +3791,12 @@ absl::Status Resolver::ResolveAndExpr(
     const ASTAndExpr* and_expr, ExprResolutionInfo* expr_resolution_info,
     std::unique_ptr<const ResolvedExpr>* resolved_expr_out) {
   RETURN_ERROR_IF_OUT_OF_STACK_SPACE();
+  std::vector<const ASTExpression*> flattened_conjuncts;
   return ResolveFunctionCallByNameWithoutAggregatePropertyCheck(
-      and_expr, "$and", and_expr->conjuncts(), *kEmptyArgumentOptionMap,
-      expr_resolution_info, resolved_expr_out);
+      and_expr, "$and",
+      FlattenNestedOperands<ASTAndExpr>(and_expr->conjuncts(),
+                                        &flattened_conjuncts),
+      *kEmptyArgumentOptionMap, expr_resolution_info, resolved_expr_out);
 }
 
 // TODO: The noinline attribute is to prevent the stack usage
@@ -3759,9 +3808,12 @@ absl::Status Resolver::ResolveOrExpr(
     const ASTOrExpr* or_expr, ExprResolutionInfo* expr_resolution_info,
     std::unique_ptr<const ResolvedExpr>* resolved_expr_out) {
   RETURN_ERROR_IF_OUT_OF_STACK_SPACE();
+  std::vector<const ASTExpression*> flattened_disjuncts;
   return ResolveFunctionCallByNameWithoutAggregatePropertyCheck(
-      or_expr, "$or", or_expr->disjuncts(), *kEmptyArgumentOptionMap,
-      expr_resolution_info, resolved_expr_out);
+      or_expr, "$or",
+      FlattenNestedOperands<ASTOrExpr>(or_expr->disjuncts(),
+                                       &flattened_disjuncts),
+      *kEmptyArgumentOptionMap, expr_resolution_info, resolved_expr_out);
 }
 
 void Resolver::FetchCorrelatedSubqueryParameters(
@@ -3783,6 +3835,8 @@ absl::Status Resolver::ResolveExprSubquery(
     const ASTExpressionSubquery* expr_subquery,
     ExprResolutionInfo* expr_resolution_info, const Type* inferred_type,
     std::unique_ptr<const ResolvedExpr>* resolved_expr_out) {
+  internal::ScopedResolverOperation profile_operation(
+      AnalyzerLogEntry::SUBQUERY_RESOLUTION);
   if (generated_column_cycle_detector_ != nullptr) {
     return MakeSqlErrorAt(expr_subquery)
            << "Generated column expression must not include a subquery";
@@ -4811,9 +4865,12 @@ absl::Status Resolver::ResolveSequence(
     const ASTPathExpression* path_expr,
     std::unique_ptr<const ResolvedSequence>* resolved_sequence) {
   const Sequence* sequence = nullptr;
-  const absl::Status find_status =
-      catalog_->FindSequence(path_expr->ToIdentifierVector(), &sequence,
-                             analyzer_options_.find_options());
+  const absl::Status find_status = internal::ProfileResolverOperation(
+      AnalyzerLogEntry::CATALOG_OTHER_LOOKUP, [&] {
+        return catalog_->FindSequence(path_expr->ToIdentifierVector(),
+                                      &sequence,
+                                      analyzer_options_.find_options());
+      });
 
   if (find_status.code() == absl::StatusCode::kNotFound) {
     std::string error_message;
@@ -8104,6 +8161,8 @@ absl::Status Resolver::LookupFunctionFromCatalog(
     const std::vector<std::string>& function_name_path,
     FunctionNotFoundHandleMode handle_mode, const Function** function,
     ResolvedFunctionCallBase::ErrorMode* error_mode) const {
+  internal::ScopedResolverOperation profile_operation(
+      AnalyzerLogEntry::CATALOG_FUNCTION_LOOKUP);
   *error_mode = ResolvedFunctionCallBase::DEFAULT_ERROR_MODE;
 
   // This is the function name path with SAFE stripped off, if applicable.
@@ -8402,6 +8461,8 @@ absl::Status Resolver::CoerceExprToType(
     const ASTNode* ast_location, AnnotatedType annotated_target_type,
     CoercionMode mode, CoercionErrorMessageFunction make_error,
     std::unique_ptr<const ResolvedExpr>* resolved_expr) const {
+  internal::ScopedResolverOperation profile_operation(
+      AnalyzerLogEntry::COERCION);
   const Type* target_type = annotated_target_type.type;
   const AnnotationMap* target_type_annotation_map =
       annotated_target_type.annotation_map;
@@ -51,6 +51,7 @@
 #include "zetasql/analyzer/resolver.h"
 #include "zetasql/analyzer/resolver_common_inl.h"
 #include "zetasql/common/errors.h"
+#include "zetasql/common/resolver_profile.h"
 #include "zetasql/public/function_signature.h"
 #include "zetasql/public/functions/array_zip_mode.pb.h"
 #include "zetasql/public/input_argument_type.h"
@@ -94,6 +95,7 @@
 #include "zetasql/public/types/type_modifiers.h"
 #include "zetasql/public/types/type_parameters.h"
 #include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/column_id_set.h"
 #include "zetasql/resolved_ast/make_node_vector.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
 #include "zetasql/resolved_ast/resolved_ast_builder.h"
@@ -870,14 +872,16 @@ absl::Status Resolver::MaybeAddProjectForColumnPruning(
     std::unique_ptr<const ResolvedScan>* current_scan) {
   RETURN_ERROR_IF_OUT_OF_STACK_SPACE();
 
-  const absl::flat_hash_set<ResolvedColumn> old_visible_columns(
-      (*current_scan)->column_list().begin(),
-      (*current_scan)->column_list().end());
+  ColumnIdSet old_visible_columns;
+  for (const ResolvedColumn& column : (*current_scan)->column_list()) {
+    old_visible_columns.insert(column.column_id());
+  }
 
-  absl::flat_hash_set<ResolvedColumn> keep_columns;
+  ColumnIdSet keep_columns;
   for (const ResolvedColumn& column : name_list.GetResolvedColumns()) {
-    keep_columns.insert(column);
-    ZETASQL_RET_CHECK(old_visible_columns.contains(column)) << column.DebugString();
+    keep_columns.insert(column.column_id());
+    ZETASQL_RET_CHECK(old_visible_columns.contains(column.column_id()))
+        << column.DebugString();
   }
 
   // To minimize the changes to existing ProjectScans, rather than using the
@@ -886,7 +890,7 @@ absl::Status Resolver::MaybeAddProjectForColumnPruning(
   bool did_pruning = false;
   ResolvedColumnList pruned_column_list;
   for (const ResolvedColumn& column : (*current_scan)->column_list()) {
-    if (keep_columns.contains(column)) {
+    if (keep_columns.contains(column.column_id())) {
       pruned_column_list.push_back(column);
     } else {
       did_pruning = true;
@@ -9154,9 +9158,12 @@ absl::StatusOr<const TableValuedFunction*> FindTVFOrMakeNiceError(
     absl::string_view tvf_name_string, const ASTTVF* ast_tvf,
     const AnalyzerOptions& analyzer_options, Catalog* catalog) {
   const TableValuedFunction* tvf_catalog_entry = nullptr;
-  const absl::Status find_status = catalog->FindTableValuedFunction(
-      ast_tvf->name()->ToIdentifierVector(), &tvf_catalog_entry,
-      analyzer_options.find_options());
+  const absl::Status find_status = internal::ProfileResolverOperation(
+      AnalyzerLogEntry::CATALOG_TABLE_VALUED_FUNCTION_LOOKUP, [&] {
+        return catalog->FindTableValuedFunction(
+            ast_tvf->name()->ToIdentifierVector(), &tvf_catalog_entry,
+            analyzer_options.find_options());
+      });
   if (find_status.code() == absl::StatusCode::kNotFound) {
     std::string error_message;
     absl::StrAppend(&error_message,
@@ -10378,9 +10385,12 @@ absl::Status Resolver::ResolveArrayArgumentForExplicitUnnest(
         argument->expression()->GetAsOrDie<ASTPathExpression>();
     const Table* table = nullptr;
     int num_names_consumed = 0;
-    const absl::Status find_status = catalog_->FindTableWithPathPrefix(
-        path_expr->ToIdentifierVector(), analyzer_options_.find_options(),
-        &num_names_consumed, &table);
+    const absl::Status find_status = internal::ProfileResolverOperation(
+        AnalyzerLogEntry::CATALOG_TABLE_LOOKUP, [&] {
+          return catalog_->FindTableWithPathPrefix(
+              path_expr->ToIdentifierVector(), analyzer_options_.find_options(),
+              &num_names_consumed, &table);
+        });
 
     if (find_status.ok()) {
       if (table != nullptr && num_names_consumed < path_expr->num_names()) {
@@ -10961,9 +10971,11 @@ absl::Status Resolver::ResolveModel(
     const ASTPathExpression* path_expr,
     std::unique_ptr<const ResolvedModel>* resolved_model) {
   const Model* model = nullptr;
-  const absl::Status find_status =
-      catalog_->FindModel(path_expr->ToIdentifierVector(), &model,
-                          analyzer_options_.find_options());
+  const absl::Status find_status = internal::ProfileResolverOperation(
+      AnalyzerLogEntry::CATALOG_OTHER_LOOKUP, [&] {
+        return catalog_->FindModel(path_expr->ToIdentifierVector(), &model,
+                                   analyzer_options_.find_options());
+      });
 
   if (find_status.code() == absl::StatusCode::kNotFound) {
     return MakeSqlErrorAt(path_expr)
@@ -11035,9 +11047,12 @@ absl::Status Resolver::ResolveConnection(
     const ASTPathExpression* path_expr,
     std::unique_ptr<const ResolvedConnection>* resolved_connection) {
   const Connection* connection = nullptr;
-  const absl::Status find_status =
-      catalog_->FindConnection(path_expr->ToIdentifierVector(), &connection,
-                               analyzer_options_.find_options());
+  const absl::Status find_status = internal::ProfileResolverOperation(
+      AnalyzerLogEntry::CATALOG_OTHER_LOOKUP, [&] {
+        return catalog_->FindConnection(path_expr->ToIdentifierVector(),
+                                        &connection,
+                                        analyzer_options_.find_options());
+      });
 
   if (find_status.code() == absl::StatusCode::kNotFound) {
     return MakeSqlErrorAt(path_expr)
@@ -11111,13 +11126,17 @@ absl::Status Resolver::ResolvePathExpressionAsTableScan(
   // Check if the table exists.
   const Table* table = nullptr;
   int num_names_consumed = 0;
-  const absl::Status find_status =
-      remaining_names != nullptr
-          ? catalog_->FindTableWithPathPrefix(path_expr->ToIdentifierVector(),
-                                              analyzer_options_.find_options(),
-                                              &num_names_consumed, &table)
-          : catalog_->FindTable(path_expr->ToIdentifierVector(), &table,
-                                analyzer_options_.find_options());
+  const absl::Status find_status = internal::ProfileResolverOperation(
+      AnalyzerLogEntry::CATALOG_TABLE_LOOKUP, [&] {
+        return remaining_names != nullptr
+                   ? catalog_->FindTableWithPathPrefix(
+                         path_expr->ToIdentifierVector(),
+                         analyzer_options_.find_options(), &num_names_consumed,
+                         &table)
+                   : catalog_->FindTable(path_expr->ToIdentifierVector(),
+                                         &table,
+                                         analyzer_options_.find_options());
+      });
   if (find_status.code() == absl::StatusCode::kNotFound) {
     if (const TableValuedFunction* tvf_catalog_entry = nullptr;
         analyzer_options()
@@ -43,6 +43,7 @@
 // This includes common macro definitions to define in the resolver cc files.
 #include "zetasql/analyzer/resolver_common_inl.h"
 #include "zetasql/common/errors.h"
+#include "zetasql/common/resolver_profile.h"
 #include "zetasql/parser/ast_node_kind.h"
 #include "zetasql/parser/parse_tree.h"
 #include "zetasql/parser/parse_tree_errors.h"
@@ -6228,9 +6229,12 @@ absl::Status Resolver::ResolveCallStatement(
   const std::string name_string =
       ast_call->procedure_name()->ToIdentifierPathString();
   const Procedure* procedure_catalog_entry = nullptr;
-  const absl::Status find_status = catalog_->FindProcedure(
-      ast_call->procedure_name()->ToIdentifierVector(),
-      &procedure_catalog_entry, analyzer_options_.find_options());
+  const absl::Status find_status = internal::ProfileResolverOperation(
+      AnalyzerLogEntry::CATALOG_OTHER_LOOKUP, [&] {
+        return catalog_->FindProcedure(
+            ast_call->procedure_name()->ToIdentifierVector(),
+            &procedure_catalog_entry, analyzer_options_.find_options());
+      });
   if (find_status.code() == absl::StatusCode::kNotFound) {
     return MakeSqlErrorAt(ast_call->procedure_name())
         << "Procedure not found: " << name_string;
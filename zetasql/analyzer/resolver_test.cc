@@ -882,6 +882,24 @@ TEST_F(ResolverTest, TestResolveFunctions) {
                        "No matching signature for function SQRT");
 }
 
+TEST_F(ResolverTest, RepeatedFunctionCallsResolveToEqualSignatures) {
+  // Later calls with the same argument types find the signature of the first
+  // call memoized by the FunctionResolver.
+  std::unique_ptr<ParserOutput> parser_output;
+  std::unique_ptr<const ResolvedExpr> resolved_expression;
+  ZETASQL_ASSERT_OK(ParseExpression(
+      "ABS(RAND()) + ABS(RAND()) = ABS(RAND()) + ABS(RAND())",
+      ParserOptions(), &parser_output));
+  ZETASQL_ASSERT_OK(ResolveExpr(parser_output->expression(), &resolved_expression));
+  ASSERT_EQ(resolved_expression->node_kind(), RESOLVED_FUNCTION_CALL);
+  const ResolvedFunctionCall* equal =
+      resolved_expression->GetAs<ResolvedFunctionCall>();
+  ASSERT_EQ(equal->argument_list_size(), 2);
+  EXPECT_EQ(equal->argument_list(0)->DebugString(),
+            equal->argument_list(1)->DebugString());
+  EXPECT_EQ(equal->argument_list(0)->type(), types::DoubleType());
+}
+
 TEST_F(ResolverTest, TestResolveAggregateExpressions) {
   ParseAndResolveFunction("Count(*)", "ZetaSQL:sum",
                           true /* is aggregation function */,
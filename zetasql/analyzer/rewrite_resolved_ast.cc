@@ -130,12 +130,27 @@ std::unique_ptr<AnalyzerOptions> AnalyzerOptionsForRewrite(
   return options_for_rewrite;
 }
 
+// Returns the rewriters of <analyzer_options.enabled_rewrites()> that apply
+// somewhere in the tree rooted at <node>.
+absl::StatusOr<absl::btree_set<ResolvedASTRewrite>>
+FindEnabledRelevantRewriters(const AnalyzerOptions& analyzer_options,
+                             const ResolvedNode* node) {
+  ZETASQL_ASSIGN_OR_RETURN(absl::btree_set<ResolvedASTRewrite> relevant_rewrites,
+                   FindRelevantRewriters(node));
+  absl::btree_set<ResolvedASTRewrite> rewrites;
+  absl::c_set_intersection(analyzer_options.enabled_rewrites(),
+                           relevant_rewrites,
+                           std::inserter(rewrites, rewrites.end()));
+  return rewrites;
+}
+
 }  // namespace
 
 namespace {
 absl::Status InternalRewriteResolvedAstNoConvertErrorLocation(
     const AnalyzerOptions& analyzer_options, Catalog* catalog,
-    TypeFactory* type_factory, AnalyzerOutput& analyzer_output) {
+    TypeFactory* type_factory, AnalyzerOutput& analyzer_output,
+    ValidatedScans* validated_input) {
   internal::ElapsedTimer rewriter_timer = internal::MakeTimerStarted();
 
   AnalyzerOutputMutator output_mutator(&analyzer_output);
@@ -206,6 +221,9 @@ absl::Status InternalRewriteResolvedAstNoConvertErrorLocation(
     if (options_for_rewrite == nullptr) {
       options_for_rewrite = AnalyzerOptionsForRewrite(
           analyzer_options, analyzer_output, fallback_sequence_number);
+      if (validated_input != nullptr) {
+        ZETASQL_RETURN_IF_ERROR(validated_input->Seal());
+      }
       last_rewrite_result = output_mutator.release_output_node();
     }
     ZETASQL_ASSIGN_OR_RETURN(
@@ -223,6 +241,8 @@ absl::Status InternalRewriteResolvedAstNoConvertErrorLocation(
   // TODO: Make this an AnalyzerOption before removing
   //     in_development from inlining rules.
   static const int64_t kMaxIterations = 25;
+  // The anonymization rewriter runs at most once; see below.
+  bool ran_anonymization = false;
   if (!rewrites_to_apply.empty()) {
     do {
       if (++iterations > kMaxIterations) {
@@ -241,6 +261,9 @@ absl::Status InternalRewriteResolvedAstNoConvertErrorLocation(
         if (options_for_rewrite == nullptr) {
           options_for_rewrite = AnalyzerOptionsForRewrite(
               analyzer_options, analyzer_output, fallback_sequence_number);
+          if (validated_input != nullptr) {
+            ZETASQL_RETURN_IF_ERROR(validated_input->Seal());
+          }
           last_rewrite_result = output_mutator.release_output_node();
         }
         const Rewriter* rewriter =
@@ -254,6 +277,9 @@ absl::Status InternalRewriteResolvedAstNoConvertErrorLocation(
         internal::ScopedTimer rewriter_details_scoped_timer =
             MakeScopedTimerStarted(&runtime_rewriter_details.timed_value);
         runtime_rewriter_details.count++;
+        if (ast_rewrite == REWRITE_ANONYMIZATION) {
+          ran_anonymization = true;
+        }
 
         ZETASQL_VLOG(2) << "Running rewriter " << rewriter->Name();
         ZETASQL_ASSIGN_OR_RETURN(
@@ -274,18 +300,25 @@ absl::Status InternalRewriteResolvedAstNoConvertErrorLocation(
         // signal that it made no meaning ful change.
         // TODO: Add a way for Rewrite to signal that it made no
         //     meaningful change.
+
+        // Find the rewriters that apply to the rewritten tree. This is much
+        // cheaper than running a rewriter, which copies the tree. Rewriters
+        // later in the registration order whose nodes were all rewritten
+        // away are skipped, and those that now apply run in this iteration
+        // already. The set is also used for the next iteration.
+        ZETASQL_ASSIGN_OR_RETURN(rewrites_to_apply,
+                         FindEnabledRelevantRewriters(
+                             analyzer_options, last_rewrite_result.get()));
+        // The checker currently cannot distinguish the output of the
+        // anonymization rewriter from its input, so it must not be offered
+        // the tree again once it has run, in this iteration or a later one.
+        // TODO: Improve the checker to avoid false positives.
+        if (ran_anonymization) {
+          rewrites_to_apply.erase(REWRITE_ANONYMIZATION);
+        }
       }
 
-      rewrites_to_apply.clear();
-      ZETASQL_ASSIGN_OR_RETURN(
-          absl::btree_set<ResolvedASTRewrite> checker_detected_rewrites,
-          FindRelevantRewriters(last_rewrite_result.get()));
-      absl::c_set_intersection(
-          analyzer_options.enabled_rewrites(), checker_detected_rewrites,
-          std::inserter(rewrites_to_apply, rewrites_to_apply.end()));
-      // The checker currently cannot distinguish the output of the
-      // anonymization rewriter from its input.
-      // TODO: Improve the checker to avoid false positives.
+      // Do not start the next iteration on a false positive from the checker.
       rewrites_to_apply.erase(REWRITE_ANONYMIZATION);
     } while (!rewrites_to_apply.empty());
   }
@@ -298,6 +331,9 @@ absl::Status InternalRewriteResolvedAstNoConvertErrorLocation(
     if (options_for_rewrite == nullptr) {
       options_for_rewrite = AnalyzerOptionsForRewrite(
           analyzer_options, analyzer_output, fallback_sequence_number);
+      if (validated_input != nullptr) {
+        ZETASQL_RETURN_IF_ERROR(validated_input->Seal());
+      }
       last_rewrite_result = output_mutator.release_output_node();
     }
     ZETASQL_ASSIGN_OR_RETURN(
@@ -319,6 +355,9 @@ absl::Status InternalRewriteResolvedAstNoConvertErrorLocation(
       ValidatorOptions validator_options{
           .allowed_hints_and_options =
               analyzer_options.allowed_hints_and_options()};
+      if (validated_input != nullptr && validated_input->sealed()) {
+        validator_options.validated_scans = validated_input;
+      }
       Validator validator(analyzer_options.language(), validator_options);
       if (analyzer_output.resolved_statement() != nullptr) {
         ZETASQL_RETURN_IF_ERROR(validator.ValidateResolvedStatement(
@@ -344,12 +383,14 @@ absl::Status InternalRewriteResolvedAstNoConvertErrorLocation(
 
 }  // namespace
 
-absl::Status InternalRewriteResolvedAst(const AnalyzerOptions& analyzer_options,
-                                        absl::string_view sql, Catalog* catalog,
-                                        TypeFactory* type_factory,
-                                        AnalyzerOutput& analyzer_output) {
+absl::Status InternalRewriteResolvedAst(
+    const AnalyzerOptions& analyzer_options, absl::string_view sql,
+    Catalog* catalog, TypeFactory* type_factory,
+    AnalyzerOutput& analyzer_output, ValidatedScans* validated_input) {
   if (analyzer_options.pre_rewrite_callback() != nullptr) {
     ZETASQL_RETURN_IF_ERROR(analyzer_options.pre_rewrite_callback()(analyzer_output));
+    // The callback may have replaced the validated resolved AST.
+    validated_input = nullptr;
   }
 
   if (analyzer_options.enabled_rewrites().empty() ||
@@ -361,7 +402,8 @@ absl::Status InternalRewriteResolvedAst(const AnalyzerOptions& analyzer_options,
   return ConvertInternalErrorLocationAndAdjustErrorString(
       analyzer_options.error_message_options(), sql,
       InternalRewriteResolvedAstNoConvertErrorLocation(
-          analyzer_options, catalog, type_factory, analyzer_output));
+          analyzer_options, catalog, type_factory, analyzer_output,
+          validated_input));
 }
 
 }  // namespace zetasql
@@ -26,6 +26,9 @@
 #include "absl/types/span.h"
 
 namespace zetasql {
+
+class ValidatedScans;
+
 // Similar to RewriteResolvedAst() in analyzer.h, except that it does
 // not register rewriters before executing. Instead, it assumes that all the
 // rewriters have already been registered. This is to prevent a dependency
@@ -33,10 +36,15 @@ namespace zetasql {
 //
 // (some rewriter class) -> internal analyzer -> InternalRewriteResolvedAst ->
 // RegisterAllRewriters -> (some rewriter class)
-absl::Status InternalRewriteResolvedAst(const AnalyzerOptions& analyzer_options,
-                                        absl::string_view sql, Catalog* catalog,
-                                        TypeFactory* type_factory,
-                                        AnalyzerOutput& analyzer_output);
+//
+// If <validated_input> is non-NULL, it holds the scans recorded while
+// validating the resolved AST in <analyzer_output>, and the validation of the
+// rewritten AST skips those that did not change.
+absl::Status InternalRewriteResolvedAst(
+    const AnalyzerOptions& analyzer_options, absl::string_view sql,
+    Catalog* catalog, TypeFactory* type_factory,
+    AnalyzerOutput& analyzer_output,
+    ValidatedScans* validated_input = nullptr);
 }  // namespace zetasql
 
 #endif  // ZETASQL_ANALYZER_REWRITE_RESOLVED_AST_H_
@@ -1708,6 +1708,39 @@ constexpr absl::string_view SetOperationTypeToString(
   }
 }
 
+// Copies <node> except for its left and right scans, which are left NULL for
+// the caller to fill in with the rewritten inputs. Deep copying the inputs only
+// to replace them would make rewriting nested joins quadratic in the size of
+// the tree, since every join would copy all the joins below it.
+absl::StatusOr<std::unique_ptr<ResolvedJoinScan>> CopyJoinScanWithoutInputs(
+    const ResolvedJoinScan* node) {
+  std::unique_ptr<ResolvedExpr> join_expr;
+  if (node->join_expr() != nullptr) {
+    ResolvedASTDeepCopyVisitor join_expr_visitor;
+    ZETASQL_RETURN_IF_ERROR(node->join_expr()->Accept(&join_expr_visitor));
+    ZETASQL_ASSIGN_OR_RETURN(join_expr,
+                     join_expr_visitor.ConsumeRootNode<ResolvedExpr>());
+  }
+  std::unique_ptr<ResolvedJoinScan> copy = MakeResolvedJoinScan(
+      node->column_list(), node->join_type(), /*left_scan=*/nullptr,
+      /*right_scan=*/nullptr, std::move(join_expr), node->has_using());
+  for (const std::unique_ptr<const ResolvedOption>& hint : node->hint_list()) {
+    ResolvedASTDeepCopyVisitor hint_visitor;
+    ZETASQL_RETURN_IF_ERROR(hint->Accept(&hint_visitor));
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ResolvedOption> hint_copy,
+                     hint_visitor.ConsumeRootNode<ResolvedOption>());
+    copy->add_hint_list(std::move(hint_copy));
+  }
+  copy->set_is_ordered(node->is_ordered());
+  copy->set_node_source(node->node_source());
+  const ParseLocationRange* parse_location =
+      node->GetParseLocationRangeOrNULL();
+  if (parse_location != nullptr) {
+    copy->SetParseLocationRange(*parse_location);
+  }
+  return copy;
+}
+
 // Rewrites the rest of the per-user scan, propagating the AnonymizationInfo()
 // userid (aka $uid column) from the base private table scan to the top node
 // returned.
@@ -2236,12 +2269,10 @@ class PerUserRewriterVisitor : public ResolvedASTDeepCopyVisitor {
     // No $uid column should have been encountered before now
     ZETASQL_RET_CHECK(!current_uid_.column.IsInitialized());
 
-    // Make a simple copy of the join node that we can swap the left and right
-    // scans out of later.
-    ResolvedASTDeepCopyVisitor join_visitor;
-    ZETASQL_RETURN_IF_ERROR(node->Accept(&join_visitor));
+    // Make a copy of the join node without its inputs, the left and right
+    // scans are rewritten and set below.
     ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ResolvedJoinScan> owned_copy,
-                     join_visitor.ConsumeRootNode<ResolvedJoinScan>());
+                     CopyJoinScanWithoutInputs(node));
     PushNodeToStack(std::move(owned_copy));
     ResolvedJoinScan* copy = GetUnownedTopOfStack<ResolvedJoinScan>();
 
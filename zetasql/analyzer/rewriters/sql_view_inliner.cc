@@ -29,11 +29,12 @@
 #include "zetasql/public/sql_view.h"
 #include "zetasql/public/types/type_factory.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
-#include "zetasql/resolved_ast/resolved_ast_deep_copy_visitor.h"
 #include "zetasql/resolved_ast/resolved_ast_enums.pb.h"
+#include "zetasql/resolved_ast/resolved_ast_rewrite_visitor.h"
 #include "zetasql/resolved_ast/resolved_node.h"
 #include "zetasql/resolved_ast/rewrite_utils.h"
 #include "zetasql/base/check.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
@@ -44,13 +45,20 @@ namespace zetasql {
 namespace {
 
 // A visitor that replaces calls to SQL view scans with the resolved query.
-class SqlViewInlineVistor : public ResolvedASTDeepCopyVisitor {
+// It rewrites the tree in place, so only the inlined view queries are copied,
+// not the rest of the statement. Views referenced by an inlined view query are
+// inlined right away too, so that views layered on top of each other are
+// inlined in a single pass instead of one rewriter iteration per layer.
+class SqlViewInlineVistor : public ResolvedASTRewriteVisitor {
  public:
   explicit SqlViewInlineVistor(ColumnFactory* column_factory)
       : column_factory_(column_factory) {}
 
  private:
   ColumnFactory* column_factory_;
+  // The views whose queries are being inlined, to detect views that
+  // (indirectly) reference themselves.
+  absl::flat_hash_set<const SQLView*> views_being_inlined_;
 
   absl::StatusOr<bool> IsScanInlinable(const ResolvedTableScan* scan) {
     const Table* table = scan->table();
@@ -82,22 +90,36 @@ class SqlViewInlineVistor : public ResolvedASTDeepCopyVisitor {
     return true;
   }
 
-  absl::Status VisitResolvedTableScan(const ResolvedTableScan* node) override {
-    ZETASQL_ASSIGN_OR_RETURN(bool is_inlinable, IsScanInlinable(node));
+  absl::StatusOr<std::unique_ptr<const ResolvedNode>>
+  PostVisitResolvedTableScan(
+      std::unique_ptr<const ResolvedTableScan> node) override {
+    ZETASQL_ASSIGN_OR_RETURN(bool is_inlinable, IsScanInlinable(node.get()));
     if (is_inlinable) {
-      return InlineSqlView(node, node->table()->GetAs<SQLView>());
+      return InlineSqlView(node.get(), node->table()->GetAs<SQLView>());
     }
-    return CopyVisitResolvedTableScan(node);
+    return node;
   }
 
-  absl::Status InlineSqlView(const ResolvedTableScan* scan,
-                             const SQLView* view) {
+  absl::StatusOr<std::unique_ptr<const ResolvedNode>> InlineSqlView(
+      const ResolvedTableScan* scan, const SQLView* view) {
     ZETASQL_RET_CHECK_NE(column_factory_, nullptr);
     ABSL_DCHECK(scan->table()->Is<SQLView>());
 
     const ResolvedScan* const view_def = view->view_query();
     ZETASQL_RET_CHECK_NE(view_def, nullptr);
 
+    if (!views_being_inlined_.insert(view).second) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "View %s references itself and cannot be inlined", view->Name()));
+    }
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<const ResolvedNode> result,
+                     InlineViewQuery(scan, view_def));
+    views_being_inlined_.erase(view);
+    return result;
+  }
+
+  absl::StatusOr<std::unique_ptr<const ResolvedNode>> InlineViewQuery(
+      const ResolvedTableScan* scan, const ResolvedScan* view_def) {
     // For definer-rights views, we introduce a ResolvedExecuteAsRole node to
     // mark the boundary between invoker and definer rights. In this case,
     // we remap the columns so that consumers of this view call do not reach
@@ -109,34 +131,32 @@ class SqlViewInlineVistor : public ResolvedASTDeepCopyVisitor {
           ReplaceScanColumns(
               *column_factory_, *view_def, scan->column_index_list(),
               CreateReplacementColumns(*column_factory_, scan->column_list())));
+      ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<const ResolvedScan> inlined,
+                       VisitAll<ResolvedScan>(std::move(view_query)));
 
-      PushNodeToStack(MakeResolvedExecuteAsRoleScan(
-          scan->column_list(), std::move(view_query), scan->table(),
-          /*original_inlined_tvf=*/nullptr));
-    } else {
-      ZETASQL_ASSIGN_OR_RETURN(
-          std::unique_ptr<ResolvedScan> view_query,
-          ReplaceScanColumns(*column_factory_, *view_def,
-                             scan->column_index_list(), scan->column_list()));
-      PushNodeToStack(std::move(view_query));
+      return MakeResolvedExecuteAsRoleScan(
+          scan->column_list(), std::move(inlined), scan->table(),
+          /*original_inlined_tvf=*/nullptr);
     }
-
-    return absl::OkStatus();
+    ZETASQL_ASSIGN_OR_RETURN(
+        std::unique_ptr<ResolvedScan> view_query,
+        ReplaceScanColumns(*column_factory_, *view_def,
+                           scan->column_index_list(), scan->column_list()));
+    return VisitAll(std::move(view_query));
   }
 };
 
 class SqlViewScanInliner : public Rewriter {
  public:
   absl::StatusOr<std::unique_ptr<const ResolvedNode>> Rewrite(
-      const AnalyzerOptions& options, const ResolvedNode& input,
+      const AnalyzerOptions& options, std::unique_ptr<const ResolvedNode> input,
       Catalog& catalog, TypeFactory& type_factory,
       AnalyzerOutputProperties& output_properties) const override {
     ZETASQL_RET_CHECK(options.column_id_sequence_number() != nullptr);
     ColumnFactory column_factory(0, options.id_string_pool().get(),
                                  options.column_id_sequence_number());
     SqlViewInlineVistor rewriter(&column_factory);
-    ZETASQL_RETURN_IF_ERROR(input.Accept(&rewriter));
-    return rewriter.ConsumeRootNode<ResolvedNode>();
+    return rewriter.VisitAll(std::move(input));
   }
 
   std::string Name() const override { return "SqlViewScanInliner"; }
@@ -1952,6 +1952,20 @@ class AnalyzerTestRunner {
     auto restored = ResolvedStatement::RestoreFrom(proto, restore_params);
     ZETASQL_ASSERT_OK(restored.status()) << "error restoring: " << proto.DebugString();
     EXPECT_EQ(original_debug_string, restored.value()->DebugString());
+
+    // The compact serialization must restore the same tree.
+    std::string compact;
+    FileDescriptorSetMap compact_map;
+    ZETASQL_ASSERT_OK(orig_output.resolved_statement()->SaveToCompact(&compact_map,
+                                                              &compact));
+    std::vector<const google::protobuf::DescriptorPool*> compact_pools;
+    for (const auto& elem : compact_map) compact_pools.push_back(elem.first);
+    ResolvedNode::RestoreParams compact_restore_params(
+        compact_pools, catalog, type_factory, options.id_string_pool().get());
+    auto restored_compact =
+        ResolvedNode::RestoreFromCompact(compact, compact_restore_params);
+    ZETASQL_ASSERT_OK(restored_compact.status());
+    EXPECT_EQ(original_debug_string, restored_compact.value()->DebugString());
   }
 
   void CheckValidatorCoverage(const AnalyzerOptions& options,
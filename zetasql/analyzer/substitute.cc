@@ -38,6 +38,7 @@
 #include "zetasql/public/types/annotation.h"
 #include "zetasql/public/types/type.h"
 #include "zetasql/public/types/type_factory.h"
+#include "zetasql/resolved_ast/column_id_set.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
 #include "zetasql/resolved_ast/resolved_ast_deep_copy_visitor.h"
 #include "zetasql/resolved_ast/resolved_column.h"
@@ -552,13 +553,13 @@ absl::Status VariableReplacementInserter::VisitResolvedSubqueryExpr(
 absl::Status VariableReplacementInserter::AddLambdaColumnRefsToSubqueryExpr(
     ResolvedSubqueryExpr* subquery_expr) {
   // Build a set of added column ids to avoid duplicates.
-  absl::flat_hash_set<int> added_column_id_set;
+  ColumnIdSet added_column_id_set;
   for (const auto& ref : subquery_expr->parameter_list()) {
-    added_column_id_set.emplace(ref->column().column_id());
+    added_column_id_set.insert(ref->column().column_id());
   }
 
   for (const auto& id_and_column : column_refs_stack_.back()) {
-    if (!added_column_id_set.insert(id_and_column.first).second) {
+    if (!added_column_id_set.insert(id_and_column.first)) {
       continue;
     }
 
@@ -31,11 +31,15 @@
 #define THIRD_PARTY_FILE_BASED_TEST_DRIVER_BASE_EDIT_DISTANCE_H__
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
 #include <iterator>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "absl/container/fixed_array.h"
+#include "absl/container/flat_hash_map.h"
 
 namespace zetasql_base {
 
@@ -103,9 +107,15 @@ int CappedLevenshteinDistance(const Ran1& seq1_begin, const Ran1& seq1_end,
     // to compute new values in *current.
     std::swap(current, previous);
 
+    // The smallest value in the stripe of row i. The values in a column never
+    // decrease by more than one per row, and neither does the minimum of a
+    // row, so once every value in the stripe has reached the capping value,
+    // so has the distance.
+    int row_min = capping_value;
     // Special case for j == 0.
     if ( i <= capping_value ) {
       current[0] = i;  // Deletion is only possibility.
+      row_min = i;
     }
     for ( int j = std::max(1, i - capping_value);
           j <= std::min<int>(seq2_size, i + capping_value);
@@ -130,12 +140,136 @@ int CappedLevenshteinDistance(const Ran1& seq1_begin, const Ran1& seq1_end,
       const int cost = equals(seq1_begin[i - 1], seq2_begin[j - 1]) ? 0 : 1;
       const int substitution_cost = previous[j - 1] + cost;
       current[j] = std::min(partial_cost, substitution_cost);
+      row_min = std::min(row_min, current[j]);
+    }
+    if ( row_min >= capping_value ) {
+      return capping_value;
     }
   }
 
   return std::min(current[seq2_size], capping_value);
 }
 
+namespace internal_edit_distance {
+
+// For each element of a pattern of at most 64 elements, the bitmask of the
+// positions in the pattern that hold it.
+template <typename T, typename = void>
+class PatternMasks {
+ public:
+  void Add(const T& element, int position) {
+    masks_[element] |= uint64_t{1} << position;
+  }
+  template <typename U>
+  uint64_t Get(const U& element) const {
+    const auto it = masks_.find(static_cast<T>(element));
+    return it == masks_.end() ? 0 : it->second;
+  }
+
+ private:
+  absl::flat_hash_map<T, uint64_t> masks_;
+};
+
+// Byte-sized elements, like the chars of a string, use a table.
+template <typename T>
+class PatternMasks<T, std::enable_if_t<std::is_integral_v<T> &&
+                                       sizeof(T) == 1>> {
+ public:
+  void Add(T element, int position) {
+    masks_[static_cast<unsigned char>(element)] |= uint64_t{1} << position;
+  }
+  uint64_t Get(T element) const {
+    return masks_[static_cast<unsigned char>(element)];
+  }
+
+ private:
+  std::array<uint64_t, 256> masks_ = {};
+};
+
+}  // namespace internal_edit_distance
+
+// Returns the same "capped" Levenshtein distance as CappedLevenshteinDistance()
+// above. Uses the bit-parallel algorithm of Myers (J. ACM 46(3):395--415,
+// 1999), in the formulation of Hyyro, which requires the first sequence to
+// have at most 64 elements. The algorithm takes O(|seq2|) word operations,
+// regardless of the capping value, and stops early once the distance cannot
+// end up below the capping value.
+//
+// Elements are compared with operator==.
+template <typename Ran1, typename Ran2>
+int BitParallelCappedLevenshteinDistance(const Ran1& seq1_begin,
+                                         const Ran1& seq1_end,
+                                         const Ran2& seq2_begin,
+                                         const Ran2& seq2_end,
+                                         const int capping_value) {
+  const int seq1_size = static_cast<int>(seq1_end - seq1_begin);
+  const int seq2_size = static_cast<int>(seq2_end - seq2_begin);
+  if ( seq1_size == 0 ) {
+    return std::min(seq2_size, capping_value);
+  }
+
+  internal_edit_distance::PatternMasks<
+      typename std::iterator_traits<Ran1>::value_type>
+      masks;
+  for ( int i = 0; i < seq1_size; ++i ) {
+    masks.Add(seq1_begin[i], i);
+  }
+
+  // Bit i of 'positive' ('negative') is set if the value in row i + 1 of the
+  // current column of the table d is one more (less) than the one in row i.
+  uint64_t positive = ~uint64_t{0};
+  uint64_t negative = 0;
+  const uint64_t last_row = uint64_t{1} << (seq1_size - 1);
+  // The value in the last row of the current column.
+  int distance = seq1_size;
+  for ( int j = 0; j < seq2_size; ++j ) {
+    const uint64_t equal = masks.Get(seq2_begin[j]);
+    const uint64_t vertical = equal | negative;
+    const uint64_t horizontal =
+        (((equal & positive) + positive) ^ positive) | equal;
+    uint64_t horizontal_positive = negative | ~(horizontal | positive);
+    uint64_t horizontal_negative = positive & horizontal;
+    if ( horizontal_positive & last_row ) {
+      ++distance;
+    } else if ( horizontal_negative & last_row ) {
+      --distance;
+    }
+    // The first row of d increases by one per column.
+    horizontal_positive = (horizontal_positive << 1) | 1;
+    horizontal_negative <<= 1;
+    positive = horizontal_negative | ~(vertical | horizontal_positive);
+    negative = horizontal_positive & vertical;
+    // The distance decreases by at most one per remaining column.
+    if ( distance - (seq2_size - 1 - j) >= capping_value ) {
+      return capping_value;
+    }
+  }
+  return std::min(distance, capping_value);
+}
+
+// Like CappedLevenshteinDistance() above, but compares elements with
+// operator==. Uses BitParallelCappedLevenshteinDistance() when one of the
+// sequences has at most 64 elements.
+template <typename Ran1, typename Ran2>
+int CappedLevenshteinDistance(const Ran1& seq1_begin, const Ran1& seq1_end,
+                              const Ran2& seq2_begin, const Ran2& seq2_end,
+                              const int capping_value) {
+  constexpr int kMaxBitParallelSize = 64;
+  if ( seq1_end - seq1_begin <= kMaxBitParallelSize ) {
+    return BitParallelCappedLevenshteinDistance(seq1_begin, seq1_end,
+                                                seq2_begin, seq2_end,
+                                                capping_value);
+  }
+  if ( seq2_end - seq2_begin <= kMaxBitParallelSize ) {
+    return BitParallelCappedLevenshteinDistance(seq2_begin, seq2_end,
+                                                seq1_begin, seq1_end,
+                                                capping_value);
+  }
+  return CappedLevenshteinDistance(
+      seq1_begin, seq1_end, seq2_begin, seq2_end,
+      [](const auto& a, const auto& b) { return a == b; }, capping_value);
+}
+
 }  // namespace zetasql_base
 
 #endif  // THIRD_PARTY_FILE_BASED_TEST_DRIVER_BASE_EDIT_DISTANCE_H__
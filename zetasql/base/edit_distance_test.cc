@@ -29,6 +29,8 @@
 #include <algorithm>
 #include <cstring>
 #include <functional>
+#include <random>
+#include <string>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -377,4 +379,59 @@ TEST_F(CappedLevenshteinDistanceTest, DifferentIterators) {
             6);
 }
 
+TEST_F(CappedLevenshteinDistanceTest, BitParallelMatchesDynamicProgramming) {
+  std::mt19937 random(/*seed=*/1);
+  for (int iteration = 0; iteration < 2000; ++iteration) {
+    // Lengths around 64 exercise both the bit-parallel algorithm and the
+    // fallback to the dynamic programming.
+    std::string a(random() % 80, ' ');
+    std::string b(random() % 80, ' ');
+    const int alphabet_size = 1 + random() % 4;
+    for (char& c : a) c = 'a' + random() % alphabet_size;
+    for (char& c : b) c = 'a' + random() % alphabet_size;
+    std::u32string wide_a(a.begin(), a.end());
+    std::u32string wide_b(b.begin(), b.end());
+    const int capping_value = random() % 90;
+
+    const int expected = CappedLevenshteinDistance(
+        a.begin(), a.end(), b.begin(), b.end(), std::equal_to<char>(),
+        capping_value);
+    EXPECT_EQ(CappedLevenshteinDistance(a.begin(), a.end(), b.begin(),
+                                        b.end(), capping_value),
+              expected)
+        << a << " " << b << " " << capping_value;
+    EXPECT_EQ(CappedLevenshteinDistance(wide_a.begin(), wide_a.end(),
+                                        wide_b.begin(), wide_b.end(),
+                                        capping_value),
+              expected)
+        << a << " " << b << " " << capping_value;
+  }
+}
+
+TEST_F(CappedLevenshteinDistanceTest, BitParallelCapped) {
+  EXPECT_EQ(BitParallelCappedLevenshteinDistance(kilo.begin(), kilo.end(),
+                                                 kilogram.begin(),
+                                                 kilogram.end(), 9),
+            4);
+  EXPECT_EQ(BitParallelCappedLevenshteinDistance(kilo.begin(), kilo.end(),
+                                                 kilogram.begin(),
+                                                 kilogram.end(), 3),
+            3);
+  EXPECT_EQ(BitParallelCappedLevenshteinDistance(empty.begin(), empty.end(),
+                                                 s567.begin(), s567.end(), 5),
+            3);
+  EXPECT_EQ(BitParallelCappedLevenshteinDistance(
+                algorithm_begin, algorithm_end, altruistic.begin(),
+                altruistic.end(), 7),
+            6);
+  // 64 elements use every bit of the masks.
+  const std::string s64(64, 'a');
+  std::string t64 = s64;
+  t64[0] = 'b';
+  t64[63] = 'b';
+  EXPECT_EQ(BitParallelCappedLevenshteinDistance(s64.begin(), s64.end(),
+                                                 t64.begin(), t64.end(), 64),
+            2);
+}
+
 }  // namespace zetasql_base
@@ -21,6 +21,7 @@
 #include "zetasql/base/string_numbers.h"
 
 #include <cassert>
+#include <charconv>
 #include <cfloat>  // for DBL_DIG and FLT_DIG
 #include <cmath>
 #include <cstdint>
@@ -28,6 +29,8 @@
 #include <cstdlib>
 #include <limits>
 #include <string>
+#include <system_error>
+#include <type_traits>
 
 #include "zetasql/base/check.h"
 #include "absl/strings/ascii.h"
@@ -290,6 +293,54 @@ inline bool safe_uint_internal(absl::string_view text, IntType* value_p,
 static constexpr double kDoublePrecisionCheckMax = DBL_MAX / 1.000000000000001;
 static constexpr int kFastToBufferSize = 32;
 
+// Writes 'value' to 'buffer' like snprintf "%.*g" with 'precision', and returns
+// the length of the result. std::to_chars() is specified to produce the same
+// characters as printf in the C locale, but does so without parsing a format
+// and touching the locale, which makes up most of the cost of CAST(<double> AS
+// STRING).
+template <typename FloatType>
+int FormatGeneral(FloatType value, int precision,
+                  char (&buffer)[kFastToBufferSize]) {
+#ifdef __cpp_lib_to_chars
+  std::to_chars_result result =
+      std::to_chars(buffer, buffer + kFastToBufferSize - 1, value,
+                    std::chars_format::general, precision);
+  // Should never overflow because the buffer is significantly larger than
+  // the precision we ask for.
+  ABSL_CHECK(result.ec == std::errc());
+  *result.ptr = '\0';
+  return static_cast<int>(result.ptr - buffer);
+#else
+  int snprintf_result =
+      snprintf(buffer, kFastToBufferSize, "%.*g", precision,
+               static_cast<double>(value));
+  // Should never overflow; see above.
+  ABSL_CHECK(snprintf_result > 0 && snprintf_result < kFastToBufferSize);
+  return snprintf_result;
+#endif
+}
+
+// Returns true if the first 'length' characters of 'buffer', as written by
+// FormatGeneral(), parse back to exactly 'value'. NaN never does.
+template <typename FloatType>
+bool ParsesBackTo(const char* buffer, int length, FloatType value) {
+  FloatType parsed_value;
+#ifdef __cpp_lib_to_chars
+  std::from_chars_result result =
+      std::from_chars(buffer, buffer + length, parsed_value);
+  return result.ec == std::errc() && parsed_value == value;
+#else
+  if constexpr (std::is_same_v<FloatType, float>) {
+    return absl::SimpleAtof(absl::string_view(buffer, length),
+                            &parsed_value) &&
+           parsed_value == value;
+  } else {
+    parsed_value = strtod(buffer, nullptr);
+    return parsed_value == value;
+  }
+#endif
+}
+
 }  // anonymous namespace
 
 std::string RoundTripDoubleToString(double d) {
@@ -299,26 +350,13 @@ std::string RoundTripDoubleToString(double d) {
   // this assert.
   static_assert(DBL_DIG < 20, "DBL_DIG is too big");
   char buffer[kFastToBufferSize];
-  bool full_precision_needed = true;
   if (std::abs(d) <= kDoublePrecisionCheckMax) {
-    int snprintf_result =
-        snprintf(buffer, kFastToBufferSize, "%.*g", DBL_DIG, d);
-
-    // The snprintf should never overflow because the buffer is significantly
-    // larger than the precision we asked for.
-    ABSL_CHECK(snprintf_result > 0 && snprintf_result < kFastToBufferSize);
-
-    full_precision_needed = strtod(buffer, nullptr) != d;
-  }
-
-  if (full_precision_needed) {
-    int snprintf_result =
-        snprintf(buffer, kFastToBufferSize, "%.*g", DBL_DIG + 2, d);
-
-    // Should never overflow; see above.
-    ABSL_CHECK(snprintf_result > 0 && snprintf_result < kFastToBufferSize);
+    int length = FormatGeneral(d, DBL_DIG, buffer);
+    if (ParsesBackTo(buffer, length, d)) {
+      return std::string(buffer, length);
+    }
   }
-  return buffer;
+  return std::string(buffer, FormatGeneral(d, DBL_DIG + 2, buffer));
 }
 
 std::string RoundTripFloatToString(float value) {
@@ -329,22 +367,11 @@ std::string RoundTripFloatToString(float value) {
   // this assert.
   static_assert(FLT_DIG < 10, "FLT_DIG is too big");
 
-  int snprintf_result =
-      snprintf(buffer, kFastToBufferSize, "%.*g", FLT_DIG, value);
-
-  // The snprintf should never overflow because the buffer is significantly
-  // larger than the precision we asked for.
-  ABSL_CHECK(snprintf_result > 0 && snprintf_result < kFastToBufferSize);
-
-  float parsed_value;
-  if (!absl::SimpleAtof(buffer, &parsed_value) || parsed_value != value) {
-    snprintf_result =
-        snprintf(buffer, kFastToBufferSize, "%.*g", FLT_DIG + 2, value);
-
-    // Should never overflow; see above.
-    ABSL_DCHECK(snprintf_result > 0 && snprintf_result < kFastToBufferSize);
+  int length = FormatGeneral(value, FLT_DIG, buffer);
+  if (!ParsesBackTo(buffer, length, value)) {
+    length = FormatGeneral(value, FLT_DIG + 2, buffer);
   }
-  return buffer;
+  return std::string(buffer, length);
 }
 
 bool safe_strto32_base(absl::string_view text, int32_t* value, int base) {
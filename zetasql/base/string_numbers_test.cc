@@ -19,8 +19,12 @@
 #include "zetasql/base/string_numbers.h"
 
 #include <array>
+#include <cfloat>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <limits>
 #include <random>
@@ -794,4 +798,81 @@ TEST(StrToUint64Base, PrefixOnly) {
   }
 }
 
+TEST(stringtest, RoundTripDoubleToString) {
+  EXPECT_EQ(zetasql_base::RoundTripDoubleToString(0.0), "0");
+  EXPECT_EQ(zetasql_base::RoundTripDoubleToString(-0.0), "-0");
+  EXPECT_EQ(zetasql_base::RoundTripDoubleToString(1.5), "1.5");
+  EXPECT_EQ(zetasql_base::RoundTripDoubleToString(0.1), "0.1");
+  EXPECT_EQ(zetasql_base::RoundTripDoubleToString(0.1 + 0.2),
+            "0.30000000000000004");
+  EXPECT_EQ(zetasql_base::RoundTripDoubleToString(123456789012345.0),
+            "123456789012345");
+  EXPECT_EQ(zetasql_base::RoundTripDoubleToString(1e15), "1e+15");
+  EXPECT_EQ(zetasql_base::RoundTripDoubleToString(1e-300), "1e-300");
+  EXPECT_EQ(zetasql_base::RoundTripDoubleToString(
+                std::numeric_limits<double>::max()),
+            "1.7976931348623157e+308");
+  EXPECT_EQ(zetasql_base::RoundTripDoubleToString(
+                std::numeric_limits<double>::denorm_min()),
+            "4.94065645841247e-324");
+  EXPECT_EQ(zetasql_base::RoundTripDoubleToString(
+                std::numeric_limits<double>::infinity()),
+            "inf");
+  EXPECT_EQ(zetasql_base::RoundTripDoubleToString(
+                -std::numeric_limits<double>::infinity()),
+            "-inf");
+  EXPECT_EQ(zetasql_base::RoundTripDoubleToString(
+                std::numeric_limits<double>::quiet_NaN()),
+            "nan");
+}
+
+TEST(stringtest, RoundTripFloatToString) {
+  EXPECT_EQ(zetasql_base::RoundTripFloatToString(0.0f), "0");
+  EXPECT_EQ(zetasql_base::RoundTripFloatToString(-0.0f), "-0");
+  EXPECT_EQ(zetasql_base::RoundTripFloatToString(1.5f), "1.5");
+  EXPECT_EQ(zetasql_base::RoundTripFloatToString(0.1f), "0.1");
+  EXPECT_EQ(zetasql_base::RoundTripFloatToString(16777216.0f), "16777216");
+  EXPECT_EQ(zetasql_base::RoundTripFloatToString(
+                std::numeric_limits<float>::max()),
+            "3.4028235e+38");
+  EXPECT_EQ(zetasql_base::RoundTripFloatToString(
+                std::numeric_limits<float>::infinity()),
+            "inf");
+}
+
+// The results must stay identical to the snprintf() based formatting that
+// RoundTrip*ToString() used originally, as they are the results of CAST.
+TEST(stringtest, RoundTripToStringMatchesSnprintf) {
+  auto snprintf_double = [](double d) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.*g", DBL_DIG, d);
+    if (std::abs(d) > DBL_MAX / 1.000000000000001 ||
+        strtod(buffer, nullptr) != d) {
+      snprintf(buffer, sizeof(buffer), "%.*g", DBL_DIG + 2, d);
+    }
+    return std::string(buffer);
+  };
+  auto snprintf_float = [](float f) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.*g", FLT_DIG, f);
+    if (strtof(buffer, nullptr) != f) {
+      snprintf(buffer, sizeof(buffer), "%.*g", FLT_DIG + 2, f);
+    }
+    return std::string(buffer);
+  };
+  std::mt19937_64 rng(12345);
+  for (size_t i = 0; i < 10000; ++i) {
+    uint64_t bits = rng();
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    if (std::isnan(d)) continue;
+    EXPECT_EQ(zetasql_base::RoundTripDoubleToString(d), snprintf_double(d));
+    float f;
+    uint32_t float_bits = static_cast<uint32_t>(bits);
+    std::memcpy(&f, &float_bits, sizeof(f));
+    if (std::isnan(f)) continue;
+    EXPECT_EQ(zetasql_base::RoundTripFloatToString(f), snprintf_float(f));
+  }
+}
+
 }  // namespace
@@ -0,0 +1,342 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/common/columnar_evaluator_table_iterator.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "zetasql/base/logging.h"
+#include "zetasql/common/simple_evaluator_table_iterator.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/base/check.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+// The number of rows between two checks of the deadline.
+static constexpr int64_t kRowsPerDeadlineCheck = 1000;
+
+static bool IsBitSet(const uint8_t* bitmap, int64_t i) {
+  return (bitmap[i >> 3] >> (i & 7)) & 1;
+}
+
+// Returns the index into the dictionary of element 'i' of the
+// dictionary-encoded 'column', or -1 if the element is NULL.
+static int64_t DictionaryIndex(const ColumnarArrayView& column, int64_t i) {
+  const int64_t j = column.offset + i;
+  if (column.validity != nullptr && !IsBitSet(column.validity, j)) {
+    return -1;
+  }
+  return static_cast<const int32_t*>(column.values)[j];
+}
+
+bool ColumnarArrayView::SupportsType(const Type* type) {
+  switch (type->kind()) {
+    case TYPE_INT64:
+    case TYPE_DOUBLE:
+    case TYPE_BOOL:
+    case TYPE_STRING:
+    case TYPE_BYTES:
+      return true;
+    default:
+      return false;
+  }
+}
+
+Value ColumnarArrayView::GetValue(int64_t i) const {
+  ABSL_DCHECK_LT(i, length);
+  if (dictionary != nullptr) {
+    const int64_t index = DictionaryIndex(*this, i);
+    return index < 0 ? Value::Null(type) : dictionary->GetValue(index);
+  }
+  const int64_t j = offset + i;
+  if (validity != nullptr && !IsBitSet(validity, j)) {
+    return Value::Null(type);
+  }
+  switch (type->kind()) {
+    case TYPE_INT64:
+      return Value::Int64(static_cast<const int64_t*>(values)[j]);
+    case TYPE_DOUBLE:
+      return Value::Double(static_cast<const double*>(values)[j]);
+    case TYPE_BOOL:
+      return Value::Bool(IsBitSet(static_cast<const uint8_t*>(values), j));
+    case TYPE_STRING:
+    case TYPE_BYTES: {
+      const absl::string_view payload(
+          static_cast<const char*>(values) + value_offsets[j],
+          value_offsets[j + 1] - value_offsets[j]);
+      return type->IsString() ? Value::String(payload) : Value::Bytes(payload);
+    }
+    default:
+      ABSL_LOG(FATAL) << "Unsupported type: " << type->DebugString();
+  }
+}
+
+// Returns an error if the dictionary of the dictionary-encoded 'column', which
+// is column 'i' of a batch, is not valid or if 'column' has an index that is
+// out of range.
+static absl::Status ValidateDictionary(const ColumnarArrayView& column,
+                                       int i) {
+  const ColumnarArrayView& dictionary = *column.dictionary;
+  if (!column.type->IsString() && !column.type->IsBytes()) {
+    return zetasql_base::InvalidArgumentErrorBuilder()
+           << "Column " << i << " of ColumnarRecordBatch has a dictionary, "
+           << "but only STRING and BYTES columns can be dictionary-encoded";
+  }
+  if (dictionary.type == nullptr || !dictionary.type->Equals(column.type) ||
+      dictionary.dictionary != nullptr) {
+    return zetasql_base::InvalidArgumentErrorBuilder()
+           << "The dictionary of column " << i
+           << " of ColumnarRecordBatch must have type "
+           << column.type->DebugString() << " and must not be "
+           << "dictionary-encoded";
+  }
+  if (dictionary.length < 0 || dictionary.offset < 0 ||
+      (dictionary.length > 0 && (dictionary.values == nullptr ||
+                                 dictionary.value_offsets == nullptr))) {
+    return zetasql_base::InvalidArgumentErrorBuilder()
+           << "The dictionary of column " << i
+           << " of ColumnarRecordBatch is missing a buffer";
+  }
+  for (int64_t row = 0; row < column.length; ++row) {
+    const int64_t j = column.offset + row;
+    if (column.validity != nullptr && !IsBitSet(column.validity, j)) continue;
+    const int32_t index = static_cast<const int32_t*>(column.values)[j];
+    if (index < 0 || index >= dictionary.length) {
+      return zetasql_base::InvalidArgumentErrorBuilder()
+             << "Column " << i << " of ColumnarRecordBatch has dictionary "
+             << "index " << index << " in row " << row
+             << ", but the dictionary has " << dictionary.length
+             << " entries";
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ColumnarEvaluatorTableIterator::ValidateBatch(
+    const ColumnarRecordBatch& batch,
+    absl::Span<const Type* const> column_types) {
+  if (batch.num_rows < 0) {
+    return zetasql_base::InvalidArgumentErrorBuilder()
+           << "ColumnarRecordBatch has a negative number of rows";
+  }
+  if (batch.columns.size() != column_types.size()) {
+    return zetasql_base::InvalidArgumentErrorBuilder()
+           << "ColumnarRecordBatch has " << batch.columns.size()
+           << " columns instead of " << column_types.size();
+  }
+  for (int i = 0; i < column_types.size(); ++i) {
+    const ColumnarArrayView& column = batch.columns[i];
+    if (column.type == nullptr || !column.type->Equals(column_types[i]) ||
+        !ColumnarArrayView::SupportsType(column.type)) {
+      return zetasql_base::InvalidArgumentErrorBuilder()
+             << "Column " << i << " of ColumnarRecordBatch must have type "
+             << column_types[i]->DebugString()
+             << ", which must be one of INT64, DOUBLE, BOOL, STRING or BYTES";
+    }
+    if (column.length != batch.num_rows || column.offset < 0) {
+      return zetasql_base::InvalidArgumentErrorBuilder()
+             << "Column " << i << " of ColumnarRecordBatch has "
+             << column.length << " elements instead of " << batch.num_rows;
+    }
+    if (column.length > 0 &&
+        (column.values == nullptr ||
+         ((column.type->IsString() || column.type->IsBytes()) &&
+          column.dictionary == nullptr && column.value_offsets == nullptr))) {
+      return zetasql_base::InvalidArgumentErrorBuilder()
+             << "Column " << i << " of ColumnarRecordBatch is missing a buffer";
+    }
+    if (column.dictionary != nullptr) {
+      ZETASQL_RETURN_IF_ERROR(ValidateDictionary(column, i));
+    }
+  }
+  return absl::OkStatus();
+}
+
+ColumnarEvaluatorTableIterator::ColumnarEvaluatorTableIterator(
+    std::vector<const Column*> columns, std::vector<int> column_idxs,
+    std::shared_ptr<const std::vector<ColumnarRecordBatch>> batches,
+    zetasql_base::Clock* clock)
+    : columns_(std::move(columns)),
+      column_idxs_(std::move(column_idxs)),
+      batches_(std::move(batches)),
+      clock_(clock),
+      referenced_(columns_.size(), true),
+      row_values_(columns_.size()),
+      row_value_is_set_(columns_.size(), false),
+      dictionary_caches_(columns_.size()) {
+  ABSL_CHECK_EQ(columns_.size(), column_idxs_.size());
+  for (const ColumnarRecordBatch& batch : *batches_) {
+    num_rows_ += batch.num_rows;
+  }
+  end_row_idx_ = num_rows_;
+  null_values_.reserve(columns_.size());
+  for (const Column* column : columns_) {
+    null_values_.push_back(Value::Null(column->GetType()));
+  }
+}
+
+absl::Status ColumnarEvaluatorTableIterator::SetColumnFilterMap(
+    absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map) {
+  ZETASQL_RET_CHECK(!called_next_)
+      << "SetColumnFilterMap() cannot be called after NextRow()";
+  for (const auto& entry : filter_map) {
+    ZETASQL_RET_CHECK_GE(entry.first, 0);
+    ZETASQL_RET_CHECK_LT(entry.first, columns_.size());
+  }
+  filter_map_ = std::move(filter_map);
+  return absl::OkStatus();
+}
+
+absl::Status ColumnarEvaluatorTableIterator::SetReferencedColumns(
+    absl::Span<const int> column_idxs) {
+  ZETASQL_RET_CHECK(!called_next_)
+      << "SetReferencedColumns() cannot be called after NextRow()";
+  referenced_.assign(columns_.size(), false);
+  for (const int column_idx : column_idxs) {
+    ZETASQL_RET_CHECK_GE(column_idx, 0);
+    ZETASQL_RET_CHECK_LT(column_idx, columns_.size());
+    referenced_[column_idx] = true;
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ColumnarEvaluatorTableIterator::SetRowRange(int64_t begin,
+                                                         int64_t end) {
+  ZETASQL_RET_CHECK(!called_next_)
+      << "SetRowRange() cannot be called after NextRow()";
+  ZETASQL_RET_CHECK_GE(begin, 0);
+  ZETASQL_RET_CHECK_LE(begin, end);
+  ZETASQL_RET_CHECK_LE(end, num_rows_);
+  row_idx_ = begin - 1;
+  end_row_idx_ = end;
+  // Find the batch containing row 'begin'. NextRow() moves on to the next
+  // batch if 'row_in_batch_' reaches the end of this one.
+  batch_idx_ = 0;
+  int64_t batch_begin = 0;
+  while (batch_idx_ < batches_->size() &&
+         batch_begin + (*batches_)[batch_idx_].num_rows <= begin) {
+    batch_begin += (*batches_)[batch_idx_].num_rows;
+    ++batch_idx_;
+  }
+  row_in_batch_ = begin - batch_begin - 1;
+  return absl::OkStatus();
+}
+
+bool ColumnarEvaluatorTableIterator::NextRow() {
+  called_next_ = true;
+  for (++row_idx_; row_idx_ < end_row_idx_; ++row_idx_) {
+    if (cancelled_) {
+      status_ = zetasql_base::CancelledErrorBuilder()
+                << "ColumnarEvaluatorTableIterator was cancelled";
+      return false;
+    }
+    if (row_idx_ % kRowsPerDeadlineCheck == 0 &&
+        clock_->TimeNow() > deadline_) {
+      status_ = zetasql_base::DeadlineExceededErrorBuilder()
+                << "ColumnarEvaluatorTableIterator deadline exceeded";
+      return false;
+    }
+
+    ++row_in_batch_;
+    while (row_in_batch_ >= (*batches_)[batch_idx_].num_rows) {
+      row_in_batch_ -= (*batches_)[batch_idx_].num_rows;
+      ++batch_idx_;
+    }
+    row_value_is_set_.assign(columns_.size(), false);
+
+    bool keep_row = true;
+    for (const auto& [column_idx, filter] : filter_map_) {
+      if (!MatchesFilter(column_idx, *filter)) {
+        keep_row = false;
+        break;
+      }
+    }
+    if (keep_row) return true;
+  }
+  return false;
+}
+
+ColumnarEvaluatorTableIterator::DictionaryCache&
+ColumnarEvaluatorTableIterator::GetDictionaryCache(
+    int i, const ColumnarArrayView& column) const {
+  DictionaryCache& cache = dictionary_caches_[i];
+  if (cache.dictionary != column.dictionary) {
+    cache.dictionary = column.dictionary;
+    cache.values.assign(column.dictionary->length, Value());
+    cache.filter_results.assign(column.dictionary->length,
+                                kFilterResultUnknown);
+  }
+  return cache;
+}
+
+bool ColumnarEvaluatorTableIterator::MatchesFilter(int i,
+                                                   const ColumnFilter& filter) {
+  const ColumnarArrayView& column =
+      (*batches_)[batch_idx_].columns[column_idxs_[i]];
+  const int64_t index = column.dictionary == nullptr
+                            ? -1
+                            : DictionaryIndex(column, row_in_batch_);
+  if (index < 0) {
+    return SimpleEvaluatorTableIterator::MatchesColumnFilter(
+        filter, GetOrConvertValue(i));
+  }
+  DictionaryCache& cache = GetDictionaryCache(i, column);
+  int8_t& result = cache.filter_results[index];
+  if (result == kFilterResultUnknown) {
+    // Converts the entry through GetOrConvertValue() so that it is cached both
+    // for the row and for the dictionary.
+    result = SimpleEvaluatorTableIterator::MatchesColumnFilter(
+        filter, GetOrConvertValue(i));
+  }
+  return result;
+}
+
+const Value& ColumnarEvaluatorTableIterator::GetOrConvertValue(int i) const {
+  if (!row_value_is_set_[i]) {
+    const ColumnarArrayView& column =
+        (*batches_)[batch_idx_].columns[column_idxs_[i]];
+    const int64_t index = column.dictionary == nullptr
+                              ? -1
+                              : DictionaryIndex(column, row_in_batch_);
+    if (index >= 0) {
+      // Copying the Value shares the payload of the entry.
+      Value& entry = GetDictionaryCache(i, column).values[index];
+      if (!entry.is_valid()) entry = column.dictionary->GetValue(index);
+      row_values_[i] = entry;
+    } else {
+      row_values_[i] = column.GetValue(row_in_batch_);
+    }
+    row_value_is_set_[i] = true;
+  }
+  return row_values_[i];
+}
+
+const Value& ColumnarEvaluatorTableIterator::GetValue(int i) const {
+  if (!referenced_[i]) return null_values_[i];
+  return GetOrConvertValue(i);
+}
+
+}  // namespace zetasql
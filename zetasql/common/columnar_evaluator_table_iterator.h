@@ -0,0 +1,222 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// An EvaluatorTableIterator over record batches in the memory layout of the
+// Apache Arrow columnar format, so that Arrow (or Parquet decoded into Arrow)
+// data can be scanned without first converting every cell into a Value.
+//
+// The buffers are described with plain pointers so that this library does not
+// depend on Arrow: for an arrow::ArrayData 'data', 'validity' is
+// data.buffers[0], and the other buffers are data.buffers[1] (and
+// data.buffers[2] for variable-length types), all with 'offset' data.offset.
+//
+// A Value owns its payload, so cells are still converted into Values, but
+// only when they are actually read: cells of columns that are not referenced
+// by the query (see EvaluatorTableIterator::SetReferencedColumns()) are never
+// converted, and cells of rows dropped by the column filters are only
+// converted for the filtered columns.
+//
+// STRING and BYTES columns may be dictionary-encoded, as for an Arrow
+// DictionaryArray with int32 indices. Every dictionary entry is then converted
+// into a Value only once, and all the rows referring to it share its payload,
+// so that hashing and comparing those Values (e.g., for GROUP BY or a hash
+// join) does not need to look at the bytes again. Column filters are also only
+// evaluated once per dictionary entry.
+
+#ifndef ZETASQL_COMMON_COLUMNAR_EVALUATOR_TABLE_ITERATOR_H_
+#define ZETASQL_COMMON_COLUMNAR_EVALUATOR_TABLE_ITERATOR_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "zetasql/base/clock.h"
+
+namespace zetasql {
+
+// A view of one column of a record batch in the Arrow columnar memory layout.
+// The buffers are not owned.
+struct ColumnarArrayView {
+  // Returns true if 'type' can be used for a ColumnarArrayView. Only INT64,
+  // DOUBLE, BOOL, STRING and BYTES are supported, corresponding to the Arrow
+  // types int64, float64, bool, utf8 and binary.
+  static bool SupportsType(const Type* type);
+
+  // Returns the 'i'-th element, counting from 'offset'.
+  Value GetValue(int64_t i) const;
+
+  const Type* type = nullptr;
+  // The number of elements, not counting the first 'offset' ones.
+  int64_t length = 0;
+  // The number of elements (or bits, for bitmaps) to skip at the start of
+  // every buffer, as for a sliced Arrow array.
+  int64_t offset = 0;
+  // Bitmap with a set bit for every non-NULL element, least significant bit
+  // first. NULL if there are no NULL elements.
+  const uint8_t* validity = nullptr;
+  // For INT64 and DOUBLE, the array of values. For BOOL, a bitmap like
+  // 'validity'. For STRING and BYTES, the concatenated payloads.
+  const void* values = nullptr;
+  // For STRING and BYTES only, the payload of element 'i' is
+  // ['value_offsets[offset + i]', 'value_offsets[offset + i + 1]') in
+  // 'values'.
+  const int32_t* value_offsets = nullptr;
+  // For STRING and BYTES only, may be set for a dictionary-encoded column, in
+  // which case 'values' is an array of int32 indices into 'dictionary', which
+  // has the same type and is not dictionary-encoded itself, and
+  // 'value_offsets' is not used. Not owned.
+  const ColumnarArrayView* dictionary = nullptr;
+};
+
+// A batch of rows, with one ColumnarArrayView per column of the table.
+struct ColumnarRecordBatch {
+  int64_t num_rows = 0;
+  std::vector<ColumnarArrayView> columns;
+  // Keeps the buffers referenced by 'columns' alive, e.g., a
+  // std::shared_ptr<arrow::RecordBatch>. May be NULL if the buffers are owned
+  // elsewhere.
+  std::shared_ptr<const void> owner;
+};
+
+class ColumnarEvaluatorTableIterator : public EvaluatorTableIterator {
+ public:
+  // 'columns' is a list of the columns in the scan. 'column_idxs[i]' is the
+  // index of 'columns[i]' in each element of 'batches', which must have been
+  // validated for those columns with ValidateBatch(). 'clock' is used to
+  // enforce deadlines.
+  ColumnarEvaluatorTableIterator(
+      std::vector<const Column*> columns, std::vector<int> column_idxs,
+      std::shared_ptr<const std::vector<ColumnarRecordBatch>> batches,
+      zetasql_base::Clock* clock);
+
+  ColumnarEvaluatorTableIterator(const ColumnarEvaluatorTableIterator&) =
+      delete;
+  ColumnarEvaluatorTableIterator& operator=(
+      const ColumnarEvaluatorTableIterator&) = delete;
+
+  // Returns an error if 'batch' does not have a column of type
+  // 'column_types[i]' and length 'batch.num_rows' for every 'i', or if a
+  // dictionary-encoded column has an index that is out of range.
+  static absl::Status ValidateBatch(const ColumnarRecordBatch& batch,
+                                    absl::Span<const Type* const> column_types);
+
+  int NumColumns() const override { return static_cast<int>(columns_.size()); }
+
+  std::string GetColumnName(int i) const override {
+    return columns_[i]->Name();
+  }
+
+  const Type* GetColumnType(int i) const override {
+    return columns_[i]->GetType();
+  }
+
+  absl::Status SetColumnFilterMap(
+      absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map)
+      override;
+
+  absl::Status SetReferencedColumns(absl::Span<const int> column_idxs) override;
+
+  std::optional<int64_t> GetNumRowsForSplitting() const override {
+    return num_rows_;
+  }
+
+  absl::Status SetRowRange(int64_t begin, int64_t end) override;
+
+  bool NextRow() override;
+
+  const Value& GetValue(int i) const override;
+
+  absl::Status Status() const override { return status_; }
+
+  absl::Status Cancel() override {
+    cancelled_ = true;
+    return absl::OkStatus();
+  }
+
+  void SetDeadline(absl::Time deadline) override { deadline_ = deadline; }
+
+ private:
+  // Returns the value of scan column 'i' in the current row, converting it
+  // on first use.
+  const Value& GetOrConvertValue(int i) const;
+
+  // Returns true if the value of scan column 'i' in the current row matches
+  // 'filter'.
+  bool MatchesFilter(int i, const ColumnFilter& filter);
+
+  // The converted entries of the dictionary of a dictionary-encoded scan
+  // column, which are kept for as long as the batches use the same dictionary.
+  struct DictionaryCache {
+    const ColumnarArrayView* dictionary = nullptr;
+    // 'values[j]' is invalid if entry 'j' has not been converted yet.
+    std::vector<Value> values;
+    // 'filter_results[j]' is whether entry 'j' matches the column filter of
+    // the scan column, or kFilterResultUnknown.
+    std::vector<int8_t> filter_results;
+  };
+  static constexpr int8_t kFilterResultUnknown = -1;
+
+  // Returns the cache for the dictionary of 'column', which is scan column
+  // 'i', resetting it if the dictionary changed.
+  DictionaryCache& GetDictionaryCache(int i,
+                                      const ColumnarArrayView& column) const;
+
+  const std::vector<const Column*> columns_;
+  const std::vector<int> column_idxs_;
+  const std::shared_ptr<const std::vector<ColumnarRecordBatch>> batches_;
+  zetasql_base::Clock* clock_;
+  int64_t num_rows_ = 0;
+
+  absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map_;
+  // 'referenced_[i]' is false if scan column 'i' is never read, in which case
+  // GetValue() returns 'null_values_[i]'.
+  std::vector<bool> referenced_;
+  std::vector<Value> null_values_;
+
+  // The current row is row 'row_in_batch_' of '(*batches_)[batch_idx_]', which
+  // is row 'row_idx_' of the table.
+  int64_t row_idx_ = -1;
+  int64_t end_row_idx_ = 0;
+  int batch_idx_ = 0;
+  int64_t row_in_batch_ = -1;
+  bool called_next_ = false;
+
+  // The values of the current row. 'row_values_[i]' is only valid if
+  // 'row_value_is_set_[i]' is true.
+  mutable std::vector<Value> row_values_;
+  mutable std::vector<bool> row_value_is_set_;
+  // Indexed by scan column. Only used for dictionary-encoded columns.
+  mutable std::vector<DictionaryCache> dictionary_caches_;
+
+  std::atomic<bool> cancelled_ = false;
+  absl::Time deadline_ = absl::InfiniteFuture();
+  absl::Status status_;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_COMMON_COLUMNAR_EVALUATOR_TABLE_ITERATOR_H_
@@ -0,0 +1,384 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/common/columnar_evaluator_table_iterator.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+#include "zetasql/base/clock.h"
+
+namespace zetasql {
+namespace {
+
+using testing::ElementsAre;
+using testing::HasSubstr;
+using testing::IsEmpty;
+using testing::Optional;
+using zetasql_base::testing::IsOkAndHolds;
+using zetasql_base::testing::StatusIs;
+
+using types::BoolType;
+using types::DoubleType;
+using types::Int64Type;
+using types::StringType;
+
+using values::Bool;
+using values::Double;
+using values::Int64;
+using values::NullInt64;
+using values::NullString;
+using values::String;
+
+// The buffers of two record batches with columns (INT64, STRING, BOOL,
+// DOUBLE). The second batch is a slice with offset 1. Together they hold
+//   (1, "a", true, 0.5)
+//   (NULL, "bb", true, 1.5)
+//   (3, "ccc", false, 2.5)
+//   (4, "dd", false, 3.5)
+//   (5, "e", true, 4.5)
+constexpr int64_t kInt64s0[] = {1, 2, 3};
+constexpr uint8_t kInt64Validity0[] = {0x05};
+constexpr char kStrings0[] = "abbccc";
+constexpr int32_t kStringOffsets0[] = {0, 1, 3, 6};
+constexpr uint8_t kBools0[] = {0x03};
+constexpr double kDoubles0[] = {0.5, 1.5, 2.5};
+
+constexpr int64_t kInt64s1[] = {99, 4, 5};
+constexpr char kStrings1[] = "xdde";
+constexpr int32_t kStringOffsets1[] = {0, 1, 3, 4};
+constexpr uint8_t kBools1[] = {0x04};
+constexpr double kDoubles1[] = {9, 3.5, 4.5};
+
+ColumnarArrayView MakeView(const Type* type, int64_t length, int64_t offset,
+                           const void* values,
+                           const int32_t* value_offsets = nullptr,
+                           const uint8_t* validity = nullptr) {
+  ColumnarArrayView view;
+  view.type = type;
+  view.length = length;
+  view.offset = offset;
+  view.validity = validity;
+  view.values = values;
+  view.value_offsets = value_offsets;
+  return view;
+}
+
+std::vector<ColumnarRecordBatch> MakeBatches() {
+  std::vector<ColumnarRecordBatch> batches(2);
+  batches[0].num_rows = 3;
+  batches[0].columns = {
+      MakeView(Int64Type(), 3, 0, kInt64s0, nullptr, kInt64Validity0),
+      MakeView(StringType(), 3, 0, kStrings0, kStringOffsets0),
+      MakeView(BoolType(), 3, 0, kBools0),
+      MakeView(DoubleType(), 3, 0, kDoubles0)};
+  batches[1].num_rows = 2;
+  batches[1].columns = {
+      MakeView(Int64Type(), 2, 1, kInt64s1),
+      MakeView(StringType(), 2, 1, kStrings1, kStringOffsets1),
+      MakeView(BoolType(), 2, 1, kBools1),
+      MakeView(DoubleType(), 2, 1, kDoubles1)};
+  return batches;
+}
+
+class ColumnarEvaluatorTableIteratorTest : public ::testing::Test {
+ protected:
+  ColumnarEvaluatorTableIteratorTest()
+      : table_("TestTable", {{"c_int64", Int64Type()},
+                             {"c_string", StringType()},
+                             {"c_bool", BoolType()},
+                             {"c_double", DoubleType()}}) {}
+
+  void SetUp() override {
+    ZETASQL_ASSERT_OK(table_.SetColumnarContents(MakeBatches()));
+  }
+
+  absl::StatusOr<std::vector<std::vector<Value>>> Read(
+      EvaluatorTableIterator* iter) {
+    std::vector<std::vector<Value>> rows;
+    while (iter->NextRow()) {
+      std::vector<Value> row;
+      row.reserve(iter->NumColumns());
+      for (int i = 0; i < iter->NumColumns(); ++i) {
+        row.push_back(iter->GetValue(i));
+      }
+      rows.push_back(std::move(row));
+    }
+    ZETASQL_RETURN_IF_ERROR(iter->Status());
+    return rows;
+  }
+
+  std::unique_ptr<EvaluatorTableIterator> CreateIter(
+      const std::vector<int>& column_idxs) {
+    absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>> iter =
+        table_.CreateEvaluatorTableIterator(column_idxs);
+    ZETASQL_EXPECT_OK(iter.status());
+    return std::move(iter).value();
+  }
+
+  SimpleTable table_;
+};
+
+TEST_F(ColumnarEvaluatorTableIteratorTest, ReadsAllRows) {
+  std::unique_ptr<EvaluatorTableIterator> iter = CreateIter({0, 1, 2, 3});
+  EXPECT_EQ(iter->GetColumnName(1), "c_string");
+  EXPECT_TRUE(iter->GetColumnType(2)->IsBool());
+  EXPECT_THAT(
+      Read(iter.get()),
+      IsOkAndHolds(ElementsAre(
+          ElementsAre(Int64(1), String("a"), Bool(true), Double(0.5)),
+          ElementsAre(NullInt64(), String("bb"), Bool(true), Double(1.5)),
+          ElementsAre(Int64(3), String("ccc"), Bool(false), Double(2.5)),
+          ElementsAre(Int64(4), String("dd"), Bool(false), Double(3.5)),
+          ElementsAre(Int64(5), String("e"), Bool(true), Double(4.5)))));
+}
+
+TEST_F(ColumnarEvaluatorTableIteratorTest, SubsetOfColumns) {
+  std::unique_ptr<EvaluatorTableIterator> iter = CreateIter({3, 0});
+  EXPECT_THAT(Read(iter.get()),
+              IsOkAndHolds(ElementsAre(ElementsAre(Double(0.5), Int64(1)),
+                                       ElementsAre(Double(1.5), NullInt64()),
+                                       ElementsAre(Double(2.5), Int64(3)),
+                                       ElementsAre(Double(3.5), Int64(4)),
+                                       ElementsAre(Double(4.5), Int64(5)))));
+}
+
+TEST_F(ColumnarEvaluatorTableIteratorTest, RowRangeAcrossBatches) {
+  std::unique_ptr<EvaluatorTableIterator> iter = CreateIter({0, 1});
+  EXPECT_THAT(iter->GetNumRowsForSplitting(), Optional(5));
+  ZETASQL_ASSERT_OK(iter->SetRowRange(2, 4));
+  EXPECT_THAT(Read(iter.get()),
+              IsOkAndHolds(ElementsAre(ElementsAre(Int64(3), String("ccc")),
+                                       ElementsAre(Int64(4), String("dd")))));
+}
+
+TEST_F(ColumnarEvaluatorTableIteratorTest, RowRangeInSecondBatch) {
+  std::unique_ptr<EvaluatorTableIterator> iter = CreateIter({0});
+  ZETASQL_ASSERT_OK(iter->SetRowRange(4, 5));
+  EXPECT_THAT(Read(iter.get()),
+              IsOkAndHolds(ElementsAre(ElementsAre(Int64(5)))));
+}
+
+TEST_F(ColumnarEvaluatorTableIteratorTest, EmptyRowRange) {
+  std::unique_ptr<EvaluatorTableIterator> iter = CreateIter({0});
+  ZETASQL_ASSERT_OK(iter->SetRowRange(5, 5));
+  EXPECT_THAT(Read(iter.get()), IsOkAndHolds(IsEmpty()));
+}
+
+TEST_F(ColumnarEvaluatorTableIteratorTest, BadRowRange) {
+  std::unique_ptr<EvaluatorTableIterator> iter = CreateIter({0});
+  EXPECT_THAT(iter->SetRowRange(3, 2), StatusIs(absl::StatusCode::kInternal));
+  EXPECT_THAT(iter->SetRowRange(0, 6), StatusIs(absl::StatusCode::kInternal));
+
+  ASSERT_TRUE(iter->NextRow());
+  EXPECT_THAT(iter->SetRowRange(0, 1),
+              StatusIs(absl::StatusCode::kInternal,
+                       HasSubstr("cannot be called after NextRow()")));
+}
+
+TEST_F(ColumnarEvaluatorTableIteratorTest, Filters) {
+  std::unique_ptr<EvaluatorTableIterator> iter = CreateIter({0, 1});
+  absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map;
+  filter_map.emplace(0, std::make_unique<ColumnFilter>(Int64(2), Value()));
+  filter_map.emplace(1, std::make_unique<ColumnFilter>(
+                            ColumnFilter::Prefix(String("c"))));
+  ZETASQL_ASSERT_OK(iter->SetColumnFilterMap(std::move(filter_map)));
+  EXPECT_THAT(Read(iter.get()),
+              IsOkAndHolds(ElementsAre(ElementsAre(Int64(3), String("ccc")))));
+}
+
+TEST_F(ColumnarEvaluatorTableIteratorTest, IsNullFilter) {
+  std::unique_ptr<EvaluatorTableIterator> iter = CreateIter({0, 1});
+  absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map;
+  filter_map.emplace(
+      0, std::make_unique<ColumnFilter>(ColumnFilter::IsNull()));
+  ZETASQL_ASSERT_OK(iter->SetColumnFilterMap(std::move(filter_map)));
+  EXPECT_THAT(Read(iter.get()), IsOkAndHolds(ElementsAre(
+                                    ElementsAre(NullInt64(), String("bb")))));
+}
+
+TEST_F(ColumnarEvaluatorTableIteratorTest, UnreferencedColumnsAreNull) {
+  std::unique_ptr<EvaluatorTableIterator> iter = CreateIter({0, 1});
+  ZETASQL_ASSERT_OK(iter->SetReferencedColumns({1}));
+  // A filtered column is still evaluated even if it is not referenced.
+  absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map;
+  filter_map.emplace(0, std::make_unique<ColumnFilter>(Int64(4), Value()));
+  ZETASQL_ASSERT_OK(iter->SetColumnFilterMap(std::move(filter_map)));
+  EXPECT_THAT(Read(iter.get()),
+              IsOkAndHolds(ElementsAre(ElementsAre(NullInt64(), String("dd")),
+                                       ElementsAre(NullInt64(), String("e")))));
+}
+
+TEST_F(ColumnarEvaluatorTableIteratorTest, Cancel) {
+  std::unique_ptr<EvaluatorTableIterator> iter = CreateIter({0});
+  ASSERT_TRUE(iter->NextRow());
+  ZETASQL_ASSERT_OK(iter->Cancel());
+  EXPECT_FALSE(iter->NextRow());
+  EXPECT_THAT(iter->Status(), StatusIs(absl::StatusCode::kCancelled));
+}
+
+TEST_F(ColumnarEvaluatorTableIteratorTest, Deadline) {
+  std::unique_ptr<EvaluatorTableIterator> iter = CreateIter({0});
+  iter->SetDeadline(absl::InfinitePast());
+  EXPECT_FALSE(iter->NextRow());
+  EXPECT_THAT(iter->Status(), StatusIs(absl::StatusCode::kDeadlineExceeded));
+}
+
+// A dictionary-encoded STRING column with the rows
+//   "blue", "red", NULL, "blue", "blue"
+constexpr char kDictionaryStrings[] = "redblue";
+constexpr int32_t kDictionaryOffsets[] = {0, 3, 7};
+constexpr int32_t kDictionaryIndices[] = {1, 0, 0, 1, 1};
+constexpr uint8_t kDictionaryValidity[] = {0x1B};
+
+class ColumnarEvaluatorTableIteratorDictionaryTest : public ::testing::Test {
+ protected:
+  ColumnarEvaluatorTableIteratorDictionaryTest()
+      : table_("TestTable", {{"c_string", StringType()}}),
+        dictionary_(MakeView(StringType(), 2, 0, kDictionaryStrings,
+                             kDictionaryOffsets)) {}
+
+  ColumnarRecordBatch MakeBatch() {
+    ColumnarArrayView column = MakeView(StringType(), 5, 0, kDictionaryIndices,
+                                        nullptr, kDictionaryValidity);
+    column.dictionary = &dictionary_;
+    ColumnarRecordBatch batch;
+    batch.num_rows = 5;
+    batch.columns = {column};
+    return batch;
+  }
+
+  std::vector<Value> Read(
+      absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map) {
+    std::unique_ptr<EvaluatorTableIterator> iter =
+        table_.CreateEvaluatorTableIterator({0}).value();
+    ZETASQL_EXPECT_OK(iter->SetColumnFilterMap(std::move(filter_map)));
+    std::vector<Value> values;
+    while (iter->NextRow()) {
+      values.push_back(iter->GetValue(0));
+    }
+    ZETASQL_EXPECT_OK(iter->Status());
+    return values;
+  }
+
+  SimpleTable table_;
+  ColumnarArrayView dictionary_;
+};
+
+TEST_F(ColumnarEvaluatorTableIteratorDictionaryTest, ReadsAllRows) {
+  ZETASQL_ASSERT_OK(table_.SetColumnarContents({MakeBatch(), MakeBatch()}));
+  std::vector<Value> values = Read({});
+  EXPECT_THAT(values,
+              ElementsAre(String("blue"), String("red"), NullString(),
+                          String("blue"), String("blue"), String("blue"),
+                          String("red"), NullString(), String("blue"),
+                          String("blue")));
+  EXPECT_EQ(MakeBatch().columns[0].GetValue(3), String("blue"));
+}
+
+TEST_F(ColumnarEvaluatorTableIteratorDictionaryTest, Filters) {
+  ZETASQL_ASSERT_OK(table_.SetColumnarContents({MakeBatch()}));
+  absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map;
+  filter_map.emplace(0, std::make_unique<ColumnFilter>(
+                            ColumnFilter::Prefix(String("b"))));
+  EXPECT_THAT(Read(std::move(filter_map)),
+              ElementsAre(String("blue"), String("blue"), String("blue")));
+
+  filter_map.clear();
+  filter_map.emplace(
+      0, std::make_unique<ColumnFilter>(ColumnFilter::IsNull()));
+  EXPECT_THAT(Read(std::move(filter_map)), ElementsAre(NullString()));
+}
+
+TEST_F(ColumnarEvaluatorTableIteratorDictionaryTest, ValidateBatch) {
+  ZETASQL_EXPECT_OK(
+      ColumnarEvaluatorTableIterator::ValidateBatch(MakeBatch(),
+                                                    {StringType()}));
+
+  constexpr int32_t kBadIndices[] = {1, 0, 0, 2, 1};
+  ColumnarRecordBatch bad_index = MakeBatch();
+  bad_index.columns[0].values = kBadIndices;
+  EXPECT_THAT(
+      ColumnarEvaluatorTableIterator::ValidateBatch(bad_index, {StringType()}),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("has dictionary index 2 in row 3")));
+
+  ColumnarArrayView nested = dictionary_;
+  nested.dictionary = &dictionary_;
+  ColumnarRecordBatch nested_dictionary = MakeBatch();
+  nested_dictionary.columns[0].dictionary = &nested;
+  EXPECT_THAT(ColumnarEvaluatorTableIterator::ValidateBatch(nested_dictionary,
+                                                            {StringType()}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("must not be dictionary-encoded")));
+}
+
+TEST(ColumnarEvaluatorTableIteratorValidateTest, ValidateBatch) {
+  const std::vector<const Type*> column_types = {Int64Type(), StringType(),
+                                                 BoolType(), DoubleType()};
+  std::vector<ColumnarRecordBatch> batches = MakeBatches();
+  ZETASQL_EXPECT_OK(
+      ColumnarEvaluatorTableIterator::ValidateBatch(batches[0], column_types));
+
+  EXPECT_THAT(ColumnarEvaluatorTableIterator::ValidateBatch(
+                  batches[0], {Int64Type(), StringType()}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("has 4 columns instead of 2")));
+  EXPECT_THAT(ColumnarEvaluatorTableIterator::ValidateBatch(
+                  batches[0], {Int64Type(), StringType(), BoolType(),
+                               Int64Type()}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Column 3")));
+
+  ColumnarRecordBatch wrong_length = MakeBatches()[0];
+  wrong_length.columns[2].length = 2;
+  EXPECT_THAT(
+      ColumnarEvaluatorTableIterator::ValidateBatch(wrong_length, column_types),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("has 2 elements instead of 3")));
+
+  ColumnarRecordBatch missing_offsets = MakeBatches()[0];
+  missing_offsets.columns[1].value_offsets = nullptr;
+  EXPECT_THAT(ColumnarEvaluatorTableIterator::ValidateBatch(missing_offsets,
+                                                            column_types),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("is missing a buffer")));
+}
+
+TEST(ColumnarEvaluatorTableIteratorValidateTest, UnsupportedType) {
+  SimpleTable table("TestTable", {{"c_date", types::DateType()}});
+  ColumnarRecordBatch batch;
+  batch.columns = {MakeView(types::DateType(), 0, 0, nullptr)};
+  EXPECT_THAT(table.SetColumnarContents({batch}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("must be one of")));
+}
+
+}  // namespace
+}  // namespace zetasql
@@ -0,0 +1,192 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/common/columnar_result_reader.h"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/common/columnar_evaluator_table_iterator.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "absl/memory/memory.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+namespace {
+
+// The buffers of one column of a batch under construction.
+struct ColumnBuffers {
+  std::vector<uint8_t> validity;
+  std::vector<int64_t> int64_values;
+  std::vector<double> double_values;
+  // For BOOL, a bitmap. For STRING and BYTES, the payloads.
+  std::string bytes;
+  std::vector<int32_t> value_offsets = {0};
+  bool has_nulls = false;
+};
+
+void AppendBit(int64_t i, bool bit, std::vector<uint8_t>* bitmap) {
+  if (i % 8 == 0) bitmap->push_back(0);
+  if (bit) bitmap->back() |= uint8_t{1} << (i % 8);
+}
+
+// Returns the payload of 'value', which must be a non-NULL STRING or BYTES.
+absl::string_view Payload(const Value& value) {
+  return value.type()->IsString() ? absl::string_view(value.string_value())
+                                  : absl::string_view(value.bytes_value());
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<ColumnarResultReader>>
+ColumnarResultReader::Create(std::unique_ptr<EvaluatorTableIterator> iter,
+                             int64_t max_rows_per_batch) {
+  ZETASQL_RET_CHECK(iter != nullptr);
+  if (max_rows_per_batch <= 0) {
+    return zetasql_base::InvalidArgumentErrorBuilder()
+           << "The maximum number of rows per columnar batch must be positive";
+  }
+  for (int i = 0; i < iter->NumColumns(); ++i) {
+    if (!ColumnarArrayView::SupportsType(iter->GetColumnType(i))) {
+      return zetasql_base::InvalidArgumentErrorBuilder()
+             << "Column " << i << " has type "
+             << iter->GetColumnType(i)->DebugString()
+             << ", which cannot be read into a columnar batch";
+    }
+  }
+  return absl::WrapUnique(
+      new ColumnarResultReader(std::move(iter), max_rows_per_batch));
+}
+
+absl::StatusOr<bool> ColumnarResultReader::NextBatch(
+    ColumnarRecordBatch* batch) {
+  *batch = ColumnarRecordBatch();
+  if (done_) return false;
+
+  const int num_columns = iter_->NumColumns();
+  auto buffers = std::make_shared<std::vector<ColumnBuffers>>(num_columns);
+  int64_t num_rows = 0;
+  while (num_rows < max_rows_per_batch_) {
+    if (!has_pending_row_) {
+      if (!iter_->NextRow()) {
+        ZETASQL_RETURN_IF_ERROR(iter_->Status());
+        done_ = true;
+        break;
+      }
+      has_pending_row_ = true;
+    }
+
+    // Stop before this row if it would overflow the offsets of a STRING or
+    // BYTES column.
+    bool fits = true;
+    for (int i = 0; i < num_columns; ++i) {
+      const Value& value = iter_->GetValue(i);
+      if (value.is_null() ||
+          !(value.type()->IsString() || value.type()->IsBytes())) {
+        continue;
+      }
+      if ((*buffers)[i].bytes.size() + Payload(value).size() >
+          std::numeric_limits<int32_t>::max()) {
+        fits = false;
+        break;
+      }
+    }
+    if (!fits) {
+      if (num_rows == 0) {
+        return zetasql_base::OutOfRangeErrorBuilder()
+               << "A STRING or BYTES value is too large for a columnar batch";
+      }
+      break;
+    }
+
+    for (int i = 0; i < num_columns; ++i) {
+      const Value& value = iter_->GetValue(i);
+      ColumnBuffers& column = (*buffers)[i];
+      AppendBit(num_rows, !value.is_null(), &column.validity);
+      column.has_nulls |= value.is_null();
+      switch (iter_->GetColumnType(i)->kind()) {
+        case TYPE_INT64:
+          column.int64_values.push_back(value.is_null() ? 0
+                                                        : value.int64_value());
+          break;
+        case TYPE_DOUBLE:
+          column.double_values.push_back(
+              value.is_null() ? 0 : value.double_value());
+          break;
+        case TYPE_BOOL:
+          if (num_rows % 8 == 0) column.bytes.push_back(0);
+          if (!value.is_null() && value.bool_value()) {
+            column.bytes.back() |= static_cast<char>(1 << (num_rows % 8));
+          }
+          break;
+        case TYPE_STRING:
+        case TYPE_BYTES:
+          if (!value.is_null()) column.bytes.append(Payload(value));
+          column.value_offsets.push_back(
+              static_cast<int32_t>(column.bytes.size()));
+          break;
+        default:
+          ZETASQL_RET_CHECK_FAIL() << "Unsupported type: "
+                           << iter_->GetColumnType(i)->DebugString();
+      }
+    }
+    has_pending_row_ = false;
+    ++num_rows;
+  }
+
+  if (num_rows == 0) return false;
+
+  batch->num_rows = num_rows;
+  batch->columns.reserve(num_columns);
+  for (int i = 0; i < num_columns; ++i) {
+    const ColumnBuffers& column = (*buffers)[i];
+    ColumnarArrayView view;
+    view.type = iter_->GetColumnType(i);
+    view.length = num_rows;
+    view.validity = column.has_nulls ? column.validity.data() : nullptr;
+    switch (view.type->kind()) {
+      case TYPE_INT64:
+        view.values = column.int64_values.data();
+        break;
+      case TYPE_DOUBLE:
+        view.values = column.double_values.data();
+        break;
+      case TYPE_STRING:
+      case TYPE_BYTES:
+        view.value_offsets = column.value_offsets.data();
+        view.values = column.bytes.data();
+        break;
+      default:
+        view.values = column.bytes.data();
+        break;
+    }
+    batch->columns.push_back(view);
+  }
+  batch->owner = std::move(buffers);
+  return true;
+}
+
+}  // namespace zetasql
@@ -0,0 +1,75 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Reads the rows of an EvaluatorTableIterator (e.g., the result of
+// PreparedQueryBase::Execute()) into ColumnarRecordBatches, whose buffers are
+// in the Apache Arrow columnar memory layout (see
+// common/columnar_evaluator_table_iterator.h). Consumers can wrap those
+// buffers in Arrow arrays (for example with arrow::Buffer::Wrap() and
+// arrow::ArrayData::Make(), keeping the batch's 'owner' alive) instead of
+// copying the result one Value at a time.
+
+#ifndef ZETASQL_COMMON_COLUMNAR_RESULT_READER_H_
+#define ZETASQL_COMMON_COLUMNAR_RESULT_READER_H_
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "zetasql/common/columnar_evaluator_table_iterator.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "absl/status/statusor.h"
+
+namespace zetasql {
+
+class ColumnarResultReader {
+ public:
+  // Returns an error if 'max_rows_per_batch' is not positive or if 'iter' has
+  // a column whose type is not supported by ColumnarArrayView.
+  static absl::StatusOr<std::unique_ptr<ColumnarResultReader>> Create(
+      std::unique_ptr<EvaluatorTableIterator> iter,
+      int64_t max_rows_per_batch);
+
+  ColumnarResultReader(const ColumnarResultReader&) = delete;
+  ColumnarResultReader& operator=(const ColumnarResultReader&) = delete;
+
+  // The underlying iterator, e.g., for its column names and types. Must not
+  // be advanced by the caller.
+  const EvaluatorTableIterator& iterator() const { return *iter_; }
+
+  // Reads the next at most 'max_rows_per_batch' rows into 'batch', whose
+  // buffers are owned by 'batch->owner'. Returns false with an empty 'batch'
+  // once there are no more rows. A batch may hold fewer rows than the maximum
+  // before the end, if the payloads of a STRING or BYTES column would not fit
+  // in int32 offsets.
+  absl::StatusOr<bool> NextBatch(ColumnarRecordBatch* batch);
+
+ private:
+  ColumnarResultReader(std::unique_ptr<EvaluatorTableIterator> iter,
+                       int64_t max_rows_per_batch)
+      : iter_(std::move(iter)), max_rows_per_batch_(max_rows_per_batch) {}
+
+  std::unique_ptr<EvaluatorTableIterator> iter_;
+  const int64_t max_rows_per_batch_;
+  // True if 'iter_' is positioned on a row that has not been read into a
+  // batch yet.
+  bool has_pending_row_ = false;
+  bool done_ = false;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_COMMON_COLUMNAR_RESULT_READER_H_
@@ -0,0 +1,209 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/common/columnar_result_reader.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/common/columnar_evaluator_table_iterator.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+
+namespace zetasql {
+namespace {
+
+using testing::ElementsAre;
+using testing::HasSubstr;
+using testing::IsEmpty;
+using zetasql_base::testing::IsOkAndHolds;
+using zetasql_base::testing::StatusIs;
+
+using types::BoolType;
+using types::BytesType;
+using types::DoubleType;
+using types::Int64Type;
+using types::StringType;
+
+using values::Bool;
+using values::Bytes;
+using values::Double;
+using values::Int64;
+using values::NullBool;
+using values::NullBytes;
+using values::NullDouble;
+using values::NullInt64;
+using values::NullString;
+using values::String;
+
+class ColumnarResultReaderTest : public ::testing::Test {
+ protected:
+  ColumnarResultReaderTest()
+      : table_("TestTable", {{"c_int64", Int64Type()},
+                             {"c_double", DoubleType()},
+                             {"c_bool", BoolType()},
+                             {"c_string", StringType()},
+                             {"c_bytes", BytesType()}}) {
+    table_.SetContents(
+        {{Int64(1), Double(0.5), Bool(true), String("a"), Bytes("x")},
+         {NullInt64(), NullDouble(), NullBool(), NullString(), NullBytes()},
+         {Int64(3), Double(2.5), Bool(false), String(""), Bytes("yz")},
+         {Int64(4), Double(3.5), Bool(true), String("dd"), Bytes("")},
+         {Int64(5), Double(4.5), Bool(false), String("eee"), Bytes("w")}});
+  }
+
+  // Returns the rows of all the batches read by 'reader', one inner vector
+  // per batch.
+  absl::StatusOr<std::vector<std::vector<std::vector<Value>>>> ReadAll(
+      ColumnarResultReader* reader) {
+    std::vector<std::vector<std::vector<Value>>> batches;
+    ColumnarRecordBatch batch;
+    while (true) {
+      ZETASQL_ASSIGN_OR_RETURN(const bool has_batch, reader->NextBatch(&batch));
+      if (!has_batch) {
+        EXPECT_EQ(batch.num_rows, 0);
+        return batches;
+      }
+      std::vector<std::vector<Value>> rows;
+      for (int64_t i = 0; i < batch.num_rows; ++i) {
+        std::vector<Value> row;
+        for (const ColumnarArrayView& column : batch.columns) {
+          row.push_back(column.GetValue(i));
+        }
+        rows.push_back(std::move(row));
+      }
+      batches.push_back(std::move(rows));
+    }
+  }
+
+  std::unique_ptr<EvaluatorTableIterator> CreateIter(
+      const std::vector<int>& column_idxs) {
+    return table_.CreateEvaluatorTableIterator(column_idxs).value();
+  }
+
+  SimpleTable table_;
+};
+
+TEST_F(ColumnarResultReaderTest, ReadsAllTypes) {
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<ColumnarResultReader> reader,
+                       ColumnarResultReader::Create(
+                           CreateIter({0, 1, 2, 3, 4}),
+                           /*max_rows_per_batch=*/10));
+  EXPECT_THAT(
+      ReadAll(reader.get()),
+      IsOkAndHolds(ElementsAre(ElementsAre(
+          ElementsAre(Int64(1), Double(0.5), Bool(true), String("a"),
+                      Bytes("x")),
+          ElementsAre(NullInt64(), NullDouble(), NullBool(), NullString(),
+                      NullBytes()),
+          ElementsAre(Int64(3), Double(2.5), Bool(false), String(""),
+                      Bytes("yz")),
+          ElementsAre(Int64(4), Double(3.5), Bool(true), String("dd"),
+                      Bytes("")),
+          ElementsAre(Int64(5), Double(4.5), Bool(false), String("eee"),
+                      Bytes("w"))))));
+}
+
+TEST_F(ColumnarResultReaderTest, SplitsIntoBatches) {
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<ColumnarResultReader> reader,
+                       ColumnarResultReader::Create(
+                           CreateIter({0, 3}), /*max_rows_per_batch=*/2));
+  EXPECT_THAT(
+      ReadAll(reader.get()),
+      IsOkAndHolds(ElementsAre(
+          ElementsAre(ElementsAre(Int64(1), String("a")),
+                      ElementsAre(NullInt64(), NullString())),
+          ElementsAre(ElementsAre(Int64(3), String("")),
+                      ElementsAre(Int64(4), String("dd"))),
+          ElementsAre(ElementsAre(Int64(5), String("eee"))))));
+}
+
+TEST_F(ColumnarResultReaderTest, NoValidityBitmapWithoutNulls) {
+  SimpleTable table("T", {{"c", Int64Type()}});
+  table.SetContents({{Int64(1)}, {Int64(2)}});
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ColumnarResultReader> reader,
+      ColumnarResultReader::Create(
+          table.CreateEvaluatorTableIterator({0}).value(),
+          /*max_rows_per_batch=*/10));
+  ColumnarRecordBatch batch;
+  EXPECT_THAT(reader->NextBatch(&batch), IsOkAndHolds(true));
+  ASSERT_EQ(batch.columns.size(), 1);
+  EXPECT_EQ(batch.columns[0].validity, nullptr);
+  EXPECT_THAT(reader->NextBatch(&batch), IsOkAndHolds(false));
+}
+
+TEST_F(ColumnarResultReaderTest, EmptyResult) {
+  SimpleTable table("T", {{"c", Int64Type()}});
+  table.SetContents({});
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ColumnarResultReader> reader,
+      ColumnarResultReader::Create(
+          table.CreateEvaluatorTableIterator({0}).value(),
+          /*max_rows_per_batch=*/10));
+  EXPECT_THAT(ReadAll(reader.get()), IsOkAndHolds(IsEmpty()));
+}
+
+TEST_F(ColumnarResultReaderTest, BatchesCanBeScannedAgain) {
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<ColumnarResultReader> reader,
+                       ColumnarResultReader::Create(
+                           CreateIter({0, 1, 2, 3, 4}),
+                           /*max_rows_per_batch=*/3));
+  std::vector<ColumnarRecordBatch> batches(2);
+  EXPECT_THAT(reader->NextBatch(&batches[0]), IsOkAndHolds(true));
+  EXPECT_THAT(reader->NextBatch(&batches[1]), IsOkAndHolds(true));
+
+  SimpleTable copy("Copy", {{"c_int64", Int64Type()},
+                            {"c_double", DoubleType()},
+                            {"c_bool", BoolType()},
+                            {"c_string", StringType()},
+                            {"c_bytes", BytesType()}});
+  ZETASQL_ASSERT_OK(copy.SetColumnarContents(std::move(batches)));
+  std::unique_ptr<EvaluatorTableIterator> iter =
+      copy.CreateEvaluatorTableIterator({3}).value();
+  std::vector<Value> values;
+  while (iter->NextRow()) values.push_back(iter->GetValue(0));
+  ZETASQL_EXPECT_OK(iter->Status());
+  EXPECT_THAT(values, ElementsAre(String("a"), NullString(), String(""),
+                                  String("dd"), String("eee")));
+}
+
+TEST_F(ColumnarResultReaderTest, InvalidArguments) {
+  EXPECT_THAT(ColumnarResultReader::Create(CreateIter({0}),
+                                           /*max_rows_per_batch=*/0),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("must be positive")));
+
+  SimpleTable table("T", {{"c", types::DateType()}});
+  table.SetContents({});
+  EXPECT_THAT(ColumnarResultReader::Create(
+                  table.CreateEvaluatorTableIterator({0}).value(),
+                  /*max_rows_per_batch=*/10),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("cannot be read into a columnar batch")));
+}
+
+}  // namespace
+}  // namespace zetasql
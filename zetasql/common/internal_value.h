@@ -17,6 +17,7 @@
 #ifndef ZETASQL_COMMON_INTERNAL_VALUE_H_
 #define ZETASQL_COMMON_INTERNAL_VALUE_H_
 
+#include <cstdint>
 #include <string>
 #include <utility>
 #include <vector>
@@ -25,6 +26,9 @@
 #include "zetasql/public/type.h"
 #include "zetasql/public/types/value_equality_check_options.h"
 #include "zetasql/public/value.h"
+#include "absl/base/optimization.h"
+#include "absl/hash/hash.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/span.h"
 
 namespace zetasql {
@@ -102,6 +106,30 @@ class InternalValue {
     return x.proto_ptr_;
   }
 
+  // Returns a hash of the content of 'x', which must be a non-NULL STRING or
+  // BYTES Value. The hash is computed once per content and cached with it, so
+  // that Values sharing content (e.g., copies of the decoded entries of a
+  // dictionary-encoded column) are hashed in constant time. Equal strings have
+  // equal hashes within a process.
+  static uint32_t StringContentHash(const Value& x) {
+    const internal::StringRef* ref = x.string_ptr_;
+    uint32_t hash = ref->cached_hash();
+    if (ABSL_PREDICT_FALSE(hash == 0)) {
+      // Never 0, which means "not set".
+      hash = static_cast<uint32_t>(
+                 absl::HashOf(absl::string_view(ref->value()))) |
+             1;
+      ref->set_cached_hash(hash);
+    }
+    return hash;
+  }
+
+  // Returns true if 'x' and 'y', which must be non-NULL STRING or BYTES Values,
+  // share their content. This implies that they are equal.
+  static bool SharesStringContent(const Value& x, const Value& y) {
+    return x.string_ptr_ == y.string_ptr_;
+  }
+
   static std::string FormatInternal(const Value& x,
                                     bool include_array_ordereness
   ) {
@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <ostream>
 #include <string>
 
@@ -50,6 +51,8 @@ JSONParser::~JSONParser() {}
 
 bool JSONParser::Parse() {
   p_ = json_;
+  skip_next_value_max_depth_ = -1;
+  skipped_value_too_deep_ = false;
 
   bool ret = ParseValue();
   // Test that the entire string was consumed
@@ -84,6 +87,182 @@ bool JSONParser::ParseValue() {
   }
 }
 
+bool JSONParser::ParseOrSkipValue() {
+  if (skip_next_value_max_depth_ < 0) {
+    return ParseValue();
+  }
+  const int max_depth = skip_next_value_max_depth_;
+  skip_next_value_max_depth_ = -1;
+  return SkipValue(max_depth);
+}
+
+bool JSONParser::SkipValue(int max_depth) {
+  switch (GetNextTokenType()) {
+    case BEGIN_STRING:
+      return SkipStringHelper();
+    case BEGIN_NUMBER: {
+      absl::string_view str;
+      return ParseNumberTextHelper(&str);
+    }
+    case BEGIN_OBJECT:
+      return SkipObject(max_depth);
+    case BEGIN_ARRAY:
+      return SkipArray(max_depth);
+    case BEGIN_TRUE:
+      p_.remove_prefix(kTrue.length());
+      return true;
+    case BEGIN_FALSE:
+      p_.remove_prefix(kFalse.length());
+      return true;
+    case BEGIN_NULL:
+      p_.remove_prefix(kNull.length());
+      return true;
+    case END_ARRAY:
+    case VALUE_SEPARATOR:
+      return true;
+    default:
+      return ReportFailure("Unexpected token");
+  }
+}
+
+bool JSONParser::SkipObject(int max_depth) {
+  ABSL_DCHECK_EQ('{', *p_.data());
+  AdvanceOneByte();
+  if (max_depth <= 0) {
+    skipped_value_too_deep_ = true;
+    return ReportFailure("Skipped value is nested too deeply");
+  }
+
+  TokenType t = GetNextTokenType();
+  if (t == END_OBJECT) {
+    AdvanceOneByte();
+    return true;
+  }
+  while (true) {
+    t = GetNextTokenType();
+    if (t == BEGIN_STRING) {
+      if (!SkipStringHelper()) return false;
+    } else if (t == BEGIN_KEY || t == BEGIN_NUMBER) {
+      return ReportFailure("Non-string key encountered while parsing object");
+    } else {
+      return ReportFailure("Expected key");
+    }
+
+    SkipWhitespace();
+    if (p_.empty() || *p_.data() != ':')
+      return ReportFailure("Expected : between key:value pair");
+    AdvanceOneByte();
+
+    if (!SkipValue(max_depth - 1)) return ReportFailure("Could not parse value");
+
+    t = GetNextTokenType();
+    AdvanceOneByte();
+    if (t == END_OBJECT) return true;
+    if (t == VALUE_SEPARATOR) {
+      t = GetNextTokenType();
+      if (t == END_OBJECT) {
+        AdvanceOneByte();
+        return true;
+      }
+      continue;
+    }
+    return ReportFailure("Expected , or } after key:value pair");
+  }
+}
+
+bool JSONParser::SkipArray(int max_depth) {
+  ABSL_DCHECK_EQ('[', *p_.data());
+  AdvanceOneByte();
+  if (max_depth <= 0) {
+    skipped_value_too_deep_ = true;
+    return ReportFailure("Skipped value is nested too deeply");
+  }
+
+  TokenType t = GetNextTokenType();
+  if (t == END_ARRAY) {
+    AdvanceOneByte();
+    return true;
+  }
+  while (true) {
+    if (!SkipValue(max_depth - 1)) return ReportFailure("Could not parse value");
+
+    t = GetNextTokenType();
+    AdvanceOneByte();
+    if (t == END_ARRAY) return true;
+    if (t == VALUE_SEPARATOR) {
+      t = GetNextTokenType();
+      if (t == END_ARRAY) {
+        AdvanceOneByte();
+        return true;
+      }
+      continue;
+    }
+    return ReportFailure("Expected , or ] after array value");
+  }
+}
+
+// Returns the offset of the first `quote` or backslash in `str`, or
+// `str.size()` if there is none. Looks at eight bytes at a time, since strings
+// in JSON documents are usually much longer than their escape sequences.
+static size_t FindQuoteOrBackslash(absl::string_view str, char quote) {
+  constexpr uint64_t kOnes = 0x0101010101010101;
+  constexpr uint64_t kHighBits = 0x8080808080808080;
+  const uint64_t quotes = kOnes * static_cast<uint8_t>(quote);
+  const uint64_t backslashes = kOnes * static_cast<uint8_t>('\\');
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= str.size(); i += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, str.data() + i, sizeof(word));
+    // (x - kOnes) & ~x & kHighBits is nonzero iff some byte of x is zero.
+    const uint64_t x = word ^ quotes;
+    const uint64_t y = word ^ backslashes;
+    if ((((x - kOnes) & ~x) | ((y - kOnes) & ~y)) & kHighBits) break;
+  }
+  for (; i < str.size(); ++i) {
+    if (str[i] == quote || str[i] == '\\') break;
+  }
+  return i;
+}
+
+bool JSONParser::SkipHexDigits(const int size) {
+  if (p_.length() < size) {
+    return false;
+  }
+  for (int i = 2; i < size; ++i) {
+    if (!absl::ascii_isxdigit(p_.data()[i])) {
+      return ReportFailure("Invalid escape sequence.");
+    }
+  }
+  p_.remove_prefix(size);
+  return true;
+}
+
+bool JSONParser::SkipStringHelper() {
+  const char open = *p_.data();
+  ABSL_DCHECK(open == '\"' || open == '\'');
+  AdvanceOneByte();
+  // Only escape sequences and the closing quote need to be looked at: in valid
+  // UTF-8, neither a quote nor a backslash occurs inside a multi-byte
+  // character, so this finds the same ones as ParseStringHelper().
+  while (true) {
+    p_.remove_prefix(FindQuoteOrBackslash(p_, open));
+    if (p_.empty()) return ReportFailure("Closing quote expected in string");
+    if (*p_.data() == open) {
+      AdvanceOneByte();
+      return true;
+    }
+    if (p_.length() == 1) return false;
+    if (p_.data()[1] == 'u') {
+      if (!SkipHexDigits(kUnicodeEscapedLength)) return false;
+    } else if (p_.data()[1] == 'x') {
+      if (!SkipHexDigits(kLatin1HexEscapedLength)) return false;
+    } else {
+      // Octal digits after the backslash are skipped like other characters.
+      p_.remove_prefix(2);
+    }
+  }
+}
+
 bool JSONParser::ParseString() {
   std::string str;
   if (!ParseStringHelper(&str)) return false;
@@ -352,7 +531,7 @@ bool JSONParser::ParseObject() {
     AdvanceOneByte();
 
     // Parse the value for this member
-    if (!ParseValue()) return ReportFailure("Could not parse value");
+    if (!ParseOrSkipValue()) return ReportFailure("Could not parse value");
 
     // ',' '}' or possibly ',}' must appear next.
     t = GetNextTokenType();
@@ -395,7 +574,7 @@ bool JSONParser::ParseArray() {
   while (true) {
     if (!BeginArrayEntry())
       return ReportFailure("BeginArrayEntry returned false");
-    if (!ParseValue()) return ReportFailure("Could not parse value");
+    if (!ParseOrSkipValue()) return ReportFailure("Could not parse value");
 
     // ',' ']' or possibly ',]' must appear next.
     t = GetNextTokenType();
@@ -95,6 +95,19 @@ class JSONParser {
   // Useful for error messages.
   std::string ContextAtCurrentPosition(int context_length) const;
 
+  // May be called from BeginMember() or BeginArrayEntry() to skip the value of
+  // that member or array entry. The value is still checked with the same
+  // grammar as by Parse(), but without calling any of the functions above for
+  // it and without unescaping its strings, so skipping is much faster for
+  // subtrees the client does not need. Objects and arrays may nest at most
+  // `max_depth` levels in the skipped value (which counts as one level);
+  // otherwise the parse fails and SkippedValueTooDeep() returns true.
+  void SkipNextValue(int max_depth) { skip_next_value_max_depth_ = max_depth; }
+
+  // Returns whether the parse failed because a value skipped with
+  // SkipNextValue() was nested too deeply.
+  bool SkippedValueTooDeep() const { return skipped_value_too_deep_; }
+
  private:
   enum TokenType {
     BEGIN_STRING,         // " or '
@@ -114,6 +127,22 @@ class JSONParser {
   // Handles any type
   bool ParseValue();
 
+  // Calls SkipValue() instead of ParseValue() if SkipNextValue() was called.
+  bool ParseOrSkipValue();
+
+  // Like ParseValue() and the functions it calls, but without calling any of
+  // the client functions and with objects and arrays nested at most
+  // `max_depth` levels.
+  bool SkipValue(int max_depth);
+  bool SkipObject(int max_depth);
+  bool SkipArray(int max_depth);
+  // Expects p_ to point to the beginning of a string, and advances p_ past
+  // its closing quote.
+  bool SkipStringHelper();
+  // Checks and advances p_ past an escape sequence of `size` bytes that
+  // begins with \u or \x.
+  bool SkipHexDigits(int size);
+
   // Expects p_ to point to the beginning of a string.
   bool ParseString();
 
@@ -169,6 +198,10 @@ class JSONParser {
 
   // A pointer into json_ to keep track of the current parsing location.
   absl::string_view p_;
+
+  // The argument of the pending SkipNextValue() call, or -1 if there is none.
+  int skip_next_value_max_depth_ = -1;
+  bool skipped_value_too_deep_ = false;
 };
 
 }  // namespace zetasql
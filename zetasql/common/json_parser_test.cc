@@ -25,6 +25,7 @@
 #include "gtest/gtest.h"
 #include "absl/flags/flag.h"
 #include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 
@@ -142,6 +143,26 @@ class JSONToJSON : private StringNoTerminator, public JSONParser {
   }
 };
 
+// Like JSONToJSON, but skips the values of members with key "skip".
+class SkippingJSONToJSON : public JSONToJSON {
+ public:
+  explicit SkippingJSONToJSON(absl::string_view js, int max_depth = 10)
+      : JSONToJSON(js), max_depth_(max_depth) {}
+
+  using JSONParser::SkippedValueTooDeep;
+
+ protected:
+  bool BeginMember(const std::string& key) override {
+    if (key == "skip") {
+      SkipNextValue(max_depth_);
+    }
+    return JSONToJSON::BeginMember(key);
+  }
+
+ private:
+  const int max_depth_;
+};
+
 // Parse `input` and test that the pretty-printed result matches `expected`.
 static void ParseAndCompare(absl::string_view input,
                             absl::string_view expected) {
@@ -639,6 +660,50 @@ TEST(JSONParserTest, KeyValueFail) {
   }
 }
 
+TEST(JSONParserTest, SkipNextValue) {
+  SkippingJSONToJSON parser(
+      R"({"a": 1, "skip": {"b": [1, "x\"y", {"c": null}], "d": 'e'}, "f": 2})");
+  ASSERT_TRUE(parser.Parse());
+  EXPECT_EQ(parser.output(),
+            "{\n"
+            "  \"a\" : 1,\n"
+            "  \"skip\" : ,\n"
+            "\"f\" : 2\n"
+            "}");
+}
+
+TEST(JSONParserTest, SkipNextValueAcceptsTheSameValues) {
+  const char* values[] = {
+      "1",           "-1.5e+3",     "1.",         "-",
+      "true",        "nul",         "null",       "\"abc\"",
+      "'abc'",       "\"a\\\"b\"",   "\"\\u00e9\"",   "\"\\u00g9\"",
+      "\"\\u00\"",     "\"\\x41\"",     "\"\\101\"",    "\"\\",
+      "\"abc",       "\"a']\"",      "[]",         "[1, 2,]",
+      "[1,,2]",      "[,1]",        "[1 2]",      "[1, 2}",
+      "{}",          "{\"a\": 1,}",  "{\"a\": 1,,}", "{\"a\" 1}",
+      "{a: 1}",      "{1: 1}",      "{\"a\": [}", "[{\"a\": [1, {}]}]",
+      "\"\xE6\x95\x8F\"", "\"long string with \\\"escapes\\\" and more text\"",
+  };
+  for (const char* value : values) {
+    const std::string input = absl::StrCat(R"({"skip": )", value, R"(, "a": 1})");
+    JSONParser parser(input);
+    SkippingJSONToJSON skipping_parser(input);
+    EXPECT_EQ(parser.Parse(), skipping_parser.Parse()) << "Input: " << input;
+    EXPECT_FALSE(skipping_parser.SkippedValueTooDeep());
+  }
+}
+
+TEST(JSONParserTest, SkipNextValueMaxDepth) {
+  SkippingJSONToJSON parser(R"({"skip": [[{"a": []}]]})", /*max_depth=*/4);
+  EXPECT_TRUE(parser.Parse());
+  EXPECT_FALSE(parser.SkippedValueTooDeep());
+
+  SkippingJSONToJSON too_deep_parser(R"({"skip": [[{"a": []}]]})",
+                                     /*max_depth=*/3);
+  EXPECT_FALSE(too_deep_parser.Parse());
+  EXPECT_TRUE(too_deep_parser.SkippedValueTooDeep());
+}
+
 // Functions
 
 const char* FunctionSimple_cases[] = {
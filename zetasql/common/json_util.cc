@@ -16,6 +16,7 @@
 
 #include "zetasql/common/json_util.h"
 
+#include <array>
 #include <string>
 
 #include "absl/strings/str_format.h"
@@ -23,10 +24,38 @@
 
 namespace zetasql {
 
+namespace {
+
+// The bytes at which JsonEscapeAndAppendString() may have to escape something:
+// control characters, quotes, backslashes, and the first byte of U+2028 and
+// U+2029.
+constexpr std::array<bool, 256> kMayNeedEscaping = [] {
+  std::array<bool, 256> may_need_escaping = {};
+  for (int c = 0; c < 0x20; ++c) {
+    may_need_escaping[c] = true;
+  }
+  may_need_escaping['\"'] = true;
+  may_need_escaping['\\'] = true;
+  may_need_escaping[0xe2] = true;
+  return may_need_escaping;
+}();
+
+}  // namespace
+
 void JsonEscapeAndAppendString(absl::string_view raw, std::string* output) {
   output->push_back('"');
   const size_t length = raw.length();
   for (size_t i = 0; i < length; ++i) {
+    // Copy the bytes up to the next one that may need escaping at once. For
+    // most strings, that is all of them.
+    const size_t begin = i;
+    while (i < length &&
+           !kMayNeedEscaping[static_cast<unsigned char>(raw[i])]) {
+      ++i;
+    }
+    output->append(raw.data() + begin, i - begin);
+    if (i == length) break;
+
     const unsigned char c = raw[i];
     if (c < 0x20) {
       // Not printable.
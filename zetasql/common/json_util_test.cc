@@ -67,6 +67,16 @@ TEST(JsonEscapeString, BigTest) {
                        R"("Σ\u2028Σ\u2029Σ\n\f\u0010\\\t")");
 }
 
+// Test runs of characters that are not escaped between ones that are.
+TEST(JsonEscapeString, Runs) {
+  TestJsonEscapeString("abc\"def\\ghi\nj", R"("abc\"def\\ghi\nj")");
+  TestJsonEscapeString("\"abc\"", R"("\"abc\"")");
+  TestJsonEscapeString("ab\xe2", "\"ab\xe2\"");
+  TestJsonEscapeString("ab\xe2\x80", "\"ab\xe2\x80\"");
+  TestJsonEscapeString(std::string(100, 'x') + "\u2028",
+                       "\"" + std::string(100, 'x') + R"(\u2028")");
+}
+
 TEST(JsonEscapeString, Append) {
   std::string buffer = "field_name:";
 
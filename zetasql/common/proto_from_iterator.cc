@@ -16,6 +16,7 @@
 
 #include "zetasql/common/proto_from_iterator.h"
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
@@ -23,10 +24,15 @@
 
 #include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/message.h"
+#include "google/protobuf/wire_format_lite.h"
 #include "zetasql/public/convert_type_to_proto.h"
 #include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/proto/type_annotation.pb.h"
 #include "zetasql/public/proto_value_conversion.h"
+#include "zetasql/public/types/proto_type.h"
 #include "zetasql/public/types/type.h"
 #include "zetasql/public/value.h"
 #include "absl/memory/memory.h"
@@ -151,4 +157,146 @@ absl::StatusOr<std::unique_ptr<google::protobuf::Message>> ProtoFromIterator(
   return table_msg;
 }
 
+namespace {
+
+using google::protobuf::internal::WireFormatLite;
+
+// Returns true if a value of type 'type' can be written to 'field' by
+// WriteScalarField(), with the same result as MergeValueToProtoField().
+bool CanWriteScalarField(const Type* type,
+                         const google::protobuf::FieldDescriptor* field) {
+  if (field->is_repeated() || !field->has_presence() ||
+      ProtoType::GetFormatAnnotation(field) != FieldFormat::DEFAULT_FORMAT) {
+    return false;
+  }
+  switch (type->kind()) {
+    case TYPE_INT32:
+      return field->type() == google::protobuf::FieldDescriptor::TYPE_INT32;
+    case TYPE_INT64:
+      return field->type() == google::protobuf::FieldDescriptor::TYPE_INT64;
+    case TYPE_UINT32:
+      return field->type() == google::protobuf::FieldDescriptor::TYPE_UINT32;
+    case TYPE_UINT64:
+      return field->type() == google::protobuf::FieldDescriptor::TYPE_UINT64;
+    case TYPE_BOOL:
+      return field->type() == google::protobuf::FieldDescriptor::TYPE_BOOL;
+    case TYPE_FLOAT:
+      return field->type() == google::protobuf::FieldDescriptor::TYPE_FLOAT;
+    case TYPE_DOUBLE:
+      return field->type() == google::protobuf::FieldDescriptor::TYPE_DOUBLE;
+    case TYPE_STRING:
+      return field->type() == google::protobuf::FieldDescriptor::TYPE_STRING;
+    case TYPE_BYTES:
+      return field->type() == google::protobuf::FieldDescriptor::TYPE_BYTES;
+    default:
+      return false;
+  }
+}
+
+// Writes a non-NULL 'value' as 'field' to 'output'. Requires
+// CanWriteScalarField(value.type(), field).
+absl::Status WriteScalarField(const Value& value,
+                              const google::protobuf::FieldDescriptor* field,
+                              google::protobuf::io::CodedOutputStream& output) {
+  const int number = field->number();
+  switch (value.type_kind()) {
+    case TYPE_INT32:
+      WireFormatLite::WriteInt32(number, value.int32_value(), &output);
+      break;
+    case TYPE_INT64:
+      WireFormatLite::WriteInt64(number, value.int64_value(), &output);
+      break;
+    case TYPE_UINT32:
+      WireFormatLite::WriteUInt32(number, value.uint32_value(), &output);
+      break;
+    case TYPE_UINT64:
+      WireFormatLite::WriteUInt64(number, value.uint64_value(), &output);
+      break;
+    case TYPE_BOOL:
+      WireFormatLite::WriteBool(number, value.bool_value(), &output);
+      break;
+    case TYPE_FLOAT:
+      WireFormatLite::WriteFloat(number, value.float_value(), &output);
+      break;
+    case TYPE_DOUBLE:
+      WireFormatLite::WriteDouble(number, value.double_value(), &output);
+      break;
+    case TYPE_STRING:
+      WireFormatLite::WriteString(number, value.string_value(), &output);
+      break;
+    case TYPE_BYTES:
+      WireFormatLite::WriteBytes(number, value.bytes_value(), &output);
+      break;
+    default:
+      ZETASQL_RET_CHECK_FAIL() << "Unexpected type " << value.type()->DebugString();
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::Status SerializeProtoFromIterator(
+    EvaluatorTableIterator& iter, const google::protobuf::Descriptor& table,
+    google::protobuf::MessageFactory& message_factory,
+    google::protobuf::io::CodedOutputStream& output) {
+  ZETASQL_RET_CHECK_GE(table.field_count(), 1) << table.DebugString();
+
+  const google::protobuf::FieldDescriptor* field = table.field(0);
+
+  ZETASQL_RET_CHECK(field->is_repeated());
+  ZETASQL_RET_CHECK_EQ(field->type(), google::protobuf::FieldDescriptor::TYPE_MESSAGE)
+      << field->DebugString();
+
+  const google::protobuf::Descriptor* row = field->message_type();
+  ZETASQL_RET_CHECK_GE(row->field_count(), iter.NumColumns());
+
+  // Decide once per column whether its values are written directly.
+  std::vector<bool> write_scalar(iter.NumColumns());
+  for (int i = 0; i < iter.NumColumns(); ++i) {
+    write_scalar[i] = CanWriteScalarField(iter.GetColumnType(i), row->field(i));
+  }
+
+  // Only used for the columns that are not written directly. Each of them is
+  // merged into an empty message and serialized on its own, so that the fields
+  // of a row are written in column order.
+  const std::unique_ptr<google::protobuf::Message> row_msg =
+      absl::WrapUnique(message_factory.GetPrototype(row)->New());
+
+  std::string row_bytes;
+  while (true) {
+    if (!iter.NextRow()) {
+      ZETASQL_RETURN_IF_ERROR(iter.Status());
+      break;
+    }
+
+    row_bytes.clear();
+    {
+      google::protobuf::io::StringOutputStream row_stream(&row_bytes);
+      google::protobuf::io::CodedOutputStream row_output(&row_stream);
+      for (int i = 0; i < iter.NumColumns(); ++i) {
+        const Value& value = iter.GetValue(i);
+        const google::protobuf::FieldDescriptor* field_desc = row->field(i);
+        if (write_scalar[i]) {
+          if (!value.is_null()) {
+            ZETASQL_RETURN_IF_ERROR(WriteScalarField(value, field_desc, row_output));
+          }
+          continue;
+        }
+        row_msg->Clear();
+        ZETASQL_RETURN_IF_ERROR(MergeValueToProtoField(value, field_desc, true,
+                                               &message_factory, row_msg.get()));
+        ZETASQL_RET_CHECK(row_msg->SerializePartialToCodedStream(&row_output));
+      }
+    }
+
+    WireFormatLite::WriteTag(field->number(),
+                             WireFormatLite::WIRETYPE_LENGTH_DELIMITED, &output);
+    output.WriteVarint32(static_cast<uint32_t>(row_bytes.size()));
+    output.WriteString(row_bytes);
+    ZETASQL_RET_CHECK(!output.HadError()) << "Failed to write row";
+  }
+
+  return absl::OkStatus();
+}
+
 }  // namespace zetasql
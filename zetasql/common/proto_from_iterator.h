@@ -24,6 +24,7 @@
 #include <string>
 
 #include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/message.h"
 #include "zetasql/public/convert_type_to_proto.h"
 #include "zetasql/public/evaluator_table_iterator.h"
@@ -96,6 +97,17 @@ absl::StatusOr<std::unique_ptr<google::protobuf::Message>> ProtoFromIterator(
     EvaluatorTableIterator& iter, const google::protobuf::Descriptor& table_desc,
     google::protobuf::MessageFactory& message_factory);
 
+// Write all rows from the given iterator to 'output' in the wire format of a
+// message of type 'table_desc', without creating that message. This is
+// equivalent to serializing the result of ProtoFromIterator(), but each row is
+// streamed to 'output' as soon as it is read. Rows are encoded into a reusable
+// buffer. Columns of scalar types are encoded directly; other columns go
+// through MergeValueToProtoField() with a reusable row message.
+absl::Status SerializeProtoFromIterator(
+    EvaluatorTableIterator& iter, const google::protobuf::Descriptor& table_desc,
+    google::protobuf::MessageFactory& message_factory,
+    google::protobuf::io::CodedOutputStream& output);
+
 }  // namespace zetasql
 
 #endif  // ZETASQL_COMMON_PROTO_FROM_ITERATOR_H_
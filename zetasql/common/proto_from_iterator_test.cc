@@ -23,6 +23,8 @@
 
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/dynamic_message.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/message.h"
 #include "google/protobuf/text_format.h"
 #include "zetasql/common/testing/proto_matchers.h"
@@ -35,6 +37,7 @@
 #include "zetasql/testdata/test_schema.pb.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "zetasql/base/status_macros.h"
@@ -227,4 +230,68 @@ TEST(ProtoFromIteratorTest, Basic) {
   EXPECT_THAT(got, testing::EqualsProto(want));
 }
 
+TEST(SerializeProtoFromIteratorTest, Basic) {
+  const std::vector<SimpleTable::NameAndType> columns{
+      {"key", types::Int32Type()},
+      {"name", types::StringType()},
+      {"tag", types::StringArrayType()},
+  };
+
+  SimpleTable table{"DataTable", columns};
+  table.SetContents({
+      {values::Int32(100), values::String("foo"),
+       values::StringArray({"aaa", "zzz"})},
+      {values::Int32(200), values::NullString(), values::StringArray({"bbb"})},
+      {values::Int32(0), values::String(""),
+       values::EmptyArray(types::StringArrayType())},
+  });
+
+  constexpr char want[] = R"pb(
+    row { key: 100 name: "foo" tag: "aaa" tag: "zzz" }
+    row { key: 200 tag: "bbb" }
+    row { key: 0 name: "" }
+  )pb";
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       table.CreateEvaluatorTableIterator({0, 1, 2}));
+
+  google::protobuf::DescriptorPool pool{google::protobuf::DescriptorPool::generated_pool()};
+
+  IteratorProtoDescriptorOptions options;
+  options.filename = "<generated>";
+  options.table_message_name = "Table";
+  options.table_row_field_name = "row";
+  options.convert_type_to_proto_options.message_name = "Row";
+  {
+    auto& cttpo = options.convert_type_to_proto_options;
+    cttpo.generate_nullable_array_wrappers = false;
+    cttpo.generate_nullable_element_wrappers = false;
+  }
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(const IteratorProtoDescriptors desc,
+                       ConvertIteratorToProto(*iter, options, pool));
+
+  google::protobuf::DynamicMessageFactory message_factory;
+  message_factory.SetDelegateToGeneratedFactory(true);
+
+  std::string bytes;
+  {
+    google::protobuf::io::StringOutputStream stream(&bytes);
+    google::protobuf::io::CodedOutputStream output(&stream);
+    ZETASQL_ASSERT_OK(SerializeProtoFromIterator(*iter, *desc.table, message_factory,
+                                         output));
+  }
+
+  std::unique_ptr<google::protobuf::Message> msg =
+      absl::WrapUnique(message_factory.GetPrototype(desc.table)->New());
+  ASSERT_TRUE(msg->ParseFromString(bytes));
+
+  std::string buf;
+  EXPECT_TRUE(google::protobuf::TextFormat::PrintToString(*msg, &buf));
+
+  IteratorProto got;
+  EXPECT_TRUE(google::protobuf::TextFormat::ParseFromString(buf, &got));
+  EXPECT_THAT(got, testing::EqualsProto(want));
+}
+
 }  // namespace zetasql
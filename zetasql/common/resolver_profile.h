@@ -0,0 +1,139 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_COMMON_RESOLVER_PROFILE_H_
+#define ZETASQL_COMMON_RESOLVER_PROFILE_H_
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+#include "zetasql/common/timer_util.h"
+#include "zetasql/public/proto/logging.pb.h"
+#include "absl/base/optimization.h"
+
+namespace zetasql::internal {
+
+// The counts and resource usage of the operations inside the resolver, see
+// AnalyzerLogEntry::ResolverOperation.
+//
+// Operations are recorded by ScopedResolverOperation into the profile of the
+// innermost ScopedResolverProfileCollector of their thread, so that code deep
+// inside the resolver, like NameScope, needs no access to the
+// AnalyzerRuntimeInfo. Without a collector, recording an operation is a single
+// thread-local load.
+class ResolverProfile {
+ public:
+  using Operation = AnalyzerLogEntry::ResolverOperation;
+
+  struct OperationDetails {
+    int64_t count = 0;
+    TimedValue timed_value;
+
+    void AccumulateAll(const OperationDetails& rhs) {
+      count += rhs.count;
+      timed_value.Accumulate(rhs.timed_value);
+    }
+  };
+
+  const OperationDetails& details(Operation operation) const {
+    return operations_[operation].details;
+  }
+  OperationDetails& details(Operation operation) {
+    return operations_[operation].details;
+  }
+
+  void AccumulateAll(const ResolverProfile& rhs) {
+    for (size_t i = 0; i < operations_.size(); ++i) {
+      operations_[i].details.AccumulateAll(rhs.operations_[i].details);
+    }
+  }
+
+ private:
+  friend class ScopedResolverProfileCollector;
+  friend class ScopedResolverOperation;
+
+  struct OperationState {
+    OperationDetails details;
+    // The number of running operations of this kind. Only the outermost one
+    // is timed, so that recursive operations are not counted twice.
+    int depth = 0;
+  };
+
+  // The profile of the innermost ScopedResolverProfileCollector of this
+  // thread.
+  static inline thread_local ResolverProfile* current_ = nullptr;
+
+  std::array<OperationState, AnalyzerLogEntry::ResolverOperation_ARRAYSIZE>
+      operations_;
+};
+
+// Records the operations of this thread into 'profile' while it is alive. If
+// 'profile' is NULL, operations are not recorded, even if an enclosing
+// collector exists.
+class ScopedResolverProfileCollector {
+ public:
+  explicit ScopedResolverProfileCollector(ResolverProfile* profile)
+      : previous_(ResolverProfile::current_) {
+    ResolverProfile::current_ = profile;
+  }
+  ScopedResolverProfileCollector(const ScopedResolverProfileCollector&) =
+      delete;
+  ScopedResolverProfileCollector& operator=(
+      const ScopedResolverProfileCollector&) = delete;
+  ~ScopedResolverProfileCollector() { ResolverProfile::current_ = previous_; }
+
+ private:
+  ResolverProfile* previous_;
+};
+
+// Counts and times one operation, from construction to destruction.
+class ScopedResolverOperation {
+ public:
+  explicit ScopedResolverOperation(ResolverProfile::Operation operation) {
+    if (ABSL_PREDICT_TRUE(ResolverProfile::current_ == nullptr)) return;
+    state_ = &ResolverProfile::current_->operations_[operation];
+    ++state_->details.count;
+    if (state_->depth++ == 0) {
+      timer_.emplace(&state_->details.timed_value);
+    }
+  }
+  ScopedResolverOperation(const ScopedResolverOperation&) = delete;
+  ScopedResolverOperation& operator=(const ScopedResolverOperation&) = delete;
+  ~ScopedResolverOperation() {
+    if (state_ != nullptr) {
+      timer_.reset();
+      --state_->depth;
+    }
+  }
+
+ private:
+  ResolverProfile::OperationState* state_ = nullptr;
+  std::optional<ScopedTimer> timer_;
+};
+
+// Returns 'fn()', recorded as one 'operation'. For timing a single call, such
+// as a catalog lookup, in the middle of a function.
+template <typename Fn>
+auto ProfileResolverOperation(ResolverProfile::Operation operation, Fn&& fn) {
+  ScopedResolverOperation scoped_operation(operation);
+  return std::forward<Fn>(fn)();
+}
+
+}  // namespace zetasql::internal
+
+#endif  // ZETASQL_COMMON_RESOLVER_PROFILE_H_
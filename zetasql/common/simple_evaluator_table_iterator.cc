@@ -16,16 +16,330 @@
 
 #include "zetasql/common/simple_evaluator_table_iterator.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/base/check.h"
 #include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/strings/match.h"
+#include "absl/types/span.h"
+#include "zetasql/base/ret_check.h"
 
 ABSL_FLAG(int64_t, zetasql_simple_iterator_call_time_now_rows_period, 1000,
           "Only call zetasql_base::Clock::TimeNow() every this many rows");
 
 namespace zetasql {
 
+namespace {
+
+// Returns true if Value::SqlLessThan() orders all values of 'type'.
+bool IsOrderedBySqlLessThan(const Type* type) {
+  switch (type->kind()) {
+    case TYPE_INT32:
+    case TYPE_INT64:
+    case TYPE_UINT32:
+    case TYPE_UINT64:
+    case TYPE_BOOL:
+    case TYPE_FLOAT:
+    case TYPE_DOUBLE:
+    case TYPE_STRING:
+    case TYPE_BYTES:
+    case TYPE_DATE:
+    case TYPE_TIMESTAMP:
+    case TYPE_DATETIME:
+    case TYPE_TIME:
+    case TYPE_NUMERIC:
+    case TYPE_BIGNUMERIC:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool IsNaN(const Value& value) {
+  switch (value.type_kind()) {
+    case TYPE_FLOAT:
+      return std::isnan(value.float_value());
+    case TYPE_DOUBLE:
+      return std::isnan(value.double_value());
+    default:
+      return false;
+  }
+}
+
+// Returns true if 'a' < 'b' is TRUE. Incomparable values are not less.
+bool IsLess(const Value& a, const Value& b) {
+  return a.SqlLessThan(b) == values::True();
+}
+
+const std::string& StringOrBytes(const Value& value) {
+  return value.type()->IsString() ? value.string_value()
+                                  : value.bytes_value();
+}
+
+}  // namespace
+
+std::shared_ptr<const ColumnBlockIndex> ColumnBlockIndex::Create(
+    absl::Span<const Value> values, int64_t rows_per_block) {
+  ABSL_CHECK_GT(rows_per_block, 0);
+  if (values.empty() || !IsOrderedBySqlLessThan(values.front().type())) {
+    return nullptr;
+  }
+  std::shared_ptr<ColumnBlockIndex> index(new ColumnBlockIndex(rows_per_block));
+  index->blocks_.resize((values.size() + rows_per_block - 1) / rows_per_block);
+  for (int64_t i = 0; i < values.size(); ++i) {
+    Block& block = index->blocks_[i / rows_per_block];
+    const Value& value = values[i];
+    if (value.is_null()) {
+      block.has_null = true;
+    } else if (!IsNaN(value)) {
+      if (!block.min.is_valid() || IsLess(value, block.min)) {
+        block.min = value;
+      }
+      if (!block.max.is_valid() || IsLess(block.max, value)) {
+        block.max = value;
+      }
+    }
+  }
+  return index;
+}
+
+bool ColumnBlockIndex::BlockMayMatch(int64_t block_idx,
+                                     const ColumnFilter& filter) const {
+  const Block& block = blocks_[block_idx];
+  switch (filter.kind()) {
+    case ColumnFilter::kIsNull:
+      return block.has_null;
+    case ColumnFilter::kRange: {
+      if (!block.min.is_valid()) return false;
+      const Value& lower_bound = filter.lower_bound();
+      const Value& upper_bound = filter.upper_bound();
+      return !(lower_bound.is_valid() && IsLess(block.max, lower_bound)) &&
+             !(upper_bound.is_valid() && IsLess(upper_bound, block.min));
+    }
+    case ColumnFilter::kInList:
+      if (!block.min.is_valid()) return false;
+      for (const Value& element : filter.in_list()) {
+        if (!IsLess(element, block.min) && !IsLess(block.max, element)) {
+          return true;
+        }
+      }
+      return false;
+    case ColumnFilter::kPrefix: {
+      if (!block.min.is_valid()) return false;
+      const Value& prefix = filter.prefix();
+      if (!prefix.type()->Equals(block.min.type()) ||
+          !prefix.type()->Equals(block.max.type())) {
+        return true;
+      }
+      // STRING and BYTES values are ordered by their bytes, and the values
+      // that start with 'prefix' are no less than it.
+      const std::string& prefix_bytes = StringOrBytes(prefix);
+      const std::string& min_bytes = StringOrBytes(block.min);
+      if (StringOrBytes(block.max) < prefix_bytes) return false;
+      return min_bytes <= prefix_bytes ||
+             absl::StartsWith(min_bytes, prefix_bytes);
+    }
+    default:
+      return true;
+  }
+}
+
+bool ColumnValueIndex::SupportsType(Kind kind, const Type* type) {
+  if (kind == kOrdered) {
+    return IsOrderedBySqlLessThan(type);
+  }
+  // Values of these types are equal if and only if they are equal in SQL.
+  switch (type->kind()) {
+    case TYPE_INT32:
+    case TYPE_INT64:
+    case TYPE_UINT32:
+    case TYPE_UINT64:
+    case TYPE_BOOL:
+    case TYPE_STRING:
+    case TYPE_BYTES:
+    case TYPE_DATE:
+    case TYPE_TIMESTAMP:
+    case TYPE_DATETIME:
+    case TYPE_TIME:
+    case TYPE_NUMERIC:
+    case TYPE_BIGNUMERIC:
+      return true;
+    default:
+      return false;
+  }
+}
+
+std::shared_ptr<const ColumnValueIndex> ColumnValueIndex::Create(
+    Kind kind, const Type* type,
+    std::shared_ptr<const std::vector<Value>> values) {
+  ABSL_CHECK(SupportsType(kind, type)) << type->DebugString();
+  std::shared_ptr<ColumnValueIndex> index(
+      new ColumnValueIndex(kind, type, std::move(values)));
+  const std::vector<Value>& column = *index->values_;
+  for (int64_t row = 0; row < column.size(); ++row) {
+    const Value& value = column[row];
+    if (value.is_null()) {
+      index->null_rows_.push_back(row);
+    } else if (kind == kHash) {
+      index->rows_by_value_[value].push_back(row);
+    } else if (!IsNaN(value)) {
+      index->sorted_rows_.push_back(row);
+    }
+  }
+  std::stable_sort(index->sorted_rows_.begin(), index->sorted_rows_.end(),
+                   [&column](int64_t a, int64_t b) {
+                     return IsLess(column[a], column[b]);
+                   });
+  return index;
+}
+
+void ColumnValueIndex::AppendEqualRows(const Value& value,
+                                       std::vector<int64_t>* rows) const {
+  if (value.is_null() || IsNaN(value)) return;
+  if (kind_ == kHash) {
+    auto it = rows_by_value_.find(value);
+    if (it != rows_by_value_.end()) {
+      rows->insert(rows->end(), it->second.begin(), it->second.end());
+    }
+    return;
+  }
+  AppendRowsInRange(value, value, rows);
+}
+
+void ColumnValueIndex::AppendRowsInRange(const Value& lower_bound,
+                                         const Value& upper_bound,
+                                         std::vector<int64_t>* rows) const {
+  // No value is in a range with a NULL or NaN bound.
+  for (const Value* bound : {&lower_bound, &upper_bound}) {
+    if (bound->is_valid() && (bound->is_null() || IsNaN(*bound))) return;
+  }
+  const std::vector<Value>& column = *values_;
+  auto begin = sorted_rows_.begin();
+  if (lower_bound.is_valid()) {
+    begin = std::lower_bound(sorted_rows_.begin(), sorted_rows_.end(),
+                             lower_bound,
+                             [&column](int64_t row, const Value& bound) {
+                               return IsLess(column[row], bound);
+                             });
+  }
+  auto end = sorted_rows_.end();
+  if (upper_bound.is_valid()) {
+    end = std::upper_bound(begin, sorted_rows_.end(), upper_bound,
+                           [&column](const Value& bound, int64_t row) {
+                             return IsLess(bound, column[row]);
+                           });
+  }
+  if (begin < end) {
+    rows->insert(rows->end(), begin, end);
+  }
+}
+
+std::optional<std::vector<int64_t>> ColumnValueIndex::LookupRows(
+    const ColumnFilter& filter) const {
+  std::vector<int64_t> rows;
+  switch (filter.kind()) {
+    case ColumnFilter::kIsNull:
+      return null_rows_;
+    case ColumnFilter::kInList:
+      for (const Value& element : filter.in_list()) {
+        if (!element.type()->Equals(type_)) return std::nullopt;
+        AppendEqualRows(element, &rows);
+      }
+      break;
+    case ColumnFilter::kRange: {
+      const Value& lower_bound = filter.lower_bound();
+      const Value& upper_bound = filter.upper_bound();
+      for (const Value* bound : {&lower_bound, &upper_bound}) {
+        if (bound->is_valid() && !bound->type()->Equals(type_)) {
+          return std::nullopt;
+        }
+      }
+      if (kind_ == kOrdered) {
+        AppendRowsInRange(lower_bound, upper_bound, &rows);
+      } else if (lower_bound.is_valid() && upper_bound.is_valid() &&
+                 lower_bound.SqlEquals(upper_bound) == values::True()) {
+        AppendEqualRows(lower_bound, &rows);
+      } else {
+        return std::nullopt;
+      }
+      break;
+    }
+    case ColumnFilter::kPrefix: {
+      const Value& prefix = filter.prefix();
+      if (kind_ != kOrdered || !prefix.type()->Equals(type_)) {
+        return std::nullopt;
+      }
+      if (prefix.is_null()) break;
+      // The values that start with 'prefix' are the first ones that are no
+      // less than it.
+      const std::vector<Value>& column = *values_;
+      const std::string& prefix_bytes = StringOrBytes(prefix);
+      for (auto it = std::lower_bound(
+               sorted_rows_.begin(), sorted_rows_.end(), prefix,
+               [&column](int64_t row, const Value& bound) {
+                 return IsLess(column[row], bound);
+               });
+           it != sorted_rows_.end() &&
+           absl::StartsWith(StringOrBytes(column[*it]), prefix_bytes);
+           ++it) {
+        rows.push_back(*it);
+      }
+      break;
+    }
+    default:
+      return std::nullopt;
+  }
+  std::sort(rows.begin(), rows.end());
+  rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+  return rows;
+}
+
+void SimpleEvaluatorTableIterator::SetColumnValueIndexes(
+    std::vector<std::shared_ptr<const ColumnValueIndex>> value_indexes) {
+  absl::MutexLock l(&mutex_);
+  ABSL_CHECK_EQ(value_indexes.size(), columns_.size());
+  value_indexes_ = std::move(value_indexes);
+}
+
+void SimpleEvaluatorTableIterator::SetColumnBlockIndexes(
+    std::vector<std::shared_ptr<const ColumnBlockIndex>> block_indexes) {
+  absl::MutexLock l(&mutex_);
+  ABSL_CHECK_EQ(block_indexes.size(), columns_.size());
+  block_indexes_.clear();
+  bool has_index = false;
+  for (const std::shared_ptr<const ColumnBlockIndex>& index : block_indexes) {
+    if (index == nullptr) continue;
+    if (!has_index) {
+      rows_per_block_ = index->rows_per_block();
+      has_index = true;
+    }
+    ABSL_CHECK_EQ(index->rows_per_block(), rows_per_block_);
+  }
+  if (has_index) {
+    block_indexes_ = std::move(block_indexes);
+  }
+}
+
+bool SimpleEvaluatorTableIterator::BlockMayMatchLocked(int64_t block) const {
+  for (const auto& [column_idx, filter] : filter_map_) {
+    const ColumnBlockIndex* index = block_indexes_[column_idx].get();
+    if (index != nullptr && !index->BlockMayMatch(block, *filter)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 absl::Status SimpleEvaluatorTableIterator::SetColumnFilterMap(
     absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map) {
   filter_map_.clear();
@@ -37,58 +351,135 @@ absl::Status SimpleEvaluatorTableIterator::SetColumnFilterMap(
   return absl::OkStatus();
 }
 
-bool SimpleEvaluatorTableIterator::NextRow() {
+absl::Status SimpleEvaluatorTableIterator::SetRowRange(int64_t begin,
+                                                       int64_t end) {
   absl::MutexLock l(&mutex_);
-  if (cancelled_) return false;
+  ZETASQL_RET_CHECK_EQ(row_idx_, -1)
+      << "SetRowRange() cannot be called after NextRow()";
+  ZETASQL_RET_CHECK_GE(begin, 0);
+  ZETASQL_RET_CHECK_LE(begin, end);
+  ZETASQL_RET_CHECK_LE(end, num_rows_);
+  row_idx_ = begin - 1;
+  end_row_idx_ = end;
+  return absl::OkStatus();
+}
 
-  for (++row_idx_; row_idx_ < num_rows_; ++row_idx_) {
-    if ((row_idx_ %
-             absl::GetFlag(
-                 FLAGS_zetasql_simple_iterator_call_time_now_rows_period) ==
-         0) &&
-        clock_->TimeNow() > deadline_) {
-      deadline_exceeded_ = true;
+bool SimpleEvaluatorTableIterator::MatchesColumnFilter(
+    const ColumnFilter& filter, const Value& value) {
+  switch (filter.kind()) {
+    case ColumnFilter::kRange: {
+      const Value& lower_bound = filter.lower_bound();
+      const Value& upper_bound = filter.upper_bound();
+      if (lower_bound.is_valid() &&
+          lower_bound.SqlLessThan(value) != values::True() &&
+          lower_bound.SqlEquals(value) != values::True()) {
+        return false;
+      }
+      return !upper_bound.is_valid() ||
+             (value.SqlLessThan(upper_bound) == values::True()) ||
+             (value.SqlEquals(upper_bound) == values::True());
+    }
+    case ColumnFilter::kInList:
+      for (const Value& element : filter.in_list()) {
+        if (value.SqlEquals(element) == values::True()) return true;
+      }
       return false;
+    case ColumnFilter::kIsNull:
+      return value.is_null();
+    case ColumnFilter::kPrefix: {
+      const Value& prefix = filter.prefix();
+      if (value.is_null() || !value.type()->Equals(prefix.type())) {
+        return false;
+      }
+      if (prefix.type()->IsString()) {
+        return absl::StartsWith(value.string_value(), prefix.string_value());
+      }
+      return absl::StartsWith(value.bytes_value(), prefix.bytes_value());
     }
+    default:
+      // Skip this unknown column filter.
+      return true;
+  }
+}
 
-    bool keep_row = true;
-    for (const auto& entry : filter_map_) {
-      if (!keep_row) break;
-
-      const int column_idx = entry.first;
-      const std::unique_ptr<ColumnFilter>& filter = entry.second;
-
-      const Value& value = (*column_major_values_[column_idx])[row_idx_];
-      switch (filter->kind()) {
-        case ColumnFilter::kRange: {
-          const Value& lower_bound = filter->lower_bound();
-          const Value& upper_bound = filter->upper_bound();
-          keep_row = !lower_bound.is_valid() ||
-                     (lower_bound.SqlLessThan(value) == values::True()) ||
-                     (lower_bound.SqlEquals(value) == values::True());
-          if (!keep_row) break;
-          keep_row = !upper_bound.is_valid() ||
-                     (value.SqlLessThan(upper_bound) == values::True()) ||
-                     (value.SqlEquals(upper_bound) == values::True());
-          break;
-        }
-        case ColumnFilter::kInList:
-          keep_row = false;
-          for (const Value& element : filter->in_list()) {
-            if (value.SqlEquals(element) == values::True()) {
-              keep_row = true;
-              break;
-            }
-          }
-          break;
-        default:
-          // Skip this unknown column filter.
-          keep_row = true;
-          break;
+bool SimpleEvaluatorTableIterator::MatchesFiltersLocked(
+    int64_t row_idx) const {
+  for (const auto& [column_idx, filter] : filter_map_) {
+    const Value& value = (*column_major_values_[column_idx])[row_idx];
+    if (!MatchesColumnFilter(*filter, value)) return false;
+  }
+  return true;
+}
+
+bool SimpleEvaluatorTableIterator::DeadlineExceededLocked(int64_t row_count) {
+  if ((row_count %
+           absl::GetFlag(
+               FLAGS_zetasql_simple_iterator_call_time_now_rows_period) ==
+       0) &&
+      clock_->TimeNow() > deadline_) {
+    deadline_exceeded_ = true;
+  }
+  return deadline_exceeded_;
+}
+
+void SimpleEvaluatorTableIterator::LookUpCandidateRowsLocked() {
+  if (value_indexes_.empty()) return;
+  for (const auto& [column_idx, filter] : filter_map_) {
+    const ColumnValueIndex* index = value_indexes_[column_idx].get();
+    if (index == nullptr) continue;
+    std::optional<std::vector<int64_t>> rows = index->LookupRows(*filter);
+    if (rows.has_value() && (!candidate_rows_.has_value() ||
+                             rows->size() < candidate_rows_->size())) {
+      candidate_rows_ = std::move(rows);
+    }
+  }
+}
+
+bool SimpleEvaluatorTableIterator::NextCandidateRowLocked() {
+  const std::vector<int64_t>& rows = *candidate_rows_;
+  for (; next_candidate_ < rows.size(); ++next_candidate_) {
+    if (DeadlineExceededLocked(next_candidate_)) return false;
+    const int64_t row = rows[next_candidate_];
+    // Skips the rows before the range of SetRowRange().
+    if (row <= row_idx_) continue;
+    if (row >= end_row_idx_) break;
+    row_idx_ = row;
+    if (MatchesFiltersLocked(row)) {
+      ++next_candidate_;
+      return true;
+    }
+  }
+  row_idx_ = end_row_idx_;
+  return false;
+}
+
+bool SimpleEvaluatorTableIterator::NextRow() {
+  absl::MutexLock l(&mutex_);
+  if (cancelled_) return false;
+
+  if (!candidate_rows_looked_up_) {
+    candidate_rows_looked_up_ = true;
+    LookUpCandidateRowsLocked();
+  }
+  if (candidate_rows_.has_value()) {
+    return NextCandidateRowLocked();
+  }
+
+  for (++row_idx_; row_idx_ < end_row_idx_; ++row_idx_) {
+    if (DeadlineExceededLocked(row_idx_)) return false;
+
+    if (!block_indexes_.empty() && !filter_map_.empty() &&
+        row_idx_ / rows_per_block_ != checked_block_) {
+      checked_block_ = row_idx_ / rows_per_block_;
+      if (!BlockMayMatchLocked(checked_block_)) {
+        // Skip to the last row of the block.
+        row_idx_ = std::min(end_row_idx_,
+                            (checked_block_ + 1) * rows_per_block_) - 1;
+        continue;
       }
     }
 
-    if (keep_row) return true;
+    if (MatchesFiltersLocked(row_idx_)) return true;
   }
 
   return false;
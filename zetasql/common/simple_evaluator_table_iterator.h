@@ -23,7 +23,9 @@
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "zetasql/base/logging.h"
@@ -32,6 +34,8 @@
 #include "zetasql/public/type.h"
 #include "zetasql/public/value.h"
 #include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "absl/types/span.h"
@@ -42,6 +46,101 @@
 
 namespace zetasql {
 
+// The smallest and largest non-NULL values of a column in each block of
+// consecutive rows, which lets SimpleEvaluatorTableIterator skip the blocks
+// that cannot match a ColumnFilter. This is most effective for columns that
+// are sorted or clustered by value, where a selective filter only reads a
+// few blocks.
+class ColumnBlockIndex {
+ public:
+  static constexpr int64_t kDefaultRowsPerBlock = 1024;
+
+  // Returns the index of 'values', or nullptr if their type is not ordered by
+  // Value::SqlLessThan() (e.g., ARRAY or PROTO).
+  static std::shared_ptr<const ColumnBlockIndex> Create(
+      absl::Span<const Value> values,
+      int64_t rows_per_block = kDefaultRowsPerBlock);
+
+  ColumnBlockIndex(const ColumnBlockIndex&) = delete;
+  ColumnBlockIndex& operator=(const ColumnBlockIndex&) = delete;
+
+  int64_t rows_per_block() const { return rows_per_block_; }
+
+  // Returns false if no row in block 'block' (the rows starting at
+  // 'block * rows_per_block()') matches 'filter'. Returns true if some row may
+  // match, or if 'filter' has a kind that this class does not know about.
+  bool BlockMayMatch(int64_t block, const ColumnFilter& filter) const;
+
+ private:
+  struct Block {
+    // Invalid if the block only has NULLs and NaNs.
+    Value min;
+    Value max;
+    bool has_null = false;
+  };
+
+  explicit ColumnBlockIndex(int64_t rows_per_block)
+      : rows_per_block_(rows_per_block) {}
+
+  const int64_t rows_per_block_;
+  std::vector<Block> blocks_;
+};
+
+// An index of the rows of a column by value, which lets
+// SimpleEvaluatorTableIterator only read the rows that may match a
+// ColumnFilter instead of scanning all of them.
+class ColumnValueIndex {
+ public:
+  enum Kind {
+    // Finds the rows with kInList and kIsNull filters, and kRange filters
+    // with equal bounds.
+    kHash,
+    // Also finds the rows with kRange and kPrefix filters.
+    kOrdered,
+  };
+
+  // Returns true if columns of 'type' can have an index of kind 'kind'.
+  static bool SupportsType(Kind kind, const Type* type);
+
+  // Returns the index of 'values', which have type 'type'. 'type' must be
+  // supported by 'kind' (see SupportsType()).
+  static std::shared_ptr<const ColumnValueIndex> Create(
+      Kind kind, const Type* type,
+      std::shared_ptr<const std::vector<Value>> values);
+
+  ColumnValueIndex(const ColumnValueIndex&) = delete;
+  ColumnValueIndex& operator=(const ColumnValueIndex&) = delete;
+
+  // Returns the rows that may match 'filter' in increasing order, or
+  // std::nullopt if this index cannot find them (e.g., for a kRange filter of
+  // a kHash index, or a filter on values of another type).
+  std::optional<std::vector<int64_t>> LookupRows(
+      const ColumnFilter& filter) const;
+
+ private:
+  ColumnValueIndex(Kind kind, const Type* type,
+                   std::shared_ptr<const std::vector<Value>> values)
+      : kind_(kind), type_(type), values_(std::move(values)) {}
+
+  // Appends the rows that equal 'value' to 'rows'.
+  void AppendEqualRows(const Value& value, std::vector<int64_t>* rows) const;
+
+  // Appends the rows in [lower_bound, upper_bound] to 'rows'. Either bound
+  // may be invalid, for no bound.
+  void AppendRowsInRange(const Value& lower_bound, const Value& upper_bound,
+                         std::vector<int64_t>* rows) const;
+
+  const Kind kind_;
+  const Type* const type_;
+  const std::shared_ptr<const std::vector<Value>> values_;
+  // The rows with NULL values.
+  std::vector<int64_t> null_rows_;
+  // For kHash, the rows of each non-NULL value.
+  absl::flat_hash_map<Value, std::vector<int64_t>> rows_by_value_;
+  // For kOrdered, the rows with non-NULL, non-NaN values, ordered by value.
+  std::vector<int64_t> sorted_rows_;
+};
+
 class SimpleEvaluatorTableIterator : public EvaluatorTableIterator {
  public:
   // 'columns' is a list of the columns in the scan.
@@ -70,6 +169,7 @@ class SimpleEvaluatorTableIterator : public EvaluatorTableIterator {
         set_deadline_cb_(set_deadline_cb),
         column_major_values_(column_major_values),
         num_rows_(num_rows),
+        end_row_idx_(num_rows),
         clock_(clock) {
     ABSL_CHECK_EQ(columns.size(), column_major_values_.size());
     for (const auto& values_for_column : column_major_values_) {
@@ -77,6 +177,26 @@ class SimpleEvaluatorTableIterator : public EvaluatorTableIterator {
     }
   }
 
+  // Returns true if 'value' matches 'filter', or if 'filter' has a kind that
+  // this class does not know about.
+  static bool MatchesColumnFilter(const ColumnFilter& filter,
+                                  const Value& value);
+
+  // Sets the indexes of the columns of the scan for skipping rows that do not
+  // match the filters passed to SetColumnFilterMap(). 'block_indexes[i]' is
+  // the index of 'columns[i]', or nullptr. All indexes must have the same
+  // rows_per_block(). Must be called before the first call to NextRow().
+  void SetColumnBlockIndexes(
+      std::vector<std::shared_ptr<const ColumnBlockIndex>> block_indexes);
+
+  // Sets the indexes of the columns of the scan for finding the rows that
+  // match the filters passed to SetColumnFilterMap(). 'value_indexes[i]' is
+  // an index of 'columns[i]', or nullptr. If several filters can use an
+  // index, the iterator only reads the rows found by the one that finds the
+  // fewest. Must be called before the first call to NextRow().
+  void SetColumnValueIndexes(
+      std::vector<std::shared_ptr<const ColumnValueIndex>> value_indexes);
+
   SimpleEvaluatorTableIterator(const SimpleEvaluatorTableIterator&) = delete;
   SimpleEvaluatorTableIterator& operator=(const SimpleEvaluatorTableIterator&) =
       delete;
@@ -95,6 +215,13 @@ class SimpleEvaluatorTableIterator : public EvaluatorTableIterator {
       absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map)
       override;
 
+  std::optional<int64_t> GetNumRowsForSplitting() const override {
+    absl::ReaderMutexLock l(&mutex_);
+    return num_rows_;
+  }
+
+  absl::Status SetRowRange(int64_t begin, int64_t end) override;
+
   bool NextRow() override;
 
   const Value& GetValue(int i) const override {
@@ -112,7 +239,13 @@ class SimpleEvaluatorTableIterator : public EvaluatorTableIterator {
       return zetasql_base::DeadlineExceededErrorBuilder()
              << "EvaluatorTestTableIterator deadline exceeded";
     }
-    if (DoneLocked()) return end_status_;
+    if (DoneLocked()) {
+      // With SetRowRange(), only the range that reaches the end of the table
+      // reports 'end_status_'.
+      if (column_major_values_.empty() || row_idx_ >= num_rows_) {
+        return end_status_;
+      }
+    }
     return absl::OkStatus();
   }
 
@@ -130,9 +263,29 @@ class SimpleEvaluatorTableIterator : public EvaluatorTableIterator {
   }
 
  private:
+  // Returns true if row 'row_idx' matches 'filter_map_'.
+  bool MatchesFiltersLocked(int64_t row_idx) const
+      ABSL_SHARED_LOCKS_REQUIRED(mutex_);
+
+  // Returns true if the deadline has passed, checking every so many rows.
+  bool DeadlineExceededLocked(int64_t row_count)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Sets 'candidate_rows_' to the fewest rows that 'value_indexes_' find for
+  // 'filter_map_', if any.
+  void LookUpCandidateRowsLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // NextRow() for the rows in 'candidate_rows_'.
+  bool NextCandidateRowLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Returns false if 'block_indexes_' show that no row in block 'block'
+  // matches 'filter_map_'.
+  bool BlockMayMatchLocked(int64_t block) const
+      ABSL_SHARED_LOCKS_REQUIRED(mutex_);
+
   bool DoneLocked() const ABSL_SHARED_LOCKS_REQUIRED(mutex_) {
     if (column_major_values_.empty()) return true;
-    return row_idx_ >= num_rows_;
+    return row_idx_ >= end_row_idx_;
   }
 
   const std::vector<const Column*> columns_;
@@ -146,6 +299,8 @@ class SimpleEvaluatorTableIterator : public EvaluatorTableIterator {
   std::vector<std::shared_ptr<const std::vector<Value>>> column_major_values_
       ABSL_GUARDED_BY(mutex_);
   int64_t num_rows_ ABSL_GUARDED_BY(mutex_);
+  // One past the last row to return (see SetRowRange()).
+  int64_t end_row_idx_ ABSL_GUARDED_BY(mutex_);
 
   int64_t row_idx_ ABSL_GUARDED_BY(mutex_) = -1;
   bool cancelled_ ABSL_GUARDED_BY(mutex_) = false;
@@ -156,6 +311,24 @@ class SimpleEvaluatorTableIterator : public EvaluatorTableIterator {
   // Contains the entries passed to 'filter_map' that are in
   // 'filter_column_idxs_'.
   absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map_;
+
+  // Empty, or one entry (possibly nullptr) for each column.
+  std::vector<std::shared_ptr<const ColumnBlockIndex>> block_indexes_
+      ABSL_GUARDED_BY(mutex_);
+  int64_t rows_per_block_ ABSL_GUARDED_BY(mutex_) =
+      ColumnBlockIndex::kDefaultRowsPerBlock;
+  // The last block of rows that was checked against 'block_indexes_'.
+  int64_t checked_block_ ABSL_GUARDED_BY(mutex_) = -1;
+
+  // Empty, or one entry (possibly nullptr) for each column.
+  std::vector<std::shared_ptr<const ColumnValueIndex>> value_indexes_
+      ABSL_GUARDED_BY(mutex_);
+  // The rows found with 'value_indexes_' on the first call to NextRow(), if
+  // any filter could use them.
+  std::optional<std::vector<int64_t>> candidate_rows_ ABSL_GUARDED_BY(mutex_);
+  bool candidate_rows_looked_up_ ABSL_GUARDED_BY(mutex_) = false;
+  // The position of the next row in 'candidate_rows_'.
+  int64_t next_candidate_ ABSL_GUARDED_BY(mutex_) = 0;
 };
 
 }  // namespace zetasql
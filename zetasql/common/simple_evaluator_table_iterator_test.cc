@@ -37,12 +37,18 @@ namespace zetasql {
 namespace {
 
 using testing::ElementsAre;
+using testing::HasSubstr;
 using testing::IsEmpty;
+using testing::Optional;
 using zetasql_base::testing::IsOkAndHolds;
+using zetasql_base::testing::StatusIs;
 
 using types::Int64Type;
+using types::StringType;
 
 using values::Int64;
+using values::NullString;
+using values::String;
 
 // Fixture for tests of SimpleEvaluatorTableIterator::SetColumnFilters().
 class ColumnFilterTest : public ::testing::Test {
@@ -177,6 +183,167 @@ TEST_F(ColumnFilterTest, OneInFilter) {
                                ElementsAre(Int64(4), Int64(40), Int64(400)))));
 }
 
+TEST_F(ColumnFilterTest, OneIsNullFilter) {
+  absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map;
+  filter_map.emplace(1, std::make_unique<ColumnFilter>(ColumnFilter::IsNull()));
+
+  EXPECT_THAT(Read(std::move(filter_map)), IsOkAndHolds(IsEmpty()));
+}
+
+TEST(SimpleEvaluatorTableIteratorTest, PrefixFilter) {
+  SimpleColumn column("TestTable", "column", StringType());
+  SimpleEvaluatorTableIterator iter(
+      {&column},
+      {std::make_shared<const std::vector<Value>>(std::vector<Value>{
+          String("abc"), NullString(), String("ab"),
+          String("abd"), String("bcd")})},
+      /*num_rows=*/5, /*end_status=*/absl::OkStatus(),
+      /*filter_column_idxs=*/{0}, /*cancel_cb=*/[]() {},
+      /*set_deadline_cb=*/[](absl::Time) {}, zetasql_base::Clock::RealClock());
+
+  absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map;
+  filter_map.emplace(0, std::make_unique<ColumnFilter>(
+                            ColumnFilter::Prefix(String("ab"))));
+  ZETASQL_ASSERT_OK(iter.SetColumnFilterMap(std::move(filter_map)));
+
+  std::vector<Value> values;
+  while (iter.NextRow()) {
+    values.push_back(iter.GetValue(0));
+  }
+  ZETASQL_ASSERT_OK(iter.Status());
+  EXPECT_THAT(values,
+              ElementsAre(String("abc"), String("ab"), String("abd")));
+}
+
+TEST(ColumnBlockIndexTest, BlockMayMatch) {
+  // Blocks of two rows: ["a", NULL], ["ab", "b"], [NULL].
+  const std::vector<Value> values = {String("a"), NullString(), String("ab"),
+                                     String("b"), NullString()};
+  std::shared_ptr<const ColumnBlockIndex> index =
+      ColumnBlockIndex::Create(values, /*rows_per_block=*/2);
+  ASSERT_NE(index, nullptr);
+
+  const ColumnFilter is_null = ColumnFilter::IsNull();
+  EXPECT_TRUE(index->BlockMayMatch(0, is_null));
+  EXPECT_FALSE(index->BlockMayMatch(1, is_null));
+  EXPECT_TRUE(index->BlockMayMatch(2, is_null));
+
+  const ColumnFilter range(String("aa"), String("az"));
+  EXPECT_FALSE(index->BlockMayMatch(0, range));
+  EXPECT_TRUE(index->BlockMayMatch(1, range));
+  EXPECT_FALSE(index->BlockMayMatch(2, range));
+
+  const ColumnFilter in_list(std::vector<Value>{String("0"), String("a")});
+  EXPECT_TRUE(index->BlockMayMatch(0, in_list));
+  EXPECT_FALSE(index->BlockMayMatch(1, in_list));
+
+  const ColumnFilter prefix = ColumnFilter::Prefix(String("b"));
+  EXPECT_FALSE(index->BlockMayMatch(0, prefix));
+  EXPECT_TRUE(index->BlockMayMatch(1, prefix));
+
+  EXPECT_EQ(ColumnBlockIndex::Create(
+                {Value::EmptyArray(types::Int64ArrayType())}),
+            nullptr);
+}
+
+TEST(SimpleEvaluatorTableIteratorTest, SkipsBlocksWithBlockIndex) {
+  SimpleColumn column("TestTable", "column", Int64Type());
+  auto values = std::make_shared<std::vector<Value>>();
+  for (int i = 0; i < 10; ++i) {
+    values->push_back(Int64(i));
+  }
+  SimpleEvaluatorTableIterator iter(
+      {&column}, {values}, /*num_rows=*/10, /*end_status=*/absl::OkStatus(),
+      /*filter_column_idxs=*/{0}, /*cancel_cb=*/[]() {},
+      /*set_deadline_cb=*/[](absl::Time) {}, zetasql_base::Clock::RealClock());
+  iter.SetColumnBlockIndexes(
+      {ColumnBlockIndex::Create(*values, /*rows_per_block=*/3)});
+  ZETASQL_ASSERT_OK(iter.SetRowRange(1, 9));
+
+  absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map;
+  filter_map.emplace(0, std::make_unique<ColumnFilter>(
+                            std::vector<Value>{Int64(2), Int64(7)}));
+  ZETASQL_ASSERT_OK(iter.SetColumnFilterMap(std::move(filter_map)));
+
+  std::vector<Value> result;
+  while (iter.NextRow()) {
+    result.push_back(iter.GetValue(0));
+  }
+  ZETASQL_ASSERT_OK(iter.Status());
+  EXPECT_THAT(result, ElementsAre(Int64(2), Int64(7)));
+}
+
+TEST(ColumnValueIndexTest, LookupRows) {
+  auto values = std::make_shared<const std::vector<Value>>(std::vector<Value>{
+      String("b"), NullString(), String("ab"), String("a"), String("b")});
+  std::shared_ptr<const ColumnValueIndex> hash_index =
+      ColumnValueIndex::Create(ColumnValueIndex::kHash, StringType(), values);
+  std::shared_ptr<const ColumnValueIndex> ordered_index =
+      ColumnValueIndex::Create(ColumnValueIndex::kOrdered, StringType(),
+                               values);
+
+  const ColumnFilter in_list(std::vector<Value>{String("b"), String("a"),
+                                                String("c"), NullString()});
+  EXPECT_THAT(hash_index->LookupRows(in_list), Optional(ElementsAre(0, 3, 4)));
+  EXPECT_THAT(ordered_index->LookupRows(in_list),
+              Optional(ElementsAre(0, 3, 4)));
+
+  const ColumnFilter is_null = ColumnFilter::IsNull();
+  EXPECT_THAT(hash_index->LookupRows(is_null), Optional(ElementsAre(1)));
+  EXPECT_THAT(ordered_index->LookupRows(is_null), Optional(ElementsAre(1)));
+
+  const ColumnFilter point(String("ab"), String("ab"));
+  EXPECT_THAT(hash_index->LookupRows(point), Optional(ElementsAre(2)));
+  const ColumnFilter range(String("aa"), Value());
+  EXPECT_EQ(hash_index->LookupRows(range), std::nullopt);
+  EXPECT_THAT(ordered_index->LookupRows(range),
+              Optional(ElementsAre(0, 2, 4)));
+
+  const ColumnFilter prefix = ColumnFilter::Prefix(String("a"));
+  EXPECT_EQ(hash_index->LookupRows(prefix), std::nullopt);
+  EXPECT_THAT(ordered_index->LookupRows(prefix), Optional(ElementsAre(2, 3)));
+
+  // Values of other types are not looked up.
+  EXPECT_EQ(ordered_index->LookupRows(
+                ColumnFilter(std::vector<Value>{Int64(1)})),
+            std::nullopt);
+  EXPECT_FALSE(ColumnValueIndex::SupportsType(ColumnValueIndex::kHash,
+                                              types::DoubleType()));
+  EXPECT_TRUE(ColumnValueIndex::SupportsType(ColumnValueIndex::kOrdered,
+                                             types::DoubleType()));
+}
+
+TEST(SimpleEvaluatorTableIteratorTest, ReadsRowsFoundWithValueIndex) {
+  SimpleColumn key("TestTable", "key", Int64Type());
+  SimpleColumn value("TestTable", "value", StringType());
+  auto keys = std::make_shared<const std::vector<Value>>(std::vector<Value>{
+      Int64(3), Int64(1), Int64(2), Int64(1), Int64(3)});
+  auto values = std::make_shared<const std::vector<Value>>(std::vector<Value>{
+      String("a"), String("b"), String("c"), String("d"), String("e")});
+  SimpleEvaluatorTableIterator iter(
+      {&key, &value}, {keys, values}, /*num_rows=*/5,
+      /*end_status=*/absl::OkStatus(), /*filter_column_idxs=*/{0, 1},
+      /*cancel_cb=*/[]() {}, /*set_deadline_cb=*/[](absl::Time) {},
+      zetasql_base::Clock::RealClock());
+  iter.SetColumnValueIndexes(
+      {ColumnValueIndex::Create(ColumnValueIndex::kHash, Int64Type(), keys),
+       nullptr});
+  ZETASQL_ASSERT_OK(iter.SetRowRange(1, 5));
+
+  absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map;
+  filter_map.emplace(0, std::make_unique<ColumnFilter>(
+                            std::vector<Value>{Int64(1), Int64(3)}));
+  filter_map.emplace(1, std::make_unique<ColumnFilter>(String("c"), Value()));
+  ZETASQL_ASSERT_OK(iter.SetColumnFilterMap(std::move(filter_map)));
+
+  std::vector<Value> result;
+  while (iter.NextRow()) {
+    result.push_back(iter.GetValue(1));
+  }
+  ZETASQL_ASSERT_OK(iter.Status());
+  EXPECT_THAT(result, ElementsAre(String("d"), String("e")));
+}
+
 TEST_F(ColumnFilterTest, OverlappingDeletionsInThreeColumns) {
   absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map;
   filter_map.emplace(0, std::make_unique<ColumnFilter>(Int64(3), Value()));
@@ -203,5 +370,41 @@ TEST_F(ColumnFilterTest, DeletionsInThreeColumnsOnlyRespectTwo) {
                                ElementsAre(Int64(4), Int64(40), Int64(400)))));
 }
 
+TEST_F(ColumnFilterTest, RowRange) {
+  EXPECT_THAT(iter_->GetNumRowsForSplitting(), Optional(4));
+  ZETASQL_ASSERT_OK(iter_->SetRowRange(1, 3));
+  EXPECT_THAT(
+      Read(/*filter_map=*/{}),
+      IsOkAndHolds(ElementsAre(ElementsAre(Int64(2), Int64(20), Int64(200)),
+                               ElementsAre(Int64(3), Int64(30), Int64(300)))));
+}
+
+TEST_F(ColumnFilterTest, RowRangeWithFilter) {
+  absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map;
+  filter_map.emplace(1, std::make_unique<ColumnFilter>(Int64(30), Value()));
+
+  ZETASQL_ASSERT_OK(iter_->SetRowRange(1, 3));
+  EXPECT_THAT(
+      Read(std::move(filter_map)),
+      IsOkAndHolds(ElementsAre(ElementsAre(Int64(3), Int64(30), Int64(300)))));
+}
+
+TEST_F(ColumnFilterTest, EmptyRowRange) {
+  ZETASQL_ASSERT_OK(iter_->SetRowRange(4, 4));
+  EXPECT_THAT(Read(/*filter_map=*/{}), IsOkAndHolds(IsEmpty()));
+}
+
+TEST_F(ColumnFilterTest, BadRowRange) {
+  EXPECT_THAT(iter_->SetRowRange(-1, 2),
+              StatusIs(absl::StatusCode::kInternal));
+  EXPECT_THAT(iter_->SetRowRange(3, 2), StatusIs(absl::StatusCode::kInternal));
+  EXPECT_THAT(iter_->SetRowRange(0, 5), StatusIs(absl::StatusCode::kInternal));
+
+  ASSERT_TRUE(iter_->NextRow());
+  EXPECT_THAT(iter_->SetRowRange(0, 1),
+              StatusIs(absl::StatusCode::kInternal,
+                       HasSubstr("cannot be called after NextRow()")));
+}
+
 }  // namespace
 }  // namespace zetasql
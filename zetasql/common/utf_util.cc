@@ -16,6 +16,8 @@
 
 #include "zetasql/common/utf_util.h"
 
+#include <string.h>
+
 #include <algorithm>
 #include <cstdint>
 #include <limits>
@@ -34,8 +36,23 @@ namespace zetasql {
 
 constexpr absl::string_view kReplacementCharacter = "\uFFFD";
 
+absl::string_view::size_type SpanAscii(absl::string_view s) {
+  constexpr uint64_t kHighBits = 0x8080808080808080ULL;
+  absl::string_view::size_type i = 0;
+  for (; i + sizeof(uint64_t) <= s.size(); i += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, s.data() + i, sizeof(word));
+    if ((word & kHighBits) != 0) break;
+  }
+  while (i < s.size() && static_cast<uint8_t>(s[i]) < 0x80) ++i;
+  return i;
+}
+
 static int SpanWellFormedUTF8(const char* s, int length) {
   for (int i = 0; i < length;) {
+    // Skip runs of ASCII characters, which are always well formed.
+    i += static_cast<int>(SpanAscii(absl::string_view(s + i, length - i)));
+    if (i == length) break;
     int start = i;
     UChar32 c;
     U8_NEXT(s, i, length, c);
@@ -116,6 +133,13 @@ std::optional<int32_t> ForwardN(absl::string_view str, int32_t str_length32,
                                 int64_t num_code_points) {
   int32_t str_offset = 0;
   for (int64_t i = 0; i < num_code_points && str_offset < str_length32; ++i) {
+    // Skip as many of the remaining code points as possible that are ASCII.
+    const int32_t ascii = static_cast<int32_t>(SpanAscii(str.substr(
+        str_offset, std::min<int64_t>(num_code_points - i,
+                                      str_length32 - str_offset))));
+    str_offset += ascii;
+    i += ascii;
+    if (i == num_code_points || str_offset == str_length32) break;
     UChar32 character;
     U8_NEXT(str, str_offset, str_length32, character);
     if (character < 0) {
@@ -129,8 +153,9 @@ absl::StatusOr<int32_t> LengthUtf8(absl::string_view str) {
   ZETASQL_RET_CHECK_LE(str.size(), std::numeric_limits<int32_t>::max());
   int32_t str_length32 = static_cast<int32_t>(str.size());
 
-  int utf8_length = 0;
-  int32_t offset = 0;
+  // Every byte of the ASCII prefix is a code point.
+  int32_t offset = static_cast<int32_t>(SpanAscii(str));
+  int utf8_length = offset;
   while (offset < str_length32) {
     UChar32 character;
     U8_NEXT(str.data(), offset, str_length32, character);
@@ -37,6 +37,14 @@ absl::string_view::size_type SpanWellFormedUTF8(absl::string_view s);
 
 bool IsWellFormedUTF8(absl::string_view s);
 
+// Returns the length of the prefix of `s` that only consists of ASCII
+// characters, i.e., bytes below 0x80. This checks 8 bytes at a time, so it is
+// much faster than decoding `s` one code point at a time, and lets the
+// UTF-8 functions handle the common case of ASCII input like bytes.
+absl::string_view::size_type SpanAscii(absl::string_view s);
+
+inline bool IsAscii(absl::string_view s) { return SpanAscii(s) == s.size(); }
+
 // Returns a well-formed Unicode string. Replaces any ill-formed
 // subsequences with the Unicode REPLACEMENT CHARACTER (U+FFFD).
 // This is usually rendered as a diamond with a question mark in the middle.
@@ -77,6 +77,20 @@ TEST(UtfUtilTest, WellFormedUTF8) {
   TestIllFormedString("ABC\xf0\x90", 3);
 }
 
+TEST(UtfUtilTest, SpanAscii) {
+  EXPECT_EQ(SpanAscii(""), 0);
+  EXPECT_EQ(SpanAscii("abc"), 3);
+  EXPECT_EQ(SpanAscii("abcdefghijklmnopq"), 17);
+  EXPECT_EQ(SpanAscii("abcdefghijklmno\xc2\xbf"), 15);
+  EXPECT_EQ(SpanAscii("abc\xc2\xbfdefghijklmnopq"), 3);
+  EXPECT_EQ(SpanAscii("\xA4"), 0);
+  EXPECT_TRUE(IsAscii("abcdefghijklmnopq\x7f"));
+  EXPECT_FALSE(IsAscii("abcdefghijklmnopq\x80"));
+
+  TestWellFormedString("abcdefghijklmnop\xc2\xbfqrstuvwxyz");
+  TestIllFormedString("abcdefghijklmnop\xc2qrstuvwxyz", 16);
+}
+
 void TestCoerce(std::string str, std::string expected) {
   if (str == expected) {
     // Sanity check.
@@ -2718,6 +2718,24 @@ std::vector<FunctionTestCall> GetFunctionTestsTimestampTruncInternal() {
       TimestampTruncTest("1970-01-01 00:00:00", MICROSECOND,
                          "1970-01-01 00:00:00"),
 
+      // Truncations before the epoch round down, also in UTC where they are
+      // computed by integer division.
+      TimestampTruncTest("1969-12-31 23:59:59.999999", MINUTE,
+                         "1969-12-31 23:59:00"),
+      TimestampTruncTest("1969-12-31 23:59:59.999999", HOUR,
+                         "1969-12-31 23:00:00"),
+      TimestampTruncTest("1969-12-31 23:59:59.999999", DAY,
+                         "1969-12-31 00:00:00"),
+      TimestampTruncTest("1969-12-31 23:59:59.999999", MONTH,
+                         "1969-12-01 00:00:00"),
+      TimestampTruncTest("1969-12-31 23:59:59.999999", QUARTER,
+                         "1969-10-01 00:00:00"),
+      TimestampTruncTest("1600-02-29 12:34:56", MONTH, "1600-02-01 00:00:00"),
+      TimestampTruncTest("1600-02-29 12:34:56", YEAR, "1600-01-01 00:00:00"),
+      TimestampTruncTest("2000-02-29 12:34:56", WEEK, "2000-02-27 00:00:00"),
+      TimestampTruncTest("2100-03-01 00:00:00.000001", DAY,
+                         "2100-03-01 00:00:00"),
+
       TimestampTruncTest("1970-01-01 00:00:00.000001", SECOND,
                          "1970-01-01 00:00:00.000000"),
       TimestampTruncTest("1970-01-01 00:00:00.000001", MILLISECOND,
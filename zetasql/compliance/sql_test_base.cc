@@ -21,6 +21,7 @@
 #include <algorithm>
 #include <array>
 #include <cstdint>
+#include <functional>
 #include <iosfwd>
 #include <iostream>
 #include <map>
@@ -66,6 +67,7 @@
 #include "gtest/gtest.h"
 #include "absl/container/btree_map.h"
 #include "absl/container/btree_set.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/container/node_hash_set.h"
 #include "absl/flags/flag.h"
@@ -82,6 +84,8 @@
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/strip.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "file_based_test_driver/file_based_test_driver.h"
 #include "zetasql/base/file_util.h"  
@@ -142,6 +146,9 @@ ABSL_FLAG(bool, zetasql_compliance_extract_labels_using_all_rewrites, false,
 ABSL_FLAG(bool, zetasql_compliance_print_array_orderedness, false,
           "When true, includes the 'known order:', 'unknown order:' prefix "
           "on array values with two or more elements.");
+ABSL_FLAG(int32_t, zetasql_compliance_report_slowest_statements, 20,
+          "The number of statements with the longest execution times to list "
+          "in the compliance report. Zero disables the list.");
 
 namespace zetasql {
 
@@ -165,6 +172,58 @@ class AutoLanguageOptions {
   LanguageOptions original_options_;
 };
 
+// Known error files are loaded by every SQLTestBase, i.e., once per test, so
+// the parsed files and compiled regexes are cached for the whole process.
+absl::StatusOr<std::shared_ptr<const KnownErrorFile>> ReadKnownErrorFile(
+    absl::string_view filename) {
+  static absl::Mutex mutex(absl::kConstInit);
+  static auto* files ABSL_GUARDED_BY(mutex) =
+      new absl::flat_hash_map<std::string,
+                              std::shared_ptr<const KnownErrorFile>>();
+  {
+    absl::MutexLock lock(&mutex);
+    auto it = files->find(filename);
+    if (it != files->end()) return it->second;
+  }
+
+  std::string text;
+  absl::Status status = internal::GetContents(filename, &text);
+  if (!status.ok()) {
+    if (status.code() == absl::StatusCode::kNotFound) {
+      return ::zetasql_base::InvalidArgumentErrorBuilder()
+             << "ERROR: Known Error file " << filename << " does not exist";
+    } else {
+      return ::zetasql_base::InvalidArgumentErrorBuilder()
+             << "ERROR: Unable to get known error contents from " << filename
+             << ": " << internal::StatusToString(status);
+    }
+  }
+
+  auto known_error_file = std::make_shared<KnownErrorFile>();
+  if (!google::protobuf::TextFormat::ParseFromString(text,
+                                                     known_error_file.get())) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder()
+           << "ERROR: Failed to parse known error file " << filename;
+  }
+
+  absl::MutexLock lock(&mutex);
+  return files->try_emplace(std::string(filename), std::move(known_error_file))
+      .first->second;
+}
+
+// Returns the compiled known error regex for `pattern`, which may not be ok().
+std::shared_ptr<const RE2> GetKnownErrorRegex(const std::string& pattern) {
+  static absl::Mutex mutex(absl::kConstInit);
+  static auto* regexes ABSL_GUARDED_BY(mutex) =
+      new absl::flat_hash_map<std::string, std::shared_ptr<const RE2>>();
+  absl::MutexLock lock(&mutex);
+  std::shared_ptr<const RE2>& regex = (*regexes)[pattern];
+  if (regex == nullptr) {
+    regex = std::make_shared<const RE2>(pattern);
+  }
+  return regex;
+}
+
 }  // anonymous namespace
 
 // Constants for code-based statement names.
@@ -297,8 +356,9 @@ class Stats {
                                  KnownErrorMode mode,
                                  const absl::btree_set<std::string>& by_set);
 
-  // Record the runtime duration of a executed statement.
-  void RecordStatementExecutionTime(absl::Duration elapsed);
+  // Record the runtime duration of a executed statement, named `name`.
+  void RecordStatementExecutionTime(absl::string_view name,
+                                    absl::Duration elapsed);
 
   // Record a failure that is not resolved by adding a known error entry.
   void RecordFailure(absl::string_view error_string) {
@@ -418,6 +478,13 @@ class Stats {
 
   int num_known_errors_ = 0;
 
+  // The total execution time of all statements.
+  absl::Duration total_execution_time_;
+  // The slowest statements seen so far, at most
+  // --zetasql_compliance_report_slowest_statements of them, as a min-heap by
+  // execution time.
+  std::vector<std::pair<absl::Duration, std::string>> slowest_statements_;
+
   bool file_based_statements_ = false;
 };
 
@@ -492,7 +559,22 @@ void Stats::RecordKnownErrorStatement(
   RecordProperty(location, by);
 }
 
-void Stats::RecordStatementExecutionTime(absl::Duration elapsed) {
+void Stats::RecordStatementExecutionTime(absl::string_view name,
+                                         absl::Duration elapsed) {
+  total_execution_time_ += elapsed;
+  const int max_statements =
+      absl::GetFlag(FLAGS_zetasql_compliance_report_slowest_statements);
+  if (max_statements <= 0) return;
+  using Entry = std::pair<absl::Duration, std::string>;
+  if (static_cast<int>(slowest_statements_.size()) >= max_statements) {
+    if (elapsed <= slowest_statements_.front().first) return;
+    std::pop_heap(slowest_statements_.begin(), slowest_statements_.end(),
+                  std::greater<Entry>());
+    slowest_statements_.pop_back();
+  }
+  slowest_statements_.emplace_back(elapsed, std::string(name));
+  std::push_heap(slowest_statements_.begin(), slowest_statements_.end(),
+                 std::greater<Entry>());
 }
 
 void Stats::LogGoogletestProperties() const {
@@ -565,6 +647,20 @@ void Stats::LogReport() const {
              "To Be Removed From Known Errors Statements", "\n");
   LogBatches(to_be_upgraded_, "To Be Upgraded Statements", "\n");
 
+  if (!slowest_statements_.empty()) {
+    std::vector<std::pair<absl::Duration, std::string>> slowest =
+        slowest_statements_;
+    std::sort(slowest.begin(), slowest.end(), std::greater<>());
+    std::vector<std::string> lines;
+    lines.reserve(slowest.size() + 1);
+    lines.push_back(absl::StrCat("Total execution time: ",
+                                 absl::FormatDuration(total_execution_time_)));
+    for (const auto& [elapsed, name] : slowest) {
+      lines.push_back(absl::StrCat(absl::FormatDuration(elapsed), "  ", name));
+    }
+    LogBatches(lines, "Slowest Statements", "\n");
+  }
+
   ABSL_LOG(INFO) << "\n==== RELATED KNOWN ERROR FILES ====\n"
             << absl::StrJoin(known_error_files, "\n")
             << "\n==== END RELATED KNOWN ERROR FILES ====\n";
@@ -1615,7 +1711,8 @@ SQLTestBase::TestResults SQLTestBase::ExecuteTestCase() {
                                           execute_statement_type_factory());
     }
   }
-  stats_->RecordStatementExecutionTime(absl::Now() - start_time);
+  stats_->RecordStatementExecutionTime(
+      full_name_.empty() ? location_ : full_name_, absl::Now() - start_time);
   return TestResults{result, is_deterministic_output};
 }
 
@@ -2226,7 +2323,7 @@ absl::Status SQLTestBase::AddKnownErrorEntry(
     if (SafeString(label) == label) {
       known_error_labels_.insert(label);
     } else if (zetasql_base::InsertIfNotPresent(&known_error_regex_strings_, label)) {
-      std::unique_ptr<RE2> regex(new RE2(label));
+      std::shared_ptr<const RE2> regex = GetKnownErrorRegex(label);
       if (regex->ok()) {
         known_error_regexes_.push_back(std::move(regex));
       } else {
@@ -2523,27 +2620,10 @@ void SQLTestBase::LogMode() const {
 }
 
 absl::Status SQLTestBase::LoadKnownErrorFile(absl::string_view filename) {
-  std::string text;
-  absl::Status status = internal::GetContents(filename, &text);
-  if (!status.ok()) {
-    if (status.code() == absl::StatusCode::kNotFound) {
-      return ::zetasql_base::InvalidArgumentErrorBuilder()
-             << "ERROR: Known Error file " << filename << " does not exist";
-    } else {
-      return ::zetasql_base::InvalidArgumentErrorBuilder()
-             << "ERROR: Unable to get known error contents from " << filename
-             << ": " << internal::StatusToString(status);
-    }
-  }
-
-  KnownErrorFile known_error_file;
-  if (!google::protobuf::TextFormat::ParseFromString(text, &known_error_file)) {
-    return ::zetasql_base::InvalidArgumentErrorBuilder()
-           << "ERROR: Failed to parse known error file " << filename;
-  }
-
-  for (int i = 0; i < known_error_file.known_errors_size(); i++) {
-    ZETASQL_RETURN_IF_ERROR(AddKnownErrorEntry(known_error_file.known_errors(i)));
+  ZETASQL_ASSIGN_OR_RETURN(std::shared_ptr<const KnownErrorFile> known_error_file,
+                   ReadKnownErrorFile(filename));
+  for (int i = 0; i < known_error_file->known_errors_size(); i++) {
+    ZETASQL_RETURN_IF_ERROR(AddKnownErrorEntry(known_error_file->known_errors(i)));
   }
 
   return absl::OkStatus();
@@ -2566,7 +2646,7 @@ KnownErrorMode SQLTestBase::IsKnownError(
                 << " in mode: " << KnownErrorMode_Name(individual_mode);
     }
 
-    for (const std::unique_ptr<RE2>& regex : known_error_regexes_) {
+    for (const std::shared_ptr<const RE2>& regex : known_error_regexes_) {
       if (RE2::FullMatch(label, *regex)) {
         individual_mode =
             zetasql_base::FindOrDie(label_info_map_, regex->pattern()).mode;
@@ -742,7 +742,8 @@ class SQLTestBase : public ::testing::TestWithParam<std::string> {
   // matching.
   absl::node_hash_set<std::string> known_error_labels_;
   absl::node_hash_set<std::string> known_error_regex_strings_;
-  std::vector<std::unique_ptr<RE2>> known_error_regexes_;
+  // Shared with the other SQLTestBase instances of the process.
+  std::vector<std::shared_ptr<const RE2>> known_error_regexes_;
 
   // Maps a label to its known error mode and the set of reasons as defined in
   // corresponding files.
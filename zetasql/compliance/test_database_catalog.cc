@@ -35,6 +35,8 @@
 #include "zetasql/base/check.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/strings/str_join.h"
 #include "google/protobuf/compiler/importer.h"
 #include "zetasql/base/ret_check.h"
@@ -42,88 +44,86 @@
 
 namespace zetasql {
 
-TestDatabaseCatalog::BuiltinFunctionCache::~BuiltinFunctionCache() {
-  DumpStats();
+TestDatabaseCatalog::BuiltinFunctionCache*
+TestDatabaseCatalog::BuiltinFunctionCache::Get() {
+  static BuiltinFunctionCache* cache = new BuiltinFunctionCache;
+  return cache;
 }
-absl::Status TestDatabaseCatalog::BuiltinFunctionCache::SetLanguageOptions(
-    const LanguageOptions& options, SimpleCatalog* catalog) {
+
+absl::StatusOr<const TestDatabaseCatalog::BuiltinFunctionCache::CacheEntry*>
+TestDatabaseCatalog::BuiltinFunctionCache::GetBuiltins(
+    const LanguageOptions& options) {
+  absl::MutexLock lock(&mutex_);
   ++total_calls_;
-  const CacheEntry* cache_entry = nullptr;
   if (auto it = builtins_cache_.find(options); it != builtins_cache_.end()) {
     cache_hit_++;
-    cache_entry = &it->second;
-  } else {
-    CacheEntry entry;
-    // We have to call type_factory() while not holding mutex_.
-    TypeFactory* type_factory = catalog->type_factory();
-    ZETASQL_RETURN_IF_ERROR(GetBuiltinFunctionsAndTypes(BuiltinFunctionOptions(options),
-                                                *type_factory, entry.functions,
-                                                entry.types));
-    cache_entry =
-        &(builtins_cache_.emplace(options, std::move(entry)).first->second);
-  }
-
-  auto builtin_function_predicate = [](const Function* fn) {
-    return fn->IsZetaSQLBuiltin();
-  };
-
-  // We need to remove all the types that are added along with builtin
-  // functions, which, at the moment is limited to opaque enum types.
-  auto builtin_type_predicate = [](const Type* type) {
-    return type->IsEnum() && type->AsEnum()->IsOpaque();
-  };
-
-  catalog->RemoveFunctions(builtin_function_predicate);
-  catalog->RemoveTypes(builtin_type_predicate);
-
-  std::vector<const Function*> functions;
-  functions.reserve(cache_entry->functions.size());
-  for (const auto& [_, function] : cache_entry->functions) {
-    ZETASQL_RET_CHECK(builtin_function_predicate(function.get()));
-    functions.push_back(function.get());
-  }
-  catalog->AddZetaSQLFunctions(functions);
-
-  for (const auto& [name, type] : cache_entry->types) {
-    // Make sure we are consistent with types we add and remove.
-    ZETASQL_RET_CHECK(builtin_type_predicate(type));
-    // Note, we currently don't support builtin types with catalog paths.
-    catalog->AddType(name, type);
+    return it->second.get();
   }
-  return absl::OkStatus();
+  auto entry = std::make_unique<CacheEntry>();
+  ZETASQL_RETURN_IF_ERROR(GetBuiltinFunctionsAndTypes(BuiltinFunctionOptions(options),
+                                              type_factory_, entry->functions,
+                                              entry->types));
+  return builtins_cache_.emplace(options, std::move(entry))
+      .first->second.get();
 }
+
 void TestDatabaseCatalog::BuiltinFunctionCache::DumpStats() {
+  absl::MutexLock lock(&mutex_);
   ABSL_LOG(INFO) << "BuiltinFunctionCache: hit: " << cache_hit_ << " / "
             << total_calls_ << "("
             << (total_calls_ == 0 ? 0 : cache_hit_ * 100. / total_calls_)
             << "%) size: " << builtins_cache_.size();
 }
 
+TestDatabaseCatalog::ProtoImporter::ProtoImporter(
+    std::unique_ptr<google::protobuf::compiler::SourceTree> source_tree_in)
+    : source_tree(std::move(source_tree_in)),
+      error_collector(
+          std::make_unique<TestDriver::ProtoErrorCollector>(&errors)),
+      importer(std::make_unique<google::protobuf::compiler::Importer>(
+          source_tree.get(), error_collector.get())) {}
+
+TestDatabaseCatalog::ProtoImporter* TestDatabaseCatalog::GetProtoImporter(
+    bool runs_as_test) {
+  static ProtoImporter* test_importer =
+      new ProtoImporter(CreateProtoSourceTree());
+  static ProtoImporter* file_importer = new ProtoImporter(
+      std::make_unique<TestDriver::ProtoSourceTree>(""));
+  return runs_as_test ? test_importer : file_importer;
+}
+
 TestDatabaseCatalog::TestDatabaseCatalog(TypeFactory* type_factory)
-    : function_cache_(std::make_unique<BuiltinFunctionCache>()),
-      type_factory_(type_factory) {}
+    : type_factory_(type_factory) {}
+
+TestDatabaseCatalog::~TestDatabaseCatalog() {
+  BuiltinFunctionCache::Get()->DumpStats();
+}
 
 absl::Status TestDatabaseCatalog::LoadProtoEnumTypes(
     const std::set<std::string>& filenames,
     const std::set<std::string>& proto_names,
     const std::set<std::string>& enum_names) {
-  errors_.clear();
+  absl::MutexLock lock(&proto_importer_->mutex);
+  google::protobuf::compiler::Importer* importer =
+      proto_importer_->importer.get();
+  std::vector<std::string>& errors = proto_importer_->errors;
+  errors.clear();
   for (const std::string& filename : filenames) {
-    importer_->Import(filename);
+    importer->Import(filename);
   }
-  if (!errors_.empty()) {
-    return ::zetasql_base::InternalErrorBuilder() << absl::StrJoin(errors_, "\n");
+  if (!errors.empty()) {
+    return ::zetasql_base::InternalErrorBuilder() << absl::StrJoin(errors, "\n");
   }
 
   std::set<std::string> proto_closure;
   std::set<std::string> enum_closure;
-  ZETASQL_RETURN_IF_ERROR(ComputeTransitiveClosure(importer_->pool(), proto_names,
+  ZETASQL_RETURN_IF_ERROR(ComputeTransitiveClosure(importer->pool(), proto_names,
                                            enum_names, &proto_closure,
                                            &enum_closure));
 
   for (const std::string& proto : proto_closure) {
     const google::protobuf::Descriptor* descriptor =
-        importer_->pool()->FindMessageTypeByName(proto);
+        importer->pool()->FindMessageTypeByName(proto);
     if (!descriptor) {
       return ::zetasql_base::NotFoundErrorBuilder() << "Proto Message Type: " << proto;
     }
@@ -134,7 +134,7 @@ absl::Status TestDatabaseCatalog::LoadProtoEnumTypes(
   }
   for (const std::string& enum_name : enum_closure) {
     const google::protobuf::EnumDescriptor* enum_descriptor =
-        importer_->pool()->FindEnumTypeByName(enum_name);
+        importer->pool()->FindEnumTypeByName(enum_name);
     if (!enum_descriptor) {
       return ::zetasql_base::NotFoundErrorBuilder() << "Enum Type: " << enum_name;
     }
@@ -183,16 +183,8 @@ void TestDatabaseCatalog::AddTable(const std::string& table_name,
 
 absl::Status TestDatabaseCatalog::SetTestDatabase(const TestDatabase& test_db) {
   catalog_ = std::make_unique<SimpleCatalog>("root_catalog", type_factory_);
-  // Prepare proto importer.
-  if (test_db.runs_as_test) {
-    proto_source_tree_ = CreateProtoSourceTree();
-  } else {
-    proto_source_tree_ = std::make_unique<TestDriver::ProtoSourceTree>("");
-  }
-  proto_error_collector_ =
-      std::make_unique<TestDriver::ProtoErrorCollector>(&errors_);
-  importer_ = std::make_unique<google::protobuf::compiler::Importer>(
-      proto_source_tree_.get(), proto_error_collector_.get());
+  installed_builtins_ = nullptr;
+  proto_importer_ = GetProtoImporter(test_db.runs_as_test);
   // Load protos and enums.
   ZETASQL_RETURN_IF_ERROR(LoadProtoEnumTypes(test_db.proto_files, test_db.proto_names,
                                      test_db.enum_names));
@@ -207,11 +199,46 @@ absl::Status TestDatabaseCatalog::SetTestDatabase(const TestDatabase& test_db) {
   return absl::OkStatus();
 }
 
+absl::Status TestDatabaseCatalog::InstallBuiltins(
+    const BuiltinFunctionCache::CacheEntry& entry) {
+  auto builtin_function_predicate = [](const Function* fn) {
+    return fn->IsZetaSQLBuiltin();
+  };
+
+  // We need to remove all the types that are added along with builtin
+  // functions, which, at the moment is limited to opaque enum types.
+  auto builtin_type_predicate = [](const Type* type) {
+    return type->IsEnum() && type->AsEnum()->IsOpaque();
+  };
+
+  catalog_->RemoveFunctions(builtin_function_predicate);
+  catalog_->RemoveTypes(builtin_type_predicate);
+
+  std::vector<const Function*> functions;
+  functions.reserve(entry.functions.size());
+  for (const auto& [_, function] : entry.functions) {
+    ZETASQL_RET_CHECK(builtin_function_predicate(function.get()));
+    functions.push_back(function.get());
+  }
+  catalog_->AddZetaSQLFunctions(functions);
+
+  for (const auto& [name, type] : entry.types) {
+    // Make sure we are consistent with types we add and remove.
+    ZETASQL_RET_CHECK(builtin_type_predicate(type));
+    // Note, we currently don't support builtin types with catalog paths.
+    catalog_->AddType(name, type);
+  }
+  return absl::OkStatus();
+}
+
 void TestDatabaseCatalog::SetLanguageOptions(
     const LanguageOptions& language_options) {
-  if (catalog_ != nullptr) {
-    ZETASQL_CHECK_OK(
-        function_cache_->SetLanguageOptions(language_options, catalog_.get()));
-  }
+  if (catalog_ == nullptr) return;
+  absl::StatusOr<const BuiltinFunctionCache::CacheEntry*> entry =
+      BuiltinFunctionCache::Get()->GetBuiltins(language_options);
+  ZETASQL_CHECK_OK(entry.status());
+  if (*entry == installed_builtins_) return;
+  ZETASQL_CHECK_OK(InstallBuiltins(**entry));
+  installed_builtins_ = *entry;
 }
 }  // namespace zetasql
@@ -29,16 +29,27 @@
 #include "zetasql/public/type.h"
 #include "zetasql/public/types/type_factory.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/base/thread_annotations.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
 #include "google/protobuf/compiler/importer.h"
 
 namespace zetasql {
 
 // Class which manages a Catalog constructed from a TestDatabase and
 // LanguageOptions.
+//
+// The builtin functions for each LanguageOptions and the imported proto files
+// are shared by all instances in the process, since compliance tests create a
+// new catalog for each test but use only a handful of distinct
+// LanguageOptions and proto files.
 class TestDatabaseCatalog {
  public:
   explicit TestDatabaseCatalog(TypeFactory* type_factory);
+  TestDatabaseCatalog(const TestDatabaseCatalog&) = delete;
+  TestDatabaseCatalog& operator=(const TestDatabaseCatalog&) = delete;
+  ~TestDatabaseCatalog();
 
   SimpleCatalog* catalog() const { return catalog_.get(); }
   absl::Status SetTestDatabase(const TestDatabase& test_db);
@@ -50,33 +61,60 @@ class TestDatabaseCatalog {
                                   const std::set<std::string>& enum_names);
 
  private:
+  // Process-wide cache of the builtin functions and types for each
+  // LanguageOptions. They are created with a TypeFactory owned by the cache,
+  // so that they outlive the TypeFactory of any one catalog.
   class BuiltinFunctionCache {
    public:
-    ~BuiltinFunctionCache();
-    absl::Status SetLanguageOptions(const LanguageOptions& options,
-                                    SimpleCatalog* catalog);
+    struct CacheEntry {
+      absl::flat_hash_map<std::string, std::unique_ptr<Function>> functions;
+      absl::flat_hash_map<std::string, const Type*> types;
+    };
+
+    static BuiltinFunctionCache* Get();
+
+    // Returns the builtins for 'options', creating them on first use. The
+    // returned entry lives as long as the process.
+    absl::StatusOr<const CacheEntry*> GetBuiltins(
+        const LanguageOptions& options);
     void DumpStats();
 
    private:
-    using BuiltinFunctionMap =
-        absl::flat_hash_map<std::string, std::unique_ptr<Function>>;
-    using BuiltinTypeMap = absl::flat_hash_map<std::string, const Type*>;
-    struct CacheEntry {
-      BuiltinFunctionMap functions;
-      BuiltinTypeMap types;
-    };
-    int total_calls_ = 0;
-    int cache_hit_ = 0;
-    absl::flat_hash_map<LanguageOptions, CacheEntry> builtins_cache_;
+    BuiltinFunctionCache() = default;
+
+    absl::Mutex mutex_;
+    TypeFactory type_factory_;
+    int total_calls_ ABSL_GUARDED_BY(mutex_) = 0;
+    int cache_hit_ ABSL_GUARDED_BY(mutex_) = 0;
+    absl::flat_hash_map<LanguageOptions, std::unique_ptr<CacheEntry>>
+        builtins_cache_ ABSL_GUARDED_BY(mutex_);
+  };
+
+  // A proto Importer shared by all catalogs that read proto files from the
+  // same source tree. Importing a file that was already imported is free, so
+  // databases loading the same proto files do not parse them again.
+  struct ProtoImporter {
+    explicit ProtoImporter(
+        std::unique_ptr<google::protobuf::compiler::SourceTree> source_tree);
+
+    absl::Mutex mutex;
+    std::vector<std::string> errors ABSL_GUARDED_BY(mutex);
+    std::unique_ptr<google::protobuf::compiler::SourceTree> source_tree;
+    std::unique_ptr<google::protobuf::compiler::MultiFileErrorCollector>
+        error_collector;
+    std::unique_ptr<google::protobuf::compiler::Importer> importer
+        ABSL_GUARDED_BY(mutex);
   };
 
-  std::vector<std::string> errors_;
-  std::unique_ptr<google::protobuf::compiler::SourceTree> proto_source_tree_;
-  std::unique_ptr<google::protobuf::compiler::MultiFileErrorCollector>
-      proto_error_collector_;
-  std::unique_ptr<google::protobuf::compiler::Importer> importer_;
-  std::unique_ptr<BuiltinFunctionCache> function_cache_;
+  static ProtoImporter* GetProtoImporter(bool runs_as_test);
+
+  absl::Status InstallBuiltins(const BuiltinFunctionCache::CacheEntry& entry);
+
+  ProtoImporter* proto_importer_ = nullptr;
   std::unique_ptr<SimpleCatalog> catalog_;
+  // The builtins currently in 'catalog_', so that setting LanguageOptions
+  // with the same builtins again does not replace them.
+  const BuiltinFunctionCache::CacheEntry* installed_builtins_ = nullptr;
   TypeFactory* type_factory_;
 };
 
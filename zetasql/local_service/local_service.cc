@@ -17,8 +17,12 @@
 #include "zetasql/local_service/local_service.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <limits>
+#include <list>
 #include <memory>
 #include <optional>
 #include <string>
@@ -50,9 +54,14 @@
 #include "zetasql/resolved_ast/resolved_ast.h"
 #include "zetasql/resolved_ast/sql_builder.h"
 #include "absl/cleanup/cleanup.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/functional/bind_front.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "zetasql/base/map_util.h"
 #include "zetasql/base/ret_check.h"
@@ -148,6 +157,93 @@ absl::StatusOr<EvaluateModifyResponse::Row::Operation> SerializeModifyOperation(
   }
 }
 
+// Builds a ColumnarTableData from the rows of a result, see
+// EvaluateQueryRequest::COLUMNAR.
+class ColumnarTableDataBuilder {
+ public:
+  ColumnarTableDataBuilder(const EvaluatorTableIterator& iterator,
+                           ColumnarTableData* table)
+      : table_(table), string_dictionaries_(iterator.NumColumns()) {
+    for (int i = 0; i < iterator.NumColumns(); ++i) {
+      column_kinds_.push_back(iterator.GetColumnType(i)->kind());
+      table_->add_column();
+    }
+  }
+
+  absl::Status AddRow(const EvaluatorTableIterator& iterator) {
+    const int64_t row = table_->num_rows();
+    for (int i = 0; i < static_cast<int>(column_kinds_.size()); ++i) {
+      ZETASQL_RETURN_IF_ERROR(AddValue(i, row, iterator.GetValue(i)));
+    }
+    table_->set_num_rows(row + 1);
+    return absl::OkStatus();
+  }
+
+ private:
+  absl::Status AddValue(int column_index, int64_t row, const Value& value) {
+    ColumnarTableData::Column* column = table_->mutable_column(column_index);
+    const bool is_null = value.is_null();
+    if (is_null) {
+      std::string* null_bitmap = column->mutable_null_bitmap();
+      null_bitmap->resize((table_->num_rows() + 8) / 8, '\0');
+      (*null_bitmap)[row / 8] |= static_cast<char>(1 << (row % 8));
+    }
+    switch (column_kinds_[column_index]) {
+      case TYPE_INT32:
+        column->add_int64_values(is_null ? 0 : value.int32_value());
+        break;
+      case TYPE_INT64:
+        column->add_int64_values(is_null ? 0 : value.int64_value());
+        break;
+      case TYPE_UINT32:
+        column->add_uint64_values(is_null ? 0 : value.uint32_value());
+        break;
+      case TYPE_UINT64:
+        column->add_uint64_values(is_null ? 0 : value.uint64_value());
+        break;
+      case TYPE_BOOL:
+        column->add_bool_values(!is_null && value.bool_value());
+        break;
+      case TYPE_FLOAT:
+        column->add_double_values(is_null ? 0 : value.float_value());
+        break;
+      case TYPE_DOUBLE:
+        column->add_double_values(is_null ? 0 : value.double_value());
+        break;
+      case TYPE_STRING: {
+        if (is_null) {
+          column->add_string_indexes(0);
+          break;
+        }
+        auto [it, inserted] = string_dictionaries_[column_index].emplace(
+            value.string_value(), column->string_dictionary_size());
+        if (inserted) {
+          column->add_string_dictionary(value.string_value());
+        }
+        column->add_string_indexes(it->second);
+        break;
+      }
+      case TYPE_BYTES:
+        if (is_null) {
+          column->add_bytes_values();
+        } else {
+          column->add_bytes_values(value.bytes_value());
+        }
+        break;
+      default:
+        ZETASQL_RETURN_IF_ERROR(value.Serialize(column->add_values()));
+        break;
+    }
+    return absl::OkStatus();
+  }
+
+  ColumnarTableData* table_;
+  std::vector<TypeKind> column_kinds_;
+  // For each column, maps its distinct strings to their index in the
+  // string_dictionary.
+  std::vector<absl::flat_hash_map<std::string, int>> string_dictionaries_;
+};
+
 }  // namespace
 
 class RegisteredDescriptorPoolState : public GenericState {
@@ -205,6 +301,78 @@ class RegisteredDescriptorPoolPool
   std::shared_ptr<RegisteredDescriptorPoolState> builtin_pool_;
 };
 
+// An LRU cache of the unregistered DescriptorPools built from the
+// FileDescriptorSets of recent requests, keyed on the serialized
+// FileDescriptorSet. Clients that send the same large FileDescriptorSet with
+// every Analyze or BuildSql call, instead of registering it, then only pay for
+// building the DescriptorPool once.
+//
+// The cached states are never registered, so only calls that don't register
+// the descriptor pools they use may share them. Callers keep the returned
+// state alive for as long as they use it, even if it is evicted.
+class DescriptorPoolCache {
+ public:
+  static constexpr int kCapacity = 8;
+
+  DescriptorPoolCache() = default;
+  DescriptorPoolCache(const DescriptorPoolCache&) = delete;
+  DescriptorPoolCache& operator=(const DescriptorPoolCache&) = delete;
+
+  absl::StatusOr<std::shared_ptr<RegisteredDescriptorPoolState>> GetOrCreate(
+      const google::protobuf::FileDescriptorSet& fdset) {
+    std::string key = fdset.SerializeAsString();
+    {
+      absl::MutexLock lock(&mutex_);
+      auto it = index_.find(key);
+      if (it != index_.end()) {
+        ++hits_;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->second;
+      }
+      ++misses_;
+    }
+
+    // Build the pool without holding 'mutex_', this is the expensive part.
+    std::shared_ptr<RegisteredDescriptorPoolState> state;
+    ZETASQL_ASSIGN_OR_RETURN(state, RegisteredDescriptorPoolState::Create(fdset));
+
+    absl::MutexLock lock(&mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      // Another thread built the same pool in the meantime.
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return it->second->second;
+    }
+    entries_.emplace_front(std::move(key), state);
+    index_.emplace(entries_.front().first, entries_.begin());
+    if (entries_.size() > kCapacity) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+    return state;
+  }
+
+  void GetStats(ServiceStatsResponse* response) {
+    absl::MutexLock lock(&mutex_);
+    response->set_cached_descriptor_pools(entries_.size());
+    response->set_descriptor_pool_cache_hits(hits_);
+    response->set_descriptor_pool_cache_misses(misses_);
+  }
+
+ private:
+  using Entry =
+      std::pair<std::string, std::shared_ptr<RegisteredDescriptorPoolState>>;
+
+  absl::Mutex mutex_;
+  int64_t hits_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t misses_ ABSL_GUARDED_BY(mutex_) = 0;
+  // Most recently used first.
+  std::list<Entry> entries_ ABSL_GUARDED_BY(mutex_);
+  // Keys are views of the keys in 'entries_'.
+  absl::flat_hash_map<absl::string_view, std::list<Entry>::iterator> index_
+      ABSL_GUARDED_BY(mutex_);
+};
+
 class InternalPreparedExpressionState : public GenericState {
  public:
   InternalPreparedExpressionState() = delete;
@@ -457,6 +625,15 @@ class RegisteredCatalogState : public GenericState {
     return owned_descriptor_pool_ids_;
   }
 
+  // Whether the catalog was registered for a prepared statement, which
+  // unregisters it when it is unprepared, rather than by RegisterCatalog.
+  bool owned_by_statement() const {
+    return owned_by_statement_.load(std::memory_order_relaxed);
+  }
+  void set_owned_by_statement() {
+    owned_by_statement_.store(true, std::memory_order_relaxed);
+  }
+
  private:
   RegisteredCatalogState(std::unique_ptr<SimpleCatalog> catalog,
                          absl::flat_hash_set<int64_t> owned_descriptor_pool_ids)
@@ -495,19 +672,118 @@ class RegisteredCatalogState : public GenericState {
 
   const std::unique_ptr<SimpleCatalog> catalog_;
   const absl::flat_hash_set<int64_t> owned_descriptor_pool_ids_;
+  std::atomic<bool> owned_by_statement_ = false;
 };
 
 class RegisteredCatalogPool : public SharedStatePool<RegisteredCatalogState> {};
 
 ZetaSqlLocalServiceImpl::ZetaSqlLocalServiceImpl()
+    : ZetaSqlLocalServiceImpl(StateRetentionOptions()) {}
+
+ZetaSqlLocalServiceImpl::ZetaSqlLocalServiceImpl(
+    const StateRetentionOptions& retention_options)
     : registered_descriptor_pools_(new RegisteredDescriptorPoolPool()),
       registered_catalogs_(new RegisteredCatalogPool()),
       prepared_expressions_(new PreparedExpressionPool()),
       prepared_queries_(new PreparedQueryPool()),
-      prepared_modifies_(new PreparedModifyPool()) {}
+      prepared_modifies_(new PreparedModifyPool()),
+      descriptor_pool_cache_(new DescriptorPoolCache()),
+      retention_options_(retention_options) {}
 
 ZetaSqlLocalServiceImpl::~ZetaSqlLocalServiceImpl() = default;
 
+template <typename StateT>
+absl::Status ZetaSqlLocalServiceImpl::CheckNotEvicted(
+    const SharedStatePool<StateT>& pool, int64_t id,
+    absl::string_view state_kind) {
+  if (pool.WasEvicted(id)) {
+    return ::zetasql_base::NotFoundErrorBuilder()
+           << state_kind << " " << id
+           << " was evicted from the local service because it was not used "
+              "recently, and must be prepared or registered again";
+  }
+  return absl::OkStatus();
+}
+
+void ZetaSqlLocalServiceImpl::EvictStates() {
+  if (retention_options_.max_idle_time == absl::InfiniteDuration() &&
+      retention_options_.max_states <= 0) {
+    return;
+  }
+  // Another registration is evicting already, and will see this one's state.
+  if (!eviction_mutex_.TryLock()) {
+    return;
+  }
+  absl::Cleanup unlock = [this] { eviction_mutex_.Unlock(); };
+
+  enum StateKind { kExpression, kQuery, kModify, kCatalog };
+  struct Candidate {
+    int64_t last_use_nanos;
+    StateKind kind;
+    int64_t id;
+  };
+  std::vector<Candidate> candidates;
+  auto add_candidates = [&candidates](auto& pool, StateKind kind,
+                                      const auto& evictable) {
+    for (const auto& [last_use_nanos, id] : pool.GetLastUseTimes(evictable)) {
+      candidates.push_back(Candidate{last_use_nanos, kind, id});
+    }
+  };
+  auto any_state = [](const GenericState&) { return true; };
+  add_candidates(*prepared_expressions_, kExpression, any_state);
+  add_candidates(*prepared_queries_, kQuery, any_state);
+  add_candidates(*prepared_modifies_, kModify, any_state);
+  add_candidates(*registered_catalogs_, kCatalog,
+                 [](const RegisteredCatalogState& state) {
+                   return !state.owned_by_statement();
+                 });
+  // Least recently used first.
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Candidate& a, const Candidate& b) {
+              return a.last_use_nanos < b.last_use_nanos;
+            });
+
+  const int64_t idle_cutoff_nanos =
+      retention_options_.max_idle_time == absl::InfiniteDuration()
+          ? std::numeric_limits<int64_t>::min()
+          : absl::GetCurrentTimeNanos() -
+                absl::ToInt64Nanoseconds(retention_options_.max_idle_time);
+  const int64_t num_to_keep = retention_options_.max_states > 0
+                                  ? retention_options_.max_states
+                                  : std::numeric_limits<int64_t>::max();
+  for (int64_t i = 0; i < static_cast<int64_t>(candidates.size()); ++i) {
+    const Candidate& candidate = candidates[i];
+    const int64_t num_remaining = candidates.size() - i;
+    if (candidate.last_use_nanos >= idle_cutoff_nanos &&
+        num_remaining <= num_to_keep) {
+      break;
+    }
+    // A state that was unprepared concurrently is simply skipped.
+    switch (candidate.kind) {
+      case kExpression:
+        if (Unprepare(candidate.id).ok()) {
+          prepared_expressions_->RecordEvicted(candidate.id);
+        }
+        break;
+      case kQuery:
+        if (UnprepareQuery(candidate.id).ok()) {
+          prepared_queries_->RecordEvicted(candidate.id);
+        }
+        break;
+      case kModify:
+        if (UnprepareModify(candidate.id).ok()) {
+          prepared_modifies_->RecordEvicted(candidate.id);
+        }
+        break;
+      case kCatalog:
+        if (UnregisterCatalog(candidate.id).ok()) {
+          registered_catalogs_->RecordEvicted(candidate.id);
+        }
+        break;
+    }
+  }
+}
+
 void ZetaSqlLocalServiceImpl::CleanupCatalog(
     std::optional<int64_t>* catalog_id) {
   if (catalog_id->has_value()) {
@@ -751,6 +1027,7 @@ absl::Status ZetaSqlLocalServiceImpl::PrepareImpl(
     owned_catalog_id = registered_catalogs_->Register(catalog_state);
     ZETASQL_RET_CHECK_NE(-1, owned_catalog_id.value())
         << "Failed to register catalog, this shouldn't happen";
+    catalog_state->set_owned_by_statement();
   }
 
   std::shared_ptr<InternalStateT> internal_state;
@@ -766,6 +1043,7 @@ absl::Status ZetaSqlLocalServiceImpl::PrepareImpl(
   // therefore any owned descriptor pools.
   std::move(catalog_cleanup).Cancel();
   std::move(descriptor_pool_cleanup).Cancel();
+  EvictStates();
   return absl::OkStatus();
 }
 
@@ -787,6 +1065,10 @@ absl::Status ZetaSqlLocalServiceImpl::UnprepareImpl(
     absl::string_view statement_type) {
   std::shared_ptr<InternalStateT> state = prepared_statements_pool.Get(id);
   if (state == nullptr) {
+    if (prepared_statements_pool.WasEvicted(id)) {
+      // The state is gone, as the client asked.
+      return absl::OkStatus();
+    }
     return MakeSqlError() << "Unknown prepared " << statement_type
                           << " ID: " << id;
   }
@@ -824,7 +1106,8 @@ absl::Status ZetaSqlLocalServiceImpl::UnprepareImpl(
 // this method can be replaced with a call to the EvaluateImpl() API and
 // the EvaluatePreparedExpression() method should be renamed to EvaluatePrepared
 absl::Status ZetaSqlLocalServiceImpl::Evaluate(const EvaluateRequest& request,
-                                                 EvaluateResponse* response) {
+                                                 EvaluateResponse* response,
+                                                 absl::Time deadline) {
   bool prepared = request.has_prepared_expression_id();
   std::shared_ptr<InternalPreparedExpressionState> state;
   std::vector<const google::protobuf::DescriptorPool*> pools;
@@ -842,6 +1125,8 @@ absl::Status ZetaSqlLocalServiceImpl::Evaluate(const EvaluateRequest& request,
     int64_t id = request.prepared_expression_id();
     state = prepared_expressions_->Get(id);
     if (state == nullptr) {
+      ZETASQL_RETURN_IF_ERROR(
+          CheckNotEvicted(*prepared_expressions_, id, "Prepared expression"));
       return MakeSqlError() << "Prepared expression " << id << " unknown.";
     }
   } else {
@@ -857,7 +1142,8 @@ absl::Status ZetaSqlLocalServiceImpl::Evaluate(const EvaluateRequest& request,
                    /*owned_catalog_id=*/std::nullopt));
   }
 
-  ZETASQL_RETURN_IF_ERROR(EvaluatePreparedExpression(request, state.get(), response));
+  ZETASQL_RETURN_IF_ERROR(
+      EvaluatePreparedExpression(request, state.get(), deadline, response));
 
   if (!prepared) {
     ZETASQL_RETURN_IF_ERROR(RegisterPrepared(
@@ -868,17 +1154,38 @@ absl::Status ZetaSqlLocalServiceImpl::Evaluate(const EvaluateRequest& request,
   // No errors, caller is now responsible for the prepared expression and
   // therefore any owned descriptor pools.
   std::move(descriptor_pool_cleanup).Cancel();
+  if (!prepared) {
+    EvictStates();
+  }
   return absl::OkStatus();
 }
 
 absl::Status ZetaSqlLocalServiceImpl::EvaluateQuery(
-    const EvaluateQueryRequest& request, EvaluateQueryResponse* response) {
+    const EvaluateQueryRequest& request, EvaluateQueryResponse* response,
+    absl::Time deadline) {
   std::optional<int64_t> prepared_query_id_opt =
       request.has_prepared_query_id()
           ? std::optional<int64_t>(request.prepared_query_id())
           : std::nullopt;
   return EvaluateImpl(request, request.table_content(), prepared_query_id_opt,
-                      *prepared_queries_, "query", response);
+                      *prepared_queries_, "query", deadline,
+                      /*write_chunk=*/{}, response);
+}
+
+absl::Status ZetaSqlLocalServiceImpl::EvaluateQueryChunked(
+    const EvaluateQueryRequest& request,
+    const std::function<absl::Status(const EvaluateQueryResponse&)>&
+        write_chunk,
+    absl::Time deadline) {
+  std::optional<int64_t> prepared_query_id_opt =
+      request.has_prepared_query_id()
+          ? std::optional<int64_t>(request.prepared_query_id())
+          : std::nullopt;
+  EvaluateQueryResponse response;
+  ZETASQL_RETURN_IF_ERROR(EvaluateImpl(request, request.table_content(),
+                               prepared_query_id_opt, *prepared_queries_,
+                               "query", deadline, write_chunk, &response));
+  return write_chunk(response);
 }
 
 absl::Status ZetaSqlLocalServiceImpl::EvaluateModify(
@@ -888,7 +1195,9 @@ absl::Status ZetaSqlLocalServiceImpl::EvaluateModify(
           ? std::optional<int64_t>(request.prepared_modify_id())
           : std::nullopt;
   return EvaluateImpl(request, request.table_content(), prepared_modify_id_opt,
-                      *prepared_modifies_, "modify", response);
+                      *prepared_modifies_, "modify",
+                      /*deadline=*/absl::InfiniteFuture(),
+                      /*write_chunk=*/{}, response);
 }
 
 template <typename RequestT, typename ResponseT, typename InternalStateT>
@@ -897,7 +1206,9 @@ absl::Status ZetaSqlLocalServiceImpl::EvaluateImpl(
     const google::protobuf::Map<std::string, TableContent>& tables_contents,
     std::optional<int64_t>& prepared_statement_id_opt,
     SharedStatePool<InternalStateT>& prepared_statements_pool,
-    absl::string_view statement_type, ResponseT* response) {
+    absl::string_view statement_type, absl::Time deadline,
+    const std::function<absl::Status(const ResponseT&)>& write_chunk,
+    ResponseT* response) {
   std::shared_ptr<InternalStateT> internal_state;
 
   std::vector<const google::protobuf::DescriptorPool*> pools;
@@ -923,12 +1234,16 @@ absl::Status ZetaSqlLocalServiceImpl::EvaluateImpl(
     int64_t id = prepared_statement_id_opt.value();
     internal_state = prepared_statements_pool.Get(id);
     if (internal_state == nullptr) {
+      ZETASQL_RETURN_IF_ERROR(
+          CheckNotEvicted(prepared_statements_pool, id,
+                          absl::StrCat("Prepared ", statement_type)));
       return MakeSqlError()
              << "Prepared " << statement_type << " " << id << " unknown.";
     }
   } else {
     ZETASQL_RETURN_IF_ERROR(GetDescriptorPools(request.descriptor_pool_list(),
-                                       descriptor_pool_states, pools));
+                                       descriptor_pool_states, pools,
+                                       /*use_descriptor_pool_cache=*/true));
 
     ZETASQL_RETURN_IF_ERROR(
         GetCatalogState(request, tables_contents, pools, catalog_state));
@@ -948,8 +1263,8 @@ absl::Status ZetaSqlLocalServiceImpl::EvaluateImpl(
   // does not have its content set.
   // Here we converting the Unimplemented error into Unimplemented
   // which is more appropriate
-  absl::Status evaluate_status =
-      EvaluatePrepared(request, internal_state.get(), response);
+  absl::Status evaluate_status = EvaluatePrepared(
+      request, internal_state.get(), deadline, write_chunk, response);
 
   if (evaluate_status.code() == absl::StatusCode::kUnimplemented) {
     return zetasql_base::InvalidArgumentErrorBuilder()
@@ -963,7 +1278,7 @@ absl::Status ZetaSqlLocalServiceImpl::EvaluateImpl(
 
 absl::Status ZetaSqlLocalServiceImpl::EvaluatePreparedExpression(
     const EvaluateRequest& request,
-    InternalPreparedExpressionState* internal_state,
+    InternalPreparedExpressionState* internal_state, absl::Time deadline,
     EvaluateResponse* response) {
   const AnalyzerOptions& analyzer_options =
       internal_state->GetAnalyzerOptions();
@@ -974,8 +1289,12 @@ absl::Status ZetaSqlLocalServiceImpl::EvaluatePreparedExpression(
   ZETASQL_RETURN_IF_ERROR(RepeatedParametersToMap(
       request.params(), analyzer_options.query_parameters(), &params));
 
-  auto result =
-      internal_state->GetExpression()->ExecuteAfterPrepare(columns, params);
+  PreparedExpression::ExpressionOptions options;
+  options.columns = std::move(columns);
+  options.parameters = std::move(params);
+  options.deadline = deadline;
+  auto result = internal_state->GetExpression()->ExecuteAfterPrepare(
+      std::move(options));
   ZETASQL_RETURN_IF_ERROR(result.status());
 
   const Value& value = result.value();
@@ -987,7 +1306,9 @@ absl::Status ZetaSqlLocalServiceImpl::EvaluatePreparedExpression(
 template <>
 absl::Status ZetaSqlLocalServiceImpl::EvaluatePrepared(
     const EvaluateQueryRequest& request,
-    InternalPreparedQueryState* internal_state,
+    InternalPreparedQueryState* internal_state, absl::Time deadline,
+    const std::function<absl::Status(const EvaluateQueryResponse&)>&
+        write_chunk,
     EvaluateQueryResponse* response) {
   const AnalyzerOptions& analyzer_options =
       internal_state->GetAnalyzerOptions();
@@ -1001,14 +1322,47 @@ absl::Status ZetaSqlLocalServiceImpl::EvaluatePrepared(
 
   ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> results_iterator,
                    internal_state->GetQuery()->ExecuteAfterPrepare(options));
+  results_iterator->SetDeadline(deadline);
+
+  const bool columnar =
+      request.result_format() == EvaluateQueryRequest::COLUMNAR;
+  const int64_t max_rows_per_chunk = request.max_rows_per_chunk() > 0
+                                         ? request.max_rows_per_chunk()
+                                         : kDefaultMaxRowsPerChunk;
+  // Starts the table of the next chunk in 'response'.
+  std::optional<ColumnarTableDataBuilder> builder;
+  TableData* table_data = nullptr;
+  auto start_chunk = [&]() {
+    if (columnar) {
+      builder.emplace(
+          *results_iterator,
+          response->mutable_content()->mutable_columnar_table_data());
+    } else {
+      table_data = response->mutable_content()->mutable_table_data();
+    }
+  };
+  start_chunk();
 
-  TableData* table_data = response->mutable_content()->mutable_table_data();
+  int64_t num_chunk_rows = 0;
   while (results_iterator->NextRow()) {
-    TableData::Row* row = table_data->add_row();
-    for (int i = 0; i < results_iterator->NumColumns(); i++) {
-      ValueProto* value = row->add_cell();
-      ZETASQL_RETURN_IF_ERROR(results_iterator->GetValue(i).Serialize(value));
+    if (write_chunk && num_chunk_rows == max_rows_per_chunk) {
+      // Only flush once the next row exists, so that the last chunk, which
+      // the caller writes, is never empty unless the whole result is.
+      ZETASQL_RETURN_IF_ERROR(write_chunk(*response));
+      response->Clear();
+      start_chunk();
+      num_chunk_rows = 0;
+    }
+    if (columnar) {
+      ZETASQL_RETURN_IF_ERROR(builder->AddRow(*results_iterator));
+    } else {
+      TableData::Row* row = table_data->add_row();
+      for (int i = 0; i < results_iterator->NumColumns(); i++) {
+        ValueProto* value = row->add_cell();
+        ZETASQL_RETURN_IF_ERROR(results_iterator->GetValue(i).Serialize(value));
+      }
     }
+    ++num_chunk_rows;
   }
 
   return results_iterator->Status();
@@ -1017,7 +1371,9 @@ absl::Status ZetaSqlLocalServiceImpl::EvaluatePrepared(
 template <>
 absl::Status ZetaSqlLocalServiceImpl::EvaluatePrepared(
     const EvaluateModifyRequest& request,
-    InternalPreparedModifyState* internal_state,
+    InternalPreparedModifyState* internal_state, absl::Time deadline,
+    const std::function<absl::Status(const EvaluateModifyResponse&)>&
+        write_chunk,
     EvaluateModifyResponse* response) {
   const AnalyzerOptions& analyzer_options =
       internal_state->GetAnalyzerOptions();
@@ -1104,7 +1460,8 @@ absl::Status ZetaSqlLocalServiceImpl::GetDescriptorPools(
     const DescriptorPoolListProto& descriptor_pool_list,
     std::vector<std::shared_ptr<RegisteredDescriptorPoolState>>&
         descriptor_pool_states,
-    std::vector<const google::protobuf::DescriptorPool*>& descriptor_pools) {
+    std::vector<const google::protobuf::DescriptorPool*>& descriptor_pools,
+    bool use_descriptor_pool_cache) {
   using Definition = DescriptorPoolListProto::Definition;
   descriptor_pool_states.clear();
   descriptor_pools.clear();
@@ -1112,8 +1469,13 @@ absl::Status ZetaSqlLocalServiceImpl::GetDescriptorPools(
     std::shared_ptr<RegisteredDescriptorPoolState> state;
     switch (definition.definition_case()) {
       case Definition::kFileDescriptorSet: {
-        ZETASQL_ASSIGN_OR_RETURN(state, RegisteredDescriptorPoolState::Create(
-                                    definition.file_descriptor_set()));
+        if (use_descriptor_pool_cache) {
+          ZETASQL_ASSIGN_OR_RETURN(state, descriptor_pool_cache_->GetOrCreate(
+                                      definition.file_descriptor_set()));
+        } else {
+          ZETASQL_ASSIGN_OR_RETURN(state, RegisteredDescriptorPoolState::Create(
+                                      definition.file_descriptor_set()));
+        }
         break;
       }
       case Definition::kRegisteredId: {
@@ -1163,6 +1525,8 @@ absl::Status ZetaSqlLocalServiceImpl::GetCatalogState(
     int64_t id = request.registered_catalog_id();
     state = registered_catalogs_->Get(id);
     if (state == nullptr) {
+      ZETASQL_RETURN_IF_ERROR(
+          CheckNotEvicted(*registered_catalogs_, id, "Registered catalog"));
       return MakeSqlError() << "Registered catalog " << id << " unknown.";
     }
   } else {
@@ -1181,7 +1545,8 @@ absl::Status ZetaSqlLocalServiceImpl::Analyze(const AnalyzeRequest& request,
       descriptor_pool_states;
 
   ZETASQL_RETURN_IF_ERROR(GetDescriptorPools(request.descriptor_pool_list(),
-                                     descriptor_pool_states, pools));
+                                     descriptor_pool_states, pools,
+                                     /*use_descriptor_pool_cache=*/true));
   ZETASQL_RETURN_IF_ERROR(GetCatalogState(request, {}, pools, catalog_state));
   if (request.has_sql_expression()) {
     return AnalyzeExpressionImpl(request, pools, catalog_state->GetCatalog(),
@@ -1212,8 +1577,8 @@ absl::Status ZetaSqlLocalServiceImpl::AnalyzeImpl(
     ZETASQL_RETURN_IF_ERROR(
         zetasql::AnalyzeStatement(sql, options, catalog, &factory, &output));
 
-    ZETASQL_RETURN_IF_ERROR(
-        SerializeResolvedOutput(output.get(), pools, sql, response));
+    ZETASQL_RETURN_IF_ERROR(SerializeResolvedOutput(
+        output.get(), pools, sql, request.statement_summary_only(), response));
   } else if (request.has_parse_resume_location()) {
     bool at_end_of_input;
     ParseResumeLocation location =
@@ -1221,8 +1586,9 @@ absl::Status ZetaSqlLocalServiceImpl::AnalyzeImpl(
     ZETASQL_RETURN_IF_ERROR(zetasql::AnalyzeNextStatement(
         &location, options, catalog, &factory, &output, &at_end_of_input));
 
-    ZETASQL_RETURN_IF_ERROR(SerializeResolvedOutput(output.get(), pools,
-                                            location.input(), response));
+    ZETASQL_RETURN_IF_ERROR(SerializeResolvedOutput(
+        output.get(), pools, location.input(),
+        request.statement_summary_only(), response));
     response->set_resume_byte_position(location.byte_position());
   }
   return absl::OkStatus();
@@ -1246,8 +1612,8 @@ absl::Status ZetaSqlLocalServiceImpl::AnalyzeExpressionImpl(
     ZETASQL_RETURN_IF_ERROR(
         zetasql::AnalyzeExpression(sql, options, catalog, &factory, &output));
 
-    ZETASQL_RETURN_IF_ERROR(
-        SerializeResolvedOutput(output.get(), pools, sql, response));
+    ZETASQL_RETURN_IF_ERROR(SerializeResolvedOutput(
+        output.get(), pools, sql, /*statement_summary_only=*/false, response));
   }
   return absl::OkStatus();
 }
@@ -1261,7 +1627,8 @@ absl::Status ZetaSqlLocalServiceImpl::BuildSql(const BuildSqlRequest& request,
       descriptor_pool_states;
 
   ZETASQL_RETURN_IF_ERROR(GetDescriptorPools(request.descriptor_pool_list(),
-                                     descriptor_pool_states, pools));
+                                     descriptor_pool_states, pools,
+                                     /*use_descriptor_pool_cache=*/true));
   ZETASQL_RETURN_IF_ERROR(GetCatalogState(request, {}, pools, catalog_state));
   IdStringPool string_pool;
   ResolvedNode::RestoreParams restore_params(
@@ -1346,14 +1713,48 @@ absl::Status ZetaSqlLocalServiceImpl::ExtractTableNamesFromNextStatement(
   return absl::OkStatus();
 }
 
+// Fills 'summary' with the statement-level information of 'statement'.
+static absl::Status SerializeStatementSummary(
+    const ResolvedStatement& statement,
+    FileDescriptorSetMap* file_descriptor_set_map,
+    AnalyzeResponse::StatementSummary* summary) {
+  summary->set_node_kind(statement.node_kind());
+  if (statement.Is<ResolvedQueryStmt>()) {
+    for (const auto& column :
+         statement.GetAs<ResolvedQueryStmt>()->output_column_list()) {
+      AnalyzeResponse::StatementSummary::OutputColumn* output_column =
+          summary->add_output_column();
+      output_column->set_name(column->name());
+      ZETASQL_RETURN_IF_ERROR(
+          column->column().type()->SerializeToProtoAndDistinctFileDescriptors(
+              output_column->mutable_type(), file_descriptor_set_map));
+    }
+  }
+  std::vector<const ResolvedNode*> scans;
+  statement.GetDescendantsWithKinds({RESOLVED_TABLE_SCAN}, &scans);
+  absl::flat_hash_set<const Table*> tables;
+  for (const ResolvedNode* scan : scans) {
+    const Table* table = scan->GetAs<ResolvedTableScan>()->table();
+    if (tables.insert(table).second) {
+      summary->add_referenced_table(table->FullName());
+    }
+  }
+  return absl::OkStatus();
+}
+
 absl::Status ZetaSqlLocalServiceImpl::SerializeResolvedOutput(
     const AnalyzerOutput* output,
     const std::vector<const google::protobuf::DescriptorPool*>& pools,
-    absl::string_view statement, AnalyzeResponse* response) {
+    absl::string_view statement, bool statement_summary_only,
+    AnalyzeResponse* response) {
   FileDescriptorSetMap file_descriptor_set_map;
   PopulateExistingPoolsToFileDescriptorSetMap(pools, &file_descriptor_set_map);
 
-  if (output->resolved_statement() != nullptr) {
+  if (output->resolved_statement() != nullptr && statement_summary_only) {
+    ZETASQL_RETURN_IF_ERROR(SerializeStatementSummary(
+        *output->resolved_statement(), &file_descriptor_set_map,
+        response->mutable_statement_summary()));
+  } else if (output->resolved_statement() != nullptr) {
     ZETASQL_RETURN_IF_ERROR(output->resolved_statement()->SaveTo(
         &file_descriptor_set_map, response->mutable_resolved_statement()));
   } else {
@@ -1443,6 +1844,7 @@ absl::Status ZetaSqlLocalServiceImpl::RegisterCatalog(
   // No errors, caller is now responsible for the prepared expression and
   // therefore any owned descriptor pools.
   std::move(descriptor_pool_cleanup).Cancel();
+  EvictStates();
 
   return absl::OkStatus();
 }
@@ -1450,6 +1852,10 @@ absl::Status ZetaSqlLocalServiceImpl::RegisterCatalog(
 absl::Status ZetaSqlLocalServiceImpl::UnregisterCatalog(int64_t id) {
   std::shared_ptr<RegisteredCatalogState> state = registered_catalogs_->Get(id);
   if (state == nullptr) {
+    if (registered_catalogs_->WasEvicted(id)) {
+      // The catalog is gone, as the client asked.
+      return absl::OkStatus();
+    }
     return MakeSqlError() << "Unknown catalog ID: " << id;
   }
 
@@ -1593,6 +1999,18 @@ absl::Status ZetaSqlLocalServiceImpl::ParseScriptImpl(
   return absl::OkStatus();
 }
 
+absl::Status ZetaSqlLocalServiceImpl::GetServiceStats(
+    const ServiceStatsRequest& request, ServiceStatsResponse* response) {
+  response->set_registered_descriptor_pools(
+      registered_descriptor_pools_->NumSavedStates());
+  response->set_registered_catalogs(registered_catalogs_->NumSavedStates());
+  response->set_prepared_expressions(prepared_expressions_->NumSavedStates());
+  response->set_prepared_queries(prepared_queries_->NumSavedStates());
+  response->set_prepared_modifies(prepared_modifies_->NumSavedStates());
+  descriptor_pool_cache_->GetStats(response);
+  return absl::OkStatus();
+}
+
 size_t ZetaSqlLocalServiceImpl::NumRegisteredDescriptorPools() const {
   return registered_descriptor_pools_->NumSavedStates();
 }
@@ -20,6 +20,7 @@
 #include <stddef.h>
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -35,11 +36,14 @@
 #include "zetasql/public/simple_catalog.h"
 #include "zetasql/public/simple_table.pb.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "zetasql/base/status.h"
 
 namespace zetasql {
 namespace local_service {
 
+class DescriptorPoolCache;
 class InternalPreparedExpressionState;
 class InternalPreparedModifyState;
 class InternalPreparedQueryState;
@@ -51,10 +55,26 @@ class RegisteredCatalogState;
 class RegisteredDescriptorPoolPool;
 class RegisteredDescriptorPoolState;
 
+// Limits on the prepared expressions, queries and modifies, and on the
+// catalogs registered with RegisterCatalog, that a ZetaSqlLocalServiceImpl
+// keeps for its clients. States beyond a limit are evicted as if their client
+// had unprepared or unregistered them. Later calls with the id of an evicted
+// state fail with NOT_FOUND, so that the client can prepare or register it
+// again.
+struct StateRetentionOptions {
+  // States that have not been used for longer than this are evicted.
+  absl::Duration max_idle_time = absl::InfiniteDuration();
+  // The number of states of all kinds together beyond which the least
+  // recently used ones are evicted. 0 means no limit.
+  int64_t max_states = 0;
+};
+
 // Implementation of ZetaSqlLocalService RPC service.
 class ZetaSqlLocalServiceImpl {
  public:
   ZetaSqlLocalServiceImpl();
+  explicit ZetaSqlLocalServiceImpl(
+      const StateRetentionOptions& retention_options);
   ZetaSqlLocalServiceImpl(const ZetaSqlLocalServiceImpl&) = delete;
   ZetaSqlLocalServiceImpl& operator=(const ZetaSqlLocalServiceImpl&) =
       delete;
@@ -65,16 +85,35 @@ class ZetaSqlLocalServiceImpl {
 
   absl::Status Unprepare(int64_t id);
 
+  // The evaluation is aborted with an error once <deadline> has passed.
   absl::Status Evaluate(const EvaluateRequest& request,
-                        EvaluateResponse* response);
+                        EvaluateResponse* response,
+                        absl::Time deadline = absl::InfiniteFuture());
 
   absl::Status PrepareQuery(const PrepareQueryRequest& request,
                             PrepareQueryResponse* response);
 
   absl::Status UnprepareQuery(int64_t id);
 
+  // <deadline> bounds the evaluation and the iteration over the result rows.
   absl::Status EvaluateQuery(const EvaluateQueryRequest& request,
-                             EvaluateQueryResponse* response);
+                             EvaluateQueryResponse* response,
+                             absl::Time deadline = absl::InfiniteFuture());
+
+  // Evaluates the query like EvaluateQuery(), but passes the result to
+  // <write_chunk> in responses of at most request.max_rows_per_chunk rows
+  // each, as soon as the rows are produced, so that the whole result is never
+  // held in memory. Only the first response has the prepared state. The last
+  // response is always written, even if there are no rows. Errors from
+  // <write_chunk> abort the evaluation.
+  absl::Status EvaluateQueryChunked(
+      const EvaluateQueryRequest& request,
+      const std::function<absl::Status(const EvaluateQueryResponse&)>&
+          write_chunk,
+      absl::Time deadline = absl::InfiniteFuture());
+
+  // The chunk size of EvaluateQueryChunked() if the request has none.
+  static constexpr int64_t kDefaultMaxRowsPerChunk = 1024;
 
   absl::Status PrepareModify(const PrepareModifyRequest& request,
                              PrepareModifyResponse* response);
@@ -121,10 +160,13 @@ class ZetaSqlLocalServiceImpl {
       const ExtractTableNamesFromNextStatementRequest& request,
       ExtractTableNamesFromNextStatementResponse* response);
 
+  // If 'statement_summary_only' is true, a resolved statement is serialized
+  // as AnalyzeResponse::statement_summary.
   absl::Status SerializeResolvedOutput(
       const AnalyzerOutput* output,
       const std::vector<const google::protobuf::DescriptorPool*>& pools,
-      absl::string_view statement, AnalyzeResponse* response);
+      absl::string_view statement, bool statement_summary_only,
+      AnalyzeResponse* response);
 
   absl::Status FormatSql(const FormatSqlRequest& request,
                          FormatSqlResponse* response);
@@ -145,6 +187,11 @@ class ZetaSqlLocalServiceImpl {
 
   absl::Status Parse(const ParseRequest& request, ParseResponse* response);
 
+  // Fills in the sizes of the saved states and the descriptor pool cache. The
+  // RPC statistics are added by the gRPC service.
+  absl::Status GetServiceStats(const ServiceStatsRequest& request,
+                               ServiceStatsResponse* response);
+
   absl::Status ParseStatementImpl(const ParseRequest& request,
                                   ParseResponse* response,
                                   ParserOptions& parser_options);
@@ -159,11 +206,15 @@ class ZetaSqlLocalServiceImpl {
   // convenience for calls into the google Deserialize calls..
   // This will _not_ register the returned states, although it will retrieve
   // states based on registered_id as necessary.
+  // If <use_descriptor_pool_cache> is true, pools built from a
+  // file_descriptor_set may be shared with earlier and later calls, so the
+  // caller must not register the returned states.
   absl::Status GetDescriptorPools(
       const DescriptorPoolListProto& descriptor_pool_list,
       std::vector<std::shared_ptr<RegisteredDescriptorPoolState>>&
           pool_states_out,
-      std::vector<const google::protobuf::DescriptorPool*>& descriptor_pools);
+      std::vector<const google::protobuf::DescriptorPool*>& descriptor_pools,
+      bool use_descriptor_pool_cache = false);
 
   // Registers each entry in <descriptor_pool_states> if not already registered
   // and returns a list of the newly registered objects in
@@ -188,6 +239,21 @@ class ZetaSqlLocalServiceImpl {
   std::unique_ptr<PreparedExpressionPool> prepared_expressions_;
   std::unique_ptr<PreparedQueryPool> prepared_queries_;
   std::unique_ptr<PreparedModifyPool> prepared_modifies_;
+  std::unique_ptr<DescriptorPoolCache> descriptor_pool_cache_;
+  const StateRetentionOptions retention_options_;
+  // Held while evicting, so that concurrent registrations don't evict the
+  // same states.
+  absl::Mutex eviction_mutex_;
+
+  // Evicts the states beyond the limits of <retention_options_>. Called
+  // after registering a new state.
+  void EvictStates();
+
+  // Returns NOT_FOUND if <id>, which is not in <pool>, was evicted from it.
+  template <typename StateT>
+  static absl::Status CheckNotEvicted(const SharedStatePool<StateT>& pool,
+                                      int64_t id,
+                                      absl::string_view state_kind);
 
   template <typename InternalStateT>
   absl::Status CreateAndPrepare(
@@ -224,16 +290,23 @@ class ZetaSqlLocalServiceImpl {
       const google::protobuf::Map<std::string, TableContent>& tables_contents,
       std::optional<int64_t>& prepared_statement_id_opt,
       SharedStatePool<InternalStateT>& prepared_statements_pool,
-      absl::string_view statement_type, ResponseT* response);
+      absl::string_view statement_type, absl::Time deadline,
+      const std::function<absl::Status(const ResponseT&)>& write_chunk,
+      ResponseT* response);
 
-  template <typename RequestT, typename ResponseT, typename InternalStateT>
-  absl::Status EvaluatePrepared(const RequestT& request,
-                                ResponseT* internal_state,
-                                InternalStateT* response);
+  // If <write_chunk> is set, the rows of a query are passed to it in chunks
+  // while evaluating, leaving the last chunk in <response>. DML statements are
+  // neither chunked nor bounded by <deadline>, their iterator has no deadline.
+  template <typename RequestT, typename InternalStateT, typename ResponseT>
+  absl::Status EvaluatePrepared(
+      const RequestT& request, InternalStateT* internal_state,
+      absl::Time deadline,
+      const std::function<absl::Status(const ResponseT&)>& write_chunk,
+      ResponseT* response);
 
   absl::Status EvaluatePreparedExpression(
       const EvaluateRequest& request,
-      InternalPreparedExpressionState* internal_state,
+      InternalPreparedExpressionState* internal_state, absl::Time deadline,
       EvaluateResponse* response);
 
   void CleanupDescriptorPools(
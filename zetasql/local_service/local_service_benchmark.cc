@@ -15,15 +15,23 @@
 //
 
 #include <cstdint>
+#include <string>
 
 #include "zetasql/base/logging.h"
+#include "google/protobuf/descriptor.pb.h"
 #include "zetasql/base/testing/status_matchers.h"
 #include "zetasql/local_service/local_service.h"
 #include "zetasql/local_service/local_service.pb.h"
+#include "zetasql/proto/simple_catalog.pb.h"
+#include "zetasql/public/simple_table.pb.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/type.pb.h"
+#include "zetasql/testdata/test_schema.pb.h"
 #include "benchmark/benchmark.h"
 #include "gtest/gtest.h"
 #include "absl/base/internal/sysinfo.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "zetasql/base/status.h"
 
 namespace zetasql {
@@ -54,5 +62,219 @@ static void BM_EvaluatePrepared(::benchmark::State& state) {
 }
 BENCHMARK(BM_EvaluatePrepared)->ThreadRange(1, NumCPUs());
 
+// The benchmarks below take the size of their input as argument, and run
+// with each thread count. Requests that need a catalog use a registered one,
+// so that only the benchmarked RPC is measured.
+
+static ZetaSqlLocalServiceImpl* GetService() {
+  static ZetaSqlLocalServiceImpl* service = new ZetaSqlLocalServiceImpl();
+  return service;
+}
+
+static void ApplyThreadsAndSizes(::benchmark::internal::Benchmark* benchmark) {
+  benchmark->RangeMultiplier(8)->Range(1, 512)->ThreadRange(1, NumCPUs());
+}
+
+// Returns "c0, c1, ..., c<num_columns - 1>".
+static std::string ColumnNames(int64_t num_columns) {
+  std::string names;
+  for (int64_t i = 0; i < num_columns; ++i) {
+    absl::StrAppend(&names, i == 0 ? "" : ", ", "c", i);
+  }
+  return names;
+}
+
+// Registers a catalog with builtin functions and table T with INT64 columns
+// c0 to c<num_columns - 1>, holding <num_rows> rows.
+static int64_t RegisterTableCatalog(int64_t num_columns, int64_t num_rows) {
+  RegisterCatalogRequest request;
+  SimpleCatalogProto* catalog = request.mutable_simple_catalog();
+  catalog->mutable_builtin_function_options();
+  SimpleTableProto* table = catalog->add_table();
+  table->set_name("T");
+  for (int64_t i = 0; i < num_columns; ++i) {
+    SimpleColumnProto* column = table->add_column();
+    column->set_name(absl::StrCat("c", i));
+    column->mutable_type()->set_type_kind(TYPE_INT64);
+  }
+  TableData* table_data = (*request.mutable_table_content())["T"]
+                              .mutable_table_data();
+  for (int64_t row = 0; row < num_rows; ++row) {
+    TableData::Row* table_row = table_data->add_row();
+    for (int64_t i = 0; i < num_columns; ++i) {
+      table_row->add_cell()->set_int64_value(row);
+    }
+  }
+  request.mutable_descriptor_pool_list();
+
+  RegisterResponse response;
+  ZETASQL_CHECK_OK(GetService()->RegisterCatalog(request, &response));
+  return response.registered_id();
+}
+
+// Prepares and unprepares an expression adding up <state.range(0)> literals.
+static void BM_Prepare(::benchmark::State& state) {
+  const int64_t catalog_id = RegisterTableCatalog(1, 0);
+  PrepareRequest request;
+  std::string sql = "1";
+  for (int64_t i = 1; i < state.range(0); ++i) {
+    absl::StrAppend(&sql, " + ", i);
+  }
+  request.set_sql(sql);
+  request.set_registered_catalog_id(catalog_id);
+
+  for (auto s : state) {
+    PrepareResponse response;
+    ZETASQL_ASSERT_OK(GetService()->Prepare(request, &response));
+    ZETASQL_ASSERT_OK(
+        GetService()->Unprepare(response.prepared().prepared_expression_id()));
+  }
+  ZETASQL_ASSERT_OK(GetService()->UnregisterCatalog(catalog_id));
+}
+BENCHMARK(BM_Prepare)->Apply(ApplyThreadsAndSizes);
+
+// Analyzes a query selecting all <state.range(0)> columns of a table.
+static void BM_Analyze(::benchmark::State& state) {
+  const int64_t catalog_id = RegisterTableCatalog(state.range(0), 0);
+  AnalyzeRequest request;
+  request.set_registered_catalog_id(catalog_id);
+  request.set_sql_statement(
+      absl::StrCat("SELECT ", ColumnNames(state.range(0)), " FROM T"));
+
+  for (auto s : state) {
+    AnalyzeResponse response;
+    ZETASQL_ASSERT_OK(GetService()->Analyze(request, &response));
+  }
+  ZETASQL_ASSERT_OK(GetService()->UnregisterCatalog(catalog_id));
+}
+BENCHMARK(BM_Analyze)->Apply(ApplyThreadsAndSizes);
+
+// Prepares and unprepares a query over a table with <state.range(0)> rows.
+static void BM_PrepareQuery(::benchmark::State& state) {
+  const int64_t catalog_id = RegisterTableCatalog(4, state.range(0));
+  PrepareQueryRequest request;
+  request.set_registered_catalog_id(catalog_id);
+  request.set_sql("SELECT c0, c1 + c2 AS c FROM T WHERE c3 >= 0");
+
+  for (auto s : state) {
+    PrepareQueryResponse response;
+    ZETASQL_ASSERT_OK(GetService()->PrepareQuery(request, &response));
+    ZETASQL_ASSERT_OK(
+        GetService()->UnprepareQuery(response.prepared().prepared_query_id()));
+  }
+  ZETASQL_ASSERT_OK(GetService()->UnregisterCatalog(catalog_id));
+}
+BENCHMARK(BM_PrepareQuery)->Apply(ApplyThreadsAndSizes);
+
+// Evaluates a prepared query over a table with <state.range(0)> rows.
+static void BM_EvaluateQuery(::benchmark::State& state) {
+  const int64_t catalog_id = RegisterTableCatalog(4, state.range(0));
+  PrepareQueryRequest prepare_request;
+  prepare_request.set_registered_catalog_id(catalog_id);
+  prepare_request.set_sql("SELECT c0, c1 + c2 AS c FROM T WHERE c3 >= 0");
+  PrepareQueryResponse prepare_response;
+  ZETASQL_ASSERT_OK(
+      GetService()->PrepareQuery(prepare_request, &prepare_response));
+  const int64_t prepared_query_id =
+      prepare_response.prepared().prepared_query_id();
+
+  EvaluateQueryRequest request;
+  request.set_prepared_query_id(prepared_query_id);
+  for (auto s : state) {
+    EvaluateQueryResponse response;
+    ZETASQL_ASSERT_OK(GetService()->EvaluateQuery(request, &response));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  ZETASQL_ASSERT_OK(GetService()->UnprepareQuery(prepared_query_id));
+  ZETASQL_ASSERT_OK(GetService()->UnregisterCatalog(catalog_id));
+}
+BENCHMARK(BM_EvaluateQuery)->Apply(ApplyThreadsAndSizes);
+
+// Registers and unregisters a catalog with <state.range(0)> tables and as many
+// copies of the KitchenSinkPB descriptor pool.
+static void BM_RegisterCatalog(::benchmark::State& state) {
+  google::protobuf::FileDescriptorSet kitchen_sink_files;
+  {
+    TypeFactory factory;
+    const ProtoType* proto_type = nullptr;
+    ZETASQL_ASSERT_OK(factory.MakeProtoType(
+        zetasql_test__::KitchenSinkPB::descriptor(), &proto_type));
+    TypeProto ignored;
+    ZETASQL_ASSERT_OK(proto_type->SerializeToProtoAndFileDescriptors(
+        &ignored, &kitchen_sink_files));
+  }
+
+  RegisterCatalogRequest request;
+  SimpleCatalogProto* catalog = request.mutable_simple_catalog();
+  catalog->mutable_builtin_function_options();
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    SimpleTableProto* table = catalog->add_table();
+    table->set_name(absl::StrCat("T", i));
+    SimpleColumnProto* column = table->add_column();
+    column->set_name("c");
+    column->mutable_type()->set_type_kind(TYPE_INT64);
+    *request.mutable_descriptor_pool_list()
+         ->add_definitions()
+         ->mutable_file_descriptor_set() = kitchen_sink_files;
+  }
+
+  for (auto s : state) {
+    RegisterResponse response;
+    ZETASQL_ASSERT_OK(GetService()->RegisterCatalog(request, &response));
+    ZETASQL_ASSERT_OK(
+        GetService()->UnregisterCatalog(response.registered_id()));
+  }
+}
+BENCHMARK(BM_RegisterCatalog)
+    ->RangeMultiplier(4)
+    ->Range(1, 64)
+    ->ThreadRange(1, NumCPUs());
+
+// Builds SQL for an analyzed query selecting <state.range(0)> columns.
+static void BM_BuildSql(::benchmark::State& state) {
+  const int64_t catalog_id = RegisterTableCatalog(state.range(0), 0);
+  AnalyzeRequest analyze_request;
+  analyze_request.set_registered_catalog_id(catalog_id);
+  analyze_request.set_sql_statement(
+      absl::StrCat("SELECT ", ColumnNames(state.range(0)), " FROM T"));
+  AnalyzeResponse analyze_response;
+  ZETASQL_ASSERT_OK(GetService()->Analyze(analyze_request, &analyze_response));
+
+  BuildSqlRequest request;
+  request.set_registered_catalog_id(catalog_id);
+  *request.mutable_resolved_statement() =
+      analyze_response.resolved_statement();
+  for (auto s : state) {
+    BuildSqlResponse response;
+    ZETASQL_ASSERT_OK(GetService()->BuildSql(request, &response));
+  }
+  ZETASQL_ASSERT_OK(GetService()->UnregisterCatalog(catalog_id));
+}
+BENCHMARK(BM_BuildSql)->Apply(ApplyThreadsAndSizes);
+
+// Formats a query selecting <state.range(0)> columns.
+static void BM_FormatSql(::benchmark::State& state) {
+  FormatSqlRequest request;
+  request.set_sql(absl::StrCat("select ", ColumnNames(state.range(0)),
+                               " from T where c0 > 1 order by c0"));
+  for (auto s : state) {
+    FormatSqlResponse response;
+    ZETASQL_ASSERT_OK(GetService()->FormatSql(request, &response));
+  }
+}
+BENCHMARK(BM_FormatSql)->Apply(ApplyThreadsAndSizes);
+
+// Parses a query selecting <state.range(0)> columns.
+static void BM_Parse(::benchmark::State& state) {
+  ParseRequest request;
+  request.set_sql_statement(
+      absl::StrCat("SELECT ", ColumnNames(state.range(0)), " FROM T"));
+  for (auto s : state) {
+    ParseResponse response;
+    ZETASQL_ASSERT_OK(GetService()->Parse(request, &response));
+  }
+}
+BENCHMARK(BM_Parse)->Apply(ApplyThreadsAndSizes);
+
 }  // namespace local_service
 }  // namespace zetasql
@@ -16,6 +16,20 @@
 
 #include "zetasql/local_service/local_service_grpc.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+
+#include "google/protobuf/descriptor.h"
+#include "zetasql/base/check.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "zetasql/base/map_util.h"
 #include "zetasql/base/status.h"
 
 namespace zetasql {
@@ -80,38 +94,161 @@ grpc::Status ToGrpcStatus(absl::Status status) {
   return grpc::Status(grpc_code, std::string(status.message()), "");
 }
 
+absl::Time GetDeadline(const grpc::ServerContext* context) {
+  const std::chrono::system_clock::time_point deadline = context->deadline();
+  if (deadline == std::chrono::system_clock::time_point::max()) {
+    return absl::InfiniteFuture();
+  }
+  return absl::FromChrono(deadline);
+}
+
+// Counts one evaluation RPC as running while alive, if fewer than <limit> were
+// running already. A <limit> of 0 admits every call.
+class ScopedEvaluationAdmission {
+ public:
+  ScopedEvaluationAdmission(std::atomic<int>& running_evaluations, int limit)
+      : running_evaluations_(running_evaluations) {
+    const int running =
+        running_evaluations_.fetch_add(1, std::memory_order_relaxed);
+    if (limit > 0 && running >= limit) {
+      running_evaluations_.fetch_sub(1, std::memory_order_relaxed);
+      admitted_ = false;
+    }
+  }
+  ScopedEvaluationAdmission(const ScopedEvaluationAdmission&) = delete;
+  ScopedEvaluationAdmission& operator=(const ScopedEvaluationAdmission&) =
+      delete;
+  ~ScopedEvaluationAdmission() {
+    if (admitted_) {
+      running_evaluations_.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+
+  bool admitted() const { return admitted_; }
+
+  static grpc::Status RejectedStatus() {
+    return grpc::Status(grpc::RESOURCE_EXHAUSTED,
+                        "Too many concurrent evaluations in the ZetaSQL local "
+                        "service");
+  }
+
+ private:
+  std::atomic<int>& running_evaluations_;
+  bool admitted_ = true;
+};
+
+// Times one call of an RPC. Finish() records its outcome in <stats>.
+class RpcTimer {
+ public:
+  explicit RpcTimer(RpcStats& stats) : stats_(stats), start_(absl::Now()) {}
+  RpcTimer(const RpcTimer&) = delete;
+  RpcTimer& operator=(const RpcTimer&) = delete;
+
+  grpc::Status Finish(grpc::Status status) {
+    stats_.Record(status, absl::Now() - start_);
+    return status;
+  }
+
+ private:
+  RpcStats& stats_;
+  const absl::Time start_;
+};
+
 }  // namespace
 
+void RpcStats::Record(const grpc::Status& status, absl::Duration latency) {
+  const int64_t micros = absl::ToInt64Microseconds(latency);
+  call_count_.fetch_add(1, std::memory_order_relaxed);
+  if (!status.ok()) {
+    error_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+  total_latency_micros_.fetch_add(micros, std::memory_order_relaxed);
+  const auto bucket =
+      std::lower_bound(kLatencyBucketUpperBoundsMicros.begin(),
+                       kLatencyBucketUpperBoundsMicros.end(), micros);
+  latency_bucket_count_[std::distance(kLatencyBucketUpperBoundsMicros.begin(),
+                                      bucket)]
+      .fetch_add(1, std::memory_order_relaxed);
+}
+
+void RpcStats::Serialize(absl::string_view method,
+                         ServiceStatsResponse::RpcStats* proto) const {
+  proto->set_method(std::string(method));
+  proto->set_call_count(call_count_.load(std::memory_order_relaxed));
+  proto->set_error_count(error_count_.load(std::memory_order_relaxed));
+  proto->set_total_latency_micros(
+      total_latency_micros_.load(std::memory_order_relaxed));
+  for (const std::atomic<int64_t>& count : latency_bucket_count_) {
+    proto->add_latency_bucket_count(count.load(std::memory_order_relaxed));
+  }
+}
+
+ZetaSqlLocalServiceGrpcImpl::ZetaSqlLocalServiceGrpcImpl(
+    int max_concurrent_evaluations,
+    const StateRetentionOptions& retention_options)
+    : service_(retention_options),
+      max_concurrent_evaluations_(max_concurrent_evaluations) {
+  const google::protobuf::ServiceDescriptor* service_descriptor =
+      google::protobuf::DescriptorPool::generated_pool()->FindServiceByName(
+          ZetaSqlLocalService::service_full_name());
+  ABSL_CHECK(service_descriptor != nullptr);
+  for (int i = 0; i < service_descriptor->method_count(); ++i) {
+    rpc_stats_.emplace(service_descriptor->method(i)->name(),
+                       std::make_unique<RpcStats>());
+  }
+}
+
+RpcStats& ZetaSqlLocalServiceGrpcImpl::GetRpcStats(absl::string_view method) {
+  return *zetasql_base::FindOrDie(rpc_stats_, method);
+}
+
 grpc::Status ZetaSqlLocalServiceGrpcImpl::Prepare(
     grpc::ServerContext* context, const PrepareRequest* req,
     PrepareResponse* resp) {
-  return ToGrpcStatus(service_.Prepare(*req, resp));
+  RpcTimer timer(GetRpcStats("Prepare"));
+  return timer.Finish(ToGrpcStatus(service_.Prepare(*req, resp)));
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::Unprepare(
     grpc::ServerContext* context, const UnprepareRequest* req,
     google::protobuf::Empty* unused) {
-  return ToGrpcStatus(service_.Unprepare(req->prepared_expression_id()));
+  RpcTimer timer(GetRpcStats("Unprepare"));
+  return timer.Finish(
+      ToGrpcStatus(service_.Unprepare(req->prepared_expression_id())));
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::Evaluate(
     grpc::ServerContext* context, const EvaluateRequest* req,
     EvaluateResponse* resp) {
-  return ToGrpcStatus(service_.Evaluate(*req, resp));
+  RpcTimer timer(GetRpcStats("Evaluate"));
+  ScopedEvaluationAdmission admission(running_evaluations_,
+                                      max_concurrent_evaluations_);
+  if (!admission.admitted()) {
+    return timer.Finish(ScopedEvaluationAdmission::RejectedStatus());
+  }
+  return timer.Finish(
+      ToGrpcStatus(service_.Evaluate(*req, resp, GetDeadline(context))));
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::EvaluateStream(
     grpc::ServerContext* context,
     grpc::ServerReaderWriter<EvaluateResponseBatch, EvaluateRequestBatch>*
         stream) {
+  RpcTimer timer(GetRpcStats("EvaluateStream"));
+  ScopedEvaluationAdmission admission(running_evaluations_,
+                                      max_concurrent_evaluations_);
+  if (!admission.admitted()) {
+    return timer.Finish(ScopedEvaluationAdmission::RejectedStatus());
+  }
+  const absl::Time deadline = GetDeadline(context);
   EvaluateRequestBatch reqb;
   while (stream->Read(&reqb)) {
     EvaluateResponseBatch respb;
     for (const auto& req : reqb.request()) {
       EvaluateResponse* resp = respb.add_response();
-      auto status = service_.Evaluate(req, resp);
+      auto status = service_.Evaluate(req, resp, deadline);
       if (!status.ok()) {
-        return ToGrpcStatus(status);
+        return timer.Finish(ToGrpcStatus(status));
       }
       if (respb.response_size() > 1 &&
           respb.ByteSizeLong() > GRPC_DEFAULT_MAX_RECV_MESSAGE_LENGTH) {
@@ -125,39 +262,56 @@ grpc::Status ZetaSqlLocalServiceGrpcImpl::EvaluateStream(
     }
     stream->Write(respb);
   }
-  return grpc::Status();
+  return timer.Finish(grpc::Status());
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::PrepareQuery(
     grpc::ServerContext* context, const PrepareQueryRequest* req,
     PrepareQueryResponse* resp) {
-  return ToGrpcStatus(service_.PrepareQuery(*req, resp));
+  RpcTimer timer(GetRpcStats("PrepareQuery"));
+  return timer.Finish(ToGrpcStatus(service_.PrepareQuery(*req, resp)));
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::UnprepareQuery(
     grpc::ServerContext* context, const UnprepareQueryRequest* req,
     google::protobuf::Empty* unused) {
-  return ToGrpcStatus(service_.UnprepareQuery(req->prepared_query_id()));
+  RpcTimer timer(GetRpcStats("UnprepareQuery"));
+  return timer.Finish(
+      ToGrpcStatus(service_.UnprepareQuery(req->prepared_query_id())));
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::EvaluateQuery(
     grpc::ServerContext* context, const EvaluateQueryRequest* req,
     EvaluateQueryResponse* resp) {
-  return ToGrpcStatus(service_.EvaluateQuery(*req, resp));
+  RpcTimer timer(GetRpcStats("EvaluateQuery"));
+  ScopedEvaluationAdmission admission(running_evaluations_,
+                                      max_concurrent_evaluations_);
+  if (!admission.admitted()) {
+    return timer.Finish(ScopedEvaluationAdmission::RejectedStatus());
+  }
+  return timer.Finish(ToGrpcStatus(
+      service_.EvaluateQuery(*req, resp, GetDeadline(context))));
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::EvaluateQueryStream(
     grpc::ServerContext* context,
     grpc::ServerReaderWriter<EvaluateQueryBatchResponse,
                              EvaluateQueryBatchRequest>* stream) {
+  RpcTimer timer(GetRpcStats("EvaluateQueryStream"));
+  ScopedEvaluationAdmission admission(running_evaluations_,
+                                      max_concurrent_evaluations_);
+  if (!admission.admitted()) {
+    return timer.Finish(ScopedEvaluationAdmission::RejectedStatus());
+  }
+  const absl::Time deadline = GetDeadline(context);
   EvaluateQueryBatchRequest reqb;
   while (stream->Read(&reqb)) {
     EvaluateQueryBatchResponse respb;
     for (const auto& req : reqb.request()) {
       EvaluateQueryResponse* resp = respb.add_response();
-      auto status = service_.EvaluateQuery(req, resp);
+      auto status = service_.EvaluateQuery(req, resp, deadline);
       if (!status.ok()) {
-        return ToGrpcStatus(status);
+        return timer.Finish(ToGrpcStatus(status));
       }
       if (respb.response_size() > 1 &&
           respb.ByteSizeLong() > GRPC_DEFAULT_MAX_RECV_MESSAGE_LENGTH) {
@@ -171,31 +325,67 @@ grpc::Status ZetaSqlLocalServiceGrpcImpl::EvaluateQueryStream(
     }
     stream->Write(respb);
   }
-  return grpc::Status();
+  return timer.Finish(grpc::Status());
+}
+
+grpc::Status ZetaSqlLocalServiceGrpcImpl::EvaluateQueryChunked(
+    grpc::ServerContext* context, const EvaluateQueryRequest* req,
+    grpc::ServerWriter<EvaluateQueryResponse>* writer) {
+  RpcTimer timer(GetRpcStats("EvaluateQueryChunked"));
+  ScopedEvaluationAdmission admission(running_evaluations_,
+                                      max_concurrent_evaluations_);
+  if (!admission.admitted()) {
+    return timer.Finish(ScopedEvaluationAdmission::RejectedStatus());
+  }
+  // Write() blocks until the previous chunks have been sent, which keeps the
+  // evaluation from running ahead of a slow client.
+  auto write_chunk = [writer](const EvaluateQueryResponse& chunk) {
+    if (!writer->Write(chunk)) {
+      return absl::CancelledError("The client stopped reading the result");
+    }
+    return absl::OkStatus();
+  };
+  return timer.Finish(ToGrpcStatus(
+      service_.EvaluateQueryChunked(*req, write_chunk, GetDeadline(context))));
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::PrepareModify(
     grpc::ServerContext* context, const PrepareModifyRequest* req,
     PrepareModifyResponse* resp) {
-  return ToGrpcStatus(service_.PrepareModify(*req, resp));
+  RpcTimer timer(GetRpcStats("PrepareModify"));
+  return timer.Finish(ToGrpcStatus(service_.PrepareModify(*req, resp)));
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::UnprepareModify(
     grpc::ServerContext* context, const UnprepareModifyRequest* req,
     google::protobuf::Empty* unused) {
-  return ToGrpcStatus(service_.UnprepareModify(req->prepared_modify_id()));
+  RpcTimer timer(GetRpcStats("UnprepareModify"));
+  return timer.Finish(
+      ToGrpcStatus(service_.UnprepareModify(req->prepared_modify_id())));
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::EvaluateModify(
     grpc::ServerContext* context, const EvaluateModifyRequest* req,
     EvaluateModifyResponse* resp) {
-  return ToGrpcStatus(service_.EvaluateModify(*req, resp));
+  RpcTimer timer(GetRpcStats("EvaluateModify"));
+  ScopedEvaluationAdmission admission(running_evaluations_,
+                                      max_concurrent_evaluations_);
+  if (!admission.admitted()) {
+    return timer.Finish(ScopedEvaluationAdmission::RejectedStatus());
+  }
+  return timer.Finish(ToGrpcStatus(service_.EvaluateModify(*req, resp)));
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::EvaluateModifyStream(
     grpc::ServerContext* context,
     grpc::ServerReaderWriter<EvaluateModifyBatchResponse,
                              EvaluateModifyBatchRequest>* stream) {
+  RpcTimer timer(GetRpcStats("EvaluateModifyStream"));
+  ScopedEvaluationAdmission admission(running_evaluations_,
+                                      max_concurrent_evaluations_);
+  if (!admission.admitted()) {
+    return timer.Finish(ScopedEvaluationAdmission::RejectedStatus());
+  }
   EvaluateModifyBatchRequest reqb;
   while (stream->Read(&reqb)) {
     EvaluateModifyBatchResponse respb;
@@ -203,7 +393,7 @@ grpc::Status ZetaSqlLocalServiceGrpcImpl::EvaluateModifyStream(
       EvaluateModifyResponse* resp = respb.add_response();
       auto status = service_.EvaluateModify(req, resp);
       if (!status.ok()) {
-        return ToGrpcStatus(status);
+        return timer.Finish(ToGrpcStatus(status));
       }
       if (respb.response_size() > 1 &&
           respb.ByteSizeLong() > GRPC_DEFAULT_MAX_RECV_MESSAGE_LENGTH) {
@@ -217,88 +407,122 @@ grpc::Status ZetaSqlLocalServiceGrpcImpl::EvaluateModifyStream(
     }
     stream->Write(respb);
   }
-  return grpc::Status();
+  return timer.Finish(grpc::Status());
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::GetTableFromProto(
     grpc::ServerContext* context, const TableFromProtoRequest* req,
     SimpleTableProto* resp) {
-  return ToGrpcStatus(service_.GetTableFromProto(*req, resp));
+  RpcTimer timer(GetRpcStats("GetTableFromProto"));
+  return timer.Finish(ToGrpcStatus(service_.GetTableFromProto(*req, resp)));
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::Analyze(
     grpc::ServerContext* context, const AnalyzeRequest* req,
     AnalyzeResponse* resp) {
-  return ToGrpcStatus(service_.Analyze(*req, resp));
+  RpcTimer timer(GetRpcStats("Analyze"));
+  return timer.Finish(ToGrpcStatus(service_.Analyze(*req, resp)));
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::BuildSql(
     grpc::ServerContext* context, const BuildSqlRequest* req,
     BuildSqlResponse* resp) {
-  return ToGrpcStatus(service_.BuildSql(*req, resp));
+  RpcTimer timer(GetRpcStats("BuildSql"));
+  return timer.Finish(ToGrpcStatus(service_.BuildSql(*req, resp)));
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::ExtractTableNamesFromStatement(
     grpc::ServerContext* context,
     const ExtractTableNamesFromStatementRequest* req,
     ExtractTableNamesFromStatementResponse* resp) {
-  return ToGrpcStatus(service_.ExtractTableNamesFromStatement(*req, resp));
+  RpcTimer timer(GetRpcStats("ExtractTableNamesFromStatement"));
+  return timer.Finish(
+      ToGrpcStatus(service_.ExtractTableNamesFromStatement(*req, resp)));
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::ExtractTableNamesFromNextStatement(
     grpc::ServerContext* context,
     const ExtractTableNamesFromNextStatementRequest* req,
     ExtractTableNamesFromNextStatementResponse* resp) {
-  return ToGrpcStatus(service_.ExtractTableNamesFromNextStatement(*req, resp));
+  RpcTimer timer(GetRpcStats("ExtractTableNamesFromNextStatement"));
+  return timer.Finish(
+      ToGrpcStatus(service_.ExtractTableNamesFromNextStatement(*req, resp)));
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::FormatSql(
     grpc::ServerContext* context, const FormatSqlRequest* req,
     FormatSqlResponse* resp) {
-  return ToGrpcStatus(service_.FormatSql(*req, resp));
+  RpcTimer timer(GetRpcStats("FormatSql"));
+  return timer.Finish(ToGrpcStatus(service_.FormatSql(*req, resp)));
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::LenientFormatSql(
     grpc::ServerContext* context, const FormatSqlRequest* req,
     FormatSqlResponse* resp) {
-  return ToGrpcStatus(service_.LenientFormatSql(*req, resp));
+  RpcTimer timer(GetRpcStats("LenientFormatSql"));
+  return timer.Finish(ToGrpcStatus(service_.LenientFormatSql(*req, resp)));
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::RegisterCatalog(
     grpc::ServerContext* context, const RegisterCatalogRequest* req,
     RegisterResponse* resp) {
-  return ToGrpcStatus(service_.RegisterCatalog(*req, resp));
+  RpcTimer timer(GetRpcStats("RegisterCatalog"));
+  return timer.Finish(ToGrpcStatus(service_.RegisterCatalog(*req, resp)));
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::UnregisterCatalog(
     grpc::ServerContext* context, const UnregisterRequest* req,
     google::protobuf::Empty* unused) {
-  return ToGrpcStatus(service_.UnregisterCatalog(req->registered_id()));
+  RpcTimer timer(GetRpcStats("UnregisterCatalog"));
+  return timer.Finish(
+      ToGrpcStatus(service_.UnregisterCatalog(req->registered_id())));
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::GetBuiltinFunctions(
     grpc::ServerContext* context,
     const ZetaSQLBuiltinFunctionOptionsProto* options,
     GetBuiltinFunctionsResponse* resp) {
-  return ToGrpcStatus(service_.GetBuiltinFunctions(*options, resp));
+  RpcTimer timer(GetRpcStats("GetBuiltinFunctions"));
+  return timer.Finish(
+      ToGrpcStatus(service_.GetBuiltinFunctions(*options, resp)));
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::GetLanguageOptions(
     grpc::ServerContext* context, const LanguageOptionsRequest* req,
     LanguageOptionsProto* resp) {
-  return ToGrpcStatus(service_.GetLanguageOptions(*req, resp));
+  RpcTimer timer(GetRpcStats("GetLanguageOptions"));
+  return timer.Finish(ToGrpcStatus(service_.GetLanguageOptions(*req, resp)));
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::GetAnalyzerOptions(
     grpc::ServerContext* context, const AnalyzerOptionsRequest* req,
     AnalyzerOptionsProto* resp) {
-  return ToGrpcStatus(service_.GetAnalyzerOptions(*req, resp));
+  RpcTimer timer(GetRpcStats("GetAnalyzerOptions"));
+  return timer.Finish(ToGrpcStatus(service_.GetAnalyzerOptions(*req, resp)));
 }
 
 grpc::Status ZetaSqlLocalServiceGrpcImpl::Parse(
     grpc::ServerContext* context, const ParseRequest* req,
     ParseResponse* resp) {
-  return ToGrpcStatus(service_.Parse(*req, resp));
+  RpcTimer timer(GetRpcStats("Parse"));
+  return timer.Finish(ToGrpcStatus(service_.Parse(*req, resp)));
+}
+
+grpc::Status ZetaSqlLocalServiceGrpcImpl::GetServiceStats(
+    grpc::ServerContext* context, const ServiceStatsRequest* req,
+    ServiceStatsResponse* resp) {
+  RpcTimer timer(GetRpcStats("GetServiceStats"));
+  for (int64_t bound : RpcStats::kLatencyBucketUpperBoundsMicros) {
+    resp->add_latency_bucket_upper_bound_micros(bound);
+  }
+  for (const auto& [method, stats] : rpc_stats_) {
+    if (stats->call_count() > 0) {
+      stats->Serialize(method, resp->add_rpc_stats());
+    }
+  }
+  resp->set_running_evaluations(
+      running_evaluations_.load(std::memory_order_relaxed));
+  return timer.Finish(ToGrpcStatus(service_.GetServiceStats(*req, resp)));
 }
 
 }  // namespace local_service
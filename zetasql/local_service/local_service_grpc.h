@@ -17,20 +17,73 @@
 #ifndef ZETASQL_LOCAL_SERVICE_LOCAL_SERVICE_GRPC_H_
 #define ZETASQL_LOCAL_SERVICE_LOCAL_SERVICE_GRPC_H_
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
 #include "zetasql/local_service/local_service.grpc.pb.h"
 #include "zetasql/local_service/local_service.h"
 #include "zetasql/local_service/local_service.pb.h"
 #include "zetasql/proto/options.pb.h"
 #include "zetasql/public/parse_resume_location.pb.h"
 #include "zetasql/public/simple_table.pb.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 
 namespace zetasql {
 namespace local_service {
 
+// The number of calls, errors and a latency histogram of one RPC method.
+// Thread safe.
+class RpcStats {
+ public:
+  static constexpr std::array<int64_t, 10> kLatencyBucketUpperBoundsMicros = {
+      100, 300, 1000, 3000, 10000, 30000, 100000, 300000, 1000000, 10000000};
+
+  void Record(const grpc::Status& status, absl::Duration latency);
+
+  void Serialize(absl::string_view method,
+                 ServiceStatsResponse::RpcStats* proto) const;
+
+  int64_t call_count() const {
+    return call_count_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<int64_t> call_count_{0};
+  std::atomic<int64_t> error_count_{0};
+  std::atomic<int64_t> total_latency_micros_{0};
+  // One more than the bounds, for the calls above all bounds.
+  std::array<std::atomic<int64_t>,
+             kLatencyBucketUpperBoundsMicros.size() + 1>
+      latency_bucket_count_{};
+};
+
 // Implementation of ZetaSqlLocalService Grpc RPC service.
+//
+// The evaluation RPCs honor the deadline of their ServerContext, so that an
+// expired call stops evaluating and releases its server thread.
+//
+// The calls of every RPC are counted and timed, see GetServiceStats.
 class ZetaSqlLocalServiceGrpcImpl
     : public ZetaSqlLocalService::Service {
  public:
+  // <max_concurrent_evaluations> bounds the number of Evaluate,
+  // EvaluateQuery and EvaluateModify calls, including the streaming ones, that
+  // run at the same time. Calls beyond it fail with RESOURCE_EXHAUSTED rather
+  // than tying up another server thread, so that a burst of long evaluations
+  // can't starve the other RPCs. 0 means no limit.
+  //
+  // <retention_options> bounds the prepared and registered states that the
+  // service keeps for its clients.
+  explicit ZetaSqlLocalServiceGrpcImpl(
+      int max_concurrent_evaluations = 0,
+      const StateRetentionOptions& retention_options =
+          StateRetentionOptions());
+
   grpc::Status Prepare(grpc::ServerContext* context, const PrepareRequest* req,
                        PrepareResponse* resp) override;
 
@@ -64,6 +117,10 @@ class ZetaSqlLocalServiceGrpcImpl
       grpc::ServerReaderWriter<EvaluateQueryBatchResponse,
                                EvaluateQueryBatchRequest>* stream) override;
 
+  grpc::Status EvaluateQueryChunked(
+      grpc::ServerContext* context, const EvaluateQueryRequest* req,
+      grpc::ServerWriter<EvaluateQueryResponse>* writer) override;
+
   grpc::Status PrepareModify(grpc::ServerContext* context,
                              const PrepareModifyRequest* req,
                              PrepareModifyResponse* resp) override;
@@ -135,8 +192,24 @@ class ZetaSqlLocalServiceGrpcImpl
                      const ParseRequest* req,
                      ParseResponse* resp) override;
 
+  grpc::Status GetServiceStats(grpc::ServerContext* context,
+                               const ServiceStatsRequest* req,
+                               ServiceStatsResponse* resp) override;
+
+  // The service the RPCs are forwarded to. For in-process callers that bypass
+  // gRPC, like the direct JNI calls, and share its prepared state.
+  ZetaSqlLocalServiceImpl& service() { return service_; }
+
  private:
+  // Returns the stats of <method>, which must be an RPC of the service.
+  RpcStats& GetRpcStats(absl::string_view method);
+
   ZetaSqlLocalServiceImpl service_;
+  const int max_concurrent_evaluations_;
+  std::atomic<int> running_evaluations_{0};
+  // One entry per RPC method, created by the constructor and never modified
+  // afterwards, so that it can be read without locking.
+  absl::flat_hash_map<std::string, std::unique_ptr<RpcStats>> rpc_stats_;
 };
 
 }  // namespace local_service
@@ -19,7 +19,9 @@
 #include <grpcpp/server.h>
 #include <grpcpp/server_builder.h>
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 #include "zetasql/base/testing/status_matchers.h"
 #include "zetasql/local_service/local_service.grpc.pb.h"
@@ -122,6 +124,64 @@ TEST_F(ZetaSqlLocalServiceGrpcImplTest, EvaluateStreamPreparedBigResponse) {
   EXPECT_OK_GRPC(stream->Finish());
 }
 
+TEST_F(ZetaSqlLocalServiceGrpcImplTest, EvaluateQueryChunked) {
+  grpc::ChannelArguments channel_args;
+  std::unique_ptr<ZetaSqlLocalService::Stub> stub(
+      ZetaSqlLocalService::NewStub(
+          server_->InProcessChannel(channel_args)));
+
+  EvaluateQueryRequest request;
+  request.set_sql("SELECT x FROM UNNEST([1, 2, 3, 4, 5, 6, 7, 8, 9, 10]) AS x");
+  request.set_max_rows_per_chunk(4);
+
+  grpc::ClientContext context;
+  std::unique_ptr<grpc::ClientReader<EvaluateQueryResponse>> reader =
+      stub->EvaluateQueryChunked(&context, request);
+
+  std::vector<int> chunk_sizes;
+  EvaluateQueryResponse response;
+  while (reader->Read(&response)) {
+    chunk_sizes.push_back(response.content().table_data().row_size());
+  }
+  EXPECT_OK_GRPC(reader->Finish());
+  EXPECT_THAT(chunk_sizes, testing::ElementsAre(4, 4, 2));
+}
+
+TEST_F(ZetaSqlLocalServiceGrpcImplTest, GetServiceStats) {
+  grpc::ChannelArguments channel_args;
+  std::unique_ptr<ZetaSqlLocalService::Stub> stub(
+      ZetaSqlLocalService::NewStub(
+          server_->InProcessChannel(channel_args)));
+
+  for (const char* sql : {"1", "1 +"}) {
+    grpc::ClientContext context;
+    EvaluateRequest request;
+    request.set_sql(sql);
+    EvaluateResponse response;
+    stub->Evaluate(&context, request, &response);
+  }
+
+  grpc::ClientContext context;
+  ServiceStatsResponse stats;
+  EXPECT_OK_GRPC(
+      stub->GetServiceStats(&context, ServiceStatsRequest(), &stats));
+  EXPECT_EQ(stats.latency_bucket_upper_bound_micros_size(),
+            RpcStats::kLatencyBucketUpperBoundsMicros.size());
+  EXPECT_EQ(stats.running_evaluations(), 0);
+  ASSERT_EQ(stats.rpc_stats_size(), 1);
+  const ServiceStatsResponse::RpcStats& evaluate_stats = stats.rpc_stats(0);
+  EXPECT_EQ(evaluate_stats.method(), "Evaluate");
+  EXPECT_EQ(evaluate_stats.call_count(), 2);
+  EXPECT_EQ(evaluate_stats.error_count(), 1);
+  ASSERT_EQ(evaluate_stats.latency_bucket_count_size(),
+            stats.latency_bucket_upper_bound_micros_size() + 1);
+  int64_t bucketed_calls = 0;
+  for (int64_t count : evaluate_stats.latency_bucket_count()) {
+    bucketed_calls += count;
+  }
+  EXPECT_EQ(bucketed_calls, 2);
+}
+
 }  // namespace
 
 }  // namespace zetasql::local_service
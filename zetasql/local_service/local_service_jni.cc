@@ -18,6 +18,7 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <grpcpp/resource_quota.h>
 #include <grpcpp/server.h>
 #include <grpcpp/server_builder.h>
 #include <grpcpp/server_posix.h>
@@ -25,21 +26,56 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <cstdint>
 #include <memory>
+#include <string>
 
+#include "zetasql/local_service/local_service.h"
+#include "zetasql/local_service/local_service.pb.h"
 #include "zetasql/local_service/local_service_grpc.h"
+#include "absl/status/status.h"
+#include "absl/strings/numbers.h"
+#include "absl/time/time.h"
 
 namespace zetasql {
 namespace local_service {
 namespace {
 
+// Limits of the server, from the system properties
+// zetasql.local_service.max_threads,
+// zetasql.local_service.max_concurrent_evaluations,
+// zetasql.local_service.max_idle_seconds and
+// zetasql.local_service.max_states, read in JNI_OnLoad. 0 means no limit.
+static int max_server_threads = 0;
+static int max_concurrent_evaluations = 0;
+static int max_state_idle_seconds = 0;
+static int max_states = 0;
+
+static ZetaSqlLocalServiceGrpcImpl* GetGrpcService() {
+  // The service must remain for the lifetime of the server.
+  static ZetaSqlLocalServiceGrpcImpl* service = []() {
+    StateRetentionOptions retention_options;
+    if (max_state_idle_seconds > 0) {
+      retention_options.max_idle_time = absl::Seconds(max_state_idle_seconds);
+    }
+    retention_options.max_states = max_states;
+    return new ZetaSqlLocalServiceGrpcImpl(max_concurrent_evaluations,
+                                           retention_options);
+  }();
+  return service;
+}
+
 static grpc::Server* GetServer() {
   static grpc::Server* server = []() {
-    // The service must remain for the lifetime of the server.
-    static ZetaSqlLocalServiceGrpcImpl* service =
-        new ZetaSqlLocalServiceGrpcImpl();
     grpc::ServerBuilder builder;
-    builder.RegisterService(service);
+    builder.RegisterService(GetGrpcService());
+    if (max_server_threads > 0) {
+      // Bounds the threads of the synchronous server. gRPC rejects calls with
+      // RESOURCE_EXHAUSTED while all of them are busy.
+      grpc::ResourceQuota quota("zetasql_local_service");
+      quota.SetMaxThreads(max_server_threads);
+      builder.SetResourceQuota(quota);
+    }
     return builder.BuildAndStart().release();
   }();
   return server;
@@ -86,6 +122,102 @@ static int GetSocketFd(JNIEnv* env) {
   return sv[1];
 }
 
+static void ThrowIllegalArgumentException(JNIEnv* env, const char* message) {
+  jclass e = env->FindClass("java/lang/IllegalArgumentException");
+  if (e == nullptr) {
+    return;
+  }
+  env->ThrowNew(e, message);
+}
+
+// JniChannelProvider.DirectCallException, looked up in JNI_OnLoad, because its
+// name depends on the name of the class the natives are registered for.
+static jclass direct_call_exception_class = nullptr;
+
+// Throws a DirectCallException for the non-OK 'status'. Its code is the
+// canonical code of 'status', same as over gRPC.
+static void ThrowDirectCallException(JNIEnv* env, const absl::Status& status) {
+  jclass e = direct_call_exception_class;
+  jmethodID constructor =
+      env->GetMethodID(e, "<init>", "(ILjava/lang/String;)V");
+  if (constructor == nullptr) {
+    return;
+  }
+  jstring message = env->NewStringUTF(std::string(status.message()).c_str());
+  if (message == nullptr) {
+    return;
+  }
+  jobject exception = env->NewObject(e, constructor,
+                                     static_cast<jint>(status.code()), message);
+  if (exception == nullptr) {
+    return;
+  }
+  env->Throw(static_cast<jthrowable>(exception));
+}
+
+// Calls 'method' of the service without going through gRPC. The request is
+// parsed straight from the first 'size' bytes of the direct ByteBuffer
+// 'request_buffer', and the response is serialized straight into the returned
+// byte array. The protos are kept per thread and only cleared between calls,
+// so that the memory of repeated fields, like parameter values and result
+// rows, is reused by the next call of the thread. Direct calls have no
+// deadline.
+template <typename RequestT, typename ResponseT>
+static jbyteArray CallDirect(
+    JNIEnv* env, jobject request_buffer, jint size,
+    absl::Status (ZetaSqlLocalServiceImpl::*method)(const RequestT&,
+                                                      ResponseT*, absl::Time)) {
+  const void* data = env->GetDirectBufferAddress(request_buffer);
+  if (data == nullptr || size < 0 ||
+      size > env->GetDirectBufferCapacity(request_buffer)) {
+    ThrowIllegalArgumentException(
+        env, "The request must be in a direct ByteBuffer of sufficient size");
+    return nullptr;
+  }
+
+  static thread_local RequestT* request = new RequestT();
+  static thread_local ResponseT* response = new ResponseT();
+  request->Clear();
+  response->Clear();
+  if (!request->ParseFromArray(data, size)) {
+    ThrowIllegalArgumentException(env, "Failed to parse the request");
+    return nullptr;
+  }
+
+  const absl::Status status =
+      (GetGrpcService()->service().*method)(*request, response,
+                                            absl::InfiniteFuture());
+  if (!status.ok()) {
+    ThrowDirectCallException(env, status);
+    return nullptr;
+  }
+
+  const int64_t response_size = response->ByteSizeLong();
+  jbyteArray result = env->NewByteArray(static_cast<jsize>(response_size));
+  if (result == nullptr) {
+    return nullptr;
+  }
+  void* result_data = env->GetPrimitiveArrayCritical(result, nullptr);
+  if (result_data == nullptr) {
+    return nullptr;
+  }
+  response->SerializeWithCachedSizesToArray(static_cast<uint8_t*>(result_data));
+  env->ReleasePrimitiveArrayCritical(result, result_data, 0);
+  return result;
+}
+
+static jbyteArray EvaluateDirect(JNIEnv* env, jclass clazz,
+                                 jobject request_buffer, jint size) {
+  return CallDirect(env, request_buffer, size,
+                    &ZetaSqlLocalServiceImpl::Evaluate);
+}
+
+static jbyteArray EvaluateQueryDirect(JNIEnv* env, jclass clazz,
+                                      jobject request_buffer, jint size) {
+  return CallDirect(env, request_buffer, size,
+                    &ZetaSqlLocalServiceImpl::EvaluateQuery);
+}
+
 static jobject WrapFileDescriptor(JNIEnv* env, const int fd) {
   jclass ioutil = env->FindClass("sun/nio/ch/IOUtil");
   if (ioutil == nullptr) {
@@ -174,6 +306,24 @@ jobject GetSocketChannel(JNIEnv* env) {
   return sc;
 }
 
+// Returns the value of the integer system property <name>, or 0 if it is not
+// set or not an integer.
+static int GetIntProperty(JNIEnv* env, jclass system, jmethodID get_property,
+                          const char* name) {
+  jstring value = (jstring)env->CallStaticObjectMethod(
+      system, get_property, env->NewStringUTF(name));
+  if (value == nullptr) {
+    return 0;
+  }
+  const char* value_str = env->GetStringUTFChars(value, nullptr);
+  int result;
+  if (!absl::SimpleAtoi(value_str, &result)) {
+    result = 0;
+  }
+  env->ReleaseStringUTFChars(value, value_str);
+  return result;
+}
+
 extern "C" JNIEXPORT jint JNICALL JNI_OnLoad_zetasql_local_service(JavaVM* vm,
                                                            void* reserved) {
   JNIEnv* env = nullptr;
@@ -198,17 +348,39 @@ extern "C" JNIEXPORT jint JNICALL JNI_OnLoad_zetasql_local_service(JavaVM* vm,
     return -1;
   }
 
+  max_server_threads =
+      GetIntProperty(env, system, gp, "zetasql.local_service.max_threads");
+  max_concurrent_evaluations = GetIntProperty(
+      env, system, gp, "zetasql.local_service.max_concurrent_evaluations");
+  max_state_idle_seconds = GetIntProperty(
+      env, system, gp, "zetasql.local_service.max_idle_seconds");
+  max_states =
+      GetIntProperty(env, system, gp, "zetasql.local_service.max_states");
+
   const char* classnamestr = env->GetStringUTFChars(classname, nullptr);
   jclass clazz = env->FindClass(classnamestr);
+  const std::string exception_classname =
+      std::string(classnamestr) + "$DirectCallException";
   env->ReleaseStringUTFChars(classname, classnamestr);
   classnamestr = nullptr;
   if (clazz == nullptr) {
     return -1;
   }
 
+  jclass exception_class = env->FindClass(exception_classname.c_str());
+  if (exception_class == nullptr) {
+    return -1;
+  }
+  direct_call_exception_class =
+      static_cast<jclass>(env->NewGlobalRef(exception_class));
+
   static JNINativeMethod methods[] = {
       {(char*)"getSocketChannel", (char*)"()Ljava/nio/channels/SocketChannel;",
        (void*)GetSocketChannel},
+      {(char*)"evaluateDirect", (char*)"(Ljava/nio/ByteBuffer;I)[B",
+       (void*)EvaluateDirect},
+      {(char*)"evaluateQueryDirect", (char*)"(Ljava/nio/ByteBuffer;I)[B",
+       (void*)EvaluateQueryDirect},
   };
   if (env->RegisterNatives(clazz, methods,
                            sizeof(methods) / sizeof(JNINativeMethod)) !=
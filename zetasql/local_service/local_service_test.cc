@@ -51,12 +51,16 @@
 #include "gtest/gtest.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "zetasql/base/status.h"
 
 namespace zetasql {
 
 using ::zetasql::testing::EqualsProto;
+using ::testing::ElementsAre;
 using ::testing::Eq;
+using ::testing::HasSubstr;
 using ::testing::IsEmpty;
 using ::testing::Not;
 using ::testing::UnorderedElementsAre;
@@ -135,6 +139,11 @@ class ZetaSqlLocalServiceImplTest : public ::testing::Test {
     return service_.Analyze(request, response);
   }
 
+  absl::Status GetServiceStats(const ServiceStatsRequest& request,
+                               ServiceStatsResponse* response) {
+    return service_.GetServiceStats(request, response);
+  }
+
   absl::Status Parse(const ParseRequest& request, ParseResponse* response) {
     return service_.Parse(request, response);
   }
@@ -1036,6 +1045,45 @@ TEST_F(ZetaSqlLocalServiceImplTest, Analyze) {
   EXPECT_EQ(40, response3.resume_byte_position());
 }
 
+TEST_F(ZetaSqlLocalServiceImplTest, AnalyzeStatementSummaryOnly) {
+  const std::string catalog_proto_text = R"pb(
+    name: "foo"
+    table {
+      name: "bar"
+      serialization_id: 1
+      column {
+        name: "baz"
+        type { type_kind: TYPE_INT32 }
+        is_pseudo_column: false
+      }
+    })pb";
+
+  AnalyzeRequest request;
+  ABSL_QCHECK(google::protobuf::TextFormat::ParseFromString(
+      catalog_proto_text, request.mutable_simple_catalog()));
+  request.set_sql_statement(
+      "select baz, baz + 1 as plus from bar "
+      "where baz in (select baz from bar)");
+  request.set_statement_summary_only(true);
+
+  AnalyzeResponse response;
+  ZETASQL_ASSERT_OK(Analyze(request, &response));
+  EXPECT_THAT(response, EqualsProto(R"pb(
+                statement_summary {
+                  node_kind: RESOLVED_QUERY_STMT
+                  output_column {
+                    name: "baz"
+                    type { type_kind: TYPE_INT32 }
+                  }
+                  output_column {
+                    name: "plus"
+                    type { type_kind: TYPE_INT64 }
+                  }
+                  referenced_table: "bar"
+                }
+              )pb"));
+}
+
 void AddDateTruncToCatalog(SimpleCatalogProto* catalog) {
   catalog->mutable_builtin_function_options()->add_include_function_ids(
       FN_DATE_TRUNC_DATE);
@@ -1462,6 +1510,72 @@ TEST_F(ZetaSqlLocalServiceImplTest,
               StatusIs(absl::StatusCode::kInvalidArgument));
 }
 
+TEST_F(ZetaSqlLocalServiceImplTest, AnalyzeReusesFileDescriptorSetPools) {
+  AnalyzeRequest analyze_request;
+  AddKitchenSinkDescriptorPool(analyze_request.mutable_descriptor_pool_list());
+  analyze_request.mutable_simple_catalog()->set_file_descriptor_set_index(0);
+  analyze_request.set_sql_statement(
+      "select new zetasql_test__.KitchenSinkPB(1 as int64_key_1, "
+      "2 as int64_key_2)");
+
+  // A Prepare of the same FileDescriptorSet registers and owns its pool, so
+  // unpreparing it must not affect the pool shared by the Analyze calls.
+  PrepareRequest prepare_request;
+  *prepare_request.mutable_descriptor_pool_list() =
+      analyze_request.descriptor_pool_list();
+  prepare_request.set_sql("1");
+  PrepareResponse prepare_response;
+  ZETASQL_ASSERT_OK(Prepare(prepare_request, &prepare_response));
+
+  for (int i = 0; i < 3; ++i) {
+    AnalyzeResponse analyze_response;
+    ZETASQL_ASSERT_OK(Analyze(analyze_request, &analyze_response));
+    const TypeProto& output_column_type =
+        analyze_response.resolved_statement()
+            .resolved_query_stmt_node()
+            .output_column_list(0)
+            .column()
+            .type();
+    EXPECT_EQ(output_column_type.proto_type().proto_name(),
+              "zetasql_test__.KitchenSinkPB");
+    if (i == 0) {
+      ZETASQL_ASSERT_OK(Unprepare(prepare_response.prepared().prepared_expression_id()));
+    }
+  }
+}
+
+TEST_F(ZetaSqlLocalServiceImplTest, GetServiceStats) {
+  PrepareRequest prepare_request;
+  prepare_request.set_sql("1");
+  PrepareResponse prepare_response;
+  ZETASQL_ASSERT_OK(Prepare(prepare_request, &prepare_response));
+
+  AnalyzeRequest analyze_request;
+  AddKitchenSinkDescriptorPool(analyze_request.mutable_descriptor_pool_list());
+  analyze_request.mutable_simple_catalog()->set_file_descriptor_set_index(0);
+  analyze_request.set_sql_statement("select 1");
+  for (int i = 0; i < 2; ++i) {
+    AnalyzeResponse analyze_response;
+    ZETASQL_ASSERT_OK(Analyze(analyze_request, &analyze_response));
+  }
+
+  ServiceStatsResponse stats;
+  ZETASQL_ASSERT_OK(GetServiceStats(ServiceStatsRequest(), &stats));
+  // The builtin descriptor pool is always registered.
+  EXPECT_EQ(stats.registered_descriptor_pools(), 1);
+  EXPECT_EQ(stats.registered_catalogs(), 0);
+  EXPECT_EQ(stats.prepared_expressions(), 1);
+  EXPECT_EQ(stats.prepared_queries(), 0);
+  EXPECT_EQ(stats.prepared_modifies(), 0);
+  EXPECT_EQ(stats.cached_descriptor_pools(), 1);
+  EXPECT_EQ(stats.descriptor_pool_cache_hits(), 1);
+  EXPECT_EQ(stats.descriptor_pool_cache_misses(), 1);
+  // RPC statistics are only collected by the gRPC service.
+  EXPECT_EQ(stats.rpc_stats_size(), 0);
+
+  ZETASQL_ASSERT_OK(Unprepare(prepare_response.prepared().prepared_expression_id()));
+}
+
 void ExpectTypeIsDate(const TypeProto& type) {
   EXPECT_EQ(type.type_kind(), TYPE_DATE);
 }
@@ -3196,6 +3310,182 @@ TEST_F(ZetaSqlLocalServiceImplTest, EvaluateQueryWithFullCatalogTableData) {
   ExpectValueIsInt32(row_0.cell(0), 123);
 }
 
+TEST_F(ZetaSqlLocalServiceImplTest, EvaluateQueryWithColumnarResult) {
+  EvaluateQueryRequest evaluate_request;
+  evaluate_request.set_sql(
+      "SELECT column_str, column_bool, column_int, 'x' AS s, "
+      "IF(column_int > 200, NULL, column_int) AS n, [column_int] AS a "
+      "FROM TestTable ORDER BY column_int");
+  evaluate_request.mutable_simple_catalog()->mutable_builtin_function_options();
+  AddTestTable(evaluate_request.mutable_simple_catalog()->add_table(),
+               "TestTable");
+  InsertTestTableContent(evaluate_request.mutable_table_content(), "TestTable");
+  evaluate_request.set_result_format(EvaluateQueryRequest::COLUMNAR);
+
+  EvaluateQueryResponse evaluate_response;
+  ZETASQL_ASSERT_OK(EvaluateQuery(evaluate_request, &evaluate_response));
+  EXPECT_FALSE(evaluate_response.content().has_table_data());
+  const ColumnarTableData& table =
+      evaluate_response.content().columnar_table_data();
+  EXPECT_EQ(table.num_rows(), 2);
+  ASSERT_EQ(table.column_size(), 6);
+
+  EXPECT_THAT(table.column(0).string_dictionary(),
+              ElementsAre("string_1", "string_2"));
+  EXPECT_THAT(table.column(0).string_indexes(), ElementsAre(0, 1));
+  EXPECT_THAT(table.column(1).bool_values(), ElementsAre(true, true));
+  EXPECT_THAT(table.column(2).int64_values(), ElementsAre(123, 321));
+  EXPECT_FALSE(table.column(2).has_null_bitmap());
+  // Equal strings share their dictionary entry.
+  EXPECT_THAT(table.column(3).string_dictionary(), ElementsAre("x"));
+  EXPECT_THAT(table.column(3).string_indexes(), ElementsAre(0, 0));
+  // The second value is NULL.
+  EXPECT_THAT(table.column(4).int64_values(), ElementsAre(123, 0));
+  EXPECT_EQ(table.column(4).null_bitmap(), std::string(1, '\x02'));
+  // Arrays are stored as ValueProtos.
+  ASSERT_EQ(table.column(5).values_size(), 2);
+  EXPECT_EQ(table.column(5).values(1).array_value().element(0).int32_value(),
+            321);
+}
+
+TEST(ZetaSqlLocalServiceImplRetentionTest, EvictsLeastRecentlyUsedStates) {
+  StateRetentionOptions retention_options;
+  retention_options.max_states = 2;
+  ZetaSqlLocalServiceImpl service(retention_options);
+
+  auto prepare = [&service](absl::string_view sql) {
+    PrepareRequest request;
+    request.set_sql(sql);
+    PrepareResponse response;
+    ZETASQL_EXPECT_OK(service.Prepare(request, &response));
+    return response.prepared().prepared_expression_id();
+  };
+  auto evaluate = [&service](int64_t id) {
+    EvaluateRequest request;
+    request.set_prepared_expression_id(id);
+    EvaluateResponse response;
+    return service.Evaluate(request, &response);
+  };
+
+  const int64_t id1 = prepare("1");
+  const int64_t id2 = prepare("2");
+  ZETASQL_EXPECT_OK(evaluate(id1));
+  // This evicts the least recently used expression, <id2>.
+  const int64_t id3 = prepare("3");
+
+  ZETASQL_EXPECT_OK(evaluate(id1));
+  ZETASQL_EXPECT_OK(evaluate(id3));
+  EXPECT_THAT(evaluate(id2),
+              StatusIs(absl::StatusCode::kNotFound, HasSubstr("was evicted")));
+  // Unpreparing an evicted expression succeeds, it is gone already.
+  ZETASQL_EXPECT_OK(service.Unprepare(id2));
+  ZETASQL_EXPECT_OK(service.Unprepare(id1));
+  ZETASQL_EXPECT_OK(service.Unprepare(id3));
+}
+
+TEST(ZetaSqlLocalServiceImplRetentionTest, EvictsIdleStates) {
+  StateRetentionOptions retention_options;
+  retention_options.max_idle_time = absl::Milliseconds(200);
+  ZetaSqlLocalServiceImpl service(retention_options);
+
+  RegisterCatalogRequest register_request;
+  register_request.mutable_simple_catalog()->set_name("catalog");
+  RegisterResponse register_response;
+  ZETASQL_ASSERT_OK(service.RegisterCatalog(register_request, &register_response));
+  const int64_t catalog_id = register_response.registered_id();
+
+  absl::SleepFor(absl::Milliseconds(400));
+  // Registering another state evicts the idle catalog.
+  PrepareQueryRequest prepare_request;
+  prepare_request.set_sql("SELECT 1");
+  PrepareQueryResponse prepare_response;
+  ZETASQL_ASSERT_OK(service.PrepareQuery(prepare_request, &prepare_response));
+
+  AnalyzeRequest analyze_request;
+  analyze_request.set_registered_catalog_id(catalog_id);
+  analyze_request.set_sql_statement("SELECT 1");
+  AnalyzeResponse analyze_response;
+  EXPECT_THAT(service.Analyze(analyze_request, &analyze_response),
+              StatusIs(absl::StatusCode::kNotFound, HasSubstr("was evicted")));
+  ZETASQL_EXPECT_OK(service.UnprepareQuery(
+      prepare_response.prepared().prepared_query_id()));
+}
+
+TEST_F(ZetaSqlLocalServiceImplTest, EvaluateWithExpiredDeadline) {
+  const absl::Time deadline = absl::Now() - absl::Seconds(1);
+
+  EvaluateRequest evaluate_request;
+  evaluate_request.set_sql("1 + 2");
+  EvaluateResponse evaluate_response;
+  EXPECT_THAT(
+      service_.Evaluate(evaluate_request, &evaluate_response, deadline),
+      StatusIs(absl::StatusCode::kResourceExhausted,
+               HasSubstr("statement deadline")));
+
+  EvaluateQueryRequest evaluate_query_request;
+  evaluate_query_request.set_sql(
+      "SELECT x FROM UNNEST([3, 1, 2]) AS x ORDER BY x");
+  EvaluateQueryResponse evaluate_query_response;
+  EXPECT_THAT(service_.EvaluateQuery(evaluate_query_request,
+                                     &evaluate_query_response, deadline),
+              StatusIs(absl::StatusCode::kResourceExhausted,
+                       HasSubstr("statement deadline")));
+
+  // The same query completes without a deadline.
+  evaluate_query_response.Clear();
+  ZETASQL_EXPECT_OK(EvaluateQuery(evaluate_query_request, &evaluate_query_response));
+  EXPECT_EQ(evaluate_query_response.content().table_data().row_size(), 3);
+}
+
+TEST_F(ZetaSqlLocalServiceImplTest, EvaluateQueryChunked) {
+  EvaluateQueryRequest evaluate_request;
+  evaluate_request.set_sql("SELECT x FROM UNNEST([1, 2, 3, 4, 5]) AS x");
+  evaluate_request.set_max_rows_per_chunk(2);
+
+  std::vector<EvaluateQueryResponse> chunks;
+  auto write_chunk = [&chunks](const EvaluateQueryResponse& chunk) {
+    chunks.push_back(chunk);
+    return absl::OkStatus();
+  };
+  ZETASQL_ASSERT_OK(service_.EvaluateQueryChunked(evaluate_request, write_chunk));
+  ASSERT_EQ(chunks.size(), 3);
+  EXPECT_EQ(chunks[0].prepared().columns_size(), 1);
+  EXPECT_FALSE(chunks[1].has_prepared());
+  EXPECT_EQ(chunks[0].content().table_data().row_size(), 2);
+  EXPECT_EQ(chunks[1].content().table_data().row_size(), 2);
+  ASSERT_EQ(chunks[2].content().table_data().row_size(), 1);
+  EXPECT_EQ(chunks[2].content().table_data().row(0).cell(0).int64_value(), 5);
+
+  // Columnar chunks each have their own string dictionaries.
+  chunks.clear();
+  evaluate_request.set_sql(
+      "SELECT s FROM UNNEST(['a', 'b', 'a', 'a']) AS s WITH OFFSET AS pos "
+      "ORDER BY pos");
+  evaluate_request.set_result_format(EvaluateQueryRequest::COLUMNAR);
+  evaluate_request.set_max_rows_per_chunk(3);
+  ZETASQL_ASSERT_OK(service_.EvaluateQueryChunked(evaluate_request, write_chunk));
+  ASSERT_EQ(chunks.size(), 2);
+  EXPECT_EQ(chunks[0].content().columnar_table_data().num_rows(), 3);
+  EXPECT_THAT(chunks[0].content().columnar_table_data().column(0)
+                  .string_dictionary(),
+              ElementsAre("a", "b"));
+  EXPECT_EQ(chunks[1].content().columnar_table_data().num_rows(), 1);
+  EXPECT_THAT(chunks[1].content().columnar_table_data().column(0)
+                  .string_dictionary(),
+              ElementsAre("a"));
+
+  // An error from writing a chunk stops the evaluation.
+  int num_writes = 0;
+  EXPECT_THAT(service_.EvaluateQueryChunked(
+                  evaluate_request,
+                  [&num_writes](const EvaluateQueryResponse& chunk) {
+                    ++num_writes;
+                    return absl::CancelledError("stop");
+                  }),
+              StatusIs(absl::StatusCode::kCancelled));
+  EXPECT_EQ(num_writes, 1);
+}
+
 TEST_F(ZetaSqlLocalServiceImplTest,
        EvaluateQueryWithDescriptorPoolListProtoWithFullCatalogTableData) {
   // Evaluate Query
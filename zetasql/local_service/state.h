@@ -19,13 +19,21 @@
 
 #include <stddef.h>
 
+#include <array>
+#include <atomic>
 #include <cstdint>
-#include <map>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
 #include "zetasql/base/map_util.h"
 
 namespace zetasql {
@@ -35,6 +43,14 @@ class GenericState;
 
 // Pool of saved states that can be shared by multiple statements.
 // The state class T must extend GenericState and must be thread safe.
+//
+// The states are sharded by id, each shard with its own mutex, so that
+// concurrent calls for different states rarely contend. Get() only takes a
+// reader lock.
+//
+// The pool remembers when each state was last registered or returned by
+// Get(), so that the owner can evict idle states, see GetLastUseTimes() and
+// RecordEvicted().
 template<class T>
 class SharedStatePool {
  public:
@@ -49,12 +65,13 @@ class SharedStatePool {
       return -1;
     }
 
-    absl::MutexLock lock(&mutex_);
-    int64_t id = next_id_++;
+    int64_t id = next_id_.fetch_add(1, std::memory_order_relaxed);
+    Shard& shard = GetShard(id);
+    absl::WriterMutexLock lock(&shard.mutex);
     if (!state->SetId(id)) {
       return -1;
     }
-    saved_states_[id] = state;
+    shard.saved_states[id] = std::move(state);
     return id;
   }
 
@@ -69,28 +86,33 @@ class SharedStatePool {
       return -1;
     }
 
-    absl::MutexLock lock(&mutex_);
-    int64_t id = next_id_++;
+    int64_t id = next_id_.fetch_add(1, std::memory_order_relaxed);
+    Shard& shard = GetShard(id);
+    absl::WriterMutexLock lock(&shard.mutex);
     if (!state->SetId(id)) {
       return -1;
     }
-    saved_states_[id].reset(state);
+    shard.saved_states[id].reset(state);
     return id;
   }
 
   bool Has(int64_t id) const {
-    absl::MutexLock lock(&mutex_);
-    return zetasql_base::ContainsKey(saved_states_, id);
+    const Shard& shard = GetShard(id);
+    absl::ReaderMutexLock lock(&shard.mutex);
+    return shard.saved_states.contains(id);
   }
 
   // Get a state object with given id, ownership is shared by the pool and all
   // threads that currently hold the state object.
   std::shared_ptr<T> Get(int64_t id) {
-    absl::MutexLock lock(&mutex_);
-    std::shared_ptr<T>* result = zetasql_base::FindOrNull(saved_states_, id);
+    const Shard& shard = GetShard(id);
+    absl::ReaderMutexLock lock(&shard.mutex);
+    const std::shared_ptr<T>* result =
+        zetasql_base::FindOrNull(shard.saved_states, id);
     if (result == nullptr) {
       return nullptr;
     } else {
+      (*result)->Touch();
       return *result;
     }
   }
@@ -98,23 +120,92 @@ class SharedStatePool {
   // Removes a state object from the pool. The state will be deleted immediately
   // if not held by any other threads, or after all threads releasing it.
   bool Delete(int64_t id) {
-    absl::MutexLock lock(&mutex_);
-    if (!zetasql_base::ContainsKey(saved_states_, id)) {
-      return false;
+    std::shared_ptr<T> state;
+    {
+      Shard& shard = GetShard(id);
+      absl::WriterMutexLock lock(&shard.mutex);
+      auto it = shard.saved_states.find(id);
+      if (it == shard.saved_states.end()) {
+        return false;
+      }
+      // Destroyed after the lock is released, as deleting a state can be
+      // expensive.
+      state = std::move(it->second);
+      shard.saved_states.erase(it);
     }
-    saved_states_.erase(id);
     return true;
   }
 
   size_t NumSavedStates() {
-    absl::MutexLock lock(&mutex_);
-    return saved_states_.size();
+    size_t num_saved_states = 0;
+    for (const Shard& shard : shards_) {
+      absl::ReaderMutexLock lock(&shard.mutex);
+      num_saved_states += shard.saved_states.size();
+    }
+    return num_saved_states;
+  }
+
+  // Returns the (last use time in nanoseconds, id) pairs of the states for
+  // which <evictable> returns true, in no particular order.
+  std::vector<std::pair<int64_t, int64_t>> GetLastUseTimes(
+      const std::function<bool(const T&)>& evictable) {
+    std::vector<std::pair<int64_t, int64_t>> last_use_times;
+    for (const Shard& shard : shards_) {
+      absl::ReaderMutexLock lock(&shard.mutex);
+      for (const auto& [id, state] : shard.saved_states) {
+        if (evictable(*state)) {
+          last_use_times.emplace_back(state->last_use_nanos(), id);
+        }
+      }
+    }
+    return last_use_times;
+  }
+
+  // Remembers that <id> was deleted by eviction rather than by its client,
+  // so that later calls with it can report that. Only the most recent
+  // kMaxEvictedIds evictions are remembered.
+  void RecordEvicted(int64_t id) {
+    absl::MutexLock lock(&evicted_mutex_);
+    if (!evicted_ids_.insert(id).second) {
+      return;
+    }
+    evicted_order_.push_back(id);
+    if (evicted_order_.size() > kMaxEvictedIds) {
+      evicted_ids_.erase(evicted_order_.front());
+      evicted_order_.pop_front();
+    }
+  }
+
+  bool WasEvicted(int64_t id) const {
+    absl::MutexLock lock(&evicted_mutex_);
+    return evicted_ids_.contains(id);
   }
 
  private:
-  mutable absl::Mutex mutex_;
-  int64_t next_id_ ABSL_GUARDED_BY(mutex_);
-  std::map<int64_t, std::shared_ptr<T>> saved_states_ ABSL_GUARDED_BY(mutex_);
+  static constexpr int kNumShards = 16;
+  static constexpr size_t kMaxEvictedIds = 4096;
+
+  struct Shard {
+    mutable absl::Mutex mutex;
+    absl::flat_hash_map<int64_t, std::shared_ptr<T>> saved_states
+        ABSL_GUARDED_BY(mutex);
+  };
+
+  // Ids are allocated sequentially, so consecutive states are in different
+  // shards.
+  Shard& GetShard(int64_t id) {
+    return shards_[static_cast<uint64_t>(id) % kNumShards];
+  }
+  const Shard& GetShard(int64_t id) const {
+    return shards_[static_cast<uint64_t>(id) % kNumShards];
+  }
+
+  std::atomic<int64_t> next_id_;
+  std::array<Shard, kNumShards> shards_;
+
+  mutable absl::Mutex evicted_mutex_;
+  absl::flat_hash_set<int64_t> evicted_ids_ ABSL_GUARDED_BY(evicted_mutex_);
+  std::deque<int64_t> evicted_order_ ABSL_GUARDED_BY(evicted_mutex_);
 
   static_assert(
       std::is_base_of<GenericState, T>::value,
@@ -130,18 +221,31 @@ class GenericState {
   int64_t GetId() const { return id_; }
   bool IsRegistered() { return id_ != -1; }
 
+  // When the state was last registered or fetched from its pool, as returned
+  // by absl::GetCurrentTimeNanos().
+  int64_t last_use_nanos() const {
+    return last_use_nanos_.load(std::memory_order_relaxed);
+  }
+
  private:
   int64_t id_ = -1;
+  std::atomic<int64_t> last_use_nanos_{0};
 
   // Should only be called by SharedStatePool.
   bool SetId(int64_t id) {
     if (id_ == -1) {
       id_ = id;
+      Touch();
       return true;
     }
     return false;
   }
 
+  void Touch() {
+    last_use_nanos_.store(absl::GetCurrentTimeNanos(),
+                          std::memory_order_relaxed);
+  }
+
   template<class T> friend class SharedStatePool;
 
   GenericState(const GenericState&) = delete;
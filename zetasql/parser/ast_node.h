@@ -38,7 +38,7 @@
 // AST classes. It should not be included directly. Include parse_tree.h.
 //
 // During the AST construction process, AddChild / AddChildren() add to the
-// children_ vector.  In InitFields(), we store pointers to children into named
+// children_ array.  In InitFields(), we store pointers to children into named
 // member fields with more specific types.  This allows users to navigate to
 // specific child objects directly.
 //
@@ -84,6 +84,15 @@ class ASTNode : public zetasql_base::ArenaOnlyGladiator {
   void set_parent(ASTNode* parent) { parent_ = parent; }
   ASTNode* parent() const { return parent_; }
 
+  // Sets the arena that the array of children is allocated from, which should
+  // be the arena of the node itself. Without one, e.g. for nodes on the stack,
+  // the array is allocated on the heap. This must be called before any child
+  // is added.
+  void set_arena(zetasql_base::UnsafeArena* arena) {
+    ABSL_DCHECK(children_ == nullptr);
+    arena_ = arena;
+  }
+
   // Adds all nodes in 'children' to the child list. Elements in 'children' are
   // allowed to be NULL, in which case they are ignored.
   void AddChildren(absl::Span<ASTNode* const> children);
@@ -101,14 +110,14 @@ class ASTNode : public zetasql_base::ArenaOnlyGladiator {
 
   // Access to child nodes with generic types.
   int num_children() const {
-    return children_.size();
+    return num_children_;
   }
   const ASTNode* child(int i) const { return children_[i]; }
   ASTNode* mutable_child(int i) { return children_[i]; }
 
   // Returns the index of the first child of a node kind or -1 if not found.
   int find_child_index(ASTNodeKind kind) const {
-    for (int i = 0; i < children_.size(); i++) {
+    for (int i = 0; i < num_children_; i++) {
       if (children_[i]->node_kind_ == kind) {
         return i;
       }
@@ -118,7 +127,7 @@ class ASTNode : public zetasql_base::ArenaOnlyGladiator {
 
   // Swap the positions of any 2 children of this ASTNode.
   bool SwapChildren(int idx_a, int idx_b) {
-    if (idx_a >= children_.size() || idx_b >= children_.size()) {
+    if (idx_a >= num_children_ || idx_b >= num_children_) {
       return false;
     }
     std::swap(children_[idx_a], children_[idx_b]);
@@ -471,14 +480,24 @@ class ASTNode : public zetasql_base::ArenaOnlyGladiator {
   // Expands the end of parse_location_range_ to include expand_range.
   void ExpandLocationRangeEnd(const ParseLocationRange& expand_range);
 
+  // Makes room for at least 'min_capacity' children in 'children_'.
+  void ReserveChildren(int min_capacity);
+
   ASTNodeKind node_kind_;
 
   ASTNode* parent_ = nullptr;
 
   ParseLocationRange parse_location_range_;
 
-  // Many nodes have one to two children, so InlinedVector saves allocations.
-  absl::InlinedVector<ASTNode*, 4> children_;
+  // The arena that 'children_' is allocated from, or NULL if it is on the heap.
+  zetasql_base::UnsafeArena* arena_ = nullptr;
+
+  // The children, in an array of 'children_capacity_' elements. Most nodes are
+  // created with all of their children at once, and get an array of exactly
+  // that size. Lists that are built incrementally double it as they grow.
+  ASTNode** children_ = nullptr;
+  int num_children_ = 0;
+  int children_capacity_ = 0;
 };
 
 }  // namespace zetasql
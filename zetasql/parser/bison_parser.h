@@ -122,6 +122,7 @@ class BisonParser {
   template <typename T, typename Location>
   T* CreateASTNode(const Location& bison_location) {
     T* result = new (zetasql_base::AllocateInArena, arena_) T;
+    result->set_arena(arena_);
     SetNodeLocation(bison_location, result);
     allocated_ast_nodes_->push_back(std::unique_ptr<ASTNode>(result));
     return result;
@@ -134,6 +135,7 @@ class BisonParser {
   T* CreateASTNode(const Location& bison_location,
                    absl::Span<ASTNode* const> children) {
     T* result = new (zetasql_base::AllocateInArena, arena_) T;
+    result->set_arena(arena_);
     SetNodeLocation(bison_location, result);
     allocated_ast_nodes_->push_back(std::unique_ptr<ASTNode>(result));
     result->AddChildren(children);
@@ -148,6 +150,7 @@ class BisonParser {
                    const Location& bison_location_end,
                    absl::Span<ASTNode* const> children) {
     T* result = new (zetasql_base::AllocateInArena, arena_) T;
+    result->set_arena(arena_);
     SetNodeLocation(bison_location_start, bison_location_end, result);
     allocated_ast_nodes_->push_back(std::unique_ptr<ASTNode>(result));
     result->AddChildren(children);
@@ -16,6 +16,7 @@
 
 #include "zetasql/parser/flex_tokenizer.h"
 
+#include <string>
 #include <vector>
 
 #include "zetasql/base/testing/status_matchers.h"
@@ -27,6 +28,7 @@
 #include "gtest/gtest.h"
 #include "zetasql/base/check.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "zetasql/base/status_macros.h"
 
@@ -116,6 +118,17 @@ TEST_F(FlexTokenizerTest, SysvarWithDotId) {
                   Token::IDENTIFIER, '.', Token::IDENTIFIER, Token::YYEOF));
 }
 
+TEST_F(FlexTokenizerTest, LongTokens) {
+  // Tokens that are much longer than the buffer of the tokenizer.
+  const std::string long_text(4 << 20, 'a');
+  const std::string sql = absl::StrCat("SELECT '", long_text, "', ", long_text,
+                                       " /*", long_text, "*/ FROM t");
+  EXPECT_THAT(GetAllTokens(BisonParserMode::kStatement, sql),
+              ElementsAre(Token::MODE_STATEMENT, Token::KW_SELECT,
+                          Token::STRING_LITERAL, ',', Token::IDENTIFIER,
+                          Token::KW_FROM, Token::IDENTIFIER, Token::YYEOF));
+}
+
 absl::StatusOr<TokenKind> GetNextToken(DisambiguatorLexer& tokenizer,
                                        Location& location) {
   TokenKind token_kind;
@@ -268,7 +268,7 @@ SCALAR_COLUMN_PROPAGATION_MODE = EnumScalarType(
 
 
 # Identifies the FieldLoader method used to populate member fields.
-# Each node field in a subclass is added to the children_ vector in ASTNode,
+# Each node field in a subclass is added to the children_ array in ASTNode,
 # then additionally added to a type-specific field in the subclass using one
 # of these methods:
 # REQUIRED: The next node in the vector, which must exist, is used for this
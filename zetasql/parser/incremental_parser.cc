@@ -0,0 +1,175 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/parser/incremental_parser.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/parser/ast_node.h"
+#include "zetasql/parser/parser.h"
+#include "zetasql/public/parse_location.h"
+#include "zetasql/public/parse_resume_location.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+
+namespace zetasql {
+namespace {
+
+// Adds <delta> to the byte offsets of the parse locations of <root> and all
+// of its descendants.
+void ShiftParseLocations(int delta, ASTNode* root) {
+  std::vector<ASTNode*> stack = {root};
+  while (!stack.empty()) {
+    ASTNode* node = stack.back();
+    stack.pop_back();
+    const ParseLocationRange range = node->GetParseLocationRange();
+    node->set_start_location(ParseLocationPoint::FromByteOffset(
+        range.start().filename(), range.start().GetByteOffset() + delta));
+    node->set_end_location(ParseLocationPoint::FromByteOffset(
+        range.end().filename(), range.end().GetByteOffset() + delta));
+    for (int i = 0; i < node->num_children(); ++i) {
+      stack.push_back(node->mutable_child(i));
+    }
+  }
+}
+
+// Orders statements by their start offsets.
+bool StartsBefore(const IncrementalParser::Statement& statement,
+                  int byte_offset) {
+  return statement.start < byte_offset;
+}
+
+}  // namespace
+
+IncrementalParser::IncrementalParser(const ParserOptions& parser_options)
+    : language_options_(parser_options.language_options()),
+      macro_catalog_(parser_options.macro_catalog()) {}
+
+void IncrementalParser::SetText(absl::string_view text) {
+  text_ = std::string(text);
+  statements_.clear();
+  statements_after_error_.clear();
+  ParseFrom(/*byte_offset=*/0, /*unchanged_start=*/0, /*delta=*/0,
+            /*old_statements=*/{});
+}
+
+absl::Status IncrementalParser::ApplyEdit(int byte_offset, int length,
+                                          absl::string_view replacement) {
+  if (byte_offset < 0 || length < 0 || byte_offset > text_.size() ||
+      length > text_.size() - byte_offset) {
+    return absl::OutOfRangeError(
+        absl::StrCat("Edit of ", length, " bytes at offset ", byte_offset,
+                     " is outside of the script of ", text_.size(), " bytes"));
+  }
+  text_.replace(byte_offset, length, replacement);
+
+  // The statement that contains <byte_offset> may change, and so may the one
+  // before it: whether the parser considers it to be at the end of the input
+  // depends on the token after its ";", which may be after <byte_offset>.
+  // Statements before these two do not look beyond the ";" of the next one.
+  auto first = std::lower_bound(statements_.begin(), statements_.end(),
+                                byte_offset, StartsBefore);
+  first -= std::min<std::ptrdiff_t>(2, first - statements_.begin());
+  const int start = first == statements_.end() ? 0 : first->start;
+  std::vector<Statement> old_statements(std::make_move_iterator(first),
+                                        std::make_move_iterator(
+                                            statements_.end()));
+  statements_.erase(first, statements_.end());
+  old_statements.insert(
+      old_statements.end(),
+      std::make_move_iterator(statements_after_error_.begin()),
+      std::make_move_iterator(statements_after_error_.end()));
+  statements_after_error_.clear();
+
+  const int delta = static_cast<int>(replacement.size()) - length;
+  ParseFrom(start, byte_offset + static_cast<int>(replacement.size()), delta,
+            std::move(old_statements));
+  return absl::OkStatus();
+}
+
+void IncrementalParser::ParseFrom(int byte_offset, int unchanged_start,
+                                  int delta,
+                                  std::vector<Statement> old_statements) {
+  status_ = absl::OkStatus();
+  num_statements_parsed_ = 0;
+  // Moves <statement> from before the edit to after it.
+  auto shift = [delta](Statement& statement) {
+    statement.start += delta;
+    statement.end += delta;
+    if (delta != 0) {
+      // The parse trees are owned by this object, so they can be updated in
+      // place.
+      ShiftParseLocations(delta, const_cast<ASTStatement*>(
+                                     statement.parser_output->statement()));
+    }
+  };
+
+  ParseResumeLocation resume_location =
+      ParseResumeLocation::FromStringView(text_);
+  resume_location.set_byte_position(byte_offset);
+  bool at_end_of_input = false;
+  while (!at_end_of_input) {
+    const int start = resume_location.byte_position();
+    if (start >= unchanged_start) {
+      // The text from <start> on is unchanged, so a statement that started
+      // there before the edit is still the same.
+      auto it = std::lower_bound(old_statements.begin(), old_statements.end(),
+                                 start - delta, StartsBefore);
+      if (it != old_statements.end() && it->start == start - delta) {
+        shift(*it);
+        // Only the last statement ends at the end of the input.
+        at_end_of_input = it->end == text_.size();
+        resume_location.set_byte_position(it->end);
+        statements_.push_back(std::move(*it));
+        continue;
+      }
+    }
+
+    ParserOptions parser_options(language_options_, macro_catalog_);
+    std::unique_ptr<ParserOutput> parser_output;
+    ++num_statements_parsed_;
+    status_ = ParseNextScriptStatement(&resume_location, parser_options,
+                                       &parser_output, &at_end_of_input);
+    if (!status_.ok()) {
+      // Keep the statements after the one that failed, so that they need not
+      // be parsed again once it is fixed.
+      for (Statement& statement : old_statements) {
+        // Those that were moved to 'statements_' are before <start>.
+        if (statement.parser_output != nullptr &&
+            statement.start + delta > start &&
+            statement.start + delta >= unchanged_start) {
+          shift(statement);
+          statements_after_error_.push_back(std::move(statement));
+        }
+      }
+      return;
+    }
+    Statement statement;
+    statement.start = start;
+    statement.end = resume_location.byte_position();
+    statement.parser_output = std::move(parser_output);
+    statements_.push_back(std::move(statement));
+  }
+}
+
+}  // namespace zetasql
@@ -0,0 +1,113 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PARSER_INCREMENTAL_PARSER_H_
+#define ZETASQL_PARSER_INCREMENTAL_PARSER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/parser/macros/macro_catalog.h"
+#include "zetasql/parser/parser.h"
+#include "zetasql/public/language_options.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+
+namespace zetasql {
+
+// Keeps the parse trees of the statements of a script up to date while the
+// script is edited, e.g. by an editor that reparses its buffer on every
+// keystroke. Rather than the whole script, an edit only reparses the
+// statements from the one before the edit up to the first one after it that
+// starts where a statement started before the edit. The statements after
+// that are kept, with their parse locations shifted by the length change.
+//
+// The statements are those of ParseNextScriptStatement() called in a loop, so
+// a BEGIN...END block or an IF...END IF is a single statement. Like that
+// loop, parsing stops at the first statement that fails to parse. The trees
+// of the statements after it are kept aside though, so that they need not be
+// parsed again once the error is fixed.
+//
+// Each statement has its own arena and IdStringPool. The warnings of the
+// kept statements are not updated, so their locations may be stale.
+class IncrementalParser {
+ public:
+  // A parsed statement of the script.
+  struct Statement {
+    // The byte offsets of the start of the statement, and of where the next
+    // statement starts, i.e. after its ";". The parse locations of the tree
+    // are within these.
+    int start = 0;
+    int end = 0;
+    std::unique_ptr<ParserOutput> parser_output;
+  };
+
+  // Only the LanguageOptions and the MacroCatalog of <parser_options> are
+  // used. The MacroCatalog must outlive this object.
+  explicit IncrementalParser(const ParserOptions& parser_options);
+
+  IncrementalParser(const IncrementalParser&) = delete;
+  IncrementalParser& operator=(const IncrementalParser&) = delete;
+
+  // Replaces the script with <text>, and parses all of it.
+  void SetText(absl::string_view text);
+
+  // Replaces the <length> bytes of the script at <byte_offset> with
+  // <replacement>, and reparses the statements that this may change. Returns
+  // an OutOfRange error if the bytes are not within the script. Parse errors
+  // are returned by status(), not here.
+  absl::Status ApplyEdit(int byte_offset, int length,
+                         absl::string_view replacement);
+
+  const std::string& text() const { return text_; }
+
+  // The statements of the script in order, up to the first one that fails to
+  // parse.
+  const std::vector<Statement>& statements() const { return statements_; }
+
+  // The error of the statement that failed to parse, if any, which starts at
+  // the end of the last of statements().
+  const absl::Status& status() const { return status_; }
+
+  // The number of statements that were parsed by the last SetText() or
+  // ApplyEdit(), including the one that failed to parse.
+  int64_t num_statements_parsed() const { return num_statements_parsed_; }
+
+ private:
+  // Parses the statements starting at <byte_offset> onto 'statements_'. A
+  // statement that starts at or after <unchanged_start>, the end of the edit,
+  // is taken from <old_statements> instead if one of them started there
+  // before the edit, which changed the length of the text by <delta>.
+  void ParseFrom(int byte_offset, int unchanged_start, int delta,
+                 std::vector<Statement> old_statements);
+
+  const LanguageOptions language_options_;
+  const parser::macros::MacroCatalog* const macro_catalog_;
+  std::string text_;
+  std::vector<Statement> statements_;
+  // If 'status_' is an error, the statements after the one that failed that
+  // parsed before, in order. Each starts where it would if the failed one was
+  // fixed, but they may not follow each other.
+  std::vector<Statement> statements_after_error_;
+  absl::Status status_;
+  int64_t num_statements_parsed_ = 0;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PARSER_INCREMENTAL_PARSER_H_
@@ -0,0 +1,130 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/parser/incremental_parser.h"
+
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/parser/parser.h"
+#include "zetasql/public/language_options.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+
+namespace zetasql {
+namespace {
+
+using ::zetasql_base::testing::StatusIs;
+
+// Returns the statements of <parser> along with their offsets.
+std::vector<std::string> DebugStrings(const IncrementalParser& parser) {
+  std::vector<std::string> debug_strings;
+  for (const IncrementalParser::Statement& statement : parser.statements()) {
+    debug_strings.push_back(absl::StrCat(
+        statement.start, "-", statement.end, ":\n",
+        statement.parser_output->statement()->DebugString()));
+  }
+  return debug_strings;
+}
+
+// Expects <parser> to have the statements of parsing its text from scratch.
+void ExpectSameAsFullParse(const IncrementalParser& parser) {
+  IncrementalParser full_parser{ParserOptions(LanguageOptions())};
+  full_parser.SetText(parser.text());
+  EXPECT_EQ(DebugStrings(parser), DebugStrings(full_parser)) << parser.text();
+  EXPECT_EQ(parser.status(), full_parser.status()) << parser.text();
+}
+
+TEST(IncrementalParserTest, ReparsesOnlyEditedStatements) {
+  std::string text;
+  for (int i = 0; i < 100; ++i) {
+    absl::StrAppend(&text, "SELECT ", i, " FROM t;\n");
+  }
+  IncrementalParser parser{ParserOptions(LanguageOptions())};
+  parser.SetText(text);
+  ZETASQL_ASSERT_OK(parser.status());
+  EXPECT_EQ(parser.statements().size(), 100);
+  EXPECT_EQ(parser.num_statements_parsed(), 100);
+
+  // Change "SELECT 50" into "SELECT 5000".
+  const int offset = parser.statements()[50].start + 10;
+  ZETASQL_ASSERT_OK(parser.ApplyEdit(offset, 0, "00"));
+  ZETASQL_ASSERT_OK(parser.status());
+  EXPECT_LE(parser.num_statements_parsed(), 3);
+  EXPECT_EQ(parser.statements()[99].end, text.size() + 2);
+  ExpectSameAsFullParse(parser);
+
+  // Break a statement, then fix it again.
+  ZETASQL_ASSERT_OK(parser.ApplyEdit(offset, 2, " FROM"));
+  EXPECT_THAT(parser.status(), StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_EQ(parser.statements().size(), 50);
+  EXPECT_LE(parser.num_statements_parsed(), 3);
+  ExpectSameAsFullParse(parser);
+  ZETASQL_ASSERT_OK(parser.ApplyEdit(offset, 5, "1"));
+  ZETASQL_ASSERT_OK(parser.status());
+  EXPECT_EQ(parser.statements().size(), 100);
+  EXPECT_LE(parser.num_statements_parsed(), 3);
+  ExpectSameAsFullParse(parser);
+}
+
+TEST(IncrementalParserTest, MatchesFullParseAfterEachEdit) {
+  IncrementalParser parser{ParserOptions(LanguageOptions())};
+  parser.SetText("SELECT 1;\nSELECT 2;\nSELECT 3");
+  struct Edit {
+    int byte_offset;
+    int length;
+    std::string replacement;
+  };
+  for (const Edit& edit : std::vector<Edit>{
+           // Merge the first two statements into a block.
+           {0, 0, "BEGIN "},
+           {25, 0, " END;"},
+           // Split the block again.
+           {0, 6, ""},
+           {19, 5, ""},
+           // Delete the ";" of the second statement, and put it back.
+           {18, 1, ""},
+           {18, 0, ";"},
+           // Remove and replace the last statement.
+           {19, 9, ""},
+           {19, 0, "\nSELECT 4;   "},
+           // Comment out the second statement.
+           {9, 0, " /*"},
+           {22, 0, "*/ "},
+           {0, 0, "-- comment\n"},
+       }) {
+    ZETASQL_ASSERT_OK(
+        parser.ApplyEdit(edit.byte_offset, edit.length, edit.replacement));
+    ExpectSameAsFullParse(parser);
+  }
+}
+
+TEST(IncrementalParserTest, RejectsEditsOutsideOfText) {
+  IncrementalParser parser{ParserOptions(LanguageOptions())};
+  parser.SetText("SELECT 1");
+  EXPECT_THAT(parser.ApplyEdit(-1, 0, "x"),
+              StatusIs(absl::StatusCode::kOutOfRange));
+  EXPECT_THAT(parser.ApplyEdit(5, 4, "x"),
+              StatusIs(absl::StatusCode::kOutOfRange));
+  ZETASQL_EXPECT_OK(parser.ApplyEdit(8, 0, ";"));
+  EXPECT_EQ(parser.text(), "SELECT 1;");
+}
+
+}  // namespace
+}  // namespace zetasql
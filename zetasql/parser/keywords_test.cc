@@ -27,6 +27,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/flags/flag.h"
+#include "absl/strings/ascii.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/types/span.h"
@@ -67,6 +68,37 @@ TEST(GetKeywordInfo, NonHit) {
   EXPECT_FALSE(info != nullptr);
 }
 
+TEST(GetKeywordInfo, FindsEveryKeywordIgnoringCase) {
+  for (const KeywordInfo& keyword_info : GetAllKeywords()) {
+    std::string lower = absl::AsciiStrToLower(keyword_info.keyword());
+    std::string mixed = lower;
+    mixed[0] = absl::ascii_toupper(mixed[0]);
+    EXPECT_EQ(GetKeywordInfo(keyword_info.keyword()), &keyword_info);
+    EXPECT_EQ(GetKeywordInfo(lower), &keyword_info);
+    EXPECT_EQ(GetKeywordInfo(mixed), &keyword_info);
+    EXPECT_EQ(GetKeywordInfo(absl::StrCat(lower, "_")), nullptr);
+    EXPECT_TRUE(IsKeywordInTokenizer(mixed));
+  }
+  EXPECT_EQ(GetKeywordInfo(""), nullptr);
+  EXPECT_EQ(GetKeywordInfo("select "), nullptr);
+  EXPECT_EQ(GetKeywordInfo("`select`"), nullptr);
+}
+
+TEST(IsKeywordInTokenizer, IncludesCurrentDateAndTimeFunctions) {
+  EXPECT_EQ(GetKeywordInfo("current_timestamp"), nullptr);
+  EXPECT_TRUE(IsKeywordInTokenizer("Current_Timestamp"));
+  EXPECT_TRUE(IsKeywordInTokenizer("CURRENT_DATE"));
+  EXPECT_FALSE(IsKeywordInTokenizer("current_day"));
+}
+
+TEST(NonReservedIdentifierMustBeBackquoted, IgnoresCase) {
+  EXPECT_TRUE(NonReservedIdentifierMustBeBackquoted("row"));
+  EXPECT_TRUE(NonReservedIdentifierMustBeBackquoted("Safe_Cast"));
+  EXPECT_TRUE(NonReservedIdentifierMustBeBackquoted("CLAMPED"));
+  EXPECT_FALSE(NonReservedIdentifierMustBeBackquoted("value"));
+  EXPECT_FALSE(NonReservedIdentifierMustBeBackquoted("rows"));
+}
+
 // Returns a section of lines from file 'file_path' delimited by
 // BEGIN_<section_delimiter> and END_<section_delimiter>. The section
 // delimiters do not need to be on a line by themselves. The lines that contain
@@ -19,6 +19,7 @@
 #include <algorithm>
 #include <cctype>
 #include <cstddef>
+#include <cstdint>
 #include <iterator>
 #include <memory>
 #include <queue>
@@ -145,7 +146,26 @@ MacroExpander::MacroExpander(std::unique_ptr<FlexTokenProvider> token_provider,
                              StackFrame* parent_location)
     : MacroExpander(std::move(token_provider), macro_catalog, arena,
                     /*call_arguments=*/{}, error_message_options,
-                    parent_location) {}
+                    parent_location, /*invocation_cache=*/nullptr) {}
+
+MacroExpander::MacroExpander(
+    std::unique_ptr<FlexTokenProvider> token_provider,
+    const MacroCatalog& macro_catalog, zetasql_base::UnsafeArena* arena,
+    const std::vector<std::vector<TokenWithLocation>> call_arguments,
+    ErrorMessageOptions error_message_options, StackFrame* parent_location,
+    InvocationCache* invocation_cache)
+    : token_provider_(std::move(token_provider)),
+      macro_catalog_(macro_catalog),
+      arena_(arena),
+      call_arguments_(std::move(call_arguments)),
+      error_message_options_(error_message_options),
+      parent_location_(parent_location),
+      invocation_cache_(invocation_cache) {
+  if (invocation_cache_ == nullptr) {
+    owned_invocation_cache_ = std::make_unique<InvocationCache>();
+    invocation_cache_ = owned_invocation_cache_.get();
+  }
+}
 
 absl::StatusOr<ExpansionOutput> MacroExpander::ExpandMacros(
     absl::string_view filename, absl::string_view input,
@@ -159,7 +179,8 @@ absl::StatusOr<ExpansionOutput> MacroExpander::ExpandMacros(
   ZETASQL_RETURN_IF_ERROR(ExpandMacrosInternal(
       std::move(token_provider), macro_catalog, expansion_output.arena.get(),
       /*call_arguments=*/{}, error_message_options, /*parent_location=*/nullptr,
-      expansion_output.expanded_tokens, expansion_output.warnings,
+      /*invocation_cache=*/nullptr, expansion_output.expanded_tokens,
+      expansion_output.warnings,
       /*out_max_arg_ref_index=*/nullptr));
   return expansion_output;
 }
@@ -700,7 +721,7 @@ absl::Status MacroExpander::ParseAndExpandArgs(
             GetTextBetween(token_provider_->input(), 0, arg_end_offset),
             arg_start_offset, token_provider_->language_options()),
         macro_catalog_, arena_, call_arguments_, error_message_options_,
-        parent_location_, expanded_arg, warnings_,
+        parent_location_, invocation_cache_, expanded_arg, warnings_,
         &max_arg_ref_index_in_current_arg));
 
     max_arg_ref_index_ =
@@ -781,6 +802,33 @@ absl::StatusOr<MacroExpander::StackFrame> MacroExpander::MakeStackFrame(
   return StackFrame{.error_source = error_source, .parent = parent_location_};
 }
 
+// Returns the key of an invocation of <macro_definition> with the expanded
+// <args>, which include the macro name as $0, in the invocation cache. The
+// expansion only depends on these, since warnings and errors are not cached.
+// The definition is identified by its address in the macro catalog, which does
+// not change during an expansion. The arguments are compared with their
+// locations, which the expanded tokens keep.
+static std::string InvocationCacheKey(
+    absl::string_view macro_definition,
+    const std::vector<std::vector<TokenWithLocation>>& args) {
+  std::string key;
+  absl::StrAppend(&key, reinterpret_cast<uintptr_t>(macro_definition.data()),
+                  ":", macro_definition.size());
+  for (const std::vector<TokenWithLocation>& arg : args) {
+    absl::StrAppend(&key, ";", arg.size());
+    for (const TokenWithLocation& token : arg) {
+      // Strings are prefixed with their lengths so that keys are unambiguous.
+      absl::string_view filename = token.location.start().filename();
+      absl::StrAppend(&key, ",", token.kind, ",", token.start_offset(), ",",
+                      token.end_offset(), ",", filename.size(), ":", filename,
+                      token.text.size(), ":", token.text,
+                      token.preceding_whitespaces.size(), ":",
+                      token.preceding_whitespaces);
+    }
+  }
+  return key;
+}
+
 // Expands the macro invocation starting at the given token.
 // REQUIRES: Any arguments must have already been loaded into the splicing
 //           buffer.
@@ -796,25 +844,41 @@ absl::Status MacroExpander::ExpandMacroInvocation(
   std::vector<std::vector<TokenWithLocation>> expanded_args;
   ZETASQL_RETURN_IF_ERROR(ParseAndExpandArgs(token, expanded_args));
 
-  absl::string_view macro_name_as_source =
-      MaybeAllocateConcatenation("macro:", GetMacroName(token));
-
-  // The macro definition can contain anything, not necessarily a statement or
-  // a script. Expanding a definition for an invocation always occurs in raw
-  // tokenization, without carrying over comments.
-  auto child_token_provider = std::make_unique<FlexTokenProvider>(
-      BisonParserMode::kTokenizer, macro_name_as_source, macro_definition,
-      /*start_offset=*/0, token_provider_->language_options());
-
   int num_args = static_cast<int>(expanded_args.size()) - 1;
 
-  ZETASQL_ASSIGN_OR_RETURN(StackFrame stack_frame,
-                   MakeStackFrame(token.location.start()));
+  std::string cache_key = InvocationCacheKey(macro_definition, expanded_args);
   int max_arg_ref_in_definition;
-  ZETASQL_RETURN_IF_ERROR(ExpandMacrosInternal(
-      std::move(child_token_provider), macro_catalog_, arena_,
-      std::move(expanded_args), error_message_options_, &stack_frame,
-      expanded_tokens, warnings_, &max_arg_ref_in_definition));
+  if (auto it = invocation_cache_->find(cache_key);
+      it != invocation_cache_->end()) {
+    expanded_tokens = it->second.expanded_tokens;
+    max_arg_ref_in_definition = it->second.max_arg_ref_index;
+  } else {
+    absl::string_view macro_name_as_source =
+        MaybeAllocateConcatenation("macro:", GetMacroName(token));
+
+    // The macro definition can contain anything, not necessarily a statement
+    // or a script. Expanding a definition for an invocation always occurs in
+    // raw tokenization, without carrying over comments.
+    auto child_token_provider = std::make_unique<FlexTokenProvider>(
+        BisonParserMode::kTokenizer, macro_name_as_source, macro_definition,
+        /*start_offset=*/0, token_provider_->language_options());
+
+    ZETASQL_ASSIGN_OR_RETURN(StackFrame stack_frame,
+                     MakeStackFrame(token.location.start()));
+    const size_t num_warnings = warnings_.size();
+    ZETASQL_RETURN_IF_ERROR(ExpandMacrosInternal(
+        std::move(child_token_provider), macro_catalog_, arena_,
+        std::move(expanded_args), error_message_options_, &stack_frame,
+        invocation_cache_, expanded_tokens, warnings_,
+        &max_arg_ref_in_definition));
+    // Warnings point to the location of this invocation, so expansions with
+    // warnings are not reused elsewhere.
+    if (warnings_.size() == num_warnings) {
+      invocation_cache_->emplace(
+          std::move(cache_key),
+          InvocationExpansion{expanded_tokens, max_arg_ref_in_definition});
+    }
+  }
   if (num_args > max_arg_ref_in_definition) {
     ZETASQL_RETURN_IF_ERROR(RaiseErrorOrAddWarning(MakeSqlErrorAt(
         token.location.start(),
@@ -936,8 +1000,8 @@ absl::StatusOr<TokenWithLocation> MacroExpander::ExpandLiteral(
     ZETASQL_RETURN_IF_ERROR(
         ExpandMacrosInternal(std::move(child_token_provider), macro_catalog_,
                              arena_, call_arguments_, error_message_options_,
-                             &stack_frame, expanded_tokens, warnings_,
-                             /*out_max_arg_ref_index=*/nullptr));
+                             &stack_frame, invocation_cache_, expanded_tokens,
+                             warnings_, /*out_max_arg_ref_index=*/nullptr));
 
     ZETASQL_RET_CHECK(!expanded_tokens.empty())
         << "A proper expansion should have at least the YYEOF token at "
@@ -1007,11 +1071,12 @@ absl::Status MacroExpander::ExpandMacrosInternal(
     const MacroCatalog& macro_catalog, zetasql_base::UnsafeArena* arena,
     const std::vector<std::vector<TokenWithLocation>>& call_arguments,
     ErrorMessageOptions error_message_options, StackFrame* parent_location,
+    InvocationCache* invocation_cache,
     std::vector<TokenWithLocation>& output_token_list,
     std::vector<absl::Status>& warnings, int* out_max_arg_ref_index) {
   auto expander = absl::WrapUnique(new MacroExpander(
       std::move(token_provider), macro_catalog, arena, call_arguments,
-      error_message_options, parent_location));
+      error_message_options, parent_location, invocation_cache));
   do {
     ZETASQL_ASSIGN_OR_RETURN(TokenWithLocation token, expander->GetNextToken());
     output_token_list.push_back(std::move(token));
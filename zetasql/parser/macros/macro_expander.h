@@ -19,6 +19,7 @@
 
 #include <memory>
 #include <queue>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -32,6 +33,7 @@
 #include "zetasql/public/language_options.h"
 #include "zetasql/public/parse_location.h"
 #include "zetasql/base/check.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
@@ -101,17 +103,30 @@ class MacroExpander final : public MacroExpanderBase {
       ErrorMessageOptions error_message_options = {});
 
  private:
+  // The expansion of a macro invocation, without the warnings and errors of
+  // the invocation itself.
+  struct InvocationExpansion {
+    std::vector<TokenWithLocation> expanded_tokens;
+    int max_arg_ref_index = 0;
+  };
+
+  // The expansions of the macro invocations that expanded without warnings,
+  // keyed on the definition and the expanded arguments (see
+  // InvocationCacheKey() in the .cc file), so that a macro that is invoked
+  // many times the same way, e.g. from within another macro, is expanded
+  // only once. It is shared by all the expanders of a top-level expansion,
+  // since the tokens may point to strings in their arena.
+  using InvocationCache =
+      absl::flat_hash_map<std::string, InvocationExpansion>;
+
+  // <invocation_cache> is that of the parent expander, or null at the top
+  // level.
   MacroExpander(
       std::unique_ptr<FlexTokenProvider> token_provider,
       const MacroCatalog& macro_catalog, zetasql_base::UnsafeArena* arena,
       const std::vector<std::vector<TokenWithLocation>> call_arguments,
-      ErrorMessageOptions error_message_options, StackFrame* parent_location)
-      : token_provider_(std::move(token_provider)),
-        macro_catalog_(macro_catalog),
-        arena_(arena),
-        call_arguments_(std::move(call_arguments)),
-        error_message_options_(error_message_options),
-        parent_location_(parent_location) {}
+      ErrorMessageOptions error_message_options, StackFrame* parent_location,
+      InvocationCache* invocation_cache);
 
   // Because this function may be called internally (e.g. when expanding
   // a nested macro), it appends to `out_warnings`, instead of replacing it.
@@ -120,6 +135,7 @@ class MacroExpander final : public MacroExpanderBase {
       const MacroCatalog& macro_catalog, zetasql_base::UnsafeArena* arena,
       const std::vector<std::vector<TokenWithLocation>>& call_arguments,
       ErrorMessageOptions error_message_options, StackFrame* parent_location,
+      InvocationCache* invocation_cache,
       std::vector<TokenWithLocation>& output_token_list,
       std::vector<absl::Status>& out_warnings, int* out_max_arg_ref_index);
 
@@ -318,6 +334,10 @@ class MacroExpander final : public MacroExpanderBase {
 
   // Tracks the current stack of macro expansions up to the parent.
   StackFrame* parent_location_ = nullptr;
+
+  // Set only at the top level, where 'invocation_cache_' points to it.
+  std::unique_ptr<InvocationCache> owned_invocation_cache_;
+  InvocationCache* invocation_cache_ = nullptr;
 };
 
 }  // namespace macros
@@ -680,6 +680,35 @@ TEST(MacroExpanderTest, ExpandsArgs) {
       })));
 }
 
+TEST(MacroExpanderTest, ExpandsRepeatedInvocationsTheSameWay) {
+  MacroCatalog macro_catalog;
+  macro_catalog.insert({"inner", "x$1"});
+  macro_catalog.insert({"outer", "$inner(1) + $inner(2)"});
+
+  EXPECT_THAT(ExpandMacros("$outer() $outer()", macro_catalog,
+                           GetLanguageOptions(/*is_strict=*/false)),
+              IsOkAndHolds(TokensEq(std::vector<TokenWithLocation>{
+                  {IDENTIFIER, MakeLocation("macro:inner", 0, 1), "x1", ""},
+                  {'+', MakeLocation("macro:outer", 10, 11), "+", " "},
+                  {IDENTIFIER, MakeLocation("macro:inner", 0, 1), "x2", " "},
+                  {IDENTIFIER, MakeLocation("macro:inner", 0, 1), "x1", " "},
+                  {'+', MakeLocation("macro:outer", 10, 11), "+", " "},
+                  {IDENTIFIER, MakeLocation("macro:inner", 0, 1), "x2", " "},
+                  {YYEOF, MakeLocation(17, 17), "", ""}})));
+}
+
+TEST(MacroExpanderTest, ReportsWarningsOfEachRepeatedInvocation) {
+  MacroCatalog macro_catalog;
+  macro_catalog.insert({"empty", ""});
+  macro_catalog.insert({"warn", "$empty(x)"});
+
+  EXPECT_THAT(ExpandMacros("$warn() $warn()", macro_catalog,
+                           GetLanguageOptions(/*is_strict=*/false)),
+              IsOkAndHolds(HasWarnings(ElementsAre(
+                  StatusIs(_, HasSubstr("[at top_file.sql:1:1]")),
+                  StatusIs(_, HasSubstr("[at top_file.sql:1:9]"))))));
+}
+
 TEST(MacroExpanderTest, ExpandsArgsThatHaveParensAndCommas) {
   MacroCatalog macro_catalog;
   macro_catalog.insert({"repeat", "$1, $1, $2, $2"});
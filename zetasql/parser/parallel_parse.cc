@@ -0,0 +1,144 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/parser/parallel_parse.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "zetasql/parser/parser.h"
+#include "zetasql/public/language_options.h"
+#include "zetasql/public/parse_resume_location.h"
+#include "zetasql/public/parse_tokens.h"
+#include "absl/status/status.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+namespace {
+
+// The result of parsing the statement at one byte offset of the input.
+struct ParsedStatement {
+  absl::Status status;
+  std::unique_ptr<ParserOutput> output;
+  // Where the next statement starts, if 'status' is OK.
+  int next_byte_position = 0;
+  bool at_end_of_input = false;
+};
+
+// Returns the byte offsets of the input of <resume_location> after its byte
+// position at which statements may start: the byte position itself, and the
+// end of each ";" token that is followed by more than whitespace and
+// comments. Only returns the byte position if the input fails to tokenize,
+// since the parser reports the error then.
+std::vector<int> FindStatementStarts(const ParseResumeLocation& resume_location,
+                                     const LanguageOptions& language_options) {
+  std::vector<int> starts = {resume_location.byte_position()};
+  ParseResumeLocation location = ParseResumeLocation::FromStringView(
+      resume_location.filename(), resume_location.input());
+  location.set_byte_position(resume_location.byte_position());
+  ParseTokenOptions options;
+  options.language_options = language_options;
+  std::vector<ParseToken> tokens;
+  if (!GetParseTokens(options, &location, &tokens).ok()) {
+    return starts;
+  }
+  for (int i = 0; i + 1 < tokens.size(); ++i) {
+    if (tokens[i].IsKeyword() && tokens[i].GetKeyword() == ";" &&
+        !tokens[i + 1].IsEndOfInput()) {
+      starts.push_back(tokens[i].GetLocationRange().end().GetByteOffset());
+    }
+  }
+  return starts;
+}
+
+ParsedStatement ParseStatementAt(const ParseResumeLocation& resume_location,
+                                 int byte_position,
+                                 const ParserOptions& parser_options,
+                                 bool allow_script_statements) {
+  ParseResumeLocation location = ParseResumeLocation::FromStringView(
+      resume_location.filename(), resume_location.input());
+  location.set_byte_position(byte_position);
+  // Fresh arenas, so that statements can be parsed concurrently.
+  ParserOptions options(parser_options.language_options(),
+                        parser_options.macro_catalog());
+  ParsedStatement result;
+  result.status =
+      allow_script_statements
+          ? ParseNextScriptStatement(&location, options, &result.output,
+                                     &result.at_end_of_input)
+          : ParseNextStatement(&location, options, &result.output,
+                               &result.at_end_of_input);
+  result.next_byte_position = location.byte_position();
+  return result;
+}
+
+}  // namespace
+
+absl::Status ParseStatementsInParallel(
+    ParseResumeLocation* resume_location, const ParserOptions& parser_options,
+    const ParallelParseOptions& options,
+    std::vector<std::unique_ptr<ParserOutput>>* outputs) {
+  ZETASQL_RETURN_IF_ERROR(resume_location->Validate());
+  outputs->clear();
+
+  const std::vector<int> starts =
+      FindStatementStarts(*resume_location, parser_options.language_options());
+  std::vector<ParsedStatement> parsed(starts.size());
+  std::atomic<int> next_index(0);
+  auto parse_statements = [&]() {
+    for (int i = next_index++; i < starts.size(); i = next_index++) {
+      parsed[i] = ParseStatementAt(*resume_location, starts[i], parser_options,
+                                   options.allow_script_statements);
+    }
+  };
+  const int num_threads =
+      std::min<int>(options.num_threads, static_cast<int>(starts.size()));
+  std::vector<std::thread> threads;
+  threads.reserve(std::max(num_threads - 1, 0));
+  for (int i = 1; i < num_threads; ++i) {
+    threads.emplace_back(parse_statements);
+  }
+  parse_statements();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  // Chain the statements from the first one on. 'starts' is sorted.
+  bool at_end_of_input = false;
+  while (!at_end_of_input) {
+    const int byte_position = resume_location->byte_position();
+    auto it = std::lower_bound(starts.begin(), starts.end(), byte_position);
+    ParsedStatement statement;
+    if (it != starts.end() && *it == byte_position) {
+      statement = std::move(parsed[it - starts.begin()]);
+    } else {
+      // The previous statement contained a ";".
+      statement = ParseStatementAt(*resume_location, byte_position,
+                                   parser_options,
+                                   options.allow_script_statements);
+    }
+    ZETASQL_RETURN_IF_ERROR(statement.status);
+    outputs->push_back(std::move(statement.output));
+    resume_location->set_byte_position(statement.next_byte_position);
+    at_end_of_input = statement.at_end_of_input;
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace zetasql
@@ -0,0 +1,67 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PARSER_PARALLEL_PARSE_H_
+#define ZETASQL_PARSER_PARALLEL_PARSE_H_
+
+#include <memory>
+#include <vector>
+
+#include "zetasql/parser/parser.h"
+#include "zetasql/public/parse_resume_location.h"
+#include "absl/status/status.h"
+
+namespace zetasql {
+
+struct ParallelParseOptions {
+  // The maximum number of threads to parse with, including the calling
+  // thread. Values <= 1 parse on the calling thread only.
+  int num_threads = 1;
+
+  // Whether to parse like ParseNextScriptStatement() rather than
+  // ParseNextStatement().
+  bool allow_script_statements = false;
+};
+
+// Parses all the statements of <resume_location>, from its byte position to
+// the end of its input, into <outputs>, like calling ParseNextStatement() (or
+// ParseNextScriptStatement()) in a loop, but using up to
+// <options.num_threads> threads. This is meant for long scripts, e.g. schema
+// migrations with many thousands of statements.
+//
+// The input is first split into segments at each ";" token, which only takes
+// a tokenization pass, and each segment is parsed on its own from where it
+// starts. Since the parser itself determines where a statement ends, the
+// outputs are then chained from the first statement on, and any statement
+// that does not start at a segment boundary (e.g. one after a BEGIN...END
+// block containing ";") is parsed again from where the previous one ended.
+// The outputs are thus always those of the sequential loop, in order, and
+// the speculative work is only wasted for statements that contain ";".
+//
+// Each output owns its own arena and IdStringPool; those of <parser_options>
+// are not used, so that statements can be parsed concurrently.
+//
+// Like the loop, stops at the first statement that fails to parse and returns
+// its error, with the outputs of the statements before it in <outputs>. On
+// success, <resume_location> is at the end of the input.
+absl::Status ParseStatementsInParallel(
+    ParseResumeLocation* resume_location, const ParserOptions& parser_options,
+    const ParallelParseOptions& options,
+    std::vector<std::unique_ptr<ParserOutput>>* outputs);
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PARSER_PARALLEL_PARSE_H_
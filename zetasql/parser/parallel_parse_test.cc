@@ -0,0 +1,135 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/parser/parallel_parse.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/parser/parser.h"
+#include "zetasql/public/language_options.h"
+#include "zetasql/public/parse_resume_location.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+
+namespace zetasql {
+namespace {
+
+using ::zetasql_base::testing::StatusIs;
+
+// Returns the debug strings of the statements of 'script', parsed one after
+// another.
+std::vector<std::string> ParseSequentially(absl::string_view script,
+                                           bool allow_script_statements) {
+  ParseResumeLocation resume_location =
+      ParseResumeLocation::FromStringView(script);
+  ParserOptions options{LanguageOptions()};
+  std::vector<std::string> statements;
+  bool at_end_of_input = false;
+  while (!at_end_of_input) {
+    std::unique_ptr<ParserOutput> output;
+    absl::Status status =
+        allow_script_statements
+            ? ParseNextScriptStatement(&resume_location, options, &output,
+                                       &at_end_of_input)
+            : ParseNextStatement(&resume_location, options, &output,
+                                 &at_end_of_input);
+    if (!status.ok()) break;
+    statements.push_back(output->statement()->DebugString());
+  }
+  return statements;
+}
+
+absl::Status ParseInParallel(absl::string_view script,
+                             bool allow_script_statements, int num_threads,
+                             std::vector<std::string>* statements) {
+  ParseResumeLocation resume_location =
+      ParseResumeLocation::FromStringView(script);
+  ParallelParseOptions options;
+  options.num_threads = num_threads;
+  options.allow_script_statements = allow_script_statements;
+  std::vector<std::unique_ptr<ParserOutput>> outputs;
+  absl::Status status = ParseStatementsInParallel(
+      &resume_location, ParserOptions(LanguageOptions()), options, &outputs);
+  statements->clear();
+  for (const std::unique_ptr<ParserOutput>& output : outputs) {
+    statements->push_back(output->statement()->DebugString());
+  }
+  if (status.ok()) {
+    EXPECT_EQ(resume_location.byte_position(), script.size());
+  }
+  return status;
+}
+
+TEST(ParallelParseTest, MatchesSequentialParsing) {
+  std::string many_statements;
+  for (int i = 0; i < 200; ++i) {
+    absl::StrAppend(&many_statements, "SELECT ", i, " AS x;\n");
+  }
+  for (const absl::string_view script :
+       {absl::string_view("SELECT 1"), absl::string_view("SELECT 1;  -- end"),
+        absl::string_view("SELECT ';' ; /* ; */ SELECT 2; DROP TABLE t"),
+        absl::string_view(many_statements)}) {
+    for (int num_threads : {1, 4}) {
+      std::vector<std::string> statements;
+      ZETASQL_ASSERT_OK(ParseInParallel(script, /*allow_script_statements=*/false,
+                                num_threads, &statements));
+      EXPECT_EQ(statements,
+                ParseSequentially(script, /*allow_script_statements=*/false))
+          << script;
+    }
+  }
+}
+
+TEST(ParallelParseTest, StatementsContainingSemicolons) {
+  const absl::string_view script =
+      "SELECT 1;\n"
+      "BEGIN SELECT 2; SELECT 3; END;\n"
+      "IF TRUE THEN SELECT 4; ELSE SELECT 5; END IF;\n"
+      "SELECT 6";
+  std::vector<std::string> statements;
+  ZETASQL_ASSERT_OK(ParseInParallel(script, /*allow_script_statements=*/true,
+                            /*num_threads=*/4, &statements));
+  EXPECT_EQ(statements.size(), 4);
+  EXPECT_EQ(statements,
+            ParseSequentially(script, /*allow_script_statements=*/true));
+}
+
+TEST(ParallelParseTest, StopsAtFirstError) {
+  const absl::string_view script = "SELECT 1; SELECT FROM; SELECT 3";
+  std::vector<std::string> statements;
+  EXPECT_THAT(ParseInParallel(script, /*allow_script_statements=*/false,
+                              /*num_threads=*/4, &statements),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_EQ(statements,
+            ParseSequentially(script, /*allow_script_statements=*/false));
+  EXPECT_EQ(statements.size(), 1);
+
+  // Unclosed string literals fail to tokenize, which the parser reports.
+  EXPECT_THAT(ParseInParallel("SELECT 1; SELECT 'a",
+                              /*allow_script_statements=*/false,
+                              /*num_threads=*/4, &statements),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_EQ(statements.size(), 1);
+}
+
+}  // namespace
+}  // namespace zetasql
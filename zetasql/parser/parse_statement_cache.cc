@@ -0,0 +1,93 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/parser/parse_statement_cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "zetasql/parser/parser.h"
+#include "zetasql/base/check.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+ParseStatementCache::ParseStatementCache(int64_t capacity)
+    : capacity_(capacity) {
+  ABSL_CHECK_GT(capacity, 0);
+}
+
+absl::StatusOr<std::shared_ptr<const ParserOutput>>
+ParseStatementCache::GetOrParse(absl::string_view statement_string,
+                                const ParserOptions& parser_options,
+                                int64_t macro_catalog_version) {
+  const KeyView key{statement_string, &parser_options.language_options(),
+                    parser_options.macro_catalog(), macro_catalog_version};
+  {
+    absl::MutexLock lock(&mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      ++hits_;
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return it->second->second;
+    }
+    ++misses_;
+  }
+
+  // Parse into fresh arenas that are owned by the output alone. 'mutex_' is
+  // not held, so that other threads can look up other statements meanwhile.
+  ParserOptions options(parser_options.language_options(),
+                        parser_options.macro_catalog());
+  std::unique_ptr<ParserOutput> parser_output;
+  ZETASQL_RETURN_IF_ERROR(ParseStatement(statement_string, options, &parser_output));
+  std::shared_ptr<const ParserOutput> result = std::move(parser_output);
+
+  absl::MutexLock lock(&mutex_);
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    // Another thread parsed the same statement in the meantime.
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->second;
+  }
+  entries_.emplace_front(Key(key), result);
+  index_.emplace(entries_.front().first.view(), entries_.begin());
+  if (static_cast<int64_t>(entries_.size()) > capacity_) {
+    index_.erase(entries_.back().first.view());
+    entries_.pop_back();
+  }
+  return result;
+}
+
+int64_t ParseStatementCache::size() const {
+  absl::MutexLock lock(&mutex_);
+  return entries_.size();
+}
+
+int64_t ParseStatementCache::hits() const {
+  absl::MutexLock lock(&mutex_);
+  return hits_;
+}
+
+int64_t ParseStatementCache::misses() const {
+  absl::MutexLock lock(&mutex_);
+  return misses_;
+}
+
+}  // namespace zetasql
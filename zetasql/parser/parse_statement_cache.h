@@ -0,0 +1,130 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PARSER_PARSE_STATEMENT_CACHE_H_
+#define ZETASQL_PARSER_PARSE_STATEMENT_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "zetasql/parser/macros/macro_catalog.h"
+#include "zetasql/parser/parser.h"
+#include "zetasql/public/language_options.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+
+namespace zetasql {
+
+// A bounded, thread-safe cache of the parse trees of ParseStatement(), for
+// callers that parse the same statements over and over again.
+//
+// Entries are keyed on the exact statement text, the LanguageOptions and the
+// MacroCatalog of the ParserOptions. The MacroCatalog is compared by address,
+// so callers that modify a catalog in place must pass a new
+// 'macro_catalog_version' for the statements they parse with it afterwards.
+//
+// Each entry owns its own arena and IdStringPool; those of the ParserOptions
+// are not used. The returned ParserOutput must be treated as immutable, since
+// it may be shared with other callers, and stays valid for as long as it is
+// held, even after it was evicted. Whenever the cache is full, the least
+// recently used statement is evicted. Statements that fail to parse are not
+// cached.
+class ParseStatementCache {
+ public:
+  // 'capacity' is the maximum number of statements, and must be positive.
+  explicit ParseStatementCache(int64_t capacity);
+
+  ParseStatementCache(const ParseStatementCache&) = delete;
+  ParseStatementCache& operator=(const ParseStatementCache&) = delete;
+
+  // Returns the output of ParseStatement(<statement_string>, <parser_options>),
+  // parsing it only if it is not in the cache.
+  absl::StatusOr<std::shared_ptr<const ParserOutput>> GetOrParse(
+      absl::string_view statement_string, const ParserOptions& parser_options,
+      int64_t macro_catalog_version = 0);
+
+  // Returns the number of cached statements.
+  int64_t size() const;
+
+  // Returns how many calls to GetOrParse() found their statement in the
+  // cache, and how many had to parse it.
+  int64_t hits() const;
+  int64_t misses() const;
+
+ private:
+  // The key of a statement, pointing to its strings.
+  struct KeyView {
+    absl::string_view statement_string;
+    const LanguageOptions* language_options;
+    const parser::macros::MacroCatalog* macro_catalog;
+    int64_t macro_catalog_version;
+
+    bool operator==(const KeyView& other) const {
+      return statement_string == other.statement_string &&
+             macro_catalog == other.macro_catalog &&
+             macro_catalog_version == other.macro_catalog_version &&
+             *language_options == *other.language_options;
+    }
+
+    template <typename H>
+    friend H AbslHashValue(H h, const KeyView& key) {
+      return H::combine(std::move(h), key.statement_string,
+                        *key.language_options, key.macro_catalog,
+                        key.macro_catalog_version);
+    }
+  };
+
+  // The key of a cached statement, which owns copies of the strings.
+  struct Key {
+    explicit Key(const KeyView& view)
+        : statement_string(view.statement_string),
+          language_options(*view.language_options),
+          macro_catalog(view.macro_catalog),
+          macro_catalog_version(view.macro_catalog_version) {}
+
+    KeyView view() const {
+      return {statement_string, &language_options, macro_catalog,
+              macro_catalog_version};
+    }
+
+    std::string statement_string;
+    LanguageOptions language_options;
+    const parser::macros::MacroCatalog* macro_catalog;
+    int64_t macro_catalog_version;
+  };
+
+  using Entry = std::pair<Key, std::shared_ptr<const ParserOutput>>;
+
+  const int64_t capacity_;
+  mutable absl::Mutex mutex_;
+  // Most recently used first.
+  std::list<Entry> entries_ ABSL_GUARDED_BY(mutex_);
+  // Keyed on views of the keys in 'entries_'.
+  absl::flat_hash_map<KeyView, std::list<Entry>::iterator> index_
+      ABSL_GUARDED_BY(mutex_);
+  int64_t hits_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t misses_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PARSER_PARSE_STATEMENT_CACHE_H_
@@ -0,0 +1,106 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/parser/parse_statement_cache.h"
+
+#include <memory>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/parser/macros/macro_catalog.h"
+#include "zetasql/parser/parser.h"
+#include "zetasql/public/language_options.h"
+#include "zetasql/public/options.pb.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+
+namespace zetasql {
+namespace {
+
+using ::zetasql_base::testing::StatusIs;
+
+TEST(ParseStatementCacheTest, SharesParseTrees) {
+  ParseStatementCache cache(/*capacity=*/10);
+  ParserOptions options{LanguageOptions()};
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const ParserOutput> first,
+                       cache.GetOrParse("SELECT 1", options));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const ParserOutput> second,
+                       cache.GetOrParse("SELECT 1", options));
+  EXPECT_EQ(first, second);
+  ASSERT_NE(first->statement(), nullptr);
+  EXPECT_NE(first->arena(), options.arena());
+  EXPECT_EQ(cache.hits(), 1);
+  EXPECT_EQ(cache.misses(), 1);
+
+  // Another text or other options are other entries.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const ParserOutput> other,
+                       cache.GetOrParse("SELECT  1", options));
+  EXPECT_NE(other, first);
+  LanguageOptions language_options;
+  language_options.EnableMaximumLanguageFeatures();
+  ParserOptions other_options(language_options);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(other,
+                       cache.GetOrParse("SELECT 1", other_options));
+  EXPECT_NE(other, first);
+  EXPECT_EQ(cache.size(), 3);
+  EXPECT_EQ(cache.misses(), 3);
+}
+
+TEST(ParseStatementCacheTest, KeysOnMacroCatalogVersion) {
+  ParseStatementCache cache(/*capacity=*/10);
+  parser::macros::MacroCatalog macro_catalog;
+  ParserOptions options(LanguageOptions(), &macro_catalog);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const ParserOutput> first,
+                       cache.GetOrParse("SELECT 1", options));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::shared_ptr<const ParserOutput> second,
+      cache.GetOrParse("SELECT 1", options, /*macro_catalog_version=*/1));
+  EXPECT_NE(first, second);
+  EXPECT_EQ(cache.hits(), 0);
+}
+
+TEST(ParseStatementCacheTest, EvictsLeastRecentlyUsed) {
+  ParseStatementCache cache(/*capacity=*/2);
+  ParserOptions options{LanguageOptions()};
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const ParserOutput> one,
+                       cache.GetOrParse("SELECT 1", options));
+  ZETASQL_ASSERT_OK(cache.GetOrParse("SELECT 2", options).status());
+  ZETASQL_ASSERT_OK(cache.GetOrParse("SELECT 1", options).status());
+  ZETASQL_ASSERT_OK(cache.GetOrParse("SELECT 3", options).status());
+  EXPECT_EQ(cache.size(), 2);
+
+  // "SELECT 2" was evicted, and evicted outputs stay valid.
+  EXPECT_EQ(cache.hits(), 1);
+  ZETASQL_ASSERT_OK(cache.GetOrParse("SELECT 1", options).status());
+  EXPECT_EQ(cache.hits(), 2);
+  ZETASQL_ASSERT_OK(cache.GetOrParse("SELECT 2", options).status());
+  EXPECT_EQ(cache.hits(), 2);
+  EXPECT_NE(one->statement(), nullptr);
+}
+
+TEST(ParseStatementCacheTest, DoesNotCacheErrors) {
+  ParseStatementCache cache(/*capacity=*/10);
+  ParserOptions options{LanguageOptions()};
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_THAT(cache.GetOrParse("SELECT FROM", options),
+                StatusIs(absl::StatusCode::kInvalidArgument));
+  }
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_EQ(cache.misses(), 2);
+}
+
+}  // namespace
+}  // namespace zetasql
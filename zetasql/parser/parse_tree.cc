@@ -27,6 +27,7 @@
 #include <utility>
 #include <vector>
 
+#include "zetasql/base/arena.h"
 #include "zetasql/base/logging.h"
 #include "zetasql/common/utf_util.h"
 #include "zetasql/parser/ast_node_kind.h"
@@ -37,6 +38,7 @@
 #include "zetasql/parser/visit_result.h"
 #include "zetasql/public/parse_location.h"
 #include "zetasql/public/strings.h"
+#include "absl/algorithm/container.h"
 #include "absl/base/attributes.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/flags/flag.h"
@@ -45,6 +47,7 @@
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
+#include "absl/types/span.h"
 #include "zetasql/base/map_util.h"
 #include "zetasql/base/ret_check.h"
 #include "zetasql/base/status.h"
@@ -57,7 +60,11 @@ ABSL_FLAG(bool, output_asc_explicitly, false,
 
 namespace zetasql {
 
-ASTNode::~ASTNode() {}
+ASTNode::~ASTNode() {
+  if (arena_ == nullptr) {
+    delete[] children_;
+  }
+}
 
 // Expands parse_location_range to include expand_range.
 void ASTNode::ExpandLocationRangeEnd(const ParseLocationRange& expand_range) {
@@ -66,24 +73,54 @@ void ASTNode::ExpandLocationRangeEnd(const ParseLocationRange& expand_range) {
   }
 }
 
+void ASTNode::ReserveChildren(int min_capacity) {
+  if (min_capacity <= children_capacity_) {
+    return;
+  }
+  const int capacity = std::max(min_capacity, 2 * children_capacity_);
+  ASTNode** children =
+      arena_ != nullptr
+          ? static_cast<ASTNode**>(arena_->AllocAligned(
+                capacity * sizeof(ASTNode*), alignof(ASTNode*)))
+          : new ASTNode*[capacity];
+  std::copy_n(children_, num_children_, children);
+  if (arena_ != nullptr) {
+    if (children_ != nullptr) {
+      arena_->Free(children_, children_capacity_ * sizeof(ASTNode*));
+    }
+  } else {
+    delete[] children_;
+  }
+  children_ = children;
+  children_capacity_ = capacity;
+}
+
 void ASTNode::AddChild(ASTNode* child) {
   ABSL_DCHECK(child != nullptr);
-  children_.push_back(child);
+  ReserveChildren(num_children_ + 1);
+  children_[num_children_++] = child;
   child->set_parent(this);
   ExpandLocationRangeEnd(child->GetParseLocationRange());
 }
 
 void ASTNode::AddChildFront(ASTNode* child) {
   ABSL_DCHECK(child != nullptr);
-  children_.insert(children_.begin(), child);
+  ReserveChildren(num_children_ + 1);
+  std::copy_backward(children_, children_ + num_children_,
+                     children_ + num_children_ + 1);
+  children_[0] = child;
+  ++num_children_;
   child->set_parent(this);
   ExpandLocationRangeEnd(child->GetParseLocationRange());
 }
 
 void ASTNode::AddChildren(absl::Span<ASTNode* const> children) {
+  ReserveChildren(num_children_ +
+                  static_cast<int>(children.size() -
+                                   absl::c_count(children, nullptr)));
   for (ASTNode* child : children) {
     if (child != nullptr) {
-      children_.push_back(child);
+      children_[num_children_++] = child;
       child->set_parent(this);
       ExpandLocationRangeEnd(child->GetParseLocationRange());
     }
@@ -134,7 +171,7 @@ void ASTNode::Accept(ParseTreeVisitor* visitor, void* data) const {
 }
 
 void ASTNode::ChildrenAccept(ParseTreeVisitor* visitor, void* data) const {
-  for (int i = 0; i < children_.size(); ++i) {
+  for (int i = 0; i < num_children_; ++i) {
     children_[i]->Accept(visitor, data);
   }
 }
@@ -191,8 +228,8 @@ void ASTNode::Dumper::Dump() {
     return;
   }
   ++current_depth_;
-  const auto& children = node_->children_;
-  for (ASTNode* n : children) {
+  for (ASTNode* n :
+       absl::MakeConstSpan(node_->children_, node_->num_children_)) {
     if (n != nullptr) {
       node_ = n;
       Dump();
@@ -302,6 +302,43 @@ TEST(ParseTreeTest, NodeKindCategories_LiteralExpression) {
   EXPECT_FALSE(expr->IsTableExpression());
 }
 
+TEST(ParseTreeTest, ManyChildren) {
+  std::vector<std::string> elements;
+  for (int i = 0; i < 1000; ++i) {
+    elements.push_back(absl::StrCat(i));
+  }
+  const std::string sql =
+      absl::StrCat("SELECT x IN (", absl::StrJoin(elements, ", "), ")");
+
+  std::unique_ptr<ParserOutput> parser_output;
+  ZETASQL_ASSERT_OK(ParseStatement(sql, ParserOptions(), &parser_output));
+  std::vector<const ASTNode*> in_lists;
+  parser_output->statement()->GetDescendantsWithKinds({AST_IN_LIST},
+                                                      &in_lists);
+  ASSERT_EQ(in_lists.size(), 1);
+  const ASTInList* in_list = in_lists[0]->GetAsOrDie<ASTInList>();
+  ASSERT_EQ(in_list->num_children(), elements.size());
+  ASSERT_EQ(in_list->list().size(), elements.size());
+  for (int i = 0; i < elements.size(); ++i) {
+    EXPECT_EQ(in_list->list()[i]->GetAsOrDie<ASTIntLiteral>()->image(),
+              elements[i]);
+    EXPECT_EQ(in_list->child(i)->parent(), in_list);
+  }
+}
+
+TEST(ParseTreeTest, AddChildrenWithoutArena) {
+  ASTInList in_list;
+  ASTIntLiteral first, second, third;
+  in_list.AddChild(&second);
+  in_list.AddChildFront(&first);
+  in_list.AddChildren({nullptr, &third, nullptr});
+  ASSERT_EQ(in_list.num_children(), 3);
+  EXPECT_EQ(in_list.child(0), &first);
+  EXPECT_EQ(in_list.child(1), &second);
+  EXPECT_EQ(in_list.child(2), &third);
+  EXPECT_EQ(third.parent(), &in_list);
+}
+
 TEST(ParseTreeTest, GetDescendantsWithKinds) {
   const std::string sql =
       "select * from (select 1+0x2, x+y), "
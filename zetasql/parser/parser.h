@@ -298,6 +298,11 @@ absl::Status ParseExpression(const ParseResumeLocation& resume_location,
 // Works for any AST node.
 std::string Unparse(const ASTNode* root);
 
+// Like Unparse(), but replaces the contents of '*unparsed' with the SQL string.
+// When unparsing many statements, reusing the same string avoids allocating
+// a new buffer for each of them.
+void Unparse(const ASTNode* root, std::string* unparsed);
+
 // Parse the first few keywords from <input> (ignoring whitespace, comments and
 // hints) to determine what kind of statement it is (if it is valid).
 //
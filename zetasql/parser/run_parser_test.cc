@@ -29,6 +29,7 @@
 #include "zetasql/parser/parse_tree.h"
 #include "zetasql/parser/parse_tree_visitor.h"
 #include "zetasql/parser/parser.h"
+#include "zetasql/parser/statement_classifier.h"
 #include "zetasql/parser/statement_properties.h"
 #include "zetasql/public/error_helpers.h"
 #include "zetasql/public/language_options.h"
@@ -269,6 +270,20 @@ class RunParserTest : public ::testing::Test {
               ast_statement_properties.is_create_table_as_select)
         << test_case;
 
+    // Whenever ClassifyStatement() classifies a valid statement, it must agree
+    // with ParseNextStatementProperties().
+    if (status.ok() && mode == "statement") {
+      const parser::StatementClassification classification =
+          parser::ClassifyStatement(test_case);
+      if (classification.node_kind != kUnknownASTNodeKind) {
+        EXPECT_EQ(classification.node_kind, ast_statement_properties.node_kind)
+            << test_case;
+        EXPECT_EQ(classification.create_scope,
+                  ast_statement_properties.create_scope)
+            << test_case;
+      }
+    }
+
     HandleOneParseTree(test_case, mode, status, root, ast_statement_properties,
                        true /* is_single */, test_outputs);
   }
@@ -0,0 +1,695 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/parser/statement_classifier.h"
+
+#include <cstddef>
+
+#include "zetasql/parser/ast_node_kind.h"
+#include "zetasql/parser/parse_tree.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/string_view.h"
+
+namespace zetasql {
+namespace parser {
+
+namespace {
+
+// A token of the input, as far as the classification needs to tell tokens
+// apart.
+struct Token {
+  enum Kind {
+    kEnd,
+    // Unterminated strings, identifiers or comments.
+    kInvalid,
+    // Keywords and unquoted identifiers.
+    kWord,
+    kQuotedIdentifier,
+    kNumber,
+    kString,
+    // Any other single character.
+    kSymbol,
+  };
+
+  Kind kind = kEnd;
+  absl::string_view text;
+};
+
+bool IsWord(const Token& token, absl::string_view keyword) {
+  return token.kind == Token::kWord &&
+         absl::EqualsIgnoreCase(token.text, keyword);
+}
+
+bool IsSymbol(const Token& token, char symbol) {
+  return token.kind == Token::kSymbol && token.text[0] == symbol;
+}
+
+bool IsIdentifier(const Token& token) {
+  return token.kind == Token::kWord || token.kind == Token::kQuotedIdentifier;
+}
+
+bool IsOpeningBracket(const Token& token) {
+  return IsSymbol(token, '(') || IsSymbol(token, '[') || IsSymbol(token, '{');
+}
+
+bool IsClosingBracket(const Token& token) {
+  return IsSymbol(token, ')') || IsSymbol(token, ']') || IsSymbol(token, '}');
+}
+
+// Returns the input text from the start of <first> to the end of <last>.
+absl::string_view TextBetween(const Token& first, const Token& last) {
+  return absl::string_view(
+      first.text.data(),
+      last.text.data() + last.text.size() - first.text.data());
+}
+
+// Splits the input into tokens, skipping whitespace and comments. This is
+// only accurate enough to find the boundaries of the tokens that the
+// classification looks at, and of the hint values.
+class Scanner {
+ public:
+  explicit Scanner(absl::string_view input) : input_(input) {}
+
+  Token Next();
+
+ private:
+  // Returns false for an unterminated comment.
+  bool SkipWhitespaceAndComments();
+
+  // Skips the quoted string or identifier that starts at <pos_>. Returns
+  // false if it is unterminated.
+  bool SkipQuoted();
+
+  bool NextCharIs(char c) const {
+    return pos_ + 1 < input_.size() && input_[pos_ + 1] == c;
+  }
+
+  absl::string_view input_;
+  size_t pos_ = 0;
+};
+
+bool IsIdentifierChar(char c) { return absl::ascii_isalnum(c) || c == '_'; }
+
+bool Scanner::SkipWhitespaceAndComments() {
+  while (pos_ < input_.size()) {
+    const char c = input_[pos_];
+    if (absl::ascii_isspace(c)) {
+      ++pos_;
+    } else if (c == '#' || (c == '-' && NextCharIs('-'))) {
+      pos_ = input_.find('\n', pos_);
+      if (pos_ == absl::string_view::npos) pos_ = input_.size();
+    } else if (c == '/' && NextCharIs('*')) {
+      const size_t end = input_.find("*/", pos_ + 2);
+      if (end == absl::string_view::npos) return false;
+      pos_ = end + 2;
+    } else {
+      break;
+    }
+  }
+  return true;
+}
+
+bool Scanner::SkipQuoted() {
+  const char quote = input_[pos_];
+  const bool triple_quoted =
+      quote != '`' && NextCharIs(quote) && pos_ + 2 < input_.size() &&
+      input_[pos_ + 2] == quote;
+  pos_ += triple_quoted ? 3 : 1;
+  while (pos_ < input_.size()) {
+    const char c = input_[pos_];
+    if (c == '\\') {
+      pos_ += 2;
+      continue;
+    }
+    if (c == quote &&
+        (!triple_quoted || (NextCharIs(quote) && pos_ + 2 < input_.size() &&
+                            input_[pos_ + 2] == quote))) {
+      pos_ += triple_quoted ? 3 : 1;
+      return true;
+    }
+    if (c == '\n' && !triple_quoted) return false;
+    ++pos_;
+  }
+  return false;
+}
+
+Token Scanner::Next() {
+  if (!SkipWhitespaceAndComments()) return {Token::kInvalid, {}};
+  if (pos_ >= input_.size()) return {Token::kEnd, {}};
+  const size_t start = pos_;
+  const char c = input_[pos_];
+  Token::Kind kind;
+  if (absl::ascii_isalpha(c) || c == '_') {
+    while (pos_ < input_.size() && IsIdentifierChar(input_[pos_])) ++pos_;
+    kind = Token::kWord;
+    // String and bytes literals can have r, b, rb and br prefixes.
+    if (pos_ < input_.size() && (input_[pos_] == '\'' || input_[pos_] == '"') &&
+        pos_ - start <= 2 &&
+        input_.substr(start, pos_ - start).find_first_not_of("rRbB") ==
+            absl::string_view::npos) {
+      if (!SkipQuoted()) return {Token::kInvalid, {}};
+      kind = Token::kString;
+    }
+  } else if (absl::ascii_isdigit(c)) {
+    while (pos_ < input_.size() &&
+           (IsIdentifierChar(input_[pos_]) || input_[pos_] == '.')) {
+      ++pos_;
+    }
+    kind = Token::kNumber;
+  } else if (c == '\'' || c == '"' || c == '`') {
+    if (!SkipQuoted()) return {Token::kInvalid, {}};
+    kind = c == '`' ? Token::kQuotedIdentifier : Token::kString;
+  } else {
+    ++pos_;
+    kind = Token::kSymbol;
+  }
+  return {kind, input_.substr(start, pos_ - start)};
+}
+
+bool IsQueryStart(const Token& token) {
+  return IsWord(token, "SELECT") || IsWord(token, "WITH") ||
+         IsWord(token, "FROM");
+}
+
+// Returns <value> without the parentheses around it, since the parser does
+// not include those in the location of a parenthesized expression. Those of
+// subqueries and struct constructors are kept, since they are part of the
+// expression.
+absl::string_view StripParentheses(absl::string_view value) {
+  {
+    Scanner scanner(value);
+    Token token = scanner.Next();
+    while (IsSymbol(token, '(')) token = scanner.Next();
+    if (IsQueryStart(token)) return value;
+  }
+  while (true) {
+    Scanner scanner(value);
+    if (!IsSymbol(scanner.Next(), '(')) return value;
+    const Token first = scanner.Next();
+    Token last;
+    int depth = 1;
+    for (Token token = first;; token = scanner.Next()) {
+      if (token.kind == Token::kEnd || token.kind == Token::kInvalid) {
+        return value;
+      }
+      if (IsOpeningBracket(token)) {
+        ++depth;
+      } else if (IsClosingBracket(token) && --depth == 0) {
+        break;
+      } else if (depth == 1 && IsSymbol(token, ',')) {
+        return value;
+      }
+      last = token;
+    }
+    if (last.text.empty() || scanner.Next().kind != Token::kEnd) {
+      return value;
+    }
+    value = TextBetween(first, last);
+  }
+}
+
+// Parses the statement level hint that starts with the "@" in <token>, and
+// sets <token> to the token after it. Returns false if the hint is malformed.
+bool ParseHint(Scanner* scanner, Token* token,
+               absl::InlinedVector<StatementHintEntry, 4>* hints) {
+  // The hint is "@<integer>", "@<integer> @{<entries>}" or "@{<entries>}".
+  *token = scanner->Next();
+  if (token->kind == Token::kNumber) {
+    *token = scanner->Next();
+    if (!IsSymbol(*token, '@')) return true;
+    *token = scanner->Next();
+  }
+  if (!IsSymbol(*token, '{')) return false;
+  while (true) {
+    StatementHintEntry entry;
+    *token = scanner->Next();
+    if (!IsIdentifier(*token)) return false;
+    entry.name = token->text;
+    *token = scanner->Next();
+    if (IsSymbol(*token, '.')) {
+      entry.qualifier = entry.name;
+      *token = scanner->Next();
+      if (!IsIdentifier(*token)) return false;
+      entry.name = token->text;
+      *token = scanner->Next();
+    }
+    if (!IsSymbol(*token, '=')) return false;
+
+    // The value ends at the first "," or "}" outside of brackets.
+    const Token first = scanner->Next();
+    Token last;
+    int depth = 0;
+    for (*token = first;; *token = scanner->Next()) {
+      if (token->kind == Token::kEnd || token->kind == Token::kInvalid) {
+        return false;
+      }
+      if (depth == 0 && (IsSymbol(*token, ',') || IsSymbol(*token, '}'))) {
+        break;
+      }
+      if (IsOpeningBracket(*token)) {
+        ++depth;
+      } else if (IsClosingBracket(*token)) {
+        if (--depth < 0) return false;
+      }
+      last = *token;
+    }
+    if (last.text.empty()) return false;
+    entry.value = StripParentheses(TextBetween(first, last));
+    hints->push_back(entry);
+    if (IsSymbol(*token, '}')) break;
+  }
+  *token = scanner->Next();
+  return true;
+}
+
+// The first few tokens of a statement after its hint, which are read on
+// demand.
+class StatementPrefix {
+ public:
+  StatementPrefix(Scanner* scanner, const Token& first) : scanner_(scanner) {
+    tokens_[0] = first;
+  }
+
+  // Returns the token at <index>, or an end token if <index> is past the
+  // tokens that are looked at.
+  const Token& Get(int index) {
+    if (index >= kMaxTokens) return end_token_;
+    while (num_tokens_ <= index) {
+      const Token& previous = tokens_[num_tokens_ - 1];
+      tokens_[num_tokens_++] =
+          previous.kind == Token::kEnd || previous.kind == Token::kInvalid
+              ? previous
+              : scanner_->Next();
+    }
+    return tokens_[index];
+  }
+
+  bool IsWord(int index, absl::string_view keyword) {
+    return parser::IsWord(Get(index), keyword);
+  }
+
+  // Returns whether the tokens starting at <index> are the non-empty
+  // <keywords>, up to the first empty one.
+  template <int kNumKeywords>
+  bool AreWords(int index, const absl::string_view (&keywords)[kNumKeywords]) {
+    for (int i = 0; i < kNumKeywords && !keywords[i].empty(); ++i) {
+      if (!IsWord(index + i, keywords[i])) return false;
+    }
+    return true;
+  }
+
+ private:
+  static constexpr int kMaxTokens = 8;
+
+  Scanner* scanner_;
+  Token tokens_[kMaxTokens];
+  int num_tokens_ = 1;
+  const Token end_token_;
+};
+
+// A statement kind that is told by a fixed sequence of keywords.
+struct KeywordRule {
+  absl::string_view keywords[5];
+  ASTNodeKind node_kind;
+};
+
+// This follows the next_statement_kind_without_hint rule of the grammar.
+// Rules for longer sequences come before those for their prefixes.
+constexpr KeywordRule kStatementRules[] = {
+    {{"SELECT"}, ASTQueryStatement::kConcreteNodeKind},
+    {{"WITH"}, ASTQueryStatement::kConcreteNodeKind},
+    {{"FROM"}, ASTQueryStatement::kConcreteNodeKind},
+    {{"GRAPH"}, ASTQueryStatement::kConcreteNodeKind},
+    {{"INSERT"}, ASTInsertStatement::kConcreteNodeKind},
+    {{"UPDATE"}, ASTUpdateStatement::kConcreteNodeKind},
+    {{"DELETE"}, ASTDeleteStatement::kConcreteNodeKind},
+    {{"MERGE"}, ASTMergeStatement::kConcreteNodeKind},
+    {{"TRUNCATE"}, ASTTruncateStatement::kConcreteNodeKind},
+    {{"EXPLAIN"}, ASTExplainStatement::kConcreteNodeKind},
+    {{"DEFINE", "TABLE"}, ASTDefineTableStatement::kConcreteNodeKind},
+    {{"DEFINE", "MACRO"}, ASTDefineMacroStatement::kConcreteNodeKind},
+    {{"EXECUTE", "IMMEDIATE"},
+     ASTExecuteImmediateStatement::kConcreteNodeKind},
+    {{"EXPORT", "DATA"}, ASTExportDataStatement::kConcreteNodeKind},
+    {{"EXPORT", "MODEL"}, ASTExportModelStatement::kConcreteNodeKind},
+    {{"EXPORT", "TABLE", "METADATA"},
+     ASTExportMetadataStatement::kConcreteNodeKind},
+    {{"EXPORT", "TABLE", "FUNCTION", "METADATA"},
+     ASTExportMetadataStatement::kConcreteNodeKind},
+    {{"CLONE", "DATA"}, ASTCloneDataStatement::kConcreteNodeKind},
+    {{"LOAD", "DATA"}, ASTAuxLoadDataStatement::kConcreteNodeKind},
+    {{"DESCRIBE"}, ASTDescribeStatement::kConcreteNodeKind},
+    {{"DESC"}, ASTDescribeStatement::kConcreteNodeKind},
+    {{"SHOW"}, ASTShowStatement::kConcreteNodeKind},
+    {{"DROP", "PRIVILEGE"},
+     ASTDropPrivilegeRestrictionStatement::kConcreteNodeKind},
+    {{"DROP", "ALL", "ROW", "ACCESS", "POLICIES"},
+     ASTDropAllRowAccessPoliciesStatement::kConcreteNodeKind},
+    {{"DROP", "ALL", "ROW", "POLICIES"},
+     ASTDropAllRowAccessPoliciesStatement::kConcreteNodeKind},
+    {{"DROP", "ROW", "ACCESS", "POLICY"},
+     ASTDropRowAccessPolicyStatement::kConcreteNodeKind},
+    {{"DROP", "SEARCH", "INDEX"},
+     ASTDropSearchIndexStatement::kConcreteNodeKind},
+    {{"DROP", "VECTOR", "INDEX"},
+     ASTDropVectorIndexStatement::kConcreteNodeKind},
+    {{"DROP", "TABLE", "FUNCTION"},
+     ASTDropTableFunctionStatement::kConcreteNodeKind},
+    {{"DROP", "TABLE"}, ASTDropStatement::kConcreteNodeKind},
+    {{"DROP", "SNAPSHOT", "TABLE"},
+     ASTDropSnapshotTableStatement::kConcreteNodeKind},
+    {{"DROP", "FUNCTION"}, ASTDropFunctionStatement::kConcreteNodeKind},
+    {{"DROP", "MATERIALIZED", "VIEW"},
+     ASTDropMaterializedViewStatement::kConcreteNodeKind},
+    {{"GRANT"}, ASTGrantStatement::kConcreteNodeKind},
+    {{"REVOKE"}, ASTRevokeStatement::kConcreteNodeKind},
+    {{"RENAME"}, ASTRenameStatement::kConcreteNodeKind},
+    {{"START", "BATCH"}, ASTStartBatchStatement::kConcreteNodeKind},
+    {{"START"}, ASTBeginStatement::kConcreteNodeKind},
+    {{"BEGIN"}, ASTBeginStatement::kConcreteNodeKind},
+    {{"COMMIT"}, ASTCommitStatement::kConcreteNodeKind},
+    {{"ROLLBACK"}, ASTRollbackStatement::kConcreteNodeKind},
+    {{"RUN", "BATCH"}, ASTRunBatchStatement::kConcreteNodeKind},
+    {{"ABORT", "BATCH"}, ASTAbortBatchStatement::kConcreteNodeKind},
+    {{"ALTER", "APPROX", "VIEW"},
+     ASTAlterApproxViewStatement::kConcreteNodeKind},
+    {{"ALTER", "DATABASE"}, ASTAlterDatabaseStatement::kConcreteNodeKind},
+    {{"ALTER", "SCHEMA"}, ASTAlterSchemaStatement::kConcreteNodeKind},
+    {{"ALTER", "EXTERNAL", "SCHEMA"},
+     ASTAlterExternalSchemaStatement::kConcreteNodeKind},
+    {{"ALTER", "TABLE"}, ASTAlterTableStatement::kConcreteNodeKind},
+    {{"ALTER", "PRIVILEGE"},
+     ASTAlterPrivilegeRestrictionStatement::kConcreteNodeKind},
+    {{"ALTER", "ROW"}, ASTAlterRowAccessPolicyStatement::kConcreteNodeKind},
+    {{"ALTER", "ALL", "ROW", "ACCESS", "POLICIES"},
+     ASTAlterAllRowAccessPoliciesStatement::kConcreteNodeKind},
+    {{"ALTER", "VIEW"}, ASTAlterViewStatement::kConcreteNodeKind},
+    {{"ALTER", "MATERIALIZED", "VIEW"},
+     ASTAlterMaterializedViewStatement::kConcreteNodeKind},
+    {{"ALTER", "MODEL"}, ASTAlterModelStatement::kConcreteNodeKind},
+    {{"CREATE", "DATABASE"}, ASTCreateDatabaseStatement::kConcreteNodeKind},
+    {{"CALL"}, ASTCallStatement::kConcreteNodeKind},
+    {{"RETURN"}, ASTReturnStatement::kConcreteNodeKind},
+    {{"IMPORT"}, ASTImportStatement::kConcreteNodeKind},
+    {{"MODULE"}, ASTModuleStatement::kConcreteNodeKind},
+    {{"ANALYZE"}, ASTAnalyzeStatement::kConcreteNodeKind},
+    {{"ASSERT"}, ASTAssertStatement::kConcreteNodeKind},
+    {{"IF"}, ASTIfStatement::kConcreteNodeKind},
+    {{"WHILE"}, ASTWhileStatement::kConcreteNodeKind},
+    {{"LOOP"}, ASTWhileStatement::kConcreteNodeKind},
+    {{"DECLARE"}, ASTVariableDeclaration::kConcreteNodeKind},
+    {{"BREAK"}, ASTBreakStatement::kConcreteNodeKind},
+    {{"LEAVE"}, ASTBreakStatement::kConcreteNodeKind},
+    {{"CONTINUE"}, ASTContinueStatement::kConcreteNodeKind},
+    {{"ITERATE"}, ASTContinueStatement::kConcreteNodeKind},
+    {{"RAISE"}, ASTRaiseStatement::kConcreteNodeKind},
+    {{"FOR"}, ASTForInStatement::kConcreteNodeKind},
+    {{"REPEAT"}, ASTRepeatStatement::kConcreteNodeKind},
+};
+
+// The statements that follow "CREATE" and its OR REPLACE and scope
+// modifiers.
+struct CreateRule {
+  absl::string_view keywords[4];
+  ASTNodeKind node_kind;
+  // Whether the statement can have a scope.
+  bool has_scope;
+};
+
+constexpr CreateRule kCreateRules[] = {
+    {{"CONSTANT"}, ASTCreateConstantStatement::kConcreteNodeKind, true},
+    {{"AGGREGATE", "CONSTANT"},
+     ASTCreateConstantStatement::kConcreteNodeKind, true},
+    {{"FUNCTION"}, ASTCreateFunctionStatement::kConcreteNodeKind, true},
+    {{"AGGREGATE", "FUNCTION"},
+     ASTCreateFunctionStatement::kConcreteNodeKind, true},
+    {{"PROCEDURE"}, ASTCreateProcedureStatement::kConcreteNodeKind, true},
+    {{"TABLE", "FUNCTION"},
+     ASTCreateTableFunctionStatement::kConcreteNodeKind, true},
+    {{"TABLE"}, ASTCreateTableStatement::kConcreteNodeKind, true},
+    {{"MODEL"}, ASTCreateModelStatement::kConcreteNodeKind, true},
+    {{"EXTERNAL", "TABLE"},
+     ASTCreateExternalTableStatement::kConcreteNodeKind, true},
+    {{"EXTERNAL", "SCHEMA"},
+     ASTCreateExternalSchemaStatement::kConcreteNodeKind, true},
+    {{"VIEW"}, ASTCreateViewStatement::kConcreteNodeKind, true},
+    {{"RECURSIVE", "VIEW"}, ASTCreateViewStatement::kConcreteNodeKind, true},
+    {{"SCHEMA"}, ASTCreateSchemaStatement::kConcreteNodeKind, false},
+    {{"PRIVILEGE"},
+     ASTCreatePrivilegeRestrictionStatement::kConcreteNodeKind, false},
+    {{"ROW", "POLICY"},
+     ASTCreateRowAccessPolicyStatement::kConcreteNodeKind, false},
+    {{"ROW", "ACCESS", "POLICY"},
+     ASTCreateRowAccessPolicyStatement::kConcreteNodeKind, false},
+    {{"APPROX", "VIEW"},
+     ASTCreateApproxViewStatement::kConcreteNodeKind, false},
+    {{"APPROX", "RECURSIVE", "VIEW"},
+     ASTCreateApproxViewStatement::kConcreteNodeKind, false},
+    {{"MATERIALIZED", "VIEW"},
+     ASTCreateMaterializedViewStatement::kConcreteNodeKind, false},
+    {{"MATERIALIZED", "RECURSIVE", "VIEW"},
+     ASTCreateMaterializedViewStatement::kConcreteNodeKind, false},
+    {{"SNAPSHOT", "SCHEMA"},
+     ASTCreateSnapshotStatement::kConcreteNodeKind, false},
+    {{"SNAPSHOT", "TABLE"},
+     ASTCreateSnapshotTableStatement::kConcreteNodeKind, false},
+};
+
+// The schema_object_kind rule of the grammar.
+constexpr absl::string_view kSchemaObjectKinds[][2] = {
+    {"AGGREGATE", "FUNCTION"},
+    {"APPROX", "VIEW"},
+    {"CONSTANT"},
+    {"DATABASE"},
+    {"EXTERNAL", "TABLE"},
+    {"EXTERNAL", "SCHEMA"},
+    {"FUNCTION"},
+    {"INDEX"},
+    {"MATERIALIZED", "VIEW"},
+    {"MODEL"},
+    {"PROCEDURE"},
+    {"SCHEMA"},
+    {"VIEW"},
+};
+
+bool IsSchemaObjectKind(StatementPrefix& prefix, int index) {
+  for (const auto& keywords : kSchemaObjectKinds) {
+    if (prefix.AreWords(index, keywords)) return true;
+  }
+  return false;
+}
+
+ASTNodeKind ClassifyCreate(StatementPrefix& prefix,
+                           ASTCreateStatement::Scope* create_scope) {
+  int index = 1;
+  if (prefix.IsWord(index, "OR") && prefix.IsWord(index + 1, "REPLACE")) {
+    index += 2;
+  }
+  ASTCreateStatement::Scope scope = ASTCreateStatement::DEFAULT_SCOPE;
+  if (prefix.IsWord(index, "TEMP") || prefix.IsWord(index, "TEMPORARY")) {
+    scope = ASTCreateStatement::TEMPORARY;
+  } else if (prefix.IsWord(index, "PUBLIC")) {
+    scope = ASTCreateStatement::PUBLIC;
+  } else if (prefix.IsWord(index, "PRIVATE")) {
+    scope = ASTCreateStatement::PRIVATE;
+  }
+  if (scope != ASTCreateStatement::DEFAULT_SCOPE) {
+    ++index;
+  }
+  for (const CreateRule& rule : kCreateRules) {
+    if (prefix.AreWords(index, rule.keywords)) {
+      if (!rule.has_scope && scope != ASTCreateStatement::DEFAULT_SCOPE) {
+        return kUnknownASTNodeKind;
+      }
+      *create_scope = scope;
+      return rule.node_kind;
+    }
+  }
+  if (scope != ASTCreateStatement::DEFAULT_SCOPE) {
+    return kUnknownASTNodeKind;
+  }
+  // CREATE [UNIQUE] [NULL_FILTERED] [SEARCH | VECTOR] INDEX
+  if (prefix.IsWord(index, "UNIQUE")) ++index;
+  if (prefix.IsWord(index, "NULL_FILTERED")) ++index;
+  if (prefix.IsWord(index, "SEARCH") || prefix.IsWord(index, "VECTOR")) {
+    ++index;
+  }
+  if (prefix.IsWord(index, "INDEX")) {
+    return ASTCreateIndexStatement::kConcreteNodeKind;
+  }
+  // Anything else would be a generic entity type.
+  return kUnknownASTNodeKind;
+}
+
+ASTNodeKind ClassifySet(StatementPrefix& prefix) {
+  if (prefix.IsWord(1, "TRANSACTION") && IsIdentifier(prefix.Get(2))) {
+    return ASTSetTransactionStatement::kConcreteNodeKind;
+  }
+  if (IsIdentifier(prefix.Get(1)) && IsSymbol(prefix.Get(2), '=')) {
+    return ASTSingleAssignment::kConcreteNodeKind;
+  }
+  if (IsSymbol(prefix.Get(1), '@')) {
+    if (IsSymbol(prefix.Get(2), '@') && IsIdentifier(prefix.Get(3))) {
+      return ASTSystemVariableAssignment::kConcreteNodeKind;
+    }
+    if (IsIdentifier(prefix.Get(2)) && IsSymbol(prefix.Get(3), '=')) {
+      return ASTParameterAssignment::kConcreteNodeKind;
+    }
+  }
+  if (IsSymbol(prefix.Get(1), '(')) {
+    return ASTAssignmentFromStruct::kConcreteNodeKind;
+  }
+  return kUnknownASTNodeKind;
+}
+
+ASTNodeKind ClassifyPrefix(StatementPrefix& prefix,
+                           ASTCreateStatement::Scope* create_scope) {
+  if (IsIdentifier(prefix.Get(0)) && IsSymbol(prefix.Get(1), ':')) {
+    // A labeled block or loop.
+    if (prefix.IsWord(2, "BEGIN")) {
+      return ASTBeginStatement::kConcreteNodeKind;
+    }
+    if (prefix.IsWord(2, "LOOP") || prefix.IsWord(2, "WHILE")) {
+      return ASTWhileStatement::kConcreteNodeKind;
+    }
+    if (prefix.IsWord(2, "FOR")) {
+      return ASTForInStatement::kConcreteNodeKind;
+    }
+    if (prefix.IsWord(2, "REPEAT")) {
+      return ASTRepeatStatement::kConcreteNodeKind;
+    }
+    return kUnknownASTNodeKind;
+  }
+  if (prefix.Get(0).kind != Token::kWord) {
+    return kUnknownASTNodeKind;
+  }
+  for (const KeywordRule& rule : kStatementRules) {
+    if (prefix.AreWords(0, rule.keywords)) {
+      return rule.node_kind;
+    }
+  }
+  if (prefix.IsWord(0, "CREATE")) {
+    return ClassifyCreate(prefix, create_scope);
+  }
+  if (prefix.IsWord(0, "DROP") && IsSchemaObjectKind(prefix, 1)) {
+    // DROP FUNCTION and DROP MATERIALIZED VIEW have their own rules above.
+    return ASTDropStatement::kConcreteNodeKind;
+  }
+  if (prefix.IsWord(0, "UNDROP") && IsSchemaObjectKind(prefix, 1)) {
+    return ASTUndropStatement::kConcreteNodeKind;
+  }
+  if (prefix.IsWord(0, "SET")) {
+    return ClassifySet(prefix);
+  }
+  return kUnknownASTNodeKind;
+}
+
+}  // namespace
+
+StatementCategory GetStatementCategory(ASTNodeKind node_kind) {
+  switch (node_kind) {
+    case kUnknownASTNodeKind:
+      return StatementCategory::kUnknown;
+    case ASTQueryStatement::kConcreteNodeKind:
+      return StatementCategory::kQuery;
+    case ASTInsertStatement::kConcreteNodeKind:
+    case ASTUpdateStatement::kConcreteNodeKind:
+    case ASTDeleteStatement::kConcreteNodeKind:
+    case ASTMergeStatement::kConcreteNodeKind:
+    case ASTTruncateStatement::kConcreteNodeKind:
+      return StatementCategory::kDml;
+    case ASTAlterAllRowAccessPoliciesStatement::kConcreteNodeKind:
+    case ASTAlterApproxViewStatement::kConcreteNodeKind:
+    case ASTAlterDatabaseStatement::kConcreteNodeKind:
+    case ASTAlterEntityStatement::kConcreteNodeKind:
+    case ASTAlterExternalSchemaStatement::kConcreteNodeKind:
+    case ASTAlterMaterializedViewStatement::kConcreteNodeKind:
+    case ASTAlterModelStatement::kConcreteNodeKind:
+    case ASTAlterPrivilegeRestrictionStatement::kConcreteNodeKind:
+    case ASTAlterRowAccessPolicyStatement::kConcreteNodeKind:
+    case ASTAlterSchemaStatement::kConcreteNodeKind:
+    case ASTAlterTableStatement::kConcreteNodeKind:
+    case ASTAlterViewStatement::kConcreteNodeKind:
+    case ASTCreateApproxViewStatement::kConcreteNodeKind:
+    case ASTCreateConstantStatement::kConcreteNodeKind:
+    case ASTCreateDatabaseStatement::kConcreteNodeKind:
+    case ASTCreateEntityStatement::kConcreteNodeKind:
+    case ASTCreateExternalSchemaStatement::kConcreteNodeKind:
+    case ASTCreateExternalTableStatement::kConcreteNodeKind:
+    case ASTCreateFunctionStatement::kConcreteNodeKind:
+    case ASTCreateIndexStatement::kConcreteNodeKind:
+    case ASTCreateMaterializedViewStatement::kConcreteNodeKind:
+    case ASTCreateModelStatement::kConcreteNodeKind:
+    case ASTCreatePrivilegeRestrictionStatement::kConcreteNodeKind:
+    case ASTCreateProcedureStatement::kConcreteNodeKind:
+    case ASTCreateRowAccessPolicyStatement::kConcreteNodeKind:
+    case ASTCreateSchemaStatement::kConcreteNodeKind:
+    case ASTCreateSnapshotStatement::kConcreteNodeKind:
+    case ASTCreateSnapshotTableStatement::kConcreteNodeKind:
+    case ASTCreateTableFunctionStatement::kConcreteNodeKind:
+    case ASTCreateTableStatement::kConcreteNodeKind:
+    case ASTCreateViewStatement::kConcreteNodeKind:
+    case ASTDefineTableStatement::kConcreteNodeKind:
+    case ASTDropAllRowAccessPoliciesStatement::kConcreteNodeKind:
+    case ASTDropEntityStatement::kConcreteNodeKind:
+    case ASTDropFunctionStatement::kConcreteNodeKind:
+    case ASTDropMaterializedViewStatement::kConcreteNodeKind:
+    case ASTDropPrivilegeRestrictionStatement::kConcreteNodeKind:
+    case ASTDropRowAccessPolicyStatement::kConcreteNodeKind:
+    case ASTDropSearchIndexStatement::kConcreteNodeKind:
+    case ASTDropSnapshotTableStatement::kConcreteNodeKind:
+    case ASTDropStatement::kConcreteNodeKind:
+    case ASTDropTableFunctionStatement::kConcreteNodeKind:
+    case ASTDropVectorIndexStatement::kConcreteNodeKind:
+    case ASTRenameStatement::kConcreteNodeKind:
+    case ASTUndropStatement::kConcreteNodeKind:
+      return StatementCategory::kDdl;
+    default:
+      return StatementCategory::kOther;
+  }
+}
+
+StatementClassification ClassifyStatement(absl::string_view sql) {
+  StatementClassification classification;
+  Scanner scanner(sql);
+  Token token = scanner.Next();
+  if (IsSymbol(token, '@') &&
+      !ParseHint(&scanner, &token, &classification.hints)) {
+    return StatementClassification();
+  }
+  ASTNodeKind node_kind = kUnknownASTNodeKind;
+  if (IsSymbol(token, '(')) {
+    // Only queries can be parenthesized.
+    while (IsSymbol(token, '(')) token = scanner.Next();
+    if (IsQueryStart(token)) {
+      node_kind = ASTQueryStatement::kConcreteNodeKind;
+    }
+  } else {
+    StatementPrefix prefix(&scanner, token);
+    node_kind = ClassifyPrefix(prefix, &classification.create_scope);
+  }
+  if (node_kind == kUnknownASTNodeKind) {
+    return StatementClassification();
+  }
+  classification.node_kind = node_kind;
+  classification.category = GetStatementCategory(node_kind);
+  return classification;
+}
+
+}  // namespace parser
+}  // namespace zetasql
@@ -0,0 +1,94 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef ZETASQL_PARSER_STATEMENT_CLASSIFIER_H_
+#define ZETASQL_PARSER_STATEMENT_CLASSIFIER_H_
+
+#include "zetasql/parser/ast_node_kind.h"
+#include "zetasql/parser/parse_tree.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/strings/string_view.h"
+
+namespace zetasql {
+namespace parser {
+
+// The broad category of a statement, e.g. for routing statements to the
+// backends that run them.
+enum class StatementCategory {
+  kUnknown,
+  kQuery,
+  // INSERT, UPDATE, DELETE, MERGE and TRUNCATE.
+  kDml,
+  // CREATE, ALTER, DROP, UNDROP, RENAME and DEFINE TABLE.
+  kDdl,
+  // All other statements, e.g. EXPLAIN, GRANT, transaction and scripting
+  // statements.
+  kOther,
+};
+
+// Returns the category of statements with parse node kind <node_kind>, which
+// must be kUnknownASTNodeKind or the kind of a statement.
+StatementCategory GetStatementCategory(ASTNodeKind node_kind);
+
+// An entry of a statement level hint, e.g. "@{qualifier.name = value}". The
+// fields point into the classified input.
+struct StatementHintEntry {
+  // As written in the input, including backquotes. <qualifier> is empty if
+  // there is none.
+  absl::string_view qualifier;
+  absl::string_view name;
+
+  // The SQL text of the value, like in
+  // ASTStatementProperties::statement_level_hints.
+  absl::string_view value;
+};
+
+struct StatementClassification {
+  // As in ASTStatementProperties. kUnknownASTNodeKind if the statement was
+  // not classified.
+  ASTNodeKind node_kind = kUnknownASTNodeKind;
+  StatementCategory category = StatementCategory::kUnknown;
+
+  // The create scope of the statement (i.e. TEMP, DEFAULT, etc.). Only
+  // applies if <node_kind> is AST_CREATE_*.
+  ASTCreateStatement::Scope create_scope = ASTCreateStatement::DEFAULT_SCOPE;
+
+  // The entries of the statement level hint, in the order they are written.
+  absl::InlinedVector<StatementHintEntry, 4> hints;
+};
+
+// Classifies the statement at the start of <sql>, from its statement level
+// hint and its first few keywords, for callers that route a lot of statements
+// before (or instead of) parsing them.
+//
+// Unlike ParseNextStatementProperties(), this does not run the tokenizer or
+// the parser, needs no arenas or LanguageOptions, and allocates nothing for
+// statements with up to four hint entries. For a valid statement, it returns
+// either the same node kind, create scope and hints as
+// ParseNextStatementProperties(), or kUnknownASTNodeKind. The latter is
+// returned for statements that cannot be told apart by their first keywords
+// alone, e.g. statements on generic entity types, whose support depends on
+// the LanguageOptions, and for input that is not a statement. Callers should
+// fall back to ParseNextStatementProperties() for those. Whether a CREATE
+// TABLE statement is CTAS is not determined, since that needs a scan of the
+// whole statement.
+StatementClassification ClassifyStatement(absl::string_view sql);
+
+}  // namespace parser
+}  // namespace zetasql
+
+#endif  // ZETASQL_PARSER_STATEMENT_CLASSIFIER_H_
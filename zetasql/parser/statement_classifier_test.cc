@@ -0,0 +1,230 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/parser/statement_classifier.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/parser/ast_node_kind.h"
+#include "zetasql/parser/parse_tree.h"
+#include "zetasql/parser/parser.h"
+#include "zetasql/parser/statement_properties.h"
+#include "zetasql/public/language_options.h"
+#include "zetasql/public/parse_resume_location.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+
+namespace zetasql {
+namespace parser {
+namespace {
+
+ASTStatementProperties ParseProperties(absl::string_view sql) {
+  LanguageOptions language_options;
+  language_options.EnableMaximumLanguageFeaturesForDevelopment();
+  ParserOptions parser_options(language_options);
+  parser_options.CreateDefaultArenasIfNotSet();
+  std::vector<std::unique_ptr<ASTNode>> allocated_ast_nodes;
+  ASTStatementProperties properties;
+  ZETASQL_EXPECT_OK(ParseNextStatementProperties(
+      ParseResumeLocation::FromStringView(sql), parser_options,
+      &allocated_ast_nodes, &properties));
+  return properties;
+}
+
+TEST(StatementClassifierTest, AgreesWithParseNextStatementProperties) {
+  for (absl::string_view sql : {
+           "SELECT 1",
+           "select * from t",
+           "WITH q AS (SELECT 1) SELECT * FROM q",
+           "((SELECT 1)) UNION ALL SELECT 2",
+           "FROM t |> WHERE true",
+           "  -- comment\n/* comment */ # comment\n SELECT 1",
+           "INSERT INTO t VALUES (1)",
+           "insert t (a) select 1",
+           "UPDATE t SET a = 1 WHERE true",
+           "DELETE FROM t WHERE true",
+           "MERGE t USING s ON true WHEN MATCHED THEN DELETE",
+           "TRUNCATE TABLE t",
+           "EXPLAIN SELECT 1",
+           "DESCRIBE t",
+           "DESC t",
+           "SHOW TABLES",
+           "DEFINE TABLE t (a=1)",
+           "EXECUTE IMMEDIATE 'SELECT 1'",
+           "EXPORT DATA AS SELECT 1",
+           "EXPORT MODEL m",
+           "EXPORT TABLE METADATA FROM t",
+           "CLONE DATA INTO t FROM s",
+           "LOAD DATA INTO t FROM FILES (uris=['a'])",
+           "CREATE DATABASE d",
+           "CREATE TABLE t (a INT64)",
+           "CREATE OR REPLACE TEMP TABLE t AS SELECT 1",
+           "CREATE TEMPORARY TABLE FUNCTION f() AS SELECT 1",
+           "CREATE PUBLIC FUNCTION f() AS (1)",
+           "CREATE PRIVATE AGGREGATE FUNCTION f(x INT64) AS (SUM(x))",
+           "CREATE TEMP CONSTANT c = 1",
+           "CREATE PROCEDURE p() BEGIN END",
+           "CREATE MODEL m",
+           "CREATE EXTERNAL TABLE t OPTIONS ()",
+           "CREATE TEMP VIEW v AS SELECT 1",
+           "CREATE RECURSIVE VIEW v AS SELECT 1",
+           "CREATE MATERIALIZED VIEW v AS SELECT 1",
+           "CREATE APPROX VIEW v AS SELECT 1",
+           "CREATE OR REPLACE SCHEMA s",
+           "CREATE SNAPSHOT TABLE t CLONE s",
+           "CREATE UNIQUE INDEX i ON t(a)",
+           "CREATE SEARCH INDEX i ON t(ALL COLUMNS)",
+           "CREATE ROW ACCESS POLICY p ON t FILTER USING (true)",
+           "CREATE PRIVILEGE RESTRICTION ON SELECT (c) ON TABLE t",
+           "ALTER TABLE t ADD COLUMN a INT64",
+           "ALTER VIEW v SET OPTIONS ()",
+           "ALTER MATERIALIZED VIEW v SET OPTIONS ()",
+           "ALTER ALL ROW ACCESS POLICIES ON t REVOKE FROM ('a')",
+           "ALTER ROW ACCESS POLICY p ON t RENAME TO q",
+           "DROP TABLE t",
+           "DROP TABLE FUNCTION f",
+           "DROP FUNCTION f",
+           "DROP AGGREGATE FUNCTION f",
+           "DROP MATERIALIZED VIEW v",
+           "DROP VIEW v",
+           "DROP SNAPSHOT TABLE t",
+           "DROP SEARCH INDEX i ON t",
+           "DROP ROW ACCESS POLICY p ON t",
+           "DROP ALL ROW ACCESS POLICIES ON t",
+           "UNDROP SCHEMA s",
+           "GRANT SELECT ON TABLE t TO 'a'",
+           "REVOKE SELECT ON TABLE t FROM 'a'",
+           "RENAME TABLE t TO s",
+           "BEGIN",
+           "START TRANSACTION",
+           "START BATCH",
+           "RUN BATCH",
+           "ABORT BATCH",
+           "COMMIT",
+           "ROLLBACK",
+           "SET TRANSACTION READ ONLY",
+           "SET x = 1",
+           "SET @p = 1",
+           "SET @@a.b = 1",
+           "SET (a, b) = (1, 2)",
+           "CALL p()",
+           "IMPORT MODULE m",
+           "MODULE m",
+           "ASSERT true",
+           "ANALYZE t",
+           "IF true THEN SELECT 1; END IF",
+           "WHILE true DO BREAK; END WHILE",
+           "LOOP LEAVE; END LOOP",
+           "REPEAT SELECT 1; UNTIL true END REPEAT",
+           "FOR x IN (SELECT 1) DO SELECT 1; END FOR",
+           "DECLARE x INT64",
+           "RAISE USING MESSAGE = 'a'",
+           "RETURN",
+           "label: BEGIN END",
+           "label: LOOP END LOOP",
+           "@5 SELECT 1",
+           "@{a = 1} SELECT 1",
+           "@5 @{a = 1, b = 'x'} SELECT 1",
+           "@{q.a = (1 + 2), b = f(x, ')'), c = ((SELECT 1)), d = ((1))} "
+           "SELECT 1",
+       }) {
+    const StatementClassification classification = ClassifyStatement(sql);
+    const ASTStatementProperties properties = ParseProperties(sql);
+    ASSERT_NE(classification.node_kind, kUnknownASTNodeKind) << sql;
+    EXPECT_EQ(classification.node_kind, properties.node_kind) << sql;
+    EXPECT_EQ(classification.create_scope, properties.create_scope) << sql;
+    absl::flat_hash_map<std::string, std::string> hints;
+    for (const StatementHintEntry& hint : classification.hints) {
+      hints.emplace(hint.qualifier.empty()
+                        ? std::string(hint.name)
+                        : absl::StrCat(hint.qualifier, ".", hint.name),
+                    std::string(hint.value));
+    }
+    EXPECT_EQ(hints, properties.statement_level_hints) << sql;
+  }
+}
+
+TEST(StatementClassifierTest, Categories) {
+  EXPECT_EQ(ClassifyStatement("SELECT 1").category, StatementCategory::kQuery);
+  EXPECT_EQ(ClassifyStatement("(WITH q AS (SELECT 1) SELECT 1)").category,
+            StatementCategory::kQuery);
+  EXPECT_EQ(ClassifyStatement("INSERT t VALUES (1)").category,
+            StatementCategory::kDml);
+  EXPECT_EQ(ClassifyStatement("TRUNCATE TABLE t").category,
+            StatementCategory::kDml);
+  EXPECT_EQ(ClassifyStatement("CREATE TEMP TABLE t (a INT64)").category,
+            StatementCategory::kDdl);
+  EXPECT_EQ(ClassifyStatement("DROP VIEW v").category, StatementCategory::kDdl);
+  EXPECT_EQ(ClassifyStatement("RENAME TABLE t TO s").category,
+            StatementCategory::kDdl);
+  EXPECT_EQ(ClassifyStatement("EXPLAIN SELECT 1").category,
+            StatementCategory::kOther);
+  EXPECT_EQ(ClassifyStatement("COMMIT").category, StatementCategory::kOther);
+  EXPECT_EQ(GetStatementCategory(ASTCreateEntityStatement::kConcreteNodeKind),
+            StatementCategory::kDdl);
+}
+
+TEST(StatementClassifierTest, HintsPointIntoTheInput) {
+  const std::string sql = "@{`quoted name` = 1, q.b = r'a}' } SELECT 1";
+  const StatementClassification classification = ClassifyStatement(sql);
+  EXPECT_EQ(classification.node_kind, ASTQueryStatement::kConcreteNodeKind);
+  ASSERT_EQ(classification.hints.size(), 2);
+  EXPECT_EQ(classification.hints[0].qualifier, "");
+  EXPECT_EQ(classification.hints[0].name, "`quoted name`");
+  EXPECT_EQ(classification.hints[0].value, "1");
+  EXPECT_EQ(classification.hints[1].qualifier, "q");
+  EXPECT_EQ(classification.hints[1].name, "b");
+  EXPECT_EQ(classification.hints[1].value, "r'a}'");
+  EXPECT_EQ(classification.hints[1].value.data(), sql.data() + sql.find("r'"));
+}
+
+TEST(StatementClassifierTest, LeavesUnknownStatementsToTheParser) {
+  for (absl::string_view sql : {
+           "",
+           "  -- only a comment",
+           "/* unterminated comment SELECT 1",
+           "1 + 2",
+           "$macro()",
+           "@{a = 1 SELECT 1",
+           "@{a = } SELECT 1",
+           "@{a = 'unterminated} SELECT 1",
+           "(INSERT t VALUES (1))",
+           // Generic entity types depend on the LanguageOptions.
+           "CREATE WIDGET w",
+           "DROP WIDGET w",
+           "ALTER WIDGET w SET OPTIONS ()",
+           // These do not have a scope.
+           "CREATE TEMP INDEX i ON t(a)",
+           "CREATE TEMP SCHEMA s",
+           "SET x",
+       }) {
+    const StatementClassification classification = ClassifyStatement(sql);
+    EXPECT_EQ(classification.node_kind, kUnknownASTNodeKind) << sql;
+    EXPECT_EQ(classification.category, StatementCategory::kUnknown) << sql;
+    EXPECT_TRUE(classification.hints.empty()) << sql;
+  }
+}
+
+}  // namespace
+}  // namespace parser
+}  // namespace zetasql
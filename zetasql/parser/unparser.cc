@@ -19,7 +19,6 @@
 #include <ctype.h>
 
 #include <cstddef>
-#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -29,34 +28,45 @@
 #include "zetasql/parser/parse_tree.h"
 #include "zetasql/public/id_string.h"
 #include "zetasql/public/options.pb.h"
+#include "zetasql/public/parse_location.h"
 #include "zetasql/public/strings.h"
 #include "zetasql/public/type.h"
 #include "zetasql/base/case.h"
 #include "absl/flags/flag.h"
 #include "zetasql/base/check.h"
-#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
-#include "zetasql/base/map_util.h"
 
 ABSL_DECLARE_FLAG(bool, output_asc_explicitly);
 
 namespace zetasql {
 
-std::string Unparse(const ASTNode* node) {
-  std::string unparsed_;
-  parser::Unparser unparser(&unparsed_);
+void Unparse(const ASTNode* node, std::string* unparsed) {
+  unparsed->clear();
+  // The output is about as long as the input, so reserving that much avoids
+  // most reallocations. A string reused across calls keeps its capacity.
+  const ParseLocationRange& range = node->GetParseLocationRange();
+  const int input_size =
+      range.end().GetByteOffset() - range.start().GetByteOffset();
+  const size_t expected_size = input_size + input_size / 4;
+  if (input_size > 0 && unparsed->capacity() < expected_size) {
+    unparsed->reserve(expected_size);
+  }
+  parser::Unparser unparser(unparsed);
   node->Accept(&unparser, nullptr);
   unparser.FlushLine();
-  return unparsed_;
+}
+
+std::string Unparse(const ASTNode* node) {
+  std::string unparsed;
+  Unparse(node, &unparsed);
+  return unparsed;
 }
 
 namespace parser {
 
-void Formatter::Indent(int spaces) {
-  absl::StrAppend(&indentation_, std::string(spaces, ' '));
-}
+void Formatter::Indent(int spaces) { indentation_.append(spaces, ' '); }
 
 void Formatter::Dedent(int spaces) {
   ABSL_CHECK_GE(indentation_.size(), spaces)  // Crash OK
@@ -67,18 +77,19 @@ void Formatter::Dedent(int spaces) {
 void Formatter::Format(absl::string_view s) {
   if (s.empty()) return;
   suppress_next_newline_ = false;
-  if (buffer_.empty()) {
+  if (LineIsEmpty()) {
     // This is treated the same as the case below when starting a new line.
-    absl::StrAppend(&buffer_, indentation_, s);
-    indentation_length_in_buffer_ = indentation_.size();
+    line_start_ = unparsed_->size();
+    absl::StrAppend(unparsed_, indentation_, s);
+    indentation_length_in_line_ = indentation_.size();
   } else {
-    // Formats according to the last char in buffer_ and first char in s.
-    char last_char = buffer_.back();
+    // Formats according to the last char in the line and first char in s.
+    char last_char = unparsed_->back();
     switch (last_char) {
       case '\n':
         // Prepends indentation when starting a new line.
-        absl::StrAppend(&buffer_, indentation_, s);
-        indentation_length_in_buffer_ = indentation_.size();
+        absl::StrAppend(unparsed_, indentation_, s);
+        indentation_length_in_line_ = indentation_.size();
         break;
       case '(':
       case '[':
@@ -87,20 +98,20 @@ void Formatter::Format(absl::string_view s) {
       case '~':
       case ' ':
         // When seeing these characters, appends s directly.
-        absl::StrAppend(&buffer_, s);
+        absl::StrAppend(unparsed_, s);
         break;
       default:
         {
           char curr_char = s[0];
           if (last_was_single_char_unary_) {
-            absl::StrAppend(&buffer_, s);
+            absl::StrAppend(unparsed_, s);
           } else if (curr_char == '(') {
             // Inserts a space if last token is a separator, otherwise regards
             // it as a function call.
             if (LastTokenIsSeparator()) {
-              absl::StrAppend(&buffer_, " ", s);
+              absl::StrAppend(unparsed_, " ", s);
             } else {
-              absl::StrAppend(&buffer_, s);
+              absl::StrAppend(unparsed_, s);
             }
           } else if (
               curr_char == ')' ||
@@ -110,17 +121,18 @@ void Formatter::Format(absl::string_view s) {
               (curr_char == '.' && last_char != ',') ||
               curr_char == ',') {
             // If s starts with these characters, appends s directly.
-            absl::StrAppend(&buffer_, s);
+            absl::StrAppend(unparsed_, s);
           } else {
             // By default, separate s from anything before with a space.
-            absl::StrAppend(&buffer_, " ", s);
+            absl::StrAppend(unparsed_, " ", s);
           }
           break;
         }
     }
   }
 
-  if (buffer_.size() >= indentation_length_in_buffer_ + kNumColumnLimit &&
+  if (unparsed_->size() - line_start_ >=
+          indentation_length_in_line_ + kNumColumnLimit &&
       LastTokenIsSeparator()) {
     FlushLine();
   }
@@ -139,7 +151,8 @@ void Formatter::FormatLine(absl::string_view s) {
 }
 
 void Formatter::AddUnary(absl::string_view s) {
-  if (last_was_single_char_unary_ && absl::EndsWith(buffer_, "-") && s == "-") {
+  if (last_was_single_char_unary_ && !LineIsEmpty() &&
+      unparsed_->back() == '-' && s == "-") {
     // Pretend it's not a unary so we don't get '--' which is a comment.
     last_was_single_char_unary_ = false;
   }
@@ -148,33 +161,45 @@ void Formatter::AddUnary(absl::string_view s) {
 }
 
 bool Formatter::LastTokenIsSeparator() {
-  // These are keywords emitted in uppercase in Unparser, so don't need to make
-  // them case insensitive.
-  static const std::set<std::string>& kWordSperarator =
-      *new std::set<std::string>({"AND", "OR", "ON", "IN", "BY"});
-  static const std::set<char>& kNonWordSperarator =
-      *new std::set<char>({',', '<', '>', '-', '+', '=', '*', '/', '%'});
-  if (buffer_.empty()) return false;
+  if (LineIsEmpty()) return false;
+  const absl::string_view line =
+      absl::string_view(*unparsed_).substr(line_start_);
   // When last token is not a word.
-  if (!isalnum(buffer_.back())) {
-    return zetasql_base::ContainsKey(kNonWordSperarator, buffer_.back());
+  if (!isalnum(line.back())) {
+    switch (line.back()) {
+      case ',':
+      case '<':
+      case '>':
+      case '-':
+      case '+':
+      case '=':
+      case '*':
+      case '/':
+      case '%':
+        return true;
+      default:
+        return false;
+    }
   }
 
-  ssize_t last_token_index = buffer_.size() - 1;
-  while (last_token_index >= 0 && isalnum(buffer_[last_token_index])) {
-    --last_token_index;
+  size_t last_token_start = line.size() - 1;
+  while (last_token_start > 0 && isalnum(line[last_token_start - 1])) {
+    --last_token_start;
   }
-  std::string last_token = buffer_.substr(last_token_index + 1);
-  return zetasql_base::ContainsKey(kWordSperarator, last_token);
+  // These are keywords emitted in uppercase in Unparser, so don't need to make
+  // them case insensitive.
+  const absl::string_view last_token = line.substr(last_token_start);
+  return last_token == "AND" || last_token == "OR" || last_token == "ON" ||
+         last_token == "IN" || last_token == "BY";
 }
 
 void Formatter::FlushLine() {
   suppress_next_newline_ = false;
-  if ((unparsed_->empty() || unparsed_->back() == '\n') && buffer_.empty()) {
+  if (LineIsEmpty() && (unparsed_->empty() || unparsed_->back() == '\n')) {
     return;
   }
-  absl::StrAppend(unparsed_, buffer_, "\n");
-  buffer_.clear();
+  unparsed_->push_back('\n');
+  line_start_ = unparsed_->size();
 }
 
 // Unparser -------------------------------------------------------------------
@@ -53,7 +53,10 @@ class Formatter {
     Formatter* formatter_;
   };
 
-  explicit Formatter(std::string* unparsed) : unparsed_(unparsed) {}
+  // Appends to '*unparsed'. Between statements, after FlushLine(), the caller
+  // may clear '*unparsed' to reuse its buffer.
+  explicit Formatter(std::string* unparsed)
+      : unparsed_(unparsed), line_start_(unparsed->size()) {}
   Formatter(const Formatter&) = delete;
   Formatter& operator=(const Formatter&) = delete;
 
@@ -81,21 +84,24 @@ class Formatter {
   // avoid it becoming '--' which marks a comment.
   void AddUnary(absl::string_view s);
 
-  // Flushes buffer_ to unparsed_, with a line break at the end.
-  // It will do nothing if it's a new line and buffer_ is empty, to avoid empty
-  // lines.
+  // Ends the current line of unparsed_ with a line break.
+  // It will do nothing if the current line is empty and follows a line break,
+  // to avoid empty lines.
   // Remember to call FlushLine() once after the whole process is over in case
-  // some content remains in buffer_.
+  // the last line has no line break yet.
   void FlushLine();
 
   // Set a flag so that if the next character is a newline, it'll be skipped.
   void SetSuppressNextNewline() { suppress_next_newline_ = true; }
 
  private:
-  // Checks if last token in buffer_ is a separator, where it is appropriate to
-  // insert a line break or a space before open paren.
+  // Checks if last token in the current line is a separator, where it is
+  // appropriate to insert a line break or a space before open paren.
   bool LastTokenIsSeparator();
 
+  // True if nothing was appended to the current line yet.
+  bool LineIsEmpty() const { return line_start_ >= unparsed_->size(); }
+
   static const int kNumColumnLimit = 100;
   static const int kDefaultNumIndentSpaces = 2;
 
@@ -105,21 +111,22 @@ class Formatter {
   // Indentation that will be prepended to a new line.
   std::string indentation_;
 
-  // Appended to unparsed_ with a line break at the end in FlushLine().
-  std::string buffer_;
-
   // If the last call to the formatter was AddUnary with a single character.
   bool last_was_single_char_unary_ = false;
 
   // If true and the next character is a newline, skip it.
   bool suppress_next_newline_ = false;
 
-  // The length of indentation at the beginning of buffer_. We have to save it
-  // in a variable since indentation_ is dynamically changing.
-  size_t indentation_length_in_buffer_;
+  // The length of indentation at the beginning of the current line. We have to
+  // save it in a variable since indentation_ is dynamically changing.
+  size_t indentation_length_in_line_ = 0;
 
-  // Unparsed result, not owned.
+  // Unparsed result, not owned. Lines are formatted in place, at the end of
+  // it, rather than in a separate buffer that is copied over.
   std::string* unparsed_;
+
+  // The offset in unparsed_ where the current line starts.
+  size_t line_start_;
 };
 
 class Unparser : public ParseTreeVisitor {
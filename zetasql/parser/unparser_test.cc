@@ -19,11 +19,14 @@
 #include <memory>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "zetasql/base/testing/status_matchers.h"
 #include "zetasql/parser/parser.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
 
 namespace zetasql {
@@ -96,4 +99,27 @@ TEST(TestUnparser, ExpressionTest) {
                     expression_string, unparsed_expression_string);
 }
 
+TEST(TestUnparser, UnparsesIntoReusedString) {
+  const std::string long_query = absl::StrCat(
+      "SELECT ", absl::StrJoin(std::vector<std::string>(200, "a + b"), ", "),
+      " FROM t");
+  std::unique_ptr<ParserOutput> long_output;
+  ZETASQL_ASSERT_OK(ParseStatement(long_query, ParserOptions(), &long_output));
+  std::unique_ptr<ParserOutput> short_output;
+  ZETASQL_ASSERT_OK(ParseStatement("SELECT * FROM foo", ParserOptions(),
+                           &short_output));
+
+  std::string unparsed = "previous contents";
+  Unparse(long_output->statement(), &unparsed);
+  EXPECT_EQ(unparsed, Unparse(long_output->statement()));
+  const size_t capacity = unparsed.capacity();
+  Unparse(short_output->statement(), &unparsed);
+  EXPECT_EQ(unparsed,
+            "SELECT\n"
+            "  *\n"
+            "FROM\n"
+            "  foo\n");
+  EXPECT_EQ(unparsed.capacity(), capacity);
+}
+
 }  // namespace zetasql
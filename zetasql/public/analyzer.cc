@@ -23,6 +23,7 @@
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "zetasql/base/arena.h"
 #include "zetasql/base/logging.h"
@@ -35,6 +36,7 @@
 #include "zetasql/analyzer/rewriters/anonymization_rewriter.h"
 #include "zetasql/common/errors.h"
 #include "zetasql/common/internal_analyzer_options.h"
+#include "zetasql/common/resolver_profile.h"
 #include "zetasql/common/status_payload_utils.h"
 #include "zetasql/common/timer_util.h"
 #include "zetasql/parser/parse_tree.h"
@@ -85,25 +87,59 @@ static void EnsureResolutionTimeInfoForEveryTable(
 static absl::Status RewriteResolvedAstImpl(
     const AnalyzerOptions& analyzer_options, absl::string_view sql,
     Catalog* catalog, TypeFactory* type_factory,
-    AnalyzerOutput& analyzer_output) {
+    AnalyzerOutput& analyzer_output,
+    ValidatedScans* validated_input = nullptr) {
   // InternalRewriteResolvedAst cannot call RegisterBuiltinRewriters because it
   // would create a dependency cycle.
   RegisterBuiltinRewriters();
   return InternalRewriteResolvedAst(analyzer_options, sql, catalog,
-                                    type_factory, analyzer_output);
+                                    type_factory, analyzer_output,
+                                    validated_input);
 }
 
-// Common post-parsing work for AnalyzeStatement() series.
+// Passes the paths in <ast_statement> that look like table and TVF names to
+// Catalog::Prefetch(). The paths are only a hint, so statements whose names
+// cannot be extracted are resolved without prefetching.
+static absl::Status PrefetchCatalogNames(absl::string_view sql,
+                                         const ASTStatement& ast_statement,
+                                         const AnalyzerOptions& options,
+                                         Catalog* catalog) {
+  TableNamesSet table_names;
+  TableNamesSet tvf_names;
+  if (!table_name_resolver::FindTables(sql, ast_statement, options,
+                                       &table_names, &tvf_names)
+           .ok() ||
+      (table_names.empty() && tvf_names.empty())) {
+    return absl::OkStatus();
+  }
+  const std::vector<std::vector<std::string>> table_paths(table_names.begin(),
+                                                          table_names.end());
+  const std::vector<std::vector<std::string>> tvf_paths(tvf_names.begin(),
+                                                        tvf_names.end());
+  return catalog->Prefetch(table_paths, tvf_paths);
+}
+
+// Common post-parsing work for AnalyzeStatement() series. If
+// <validated_scans> is non-NULL, the scans found valid are recorded in it.
 static absl::Status FinishResolveStatementImpl(
     absl::string_view sql, const ASTStatement& ast_statement,
     Resolver* resolver, const AnalyzerOptions& options, Catalog* catalog,
     TypeFactory* type_factory, AnalyzerRuntimeInfo* analyzer_runtime_info,
+    ValidatedScans* validated_scans,
     std::unique_ptr<const ResolvedStatement>* resolved_statement) {
   ZETASQL_VLOG(5) << "Parsed AST:\n" << ast_statement.DebugString();
   {
     internal::ScopedTimer scoped_resolver_timer =
         internal::MakeScopedTimerStarted(
             &analyzer_runtime_info->resolver_timed_value());
+    internal::ScopedResolverProfileCollector profile_collector(
+        options.collect_resolver_profile()
+            ? &analyzer_runtime_info->resolver_profile()
+            : nullptr);
+    if (options.prefetch_catalog_names()) {
+      ZETASQL_RETURN_IF_ERROR(
+          PrefetchCatalogNames(sql, ast_statement, options, catalog));
+    }
     ZETASQL_RETURN_IF_ERROR(
         resolver->ResolveStatement(sql, &ast_statement, resolved_statement));
   }
@@ -115,6 +151,7 @@ static absl::Status FinishResolveStatementImpl(
             &analyzer_runtime_info->validator_timed_value());
     ValidatorOptions validator_options{.allowed_hints_and_options =
                                            options.allowed_hints_and_options()};
+    validator_options.validated_scans = validated_scans;
     Validator validator(options.language(), validator_options);
     ZETASQL_RETURN_IF_ERROR(
         validator.ValidateResolvedStatement(resolved_statement->get()));
@@ -256,9 +293,16 @@ static absl::Status AnalyzeStatementHelper(
     ZETASQL_RET_CHECK(options.AllArenasAreInitialized());
     std::unique_ptr<const ResolvedStatement> resolved_statement;
     Resolver resolver(catalog, type_factory, &options);
+    ValidatedScans validated_scans;
+    ValidatedScans* validated_input =
+        options.validate_resolved_ast_incrementally() &&
+                InternalAnalyzerOptions::GetValidateResolvedAST(options) &&
+                !options.enabled_rewrites().empty()
+            ? &validated_scans
+            : nullptr;
     absl::Status status = FinishResolveStatementImpl(
         sql, ast_statement, &resolver, options, catalog, type_factory,
-        &analyzer_runtime_info, &resolved_statement);
+        &analyzer_runtime_info, validated_input, &resolved_statement);
 
     const absl::StatusOr<QueryParametersMap>& type_assignments =
         resolver.AssignTypesToUndeclaredParameters();
@@ -286,8 +330,9 @@ static absl::Status AnalyzeStatementHelper(
         *type_assignments, resolver.undeclared_positional_parameters(),
         resolver.max_column_id()
     );
-    ZETASQL_RETURN_IF_ERROR(
-        RewriteResolvedAstImpl(options, sql, catalog, type_factory, **output));
+    ZETASQL_RETURN_IF_ERROR(RewriteResolvedAstImpl(options, sql, catalog,
+                                           type_factory, **output,
+                                           validated_input));
     if (options.fields_accessed_mode() ==
         AnalyzerOptions::FieldsAccessedMode::CLEAR_FIELDS) {
       // Always clear fields before return.
@@ -303,15 +303,38 @@ absl::Status AllowedHintsAndOptions::Serialize(
 AnalyzerOptions::AnalyzerOptions() : AnalyzerOptions(LanguageOptions()) {}
 
 AnalyzerOptions::AnalyzerOptions(const LanguageOptions& language_options)
-    : data_(new Data{.language_options = language_options,
-                     .validate_resolved_ast = absl::GetFlag(
+    : data_(new Data{.validate_resolved_ast = absl::GetFlag(
                          FLAGS_zetasql_validate_resolved_ast)}) {
+  data_->shared->language_options = language_options;
   ZETASQL_CHECK_OK(FindTimeZoneByName("America/Los_Angeles",  // Crash OK
                               &data_->default_timezone));
 }
 
 AnalyzerOptions::~AnalyzerOptions() = default;
 
+std::unique_ptr<AnalyzerOptions::Data> AnalyzerOptions::CopyData(
+    const Data& data) {
+  auto copy = std::make_unique<Data>(data);
+  if (!data.shared->frozen) {
+    copy->shared = std::make_shared<SharedData>(*data.shared);
+  }
+  return copy;
+}
+
+AnalyzerOptions::SharedData& AnalyzerOptions::mutable_shared() {
+  if (data_->shared->frozen) {
+    data_->shared = std::make_shared<SharedData>(*data_->shared);
+    data_->shared->frozen = false;
+  }
+  return *data_->shared;
+}
+
+void AnalyzerOptions::Freeze() {
+  if (!data_->shared->frozen) {
+    data_->shared->frozen = true;
+  }
+}
+
 void AnalyzerOptions::CreateDefaultArenasIfNotSet() {
   if (data_->arena == nullptr) {
     data_->arena = std::make_shared<zetasql_base::UnsafeArena>(/*block_size=*/4096);
@@ -424,9 +447,9 @@ absl::Status AnalyzerOptions::Deserialize(
     result->set_allowed_hints_and_options(hints_and_options);
   }
 
-  result->data_->enabled_rewrites.clear();
+  result->mutable_shared().enabled_rewrites.clear();
   for (int rewrite : proto.enabled_rewrites()) {
-    result->data_->enabled_rewrites.insert(
+    result->mutable_shared().enabled_rewrites.insert(
         static_cast<ResolvedASTRewrite>(rewrite));
   }
 
@@ -436,7 +459,7 @@ absl::Status AnalyzerOptions::Deserialize(
   }
 
   if (proto.has_rewrite_options()) {
-    result->data_->rewrite_options = proto.rewrite_options();
+    result->mutable_shared().rewrite_options = proto.rewrite_options();
   }
 
   return absl::OkStatus();
@@ -444,7 +467,7 @@ absl::Status AnalyzerOptions::Deserialize(
 
 absl::Status AnalyzerOptions::Serialize(FileDescriptorSetMap* map,
                                         AnalyzerOptionsProto* proto) const {
-  data_->language_options.Serialize(proto->mutable_language_options());
+  data_->shared->language_options.Serialize(proto->mutable_language_options());
 
   for (const auto& param : data_->query_parameters) {
     auto* param_proto = proto->add_query_parameters();
@@ -453,7 +476,7 @@ absl::Status AnalyzerOptions::Serialize(FileDescriptorSetMap* map,
         param_proto->mutable_type(), map));
   }
 
-  for (const auto& system_variable : data_->system_variables) {
+  for (const auto& system_variable : data_->shared->system_variables) {
     auto* system_variable_proto = proto->add_system_variables();
     for (const std::string& path_part : system_variable.first) {
       system_variable_proto->add_name_path(path_part);
@@ -509,7 +532,7 @@ absl::Status AnalyzerOptions::Serialize(FileDescriptorSetMap* map,
   proto->set_replace_table_not_found_error_with_tvf_error_if_applicable(
       data_->replace_table_not_found_error_with_tvf_error_if_applicable);
 
-  ZETASQL_RETURN_IF_ERROR(data_->allowed_hints_and_options.Serialize(
+  ZETASQL_RETURN_IF_ERROR(data_->shared->allowed_hints_and_options.Serialize(
       map, proto->mutable_allowed_hints_and_options()));
 
   if (data_->parse_location_record_type != PARSE_LOCATION_RECORD_NONE) {
@@ -521,11 +544,11 @@ absl::Status AnalyzerOptions::Serialize(FileDescriptorSetMap* map,
         proto->add_target_column_types(), map));
   }
 
-  for (ResolvedASTRewrite rewrite : data_->enabled_rewrites) {
+  for (ResolvedASTRewrite rewrite : data_->shared->enabled_rewrites) {
     proto->add_enabled_rewrites(rewrite);
   }
 
-  *proto->mutable_rewrite_options() = data_->rewrite_options;
+  *proto->mutable_rewrite_options() = data_->shared->rewrite_options;
 
   return absl::OkStatus();
 }
@@ -552,7 +575,7 @@ absl::Status AnalyzerOptions::AddSystemVariable(
                           << type->TypeName(language().product_mode());
   }
 
-  if (!zetasql_base::InsertIfNotPresent(&data_->system_variables,
+  if (!zetasql_base::InsertIfNotPresent(&mutable_shared().system_variables,
                                std::make_pair(name_path, type))) {
     return MakeSqlError() << "Duplicate system variable "
                           << absl::StrJoin(name_path, ".");
@@ -722,19 +745,20 @@ void AnalyzerOptions::SetDdlPseudoColumns(
 }
 
 ParserOptions AnalyzerOptions::GetParserOptions() const {
-  return ParserOptions(id_string_pool(), arena(), &data_->language_options);
+  return ParserOptions(id_string_pool(), arena(),
+                       &data_->shared->language_options);
 }
 
 void AnalyzerOptions::enable_rewrite(ResolvedASTRewrite rewrite, bool enable) {
   if (enable) {
-    data_->enabled_rewrites.insert(rewrite);
+    mutable_shared().enabled_rewrites.insert(rewrite);
   } else {
     disable_rewrite(rewrite);
   }
 }
 
 void AnalyzerOptions::disable_rewrite(ResolvedASTRewrite rewrite) {
-  data_->enabled_rewrites.erase(rewrite);
+  mutable_shared().enabled_rewrites.erase(rewrite);
 }
 
 absl::Status AnalyzerOptions::set_default_anon_kappa_value(int64_t value) {
@@ -264,11 +264,11 @@ class AnalyzerOptions {
   AnalyzerOptions();
   explicit AnalyzerOptions(const LanguageOptions& language_options);
   AnalyzerOptions(const AnalyzerOptions& options)
-      : data_(std::make_unique<Data>(*options.data_)) {}
+      : data_(CopyData(*options.data_)) {}
   AnalyzerOptions(AnalyzerOptions&& options)
       : data_(std::move(options.data_)) {}
   AnalyzerOptions& operator=(const AnalyzerOptions& options) {
-    data_ = std::make_unique<Data>(*options.data_);
+    data_ = CopyData(*options.data_);
     return *this;
   }
   AnalyzerOptions& operator=(AnalyzerOptions&& options) {
@@ -277,6 +277,16 @@ class AnalyzerOptions {
   }
   ~AnalyzerOptions();
 
+  // Freezes the settings that usually stay the same across requests and are
+  // expensive to copy: the language options, system variables, allowed hints
+  // and options, rewrites, rewriters, annotation specs and rewrite options.
+  // Copies of frozen AnalyzerOptions share these settings instead of copying
+  // them, so per-request AnalyzerOptions can be cheaply made by copying a
+  // frozen base and then setting query parameters and other per-request
+  // options. Modifying a frozen setting in a copy, e.g. through
+  // mutable_language(), copies the shared settings for that copy only.
+  void Freeze();
+
   // Deserialize AnalyzerOptions from proto. Types will be deserialized using
   // the given TypeFactory and Descriptors from the given DescriptorPools.
   // The TypeFactory and the DescriptorPools must both outlive the result
@@ -295,28 +305,34 @@ class AnalyzerOptions {
                          AnalyzerOptionsProto* proto) const;
 
   // Options for the language.
-  const LanguageOptions& language() const { return data_->language_options; }
-  LanguageOptions* mutable_language() { return &data_->language_options; }
+  const LanguageOptions& language() const {
+    return data_->shared->language_options;
+  }
+  LanguageOptions* mutable_language() {
+    return &mutable_shared().language_options;
+  }
   void set_language(const LanguageOptions& options) {
-    data_->language_options = options;
+    mutable_shared().language_options = options;
   }
 
   // Gets the rewrite options, which will be referenced by individual resolved
   // ast rewriters.
   const RewriteOptions& get_rewrite_options() const {
-    return data_->rewrite_options;
+    return data_->shared->rewrite_options;
   }
 
-  RewriteOptions* mutable_rewrite_options() { return &data_->rewrite_options; }
+  RewriteOptions* mutable_rewrite_options() {
+    return &mutable_shared().rewrite_options;
+  }
 
   // Allows updating the set of enabled AST rewrites.
   // By default rewrites in DefaultResolvedASTRewrites() are enabled.
   // These are documented with the ResolvedASTRewrite enum.
   void set_enabled_rewrites(absl::btree_set<ResolvedASTRewrite> rewrites) {
-    data_->enabled_rewrites = std::move(rewrites);
+    mutable_shared().enabled_rewrites = std::move(rewrites);
   }
   const absl::btree_set<ResolvedASTRewrite>& enabled_rewrites() const {
-    return data_->enabled_rewrites;
+    return data_->shared->enabled_rewrites;
   }
   // Enables or disables a particular rewrite.
   void enable_rewrite(ResolvedASTRewrite rewrite, bool enable = true);
@@ -326,7 +342,7 @@ class AnalyzerOptions {
   void disable_rewrite(ResolvedASTRewrite rewrite);
   // Returns if a given AST rewrite is enabled.
   ABSL_MUST_USE_RESULT bool rewrite_enabled(ResolvedASTRewrite rewrite) const {
-    return data_->enabled_rewrites.contains(rewrite);
+    return data_->shared->enabled_rewrites.contains(rewrite);
   }
   // Returns the set of rewrites that are enabled by default.
   static absl::btree_set<ResolvedASTRewrite> DefaultRewrites();
@@ -336,17 +352,17 @@ class AnalyzerOptions {
   // If added multiple times, the rewriter will run once for each slot where it
   // was added in the sequence.
   void add_leading_rewriter(std::shared_ptr<Rewriter> rewriter) {
-    data_->leading_rewriters.push_back(std::move(rewriter));
+    mutable_shared().leading_rewriters.push_back(std::move(rewriter));
   }
   // Sets non-built-in rewriters that will be applied before all built-in
   // rewriters.
   void set_leading_rewriters(std::vector<std::shared_ptr<Rewriter>> rewriters) {
-    data_->leading_rewriters = std::move(rewriters);
+    mutable_shared().leading_rewriters = std::move(rewriters);
   }
   // Returns non-built-in rewriters that will be applied before all built-in
   // rewriters.
   const std::vector<std::shared_ptr<Rewriter>>& leading_rewriters() const {
-    return data_->leading_rewriters;
+    return data_->shared->leading_rewriters;
   }
 
   // Adds new non-built-in rewriter that will be applied after all built-in
@@ -354,18 +370,18 @@ class AnalyzerOptions {
   // If added multiple times, the rewriter will run once for each slot where it
   // was added in the sequence.
   void add_trailing_rewriter(std::shared_ptr<Rewriter> rewriter) {
-    data_->trailing_rewriters.push_back(std::move(rewriter));
+    mutable_shared().trailing_rewriters.push_back(std::move(rewriter));
   }
   // Sets non-built-in rewriters that will be applied after all built-in
   // rewriters.
   void set_trailing_rewriters(
       std::vector<std::shared_ptr<Rewriter>> rewriters) {
-    data_->trailing_rewriters = std::move(rewriters);
+    mutable_shared().trailing_rewriters = std::move(rewriters);
   }
   // Returns non-built-in rewriters that will be applied after all built-in
   // rewriters.
   const std::vector<std::shared_ptr<Rewriter>>& trailing_rewriters() const {
-    return data_->trailing_rewriters;
+    return data_->shared->trailing_rewriters;
   }
 
   // Options for Find*() name lookups into the Catalog.
@@ -669,10 +685,10 @@ class AnalyzerOptions {
   bool prune_unused_columns() const { return data_->prune_unused_columns; }
 
   void set_allowed_hints_and_options(const AllowedHintsAndOptions& allowed) {
-    data_->allowed_hints_and_options = allowed;
+    mutable_shared().allowed_hints_and_options = allowed;
   }
   const AllowedHintsAndOptions& allowed_hints_and_options() const {
-    return data_->allowed_hints_and_options;
+    return data_->shared->allowed_hints_and_options;
   }
 
   // If false (default), the analyzer will avoid adding a ResolvedCast node for
@@ -707,6 +723,39 @@ class AnalyzerOptions {
   // into target types.
   bool fold_literal_cast() const { return data_->fold_literal_cast; }
 
+  // If true, the analyzer passes the table and TVF names that appear in a
+  // statement to Catalog::Prefetch() before resolving it, so that catalogs
+  // can fetch them in one batch. Off by default, since finding the names
+  // takes an extra pass over the parse tree.
+  void set_prefetch_catalog_names(bool value) {
+    data_->prefetch_catalog_names = value;
+  }
+  bool prefetch_catalog_names() const { return data_->prefetch_catalog_names; }
+
+  // If true, the resolver counts and times its catalog lookups, signature
+  // matching, coercions and other operations, and reports them in
+  // AnalyzerRuntimeInfo::resolver_profile() and in the 'resolver_stats_by_op'
+  // of its log_entry(). Off by default, since timing every operation adds
+  // overhead to small ones.
+  void set_collect_resolver_profile(bool value) {
+    data_->collect_resolver_profile = value;
+  }
+  bool collect_resolver_profile() const {
+    return data_->collect_resolver_profile;
+  }
+
+  // If true, and the resolved AST is validated, the validation after running
+  // the rewriters skips the scans that are identical to scans already found
+  // valid after resolving, and only validates the rewritten parts of the tree.
+  // Only scans that do not depend on their enclosing nodes are skipped. Off by
+  // default, since the tree is fingerprinted to find the identical scans.
+  void set_validate_resolved_ast_incrementally(bool value) {
+    data_->validate_resolved_ast_incrementally = value;
+  }
+  bool validate_resolved_ast_incrementally() const {
+    return data_->validate_resolved_ast_incrementally;
+  }
+
   // Controls whether to preserve aliases of aggregate columns and analytic
   // function columns. This option has no effect on query semantics and just
   // changes what names are used inside ResolvedColumns.
@@ -729,9 +778,9 @@ class AnalyzerOptions {
   ParserOptions GetParserOptions() const;
 
   const SystemVariablesMap& system_variables() const {
-    return data_->system_variables;
+    return data_->shared->system_variables;
   }
-  void clear_system_variables() { data_->system_variables.clear(); }
+  void clear_system_variables() { mutable_shared().system_variables.clear(); }
   absl::Status AddSystemVariable(const std::vector<std::string>& name_path,
                                  const Type* type);
 
@@ -756,11 +805,11 @@ class AnalyzerOptions {
   }
 
   void set_annotation_specs(std::vector<AnnotationSpec*> annotation_specs) {
-    data_->annotation_specs = annotation_specs;
+    mutable_shared().annotation_specs = annotation_specs;
   }
 
   const std::vector<AnnotationSpec*>& get_annotation_specs() const {
-    return data_->annotation_specs;
+    return data_->shared->annotation_specs;
   }
 
   enum class FieldsAccessedMode {
@@ -824,6 +873,49 @@ class AnalyzerOptions {
   // when adding new fields here.
   // ======================================================================
 
+  // The options that usually stay the same across requests, and are the
+  // expensive ones to copy. Once frozen by Freeze(), a SharedData is no longer
+  // modified, and is shared by all copies of the AnalyzerOptions.
+  struct SharedData {
+    // These options determine the language that is accepted.
+    LanguageOptions language_options;
+
+    // Maps system variables to their types.
+    SystemVariablesMap system_variables;
+
+    // This specifies the set of allowed hints and options, their expected
+    // types, and whether to give errors on unrecognized names.
+    // See the class definition for details.
+    AllowedHintsAndOptions allowed_hints_and_options;
+
+    // The set of ASTRewrites that are enabled.
+    // Note that we store these as a btree_set to make the order in which the
+    // rewrites are applied consistent, and thus prevent instability in the
+    // analyzer test column ids.
+    absl::btree_set<ResolvedASTRewrite> enabled_rewrites = DefaultRewrites();
+
+    // Engine supplied rewriters that are applied before any built-in rewrites.
+    // The pointers in this vector will be dereferenced in order and the
+    // pointed-to Rewriter will run once per dereference.
+    std::vector<std::shared_ptr<Rewriter>> leading_rewriters;
+
+    // Engine supplied rewriters that are applied before any built-in rewrites.
+    // The pointers in this vector will be dereferenced in order and the
+    // pointed-to Rewriter will run once per dereference.
+    std::vector<std::shared_ptr<Rewriter>> trailing_rewriters;
+
+    // The annotations specs that are passed in and should be handled by
+    // the annotation framework.
+    std::vector<AnnotationSpec*> annotation_specs;  // Not owned.
+
+    // These options determine the behaviors of rewrites.
+    RewriteOptions rewrite_options;
+
+    // True if this SharedData is shared and must be copied before it is
+    // modified.
+    bool frozen = false;
+  };
+
   // AnalyzerOptions are frequently allocated on the stack. The huge contents
   // of this object makes for expensive stack frames, and in the recursive
   // nature of much ZetaSQL processing this becomes a problem. Therefore,
@@ -831,8 +923,7 @@ class AnalyzerOptions {
   // AnalyzerOptions was already so expensive that throwing one more heap
   // allocation into the mix was in the noise.)
   struct Data {
-    // These options determine the language that is accepted.
-    LanguageOptions language_options;
+    std::shared_ptr<SharedData> shared = std::make_shared<SharedData>();
 
     // These options are used for name lookups into the catalog, i.e., for
     // Catalog::Find*() calls.
@@ -845,9 +936,6 @@ class AnalyzerOptions {
     QueryParametersMap query_parameters;
     QueryParametersMap expression_columns;
 
-    // Maps system variables to their types.
-    SystemVariablesMap system_variables;
-
     // TODO: Clean up the legacy callback once all getters are removed.
     LookupExpressionColumnCallback lookup_expression_column_callback = nullptr;
 
@@ -971,11 +1059,6 @@ class AnalyzerOptions {
     // and then remove this option.
     bool prune_unused_columns = false;
 
-    // This specifies the set of allowed hints and options, their expected
-    // types, and whether to give errors on unrecognized names.
-    // See the class definition for details.
-    AllowedHintsAndOptions allowed_hints_and_options;
-
     // Controls whether to preserve aliases of aggregate columns and analytic
     // function columns. See set_preserve_column_aliases() for details.
     bool preserve_column_aliases = true;
@@ -983,22 +1066,6 @@ class AnalyzerOptions {
     // Target output column types for a query.
     std::vector<const Type*> target_column_types;
 
-    // The set of ASTRewrites that are enabled.
-    // Note that we store these as a btree_set to make the order in which the
-    // rewrites are applied consistent, and thus prevent instability in the
-    // analyzer test column ids.
-    absl::btree_set<ResolvedASTRewrite> enabled_rewrites = DefaultRewrites();
-
-    // Engine supplied rewriters that are applied before any built-in rewrites.
-    // The pointers in this vector will be dereferenced in order and the
-    // pointed-to Rewriter will run once per dereference.
-    std::vector<std::shared_ptr<Rewriter>> leading_rewriters;
-
-    // Engine supplied rewriters that are applied before any built-in rewrites.
-    // The pointers in this vector will be dereferenced in order and the
-    // pointed-to Rewriter will run once per dereference.
-    std::vector<std::shared_ptr<Rewriter>> trailing_rewriters;
-
     // Controls whether the analyzer will add a ResolvedCAST node for a CAST
     // operation in the query even when the source and target types are the
     // same.
@@ -1016,19 +1083,29 @@ class AnalyzerOptions {
     // Controls if CAST of literal is implicitly folded to the target type.
     bool fold_literal_cast = true;
 
-    // The annotations specs that are passed in and should be handled by
-    // the annotation framework.
-    std::vector<AnnotationSpec*> annotation_specs;  // Not owned.
+    // Controls if table and TVF names are passed to Catalog::Prefetch().
+    bool prefetch_catalog_names = false;
+
+    // Controls if the resolver records an internal::ResolverProfile.
+    bool collect_resolver_profile = false;
+
+    // Controls if the validation after rewriting skips unchanged scans.
+    bool validate_resolved_ast_incrementally = false;
 
     FieldsAccessedMode fields_accessed_mode =
         FieldsAccessedMode::LEGACY_FIELDS_ACCESSED_MODE;
 
-    // These options determine the behaviors of rewrites.
-    RewriteOptions rewrite_options;
     ErrorMessageStability error_message_stability;
   };
   std::unique_ptr<Data> data_;
 
+  // Returns a copy of <data>, which shares its SharedData only if frozen.
+  static std::unique_ptr<Data> CopyData(const Data& data);
+
+  // Returns the SharedData of these options for modification, first copying
+  // it if it is frozen.
+  SharedData& mutable_shared();
+
   // Copyable
 };
 
@@ -17,6 +17,9 @@
 #include "zetasql/public/analyzer_options.h"
 
 #include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/language_options.h"
+#include "zetasql/public/options.pb.h"
+#include "zetasql/public/types/type_factory.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -42,4 +45,26 @@ TEST(AnalyzerOptionsTest, CollateFeatureValidation) {
                                  "the ANNOTATION_FRAMEWORK language feature")));
 }
 
+TEST(AnalyzerOptionsTest, CopiesOfFrozenOptionsShareSettings) {
+  AnalyzerOptions base;
+  base.mutable_language()->EnableLanguageFeature(FEATURE_V_1_3_QUALIFY);
+  base.Freeze();
+
+  AnalyzerOptions copy = base;
+  EXPECT_EQ(&copy.language(), &base.language());
+  ZETASQL_EXPECT_OK(copy.AddQueryParameter("p", types::Int64Type()));
+  EXPECT_EQ(&copy.language(), &base.language());
+  EXPECT_TRUE(base.query_parameters().empty());
+
+  // Modifying a shared setting stops sharing it, without affecting the base.
+  copy.mutable_language()->DisableLanguageFeature(FEATURE_V_1_3_QUALIFY);
+  EXPECT_NE(&copy.language(), &base.language());
+  EXPECT_FALSE(copy.language().LanguageFeatureEnabled(FEATURE_V_1_3_QUALIFY));
+  EXPECT_TRUE(base.language().LanguageFeatureEnabled(FEATURE_V_1_3_QUALIFY));
+
+  // Copies of options that are not frozen do not share settings.
+  AnalyzerOptions copy_of_copy = copy;
+  EXPECT_NE(&copy_of_copy.language(), &copy.language());
+}
+
 }  // namespace zetasql
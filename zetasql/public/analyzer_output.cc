@@ -24,9 +24,11 @@
 #include <vector>
 
 #include "zetasql/base/enum_utils.h"
+#include "zetasql/common/resolver_profile.h"
 #include "zetasql/common/timer_util.h"
 #include "zetasql/public/proto/logging.pb.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/time/time.h"
 #include "zetasql/base/map_util.h"
@@ -111,6 +113,7 @@ void AnalyzerRuntimeInfo::AccumulateAll(const AnalyzerRuntimeInfo& rhs) {
   }
   rewriters_timed_value().Accumulate(rhs.impl_->rewriters_timed_value);
   validator_timed_value().Accumulate(rhs.impl_->validator_timed_value);
+  impl_->resolver_profile.AccumulateAll(rhs.impl_->resolver_profile);
 }
 
 // Modifies the debug-string to assume this is the accumulation of multiple
@@ -150,7 +153,7 @@ std::string AnalyzerRuntimeInfo::DebugString(
         absl::ToDoubleMicroseconds(latency) / total_runs, count_total,
         absl::ToDoubleMicroseconds(latency) / count_total);
   }
-  return absl::StrFormat(
+  std::string result = absl::StrFormat(
       R"(Sum Total    : %s
   Parser     : %s
   Resolver   : %s
@@ -163,6 +166,24 @@ std::string AnalyzerRuntimeInfo::DebugString(
       print_latency(resolver_timed_value().elapsed_duration()),
       print_latency(validator_timed_value().elapsed_duration()),
       print_latency(rewriters_timed_value().elapsed_duration()), rewriter_str);
+
+  std::string resolver_operations_str;
+  for (AnalyzerLogEntry::ResolverOperation operation :
+       zetasql_base::EnumerateEnumValues<
+           AnalyzerLogEntry::ResolverOperation>()) {
+    const internal::ResolverProfile::OperationDetails& details =
+        resolver_profile().details(operation);
+    if (details.count == 0) continue;
+    absl::StrAppendFormat(
+        &resolver_operations_str, "    %36s: %s %d\n",
+        absl::string_view(AnalyzerLogEntry::ResolverOperation_Name(operation)),
+        print_latency(details.timed_value.elapsed_duration()), details.count);
+  }
+  if (!resolver_operations_str.empty()) {
+    absl::StrAppend(&result, "\n  Resolver operations:\n",
+                    resolver_operations_str);
+  }
+  return result;
 }
 
 AnalyzerLogEntry AnalyzerRuntimeInfo::log_entry() const {
@@ -177,6 +198,18 @@ AnalyzerLogEntry AnalyzerRuntimeInfo::log_entry() const {
     *stage.mutable_value() = time.ToExecutionStatsProto();
   };
   add_timing(AnalyzerLogEntry::RESOLVER, resolver_timed_value());
+
+  for (AnalyzerLogEntry::ResolverOperation operation :
+       zetasql_base::EnumerateEnumValues<
+           AnalyzerLogEntry::ResolverOperation>()) {
+    const internal::ResolverProfile::OperationDetails& details =
+        resolver_profile().details(operation);
+    if (details.count == 0) continue;
+    auto& stats = *entry.add_resolver_stats_by_op();
+    stats.set_key(operation);
+    stats.set_count(details.count);
+    *stats.mutable_value() = details.timed_value.ToExecutionStatsProto();
+  }
   return entry;
 }
 }  // namespace zetasql
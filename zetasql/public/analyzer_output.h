@@ -23,6 +23,7 @@
 #include <vector>
 
 #include "zetasql/base/arena.h"
+#include "zetasql/common/resolver_profile.h"
 #include "zetasql/common/timer_util.h"
 #include "zetasql/parser/parser.h"
 #include "zetasql/public/analyzer_options.h"
@@ -118,6 +119,16 @@ class AnalyzerRuntimeInfo {
     return impl_->validator_timed_value;
   }
 
+  // The operations inside the resolver, which are only recorded if
+  // AnalyzerOptions::collect_resolver_profile() is true. These are not part of
+  // sum_elapsed_duration(), since they are included in the resolver time.
+  const internal::ResolverProfile& resolver_profile() const {
+    return impl_->resolver_profile;
+  }
+  internal::ResolverProfile& resolver_profile() {
+    return impl_->resolver_profile;
+  }
+
   void AccumulateAll(const AnalyzerRuntimeInfo& rhs);
 
   AnalyzerLogEntry log_entry() const;
@@ -142,6 +153,7 @@ class AnalyzerRuntimeInfo {
     internal::TimedValue rewriters_timed_value;
     internal::TimedValue validator_timed_value;
     internal::TimedValue overall_timed_value;
+    internal::ResolverProfile resolver_profile;
   };
   std::unique_ptr<Impl> impl_;
   friend class AnalyzerOutputMutator;
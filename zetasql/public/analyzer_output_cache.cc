@@ -0,0 +1,129 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/public/analyzer_output_cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "zetasql/public/analyzer.h"
+#include "zetasql/public/analyzer_options.h"
+#include "zetasql/public/analyzer_output.h"
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/base/check.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+AnalyzerOutputCache::AnalyzerOutputCache(int64_t capacity,
+                                         const AnalyzerOptions& options,
+                                         Catalog* catalog,
+                                         TypeFactory* type_factory)
+    : capacity_(capacity),
+      options_(options),
+      catalog_(catalog),
+      type_factory_(type_factory) {
+  ABSL_CHECK_GT(capacity, 0);
+  // Analysis creates fresh arenas that are owned by the output alone, so that
+  // concurrent calls can analyze with 'options_'.
+  options_.set_arena(nullptr);
+  options_.set_id_string_pool(nullptr);
+}
+
+absl::StatusOr<std::shared_ptr<const AnalyzerOutput>>
+AnalyzerOutputCache::GetOrAnalyze(absl::string_view sql) {
+  const std::optional<int64_t> version = catalog_->GetVersion();
+  {
+    absl::MutexLock lock(&mutex_);
+    if (version.has_value() &&
+        (!catalog_version_.has_value() || *version > *catalog_version_)) {
+      ClearLocked();
+      catalog_version_ = version;
+    }
+    if (version.has_value() && version == catalog_version_) {
+      auto it = index_.find(sql);
+      if (it != index_.end()) {
+        ++hits_;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->second;
+      }
+    }
+    ++misses_;
+  }
+
+  // 'mutex_' is not held, so that other threads can look up other statements
+  // meanwhile.
+  std::unique_ptr<const AnalyzerOutput> analyzer_output;
+  ZETASQL_RETURN_IF_ERROR(AnalyzeStatement(sql, options_, catalog_, type_factory_,
+                                   &analyzer_output));
+  std::shared_ptr<const AnalyzerOutput> result = std::move(analyzer_output);
+  if (!version.has_value()) {
+    return result;
+  }
+
+  absl::MutexLock lock(&mutex_);
+  if (version != catalog_version_) {
+    // The Catalog changed in the meantime.
+    return result;
+  }
+  auto it = index_.find(sql);
+  if (it != index_.end()) {
+    // Another thread analyzed the same statement in the meantime.
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->second;
+  }
+  entries_.emplace_front(std::string(sql), result);
+  index_.emplace(entries_.front().first, entries_.begin());
+  if (static_cast<int64_t>(entries_.size()) > capacity_) {
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+  return result;
+}
+
+void AnalyzerOutputCache::Clear() {
+  absl::MutexLock lock(&mutex_);
+  ClearLocked();
+}
+
+void AnalyzerOutputCache::ClearLocked() {
+  index_.clear();
+  entries_.clear();
+}
+
+int64_t AnalyzerOutputCache::size() const {
+  absl::MutexLock lock(&mutex_);
+  return entries_.size();
+}
+
+int64_t AnalyzerOutputCache::hits() const {
+  absl::MutexLock lock(&mutex_);
+  return hits_;
+}
+
+int64_t AnalyzerOutputCache::misses() const {
+  absl::MutexLock lock(&mutex_);
+  return misses_;
+}
+
+}  // namespace zetasql
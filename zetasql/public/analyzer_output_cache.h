@@ -0,0 +1,113 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef ZETASQL_PUBLIC_ANALYZER_OUTPUT_CACHE_H_
+#define ZETASQL_PUBLIC_ANALYZER_OUTPUT_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "zetasql/public/analyzer_options.h"
+#include "zetasql/public/analyzer_output.h"
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/type.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+
+namespace zetasql {
+
+// A bounded, thread-safe cache of the outputs of AnalyzeStatement(), for
+// callers that analyze the same statements against the same Catalog over and
+// over again.
+//
+// A cache analyzes with the AnalyzerOptions, Catalog and TypeFactory that it
+// is constructed with; callers that use several of those use a cache for
+// each. Entries are keyed on the exact statement text, which the parse
+// locations in the outputs refer to.
+//
+// Outputs are only reused while Catalog::GetVersion() returns the version
+// they were analyzed at. Once the version increases, all entries are dropped.
+// Nothing is cached if the Catalog has no version, nor for statements that
+// fail to analyze.
+//
+// Each analysis uses its own arena and IdStringPool; those of the
+// AnalyzerOptions are not used. The returned AnalyzerOutput must be treated
+// as immutable, since it may be shared with other callers, and stays valid
+// for as long as it is held, even after it was evicted. Whenever the cache is
+// full, the least recently used statement is evicted.
+class AnalyzerOutputCache {
+ public:
+  // 'capacity' is the maximum number of statements, and must be positive.
+  // 'catalog' and 'type_factory' must outlive the cache and all outputs that
+  // it returns.
+  AnalyzerOutputCache(int64_t capacity, const AnalyzerOptions& options,
+                      Catalog* catalog, TypeFactory* type_factory);
+
+  AnalyzerOutputCache(const AnalyzerOutputCache&) = delete;
+  AnalyzerOutputCache& operator=(const AnalyzerOutputCache&) = delete;
+
+  // Returns the output of AnalyzeStatement(<sql>, ...), analyzing it only if
+  // it is not in the cache for the current version of the Catalog.
+  absl::StatusOr<std::shared_ptr<const AnalyzerOutput>> GetOrAnalyze(
+      absl::string_view sql);
+
+  // Drops all entries, e.g. after a change that the version of the Catalog
+  // does not reflect.
+  void Clear();
+
+  // Returns the number of cached statements.
+  int64_t size() const;
+
+  // Returns how many calls to GetOrAnalyze() found their statement in the
+  // cache, and how many had to analyze it.
+  int64_t hits() const;
+  int64_t misses() const;
+
+ private:
+  using Entry = std::pair<std::string, std::shared_ptr<const AnalyzerOutput>>;
+
+  void ClearLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const int64_t capacity_;
+  // Without arenas.
+  AnalyzerOptions options_;
+  Catalog* const catalog_;
+  TypeFactory* const type_factory_;
+
+  mutable absl::Mutex mutex_;
+  // The version of the Catalog that all entries were analyzed at, once one
+  // was seen.
+  std::optional<int64_t> catalog_version_ ABSL_GUARDED_BY(mutex_);
+  // Most recently used first.
+  std::list<Entry> entries_ ABSL_GUARDED_BY(mutex_);
+  // Keyed on the statements in 'entries_'.
+  absl::flat_hash_map<absl::string_view, std::list<Entry>::iterator> index_
+      ABSL_GUARDED_BY(mutex_);
+  int64_t hits_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t misses_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_ANALYZER_OUTPUT_CACHE_H_
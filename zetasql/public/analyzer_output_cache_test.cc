@@ -0,0 +1,155 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/public/analyzer_output_cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/analyzer_options.h"
+#include "zetasql/public/analyzer_output.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/types/type_factory.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+
+namespace zetasql {
+namespace {
+
+using ::zetasql_base::testing::StatusIs;
+
+// A SimpleCatalog whose version is set by the test.
+class VersionedCatalog : public SimpleCatalog {
+ public:
+  explicit VersionedCatalog(TypeFactory* type_factory)
+      : SimpleCatalog("versioned", type_factory) {}
+
+  std::optional<int64_t> GetVersion() const override { return version_; }
+
+  void set_version(std::optional<int64_t> version) { version_ = version; }
+
+ private:
+  std::optional<int64_t> version_ = 1;
+};
+
+class AnalyzerOutputCacheTest : public ::testing::Test {
+ protected:
+  AnalyzerOutputCacheTest() : catalog_(&type_factory_) {
+    catalog_.AddOwnedTable(std::make_unique<SimpleTable>(
+        "t", std::vector<SimpleTable::NameAndType>{
+                 {"a", type_factory_.get_int64()}}));
+  }
+
+  TypeFactory type_factory_;
+  VersionedCatalog catalog_;
+  AnalyzerOptions options_;
+};
+
+TEST_F(AnalyzerOutputCacheTest, SharesOutputs) {
+  AnalyzerOutputCache cache(/*capacity=*/10, options_, &catalog_,
+                            &type_factory_);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const AnalyzerOutput> first,
+                       cache.GetOrAnalyze("SELECT a FROM t"));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const AnalyzerOutput> second,
+                       cache.GetOrAnalyze("SELECT a FROM t"));
+  EXPECT_EQ(first, second);
+  ASSERT_NE(first->resolved_statement(), nullptr);
+  EXPECT_EQ(cache.hits(), 1);
+  EXPECT_EQ(cache.misses(), 1);
+
+  // Another text is another entry.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const AnalyzerOutput> other,
+                       cache.GetOrAnalyze("SELECT  a FROM t"));
+  EXPECT_NE(other, first);
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.misses(), 2);
+}
+
+TEST_F(AnalyzerOutputCacheTest, InvalidatesOnNewCatalogVersion) {
+  AnalyzerOutputCache cache(/*capacity=*/10, options_, &catalog_,
+                            &type_factory_);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const AnalyzerOutput> first,
+                       cache.GetOrAnalyze("SELECT a FROM t"));
+  EXPECT_THAT(cache.GetOrAnalyze("SELECT b FROM u"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_EQ(cache.size(), 1);
+
+  catalog_.AddOwnedTable(std::make_unique<SimpleTable>(
+      "u", std::vector<SimpleTable::NameAndType>{
+               {"b", type_factory_.get_string()}}));
+  catalog_.set_version(2);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const AnalyzerOutput> second,
+                       cache.GetOrAnalyze("SELECT a FROM t"));
+  EXPECT_NE(first, second);
+  ZETASQL_EXPECT_OK(cache.GetOrAnalyze("SELECT b FROM u"));
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.hits(), 0);
+  // The evicted output is still valid.
+  EXPECT_NE(first->resolved_statement(), nullptr);
+
+  // An older version does not use or replace the entries.
+  catalog_.set_version(1);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const AnalyzerOutput> stale,
+                       cache.GetOrAnalyze("SELECT a FROM t"));
+  EXPECT_NE(stale, second);
+  catalog_.set_version(2);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const AnalyzerOutput> third,
+                       cache.GetOrAnalyze("SELECT a FROM t"));
+  EXPECT_EQ(third, second);
+
+  cache.Clear();
+  EXPECT_EQ(cache.size(), 0);
+}
+
+TEST_F(AnalyzerOutputCacheTest, DoesNotCacheWithoutCatalogVersion) {
+  catalog_.set_version(std::nullopt);
+  AnalyzerOutputCache cache(/*capacity=*/10, options_, &catalog_,
+                            &type_factory_);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const AnalyzerOutput> first,
+                       cache.GetOrAnalyze("SELECT a FROM t"));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const AnalyzerOutput> second,
+                       cache.GetOrAnalyze("SELECT a FROM t"));
+  EXPECT_NE(first, second);
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_EQ(cache.misses(), 2);
+}
+
+TEST_F(AnalyzerOutputCacheTest, EvictsLeastRecentlyUsed) {
+  AnalyzerOutputCache cache(/*capacity=*/2, options_, &catalog_,
+                            &type_factory_);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const AnalyzerOutput> one,
+                       cache.GetOrAnalyze("SELECT 1"));
+  ZETASQL_EXPECT_OK(cache.GetOrAnalyze("SELECT 2"));
+  ZETASQL_EXPECT_OK(cache.GetOrAnalyze("SELECT 1"));
+  ZETASQL_EXPECT_OK(cache.GetOrAnalyze("SELECT 3"));
+  EXPECT_EQ(cache.size(), 2);
+  // "SELECT 2" was evicted, "SELECT 1" was not.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const AnalyzerOutput> again,
+                       cache.GetOrAnalyze("SELECT 1"));
+  EXPECT_EQ(again, one);
+  const int64_t misses = cache.misses();
+  ZETASQL_EXPECT_OK(cache.GetOrAnalyze("SELECT 2"));
+  EXPECT_EQ(cache.misses(), misses + 1);
+}
+
+}  // namespace
+}  // namespace zetasql
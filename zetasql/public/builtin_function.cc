@@ -16,10 +16,13 @@
 
 #include "zetasql/public/builtin_function.h"
 
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
+#include <vector>
 
 #include "zetasql/common/builtin_function_internal.h"
 #include "zetasql/public/builtin_function_options.h"
@@ -29,8 +32,11 @@
 #include "absl/container/flat_hash_map.h"
 #include "zetasql/base/check.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
 #include "zetasql/base/map_util.h"
+#include "zetasql/base/ret_check.h"
 #include "zetasql/base/status_macros.h"
 
 namespace zetasql {
@@ -130,6 +136,143 @@ void GetZetaSQLFunctions(
   ZETASQL_DCHECK_OK(status);
 }
 
+namespace {
+
+// The builtin functions are added in this many groups, which
+// GetSharedBuiltinFunctionsAndTypes() builds concurrently. The groups are of
+// roughly similar cost.
+constexpr int kNumBuiltinFunctionGroups = 4;
+
+// Adds the Functions and Types of group 'group' of the builtin functions.
+absl::Status GetBuiltinFunctionGroup(int group,
+                                     const BuiltinFunctionOptions& options,
+                                     TypeFactory& type_factory,
+                                     NameToFunctionMap& functions,
+                                     NameToTypeMap& types) {
+  switch (group) {
+    case 0:
+      GetDatetimeFunctions(&type_factory, options, &functions);
+      GetIntervalFunctions(&type_factory, options, &functions);
+      GetArithmeticFunctions(&type_factory, options, &functions);
+      GetBitwiseFunctions(&type_factory, options, &functions);
+      GetAggregateFunctions(&type_factory, options, &functions);
+      GetApproxFunctions(&type_factory, options, &functions);
+      GetStatisticalFunctions(&type_factory, options, &functions);
+      ZETASQL_RETURN_IF_ERROR(GetBooleanFunctions(&type_factory, options, &functions));
+      GetLogicFunctions(&type_factory, options, &functions);
+      return absl::OkStatus();
+    case 1:
+      GetStringFunctions(&type_factory, options, &functions);
+      GetRegexFunctions(&type_factory, options, &functions);
+      GetErrorHandlingFunctions(&type_factory, options, &functions);
+      GetConditionalFunctions(&type_factory, options, &functions);
+      GetMiscellaneousFunctions(&type_factory, options, &functions);
+      ZETASQL_RETURN_IF_ERROR(
+          GetDistanceFunctions(&type_factory, options, &functions));
+      GetArrayMiscFunctions(&type_factory, options, &functions);
+      GetArrayAggregationFunctions(&type_factory, options, &functions);
+      GetSubscriptFunctions(&type_factory, options, &functions);
+      GetJSONFunctions(&type_factory, options, &functions);
+      return absl::OkStatus();
+    case 2:
+      ZETASQL_RETURN_IF_ERROR(
+          GetMathFunctions(&type_factory, options, &functions, &types));
+      GetHllCountFunctions(&type_factory, options, &functions);
+      GetD3ACountFunctions(&type_factory, options, &functions);
+      GetKllQuantilesFunctions(&type_factory, options, &functions);
+      ZETASQL_RETURN_IF_ERROR(
+          GetProto3ConversionFunctions(&type_factory, options, &functions));
+      // TODO: Move language feature checks to function declarations.
+      if (options.language_options.LanguageFeatureEnabled(
+              FEATURE_ANALYTIC_FUNCTIONS)) {
+        GetAnalyticFunctions(&type_factory, options, &functions);
+      }
+      GetNetFunctions(&type_factory, options, &functions);
+      GetHashingFunctions(&type_factory, options, &functions);
+      if (options.language_options.LanguageFeatureEnabled(FEATURE_ENCRYPTION)) {
+        GetEncryptionFunctions(&type_factory, options, &functions);
+      }
+      if (options.language_options.LanguageFeatureEnabled(FEATURE_GEOGRAPHY)) {
+        GetGeographyFunctions(&type_factory, options, &functions);
+      }
+      return absl::OkStatus();
+    case 3:
+      if (options.language_options.LanguageFeatureEnabled(
+              FEATURE_ANONYMIZATION)) {
+        GetAnonFunctions(&type_factory, options, &functions);
+      }
+      if (options.language_options.LanguageFeatureEnabled(
+              FEATURE_DIFFERENTIAL_PRIVACY)) {
+        ZETASQL_RETURN_IF_ERROR(GetDifferentialPrivacyFunctions(
+            &type_factory, options, &functions, &types));
+      }
+      GetTypeOfFunction(&type_factory, options, &functions);
+      GetFilterFieldsFunction(&type_factory, options, &functions);
+      if (options.language_options.LanguageFeatureEnabled(FEATURE_RANGE_TYPE)) {
+        GetRangeFunctions(&type_factory, options, &functions);
+      }
+      GetArraySlicingFunctions(&type_factory, options, &functions);
+      GetArrayFilteringFunctions(&type_factory, options, &functions);
+      GetArrayTransformFunctions(&type_factory, options, &functions);
+      GetArrayIncludesFunctions(&type_factory, options, &functions);
+      GetElementWiseAggregationFunctions(&type_factory, options, &functions);
+      if (options.language_options.LanguageFeatureEnabled(
+              FEATURE_V_1_4_ARRAY_FIND_FUNCTIONS)) {
+        ZETASQL_RETURN_IF_ERROR(
+            GetArrayFindFunctions(&type_factory, options, &functions, &types));
+      }
+      if (options.language_options.LanguageFeatureEnabled(
+              FEATURE_V_1_4_ARRAY_ZIP)) {
+        ZETASQL_RETURN_IF_ERROR(
+            GetArrayZipFunctions(&type_factory, options, &functions, &types));
+      }
+      ZETASQL_RETURN_IF_ERROR(
+          GetStandaloneBuiltinEnumTypes(&type_factory, options, &types));
+      GetMapCoreFunctions(&type_factory, options, &functions);
+      return absl::OkStatus();
+  }
+  ZETASQL_RET_CHECK_FAIL() << "Unknown builtin function group " << group;
+}
+
+// Same as GetBuiltinFunctionsAndTypes(), building each group of functions on
+// its own thread. 'type_factory' is thread-safe.
+absl::Status GetBuiltinFunctionsAndTypesInParallel(
+    const BuiltinFunctionOptions& options, TypeFactory& type_factory,
+    NameToFunctionMap& functions, NameToTypeMap& types) {
+  std::vector<NameToFunctionMap> group_functions(kNumBuiltinFunctionGroups);
+  std::vector<NameToTypeMap> group_types(kNumBuiltinFunctionGroups);
+  std::vector<absl::Status> group_status(kNumBuiltinFunctionGroups);
+  std::vector<std::thread> threads;
+  threads.reserve(kNumBuiltinFunctionGroups - 1);
+  for (int group = 1; group < kNumBuiltinFunctionGroups; ++group) {
+    threads.emplace_back([&, group] {
+      group_status[group] =
+          GetBuiltinFunctionGroup(group, options, type_factory,
+                                  group_functions[group], group_types[group]);
+    });
+  }
+  group_status[0] = GetBuiltinFunctionGroup(0, options, type_factory,
+                                            group_functions[0], group_types[0]);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  for (int group = 0; group < kNumBuiltinFunctionGroups; ++group) {
+    ZETASQL_RETURN_IF_ERROR(group_status[group]);
+    for (auto& [name, function] : group_functions[group]) {
+      ZETASQL_RET_CHECK(functions.emplace(name, std::move(function)).second)
+          << "Duplicate builtin function " << name;
+    }
+    for (const auto& [name, type] : group_types[group]) {
+      ZETASQL_RET_CHECK(types.emplace(name, type).second)
+          << "Duplicate builtin type " << name;
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
 absl::Status GetBuiltinFunctionsAndTypes(const BuiltinFunctionOptions& options,
                                          TypeFactory& type_factory,
                                          NameToFunctionMap& functions,
@@ -137,76 +280,82 @@ absl::Status GetBuiltinFunctionsAndTypes(const BuiltinFunctionOptions& options,
   // TODO: Enable these preconditions with global presubmit.
   // ZETASQL_RET_CHECK(types.empty());
   // ZETASQL_RET_CHECK(functions.empty());
-  GetDatetimeFunctions(&type_factory, options, &functions);
-  GetIntervalFunctions(&type_factory, options, &functions);
-  GetArithmeticFunctions(&type_factory, options, &functions);
-  GetBitwiseFunctions(&type_factory, options, &functions);
-  GetAggregateFunctions(&type_factory, options, &functions);
-  GetApproxFunctions(&type_factory, options, &functions);
-  GetStatisticalFunctions(&type_factory, options, &functions);
-  ZETASQL_RETURN_IF_ERROR(GetBooleanFunctions(&type_factory, options, &functions));
-  GetLogicFunctions(&type_factory, options, &functions);
-  GetStringFunctions(&type_factory, options, &functions);
-  GetRegexFunctions(&type_factory, options, &functions);
-  GetErrorHandlingFunctions(&type_factory, options, &functions);
-  GetConditionalFunctions(&type_factory, options, &functions);
-  GetMiscellaneousFunctions(&type_factory, options, &functions);
-  ZETASQL_RETURN_IF_ERROR(GetDistanceFunctions(&type_factory, options, &functions));
-  GetArrayMiscFunctions(&type_factory, options, &functions);
-  GetArrayAggregationFunctions(&type_factory, options, &functions);
-  GetSubscriptFunctions(&type_factory, options, &functions);
-  GetJSONFunctions(&type_factory, options, &functions);
-  ZETASQL_RETURN_IF_ERROR(GetMathFunctions(&type_factory, options, &functions, &types));
-  GetHllCountFunctions(&type_factory, options, &functions);
-  GetD3ACountFunctions(&type_factory, options, &functions);
-  GetKllQuantilesFunctions(&type_factory, options, &functions);
-  ZETASQL_RETURN_IF_ERROR(
-      GetProto3ConversionFunctions(&type_factory, options, &functions));
-  // TODO: Move language feature checks to function declarations.
-  if (options.language_options.LanguageFeatureEnabled(
-          FEATURE_ANALYTIC_FUNCTIONS)) {
-    GetAnalyticFunctions(&type_factory, options, &functions);
-  }
-  GetNetFunctions(&type_factory, options, &functions);
-  GetHashingFunctions(&type_factory, options, &functions);
-  if (options.language_options.LanguageFeatureEnabled(FEATURE_ENCRYPTION)) {
-    GetEncryptionFunctions(&type_factory, options, &functions);
-  }
-  if (options.language_options.LanguageFeatureEnabled(FEATURE_GEOGRAPHY)) {
-    GetGeographyFunctions(&type_factory, options, &functions);
+  for (int group = 0; group < kNumBuiltinFunctionGroups; ++group) {
+    ZETASQL_RETURN_IF_ERROR(
+        GetBuiltinFunctionGroup(group, options, type_factory, functions, types));
   }
-  if (options.language_options.LanguageFeatureEnabled(FEATURE_ANONYMIZATION)) {
-    GetAnonFunctions(&type_factory, options, &functions);
+  return absl::OkStatus();
+}
+
+namespace {
+
+// BuiltinFunctionOptions in a form that can be compared and hashed, as the key
+// of the collections of GetSharedBuiltinFunctionsAndTypes().
+struct SharedBuiltinsKey {
+  explicit SharedBuiltinsKey(const BuiltinFunctionOptions& options)
+      : language_options(options.language_options),
+        include_function_ids(options.include_function_ids.begin(),
+                             options.include_function_ids.end()),
+        exclude_function_ids(options.exclude_function_ids.begin(),
+                             options.exclude_function_ids.end()),
+        rewrite_enabled(options.rewrite_enabled.begin(),
+                        options.rewrite_enabled.end()) {
+    std::sort(include_function_ids.begin(), include_function_ids.end());
+    std::sort(exclude_function_ids.begin(), exclude_function_ids.end());
+    std::sort(rewrite_enabled.begin(), rewrite_enabled.end());
   }
-  if (options.language_options.LanguageFeatureEnabled(
-          FEATURE_DIFFERENTIAL_PRIVACY)) {
-    ZETASQL_RETURN_IF_ERROR(GetDifferentialPrivacyFunctions(&type_factory, options,
-                                                    &functions, &types));
+
+  bool operator==(const SharedBuiltinsKey& other) const {
+    return language_options == other.language_options &&
+           include_function_ids == other.include_function_ids &&
+           exclude_function_ids == other.exclude_function_ids &&
+           rewrite_enabled == other.rewrite_enabled;
   }
-  GetTypeOfFunction(&type_factory, options, &functions);
-  GetFilterFieldsFunction(&type_factory, options, &functions);
-  if (options.language_options.LanguageFeatureEnabled(FEATURE_RANGE_TYPE)) {
-    GetRangeFunctions(&type_factory, options, &functions);
+
+  template <typename H>
+  friend H AbslHashValue(H h, const SharedBuiltinsKey& key) {
+    return H::combine(std::move(h), key.language_options,
+                      key.include_function_ids, key.exclude_function_ids,
+                      key.rewrite_enabled);
   }
-  GetArraySlicingFunctions(&type_factory, options, &functions);
-  GetArrayFilteringFunctions(&type_factory, options, &functions);
-  GetArrayTransformFunctions(&type_factory, options, &functions);
-  GetArrayIncludesFunctions(&type_factory, options, &functions);
-  GetElementWiseAggregationFunctions(&type_factory, options, &functions);
-  if (options.language_options.LanguageFeatureEnabled(
-          FEATURE_V_1_4_ARRAY_FIND_FUNCTIONS)) {
-    ZETASQL_RETURN_IF_ERROR(
-        GetArrayFindFunctions(&type_factory, options, &functions, &types));
+
+  LanguageOptions language_options;
+  std::vector<FunctionSignatureId> include_function_ids;
+  std::vector<FunctionSignatureId> exclude_function_ids;
+  std::vector<std::pair<FunctionSignatureId, bool>> rewrite_enabled;
+};
+
+}  // namespace
+
+absl::StatusOr<const SharedBuiltinFunctionsAndTypes*>
+GetSharedBuiltinFunctionsAndTypes(const BuiltinFunctionOptions& options) {
+  // Process lifetime.
+  static absl::Mutex& mutex = *new absl::Mutex;
+  static TypeFactory& type_factory = *new TypeFactory;
+  static auto& shared =
+      *new absl::flat_hash_map<SharedBuiltinsKey,
+                               const SharedBuiltinFunctionsAndTypes*>;
+
+  SharedBuiltinsKey key(options);
+  // Builtins are only built once per key, so holding 'mutex' while they are
+  // built makes concurrent first calls wait rather than duplicate the work.
+  absl::MutexLock lock(&mutex);
+  auto it = shared.find(key);
+  if (it != shared.end()) {
+    return it->second;
   }
-  if (options.language_options.LanguageFeatureEnabled(
-          FEATURE_V_1_4_ARRAY_ZIP)) {
-    ZETASQL_RETURN_IF_ERROR(
-        GetArrayZipFunctions(&type_factory, options, &functions, &types));
+  NameToFunctionMap owned_functions;
+  auto result = std::make_unique<SharedBuiltinFunctionsAndTypes>();
+  // This is on the startup path of many callers, so the groups of functions
+  // are built concurrently.
+  ZETASQL_RETURN_IF_ERROR(GetBuiltinFunctionsAndTypesInParallel(
+      options, type_factory, owned_functions, result->types));
+  for (auto& [name, function] : owned_functions) {
+    result->functions.emplace(name, function.release());
   }
-  ZETASQL_RETURN_IF_ERROR(
-      GetStandaloneBuiltinEnumTypes(&type_factory, options, &types));
-  GetMapCoreFunctions(&type_factory, options, &functions);
-  return absl::OkStatus();
+  const SharedBuiltinFunctionsAndTypes* released = result.release();
+  shared.emplace(std::move(key), released);
+  return released;
 }
 
 bool FunctionMayHaveUnintendedArgumentCoercion(const Function* function) {
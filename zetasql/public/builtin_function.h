@@ -30,6 +30,7 @@
 #include "absl/base/macros.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 
 namespace zetasql {
 
@@ -81,6 +82,25 @@ std::pair<const absl::flat_hash_map<std::string, const Function*>&,
           const absl::flat_hash_map<std::string, const Type*>&>
 GetBuiltinFunctionsAndTypesForDefaultOptions();
 
+// The Functions and named Types returned by GetSharedBuiltinFunctionsAndTypes.
+struct SharedBuiltinFunctionsAndTypes {
+  absl::flat_hash_map<std::string, const Function*> functions;
+  absl::flat_hash_map<std::string, const Type*> types;
+};
+
+// Returns the same Functions and Types as `GetBuiltinFunctionsAndTypes`, from
+// a process-wide collection that is built on the first call for equal
+// `options`, and shared by all later calls. The returned Functions and Types
+// are immutable and have process lifetime; Types are allocated by an internal
+// TypeFactory that is never destroyed.
+//
+// This is meant for callers that set up many Catalogs with the same options,
+// e.g. one per request, where building hundreds of Functions each time would
+// dominate their cost. Each distinct `options` keeps its collection alive
+// forever, so callers should only use a bounded number of them.
+absl::StatusOr<const SharedBuiltinFunctionsAndTypes*>
+GetSharedBuiltinFunctionsAndTypes(const BuiltinFunctionOptions& options);
+
 const std::string FunctionSignatureIdToName(FunctionSignatureId id);
 
 // If the function allows argument coercion, then checks the function
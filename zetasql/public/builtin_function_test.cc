@@ -1052,4 +1052,37 @@ TEST(SimpleFunctionTests, TestGetAllAPI) {
   EXPECT_THAT(types1, Eq(types2));
 }
 
+TEST(SimpleFunctionTests, TestSharedAPI) {
+  LanguageOptions language_options;
+  language_options.EnableLanguageFeature(FEATURE_ROUND_WITH_ROUNDING_MODE);
+  const BuiltinFunctionOptions options(language_options);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(const SharedBuiltinFunctionsAndTypes* shared1,
+                       GetSharedBuiltinFunctionsAndTypes(options));
+  TypeFactory type_factory;
+  NameToFunctionMap functions;
+  NameToTypeMap types;
+  ZETASQL_ASSERT_OK(
+      GetBuiltinFunctionsAndTypes(options, type_factory, functions, types));
+  EXPECT_EQ(shared1->functions.size(), functions.size());
+  EXPECT_EQ(shared1->types.size(), types.size());
+  // The shared collection is built concurrently, with the same result.
+  for (const auto& [name, function] : functions) {
+    auto it = shared1->functions.find(name);
+    ASSERT_TRUE(it != shared1->functions.end()) << name;
+    EXPECT_EQ(it->second->NumSignatures(), function->NumSignatures()) << name;
+  }
+
+  // Equal options share the same collection, others do not.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(const SharedBuiltinFunctionsAndTypes* shared2,
+                       GetSharedBuiltinFunctionsAndTypes(
+                           BuiltinFunctionOptions(language_options)));
+  EXPECT_EQ(shared1, shared2);
+
+  BuiltinFunctionOptions excluding_options(language_options);
+  excluding_options.exclude_function_ids.insert(FN_ROUND_DOUBLE);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(const SharedBuiltinFunctionsAndTypes* excluding,
+                       GetSharedBuiltinFunctionsAndTypes(excluding_options));
+  EXPECT_NE(shared1, excluding);
+}
+
 }  // namespace zetasql
@@ -0,0 +1,283 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/public/caching_catalog.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/base/clock.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+CachingCatalog::CachingCatalog(Catalog* catalog, CachingCatalogOptions options)
+    : catalog_(catalog),
+      options_(std::move(options)),
+      clock_(options_.clock != nullptr ? options_.clock
+                                       : zetasql_base::Clock::RealClock()),
+      version_(catalog_->GetVersion()) {}
+
+void CachingCatalog::ClearIfVersionChanged(std::optional<int64_t> version) {
+  if (version != version_) {
+    lookups_ = {};
+    version_ = version;
+  }
+}
+
+template <typename T>
+absl::Status CachingCatalog::FindMemoized(FindMethod<T> find,
+                                          absl::Span<const std::string> path,
+                                          const T** object,
+                                          const FindOptions& options) {
+  const absl::Time now = clock_->TimeNow();
+  const std::optional<int64_t> version = catalog_->GetVersion();
+  std::vector<std::string> key(path.begin(), path.end());
+  {
+    absl::MutexLock lock(&mutex_);
+    ClearIfVersionChanged(version);
+    LookupMap<T>& lookups = std::get<LookupMap<T>>(lookups_);
+    auto it = lookups.find(key);
+    if (it != lookups.end()) {
+      if (now < it->second.expiration) {
+        ++hits_;
+        *object = it->second.object;
+        return it->second.status;
+      }
+      lookups.erase(it);
+    }
+    ++misses_;
+  }
+
+  // 'mutex_' is not held, so that other threads can look up other names
+  // meanwhile.
+  *object = nullptr;
+  const absl::Status status = (catalog_->*find)(path, object, options);
+  absl::MutexLock lock(&mutex_);
+  Memoize(std::move(key), status, *object, now, version);
+  return status;
+}
+
+template <typename T>
+void CachingCatalog::Memoize(std::vector<std::string> path,
+                             const absl::Status& status, const T* object,
+                             absl::Time now, std::optional<int64_t> version) {
+  // The wrapped Catalog may have changed during the lookup.
+  if ((!status.ok() && !absl::IsNotFound(status)) || version != version_) {
+    return;
+  }
+  std::get<LookupMap<T>>(lookups_).insert_or_assign(
+      std::move(path), CachedLookup<T>{status, status.ok() ? object : nullptr,
+                                       now + options_.ttl});
+}
+
+template <typename T>
+std::vector<std::vector<std::string>> CachingCatalog::GetUnmemoizedPaths(
+    absl::Span<const std::vector<std::string>> paths, absl::Time now) {
+  std::vector<std::vector<std::string>> unmemoized_paths;
+  const std::optional<int64_t> version = catalog_->GetVersion();
+  absl::MutexLock lock(&mutex_);
+  ClearIfVersionChanged(version);
+  const LookupMap<T>& lookups = std::get<LookupMap<T>>(lookups_);
+  for (const std::vector<std::string>& path : paths) {
+    auto it = lookups.find(path);
+    if (it == lookups.end() || now >= it->second.expiration) {
+      unmemoized_paths.push_back(path);
+    }
+  }
+  return unmemoized_paths;
+}
+
+template <typename T>
+absl::Status CachingCatalog::FindAllMemoized(
+    FindMethod<T> find, absl::Span<const std::vector<std::string>> paths) {
+  for (const std::vector<std::string>& path : paths) {
+    const T* object;
+    const absl::Status status =
+        FindMemoized(find, path, &object, FindOptions());
+    if (!status.ok() && !absl::IsNotFound(status)) {
+      return status;
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status CachingCatalog::Prefetch(
+    absl::Span<const std::vector<std::string>> table_paths,
+    absl::Span<const std::vector<std::string>> tvf_paths) {
+  const absl::Time now = clock_->TimeNow();
+  const std::vector<std::vector<std::string>> tables =
+      GetUnmemoizedPaths<Table>(table_paths, now);
+  const std::vector<std::vector<std::string>> tvfs =
+      GetUnmemoizedPaths<TableValuedFunction>(tvf_paths, now);
+  if (tables.empty() && tvfs.empty()) {
+    return absl::OkStatus();
+  }
+  ZETASQL_RETURN_IF_ERROR(catalog_->Prefetch(tables, tvfs));
+  ZETASQL_RETURN_IF_ERROR(FindAllMemoized<Table>(&Catalog::FindTable, tables));
+  return FindAllMemoized<TableValuedFunction>(
+      &Catalog::FindTableValuedFunction, tvfs);
+}
+
+void CachingCatalog::Clear() {
+  absl::MutexLock lock(&mutex_);
+  lookups_ = {};
+}
+
+int64_t CachingCatalog::size() const {
+  absl::MutexLock lock(&mutex_);
+  return std::apply(
+      [](const auto&... lookups) {
+        return (int64_t{0} + ... + static_cast<int64_t>(lookups.size()));
+      },
+      lookups_);
+}
+
+int64_t CachingCatalog::hits() const {
+  absl::MutexLock lock(&mutex_);
+  return hits_;
+}
+
+int64_t CachingCatalog::misses() const {
+  absl::MutexLock lock(&mutex_);
+  return misses_;
+}
+
+absl::Status CachingCatalog::FindTable(
+    const absl::Span<const std::string>& path, const Table** table,
+    const FindOptions& options) {
+  return FindMemoized<Table>(&Catalog::FindTable, path, table, options);
+}
+
+absl::Status CachingCatalog::FindModel(
+    const absl::Span<const std::string>& path, const Model** model,
+    const FindOptions& options) {
+  return FindMemoized<Model>(&Catalog::FindModel, path, model, options);
+}
+
+absl::Status CachingCatalog::FindFunction(
+    const absl::Span<const std::string>& path, const Function** function,
+    const FindOptions& options) {
+  return FindMemoized<Function>(&Catalog::FindFunction, path, function,
+                                options);
+}
+
+absl::Status CachingCatalog::FindTableValuedFunction(
+    const absl::Span<const std::string>& path,
+    const TableValuedFunction** function, const FindOptions& options) {
+  return FindMemoized<TableValuedFunction>(&Catalog::FindTableValuedFunction,
+                                           path, function, options);
+}
+
+absl::Status CachingCatalog::FindProcedure(
+    const absl::Span<const std::string>& path, const Procedure** procedure,
+    const FindOptions& options) {
+  return FindMemoized<Procedure>(&Catalog::FindProcedure, path, procedure,
+                                 options);
+}
+
+absl::Status CachingCatalog::FindType(const absl::Span<const std::string>& path,
+                                      const Type** type,
+                                      const FindOptions& options) {
+  return FindMemoized<Type>(&Catalog::FindType, path, type, options);
+}
+
+absl::Status CachingCatalog::FindTableWithPathPrefix(
+    absl::Span<const std::string> path, const FindOptions& options,
+    int* num_names_consumed, const Table** table) {
+  return catalog_->FindTableWithPathPrefix(path, options, num_names_consumed,
+                                           table);
+}
+
+absl::Status CachingCatalog::FindConnection(
+    const absl::Span<const std::string>& path, const Connection** connection,
+    const FindOptions& options) {
+  return catalog_->FindConnection(path, connection, options);
+}
+
+absl::Status CachingCatalog::FindSequence(
+    const absl::Span<const std::string>& path, const Sequence** sequence,
+    const FindOptions& options) {
+  return catalog_->FindSequence(path, sequence, options);
+}
+
+absl::Status CachingCatalog::FindConstantWithPathPrefix(
+    absl::Span<const std::string> path, int* num_names_consumed,
+    const Constant** constant, const FindOptions& options) {
+  return catalog_->FindConstantWithPathPrefix(path, num_names_consumed,
+                                              constant, options);
+}
+
+absl::Status CachingCatalog::FindConversion(
+    const Type* from_type, const Type* to_type,
+    const FindConversionOptions& options, Conversion* conversion) {
+  return catalog_->FindConversion(from_type, to_type, options, conversion);
+}
+
+absl::StatusOr<TypeListView> CachingCatalog::GetExtendedTypeSuperTypes(
+    const Type* type) {
+  return catalog_->GetExtendedTypeSuperTypes(type);
+}
+
+std::string CachingCatalog::SuggestTable(
+    const absl::Span<const std::string>& mistyped_path) {
+  return catalog_->SuggestTable(mistyped_path);
+}
+
+std::string CachingCatalog::SuggestModel(
+    const absl::Span<const std::string>& mistyped_path) {
+  return catalog_->SuggestModel(mistyped_path);
+}
+
+std::string CachingCatalog::SuggestFunction(
+    const absl::Span<const std::string>& mistyped_path) {
+  return catalog_->SuggestFunction(mistyped_path);
+}
+
+std::string CachingCatalog::SuggestTableValuedFunction(
+    const absl::Span<const std::string>& mistyped_path) {
+  return catalog_->SuggestTableValuedFunction(mistyped_path);
+}
+
+std::string CachingCatalog::SuggestConstant(
+    const absl::Span<const std::string>& mistyped_path) {
+  return catalog_->SuggestConstant(mistyped_path);
+}
+
+std::string CachingCatalog::SuggestEnumValue(const EnumType* type,
+                                             absl::string_view mistyped_value) {
+  return catalog_->SuggestEnumValue(type, mistyped_value);
+}
+
+std::string CachingCatalog::SuggestSequence(
+    const absl::Span<const std::string>& mistyped_path) {
+  return catalog_->SuggestSequence(mistyped_path);
+}
+
+}  // namespace zetasql
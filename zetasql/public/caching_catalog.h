@@ -0,0 +1,226 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef ZETASQL_PUBLIC_CACHING_CATALOG_H_
+#define ZETASQL_PUBLIC_CACHING_CATALOG_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/base/clock.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+
+namespace zetasql {
+
+struct CachingCatalogOptions {
+  // How long a lookup stays memoized. The default never expires lookups,
+  // which fits a CachingCatalog that is created for a single analysis.
+  // CachingCatalogs that are shared across analyses should set a TTL that
+  // bounds how stale their results can get.
+  absl::Duration ttl = absl::InfiniteDuration();
+
+  // The clock that <ttl> is measured with. Defaults to the real clock.
+  zetasql_base::Clock* clock = nullptr;
+};
+
+// Catalog that wraps another Catalog and memoizes the results of its
+// FindTable(), FindModel(), FindFunction(), FindTableValuedFunction(),
+// FindProcedure() and FindType(), for Catalogs whose lookups are expensive.
+// The analyzer looks up the same names many times over a statement, and a
+// script or a batch of statements looks up the same names again.
+//
+// Lookups are memoized per exact path, so that a catalog that ignores case
+// gets one entry for each spelling. Both found objects and NOT_FOUND errors
+// are memoized; other errors are not, since they may be transient. Objects
+// that are found must outlive the CachingCatalog, as they do for the wrapped
+// Catalog. All memoized lookups are forgotten when GetVersion() of the
+// wrapped Catalog changes, so that caches keyed on the version, like
+// AnalyzerOutputCache, do not get stale objects after re-analyzing.
+//
+// Prefetch() only forwards the paths that are not memoized yet. All other
+// lookups, including FindTableWithPathPrefix() and
+// FindConstantWithPathPrefix(), are forwarded to the wrapped Catalog as is.
+//
+// This class is thread-safe if the wrapped Catalog is.
+class CachingCatalog : public Catalog {
+ public:
+  // Does not take ownership of <catalog>, which must outlive this object.
+  explicit CachingCatalog(Catalog* catalog,
+                          CachingCatalogOptions options = {});
+
+  CachingCatalog(const CachingCatalog&) = delete;
+  CachingCatalog& operator=(const CachingCatalog&) = delete;
+
+  std::string FullName() const override { return catalog_->FullName(); }
+  // Returns the version of the wrapped Catalog.
+  std::optional<int64_t> GetVersion() const override {
+    return catalog_->GetVersion();
+  }
+
+  // Passes the paths that are not memoized yet to Prefetch() of the wrapped
+  // Catalog, so that it can fetch them in one batch, and then memoizes their
+  // FindTable() and FindTableValuedFunction() results. Returns the first
+  // error other than NOT_FOUND.
+  absl::Status Prefetch(
+      absl::Span<const std::vector<std::string>> table_paths,
+      absl::Span<const std::vector<std::string>> tvf_paths) override;
+
+  // Forgets all memoized lookups, e.g. after the wrapped Catalog changed.
+  void Clear();
+
+  // Returns the number of memoized lookups.
+  int64_t size() const;
+
+  // Returns how many lookups were answered from memoized results, and how
+  // many were forwarded to the wrapped Catalog.
+  int64_t hits() const;
+  int64_t misses() const;
+
+  absl::Status FindTable(const absl::Span<const std::string>& path,
+                         const Table** table,
+                         const FindOptions& options = FindOptions()) override;
+  absl::Status FindModel(const absl::Span<const std::string>& path,
+                         const Model** model,
+                         const FindOptions& options = FindOptions()) override;
+  absl::Status FindFunction(
+      const absl::Span<const std::string>& path, const Function** function,
+      const FindOptions& options = FindOptions()) override;
+  absl::Status FindTableValuedFunction(
+      const absl::Span<const std::string>& path,
+      const TableValuedFunction** function,
+      const FindOptions& options = FindOptions()) override;
+  absl::Status FindProcedure(
+      const absl::Span<const std::string>& path, const Procedure** procedure,
+      const FindOptions& options = FindOptions()) override;
+  absl::Status FindType(const absl::Span<const std::string>& path,
+                        const Type** type,
+                        const FindOptions& options = FindOptions()) override;
+
+  absl::Status FindTableWithPathPrefix(absl::Span<const std::string> path,
+                                       const FindOptions& options,
+                                       int* num_names_consumed,
+                                       const Table** table) override;
+  absl::Status FindConnection(const absl::Span<const std::string>& path,
+                              const Connection** connection,
+                              const FindOptions& options) override;
+  absl::Status FindSequence(const absl::Span<const std::string>& path,
+                            const Sequence** sequence,
+                            const FindOptions& options) override;
+  absl::Status FindConstantWithPathPrefix(
+      absl::Span<const std::string> path, int* num_names_consumed,
+      const Constant** constant,
+      const FindOptions& options = FindOptions()) override;
+  absl::Status FindConversion(const Type* from_type, const Type* to_type,
+                              const FindConversionOptions& options,
+                              Conversion* conversion) override;
+  absl::StatusOr<TypeListView> GetExtendedTypeSuperTypes(
+      const Type* type) override;
+
+  std::string SuggestTable(
+      const absl::Span<const std::string>& mistyped_path) override;
+  std::string SuggestModel(
+      const absl::Span<const std::string>& mistyped_path) override;
+  std::string SuggestFunction(
+      const absl::Span<const std::string>& mistyped_path) override;
+  std::string SuggestTableValuedFunction(
+      const absl::Span<const std::string>& mistyped_path) override;
+  std::string SuggestConstant(
+      const absl::Span<const std::string>& mistyped_path) override;
+  std::string SuggestEnumValue(const EnumType* type,
+                               absl::string_view mistyped_value) override;
+  std::string SuggestSequence(
+      const absl::Span<const std::string>& mistyped_path) override;
+
+ private:
+  // The result of a lookup. <object> is null for NOT_FOUND.
+  template <typename T>
+  struct CachedLookup {
+    absl::Status status;
+    const T* object = nullptr;
+    absl::Time expiration;
+  };
+
+  template <typename T>
+  using LookupMap =
+      absl::flat_hash_map<std::vector<std::string>, CachedLookup<T>>;
+
+  template <typename T>
+  using FindMethod = absl::Status (Catalog::*)(
+      const absl::Span<const std::string>& path, const T** object,
+      const FindOptions& options);
+
+  // Returns the memoized result of (catalog_->*find)(<path>, ...), looking it
+  // up if it is not memoized or has expired.
+  template <typename T>
+  absl::Status FindMemoized(FindMethod<T> find,
+                            absl::Span<const std::string> path,
+                            const T** object, const FindOptions& options);
+
+  // Returns the paths in <paths> whose lookups are not memoized at <now>.
+  template <typename T>
+  std::vector<std::vector<std::string>> GetUnmemoizedPaths(
+      absl::Span<const std::vector<std::string>> paths, absl::Time now);
+
+  // Calls FindMemoized() on each path in <paths>, and returns the first error
+  // other than NOT_FOUND.
+  template <typename T>
+  absl::Status FindAllMemoized(
+      FindMethod<T> find, absl::Span<const std::vector<std::string>> paths);
+
+  // Memoizes <status> and <object> as the result of looking up <path>, if
+  // <status> is OK or NOT_FOUND and the lookup was done at the current
+  // <version_>.
+  template <typename T>
+  void Memoize(std::vector<std::string> path, const absl::Status& status,
+               const T* object, absl::Time now, std::optional<int64_t> version)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Forgets all memoized lookups if <version> of the wrapped Catalog differs
+  // from <version_>, and sets <version_> to it.
+  void ClearIfVersionChanged(std::optional<int64_t> version)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  Catalog* const catalog_;
+  const CachingCatalogOptions options_;
+  zetasql_base::Clock* const clock_;
+
+  mutable absl::Mutex mutex_;
+  std::tuple<LookupMap<Table>, LookupMap<Model>, LookupMap<Function>,
+             LookupMap<TableValuedFunction>, LookupMap<Procedure>,
+             LookupMap<Type>>
+      lookups_ ABSL_GUARDED_BY(mutex_);
+  // The version of the wrapped Catalog that <lookups_> were done at.
+  std::optional<int64_t> version_ ABSL_GUARDED_BY(mutex_);
+  int64_t hits_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t misses_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_CACHING_CATALOG_H_
@@ -0,0 +1,220 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/public/caching_catalog.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/types/type_factory.h"
+#include "zetasql/base/clock.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+
+namespace zetasql {
+namespace {
+
+using ::testing::ElementsAre;
+using ::zetasql_base::testing::StatusIs;
+
+// A SimpleCatalog that counts its table lookups, and fails them on request.
+class CountingCatalog : public SimpleCatalog {
+ public:
+  explicit CountingCatalog(TypeFactory* type_factory)
+      : SimpleCatalog("counting", type_factory) {}
+
+  absl::Status FindTable(const absl::Span<const std::string>& path,
+                         const Table** table,
+                         const FindOptions& options) override {
+    ++num_find_table_;
+    if (fail_) {
+      return absl::UnavailableError("unavailable");
+    }
+    return SimpleCatalog::FindTable(path, table, options);
+  }
+
+  absl::Status Prefetch(
+      absl::Span<const std::vector<std::string>> table_paths,
+      absl::Span<const std::vector<std::string>> tvf_paths) override {
+    prefetched_tables_.emplace_back(table_paths.begin(), table_paths.end());
+    return absl::OkStatus();
+  }
+
+  std::optional<int64_t> GetVersion() const override { return version_; }
+
+  int num_find_table() const { return num_find_table_; }
+  void set_fail(bool fail) { fail_ = fail; }
+  void set_version(int64_t version) { version_ = version; }
+
+  // The table paths of each call to Prefetch().
+  const std::vector<std::vector<std::vector<std::string>>>& prefetched_tables()
+      const {
+    return prefetched_tables_;
+  }
+
+ private:
+  int num_find_table_ = 0;
+  bool fail_ = false;
+  std::optional<int64_t> version_ = 1;
+  std::vector<std::vector<std::vector<std::string>>> prefetched_tables_;
+};
+
+class CachingCatalogTest : public ::testing::Test {
+ protected:
+  CachingCatalogTest() : catalog_(&type_factory_) {
+    for (const char* name : {"t1", "t2"}) {
+      catalog_.AddOwnedTable(std::make_unique<SimpleTable>(
+          name, std::vector<SimpleTable::NameAndType>{
+                    {"a", type_factory_.get_int64()}}));
+    }
+  }
+
+  TypeFactory type_factory_;
+  CountingCatalog catalog_;
+};
+
+TEST_F(CachingCatalogTest, MemoizesFoundAndNotFoundTables) {
+  CachingCatalog caching_catalog(&catalog_);
+  for (int i = 0; i < 3; ++i) {
+    const Table* table = nullptr;
+    ZETASQL_ASSERT_OK(caching_catalog.FindTable({"t1"}, &table));
+    ASSERT_NE(table, nullptr);
+    EXPECT_EQ(table->Name(), "t1");
+
+    EXPECT_THAT(caching_catalog.FindTable({"missing"}, &table),
+                StatusIs(absl::StatusCode::kNotFound));
+    EXPECT_EQ(table, nullptr);
+  }
+  EXPECT_EQ(catalog_.num_find_table(), 2);
+  EXPECT_EQ(caching_catalog.size(), 2);
+  EXPECT_EQ(caching_catalog.hits(), 4);
+  EXPECT_EQ(caching_catalog.misses(), 2);
+
+  caching_catalog.Clear();
+  EXPECT_EQ(caching_catalog.size(), 0);
+  const Table* table = nullptr;
+  ZETASQL_ASSERT_OK(caching_catalog.FindTable({"t1"}, &table));
+  EXPECT_EQ(catalog_.num_find_table(), 3);
+}
+
+TEST_F(CachingCatalogTest, MemoizesTypes) {
+  CachingCatalog caching_catalog(&catalog_);
+  catalog_.AddType("my_int", type_factory_.get_int64());
+  for (int i = 0; i < 2; ++i) {
+    const Type* type = nullptr;
+    ZETASQL_ASSERT_OK(caching_catalog.FindType({"my_int"}, &type));
+    EXPECT_EQ(type, type_factory_.get_int64());
+  }
+  EXPECT_EQ(caching_catalog.hits(), 1);
+  EXPECT_EQ(caching_catalog.misses(), 1);
+}
+
+TEST_F(CachingCatalogTest, DoesNotMemoizeOtherErrors) {
+  CachingCatalog caching_catalog(&catalog_);
+  catalog_.set_fail(true);
+  const Table* table = nullptr;
+  EXPECT_THAT(caching_catalog.FindTable({"t1"}, &table),
+              StatusIs(absl::StatusCode::kUnavailable));
+  catalog_.set_fail(false);
+  ZETASQL_ASSERT_OK(caching_catalog.FindTable({"t1"}, &table));
+  EXPECT_NE(table, nullptr);
+  EXPECT_EQ(catalog_.num_find_table(), 2);
+}
+
+TEST_F(CachingCatalogTest, ExpiresLookupsAfterTtl) {
+  zetasql_base::SimulatedClock clock;
+  CachingCatalogOptions options;
+  options.ttl = absl::Seconds(10);
+  options.clock = &clock;
+  CachingCatalog caching_catalog(&catalog_, options);
+  const Table* table = nullptr;
+  ZETASQL_ASSERT_OK(caching_catalog.FindTable({"t1"}, &table));
+  clock.AdvanceTime(absl::Seconds(5));
+  ZETASQL_ASSERT_OK(caching_catalog.FindTable({"t1"}, &table));
+  EXPECT_EQ(catalog_.num_find_table(), 1);
+  clock.AdvanceTime(absl::Seconds(5));
+  ZETASQL_ASSERT_OK(caching_catalog.FindTable({"t1"}, &table));
+  EXPECT_EQ(catalog_.num_find_table(), 2);
+}
+
+TEST_F(CachingCatalogTest, ForgetsLookupsWhenVersionChanges) {
+  CachingCatalog caching_catalog(&catalog_);
+  EXPECT_EQ(caching_catalog.GetVersion(), 1);
+  const Table* table = nullptr;
+  EXPECT_THAT(caching_catalog.FindTable({"t3"}, &table),
+              StatusIs(absl::StatusCode::kNotFound));
+  ZETASQL_ASSERT_OK(caching_catalog.FindTable({"t1"}, &table));
+  EXPECT_EQ(caching_catalog.size(), 2);
+
+  // Adds "t3" at a new version, which was memoized as NOT_FOUND before.
+  catalog_.set_version(2);
+  EXPECT_EQ(caching_catalog.GetVersion(), 2);
+  catalog_.AddOwnedTable(std::make_unique<SimpleTable>(
+      "t3", std::vector<SimpleTable::NameAndType>{
+                {"a", type_factory_.get_int64()}}));
+
+  ZETASQL_ASSERT_OK(caching_catalog.FindTable({"t1"}, &table));
+  ZETASQL_ASSERT_OK(caching_catalog.FindTable({"t3"}, &table));
+  EXPECT_EQ(table->Name(), "t3");
+  EXPECT_EQ(catalog_.num_find_table(), 4);
+  EXPECT_EQ(caching_catalog.size(), 2);
+
+  ZETASQL_ASSERT_OK(caching_catalog.FindTable({"t1"}, &table));
+  EXPECT_EQ(catalog_.num_find_table(), 4);
+}
+
+TEST_F(CachingCatalogTest, PrefetchesUnmemoizedTables) {
+  using Path = std::vector<std::string>;
+  CachingCatalog caching_catalog(&catalog_);
+  const Table* table = nullptr;
+  ZETASQL_ASSERT_OK(caching_catalog.FindTable({"t1"}, &table));
+  ZETASQL_ASSERT_OK(caching_catalog.Prefetch(
+      {Path{"t1"}, Path{"t2"}, Path{"missing"}}, /*tvf_paths=*/{}));
+  // "t1" was already memoized.
+  EXPECT_THAT(catalog_.prefetched_tables(),
+              ElementsAre(ElementsAre(Path{"t2"}, Path{"missing"})));
+  EXPECT_EQ(catalog_.num_find_table(), 3);
+
+  ZETASQL_ASSERT_OK(caching_catalog.FindTable({"t2"}, &table));
+  EXPECT_EQ(table->Name(), "t2");
+  EXPECT_THAT(caching_catalog.FindTable({"missing"}, &table),
+              StatusIs(absl::StatusCode::kNotFound));
+  EXPECT_EQ(catalog_.num_find_table(), 3);
+
+  // Nothing is left to prefetch.
+  ZETASQL_ASSERT_OK(caching_catalog.Prefetch({Path{"t2"}}, /*tvf_paths=*/{}));
+  EXPECT_EQ(catalog_.prefetched_tables().size(), 1);
+
+  catalog_.set_fail(true);
+  caching_catalog.Clear();
+  EXPECT_THAT(caching_catalog.Prefetch({Path{"t1"}}, /*tvf_paths=*/{}),
+              StatusIs(absl::StatusCode::kUnavailable));
+  EXPECT_EQ(caching_catalog.size(), 0);
+}
+
+}  // namespace
+}  // namespace zetasql
@@ -28,6 +28,7 @@
 #include "zetasql/public/evaluator_table_iterator.h"
 #include "zetasql/public/type.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
@@ -95,8 +96,9 @@ class TableValuedFunction;
 // TODO: We could allow best-effort methods like ListTables so commands
 // like show tables can be implemented inside ZetaSQL, if necessary.
 //
-// ZetaSQL will not cache resolved names across queries.  If caching is
-// necessary, it should be done inside the Catalog implementation.
+// ZetaSQL will not cache resolved names across queries, except in an
+// AnalyzerOutputCache for a Catalog that has versions (see GetVersion()).  If
+// caching is necessary, it should be done inside the Catalog implementation.
 //
 // All objects returned from Catalog lookups must stay valid for the lifetime
 // of the Catalog.
@@ -121,6 +123,14 @@ class Catalog {
   // Suitable for log messages, but not necessarily a valid SQL path expression.
   virtual std::string FullName() const = 0;
 
+  // Returns a version of the contents of this Catalog, for callers that cache
+  // the results of analyzing statements against it, like AnalyzerOutputCache.
+  // The version must increase whenever a lookup, including one in a nested
+  // Catalog, could return something else than before. Returns std::nullopt if
+  // the Catalog does not track versions, which is the default; the results of
+  // analysis against such a Catalog are not cached.
+  virtual std::optional<int64_t> GetVersion() const { return std::nullopt; }
+
   // Options for a LookupName call.
   class FindOptions {
    public:
@@ -324,6 +334,23 @@ class Catalog {
   absl::Status FindObject(absl::Span<const std::string> path,
                           const Type** object, const FindOptions& options);
 
+  // Called by the analyzer before it resolves a statement, if
+  // AnalyzerOptions::prefetch_catalog_names() is set, with the paths in the
+  // statement that look like table names and TVF names (see
+  // ExtractTableNamesFromStatement()). Catalogs whose lookups are expensive,
+  // e.g. because they are served remotely, can override this to fetch all of
+  // these objects at once, so that the FindTable() and
+  // FindTableValuedFunction() calls that follow are cheap.
+  //
+  // The paths are in their as-written case, and need not name existing
+  // objects; those that do not must be ignored. Any error fails the analysis.
+  // The default does nothing.
+  virtual absl::Status Prefetch(
+      absl::Span<const std::vector<std::string>> table_paths,
+      absl::Span<const std::vector<std::string>> tvf_paths) {
+    return absl::OkStatus();
+  }
+
   // FindConversion looks up a Conversion between from_type and to_type with the
   // given options.
   //
@@ -796,6 +823,27 @@ class Table {
            << " does not support the API in evaluator.h";
   }
 
+  // Returns an estimate of the number of rows in this table, or nullopt if no
+  // estimate is available.
+  //
+  // Not used for zetasql analysis.
+  // Used only by the reference implementation, which builds the hash table of
+  // an inner join on the input that is estimated to have fewer rows.
+  virtual std::optional<int64_t> GetRowCountEstimate() const {
+    return std::nullopt;
+  }
+
+  // Returns a version of the rows of this table, for callers that cache the
+  // results of queries that read it, like QueryResultCache. The version must
+  // change whenever CreateEvaluatorTableIterator() could return other rows
+  // than before, and must not be reused for other rows of any table with the
+  // same version. Returns std::nullopt if the table does not track versions,
+  // which is the default; the results of queries that read such a table are
+  // not cached.
+  //
+  // Not used for zetasql analysis.
+  virtual std::optional<int64_t> GetVersion() const { return std::nullopt; }
+
   // Returns AnonymizationInfo related to this table, if any.
   // For further details, see:
   //
@@ -20,6 +20,7 @@
 #include <functional>
 #include <iterator>
 #include <memory>
+#include <optional>
 #include <set>
 #include <stack>
 #include <string>
@@ -42,6 +43,7 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/match.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "zetasql/base/map_util.h"
 #include "zetasql/base/status.h"
@@ -376,9 +378,16 @@ class Coercer::ContextBase {
   // already set.
   absl::Status AddExtendedConversion(const Conversion& extended_conversion);
 
+  // Returns how many times AddExtendedConversion() was called.
+  int num_extended_conversions() const { return num_extended_conversions_; }
+
+ protected:
+  const Coercer& coercer() const { return coercer_; }
+
  private:
   const Coercer& coercer_;
   ConversionEvaluatorSet extended_conversion_evaluators_;
+  int num_extended_conversions_ = 0;
   const bool is_explicit_;
 };
 
@@ -387,6 +396,7 @@ absl::Status Coercer::ContextBase::AddExtendedConversion(
   ZETASQL_RET_CHECK(extended_conversion.is_valid());
 
   extended_conversion_evaluators_.insert(extended_conversion.evaluator());
+  ++num_extended_conversions_;
   return absl::OkStatus();
 }
 
@@ -414,6 +424,12 @@ class Coercer::Context : public Coercer::ContextBase {
                                        const Type* to_type,
                                        SignatureMatchResult* result);
 
+  // Same as StructCoercesTo() for a non-literal of STRUCT type <from_type>,
+  // but memoized in the Coercer.
+  absl::StatusOr<bool> StructTypeCoercesTo(const Type* from_type,
+                                           const Type* to_type,
+                                           SignatureMatchResult* result);
+
   absl::StatusOr<bool> ArrayCoercesTo(const InputArgumentType& array_argument,
                                       const Type* to_type,
                                       SignatureMatchResult* result);
@@ -643,11 +659,51 @@ const Type* Coercer::GetCommonSuperType(
   return status.ok() ? common_supertype : nullptr;
 }
 
+// Returns whether <argument> is a non-literal, non-parameter argument whose
+// STRUCT fields, if any, are too.
+static bool IsTypedExpressionWithTypedFields(
+    const InputArgumentType& argument) {
+  return argument.is_typed_expression() && argument.type() != nullptr &&
+         absl::c_all_of(argument.field_types(),
+                        IsTypedExpressionWithTypedFields);
+}
+
+std::optional<std::vector<const Type*>> Coercer::GetSuperTypeMemoKey(
+    const InputArgumentTypeSet& argument_set) {
+  const InputArgumentType* dominant_argument = argument_set.dominant_argument();
+  if (dominant_argument == nullptr ||
+      !IsTypedExpressionWithTypedFields(*dominant_argument)) {
+    return std::nullopt;
+  }
+  std::vector<const Type*> key;
+  key.reserve(argument_set.arguments().size() + 1);
+  key.push_back(dominant_argument->type());
+  for (const InputArgumentType& argument : argument_set.arguments()) {
+    if (!IsTypedExpressionWithTypedFields(argument)) {
+      return std::nullopt;
+    }
+    key.push_back(argument.type());
+  }
+  return key;
+}
+
 absl::Status Coercer::GetCommonSuperType(
     const InputArgumentTypeSet& argument_set,
     const Type** common_supertype) const {
   ZETASQL_RET_CHECK_NE(common_supertype, nullptr);
 
+  std::optional<std::vector<const Type*>> memo_key =
+      GetSuperTypeMemoKey(argument_set);
+  if (memo_key.has_value()) {
+    absl::MutexLock lock(&mutex_);
+    const Type* const* memoized =
+        zetasql_base::FindOrNull(common_supertypes_, *memo_key);
+    if (memoized != nullptr) {
+      *common_supertype = *memoized;
+      return absl::OkStatus();
+    }
+  }
+
   ZETASQL_ASSIGN_OR_RETURN(*common_supertype,
                    GetCommonSuperTypeImpl(
                        argument_set, /*treat_parameters_as_literals=*/false));
@@ -658,6 +714,10 @@ absl::Status Coercer::GetCommonSuperType(
                          argument_set, /*treat_parameters_as_literals=*/true));
   }
 
+  if (memo_key.has_value()) {
+    absl::MutexLock lock(&mutex_);
+    common_supertypes_.emplace(*std::move(memo_key), *common_supertype);
+  }
   return absl::OkStatus();
 }
 
@@ -1071,7 +1131,7 @@ absl::StatusOr<bool> Coercer::Context::TypeCoercesTo(
   // STRUCT->PROTO is not a generically supported cast, but there is a special
   // case for map entries.
   if (from_type->IsStruct()) {
-    return StructCoercesTo(InputArgumentType(from_type), to_type, result);
+    return StructTypeCoercesTo(from_type, to_type, result);
   }
 
   const CastFunctionProperty* property =
@@ -1187,6 +1247,63 @@ absl::StatusOr<bool> Coercer::Context::StructCoercesTo(
   return true;
 }
 
+// Returns whether a successful StructCoercesTo() of a non-literal of type
+// <from_struct> to <to_type> calls UpdateFromResult() on its result.
+static bool StructCoercionUpdatesResult(const StructType* from_struct,
+                                        const Type* to_type) {
+  if (!to_type->IsStruct()) {
+    return true;
+  }
+  const StructType* to_struct = to_type->AsStruct();
+  for (int idx = 0; idx < to_struct->num_fields(); ++idx) {
+    if (!from_struct->field(idx).type->Equals(to_struct->field(idx).type)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+absl::StatusOr<bool> Coercer::Context::StructTypeCoercesTo(
+    const Type* from_type, const Type* to_type, SignatureMatchResult* result) {
+  const CoercionKey key(from_type, to_type, is_explicit());
+  std::optional<MemoizedCoercion> coercion;
+  {
+    absl::MutexLock lock(&coercer().mutex_);
+    const MemoizedCoercion* memoized =
+        zetasql_base::FindOrNull(coercer().struct_coercions_, key);
+    if (memoized != nullptr) {
+      coercion = *memoized;
+    }
+  }
+  if (!coercion.has_value()) {
+    coercion.emplace();
+    const int num_extended_conversions_before = num_extended_conversions();
+    ZETASQL_ASSIGN_OR_RETURN(coercion->coerced,
+                     StructCoercesTo(InputArgumentType(from_type), to_type,
+                                     &coercion->result));
+    coercion->updates_result =
+        coercion->coerced &&
+        StructCoercionUpdatesResult(from_type->AsStruct(), to_type);
+    // Extended conversions are collected in this Context, so coercions that
+    // need any are not memoized.
+    if (num_extended_conversions() == num_extended_conversions_before) {
+      absl::MutexLock lock(&coercer().mutex_);
+      coercer().struct_coercions_.emplace(key, *coercion);
+    }
+  }
+  // A failure is counted as a single non-matched argument, since callers
+  // disregard the other counts of failed coercions. Otherwise <result> is
+  // updated from the coerced fields, like StructCoercesTo() does.
+  if (!coercion->coerced) {
+    result->incr_non_matched_arguments();
+    return false;
+  }
+  if (coercion->updates_result) {
+    result->UpdateFromResult(coercion->result);
+  }
+  return true;
+}
+
 absl::StatusOr<bool> Coercer::Context::StructCoercesToProtoMapEntry(
     const StructType* from_struct, const ProtoType* to_type,
     SignatureMatchResult* result) {
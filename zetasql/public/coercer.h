@@ -17,12 +17,19 @@
 #ifndef ZETASQL_PUBLIC_COERCER_H_
 #define ZETASQL_PUBLIC_COERCER_H_
 
+#include <optional>
+#include <tuple>
+#include <vector>
+
 #include "zetasql/public/function.h"
 #include "zetasql/public/language_options.h"
 #include "zetasql/public/signature_match_result.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/types/type.h"
 #include "zetasql/public/value.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 
 namespace zetasql {
@@ -46,6 +53,11 @@ int GetLiteralCoercionCost(const Value& literal_value, const Type* to_type);
 
 class ExtendedCompositeCastEvaluator;
 
+// A Coercer memoizes the common supertypes of sets of non-literal,
+// non-parameter arguments, and whether non-literal STRUCT types coerce to
+// other types, since these only depend on the types. The memoized results
+// assume that <*language_options> and the conversions of <catalog> do not
+// change during the lifetime of the Coercer. The Coercer is thread-safe.
 class Coercer {
  public:
   // Does not take ownership of <catalog> or <type_factory>.
@@ -190,6 +202,26 @@ class Coercer {
   // nested structs).
   void StripFieldAliasesFromStructType(const Type** struct_type) const;
 
+  // Returns the key under which GetCommonSuperType() memoizes the supertype of
+  // <argument_set>: the type of the dominant argument followed by the types of
+  // all arguments. Returns nullopt if any argument is a literal, a parameter,
+  // untyped, or a STRUCT with such fields, since then the supertype also
+  // depends on more than the types.
+  static std::optional<std::vector<const Type*>> GetSuperTypeMemoKey(
+      const InputArgumentTypeSet& argument_set);
+
+  // The memoized outcome of coercing a non-literal STRUCT type to another
+  // type.
+  struct MemoizedCoercion {
+    bool coerced = false;
+    // Whether a successful coercion updates the SignatureMatchResult from
+    // <result> (as opposed to leaving it unchanged).
+    bool updates_result = false;
+    SignatureMatchResult result;
+  };
+  // From type, to type and whether the coercion is explicit.
+  using CoercionKey = std::tuple<const Type*, const Type*, bool>;
+
   class ContextBase;
   class Context;
 
@@ -197,6 +229,12 @@ class Coercer {
   Catalog* catalog_;           // Not owned. Can be null.
 
   const LanguageOptions& language_options_;  // Not owned.
+
+  mutable absl::Mutex mutex_;
+  mutable absl::flat_hash_map<std::vector<const Type*>, const Type*>
+      common_supertypes_ ABSL_GUARDED_BY(mutex_);
+  mutable absl::flat_hash_map<CoercionKey, MemoizedCoercion> struct_coercions_
+      ABSL_GUARDED_BY(mutex_);
   friend class CoercerTest;
 };
 
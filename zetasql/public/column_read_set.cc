@@ -0,0 +1,372 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/column_read_set.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "google/protobuf/descriptor.h"
+#include "zetasql/public/builtin_function.pb.h"
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/resolved_ast_visitor.h"
+#include "zetasql/resolved_ast/resolved_column.h"
+#include "zetasql/resolved_ast/resolved_node.h"
+#include "zetasql/resolved_ast/resolved_node_kind.pb.h"
+#include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_replace.h"
+#include "absl/strings/string_view.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+namespace {
+
+// Returns true if the columns of scans of kind `kind` only pass through their
+// column lists and ResolvedColumnRefs, and positionally through the
+// ResolvedNodes that ReadSetCollector handles.
+bool IsUnderstoodScan(ResolvedNodeKind kind) {
+  switch (kind) {
+    case RESOLVED_TABLE_SCAN:
+    case RESOLVED_SINGLE_ROW_SCAN:
+    case RESOLVED_PROJECT_SCAN:
+    case RESOLVED_FILTER_SCAN:
+    case RESOLVED_JOIN_SCAN:
+    case RESOLVED_ARRAY_SCAN:
+    case RESOLVED_AGGREGATE_SCAN:
+    case RESOLVED_ANALYTIC_SCAN:
+    case RESOLVED_ORDER_BY_SCAN:
+    case RESOLVED_LIMIT_OFFSET_SCAN:
+    case RESOLVED_SET_OPERATION_SCAN:
+    case RESOLVED_WITH_SCAN:
+    case RESOLVED_WITH_REF_SCAN:
+    case RESOLVED_SAMPLE_SCAN:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns true if `context_id` is the signature of a builtin function that
+// extracts a JSONPath from its first argument, a JSON value.
+bool IsJsonExtractionFunction(int64_t context_id) {
+  switch (context_id) {
+    case FN_JSON_EXTRACT_JSON:
+    case FN_JSON_EXTRACT_SCALAR_JSON:
+    case FN_JSON_EXTRACT_ARRAY_JSON:
+    case FN_JSON_EXTRACT_STRING_ARRAY_JSON:
+    case FN_JSON_QUERY_JSON:
+    case FN_JSON_QUERY_ARRAY_JSON:
+    case FN_JSON_VALUE_JSON:
+    case FN_JSON_VALUE_ARRAY_JSON:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns the JSONPath step of a member named `name`, quoted unless it is
+// made of letters, digits and underscores.
+std::string JsonMemberStep(absl::string_view name) {
+  const bool needs_quotes =
+      name.empty() || !std::all_of(name.begin(), name.end(), [](char c) {
+        return absl::ascii_isalnum(c) || c == '_';
+      });
+  if (!needs_quotes) {
+    return absl::StrCat(".", name);
+  }
+  return absl::StrCat(
+      ".\"", absl::StrReplaceAll(name, {{"\\", "\\\\"}, {"\"", "\\\""}}),
+      "\"");
+}
+
+// If `expr` reads a member or an element of a JSON value, returns the
+// JSONPath step of it and sets `input` to the expression of the JSON value.
+std::optional<std::string> JsonPathStep(const ResolvedExpr* expr,
+                                        const ResolvedExpr** input) {
+  if (expr->Is<ResolvedGetJsonField>()) {
+    const auto* get_field = expr->GetAs<ResolvedGetJsonField>();
+    *input = get_field->expr();
+    return JsonMemberStep(get_field->field_name());
+  }
+  if (!expr->Is<ResolvedFunctionCall>()) {
+    return std::nullopt;
+  }
+  const auto* call = expr->GetAs<ResolvedFunctionCall>();
+  if (!call->function()->IsZetaSQLBuiltin() ||
+      call->argument_list_size() != 2 ||
+      !call->argument_list(1)->Is<ResolvedLiteral>()) {
+    return std::nullopt;
+  }
+  const Value& subscript =
+      call->argument_list(1)->GetAs<ResolvedLiteral>()->value();
+  if (subscript.is_null()) {
+    return std::nullopt;
+  }
+  *input = call->argument_list(0);
+  switch (call->signature().context_id()) {
+    case FN_JSON_SUBSCRIPT_STRING:
+      if (!subscript.type()->IsString()) return std::nullopt;
+      return JsonMemberStep(subscript.string_value());
+    case FN_JSON_SUBSCRIPT_INT64:
+      if (!subscript.type()->IsInt64() || subscript.int64_value() < 0) {
+        return std::nullopt;
+      }
+      return absl::StrCat("[", subscript.int64_value(), "]");
+    default:
+      return std::nullopt;
+  }
+}
+
+// Collects the read sets of the columns of the ResolvedTableScans of a
+// statement.
+class ReadSetCollector : public ResolvedASTVisitor {
+ public:
+  absl::Status Collect(const ResolvedStatement& statement) {
+    std::vector<const ResolvedNode*> scans;
+    statement.GetDescendantsSatisfying(&ResolvedNode::IsScan, &scans);
+    bool understood = statement.Is<ResolvedQueryStmt>();
+    for (const ResolvedNode* scan : scans) {
+      understood = understood && IsUnderstoodScan(scan->node_kind());
+      if (!scan->Is<ResolvedTableScan>()) continue;
+      const auto* table_scan = scan->GetAs<ResolvedTableScan>();
+      ZETASQL_RET_CHECK_EQ(table_scan->column_list_size(),
+                   table_scan->column_index_list_size());
+      for (int i = 0; i < table_scan->column_list_size(); ++i) {
+        table_columns_[table_scan->column_list(i).column_id()] = {
+            table_scan->table(), table_scan->column_index_list(i)};
+      }
+    }
+    if (!understood) {
+      for (const auto& [column_id, column] : table_columns_) {
+        state_[column.table][column.index].reads_whole_value = true;
+      }
+      return absl::OkStatus();
+    }
+    for (const auto& output_column :
+         statement.GetAs<ResolvedQueryStmt>()->output_column_list()) {
+      ReadWholeColumn(output_column->column());
+    }
+    return statement.Accept(this);
+  }
+
+  absl::flat_hash_map<const Table*, TableReadSet> GetReadSet() const {
+    absl::flat_hash_map<const Table*, TableReadSet> read_set;
+    for (const auto& [table, columns] : state_) {
+      TableReadSet& table_read_set = read_set[table];
+      for (const auto& [index, state] : columns) {
+        ColumnReadSet& column_read_set = table_read_set[index];
+        column_read_set.reads_whole_value = state.reads_whole_value;
+        if (state.reads_whole_value) continue;
+        // A path sorts right before the paths that extend it.
+        for (const std::vector<std::string>& path : state.proto_field_paths) {
+          const std::vector<std::string>* last =
+              column_read_set.proto_field_paths.empty()
+                  ? nullptr
+                  : &column_read_set.proto_field_paths.back();
+          if (last != nullptr && last->size() <= path.size() &&
+              std::equal(last->begin(), last->end(), path.begin())) {
+            continue;
+          }
+          column_read_set.proto_field_paths.push_back(path);
+        }
+        column_read_set.json_paths.assign(state.json_paths.begin(),
+                                          state.json_paths.end());
+      }
+    }
+    return read_set;
+  }
+
+  absl::Status DefaultVisit(const ResolvedNode* node) override {
+    return node->ChildrenAccept(this);
+  }
+
+  absl::Status VisitResolvedColumnRef(const ResolvedColumnRef* node) override {
+    ReadWholeColumn(node->column());
+    return absl::OkStatus();
+  }
+
+  absl::Status VisitResolvedGetProtoField(
+      const ResolvedGetProtoField* node) override {
+    std::vector<std::string> path;
+    const ResolvedExpr* expr = node;
+    while (expr->Is<ResolvedGetProtoField>()) {
+      const auto* get_field = expr->GetAs<ResolvedGetProtoField>();
+      const google::protobuf::FieldDescriptor* field = get_field->field_descriptor();
+      path.push_back(field->is_extension()
+                         ? absl::StrCat("(", field->full_name(), ")")
+                         : std::string(field->name()));
+      expr = get_field->expr();
+    }
+    ColumnState* state = GetColumnState(expr);
+    if (state == nullptr) {
+      return DefaultVisit(node);
+    }
+    std::reverse(path.begin(), path.end());
+    state->proto_field_paths.insert(std::move(path));
+    return absl::OkStatus();
+  }
+
+  absl::Status VisitResolvedGetJsonField(
+      const ResolvedGetJsonField* node) override {
+    return VisitJsonAccess(node);
+  }
+
+  absl::Status VisitResolvedFunctionCall(
+      const ResolvedFunctionCall* node) override {
+    if (node->function()->IsZetaSQLBuiltin() &&
+        IsJsonExtractionFunction(node->signature().context_id()) &&
+        node->argument_list_size() >= 1 &&
+        node->argument_list(0)->type()->IsJson()) {
+      ColumnState* state = GetColumnState(node->argument_list(0));
+      if (state != nullptr && node->argument_list_size() == 1) {
+        // The JSONPath defaults to "$".
+        state->reads_whole_value = true;
+        return absl::OkStatus();
+      }
+      if (state != nullptr && node->argument_list_size() == 2 &&
+          node->argument_list(1)->Is<ResolvedLiteral>()) {
+        const Value& path =
+            node->argument_list(1)->GetAs<ResolvedLiteral>()->value();
+        if (!path.is_null() && path.type()->IsString()) {
+          if (path.string_value() == "$") {
+            state->reads_whole_value = true;
+          } else {
+            state->json_paths.insert(path.string_value());
+          }
+          return absl::OkStatus();
+        }
+      }
+    }
+    return VisitJsonAccess(node);
+  }
+
+  absl::Status VisitResolvedSubqueryExpr(
+      const ResolvedSubqueryExpr* node) override {
+    // All the subqueries other than EXISTS consume their output column.
+    if (node->subquery_type() != ResolvedSubqueryExpr::EXISTS) {
+      for (const ResolvedColumn& column : node->subquery()->column_list()) {
+        ReadWholeColumn(column);
+      }
+    }
+    // The parameter list only passes columns that the subquery references
+    // with correlated ResolvedColumnRefs of its own.
+    if (node->in_expr() != nullptr) {
+      ZETASQL_RETURN_IF_ERROR(node->in_expr()->Accept(this));
+    }
+    return node->subquery()->Accept(this);
+  }
+
+  absl::Status VisitResolvedSetOperationItem(
+      const ResolvedSetOperationItem* node) override {
+    for (const ResolvedColumn& column : node->output_column_list()) {
+      ReadWholeColumn(column);
+    }
+    return DefaultVisit(node);
+  }
+
+  absl::Status VisitResolvedWithEntry(const ResolvedWithEntry* node) override {
+    // ResolvedWithRefScans read the columns of the subquery positionally.
+    for (const ResolvedColumn& column : node->with_subquery()->column_list()) {
+      ReadWholeColumn(column);
+    }
+    return DefaultVisit(node);
+  }
+
+ private:
+  struct TableColumn {
+    const Table* table;
+    int index;
+  };
+
+  struct ColumnState {
+    bool reads_whole_value = false;
+    std::set<std::vector<std::string>> proto_field_paths;
+    std::set<std::string> json_paths;
+  };
+
+  // Returns the state of the table column that `expr` references, or null if
+  // it is not a ResolvedColumnRef of a column of a ResolvedTableScan.
+  ColumnState* GetColumnState(const ResolvedExpr* expr) {
+    if (!expr->Is<ResolvedColumnRef>()) {
+      return nullptr;
+    }
+    auto it = table_columns_.find(
+        expr->GetAs<ResolvedColumnRef>()->column().column_id());
+    if (it == table_columns_.end()) {
+      return nullptr;
+    }
+    return &state_[it->second.table][it->second.index];
+  }
+
+  void ReadWholeColumn(const ResolvedColumn& column) {
+    auto it = table_columns_.find(column.column_id());
+    if (it != table_columns_.end()) {
+      state_[it->second.table][it->second.index].reads_whole_value = true;
+    }
+  }
+
+  // Records the JSONPath of a chain of member and element accesses that starts
+  // with `node`, if it is applied to a table column.
+  absl::Status VisitJsonAccess(const ResolvedExpr* node) {
+    std::vector<std::string> steps;
+    const ResolvedExpr* expr = node;
+    while (true) {
+      const ResolvedExpr* input;
+      std::optional<std::string> step = JsonPathStep(expr, &input);
+      if (!step.has_value()) break;
+      steps.push_back(*std::move(step));
+      expr = input;
+    }
+    ColumnState* state = steps.empty() ? nullptr : GetColumnState(expr);
+    if (state == nullptr) {
+      return DefaultVisit(node);
+    }
+    std::reverse(steps.begin(), steps.end());
+    state->json_paths.insert(absl::StrCat("$", absl::StrJoin(steps, "")));
+    return absl::OkStatus();
+  }
+
+  // Keyed on column ids.
+  absl::flat_hash_map<int, TableColumn> table_columns_;
+  absl::flat_hash_map<const Table*, absl::btree_map<int, ColumnState>> state_;
+};
+
+}  // namespace
+
+absl::StatusOr<absl::flat_hash_map<const Table*, TableReadSet>>
+GetStatementReadSet(const ResolvedStatement& statement) {
+  ReadSetCollector collector;
+  ZETASQL_RETURN_IF_ERROR(collector.Collect(statement));
+  return collector.GetReadSet();
+}
+
+}  // namespace zetasql
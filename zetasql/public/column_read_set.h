@@ -0,0 +1,70 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_COLUMN_READ_SET_H_
+#define ZETASQL_PUBLIC_COLUMN_READ_SET_H_
+
+#include <string>
+#include <vector>
+
+#include "zetasql/public/catalog.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+
+namespace zetasql {
+
+// The parts of the value of a table column that a statement reads, which
+// storage can use to read only some sub-columns of large PROTO and JSON
+// columns.
+struct ColumnReadSet {
+  // True if the statement reads the whole value of the column, in which case
+  // the paths below are empty.
+  bool reads_whole_value = false;
+
+  // The fields that the statement reads from a PROTO column, as paths of field
+  // names from the message of the column, in sorted order. Extensions are
+  // named by their full names in parentheses, as in SQL. Reading a field
+  // reads all the fields under it, so no path is a prefix of another one.
+  std::vector<std::vector<std::string>> proto_field_paths;
+
+  // The JSONPaths that the statement reads from a JSON column in sorted order,
+  // such as "$.a.b" for `column.a.b`, or the path argument of a JSON_QUERY(),
+  // JSON_VALUE() or JSON_EXTRACT() family function as written in the query.
+  std::vector<std::string> json_paths;
+};
+
+// The columns of a table that a statement reads, keyed on their indexes in
+// the table.
+using TableReadSet = absl::btree_map<int, ColumnReadSet>;
+
+// Returns the read sets of the tables that `statement` scans, such as the
+// resolved_statement() of an AnalyzerOutput. Columns of the tables that the
+// statement does not read are left out.
+//
+// Paths are only computed for a ResolvedQueryStmt that is made of the common
+// kinds of scans, and only for field accesses and JSON functions directly on a
+// column of a ResolvedTableScan. Any other use of a column reads its whole
+// value. For any other statement, including queries with TVFs, pivots or
+// recursive WITH, all the columns of all the ResolvedTableScans read their
+// whole values, so the result is always safe to prune storage reads with.
+absl::StatusOr<absl::flat_hash_map<const Table*, TableReadSet>>
+GetStatementReadSet(const ResolvedStatement& statement);
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_COLUMN_READ_SET_H_
@@ -0,0 +1,142 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/column_read_set.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/check.h"
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/analyzer.h"
+#include "zetasql/public/analyzer_options.h"
+#include "zetasql/public/analyzer_output.h"
+#include "zetasql/public/builtin_function_options.h"
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/options.pb.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/types/type_factory.h"
+#include "zetasql/testdata/test_schema.pb.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+
+namespace zetasql {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+class ColumnReadSetTest : public ::testing::Test {
+ protected:
+  ColumnReadSetTest() : catalog_("test", &type_factory_) {
+    catalog_.AddBuiltinFunctions(BuiltinFunctionOptions::AllReleasedFunctions());
+    const ProtoType* proto_type;
+    ZETASQL_CHECK_OK(type_factory_.MakeProtoType(
+        zetasql_test__::KitchenSinkPB::descriptor(), &proto_type));
+    auto table = std::make_unique<SimpleTable>(
+        "T", std::vector<SimpleTable::NameAndType>{
+                 {"key", types::Int64Type()},
+                 {"p", proto_type},
+                 {"j", types::JsonType()},
+                 {"other", types::Int64Type()},
+                 {"unread", types::Int64Type()}});
+    table_ = table.get();
+    catalog_.AddOwnedTable(std::move(table));
+    options_.mutable_language()->EnableLanguageFeature(FEATURE_JSON_TYPE);
+    options_.mutable_language()->SetSupportsAllStatementKinds();
+    ZETASQL_CHECK_OK(options_.AddQueryParameter("path", types::StringType()));
+  }
+
+  absl::StatusOr<TableReadSet> GetTableReadSet(const std::string& sql) {
+    std::unique_ptr<const AnalyzerOutput> output;
+    ZETASQL_RETURN_IF_ERROR(
+        AnalyzeStatement(sql, options_, &catalog_, &type_factory_, &output));
+    ZETASQL_ASSIGN_OR_RETURN(
+        (absl::flat_hash_map<const Table*, TableReadSet> read_set),
+        GetStatementReadSet(*output->resolved_statement()));
+    return read_set[table_];
+  }
+
+  TypeFactory type_factory_;
+  SimpleCatalog catalog_;
+  const Table* table_;
+  AnalyzerOptions options_;
+};
+
+TEST_F(ColumnReadSetTest, ReadsPathsOfProtoAndJsonColumns) {
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      TableReadSet read_set,
+      GetTableReadSet("SELECT key, p.int64_key_1, p.nested_value.nested_int64, "
+                      "p.nested_value, j.a.b, JSON_VALUE(j, '$.c'), j['d'][0] "
+                      "FROM T WHERE other > 0"));
+  ASSERT_EQ(read_set.size(), 4);
+  EXPECT_TRUE(read_set[0].reads_whole_value);
+
+  const ColumnReadSet& p = read_set[1];
+  EXPECT_FALSE(p.reads_whole_value);
+  EXPECT_THAT(p.proto_field_paths,
+              ElementsAre(ElementsAre("int64_key_1"),
+                          ElementsAre("nested_value")));
+  EXPECT_THAT(p.json_paths, IsEmpty());
+
+  const ColumnReadSet& j = read_set[2];
+  EXPECT_FALSE(j.reads_whole_value);
+  EXPECT_THAT(j.proto_field_paths, IsEmpty());
+  EXPECT_THAT(j.json_paths, ElementsAre("$.a.b", "$.c", "$.d[0]"));
+
+  EXPECT_TRUE(read_set[3].reads_whole_value);
+  EXPECT_FALSE(read_set.contains(4));
+}
+
+TEST_F(ColumnReadSetTest, ReadsWholeValuesOfOtherUses) {
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      TableReadSet read_set,
+      GetTableReadSet("SELECT p.string_val FROM T UNION ALL "
+                      "SELECT p.string_val FROM T"));
+  EXPECT_THAT(read_set[1].proto_field_paths,
+              ElementsAre(ElementsAre("string_val")));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(read_set, GetTableReadSet("SELECT p, j.a FROM T"));
+  EXPECT_TRUE(read_set[1].reads_whole_value);
+  EXPECT_THAT(read_set[1].proto_field_paths, IsEmpty());
+  EXPECT_FALSE(read_set[2].reads_whole_value);
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      read_set,
+      GetTableReadSet("WITH w AS (SELECT p FROM T) SELECT p.string_val FROM w"));
+  EXPECT_TRUE(read_set[1].reads_whole_value);
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      read_set,
+      GetTableReadSet("SELECT (SELECT p.string_val), j.a FROM T "
+                      "WHERE JSON_VALUE(j, @path) IS NULL"));
+  EXPECT_THAT(read_set[1].proto_field_paths,
+              ElementsAre(ElementsAre("string_val")));
+  EXPECT_TRUE(read_set[2].reads_whole_value);
+
+  // Statements other than queries read all of their scanned columns.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      read_set,
+      GetTableReadSet("CREATE TABLE x AS SELECT p.string_val FROM T"));
+  EXPECT_TRUE(read_set[1].reads_whole_value);
+}
+
+}  // namespace
+}  // namespace zetasql
@@ -16,6 +16,7 @@
 
 #include "zetasql/public/evaluator_base.h"
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <optional>
@@ -26,7 +27,9 @@
 #include <vector>
 
 #include "zetasql/base/logging.h"
+#include "zetasql/common/columnar_result_reader.h"
 #include "zetasql/common/internal_analyzer_options.h"
+#include "zetasql/common/timer_util.h"
 #include "zetasql/public/analyzer.h"
 #include "zetasql/public/catalog.h"
 #include "zetasql/public/language_options.h"
@@ -36,10 +39,14 @@
 #include "zetasql/public/type.h"
 #include "zetasql/public/value.h"
 #include "zetasql/reference_impl/algebrizer.h"
+#include "zetasql/reference_impl/common.h"
 #include "zetasql/reference_impl/evaluation.h"
 #include "zetasql/reference_impl/operator.h"
+#include "zetasql/reference_impl/operator_profile.h"
 #include "zetasql/reference_impl/parameters.h"
+#include "zetasql/reference_impl/plan_fragments.h"
 #include "zetasql/reference_impl/tuple.h"
+#include "zetasql/reference_impl/variable_generator.h"
 #include "zetasql/reference_impl/variable_id.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
 #include "zetasql/resolved_ast/resolved_column.h"
@@ -47,11 +54,13 @@
 #include "zetasql/resolved_ast/resolved_node_kind.pb.h"
 #include "zetasql/resolved_ast/validator.h"
 #include "zetasql/base/case.h"
+#include "absl/container/btree_set.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/node_hash_map.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "absl/types/span.h"
@@ -219,10 +228,163 @@ class ReferenceResultIterator : public EvaluatorTableIterator {
   const std::function<void()> deletion_cb_;
 };
 
+// Iterates over the rows of several vectors, one after the other.
+class RowsIterator : public EvaluatorTableIterator {
+ public:
+  using Rows = std::vector<std::vector<Value>>;
+
+  RowsIterator(absl::Span<const Type* const> types,
+               std::vector<std::shared_ptr<const Rows>> parts)
+      : types_(types.begin(), types.end()), parts_(std::move(parts)) {}
+
+  int NumColumns() const override { return static_cast<int>(types_.size()); }
+  std::string GetColumnName(int i) const override { return ""; }
+  const Type* GetColumnType(int i) const override { return types_[i]; }
+
+  bool NextRow() override {
+    ++row_;
+    while (part_ < parts_.size() && row_ >= parts_[part_]->size()) {
+      ++part_;
+      row_ = 0;
+    }
+    return part_ < parts_.size();
+  }
+
+  const Value& GetValue(int i) const override {
+    return (*parts_[part_])[row_][i];
+  }
+
+  absl::Status Status() const override { return absl::OkStatus(); }
+  absl::Status Cancel() override { return absl::OkStatus(); }
+
+ private:
+  const std::vector<const Type*> types_;
+  const std::vector<std::shared_ptr<const Rows>> parts_;
+  int part_ = 0;
+  int64_t row_ = -1;
+};
+
+// Returns the options that statements and expressions are algebrized with.
+AlgebrizerOptions GetAlgebrizerOptions() {
+  AlgebrizerOptions algebrizer_options;
+  algebrizer_options.consolidate_proto_field_accesses = true;
+  algebrizer_options.allow_hash_join = true;
+  algebrizer_options.allow_range_join = true;
+  algebrizer_options.allow_merge_join = true;
+  algebrizer_options.use_row_count_estimates = true;
+  algebrizer_options.use_join_key_filters = true;
+  algebrizer_options.allow_order_by_limit_operator = true;
+  algebrizer_options.push_down_filters = true;
+  algebrizer_options.inline_with_entries = true;
+  algebrizer_options.memoize_subqueries = true;
+  algebrizer_options.allow_semi_join = true;
+  algebrizer_options.report_referenced_columns = true;
+  algebrizer_options.fold_constants = true;
+  algebrizer_options.eliminate_common_subexpressions = true;
+  algebrizer_options.group_json_extractions = true;
+  algebrizer_options.stream_generated_arrays = true;
+  return algebrizer_options;
+}
+
+// Returns the variables of the TupleData that an algebrized plan is evaluated
+// with: the columns, then the parameters, then the system variables.
+std::vector<VariableId> GetParamsVariables(
+    const ParameterMap& column_map, const Parameters& parameters,
+    const SystemVariablesAlgebrizerMap& system_variables) {
+  std::vector<VariableId> vars;
+  for (const auto& elt : column_map) {
+    vars.push_back(elt.second);
+  }
+  if (parameters.is_named()) {
+    for (const auto& elt : parameters.named_parameters()) {
+      vars.push_back(elt.second);
+    }
+  } else {
+    const ParameterList& params = parameters.positional_parameters();
+    vars.insert(vars.end(), params.begin(), params.end());
+  }
+  for (const auto& system_variable : system_variables) {
+    vars.push_back(system_variable.second);
+  }
+  return vars;
+}
+
+// Returns the rows of 'op', with the values of the variables of its output
+// schema in order.
+absl::StatusOr<std::shared_ptr<const RowsIterator::Rows>> ReadRows(
+    const RelationalOp& op, const TupleData& params_data,
+    EvaluationContext* context) {
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<TupleIterator> iter,
+                   op.Eval({&params_data}, /*num_extra_slots=*/0, context));
+  const int num_variables = iter->Schema().num_variables();
+  auto rows = std::make_shared<RowsIterator::Rows>();
+  while (const TupleData* data = iter->Next()) {
+    std::vector<Value>& row = rows->emplace_back();
+    row.reserve(num_variables);
+    for (int i = 0; i < num_variables; ++i) {
+      row.push_back(data->slot(i).value());
+    }
+  }
+  ZETASQL_RETURN_IF_ERROR(iter->Status());
+  return rows;
+}
+
 }  // namespace
 
 namespace internal {
 
+// The plan and the state of an IncrementalQueryState. The query is split at
+// its aggregation (see SplitAtPartialAggregate()): 'delta_op_' computes the
+// partial aggregates of the rows appended since the previous execution,
+// 'merge_op_' merges them with 'groups_', and 'output_op_' is the rest of the
+// query over the merged partial aggregates.
+class IncrementalQueryPlan : public ExchangeReceiver {
+ public:
+  // The exchange through which 'output_op_' reads 'groups_'.
+  static constexpr int kGroupsExchangeId = 1;
+  // The exchange through which 'merge_op_' reads 'merge_input_'.
+  static constexpr int kMergeExchangeId = 2;
+
+  IncrementalQueryPlan(const Evaluator* evaluator, const Table* table)
+      : evaluator_(evaluator), table_(table) {}
+
+  absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>> Receive(
+      int exchange_id, absl::Span<const Type* const> column_types) override {
+    switch (exchange_id) {
+      case kGroupsExchangeId:
+        return std::make_unique<RowsIterator>(
+            column_types,
+            std::vector<std::shared_ptr<const RowsIterator::Rows>>{groups_});
+      case kMergeExchangeId:
+        return std::make_unique<RowsIterator>(column_types, merge_input_);
+      default:
+        ZETASQL_RET_CHECK_FAIL() << "Unknown exchange " << exchange_id;
+    }
+  }
+
+ private:
+  friend class Evaluator;
+  friend class ::zetasql::IncrementalQueryState;
+
+  const Evaluator* const evaluator_;
+  const Table* const table_;
+  std::unique_ptr<RelationalOp> delta_op_;
+  std::unique_ptr<RelationalOp> merge_op_;
+  // Wrapped in the RootOp of the plan, which owns state shared by all three
+  // ops.
+  std::unique_ptr<RelationalOp> output_op_;
+  std::vector<VariableId> output_column_variables_;
+
+  // The number of rows of 'table_' that 'groups_' aggregates.
+  int64_t num_rows_read_ = 0;
+  // One row of partial aggregates for each group, as the output of
+  // 'delta_op_'.
+  std::shared_ptr<const RowsIterator::Rows> groups_ =
+      std::make_shared<const RowsIterator::Rows>();
+  // The partial aggregates that 'merge_op_' merges during an execution.
+  std::vector<std::shared_ptr<const RowsIterator::Rows>> merge_input_;
+};
+
 class Evaluator {
  public:
   Evaluator(const std::string& sql, bool is_expr,
@@ -266,25 +428,55 @@ class Evaluator {
       std::unique_ptr<EvaluatorTableIterator>* query_output_iterator)
       ABSL_LOCKS_EXCLUDED(mutex_);
 
+  // If 'profile' is non-NULL, the runtime statistics of the operators of a
+  // query are recorded into it while 'query_output_iterator' is consumed.
   absl::Status ExecuteAfterPrepare(
       ExpressionOptions options, Value* expression_output_value,
-      std::unique_ptr<EvaluatorTableIterator>* query_output_iterator) const
-      ABSL_LOCKS_EXCLUDED(mutex_) {
+      std::unique_ptr<EvaluatorTableIterator>* query_output_iterator,
+      OperatorProfile* profile = nullptr) const ABSL_LOCKS_EXCLUDED(mutex_) {
     absl::ReaderMutexLock l(&mutex_);
-    return ExecuteAfterPrepareLocked(
-        std::move(options), expression_output_value, query_output_iterator);
+    return ExecuteAfterPrepareLocked(std::move(options),
+                                     expression_output_value,
+                                     query_output_iterator, profile);
   }
 
   absl::Status ExecuteAfterPrepareWithOrderedParams(
       const ExpressionOptions& options, Value* expression_output_value,
-      std::unique_ptr<EvaluatorTableIterator>* query_output_iterator) const
-      ABSL_LOCKS_EXCLUDED(mutex_) {
+      std::unique_ptr<EvaluatorTableIterator>* query_output_iterator,
+      OperatorProfile* profile = nullptr) const ABSL_LOCKS_EXCLUDED(mutex_) {
     absl::ReaderMutexLock l(&mutex_);
     return ExecuteAfterPrepareWithOrderedParamsLocked(
-        options, expression_output_value, query_output_iterator);
+        options, expression_output_value, query_output_iterator, profile);
   }
 
-  absl::StatusOr<std::string> ExplainAfterPrepare() const
+  // Implements PreparedQueryBase::ExecuteIncrementallyAfterPrepare().
+  absl::Status ExecuteIncrementallyAfterPrepare(
+      ExpressionOptions options, const Table* appended_table,
+      IncrementalQueryState* state,
+      std::unique_ptr<EvaluatorTableIterator>* query_output_iterator) const
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // If 'profile' is non-NULL and this is a query, each operator is annotated
+  // with its statistics from 'profile'.
+  absl::StatusOr<std::string> ExplainAfterPrepare(
+      const OperatorProfile* profile = nullptr) const
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Implements PreparedExpressionBase::BindAfterPrepare().
+  absl::StatusOr<std::unique_ptr<BoundExpression>> Bind(
+      const SystemVariableValuesMap& system_variables) const
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Implements BoundExpression::Execute().
+  absl::StatusOr<Value> ExecuteBound(absl::Span<const Value> columns,
+                                     absl::Span<const Value> parameters,
+                                     BoundExpression* bound) const
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Implements BoundExpression::ExecuteBatch().
+  absl::StatusOr<std::vector<Value>> ExecuteBoundBatch(
+      int64_t num_rows, absl::Span<const ParameterValueList> columns,
+      absl::Span<const Value> parameters, BoundExpression* bound) const
       ABSL_LOCKS_EXCLUDED(mutex_);
 
   // Returns NULL if this object is for a query instead of an expression.
@@ -371,14 +563,38 @@ class Evaluator {
   // with a write lock).
   absl::Status ExecuteAfterPrepareLocked(
       ExpressionOptions options, Value* expression_output_value,
-      std::unique_ptr<EvaluatorTableIterator>* query_output_iterator) const
+      std::unique_ptr<EvaluatorTableIterator>* query_output_iterator,
+      OperatorProfile* profile = nullptr) const
+      ABSL_SHARED_LOCKS_REQUIRED(mutex_);
+
+  // Evaluates 'bound' for one row into 'result', without re-reading the clock.
+  absl::Status ExecuteBoundLocked(absl::Span<const Value> columns,
+                                  absl::Span<const Value> parameters,
+                                  BoundExpression* bound, Value* result) const
       ABSL_SHARED_LOCKS_REQUIRED(mutex_);
 
   // Same as ExecuteAfterPrepareWithOrderedParams(), but with the mutex already
   // locked.
   absl::Status ExecuteAfterPrepareWithOrderedParamsLocked(
       const ExpressionOptions& options, Value* expression_output_value,
-      std::unique_ptr<EvaluatorTableIterator>* query_output_iterator) const
+      std::unique_ptr<EvaluatorTableIterator>* query_output_iterator,
+      OperatorProfile* profile = nullptr) const
+      ABSL_SHARED_LOCKS_REQUIRED(mutex_);
+
+  // Returns 'options' with its columns and named parameters, if any, replaced
+  // by ordered ones, as ExecuteAfterPrepareWithOrderedParams() takes them.
+  absl::StatusOr<ExpressionOptions> OrderParametersLocked(
+      ExpressionOptions options) const ABSL_SHARED_LOCKS_REQUIRED(mutex_);
+
+  // Returns the TupleData of the ordered columns, parameters and system
+  // variables of 'options' that the algebrized plan is evaluated with.
+  TupleData CreateParamsDataLocked(const ExpressionOptions& options) const
+      ABSL_SHARED_LOCKS_REQUIRED(mutex_);
+
+  // Algebrizes the query again and splits it for incremental execution over
+  // the rows appended to 'appended_table'.
+  absl::StatusOr<std::unique_ptr<IncrementalQueryPlan>>
+  CreateIncrementalPlanLocked(const Table* appended_table) const
       ABSL_SHARED_LOCKS_REQUIRED(mutex_);
 
   // Checks if 'parameters_map' specifies valid values for all variables from
@@ -418,11 +634,21 @@ class Evaluator {
     evaluation_options.scramble_undefined_orderings =
         evaluator_options_.scramble_undefined_orderings;
     evaluation_options.store_proto_field_value_maps = true;
+    evaluation_options.use_proto_field_index = true;
+    evaluation_options.use_tuple_arena = true;
     evaluation_options.use_top_n_accumulator_when_possible = true;
     evaluation_options.max_value_byte_size =
         evaluator_options_.max_value_byte_size;
     evaluation_options.max_intermediate_byte_size =
         evaluator_options_.max_intermediate_byte_size;
+    evaluation_options.num_threads = evaluator_options_.num_threads;
+    evaluation_options.executor = evaluator_options_.executor;
+    evaluation_options.tracer = evaluator_options_.tracer;
+    evaluation_options.memory_pool = evaluator_options_.memory_pool;
+    evaluation_options.scan_prefetch_rows =
+        evaluator_options_.scan_prefetch_rows;
+    evaluation_options.spill_directory = evaluator_options_.spill_directory;
+    evaluation_options.tuple_batch_size = evaluator_options_.tuple_batch_size;
     evaluation_options.return_all_rows_for_dml = false;
 
     auto context = std::make_unique<EvaluationContext>(evaluation_options);
@@ -532,6 +758,13 @@ absl::Status Evaluator::PrepareLocked(const AnalyzerOptions& options,
   }
   is_prepared_ = true;
   analyzer_options_ = options;
+  if (evaluator_options_.skip_rewrites_with_native_support) {
+    absl::btree_set<ResolvedASTRewrite> rewrites = options.enabled_rewrites();
+    for (ResolvedASTRewrite rewrite : RewritesWithNativeSupportInReference()) {
+      rewrites.erase(rewrite);
+    }
+    analyzer_options_.set_enabled_rewrites(std::move(rewrites));
+  }
   // TODO: Enable pruning by default. We will need to
   // fix some Table::CreateEvaluatorTableIterator() implementations to
   // respect the input column indexes.
@@ -546,12 +779,7 @@ absl::Status Evaluator::PrepareLocked(const AnalyzerOptions& options,
     catalog = owned_catalog_.get();
   }
 
-  AlgebrizerOptions algebrizer_options;
-  algebrizer_options.consolidate_proto_field_accesses = true;
-  algebrizer_options.allow_hash_join = true;
-  algebrizer_options.allow_order_by_limit_operator = true;
-  algebrizer_options.push_down_filters = true;
-  algebrizer_options.inline_with_entries = true;
+  const AlgebrizerOptions algebrizer_options = GetAlgebrizerOptions();
 
   if (!is_expr_) {
     if (statement_ == nullptr) {
@@ -627,28 +855,9 @@ absl::Status Evaluator::PrepareLocked(const AnalyzerOptions& options,
   }
 
   // Build the TupleSchema for the parameters.
-  const int num_params =
-      algebrizer_parameters_.is_named()
-          ? algebrizer_parameters_.named_parameters().size()
-          : algebrizer_parameters_.positional_parameters().size();
-  std::vector<VariableId> vars;
-  vars.reserve(algebrizer_column_map_.size() + num_params);
-  for (const auto& elt : algebrizer_column_map_) {
-    vars.push_back(elt.second);
-  }
-  if (algebrizer_parameters_.is_named()) {
-    for (const auto& elt : algebrizer_parameters_.named_parameters()) {
-      vars.push_back(elt.second);
-    }
-  } else {
-    const ParameterList& params =
-        algebrizer_parameters_.positional_parameters();
-    vars.insert(vars.end(), params.begin(), params.end());
-  }
-  for (const auto& system_variable : algebrizer_system_variables_) {
-    vars.push_back(system_variable.second);
-  }
-  const TupleSchema params_schema(vars);
+  const TupleSchema params_schema(
+      GetParamsVariables(algebrizer_column_map_, algebrizer_parameters_,
+                         algebrizer_system_variables_));
 
   // Set the TupleSchema for the parameters.
   if (compiled_relational_op_ != nullptr) {
@@ -800,7 +1009,8 @@ absl::Status Evaluator::Execute(
 
 absl::Status Evaluator::ExecuteAfterPrepareLocked(
     ExpressionOptions options, Value* expression_output_value,
-    std::unique_ptr<EvaluatorTableIterator>* query_output_iterator) const {
+    std::unique_ptr<EvaluatorTableIterator>* query_output_iterator,
+    OperatorProfile* profile) const {
   if (!has_prepare_succeeded()) {
     // Previous Prepare() failed with an analysis error or Prepare was never
     // called. Returns an error for consistency.
@@ -808,6 +1018,14 @@ absl::Status Evaluator::ExecuteAfterPrepareLocked(
            << "Invalid prepared expression/query";
   }
 
+  ZETASQL_ASSIGN_OR_RETURN(ExpressionOptions ordered_options,
+                   OrderParametersLocked(std::move(options)));
+  return ExecuteAfterPrepareWithOrderedParamsLocked(
+      ordered_options, expression_output_value, query_output_iterator, profile);
+}
+
+absl::StatusOr<ExpressionOptions> Evaluator::OrderParametersLocked(
+    ExpressionOptions options) const {
   ParameterValueList columns_list;
   ZETASQL_RETURN_IF_ERROR(
       TranslateParameterValueMapToList(*options.columns, algebrizer_column_map_,
@@ -829,9 +1047,7 @@ absl::Status Evaluator::ExecuteAfterPrepareLocked(
   ExpressionOptions new_options = std::move(options);
   new_options.ordered_columns = std::move(columns_list);
   new_options.ordered_parameters = std::move(parameters_list);
-
-  return ExecuteAfterPrepareWithOrderedParamsLocked(
-      new_options, expression_output_value, query_output_iterator);
+  return new_options;
 }
 
 absl::StatusOr<EvaluatorModifyResult> Evaluator::MakeUpdateIterator(
@@ -899,22 +1115,35 @@ class TupleIteratorAdaptor : public EvaluatorTableIterator {
   using NameAndType = PreparedQueryBase::NameAndType;
 
   // 'tuple_indexes[i]' is in the index in a TupleData returned by 'iter' of the
-  // value for 'columns[i]'.
+  // value for 'columns[i]'. If 'stats' is non-null, it is set when the
+  // adaptor is destroyed, and 'timed_value' is the time spent creating
+  // 'iter'.
   TupleIteratorAdaptor(const std::vector<NameAndType>& columns,
                        const std::vector<int>& tuple_indexes,
                        const std::function<void()>& deletion_cb,
                        std::unique_ptr<EvaluationContext> context,
-                       std::unique_ptr<TupleIterator> iter)
+                       std::unique_ptr<TupleIterator> iter,
+                       EvaluationStats* stats = nullptr,
+                       const internal::TimedValue& timed_value = {})
       : columns_(columns),
         tuple_indexes_(tuple_indexes),
         deletion_cb_(deletion_cb),
+        stats_(stats),
         context_(std::move(context)),
-        iter_(std::move(iter)) {}
+        iter_(std::move(iter)),
+        timed_value_(timed_value) {}
 
   TupleIteratorAdaptor(const TupleIteratorAdaptor&) = delete;
   TupleIteratorAdaptor& operator=(const TupleIteratorAdaptor&) = delete;
 
-  ~TupleIteratorAdaptor() override { deletion_cb_(); }
+  ~TupleIteratorAdaptor() override {
+    if (stats_ != nullptr) {
+      absl::MutexLock l(&mutex_);
+      stats_->execution_stats = timed_value_.ToExecutionStatsProto();
+      stats_->peak_memory_bytes = context_->memory_accountant()->peak_bytes();
+    }
+    deletion_cb_();
+  }
 
   int NumColumns() const override { return columns_.size(); }
 
@@ -924,7 +1153,13 @@ class TupleIteratorAdaptor : public EvaluatorTableIterator {
 
   bool NextRow() override {
     absl::MutexLock l(&mutex_);
-    current_ = iter_->Next();
+    if (stats_ != nullptr) {
+      internal::ElapsedTimer timer = internal::MakeTimerStarted();
+      current_ = iter_->Next();
+      timed_value_.Accumulate(timer);
+    } else {
+      current_ = iter_->Next();
+    }
     called_next_ = true;
     return current_ != nullptr;
   }
@@ -953,6 +1188,7 @@ class TupleIteratorAdaptor : public EvaluatorTableIterator {
   const std::vector<NameAndType> columns_;
   const std::vector<int> tuple_indexes_;
   const std::function<void()> deletion_cb_;
+  EvaluationStats* const stats_;
   mutable absl::Mutex mutex_;
   std::unique_ptr<EvaluationContext> context_ ABSL_GUARDED_BY(mutex_)
       ABSL_PT_GUARDED_BY(mutex_);
@@ -962,12 +1198,14 @@ class TupleIteratorAdaptor : public EvaluatorTableIterator {
   const TupleData* current_ ABSL_GUARDED_BY(mutex_)
       ABSL_PT_GUARDED_BY(mutex_) = nullptr;
   absl::Status status_ ABSL_GUARDED_BY(mutex_);
+  internal::TimedValue timed_value_ ABSL_GUARDED_BY(mutex_);
 };
 }  // namespace
 
 absl::Status Evaluator::ExecuteAfterPrepareWithOrderedParamsLocked(
     const ExpressionOptions& options, Value* expression_output_value,
-    std::unique_ptr<EvaluatorTableIterator>* query_output_iterator) const {
+    std::unique_ptr<EvaluatorTableIterator>* query_output_iterator,
+    OperatorProfile* profile) const {
   if (!has_prepare_succeeded()) {
     // Previous Prepare() failed with an analysis error or Prepare was never
     // called. Returns an error for consistency.
@@ -982,21 +1220,16 @@ absl::Status Evaluator::ExecuteAfterPrepareWithOrderedParamsLocked(
   ZETASQL_RETURN_IF_ERROR(ValidateParameters(parameters));
   ZETASQL_RETURN_IF_ERROR(ValidateSystemVariables(system_variables));
 
+  const internal::ElapsedTimer timer = internal::MakeTimerStarted();
   std::unique_ptr<EvaluationContext> context = CreateEvaluationContext();
   context->SetStatementEvaluationDeadline(options.deadline);
+  context->set_operator_profile(profile);
 
   if (options.session_user.has_value()) {
     context->SetSessionUser(options.session_user.value());
   }
 
-  ParameterValueList params;
-  params.reserve(columns.size() + parameters.size() + system_variables.size());
-  params.insert(params.end(), columns.begin(), columns.end());
-  params.insert(params.end(), parameters.begin(), parameters.end());
-  for (const auto& algebrizer_sysvar : algebrizer_system_variables_) {
-    params.push_back(system_variables.at(algebrizer_sysvar.first));
-  }
-  const TupleData params_data = CreateTupleDataFromValues(std::move(params));
+  const TupleData params_data = CreateParamsDataLocked(options);
 
   if (compiled_relational_op_ != nullptr) {
     ZETASQL_ASSIGN_OR_RETURN(
@@ -1017,26 +1250,349 @@ absl::Status Evaluator::ExecuteAfterPrepareWithOrderedParamsLocked(
     };
     *query_output_iterator = std::make_unique<TupleIteratorAdaptor>(
         output_columns_, tuple_indexes, deletion_cb, std::move(context),
-        std::move(tuple_iter));
+        std::move(tuple_iter), options.stats,
+        internal::TimedValue(timer.GetStart(),
+                             internal::ResourceMeasurement::CreateEnd()));
   } else {
     ZETASQL_RET_CHECK(compiled_value_expr_ != nullptr);
 
     TupleSlot result;
     absl::Status status;
-    if (!compiled_value_expr_->EvalSimple({&params_data}, context.get(),
-                                          &result, &status)) {
-      return status;
+    const bool succeeded = compiled_value_expr_->EvalSimple(
+        {&params_data}, context.get(), &result, &status);
+    if (options.stats != nullptr) {
+      options.stats->execution_stats =
+          internal::TimedValue(timer.GetStart(),
+                               internal::ResourceMeasurement::CreateEnd())
+              .ToExecutionStatsProto();
+      options.stats->peak_memory_bytes =
+          context->memory_accountant()->peak_bytes();
     }
+    if (!succeeded) return status;
     *expression_output_value = result.value();
   }
 
   return absl::OkStatus();
 }
 
-absl::StatusOr<std::string> Evaluator::ExplainAfterPrepare() const {
+TupleData Evaluator::CreateParamsDataLocked(
+    const ExpressionOptions& options) const {
+  const ParameterValueList& columns = options.ordered_columns.value();
+  const ParameterValueList& parameters = options.ordered_parameters.value();
+  ParameterValueList params;
+  params.reserve(columns.size() + parameters.size() +
+                 algebrizer_system_variables_.size());
+  params.insert(params.end(), columns.begin(), columns.end());
+  params.insert(params.end(), parameters.begin(), parameters.end());
+  for (const auto& algebrizer_sysvar : algebrizer_system_variables_) {
+    params.push_back(options.system_variables.at(algebrizer_sysvar.first));
+  }
+  return CreateTupleDataFromValues(std::move(params));
+}
+
+absl::StatusOr<std::unique_ptr<IncrementalQueryPlan>>
+Evaluator::CreateIncrementalPlanLocked(const Table* appended_table) const {
+  auto plan = std::make_unique<IncrementalQueryPlan>(this, appended_table);
+
+  // The query is algebrized again so that 'compiled_relational_op_' is left
+  // alone. The new plan takes the same parameters in the same order.
+  Parameters parameters;
+  parameters.set_named(algebrizer_parameters_.is_named());
+  ParameterMap column_map;
+  SystemVariablesAlgebrizerMap system_variables;
+  ResolvedColumnList output_column_list;
+  std::vector<std::string> output_column_names;
+  std::unique_ptr<RelationalOp> root;
+  ZETASQL_RETURN_IF_ERROR(Algebrizer::AlgebrizeQueryStatementAsRelation(
+      analyzer_options_.language(), GetAlgebrizerOptions(),
+      evaluator_options_.type_factory, statement_->GetAs<ResolvedQueryStmt>(),
+      &output_column_list, &root, &output_column_names,
+      &plan->output_column_variables_, &parameters, &column_map,
+      &system_variables));
+  const std::vector<VariableId> params_variables =
+      GetParamsVariables(column_map, parameters, system_variables);
+  ZETASQL_RET_CHECK(params_variables ==
+            GetParamsVariables(algebrizer_column_map_, algebrizer_parameters_,
+                               algebrizer_system_variables_));
+
+  // Takes the query out of its RootOp to split it.
+  AlgebraArg* query_arg = nullptr;
+  for (AlgebraArg* arg : root->GetMutableArgs()) {
+    if (arg->relational_op() != nullptr) query_arg = arg;
+  }
+  ZETASQL_RET_CHECK(query_arg != nullptr);
+  std::unique_ptr<RelationalOp> query = absl::WrapUnique(
+      query_arg->ReplaceNode(nullptr).release()->AsMutableRelationalOp());
+
+  VariableGenerator variable_gen;
+  ZETASQL_ASSIGN_OR_RETURN(
+      std::optional<PlanFragments> fragments,
+      SplitAtPartialAggregate(IncrementalQueryPlan::kGroupsExchangeId,
+                              plan.get(), &variable_gen, &query));
+  if (!fragments.has_value() ||
+      !CanEvaluateOverAppendedRows(*fragments, appended_table)) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder()
+           << "Query cannot be executed incrementally over the rows appended "
+              "to table "
+           << appended_table->Name()
+           << ": it must aggregate that table with mergeable aggregate "
+              "functions, after reading it once through filters, projections "
+              "and joins that keep each of its rows on their own";
+  }
+  const auto* delta_aggregate =
+      dynamic_cast<const AggregateOp*>(fragments->shard_fragment.get());
+  ZETASQL_RET_CHECK(delta_aggregate != nullptr);
+
+  // The merge reads the kept and the new partial aggregates, which both have
+  // the types of the output of 'delta_aggregate', with new variables.
+  const std::vector<const Type*> types = delta_aggregate->GetOutputTypes();
+  const std::unique_ptr<TupleSchema> schema =
+      delta_aggregate->CreateOutputSchema();
+  ZETASQL_RET_CHECK_EQ(types.size(), schema->num_variables());
+  std::vector<VariableId> merge_variables;
+  std::vector<std::unique_ptr<ExprArg>> merge_columns;
+  for (int i = 0; i < types.size(); ++i) {
+    merge_variables.push_back(variable_gen.GetNewVariableName(
+        absl::StrCat(schema->variable(i).ToString(), "_kept")));
+    merge_columns.push_back(
+        std::make_unique<ExprArg>(merge_variables.back(), types[i]));
+  }
+  ZETASQL_ASSIGN_OR_RETURN(
+      std::unique_ptr<ExchangeOp> merge_exchange,
+      ExchangeOp::Create(IncrementalQueryPlan::kMergeExchangeId,
+                         std::move(merge_columns), plan.get()));
+  ZETASQL_ASSIGN_OR_RETURN(plan->merge_op_,
+                   delta_aggregate->CreateFinalAggregate(
+                       std::move(merge_exchange), merge_variables));
+  ZETASQL_RET_CHECK(plan->merge_op_ != nullptr);
+  plan->delta_op_ = std::move(fragments->shard_fragment);
+  query_arg->ReplaceNode(std::move(fragments->final_fragment));
+  plan->output_op_ = std::move(root);
+
+  const TupleSchema params_schema(params_variables);
+  for (RelationalOp* op :
+       {plan->delta_op_.get(), plan->merge_op_.get(), plan->output_op_.get()}) {
+    ZETASQL_RETURN_IF_ERROR(op->SetSchemasForEvaluation({&params_schema}));
+  }
+  return plan;
+}
+
+absl::Status Evaluator::ExecuteIncrementallyAfterPrepare(
+    ExpressionOptions options, const Table* appended_table,
+    IncrementalQueryState* state,
+    std::unique_ptr<EvaluatorTableIterator>* query_output_iterator) const {
+  absl::ReaderMutexLock l(&mutex_);
+  if (!has_prepare_succeeded()) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder()
+           << "Invalid prepared expression/query";
+  }
+  ZETASQL_RET_CHECK(compiled_relational_op_ != nullptr);
+  if (options.parameters.has_value()) {
+    ZETASQL_ASSIGN_OR_RETURN(options, OrderParametersLocked(std::move(options)));
+  }
+  ZETASQL_RETURN_IF_ERROR(ValidateColumns(options.ordered_columns.value()));
+  ZETASQL_RETURN_IF_ERROR(ValidateParameters(options.ordered_parameters.value()));
+  ZETASQL_RETURN_IF_ERROR(ValidateSystemVariables(options.system_variables));
+
+  if (state->plan_ == nullptr) {
+    ZETASQL_ASSIGN_OR_RETURN(state->plan_,
+                     CreateIncrementalPlanLocked(appended_table));
+  } else if (state->plan_->evaluator_ != this ||
+             state->plan_->table_ != appended_table) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder()
+           << "IncrementalQueryState was used with another query or table";
+  }
+  IncrementalQueryPlan& plan = *state->plan_;
+
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> table_iter,
+                   appended_table->CreateEvaluatorTableIterator({}));
+  const std::optional<int64_t> num_rows = table_iter->GetNumRowsForSplitting();
+  table_iter.reset();
+  if (!num_rows.has_value()) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder()
+           << "Table " << appended_table->Name()
+           << " does not support reading only its appended rows";
+  }
+  if (num_rows.value() < plan.num_rows_read_) {
+    return ::zetasql_base::FailedPreconditionErrorBuilder()
+           << "Table " << appended_table->Name() << " has " << num_rows.value()
+           << " rows, but a previous execution read " << plan.num_rows_read_
+           << "; rows must only be appended to it";
+  }
+
+  const internal::ElapsedTimer timer = internal::MakeTimerStarted();
+  std::unique_ptr<EvaluationContext> context = CreateEvaluationContext();
+  context->SetStatementEvaluationDeadline(options.deadline);
+  if (options.session_user.has_value()) {
+    context->SetSessionUser(options.session_user.value());
+  }
+  context->SetTableRowRange(appended_table, plan.num_rows_read_,
+                            num_rows.value());
+  const TupleData params_data = CreateParamsDataLocked(options);
+
+  ZETASQL_ASSIGN_OR_RETURN(std::shared_ptr<const RowsIterator::Rows> new_groups,
+                   ReadRows(*plan.delta_op_, params_data, context.get()));
+  plan.merge_input_ = {plan.groups_, std::move(new_groups)};
+  absl::StatusOr<std::shared_ptr<const RowsIterator::Rows>> groups =
+      ReadRows(*plan.merge_op_, params_data, context.get());
+  plan.merge_input_.clear();
+  ZETASQL_RETURN_IF_ERROR(groups.status());
+  // The state is that of all the rows read so far, even if the rest of the
+  // query fails.
+  plan.groups_ = *std::move(groups);
+  plan.num_rows_read_ = num_rows.value();
+
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<TupleIterator> tuple_iter,
+                   plan.output_op_->Eval({&params_data},
+                                         /*num_extra_slots=*/0, context.get()));
+  std::vector<int> tuple_indexes;
+  tuple_indexes.reserve(plan.output_column_variables_.size());
+  for (const VariableId& var : plan.output_column_variables_) {
+    std::optional<int> i = tuple_iter->Schema().FindIndexForVariable(var);
+    ZETASQL_RET_CHECK(i.has_value()) << var;
+    tuple_indexes.push_back(i.value());
+  }
+
+  IncrementNumLiveIterators();
+  std::function<void()> deletion_cb = [this]() {
+    DecrementNumLiveIterators();
+  };
+  *query_output_iterator = std::make_unique<TupleIteratorAdaptor>(
+      output_columns_, tuple_indexes, deletion_cb, std::move(context),
+      std::move(tuple_iter), options.stats,
+      internal::TimedValue(timer.GetStart(),
+                           internal::ResourceMeasurement::CreateEnd()));
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::unique_ptr<BoundExpression>> Evaluator::Bind(
+    const SystemVariableValuesMap& system_variables) const {
+  absl::ReaderMutexLock l(&mutex_);
+  if (!has_prepare_succeeded()) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder()
+           << "Invalid prepared expression";
+  }
+  ZETASQL_RET_CHECK(is_expr_);
+  ZETASQL_RET_CHECK(compiled_value_expr_ != nullptr);
+  ZETASQL_RETURN_IF_ERROR(ValidateSystemVariables(system_variables));
+
+  auto bound = absl::WrapUnique(new BoundExpression(this));
+  bound->num_columns_ = static_cast<int>(algebrizer_column_map_.size());
+  bound->named_parameters_ = algebrizer_parameters_.is_named();
+  bound->num_parameters_ = static_cast<int>(
+      algebrizer_parameters_.is_named()
+          ? algebrizer_parameters_.named_parameters().size()
+          : algebrizer_parameters_.positional_parameters().size());
+  bound->context_ = CreateEvaluationContext();
+  bound->params_data_ = std::make_unique<TupleData>(
+      bound->num_columns_ + bound->num_parameters_ +
+      static_cast<int>(algebrizer_system_variables_.size()));
+  int slot_idx = bound->num_columns_ + bound->num_parameters_;
+  for (const auto& algebrizer_sysvar : algebrizer_system_variables_) {
+    bound->params_data_->mutable_slot(slot_idx++)->SetValue(
+        system_variables.at(algebrizer_sysvar.first));
+  }
+  return bound;
+}
+
+absl::StatusOr<Value> Evaluator::ExecuteBound(
+    absl::Span<const Value> columns, absl::Span<const Value> parameters,
+    BoundExpression* bound) const {
+  absl::ReaderMutexLock l(&mutex_);
+  // Like a new EvaluationContext, re-read the clock for each evaluation.
+  bound->context_->SetClockAndClearCurrentTimestamp(evaluator_options_.clock);
+  Value result;
+  ZETASQL_RETURN_IF_ERROR(ExecuteBoundLocked(columns, parameters, bound, &result));
+  return result;
+}
+
+absl::StatusOr<std::vector<Value>> Evaluator::ExecuteBoundBatch(
+    int64_t num_rows, absl::Span<const ParameterValueList> columns,
+    absl::Span<const Value> parameters, BoundExpression* bound) const {
+  absl::ReaderMutexLock l(&mutex_);
+  for (int i = 0; i < columns.size(); ++i) {
+    if (columns[i].size() != num_rows) {
+      return zetasql_base::InvalidArgumentErrorBuilder()
+             << "Expected " << num_rows << " values for column parameter " << i
+             << " but found " << columns[i].size();
+    }
+  }
+  // The whole batch is one evaluation, so it sees a single current time.
+  bound->context_->SetClockAndClearCurrentTimestamp(evaluator_options_.clock);
+
+  std::vector<Value> results(num_rows);
+  std::vector<Value>& row = bound->row_;
+  row.resize(columns.size());
+  for (int64_t r = 0; r < num_rows; ++r) {
+    for (int i = 0; i < columns.size(); ++i) {
+      row[i] = columns[i][r];
+    }
+    ZETASQL_RETURN_IF_ERROR(ExecuteBoundLocked(row, parameters, bound, &results[r]));
+  }
+  return results;
+}
+
+absl::Status Evaluator::ExecuteBoundLocked(absl::Span<const Value> columns,
+                                           absl::Span<const Value> parameters,
+                                           BoundExpression* bound,
+                                           Value* result) const {
+  const int num_columns = bound->num_columns_;
+  const int num_parameters = bound->num_parameters_;
+
+  // Fast path: the argument types are the same Type objects as in the
+  // previous call, which validated them.
+  const std::vector<const Type*>& validated_types = bound->validated_types_;
+  bool validated = columns.size() == num_columns &&
+                   (bound->named_parameters_
+                        ? parameters.size() == num_parameters
+                        : parameters.size() >= num_parameters) &&
+                   validated_types.size() == num_columns + num_parameters;
+  for (int i = 0; validated && i < num_columns; ++i) {
+    validated = columns[i].type() == validated_types[i];
+  }
+  for (int i = 0; validated && i < num_parameters; ++i) {
+    validated = parameters[i].type() == validated_types[num_columns + i];
+  }
+  if (!validated) {
+    ZETASQL_RETURN_IF_ERROR(
+        ValidateColumns(ParameterValueList(columns.begin(), columns.end())));
+    ZETASQL_RETURN_IF_ERROR(ValidateParameters(
+        ParameterValueList(parameters.begin(), parameters.end())));
+    bound->validated_types_.clear();
+    for (int i = 0; i < num_columns; ++i) {
+      bound->validated_types_.push_back(columns[i].type());
+    }
+    for (int i = 0; i < num_parameters; ++i) {
+      bound->validated_types_.push_back(parameters[i].type());
+    }
+  }
+
+  TupleData* params_data = bound->params_data_.get();
+  for (int i = 0; i < num_columns; ++i) {
+    params_data->mutable_slot(i)->SetValue(columns[i]);
+  }
+  for (int i = 0; i < num_parameters; ++i) {
+    params_data->mutable_slot(num_columns + i)->SetValue(parameters[i]);
+  }
+
+  TupleSlot slot;
+  absl::Status status;
+  if (!compiled_value_expr_->EvalSimple({params_data}, bound->context_.get(),
+                                        &slot, &status)) {
+    return status;
+  }
+  *result = slot.value();
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::string> Evaluator::ExplainAfterPrepare(
+    const OperatorProfile* profile) const {
   absl::ReaderMutexLock l(&mutex_);
   ZETASQL_RET_CHECK(is_prepared()) << "Prepare must be called first";
   if (compiled_relational_op_ != nullptr) {
+    if (profile != nullptr) {
+      return profile->DebugString(compiled_relational_op_.get());
+    }
     return compiled_relational_op_->DebugString();
   } else {
     ZETASQL_RET_CHECK(compiled_value_expr_ != nullptr);
@@ -1286,6 +1842,7 @@ ExpressionOptions QueryOptionsToExpressionOptions(QueryOptions query_options) {
         std::move(query_options.ordered_parameters);
   }
   expr_options.system_variables = std::move(query_options.system_variables);
+  expr_options.stats = query_options.stats;
   return expr_options;
 }
 
@@ -1386,6 +1943,38 @@ PreparedExpressionBase::ExecuteAfterPrepareWithOrderedParams(
   return ExecuteAfterPrepare(std::move(options));
 }
 
+absl::StatusOr<std::unique_ptr<BoundExpression>>
+PreparedExpressionBase::BindAfterPrepare(
+    const SystemVariableValuesMap& system_variables) const {
+  return evaluator_->Bind(system_variables);
+}
+
+BoundExpression::BoundExpression(const internal::Evaluator* evaluator)
+    : evaluator_(evaluator) {}
+
+BoundExpression::~BoundExpression() {}
+
+absl::StatusOr<Value> BoundExpression::Execute(
+    absl::Span<const Value> columns, absl::Span<const Value> parameters) {
+  return evaluator_->ExecuteBound(columns, parameters, this);
+}
+
+absl::StatusOr<std::vector<Value>> BoundExpression::ExecuteBatch(
+    int64_t num_rows, absl::Span<const ParameterValueList> columns,
+    absl::Span<const Value> parameters) {
+  return evaluator_->ExecuteBoundBatch(num_rows, columns, parameters, this);
+}
+
+absl::StatusOr<std::vector<Value>>
+PreparedExpressionBase::ExecuteBatchAfterPrepare(
+    int64_t num_rows, absl::Span<const ParameterValueList> columns,
+    absl::Span<const Value> parameters,
+    const SystemVariableValuesMap& system_variables) const {
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<BoundExpression> bound,
+                   BindAfterPrepare(system_variables));
+  return bound->ExecuteBatch(num_rows, columns, parameters);
+}
+
 absl::StatusOr<std::string> PreparedExpressionBase::ExplainAfterPrepare()
     const {
   return evaluator_->ExplainAfterPrepare();
@@ -1395,6 +1984,18 @@ const Type* PreparedExpressionBase::output_type() const {
   return evaluator_->expression_output_type();
 }
 
+IncrementalQueryState::IncrementalQueryState() = default;
+
+IncrementalQueryState::~IncrementalQueryState() = default;
+
+int64_t IncrementalQueryState::num_rows_read() const {
+  return plan_ == nullptr ? 0 : plan_->num_rows_read_;
+}
+
+int64_t IncrementalQueryState::num_groups() const {
+  return plan_ == nullptr ? 0 : static_cast<int64_t>(plan_->groups_->size());
+}
+
 PreparedQueryBase::PreparedQueryBase(const std::string& sql,
                                      const EvaluatorOptions& options)
     : evaluator_(new internal::Evaluator(sql, /*is_expr=*/false, options)) {}
@@ -1459,28 +2060,57 @@ PreparedQueryBase::ExecuteWithPositionalParams(
   return Execute(std::move(options));
 }
 
+absl::StatusOr<std::unique_ptr<ColumnarResultReader>>
+PreparedQueryBase::ExecuteAsColumnarBatches(int64_t max_rows_per_batch,
+                                            QueryOptions options) {
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> iter,
+                   Execute(std::move(options)));
+  return ColumnarResultReader::Create(std::move(iter), max_rows_per_batch);
+}
+
+namespace {
+
+// Implements PreparedQueryBase::ExecuteAfterPrepare(), recording the
+// statistics of the operators into 'profile' if it is non-NULL.
 absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>>
-PreparedQueryBase::ExecuteAfterPrepare(QueryOptions options) const {
+ExecuteQueryAfterPrepare(const internal::Evaluator& evaluator,
+                         PreparedQueryBase::QueryOptions options,
+                         OperatorProfile* profile) {
   std::unique_ptr<EvaluatorTableIterator> output;
   ExpressionOptions expr_options =
       QueryOptionsToExpressionOptions(std::move(options));
   GiveDefaultParameters(&expr_options);
   if (expr_options.parameters.has_value()) {
     ZETASQL_RETURN_IF_ERROR(ValidateExpressionOptions(expr_options));
-    ZETASQL_RETURN_IF_ERROR(evaluator_->ExecuteAfterPrepare(
+    ZETASQL_RETURN_IF_ERROR(evaluator.ExecuteAfterPrepare(
         std::move(expr_options),
-        /*expression_output_value=*/nullptr, &output));
+        /*expression_output_value=*/nullptr, &output, profile));
   } else {
     expr_options.columns.reset();
     expr_options.ordered_columns = ParameterValueList();
     ZETASQL_RETURN_IF_ERROR(ValidateExpressionOptions(expr_options));
-    ZETASQL_RETURN_IF_ERROR(evaluator_->ExecuteAfterPrepareWithOrderedParams(
+    ZETASQL_RETURN_IF_ERROR(evaluator.ExecuteAfterPrepareWithOrderedParams(
         expr_options,
-        /*expression_output_value=*/nullptr, &output));
+        /*expression_output_value=*/nullptr, &output, profile));
   }
   return output;
 }
 
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>>
+PreparedQueryBase::ExecuteAfterPrepare(QueryOptions options) const {
+  return ExecuteQueryAfterPrepare(*evaluator_, std::move(options),
+                                  /*profile=*/nullptr);
+}
+
+absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>>
+PreparedQueryBase::ExecuteAfterPrepareWithProfile(
+    QueryOptions options, OperatorProfile* profile) const {
+  ZETASQL_RET_CHECK(profile != nullptr);
+  return ExecuteQueryAfterPrepare(*evaluator_, std::move(options), profile);
+}
+
 absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>>
 PreparedQueryBase::ExecuteAfterPrepare(
     ParameterValueList parameters,
@@ -1491,10 +2121,45 @@ PreparedQueryBase::ExecuteAfterPrepare(
   return ExecuteAfterPrepare(std::move(options));
 }
 
+absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>>
+PreparedQueryBase::ExecuteIncrementallyAfterPrepare(
+    const Table* appended_table, IncrementalQueryState* state,
+    QueryOptions options) const {
+  ZETASQL_RET_CHECK(appended_table != nullptr);
+  ZETASQL_RET_CHECK(state != nullptr);
+  std::unique_ptr<EvaluatorTableIterator> output;
+  ExpressionOptions expr_options =
+      QueryOptionsToExpressionOptions(std::move(options));
+  GiveDefaultParameters(&expr_options);
+  if (!expr_options.parameters.has_value()) {
+    expr_options.columns.reset();
+    expr_options.ordered_columns = ParameterValueList();
+  }
+  ZETASQL_RETURN_IF_ERROR(ValidateExpressionOptions(expr_options));
+  ZETASQL_RETURN_IF_ERROR(evaluator_->ExecuteIncrementallyAfterPrepare(
+      std::move(expr_options), appended_table, state, &output));
+  return output;
+}
+
 absl::StatusOr<std::string> PreparedQueryBase::ExplainAfterPrepare() const {
   return evaluator_->ExplainAfterPrepare();
 }
 
+absl::StatusOr<std::string> PreparedQueryBase::ExplainAnalyzeAfterPrepare(
+    QueryOptions options) const {
+  OperatorProfile profile;
+  {
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> iter,
+                     ExecuteAfterPrepareWithProfile(std::move(options),
+                                                    &profile));
+    while (iter->NextRow()) {
+    }
+    ZETASQL_RETURN_IF_ERROR(iter->Status());
+  }
+  // The iterators record their statistics when they are destroyed above.
+  return evaluator_->ExplainAfterPrepare(&profile);
+}
+
 int PreparedQueryBase::num_columns() const {
   return evaluator_->query_output_columns().size();
 }
@@ -174,9 +174,14 @@
 #include <utility>
 #include <vector>
 
+#include "zetasql/common/columnar_result_reader.h"
 #include "zetasql/public/analyzer.h"
 #include "zetasql/public/catalog.h"
+#include "zetasql/public/evaluator_executor.h"
 #include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/evaluator_tracer.h"
+#include "zetasql/public/memory_pool.h"
+#include "zetasql/public/proto/logging.pb.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/value.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
@@ -185,20 +190,25 @@
 #include "absl/memory/memory.h"
 #include "absl/status/statusor.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "zetasql/base/status.h"
 #include "zetasql/base/clock.h"
 
 namespace zetasql {
 
+class BoundExpression;
 class EvaluationContext;
+class OperatorProfile;
 class ResolvedExpr;
 class ResolvedQueryStmt;
+class TupleData;
 
 using ParameterValueMap = std::map<std::string, Value>;
 using ParameterValueList = std::vector<Value>;
 
 namespace internal {
 class Evaluator;
+class IncrementalQueryPlan;
 }  // namespace internal
 
 struct EvaluatorOptions {
@@ -249,6 +259,81 @@ struct EvaluatorOptions {
   // accounting charges each of them individually. In some cases, it is
   // necessary to set this option to a very large value.
   int64_t max_intermediate_byte_size = 128 * 1024 * 1024;
+
+  // The maximum number of threads that evaluation may use for operators that
+  // support parallel execution: building hash join tables, and scanning
+  // tables whose EvaluatorTableIterators support SetRowRange(). 1 (the
+  // default) evaluates everything on the calling thread. Results are the same
+  // for any value.
+  int num_threads = 1;
+
+  // If non-null, the operators that use more than one thread (see
+  // 'num_threads' and 'scan_prefetch_rows') run their helper tasks on this
+  // executor instead of creating threads, e.g., so that all the queries of a
+  // service share one thread pool. Does not take ownership; must outlive the
+  // evaluations. Results are the same with and without an executor.
+  EvaluatorExecutor* executor = nullptr;
+
+  // If non-null, receives tracing events of each evaluation: the iterator
+  // creations and row counts of its operators, and the number of calls and
+  // time of each scalar function (see EvaluatorTracer). Disabled by default,
+  // which costs a pointer check per operator iterator and function call. Does
+  // not take ownership; must outlive the evaluations.
+  EvaluatorTracer* tracer = nullptr;
+
+  // If non-null, the memory that each evaluation uses for intermediate Tuples
+  // (see 'max_intermediate_byte_size') is also reserved from this pool, which
+  // may be shared with other evaluations, e.g., to bound the memory of all the
+  // queries of a tenant. Running out of the pool is handled like exceeding
+  // 'max_intermediate_byte_size'. Does not take ownership; must outlive the
+  // evaluations.
+  MemoryPool* memory_pool = nullptr;
+
+  // If positive, table scans read their EvaluatorTableIterator on a background
+  // thread, up to this many rows ahead of the rest of the query. This overlaps
+  // waits in EvaluatorTableIterator::NextRow() (e.g., for I/O) with
+  // evaluation. Does not affect scans that use multiple threads because of
+  // 'num_threads'. Results are the same for any value.
+  int scan_prefetch_rows = 0;
+
+  // If non-empty, a directory for temporary files. Operators that support it
+  // (currently ORDER BY without LIMIT) spill intermediate rows there rather
+  // than fail when they would exceed 'max_intermediate_byte_size' or run out
+  // of 'memory_pool'. The files
+  // are removed automatically.
+  std::string spill_directory;
+
+  // If positive, operators that consume their entire input (currently ORDER
+  // BY) read it in batches of this many rows instead of one row at a time.
+  // Within a batch, simple scalar expressions (e.g., INT64 and DOUBLE
+  // arithmetic, comparisons and AND/OR/NOT) of projections and filters are
+  // evaluated column-wise. Results are the same for any value.
+  int tuple_batch_size = 0;
+
+  // If true, when the evaluator analyzes the SQL itself, it disables the
+  // rewrites of AnalyzerOptions::enabled_rewrites() for constructs that it
+  // evaluates natively, e.g., REWRITE_BUILTIN_FUNCTION_INLINER and
+  // REWRITE_WITH_EXPR. The original function calls and WITH expressions are
+  // then evaluated directly instead of as the more general expressions and
+  // subqueries of the rewrites. All other enabled rewrites, like
+  // REWRITE_ANONYMIZATION, stay enabled. Has no effect when a resolved AST is
+  // passed in. Results are the same either way.
+  bool skip_rewrites_with_native_support = false;
+};
+
+// Resource usage of one execution of a PreparedExpression or PreparedQuery,
+// which services can use for per-query accounting (see
+// ExpressionOptions::stats and QueryOptions::stats).
+struct EvaluationStats {
+  // The wall and CPU time spent evaluating on the calling threads, i.e., in
+  // Execute() and, for queries, in EvaluatorTableIterator::NextRow(). Does
+  // not include the helper tasks of operators that use more than one thread
+  // (see EvaluatorOptions::num_threads).
+  ExecutionStats execution_stats;
+
+  // The largest number of bytes that the execution used at once for
+  // intermediate Tuples (see EvaluatorOptions::max_intermediate_byte_size).
+  int64_t peak_memory_bytes = 0;
 };
 
 class PreparedExpressionBase {
@@ -392,6 +477,11 @@ class PreparedExpressionBase {
     // Optional session user for the expression evaluation. Session user is used
     // to evaluate the current user (e.g. in the SESSION_USER function).
     std::optional<std::string> session_user;
+
+    // If non-null, set to the resource usage of the execution when it
+    // finishes: when Execute() returns for expressions, or when the returned
+    // iterator is destroyed for queries. Not owned.
+    EvaluationStats* stats = nullptr;
   };
 
   // Execute the expression.
@@ -442,6 +532,30 @@ class PreparedExpressionBase {
       ParameterValueList columns, ParameterValueList parameters,
       SystemVariableValuesMap system_variables = {}) const;
 
+  // Returns a BoundExpression for evaluating this expression many times with
+  // different column and parameter values, e.g., as a row-level predicate.
+  // The evaluation state is allocated once, so that BoundExpression::Execute()
+  // does not allocate for arguments and results of simple types.
+  // 'system_variables' are fixed for all the executions. This object must
+  // outlive the return value.
+  //
+  // REQUIRES: Prepare() has been called successfully.
+  absl::StatusOr<std::unique_ptr<BoundExpression>> BindAfterPrepare(
+      const SystemVariableValuesMap& system_variables = {}) const;
+
+  // Evaluates this expression for 'num_rows' rows, paying the per-call setup
+  // once for the whole batch. The input is columnar: 'columns[i][r]' is the
+  // value of column 'i' (in the order of GetReferencedColumns()) in row 'r'.
+  // 'parameters' are ordered as for ExecuteAfterPrepareWithOrderedParams()
+  // and are the same for every row. Returns one result per row, or the first
+  // error.
+  //
+  // REQUIRES: Prepare() has been called successfully.
+  absl::StatusOr<std::vector<Value>> ExecuteBatchAfterPrepare(
+      int64_t num_rows, absl::Span<const ParameterValueList> columns,
+      absl::Span<const Value> parameters = {},
+      const SystemVariableValuesMap& system_variables = {}) const;
+
   // Returns a human-readable representation of how this expression would
   // actually be executed. Do not try to interpret this string with code, as the
   // format can change at any time. Requires that Prepare has already been
@@ -455,6 +569,88 @@ class PreparedExpressionBase {
   std::unique_ptr<internal::Evaluator> evaluator_;
 };
 
+// Repeatedly evaluates a PreparedExpressionBase, reusing one EvaluationContext
+// and one set of parameter slots. Created by
+// PreparedExpressionBase::BindAfterPrepare().
+//
+// Example:
+//   PreparedExpression expr("a > 5 AND b = 'x'");
+//   ZETASQL_RETURN_IF_ERROR(expr.Prepare(analyzer_options));
+//   ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<BoundExpression> bound,
+//                    expr.BindAfterPrepare());
+//   Value columns[2];
+//   for (...) {
+//     columns[0] = ...;
+//     columns[1] = ...;
+//     ZETASQL_ASSIGN_OR_RETURN(Value result, bound->Execute(columns));
+//   }
+//
+// Not thread safe: use one BoundExpression per thread.
+class BoundExpression {
+ public:
+  BoundExpression(const BoundExpression&) = delete;
+  BoundExpression& operator=(const BoundExpression&) = delete;
+  ~BoundExpression();
+
+  // Evaluates the expression. 'columns' and 'parameters' are in the same
+  // order as for PreparedExpressionBase::ExecuteAfterPrepareWithOrderedParams()
+  // (see GetReferencedColumns() and GetReferencedParameters()). The types of
+  // the arguments are only fully validated when they differ from those of the
+  // previous call.
+  absl::StatusOr<Value> Execute(absl::Span<const Value> columns,
+                                absl::Span<const Value> parameters = {});
+
+  // Same as PreparedExpressionBase::ExecuteBatchAfterPrepare(), reusing this
+  // object's evaluation state. All the rows of a batch see the same current
+  // time.
+  absl::StatusOr<std::vector<Value>> ExecuteBatch(
+      int64_t num_rows, absl::Span<const ParameterValueList> columns,
+      absl::Span<const Value> parameters = {});
+
+ private:
+  friend class internal::Evaluator;
+
+  explicit BoundExpression(const internal::Evaluator* evaluator);
+
+  const internal::Evaluator* evaluator_;
+  int num_columns_ = 0;
+  int num_parameters_ = 0;
+  bool named_parameters_ = false;
+  std::unique_ptr<EvaluationContext> context_;
+  // Slots for the columns, the parameters and the system variables.
+  std::unique_ptr<TupleData> params_data_;
+  // The types of the columns and parameters of the last successful call, or
+  // empty before the first one.
+  std::vector<const Type*> validated_types_;
+  // Scratch space for one row of ExecuteBatch().
+  std::vector<Value> row_;
+};
+
+// What PreparedQueryBase::ExecuteIncrementallyAfterPrepare() keeps between
+// the executions of a query: its plan, the partial aggregates of the rows read
+// so far, and how many rows of the appended table were read. Not thread-safe.
+// Must outlive the iterators returned with it, and must not outlive the
+// PreparedQuery.
+class IncrementalQueryState {
+ public:
+  IncrementalQueryState();
+  IncrementalQueryState(const IncrementalQueryState&) = delete;
+  IncrementalQueryState& operator=(const IncrementalQueryState&) = delete;
+  ~IncrementalQueryState();
+
+  // Returns the number of rows of the appended table that were read so far.
+  int64_t num_rows_read() const;
+
+  // Returns the number of groups whose partial aggregates are kept.
+  int64_t num_groups() const;
+
+ private:
+  friend class internal::Evaluator;
+
+  // Created by the first execution.
+  std::unique_ptr<internal::IncrementalQueryPlan> plan_;
+};
+
 // See evaluator_base.h for the full interface and usage instructions.
 class PreparedQueryBase {
  public:
@@ -531,6 +727,10 @@ class PreparedQueryBase {
 
     // Optional system variables for all variants of Execute.
     SystemVariableValuesMap system_variables;
+
+    // If non-null, set to the resource usage of the execution when the
+    // returned iterator is destroyed. Not owned.
+    EvaluationStats* stats = nullptr;
   };
 
   // Execute the query. This object must outlive the return value.
@@ -572,12 +772,69 @@ class PreparedQueryBase {
       ParameterValueList parameters,
       SystemVariableValuesMap system_variables = {}) const;
 
+  // Same as ExecuteAfterPrepare(), but adds the runtime statistics of the
+  // operators of the query to 'profile' as their iterators are destroyed, as
+  // for ExplainAnalyzeAfterPrepare(). 'profile' must outlive the returned
+  // iterator.
+  //
+  // REQUIRES: Prepare() has been called successfully.
+  absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>>
+  ExecuteAfterPrepareWithProfile(QueryOptions options,
+                                 OperatorProfile* profile) const;
+
+  // Same as ExecuteAfterPrepare(), but for a query that is executed again
+  // each time rows are appended to 'appended_table', such as a dashboard that
+  // is refreshed. Each execution only reads the rows appended since the
+  // previous execution with 'state', and merges their partial aggregates into
+  // those that 'state' keeps, so its cost depends on the number of new rows
+  // and groups rather than on the size of 'appended_table'. The result is that
+  // of ExecuteAfterPrepare() over all the rows.
+  //
+  // The query must aggregate 'appended_table', optionally followed by
+  // projections, filters (e.g. HAVING), ORDER BY and LIMIT. The aggregate
+  // functions must be COUNT, COUNTIF, SUM, MIN, MAX, ANY_VALUE, LOGICAL_AND,
+  // LOGICAL_OR, BIT_AND, BIT_OR or BIT_XOR without modifiers, and there must
+  // be no grouping sets. Their input may project and filter 'appended_table'
+  // and join it with other tables, on a side of the join that keeps each row
+  // on its own (e.g. either side of an inner join, or the left side of a left
+  // outer join). 'appended_table' must be read only once. Other queries
+  // return an InvalidArgument error.
+  //
+  // Rows of 'appended_table' must never be changed or removed, and its
+  // EvaluatorTableIterators must support SetRowRange() (e.g. SimpleTable).
+  // The other tables are read in full on each execution and must not change,
+  // and every execution with 'state' must have the same parameters. Otherwise
+  // the results are undefined. 'state' must outlive the returned iterator.
+  //
+  // REQUIRES: Prepare() has been called successfully.
+  absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>>
+  ExecuteIncrementallyAfterPrepare(const Table* appended_table,
+                                   IncrementalQueryState* state,
+                                   QueryOptions options = QueryOptions()) const;
+
+  // Same as Execute(), but returns the result in batches of at most
+  // 'max_rows_per_batch' rows in the Arrow columnar memory layout, for
+  // consumers that would otherwise convert it from Values one cell at a time.
+  // Returns an error if an output column has a type other than INT64, DOUBLE,
+  // BOOL, STRING or BYTES. This object must outlive the return value.
+  absl::StatusOr<std::unique_ptr<ColumnarResultReader>>
+  ExecuteAsColumnarBatches(int64_t max_rows_per_batch,
+                           QueryOptions options = QueryOptions());
+
   // Returns a human-readable representation of how this query would actually
   // be executed. Do not try to interpret this string with code, as the
   // format can change at any time. Requires that Prepare has already been
   // called.
   absl::StatusOr<std::string> ExplainAfterPrepare() const;
 
+  // Executes the query, discards its rows, and returns the operators of
+  // ExplainAfterPrepare() annotated with runtime statistics, such as the number
+  // of rows each one produced and the time spent in it, in the manner of
+  // EXPLAIN ANALYZE. As for ExplainAfterPrepare(), the format can change at any
+  // time. Requires that Prepare has already been called.
+  absl::StatusOr<std::string> ExplainAnalyzeAfterPrepare(
+      QueryOptions options = QueryOptions()) const;
+
   // Get the schema of the output table of this query. Anonymous column names
   // are empty. (There may be more than one column with the same name.)
   //
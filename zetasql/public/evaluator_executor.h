@@ -0,0 +1,65 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// API for running the parallel work of the ZetaSQL Evaluator (see
+// evaluator.h) on a thread pool or scheduler of the caller.
+
+#ifndef ZETASQL_PUBLIC_EVALUATOR_EXECUTOR_H_
+#define ZETASQL_PUBLIC_EVALUATOR_EXECUTOR_H_
+
+#include <functional>
+
+namespace zetasql {
+
+// Runs the helper tasks of the operators of an evaluation that use more than
+// one thread (see EvaluatorOptions::executor), such as building hash join
+// tables, sorting, reading UNION ALL inputs and table morsels concurrently,
+// and prefetching table scans. Without an executor, those operators create
+// threads of their own.
+//
+// The executor decides where and when each task runs, so a service can keep
+// all evaluations on one shared pool under its own scheduling. To give
+// queries different priorities, pass each one an executor that schedules on
+// the shared pool with the priority of that query; EvaluatorOptions::
+// num_threads still limits the parallelism of each operator.
+//
+// Example:
+//   class PoolExecutor : public EvaluatorExecutor {
+//    public:
+//     PoolExecutor(ThreadPool* pool, int priority) : ... {}
+//     void Schedule(std::function<void()> task) override {
+//       pool_->Schedule(std::move(task), priority_);
+//     }
+//   };
+//
+// Implementations must be thread-safe.
+class EvaluatorExecutor {
+ public:
+  virtual ~EvaluatorExecutor() = default;
+
+  // Runs `task` once, on a thread other than the calling one. Operators that
+  // split their work into tasks also do the work on the calling thread, and
+  // do not wait for tasks that have not started when they are done, so those
+  // tasks need not run right away. A prefetching scan does wait for its task
+  // to produce rows, and its task blocks while the buffer of the scan is
+  // full, so every task must eventually run, and not on a thread that the
+  // same evaluation waits for.
+  virtual void Schedule(std::function<void()> task) = 0;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_EVALUATOR_EXECUTOR_H_
@@ -23,9 +23,11 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "zetasql/public/value.h"
+#include "absl/types/span.h"
 #include "zetasql/base/status.h"
 
 namespace zetasql {
@@ -94,6 +96,10 @@ class EvaluatorTableIterator {
   //
   //   - WHERE Column1 = 10 AND (Column2 BETWEEN 100 AND 200)
   //
+  //   - WHERE Column IS NULL
+  //
+  //   - WHERE Column LIKE 'abc%'
+  //
   // Note that the algebrizer is not able to express ORs or NOTs through this
   // API, so queries may have to be rewritten for performance reasons if that
   // proves to be important.
@@ -135,6 +141,19 @@ class EvaluatorTableIterator {
     return absl::OkStatus();
   }
 
+  // This method is called just before the first call to NextRow() to indicate
+  // that the query only reads the columns of the scan in 'column_idxs' (which
+  // are indexes of columns in the scan, not the Table, in increasing order).
+  // It is not called if the evaluator cannot tell which columns are read.
+  //
+  // An implementation that decodes rows from storage may skip decoding the
+  // other columns and return any Value of the right type (e.g., a NULL) for
+  // them from GetValue(). Unlike SetColumnFilterMap(), this is not a filter:
+  // the iterator must still return the same rows.
+  virtual absl::Status SetReferencedColumns(absl::Span<const int> column_idxs) {
+    return absl::OkStatus();
+  }
+
   // Indicates that the iterator should read from a snapshot of the table at the
   // given moment in time, rather than the current table content. This function
   // must be called prior to the first call to NextRow().
@@ -146,6 +165,29 @@ class EvaluatorTableIterator {
         "EvaluatorTableIterator::SetReadTime() not implemented");
   }
 
+  // Returns the number of rows that this iterator would return without any
+  // column filters if it supports SetRowRange(), or std::nullopt otherwise.
+  // Must be called before the first call to NextRow().
+  //
+  // The evaluator uses this to split a scan into ranges of rows ("morsels")
+  // that are read concurrently (see EvaluatorOptions::num_threads).
+  virtual std::optional<int64_t> GetNumRowsForSplitting() const {
+    return std::nullopt;
+  }
+
+  // Restricts the iterator to the rows in [begin, end), numbering rows from 0
+  // as in GetNumRowsForSplitting(). Column filters still apply. This function
+  // must be called prior to the first call to NextRow().
+  //
+  // Implementations must allow iterators over disjoint ranges of the same
+  // table to be used concurrently from different threads (each iterator by
+  // one thread), and reading consecutive ranges one after the other must
+  // return the same rows in the same order as an unrestricted iterator.
+  virtual absl::Status SetRowRange(int64_t begin, int64_t end) {
+    return absl::UnimplementedError(
+        "EvaluatorTableIterator::SetRowRange() not implemented");
+  }
+
   // Returns false if there is no next row. The caller must then check
   // 'Status()'. If NextRow() returns false, the only allowed operations on this
   // iterator are NumColumns(), GetColumnName(), GetColumnType(), and Status().
@@ -197,9 +239,9 @@ class EvaluatorTableIterator {
 //
 // For all filters expressed with this class:
 // - Comparisons are done with SQL semantics. (Comparisons with NULLs or NaNs
-//   cannot return true.) However, any filter expressed with this class can
-//   never match a NULL or NaN value, so the implementer can skip all such
-//   values.
+//   cannot return true.) However, any filter expressed with this class other
+//   than kIsNull can never match a NULL or NaN value, so the implementer can
+//   skip all such values.
 // - Comparisons are allowed between types that are directly comparable with =
 //   or < operators without even implicit casts. For example, comparison between
 //   int64_t and uint64_t is allowed.
@@ -212,6 +254,11 @@ class ColumnFilter {
     kRange,
     // Represents a list of non-NULL/non-NaN values.
     kInList,
+    // Represents the NULL value only.
+    kIsNull,
+    // Represents the non-NULL STRING or BYTES values that start with a given
+    // non-NULL prefix of the same type.
+    kPrefix,
     // Switches must have a default case to allow us to add more kinds of
     // ValueFilters to the API.
     __Kind__switches_must_have_a_default
@@ -230,6 +277,15 @@ class ColumnFilter {
   explicit ColumnFilter(absl::Span<const Value> in_list)
       : kind_(kInList), values_(in_list.begin(), in_list.end()) {}
 
+  // Returns a kIsNull ColumnFilter.
+  static ColumnFilter IsNull() { return ColumnFilter(kIsNull, {}); }
+
+  // Returns a kPrefix ColumnFilter. 'prefix' must be a non-NULL STRING or
+  // BYTES value.
+  static ColumnFilter Prefix(const Value& prefix) {
+    return ColumnFilter(kPrefix, {prefix});
+  }
+
   const Kind kind() const { return kind_; }
 
   // Returns the range boundaries of this filter. 'kind()' must be kRange. The
@@ -242,10 +298,18 @@ class ColumnFilter {
   // elements of this list are NULL or NaN.
   const std::vector<Value>& in_list() const { return values_; }
 
+  // Returns the prefix for this filter, which must have 'kind()' kPrefix. The
+  // prefix is a non-NULL STRING or BYTES value.
+  const Value& prefix() const { return values_[0]; }
+
  private:
+  ColumnFilter(Kind kind, std::vector<Value> values)
+      : kind_(kind), values_(std::move(values)) {}
+
   Kind kind_;
   // If 'kind_ == kRange', this has two elements, the lower bound and the upper
-  // bound.
+  // bound. If 'kind_ == kPrefix', this has one element, the prefix. If
+  // 'kind_ == kIsNull', this is empty.
   std::vector<Value> values_;
 };
 
@@ -19,6 +19,7 @@
 #include <cstdint>
 #include <limits>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -34,19 +35,23 @@
 #include "zetasql/public/civil_time.h"
 #include "zetasql/public/evaluator_base.h"
 #include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/evaluator_tracer.h"
 #include "zetasql/public/function.h"
 #include "zetasql/public/function.pb.h"
 #include "zetasql/public/function_signature.h"
 #include "zetasql/public/functions/date_time_util.h"
 #include "zetasql/public/id_string.h"
 #include "zetasql/public/language_options.h"
+#include "zetasql/public/memory_pool.h"
 #include "zetasql/public/options.pb.h"
 #include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/table_valued_function.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/type.pb.h"
 #include "zetasql/public/types/type_factory.h"
 #include "zetasql/public/value.h"
 #include "zetasql/reference_impl/evaluation.h"
+#include "zetasql/reference_impl/operator_profile.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
 #include "zetasql/resolved_ast/resolved_column.h"
 #include "zetasql/resolved_ast/resolved_node_kind.pb.h"
@@ -57,6 +62,8 @@
 #include "zetasql/testing/using_test_value.cc"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/flags/flag.h"
 #include "zetasql/base/check.h"
 #include "absl/memory/memory.h"
@@ -66,6 +73,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/civil_time.h"
 #include "absl/time/time.h"
 #include "absl/types/span.h"
@@ -87,6 +95,9 @@ using ::testing::ElementsAre;
 using ::testing::Eq;
 using ::testing::HasSubstr;
 using ::testing::IsEmpty;
+using ::testing::Not;
+using ::testing::Optional;
+using ::testing::Pair;
 using ::testing::UnorderedElementsAre;
 using ::zetasql_base::testing::IsOkAndHolds;
 using ::zetasql_base::testing::StatusIs;
@@ -427,6 +438,35 @@ TEST(EvaluatorTest, WithRecursiveMemoryExhaustedByHashSet) {
                    "MemoryAccountant(max_intermediate_byte_size): requested")));
 }
 
+TEST(EvaluatorTest, JsonMutationOutOfMemory) {
+  EvaluatorOptions options;
+  options.max_intermediate_byte_size = 1000;
+  PreparedExpression expr("JSON_REMOVE(PARSE_JSON(col), '$.a')", options);
+  LanguageOptions language_options;
+  language_options.EnableLanguageFeature(FEATURE_JSON_TYPE);
+  language_options.EnableLanguageFeature(FEATURE_JSON_MUTATOR_FUNCTIONS);
+  AnalyzerOptions analyzer_options(language_options);
+  ZETASQL_ASSERT_OK(analyzer_options.AddExpressionColumn("col", types::StringType()));
+  ZETASQL_ASSERT_OK(expr.Prepare(analyzer_options));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      Value result, expr.Execute({{"col", String(R"({"a": 1, "b": 2})")}}));
+  EXPECT_EQ(result.json_string(), R"({"b":2})");
+
+  // The copy that JSON_REMOVE modifies is charged to the memory limit.
+  std::string large_document = R"({"a": 1, "b": [0)";
+  for (int i = 0; i < 1000; ++i) {
+    absl::StrAppend(&large_document, ", ", i);
+  }
+  absl::StrAppend(&large_document, "]}");
+  EXPECT_THAT(
+      expr.Execute({{"col", String(large_document)}}),
+      StatusIs(_,
+               HasSubstr(
+                   "Out of memory for "
+                   "MemoryAccountant(max_intermediate_byte_size): requested")));
+}
+
 TEST(EvaluatorTest, WithClauseSubquery_b119901615) {
   PreparedExpression expr(
       "(WITH a AS (SELECT true as b, 15 as c) SELECT IF(b, c, -1) FROM a)");
@@ -1161,6 +1201,190 @@ TEST(EvaluatorTest,
               IsOkAndHolds(Value::Int64(15)));
 }
 
+TEST(EvaluatorTest, BoundExpression) {
+  PreparedExpression expr("a > @min AND b = 'x'");
+
+  AnalyzerOptions options;
+  ZETASQL_ASSERT_OK(options.AddQueryParameter("min", types::Int64Type()));
+  ZETASQL_ASSERT_OK(options.AddExpressionColumn("a", types::Int64Type()));
+  ZETASQL_ASSERT_OK(options.AddExpressionColumn("b", types::StringType()));
+  ZETASQL_ASSERT_OK(expr.Prepare(options));
+  EXPECT_THAT(expr.GetReferencedColumns(),
+              IsOkAndHolds(ElementsAre("a", "b")));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BoundExpression> bound,
+                       expr.BindAfterPrepare());
+  const Value min[] = {Value::Int64(5)};
+  Value columns[] = {Value::Int64(6), Value::String("x")};
+  EXPECT_THAT(bound->Execute(columns, min), IsOkAndHolds(Value::Bool(true)));
+  columns[0] = Value::Int64(4);
+  EXPECT_THAT(bound->Execute(columns, min), IsOkAndHolds(Value::Bool(false)));
+  columns[0] = Value::NullInt64();
+  EXPECT_THAT(bound->Execute(columns, min), IsOkAndHolds(Value::NullBool()));
+  columns[1] = Value::String("y");
+  EXPECT_THAT(bound->Execute(columns, min), IsOkAndHolds(Value::Bool(false)));
+
+  // Arguments are still validated.
+  columns[0] = Value::Double(6);
+  EXPECT_THAT(bound->Execute(columns, min),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Expected column parameter 'a' to be of type "
+                                 "INT64 but found DOUBLE")));
+  EXPECT_THAT(bound->Execute(absl::MakeConstSpan(columns, 1), min),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Incorrect number of column parameters")));
+  EXPECT_THAT(bound->Execute(columns, {}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(EvaluatorTest, BoundExpressionWithSystemVariables) {
+  PreparedExpression expr("@@sysvar + col");
+  AnalyzerOptions options;
+  ZETASQL_ASSERT_OK(options.AddSystemVariable({"sysvar"}, types::Int64Type()));
+  ZETASQL_ASSERT_OK(options.AddExpressionColumn("col", types::Int64Type()));
+  ZETASQL_ASSERT_OK(expr.Prepare(options));
+
+  EXPECT_THAT(expr.BindAfterPrepare(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("No value provided for system variable")));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<BoundExpression> bound,
+      expr.BindAfterPrepare({{{"sysvar"}, Value::Int64(10)}}));
+  EXPECT_THAT(bound->Execute({Value::Int64(1)}),
+              IsOkAndHolds(Value::Int64(11)));
+  EXPECT_THAT(bound->Execute({Value::Int64(2)}),
+              IsOkAndHolds(Value::Int64(12)));
+}
+
+TEST(EvaluatorTest, ExecuteBatchAfterPrepare) {
+  PreparedExpression expr("IF(a > @min, b, NULL)");
+
+  AnalyzerOptions options;
+  ZETASQL_ASSERT_OK(options.AddQueryParameter("min", types::Int64Type()));
+  ZETASQL_ASSERT_OK(options.AddExpressionColumn("a", types::Int64Type()));
+  ZETASQL_ASSERT_OK(options.AddExpressionColumn("b", types::StringType()));
+  ZETASQL_ASSERT_OK(expr.Prepare(options));
+
+  const std::vector<ParameterValueList> columns = {
+      {Value::Int64(1), Value::Int64(7), Value::NullInt64()},
+      {Value::String("x"), Value::String("y"), Value::String("z")}};
+  EXPECT_THAT(expr.ExecuteBatchAfterPrepare(/*num_rows=*/3, columns,
+                                            {Value::Int64(5)}),
+              IsOkAndHolds(ElementsAre(Value::NullString(), Value::String("y"),
+                                       Value::NullString())));
+  EXPECT_THAT(expr.ExecuteBatchAfterPrepare(/*num_rows=*/0, {{}, {}},
+                                            {Value::Int64(5)}),
+              IsOkAndHolds(IsEmpty()));
+
+  EXPECT_THAT(expr.ExecuteBatchAfterPrepare(/*num_rows=*/2, columns,
+                                            {Value::Int64(5)}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Expected 2 values for column parameter 0 "
+                                 "but found 3")));
+  EXPECT_THAT(expr.ExecuteBatchAfterPrepare(
+                  /*num_rows=*/1, {{Value::Int64(1)}, {Value::Int64(2)}},
+                  {Value::Int64(5)}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Expected column parameter 'b'")));
+}
+
+TEST(EvaluatorTest, ExecuteBatchReturnsFirstError) {
+  PreparedExpression expr("10 / x");
+  AnalyzerOptions options;
+  ZETASQL_ASSERT_OK(options.AddExpressionColumn("x", types::DoubleType()));
+  ZETASQL_ASSERT_OK(expr.Prepare(options));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BoundExpression> bound,
+                       expr.BindAfterPrepare());
+
+  EXPECT_THAT(
+      bound->ExecuteBatch(/*num_rows=*/2,
+                          {{Value::Double(2), Value::Double(0)}}),
+      StatusIs(absl::StatusCode::kOutOfRange, HasSubstr("division by zero")));
+  // The same object can be used for more batches afterwards.
+  EXPECT_THAT(bound->ExecuteBatch(/*num_rows=*/2,
+                                  {{Value::Double(2), Value::Double(5)}}),
+              IsOkAndHolds(ElementsAre(Value::Double(5), Value::Double(2))));
+}
+
+TEST(EvaluatorTest, ArrayFunctionsOnPackedArrays) {
+  LanguageOptions language_options;
+  language_options.EnableLanguageFeature(
+      FEATURE_V_1_4_ARRAY_AGGREGATION_FUNCTIONS);
+  language_options.EnableLanguageFeature(FEATURE_V_1_4_ARRAY_FIND_FUNCTIONS);
+  AnalyzerOptions options(language_options);
+  ZETASQL_ASSERT_OK(options.AddQueryParameter("ints", types::Int64ArrayType()));
+  ZETASQL_ASSERT_OK(
+      options.AddQueryParameter("doubles", types::DoubleArrayType()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      Value ints,
+      Value::MakePackedArray(types::Int64ArrayType(),
+                             std::vector<int64_t>{3, 0, -1, 7},
+                             {false, true, false, false}));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      Value doubles,
+      Value::MakePackedArray(types::DoubleArrayType(),
+                             std::vector<double>{0.5, 2, -1}));
+  const ParameterValueMap parameters = {{"ints", ints}, {"doubles", doubles}};
+
+  const std::vector<std::pair<std::string, Value>> cases = {
+      {"ARRAY_SUM(@ints)", Int64(9)},
+      {"ARRAY_AVG(@ints)", Double(3)},
+      {"ARRAY_MIN(@ints)", Int64(-1)},
+      {"ARRAY_MAX(@ints)", Int64(7)},
+      {"ARRAY_INCLUDES(@ints, 7)", Bool(true)},
+      {"ARRAY_INCLUDES(@ints, 0)", Bool(false)},
+      {"ARRAY_SUM(@doubles)", Double(1.5)},
+      {"ARRAY_AVG(@doubles)", Double(0.5)},
+      {"ARRAY_MIN(@doubles)", Double(-1)},
+      {"ARRAY_MAX(@doubles)", Double(2)},
+      {"ARRAY_INCLUDES(@doubles, 2.0)", Bool(true)},
+      {"ARRAY_LENGTH(@ints)", Int64(4)},
+      {"@ints[OFFSET(3)]", Int64(7)},
+  };
+  for (const auto& [sql, expected] : cases) {
+    PreparedExpression expr(sql);
+    ZETASQL_ASSERT_OK(expr.Prepare(options)) << sql;
+    EXPECT_THAT(expr.Execute({}, parameters), IsOkAndHolds(expected)) << sql;
+  }
+}
+
+TEST(EvaluatorTest, GenerateArrayProducesPackedArrays) {
+  LanguageOptions language_options;
+  language_options.EnableLanguageFeature(
+      FEATURE_V_1_4_ARRAY_AGGREGATION_FUNCTIONS);
+  AnalyzerOptions options(language_options);
+
+  PreparedExpression ints("GENERATE_ARRAY(1, 7, 3)");
+  ZETASQL_ASSERT_OK(ints.Prepare(options));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(Value result, ints.Execute());
+  EXPECT_TRUE(result.has_packed_elements());
+  EXPECT_THAT(result.packed_int64_elements(), ElementsAre(1, 4, 7));
+  EXPECT_EQ(result, values::Int64Array({1, 4, 7}));
+
+  PreparedExpression doubles("GENERATE_ARRAY(0.5, 1.5, 0.5)");
+  ZETASQL_ASSERT_OK(doubles.Prepare(options));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(result, doubles.Execute());
+  EXPECT_TRUE(result.has_packed_elements());
+  EXPECT_EQ(result, values::DoubleArray({0.5, 1, 1.5}));
+
+  // Other element types are not packed.
+  PreparedExpression uints(
+      "GENERATE_ARRAY(CAST(1 AS UINT64), CAST(3 AS UINT64))");
+  ZETASQL_ASSERT_OK(uints.Prepare(options));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(result, uints.Execute());
+  EXPECT_FALSE(result.has_packed_elements());
+
+  PreparedExpression sum("ARRAY_SUM(GENERATE_ARRAY(1, 100))");
+  ZETASQL_ASSERT_OK(sum.Prepare(options));
+  EXPECT_THAT(sum.Execute(), IsOkAndHolds(Int64(5050)));
+}
+
+TEST(EvaluatorTest, BindAfterPrepareWithoutPrepare) {
+  PreparedExpression expr("1");
+  EXPECT_THAT(expr.BindAfterPrepare(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 TEST(EvaluatorTest, ExplainAfterPrepareWithoutPrepare) {
   PreparedExpression expr("@param + col");
   EXPECT_THAT(expr.ExplainAfterPrepare(),
@@ -1178,6 +1402,83 @@ TEST(EvaluatorTest, ExplainAfterPrepare) {
               IsOkAndHolds("RootExpr(Add($param, $col))"));
 }
 
+TEST(EvaluatorTest, FoldConstants) {
+  PreparedExpression expr("col + (1 + 2) * 4");
+  AnalyzerOptions options;
+  ZETASQL_ASSERT_OK(options.AddExpressionColumn("col", types::Int64Type()));
+  ZETASQL_ASSERT_OK(expr.Prepare(options));
+  EXPECT_THAT(expr.ExplainAfterPrepare(),
+              IsOkAndHolds("RootExpr(Add($col, ConstExpr(12)))"));
+  EXPECT_THAT(expr.Execute({{"col", Int64(1)}}), IsOkAndHolds(Int64(13)));
+}
+
+TEST(EvaluatorTest, FoldConstantsKeepsErrors) {
+  // 1 / 0 is not folded, so the error is only raised if it is evaluated.
+  PreparedExpression expr("IF(col, 1, DIV(1, 0))");
+  AnalyzerOptions options;
+  ZETASQL_ASSERT_OK(options.AddExpressionColumn("col", types::BoolType()));
+  ZETASQL_ASSERT_OK(expr.Prepare(options));
+  EXPECT_THAT(expr.Execute({{"col", Bool(true)}}), IsOkAndHolds(Int64(1)));
+  EXPECT_THAT(expr.Execute({{"col", Bool(false)}}),
+              StatusIs(absl::StatusCode::kOutOfRange,
+                       HasSubstr("division by zero")));
+}
+
+TEST(EvaluatorTest, SkipRewritesWithNativeSupport) {
+  const std::string sql = "WITH(a AS col + 1, a * a)";
+  AnalyzerOptions options;
+  options.mutable_language()->EnableLanguageFeature(
+      FEATURE_V_1_4_WITH_EXPRESSION);
+  ZETASQL_ASSERT_OK(options.AddExpressionColumn("col", types::Int64Type()));
+
+  // By default, REWRITE_WITH_EXPR turns the WITH expression into a subquery.
+  PreparedExpression rewritten(sql, EvaluatorOptions());
+  ZETASQL_ASSERT_OK(rewritten.Prepare(options));
+  EXPECT_THAT(rewritten.ExplainAfterPrepare(),
+              IsOkAndHolds(Not(HasSubstr("WithExpr("))));
+  EXPECT_THAT(rewritten.Execute({{"col", Int64(2)}}), IsOkAndHolds(Int64(9)));
+
+  EvaluatorOptions evaluator_options;
+  evaluator_options.skip_rewrites_with_native_support = true;
+  PreparedExpression native(sql, evaluator_options);
+  ZETASQL_ASSERT_OK(native.Prepare(options));
+  EXPECT_THAT(native.ExplainAfterPrepare(),
+              IsOkAndHolds(HasSubstr("WithExpr(")));
+  EXPECT_THAT(native.Execute({{"col", Int64(2)}}), IsOkAndHolds(Int64(9)));
+}
+
+TEST(EvaluatorTest, SkipRewritesWithNativeSupportKeepsOtherRewrites) {
+  SimpleTable table("t", {{"uid", types::Int64Type()},
+                          {"x", types::Int64Type()}});
+  ZETASQL_ASSERT_OK(table.SetAnonymizationInfo("uid"));
+  table.SetContents({{Int64(1), Int64(10)},
+                     {Int64(2), Int64(20)},
+                     {Int64(3), Int64(30)}});
+  SimpleCatalog catalog("TestCatalog");
+  catalog.AddTable(table.Name(), &table);
+  catalog.AddBuiltinFunctions(BuiltinFunctionOptions::AllReleasedFunctions());
+
+  AnalyzerOptions options;
+  options.mutable_language()->EnableLanguageFeature(FEATURE_ANONYMIZATION);
+  options.enable_rewrite(REWRITE_ANONYMIZATION);
+
+  // The evaluator has no direct implementation of anonymized aggregation, so
+  // REWRITE_ANONYMIZATION must still run.
+  EvaluatorOptions evaluator_options;
+  evaluator_options.skip_rewrites_with_native_support = true;
+  PreparedQuery query(
+      "SELECT WITH ANONYMIZATION OPTIONS(epsilon=1e20, k_threshold=1) "
+      "ANON_SUM(x CLAMPED BETWEEN 0 AND 100) FROM t",
+      evaluator_options);
+  ZETASQL_ASSERT_OK(query.Prepare(options, &catalog));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       query.Execute());
+  ASSERT_TRUE(iter->NextRow()) << iter->Status();
+  EXPECT_EQ(iter->GetValue(0), Int64(60));
+  EXPECT_FALSE(iter->NextRow());
+  ZETASQL_EXPECT_OK(iter->Status());
+}
+
 TEST(EvaluatorTest, GetReferencedParametersAsProperSubset) {
   PreparedExpression expr("@param1 + @param2");
   AnalyzerOptions options;
@@ -2759,6 +3060,514 @@ TEST(PreparedQuery, ExpressionQuery) {
   ZETASQL_EXPECT_OK(iter->Status());
 }
 
+TEST(PreparedQuery, MemoizedSubqueries) {
+  PreparedQuery query(
+      "SELECT (SELECT COUNT(*) FROM UNNEST([1, 2, 3]) x WHERE x < y),\n"
+      "       y IN (SELECT x FROM UNNEST([2, 3]) x),\n"
+      "       EXISTS(SELECT 1 FROM UNNEST([3]) x WHERE x = y)\n"
+      "FROM UNNEST([1, 2, 2, 3]) y WITH OFFSET pos ORDER BY pos",
+      EvaluatorOptions());
+  ZETASQL_ASSERT_OK(query.Prepare(AnalyzerOptions()));
+  EXPECT_THAT(query.ExplainAfterPrepare(),
+              IsOkAndHolds(HasSubstr("MemoizedSubqueryExpr")));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       query.Execute());
+  const std::vector<std::vector<Value>> expected = {
+      {Int64(0), Bool(false), Bool(false)},
+      {Int64(1), Bool(true), Bool(false)},
+      {Int64(1), Bool(true), Bool(false)},
+      {Int64(2), Bool(true), Bool(true)}};
+  for (const std::vector<Value>& row : expected) {
+    ASSERT_TRUE(iter->NextRow()) << iter->Status();
+    for (int i = 0; i < row.size(); ++i) {
+      EXPECT_EQ(row[i], iter->GetValue(i));
+    }
+  }
+  EXPECT_FALSE(iter->NextRow());
+  ZETASQL_EXPECT_OK(iter->Status());
+}
+
+TEST(PreparedQuery, ReportsEvaluationStats) {
+  PreparedQuery query(
+      "SELECT x FROM UNNEST(GENERATE_ARRAY(1, 1000)) x ORDER BY -x",
+      EvaluatorOptions());
+  EvaluationStats stats;
+  PreparedQuery::QueryOptions options;
+  options.stats = &stats;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       query.Execute(std::move(options)));
+  ASSERT_TRUE(iter->NextRow()) << iter->Status();
+  EXPECT_EQ(Int64(1000), iter->GetValue(0));
+  // The stats are set when the iterator is destroyed.
+  EXPECT_EQ(stats.peak_memory_bytes, 0);
+  iter.reset();
+  EXPECT_GT(stats.peak_memory_bytes, 0);
+  EXPECT_TRUE(stats.execution_stats.has_wall_time());
+  EXPECT_TRUE(stats.execution_stats.has_cpu_time());
+
+  PreparedExpression expr(
+      "ARRAY(SELECT x FROM UNNEST([3, 1, 2]) x ORDER BY x)");
+  EvaluationStats expr_stats;
+  ExpressionOptions expr_options;
+  expr_options.stats = &expr_stats;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(Value result,
+                       expr.Execute(std::move(expr_options)));
+  EXPECT_EQ(result, values::Int64Array({1, 2, 3}));
+  EXPECT_GT(expr_stats.peak_memory_bytes, 0);
+}
+
+TEST(PreparedQuery, ReservesIntermediateMemoryFromPool) {
+  MemoryPool process_pool(/*max_bytes=*/1 << 30, /*parent=*/nullptr,
+                          "process");
+  MemoryPool tenant_pool(/*max_bytes=*/10000, &process_pool, "tenant");
+  EvaluatorOptions evaluator_options;
+  evaluator_options.memory_pool = &tenant_pool;
+  PreparedQuery query(
+      "SELECT x FROM UNNEST(GENERATE_ARRAY(1, @n)) x ORDER BY -x",
+      evaluator_options);
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       query.Execute({{"n", Int64(10)}}));
+  ASSERT_TRUE(iter->NextRow()) << iter->Status();
+  EXPECT_GT(tenant_pool.reserved_bytes(), 0);
+  EXPECT_EQ(process_pool.reserved_bytes(), tenant_pool.reserved_bytes());
+  iter.reset();
+  EXPECT_EQ(tenant_pool.reserved_bytes(), 0);
+  EXPECT_EQ(process_pool.reserved_bytes(), 0);
+
+  // Running out of the pool fails the query even though it is far below
+  // 'max_intermediate_byte_size'.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(iter, query.Execute({{"n", Int64(10000)}}));
+  EXPECT_FALSE(iter->NextRow());
+  EXPECT_THAT(iter->Status(),
+              StatusIs(absl::StatusCode::kResourceExhausted,
+                       HasSubstr("Out of memory for MemoryPool(tenant)")));
+  iter.reset();
+  EXPECT_EQ(tenant_pool.reserved_bytes(), 0);
+}
+
+// Records the events of an EvaluatorTracer by operator and function name.
+class RecordingTracer : public EvaluatorTracer {
+ public:
+  void BeginCreateIterator(const void* operator_id,
+                           absl::string_view operator_name) override {
+    absl::MutexLock lock(&mutex_);
+    ++num_begins_[operator_name];
+  }
+  void EndCreateIterator(const void* operator_id,
+                         absl::string_view operator_name,
+                         const absl::Status& status) override {
+    absl::MutexLock lock(&mutex_);
+    ++num_ends_[operator_name];
+  }
+  int64_t row_sample_interval() const override { return 1000; }
+  void SampleRows(const void* operator_id, absl::string_view operator_name,
+                  int64_t num_rows) override {
+    absl::MutexLock lock(&mutex_);
+    row_samples_[operator_name].push_back(num_rows);
+  }
+  void RecordFunctionCalls(absl::string_view function_name, int64_t num_calls,
+                           absl::Duration wall_time) override {
+    absl::MutexLock lock(&mutex_);
+    num_function_calls_[function_name] += num_calls;
+  }
+
+  absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, int> num_begins_;
+  absl::flat_hash_map<std::string, int> num_ends_;
+  absl::flat_hash_map<std::string, std::vector<int64_t>> row_samples_;
+  absl::flat_hash_map<std::string, int64_t> num_function_calls_;
+};
+
+TEST(PreparedQuery, ReportsTracingEvents) {
+  RecordingTracer tracer;
+  EvaluatorOptions evaluator_options;
+  evaluator_options.tracer = &tracer;
+  PreparedQuery query(
+      "SELECT x + 1 FROM UNNEST(GENERATE_ARRAY(1, 2500)) x ORDER BY -x",
+      evaluator_options);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       query.Execute());
+  int64_t num_rows = 0;
+  while (iter->NextRow()) ++num_rows;
+  ZETASQL_ASSERT_OK(iter->Status());
+  EXPECT_EQ(num_rows, 2500);
+  iter.reset();
+
+  absl::MutexLock lock(&tracer.mutex_);
+  EXPECT_EQ(tracer.num_begins_["SortOp"], 1);
+  EXPECT_EQ(tracer.num_begins_, tracer.num_ends_);
+  EXPECT_THAT(tracer.row_samples_["SortOp"], ElementsAre(1000, 2000, 2500));
+  EXPECT_EQ(tracer.num_function_calls_["Add"], 2500);
+}
+
+TEST(PreparedQuery, WithEntryReferencedInCorrelatedSubquery) {
+  // The only reference to 't' is evaluated once per row of 'y', but 't' must
+  // still be evaluated only once.
+  PreparedQuery query(
+      "WITH t AS (SELECT RAND() AS r)\n"
+      "SELECT COUNT(DISTINCT (SELECT r FROM t WHERE y = y))\n"
+      "FROM UNNEST([1, 2, 3, 4]) y",
+      EvaluatorOptions());
+  ZETASQL_ASSERT_OK(query.Prepare(AnalyzerOptions()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       query.Execute());
+  ASSERT_TRUE(iter->NextRow()) << iter->Status();
+  EXPECT_EQ(Int64(1), iter->GetValue(0));
+  EXPECT_FALSE(iter->NextRow());
+  ZETASQL_EXPECT_OK(iter->Status());
+}
+
+TEST(PreparedQuery, SemiJoinSubqueries) {
+  // Appends the values of the only column of 'sql' to 'values' and returns
+  // the ExplainAfterPrepare() output.
+  auto evaluate =
+      [](const std::string& sql,
+         std::vector<Value>* values) -> absl::StatusOr<std::string> {
+    PreparedQuery query(sql, EvaluatorOptions());
+    ZETASQL_RETURN_IF_ERROR(query.Prepare(AnalyzerOptions()));
+    ZETASQL_ASSIGN_OR_RETURN(std::string explain, query.ExplainAfterPrepare());
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> iter,
+                     query.Execute());
+    while (iter->NextRow()) {
+      values->push_back(iter->GetValue(0));
+    }
+    ZETASQL_RETURN_IF_ERROR(iter->Status());
+    return explain;
+  };
+
+  std::vector<Value> values;
+  EXPECT_THAT(
+      evaluate("SELECT y FROM UNNEST([1, 2, 2, 3, NULL]) y WITH OFFSET pos\n"
+               "WHERE y IN (SELECT x FROM UNNEST([2, 3]) x)\n"
+               "  AND NOT EXISTS(SELECT 1 FROM UNNEST([3]) x WHERE x = y)\n"
+               "ORDER BY pos",
+               &values),
+      IsOkAndHolds(AllOf(HasSubstr("JoinOp(SEMI"), HasSubstr("JoinOp(ANTI"),
+                         Not(HasSubstr("ExistsExpr")))));
+  EXPECT_THAT(values, ElementsAre(Int64(2), Int64(2)));
+
+  values.clear();
+  EXPECT_THAT(
+      evaluate("SELECT y FROM UNNEST([1, 2, NULL]) y WITH OFFSET pos\n"
+               "WHERE y NOT IN (SELECT x FROM UNNEST([2, 4]) x) ORDER BY pos",
+               &values),
+      IsOkAndHolds(HasSubstr("JoinOp(NULL-AWARE ANTI")));
+  EXPECT_THAT(values, ElementsAre(Int64(1)));
+
+  values.clear();
+  ZETASQL_EXPECT_OK(evaluate(
+      "SELECT y FROM UNNEST([1, 2, NULL]) y\n"
+      "WHERE y NOT IN (SELECT x FROM UNNEST([2, NULL]) x)",
+      &values));
+  EXPECT_THAT(values, IsEmpty());
+}
+
+TEST(PreparedQuery, RangeJoin) {
+  PreparedQuery query(
+      "SELECT x.id, y.id\n"
+      "FROM UNNEST([STRUCT(1 AS id, RANGE<DATE> '[2020-01-01, 2020-01-10)' "
+      "AS r),\n"
+      "             (2, RANGE<DATE> '[2020-02-01, UNBOUNDED)')]) x\n"
+      "JOIN UNNEST([STRUCT(10 AS id, RANGE<DATE> '[2019-12-25, 2020-01-02)' "
+      "AS r),\n"
+      "             (20, RANGE<DATE> '[2020-01-10, 2020-03-01)')]) y\n"
+      "ON RANGE_OVERLAPS(x.r, y.r)\n"
+      "ORDER BY 1, 2",
+      EvaluatorOptions());
+  LanguageOptions language_options;
+  language_options.EnableLanguageFeature(FEATURE_RANGE_TYPE);
+  ZETASQL_ASSERT_OK(query.Prepare(AnalyzerOptions(language_options)));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::string explain, query.ExplainAfterPrepare());
+  EXPECT_THAT(explain, AllOf(HasSubstr("range_join_left_expr"),
+                             HasSubstr("range_join_right_expr")));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       query.Execute());
+  const std::vector<std::vector<Value>> expected = {{Int64(1), Int64(10)},
+                                                    {Int64(2), Int64(20)}};
+  for (const std::vector<Value>& row : expected) {
+    ASSERT_TRUE(iter->NextRow()) << iter->Status();
+    for (int i = 0; i < row.size(); ++i) {
+      EXPECT_EQ(row[i], iter->GetValue(i));
+    }
+  }
+  EXPECT_FALSE(iter->NextRow());
+  ZETASQL_EXPECT_OK(iter->Status());
+}
+
+TEST(PreparedQuery, InnerJoinBuildsOnSmallerInput) {
+  SimpleTable small_table("SmallTable", {{"a", types::Int64Type()}});
+  small_table.SetContents({{Int64(1)}, {Int64(2)}});
+  SimpleTable big_table("BigTable", {{"a", types::Int64Type()},
+                                     {"b", types::StringType()}});
+  big_table.SetContents({{Int64(1), String("x")},
+                         {Int64(2), String("y")},
+                         {Int64(3), String("z")}});
+  big_table.SetRowCountEstimate(1000000);
+  SimpleCatalog catalog("TestCatalog");
+  catalog.AddTable(small_table.Name(), &small_table);
+  catalog.AddTable(big_table.Name(), &big_table);
+
+  PreparedQuery query(
+      "SELECT s.a, b.b FROM SmallTable s JOIN BigTable b ON s.a = b.a "
+      "ORDER BY 1",
+      EvaluatorOptions());
+  ZETASQL_ASSERT_OK(query.Prepare(AnalyzerOptions(), &catalog));
+  // The hash table is built on the right input, which is now SmallTable.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::string explain, query.ExplainAfterPrepare());
+  const size_t big_table_pos = explain.find("table: BigTable");
+  const size_t small_table_pos = explain.find("table: SmallTable");
+  ASSERT_NE(big_table_pos, std::string::npos);
+  ASSERT_NE(small_table_pos, std::string::npos);
+  EXPECT_LT(big_table_pos, small_table_pos) << explain;
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       query.Execute());
+  const std::vector<std::vector<Value>> expected = {{Int64(1), String("x")},
+                                                    {Int64(2), String("y")}};
+  for (const std::vector<Value>& row : expected) {
+    ASSERT_TRUE(iter->NextRow()) << iter->Status();
+    for (int i = 0; i < row.size(); ++i) {
+      EXPECT_EQ(row[i], iter->GetValue(i));
+    }
+  }
+  EXPECT_FALSE(iter->NextRow());
+  ZETASQL_EXPECT_OK(iter->Status());
+}
+
+TEST(PreparedQuery, JoinKeyFiltersOnProbeSideScan) {
+  SimpleTable keys_table("KeysTable", {{"a", types::Int64Type()}});
+  keys_table.SetContents({{Int64(2)}, {Int64(4)}, {NullInt64()}});
+  SimpleTable probe_table("ProbeTable", {{"a", types::Int64Type()},
+                                         {"b", types::StringType()}});
+  std::vector<std::vector<Value>> probe_rows;
+  for (int64_t i = 0; i < 100; ++i) {
+    probe_rows.push_back({Int64(i), String(absl::StrCat("row", i))});
+  }
+  probe_rows.push_back({NullInt64(), String("null")});
+  probe_table.SetContents(probe_rows);
+  SimpleCatalog catalog("TestCatalog");
+  catalog.AddTable(keys_table.Name(), &keys_table);
+  catalog.AddTable(probe_table.Name(), &probe_table);
+
+  // The hash table is built on KeysTable, and its keys filter the scan of
+  // ProbeTable.
+  PreparedQuery query(
+      "SELECT p.a, p.b FROM ProbeTable p JOIN KeysTable k ON p.a = k.a "
+      "ORDER BY 1",
+      EvaluatorOptions());
+  ZETASQL_ASSERT_OK(query.Prepare(AnalyzerOptions(), &catalog));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::string explain, query.ExplainAfterPrepare());
+  EXPECT_THAT(explain, HasSubstr("join_key_filters: "));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       query.Execute());
+  const std::vector<std::vector<Value>> expected = {
+      {Int64(2), String("row2")}, {Int64(4), String("row4")}};
+  for (const std::vector<Value>& row : expected) {
+    ASSERT_TRUE(iter->NextRow()) << iter->Status();
+    for (int i = 0; i < row.size(); ++i) {
+      EXPECT_EQ(row[i], iter->GetValue(i));
+    }
+  }
+  EXPECT_FALSE(iter->NextRow());
+  ZETASQL_EXPECT_OK(iter->Status());
+
+  // The unmatched rows of the left input of a LEFT JOIN are in the output.
+  PreparedQuery left_join_query(
+      "SELECT COUNT(*) FROM ProbeTable p LEFT JOIN KeysTable k ON p.a = k.a",
+      EvaluatorOptions());
+  ZETASQL_ASSERT_OK(left_join_query.Prepare(AnalyzerOptions(), &catalog));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(explain, left_join_query.ExplainAfterPrepare());
+  EXPECT_THAT(explain, Not(HasSubstr("join_key_filters: ")));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(iter, left_join_query.Execute());
+  ASSERT_TRUE(iter->NextRow()) << iter->Status();
+  EXPECT_EQ(iter->GetValue(0), Int64(101));
+}
+
+TEST(PreparedQuery, BetweenRangeJoin) {
+  // The right input is indexed by the intervals [lo, lo + 2].
+  PreparedQuery query(
+      "SELECT x, lo FROM UNNEST([1, 4, 5, 10, NULL]) x\n"
+      "JOIN UNNEST([0, 4, 9]) lo ON x BETWEEN lo AND lo + 2\n"
+      "ORDER BY 1",
+      EvaluatorOptions());
+  ZETASQL_ASSERT_OK(query.Prepare(AnalyzerOptions()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::string explain, query.ExplainAfterPrepare());
+  EXPECT_THAT(explain, HasSubstr("range_join_right_upper_bound_expr"));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       query.Execute());
+  const std::vector<std::vector<Value>> expected = {
+      {Int64(1), Int64(0)},
+      {Int64(4), Int64(4)},
+      {Int64(5), Int64(4)},
+      {Int64(10), Int64(9)}};
+  for (const std::vector<Value>& row : expected) {
+    ASSERT_TRUE(iter->NextRow()) << iter->Status();
+    for (int i = 0; i < row.size(); ++i) {
+      EXPECT_EQ(row[i], iter->GetValue(i));
+    }
+  }
+  EXPECT_FALSE(iter->NextRow());
+  ZETASQL_EXPECT_OK(iter->Status());
+}
+
+TEST(PreparedQuery, MergeJoinOfSortedInputs) {
+  // Both inputs are sorted on the join key, so they are merged.
+  PreparedQuery query(
+      "SELECT l.x, r.y\n"
+      "FROM (SELECT x FROM UNNEST([1, 2, 2, 3, NULL]) x ORDER BY x) l\n"
+      "JOIN (SELECT s.x, s.y\n"
+      "      FROM UNNEST([STRUCT(2 AS x, 'a' AS y), (3, 'b'), (3, 'c'),\n"
+      "                   (4, 'd'), (NULL, 'e')]) s\n"
+      "      ORDER BY s.x) r\n"
+      "ON l.x = r.x\n"
+      "ORDER BY 1, 2",
+      EvaluatorOptions());
+  ZETASQL_ASSERT_OK(query.Prepare(AnalyzerOptions()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::string explain, query.ExplainAfterPrepare());
+  EXPECT_THAT(explain, HasSubstr("merge_join"));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       query.Execute());
+  const std::vector<std::vector<Value>> expected = {{Int64(2), String("a")},
+                                                    {Int64(2), String("a")},
+                                                    {Int64(3), String("b")},
+                                                    {Int64(3), String("c")}};
+  for (const std::vector<Value>& row : expected) {
+    ASSERT_TRUE(iter->NextRow()) << iter->Status();
+    for (int i = 0; i < row.size(); ++i) {
+      EXPECT_EQ(row[i], iter->GetValue(i));
+    }
+  }
+  EXPECT_FALSE(iter->NextRow());
+  ZETASQL_EXPECT_OK(iter->Status());
+}
+
+TEST(PreparedQuery, CommonSubexpressions) {
+  PreparedQuery query(
+      "SELECT x * y + 1 AS a, x * y + 1 > 2 AS b, IF(x > 1, x * y, 0) AS c,\n"
+      "       RAND() < 2 AS d, RAND() < 2 AS e\n"
+      "FROM UNNEST([1, 2]) x WITH OFFSET y ORDER BY y",
+      EvaluatorOptions());
+  ZETASQL_ASSERT_OK(query.Prepare(AnalyzerOptions()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::string explain, query.ExplainAfterPrepare());
+  // Only x * y + 1 is hoisted: x * y in IF() is covered by it, and RAND() is
+  // volatile.
+  EXPECT_THAT(explain,
+              HasSubstr("$cse := Add(Multiply($x, $y), ConstExpr(1))"));
+  EXPECT_THAT(explain, Not(HasSubstr("$cse.")));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       query.Execute());
+  const std::vector<std::vector<Value>> expected = {
+      {Int64(1), Bool(false), Int64(0), Bool(true), Bool(true)},
+      {Int64(3), Bool(true), Int64(2), Bool(true), Bool(true)}};
+  for (const std::vector<Value>& row : expected) {
+    ASSERT_TRUE(iter->NextRow()) << iter->Status();
+    for (int i = 0; i < row.size(); ++i) {
+      EXPECT_EQ(row[i], iter->GetValue(i));
+    }
+  }
+  EXPECT_FALSE(iter->NextRow());
+  ZETASQL_EXPECT_OK(iter->Status());
+}
+
+TEST(PreparedQuery, GroupedJsonExtractions) {
+  PreparedQuery query(
+      "SELECT JSON_VALUE(j, '$.a') AS a, JSON_EXTRACT(j, '$.b') AS b,\n"
+      "       JSON_VALUE(j, '$.a') || 'x' AS c, JSON_QUERY(j, '$.c[1]') AS d\n"
+      "FROM UNNEST(['{\"a\": \"x\", \"b\": {\"c\": 1}}',\n"
+      "             '{\"c\": [1, {\"d\": true}]}',\n"
+      "             CAST(NULL AS STRING)]) j WITH OFFSET o\n"
+      "ORDER BY o",
+      EvaluatorOptions());
+  ZETASQL_ASSERT_OK(query.Prepare(AnalyzerOptions()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::string explain, query.ExplainAfterPrepare());
+  // The three distinct extractions from 'j' are computed together.
+  EXPECT_THAT(explain, HasSubstr("$json := JsonMultiExtract($j)"));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       query.Execute());
+  const std::vector<std::vector<Value>> expected = {
+      {String("x"), String("{\"c\":1}"), String("xx"), NullString()},
+      {NullString(), NullString(), NullString(), String("{\"d\":true}")},
+      {NullString(), NullString(), NullString(), NullString()}};
+  for (const std::vector<Value>& row : expected) {
+    ASSERT_TRUE(iter->NextRow()) << iter->Status();
+    for (int i = 0; i < row.size(); ++i) {
+      EXPECT_EQ(row[i], iter->GetValue(i));
+    }
+  }
+  EXPECT_FALSE(iter->NextRow());
+  ZETASQL_EXPECT_OK(iter->Status());
+}
+
+TEST(PreparedQuery, ExplainAnalyzeAfterPrepare) {
+  PreparedQuery query(
+      "SELECT x FROM UNNEST([3, 1, 2]) x WHERE x > 1 ORDER BY x",
+      EvaluatorOptions());
+  ZETASQL_ASSERT_OK(query.Prepare(AnalyzerOptions()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::string explain,
+                       query.ExplainAnalyzeAfterPrepare());
+  EXPECT_THAT(explain, HasSubstr("SortOp: iterators=1 rows=2 "));
+  EXPECT_THAT(explain, HasSubstr("FilterOp: iterators=1 rows=2 "));
+  EXPECT_THAT(explain, HasSubstr("ArrayScanOp: iterators=1 rows=3 "));
+  EXPECT_THAT(explain, HasSubstr("wall_time="));
+
+  // Profiling does not affect normal execution.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       query.ExecuteAfterPrepare());
+  ASSERT_TRUE(iter->NextRow()) << iter->Status();
+  EXPECT_EQ(Int64(2), iter->GetValue(0));
+  ASSERT_TRUE(iter->NextRow()) << iter->Status();
+  EXPECT_EQ(Int64(3), iter->GetValue(0));
+  EXPECT_FALSE(iter->NextRow());
+  ZETASQL_EXPECT_OK(iter->Status());
+}
+
+TEST(PreparedQuery, ExecuteAfterPrepareWithProfile) {
+  PreparedQuery query("SELECT x FROM UNNEST([3, 1, 2]) x ORDER BY x",
+                      EvaluatorOptions());
+  ZETASQL_ASSERT_OK(query.Prepare(AnalyzerOptions()));
+  OperatorProfile profile;
+  {
+    ZETASQL_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<EvaluatorTableIterator> iter,
+        query.ExecuteAfterPrepareWithProfile(PreparedQuery::QueryOptions(),
+                                             &profile));
+    int num_rows = 0;
+    while (iter->NextRow()) ++num_rows;
+    ZETASQL_EXPECT_OK(iter->Status());
+    EXPECT_EQ(num_rows, 3);
+  }
+  // The sort buffers its input in memory tracked by the MemoryAccountant.
+  EXPECT_GT(profile.GetPeakMemoryBytes(), 0);
+}
+
+TEST(PreparedQuery, GeneratedArrayScans) {
+  // The array would have more elements than GENERATE_ARRAY allows.
+  PreparedQuery query(
+      "SELECT COUNT(*), SUM(x), MAX(o)\n"
+      "FROM UNNEST(GENERATE_ARRAY(1, 100000)) x WITH OFFSET o",
+      EvaluatorOptions());
+  ZETASQL_ASSERT_OK(query.Prepare(AnalyzerOptions()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::string explain, query.ExplainAfterPrepare());
+  EXPECT_THAT(explain, HasSubstr("GenerateArrayScanOp("));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       query.Execute());
+  ASSERT_TRUE(iter->NextRow()) << iter->Status();
+  EXPECT_EQ(iter->GetValue(0), Int64(100000));
+  EXPECT_EQ(iter->GetValue(1), Int64(5000050000));
+  EXPECT_EQ(iter->GetValue(2), Int64(99999));
+  EXPECT_FALSE(iter->NextRow());
+  ZETASQL_EXPECT_OK(iter->Status());
+}
+
 TEST(PreparedQuery, NontrivialOutputColumnNames) {
   // Query adapted from b/123093575.
   const std::string query_str =
@@ -4980,6 +5789,416 @@ TEST(PreparedQuery, FromTableDeadlineExceeded) {
   EXPECT_THAT(iter->Status(), StatusIs(absl::StatusCode::kDeadlineExceeded, _));
 }
 
+// A SimpleTable whose iterators record the arguments of
+// SetReferencedColumns() and SetColumnFilterMap(), and return NULL for the
+// columns that are not referenced.
+class ScanHintsRecordingTable : public SimpleTable {
+ public:
+  struct Hints {
+    std::optional<std::vector<int>> referenced_columns;
+    absl::flat_hash_map<int, ColumnFilter::Kind> filter_kinds;
+  };
+
+  using SimpleTable::SimpleTable;
+
+  absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>>
+  CreateEvaluatorTableIterator(
+      absl::Span<const int> column_idxs) const override {
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> iter,
+                     SimpleTable::CreateEvaluatorTableIterator(column_idxs));
+    return std::make_unique<Iterator>(std::move(iter), &hints_);
+  }
+
+  const Hints& hints() const { return hints_; }
+
+ private:
+  class Iterator : public EvaluatorTableIterator {
+   public:
+    Iterator(std::unique_ptr<EvaluatorTableIterator> iter, Hints* hints)
+        : iter_(std::move(iter)), hints_(hints) {
+      for (int i = 0; i < iter_->NumColumns(); ++i) {
+        null_values_.push_back(Value::Null(iter_->GetColumnType(i)));
+      }
+    }
+
+    int NumColumns() const override { return iter_->NumColumns(); }
+    std::string GetColumnName(int i) const override {
+      return iter_->GetColumnName(i);
+    }
+    const Type* GetColumnType(int i) const override {
+      return iter_->GetColumnType(i);
+    }
+
+    absl::Status SetColumnFilterMap(
+        absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map)
+        override {
+      for (const auto& [column_idx, filter] : filter_map) {
+        hints_->filter_kinds[column_idx] = filter->kind();
+      }
+      return iter_->SetColumnFilterMap(std::move(filter_map));
+    }
+
+    absl::Status SetReferencedColumns(
+        absl::Span<const int> column_idxs) override {
+      hints_->referenced_columns.emplace(column_idxs.begin(),
+                                         column_idxs.end());
+      return iter_->SetReferencedColumns(column_idxs);
+    }
+
+    bool NextRow() override { return iter_->NextRow(); }
+
+    const Value& GetValue(int i) const override {
+      if (hints_->referenced_columns.has_value() &&
+          !absl::c_linear_search(*hints_->referenced_columns, i)) {
+        return null_values_[i];
+      }
+      return iter_->GetValue(i);
+    }
+
+    absl::Status Status() const override { return iter_->Status(); }
+    absl::Status Cancel() override { return iter_->Cancel(); }
+
+   private:
+    std::unique_ptr<EvaluatorTableIterator> iter_;
+    Hints* hints_;
+    std::vector<Value> null_values_;
+  };
+
+  mutable Hints hints_;
+};
+
+TEST(PreparedQuery, PushesDownScanHints) {
+  ScanHintsRecordingTable test_table("TestTable",
+                                     {{"a", types::Int64Type()},
+                                      {"b", types::Int64Type()},
+                                      {"c", types::StringType()},
+                                      {"d", types::StringType()}});
+  test_table.SetContents({{Int64(1), NullInt64(), String("abc"), String("w")},
+                          {Int64(2), Int64(5), String("abd"), String("x")},
+                          {Int64(3), NullInt64(), String("bcd"), String("y")},
+                          {Int64(4), NullInt64(), String("ab"), String("z")}});
+
+  SimpleCatalog catalog("TestCatalog");
+  catalog.AddBuiltinFunctions(BuiltinFunctionOptions::AllReleasedFunctions());
+  catalog.AddTable(test_table.Name(), &test_table);
+
+  PreparedQuery query(
+      "SELECT a FROM TestTable WHERE b IS NULL AND c LIKE 'ab%' ORDER BY a",
+      EvaluatorOptions());
+  ZETASQL_ASSERT_OK(query.Prepare(AnalyzerOptions(), &catalog));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       query.Execute());
+
+  std::vector<Value> values;
+  while (iter->NextRow()) {
+    values.push_back(iter->GetValue(0));
+  }
+  ZETASQL_ASSERT_OK(iter->Status());
+  EXPECT_THAT(values, ElementsAre(Int64(1), Int64(4)));
+
+  // Column 'd' is never read.
+  EXPECT_THAT(test_table.hints().referenced_columns,
+              Optional(ElementsAre(0, 1, 2)));
+  EXPECT_THAT(test_table.hints().filter_kinds,
+              UnorderedElementsAre(Pair(1, ColumnFilter::kIsNull),
+                                   Pair(2, ColumnFilter::kPrefix)));
+}
+
+// A TVF with a fixed schema that returns the rows of a SimpleTable. Its
+// iterators record the filters passed to SetColumnFilterMap(), but do not
+// apply them.
+class FilterRecordingTVF : public FixedOutputSchemaTVF {
+ public:
+  FilterRecordingTVF(const TVFRelation& schema, const SimpleTable* table)
+      : FixedOutputSchemaTVF(
+            {"filter_recording_tvf"},
+            FunctionSignature(
+                FunctionArgumentType::RelationWithSchema(
+                    schema, /*extra_relation_input_columns_allowed=*/false),
+                FunctionArgumentTypeList(), /*context_ptr=*/nullptr),
+            schema),
+        table_(table) {}
+
+  absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>> CreateEvaluator(
+      std::vector<TvfEvaluatorArg> input_arguments,
+      const std::vector<TVFSchemaColumn>& output_columns,
+      const FunctionSignature* function_call_signature) const override {
+    std::vector<int> column_idxs;
+    for (int i = 0; i < table_->NumColumns(); ++i) {
+      column_idxs.push_back(i);
+    }
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> iter,
+                     table_->CreateEvaluatorTableIterator(column_idxs));
+    return std::make_unique<Iterator>(std::move(iter), &filter_kinds_);
+  }
+
+  // Keyed on the column indexes of the iterator, which are those of the table.
+  const absl::flat_hash_map<int, ColumnFilter::Kind>& filter_kinds() const {
+    return filter_kinds_;
+  }
+
+ private:
+  class Iterator : public EvaluatorTableIterator {
+   public:
+    Iterator(std::unique_ptr<EvaluatorTableIterator> iter,
+             absl::flat_hash_map<int, ColumnFilter::Kind>* filter_kinds)
+        : iter_(std::move(iter)), filter_kinds_(filter_kinds) {}
+
+    int NumColumns() const override { return iter_->NumColumns(); }
+    std::string GetColumnName(int i) const override {
+      return iter_->GetColumnName(i);
+    }
+    const Type* GetColumnType(int i) const override {
+      return iter_->GetColumnType(i);
+    }
+
+    absl::Status SetColumnFilterMap(
+        absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map)
+        override {
+      for (const auto& [column_idx, filter] : filter_map) {
+        (*filter_kinds_)[column_idx] = filter->kind();
+      }
+      return absl::OkStatus();
+    }
+
+    bool NextRow() override { return iter_->NextRow(); }
+    const Value& GetValue(int i) const override { return iter_->GetValue(i); }
+    absl::Status Status() const override { return iter_->Status(); }
+    absl::Status Cancel() override { return iter_->Cancel(); }
+
+   private:
+    std::unique_ptr<EvaluatorTableIterator> iter_;
+    absl::flat_hash_map<int, ColumnFilter::Kind>* filter_kinds_;
+  };
+
+  const SimpleTable* table_;
+  mutable absl::flat_hash_map<int, ColumnFilter::Kind> filter_kinds_;
+};
+
+TEST(PreparedQuery, PushesDownFiltersIntoTvf) {
+  SimpleTable table("TvfRows",
+                    {{"a", types::Int64Type()}, {"b", types::StringType()}});
+  table.SetContents({{Int64(1), String("x")},
+                     {Int64(2), String("y")},
+                     {Int64(3), String("x")},
+                     {Int64(4), String("x")}});
+  FilterRecordingTVF tvf(
+      TVFRelation({{"a", types::Int64Type()}, {"b", types::StringType()}}),
+      &table);
+
+  SimpleCatalog catalog("TestCatalog");
+  catalog.AddBuiltinFunctions(BuiltinFunctionOptions::AllReleasedFunctions());
+  catalog.AddTableValuedFunction(&tvf);
+
+  AnalyzerOptions analyzer_options;
+  analyzer_options.mutable_language()->EnableLanguageFeature(
+      FEATURE_TABLE_VALUED_FUNCTIONS);
+  PreparedQuery query(
+      "SELECT a FROM filter_recording_tvf() WHERE a >= 2 AND b = 'x' "
+      "ORDER BY a",
+      EvaluatorOptions());
+  ZETASQL_ASSERT_OK(query.Prepare(analyzer_options, &catalog));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       query.Execute());
+
+  std::vector<Value> values;
+  while (iter->NextRow()) {
+    values.push_back(iter->GetValue(0));
+  }
+  ZETASQL_ASSERT_OK(iter->Status());
+  // The TVF ignores the filters, so the rows are still filtered above it.
+  EXPECT_THAT(values, ElementsAre(Int64(3), Int64(4)));
+  EXPECT_THAT(tvf.filter_kinds(),
+              UnorderedElementsAre(Pair(0, ColumnFilter::kRange),
+                                   Pair(1, ColumnFilter::kInList)));
+}
+
+TEST(PreparedQuery, ExecuteAsColumnarBatches) {
+  PreparedQuery query(
+      "SELECT x, CAST(x AS STRING) AS s FROM UNNEST([1, 2, NULL]) AS x "
+      "WITH OFFSET o ORDER BY o",
+      EvaluatorOptions());
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ColumnarResultReader> reader,
+      query.ExecuteAsColumnarBatches(/*max_rows_per_batch=*/2));
+  EXPECT_EQ(reader->iterator().GetColumnName(1), "s");
+
+  ColumnarRecordBatch batch;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(bool has_batch, reader->NextBatch(&batch));
+  ASSERT_TRUE(has_batch);
+  ASSERT_EQ(batch.num_rows, 2);
+  EXPECT_EQ(batch.columns[0].GetValue(1), Int64(2));
+  EXPECT_EQ(batch.columns[1].GetValue(0), String("1"));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(has_batch, reader->NextBatch(&batch));
+  ASSERT_TRUE(has_batch);
+  ASSERT_EQ(batch.num_rows, 1);
+  EXPECT_EQ(batch.columns[0].GetValue(0), NullInt64());
+  EXPECT_EQ(batch.columns[1].GetValue(0), NullString());
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(has_batch, reader->NextBatch(&batch));
+  EXPECT_FALSE(has_batch);
+}
+
+TEST(PreparedQuery, ExecuteAsColumnarBatchesUnsupportedType) {
+  PreparedQuery query("SELECT [1] AS a", EvaluatorOptions());
+  EXPECT_THAT(query.ExecuteAsColumnarBatches(/*max_rows_per_batch=*/10),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("cannot be read into a columnar batch")));
+}
+
+// Returns the rows of 'iter'.
+absl::StatusOr<std::vector<std::vector<Value>>> ReadRows(
+    EvaluatorTableIterator* iter) {
+  std::vector<std::vector<Value>> rows;
+  while (iter->NextRow()) {
+    std::vector<Value>& row = rows.emplace_back();
+    for (int i = 0; i < iter->NumColumns(); ++i) {
+      row.push_back(iter->GetValue(i));
+    }
+  }
+  ZETASQL_RETURN_IF_ERROR(iter->Status());
+  return rows;
+}
+
+TEST(PreparedQuery, ExecuteIncrementallyAfterPrepare) {
+  SimpleTable sales("Sales", {{"store", types::Int64Type()},
+                              {"amount", types::Int64Type()}});
+  std::vector<std::vector<Value>> sales_rows = {
+      {Int64(1), Int64(10)}, {Int64(2), Int64(5)}, {Int64(3), Int64(-1)}};
+  sales.SetContents(sales_rows);
+  SimpleTable stores("Stores", {{"id", types::Int64Type()},
+                                {"region", types::StringType()}});
+  stores.SetContents({{Int64(1), String("east")},
+                      {Int64(2), String("west")},
+                      {Int64(3), String("west")}});
+  SimpleCatalog catalog("TestCatalog");
+  catalog.AddBuiltinFunctions(BuiltinFunctionOptions::AllReleasedFunctions());
+  catalog.AddTable(sales.Name(), &sales);
+  catalog.AddTable(stores.Name(), &stores);
+
+  PreparedQuery query(
+      "SELECT st.region, COUNT(*) AS n, SUM(s.amount) AS total, "
+      "MAX(s.amount) AS biggest FROM Sales s JOIN Stores st "
+      "ON s.store = st.id WHERE s.amount > 0 GROUP BY st.region "
+      "ORDER BY st.region",
+      EvaluatorOptions());
+  ZETASQL_ASSERT_OK(query.Prepare(AnalyzerOptions(), &catalog));
+
+  IncrementalQueryState state;
+  {
+    ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                         query.ExecuteIncrementallyAfterPrepare(&sales, &state));
+    EXPECT_THAT(ReadRows(iter.get()),
+                IsOkAndHolds(ElementsAre(
+                    ElementsAre(String("east"), Int64(1), Int64(10), Int64(10)),
+                    ElementsAre(String("west"), Int64(1), Int64(5),
+                                Int64(5)))));
+  }
+  EXPECT_EQ(state.num_rows_read(), 3);
+  EXPECT_EQ(state.num_groups(), 2);
+
+  sales_rows.push_back({Int64(3), Int64(7)});
+  sales_rows.push_back({Int64(1), Int64(2)});
+  sales.SetContents(sales_rows);
+  {
+    ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                         query.ExecuteIncrementallyAfterPrepare(&sales, &state));
+    ZETASQL_ASSERT_OK_AND_ASSIGN(std::vector<std::vector<Value>> rows,
+                         ReadRows(iter.get()));
+    EXPECT_THAT(rows, ElementsAre(ElementsAre(String("east"), Int64(2),
+                                              Int64(12), Int64(10)),
+                                  ElementsAre(String("west"), Int64(2),
+                                              Int64(12), Int64(7))));
+    ZETASQL_ASSERT_OK_AND_ASSIGN(iter, query.ExecuteAfterPrepare());
+    EXPECT_THAT(ReadRows(iter.get()), IsOkAndHolds(rows));
+  }
+  EXPECT_EQ(state.num_rows_read(), 5);
+
+  // Nothing was appended.
+  {
+    ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                         query.ExecuteIncrementallyAfterPrepare(&sales, &state));
+    ZETASQL_ASSERT_OK_AND_ASSIGN(std::vector<std::vector<Value>> rows,
+                         ReadRows(iter.get()));
+    EXPECT_EQ(rows.size(), 2);
+  }
+
+  sales_rows.pop_back();
+  sales.SetContents(sales_rows);
+  EXPECT_THAT(query.ExecuteIncrementallyAfterPrepare(&sales, &state),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("rows must only be appended")));
+  EXPECT_THAT(query.ExecuteIncrementallyAfterPrepare(&stores, &state),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("another query or table")));
+}
+
+TEST(PreparedQuery, TupleBatchSize) {
+  // The ORDER BY reads from a filter and projections that are evaluated
+  // column-wise when reading in batches.
+  const std::string sql =
+      "SELECT x, x * 2 + 1 AS y, x * 0.5 AS z "
+      "FROM UNNEST(GENERATE_ARRAY(1, 1000)) AS x "
+      "WHERE x * 3 < 2000 AND NOT (x = 10) "
+      "ORDER BY y DESC";
+  PreparedQuery row_query(sql, EvaluatorOptions());
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       row_query.Execute());
+  ZETASQL_ASSERT_OK_AND_ASSIGN(const std::vector<std::vector<Value>> expected,
+                       ReadRows(iter.get()));
+  ASSERT_EQ(expected.size(), 665);
+  EXPECT_THAT(expected.front(),
+              ElementsAre(Int64(666), Int64(1333), Double(333)));
+
+  for (int batch_size : {1, 7, 256}) {
+    EvaluatorOptions options;
+    options.tuple_batch_size = batch_size;
+    PreparedQuery batch_query(sql, options);
+    ZETASQL_ASSERT_OK_AND_ASSIGN(iter, batch_query.Execute());
+    EXPECT_THAT(ReadRows(iter.get()), IsOkAndHolds(expected))
+        << "tuple_batch_size " << batch_size;
+
+    PreparedQuery overflow_query(
+        "SELECT x + 9223372036854775806 AS y FROM UNNEST([0, 1, 2]) AS x "
+        "ORDER BY y",
+        options);
+    // The ORDER BY may read its input when the query starts or on the first
+    // row.
+    absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>> overflow_iter =
+        overflow_query.Execute();
+    const absl::Status status = overflow_iter.ok()
+                                    ? ReadRows(overflow_iter->get()).status()
+                                    : overflow_iter.status();
+    EXPECT_THAT(status, StatusIs(absl::StatusCode::kOutOfRange,
+                                 HasSubstr("int64 overflow")))
+        << "tuple_batch_size " << batch_size;
+  }
+}
+
+TEST(PreparedQuery, ExecuteIncrementallyAfterPrepareUnsupportedQueries) {
+  SimpleTable sales("Sales", {{"store", types::Int64Type()},
+                              {"amount", types::Int64Type()}});
+  sales.SetContents({{Int64(1), Int64(10)}});
+  SimpleCatalog catalog("TestCatalog");
+  catalog.AddBuiltinFunctions(BuiltinFunctionOptions::AllReleasedFunctions());
+  catalog.AddTable(sales.Name(), &sales);
+
+  for (const char* sql :
+       {"SELECT amount FROM Sales",
+        "SELECT COUNT(DISTINCT amount) FROM Sales",
+        "SELECT AVG(amount) FROM Sales GROUP BY store",
+        "SELECT COUNT(*) FROM Sales a JOIN Sales b USING (store)"}) {
+    PreparedQuery query(sql, EvaluatorOptions());
+    ZETASQL_ASSERT_OK(query.Prepare(AnalyzerOptions(), &catalog));
+    IncrementalQueryState state;
+    EXPECT_THAT(query.ExecuteIncrementallyAfterPrepare(&sales, &state),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("cannot be executed incrementally")))
+        << sql;
+  }
+}
+
 TEST(PreparedQuery, OutputIsValueTable) {
   PreparedQuery query("select as value 1 a", EvaluatorOptions());
   ZETASQL_EXPECT_OK(query.Prepare(AnalyzerOptions()));
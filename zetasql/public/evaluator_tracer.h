@@ -0,0 +1,79 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// API for observing where the ZetaSQL Evaluator (see evaluator.h) spends its
+// time, e.g., to export spans and metrics to a tracing system or profiler.
+
+#ifndef ZETASQL_PUBLIC_EVALUATOR_TRACER_H_
+#define ZETASQL_PUBLIC_EVALUATOR_TRACER_H_
+
+#include <cstdint>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+
+namespace zetasql {
+
+// Receives the events of the evaluations that it is passed to (see
+// EvaluatorOptions::tracer). Without a tracer, the only cost of these hooks is
+// a pointer check per operator iterator and per function call.
+//
+// The relational operators of an evaluation are identified by an opaque
+// 'operator_id', which is stable for the lifetime of the prepared statement,
+// and a human-readable 'operator_name' like "SortOp". Operators that are
+// re-evaluated, like the right side of a correlated join, create an iterator
+// each time.
+//
+// All methods may be called concurrently from the threads of one evaluation
+// (see EvaluatorOptions::num_threads), and from concurrent evaluations, so
+// implementations must be thread-safe. They are called on the hot path of the
+// evaluation and should return quickly.
+class EvaluatorTracer {
+ public:
+  virtual ~EvaluatorTracer() = default;
+
+  // Called before and after an operator creates an iterator. The time between
+  // the calls includes the work that the operator does up front, like
+  // building the hash table of a join or sorting its input. 'status' is the
+  // error if creating the iterator failed.
+  virtual void BeginCreateIterator(const void* operator_id,
+                                   absl::string_view operator_name) {}
+  virtual void EndCreateIterator(const void* operator_id,
+                                 absl::string_view operator_name,
+                                 const absl::Status& status) {}
+
+  // The number of rows an iterator returns between calls to SampleRows().
+  virtual int64_t row_sample_interval() const { return 1024; }
+
+  // Called every row_sample_interval() rows returned by an iterator of the
+  // operator, and once more when the iterator is destroyed, with the number of
+  // rows that the iterator has returned so far.
+  virtual void SampleRows(const void* operator_id,
+                          absl::string_view operator_name, int64_t num_rows) {
+  }
+
+  // Called when an evaluation completes, once for each scalar function that
+  // it called, e.g., "Add" or "Concat", with the number of calls and their
+  // total wall time. The time excludes evaluating the arguments of the calls.
+  virtual void RecordFunctionCalls(absl::string_view function_name,
+                                   int64_t num_calls,
+                                   absl::Duration wall_time) {}
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_EVALUATOR_TRACER_H_
@@ -48,6 +48,9 @@ FormatterOptions::FormatterOptions(const FormatterOptionsProto& proto)
   if (proto.has_enforce_single_quotes()) {
     enforce_single_quotes_ = proto.enforce_single_quotes();
   }
+  if (proto.has_num_threads()) {
+    num_threads_ = proto.num_threads();
+  }
 }
 
 }  // namespace zetasql
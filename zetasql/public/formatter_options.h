@@ -41,7 +41,8 @@ class FormatterOptions {
         capitalize_keywords_(true),
         preserve_line_breaks_(false),
         expand_format_ranges_(false),
-        enforce_single_quotes_(false) {}
+        enforce_single_quotes_(false),
+        num_threads_(1) {}
 
   // Creates options overwriting defaults using the given proto. Not set fields
   // in the proto are ignored.
@@ -110,6 +111,12 @@ class FormatterOptions {
   }
   bool IsEnforcingSingleQuotes() const { return enforce_single_quotes_; }
 
+  // The number of threads used to lay out the statements of the input, which
+  // are formatted independently of each other. Values <= 1 format all
+  // statements on the calling thread. The output does not depend on it.
+  void SetNumThreads(int num_threads) { num_threads_ = num_threads; }
+  int NumThreads() const { return num_threads_; }
+
  private:
   std::string new_line_type_;
   int line_length_limit_;
@@ -120,6 +127,7 @@ class FormatterOptions {
   bool preserve_line_breaks_;
   bool expand_format_ranges_;
   bool enforce_single_quotes_;
+  int num_threads_;
 };
 
 // Represents a range in the input to be formatted. The range may be in byte
@@ -23,7 +23,9 @@
 #include <limits>
 #include <memory>
 #include <string>
+#include <utility>
 #include <variant>
+#include <vector>
 
 #include "zetasql/base/logging.h"
 #include "zetasql/common/errors.h"
@@ -34,6 +36,9 @@
 #include "zetasql/public/interval_value.h"
 #include "zetasql/public/time_zone_util.h"
 #include "zetasql/public/types/timestamp_util.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
 #include "absl/numeric/int128.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -43,6 +48,7 @@
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/strip.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/civil_time.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
@@ -80,8 +86,36 @@ enum NewOrLegacyTimestampType {
 
 const absl::CivilDay kEpochDay = absl::CivilDay(1970, 1, 1);
 
+// Converts days since 1970-01-01 to a proleptic Gregorian year, month and day
+// in constant time with integer arithmetic, where adding the days to an
+// absl::CivilDay normalizes them year by year. This is the civil_from_days()
+// algorithm of http://howardhinnant.github.io/date_algorithms.html, which
+// counts from 0000-03-01 so that leap days fall at the end of the year.
+void EpochDaysToYearMonthDay(int64_t days_since_epoch, int64_t* year,
+                             int* month, int* day) {
+  constexpr int64_t kDaysPer400Years = 146097;
+  const int64_t days = days_since_epoch + 719468;  // Days since 0000-03-01.
+  const int64_t era =
+      (days >= 0 ? days : days - kDaysPer400Years + 1) / kDaysPer400Years;
+  const int64_t day_of_era = days - era * kDaysPer400Years;  // [0, 146096]
+  const int64_t year_of_era = (day_of_era - day_of_era / 1460 +
+                               day_of_era / 36524 - day_of_era / 146096) /
+                              365;  // [0, 399]
+  const int64_t day_of_year =
+      day_of_era -
+      (365 * year_of_era + year_of_era / 4 - year_of_era / 100);  // [0, 365]
+  const int64_t month_from_march = (5 * day_of_year + 2) / 153;    // [0, 11]
+  *day = static_cast<int>(day_of_year - (153 * month_from_march + 2) / 5 + 1);
+  *month = static_cast<int>(month_from_march < 10 ? month_from_march + 3
+                                                  : month_from_march - 9);
+  *year = year_of_era + era * 400 + (*month <= 2 ? 1 : 0);
+}
+
 absl::CivilDay EpochDaysToCivilDay(int32_t days_since_epoch) {
-  return kEpochDay + days_since_epoch;
+  int64_t year;
+  int month, day;
+  EpochDaysToYearMonthDay(days_since_epoch, &year, &month, &day);
+  return absl::CivilDay(year, month, day);
 }
 
 int DaysPerMonth(int year, int month) {
@@ -1334,8 +1368,7 @@ static absl::Status TruncateDateImpl(int32_t date, DateTimestampPart part,
       break;
     }
     case MONTH: {
-      *output = CivilDayToEpochDays(
-          absl::CivilDay(civil_day.year(), civil_day.month(), 1));
+      *output = date - (civil_day.day() - 1);
       break;
     }
     case QUARTER: {
@@ -1599,6 +1632,62 @@ static absl::Status TimestampTruncAtLeastMinute(absl::Time timestamp,
   return absl::OkStatus();
 }
 
+// Truncates 'timestamp' in UTC to a 'part' of at least a minute. UTC has no
+// offset changes and no leap seconds, so minutes, hours and days are plain
+// multiples of the timestamp unit and truncating to them is a floor division;
+// longer parts truncate the day number with TruncateDateImpl(). Returns false
+// if 'part' is not supported or the result is out of range, in which case the
+// caller falls back to TimestampTruncAtLeastMinute() to produce the error.
+static bool TimestampTruncUtc(int64_t timestamp, TimestampScale scale,
+                              DateTimestampPart part, int64_t* output) {
+  const int64_t units_per_second = powers_of_ten[scale];
+  int64_t units_per_part;
+  switch (part) {
+    case MINUTE:
+      units_per_part = kNaiveNumSecondsPerMinute * units_per_second;
+      break;
+    case HOUR:
+      units_per_part = kNaiveNumSecondsPerHour * units_per_second;
+      break;
+    case DAY:
+    case WEEK:
+    case ISOWEEK:
+    case WEEK_MONDAY:
+    case WEEK_TUESDAY:
+    case WEEK_WEDNESDAY:
+    case WEEK_THURSDAY:
+    case WEEK_FRIDAY:
+    case WEEK_SATURDAY:
+    case MONTH:
+    case QUARTER:
+    case YEAR:
+    case ISOYEAR:
+      units_per_part = kNaiveNumSecondsPerDay * units_per_second;
+      break;
+    default:
+      return false;
+  }
+  int64_t truncated = timestamp / units_per_part;
+  if (timestamp < 0 && timestamp % units_per_part != 0) {
+    truncated -= 1;
+  }
+  if (part != MINUTE && part != HOUR && part != DAY) {
+    const int64_t date = truncated;
+    int32_t truncated_date;
+    if (date < std::numeric_limits<int32_t>::lowest() ||
+        date > std::numeric_limits<int32_t>::max() ||
+        !TruncateDateImpl(static_cast<int32_t>(date), part,
+                          /*enforce_range=*/true, &truncated_date)
+             .ok()) {
+      return false;
+    }
+    truncated = truncated_date;
+  }
+  // Truncating to a week can underflow the valid range.
+  return Multiply<int64_t>(truncated, units_per_part, output, kNoError) &&
+         IsValidTimestamp(*output, scale);
+}
+
 static absl::Status TimestampTruncImpl(int64_t timestamp, TimestampScale scale,
                                        NewOrLegacyTimestampType timestamp_type,
                                        absl::TimeZone timezone,
@@ -1713,6 +1802,10 @@ static absl::Status TimestampTruncImpl(int64_t timestamp, TimestampScale scale,
       }
       break;
   }
+  if (timezone == absl::UTCTimeZone() &&
+      TimestampTruncUtc(timestamp, scale, part, output)) {
+    return absl::OkStatus();
+  }
   const absl::Time base_time = MakeTime(timestamp, scale);
   absl::Time output_base_time;
   ZETASQL_RETURN_IF_ERROR(TimestampTruncAtLeastMinute(base_time, scale, timezone, part,
@@ -2151,6 +2244,134 @@ absl::Status FormatTimeToString(absl::string_view format_string,
   return absl::OkStatus();
 }
 
+// static
+std::unique_ptr<const DateTimeFormatPlan> DateTimeFormatPlan::Compile(
+    absl::string_view format_string) {
+  std::vector<Element> elements;
+  bool has_time_directives = false;
+  auto add_literal = [&elements](absl::string_view literal) {
+    if (elements.empty() || !std::holds_alternative<std::string>(
+                                elements.back())) {
+      elements.emplace_back(std::string());
+    }
+    absl::StrAppend(&std::get<std::string>(elements.back()), literal);
+  };
+  for (size_t i = 0; i < format_string.size(); ++i) {
+    if (format_string[i] != '%') {
+      add_literal(format_string.substr(i, 1));
+      continue;
+    }
+    if (++i == format_string.size()) return nullptr;
+    switch (format_string[i]) {
+      case 'Y':
+        elements.emplace_back(Directive::kYear);
+        break;
+      case 'm':
+        elements.emplace_back(Directive::kMonth);
+        break;
+      case 'd':
+        elements.emplace_back(Directive::kDay);
+        break;
+      case 'F':
+        elements.emplace_back(Directive::kYear);
+        add_literal("-");
+        elements.emplace_back(Directive::kMonth);
+        add_literal("-");
+        elements.emplace_back(Directive::kDay);
+        break;
+      case 'H':
+        elements.emplace_back(Directive::kHour);
+        has_time_directives = true;
+        break;
+      case 'M':
+        elements.emplace_back(Directive::kMinute);
+        has_time_directives = true;
+        break;
+      case 'S':
+        elements.emplace_back(Directive::kSecond);
+        has_time_directives = true;
+        break;
+      case 'T':
+        elements.emplace_back(Directive::kHour);
+        add_literal(":");
+        elements.emplace_back(Directive::kMinute);
+        add_literal(":");
+        elements.emplace_back(Directive::kSecond);
+        has_time_directives = true;
+        break;
+      case '%':
+        add_literal("%");
+        break;
+      default:
+        return nullptr;
+    }
+  }
+  auto plan = absl::WrapUnique(new DateTimeFormatPlan(std::move(elements)));
+  plan->has_time_directives_ = has_time_directives;
+  return plan;
+}
+
+bool DateTimeFormatPlan::Format(absl::CivilSecond civil_second,
+                                std::string* out) const {
+  // absl::FormatTime() does not pad %Y, so only years with 4 digits have a
+  // fixed width.
+  if (civil_second.year() < 1000 || civil_second.year() > 9999) return false;
+  out->clear();
+  for (const Element& element : elements_) {
+    if (const std::string* literal = std::get_if<std::string>(&element)) {
+      out->append(*literal);
+      continue;
+    }
+    int value = 0;
+    switch (std::get<Directive>(element)) {
+      case Directive::kYear:
+        absl::StrAppend(out, civil_second.year());
+        continue;
+      case Directive::kMonth:
+        value = civil_second.month();
+        break;
+      case Directive::kDay:
+        value = civil_second.day();
+        break;
+      case Directive::kHour:
+        value = civil_second.hour();
+        break;
+      case Directive::kMinute:
+        value = civil_second.minute();
+        break;
+      case Directive::kSecond:
+        value = civil_second.second();
+        break;
+    }
+    out->push_back(static_cast<char>('0' + value / 10));
+    out->push_back(static_cast<char>('0' + value % 10));
+  }
+  return true;
+}
+
+bool DateTimeFormatPlan::FormatTimestamp(absl::Time timestamp,
+                                         absl::TimeZone timezone,
+                                         std::string* out) const {
+  if (!IsValidTime(timestamp)) return false;
+  return Format(
+      internal_functions::GetNormalizedTimeZone(timestamp, timezone)
+          .At(timestamp)
+          .cs,
+      out);
+}
+
+bool DateTimeFormatPlan::FormatDatetime(const DatetimeValue& datetime,
+                                        std::string* out) const {
+  if (!datetime.IsValid()) return false;
+  return Format(datetime.ConvertToCivilSecond(), out);
+}
+
+bool DateTimeFormatPlan::FormatDate(int32_t date, std::string* out) const {
+  // FormatDateToString() prints time elements literally.
+  if (has_time_directives_ || !IsValidDate(date)) return false;
+  return Format(absl::CivilSecond(absl::CivilDay(1970, 1, 1) + date), out);
+}
+
 absl::Status FormatTimestampToString(
     absl::string_view format_str, absl::Time timestamp, absl::TimeZone timezone,
     const FormatDateTimestampOptions& format_options, std::string* out) {
@@ -2253,6 +2474,61 @@ absl::Status ConvertTimestampToString(absl::Time input, TimestampScale scale,
   return ConvertTimestampToString(input, scale, timezone, output);
 }
 
+namespace {
+
+// The time zones that MakeTimeZone() has loaded. Functions that take a time
+// zone argument call MakeTimeZone() for every row, and both loading a time
+// zone by name and creating a fixed offset time zone go through a
+// process-wide lock and map in the time library. Fixed offsets are keyed by
+// the offset, so that all the spellings of an offset ('+5:30', '+05:30')
+// share an entry. Only valid time zones are cached, and the number of names
+// is bounded so that arbitrary strings cannot grow the cache without limit.
+class TimeZoneCache {
+ public:
+  static TimeZoneCache& Get() {
+    static TimeZoneCache* cache = new TimeZoneCache;
+    return *cache;
+  }
+
+  bool FindName(absl::string_view name, absl::TimeZone* timezone) const {
+    absl::ReaderMutexLock lock(&mutex_);
+    auto it = names_.find(name);
+    if (it == names_.end()) return false;
+    *timezone = it->second;
+    return true;
+  }
+
+  void AddName(absl::string_view name, absl::TimeZone timezone) {
+    absl::MutexLock lock(&mutex_);
+    if (names_.size() < kMaxNames) {
+      names_.try_emplace(std::string(name), timezone);
+    }
+  }
+
+  absl::TimeZone GetFixed(int64_t seconds_offset) {
+    {
+      absl::ReaderMutexLock lock(&mutex_);
+      auto it = offsets_.find(seconds_offset);
+      if (it != offsets_.end()) return it->second;
+    }
+    const absl::TimeZone timezone = absl::FixedTimeZone(seconds_offset);
+    absl::MutexLock lock(&mutex_);
+    offsets_.try_emplace(seconds_offset, timezone);
+    return timezone;
+  }
+
+ private:
+  static constexpr size_t kMaxNames = 1024;
+
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, absl::TimeZone> names_
+      ABSL_GUARDED_BY(mutex_);
+  // Valid offsets are within a day, so this is bounded as well.
+  absl::flat_hash_map<int64_t, absl::TimeZone> offsets_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace
+
 absl::Status MakeTimeZone(absl::string_view timezone_string,
                           absl::TimeZone* timezone) {
   // An empty time zone is an error.  There is no inherent default.
@@ -2272,12 +2548,18 @@ absl::Status MakeTimeZone(absl::string_view timezone_string,
                                kSeconds, &seconds_offset)) {
       return MakeEvalError() << "Invalid time zone: " << timezone_string;
     }
-    *timezone = absl::FixedTimeZone(seconds_offset);
+    *timezone = TimeZoneCache::Get().GetFixed(seconds_offset);
     return absl::OkStatus();
   }
 
   // Otherwise, try to look the time zone up from by name.
-  return FindTimeZoneByName(timezone_string, timezone);
+  TimeZoneCache& cache = TimeZoneCache::Get();
+  if (cache.FindName(timezone_string, timezone)) {
+    return absl::OkStatus();
+  }
+  ZETASQL_RETURN_IF_ERROR(FindTimeZoneByName(timezone_string, timezone));
+  cache.AddName(timezone_string, *timezone);
+  return absl::OkStatus();
 }
 
 absl::Status ConvertStringToDate(absl::string_view str, int32_t* date) {
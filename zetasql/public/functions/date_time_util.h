@@ -18,9 +18,11 @@
 #define ZETASQL_PUBLIC_FUNCTIONS_DATE_TIME_UTIL_H_
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <utility>
 #include <variant>
+#include <vector>
 
 #include "google/protobuf/timestamp.pb.h"
 #include "google/type/date.pb.h"
@@ -279,6 +281,43 @@ absl::Status FormatDateToString(
     absl::string_view format_string, int64_t date,
     const FormatDateTimestampOptions& format_options, std::string* out);
 
+// A format string for FormatTimestampToString(), FormatDatetimeToString() or
+// FormatDateToString() that is compiled once into a sequence of typed
+// directives, so that FORMAT_TIMESTAMP and friends with a constant format do
+// not interpret it again for every value. Only formats that consist of the
+// elements %Y, %m, %d, %H, %M, %S, %F, %T and %% and of other characters can
+// be compiled, which covers the common ISO 8601 layouts.
+class DateTimeFormatPlan {
+ public:
+  // Returns nullptr if <format_string> cannot be compiled.
+  static std::unique_ptr<const DateTimeFormatPlan> Compile(
+      absl::string_view format_string);
+
+  // Sets <out> to the same string as the corresponding Format*ToString()
+  // function with the compiled format string, and returns true. Returns false
+  // if the plan does not handle the value (e.g., if it is invalid, or its year
+  // does not have 4 digits, or the format has time elements for a DATE), in
+  // which case the caller must call that function instead.
+  bool FormatTimestamp(absl::Time timestamp, absl::TimeZone timezone,
+                       std::string* out) const;
+  bool FormatDatetime(const DatetimeValue& datetime, std::string* out) const;
+  bool FormatDate(int32_t date, std::string* out) const;
+
+ private:
+  enum class Directive { kYear, kMonth, kDay, kHour, kMinute, kSecond };
+
+  // Each element is a directive, or a literal string to copy to the output.
+  using Element = std::variant<Directive, std::string>;
+
+  explicit DateTimeFormatPlan(std::vector<Element> elements)
+      : elements_(std::move(elements)) {}
+
+  bool Format(absl::CivilSecond civil_second, std::string* out) const;
+
+  std::vector<Element> elements_;
+  bool has_time_directives_ = false;
+};
+
 // Populates <out> using the <format_string> as defined by absl::FormatTime() in
 // base/time.h. Returns error status if conversion fails.
 //
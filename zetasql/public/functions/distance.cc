@@ -17,6 +17,7 @@
 #include "zetasql/public/functions/distance.h"
 
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <functional>
 #include <optional>
@@ -119,6 +120,30 @@ double GetValueOrZero(const absl::flat_hash_map<IdxType, double>& map,
   return 0.0;
 }
 
+// Computes the cosine distance of two vectors from their dot product
+// <numerator> and their squared lengths.
+absl::StatusOr<Value> FinishCosineDistance(double numerator, double len_a,
+                                           double len_b) {
+  if (len_a == 0 || len_b == 0) {
+    return absl::InvalidArgumentError(
+        "Cannot compute cosine distance against zero vector");
+  }
+
+  double sqrt_len_a;
+  ZETASQL_RETURN_IF_ERROR(Apply(Sqrt<double>, len_a, &sqrt_len_a));
+  double sqrt_len_b;
+  ZETASQL_RETURN_IF_ERROR(Apply(Sqrt<double>, len_b, &sqrt_len_b));
+
+  double denominator;
+  ZETASQL_RETURN_IF_ERROR(
+      Apply(Multiply<double>, sqrt_len_a, sqrt_len_b, &denominator));
+  double result;
+  ZETASQL_RETURN_IF_ERROR(Apply(Divide<double>, numerator, denominator, &result));
+  ZETASQL_RETURN_IF_ERROR(Apply(Subtract<double>, 1.0, result, &result));
+
+  return Value::Double(result);
+}
+
 template <typename T, typename = std::enable_if_t<std::is_floating_point_v<T>>>
 absl::StatusOr<Value> ComputeCosineDistance(
     absl::FunctionRef<absl::StatusOr<std::optional<std::pair<T, T>>>()>
@@ -147,24 +172,7 @@ absl::StatusOr<Value> ComputeCosineDistance(
     ZETASQL_RETURN_IF_ERROR(Apply(Add<double>, len_b, b_square, &len_b));
   }
 
-  if (len_a == 0 || len_b == 0) {
-    return absl::InvalidArgumentError(
-        "Cannot compute cosine distance against zero vector");
-  }
-
-  double sqrt_len_a;
-  ZETASQL_RETURN_IF_ERROR(Apply(Sqrt<double>, len_a, &sqrt_len_a));
-  double sqrt_len_b;
-  ZETASQL_RETURN_IF_ERROR(Apply(Sqrt<double>, len_b, &sqrt_len_b));
-
-  double denominator;
-  ZETASQL_RETURN_IF_ERROR(
-      Apply(Multiply<double>, sqrt_len_a, sqrt_len_b, &denominator));
-  double result;
-  ZETASQL_RETURN_IF_ERROR(Apply(Divide<double>, numerator, denominator, &result));
-  ZETASQL_RETURN_IF_ERROR(Apply(Subtract<double>, 1.0, result, &result));
-
-  return Value::Double(result);
+  return FinishCosineDistance(numerator, len_a, len_b);
 }
 
 template <typename IdxType>
@@ -339,6 +347,164 @@ absl::StatusOr<Value> ComputeL2Norm(
   return Value::Double(result);
 }
 
+// The distance functions below first try to compute their result with plain
+// arithmetic over the array elements. The only errors of the Compute*
+// functions above are NULL elements and floating point overflows, which make
+// the running sums non-finite. The accumulators add up the same terms in the
+// same order, so whenever their sums stay finite they compute the same result
+// as the Compute* functions, which are only called otherwise, to report the
+// error or to propagate non-finite inputs.
+
+struct CosineDistanceAccumulator {
+  void Add(double a, double b) {
+    numerator += a * b;
+    len_a += a * a;
+    len_b += b * b;
+  }
+  bool IsFinite() const {
+    return std::isfinite(numerator) && std::isfinite(len_a) &&
+           std::isfinite(len_b);
+  }
+  absl::StatusOr<Value> Finish() const {
+    return FinishCosineDistance(numerator, len_a, len_b);
+  }
+
+  double numerator = 0;
+  double len_a = 0;
+  double len_b = 0;
+};
+
+struct EuclideanDistanceAccumulator {
+  void Add(double a, double b) {
+    const double c = a - b;
+    sum += c * c;
+  }
+  bool IsFinite() const { return std::isfinite(sum); }
+  absl::StatusOr<Value> Finish() const {
+    double result;
+    ZETASQL_RETURN_IF_ERROR(Apply(Sqrt<double>, sum, &result));
+    return Value::Double(result);
+  }
+
+  double sum = 0;
+};
+
+struct DotProductAccumulator {
+  void Add(double a, double b) { sum += a * b; }
+  bool IsFinite() const { return std::isfinite(sum); }
+  absl::StatusOr<Value> Finish() const { return Value::Double(sum); }
+
+  double sum = 0;
+};
+
+struct ManhattanDistanceAccumulator {
+  void Add(double a, double b) { sum += std::fabs(a - b); }
+  bool IsFinite() const { return std::isfinite(sum); }
+  absl::StatusOr<Value> Finish() const { return Value::Double(sum); }
+
+  double sum = 0;
+};
+
+// Adds the elements of two arrays of the same length to <accumulator>.
+// Returns false if an element is NULL or the sums are not finite.
+template <typename T, typename Accumulator>
+bool AccumulateDenseElements(const Value& vector1, const Value& vector2,
+                     Accumulator& accumulator) {
+  const std::vector<Value>& elements1 = vector1.elements();
+  const std::vector<Value>& elements2 = vector2.elements();
+  for (int i = 0; i < elements1.size(); ++i) {
+    const Value& element1 = elements1[i];
+    const Value& element2 = elements2[i];
+    if (element1.is_null() || element2.is_null()) {
+      return false;
+    }
+    accumulator.Add(static_cast<double>(element1.Get<T>()),
+                    static_cast<double>(element2.Get<T>()));
+  }
+  return accumulator.IsFinite();
+}
+
+template <typename Accumulator>
+bool AccumulateDense(const Value& vector1, const Value& vector2,
+                     Accumulator& accumulator) {
+  const Type* element_type = vector1.type()->AsArray()->element_type();
+  if (element_type->IsInt64()) {
+    return AccumulateDenseElements<int64_t>(vector1, vector2, accumulator);
+  } else if (element_type->IsFloat()) {
+    return AccumulateDenseElements<float>(vector1, vector2, accumulator);
+  } else if (element_type->IsDouble()) {
+    return AccumulateDenseElements<double>(vector1, vector2, accumulator);
+  }
+  return false;
+}
+
+// For keys that are STRINGs, the sparse elements refer to the strings in the
+// array values.
+template <typename IdxType>
+using SparseKey = std::conditional_t<std::is_same_v<IdxType, std::string>,
+                                     absl::string_view, IdxType>;
+
+// Sets <elements> to the (index, value) pairs of a sparse vector, sorted by
+// index. Returns false if any of them or their fields is NULL, or if an index
+// is repeated.
+template <typename IdxType>
+bool SortSparseInput(
+    absl::Span<const Value> input_array,
+    std::vector<std::pair<SparseKey<IdxType>, double>>& elements) {
+  elements.reserve(input_array.size());
+  for (const Value& element : input_array) {
+    if (element.is_null() || element.field(0).is_null() ||
+        element.field(1).is_null()) {
+      return false;
+    }
+    if constexpr (std::is_same_v<IdxType, std::string>) {
+      elements.emplace_back(element.field(0).string_value(),
+                            element.field(1).double_value());
+    } else {
+      elements.emplace_back(element.field(0).Get<IdxType>(),
+                            element.field(1).double_value());
+    }
+  }
+  std::sort(elements.begin(), elements.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+  return std::adjacent_find(elements.begin(), elements.end(),
+                            [](const auto& a, const auto& b) {
+                              return a.first == b.first;
+                            }) == elements.end();
+}
+
+// Adds the values of the union of the indices of two sparse vectors to
+// <accumulator>, in the order of their indices, with zero for an index that
+// only one of them has. Returns false if the input is invalid or the sums are
+// not finite.
+template <typename IdxType, typename Accumulator>
+bool AccumulateSparse(const Value& vector1, const Value& vector2,
+                      Accumulator& accumulator) {
+  std::vector<std::pair<SparseKey<IdxType>, double>> elements1;
+  std::vector<std::pair<SparseKey<IdxType>, double>> elements2;
+  if (!SortSparseInput<IdxType>(vector1.elements(), elements1) ||
+      !SortSparseInput<IdxType>(vector2.elements(), elements2)) {
+    return false;
+  }
+  auto it1 = elements1.begin();
+  auto it2 = elements2.begin();
+  while (it1 != elements1.end() || it2 != elements2.end()) {
+    if (it2 == elements2.end() ||
+        (it1 != elements1.end() && it1->first < it2->first)) {
+      accumulator.Add(it1->second, 0.0);
+      ++it1;
+    } else if (it1 == elements1.end() || it2->first < it1->first) {
+      accumulator.Add(0.0, it2->second);
+      ++it2;
+    } else {
+      accumulator.Add(it1->second, it2->second);
+      ++it1;
+      ++it2;
+    }
+  }
+  return accumulator.IsFinite();
+}
+
 }  // namespace
 
 template <typename T, typename = std::enable_if_t<std::is_floating_point_v<T> ||
@@ -392,6 +558,10 @@ absl::StatusOr<Value> CosineDistanceDense(Value vector1, Value vector2) {
         absl::Substitute("Array length mismatch: $0 and $1",
                          vector1.num_elements(), vector2.num_elements()));
   }
+  if (CosineDistanceAccumulator accumulator;
+      AccumulateDense(vector1, vector2, accumulator)) {
+    return accumulator.Finish();
+  }
   if (vector1.type()->AsArray()->element_type() == types::DoubleType()) {
     return ComputeCosineDistance<double>(
         MakeZippedArrayElementsSupplier<double>(vector1.elements(),
@@ -404,11 +574,19 @@ absl::StatusOr<Value> CosineDistanceDense(Value vector1, Value vector2) {
 
 absl::StatusOr<Value> CosineDistanceSparseInt64Key(Value vector1,
                                                    Value vector2) {
+  if (CosineDistanceAccumulator accumulator;
+      AccumulateSparse<int64_t>(vector1, vector2, accumulator)) {
+    return accumulator.Finish();
+  }
   return ComputeCosineDistanceFunctionSparse<int64_t>(vector1, vector2);
 }
 
 absl::StatusOr<Value> CosineDistanceSparseStringKey(Value vector1,
                                                     Value vector2) {
+  if (CosineDistanceAccumulator accumulator;
+      AccumulateSparse<std::string>(vector1, vector2, accumulator)) {
+    return accumulator.Finish();
+  }
   return ComputeCosineDistanceFunctionSparse<std::string>(vector1, vector2);
 }
 
@@ -419,6 +597,10 @@ absl::StatusOr<Value> EuclideanDistanceDense(Value vector1, Value vector2) {
                          vector1.num_elements(), vector2.num_elements()));
   }
 
+  if (EuclideanDistanceAccumulator accumulator;
+      AccumulateDense(vector1, vector2, accumulator)) {
+    return accumulator.Finish();
+  }
   if (vector1.type()->AsArray()->element_type() == types::DoubleType()) {
     return ComputeEuclideanDistance<double>(
         MakeZippedArrayElementsSupplier<double>(vector1.elements(),
@@ -432,11 +614,19 @@ absl::StatusOr<Value> EuclideanDistanceDense(Value vector1, Value vector2) {
 
 absl::StatusOr<Value> EuclideanDistanceSparseInt64Key(Value vector1,
                                                       Value vector2) {
+  if (EuclideanDistanceAccumulator accumulator;
+      AccumulateSparse<int64_t>(vector1, vector2, accumulator)) {
+    return accumulator.Finish();
+  }
   return ComputeEuclideanDistanceFunctionSparse<int64_t>(vector1, vector2);
 }
 
 absl::StatusOr<Value> EuclideanDistanceSparseStringKey(Value vector1,
                                                        Value vector2) {
+  if (EuclideanDistanceAccumulator accumulator;
+      AccumulateSparse<std::string>(vector1, vector2, accumulator)) {
+    return accumulator.Finish();
+  }
   return ComputeEuclideanDistanceFunctionSparse<std::string>(vector1, vector2);
 }
 
@@ -449,6 +639,10 @@ absl::StatusOr<Value> DotProduct(Value vector1, Value vector2) {
 
   const Type* element_type = vector1.type()->AsArray()->element_type();
 
+  if (DotProductAccumulator accumulator;
+      AccumulateDense(vector1, vector2, accumulator)) {
+    return accumulator.Finish();
+  }
   if (element_type->IsInt64()) {
     return ComputeDotProduct<int64_t>(MakeZippedArrayElementsSupplier<int64_t>(
         vector1.elements(), vector2.elements()));
@@ -473,6 +667,10 @@ absl::StatusOr<Value> ManhattanDistance(Value vector1, Value vector2) {
 
   const Type* element_type = vector1.type()->AsArray()->element_type();
 
+  if (ManhattanDistanceAccumulator accumulator;
+      AccumulateDense(vector1, vector2, accumulator)) {
+    return accumulator.Finish();
+  }
   if (element_type->IsInt64()) {
     return ComputeManhattanDistance<int64_t>(
         MakeZippedArrayElementsSupplier<int64_t>(vector1.elements(),
@@ -561,8 +759,7 @@ absl::StatusOr<int64_t> EditDistance(
 
   int64_t result = zetasql_base::CappedLevenshteinDistance(
       code_points0.begin(), code_points0.end(), code_points1.begin(),
-      code_points1.end(), std::equal_to<char32_t>(),
-      static_cast<int>(max_distance));
+      code_points1.end(), static_cast<int>(max_distance));
 
   return result;
 }
@@ -582,7 +779,7 @@ absl::StatusOr<int64_t> EditDistanceBytes(
   }
 
   int64_t result = zetasql_base::CappedLevenshteinDistance(
-      s0.begin(), s0.end(), s1.begin(), s1.end(), std::equal_to<char>(),
+      s0.begin(), s0.end(), s1.begin(), s1.end(),
       static_cast<int>(max_distance));
 
   return result;
@@ -44,6 +44,7 @@ namespace zetasql {
 namespace functions {
 namespace {
 
+using ::zetasql_base::testing::IsOkAndHolds;
 using ::zetasql_base::testing::StatusIs;
 
 struct Int64Value {
@@ -203,6 +204,44 @@ TEST(EuclideanDistanceTest, SparseArrayDuplicateStringKey) {
                        "Duplicate index a found in the input array"));
 }
 
+TEST(EuclideanDistanceTest, SparseArrayUnsortedKeys) {
+  std::vector<Value> args = CreateArrayPair<Int64Value>(
+      {{3, 1.0}, {1, 2.0}, {2, 3.0}}, {{2, 1.0}, {4, 2.0}});
+  EXPECT_THAT(EuclideanDistanceSparseInt64Key(args[0], args[1]),
+              IsOkAndHolds(Value::Double(std::sqrt(13.0))));
+  args = CreateArrayPair<Int64Value>({{3, 1.0}, {1, 2.0}, {3, 3.0}}, {});
+  EXPECT_THAT(EuclideanDistanceSparseInt64Key(args[0], args[1]),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "Duplicate index 3 found in the input array"));
+}
+
+TEST(DotProductTest, DenseNullElement) {
+  const Value array = MakeArray(std::vector<double>{1.0, 2.0});
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      const Value array_with_null,
+      Value::MakeArray(types::DoubleArrayType(),
+                       {Value::Double(1.0), Value::NullDouble()}));
+  EXPECT_THAT(DotProduct(array, array_with_null),
+              StatusIs(absl::StatusCode::kOutOfRange,
+                       "NULL array element in second argument"));
+  EXPECT_THAT(CosineDistanceDense(array_with_null, array),
+              StatusIs(absl::StatusCode::kOutOfRange,
+                       "NULL array element in first argument"));
+}
+
+TEST(DotProductTest, DoubleTypeOverflowAndNonFiniteInput) {
+  std::vector<Value> args = CreateArrayPair<double>({1e200, 1.0}, {1e200, 2.0});
+  EXPECT_THAT(DotProduct(args[0], args[1]),
+              StatusIs(absl::StatusCode::kOutOfRange,
+                       ::testing::HasSubstr("overflow")));
+  args = CreateArrayPair<double>({std::nan(""), 1.0}, {1.0, 2.0});
+  ZETASQL_ASSERT_OK_AND_ASSIGN(Value result, DotProduct(args[0], args[1]));
+  EXPECT_TRUE(std::isnan(result.double_value()));
+  args = CreateArrayPair<double>({INFINITY, 1.0}, {1.0, 2.0});
+  EXPECT_THAT(ManhattanDistance(args[0], args[1]),
+              IsOkAndHolds(Value::Double(INFINITY)));
+}
+
 TEST(DotProductTest, ArrayLengthMismatch) {
   std::vector<Value> args = CreateArrayPair<double>({1.0, 2.0}, {3.0});
   EXPECT_THAT(DotProduct(args[0], args[1]),
@@ -42,6 +42,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/status/statusor.h"
 #include "zetasql/base/map_util.h"
+#include "zetasql/base/status_macros.h"
 
 namespace zetasql {
 namespace functions {
@@ -103,9 +104,37 @@ struct FormatFunctionParam {
   }
 };
 
+// Implements FormatF with a StringFormatPlan, which formats `values` twice to
+// check that the plan gives the same result when it is reused.
+static absl::Status StringFormatWithPlan(absl::string_view format_string,
+                                         absl::Span<const Value> values,
+                                         ProductMode product_mode,
+                                         std::string* output, bool* is_null,
+                                         bool canonicalize_zero,
+                                         bool use_external_float32) {
+  std::vector<const Type*> types;
+  for (const Value& value : values) {
+    types.push_back(value.type());
+  }
+  ZETASQL_ASSIGN_OR_RETURN(
+      std::unique_ptr<const StringFormatPlan> plan,
+      StringFormatPlan::Create(format_string, std::move(types), product_mode,
+                               canonicalize_zero, use_external_float32));
+  const absl::Status first_status = plan->Format(values, output, is_null);
+  const std::string first_output = *output;
+  const bool first_is_null = *is_null;
+  const absl::Status status = plan->Format(values, output, is_null);
+  EXPECT_EQ(status, first_status);
+  if (status.ok()) {
+    EXPECT_EQ(*is_null, first_is_null);
+    EXPECT_EQ(*output, first_output);
+  }
+  return status;
+}
+
 std::vector<FormatFunctionParam> GetFormatFunctionParams() {
-  return {
-          FormatFunctionParam{"StringFormatUtf8", StringFormatUtf8}};
+  return {FormatFunctionParam{"StringFormatUtf8", StringFormatUtf8},
+          FormatFunctionParam{"StringFormatPlan", StringFormatWithPlan}};
 }
 
 class FormatFunctionTests
@@ -0,0 +1,494 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Measures the per-row cost of the kernels of hot scalar functions, called
+// directly as the reference implementation and engines do. Each benchmark
+// cycles through a fixed set of pseudo-random inputs, so that the branch
+// predictor and caches see a realistic mix rather than one repeated value, and
+// reports items_per_second as the number of rows processed.
+//
+// See reference_impl/function_benchmark.cc for the same functions called
+// through the reference implementation's BuiltinScalarFunctions.
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/functions/convert_string.h"
+#include "zetasql/public/functions/date_time_util.h"
+#include "zetasql/public/functions/datetime.pb.h"
+#include "zetasql/public/functions/distance.h"
+#include "zetasql/public/functions/hash.h"
+#include "zetasql/public/functions/json.h"
+#include "zetasql/public/functions/like.h"
+#include "zetasql/public/functions/parse_date_time.h"
+#include "zetasql/public/functions/regexp.h"
+#include "zetasql/public/functions/string.h"
+#include "zetasql/public/numeric_value.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/type.pb.h"
+#include "zetasql/public/value.h"
+#include "benchmark/benchmark.h"
+#include "zetasql/base/check.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+namespace functions {
+namespace {
+
+// The number of distinct inputs each benchmark cycles through.
+constexpr int kNumInputs = 1024;
+
+// Returns strings with lengths uniformly distributed in [min_length,
+// max_length] characters. If 'unicode' is true, about a quarter of the
+// characters are two or three byte UTF-8 sequences.
+std::vector<std::string> MakeStrings(int min_length, int max_length,
+                                     bool unicode) {
+  static constexpr const char* kNonAscii[] = {"é", "ß", "Ж", "中"};
+  std::mt19937 random(min_length * 31 + max_length);
+  std::vector<std::string> strings;
+  for (int i = 0; i < kNumInputs; ++i) {
+    const int length =
+        min_length + static_cast<int>(random() % (max_length - min_length + 1));
+    std::string str;
+    for (int j = 0; j < length; ++j) {
+      if (unicode && random() % 4 == 0) {
+        str.append(kNonAscii[random() % 4]);
+      } else {
+        str.push_back(static_cast<char>('A' + random() % 52));
+      }
+    }
+    strings.push_back(std::move(str));
+  }
+  return strings;
+}
+
+// Strings of words separated by spaces, some of which contain "abc".
+std::vector<std::string> MakeText() {
+  std::mt19937 random(kNumInputs);
+  std::vector<std::string> strings;
+  for (int i = 0; i < kNumInputs; ++i) {
+    std::string str;
+    const int num_words = 1 + random() % 10;
+    for (int j = 0; j < num_words; ++j) {
+      if (j > 0) str.push_back(' ');
+      const int word = random() % 100;
+      absl::StrAppend(&str, word < 10 ? "abc" : "word", word);
+    }
+    strings.push_back(std::move(str));
+  }
+  return strings;
+}
+
+void BM_SubstrWithLengthUtf8(benchmark::State& state) {
+  const std::vector<std::string> inputs =
+      MakeStrings(0, 64, /*unicode=*/state.range(0) != 0);
+  int i = 0;
+  for (auto s : state) {
+    absl::string_view out;
+    absl::Status error;
+    benchmark::DoNotOptimize(
+        SubstrWithLengthUtf8(inputs[i++ % kNumInputs], 3, 10, &out, &error));
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SubstrWithLengthUtf8)->ArgName("unicode")->Arg(0)->Arg(1);
+
+void BM_LowerUtf8(benchmark::State& state) {
+  const std::vector<std::string> inputs =
+      MakeStrings(0, 64, /*unicode=*/state.range(0) != 0);
+  int i = 0;
+  std::string out;
+  for (auto s : state) {
+    absl::Status error;
+    benchmark::DoNotOptimize(
+        LowerUtf8(inputs[i++ % kNumInputs], &out, &error));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LowerUtf8)->ArgName("unicode")->Arg(0)->Arg(1);
+
+void BM_Like(benchmark::State& state, absl::string_view pattern) {
+  const std::vector<std::string> inputs = MakeText();
+  auto matcher = LikeMatcher::Create(pattern, TYPE_STRING);
+  ZETASQL_CHECK_OK(matcher.status());
+  int i = 0;
+  for (auto s : state) {
+    benchmark::DoNotOptimize((*matcher)->Match(inputs[i++ % kNumInputs]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_CAPTURE(BM_Like, prefix, "abc%");
+BENCHMARK_CAPTURE(BM_Like, contains, "%abc%");
+BENCHMARK_CAPTURE(BM_Like, pieces, "%abc%word%");
+BENCHMARK_CAPTURE(BM_Like, underscore, "%abc_ %");
+
+void BM_RegexpContains(benchmark::State& state) {
+  const std::vector<std::string> inputs = MakeText();
+  auto regexp = MakeRegExpUtf8("abc[0-9]+");
+  ZETASQL_CHECK_OK(regexp.status());
+  int i = 0;
+  for (auto s : state) {
+    bool out;
+    absl::Status error;
+    benchmark::DoNotOptimize(
+        (*regexp)->Contains(inputs[i++ % kNumInputs], &out, &error));
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RegexpContains);
+
+void BM_RegexpExtract(benchmark::State& state) {
+  const std::vector<std::string> inputs = MakeText();
+  auto regexp = MakeRegExpUtf8("abc([0-9]+)");
+  ZETASQL_CHECK_OK(regexp.status());
+  int i = 0;
+  for (auto s : state) {
+    absl::string_view out;
+    bool is_null;
+    absl::Status error;
+    benchmark::DoNotOptimize((*regexp)->Extract(inputs[i++ % kNumInputs], &out,
+                                                &is_null, &error));
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RegexpExtract);
+
+// JSON objects with a nested array, of which the path below selects the
+// field of the second element when it exists.
+std::vector<std::string> MakeJsonDocuments() {
+  std::mt19937 random(kNumInputs);
+  std::vector<std::string> documents;
+  for (int i = 0; i < kNumInputs; ++i) {
+    std::string elements;
+    const int num_elements = random() % 5;
+    for (int j = 0; j < num_elements; ++j) {
+      absl::StrAppend(&elements, j > 0 ? "," : "", R"({"c": ")",
+                      random() % 1000, R"(", "d": [1, 2, 3]})");
+    }
+    documents.push_back(absl::StrCat(R"({"id": )", i, R"(, "a": {"b": [)",
+                                     elements, R"(]}, "e": "tail"})"));
+  }
+  return documents;
+}
+
+void BM_JsonExtract(benchmark::State& state) {
+  const std::vector<std::string> inputs = MakeJsonDocuments();
+  auto evaluator = JsonPathEvaluator::Create(
+      "$.a.b[1].c", /*sql_standard_mode=*/false,
+      /*enable_special_character_escaping_in_values=*/false,
+      /*enable_special_character_escaping_in_keys=*/false);
+  ZETASQL_CHECK_OK(evaluator.status());
+  int i = 0;
+  std::string value;
+  for (auto s : state) {
+    bool is_null;
+    ZETASQL_CHECK_OK(
+        (*evaluator)->Extract(inputs[i++ % kNumInputs], &value, &is_null));
+    benchmark::DoNotOptimize(value);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_JsonExtract);
+
+// JSON objects whose path target follows a large member that the extractor
+// has to step over: long escaped strings inside nested arrays.
+std::vector<std::string> MakeJsonDocumentsWithLargeMember() {
+  std::mt19937 random(kNumInputs);
+  std::vector<std::string> documents;
+  for (int i = 0; i < kNumInputs; ++i) {
+    std::string payload;
+    for (int j = 0; j < 100; ++j) {
+      absl::StrAppend(&payload, j > 0 ? "," : "", R"([{"s": ")",
+                      std::string(random() % 200, 'x'), R"(\n\u00e9"}, )",
+                      random() % 1000, "]");
+    }
+    documents.push_back(absl::StrCat(R"({"payload": [)", payload,
+                                     R"(], "a": {"b": )", i, "}}"));
+  }
+  return documents;
+}
+
+void BM_JsonExtractSkippingLargeMember(benchmark::State& state) {
+  const std::vector<std::string> inputs = MakeJsonDocumentsWithLargeMember();
+  auto evaluator = JsonPathEvaluator::Create(
+      "$.a.b", /*sql_standard_mode=*/false,
+      /*enable_special_character_escaping_in_values=*/false,
+      /*enable_special_character_escaping_in_keys=*/false);
+  ZETASQL_CHECK_OK(evaluator.status());
+  int i = 0;
+  std::string value;
+  for (auto s : state) {
+    bool is_null;
+    ZETASQL_CHECK_OK(
+        (*evaluator)->Extract(inputs[i++ % kNumInputs], &value, &is_null));
+    benchmark::DoNotOptimize(value);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_JsonExtractSkippingLargeMember);
+
+// Timestamps in '%Y-%m-%d %H:%M:%S' format between 1970 and 2038.
+std::vector<std::string> MakeTimestampStrings() {
+  std::mt19937 random(kNumInputs);
+  std::vector<std::string> strings;
+  for (int i = 0; i < kNumInputs; ++i) {
+    strings.push_back(absl::FormatTime(
+        "%Y-%m-%d %H:%M:%S", absl::FromUnixSeconds(random() % (1LL << 31)),
+        absl::UTCTimeZone()));
+  }
+  return strings;
+}
+
+void BM_ParseStringToTimestamp(benchmark::State& state) {
+  const std::vector<std::string> inputs = MakeTimestampStrings();
+  int i = 0;
+  for (auto s : state) {
+    int64_t timestamp;
+    ZETASQL_CHECK_OK(ParseStringToTimestamp("%Y-%m-%d %H:%M:%S",
+                                    inputs[i++ % kNumInputs],
+                                    absl::UTCTimeZone(),
+                                    /*parse_version2=*/true, &timestamp));
+    benchmark::DoNotOptimize(timestamp);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ParseStringToTimestamp);
+
+void BM_TimestampTruncUtc(benchmark::State& state) {
+  const DateTimestampPart part = static_cast<DateTimestampPart>(state.range(0));
+  std::mt19937 random(kNumInputs);
+  std::vector<int64_t> timestamps;
+  for (int i = 0; i < kNumInputs; ++i) {
+    timestamps.push_back(static_cast<int64_t>(random() % (1LL << 31)) *
+                         1000000);
+  }
+  int i = 0;
+  for (auto s : state) {
+    int64_t truncated;
+    ZETASQL_CHECK_OK(TimestampTrunc(timestamps[i++ % kNumInputs], absl::UTCTimeZone(),
+                            part, &truncated));
+    benchmark::DoNotOptimize(truncated);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TimestampTruncUtc)->Arg(HOUR)->Arg(DAY)->Arg(WEEK)->Arg(MONTH);
+
+void BM_TimestampParsePlan(benchmark::State& state) {
+  const std::vector<std::string> inputs = MakeTimestampStrings();
+  std::unique_ptr<const TimestampParsePlan> plan =
+      TimestampParsePlan::Compile("%Y-%m-%d %H:%M:%S");
+  ABSL_CHECK(plan != nullptr);
+  int i = 0;
+  for (auto s : state) {
+    absl::Time timestamp;
+    benchmark::DoNotOptimize(plan->Parse(inputs[i++ % kNumInputs],
+                                         absl::UTCTimeZone(), &timestamp));
+    benchmark::DoNotOptimize(timestamp);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TimestampParsePlan);
+
+// Decimal strings of integers with up to 18 digits, about half of them
+// negative, or with two fractional digits if 'fractional' is true.
+std::vector<std::string> MakeNumberStrings(bool fractional) {
+  std::mt19937_64 random(kNumInputs);
+  std::vector<std::string> strings;
+  for (int i = 0; i < kNumInputs; ++i) {
+    const int64_t magnitude =
+        static_cast<int64_t>(random() % 1000000000000000000ULL) >>
+        (random() % 60);
+    const int64_t value = random() % 2 == 0 ? magnitude : -magnitude;
+    strings.push_back(fractional ? absl::StrCat(value / 100, ".",
+                                                std::abs(value % 100))
+                                 : absl::StrCat(value));
+  }
+  return strings;
+}
+
+void BM_StringToInt64(benchmark::State& state) {
+  const std::vector<std::string> inputs =
+      MakeNumberStrings(/*fractional=*/false);
+  int i = 0;
+  for (auto s : state) {
+    int64_t out;
+    absl::Status error;
+    benchmark::DoNotOptimize(
+        StringToNumeric(inputs[i++ % kNumInputs], &out, &error));
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StringToInt64);
+
+void BM_StringToDouble(benchmark::State& state) {
+  const std::vector<std::string> inputs =
+      MakeNumberStrings(/*fractional=*/true);
+  int i = 0;
+  for (auto s : state) {
+    double out;
+    absl::Status error;
+    benchmark::DoNotOptimize(
+        StringToNumeric(inputs[i++ % kNumInputs], &out, &error));
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StringToDouble);
+
+void BM_Int64ToString(benchmark::State& state) {
+  const std::vector<std::string> strings =
+      MakeNumberStrings(/*fractional=*/false);
+  std::vector<int64_t> inputs;
+  for (const std::string& str : strings) {
+    int64_t value;
+    absl::Status error;
+    ABSL_CHECK(StringToNumeric(str, &value, &error));
+    inputs.push_back(value);
+  }
+  int i = 0;
+  std::string out;
+  for (auto s : state) {
+    absl::Status error;
+    benchmark::DoNotOptimize(
+        NumericToString(inputs[i++ % kNumInputs], &out, &error));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Int64ToString);
+
+std::vector<NumericValue> MakeNumericValues() {
+  std::vector<NumericValue> values;
+  for (const std::string& str : MakeNumberStrings(/*fractional=*/true)) {
+    auto value = NumericValue::FromString(str);
+    ZETASQL_CHECK_OK(value.status());
+    values.push_back(*value);
+  }
+  return values;
+}
+
+void BM_NumericAdd(benchmark::State& state) {
+  const std::vector<NumericValue> inputs = MakeNumericValues();
+  int i = 0;
+  for (auto s : state) {
+    benchmark::DoNotOptimize(inputs[i % kNumInputs].Add(
+        inputs[(i + 1) % kNumInputs]));
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NumericAdd);
+
+void BM_NumericMultiply(benchmark::State& state) {
+  const std::vector<NumericValue> inputs = MakeNumericValues();
+  int i = 0;
+  for (auto s : state) {
+    // Overflows are part of the distribution, as they are errors that engines
+    // must report.
+    benchmark::DoNotOptimize(inputs[i % kNumInputs].Multiply(
+        inputs[(i + 1) % kNumInputs]));
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NumericMultiply);
+
+void BM_NumericDivide(benchmark::State& state) {
+  const std::vector<NumericValue> inputs = MakeNumericValues();
+  int i = 0;
+  for (auto s : state) {
+    benchmark::DoNotOptimize(inputs[i % kNumInputs].Divide(
+        inputs[(i + 1) % kNumInputs]));
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NumericDivide);
+
+// ARRAY<DOUBLE> values of 'dimensions' elements.
+std::vector<Value> MakeVectors(int dimensions) {
+  std::mt19937 random(dimensions);
+  std::uniform_real_distribution<double> distribution(-1, 1);
+  std::vector<Value> vectors;
+  for (int i = 0; i < kNumInputs; ++i) {
+    std::vector<Value> elements;
+    for (int j = 0; j < dimensions; ++j) {
+      elements.push_back(values::Double(distribution(random)));
+    }
+    vectors.push_back(values::Array(types::DoubleArrayType(), elements));
+  }
+  return vectors;
+}
+
+void BM_CosineDistanceDense(benchmark::State& state) {
+  const std::vector<Value> inputs = MakeVectors(state.range(0));
+  int i = 0;
+  for (auto s : state) {
+    benchmark::DoNotOptimize(CosineDistanceDense(
+        inputs[i % kNumInputs], inputs[(i + 1) % kNumInputs]));
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CosineDistanceDense)->Range(8, 1024);
+
+void BM_EditDistance(benchmark::State& state) {
+  const std::vector<std::string> inputs =
+      MakeStrings(0, state.range(0), /*unicode=*/false);
+  int i = 0;
+  for (auto s : state) {
+    benchmark::DoNotOptimize(EditDistance(inputs[i % kNumInputs],
+                                          inputs[(i + 1) % kNumInputs],
+                                          /*max_distance=*/std::nullopt));
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EditDistance)->Range(8, 256);
+
+void BM_Hash(benchmark::State& state) {
+  const std::vector<std::string> inputs =
+      MakeStrings(state.range(1), state.range(1), /*unicode=*/false);
+  std::unique_ptr<Hasher> hasher =
+      Hasher::Create(static_cast<Hasher::Algorithm>(state.range(0)));
+  int i = 0;
+  for (auto s : state) {
+    benchmark::DoNotOptimize(hasher->Hash(inputs[i++ % kNumInputs]));
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_Hash)
+    ->ArgNames({"algorithm", "bytes"})
+    ->ArgsProduct({{Hasher::kMd5, Hasher::kSha1, Hasher::kSha256,
+                    Hasher::kSha512},
+                   {16, 256, 4096}});
+
+}  // namespace
+}  // namespace functions
+}  // namespace zetasql
@@ -169,6 +169,77 @@ absl::Status inline CheckStartEndStep(absl::Time start, absl::Time end,
   return absl::OkStatus();
 }
 
+// Produces the elements of the array from 'start' to 'end' with 'step' one at
+// a time, so that callers which only iterate over them (e.g., for UNNEST) do
+// not need to hold the whole array in memory. Unlike GenerateArray(), it does
+// not limit the number of elements.
+template <typename T>
+class ArrayGenerator {
+ public:
+  using elem_t = typename T::elem_t;
+  using step_t = typename T::step_t;
+
+  // Returns an error for the same arguments as GenerateArray().
+  static absl::StatusOr<ArrayGenerator> Create(elem_t start, elem_t end,
+                                               step_t step) {
+    const elem_t step_value = T::ExtractStep(step);
+    const elem_t zero_value = elem_t();
+
+    ZETASQL_RETURN_IF_ERROR(CheckStartEndStep(start, end, step_value));
+
+    ArrayGenerator generator(start, end, step);
+    // Empty range cases.
+    if ((start < end && step_value < zero_value) ||
+        (start > end && step_value > zero_value)) {
+      generator.done_ = true;
+    }
+    // Single element case. Handles start == end == +/-inf.
+    generator.single_element_ = start == end;
+    return generator;
+  }
+
+  // Sets '*value' to the next element and returns true, or returns false if
+  // there are no more elements.
+  bool Next(elem_t* value) {
+    if (done_) return false;
+    if (single_element_) {
+      *value = start_;
+      done_ = true;
+      return true;
+    }
+    // When start <= end, generate the range [start, end].
+    // When start > end, generate the range [end, start].
+    if (start_ <= end_ ? !(next_ <= end_) : !(next_ >= end_)) {
+      done_ = true;
+      return false;
+    }
+    *value = next_;
+    ++num_elements_;
+    absl::Status status =
+        T::GenerateNextValue(start_, next_, step_, num_elements_, &next_);
+    if (!status.ok()) {
+      // An overflow can only happen here if the generated element value would
+      // have been outside the start end range anyway.
+      done_ = true;
+    }
+    return true;
+  }
+
+ private:
+  ArrayGenerator(elem_t start, elem_t end, step_t step)
+      : start_(start), end_(end), step_(step), next_(start) {}
+
+  elem_t start_;
+  elem_t end_;
+  step_t step_;
+  // The element that Next() returns, if it is still within the range.
+  elem_t next_;
+  // The number of elements returned so far.
+  size_t num_elements_ = 0;
+  bool single_element_ = false;
+  bool done_ = false;
+};
+
 template <typename T>
 absl::Status GenerateArrayHelper(typename T::elem_t start,
                                  typename T::elem_t end,
@@ -178,40 +249,16 @@ absl::Status GenerateArrayHelper(typename T::elem_t start,
   // of generated arrays.
   static constexpr int kMaxGeneratedArraySize = 16000;
 
-  const typename T::elem_t step_value = T::ExtractStep(step);
-  const typename T::elem_t zero_value = typename T::elem_t();
-
-  ZETASQL_RETURN_IF_ERROR(CheckStartEndStep(start, end, step_value));
-
-  // Empty range cases.
-  if ((start < end && step_value < zero_value) ||
-      (start > end && step_value > zero_value)) {
-    return absl::OkStatus();
-  }
-
-  // Single element case. Handles start == end == +/-inf.
-  if (start == end) {
-    values->emplace_back(start);
-    return absl::OkStatus();
-  }
-
-  // When start <= end, generate the range [start, end].
-  // When start > end, generate the range [end, start].
-  for (typename T::elem_t val = start;
-       start <= end ? (val <= end) : (val >= end);) {
+  ZETASQL_ASSIGN_OR_RETURN(ArrayGenerator<T> generator,
+                   ArrayGenerator<T>::Create(start, end, step));
+  typename T::elem_t value;
+  while (generator.Next(&value)) {
     if (values->size() >= kMaxGeneratedArraySize) {
       return ::zetasql_base::OutOfRangeErrorBuilder()
              << "Cannot generate arrays with more than "
              << kMaxGeneratedArraySize << " elements.";
     }
-    values->emplace_back(val);
-    absl::Status status =
-        T::GenerateNextValue(start, val, step, values->size(), &val);
-    if (!status.ok()) {
-      // An overflow can only happen here if the generated element value would
-      // have been outside the start end range anyway.
-      break;
-    }
+    values->emplace_back(value);
   }
   return absl::OkStatus();
 }
@@ -221,6 +268,12 @@ absl::Status GenerateArray(T start, T end, TStep step, std::vector<T>* values) {
   return GenerateArrayHelper<ArrayGenTrait<T, TStep>>(start, end, step, values);
 }
 
+template <typename T, typename TStep>
+absl::StatusOr<ArrayGenerator<ArrayGenTrait<T, TStep>>> MakeArrayGenerator(
+    T start, T end, TStep step) {
+  return ArrayGenerator<ArrayGenTrait<T, TStep>>::Create(start, end, step);
+}
+
 }  // namespace functions
 }  // namespace zetasql
 
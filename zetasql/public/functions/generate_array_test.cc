@@ -59,6 +59,32 @@ TEST(GenerateArrayTest, TooManyElementsDouble) {
   EXPECT_THAT(status, StatusIs(absl::StatusCode::kOutOfRange));
 }
 
+TEST(GenerateArrayTest, GeneratorHasNoElementLimit) {
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto generator, (MakeArrayGenerator<int64_t, int64_t>(1, 1000000, 3)));
+  int64_t value;
+  int64_t num_values = 0;
+  int64_t last_value = 0;
+  while (generator.Next(&value)) {
+    ++num_values;
+    last_value = value;
+  }
+  EXPECT_EQ(num_values, 333334);
+  EXPECT_EQ(last_value, 999999);
+  EXPECT_FALSE(generator.Next(&value));
+
+  // Stops at the largest value instead of overflowing.
+  const int64_t max = std::numeric_limits<int64_t>::max();
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      generator, (MakeArrayGenerator<int64_t, int64_t>(max - 1, max, 1)));
+  num_values = 0;
+  while (generator.Next(&value)) ++num_values;
+  EXPECT_EQ(num_values, 2);
+
+  EXPECT_THAT((MakeArrayGenerator<int64_t, int64_t>(1, 10, 0)).status(),
+              StatusIs(absl::StatusCode::kOutOfRange));
+}
+
 TEST(GenerateArrayTest, ComplianceTests) {
   const std::vector<FunctionTestCall> tests = GetFunctionTestsGenerateArray();
   for (const auto& test : tests) {
@@ -16,6 +16,7 @@
 
 #include "zetasql/public/functions/hash.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <memory>
@@ -23,6 +24,8 @@
 
 #include "zetasql/base/logging.h"
 #include "absl/base/casts.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "openssl/md5.h"
 #include "openssl/sha.h"
 #include "zetasql/base/endian.h"
@@ -55,6 +58,22 @@ class OpenSSLHasher final : public Hasher {
     return std::string(reinterpret_cast<const char*>(digest_), sizeof(digest_));
   }
 
+  void HashBatch(absl::Span<const absl::string_view> inputs,
+                 std::string* output) final {
+    size_t offset = output->size();
+    output->resize(offset + inputs.size() * kDigestSize);
+    for (const absl::string_view input : inputs) {
+      init_f(&ctx_);
+      ABSL_CHECK_EQ(update_f(&ctx_, input.data(), input.length()), 1);
+      // The digest is written to the output directly, rather than to digest_.
+      ABSL_CHECK_EQ(
+          finalize_f(reinterpret_cast<unsigned char*>(&(*output)[offset]),
+                     &ctx_),
+          1);
+      offset += kDigestSize;
+    }
+  }
+
  private:
   // Note: Neither of these values are really state of the class, rather, they
   // are used as buffers to avoid having to allocate on every call to `Hash()`.
@@ -109,9 +128,24 @@ std::unique_ptr<Hasher> Hasher::Create(Algorithm algorithm) {
   }
 }
 
+void Hasher::HashBatch(absl::Span<const absl::string_view> inputs,
+                       std::string* output) {
+  for (const absl::string_view input : inputs) {
+    output->append(Hash(input));
+  }
+}
+
 int64_t FarmFingerprint(absl::string_view input) {
   return absl::bit_cast<int64_t>(farmhash::Fingerprint64(input));
 }
 
+void FarmFingerprintBatch(absl::Span<const absl::string_view> inputs,
+                          absl::Span<int64_t> output) {
+  ABSL_CHECK_EQ(inputs.size(), output.size());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    output[i] = absl::bit_cast<int64_t>(farmhash::Fingerprint64(inputs[i]));
+  }
+}
+
 }  // namespace functions
 }  // namespace zetasql
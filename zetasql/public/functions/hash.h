@@ -25,6 +25,7 @@
 
 #include "absl/base/attributes.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 
 namespace zetasql {
 namespace functions {
@@ -47,12 +48,26 @@ class Hasher {
   // Returns the hash of the input bytes. Calling this method concurrently
   // on the same object is not thread-safe.
   ABSL_MUST_USE_RESULT virtual std::string Hash(absl::string_view input) = 0;
+
+  // Appends the hashes of all of `inputs` to `output`, one after the other.
+  // All hashes of an algorithm have the same size, so the hash of `inputs[i]`
+  // starts at `i` times that size from the former end of `output`. This is
+  // equivalent to appending Hash() of each input, but does not allocate a
+  // string per input. Calling this method concurrently on the same object is
+  // not thread-safe.
+  virtual void HashBatch(absl::Span<const absl::string_view> inputs,
+                         std::string* output);
 };
 
 // Computes the fingerprint of the input bytes using the farmhash::Fingerprint64
 // function from the FarmHash library (https://github.com/google/farmhash).
 int64_t FarmFingerprint(absl::string_view input);
 
+// Sets `output[i]` to FarmFingerprint(`inputs[i]`) for all of `inputs`.
+// `output` must have the same size as `inputs`.
+void FarmFingerprintBatch(absl::Span<const absl::string_view> inputs,
+                          absl::Span<int64_t> output);
+
 }  // namespace functions
 }  // namespace zetasql
 
@@ -16,6 +16,7 @@
 
 #include "zetasql/public/functions/hash.h"
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
@@ -26,7 +27,9 @@
 #include "zetasql/public/value.h"
 #include "zetasql/testing/test_function.h"
 #include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/types/span.h"
 
 namespace zetasql {
 namespace functions {
@@ -81,6 +84,27 @@ TEST(HashTest, BasicCorrectness) {
   }
 }
 
+TEST(HashTest, HashBatchIsSameAsHash) {
+  const std::vector<absl::string_view> inputs = {"abc [] +-", "", "123456",
+                                                 "abc [] +-"};
+  for (const Hasher::Algorithm algorithm :
+       {Hasher::kMd5, Hasher::kSha1, Hasher::kSha256, Hasher::kSha512}) {
+    SCOPED_TRACE(absl::Substitute("Algorithm $0", algorithm));
+    const std::unique_ptr<Hasher> hasher = Hasher::Create(algorithm);
+    std::string expected = "prefix";
+    for (const absl::string_view input : inputs) {
+      expected.append(hasher->Hash(input));
+    }
+    std::string output = "prefix";
+    hasher->HashBatch(inputs, &output);
+    EXPECT_EQ(output, expected);
+
+    output = "prefix";
+    hasher->HashBatch({}, &output);
+    EXPECT_EQ(output, "prefix");
+  }
+}
+
 TEST(HashTest, ComplianceTests) {
   std::unique_ptr<Hasher> md5 = Hasher::Create(Hasher::Algorithm::kMd5);
   std::unique_ptr<Hasher> sha1 = Hasher::Create(Hasher::Algorithm::kSha1);
@@ -145,6 +169,16 @@ TEST(FingerprintTest, ComplianceTests) {
   }
 }
 
+TEST(FingerprintTest, FarmFingerprintBatchIsSameAsFarmFingerprint) {
+  const std::vector<absl::string_view> inputs = {"", "a", "abc [] +-",
+                                                 "123456"};
+  std::vector<int64_t> output(inputs.size());
+  FarmFingerprintBatch(inputs, absl::MakeSpan(output));
+  for (int i = 0; i < inputs.size(); ++i) {
+    EXPECT_EQ(output[i], FarmFingerprint(inputs[i])) << inputs[i];
+  }
+}
+
 }  // namespace
 }  // namespace functions
 }  // namespace zetasql
@@ -70,7 +70,11 @@ JsonPathEvaluator::JsonPathEvaluator(
       enable_special_character_escaping_in_values_(
           enable_special_character_escaping_in_values),
       enable_special_character_escaping_in_keys_(
-          enable_special_character_escaping_in_keys) {}
+          enable_special_character_escaping_in_keys) {
+  for (int i = 1; i < path_iterator_->Size(); ++i) {
+    path_tokens_.push_back(path_iterator_->GetToken(i));
+  }
+}
 
 // static
 absl::StatusOr<std::unique_ptr<JsonPathEvaluator>> JsonPathEvaluator::Create(
@@ -176,6 +180,72 @@ std::optional<std::string> JsonPathEvaluator::ExtractScalar(
   return optional_json->ToString();
 }
 
+// static
+absl::Status JsonPathEvaluator::ExtractMany(
+    absl::string_view json,
+    absl::Span<const JsonPathEvaluator* const> evaluators,
+    const std::vector<bool>& scalar,
+    std::vector<std::optional<std::string>>* values) {
+  ZETASQL_RET_CHECK_EQ(evaluators.size(), scalar.size());
+  std::vector<std::unique_ptr<JSONPathExtractor>> extractors;
+  std::vector<JSONPathExtractor*> extractor_ptrs;
+  extractors.reserve(evaluators.size());
+  extractor_ptrs.reserve(evaluators.size());
+  for (int i = 0; i < evaluators.size(); ++i) {
+    const JsonPathEvaluator& evaluator = *evaluators[i];
+    if (scalar[i]) {
+      extractors.push_back(
+          std::make_unique<json_internal::JSONPathExtractScalar>(
+              json, evaluator.path_iterator_.get()));
+    } else {
+      auto extractor = std::make_unique<JSONPathExtractor>(
+          json, evaluator.path_iterator_.get());
+      extractor->set_special_character_escaping(
+          evaluator.enable_special_character_escaping_in_values_);
+      extractor->set_special_character_key_escaping(
+          evaluator.enable_special_character_escaping_in_keys_);
+      extractor->set_escaping_needed_callback(
+          &evaluator.escaping_needed_callback_);
+      extractors.push_back(std::move(extractor));
+    }
+    extractor_ptrs.push_back(extractors.back().get());
+  }
+
+  json_internal::JSONPathMultiExtractor parser(json,
+                                               std::move(extractor_ptrs));
+  parser.Parse();
+
+  values->clear();
+  values->reserve(extractors.size());
+  for (int i = 0; i < extractors.size(); ++i) {
+    if (extractors[i]->StoppedDueToStackSpace()) {
+      return MakeEvalError() << "JSON parsing failed due to deeply nested "
+                                "array/struct. Maximum nesting depth is "
+                             << JSONPathExtractor::kMaxParsingDepth;
+    }
+    std::string value;
+    bool is_null;
+    if (scalar[i]) {
+      static_cast<json_internal::JSONPathExtractScalar*>(extractors[i].get())
+          ->ExtractParsed(parser.parsed(i), &value, &is_null);
+    } else {
+      extractors[i]->ExtractParsed(parser.parsed(i), &value, &is_null);
+    }
+    if (is_null) {
+      values->push_back(std::nullopt);
+    } else {
+      values->push_back(std::move(value));
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<JSONValue> JsonPathEvaluator::ParseJSONAlongPath(
+    absl::string_view json, const JSONParsingOptions& parsing_options) const {
+  return JSONValue::ParseJSONStringAlongPath(json, path_tokens_,
+                                             parsing_options);
+}
+
 absl::Status JsonPathEvaluator::ExtractArray(
     absl::string_view json, std::vector<std::string>* value, bool* is_null,
     std::optional<std::function<void(absl::Status)>> issue_warning) const {
@@ -36,6 +36,7 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 
 namespace zetasql {
 namespace functions {
@@ -154,6 +155,27 @@ class JsonPathEvaluator {
   // * json_path does not correspond to a scalar value in json.
   std::optional<std::string> ExtractScalar(JSONValueConstRef input) const;
 
+  // Like calling Extract() (or ExtractScalar() if `scalar[i]`) of each of
+  // `evaluators` on `json`, but scans `json` only once for all of them, and
+  // stops as soon as all of them have found their value. Sets `values[i]` to
+  // the value of `evaluators[i]`, or to std::nullopt if it is NULL.
+  //
+  // Error cases are the same as in Extract() and ExtractScalar().
+  static absl::Status ExtractMany(
+      absl::string_view json,
+      absl::Span<const JsonPathEvaluator* const> evaluators,
+      const std::vector<bool>& scalar,
+      std::vector<std::optional<std::string>>* values);
+
+  // Parses `json` like JSONValue::ParseJSONString(), but only materializes the
+  // values on the JSONPath provided in Create() (see
+  // JSONValue::ParseJSONStringAlongPath()). The functions above for JSON types
+  // give the same results for the returned value as for the fully parsed
+  // document, so this is a much cheaper way to evaluate them on a large JSON
+  // document that has not been parsed yet.
+  absl::StatusOr<JSONValue> ParseJSONAlongPath(
+      absl::string_view json, const JSONParsingOptions& parsing_options) const;
+
   // Extracts an array from `json` according to the JSONPath string json_path
   // provided in Create(). The value in `json` that json_path refers to should
   // be a JSON array. Then the output of the function will be in the form of an
@@ -243,6 +265,8 @@ class JsonPathEvaluator {
                     bool enable_special_character_escaping_in_values,
                     bool enable_special_character_escaping_in_keys);
   const std::unique_ptr<json_internal::ValidJSONPathIterator> path_iterator_;
+  // The tokens of 'path_iterator_' after the one for the whole document.
+  std::vector<std::string> path_tokens_;
   bool enable_special_character_escaping_in_values_ = false;
   bool enable_special_character_escaping_in_keys_ = false;
   std::function<void(absl::string_view, bool)> escaping_needed_callback_;
@@ -249,11 +249,8 @@ void JsonFromNumericOrBool(const BigNumericValue& value, std::string* output) {
 }
 
 void JsonFromString(absl::string_view value, std::string* output) {
-  // Escape and append the string (in quotes) to output. Using PROTO3 for the
-  // flags sets the escaping settings appropriately.
-  std::string json;
-  JsonEscapeString(value, &json);
-  output->append(json);
+  // Escape and append the string (in quotes) to output.
+  JsonEscapeAndAppendString(value, output);
 }
 
 void JsonFromBytes(absl::string_view value, std::string* output,
@@ -19,6 +19,7 @@
 
 #include <stdio.h>
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
@@ -261,7 +262,18 @@ class JSONPathExtractor : public zetasql::JSONParser {
   bool Extract(std::string* result, bool* is_null,
                std::optional<std::function<void(absl::Status)>> issue_warning =
                    std::nullopt) {
-    bool parse_success = zetasql::JSONParser::Parse() || stop_on_first_match_;
+    return ExtractParsed(zetasql::JSONParser::Parse(), result, is_null,
+                         issue_warning);
+  }
+
+  // Like Extract(), but for an extractor that was driven by a
+  // JSONPathMultiExtractor instead of parsing the JSON document itself.
+  // `parsed` is the result that JSONPathMultiExtractor::parsed() returns for
+  // it.
+  bool ExtractParsed(bool parsed, std::string* result, bool* is_null,
+                     std::optional<std::function<void(absl::Status)>>
+                         issue_warning = std::nullopt) {
+    bool parse_success = parsed || stop_on_first_match_;
 
     // Parse-failed OR no-match-found OR null-Value
     *is_null = !parse_success || !stop_on_first_match_ || parsed_null_result_;
@@ -278,9 +290,13 @@ class JSONPathExtractor : public zetasql::JSONParser {
   bool StoppedOnFirstMatch() { return stop_on_first_match_; }
 
   // Returns whether parsing failed due to running out of stack space.
-  bool StoppedDueToStackSpace() const { return stopped_due_to_stack_space_; }
+  bool StoppedDueToStackSpace() const {
+    return stopped_due_to_stack_space_ || SkippedValueTooDeep();
+  }
 
  protected:
+  friend class JSONPathMultiExtractor;
+
   bool BeginObject() override {
     if (!MaintainInvariantMovingDown()) {
       return false;
@@ -456,6 +472,12 @@ class JSONPathExtractor : public zetasql::JSONParser {
     } else {
       matching_token_ = (*path_iterator_ == key);
     }
+    if (!matching_token_) {
+      // Nothing in the value can match, so the callbacks for it would not
+      // change any state: skip it, with the nesting limit it would have had.
+      unmatched_value_max_depth_ = kMaxParsingDepth + 1 - curr_depth_;
+      SkipNextValue(unmatched_value_max_depth_);
+    }
   }
 
   // Escapes and appends `val` to `result_json_` based on different conditions.
@@ -549,6 +571,10 @@ class JSONPathExtractor : public zetasql::JSONParser {
   bool stopped_due_to_stack_space_ = false;
   // Whether the JSONPath points to an array.
   bool array_accepted_ = false;
+  // The nesting limit for the value of the current member or array entry if
+  // it does not match the path, or -1. Only used by JSONPathMultiExtractor,
+  // which skips a value only if no extractor needs it.
+  int unmatched_value_max_depth_ = -1;
 };
 
 //
@@ -562,8 +588,13 @@ class JSONPathExtractScalar final : public JSONPathExtractor {
       : JSONPathExtractor(json, iter) {}
 
   bool Extract(std::string* result, bool* is_null) {
-    bool parse_success =
-        zetasql::JSONParser::Parse() || accept_ || stop_on_first_match_;
+    return ExtractParsed(zetasql::JSONParser::Parse(), result, is_null);
+  }
+
+  // Like Extract(), but for an extractor that was driven by a
+  // JSONPathMultiExtractor, see JSONPathExtractor::ExtractParsed().
+  bool ExtractParsed(bool parsed, std::string* result, bool* is_null) {
+    bool parse_success = parsed || accept_ || stop_on_first_match_;
 
     // Parse-failed  OR Subtree-Node OR null-Value OR no-match-found
     *is_null = !parse_success || accept_ || parsed_null_result_ ||
@@ -598,6 +629,110 @@ class JSONPathExtractScalar final : public JSONPathExtractor {
   }
 };
 
+// Drives several JSONPath extractors over a single parse of a JSON document,
+// so that extracting many paths from the same document scans it only once.
+// Each extractor receives the same events as if it parsed the document on its
+// own, until it would have stopped its own parse, and the parse stops as soon
+// as all of them have stopped. Afterwards, the results are read with the
+// ExtractParsed() method of each extractor.
+class JSONPathMultiExtractor final : public zetasql::JSONParser {
+ public:
+  // `extractors` and the object underlying `json` must outlive this object.
+  JSONPathMultiExtractor(absl::string_view json,
+                         std::vector<JSONPathExtractor*> extractors)
+      : zetasql::JSONParser(json),
+        extractors_(std::move(extractors)),
+        active_(extractors_.size(), true),
+        num_active_(extractors_.size()) {}
+
+  bool Parse() override {
+    parse_success_ = zetasql::JSONParser::Parse();
+    if (SkippedValueTooDeep()) {
+      for (int i = 0; i < extractors_.size(); ++i) {
+        if (active_[i]) {
+          extractors_[i]->stopped_due_to_stack_space_ = true;
+        }
+      }
+    }
+    return parse_success_;
+  }
+
+  // Returns what the parse of the `i`-th extractor would have returned.
+  // Must only be called after Parse().
+  bool parsed(int i) const { return parse_success_ && active_[i]; }
+
+ protected:
+  bool BeginObject() override {
+    return Forward(&JSONPathExtractor::BeginObject);
+  }
+  bool EndObject() override { return Forward(&JSONPathExtractor::EndObject); }
+  bool BeginMember(const std::string& key) override {
+    return Forward(&JSONPathExtractor::BeginMember, key) && MaybeSkipValue();
+  }
+  bool EndMember(bool last) override {
+    return Forward(&JSONPathExtractor::EndMember, last);
+  }
+  bool BeginArray() override { return Forward(&JSONPathExtractor::BeginArray); }
+  bool EndArray() override { return Forward(&JSONPathExtractor::EndArray); }
+  bool BeginArrayEntry() override {
+    return Forward(&JSONPathExtractor::BeginArrayEntry) && MaybeSkipValue();
+  }
+  bool EndArrayEntry(bool last) override {
+    return Forward(&JSONPathExtractor::EndArrayEntry, last);
+  }
+  bool ParsedString(const std::string& str) override {
+    return Forward(&JSONPathExtractor::ParsedString, str);
+  }
+  bool ParsedNumber(absl::string_view str) override {
+    return Forward(&JSONPathExtractor::ParsedNumber, str);
+  }
+  bool ParsedBool(bool val) override {
+    return Forward(&JSONPathExtractor::ParsedBool, val);
+  }
+  bool ParsedNull() override { return Forward(&JSONPathExtractor::ParsedNull); }
+
+ private:
+  // Calls `callback` on each active extractor, deactivating the ones that
+  // stop. Returns false once no extractor is active.
+  template <typename... Params, typename... Args>
+  bool Forward(bool (JSONPathExtractor::*callback)(Params...),
+               const Args&... args) {
+    for (int i = 0; i < extractors_.size(); ++i) {
+      if (active_[i] && !(extractors_[i]->*callback)(args...)) {
+        active_[i] = false;
+        --num_active_;
+      }
+    }
+    return num_active_ > 0;
+  }
+
+  // Skips the value of the current member or array entry if it does not match
+  // the path of any active extractor. Always returns true.
+  bool MaybeSkipValue() {
+    bool skip = true;
+    int max_depth = JSONPathExtractor::kMaxParsingDepth + 1;
+    for (int i = 0; i < extractors_.size(); ++i) {
+      const int extractor_max_depth =
+          std::exchange(extractors_[i]->unmatched_value_max_depth_, -1);
+      if (!active_[i]) continue;
+      if (extractor_max_depth < 0) {
+        skip = false;
+      } else {
+        max_depth = std::min(max_depth, extractor_max_depth);
+      }
+    }
+    if (skip) {
+      SkipNextValue(max_depth);
+    }
+    return true;
+  }
+
+  const std::vector<JSONPathExtractor*> extractors_;
+  std::vector<bool> active_;
+  int num_active_;
+  bool parse_success_ = false;
+};
+
 // A JSONPath extractor that extracts array referred to by JSONPath. Similar to
 // the scalar version of JSONPath extractor, it finds the first sub-tree
 // matching the JSONPath. If it is not an array, returns null. Otherwise it
@@ -592,6 +592,48 @@ TEST(JsonTest, StringJsonCompliance) {
   }
 }
 
+TEST(JsonTest, StringJsonExtractMany) {
+  const std::vector<std::string> paths = {"$.a", "$.b", "$.b.c[1]", "$.d",
+                                          "$", "$.a.x"};
+  const std::vector<bool> scalar = {true, false, true, false, false, true};
+  std::vector<std::unique_ptr<JsonPathEvaluator>> evaluators;
+  std::vector<const JsonPathEvaluator*> evaluator_ptrs;
+  for (const std::string& path : paths) {
+    ZETASQL_ASSERT_OK_AND_ASSIGN(
+        evaluators.emplace_back(),
+        JsonPathEvaluator::Create(
+            path, /*sql_standard_mode=*/false,
+            /*enable_special_character_escaping_in_values=*/true,
+            /*enable_special_character_escaping_in_keys=*/true));
+    evaluator_ptrs.push_back(evaluators.back().get());
+  }
+
+  for (absl::string_view json :
+       {R"({"a": "x", "b": {"c": [1, 2]}, "d": null})", R"({"b": [)",
+        R"({"d": {"e": "f\"g"}, "a": 1})", "[1, 2]", ""}) {
+    SCOPED_TRACE(json);
+    std::vector<std::optional<std::string>> values;
+    ZETASQL_ASSERT_OK(JsonPathEvaluator::ExtractMany(json, evaluator_ptrs, scalar,
+                                             &values));
+    ASSERT_EQ(values.size(), paths.size());
+    for (int i = 0; i < paths.size(); ++i) {
+      SCOPED_TRACE(paths[i]);
+      std::string value;
+      bool is_null;
+      if (scalar[i]) {
+        ZETASQL_ASSERT_OK(evaluators[i]->ExtractScalar(json, &value, &is_null));
+      } else {
+        ZETASQL_ASSERT_OK(evaluators[i]->Extract(json, &value, &is_null));
+      }
+      if (is_null) {
+        EXPECT_EQ(values[i], std::nullopt);
+      } else {
+        EXPECT_THAT(values[i], Optional(value));
+      }
+    }
+  }
+}
+
 TEST(JsonTest, NativeJsonCompliance) {
   std::vector<std::vector<FunctionTestCall>> all_tests = {
       GetFunctionTestsNativeJsonQuery(), GetFunctionTestsNativeJsonExtract(),
@@ -626,19 +668,31 @@ TEST(JsonTest, NativeJsonCompliance) {
       if (evaluator_status.ok()) {
         const std::unique_ptr<JsonPathEvaluator>& evaluator =
             evaluator_status.value();
+        // The document parsed along the path must give the same results.
+        ZETASQL_ASSERT_OK_AND_ASSIGN(
+            JSONValue along_path,
+            evaluator->ParseJSONAlongPath(json.ToString(),
+                                          JSONParsingOptions()));
         if (test.function_name == "json_extract" ||
             test.function_name == "json_query") {
-          std::optional<JSONValueConstRef> result_or = evaluator->Extract(json);
-          EXPECT_EQ(test.params.result().is_null(), !result_or.has_value());
-          if (!test.params.result().is_null() && result_or.has_value()) {
-            EXPECT_THAT(result_or.value(),
-                        JsonEq(test.params.result().json_value()));
+          for (JSONValueConstRef input : {json, along_path.GetConstRef()}) {
+            std::optional<JSONValueConstRef> result_or =
+                evaluator->Extract(input);
+            EXPECT_EQ(test.params.result().is_null(), !result_or.has_value());
+            if (!test.params.result().is_null() && result_or.has_value()) {
+              EXPECT_THAT(result_or.value(),
+                          JsonEq(test.params.result().json_value()));
+            }
           }
         } else {
-          std::optional<std::string> result_or = evaluator->ExtractScalar(json);
-          EXPECT_EQ(test.params.result().is_null(), !result_or.has_value());
-          if (!test.params.result().is_null() && result_or.has_value()) {
-            EXPECT_EQ(result_or.value(), test.params.result().string_value());
+          for (JSONValueConstRef input : {json, along_path.GetConstRef()}) {
+            std::optional<std::string> result_or =
+                evaluator->ExtractScalar(input);
+            EXPECT_EQ(test.params.result().is_null(), !result_or.has_value());
+            if (!test.params.result().is_null() && result_or.has_value()) {
+              EXPECT_EQ(result_or.value(),
+                        test.params.result().string_value());
+            }
           }
         }
       } else {
@@ -16,12 +16,20 @@
 
 #include "zetasql/public/functions/like.h"
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "zetasql/base/logging.h"
+#include "zetasql/common/utf_util.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/match.h"
+#include "absl/types/span.h"
 #include "re2/re2.h"
 #include "zetasql/base/status.h"
 #include "zetasql/base/status_macros.h"
@@ -115,5 +123,156 @@ absl::Status CreateLikeRegexp(absl::string_view pattern, TypeKind type,
   return CreateLikeRegexpWithOptions(pattern, options, regexp);
 }
 
+absl::StatusOr<std::unique_ptr<const LikeMatcher>> LikeMatcher::Create(
+    absl::string_view pattern, TypeKind type) {
+  ABSL_DCHECK(type == TYPE_STRING || type == TYPE_BYTES);
+  auto matcher = absl::WrapUnique(new LikeMatcher());
+  // Splits the pattern at every run of '%'.
+  std::vector<std::string>& pieces = matcher->pieces_;
+  pieces.emplace_back();
+  bool has_underscore = false;
+  for (size_t i = 0; i < pattern.size() && !has_underscore; ++i) {
+    char c = pattern[i];
+    switch (c) {
+      case '\\':
+        if (i + 1 >= pattern.size()) {
+          return absl::Status(absl::StatusCode::kOutOfRange,
+                              "LIKE pattern ends with a backslash");
+        }
+        pieces.back().push_back(pattern[++i]);
+        break;
+      case '_':
+        has_underscore = true;
+        break;
+      case '%':
+        if (pieces.size() == 1 || !pieces.back().empty()) {
+          pieces.emplace_back();
+        }
+        break;
+      default:
+        pieces.back().push_back(c);
+    }
+  }
+  // The regexp also rejects STRING patterns that are not valid UTF-8.
+  if (has_underscore || (type == TYPE_STRING && !IsWellFormedUTF8(pattern))) {
+    pieces.clear();
+    std::unique_ptr<RE2> regexp;
+    ZETASQL_RETURN_IF_ERROR(CreateLikeRegexp(pattern, type, &regexp));
+    matcher->regexp_ = std::move(regexp);
+    return matcher;
+  }
+  matcher->has_wildcard_ = pieces.size() > 1;
+  matcher->requires_utf8_ = matcher->has_wildcard_ && type == TYPE_STRING;
+  return matcher;
+}
+
+bool LikeMatcher::Match(absl::string_view text) const {
+  if (regexp_ != nullptr) {
+    return RE2::FullMatch(text, *regexp_);
+  }
+  if (!has_wildcard_) {
+    return text == pieces_[0];
+  }
+  const std::string& first = pieces_.front();
+  const std::string& last = pieces_.back();
+  if (text.size() < first.size() + last.size() ||
+      !absl::StartsWith(text, first) || !absl::EndsWith(text, last)) {
+    return false;
+  }
+  absl::string_view middle =
+      text.substr(first.size(), text.size() - first.size() - last.size());
+  for (int i = 1; i + 1 < pieces_.size(); ++i) {
+    // Matching the leftmost occurrence of every piece leaves the most room for
+    // the following ones.
+    const size_t pos = middle.find(pieces_[i]);
+    if (pos == absl::string_view::npos) {
+      return false;
+    }
+    middle.remove_prefix(pos + pieces_[i].size());
+  }
+  return !requires_utf8_ || IsWellFormedUTF8(text);
+}
+
+bool LikeMatcher::GetContainedLiteral(absl::string_view* literal) const {
+  if (regexp_ != nullptr || pieces_.size() != 3 || !pieces_[0].empty() ||
+      !pieces_[2].empty()) {
+    return false;
+  }
+  *literal = pieces_[1];
+  return true;
+}
+
+std::unique_ptr<const LikeContainsAnyMatcher> LikeContainsAnyMatcher::Create(
+    absl::Span<const absl::string_view> literals, TypeKind type) {
+  ABSL_DCHECK(type == TYPE_STRING || type == TYPE_BYTES);
+  auto matcher = absl::WrapUnique(new LikeContainsAnyMatcher());
+  std::vector<std::array<int32_t, 256>>& transitions = matcher->transitions_;
+  std::vector<bool>& is_match = matcher->is_match_;
+  auto add_state = [&]() {
+    transitions.emplace_back().fill(-1);
+    is_match.push_back(false);
+    return static_cast<int32_t>(transitions.size() - 1);
+  };
+  add_state();
+
+  // Builds the trie of the literals.
+  for (const absl::string_view literal : literals) {
+    int32_t state = 0;
+    for (const char c : literal) {
+      const uint8_t byte = static_cast<uint8_t>(c);
+      if (transitions[state][byte] < 0) {
+        if (static_cast<int64_t>(transitions.size()) >= kMaxStates) {
+          return nullptr;
+        }
+        const int32_t next = add_state();
+        transitions[state][byte] = next;
+      }
+      state = transitions[state][byte];
+    }
+    is_match[state] = true;
+  }
+
+  // Resolves the failure links in breadth-first order, so that the failure
+  // state of every state has been resolved before the state itself.
+  std::vector<int32_t> failure(transitions.size(), 0);
+  std::deque<int32_t> queue;
+  for (int32_t& next : transitions[0]) {
+    if (next < 0) {
+      next = 0;
+    } else {
+      queue.push_back(next);
+    }
+  }
+  while (!queue.empty()) {
+    const int32_t state = queue.front();
+    queue.pop_front();
+    if (is_match[failure[state]]) {
+      is_match[state] = true;
+    }
+    for (int byte = 0; byte < 256; ++byte) {
+      const int32_t next = transitions[state][byte];
+      const int32_t failure_next = transitions[failure[state]][byte];
+      if (next < 0) {
+        transitions[state][byte] = failure_next;
+      } else {
+        failure[next] = failure_next;
+        queue.push_back(next);
+      }
+    }
+  }
+  matcher->requires_utf8_ = type == TYPE_STRING;
+  return matcher;
+}
+
+bool LikeContainsAnyMatcher::MatchAny(absl::string_view text) const {
+  bool found = is_match_[0];
+  int32_t state = 0;
+  for (size_t i = 0; i < text.size() && !found; ++i) {
+    state = transitions_[state][static_cast<uint8_t>(text[i])];
+    found = is_match_[state];
+  }
+  return found && (!requires_utf8_ || IsWellFormedUTF8(text));
+}
+
 }  // namespace functions
 }  // namespace zetasql
@@ -17,13 +17,17 @@
 #ifndef ZETASQL_PUBLIC_FUNCTIONS_LIKE_H_
 #define ZETASQL_PUBLIC_FUNCTIONS_LIKE_H_
 
+#include <array>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "zetasql/public/type.pb.h"
 #include "absl/base/attributes.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "re2/re2.h"
 #include "zetasql/base/status.h"
 
@@ -51,6 +55,81 @@ absl::Status CreateLikeRegexpWithOptions(absl::string_view pattern,
                                          const RE2::Options& options,
                                          std::unique_ptr<RE2>* regexp);
 
+// A compiled LIKE pattern. Most patterns consist only of literal characters
+// and '%', like 'abc', 'abc%', '%abc' and '%abc%', and these are matched with
+// comparisons and substring searches on their literal pieces. Patterns with
+// '_' are matched with the regexp from CreateLikeRegexp().
+//
+// Like the other objects in this file, this class is thread-compatible, and
+// its const methods are thread-safe.
+class LikeMatcher {
+ public:
+  // Returns an error if 'pattern' is not a valid LIKE pattern for 'type', which
+  // must be either TYPE_STRING or TYPE_BYTES.
+  static absl::StatusOr<std::unique_ptr<const LikeMatcher>> Create(
+      absl::string_view pattern, TypeKind type);
+
+  LikeMatcher(const LikeMatcher&) = delete;
+  LikeMatcher& operator=(const LikeMatcher&) = delete;
+
+  // Returns true if 'text' matches the pattern, like RE2::FullMatch() with the
+  // regexp from CreateLikeRegexp().
+  bool Match(absl::string_view text) const;
+
+  // Returns true if the pattern has the form '%<literal>%', and sets
+  // '*literal' (with escape characters removed) if so.
+  bool GetContainedLiteral(absl::string_view* literal) const;
+
+  // Returns the regexp used for the pattern, or NULL if it is matched without
+  // one.
+  const RE2* regexp() const { return regexp_.get(); }
+
+ private:
+  LikeMatcher() = default;
+
+  // Pieces of literal text that were separated by '%' in the pattern. If
+  // 'has_wildcard_' is false, 'pieces_' has a single element that must be
+  // equal to the text. Otherwise, the first piece must be a prefix of the
+  // text, the last piece must be a suffix, and the others must be found in
+  // between in order. For example, '%abc%' yields {"", "abc", ""}.
+  std::vector<std::string> pieces_;
+  bool has_wildcard_ = false;
+  // For TYPE_STRING, a text only matches a '%' if it is valid UTF-8, since
+  // that is what the regexp does.
+  bool requires_utf8_ = false;
+  // Only set if the pattern has a '_'.
+  std::unique_ptr<const RE2> regexp_;
+};
+
+// Matches a text against many '%<literal>%' LIKE patterns at once, with an
+// Aho-Corasick automaton over their literals, for LIKE ANY with many patterns.
+class LikeContainsAnyMatcher {
+ public:
+  // Returns NULL if the automaton for 'literals' would have more than
+  // 'kMaxStates' states. 'type' must be either TYPE_STRING or TYPE_BYTES.
+  static std::unique_ptr<const LikeContainsAnyMatcher> Create(
+      absl::Span<const absl::string_view> literals, TypeKind type);
+
+  // Bounds the memory of the automaton, which is 1KB per state.
+  static constexpr int64_t kMaxStates = 8192;
+
+  LikeContainsAnyMatcher(const LikeContainsAnyMatcher&) = delete;
+  LikeContainsAnyMatcher& operator=(const LikeContainsAnyMatcher&) = delete;
+
+  // Returns true if 'text' matches any of the patterns.
+  bool MatchAny(absl::string_view text) const;
+
+ private:
+  LikeContainsAnyMatcher() = default;
+
+  // 'transitions_[s][c]' is the state after reading byte 'c' in state 's',
+  // with the failure links already resolved. State 0 is the initial state.
+  std::vector<std::array<int32_t, 256>> transitions_;
+  // Whether a literal ends in (or has a suffix ending in) each state.
+  std::vector<bool> is_match_;
+  bool requires_utf8_ = false;
+};
+
 }  // namespace functions
 }  // namespace zetasql
 
@@ -17,9 +17,13 @@
 #include "zetasql/public/functions/like.h"
 
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "re2/re2.h"
 #include "zetasql/base/status.h"
@@ -140,6 +144,73 @@ TEST_P(LikeMatchTest, MatchTest) {
   ASSERT_TRUE(status.ok()) << status;
 
   ASSERT_EQ(params.expected_outcome, RE2::FullMatch(params.input, *re));
+
+  absl::StatusOr<std::unique_ptr<const LikeMatcher>> matcher =
+      LikeMatcher::Create(params.pattern, params.type);
+  ASSERT_TRUE(matcher.ok()) << matcher.status();
+  EXPECT_EQ(params.expected_outcome, (*matcher)->Match(params.input));
+}
+
+TEST(LikeMatcherTest, OnlyPatternsWithUnderscoreUseRegexp) {
+  for (const char* pattern : {"abc", "abc%", "%abc", "%abc%", "a%b%%c", "%",
+                              "\\_abc", ""}) {
+    std::unique_ptr<const LikeMatcher> matcher =
+        LikeMatcher::Create(pattern, TYPE_STRING).value();
+    EXPECT_EQ(matcher->regexp(), nullptr) << pattern;
+  }
+  EXPECT_NE(LikeMatcher::Create("a_c", TYPE_STRING).value()->regexp(),
+            nullptr);
+}
+
+TEST(LikeMatcherTest, WildcardRequiresValidUtf8) {
+  // As with the regexp, '%' does not match invalid UTF-8 in a STRING.
+  EXPECT_FALSE(
+      LikeMatcher::Create("a%", TYPE_STRING).value()->Match("a\xC2"));
+  EXPECT_TRUE(LikeMatcher::Create("a%", TYPE_BYTES).value()->Match("a\xC2"));
+}
+
+TEST(LikeMatcherTest, BadPatterns) {
+  EXPECT_EQ(LikeMatcher::Create("\xC2", TYPE_STRING).status().code(),
+            absl::StatusCode::kOutOfRange);
+  EXPECT_EQ(LikeMatcher::Create("abc\\", TYPE_STRING).status().code(),
+            absl::StatusCode::kOutOfRange);
+}
+
+TEST(LikeMatcherTest, GetContainedLiteral) {
+  absl::string_view literal;
+  EXPECT_TRUE(LikeMatcher::Create("%%a\\%c%", TYPE_STRING)
+                  .value()
+                  ->GetContainedLiteral(&literal));
+  EXPECT_EQ(literal, "a%c");
+  for (const char* pattern : {"abc", "abc%", "%abc", "%a%b%", "%a_c%", "%"}) {
+    EXPECT_FALSE(LikeMatcher::Create(pattern, TYPE_STRING)
+                     .value()
+                     ->GetContainedLiteral(&literal))
+        << pattern;
+  }
+}
+
+TEST(LikeContainsAnyMatcherTest, MatchAny) {
+  const std::vector<absl::string_view> literals = {"he", "she", "his", "hers"};
+  std::unique_ptr<const LikeContainsAnyMatcher> matcher =
+      LikeContainsAnyMatcher::Create(literals, TYPE_STRING);
+  ASSERT_NE(matcher, nullptr);
+  EXPECT_TRUE(matcher->MatchAny("ushers"));
+  EXPECT_TRUE(matcher->MatchAny("this"));
+  EXPECT_TRUE(matcher->MatchAny("ahishers"));
+  EXPECT_FALSE(matcher->MatchAny("hi"));
+  EXPECT_FALSE(matcher->MatchAny(""));
+  EXPECT_FALSE(matcher->MatchAny("\xC2she"));
+
+  EXPECT_TRUE(LikeContainsAnyMatcher::Create(literals, TYPE_BYTES)
+                  ->MatchAny("\xC2she"));
+  const std::vector<absl::string_view> with_empty = {"xyz", ""};
+  EXPECT_TRUE(
+      LikeContainsAnyMatcher::Create(with_empty, TYPE_STRING)->MatchAny(""));
+
+  const std::string long_literal(LikeContainsAnyMatcher::kMaxStates, 'a');
+  const std::vector<absl::string_view> too_long = {long_literal};
+  EXPECT_EQ(LikeContainsAnyMatcher::Create(too_long, TYPE_STRING), nullptr);
 }
 
 TEST(LikeTest, BadPatternUTF8) {
@@ -22,14 +22,18 @@
 #include <sys/socket.h>
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <limits>
 #include <string>
 
 #include "zetasql/public/functions/util.h"
+#include "zetasql/base/check.h"
 #include "absl/base/optimization.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "zetasql/base/net/idn.h"
 #include "zetasql/base/net/ipaddress.h"
 #include "zetasql/base/net/public_suffix.h"
@@ -39,6 +43,70 @@ namespace zetasql {
 namespace functions {
 namespace net {
 
+namespace {
+
+// Parses the canonical dotted-quad form of an IPv4 address, i.e., four
+// decimal numbers in [0, 255] without leading zeros separated by dots, into a
+// host-byte-order integer in a single pass. inet_pton() parses every input
+// that this accepts the same way. Callers fall back to it for the others,
+// e.g., for IPv6 addresses.
+bool ParseCanonicalIPv4(absl::string_view in, uint32_t* out) {
+  if (in.size() < 7 || in.size() > 15) {
+    return false;
+  }
+  const char* p = in.data();
+  const char* const end = p + in.size();
+  uint32_t result = 0;
+  for (int part = 0; part < 4; ++part) {
+    if (part > 0) {
+      if (p == end || *p != '.') {
+        return false;
+      }
+      ++p;
+    }
+    const char* const part_begin = p;
+    uint32_t value = 0;
+    while (p < end && p - part_begin < 3 && absl::ascii_isdigit(*p)) {
+      value = value * 10 + (*p - '0');
+      ++p;
+    }
+    const ptrdiff_t num_digits = p - part_begin;
+    if (num_digits == 0 || value > 255 ||
+        (num_digits > 1 && *part_begin == '0')) {
+      return false;
+    }
+    result = (result << 8) | value;
+  }
+  if (p != end) {
+    return false;
+  }
+  *out = result;
+  return true;
+}
+
+// Sets '*out' to the dotted-quad form of the host-byte-order IPv4 address
+// 'in', like IPAddress::ToString() but without creating an IPAddress.
+void FormatIPv4(uint32_t in, std::string* out) {
+  char buffer[15];
+  char* p = buffer;
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    const uint32_t value = (in >> shift) & 0xFF;
+    if (value >= 100) {
+      *p++ = static_cast<char>('0' + value / 100);
+    }
+    if (value >= 10) {
+      *p++ = static_cast<char>('0' + value / 10 % 10);
+    }
+    *p++ = static_cast<char>('0' + value % 10);
+    if (shift > 0) {
+      *p++ = '.';
+    }
+  }
+  out->assign(buffer, p - buffer);
+}
+
+}  // namespace
+
 bool FormatIP(int64_t in, std::string* out, absl::Status* error) {
   if (in < 0) {
     internal::UpdateError(
@@ -50,8 +118,7 @@ bool FormatIP(int64_t in, std::string* out, absl::Status* error) {
         error, "NET.FORMAT_IP() encountered an invalid integer IP");
     return false;
   }
-  *out = zetasql::internal::HostUInt32ToIPAddress(static_cast<uint32_t>(in))
-             .ToString();
+  FormatIPv4(static_cast<uint32_t>(in), out);
   return true;
 }
 
@@ -70,6 +137,11 @@ bool IPv4FromInt64(int64_t in, std::string* out, absl::Status* error) {
 }
 
 bool ParseIP(absl::string_view in, int64_t* out, absl::Status* error) {
+  uint32_t ipv4;
+  if (ABSL_PREDICT_TRUE(ParseCanonicalIPv4(in, &ipv4))) {
+    *out = ipv4;
+    return true;
+  }
   zetasql::internal::IPAddress addr;
   if (!zetasql::internal::StringToIPAddress(in, &addr)) {
     internal::UpdateError(
@@ -85,6 +157,17 @@ bool ParseIP(absl::string_view in, int64_t* out, absl::Status* error) {
   return true;
 }
 
+bool ParseIPBatch(absl::Span<const absl::string_view> inputs,
+                  absl::Span<int64_t> output, absl::Status* error) {
+  ABSL_DCHECK_EQ(inputs.size(), output.size());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    if (ABSL_PREDICT_FALSE(!ParseIP(inputs[i], &output[i], error))) {
+      return false;
+    }
+  }
+  return true;
+}
+
 bool IPv4ToInt64(absl::string_view in, int64_t* out, absl::Status* error) {
   uint32_t v;
   if (ABSL_PREDICT_TRUE(in.size() == sizeof(v))) {
@@ -101,6 +184,12 @@ bool IPv4ToInt64(absl::string_view in, int64_t* out, absl::Status* error) {
 
 bool FormatPackedIP(absl::string_view in, std::string* out,
                     absl::Status* error) {
+  if (in.size() == sizeof(uint32_t)) {
+    uint32_t v;
+    memcpy(&v, in.data(), sizeof(v));
+    FormatIPv4(ntohl(v), out);
+    return true;
+  }
   zetasql::internal::IPAddress addr;
   if (!zetasql::internal::PackedStringToIPAddress(in, &addr)) {
     internal::UpdateError(error, "NET.FORMAT_PACKED_IP() encountered an "
@@ -113,6 +202,12 @@ bool FormatPackedIP(absl::string_view in, std::string* out,
 }
 
 bool IPToString(absl::string_view in, std::string* out, absl::Status* error) {
+  if (in.size() == sizeof(uint32_t)) {
+    uint32_t v;
+    memcpy(&v, in.data(), sizeof(v));
+    FormatIPv4(ntohl(v), out);
+    return true;
+  }
   zetasql::internal::IPAddress addr;
   if (ABSL_PREDICT_FALSE(
           !zetasql::internal::PackedStringToIPAddress(in, &addr))) {
@@ -129,6 +224,12 @@ bool IPToString(absl::string_view in, std::string* out, absl::Status* error) {
 
 bool ParsePackedIP(absl::string_view in, std::string* out,
                    absl::Status* error) {
+  uint32_t ipv4;
+  if (ABSL_PREDICT_TRUE(ParseCanonicalIPv4(in, &ipv4))) {
+    const uint32_t v = htonl(ipv4);
+    out->assign(reinterpret_cast<const char*>(&v), sizeof(v));
+    return true;
+  }
   zetasql::internal::IPAddress addr;
   if (!zetasql::internal::StringToIPAddress(in, &addr)) {
     internal::UpdateError(
@@ -140,6 +241,12 @@ bool ParsePackedIP(absl::string_view in, std::string* out,
 }
 
 static bool InternalIPFromString(absl::string_view in, std::string* out) {
+  uint32_t ipv4;
+  if (ABSL_PREDICT_TRUE(ParseCanonicalIPv4(in, &ipv4))) {
+    const uint32_t v = htonl(ipv4);
+    out->assign(reinterpret_cast<const char*>(&v), sizeof(v));
+    return true;
+  }
   if (ABSL_PREDICT_TRUE(in.size() < INET6_ADDRSTRLEN &&
                         memchr(in.data(), '\0', in.size()) == nullptr)) {
     // inet_pton needs a NULL-terminated string, so we have to make a copy.
@@ -22,6 +22,7 @@
 
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 
 namespace zetasql {
 namespace functions {
@@ -54,6 +55,13 @@ bool IPv4FromInt64(int64_t in, std::string* out, absl::Status* error);
 // will be set to OUT_OF RANGE.
 bool ParseIP(absl::string_view in, int64_t* out, absl::Status* error);
 
+// Sets <output[i]> to the result of ParseIP(<inputs[i]>) for all of <inputs>.
+// <output> must have the same size as <inputs>. If ParseIP() fails for an
+// input, false is returned and <*error> is set like it does, and only the
+// outputs of the preceding inputs are set.
+bool ParseIPBatch(absl::Span<const absl::string_view> inputs,
+                  absl::Span<int64_t> output, absl::Status* error);
+
 // NET.IPV4_TO_INT64(Bytes) -> int64_t.
 // Takes an IPv4 address in binary representation in network-byte-order and
 // transforms it into a host-byte-order integer in the range [0, 0xFFFFFFFF].
@@ -28,6 +28,9 @@
 #include "zetasql/testing/test_function.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "re2/re2.h"
 #include "zetasql/base/status.h"
 
@@ -186,6 +189,43 @@ TEST_P(NetTest, Testlib) {
 INSTANTIATE_TEST_SUITE_P(String, NetTest,
                          testing::ValuesIn(GetFunctionTestsNet()));
 
+TEST(NetIPv4Test, FormatAndParse) {
+  for (int64_t ip : {0LL, 9LL, 10LL, 99LL, 100LL, 255LL, 0x0A00FF01LL,
+                     0x7F000001LL, 0xFFFFFFFFLL}) {
+    std::string formatted;
+    absl::Status error;
+    ASSERT_TRUE(FormatIP(ip, &formatted, &error)) << ip;
+    int64_t parsed = -1;
+    EXPECT_TRUE(ParseIP(formatted, &parsed, &error)) << formatted;
+    EXPECT_EQ(parsed, ip) << formatted;
+  }
+  std::string formatted;
+  absl::Status error;
+  ASSERT_TRUE(FormatIP(0x0A00FF01, &formatted, &error));
+  EXPECT_EQ(formatted, "10.0.255.1");
+
+  for (absl::string_view bad :
+       {"", "01.2.3.4", "256.1.1.1", "1.2.3", "1.2.3.4.", "1..2.3",
+        " 1.2.3.4", "1.2.3.4 ", "1.2.3.-4", "1234.1.1.1", "::1"}) {
+    int64_t parsed;
+    EXPECT_FALSE(ParseIP(bad, &parsed, &error)) << bad;
+  }
+}
+
+TEST(NetIPv4Test, ParseIPBatch) {
+  const std::vector<absl::string_view> inputs = {"1.2.3.4", "0.0.0.0",
+                                                 "255.255.255.255"};
+  std::vector<int64_t> output(inputs.size());
+  absl::Status error;
+  ASSERT_TRUE(ParseIPBatch(inputs, absl::MakeSpan(output), &error));
+  EXPECT_THAT(output, testing::ElementsAre(0x01020304, 0, 0xFFFFFFFF));
+
+  const std::vector<absl::string_view> bad_inputs = {"1.2.3.4", "1.2.3"};
+  output.assign(bad_inputs.size(), -1);
+  EXPECT_FALSE(ParseIPBatch(bad_inputs, absl::MakeSpan(output), &error));
+  EXPECT_EQ(output[0], 0x01020304);
+}
+
 }  // anonymous namespace
 }  // namespace net
 }  // namespace functions
@@ -22,8 +22,10 @@
 #include <cctype>
 #include <cstdint>
 #include <limits>
+#include <memory>
 #include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "zetasql/base/logging.h"
@@ -35,6 +37,8 @@
 #include "zetasql/public/strings.h"
 #include "zetasql/public/type.h"
 #include "absl/base/optimization.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/ascii.h"
 #include "absl/strings/str_format.h"
 #include "absl/time/time.h"
 #include "zetasql/base/mathutil.h"
@@ -1836,6 +1840,140 @@ absl::Status ParseStringToTimestamp(absl::string_view format_string,
                                 parse_version2, timestamp);
 }
 
+// static
+std::unique_ptr<const TimestampParsePlan> TimestampParsePlan::Compile(
+    absl::string_view format_string) {
+  std::vector<Element> elements;
+  bool seen[static_cast<int>(Directive::kLiteral)] = {};
+  auto add_directive = [&elements, &seen](Directive directive) {
+    // A repeated element would override the earlier value.
+    bool& directive_seen = seen[static_cast<int>(directive)];
+    if (directive_seen) return false;
+    directive_seen = true;
+    elements.push_back({directive});
+    return true;
+  };
+  for (size_t i = 0; i < format_string.size(); ++i) {
+    const char c = format_string[i];
+    if (c == ' ') {
+      // A run of spaces in the format matches any whitespace in the input, so
+      // the plan only accepts a single space for it.
+      if (elements.empty() ||
+          elements.back().directive != Directive::kLiteral ||
+          elements.back().literal != ' ') {
+        elements.push_back({Directive::kLiteral, ' '});
+      }
+      continue;
+    }
+    if (c != '%') {
+      if (absl::ascii_isdigit(c) || !absl::ascii_isgraph(c)) return nullptr;
+      elements.push_back({Directive::kLiteral, c});
+      continue;
+    }
+    if (++i == format_string.size()) return nullptr;
+    bool ok = true;
+    switch (format_string[i]) {
+      case 'Y':
+        ok = add_directive(Directive::kYear);
+        break;
+      case 'm':
+        ok = add_directive(Directive::kMonth);
+        break;
+      case 'd':
+        ok = add_directive(Directive::kDay);
+        break;
+      case 'H':
+        ok = add_directive(Directive::kHour);
+        break;
+      case 'M':
+        ok = add_directive(Directive::kMinute);
+        break;
+      case 'S':
+        ok = add_directive(Directive::kSecond);
+        break;
+      case 'F':
+        ok = add_directive(Directive::kYear);
+        elements.push_back({Directive::kLiteral, '-'});
+        ok = ok && add_directive(Directive::kMonth);
+        elements.push_back({Directive::kLiteral, '-'});
+        ok = ok && add_directive(Directive::kDay);
+        break;
+      case 'T':
+        ok = add_directive(Directive::kHour);
+        elements.push_back({Directive::kLiteral, ':'});
+        ok = ok && add_directive(Directive::kMinute);
+        elements.push_back({Directive::kLiteral, ':'});
+        ok = ok && add_directive(Directive::kSecond);
+        break;
+      default:
+        ok = false;
+    }
+    if (!ok) return nullptr;
+  }
+  return absl::WrapUnique(new TimestampParsePlan(std::move(elements)));
+}
+
+bool TimestampParsePlan::Parse(absl::string_view timestamp_string,
+                               absl::TimeZone timezone,
+                               absl::Time* timestamp) const {
+  // The defaults of ParseTime() for unspecified fields.
+  int year = 1970;
+  int month = 1;
+  int day = 1;
+  int hour = 0;
+  int minute = 0;
+  int second = 0;
+
+  const char* data = timestamp_string.data();
+  const char* const end_of_data = data + timestamp_string.size();
+  for (const Element& element : elements_) {
+    int width = 2;
+    int* value;
+    switch (element.directive) {
+      case Directive::kLiteral:
+        if (data == end_of_data || *data != element.literal) return false;
+        ++data;
+        continue;
+      case Directive::kYear:
+        width = 4;
+        value = &year;
+        break;
+      case Directive::kMonth:
+        value = &month;
+        break;
+      case Directive::kDay:
+        value = &day;
+        break;
+      case Directive::kHour:
+        value = &hour;
+        break;
+      case Directive::kMinute:
+        value = &minute;
+        break;
+      case Directive::kSecond:
+        value = &second;
+        break;
+    }
+    if (end_of_data - data < width) return false;
+    *value = 0;
+    for (int i = 0; i < width; ++i, ++data) {
+      if (!absl::ascii_isdigit(*data)) return false;
+      *value = *value * 10 + (*data - '0');
+    }
+  }
+  // A fifth digit of %Y would be consumed by ParseTime(), as would the
+  // leap second 60.
+  if (data != end_of_data || month < 1 || month > 12 || day < 1 || day > 31 ||
+      hour > 23 || minute > 59 || second > 59) {
+    return false;
+  }
+  const absl::TimeConversion tc = absl::ConvertDateTime(
+      year, month, day, hour, minute, second, timezone);
+  if (tc.normalized || !IsValidTime(tc.pre)) return false;
+  *timestamp = tc.pre;
+  return true;
+}
+
 absl::Status ParseStringToDate(absl::string_view format_string,
                                absl::string_view date_string,
                                bool parse_version2, int32_t* date) {
@@ -18,7 +18,10 @@
 #define ZETASQL_PUBLIC_FUNCTIONS_PARSE_DATE_TIME_H_
 
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "zetasql/public/civil_time.h"
 #include "zetasql/public/functions/date_time_util.h"
@@ -83,6 +86,49 @@ absl::Status ParseStringToTimestamp(absl::string_view format_string,
                                     absl::TimeZone default_timezone,
                                     bool parse_version2, absl::Time* timestamp);
 
+// A format string for ParseStringToTimestamp() that is compiled once into a
+// sequence of typed directives, so that PARSE_TIMESTAMP with a constant format
+// does not interpret it again for every input. Only formats that are a fixed
+// layout of the elements %Y, %m, %d, %H, %M, %S, %F and %T, spaces and other
+// separators (but not digits) can be compiled, which covers the common
+// ISO 8601 layouts such as '%Y-%m-%d %H:%M:%S' and '%FT%T'.
+class TimestampParsePlan {
+ public:
+  // Returns nullptr if <format_string> cannot be compiled.
+  static std::unique_ptr<const TimestampParsePlan> Compile(
+      absl::string_view format_string);
+
+  // Sets <timestamp> to the same value as ParseStringToTimestamp() with the
+  // compiled format string, and returns true, if <timestamp_string> matches
+  // the plan exactly: every element has its full width (e.g., 4 digits for %Y
+  // and 2 for %m), a space in the format matches a single space, and there
+  // is no other leading or trailing whitespace. Returns false for any other
+  // input, or if the result is invalid, in which case the caller must call
+  // ParseStringToTimestamp() instead, which also reports any error.
+  bool Parse(absl::string_view timestamp_string, absl::TimeZone timezone,
+             absl::Time* timestamp) const;
+
+ private:
+  enum class Directive {
+    kYear,
+    kMonth,
+    kDay,
+    kHour,
+    kMinute,
+    kSecond,
+    kLiteral,
+  };
+  struct Element {
+    Directive directive;
+    char literal = 0;  // For kLiteral.
+  };
+
+  explicit TimestampParsePlan(std::vector<Element> elements)
+      : elements_(std::move(elements)) {}
+
+  std::vector<Element> elements_;
+};
+
 // Parses an input <date_string> with the given input <format_string>,
 // and produces the appropriate date as output. Date parts that are
 // unspecified in the format are derived from '1970-01-01'.
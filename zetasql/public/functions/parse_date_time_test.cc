@@ -1875,6 +1875,100 @@ TEST(ParseFormatDateTimestampTests, ParseMeridianIndicatorTests) {
   }
 }
 
+TEST(TimestampParsePlanTests, CompiledFormats) {
+  EXPECT_NE(TimestampParsePlan::Compile("%Y-%m-%d %H:%M:%S"), nullptr);
+  EXPECT_NE(TimestampParsePlan::Compile("%FT%T"), nullptr);
+  EXPECT_NE(TimestampParsePlan::Compile("%Y%m%d"), nullptr);
+  EXPECT_NE(TimestampParsePlan::Compile(""), nullptr);
+  // Other elements, repeated elements and digits are not compiled.
+  EXPECT_EQ(TimestampParsePlan::Compile("%Y-%m-%d %H:%M:%E6S"), nullptr);
+  EXPECT_EQ(TimestampParsePlan::Compile("%F %Y"), nullptr);
+  EXPECT_EQ(TimestampParsePlan::Compile("%Y-%m-01"), nullptr);
+  EXPECT_EQ(TimestampParsePlan::Compile("%Y\t%m"), nullptr);
+  EXPECT_EQ(TimestampParsePlan::Compile("%Y%"), nullptr);
+}
+
+TEST(TimestampParsePlanTests, SameAsParseStringToTimestamp) {
+  const absl::TimeZone timezone = absl::FixedTimeZone(-8 * 60 * 60);
+  for (const char* format :
+       {"%Y-%m-%d %H:%M:%S", "%FT%T", "%Y%m%d", "%d/%m/%Y", "%H:%M", "%Y"}) {
+    std::unique_ptr<const TimestampParsePlan> plan =
+        TimestampParsePlan::Compile(format);
+    ASSERT_NE(plan, nullptr) << format;
+    for (const char* input :
+         {"2023-04-05 06:07:08", "2023-04-05T06:07:08", "20230405",
+          "05/04/2023", "06:07", "2023", "2023-4-5 6:7:8",
+          " 2023-04-05 06:07:08",
+          "2023-04-05  06:07:08", "2023-02-30 00:00:00", "2023-04-05 06:07:60",
+          "20230", "0000", "1969/12/31", ""}) {
+      SCOPED_TRACE(absl::StrCat(format, ", ", input));
+      absl::Time expected;
+      const absl::Status status = ParseStringToTimestamp(
+          format, input, timezone, /*parse_version2=*/true, &expected);
+      absl::Time timestamp;
+      if (plan->Parse(input, timezone, &timestamp)) {
+        ZETASQL_ASSERT_OK(status);
+        EXPECT_EQ(timestamp, expected);
+      }
+    }
+  }
+
+  std::unique_ptr<const TimestampParsePlan> plan =
+      TimestampParsePlan::Compile("%Y-%m-%d %H:%M:%S");
+  absl::Time timestamp;
+  EXPECT_TRUE(plan->Parse("2023-04-05 06:07:08", timezone, &timestamp));
+  EXPECT_EQ(timestamp, absl::FromCivil(absl::CivilSecond(2023, 4, 5, 6, 7, 8),
+                                       timezone));
+  // Inputs that ParseStringToTimestamp() accepts in other forms are left to
+  // it.
+  EXPECT_FALSE(plan->Parse("2023-4-5 6:7:8", timezone, &timestamp));
+  EXPECT_FALSE(plan->Parse("2023-04-05 06:07:08 ", timezone, &timestamp));
+  EXPECT_FALSE(plan->Parse("2023-04-05 06:07:60", timezone, &timestamp));
+}
+
+TEST(DateTimeFormatPlanTests, SameAsFormatToString) {
+  const absl::TimeZone timezone = absl::FixedTimeZone(5 * 60 * 60 + 30 * 60);
+  for (const char* format : {"%Y-%m-%d %H:%M:%S", "%FT%T", "%Y%m%d",
+                             "%d/%m/%Y", "100%% %H:%M", "Date: %F"}) {
+    SCOPED_TRACE(format);
+    std::unique_ptr<const DateTimeFormatPlan> plan =
+        DateTimeFormatPlan::Compile(format);
+    ASSERT_NE(plan, nullptr);
+    for (const absl::Time timestamp :
+         {absl::FromUnixSeconds(0), absl::FromUnixMicros(1680674828123456),
+          absl::FromCivil(absl::CivilSecond(1000, 1, 1), timezone),
+          absl::FromCivil(absl::CivilSecond(9999, 12, 31, 23, 59, 59),
+                          absl::UTCTimeZone())}) {
+      std::string expected;
+      std::string out;
+      ZETASQL_ASSERT_OK(FormatTimestampToString(format, timestamp, timezone,
+                                        kExpandQandJ, &expected));
+      ASSERT_TRUE(plan->FormatTimestamp(timestamp, timezone, &out));
+      EXPECT_EQ(out, expected);
+
+      const DatetimeValue datetime =
+          DatetimeValue::FromCivilSecondAndNanos(timezone.At(timestamp).cs, 0);
+      ZETASQL_ASSERT_OK(FormatDatetimeToStringWithOptions(format, datetime,
+                                                  kExpandQandJ, &expected));
+      ASSERT_TRUE(plan->FormatDatetime(datetime, &out));
+      EXPECT_EQ(out, expected);
+    }
+  }
+
+  std::unique_ptr<const DateTimeFormatPlan> plan =
+      DateTimeFormatPlan::Compile("%Y-%m-%d");
+  std::string out;
+  EXPECT_TRUE(plan->FormatDate(19452, &out));
+  EXPECT_EQ(out, "2023-04-05");
+  // Years without 4 digits are left to FormatTimestampToString().
+  EXPECT_FALSE(plan->FormatTimestamp(
+      absl::FromCivil(absl::CivilSecond(999, 1, 1), absl::UTCTimeZone()),
+      absl::UTCTimeZone(), &out));
+  // FormatDateToString() prints time elements literally.
+  EXPECT_FALSE(DateTimeFormatPlan::Compile("%F %T")->FormatDate(19452, &out));
+  EXPECT_EQ(DateTimeFormatPlan::Compile("%Y-%m-%d %Z"), nullptr);
+}
+
 }  // namespace
 }  // namespace functions
 }  // namespace zetasql
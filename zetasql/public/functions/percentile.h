@@ -160,9 +160,8 @@ class PercentileEvaluator {
       *result = *GetNthElement<sorted, Itr>(
           nonnull_values_begin, nonnull_values_end, index, num_nans, comp);
       if (right_weight > Weight()) {
-        const PercentileType right_value = *GetNthElement<sorted, Itr>(
-            nonnull_values_begin, nonnull_values_end, index + 1, num_nans,
-            comp);
+        const PercentileType right_value = *GetNextElement<sorted, Itr>(
+            nonnull_values_begin, nonnull_values_end, index, num_nans, comp);
         *result = ComputeLinearInterpolation((*result), left_weight,
                                              right_value, right_weight);
       }
@@ -261,6 +260,25 @@ class PercentileEvaluator {
     }
   }
 
+  // Returns the element that follows the <index>-th element in ascending
+  // order, after GetNthElement() has returned the latter. No element after
+  // the <index>-th one is then smaller than it, so unless it is a NaN, the
+  // next element is the minimum of the rest of the range, which is cheaper to
+  // find than selecting it again.
+  template <bool sorted, typename Itr, typename Comparator>
+  static Itr GetNextElement(Itr begin, Itr end, size_t index, size_t num_nans,
+                            Comparator& comp) {
+    if constexpr (sorted) {
+      return begin + index + 1;
+    } else {
+      if (index < num_nans) {
+        return GetNthElement<sorted, Itr>(begin, end, index + 1, num_nans,
+                                          comp);
+      }
+      return std::min_element(begin + index + 1, end, comp);
+    }
+  }
+
   template <typename T, bool sorted, typename Itr, typename Compare>
   Itr ComputePercentileDiscImpl(Itr nonnull_values_begin,
                                 Itr nonnull_values_end, size_t num_nulls,
@@ -16,11 +16,13 @@
 
 #include "zetasql/public/functions/percentile.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <deque>
 #include <limits>
 #include <string>
+#include <vector>
 
 #include "zetasql/common/string_util.h"
 #include "zetasql/base/testing/status_matchers.h"
@@ -942,6 +944,38 @@ TEST(DoublePercentileTest, ComputePercentileCont) {
   }
 }
 
+TEST(DoublePercentileTest, ComputePercentileContWithDuplicates) {
+  // Many duplicates, so that the two values to interpolate are often equal,
+  // or the same value at different positions of the unsorted input.
+  std::vector<double> values;
+  for (int i = 0; i < 1000; ++i) {
+    values.push_back((i * 7919) % 97 / 4);
+  }
+  values.push_back(kNaN);
+  std::vector<double> sorted_values = values;
+  std::sort(sorted_values.begin(), sorted_values.end() - 1);
+  std::rotate(sorted_values.begin(), sorted_values.end() - 1,
+              sorted_values.end());
+
+  for (double percentile = 0; percentile <= 1; percentile += 0.0123) {
+    SCOPED_TRACE(absl::StrCat("percentile=", percentile));
+    ZETASQL_ASSERT_OK_AND_ASSIGN(PercentileEvaluator<double> percentile_evalutor,
+                         PercentileEvaluator<double>::Create(percentile));
+    double expected;
+    ASSERT_TRUE(percentile_evalutor.ComputePercentileCont<true>(
+        sorted_values.cbegin(), sorted_values.cend(), 0, &expected));
+    std::vector<double> unsorted_values = values;
+    double result;
+    ASSERT_TRUE(percentile_evalutor.ComputePercentileCont<false>(
+        unsorted_values.begin(), unsorted_values.end(), 0, &result));
+    if (std::isnan(expected)) {
+      EXPECT_TRUE(std::isnan(result));
+    } else {
+      EXPECT_EQ(result, expected);
+    }
+  }
+}
+
 struct NumericPercentileContTestItem {
   absl::string_view expected_result;
   std::initializer_list<absl::string_view> values;
@@ -202,6 +202,13 @@ bool Utf8Trimmer::Initialize(absl::string_view to_trim, absl::Status* error) {
   }
   unicode_set_ = std::make_unique<icu::UnicodeSet>();
   has_explicit_replacement_char_ = false;
+  ascii_only_ = IsAscii(to_trim);
+  ascii_to_trim_.reset();
+  if (ascii_only_) {
+    for (const char ch : to_trim) {
+      ascii_to_trim_.set(static_cast<uint8_t>(ch));
+    }
+  }
   int32_t offset = 0;
   while (offset < str_length32) {
     UChar32 character;
@@ -256,6 +263,16 @@ bool Utf8Trimmer::TrimLeft(absl::string_view str, absl::string_view* out,
     *out = str;
     return true;
   }
+  if (ascii_only_) {
+    size_t prefix_length = 0;
+    while (prefix_length < str.size() &&
+           static_cast<uint8_t>(str[prefix_length]) < 0x80 &&
+           ascii_to_trim_[static_cast<uint8_t>(str[prefix_length])]) {
+      ++prefix_length;
+    }
+    *out = str.substr(prefix_length);
+    return true;
+  }
   if (has_explicit_replacement_char_ && !IsWellFormedUTF8(str)) {
     return internal::UpdateError(error, kBadUtf8);
   }
@@ -270,6 +287,16 @@ bool Utf8Trimmer::TrimRight(absl::string_view str, absl::string_view* out,
     *out = str;
     return true;
   }
+  if (ascii_only_) {
+    size_t suffix_start = str.size();
+    while (suffix_start > 0 &&
+           static_cast<uint8_t>(str[suffix_start - 1]) < 0x80 &&
+           ascii_to_trim_[static_cast<uint8_t>(str[suffix_start - 1])]) {
+      --suffix_start;
+    }
+    *out = str.substr(0, suffix_start);
+    return true;
+  }
   if (has_explicit_replacement_char_ && !IsWellFormedUTF8(str)) {
     return internal::UpdateError(error, kBadUtf8);
   }
@@ -411,8 +438,9 @@ bool LengthUtf8(absl::string_view str, int64_t* out, absl::Status* error) {
     return false;
   }
 
-  int utf8_length = 0;
-  int32_t offset = 0;
+  // Every byte of the ASCII prefix is a code point.
+  int32_t offset = static_cast<int32_t>(SpanAscii(str));
+  int64_t utf8_length = offset;
   while (offset < str_length32) {
     UChar32 character;
     U8_NEXT(str.data(), offset, str_length32, character);
@@ -572,12 +600,20 @@ static bool ForwardN(absl::string_view str, int32_t str_length32,
                      int64_t num_code_points, int32_t* str_offset,
                      bool* hit_end, absl::Status* error) {
   int64_t i = 0;
-  for (; i < num_code_points && *str_offset < str_length32; ++i) {
+  while (i < num_code_points && *str_offset < str_length32) {
+    // Skip as many of the remaining code points as possible that are ASCII.
+    const int32_t ascii = static_cast<int32_t>(SpanAscii(str.substr(
+        *str_offset, std::min<int64_t>(num_code_points - i,
+                                       str_length32 - *str_offset))));
+    *str_offset += ascii;
+    i += ascii;
+    if (i == num_code_points || *str_offset == str_length32) break;
     UChar32 character;
     U8_NEXT(str.data(), *str_offset, str_length32, character);
     if (character < 0) {
       return internal::UpdateError(error, kBadUtf8);
     }
+    ++i;
   }
   *hit_end = (i < num_code_points);
   return true;
@@ -591,6 +627,10 @@ static bool BackN(absl::string_view str, int64_t num_code_points,
                   int32_t* str_offset, bool* hit_start, absl::Status* error) {
   int64_t i = 0;
   for (; i<num_code_points&& * str_offset> 0; ++i) {
+    if (static_cast<uint8_t>(str[*str_offset - 1]) < 0x80) {
+      --*str_offset;
+      continue;
+    }
     UChar32 character;
     U8_PREV(str.data(), 0, *str_offset, character);
 
@@ -989,6 +1029,10 @@ bool UpperUtf8(absl::string_view str, std::string* out, absl::Status* error) {
   if (!CheckAndCastStrLength(str, &str_length32, error)) {
     return false;
   }
+  if (IsAscii(str)) {
+    // The case mapping of the root locale only changes ASCII letters.
+    return UpperBytes(str, out, error);
+  }
   out->clear();
   out->reserve(str.length());
 
@@ -1013,6 +1057,10 @@ bool LowerUtf8(absl::string_view str, std::string* out, absl::Status* error) {
   if (!CheckAndCastStrLength(str, &str_length32, error)) {
     return false;
   }
+  if (IsAscii(str)) {
+    // The case mapping of the root locale only changes ASCII letters.
+    return LowerBytes(str, out, error);
+  }
   out->clear();
   out->reserve(str.length());
 
@@ -164,6 +164,11 @@ class Utf8Trimmer {
   // ill-formed).  We do this conditionally, as it is more expensive, since
   // it requires two passes over the input.
   bool has_explicit_replacement_char_ = false;
+  // If all the characters to trim are ASCII, they are also in this set, and
+  // the input is trimmed byte by byte as long as it is ASCII, since no other
+  // character (nor any ill-formed sequence) can be trimmed.
+  bool ascii_only_ = false;
+  std::bitset<128> ascii_to_trim_;
 };
 
 // This class allows for a more efficient implementation of TRIM(), LTRIM()
@@ -38,12 +38,14 @@
 #include "absl/base/optimization.h"
 #include "absl/flags/flag.h"
 #include "absl/memory/memory.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/match.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "unicode/utf8.h"
@@ -1675,31 +1677,36 @@ AbslFormatConvert(const FormatGsqlNumeric<NumericType, GROUPING>& value,
 
 }  // namespace string_format_internal
 
+// Returns a DynamicMessageFactory for formatting values of `types` if they
+// may need one, or nullptr.
+static std::unique_ptr<google::protobuf::DynamicMessageFactory>
+MaybeMakeProtoFactory(absl::Span<const Type* const> types) {
+  for (const Type* type : types) {
+    const Type* t = type->IsArray() ? type->AsArray()->element_type() : type;
+
+    if (t->IsProto() || t->IsStruct()) {
+      // A struct may contain a proto (transitively). It's probably cheaper
+      // to just make the factory instead of searching the struct for
+      // a proto type.
+      return std::make_unique<google::protobuf::DynamicMessageFactory>();
+    }
+  }
+  return nullptr;
+}
+
 absl::Status StringFormatUtf8(absl::string_view format_string,
                               absl::Span<const Value> values,
                               ProductMode product_mode, std::string* output,
                               bool* is_null, bool canonicalize_zero,
                               bool use_external_float32) {
-  bool maybe_need_proto_factory = false;
   std::vector<const Type*> types;
+  types.reserve(values.size());
   for (const Value& value : values) {
     types.push_back(value.type());
-    const Type* t = value.type()->IsArray()
-                        ? value.type()->AsArray()->element_type()
-                        : value.type();
-
-    if (t->IsProto() || t->IsStruct()) {
-      // A struct may contain a proto (transitively). It's probably cheaper
-      // to just make the factory instead of searching the struct for
-      // a proto type.
-      maybe_need_proto_factory = true;
-    }
   }
 
-  std::unique_ptr<google::protobuf::DynamicMessageFactory> factory;
-  if (maybe_need_proto_factory) {
-    factory = std::make_unique<google::protobuf::DynamicMessageFactory>();
-  }
+  std::unique_ptr<google::protobuf::DynamicMessageFactory> factory =
+      MaybeMakeProtoFactory(types);
   string_format_internal::StringFormatEvaluator evaluator(
       product_mode, canonicalize_zero, use_external_float32);
   ZETASQL_RETURN_IF_ERROR(evaluator.SetTypes(std::move(types), factory.get()));
@@ -1717,5 +1724,28 @@ absl::Status CheckStringFormatUtf8ArgumentTypes(absl::string_view format_string,
   return evaluator.SetPattern(format_string);
 }
 
+absl::StatusOr<std::unique_ptr<const StringFormatPlan>>
+StringFormatPlan::Create(absl::string_view format_string,
+                         std::vector<const Type*> types,
+                         ProductMode product_mode, bool canonicalize_zero,
+                         bool use_external_float32) {
+  std::unique_ptr<google::protobuf::DynamicMessageFactory> factory =
+      MaybeMakeProtoFactory(types);
+  auto evaluator =
+      std::make_unique<string_format_internal::StringFormatEvaluator>(
+          product_mode, canonicalize_zero, use_external_float32);
+  ZETASQL_RETURN_IF_ERROR(evaluator->SetTypes(std::move(types), factory.get()));
+  ZETASQL_RETURN_IF_ERROR(evaluator->SetPattern(format_string));
+  return absl::WrapUnique(
+      new StringFormatPlan(std::move(factory), std::move(evaluator)));
+}
+
+absl::Status StringFormatPlan::Format(absl::Span<const Value> values,
+                                      std::string* output,
+                                      bool* is_null) const {
+  absl::MutexLock lock(&mutex_);
+  return evaluator_->Format(values, output, is_null);
+}
+
 }  // namespace functions
 }  // namespace zetasql
@@ -22,16 +22,21 @@
 #include <memory>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "google/protobuf/descriptor.h"
+#include "google/protobuf/dynamic_message.h"
 #include "google/protobuf/message.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/value.h"
+#include "absl/base/thread_annotations.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 
 namespace zetasql {
@@ -341,6 +346,41 @@ absl::Status CheckStringFormatUtf8ArgumentTypes(absl::string_view format_string,
                                                 std::vector<const Type*> types,
                                                 ProductMode product_mode);
 
+// A FORMAT pattern that has been parsed and type checked against the types of
+// its arguments once, e.g. because the format string is a constant, so that
+// it can format many rows without doing that again. Format() returns the same
+// results as StringFormatUtf8() with the same arguments. This class is
+// thread-safe.
+class StringFormatPlan {
+ public:
+  // Returns an error for the same `format_string` and `types` for which
+  // StringFormatUtf8() would return an error before looking at the values.
+  static absl::StatusOr<std::unique_ptr<const StringFormatPlan>> Create(
+      absl::string_view format_string, std::vector<const Type*> types,
+      ProductMode product_mode, bool canonicalize_zero = false,
+      bool use_external_float32 = false);
+
+  StringFormatPlan(const StringFormatPlan&) = delete;
+  StringFormatPlan& operator=(const StringFormatPlan&) = delete;
+
+  // The types of `values` must be the `types` passed to Create().
+  absl::Status Format(absl::Span<const Value> values, std::string* output,
+                      bool* is_null) const;
+
+ private:
+  StringFormatPlan(
+      std::unique_ptr<google::protobuf::DynamicMessageFactory> factory,
+      std::unique_ptr<string_format_internal::StringFormatEvaluator> evaluator)
+      : factory_(std::move(factory)), evaluator_(std::move(evaluator)) {}
+
+  // Owns the prototypes used by `evaluator_`, so must outlive it.
+  const std::unique_ptr<google::protobuf::DynamicMessageFactory> factory_;
+  mutable absl::Mutex mutex_;
+  // Keeps per-row state, so is only used by one Format() at a time.
+  const std::unique_ptr<string_format_internal::StringFormatEvaluator>
+      evaluator_ ABSL_GUARDED_BY(mutex_);
+};
+
 }  // namespace functions
 }  // namespace zetasql
 
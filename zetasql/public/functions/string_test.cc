@@ -605,6 +605,41 @@ TEST(Trim, Utf8) {
   // It is undefined behavior what we chose to do on ill formed strings, in this
   // case, we don't detect that we have an ill formed string.
   TestUtf8Trimmer(trimmer, kIllFormed, kIllFormed, kIllFormed, kIllFormed);
+
+  // Only ASCII characters to trim, next to other characters.
+  EXPECT_TRUE(trimmer.Initialize("ab ", &error));
+  ZETASQL_EXPECT_OK(error);
+  TestUtf8Trimmer(trimmer, " aбb ", "бb ", " aб", "б");
+  TestUtf8Trimmer(trimmer, "ab\xA4ba", "\xA4ba", "ab\xA4", "\xA4");
+}
+
+TEST(Utf8, AsciiPrefixes) {
+  // Mixes long ASCII runs, which are processed 8 bytes at a time, with
+  // multi-byte characters.
+  const std::string str = "abcdefghijбklmnopqrstuvwxyzчabcdefghij";
+  absl::Status error;
+  int64_t length;
+  EXPECT_TRUE(LengthUtf8(str, &length, &error));
+  EXPECT_EQ(length, 38);
+
+  absl::string_view substr;
+  EXPECT_TRUE(SubstrWithLengthUtf8(str, 10, 4, &substr, &error));
+  EXPECT_EQ(substr, "jбkl");
+  EXPECT_TRUE(SubstrWithLengthUtf8(str, -12, 3, &substr, &error));
+  EXPECT_EQ(substr, "zчa");
+
+  int64_t pos;
+  EXPECT_TRUE(StrPosOccurrenceUtf8(str, "abc", 2, 1, &pos, &error));
+  EXPECT_EQ(pos, 29);
+
+  std::string cased;
+  EXPECT_TRUE(UpperUtf8("abcdefghijk-xyz", &cased, &error));
+  EXPECT_EQ(cased, "ABCDEFGHIJK-XYZ");
+  EXPECT_TRUE(LowerUtf8("ABCDEFGHIJбK", &cased, &error));
+  EXPECT_EQ(cased, "abcdefghijбk");
+
+  EXPECT_FALSE(LengthUtf8("abcdefghijklmnop\xA4", &length, &error));
+  EXPECT_FALSE(error.ok());
 }
 
 TEST(Split, Utf8) {
@@ -31,6 +31,7 @@
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/match.h"
 #include "absl/strings/string_view.h"
 #include "unicode/coleitr.h"
 #include "unicode/errorcode.h"
@@ -105,6 +106,110 @@ absl::StatusOr<bool> IsUnicodeStringEmpty(const ZetaSqlCollator& collator,
   return result == UCOL_EQUAL;
 }
 
+// Returns true if the collation of 'collator' is "und:ci" and 'str' and
+// 'substr' only have printable ASCII characters. In the root collation, each
+// of those characters is one collation element which is not ignorable and not
+// part of a contraction, and distinct characters only differ at the secondary
+// strength of "ci" if they differ beyond ASCII case. So searching 'str' for
+// 'substr' with ICU finds exactly the matches of a byte-wise search that
+// ignores ASCII case, and the searches below use it instead.
+bool UseAsciiCaseInsensitiveSearch(const ZetaSqlCollator& collator,
+                                   absl::string_view str,
+                                   absl::string_view substr) {
+  if (collator.GetCollationName() != "und:ci") {
+    return false;
+  }
+  auto is_printable_ascii = [](absl::string_view s) {
+    return std::all_of(s.begin(), s.end(),
+                       [](char c) { return c >= ' ' && c <= '~'; });
+  };
+  return is_printable_ascii(str) && is_printable_ascii(substr);
+}
+
+// Returns the byte offset of the first match of 'substr' in 'str' that starts
+// at or after 'pos', ignoring ASCII case, or absl::string_view::npos.
+size_t FindAsciiCaseInsensitive(absl::string_view str, absl::string_view substr,
+                                size_t pos) {
+  if (substr.size() > str.size()) {
+    return absl::string_view::npos;
+  }
+  for (size_t i = pos; i <= str.size() - substr.size(); ++i) {
+    if (absl::EqualsIgnoreCase(str.substr(i, substr.size()), substr)) {
+      return i;
+    }
+  }
+  return absl::string_view::npos;
+}
+
+// Like FindAsciiCaseInsensitive(), but returns the last match.
+size_t FindLastAsciiCaseInsensitive(absl::string_view str,
+                                    absl::string_view substr) {
+  if (substr.size() > str.size()) {
+    return absl::string_view::npos;
+  }
+  for (size_t i = str.size() - substr.size() + 1; i > 0; --i) {
+    if (absl::EqualsIgnoreCase(str.substr(i - 1, substr.size()), substr)) {
+      return i - 1;
+    }
+  }
+  return absl::string_view::npos;
+}
+
+// LikeUtf8WithCollation() for the inputs of UseAsciiCaseInsensitiveSearch().
+// The pattern is split into chunks by '%' in the same order, with the same
+// errors, as there.
+absl::StatusOr<bool> LikeAsciiCaseInsensitive(absl::string_view text,
+                                              absl::string_view pattern) {
+  size_t pattern_index = 0;
+  // The end of the match of the previous chunk.
+  size_t text_offset = 0;
+  while (true) {
+    size_t chunk_end = pattern_index;
+    std::string chunk;
+    while (chunk_end < pattern.size() && pattern[chunk_end] != '%') {
+      char c = pattern[chunk_end++];
+      if (c == '_') {
+        return ::zetasql_base::OutOfRangeErrorBuilder()
+               << "LIKE pattern has '_' which is not allowed when its "
+                  "operands have collation: "
+               << pattern;
+      }
+      if (c == '\\') {
+        if (chunk_end >= pattern.size()) {
+          return ::zetasql_base::OutOfRangeErrorBuilder()
+                 << "LIKE pattern ends with a backslash which is not "
+                    "allowed: "
+                 << pattern;
+        }
+        c = pattern[chunk_end++];
+      }
+      chunk.push_back(c);
+    }
+    const bool is_first_chunk = pattern_index == 0;
+    const bool is_last_chunk = chunk_end == pattern.size();
+    if (chunk.empty()) {
+      if (is_last_chunk) {
+        // Either the pattern ends with '%', or it is empty.
+        return !is_first_chunk || text.empty();
+      }
+    } else {
+      const size_t match =
+          is_last_chunk ? FindLastAsciiCaseInsensitive(text, chunk)
+                        : FindAsciiCaseInsensitive(text, chunk, text_offset);
+      if (match == absl::string_view::npos || match < text_offset ||
+          (is_first_chunk && match != 0)) {
+        return false;
+      }
+      if (is_last_chunk) {
+        return match + chunk.size() == text.size();
+      }
+      text_offset = match + chunk.size();
+    }
+    // Skip the '%'.
+    pattern_index = chunk_end + 1;
+  }
+}
+
 }  // anonymous namespace
 
 // REPLACE(COLLATOR, STRING, STRING, STRING) -> STRING
@@ -147,6 +252,20 @@ bool ReplaceUtf8WithCollation(const ZetaSqlCollator& collator,
     // not necessary. Use the non-collation version of REPLACE in this case.
     return ReplaceUtf8(str, oldsub, newsub, out, status);
   }
+  if (UseAsciiCaseInsensitiveSearch(collator, str, oldsub)) {
+    size_t pos = 0;
+    size_t match;
+    while ((match = FindAsciiCaseInsensitive(str, oldsub, pos)) !=
+           absl::string_view::npos) {
+      if (out->size() + (match - pos) + newsub.length() > kMaxOutputSize) {
+        return internal::UpdateError(status, kExceededReplaceOutputSize);
+      }
+      out->append(str, pos, match - pos).append(newsub);
+      pos = match + oldsub.size();
+    }
+    out->append(str, pos);
+    return true;
+  }
   icu::ErrorCode icu_error;
   icu::UnicodeString old_sequence = icu::UnicodeString::fromUTF8(oldsub);
   icu::UnicodeString original = icu::UnicodeString::fromUTF8(str);
@@ -224,6 +343,18 @@ bool SplitUtf8WithCollationImpl(const ZetaSqlCollator& collator,
     out->push_back("");
     return true;
   }
+  if (!delimiter.empty() &&
+      UseAsciiCaseInsensitiveSearch(collator, str, delimiter)) {
+    size_t pos = 0;
+    size_t match;
+    while ((match = FindAsciiCaseInsensitive(str, delimiter, pos)) !=
+           absl::string_view::npos) {
+      out->push_back(str.substr(pos, match - pos));
+      pos = match + delimiter.size();
+    }
+    out->push_back(str.substr(pos));
+    return true;
+  }
   icu::UnicodeString unicode_str = icu::UnicodeString::fromUTF8(str);
   // This cast is necessary because the StringSearch API requires a non-const
   // collator. The collator is not changed by the StringSearch methods used
@@ -360,6 +491,23 @@ bool GetNthPosMatchIndex(const ZetaSqlCollator& collator,
         status,
         "Internal error when computing starting position of a substring.");
   }
+  if (UseAsciiCaseInsensitiveSearch(collator, str, substr)) {
+    *out = 0;
+    if (substr.empty()) {
+      return true;
+    }
+    // Matches may overlap, so each occurrence is searched for from the
+    // character after the start of the previous one.
+    size_t match = code_point_pos - 1;
+    for (int64_t i = 0; i < occurrence; ++i) {
+      match = FindAsciiCaseInsensitive(str, substr, i == 0 ? match : match + 1);
+      if (match == absl::string_view::npos) {
+        return true;
+      }
+    }
+    *out = match + 1;
+    return true;
+  }
   icu::UnicodeString unicode_substr = icu::UnicodeString::fromUTF8(substr);
   if (unicode_substr.isEmpty()) {
     *out = 0;
@@ -546,6 +694,11 @@ bool StartsWithUtf8WithCollation(const ZetaSqlCollator& collator,
     return internal::UpdateError(
         status, "Value in STARTS_WITH function is not a valid UTF-8 string");
   }
+  if (UseAsciiCaseInsensitiveSearch(collator, str, substr)) {
+    // Like the ICU search, an empty 'substr' has no match.
+    *out = !substr.empty() && absl::StartsWithIgnoreCase(str, substr);
+    return true;
+  }
   int64_t match_index;
   if (!GetNthPosMatchIndex(collator, str, substr, /*code_point_pos=*/1,
                            /*occurrence=*/1, &match_index, status)) {
@@ -572,6 +725,11 @@ bool EndsWithUtf8WithCollation(const ZetaSqlCollator& collator,
     return internal::UpdateError(
         status, "Value in ENDS_WITH function is not a valid UTF-8 string");
   }
+  if (UseAsciiCaseInsensitiveSearch(collator, str, substr)) {
+    // Like the ICU search, an empty 'substr' has no match.
+    *out = !substr.empty() && absl::EndsWithIgnoreCase(str, substr);
+    return true;
+  }
   int64_t match_index;
   if (!GetNthNegMatchIndex(collator, str, substr, /*code_point_pos=*/-1,
                            /*occurrence=*/1, &match_index, out, status)) {
@@ -595,6 +753,9 @@ absl::StatusOr<bool> LikeUtf8WithCollation(absl::string_view text,
     ZETASQL_RETURN_IF_ERROR(functions::CreateLikeRegexp(pattern, TYPE_STRING, &regexp));
     return RE2::FullMatch(text, *regexp);
   }
+  if (UseAsciiCaseInsensitiveSearch(collator, text, pattern)) {
+    return LikeAsciiCaseInsensitive(text, pattern);
+  }
   if (!IsWellFormedUTF8(text)) {
     return ::zetasql_base::OutOfRangeErrorBuilder()
            << "The first operand of LIKE operator is not a valid UTF-8 string: "
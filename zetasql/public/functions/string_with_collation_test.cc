@@ -18,6 +18,8 @@
 
 #include <sys/types.h>
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -26,6 +28,7 @@
 #include "zetasql/public/type.pb.h"
 #include "zetasql/testing/test_function.h"
 #include "gtest/gtest.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
@@ -503,6 +506,70 @@ TEST(ReplaceWithCollator, HandleExplodingStringLength) {
                                         generation2, &generation3, &error));
 }
 
+// "und:ci" searches printable ASCII strings without ICU, which must find the
+// same matches as the ICU search of "unicode:ci", which has the same rules.
+TEST(StringWithCollator, AsciiCaseInsensitiveMatchesIcu) {
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<const ZetaSqlCollator> ascii,
+                       MakeSqlCollator("und:ci"));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<const ZetaSqlCollator> icu,
+                       MakeSqlCollator("unicode:ci"));
+  const std::vector<std::string> strings = {
+      "", "a", "A", "ab", "aA", "aaa", "AbAbA", "b a B", "x%y", "XyZ-xYz"};
+  for (const std::string& str : strings) {
+    for (const std::string& substr : strings) {
+      SCOPED_TRACE(absl::StrCat("'", str, "', '", substr, "'"));
+      absl::Status status;
+      for (int64_t pos : {1, 2, 4}) {
+        for (int64_t occurrence : {1, 2}) {
+          int64_t ascii_out, icu_out;
+          ASSERT_TRUE(StrPosOccurrenceUtf8WithCollation(
+              *ascii, str, substr, pos, occurrence, &ascii_out, &status));
+          ASSERT_TRUE(StrPosOccurrenceUtf8WithCollation(
+              *icu, str, substr, pos, occurrence, &icu_out, &status));
+          EXPECT_EQ(ascii_out, icu_out) << pos << ", " << occurrence;
+        }
+      }
+      bool ascii_bool, icu_bool;
+      ASSERT_TRUE(StartsWithUtf8WithCollation(*ascii, str, substr, &ascii_bool,
+                                              &status));
+      ASSERT_TRUE(
+          StartsWithUtf8WithCollation(*icu, str, substr, &icu_bool, &status));
+      EXPECT_EQ(ascii_bool, icu_bool);
+      ASSERT_TRUE(EndsWithUtf8WithCollation(*ascii, str, substr, &ascii_bool,
+                                            &status));
+      ASSERT_TRUE(
+          EndsWithUtf8WithCollation(*icu, str, substr, &icu_bool, &status));
+      EXPECT_EQ(ascii_bool, icu_bool);
+
+      std::string ascii_string, icu_string;
+      ASSERT_TRUE(ReplaceUtf8WithCollation(*ascii, str, substr, "<>",
+                                           &ascii_string, &status));
+      ASSERT_TRUE(ReplaceUtf8WithCollation(*icu, str, substr, "<>",
+                                           &icu_string, &status));
+      EXPECT_EQ(ascii_string, icu_string);
+      std::vector<absl::string_view> ascii_parts, icu_parts;
+      ASSERT_TRUE(
+          SplitUtf8WithCollation(*ascii, str, substr, &ascii_parts, &status));
+      ASSERT_TRUE(
+          SplitUtf8WithCollation(*icu, str, substr, &icu_parts, &status));
+      EXPECT_EQ(ascii_parts, icu_parts);
+
+      for (const std::string& pattern :
+           {substr, absl::StrCat(substr, "%"), absl::StrCat("%", substr),
+            absl::StrCat("%", substr, "%", substr)}) {
+        absl::StatusOr<bool> ascii_like =
+            LikeUtf8WithCollation(str, pattern, *ascii);
+        absl::StatusOr<bool> icu_like =
+            LikeUtf8WithCollation(str, pattern, *icu);
+        ASSERT_EQ(ascii_like.ok(), icu_like.ok()) << pattern;
+        if (ascii_like.ok()) {
+          EXPECT_EQ(*ascii_like, *icu_like) << pattern;
+        }
+      }
+    }
+  }
+}
+
 TEST(LikeWithCollationMatchTest, MatchTest) {
   ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<const ZetaSqlCollator> collator,
                        MakeSqlCollator("und:ci"));
@@ -20,10 +20,12 @@
 #include <memory>
 #include <string>
 #include <unordered_set>
+#include <utility>
 
 #include "zetasql/base/logging.h"
 #include "zetasql/common/unicode_utils.h"
 #include "zetasql/base/case.h"
+#include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "zetasql/base/map_util.h"
 
@@ -68,6 +70,17 @@ IdStringPool::IdStringPool(const std::shared_ptr<zetasql_base::UnsafeArena>& are
 #endif
 }
 
+IdStringPool::IdStringPool(std::shared_ptr<const IdStringPool> base)
+    : IdStringPool() {
+  base_ = std::move(base);
+}
+
+IdStringPool::IdStringPool(const std::shared_ptr<zetasql_base::UnsafeArena>& arena,
+                           std::shared_ptr<const IdStringPool> base)
+    : IdStringPool(arena) {
+  base_ = std::move(base);
+}
+
 IdStringPool::~IdStringPool() {
 #ifndef NDEBUG
   ZETASQL_VLOG(1) << "Deleting IdStringPool " << pool_id_;
@@ -87,6 +100,24 @@ int64_t IdStringPool::AllocatePoolId() {
 }
 #endif
 
+IdString IdStringPool::Intern(absl::string_view str) {
+  if (const IdString* interned = FindInterned(str); interned != nullptr) {
+    return *interned;
+  }
+  const IdString id_string = Make(str);
+  interned_.emplace(id_string.ToStringView(), id_string);
+  return id_string;
+}
+
+const IdString* IdStringPool::FindInterned(absl::string_view str) const {
+  for (const IdStringPool* pool = this; pool != nullptr;
+       pool = pool->base_.get()) {
+    auto it = pool->interned_.find(str);
+    if (it != pool->interned_.end()) return &it->second;
+  }
+  return nullptr;
+}
+
 IdString IdString::ToLower(IdStringPool* pool) const {
   return pool->Make(
       zetasql::GetNormalizedAndCasefoldedString(ToStringView()));
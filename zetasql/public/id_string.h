@@ -39,6 +39,7 @@
 #include "absl/base/attributes.h"
 #include "absl/base/const_init.h"
 #include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/container/node_hash_set.h"
 #include "absl/flags/flag.h"
@@ -416,20 +417,35 @@ using IdStringHashMapCase =
 // IdStringPool is not thread-safe.  The returned IdStrings are thread-safe to
 // read and copy.
 //
-// TODO Consider variants, like an interning IdStringPool.
+// A pool can be layered on a long-lived base pool, where frequently used
+// identifiers, like the table and column names of a catalog, are interned once
+// with Intern(). Make() in the layered pool returns the base's IdStrings for
+// interned strings, without allocating, and these IdStrings compare equal by
+// pointer across all pools sharing the base. Once it is used as a base, a pool
+// must not be modified anymore, and can then be used by layered pools in any
+// number of threads.
 class IdStringPool {
  public:
   // Pass 'arena' to use an existing arena.
   IdStringPool();
   explicit IdStringPool(const std::shared_ptr<zetasql_base::UnsafeArena>& arena);
+  // Creates a pool layered on <base>, which is kept alive by this pool.
+  explicit IdStringPool(std::shared_ptr<const IdStringPool> base);
+  IdStringPool(const std::shared_ptr<zetasql_base::UnsafeArena>& arena,
+               std::shared_ptr<const IdStringPool> base);
 #ifndef SWIG
   IdStringPool(const IdStringPool&) = delete;
   IdStringPool& operator=(const IdStringPool&) = delete;
 #endif  // SWIG
   ~IdStringPool();
 
-  // Make an IdString with contents allocated in this pool.
+  // Make an IdString with contents allocated in this pool, or return the
+  // IdString interned for <str> in the base pool, if any.
   IdString Make(absl::string_view str) {
+    if (base_ != nullptr) {
+      const IdString* interned = base_->FindInterned(str);
+      if (interned != nullptr) return *interned;
+    }
 #ifndef NDEBUG
     return IdString(MakeShared(str), pool_id_);
 #else
@@ -444,7 +460,17 @@ class IdStringPool {
   // Do NOT use for any allocations that are done on a per-query basis.
   static IdString MakeGlobal(absl::string_view str);
 
+  // Like Make(), but returns the same IdString for all calls with the same
+  // <str>, and makes pools layered on this one return it from Make() too.
+  IdString Intern(absl::string_view str);
+
+  const IdStringPool* base() const { return base_.get(); }
+
  private:
+  // Returns the IdString interned for <str> in this pool or its base pools, or
+  // NULL if there is none.
+  const IdString* FindInterned(absl::string_view str) const;
+
   // Make an IdString::Shared for <str>, allocated in the arena.
   const IdString::Shared* MakeShared(absl::string_view str) const {
     static_assert(sizeof(IdString::Shared) % sizeof(int64_t) == 0,
@@ -543,6 +569,12 @@ class IdStringPool {
 
   std::shared_ptr<zetasql_base::UnsafeArena> arena_;
 
+  // The pool this one is layered on, if any.
+  std::shared_ptr<const IdStringPool> base_;
+
+  // The IdStrings created by Intern(), keyed by their contents.
+  absl::flat_hash_map<absl::string_view, IdString> interned_;
+
 #ifndef NDEBUG
   static absl::Mutex global_mutex_;
 
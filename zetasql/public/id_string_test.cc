@@ -17,6 +17,7 @@
 #include "zetasql/public/id_string.h"
 
 #include <algorithm>
+#include <memory>
 #include <set>
 #include <string>
 #include <unordered_set>
@@ -409,6 +410,36 @@ TEST(IdString, Set) {
       std::set<IdString, IdStringCaseLess>>();
 }
 
+TEST(IdStringPool, Intern) {
+  auto base = std::make_shared<IdStringPool>();
+  const IdString interned = base->Intern("Table");
+  EXPECT_EQ(interned.ToStringView().data(),
+            base->Intern("Table").ToStringView().data());
+  // Make() in the base itself still allocates.
+  EXPECT_NE(interned.ToStringView().data(),
+            base->Make("Table").ToStringView().data());
+
+  IdStringPool layered(base);
+  EXPECT_EQ(layered.base(), base.get());
+  const IdString from_layered = layered.Make("Table");
+  EXPECT_EQ(from_layered, interned);
+  EXPECT_EQ(from_layered.ToStringView().data(), interned.ToStringView().data());
+
+  // Strings that are not interned in the base are made in the layered pool.
+  const IdString other = layered.Make("Column");
+  EXPECT_EQ(other.ToStringView(), "Column");
+  EXPECT_NE(other.ToStringView().data(),
+            layered.Make("Column").ToStringView().data());
+  // Interning is case sensitive.
+  EXPECT_NE(layered.Make("table").ToStringView().data(),
+            interned.ToStringView().data());
+
+  // The layered pool keeps its base alive.
+  base.reset();
+  from_layered.CheckAlive();
+  EXPECT_EQ(from_layered.ToStringView(), "Table");
+}
+
 static const char kPoolIsDeadMsg[] =
     "IdString was accessed after its IdStringPool .* was destructed";
 
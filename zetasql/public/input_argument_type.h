@@ -130,6 +130,9 @@ class InputArgumentType {
   bool is_untyped_query_parameter() const {
     return category_ == kUntypedParameter;
   }
+  // Returns true for typed arguments that are neither literals nor
+  // parameters, i.e. general expressions.
+  bool is_typed_expression() const { return category_ == kTypedExpression; }
   bool is_relation() const { return category_ == kRelation; }
   bool is_model() const { return category_ == kModel; }
   bool is_connection() const { return category_ == kConnection; }
@@ -42,6 +42,7 @@
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/types/span.h"
 #include "single_include/nlohmann/json.hpp"
 #include "zetasql/base/map_util.h"
 #include "zetasql/base/ret_check.h"
@@ -64,12 +65,22 @@ class JSONValueBuilder {
   // Constructs a builder that adds content to the given 'value'. If
   // 'max_nesting' has a value, then the parser will return an error when the
   // JSON document exceeds the max level of nesting. If 'max_nesting' is
-  // negative, 0 will be set instead.
-  explicit JSONValueBuilder(JSON& value, std::optional<int> max_nesting)
-      : value_(value), max_nesting_(max_nesting) {
+  // negative, 0 will be set instead. If 'path' is not empty, only the values
+  // on it are added, see JSONValue::ParseJSONStringAlongPath().
+  explicit JSONValueBuilder(JSON& value, std::optional<int> max_nesting,
+                            absl::Span<const std::string> path = {})
+      : value_(value), max_nesting_(max_nesting), path_(path) {
     if (max_nesting_.has_value() && *max_nesting_ < 0) {
       max_nesting_ = 0;
     }
+    path_indexes_.reserve(path_.size());
+    for (const std::string& token : path_) {
+      int64_t index;
+      if (!absl::SimpleAtoi(token, &index) || index < 0) {
+        index = -1;
+      }
+      path_indexes_.push_back(index);
+    }
   }
 
   // Resets the builder with a new 'value' to construct.
@@ -102,6 +113,13 @@ class JSONValueBuilder {
       return absl::OkStatus();
     }
 
+    // Skip the members of an object on 'path_' that are not on it themselves.
+    if (ref_stack_.size() <= path_.size() &&
+        key != path_[ref_stack_.size() - 1]) {
+      object_member_ = GetSkippingNodeMarker();
+      return absl::OkStatus();
+    }
+
     // Insert JSON null at the `key` spot, if an element with such `key` doesn't
     // exist already.
     auto [it, inserted] =
@@ -186,6 +204,19 @@ class JSONValueBuilder {
     }
 
     if (ref_stack_.back()->is_array()) {
+      // Skip the elements of an array on 'path_' that are not on it
+      // themselves, keeping nulls in place of the ones before it so that it
+      // keeps its index.
+      if (ref_stack_.size() <= path_.size()) {
+        const int64_t path_index = path_indexes_[ref_stack_.size() - 1];
+        const int64_t index = ref_stack_.back()->size();
+        if (index != path_index) {
+          if (index < path_index) {
+            ref_stack_.back()->emplace_back(nullptr);
+          }
+          return GetSkippingNodeMarker();
+        }
+      }
       ref_stack_.back()->emplace_back(std::forward<Value>(v));
       return &(ref_stack_.back()->back());
     }
@@ -212,6 +243,11 @@ class JSONValueBuilder {
   JSON& value_;
   // Max nesting allowed.
   std::optional<int> max_nesting_;
+  // Object member names and array indexes of the values to add, starting at
+  // the root. Empty to add all values.
+  absl::Span<const std::string> path_;
+  // 'path_' parsed as array indexes, -1 for tokens that are not indexes.
+  std::vector<int64_t> path_indexes_;
   // Stack to model hierarchy of values.
   std::vector<JSON*> ref_stack_;
   // Helper to hold the reference for the next object element.
@@ -293,8 +329,9 @@ class JSONValueParserBase {
 class JSONValueStandardParser : public JSONValueParserBase {
  public:
   JSONValueStandardParser(JSON& value, WideNumberMode wide_number_mode,
-                          std::optional<int> max_nesting)
-      : value_builder_(value, max_nesting),
+                          std::optional<int> max_nesting,
+                          absl::Span<const std::string> path = {})
+      : value_builder_(value, max_nesting, path),
         wide_number_mode_(wide_number_mode) {}
   JSONValueStandardParser() = delete;
 
@@ -459,6 +496,18 @@ StatusOr<JSONValue> JSONValue::ParseJSONString(
   return json;
 }
 
+StatusOr<JSONValue> JSONValue::ParseJSONStringAlongPath(
+    absl::string_view str, absl::Span<const std::string> path,
+    JSONParsingOptions parsing_options) {
+  JSONValue json;
+  JSONValueStandardParser parser(json.impl_->value,
+                                 parsing_options.wide_number_mode,
+                                 parsing_options.max_nesting, path);
+  JSON::sax_parse(str, &parser);
+  ZETASQL_RETURN_IF_ERROR(parser.status());
+  return json;
+}
+
 StatusOr<JSONValue> JSONValue::DeserializeFromProtoBytes(
     absl::string_view str, std::optional<int> max_nesting_level) {
   JSONValue json;
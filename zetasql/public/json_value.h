@@ -31,6 +31,7 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 
 namespace zetasql {
 
@@ -112,6 +113,18 @@ class JSONValue final {
       absl::string_view str,
       JSONParsingOptions parsing_options = JSONParsingOptions());
 
+  // Like ParseJSONString(), but only materializes the values of 'str' on
+  // 'path', a sequence of object member names and array indexes starting at
+  // the root (e.g. {"a", "1"} for the JSONPath $.a[1]), and all the values
+  // below the last one. The other object members are dropped, and the other
+  // array elements before the one on 'path' become nulls. Following 'path' in
+  // the result gives the same value as in the fully parsed document, and the
+  // whole document is still validated, but parsing a large document to look
+  // up one of its values is much cheaper.
+  static absl::StatusOr<JSONValue> ParseJSONStringAlongPath(
+      absl::string_view str, absl::Span<const std::string> path,
+      JSONParsingOptions parsing_options = JSONParsingOptions());
+
   // Decodes a binary representation of a JSON value produced by
   // JSONValueConstRef::SerializeAndAppendToProtoBytes(). Returns an error if
   // 'str' is not a valid binary representation.
@@ -873,6 +873,40 @@ TEST(JSONStandardParserTest, ParseErrorStandard) {
   EXPECT_EQ(result.status().message(), "number overflow parsing '1e99999'");
 }
 
+TEST(JSONStandardParserTest, ParseAlongPath) {
+  constexpr absl::string_view kDocument =
+      R"({"a":[{"x":1},{"b":{"c":[1,2]},"d":3},{"e":4}],"a":5,"f":{"g":6}})";
+  std::vector<std::string> path = {"a", "1", "b"};
+  ZETASQL_ASSERT_OK_AND_ASSIGN(JSONValue value,
+                       JSONValue::ParseJSONStringAlongPath(kDocument, path));
+  EXPECT_EQ(value.GetConstRef().ToString(),
+            R"({"a":[null,{"b":{"c":[1,2]}}]})");
+
+  // A path that is not in the document keeps nothing of it.
+  path = {"f", "0"};
+  ZETASQL_ASSERT_OK_AND_ASSIGN(value,
+                       JSONValue::ParseJSONStringAlongPath(kDocument, path));
+  EXPECT_EQ(value.GetConstRef().ToString(), R"({"f":{}})");
+
+  // An empty path parses the whole document.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(value,
+                       JSONValue::ParseJSONStringAlongPath(kDocument, {}));
+  EXPECT_EQ(value.GetConstRef().ToString(),
+            R"({"a":[{"x":1},{"b":{"c":[1,2]},"d":3},{"e":4}],"f":{"g":6}})");
+
+  // Values that are not on the path are still validated.
+  path = {"a"};
+  EXPECT_FALSE(
+      JSONValue::ParseJSONStringAlongPath(R"({"a":1,"b":[1, a]})", path).ok());
+  EXPECT_FALSE(JSONValue::ParseJSONStringAlongPath(
+                   R"({"a":1,"b":-1.003502000000000000000000001})", path,
+                   {.wide_number_mode = WideNumberMode::kExact})
+                   .ok());
+  EXPECT_FALSE(JSONValue::ParseJSONStringAlongPath(R"({"a":1,"b":[[1]]})", path,
+                                                   {.max_nesting = 2})
+                   .ok());
+}
+
 TEST(JSONValueTest, SerializePrimitiveValueToString) {
   JSONValue value;
   JSONValueRef ref = value.GetRef();
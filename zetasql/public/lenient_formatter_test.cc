@@ -24,6 +24,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "unicode/uchar.h"
 #include "unicode/unistr.h"
@@ -69,5 +70,22 @@ WHERE condition_that_makes_the_entire_query > default_line_length;
 |)") << result;
 }
 
+TEST(LenientFormatterTest, NumThreadsDoesNotChangeOutput) {
+  std::string input;
+  for (int i = 0; i < 50; ++i) {
+    absl::StrAppend(&input, "select a, b from t", i,
+                    " where some_long_condition_to_break > ", i,
+                    " and another_long_condition_to_break < ", i, ";\n");
+  }
+  std::string expected;
+  ZETASQL_ASSERT_OK(LenientFormatSql(input, &expected));
+
+  FormatterOptions options;
+  options.SetNumThreads(4);
+  std::string result;
+  ZETASQL_EXPECT_OK(LenientFormatSql(input, &result, options));
+  EXPECT_EQ(result, expected);
+}
+
 }  // namespace
 }  // namespace zetasql
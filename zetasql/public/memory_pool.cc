@@ -0,0 +1,82 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/memory_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "zetasql/base/logging.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/substitute.h"
+#include "absl/synchronization/mutex.h"
+
+namespace zetasql {
+
+MemoryPool::MemoryPool(int64_t max_bytes, MemoryPool* parent,
+                       absl::string_view name)
+    : max_bytes_(max_bytes), parent_(parent), name_(name) {}
+
+MemoryPool::~MemoryPool() {
+  absl::MutexLock lock(&mutex_);
+  ABSL_DCHECK_EQ(reserved_bytes_, 0) << name_;
+}
+
+bool MemoryPool::Reserve(int64_t num_bytes, absl::Status* status) {
+  ABSL_DCHECK_GE(num_bytes, 0);
+  {
+    absl::MutexLock lock(&mutex_);
+    if (num_bytes > max_bytes_ - reserved_bytes_) {
+      *status = absl::ResourceExhaustedError(absl::Substitute(
+          "Out of memory for MemoryPool($0): requested $1 bytes but only $2 "
+          "are available out of a total of $3.",
+          name_, num_bytes, max_bytes_ - reserved_bytes_, max_bytes_));
+      return false;
+    }
+    reserved_bytes_ += num_bytes;
+  }
+  if (parent_ != nullptr && !parent_->Reserve(num_bytes, status)) {
+    absl::MutexLock lock(&mutex_);
+    reserved_bytes_ -= num_bytes;
+    return false;
+  }
+  // The peak only counts reservations that succeeded in all the ancestors.
+  absl::MutexLock lock(&mutex_);
+  peak_reserved_bytes_ = std::max(peak_reserved_bytes_, reserved_bytes_);
+  return true;
+}
+
+void MemoryPool::Release(int64_t num_bytes) {
+  if (parent_ != nullptr) {
+    parent_->Release(num_bytes);
+  }
+  absl::MutexLock lock(&mutex_);
+  reserved_bytes_ -= num_bytes;
+  ABSL_DCHECK_GE(reserved_bytes_, 0) << name_;
+}
+
+int64_t MemoryPool::reserved_bytes() const {
+  absl::MutexLock lock(&mutex_);
+  return reserved_bytes_;
+}
+
+int64_t MemoryPool::peak_reserved_bytes() const {
+  absl::MutexLock lock(&mutex_);
+  return peak_reserved_bytes_;
+}
+
+}  // namespace zetasql
@@ -0,0 +1,89 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_MEMORY_POOL_H_
+#define ZETASQL_PUBLIC_MEMORY_POOL_H_
+
+#include <cstdint>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+
+namespace zetasql {
+
+// A budget of bytes that is shared by evaluations, such as all the queries of
+// a tenant (see EvaluatorOptions::memory_pool). A pool may have a parent pool
+// that it also reserves its bytes from, such as the budget of the whole
+// process, so that budgets form a hierarchy:
+//
+//   MemoryPool process_pool(/*max_bytes=*/8LL << 30, nullptr, "process");
+//   MemoryPool tenant_pool(/*max_bytes=*/1LL << 30, &process_pool, "tenant");
+//   EvaluatorOptions options;
+//   options.memory_pool = &tenant_pool;
+//
+// Each evaluation still has its own limit of 'max_intermediate_byte_size',
+// and grows its reservation from the pool in chunks as it needs memory, up to
+// that limit. Operators that can spill to disk (see
+// EvaluatorOptions::spill_directory) do so when the pool is exhausted, like
+// when they reach the limit of the evaluation. Other operators fail with a
+// resource exhausted error.
+//
+// This class is thread-safe.
+class MemoryPool {
+ public:
+  // A pool of at most 'max_bytes' bytes. If 'parent' is non-null, bytes are
+  // only reserved from this pool if they can be reserved from 'parent' too.
+  // 'parent' must outlive this pool.
+  explicit MemoryPool(int64_t max_bytes, MemoryPool* parent = nullptr,
+                      absl::string_view name = "");
+
+  MemoryPool(const MemoryPool&) = delete;
+  MemoryPool& operator=(const MemoryPool&) = delete;
+  ~MemoryPool();
+
+  // If 'num_bytes' are available in this pool and all of its ancestors,
+  // reserves them from all of them and returns true. Else reserves nothing,
+  // returns false and populates 'status'. Does not return absl::Status for
+  // consistency with MemoryAccountant::RequestBytes().
+  bool Reserve(int64_t num_bytes, absl::Status* status)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Returns 'num_bytes' previously reserved with Reserve().
+  void Release(int64_t num_bytes) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  int64_t max_bytes() const { return max_bytes_; }
+
+  // The number of bytes currently reserved, and the largest number of bytes
+  // that was reserved at once.
+  int64_t reserved_bytes() const ABSL_LOCKS_EXCLUDED(mutex_);
+  int64_t peak_reserved_bytes() const ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  const int64_t max_bytes_;
+  MemoryPool* const parent_;
+  const std::string name_;
+
+  mutable absl::Mutex mutex_;
+  int64_t reserved_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t peak_reserved_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_MEMORY_POOL_H_
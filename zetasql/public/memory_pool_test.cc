@@ -0,0 +1,87 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/memory_pool.h"
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+
+namespace zetasql {
+namespace {
+
+using ::testing::HasSubstr;
+using ::zetasql_base::testing::StatusIs;
+
+TEST(MemoryPoolTest, ReservesUpToMaxBytes) {
+  MemoryPool pool(/*max_bytes=*/100, /*parent=*/nullptr, "test_pool");
+  absl::Status status;
+  EXPECT_TRUE(pool.Reserve(60, &status));
+  EXPECT_TRUE(pool.Reserve(40, &status));
+  ZETASQL_EXPECT_OK(status);
+  EXPECT_EQ(pool.reserved_bytes(), 100);
+
+  EXPECT_FALSE(pool.Reserve(1, &status));
+  EXPECT_THAT(status,
+              StatusIs(absl::StatusCode::kResourceExhausted,
+                       HasSubstr("Out of memory for MemoryPool(test_pool): "
+                                 "requested 1 bytes but only 0 are available "
+                                 "out of a total of 100.")));
+
+  pool.Release(60);
+  EXPECT_EQ(pool.reserved_bytes(), 40);
+  EXPECT_EQ(pool.peak_reserved_bytes(), 100);
+  pool.Release(40);
+}
+
+TEST(MemoryPoolTest, ReservesFromAncestors) {
+  MemoryPool process(/*max_bytes=*/100, /*parent=*/nullptr, "process");
+  MemoryPool tenant1(/*max_bytes=*/80, &process, "tenant1");
+  MemoryPool tenant2(/*max_bytes=*/80, &process, "tenant2");
+  absl::Status status;
+
+  EXPECT_TRUE(tenant1.Reserve(70, &status));
+  EXPECT_EQ(process.reserved_bytes(), 70);
+
+  // 'tenant2' has room, but 'process' does not, so nothing is reserved.
+  EXPECT_FALSE(tenant2.Reserve(40, &status));
+  EXPECT_THAT(status, StatusIs(absl::StatusCode::kResourceExhausted,
+                               HasSubstr("MemoryPool(process)")));
+  EXPECT_EQ(tenant2.reserved_bytes(), 0);
+  EXPECT_EQ(tenant2.peak_reserved_bytes(), 0);
+  EXPECT_EQ(process.reserved_bytes(), 70);
+
+  // 'process' has room, but 'tenant1' does not.
+  status = absl::OkStatus();
+  EXPECT_FALSE(tenant1.Reserve(20, &status));
+  EXPECT_THAT(status, StatusIs(absl::StatusCode::kResourceExhausted,
+                               HasSubstr("MemoryPool(tenant1)")));
+  EXPECT_EQ(process.reserved_bytes(), 70);
+
+  status = absl::OkStatus();
+  EXPECT_TRUE(tenant2.Reserve(30, &status));
+  ZETASQL_EXPECT_OK(status);
+  EXPECT_EQ(process.reserved_bytes(), 100);
+
+  tenant1.Release(70);
+  tenant2.Release(30);
+  EXPECT_EQ(process.reserved_bytes(), 0);
+  EXPECT_EQ(process.peak_reserved_bytes(), 100);
+}
+
+}  // namespace
+}  // namespace zetasql
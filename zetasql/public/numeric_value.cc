@@ -1168,9 +1168,23 @@ absl::StatusOr<NumericValue> NumericValue::Multiply(NumericValue rh) const {
   const __int128 rh_value = rh.as_packed_int();
   bool negative = value < 0;
   bool rh_negative = rh_value < 0;
-  FixedUint<64, 4> product =
-      ExtendAndMultiply(FixedUint<64, 2>(int128_abs(value)),
-                        FixedUint<64, 2>(int128_abs(rh_value)));
+  const unsigned __int128 abs_value = int128_abs(value);
+  const unsigned __int128 rh_abs_value = int128_abs(rh_value);
+  if (ABSL_PREDICT_TRUE(abs_value <= std::numeric_limits<uint64_t>::max() &&
+                        rh_abs_value <= std::numeric_limits<uint64_t>::max())) {
+    // Values below 2^64 / kScalingFactor (about 1.8e10), which are most
+    // values in practice, multiply within 128 bits. The product is less than
+    // 2^128 - 2^65, so adding kScalingFactor / 2 cannot overflow, and the
+    // result is far inside of the NUMERIC range.
+    unsigned __int128 v = static_cast<unsigned __int128>(
+                              static_cast<uint64_t>(abs_value)) *
+                          static_cast<uint64_t>(rh_abs_value);
+    v = (v + kScalingFactor / 2) / kScalingFactor;
+    return NumericValue(
+        static_cast<__int128>(negative == rh_negative ? v : -v));
+  }
+  FixedUint<64, 4> product = ExtendAndMultiply(FixedUint<64, 2>(abs_value),
+                                               FixedUint<64, 2>(rh_abs_value));
 
   // This value represents kNumericMax * kScalingFactor + kScalingFactor / 2.
   // At this value, <res> would be internal::kNumericMax + 1 and overflow.
@@ -1559,8 +1573,23 @@ absl::StatusOr<NumericValue> NumericValue::Divide(NumericValue rh) const {
   const bool rh_is_negative = rh_value < 0;
 
   if (ABSL_PREDICT_TRUE(rh_value != 0)) {
-    FixedUint<64, 3> dividend(int128_abs(value));
+    const unsigned __int128 abs_value = int128_abs(value);
     unsigned __int128 divisor = int128_abs(rh_value);
+    constexpr unsigned __int128 kMaxDividend = static_cast<unsigned __int128>(1)
+                                               << 97;
+    if (ABSL_PREDICT_TRUE(abs_value < kMaxDividend)) {
+      // Values below 2^97 / kScalingFactor (about 1.6e20) can be scaled to
+      // less than 2^127, and the rounding term is less than 2^127 as well, so
+      // the division does not need more than 128 bits.
+      const unsigned __int128 quotient =
+          (abs_value * kScalingFactor + (divisor >> 1)) / divisor;
+      if (ABSL_PREDICT_TRUE(quotient <= static_cast<unsigned __int128>(
+                                            internal::kNumericMax))) {
+        return NumericValue(static_cast<__int128>(
+            is_negative != rh_is_negative ? -quotient : quotient));
+      }
+    }
+    FixedUint<64, 3> dividend(abs_value);
 
     // To preserve the scale of the result we need to multiply the dividend by
     // the scaling factor first.
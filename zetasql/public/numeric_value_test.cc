@@ -1609,6 +1609,11 @@ TEST_F(NumericValueTest, Multiply) {
       // Overflow after rounding.
       {"99999999.99", "1000000000100000000010.000000001", kNumericOverflow},
       {"5e14", "2e14", kNumericOverflow},
+      // Around the largest operands that multiply within 128 bits.
+      {"18446744073.709551615", "18446744073.709551615",
+       "340282366920938463426.481119284"},
+      {"18446744073.709551615", "18446744073.709551617",
+       "340282366920938463463.374607432"},
   };
 
   NumericMultiplyOp op;
@@ -2308,6 +2313,14 @@ TEST_F(NumericValueTest, Divide) {
       {5, 2, "2.5"},
       {5, "0.5", 10},
       {"18446744073709551616", 4294967296, 4294967296},
+      // Around the largest dividend that is divided within 128 bits.
+      {"158456325028528675187.087900671", 3, "52818775009509558395.69596689"},
+      {"158456325028528675187.087900672", 3, "52818775009509558395.695966891"},
+      {"158456325028528675187.087900671", "0.000000007",
+       "22636617861218382169583985810.142857143"},
+      {"158456325028528675187.087900672", "0.000000007",
+       "22636617861218382169583985810.285714286"},
+      {"158456325028528675187.087900671", "1e-9", kNumericOverflow},
 
       // Rounding.
       {1, 3, "0.333333333"},
@@ -24,6 +24,7 @@
 #include <vector>
 
 #include "zetasql/base/arena.h"
+#include "farmhash.h"
 #include "zetasql/common/errors.h"
 #include "zetasql/parser/bison_parser.bison.h"
 #include "zetasql/parser/bison_parser_mode.h"
@@ -35,6 +36,7 @@
 #include "zetasql/public/value.h"
 #include "zetasql/base/case.h"
 #include "absl/memory/memory.h"
+#include "absl/numeric/int128.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
@@ -279,6 +281,56 @@ absl::Status GetParseTokens(const ParseTokenOptions& options,
   return status;
 }
 
+absl::Status GetStatementFingerprint(absl::string_view statement,
+                                     const LanguageOptions& language_options,
+                                     StatementFingerprint* fingerprint) {
+  ParseTokenOptions options;
+  options.language_options = language_options;
+  ParseResumeLocation resume_location =
+      ParseResumeLocation::FromStringView(statement);
+  std::vector<ParseToken> tokens;
+  ZETASQL_RETURN_IF_ERROR(GetParseTokens(options, &resume_location, &tokens));
+  ZETASQL_RET_CHECK(!tokens.empty() && tokens.back().IsEndOfInput());
+  tokens.pop_back();
+  if (!tokens.empty() && tokens.back().kind() == ParseToken::KEYWORD &&
+      tokens.back().GetImage() == ";") {
+    tokens.pop_back();
+  }
+
+  // Each token is written as its kind, the length of its text and the text,
+  // so that no two sequences of tokens have the same encoding.
+  std::string shape;
+  fingerprint->literals.clear();
+  fingerprint->literal_locations.clear();
+  for (const ParseToken& token : tokens) {
+    std::string text;
+    switch (token.kind()) {
+      case ParseToken::KEYWORD:
+        text = token.GetKeyword();
+        break;
+      case ParseToken::IDENTIFIER:
+      case ParseToken::IDENTIFIER_OR_KEYWORD:
+        text = token.GetIdentifier();
+        break;
+      case ParseToken::VALUE:
+        text = TypeKind_Name(token.GetValue().type_kind());
+        fingerprint->literals.push_back(token.GetValue());
+        fingerprint->literal_locations.push_back(token.GetLocationRange());
+        break;
+      case ParseToken::COMMENT:
+      case ParseToken::END_OF_INPUT:
+        ZETASQL_RET_CHECK_FAIL() << "Unexpected token: " << token.DebugString();
+    }
+    absl::StrAppend(&shape, static_cast<int>(token.kind()), ",", text.size(),
+                    ":", text);
+  }
+  const farmhash::uint128_t hash =
+      farmhash::Fingerprint128(shape.data(), shape.size());
+  fingerprint->hash = absl::MakeUint128(farmhash::Uint128High64(hash),
+                                        farmhash::Uint128Low64(hash));
+  return absl::OkStatus();
+}
+
 std::string ParseToken::GetKeyword() const {
   if (kind_ == KEYWORD) {
     return absl::AsciiStrToUpper(GetImage());
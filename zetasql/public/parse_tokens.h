@@ -22,7 +22,9 @@
 
 #include "zetasql/public/parse_location.h"
 #include "zetasql/public/parse_resume_location.h"
+#include "zetasql/public/language_options.h"
 #include "zetasql/public/value.h"
+#include "absl/numeric/int128.h"
 #include "absl/strings/string_view.h"
 #include "zetasql/base/status.h"
 
@@ -206,6 +208,34 @@ absl::Status GetParseTokens(const ParseTokenOptions& options,
                             ParseResumeLocation* resume_location,
                             std::vector<ParseToken>* tokens);
 
+// The shape of a statement, with its literals abstracted out, as computed by
+// GetStatementFingerprint().
+struct StatementFingerprint {
+  // A hash of the tokens of the statement, where each literal only
+  // contributes its type. Comments, whitespace and a trailing ";" are
+  // ignored. The hash is stable across processes and releases, so it can be
+  // used as a key of persistent caches.
+  absl::uint128 hash = 0;
+
+  // The values of the literals, in the order in which they appear, as
+  // returned by ParseToken::GetValue(). Statements with the same hash only
+  // differ in these.
+  std::vector<Value> literals;
+
+  // The location of each of 'literals' in the statement.
+  std::vector<ParseLocationRange> literal_locations;
+};
+
+// Computes the fingerprint of the single statement <statement> from its parse
+// tokens, without parsing or analyzing it, so that caches of analyzed or
+// prepared statements can be keyed on their shape. Like GetParseTokens(),
+// literals are the STRING, BYTES, INT64, UINT64 and DOUBLE tokens, so e.g.
+// the "-" of a negative number and the DATE of a date literal are part of the
+// shape. Returns an error on any tokenization failure.
+absl::Status GetStatementFingerprint(absl::string_view statement,
+                                     const LanguageOptions& language_options,
+                                     StatementFingerprint* fingerprint);
+
 }  // namespace zetasql
 
 #endif  // ZETASQL_PUBLIC_PARSE_TOKENS_H_
@@ -22,8 +22,10 @@
 
 #include "zetasql/base/testing/status_matchers.h"
 #include "zetasql/public/error_helpers.h"
+#include "zetasql/public/language_options.h"
 #include "zetasql/public/options.pb.h"
 #include "zetasql/public/parse_resume_location.h"
+#include "zetasql/public/value.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/strings/str_cat.h"
@@ -33,6 +35,7 @@
 namespace zetasql {
 
 using ::testing::_;
+using ::testing::ElementsAre;
 using ::testing::HasSubstr;
 using ::testing::Not;
 using ::zetasql_base::testing::IsOk;
@@ -271,4 +274,46 @@ TEST(GetNextTokensTest, ResumeLocationIsAdjustedOnError) {
   EXPECT_EQ(location.byte_position(), 0);
 }
 
+
+TEST(GetStatementFingerprintTest, AbstractsLiterals) {
+  const LanguageOptions language_options;
+  StatementFingerprint first;
+  ZETASQL_ASSERT_OK(GetStatementFingerprint(
+      "SELECT a FROM t WHERE b = 1 AND c = 'x'", language_options, &first));
+  EXPECT_THAT(first.literals,
+              ElementsAre(Value::Int64(1), Value::String("x")));
+  ASSERT_EQ(first.literal_locations.size(), 2);
+  EXPECT_EQ(first.literal_locations[0].start().GetByteOffset(), 26);
+  EXPECT_EQ(first.literal_locations[0].end().GetByteOffset(), 27);
+
+  StatementFingerprint second;
+  ZETASQL_ASSERT_OK(GetStatementFingerprint(
+      "select a\nFROM t -- comment\n WHERE b = 42 AND c = \"yz\";",
+      language_options, &second));
+  EXPECT_EQ(second.hash, first.hash);
+  EXPECT_THAT(second.literals,
+              ElementsAre(Value::Int64(42), Value::String("yz")));
+
+  // Other identifiers or types of literals change the shape.
+  for (absl::string_view other :
+       {"SELECT a FROM t WHERE b = 1 AND c = b'x'",
+        "SELECT a FROM t WHERE b = 1.5 AND c = 'x'",
+        "SELECT a FROM t WHERE b = -1 AND c = 'x'",
+        "SELECT a FROM u WHERE b = 1 AND c = 'x'",
+        "SELECT a FROM `t` WHERE b = 1 AND c = 'x'",
+        "SELECT a FROM t WHERE b = 1 AND c = x"}) {
+    StatementFingerprint fingerprint;
+    ZETASQL_ASSERT_OK(
+        GetStatementFingerprint(other, language_options, &fingerprint));
+    EXPECT_NE(fingerprint.hash, first.hash) << other;
+  }
+}
+
+TEST(GetStatementFingerprintTest, ReturnsTokenizerErrors) {
+  StatementFingerprint fingerprint;
+  EXPECT_THAT(
+      GetStatementFingerprint("SELECT 'abc", LanguageOptions(), &fingerprint),
+      Not(IsOk()));
+}
+
 }  // namespace zetasql
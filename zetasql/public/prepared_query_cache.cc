@@ -0,0 +1,291 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/prepared_query_cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/analyzer.h"
+#include "zetasql/public/analyzer_options.h"
+#include "zetasql/public/analyzer_output.h"
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/evaluator.h"
+#include "zetasql/public/literal_remover.h"
+#include "zetasql/public/options.pb.h"
+#include "zetasql/public/parse_location.h"
+#include "zetasql/public/parse_tokens.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/base/check.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+namespace {
+
+bool Contains(const ParseLocationRange& outer,
+              const ParseLocationRange& inner) {
+  return outer.start().GetByteOffset() <= inner.start().GetByteOffset() &&
+         inner.end().GetByteOffset() <= outer.end().GetByteOffset();
+}
+
+bool IsSameRange(const ParseLocationRange& a, const ParseLocationRange& b) {
+  return a.start().GetByteOffset() == b.start().GetByteOffset() &&
+         a.end().GetByteOffset() == b.end().GetByteOffset();
+}
+
+// A literal of the statement is bound to a parameter if it is covered by the
+// replaced literals of a single parameter, one of which has the location,
+// type and value of the literal.
+void BindLiterals(const StatementFingerprint& fingerprint,
+                  const LiteralReplacementMap& literal_map,
+                  std::vector<std::string>* literal_parameters) {
+  for (int i = 0; i < fingerprint.literals.size(); ++i) {
+    const ParseLocationRange& token_location = fingerprint.literal_locations[i];
+    absl::flat_hash_set<absl::string_view> covering_parameters;
+    absl::string_view exact_parameter;
+    for (const auto& [literal, name] : literal_map) {
+      const ParseLocationRange* location =
+          literal->GetParseLocationRangeOrNULL();
+      if (location == nullptr || !Contains(*location, token_location)) {
+        continue;
+      }
+      covering_parameters.insert(name);
+      if (IsSameRange(*location, token_location) &&
+          literal->value().type()->Equals(fingerprint.literals[i].type()) &&
+          literal->value() == fingerprint.literals[i]) {
+        exact_parameter = name;
+      }
+    }
+    if (covering_parameters.size() == 1 && !exact_parameter.empty()) {
+      (*literal_parameters)[i] = std::string(exact_parameter);
+    }
+  }
+}
+
+}  // namespace
+
+PreparedQueryCache::PreparedQueryCache(
+    int64_t capacity, const AnalyzerOptions& options, Catalog* catalog,
+    const EvaluatorOptions& evaluator_options)
+    : capacity_(capacity),
+      options_(options),
+      catalog_(catalog),
+      evaluator_options_(evaluator_options) {
+  ABSL_CHECK_GT(capacity, 0);
+  ABSL_CHECK(catalog != nullptr);
+  // As in AnalyzerOutputCache, each analysis creates its own arenas, so that
+  // concurrent misses can prepare with 'options_'.
+  options_.set_arena(nullptr);
+  options_.set_id_string_pool(nullptr);
+  if (evaluator_options_.type_factory == nullptr) {
+    owned_type_factory_ = std::make_unique<TypeFactory>();
+    evaluator_options_.type_factory = owned_type_factory_.get();
+  }
+}
+
+absl::StatusOr<PreparedQueryCache::BoundQuery> PreparedQueryCache::GetOrPrepare(
+    absl::string_view sql) {
+  StatementFingerprint fingerprint;
+  if (options_.parameter_mode() == PARAMETER_POSITIONAL ||
+      !GetStatementFingerprint(sql, options_.language(), &fingerprint).ok()) {
+    // Tokenization errors are returned by Prepare().
+    BoundQuery bound;
+    ZETASQL_ASSIGN_OR_RETURN(bound.query, PrepareQuery(sql, options_));
+    return bound;
+  }
+
+  const std::optional<int64_t> version = catalog_->GetVersion();
+  {
+    absl::MutexLock lock(&mutex_);
+    if (version.has_value() &&
+        (!catalog_version_.has_value() || *version > *catalog_version_)) {
+      ClearLocked();
+      catalog_version_ = version;
+    }
+    if (version.has_value() && version == catalog_version_) {
+      auto it = index_.find(fingerprint.hash);
+      if (it != index_.end() && Matches(*it->second->second, fingerprint)) {
+        ++hits_;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return Bind(*it->second->second, fingerprint);
+      }
+    }
+    ++misses_;
+  }
+
+  // 'mutex_' is not held, so that other threads can look up other statements
+  // meanwhile.
+  ZETASQL_ASSIGN_OR_RETURN(std::shared_ptr<const CacheEntry> entry,
+                   CreateEntry(sql, fingerprint));
+  if (!version.has_value()) {
+    return Bind(*entry, fingerprint);
+  }
+
+  absl::MutexLock lock(&mutex_);
+  if (version != catalog_version_) {
+    // The Catalog changed in the meantime.
+    return Bind(*entry, fingerprint);
+  }
+  auto it = index_.find(fingerprint.hash);
+  if (it != index_.end()) {
+    if (Matches(*it->second->second, fingerprint)) {
+      // Another thread prepared the same shape in the meantime.
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return Bind(*it->second->second, fingerprint);
+    }
+    // The entry is for other values of the literals that are not bound to
+    // parameters, so it is replaced.
+    entries_.erase(it->second);
+    index_.erase(it);
+  }
+  entries_.emplace_front(fingerprint.hash, entry);
+  index_.emplace(fingerprint.hash, entries_.begin());
+  if (static_cast<int64_t>(entries_.size()) > capacity_) {
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+  return Bind(*entry, fingerprint);
+}
+
+absl::StatusOr<std::shared_ptr<const PreparedQueryCache::CacheEntry>>
+PreparedQueryCache::CreateEntry(absl::string_view sql,
+                                const StatementFingerprint& fingerprint) const {
+  auto entry = std::make_shared<CacheEntry>();
+  entry->literals = fingerprint.literals;
+  entry->literal_parameters.resize(fingerprint.literals.size());
+
+  AnalyzerOptions analyzer_options = options_;
+  if (analyzer_options.parse_location_record_type() ==
+      PARSE_LOCATION_RECORD_NONE) {
+    analyzer_options.set_record_parse_locations(true);
+  }
+  std::unique_ptr<const AnalyzerOutput> analyzer_output;
+  ZETASQL_RETURN_IF_ERROR(AnalyzeStatement(sql, analyzer_options, catalog_,
+                                   evaluator_options_.type_factory,
+                                   &analyzer_output));
+  const ResolvedStatement* statement = analyzer_output->resolved_statement();
+
+  LiteralReplacementMap literal_map;
+  GeneratedParameterMap generated_parameters;
+  std::string parameterized_sql;
+  if (statement->node_kind() == RESOLVED_QUERY_STMT &&
+      ReplaceLiteralsByParameters(sql, LiteralReplacementOptions(),
+                                  analyzer_options, statement, &literal_map,
+                                  &generated_parameters, &parameterized_sql)
+          .ok() &&
+      !generated_parameters.empty()) {
+    BindLiterals(fingerprint, literal_map, &entry->literal_parameters);
+    entry->fixed_parameters.insert(generated_parameters.begin(),
+                                   generated_parameters.end());
+    for (const std::string& name : entry->literal_parameters) {
+      if (!name.empty()) entry->fixed_parameters.erase(name);
+    }
+
+    AnalyzerOptions parameterized_options = options_;
+    absl::Status status;
+    for (const auto& [name, value] : generated_parameters) {
+      status.Update(parameterized_options.AddQueryParameter(name, value.type()));
+    }
+    if (status.ok()) {
+      absl::StatusOr<std::shared_ptr<const PreparedQuery>> query =
+          PrepareQuery(parameterized_sql, parameterized_options);
+      if (query.ok()) {
+        entry->query = *std::move(query);
+        return entry;
+      }
+    }
+  }
+
+  // The query is prepared as written, so all the literals must be the same.
+  entry->literal_parameters.assign(fingerprint.literals.size(), "");
+  entry->fixed_parameters.clear();
+  ZETASQL_ASSIGN_OR_RETURN(entry->query, PrepareQuery(sql, options_));
+  return entry;
+}
+
+absl::StatusOr<std::shared_ptr<const PreparedQuery>>
+PreparedQueryCache::PrepareQuery(absl::string_view sql,
+                                 const AnalyzerOptions& options) const {
+  auto query =
+      std::make_shared<PreparedQuery>(std::string(sql), evaluator_options_);
+  ZETASQL_RETURN_IF_ERROR(query->Prepare(options, catalog_));
+  return query;
+}
+
+bool PreparedQueryCache::Matches(const CacheEntry& entry,
+                                 const StatementFingerprint& fingerprint) {
+  if (entry.literals.size() != fingerprint.literals.size()) return false;
+  for (int i = 0; i < entry.literals.size(); ++i) {
+    if (entry.literal_parameters[i].empty() &&
+        !(entry.literals[i].type()->Equals(fingerprint.literals[i].type()) &&
+          entry.literals[i] == fingerprint.literals[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+PreparedQueryCache::BoundQuery PreparedQueryCache::Bind(
+    const CacheEntry& entry, const StatementFingerprint& fingerprint) {
+  BoundQuery bound;
+  bound.query = entry.query;
+  bound.parameters = entry.fixed_parameters;
+  for (int i = 0; i < entry.literal_parameters.size(); ++i) {
+    if (!entry.literal_parameters[i].empty()) {
+      bound.parameters[entry.literal_parameters[i]] = fingerprint.literals[i];
+    }
+  }
+  return bound;
+}
+
+void PreparedQueryCache::Clear() {
+  absl::MutexLock lock(&mutex_);
+  ClearLocked();
+}
+
+void PreparedQueryCache::ClearLocked() {
+  index_.clear();
+  entries_.clear();
+}
+
+int64_t PreparedQueryCache::size() const {
+  absl::MutexLock lock(&mutex_);
+  return entries_.size();
+}
+
+int64_t PreparedQueryCache::hits() const {
+  absl::MutexLock lock(&mutex_);
+  return hits_;
+}
+
+int64_t PreparedQueryCache::misses() const {
+  absl::MutexLock lock(&mutex_);
+  return misses_;
+}
+
+}  // namespace zetasql
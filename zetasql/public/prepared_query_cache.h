@@ -0,0 +1,166 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_PREPARED_QUERY_CACHE_H_
+#define ZETASQL_PUBLIC_PREPARED_QUERY_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/analyzer_options.h"
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/evaluator.h"
+#include "zetasql/public/parse_tokens.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/numeric/int128.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+
+namespace zetasql {
+
+// A bounded, thread-safe cache of PreparedQueries, for callers that run many
+// queries that only differ in their literals, such as queries generated by
+// tools that do not use query parameters.
+//
+// Entries are keyed on the fingerprint of the statement (see
+// GetStatementFingerprint()), so that the statement is neither analyzed nor
+// algebrized on a hit. On a miss, the literals of the statement are replaced
+// by query parameters (see ReplaceLiteralsByParameters()) and the query is
+// prepared in that form. A hit binds the literals of the new statement to
+// those parameters. Literals that the analyzer does not turn into a parameter
+// of their own type, such as ordinals in ORDER BY, the string of a DATE
+// literal or coerced literals, are part of the entry instead: a statement
+// only hits if those are the same. If the parameterized query fails to
+// prepare, the query is prepared as written, with all its literals in the
+// entry.
+//
+// As for AnalyzerOutputCache, a cache prepares with the AnalyzerOptions,
+// Catalog and EvaluatorOptions that it is constructed with, entries are only
+// reused while Catalog::GetVersion() returns the version they were prepared
+// at, and nothing is cached if the Catalog has no version. Statements with
+// positional query parameters are not cached.
+class PreparedQueryCache {
+ public:
+  // A prepared query and the values of the parameters that replaced the
+  // literals of a statement. The query is shared with other callers and stays
+  // valid for as long as it is held, even after it was evicted.
+  struct BoundQuery {
+    std::shared_ptr<const PreparedQuery> query;
+    // The values of the generated parameters. The values of the parameters of
+    // the AnalyzerOptions must be added to these before execution.
+    ParameterValueMap parameters;
+  };
+
+  // 'capacity' is the maximum number of statements, and must be positive.
+  // 'catalog' and 'evaluator_options.type_factory', if set, must outlive the
+  // cache and all queries that it returns. Without a TypeFactory, the cache
+  // owns one, and its queries must not outlive it. The arena and IdStringPool
+  // of 'options' are not used.
+  PreparedQueryCache(int64_t capacity, const AnalyzerOptions& options,
+                     Catalog* catalog,
+                     const EvaluatorOptions& evaluator_options);
+
+  PreparedQueryCache(const PreparedQueryCache&) = delete;
+  PreparedQueryCache& operator=(const PreparedQueryCache&) = delete;
+
+  // Returns a prepared query that evaluates <sql> when executed with the
+  // returned parameters, e.g.
+  //   ZETASQL_ASSIGN_OR_RETURN(PreparedQueryCache::BoundQuery bound,
+  //                    cache.GetOrPrepare(sql));
+  //   ZETASQL_ASSIGN_OR_RETURN(
+  //       std::unique_ptr<EvaluatorTableIterator> iter,
+  //       bound.query->ExecuteAfterPrepare({.parameters = bound.parameters}));
+  // 'bound.query' must outlive 'iter'.
+  absl::StatusOr<BoundQuery> GetOrPrepare(absl::string_view sql);
+
+  // Drops all entries, e.g. after a change that the version of the Catalog
+  // does not reflect.
+  void Clear();
+
+  // Returns the number of cached statement shapes.
+  int64_t size() const;
+
+  // Returns how many calls to GetOrPrepare() found a query for their
+  // statement in the cache, and how many had to prepare one.
+  int64_t hits() const;
+  int64_t misses() const;
+
+ private:
+  // A query prepared for one statement and its literals.
+  struct CacheEntry {
+    std::shared_ptr<const PreparedQuery> query;
+    // The literals of the statement that the query was prepared for.
+    std::vector<Value> literals;
+    // For each of 'literals', the name of the parameter that it is bound to,
+    // or empty if the literal must be the same to reuse 'query'.
+    std::vector<std::string> literal_parameters;
+    // The generated parameters that are not bound to a single literal, with
+    // the values of the statement that the query was prepared for.
+    ParameterValueMap fixed_parameters;
+  };
+  using Entry = std::pair<absl::uint128, std::shared_ptr<const CacheEntry>>;
+
+  // Prepares the query for <sql>, whose fingerprint is 'fingerprint'.
+  absl::StatusOr<std::shared_ptr<const CacheEntry>> CreateEntry(
+      absl::string_view sql, const StatementFingerprint& fingerprint) const;
+
+  // Prepares <sql> as written, with the additional parameters of 'options'.
+  absl::StatusOr<std::shared_ptr<const PreparedQuery>> PrepareQuery(
+      absl::string_view sql, const AnalyzerOptions& options) const;
+
+  // Returns whether 'entry' can evaluate a statement with 'fingerprint'.
+  static bool Matches(const CacheEntry& entry,
+                      const StatementFingerprint& fingerprint);
+
+  // Binds the literals of 'fingerprint' to the parameters of 'entry'.
+  static BoundQuery Bind(const CacheEntry& entry,
+                         const StatementFingerprint& fingerprint);
+
+  void ClearLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const int64_t capacity_;
+  // Without arenas.
+  AnalyzerOptions options_;
+  Catalog* const catalog_;
+  // Owns the types of the queries if 'evaluator_options' has no TypeFactory.
+  std::unique_ptr<TypeFactory> owned_type_factory_;
+  EvaluatorOptions evaluator_options_;
+
+  mutable absl::Mutex mutex_;
+  // The version of the Catalog that all entries were prepared at, once one
+  // was seen.
+  std::optional<int64_t> catalog_version_ ABSL_GUARDED_BY(mutex_);
+  // Most recently used first.
+  std::list<Entry> entries_ ABSL_GUARDED_BY(mutex_);
+  // Keyed on the fingerprints in 'entries_'.
+  absl::flat_hash_map<absl::uint128, std::list<Entry>::iterator> index_
+      ABSL_GUARDED_BY(mutex_);
+  int64_t hits_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t misses_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_PREPARED_QUERY_CACHE_H_
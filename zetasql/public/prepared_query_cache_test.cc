@@ -0,0 +1,186 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/prepared_query_cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/analyzer_options.h"
+#include "zetasql/public/builtin_function_options.h"
+#include "zetasql/public/evaluator.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/types/type_factory.h"
+#include "zetasql/public/value.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+
+namespace zetasql {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::zetasql_base::testing::IsOkAndHolds;
+using ::zetasql_base::testing::StatusIs;
+
+// A SimpleCatalog whose version is set by the test.
+class VersionedCatalog : public SimpleCatalog {
+ public:
+  explicit VersionedCatalog(TypeFactory* type_factory)
+      : SimpleCatalog("versioned", type_factory) {}
+
+  std::optional<int64_t> GetVersion() const override { return version_; }
+
+  void set_version(std::optional<int64_t> version) { version_ = version; }
+
+ private:
+  std::optional<int64_t> version_ = 1;
+};
+
+class PreparedQueryCacheTest : public ::testing::Test {
+ protected:
+  PreparedQueryCacheTest() : catalog_(&type_factory_) {
+    catalog_.AddBuiltinFunctions(BuiltinFunctionOptions::AllReleasedFunctions());
+    auto table = std::make_unique<SimpleTable>(
+        "t", std::vector<SimpleTable::NameAndType>{
+                 {"a", type_factory_.get_int64()}});
+    table->SetContents(
+        {{Value::Int64(1)}, {Value::Int64(2)}, {Value::Int64(3)}});
+    catalog_.AddOwnedTable(std::move(table));
+    evaluator_options_.type_factory = &type_factory_;
+  }
+
+  // Returns the first column of the rows of 'bound'.
+  absl::StatusOr<std::vector<Value>> Execute(
+      const PreparedQueryCache::BoundQuery& bound) {
+    PreparedQuery::QueryOptions query_options;
+    query_options.parameters = bound.parameters;
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> iter,
+                     bound.query->ExecuteAfterPrepare(query_options));
+    std::vector<Value> values;
+    while (iter->NextRow()) {
+      values.push_back(iter->GetValue(0));
+    }
+    ZETASQL_RETURN_IF_ERROR(iter->Status());
+    return values;
+  }
+
+  TypeFactory type_factory_;
+  VersionedCatalog catalog_;
+  AnalyzerOptions options_;
+  EvaluatorOptions evaluator_options_;
+};
+
+TEST_F(PreparedQueryCacheTest, BindsLiteralsToSharedQuery) {
+  PreparedQueryCache cache(/*capacity=*/10, options_, &catalog_,
+                           evaluator_options_);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      PreparedQueryCache::BoundQuery first,
+      cache.GetOrPrepare("SELECT a FROM t WHERE a > 1 ORDER BY a"));
+  EXPECT_THAT(Execute(first),
+              IsOkAndHolds(ElementsAre(Value::Int64(2), Value::Int64(3))));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      PreparedQueryCache::BoundQuery second,
+      cache.GetOrPrepare("select a from t where a > 2 order by a;"));
+  EXPECT_EQ(second.query, first.query);
+  EXPECT_THAT(Execute(second), IsOkAndHolds(ElementsAre(Value::Int64(3))));
+  EXPECT_EQ(cache.hits(), 1);
+  EXPECT_EQ(cache.misses(), 1);
+  EXPECT_EQ(cache.size(), 1);
+}
+
+TEST_F(PreparedQueryCacheTest, LiteralsThatAreNotParametersMustMatch) {
+  PreparedQueryCache cache(/*capacity=*/10, options_, &catalog_,
+                           evaluator_options_);
+  // The ordinals of ORDER BY are not literals of the query.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(PreparedQueryCache::BoundQuery first,
+                       cache.GetOrPrepare("SELECT a, -a FROM t ORDER BY 1"));
+  EXPECT_THAT(first.parameters, IsEmpty());
+  EXPECT_THAT(Execute(first), IsOkAndHolds(ElementsAre(Value::Int64(1),
+                                                       Value::Int64(2),
+                                                       Value::Int64(3))));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(PreparedQueryCache::BoundQuery second,
+                       cache.GetOrPrepare("SELECT a, -a FROM t ORDER BY 2"));
+  EXPECT_NE(second.query, first.query);
+  EXPECT_THAT(Execute(second), IsOkAndHolds(ElementsAre(Value::Int64(3),
+                                                        Value::Int64(2),
+                                                        Value::Int64(1))));
+  EXPECT_EQ(cache.hits(), 0);
+  EXPECT_EQ(cache.size(), 1);
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(PreparedQueryCache::BoundQuery third,
+                       cache.GetOrPrepare("SELECT a, -a FROM t ORDER BY 2"));
+  EXPECT_EQ(third.query, second.query);
+  EXPECT_EQ(cache.hits(), 1);
+}
+
+TEST_F(PreparedQueryCacheTest, InvalidatesOnNewCatalogVersion) {
+  PreparedQueryCache cache(/*capacity=*/10, options_, &catalog_,
+                           evaluator_options_);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(PreparedQueryCache::BoundQuery first,
+                       cache.GetOrPrepare("SELECT a + 1 FROM t"));
+  EXPECT_THAT(cache.GetOrPrepare("SELECT b FROM t"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_EQ(cache.size(), 1);
+
+  catalog_.set_version(2);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(PreparedQueryCache::BoundQuery second,
+                       cache.GetOrPrepare("SELECT a + 2 FROM t"));
+  EXPECT_NE(second.query, first.query);
+  EXPECT_EQ(cache.hits(), 0);
+  // The evicted query is still valid.
+  ZETASQL_EXPECT_OK(Execute(first));
+
+  catalog_.set_version(std::nullopt);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(PreparedQueryCache::BoundQuery third,
+                       cache.GetOrPrepare("SELECT a + 3 FROM t"));
+  EXPECT_NE(third.query, second.query);
+  EXPECT_EQ(cache.misses(), 4);
+
+  cache.Clear();
+  EXPECT_EQ(cache.size(), 0);
+}
+
+TEST_F(PreparedQueryCacheTest, EvictsLeastRecentlyUsed) {
+  PreparedQueryCache cache(/*capacity=*/2, options_, &catalog_,
+                           evaluator_options_);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(PreparedQueryCache::BoundQuery one,
+                       cache.GetOrPrepare("SELECT 1"));
+  ZETASQL_EXPECT_OK(cache.GetOrPrepare("SELECT 'a'"));
+  ZETASQL_EXPECT_OK(cache.GetOrPrepare("SELECT 2"));
+  ZETASQL_EXPECT_OK(cache.GetOrPrepare("SELECT 1.5"));
+  EXPECT_EQ(cache.size(), 2);
+  // "SELECT 'a'" was evicted, "SELECT 1" was not.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(PreparedQueryCache::BoundQuery again,
+                       cache.GetOrPrepare("SELECT 3"));
+  EXPECT_EQ(again.query, one.query);
+  EXPECT_THAT(Execute(again), IsOkAndHolds(ElementsAre(Value::Int64(3))));
+  const int64_t misses = cache.misses();
+  ZETASQL_EXPECT_OK(cache.GetOrPrepare("SELECT 'b'"));
+  EXPECT_EQ(cache.misses(), misses + 1);
+}
+
+}  // namespace
+}  // namespace zetasql
@@ -1003,11 +1003,46 @@ using ElementValueList = std::vector<std::vector<absl::StatusOr<Value>>>;
 
 }  // namespace
 
-absl::Status ReadProtoFields(
+absl::StatusOr<std::unique_ptr<internal::ProtoFieldIndex>>
+BuildProtoFieldIndex(const absl::Cord& bytes) {
+  auto index = std::make_unique<internal::ProtoFieldIndex>();
+  google::protobuf::io::CordInputStream cord_stream(&bytes);
+  google::protobuf::io::CodedInputStream in(&cord_stream);
+  int begin = in.CurrentPosition();
+  uint32_t tag_and_type;
+  while (0 < (tag_and_type = in.ReadTag())) {
+    const int tag_number = WireFormatLite::GetTagFieldNumber(tag_and_type);
+    if (ABSL_PREDICT_FALSE(!WireFormatLite::SkipField(&in, tag_and_type))) {
+      return ::zetasql_base::OutOfRangeErrorBuilder()
+             << "Corrupted protocol buffer: "
+             << "Failed to skip field with tag number " << tag_number;
+    }
+    const int end = in.CurrentPosition();
+    std::vector<std::pair<int, int>>& ranges = index->field_ranges[tag_number];
+    if (!ranges.empty() && ranges.back().second == begin) {
+      ranges.back().second = end;
+    } else {
+      ranges.emplace_back(begin, end);
+    }
+    begin = end;
+  }
+  index->physical_byte_size = sizeof(internal::ProtoFieldIndex);
+  for (const auto& [tag_number, ranges] : index->field_ranges) {
+    index->physical_byte_size +=
+        sizeof(std::pair<const int, std::vector<std::pair<int, int>>>) +
+        ranges.capacity() * sizeof(std::pair<int, int>);
+  }
+  return index;
+}
+
+// Implements both forms of ReadProtoFields(). 'index' may be nullptr.
+static absl::Status ReadProtoFieldsImpl(
     absl::Span<const ProtoFieldInfo* const> field_infos,
-    const absl::Cord& bytes, ProtoFieldValueList* field_value_list) {
+    const absl::Cord& bytes, const internal::ProtoFieldIndex* index,
+    ProtoFieldValueList* field_value_list) {
+  // The index already avoids scanning the fields that are not read.
   const bool use_optimization =
-      field_infos.size() == 1 &&
+      index == nullptr && field_infos.size() == 1 &&
       absl::GetFlag(FLAGS_zetasql_read_proto_field_optimized_path);
 
   if (use_optimization) {
@@ -1030,8 +1065,11 @@ absl::Status ReadProtoFields(
   ElementValueList element_value_list(field_infos.size());
   ZETASQL_RET_CHECK(!field_infos.empty());
   const google::protobuf::FieldDescriptor* some_field = field_infos[0]->descriptor;
+  // Reads all the (tag, value) pairs in 'proto_bytes', which is either 'bytes'
+  // or a range of it recorded by 'index'.
+  auto read_tags = [&](const absl::Cord& proto_bytes) -> absl::Status {
     uint32_t tag_and_type;
-    google::protobuf::io::CordInputStream cord_stream(&bytes);
+    google::protobuf::io::CordInputStream cord_stream(&proto_bytes);
     google::protobuf::io::CodedInputStream in(&cord_stream);
     while (0 < (tag_and_type = in.ReadTag())) {
       const int tag_number = WireFormatLite::GetTagFieldNumber(tag_and_type);
@@ -1069,7 +1107,7 @@ absl::Status ReadProtoFields(
       } else {
         WireValueType wire_value;
         if (ABSL_PREDICT_FALSE(!ReadWireValue(descriptor->type(), tag_and_type,
-                                              bytes, &in, &wire_value))) {
+                                              proto_bytes, &in, &wire_value))) {
           return zetasql_base::OutOfRangeErrorBuilder()
                  << "Corrupted protocol buffer: Failed to read value for field "
                  << descriptor->full_name();
@@ -1102,6 +1140,23 @@ absl::Status ReadProtoFields(
         }
       }
     }
+    return absl::OkStatus();
+  };
+  if (index == nullptr) {
+    ZETASQL_RETURN_IF_ERROR(read_tags(bytes));
+  } else {
+    // Each ProtoFieldInfo only gets values from the ranges of its own field,
+    // and those are read in wire order, so the result is the same as for
+    // reading the whole proto.
+    for (const auto& [tag_number, info_idxs] : field_info_map) {
+      const std::vector<std::pair<int, int>>* ranges =
+          zetasql_base::FindOrNull(index->field_ranges, tag_number);
+      if (ranges == nullptr) continue;
+      for (const auto& [begin, end] : *ranges) {
+        ZETASQL_RETURN_IF_ERROR(read_tags(bytes.Subcord(begin, end - begin)));
+      }
+    }
+  }
 
   // Now that we have read all of the values we care about, use them to populate
   // 'field_value_list'.
@@ -1169,6 +1224,20 @@ absl::Status ReadProtoFields(
   return absl::OkStatus();
 }
 
+absl::Status ReadProtoFields(
+    absl::Span<const ProtoFieldInfo* const> field_infos,
+    const absl::Cord& bytes, ProtoFieldValueList* field_value_list) {
+  return ReadProtoFieldsImpl(field_infos, bytes, /*index=*/nullptr,
+                             field_value_list);
+}
+
+absl::Status ReadProtoFields(
+    absl::Span<const ProtoFieldInfo* const> field_infos,
+    const absl::Cord& bytes, const internal::ProtoFieldIndex& index,
+    ProtoFieldValueList* field_value_list) {
+  return ReadProtoFieldsImpl(field_infos, bytes, &index, field_value_list);
+}
+
 absl::Status ReadProtoField(const google::protobuf::FieldDescriptor* field_descr,
                             FieldFormat::Format format, const Type* type,
                             const Value& default_value, bool get_has_bit,
@@ -1219,6 +1288,52 @@ absl::Status ProtoHasField(
   return absl::OkStatus();
 }
 
+absl::StatusOr<const google::protobuf::FieldDescriptor*> ReadSetOneofField(
+    const google::protobuf::OneofDescriptor* oneof, const absl::Cord& bytes) {
+  ZETASQL_RET_CHECK(oneof != nullptr);
+  const google::protobuf::FieldDescriptor* set_field = nullptr;
+  google::protobuf::io::CordInputStream cord_stream(&bytes);
+  google::protobuf::io::CodedInputStream in(&cord_stream);
+  uint32_t tag_and_type;
+  while (0 < (tag_and_type = in.ReadTag())) {
+    const int tag_number = WireFormatLite::GetTagFieldNumber(tag_and_type);
+    const google::protobuf::FieldDescriptor* field =
+        oneof->containing_type()->FindFieldByNumber(tag_number);
+    // A member occurrence with the wrong wire type is an unknown field to the
+    // proto parser, so it does not change which field is set.
+    const bool is_member =
+        field != nullptr && field->containing_oneof() == oneof &&
+        WireFormatLite::GetTagWireType(tag_and_type) ==
+            WireFormatLite::WireTypeForFieldType(
+                static_cast<WireFormatLite::FieldType>(field->type()));
+    if (is_member && field->type() == google::protobuf::FieldDescriptor::TYPE_ENUM &&
+        field->enum_type()->is_closed()) {
+      int32_t enum_value;
+      if (!WireFormatLite::ReadPrimitive<int32_t, WireFormatLite::TYPE_ENUM>(
+              &in, &enum_value)) {
+        return ::zetasql_base::OutOfRangeErrorBuilder()
+               << "Corrupted protocol buffer: Failed to read value for field "
+               << field->full_name();
+      }
+      // Proto2 keeps unknown enum values out of the oneof.
+      if (field->enum_type()->FindValueByNumber(enum_value) != nullptr) {
+        set_field = field;
+      }
+      continue;
+    }
+    if (ABSL_PREDICT_FALSE(!WireFormatLite::SkipField(&in, tag_and_type))) {
+      return ::zetasql_base::OutOfRangeErrorBuilder()
+             << "Corrupted protocol buffer: "
+             << "Failed to skip field with tag number " << tag_number << " in "
+             << oneof->containing_type()->full_name();
+    }
+    if (is_member) {
+      set_field = field;
+    }
+  }
+  return set_field;
+}
+
 bool IsProtoMap(const Type* type) {
   if (type == nullptr) {
     return false;
@@ -101,6 +101,20 @@ absl::Status ReadProtoFields(
     absl::Span<const ProtoFieldInfo* const> field_infos,
     const absl::Cord& bytes, ProtoFieldValueList* field_value_list);
 
+// Builds an index of the fields in 'bytes', a serialized proto, for reading
+// them with the form of ReadProtoFields() below. Returns an error if 'bytes'
+// is corrupted.
+absl::StatusOr<std::unique_ptr<internal::ProtoFieldIndex>>
+BuildProtoFieldIndex(const absl::Cord& bytes);
+
+// Same as above, but only parses the byte ranges that 'index', built from
+// 'bytes' by BuildProtoFieldIndex(), records for the fields in 'field_infos'.
+// This is faster when 'bytes' has many other fields.
+absl::Status ReadProtoFields(
+    absl::Span<const ProtoFieldInfo* const> field_infos,
+    const absl::Cord& bytes, const internal::ProtoFieldIndex& index,
+    ProtoFieldValueList* field_value_list);
+
 // Convenience form of ReadProtoFields() for reading a single field. Reads the
 // proto field matching tag and type of 'field_descr' from 'bytes' and returns
 // the result in 'output_value'. If 'tag' is missing in 'bytes', returns
@@ -130,6 +144,15 @@ absl::Status ProtoHasField(
     int32_t field_tag, const absl::Cord& bytes,
     bool* has_field);
 
+// Returns the field of 'oneof' that is set in 'bytes', a serialized proto of
+// oneof->containing_type(), or nullptr if no field of 'oneof' is set. Scans the
+// wire format directly: the last occurrence of a member field in 'bytes' wins,
+// matching the proto parser, and occurrences with a mismatched wire type or an
+// unknown closed enum value are ignored. Returns an error if 'bytes' is
+// corrupted.
+absl::StatusOr<const google::protobuf::FieldDescriptor*> ReadSetOneofField(
+    const google::protobuf::OneofDescriptor* oneof, const absl::Cord& bytes);
+
 // Returns whether Type represents a protocol buffer map. A Type is a protocol
 // buffer map if it is an ARRAY<PROTO> where the array element type is a
 // protocol buffer map entry descriptor.
@@ -1080,6 +1080,111 @@ TEST_P(ReadProtoFieldsTest, SameFieldWithTwoFormats) {
   EXPECT_THAT(value_list[1], IsOkAndHolds(values::Date(10)));
 }
 
+TEST_P(ReadProtoFieldsTest, WithFieldIndex) {
+  // Concatenating two serialized protos interleaves the occurrences of their
+  // fields.
+  kitchen_sink_.set_int64_val(5);
+  kitchen_sink_.add_repeated_int32_val(1);
+  kitchen_sink_.add_repeated_int32_val(2);
+  kitchen_sink_.add_repeated_string_val("a");
+  absl::Cord bytes;
+  ABSL_CHECK(kitchen_sink_.SerializePartialToCord(&bytes));
+  kitchen_sink_.Clear();
+  kitchen_sink_.set_int64_val(7);
+  kitchen_sink_.add_repeated_int32_val(3);
+  absl::Cord more_bytes;
+  ABSL_CHECK(kitchen_sink_.SerializePartialToCord(&more_bytes));
+  bytes.Append(more_bytes);
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<internal::ProtoFieldIndex> index,
+                       BuildProtoFieldIndex(bytes));
+  const google::protobuf::Descriptor* descriptor =
+      kitchen_sink_.GetDescriptor();
+  const int repeated_int32_number =
+      descriptor->FindFieldByName("repeated_int32_val")->number();
+  EXPECT_EQ(index->field_ranges.at(repeated_int32_number).size(), 2);
+
+  std::vector<ProtoFieldInfo> infos(4);
+  infos[0].descriptor = descriptor->FindFieldByName("int64_val");
+  infos[0].type = types::Int64Type();
+  infos[0].default_value = values::Int64(0);
+  infos[1].descriptor = descriptor->FindFieldByName("repeated_int32_val");
+  infos[1].type = types::Int32ArrayType();
+  infos[2].descriptor = descriptor->FindFieldByName("int32_val");
+  infos[2].type = types::Int32Type();
+  infos[2].default_value = values::Int32(0);
+  infos[3].descriptor = descriptor->FindFieldByName("int32_val");
+  infos[3].get_has_bit = true;
+  std::vector<const ProtoFieldInfo*> info_ptrs;
+  for (const ProtoFieldInfo& info : infos) {
+    info_ptrs.push_back(&info);
+  }
+
+  ProtoFieldValueList expected;
+  ZETASQL_ASSERT_OK(ReadProtoFields(info_ptrs, bytes, &expected));
+  ProtoFieldValueList value_list;
+  ZETASQL_ASSERT_OK(ReadProtoFields(info_ptrs, bytes, *index, &value_list));
+  ASSERT_EQ(value_list.size(), 4);
+  EXPECT_THAT(value_list[0], IsOkAndHolds(values::Int64(7)));
+  EXPECT_THAT(value_list[1], IsOkAndHolds(values::Int32Array({1, 2, 3})));
+  EXPECT_THAT(value_list[2], IsOkAndHolds(values::Int32(0)));
+  EXPECT_THAT(value_list[3], IsOkAndHolds(values::Bool(false)));
+  for (int i = 0; i < value_list.size(); ++i) {
+    EXPECT_EQ(value_list[i], expected[i]);
+  }
+
+  // A single field is read from the index too.
+  value_list.clear();
+  ZETASQL_ASSERT_OK(
+      ReadProtoFields({info_ptrs[1]}, bytes, *index, &value_list));
+  EXPECT_THAT(value_list, ::testing::ElementsAre(
+                              IsOkAndHolds(values::Int32Array({1, 2, 3}))));
+}
+
+TEST(BuildProtoFieldIndex, CorruptedProto) {
+  EXPECT_THAT(BuildProtoFieldIndex(absl::Cord("\x0a\x05\x01")),
+              StatusIs(absl::StatusCode::kOutOfRange,
+                       HasSubstr("Corrupted protocol buffer")));
+}
+
+TEST(ReadSetOneofField, LastOccurrenceWins) {
+  const google::protobuf::OneofDescriptor* oneof =
+      KitchenSinkPB::descriptor()->FindOneofByName("one_of_field");
+  ASSERT_NE(oneof, nullptr);
+
+  KitchenSinkPB kitchen_sink;
+  kitchen_sink.set_int64_key_1(1);
+  kitchen_sink.set_int64_one_of(5);
+  EXPECT_THAT(ReadSetOneofField(oneof, SerializePartialToCord(kitchen_sink)),
+              IsOkAndHolds(nullptr));
+
+  KitchenSinkPB part_1;
+  part_1.set_string_one_of("foo");
+  KitchenSinkPB part_2;
+  part_2.set_int32_one_of(3);
+  absl::Cord bytes = SerializePartialToCord(part_1);
+  bytes.Append(SerializePartialToCord(part_2));
+  EXPECT_THAT(ReadSetOneofField(oneof, bytes),
+              IsOkAndHolds(KitchenSinkPB::descriptor()->FindFieldByName(
+                  "int32_one_of")));
+
+  // An occurrence with the wrong wire type is an unknown field.
+  part_2.GetReflection()->MutableUnknownFields(&part_2)->AddFixed32(
+      KitchenSinkPB::kStringOneOfFieldNumber, 7);
+  bytes = SerializePartialToCord(part_2);
+  EXPECT_THAT(ReadSetOneofField(oneof, bytes),
+              IsOkAndHolds(KitchenSinkPB::descriptor()->FindFieldByName(
+                  "int32_one_of")));
+}
+
+TEST(ReadSetOneofField, CorruptedProto) {
+  const google::protobuf::OneofDescriptor* oneof =
+      KitchenSinkPB::descriptor()->FindOneofByName("one_of_field");
+  EXPECT_THAT(ReadSetOneofField(oneof, absl::Cord("\x0a\x05\x01")),
+              StatusIs(absl::StatusCode::kOutOfRange,
+                       HasSubstr("Corrupted protocol buffer")));
+}
+
 TEST(GetProtoFieldDefault, Interval) {
   ProtoWithIntervalField proto;
   ProtoFieldDefaultOptions options;
@@ -0,0 +1,314 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/query_result_cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/evaluator.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/function.pb.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/public/value_column_codec.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/resolved_ast_fingerprint.h"
+#include "zetasql/resolved_ast/resolved_node.h"
+#include "zetasql/resolved_ast/resolved_node_kind.pb.h"
+#include "zetasql/base/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+namespace {
+
+// Iterates over a result decoded by DecodeTableResult().
+class DecodedResultIterator : public EvaluatorTableIterator {
+ public:
+  DecodedResultIterator(std::vector<const Type*> types,
+                        DecodedTableResult result)
+      : types_(std::move(types)), result_(std::move(result)) {}
+
+  int NumColumns() const override { return static_cast<int>(types_.size()); }
+  std::string GetColumnName(int i) const override {
+    return result_.column_names[i];
+  }
+  const Type* GetColumnType(int i) const override { return types_[i]; }
+
+  bool NextRow() override {
+    if (row_ < result_.num_rows) ++row_;
+    return row_ < result_.num_rows;
+  }
+
+  const Value& GetValue(int i) const override {
+    return result_.columns[i][row_];
+  }
+
+  absl::Status Status() const override { return absl::OkStatus(); }
+  absl::Status Cancel() override { return absl::OkStatus(); }
+
+ private:
+  const std::vector<const Type*> types_;
+  const DecodedTableResult result_;
+  int64_t row_ = -1;
+};
+
+// Returns whether executing 'stmt' twice over the same tables, with the same
+// parameters, returns the same result.
+bool IsDeterministic(const ResolvedQueryStmt* stmt) {
+  std::vector<const ResolvedNode*> scans;
+  stmt->GetDescendantsSatisfying(&ResolvedNode::IsScan, &scans);
+  for (const ResolvedNode* scan : scans) {
+    switch (scan->node_kind()) {
+      case RESOLVED_TVFSCAN:
+      case RESOLVED_ANONYMIZED_AGGREGATE_SCAN:
+      case RESOLVED_DIFFERENTIAL_PRIVACY_AGGREGATE_SCAN:
+        return false;
+      case RESOLVED_SAMPLE_SCAN:
+        if (scan->GetAs<ResolvedSampleScan>()->repeatable_argument() ==
+            nullptr) {
+          return false;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  std::vector<const ResolvedNode*> exprs;
+  stmt->GetDescendantsSatisfying(&ResolvedNode::IsExpression, &exprs);
+  for (const ResolvedNode* expr : exprs) {
+    switch (expr->node_kind()) {
+      case RESOLVED_FUNCTION_CALL:
+      case RESOLVED_AGGREGATE_FUNCTION_CALL:
+      case RESOLVED_ANALYTIC_FUNCTION_CALL:
+        if (expr->GetAs<ResolvedFunctionCallBase>()
+                ->function()
+                ->function_options()
+                .volatility != FunctionEnums::IMMUTABLE) {
+          return false;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  return true;
+}
+
+// Returns the tables that 'stmt' reads, without duplicates.
+std::vector<const Table*> GetScannedTables(const ResolvedQueryStmt* stmt) {
+  std::vector<const ResolvedNode*> scans;
+  stmt->GetDescendantsWithKinds({RESOLVED_TABLE_SCAN}, &scans);
+  std::vector<const Table*> tables;
+  tables.reserve(scans.size());
+  for (const ResolvedNode* scan : scans) {
+    tables.push_back(scan->GetAs<ResolvedTableScan>()->table());
+  }
+  std::sort(tables.begin(), tables.end());
+  tables.erase(std::unique(tables.begin(), tables.end()), tables.end());
+  return tables;
+}
+
+// Appends 'part' to 'key', prefixed by its length so that the parts of
+// different keys cannot be confused.
+void AppendKeyPart(absl::string_view part, std::string* key) {
+  absl::StrAppend(key, part.size(), ":", part);
+}
+
+absl::Status AppendValueToKey(const Value& value, std::string* key) {
+  AppendKeyPart(value.type()->DebugString(), key);
+  std::string encoded;
+  ZETASQL_RETURN_IF_ERROR(EncodeValueColumn(value.type(), {value}, &encoded));
+  AppendKeyPart(encoded, key);
+  return absl::OkStatus();
+}
+
+// Returns the versions of 'tables', or std::nullopt if one has no version.
+std::optional<std::vector<int64_t>> GetVersions(
+    const std::vector<const Table*>& tables) {
+  std::vector<int64_t> versions;
+  versions.reserve(tables.size());
+  for (const Table* table : tables) {
+    const std::optional<int64_t> version = table->GetVersion();
+    if (!version.has_value()) return std::nullopt;
+    versions.push_back(*version);
+  }
+  return versions;
+}
+
+// Returns the key of the result of executing 'query' with 'options' over
+// 'tables' at 'versions'.
+absl::StatusOr<std::string> MakeKey(
+    const PreparedQuery& query, const PreparedQuery::QueryOptions& options,
+    const std::vector<const Table*>& tables,
+    const std::vector<int64_t>& versions) {
+  ZETASQL_ASSIGN_OR_RETURN(const uint64_t fingerprint,
+                   FingerprintResolvedAST(query.resolved_query_stmt()));
+  std::string key = absl::StrCat(fingerprint);
+  for (int i = 0; i < tables.size(); ++i) {
+    absl::StrAppend(&key, "|t",
+                    absl::Hex(reinterpret_cast<uintptr_t>(tables[i])), "@",
+                    versions[i]);
+  }
+  if (options.parameters.has_value()) {
+    for (const auto& [name, value] : *options.parameters) {
+      absl::StrAppend(&key, "|p");
+      AppendKeyPart(name, &key);
+      ZETASQL_RETURN_IF_ERROR(AppendValueToKey(value, &key));
+    }
+  }
+  if (options.ordered_parameters.has_value()) {
+    for (const Value& value : *options.ordered_parameters) {
+      absl::StrAppend(&key, "|o");
+      ZETASQL_RETURN_IF_ERROR(AppendValueToKey(value, &key));
+    }
+  }
+  for (const auto& [path, value] : options.system_variables) {
+    absl::StrAppend(&key, "|s", path.size());
+    for (const std::string& name : path) {
+      AppendKeyPart(name, &key);
+    }
+    ZETASQL_RETURN_IF_ERROR(AppendValueToKey(value, &key));
+  }
+  return key;
+}
+
+std::vector<const Type*> GetColumnTypes(const PreparedQuery& query) {
+  std::vector<const Type*> types;
+  types.reserve(query.num_columns());
+  for (int i = 0; i < query.num_columns(); ++i) {
+    types.push_back(query.column_type(i));
+  }
+  return types;
+}
+
+absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>> DecodeResult(
+    const PreparedQuery& query, absl::string_view encoded) {
+  std::vector<const Type*> types = GetColumnTypes(query);
+  ZETASQL_ASSIGN_OR_RETURN(DecodedTableResult result,
+                   DecodeTableResult(encoded, types));
+  return std::make_unique<DecodedResultIterator>(std::move(types),
+                                                 std::move(result));
+}
+
+}  // namespace
+
+QueryResultCache::QueryResultCache(int64_t max_bytes) : max_bytes_(max_bytes) {
+  ABSL_CHECK_GT(max_bytes, 0);
+}
+
+absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>>
+QueryResultCache::Execute(const PreparedQuery& query,
+                          PreparedQuery::QueryOptions options) {
+  const ResolvedQueryStmt* stmt = query.resolved_query_stmt();
+  const std::vector<const Table*> tables = GetScannedTables(stmt);
+  const std::optional<std::vector<int64_t>> versions = GetVersions(tables);
+  if (!versions.has_value() || !IsDeterministic(stmt)) {
+    {
+      absl::MutexLock lock(&mutex_);
+      ++misses_;
+    }
+    return query.ExecuteAfterPrepare(std::move(options));
+  }
+  ZETASQL_ASSIGN_OR_RETURN(std::string key,
+                   MakeKey(query, options, tables, *versions));
+
+  std::shared_ptr<const std::string> cached;
+  {
+    absl::MutexLock lock(&mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      ++hits_;
+      entries_.splice(entries_.begin(), entries_, it->second);
+      cached = it->second->second;
+    } else {
+      ++misses_;
+    }
+  }
+  if (cached != nullptr) {
+    return DecodeResult(query, *cached);
+  }
+
+  // 'mutex_' is not held, so that other threads can look up other results
+  // meanwhile.
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> iter,
+                   query.ExecuteAfterPrepare(std::move(options)));
+  ZETASQL_ASSIGN_OR_RETURN(std::string encoded_result,
+                   EncodeTableResult(iter.get()));
+  auto encoded = std::make_shared<const std::string>(std::move(encoded_result));
+  const int64_t entry_bytes = static_cast<int64_t>(encoded->size());
+  if (entry_bytes <= max_bytes_ && GetVersions(tables) == versions) {
+    absl::MutexLock lock(&mutex_);
+    if (!index_.contains(key)) {
+      entries_.emplace_front(std::move(key), encoded);
+      index_.emplace(entries_.front().first, entries_.begin());
+      bytes_ += entry_bytes;
+      while (bytes_ > max_bytes_) {
+        bytes_ -= static_cast<int64_t>(entries_.back().second->size());
+        index_.erase(entries_.back().first);
+        entries_.pop_back();
+      }
+    }
+  }
+  return DecodeResult(query, *encoded);
+}
+
+void QueryResultCache::Clear() {
+  absl::MutexLock lock(&mutex_);
+  ClearLocked();
+}
+
+void QueryResultCache::ClearLocked() {
+  index_.clear();
+  entries_.clear();
+  bytes_ = 0;
+}
+
+int64_t QueryResultCache::size() const {
+  absl::MutexLock lock(&mutex_);
+  return entries_.size();
+}
+
+int64_t QueryResultCache::bytes() const {
+  absl::MutexLock lock(&mutex_);
+  return bytes_;
+}
+
+int64_t QueryResultCache::hits() const {
+  absl::MutexLock lock(&mutex_);
+  return hits_;
+}
+
+int64_t QueryResultCache::misses() const {
+  absl::MutexLock lock(&mutex_);
+  return misses_;
+}
+
+}  // namespace zetasql
@@ -0,0 +1,113 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_QUERY_RESULT_CACHE_H_
+#define ZETASQL_PUBLIC_QUERY_RESULT_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "zetasql/public/evaluator.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+
+namespace zetasql {
+
+// A bounded, thread-safe cache of the results of PreparedQueries, for callers
+// that execute the same deterministic queries over tables that rarely change,
+// such as dashboards that are refreshed periodically.
+//
+// Entries are keyed on the fingerprint of the resolved AST of the query (see
+// FingerprintResolvedAST()), the values of the query parameters and system
+// variables of the execution, and the version of each table that the query
+// reads (see Table::GetVersion()). A result is only cached if every table has
+// a version and the query is deterministic: all its functions must be
+// FunctionEnums::IMMUTABLE, and it must not call table-valued functions, add
+// noise for anonymization or differential privacy, or sample rows without
+// REPEATABLE. Other queries are executed as usual.
+//
+// Results are stored in the encoding of EncodeTableResult(), and the sizes of
+// those encodings are bounded by the capacity of the cache. Whenever the
+// cache is full, the least recently used results are evicted. Results that
+// are larger than the capacity, or that fail, are not cached.
+//
+// The fingerprint of a query identifies its catalog objects and Types by
+// address, so queries only share results if they were prepared against the
+// same objects, which must not be replaced by others while the cache holds
+// results for them. The EvaluatorOptions of the queries are not part of the
+// key: queries with other options, such as another default time zone, must
+// use another cache.
+class QueryResultCache {
+ public:
+  // 'max_bytes' is the maximum total size of the encoded results, and must be
+  // positive.
+  explicit QueryResultCache(int64_t max_bytes);
+
+  QueryResultCache(const QueryResultCache&) = delete;
+  QueryResultCache& operator=(const QueryResultCache&) = delete;
+
+  // Returns the result of query.ExecuteAfterPrepare(options), executing the
+  // query only if its result is not in the cache. 'query' must outlive the
+  // returned iterator. As for ExecuteAfterPrepare(), 'query' must have been
+  // prepared successfully.
+  absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>> Execute(
+      const PreparedQuery& query,
+      PreparedQuery::QueryOptions options = PreparedQuery::QueryOptions());
+
+  // Drops all entries, e.g. after a change that the versions of the tables do
+  // not reflect.
+  void Clear();
+
+  // Returns the number of cached results, and the total size of their
+  // encodings.
+  int64_t size() const;
+  int64_t bytes() const;
+
+  // Returns how many calls to Execute() found their result in the cache, and
+  // how many had to execute their query, including those whose result cannot
+  // be cached.
+  int64_t hits() const;
+  int64_t misses() const;
+
+ private:
+  // The key of a result and its encoding.
+  using Entry = std::pair<std::string, std::shared_ptr<const std::string>>;
+
+  void ClearLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const int64_t max_bytes_;
+
+  mutable absl::Mutex mutex_;
+  // Most recently used first.
+  std::list<Entry> entries_ ABSL_GUARDED_BY(mutex_);
+  // Keyed on the keys in 'entries_'.
+  absl::flat_hash_map<absl::string_view, std::list<Entry>::iterator> index_
+      ABSL_GUARDED_BY(mutex_);
+  int64_t bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t hits_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t misses_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_QUERY_RESULT_CACHE_H_
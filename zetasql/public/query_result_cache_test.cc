@@ -0,0 +1,188 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/query_result_cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/status.h"
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/analyzer_options.h"
+#include "zetasql/public/builtin_function_options.h"
+#include "zetasql/public/evaluator.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/types/type_factory.h"
+#include "zetasql/public/value.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+
+namespace zetasql {
+namespace {
+
+using ::testing::ElementsAre;
+using ::zetasql_base::testing::IsOkAndHolds;
+
+class QueryResultCacheTest : public ::testing::Test {
+ protected:
+  QueryResultCacheTest() : catalog_("test", &type_factory_) {
+    catalog_.AddBuiltinFunctions(BuiltinFunctionOptions::AllReleasedFunctions());
+    auto table = std::make_unique<SimpleTable>(
+        "t", std::vector<SimpleTable::NameAndType>{
+                 {"a", type_factory_.get_int64()}});
+    table->SetContents({{Value::Int64(2)}, {Value::Int64(1)}});
+    table_ = table.get();
+    catalog_.AddOwnedTable(std::move(table));
+    ZETASQL_CHECK_OK(
+        options_.AddQueryParameter("p", type_factory_.get_int64()));
+    evaluator_options_.type_factory = &type_factory_;
+  }
+
+  absl::StatusOr<std::unique_ptr<PreparedQuery>> Prepare(
+      const std::string& sql) {
+    auto query = std::make_unique<PreparedQuery>(sql, evaluator_options_);
+    ZETASQL_RETURN_IF_ERROR(query->Prepare(options_, &catalog_));
+    return query;
+  }
+
+  // Returns the first column of the rows of the result of 'query' with
+  // parameter 'p'.
+  absl::StatusOr<std::vector<Value>> Execute(QueryResultCache& cache,
+                                             const PreparedQuery& query,
+                                             int64_t p = 0) {
+    PreparedQuery::QueryOptions query_options;
+    query_options.parameters = ParameterValueMap{{"p", Value::Int64(p)}};
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> iter,
+                     cache.Execute(query, query_options));
+    std::vector<Value> values;
+    while (iter->NextRow()) {
+      values.push_back(iter->GetValue(0));
+    }
+    ZETASQL_RETURN_IF_ERROR(iter->Status());
+    return values;
+  }
+
+  TypeFactory type_factory_;
+  SimpleCatalog catalog_;
+  SimpleTable* table_;
+  AnalyzerOptions options_;
+  EvaluatorOptions evaluator_options_;
+};
+
+TEST_F(QueryResultCacheTest, CachesUntilTheTableChanges) {
+  QueryResultCache cache(/*max_bytes=*/1 << 20);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<PreparedQuery> query,
+                       Prepare("SELECT a + @p AS b FROM t ORDER BY a"));
+  EXPECT_THAT(Execute(cache, *query),
+              IsOkAndHolds(ElementsAre(Value::Int64(1), Value::Int64(2))));
+  EXPECT_THAT(Execute(cache, *query),
+              IsOkAndHolds(ElementsAre(Value::Int64(1), Value::Int64(2))));
+  EXPECT_EQ(cache.hits(), 1);
+  EXPECT_EQ(cache.misses(), 1);
+  EXPECT_EQ(cache.size(), 1);
+  EXPECT_GT(cache.bytes(), 0);
+
+  PreparedQuery::QueryOptions query_options;
+  query_options.parameters = ParameterValueMap{{"p", Value::Int64(0)}};
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       cache.Execute(*query, query_options));
+  ASSERT_EQ(iter->NumColumns(), 1);
+  EXPECT_EQ(iter->GetColumnName(0), "b");
+  EXPECT_TRUE(iter->GetColumnType(0)->IsInt64());
+
+  // Other parameters have results of their own.
+  EXPECT_THAT(Execute(cache, *query, /*p=*/10),
+              IsOkAndHolds(ElementsAre(Value::Int64(11), Value::Int64(12))));
+  EXPECT_EQ(cache.size(), 2);
+
+  table_->SetContents({{Value::Int64(5)}});
+  EXPECT_THAT(Execute(cache, *query),
+              IsOkAndHolds(ElementsAre(Value::Int64(5))));
+  EXPECT_EQ(cache.hits(), 2);
+  EXPECT_EQ(cache.misses(), 3);
+
+  cache.Clear();
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_EQ(cache.bytes(), 0);
+}
+
+TEST_F(QueryResultCacheTest, DoesNotCacheNonDeterministicQueries) {
+  QueryResultCache cache(/*max_bytes=*/1 << 20);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<PreparedQuery> rand,
+                       Prepare("SELECT a FROM t WHERE ABS(RAND()) < 2"));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<PreparedQuery> now,
+                       Prepare("SELECT CURRENT_TIMESTAMP()"));
+  for (int i = 0; i < 2; ++i) {
+    ZETASQL_EXPECT_OK(Execute(cache, *rand));
+    ZETASQL_EXPECT_OK(Execute(cache, *now));
+  }
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_EQ(cache.hits(), 0);
+  EXPECT_EQ(cache.misses(), 4);
+
+  // Nor queries that read tables without versions.
+  table_->SetEvaluatorTableIteratorFactory(
+      [](absl::Span<const int> column_idxs)
+          -> absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>> {
+        return absl::UnimplementedError("no rows");
+      });
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<PreparedQuery> query,
+                       Prepare("SELECT a FROM t"));
+  EXPECT_FALSE(Execute(cache, *query).ok());
+  EXPECT_EQ(cache.size(), 0);
+}
+
+TEST_F(QueryResultCacheTest, EvictsLeastRecentlyUsed) {
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<PreparedQuery> query,
+                       Prepare("SELECT a + @p FROM t ORDER BY a"));
+  int64_t result_bytes;
+  {
+    QueryResultCache cache(/*max_bytes=*/1 << 20);
+    ZETASQL_ASSERT_OK(Execute(cache, *query));
+    result_bytes = cache.bytes();
+  }
+
+  // Results of the same size, with room for two of them.
+  QueryResultCache cache(/*max_bytes=*/2 * result_bytes);
+  ZETASQL_ASSERT_OK(Execute(cache, *query, /*p=*/1));
+  ZETASQL_ASSERT_OK(Execute(cache, *query, /*p=*/2));
+  ZETASQL_ASSERT_OK(Execute(cache, *query, /*p=*/1));
+  ZETASQL_ASSERT_OK(Execute(cache, *query, /*p=*/3));
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.bytes(), 2 * result_bytes);
+  EXPECT_EQ(cache.hits(), 1);
+  // The result for p = 2 was evicted, the one for p = 1 was not.
+  ZETASQL_ASSERT_OK(Execute(cache, *query, /*p=*/1));
+  EXPECT_EQ(cache.hits(), 2);
+  ZETASQL_ASSERT_OK(Execute(cache, *query, /*p=*/2));
+  EXPECT_EQ(cache.hits(), 2);
+
+  // Results larger than the cache are not cached.
+  QueryResultCache small_cache(/*max_bytes=*/1);
+  EXPECT_THAT(Execute(small_cache, *query),
+              IsOkAndHolds(ElementsAre(Value::Int64(1), Value::Int64(2))));
+  EXPECT_EQ(small_cache.size(), 0);
+}
+
+}  // namespace
+}  // namespace zetasql
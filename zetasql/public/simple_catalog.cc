@@ -16,6 +16,7 @@
 
 #include "zetasql/public/simple_catalog.h"
 
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <map>
@@ -23,6 +24,7 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <typeinfo>
 #include <utility>
 #include <vector>
 
@@ -170,6 +172,68 @@ absl::Status SimpleCatalog::GetConstant(const std::string& name,
   return absl::OkStatus();
 }
 
+const Table* SimpleCatalog::FindTableInNestedSimpleCatalogs(
+    absl::Span<const std::string> path, int* num_names_consumed) const {
+  *num_names_consumed = 0;
+  if (path.empty() || typeid(*this) != typeid(SimpleCatalog)) {
+    return nullptr;
+  }
+  const SimpleCatalog* catalog = this;
+  for (int i = 0; i < path.size(); ++i) {
+    const std::string name = absl::AsciiStrToLower(path[i]);
+    const Catalog* next_catalog = nullptr;
+    const Table* table = nullptr;
+    {
+      absl::ReaderMutexLock l(&catalog->mutex_);
+      // Like Catalog::FindTableWithPathPrefix(), a sub-catalog takes
+      // precedence over a table with the same name, except for the last name.
+      if (i < path.size() - 1) {
+        next_catalog = zetasql_base::FindPtrOrNull(catalog->catalogs_, name);
+      }
+      if (next_catalog == nullptr) {
+        table = zetasql_base::FindPtrOrNull(catalog->tables_, name);
+      }
+    }
+    if (next_catalog == nullptr) {
+      if (table != nullptr) {
+        *num_names_consumed = i + 1;
+      }
+      return table;
+    }
+    if (typeid(*next_catalog) != typeid(SimpleCatalog)) {
+      return nullptr;
+    }
+    catalog = static_cast<const SimpleCatalog*>(next_catalog);
+  }
+  return nullptr;
+}
+
+absl::Status SimpleCatalog::FindTable(const absl::Span<const std::string>& path,
+                                      const Table** table,
+                                      const FindOptions& options) {
+  int num_names_consumed = 0;
+  const Table* found =
+      FindTableInNestedSimpleCatalogs(path, &num_names_consumed);
+  if (found != nullptr && num_names_consumed == path.size()) {
+    *table = found;
+    return absl::OkStatus();
+  }
+  return Catalog::FindTable(path, table, options);
+}
+
+absl::Status SimpleCatalog::FindTableWithPathPrefix(
+    absl::Span<const std::string> path, const FindOptions& options,
+    int* num_names_consumed, const Table** table) {
+  const Table* found =
+      FindTableInNestedSimpleCatalogs(path, num_names_consumed);
+  if (found != nullptr) {
+    *table = found;
+    return absl::OkStatus();
+  }
+  return Catalog::FindTableWithPathPrefix(path, options, num_names_consumed,
+                                          table);
+}
+
 std::string SimpleCatalog::SuggestTable(
     const absl::Span<const std::string>& mistyped_path) {
   if (mistyped_path.empty()) {
@@ -791,6 +855,28 @@ void SimpleCatalog::AddZetaSQLFunctions(
   }
 }
 
+absl::StatusOr<SimpleCatalog*> SimpleCatalog::GetOrCreateBuiltinFunctionCatalog(
+    const std::vector<std::string>& path, TypeFactory* type_factory) {
+  if (path.size() <= 1) {
+    return this;
+  }
+  ZETASQL_RET_CHECK_LE(path.size(), 2);
+  absl::MutexLock l(&mutex_);
+  const std::string& space = path[0];
+  auto sub_entry = owned_zetasql_subcatalogs_.find(space);
+  if (sub_entry != owned_zetasql_subcatalogs_.end()) {
+    ZETASQL_RET_CHECK(sub_entry->second != nullptr)
+        << "internal state corrupt: " << space;
+    return sub_entry->second.get();
+  }
+  auto new_catalog = std::make_unique<SimpleCatalog>(space, type_factory);
+  SimpleCatalog* catalog = new_catalog.get();
+  AddCatalogLocked(space, catalog);
+  ZETASQL_RET_CHECK(
+      owned_zetasql_subcatalogs_.emplace(space, std::move(new_catalog)).second);
+  return catalog;
+}
+
 absl::Status SimpleCatalog::AddBuiltinFunctionsAndTypesImpl(
     const BuiltinFunctionOptions& options, bool add_types) {
   absl::flat_hash_map<std::string, std::unique_ptr<Function>> function_map;
@@ -803,24 +889,8 @@ absl::Status SimpleCatalog::AddBuiltinFunctionsAndTypesImpl(
   for (auto& function_pair : function_map) {
     const std::vector<std::string>& path =
         function_pair.second->FunctionNamePath();
-    SimpleCatalog* catalog = this;
-    if (path.size() > 1) {
-      ZETASQL_RET_CHECK_LE(path.size(), 2);
-      absl::MutexLock l(&mutex_);
-      const std::string& space = path[0];
-      auto sub_entry = owned_zetasql_subcatalogs_.find(space);
-      if (sub_entry != owned_zetasql_subcatalogs_.end()) {
-        catalog = sub_entry->second.get();
-        ZETASQL_RET_CHECK(catalog != nullptr) << "internal state corrupt: " << space;
-      } else {
-        auto new_catalog = std::make_unique<SimpleCatalog>(space, type_factory);
-        AddCatalogLocked(space, new_catalog.get());
-        catalog = new_catalog.get();
-        ZETASQL_RET_CHECK(
-            owned_zetasql_subcatalogs_.emplace(space, std::move(new_catalog))
-                .second);
-      }
-    }
+    ZETASQL_ASSIGN_OR_RETURN(SimpleCatalog * catalog,
+                     GetOrCreateBuiltinFunctionCatalog(path, type_factory));
     catalog->AddOwnedFunction(path.back(), std::move(function_pair.second));
   }
   if (add_types) {
@@ -831,6 +901,24 @@ absl::Status SimpleCatalog::AddBuiltinFunctionsAndTypesImpl(
   return absl::OkStatus();
 }
 
+absl::Status SimpleCatalog::AddSharedBuiltinFunctionsAndTypes(
+    const BuiltinFunctionOptions& options) {
+  ZETASQL_ASSIGN_OR_RETURN(const SharedBuiltinFunctionsAndTypes* builtins,
+                   GetSharedBuiltinFunctionsAndTypes(options));
+  // We have to call type_factory() while not holding mutex_.
+  TypeFactory* type_factory = this->type_factory();
+  for (const auto& [name, function] : builtins->functions) {
+    const std::vector<std::string>& path = function->FunctionNamePath();
+    ZETASQL_ASSIGN_OR_RETURN(SimpleCatalog * catalog,
+                     GetOrCreateBuiltinFunctionCatalog(path, type_factory));
+    catalog->AddFunction(path.back(), function);
+  }
+  for (const auto& [name, type] : builtins->types) {
+    AddTypeIfNotPresent(name, type);
+  }
+  return absl::OkStatus();
+}
+
 void SimpleCatalog::AddBuiltinFunctions(const BuiltinFunctionOptions& options) {
   absl::Status status =
       this->AddBuiltinFunctionsAndTypesImpl(options, /*add_types=*/false);
@@ -1128,11 +1216,14 @@ absl::StatusOr<std::unique_ptr<SimpleCatalog>> SimpleCatalog::Deserialize(
     const ExtendedTypeDeserializer* extended_type_deserializer) {
   std::unique_ptr<SimpleCatalog> catalog(
       new SimpleCatalog(proto.name(), type_factory));
+  // Catalogs often have many columns and arguments of the same types, which
+  // are only deserialized once.
+  TypeDeserializerCache cache;
+  TypeDeserializer type_deserializer(catalog->type_factory(), pools,
+                                     extended_type_deserializer);
+  type_deserializer.set_cache(&cache);
   ZETASQL_RETURN_IF_ERROR(
-      catalog->DeserializeImpl(proto,
-                               TypeDeserializer(catalog->type_factory(), pools,
-                                                extended_type_deserializer),
-                               catalog.get()));
+      catalog->DeserializeImpl(proto, type_deserializer, catalog.get()));
   return catalog;
 }
 
@@ -1583,38 +1674,173 @@ absl::Status SimpleTable::InsertColumnToColumnMap(const Column* column) {
 }
 
 void SimpleTable::SetContents(absl::Span<const std::vector<Value>> rows) {
-  column_major_contents_.clear();
-  column_major_contents_.resize(NumColumns());
+  std::vector<std::shared_ptr<const std::vector<Value>>> columns;
+  columns.reserve(NumColumns());
   for (int i = 0; i < NumColumns(); ++i) {
     auto column_values = std::make_shared<std::vector<Value>>();
     column_values->reserve(rows.size());
     for (int j = 0; j < rows.size(); ++j) {
       column_values->push_back(rows[j][i]);
     }
-    column_major_contents_[i] = column_values;
+    columns.push_back(std::move(column_values));
   }
+  SetColumnMajorContentsInternal(std::move(columns), rows.size());
+}
 
-  num_rows_ = rows.size();
+absl::Status SimpleTable::SetColumnMajorContents(
+    std::vector<std::shared_ptr<const std::vector<Value>>> columns) {
+  if (columns.size() != NumColumns()) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder()
+           << "Expected " << NumColumns() << " columns for table "
+           << FullName() << ", but got " << columns.size();
+  }
+  const int64_t num_rows = columns.empty() ? 0 : columns[0]->size();
+  for (int i = 0; i < columns.size(); ++i) {
+    const Column* column = GetColumn(i);
+    if (columns[i]->size() != num_rows) {
+      return ::zetasql_base::InvalidArgumentErrorBuilder()
+             << "Column " << column->Name() << " of table " << FullName()
+             << " has " << columns[i]->size() << " rows, but column "
+             << GetColumn(0)->Name() << " has " << num_rows;
+    }
+    for (const Value& value : *columns[i]) {
+      if (!value.is_valid() || !value.type()->Equals(column->GetType())) {
+        return ::zetasql_base::InvalidArgumentErrorBuilder()
+               << "Column " << column->Name() << " of table " << FullName()
+               << " has type " << column->GetType()->DebugString()
+               << ", but got value " << value.DebugString();
+      }
+    }
+  }
+  SetColumnMajorContentsInternal(std::move(columns), num_rows);
+  return absl::OkStatus();
+}
+
+absl::Status SimpleTable::AddIndex(int column_idx,
+                                   ColumnValueIndex::Kind kind) {
+  ZETASQL_RET_CHECK_GE(column_idx, 0);
+  ZETASQL_RET_CHECK_LT(column_idx, NumColumns());
+  const Column* column = GetColumn(column_idx);
+  if (!ColumnValueIndex::SupportsType(kind, column->GetType())) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder()
+           << "Column " << column->Name() << " of table " << FullName()
+           << " with type " << column->GetType()->DebugString()
+           << " does not support an index of this kind";
+  }
+  index_kinds_[column_idx] = kind;
+  if (!column_major_contents_.empty()) {
+    BuildIndex(column_idx);
+  }
+  return absl::OkStatus();
+}
+
+void SimpleTable::BuildIndex(int column_idx) {
+  column_value_indexes_.resize(column_major_contents_.size());
+  column_value_indexes_[column_idx] = ColumnValueIndex::Create(
+      index_kinds_.at(column_idx), GetColumn(column_idx)->GetType(),
+      column_major_contents_[column_idx]);
+}
+
+void SimpleTable::SetColumnMajorContentsInternal(
+    std::vector<std::shared_ptr<const std::vector<Value>>> columns,
+    int64_t num_rows) {
+  column_major_contents_ = std::move(columns);
+  column_block_indexes_.clear();
+  if (num_rows > ColumnBlockIndex::kDefaultRowsPerBlock) {
+    column_block_indexes_.reserve(column_major_contents_.size());
+    for (const auto& column_values : column_major_contents_) {
+      column_block_indexes_.push_back(
+          ColumnBlockIndex::Create(*column_values));
+    }
+  }
+  column_value_indexes_.clear();
+  for (const auto& [column_idx, kind] : index_kinds_) {
+    BuildIndex(column_idx);
+  }
+
+  num_rows_ = num_rows;
+  row_count_estimate_ = num_rows_;
   auto factory = [this](absl::Span<const int> column_idxs)
       -> absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>> {
     std::vector<const Column*> columns;
     std::vector<std::shared_ptr<const std::vector<Value>>> column_values;
+    std::vector<std::shared_ptr<const ColumnBlockIndex>> block_indexes;
+    std::vector<std::shared_ptr<const ColumnValueIndex>> value_indexes;
     column_values.reserve(column_idxs.size());
-    for (const int column_idx : column_idxs) {
+    // Column filters are keyed on the index of the column in the scan.
+    absl::flat_hash_set<int> filter_column_idxs;
+    for (int i = 0; i < column_idxs.size(); ++i) {
+      const int column_idx = column_idxs[i];
       columns.push_back(GetColumn(column_idx));
       column_values.push_back(column_major_contents_[column_idx]);
+      if (!column_block_indexes_.empty()) {
+        block_indexes.push_back(column_block_indexes_[column_idx]);
+      }
+      if (!column_value_indexes_.empty()) {
+        value_indexes.push_back(column_value_indexes_[column_idx]);
+      }
+      filter_column_idxs.insert(i);
+    }
+    auto iter = std::make_unique<SimpleEvaluatorTableIterator>(
+        columns, column_values, num_rows_,
+        /*end_status=*/absl::OkStatus(), filter_column_idxs,
+        /*cancel_cb=*/[]() {},
+        /*set_deadline_cb=*/[](absl::Time t) {}, zetasql_base::Clock::RealClock());
+    if (!block_indexes.empty()) {
+      iter->SetColumnBlockIndexes(std::move(block_indexes));
+    }
+    if (!value_indexes.empty()) {
+      iter->SetColumnValueIndexes(std::move(value_indexes));
     }
-    std::unique_ptr<EvaluatorTableIterator> iter(
-        new SimpleEvaluatorTableIterator(
-            columns, column_values, num_rows_,
-            /*end_status=*/absl::OkStatus(), /*filter_column_idxs=*/
-            absl::flat_hash_set<int>(column_idxs.begin(), column_idxs.end()),
-            /*cancel_cb=*/[]() {},
-            /*set_deadline_cb=*/[](absl::Time t) {}, zetasql_base::Clock::RealClock()));
     return iter;
   };
 
   SetEvaluatorTableIteratorFactory(factory);
+  version_ = NewVersion();
+}
+
+absl::Status SimpleTable::SetColumnarContents(
+    std::vector<ColumnarRecordBatch> batches) {
+  std::vector<const Type*> column_types;
+  column_types.reserve(NumColumns());
+  for (int i = 0; i < NumColumns(); ++i) {
+    column_types.push_back(GetColumn(i)->GetType());
+  }
+  for (const ColumnarRecordBatch& batch : batches) {
+    ZETASQL_RETURN_IF_ERROR(
+        ColumnarEvaluatorTableIterator::ValidateBatch(batch, column_types));
+  }
+
+  int64_t num_rows = 0;
+  for (const ColumnarRecordBatch& batch : batches) {
+    num_rows += batch.num_rows;
+  }
+  row_count_estimate_ = num_rows;
+
+  auto shared_batches =
+      std::make_shared<const std::vector<ColumnarRecordBatch>>(
+          std::move(batches));
+  auto factory = [this, shared_batches](absl::Span<const int> column_idxs)
+      -> absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>> {
+    std::vector<const Column*> columns;
+    columns.reserve(column_idxs.size());
+    for (const int column_idx : column_idxs) {
+      columns.push_back(GetColumn(column_idx));
+    }
+    return std::make_unique<ColumnarEvaluatorTableIterator>(
+        std::move(columns),
+        std::vector<int>(column_idxs.begin(), column_idxs.end()),
+        shared_batches, zetasql_base::Clock::RealClock());
+  };
+
+  SetEvaluatorTableIteratorFactory(factory);
+  version_ = NewVersion();
+  return absl::OkStatus();
+}
+
+int64_t SimpleTable::NewVersion() {
+  static std::atomic<int64_t> next_version(1);
+  return next_version.fetch_add(1, std::memory_order_relaxed);
 }
 
 absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>>
@@ -1815,6 +2041,15 @@ absl::Status SimpleConstant::Create(
   return absl::OkStatus();
 }
 
+absl::Status SimpleConstant::SetValue(const Value& value) {
+  ZETASQL_RET_CHECK(value.is_valid());
+  ZETASQL_RET_CHECK(value.type()->Equals(type()))
+      << "Cannot change the type of constant " << FullName() << " from "
+      << type()->DebugString() << " to " << value.type()->DebugString();
+  value_ = value;
+  return absl::OkStatus();
+}
+
 std::string SimpleConstant::DebugString() const {
   return absl::StrCat(FullName(), "=", ConstantValueDebugString());
 }
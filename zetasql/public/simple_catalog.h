@@ -27,6 +27,7 @@
 
 #include "zetasql/base/logging.h"
 #include "google/protobuf/descriptor.h"
+#include "zetasql/common/columnar_evaluator_table_iterator.h"
 #include "zetasql/common/simple_evaluator_table_iterator.h"
 #include "zetasql/public/builtin_function.h"
 #include "zetasql/public/catalog.h"
@@ -123,6 +124,22 @@ class SimpleCatalog : public EnumerableCatalog {
                            const FindOptions& options = FindOptions()) override
       ABSL_LOCKS_EXCLUDED(mutex_);
 
+  // FindTable() and FindTableWithPathPrefix() resolve paths through nested
+  // SimpleCatalogs in a single walk, with one map lookup per name, instead of
+  // calling GetCatalog() and GetTable() through each level and walking the
+  // path again for each candidate prefix. Errors, and paths that reach a
+  // Catalog of any other type, go through the generic Catalog implementation.
+  absl::Status FindTable(const absl::Span<const std::string>& path,
+                         const Table** table,
+                         const FindOptions& options = FindOptions()) override
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  absl::Status FindTableWithPathPrefix(absl::Span<const std::string> path,
+                                       const FindOptions& options,
+                                       int* num_names_consumed,
+                                       const Table** table) override
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
   // For suggestions we look from the last level of <mistyped_path>:
   //  - Whether the object exists directly in sub-catalogs.
   //  - If not above, whether there is a single name that's misspelled in the
@@ -330,6 +347,14 @@ class SimpleCatalog : public EnumerableCatalog {
   absl::Status AddBuiltinFunctionsAndTypes(
       const BuiltinFunctionOptions& options) ABSL_LOCKS_EXCLUDED(mutex_);
 
+  // Same as AddBuiltinFunctionsAndTypes(), but adds the Functions and Types of
+  // GetSharedBuiltinFunctionsAndTypes() without taking ownership of them. The
+  // builtins are only built on the first call for equal `options` in the
+  // process, which makes this much cheaper for callers that set up many
+  // catalogs with the same options.
+  absl::Status AddSharedBuiltinFunctionsAndTypes(
+      const BuiltinFunctionOptions& options) ABSL_LOCKS_EXCLUDED(mutex_);
+
   // DEPRECATED - As above but using the old name.
   ABSL_DEPRECATED("Inline me!")
   absl::Status AddZetaSQLFunctionsAndTypes(
@@ -579,9 +604,25 @@ class SimpleCatalog : public EnumerableCatalog {
       bool is_table_valued_function,
       absl::Span<const std::string> mistyped_path);
 
+  // Returns the Table for the longest prefix of <path> that names a table,
+  // following the rules of Catalog::FindTableWithPathPrefix(), and sets
+  // <num_names_consumed> to the length of that prefix. Returns nullptr if there
+  // is no such table, or if the walk reaches a catalog that is not exactly a
+  // SimpleCatalog, whose lookups may be overridden.
+  const Table* FindTableInNestedSimpleCatalogs(
+      absl::Span<const std::string> path, int* num_names_consumed) const
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
   absl::Status AddBuiltinFunctionsAndTypesImpl(
       const BuiltinFunctionOptions& options, bool add_types);
 
+  // Returns the catalog that the builtin function at <path> belongs in: this
+  // catalog, or an owned sub-catalog for its namespace, which is created if
+  // needed.
+  absl::StatusOr<SimpleCatalog*> GetOrCreateBuiltinFunctionCatalog(
+      const std::vector<std::string>& path, TypeFactory* type_factory)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
   const std::string name_;
 
   mutable absl::Mutex mutex_;
@@ -764,20 +805,75 @@ class SimpleTable : public Table {
       const EvaluatorTableIteratorFactory& factory) {
     evaluator_table_iterator_factory_ =
         std::make_unique<EvaluatorTableIteratorFactory>(factory);
+    // The rows that 'factory' returns are not known to be fixed.
+    version_ = std::nullopt;
   }
 
   // Convenience method that calls SetEvaluatorTableIteratorFactory to
   // correspond to a list of rows. More specifically, sets the table contents
   // to a copy of 'rows' and sets up a callback to return those values when
   // CreateEvaluatorTableIterator() is called.
+  // Iterators skip blocks of rows that cannot match the filters passed to
+  // SetColumnFilterMap(), using the smallest and largest value of each column
+  // in each block (see ColumnBlockIndex).
   // CAVEAT: This is not preserved by serialization/deserialization.  It is only
   // relevant to users of the evaluator API defined in public/evaluator.h.
   void SetContents(absl::Span<const std::vector<Value>> rows);
 
+  // Like SetContents(), but the table contents are 'columns', where
+  // '(*columns[i])[j]' is the value of the i-th column in the j-th row. The
+  // columns are shared with the iterators instead of being copied. Returns an
+  // error if there is not one column for each column of this table, if the
+  // columns do not have the same number of rows, or if a value does not have
+  // the type of its column.
+  // CAVEAT: This is not preserved by serialization/deserialization.  It is only
+  // relevant to users of the evaluator API defined in public/evaluator.h.
+  absl::Status SetColumnMajorContents(
+      std::vector<std::shared_ptr<const std::vector<Value>>> columns);
+
+  // Like SetContents(), but the table contents are 'batches' in the Arrow
+  // columnar memory layout (see common/columnar_evaluator_table_iterator.h),
+  // which are scanned in place instead of being converted into Values up
+  // front. Returns an error if a batch does not match the columns of this
+  // table. Does not change column_major_contents().
+  // CAVEAT: This is not preserved by serialization/deserialization.  It is only
+  // relevant to users of the evaluator API defined in public/evaluator.h.
+  absl::Status SetColumnarContents(std::vector<ColumnarRecordBatch> batches);
+
+  // Declares an index of kind 'kind' on column 'column_idx', which iterators
+  // use to only read the rows that may match the filters passed to
+  // SetColumnFilterMap() instead of scanning the table (see
+  // ColumnValueIndex). A column has at most one index, so this replaces any
+  // other index of the column. Indexes are built for the contents passed to
+  // SetContents() or SetColumnMajorContents(), now and when they are set
+  // again, and are not used with SetColumnarContents(). Returns an error if
+  // the type of the column does not support 'kind'.
+  // CAVEAT: This is not preserved by serialization/deserialization.  It is only
+  // relevant to users of the evaluator API defined in public/evaluator.h.
+  absl::Status AddIndex(int column_idx, ColumnValueIndex::Kind kind);
+
   absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>>
   CreateEvaluatorTableIterator(
       absl::Span<const int> column_idxs) const override;
 
+  // Returns the value passed to the last call to SetRowCountEstimate(),
+  // SetContents() or SetColumnarContents(). A factory passed to
+  // SetEvaluatorTableIteratorFactory() does not change the estimate.
+  std::optional<int64_t> GetRowCountEstimate() const override {
+    return row_count_estimate_;
+  }
+  void SetRowCountEstimate(int64_t row_count_estimate) {
+    row_count_estimate_ = row_count_estimate;
+  }
+
+  // Returns a version that is unique across SimpleTables and changes on each
+  // call to SetContents(), SetColumnMajorContents() or SetColumnarContents().
+  // Returns std::nullopt once a factory was passed to
+  // SetEvaluatorTableIteratorFactory(), until the contents are set again.
+  // Subclasses that override CreateEvaluatorTableIterator() must override
+  // this too.
+  std::optional<int64_t> GetVersion() const override { return version_; }
+
   // Sets the <anonymization_info_> with the specified <userid_column_name>
   // (overwriting any previous anonymization info).  An error is returned if
   // the named column is ambiguous or does not exist in this table.
@@ -819,17 +915,26 @@ class SimpleTable : public Table {
       const SimpleTableProto& proto, const TypeDeserializer& deserializer);
 
  protected:
-  // Returns the current contents (passed to the last call to SetContents()) in
-  // column-major order.
+  // Returns the current contents (passed to the last call to SetContents() or
+  // SetColumnMajorContents()) in column-major order.
   const std::vector<std::shared_ptr<const std::vector<Value>>>&
   column_major_contents() const {
     return column_major_contents_;
   }
 
-  // Returns the number of rows set in the last call to SetContents().
+  // Returns the number of rows set in the last call to SetContents() or
+  // SetColumnMajorContents().
   int64_t num_rows() const { return num_rows_; }
 
  private:
+  // Builds the index declared for column 'column_idx' of the contents.
+  void BuildIndex(int column_idx);
+
+  // Sets the contents for SetContents() and SetColumnMajorContents().
+  void SetColumnMajorContentsInternal(
+      std::vector<std::shared_ptr<const std::vector<Value>>> columns,
+      int64_t num_rows);
+
   // Insert a column to columns_map_. Return error when
   // allow_anonymous_column_name_ or allow_duplicate_column_names_ are violated.
   // Furthermore, if the column's name is duplicated, it's recorded in
@@ -856,8 +961,21 @@ class SimpleTable : public Table {
   // iterators outstanding.
   int64_t num_rows_ = 0;
   std::vector<std::shared_ptr<const std::vector<Value>>> column_major_contents_;
+  // The index of each of 'column_major_contents_', or nullptr. Empty if the
+  // table has at most one block of rows.
+  std::vector<std::shared_ptr<const ColumnBlockIndex>> column_block_indexes_;
+  // The kinds of the indexes passed to AddIndex(), by column.
+  absl::flat_hash_map<int, ColumnValueIndex::Kind> index_kinds_;
+  // The index of each of 'column_major_contents_', or nullptr. Empty if no
+  // index was declared.
+  std::vector<std::shared_ptr<const ColumnValueIndex>> column_value_indexes_;
+  std::optional<int64_t> row_count_estimate_;
   std::unique_ptr<EvaluatorTableIteratorFactory>
       evaluator_table_iterator_factory_;
+  std::optional<int64_t> version_ = NewVersion();
+
+  // Returns a version that no SimpleTable had before.
+  static int64_t NewVersion();
 
   static absl::Status ValidateNonEmptyColumnName(
       const std::string& column_name);
@@ -1149,6 +1267,12 @@ class SimpleConstant : public Constant {
 
   const Value& value() const { return value_; }
 
+  // Replaces the value of this Constant, returning an error if <value> is an
+  // invalid Value or its type differs from type(). Does not affect resolved
+  // ASTs that reference this Constant, so that an analyzed statement can be
+  // prepared again for a new value without being analyzed again.
+  absl::Status SetValue(const Value& value);
+
   // Returns a string describing this Constant for debugging purposes.
   std::string DebugString() const override;
   // Same as the previous, but includes the Type debug string.
@@ -0,0 +1,308 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/simple_catalog_image.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format_lite.h"
+#include "google/protobuf/descriptor.h"
+#include "zetasql/proto/simple_catalog.pb.h"
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/constant.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/procedure.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/simple_table.pb.h"
+#include "zetasql/public/table_valued_function.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/types/type_deserializer.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+namespace {
+
+using ::google::protobuf::internal::WireFormatLite;
+
+absl::Status InvalidImageError(absl::string_view what) {
+  return ::zetasql_base::InvalidArgumentErrorBuilder()
+         << "Invalid serialized " << what << " in SimpleCatalogImage";
+}
+
+// Returns the name that SimpleCatalog::Deserialize() adds the SimpleTableProto
+// (if 'is_table') or SimpleCatalogProto in 'message' to its catalog with.
+absl::StatusOr<std::string> ReadName(absl::string_view message,
+                                     bool is_table) {
+  google::protobuf::io::CodedInputStream input(
+      reinterpret_cast<const uint8_t*>(message.data()),
+      static_cast<int>(message.size()));
+  std::string name;
+  std::string name_in_catalog;
+  bool has_name_in_catalog = false;
+  while (const uint32_t tag = input.ReadTag()) {
+    const int field_number = WireFormatLite::GetTagFieldNumber(tag);
+    const bool is_string = WireFormatLite::GetTagWireType(tag) ==
+                           WireFormatLite::WIRETYPE_LENGTH_DELIMITED;
+    if (is_string && field_number == 1) {
+      // SimpleTableProto::name and SimpleCatalogProto::name.
+      if (!WireFormatLite::ReadString(&input, &name)) break;
+    } else if (is_string && is_table &&
+               field_number == SimpleTableProto::kNameInCatalogFieldNumber) {
+      if (!WireFormatLite::ReadString(&input, &name_in_catalog)) break;
+      has_name_in_catalog = true;
+    } else if (!WireFormatLite::SkipField(&input, tag)) {
+      break;
+    }
+  }
+  if (input.CurrentPosition() != static_cast<int>(message.size())) {
+    return InvalidImageError(is_table ? "table" : "catalog");
+  }
+  return has_name_in_catalog ? name_in_catalog : name;
+}
+
+}  // namespace
+
+struct SimpleCatalogImage::Context {
+  Context(
+      absl::Span<const google::protobuf::DescriptorPool* const> descriptor_pools,
+      TypeFactory* factory,
+      const ExtendedTypeDeserializer* extended_type_deserializer)
+      : owned_type_factory(factory == nullptr ? std::make_unique<TypeFactory>()
+                                              : nullptr),
+        type_factory(factory == nullptr ? owned_type_factory.get() : factory),
+        pools(descriptor_pools.begin(), descriptor_pools.end()),
+        extended_type_deserializer(extended_type_deserializer),
+        type_deserializer(type_factory, pools, extended_type_deserializer) {
+    type_deserializer.set_cache(&type_cache);
+  }
+
+  const std::unique_ptr<TypeFactory> owned_type_factory;
+  TypeFactory* const type_factory;
+  const std::vector<const google::protobuf::DescriptorPool*> pools;
+  const ExtendedTypeDeserializer* const extended_type_deserializer;
+  // Thread-safe.
+  mutable TypeDeserializerCache type_cache;
+  // Deserializes with 'type_cache'.
+  TypeDeserializer type_deserializer;
+};
+
+absl::StatusOr<std::unique_ptr<SimpleCatalogImage>> SimpleCatalogImage::Create(
+    absl::string_view image,
+    absl::Span<const google::protobuf::DescriptorPool* const> pools,
+    TypeFactory* type_factory,
+    const ExtendedTypeDeserializer* extended_type_deserializer) {
+  auto context = std::make_shared<const Context>(pools, type_factory,
+                                                 extended_type_deserializer);
+  std::unique_ptr<SimpleCatalogImage> catalog(
+      new SimpleCatalogImage(std::move(context)));
+  ZETASQL_RETURN_IF_ERROR(catalog->Init(image));
+  return catalog;
+}
+
+absl::Status SimpleCatalogImage::Init(absl::string_view image) {
+  absl::MutexLock lock(&mutex_);
+  google::protobuf::io::CodedInputStream input(
+      reinterpret_cast<const uint8_t*>(image.data()),
+      static_cast<int>(image.size()));
+  while (true) {
+    const int start = input.CurrentPosition();
+    const uint32_t tag = input.ReadTag();
+    if (tag == 0) break;
+    const int field_number = WireFormatLite::GetTagFieldNumber(tag);
+    const bool is_table =
+        field_number == SimpleCatalogProto::kTableFieldNumber;
+    const bool is_catalog =
+        field_number == SimpleCatalogProto::kCatalogFieldNumber;
+    if ((is_table || is_catalog) &&
+        WireFormatLite::GetTagWireType(tag) ==
+            WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      uint32_t length;
+      if (!input.ReadVarint32(&length) ||
+          length > image.size() - input.CurrentPosition()) {
+        return InvalidImageError("catalog");
+      }
+      const absl::string_view message =
+          image.substr(input.CurrentPosition(), length);
+      input.Skip(static_cast<int>(length));
+      ZETASQL_ASSIGN_OR_RETURN(const std::string name,
+                       ReadName(message, is_table));
+      const std::string key = absl::AsciiStrToLower(name);
+      if (is_table) {
+        if (!tables_.try_emplace(key, LazyObject<SimpleTable>{message})
+                 .second) {
+          return ::zetasql_base::InvalidArgumentErrorBuilder()
+                 << "Duplicate table '" << name << "' in serialized catalog";
+        }
+      } else if (!catalogs_
+                      .try_emplace(key,
+                                   LazyObject<SimpleCatalogImage>{message})
+                      .second) {
+        return ::zetasql_base::InvalidArgumentErrorBuilder()
+               << "Duplicate catalog '" << name << "' in serialized catalog";
+      }
+      continue;
+    }
+
+    if (field_number == SimpleCatalogProto::kNameFieldNumber &&
+        WireFormatLite::GetTagWireType(tag) ==
+            WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      if (!WireFormatLite::ReadString(&input, &name_)) {
+        return InvalidImageError("catalog");
+      }
+    } else if (!WireFormatLite::SkipField(&input, tag)) {
+      return InvalidImageError("catalog");
+    }
+    other_fields_.append(image.substr(start, input.CurrentPosition() - start));
+  }
+  if (input.CurrentPosition() != static_cast<int>(image.size())) {
+    return InvalidImageError("catalog");
+  }
+  return absl::OkStatus();
+}
+
+absl::Status SimpleCatalogImage::GetTable(const std::string& name,
+                                          const Table** table,
+                                          const FindOptions& options) {
+  *table = nullptr;
+  absl::MutexLock lock(&mutex_);
+  auto it = tables_.find(absl::AsciiStrToLower(name));
+  if (it == tables_.end()) {
+    return absl::OkStatus();
+  }
+  LazyObject<SimpleTable>& entry = it->second;
+  if (entry.object == nullptr) {
+    SimpleTableProto proto;
+    if (!proto.ParseFromArray(entry.image.data(),
+                              static_cast<int>(entry.image.size()))) {
+      return InvalidImageError("table");
+    }
+    ZETASQL_ASSIGN_OR_RETURN(entry.object, SimpleTable::Deserialize(
+                                       proto, context_->type_deserializer));
+    ++num_deserialized_tables_;
+  }
+  *table = entry.object.get();
+  return absl::OkStatus();
+}
+
+absl::Status SimpleCatalogImage::GetCatalog(const std::string& name,
+                                            Catalog** catalog,
+                                            const FindOptions& options) {
+  *catalog = nullptr;
+  absl::MutexLock lock(&mutex_);
+  auto it = catalogs_.find(absl::AsciiStrToLower(name));
+  if (it == catalogs_.end()) {
+    return absl::OkStatus();
+  }
+  LazyObject<SimpleCatalogImage>& entry = it->second;
+  if (entry.object == nullptr) {
+    std::unique_ptr<SimpleCatalogImage> nested(
+        new SimpleCatalogImage(context_));
+    ZETASQL_RETURN_IF_ERROR(nested->Init(entry.image));
+    entry.object = std::move(nested);
+  }
+  *catalog = entry.object.get();
+  return absl::OkStatus();
+}
+
+absl::StatusOr<SimpleCatalog*> SimpleCatalogImage::GetOtherObjects() {
+  absl::MutexLock lock(&mutex_);
+  if (other_objects_ == nullptr) {
+    SimpleCatalogProto proto;
+    if (!proto.ParseFromString(other_fields_)) {
+      return InvalidImageError("catalog");
+    }
+    ZETASQL_ASSIGN_OR_RETURN(
+        other_objects_,
+        SimpleCatalog::Deserialize(proto, context_->pools,
+                                   context_->type_factory,
+                                   context_->extended_type_deserializer));
+  }
+  return other_objects_.get();
+}
+
+absl::Status SimpleCatalogImage::GetModel(const std::string& name,
+                                          const Model** model,
+                                          const FindOptions& options) {
+  ZETASQL_ASSIGN_OR_RETURN(SimpleCatalog * other_objects, GetOtherObjects());
+  return other_objects->GetModel(name, model, options);
+}
+
+absl::Status SimpleCatalogImage::GetConnection(const std::string& name,
+                                               const Connection** connection,
+                                               const FindOptions& options) {
+  ZETASQL_ASSIGN_OR_RETURN(SimpleCatalog * other_objects, GetOtherObjects());
+  return other_objects->GetConnection(name, connection, options);
+}
+
+absl::Status SimpleCatalogImage::GetFunction(const std::string& name,
+                                             const Function** function,
+                                             const FindOptions& options) {
+  ZETASQL_ASSIGN_OR_RETURN(SimpleCatalog * other_objects, GetOtherObjects());
+  return other_objects->GetFunction(name, function, options);
+}
+
+absl::Status SimpleCatalogImage::GetTableValuedFunction(
+    const std::string& name, const TableValuedFunction** function,
+    const FindOptions& options) {
+  ZETASQL_ASSIGN_OR_RETURN(SimpleCatalog * other_objects, GetOtherObjects());
+  return other_objects->GetTableValuedFunction(name, function, options);
+}
+
+absl::Status SimpleCatalogImage::GetProcedure(const std::string& name,
+                                              const Procedure** procedure,
+                                              const FindOptions& options) {
+  ZETASQL_ASSIGN_OR_RETURN(SimpleCatalog * other_objects, GetOtherObjects());
+  return other_objects->GetProcedure(name, procedure, options);
+}
+
+absl::Status SimpleCatalogImage::GetType(const std::string& name,
+                                         const Type** type,
+                                         const FindOptions& options) {
+  ZETASQL_ASSIGN_OR_RETURN(SimpleCatalog * other_objects, GetOtherObjects());
+  return other_objects->GetType(name, type, options);
+}
+
+absl::Status SimpleCatalogImage::GetConstant(const std::string& name,
+                                             const Constant** constant,
+                                             const FindOptions& options) {
+  ZETASQL_ASSIGN_OR_RETURN(SimpleCatalog * other_objects, GetOtherObjects());
+  return other_objects->GetConstant(name, constant, options);
+}
+
+int64_t SimpleCatalogImage::num_tables() const {
+  absl::MutexLock lock(&mutex_);
+  return tables_.size();
+}
+
+int64_t SimpleCatalogImage::num_deserialized_tables() const {
+  absl::MutexLock lock(&mutex_);
+  return num_deserialized_tables_;
+}
+
+}  // namespace zetasql
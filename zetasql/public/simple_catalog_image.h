@@ -0,0 +1,168 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_SIMPLE_CATALOG_IMAGE_H_
+#define ZETASQL_PUBLIC_SIMPLE_CATALOG_IMAGE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "google/protobuf/descriptor.h"
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/constant.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/procedure.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/table_valued_function.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/types/type_deserializer.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+
+namespace zetasql {
+
+// A read-only Catalog over a serialized SimpleCatalogProto, such as a file
+// that is memory-mapped, for processes that load large catalogs at startup
+// but only use a few of their tables.
+//
+// Unlike SimpleCatalog::Deserialize(), creating the catalog does not parse
+// the proto or create any objects: it only scans the serialized bytes for the
+// names of the tables and nested catalogs. A table is deserialized into a
+// SimpleTable on the first lookup of its name, and a nested catalog into
+// another SimpleCatalogImage. The types of the columns are deserialized with
+// a TypeDeserializerCache that is shared by the whole catalog. The other
+// objects of a catalog, such as functions, named types and constants, are
+// deserialized together with SimpleCatalog::Deserialize() on the first lookup
+// of any of them.
+//
+// Lookups are case-insensitive, as in SimpleCatalog. Errors in the
+// serialized objects are returned by the lookups of those objects.
+//
+// This class is thread-safe.
+class SimpleCatalogImage : public Catalog {
+ public:
+  // Returns a catalog over `image`, a SimpleCatalogProto in the binary wire
+  // format. `image` and `pools`, which are the DescriptorPools of the types
+  // as for SimpleCatalog::Deserialize(), must outlive the catalog. Types are
+  // created in `type_factory`, which must outlive the catalog too, or in a
+  // TypeFactory that the catalog owns if it is null. Returns an error if
+  // `image` is not a valid encoding, or has two tables or catalogs with the
+  // same name.
+  static absl::StatusOr<std::unique_ptr<SimpleCatalogImage>> Create(
+      absl::string_view image,
+      absl::Span<const google::protobuf::DescriptorPool* const> pools,
+      TypeFactory* type_factory = nullptr,
+      const ExtendedTypeDeserializer* extended_type_deserializer = nullptr);
+
+  SimpleCatalogImage(const SimpleCatalogImage&) = delete;
+  SimpleCatalogImage& operator=(const SimpleCatalogImage&) = delete;
+
+  std::string FullName() const override { return name_; }
+
+  absl::Status GetTable(const std::string& name, const Table** table,
+                        const FindOptions& options = FindOptions()) override
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  absl::Status GetCatalog(const std::string& name, Catalog** catalog,
+                          const FindOptions& options = FindOptions()) override
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  absl::Status GetModel(const std::string& name, const Model** model,
+                        const FindOptions& options = FindOptions()) override
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  absl::Status GetConnection(const std::string& name,
+                             const Connection** connection,
+                             const FindOptions& options) override
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  absl::Status GetFunction(const std::string& name, const Function** function,
+                           const FindOptions& options = FindOptions()) override
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  absl::Status GetTableValuedFunction(
+      const std::string& name, const TableValuedFunction** function,
+      const FindOptions& options = FindOptions()) override
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  absl::Status GetProcedure(
+      const std::string& name, const Procedure** procedure,
+      const FindOptions& options = FindOptions()) override
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  absl::Status GetType(const std::string& name, const Type** type,
+                       const FindOptions& options = FindOptions()) override
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  absl::Status GetConstant(const std::string& name, const Constant** constant,
+                           const FindOptions& options = FindOptions()) override
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Returns the number of tables in this catalog, without nested catalogs,
+  // and how many of those were deserialized.
+  int64_t num_tables() const ABSL_LOCKS_EXCLUDED(mutex_);
+  int64_t num_deserialized_tables() const ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  // The state that a catalog shares with its nested catalogs.
+  struct Context;
+
+  // A table or nested catalog, which is deserialized on its first lookup.
+  template <typename T>
+  struct LazyObject {
+    // The serialized proto.
+    absl::string_view image;
+    std::unique_ptr<T> object;
+  };
+
+  explicit SimpleCatalogImage(std::shared_ptr<const Context> context)
+      : context_(std::move(context)) {}
+
+  // Indexes the fields of the SimpleCatalogProto in `image`. Must be called
+  // once, before any lookup.
+  absl::Status Init(absl::string_view image);
+
+  // Returns the catalog of the objects of this catalog other than tables and
+  // nested catalogs, deserializing it on the first call.
+  absl::StatusOr<SimpleCatalog*> GetOtherObjects() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Set by Init().
+  std::string name_;
+  const std::shared_ptr<const Context> context_;
+
+  mutable absl::Mutex mutex_;
+  // Keyed on lower case names.
+  absl::flat_hash_map<std::string, LazyObject<SimpleTable>> tables_
+      ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<std::string, LazyObject<SimpleCatalogImage>> catalogs_
+      ABSL_GUARDED_BY(mutex_);
+  int64_t num_deserialized_tables_ ABSL_GUARDED_BY(mutex_) = 0;
+  // The serialized fields of the other objects, which form a
+  // SimpleCatalogProto of their own.
+  std::string other_fields_ ABSL_GUARDED_BY(mutex_);
+  std::unique_ptr<SimpleCatalog> other_objects_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_SIMPLE_CATALOG_IMAGE_H_
@@ -0,0 +1,105 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/simple_catalog_image.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/status.h"
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/proto/simple_catalog.pb.h"
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/types/type_factory.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+
+namespace zetasql {
+namespace {
+
+using ::zetasql_base::testing::StatusIs;
+
+std::string SerializeCatalog(const SimpleCatalog& catalog) {
+  FileDescriptorSetMap file_descriptor_set_map;
+  SimpleCatalogProto proto;
+  ZETASQL_CHECK_OK(catalog.Serialize(&file_descriptor_set_map, &proto));
+  return proto.SerializeAsString();
+}
+
+TEST(SimpleCatalogImageTest, DeserializesTablesOnLookup) {
+  TypeFactory type_factory;
+  const StructType* struct_type;
+  ZETASQL_ASSERT_OK(type_factory.MakeStructType(
+      {{"x", types::Int64Type()}, {"y", types::StringType()}}, &struct_type));
+  SimpleCatalog catalog("root", &type_factory);
+  catalog.AddOwnedTable(new SimpleTable(
+      "Orders", {{"id", types::Int64Type()}, {"item", struct_type}}));
+  catalog.AddOwnedTable(
+      new SimpleTable("Users", {{"id", types::Int64Type()}}));
+  catalog.AddType("MyStruct", struct_type);
+  auto nested = std::make_unique<SimpleCatalog>("Nested", &type_factory);
+  nested->AddOwnedTable(
+      new SimpleTable("Events", {{"item", struct_type}}));
+  catalog.AddOwnedCatalog(std::move(nested));
+  const std::string image = SerializeCatalog(catalog);
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<SimpleCatalogImage> image_catalog,
+                       SimpleCatalogImage::Create(image, /*pools=*/{}));
+  EXPECT_EQ(image_catalog->FullName(), "root");
+  EXPECT_EQ(image_catalog->num_tables(), 2);
+  EXPECT_EQ(image_catalog->num_deserialized_tables(), 0);
+
+  const Table* table;
+  ZETASQL_ASSERT_OK(image_catalog->FindTable({"orders"}, &table));
+  EXPECT_EQ(table->Name(), "Orders");
+  ASSERT_EQ(table->NumColumns(), 2);
+  EXPECT_TRUE(table->GetColumn(1)->GetType()->Equals(struct_type));
+  EXPECT_EQ(image_catalog->num_deserialized_tables(), 1);
+  const Table* again;
+  ZETASQL_ASSERT_OK(image_catalog->FindTable({"ORDERS"}, &again));
+  EXPECT_EQ(again, table);
+  EXPECT_EQ(image_catalog->num_deserialized_tables(), 1);
+
+  // Columns of tables in nested catalogs share the types of the columns of
+  // other tables.
+  const Table* events;
+  ZETASQL_ASSERT_OK(image_catalog->FindTable({"nested", "events"}, &events));
+  EXPECT_EQ(events->GetColumn(0)->GetType(), table->GetColumn(1)->GetType());
+
+  const Type* type;
+  ZETASQL_ASSERT_OK(image_catalog->FindType({"mystruct"}, &type));
+  EXPECT_TRUE(type->Equals(struct_type));
+
+  EXPECT_THAT(image_catalog->FindTable({"missing"}, &table),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+TEST(SimpleCatalogImageTest, RejectsInvalidImages) {
+  SimpleCatalogProto proto;
+  proto.add_table()->set_name("t");
+  proto.add_table()->set_name("T");
+  EXPECT_THAT(SimpleCatalogImage::Create(proto.SerializeAsString(), {}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  EXPECT_THAT(SimpleCatalogImage::Create("\x12\x05\x0a", {}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace zetasql
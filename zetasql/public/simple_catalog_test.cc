@@ -0,0 +1,243 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/simple_catalog.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/types/type_factory.h"
+#include "zetasql/public/value.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+namespace zetasql {
+namespace {
+
+using ::testing::ElementsAre;
+using ::zetasql_base::testing::StatusIs;
+
+// A subclass of SimpleCatalog, so that its lookups go through the generic
+// Catalog implementations of FindTable() and FindTableWithPathPrefix().
+class GenericLookupCatalog : public SimpleCatalog {
+ public:
+  GenericLookupCatalog(absl::string_view name, TypeFactory* type_factory)
+      : SimpleCatalog(name, type_factory) {}
+};
+
+// Adds these tables under 'root', with nested catalogs of type CatalogType:
+//   t, x (both a table and a catalog), x.u, db.t, db.x.t, db.generic.t
+// where db.generic is always a GenericLookupCatalog.
+template <typename CatalogType>
+void AddTestTables(TypeFactory* type_factory, SimpleCatalog* root) {
+  auto add_table = [type_factory](absl::string_view name,
+                                  SimpleCatalog* catalog) {
+    catalog->AddOwnedTable(std::make_unique<SimpleTable>(
+        name, std::vector<SimpleTable::NameAndType>{
+                  {"a", type_factory->get_int64()}}));
+  };
+  auto add_catalog = [type_factory](absl::string_view name,
+                                    SimpleCatalog* parent) {
+    auto catalog = std::make_unique<CatalogType>(name, type_factory);
+    SimpleCatalog* result = catalog.get();
+    parent->AddOwnedCatalog(std::move(catalog));
+    return result;
+  };
+  add_table("t", root);
+  add_table("x", root);
+  add_table("u", add_catalog("x", root));
+  SimpleCatalog* db = add_catalog("db", root);
+  add_table("T", db);
+  add_table("t", add_catalog("x", db));
+  auto generic =
+      std::make_unique<GenericLookupCatalog>("generic", type_factory);
+  add_table("t", generic.get());
+  db->AddOwnedCatalog(std::move(generic));
+}
+
+TEST(SimpleCatalog, FindTableWithPathPrefixMatchesCatalog) {
+  TypeFactory type_factory;
+  SimpleCatalog catalog("root", &type_factory);
+  AddTestTables<SimpleCatalog>(&type_factory, &catalog);
+  GenericLookupCatalog generic_catalog("root", &type_factory);
+  AddTestTables<GenericLookupCatalog>(&type_factory, &generic_catalog);
+
+  const std::vector<std::vector<std::string>> paths = {
+      {"t"},           {"T", "a"},          {"t", "a", "b"},
+      {"x"},           {"x", "u"},          {"X", "u", "a"},
+      {"x", "a"},      {"db", "t"},         {"DB", "t", "a"},
+      {"db", "x"},     {"db", "x", "t"},    {"db", "x", "t", "a"},
+      {"db", "other"}, {"db", "generic"},   {"db", "generic", "t", "a"},
+      {"missing"},     {"missing", "t"},    {"db"},
+      {"db", "x", "missing", "a"},
+  };
+  for (const std::vector<std::string>& path : paths) {
+    SCOPED_TRACE(absl::StrJoin(path, "."));
+    int num_names_consumed = -1;
+    const Table* table = nullptr;
+    int expected_num_names_consumed = -1;
+    const Table* expected_table = nullptr;
+    const absl::Status status = catalog.FindTableWithPathPrefix(
+        path, FindOptions(), &num_names_consumed, &table);
+    const absl::Status expected_status =
+        generic_catalog.FindTableWithPathPrefix(
+            path, FindOptions(), &expected_num_names_consumed,
+            &expected_table);
+    EXPECT_EQ(status, expected_status);
+    EXPECT_EQ(num_names_consumed, expected_num_names_consumed);
+    EXPECT_EQ(table == nullptr, expected_table == nullptr);
+    if (table != nullptr && expected_table != nullptr) {
+      EXPECT_EQ(table->FullName(), expected_table->FullName());
+    }
+
+    const absl::Status find_status = catalog.FindTable(path, &table);
+    const absl::Status expected_find_status =
+        generic_catalog.FindTable(path, &expected_table);
+    EXPECT_EQ(find_status, expected_find_status);
+    EXPECT_EQ(table == nullptr, expected_table == nullptr);
+  }
+}
+
+TEST(SimpleCatalog, FindTableWithPathPrefixPrefersCatalogs) {
+  TypeFactory type_factory;
+  SimpleCatalog catalog("root", &type_factory);
+  AddTestTables<SimpleCatalog>(&type_factory, &catalog);
+
+  int num_names_consumed = 0;
+  const Table* table = nullptr;
+  ZETASQL_ASSERT_OK(catalog.FindTableWithPathPrefix({"db", "x", "t", "a"},
+                                            FindOptions(), &num_names_consumed,
+                                            &table));
+  EXPECT_EQ(num_names_consumed, 3);
+  ASSERT_NE(table, nullptr);
+
+  // "x" is both a table and a catalog, and the catalog has no table "a".
+  EXPECT_THAT(catalog.FindTableWithPathPrefix(
+                  {"x", "a"}, FindOptions(), &num_names_consumed, &table),
+              StatusIs(absl::StatusCode::kNotFound));
+  EXPECT_EQ(num_names_consumed, 0);
+  EXPECT_EQ(table, nullptr);
+}
+
+TEST(SimpleTable, SetColumnMajorContents) {
+  SimpleTable table("t", {{"a", types::Int64Type()},
+                          {"b", types::StringType()}});
+  // Sorted on 'a', with more than one block of rows.
+  auto a = std::make_shared<std::vector<Value>>();
+  auto b = std::make_shared<std::vector<Value>>();
+  for (int64_t i = 0; i < 3000; ++i) {
+    a->push_back(Value::Int64(i));
+    b->push_back(i % 1000 == 0 ? Value::NullString() : Value::String("x"));
+  }
+  ZETASQL_ASSERT_OK(table.SetColumnMajorContents({a, b}));
+  EXPECT_EQ(table.GetRowCountEstimate(), 3000);
+
+  // Filters are keyed on the columns of the scan.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       table.CreateEvaluatorTableIterator({1, 0}));
+  absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map;
+  filter_map.emplace(0, std::make_unique<ColumnFilter>(ColumnFilter::IsNull()));
+  filter_map.emplace(1, std::make_unique<ColumnFilter>(Value::Int64(1500),
+                                                       Value()));
+  ZETASQL_ASSERT_OK(iter->SetColumnFilterMap(std::move(filter_map)));
+  std::vector<Value> values;
+  while (iter->NextRow()) {
+    values.push_back(iter->GetValue(1));
+  }
+  ZETASQL_ASSERT_OK(iter->Status());
+  EXPECT_THAT(values, ElementsAre(Value::Int64(2000)));
+
+  EXPECT_THAT(table.SetColumnMajorContents({a}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(
+      table.SetColumnMajorContents(
+          {a, std::make_shared<std::vector<Value>>(
+                  std::vector<Value>{Value::String("x")})}),
+      StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(table.SetColumnMajorContents({b, a}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(SimpleTable, GetVersion) {
+  SimpleTable table("t", {{"a", types::Int64Type()}});
+  SimpleTable other("u", {{"a", types::Int64Type()}});
+  ASSERT_TRUE(table.GetVersion().has_value());
+  EXPECT_NE(table.GetVersion(), other.GetVersion());
+
+  const std::optional<int64_t> empty_version = table.GetVersion();
+  table.SetContents({{Value::Int64(1)}});
+  const std::optional<int64_t> version = table.GetVersion();
+  ASSERT_TRUE(version.has_value());
+  EXPECT_NE(version, empty_version);
+  ZETASQL_ASSERT_OK(table.AddIndex(0, ColumnValueIndex::kHash));
+  EXPECT_EQ(table.GetVersion(), version);
+  EXPECT_FALSE(table.SetColumnMajorContents({}).ok());
+  EXPECT_EQ(table.GetVersion(), version);
+
+  table.SetEvaluatorTableIteratorFactory(
+      [](absl::Span<const int> column_idxs)
+          -> absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>> {
+        return absl::UnimplementedError("no rows");
+      });
+  EXPECT_EQ(table.GetVersion(), std::nullopt);
+  ZETASQL_ASSERT_OK(table.SetColumnarContents({}));
+  ASSERT_TRUE(table.GetVersion().has_value());
+  EXPECT_NE(table.GetVersion(), version);
+}
+
+TEST(SimpleTable, AddIndex) {
+  SimpleTable table("t", {{"k", types::Int64Type()},
+                          {"v", types::DoubleType()}});
+  EXPECT_THAT(table.AddIndex(1, ColumnValueIndex::kHash),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  ZETASQL_ASSERT_OK(table.AddIndex(0, ColumnValueIndex::kHash));
+  ZETASQL_ASSERT_OK(table.AddIndex(1, ColumnValueIndex::kOrdered));
+  table.SetContents({{Value::Int64(7), Value::Double(1.5)},
+                     {Value::Int64(8), Value::Double(0.5)},
+                     {Value::Int64(7), Value::Double(-1)}});
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       table.CreateEvaluatorTableIterator({0, 1}));
+  absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map;
+  filter_map.emplace(0, std::make_unique<ColumnFilter>(
+                            std::vector<Value>{Value::Int64(7)}));
+  filter_map.emplace(1, std::make_unique<ColumnFilter>(Value::Double(0),
+                                                       Value()));
+  ZETASQL_ASSERT_OK(iter->SetColumnFilterMap(std::move(filter_map)));
+  std::vector<Value> values;
+  while (iter->NextRow()) {
+    values.push_back(iter->GetValue(1));
+  }
+  ZETASQL_ASSERT_OK(iter->Status());
+  EXPECT_THAT(values, ElementsAre(Value::Double(1.5)));
+}
+
+}  // namespace
+}  // namespace zetasql
@@ -371,6 +371,13 @@ class TableValuedFunction {
   // all output columns of the result schema. The order of columns is not
   // relevant.
   //
+  // Before the first call to NextRow(), the evaluator may call
+  // SetColumnFilterMap() on the output iterator with filters from the enclosing
+  // query, keyed on the iterator's own column indexes. As for table scans, an
+  // implementation that reads from storage can use them to skip rows at the
+  // source. Applying them is optional: the evaluator still filters the rows,
+  // so the default implementation, which ignores them, is correct.
+  //
   // Not used for zetasql analysis.
   // Used only for evaluating queries on this table with the reference
   // implementation, using the interfaces in evaluator.h.
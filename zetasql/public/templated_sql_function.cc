@@ -32,6 +32,8 @@
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "zetasql/base/ret_check.h"
 #include "zetasql/base/status_macros.h"
 #include "zetasql/base/status_payload.h"
@@ -102,6 +104,48 @@ absl::Status TemplatedSQLFunction::Serialize(
   return absl::OkStatus();
 }
 
+void TemplatedSQLFunction::ClearResolvedCallCache() {
+  absl::MutexLock lock(&mutex_);
+  resolved_calls_.clear();
+}
+
+// static
+TemplatedSQLFunction::ResolvedCallKey TemplatedSQLFunction::MakeResolvedCallKey(
+    const Catalog* catalog, const TypeFactory* type_factory,
+    const LanguageOptions& language_options,
+    absl::Span<const InputArgumentType> arguments) {
+  ResolvedCallKey key{catalog, type_factory, language_options, {}};
+  key.argument_types.reserve(arguments.size());
+  for (const InputArgumentType& argument : arguments) {
+    key.argument_types.push_back(argument.type());
+  }
+  return key;
+}
+
+std::shared_ptr<ResolvedFunctionCallInfo>
+TemplatedSQLFunction::FindResolvedCall(
+    const Catalog* catalog, const TypeFactory* type_factory,
+    const LanguageOptions& language_options,
+    absl::Span<const InputArgumentType> arguments) const {
+  const ResolvedCallKey key =
+      MakeResolvedCallKey(catalog, type_factory, language_options, arguments);
+  absl::MutexLock lock(&mutex_);
+  auto it = resolved_calls_.find(key);
+  return it == resolved_calls_.end() ? nullptr : it->second;
+}
+
+void TemplatedSQLFunction::AddResolvedCall(
+    const Catalog* catalog, const TypeFactory* type_factory,
+    const LanguageOptions& language_options,
+    absl::Span<const InputArgumentType> arguments,
+    std::shared_ptr<ResolvedFunctionCallInfo> call) const {
+  ResolvedCallKey key =
+      MakeResolvedCallKey(catalog, type_factory, language_options, arguments);
+  absl::MutexLock lock(&mutex_);
+  // If another thread resolved the same call meanwhile, either result will do.
+  resolved_calls_.try_emplace(std::move(key), std::move(call));
+}
+
 TemplatedSQLFunctionCall::TemplatedSQLFunctionCall(
     std::unique_ptr<const ResolvedExpr> expr,
     std::vector<std::unique_ptr<const ResolvedComputedColumn>>
@@ -19,12 +19,20 @@
 
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "google/protobuf/descriptor.h"
+#include "zetasql/public/catalog.h"
 #include "zetasql/public/function.h"
+#include "zetasql/public/input_argument_type.h"
+#include "zetasql/public/language_options.h"
 #include "zetasql/public/parse_resume_location.h"
 #include "zetasql/public/type.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "zetasql/base/status.h"
 
 // This file includes interfaces and classes related to templated SQL
@@ -54,6 +62,12 @@ class ResolvedExpr;
 // TemplatedSQLFunctionCall instance that includes not only the UDA's
 // function expression, but also a list of referenced (child) aggregates
 // (if any).
+//
+// By default the function expression is parsed and resolved again for every
+// call. If set_cache_resolved_calls(true) is called, the result is instead
+// cached for each combination of concrete argument types, LanguageOptions,
+// Catalog and TypeFactory that the function is called with, and shared by
+// all such calls, also across statements and threads.
 class TemplatedSQLFunction : public Function {
  public:
   // The name of the ZetaSQL function group for TemplatedSQLFunction. All
@@ -91,6 +105,32 @@ class TemplatedSQLFunction : public Function {
 
   Catalog* resolution_catalog() const { return resolution_catalog_; }
 
+  // If true, resolved calls are cached, as described in the class comment.
+  // Types created while resolving a call are owned by the TypeFactory given
+  // to the analyzer, so this may only be enabled if all the TypeFactories this
+  // function is called with outlive it, or ClearResolvedCallCache() is called
+  // before destroying them. Failed calls are not cached, so that their errors
+  // point to each call.
+  void set_cache_resolved_calls(bool cache_resolved_calls) {
+    cache_resolved_calls_ = cache_resolved_calls;
+  }
+  bool cache_resolved_calls() const { return cache_resolved_calls_; }
+
+  void ClearResolvedCallCache();
+
+  // Returns the cached resolution of a call with 'arguments', or NULL if there
+  // is none. Only used by the resolver, if cache_resolved_calls() is true.
+  std::shared_ptr<ResolvedFunctionCallInfo> FindResolvedCall(
+      const Catalog* catalog, const TypeFactory* type_factory,
+      const LanguageOptions& language_options,
+      absl::Span<const InputArgumentType> arguments) const;
+
+  // Adds the resolution 'call' of a call with 'arguments' to the cache.
+  void AddResolvedCall(const Catalog* catalog, const TypeFactory* type_factory,
+                       const LanguageOptions& language_options,
+                       absl::Span<const InputArgumentType> arguments,
+                       std::shared_ptr<ResolvedFunctionCallInfo> call) const;
+
   static absl::Status Deserialize(
       const FunctionProto& proto,
       const std::vector<const google::protobuf::DescriptorPool*>& pools,
@@ -105,10 +145,42 @@ class TemplatedSQLFunction : public Function {
   }
 
  private:
+  // The key of a resolved call. Only the types of the arguments matter, since
+  // the function expression sees them as ResolvedArgumentRefs.
+  struct ResolvedCallKey {
+    const Catalog* catalog;
+    const TypeFactory* type_factory;
+    LanguageOptions language_options;
+    std::vector<const Type*> argument_types;
+
+    bool operator==(const ResolvedCallKey& other) const {
+      return catalog == other.catalog && type_factory == other.type_factory &&
+             argument_types == other.argument_types &&
+             language_options == other.language_options;
+    }
+
+    template <typename H>
+    friend H AbslHashValue(H h, const ResolvedCallKey& key) {
+      return H::combine(std::move(h), key.catalog, key.type_factory,
+                        key.language_options, key.argument_types);
+    }
+  };
+
+  static ResolvedCallKey MakeResolvedCallKey(
+      const Catalog* catalog, const TypeFactory* type_factory,
+      const LanguageOptions& language_options,
+      absl::Span<const InputArgumentType> arguments);
+
   // If non-NULL, this Catalog is used to override the catalog when the
   // resolver runs.
   Catalog* resolution_catalog_ = nullptr;
 
+  bool cache_resolved_calls_ = false;
+  mutable absl::Mutex mutex_;
+  mutable absl::flat_hash_map<ResolvedCallKey,
+                              std::shared_ptr<ResolvedFunctionCallInfo>>
+      resolved_calls_ ABSL_GUARDED_BY(mutex_);
+
   // The list of names of all the function arguments, in the same order that
   // they appear in the function signature.
   const std::vector<std::string> argument_names_;
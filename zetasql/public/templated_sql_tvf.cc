@@ -50,6 +50,7 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "zetasql/base/map_util.h"
 #include "zetasql/base/ret_check.h"
 #include "zetasql/base/status_macros.h"
@@ -109,6 +110,39 @@ absl::Status TemplatedSQLTVF::Deserialize(
   return absl::OkStatus();
 }
 
+void TemplatedSQLTVF::ClearResolvedCallCache() {
+  absl::MutexLock lock(&mutex_);
+  resolved_calls_.clear();
+}
+
+std::optional<TemplatedSQLTVF::ResolvedCallKey>
+TemplatedSQLTVF::MakeResolvedCallKey(
+    const AnalyzerOptions& analyzer_options,
+    const std::vector<TVFInputArgumentType>& input_arguments,
+    const Catalog* catalog, const TypeFactory* type_factory) const {
+  // Query parameters in the body may resolve differently for each statement.
+  if (!cache_resolved_calls_ || allow_query_parameters_) {
+    return std::nullopt;
+  }
+  ResolvedCallKey key{catalog, type_factory, analyzer_options.language(), {}};
+  key.arguments.reserve(input_arguments.size());
+  for (const TVFInputArgumentType& argument : input_arguments) {
+    if (argument.is_relation()) {
+      key.arguments.push_back({nullptr, argument.relation()});
+    } else if (argument.is_scalar()) {
+      absl::StatusOr<InputArgumentType> scalar_type =
+          argument.GetScalarArgType();
+      if (!scalar_type.ok()) {
+        return std::nullopt;
+      }
+      key.arguments.push_back({scalar_type->type(), std::nullopt});
+    } else {
+      return std::nullopt;
+    }
+  }
+  return key;
+}
+
 absl::Status TemplatedSQLTVF::Resolve(
     const AnalyzerOptions* analyzer_options,
     const std::vector<TVFInputArgumentType>& input_arguments,
@@ -118,11 +152,56 @@ absl::Status TemplatedSQLTVF::Resolve(
   // TODO: Attach proper error locations to the returned Status.
   ZETASQL_RETURN_IF_ERROR(CheckIsValid());
 
+  if (resolution_catalog_ != nullptr) {
+    catalog = resolution_catalog_;
+  }
+
+  const std::optional<ResolvedCallKey> key = MakeResolvedCallKey(
+      *analyzer_options, input_arguments, catalog, type_factory);
+  std::optional<ResolvedCall> resolved_call;
+  if (key.has_value()) {
+    absl::MutexLock lock(&mutex_);
+    auto it = resolved_calls_.find(*key);
+    if (it != resolved_calls_.end()) {
+      resolved_call = it->second;
+    }
+  }
+  if (!resolved_call.has_value()) {
+    ZETASQL_ASSIGN_OR_RETURN(
+        resolved_call,
+        ResolveCall(*analyzer_options, input_arguments, catalog, type_factory));
+    if (key.has_value()) {
+      absl::MutexLock lock(&mutex_);
+      // If another thread resolved the same call meanwhile, either will do.
+      resolved_calls_.try_emplace(*key, *resolved_call);
+    }
+  }
+
+  TVFSignatureOptions tvf_signature_options;
+  tvf_signature_options.additional_deprecation_warnings =
+      concrete_signature.AdditionalDeprecationWarnings();
+
+  // Return the final TVFSignature and resolved templated query.
+  tvf_signature->reset(new TemplatedSQLTVFSignature(
+      input_arguments, resolved_call->output_schema, tvf_signature_options,
+      resolved_call->resolved_templated_query, GetArgumentNames()));
+  if (anonymization_info_ != nullptr) {
+    auto anonymization_info =
+        std::make_unique<AnonymizationInfo>(*anonymization_info_);
+    tvf_signature->get()->SetAnonymizationInfo(std::move(anonymization_info));
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<TemplatedSQLTVF::ResolvedCall> TemplatedSQLTVF::ResolveCall(
+    const AnalyzerOptions& analyzer_options,
+    const std::vector<TVFInputArgumentType>& input_arguments, Catalog* catalog,
+    TypeFactory* type_factory) const {
   // Check if this function calls itself. If so, return an error. Otherwise, add
   // a pointer to this class to the cycle detector in the analyzer options.
   CycleDetector::ObjectInfo object(
       FullName(), this,
-      analyzer_options->find_options().cycle_detector());
+      analyzer_options.find_options().cycle_detector());
   // TODO: Attach proper error locations to the returned Status.
   ZETASQL_RETURN_IF_ERROR(object.DetectCycle("table function"));
 
@@ -134,7 +213,7 @@ absl::Status TemplatedSQLTVF::Resolve(
       << DebugString();
   for (int i = 0; i < input_arguments.size(); ++i) {
     const IdString tvf_arg_name =
-        analyzer_options->id_string_pool()->Make(GetArgumentNames()[i]);
+        analyzer_options.id_string_pool()->Make(GetArgumentNames()[i]);
     const TVFInputArgumentType& tvf_arg_type = input_arguments[i];
     if (tvf_arg_type.is_relation()) {
       // TODO: Attach proper error locations to the returned Status.
@@ -157,30 +236,26 @@ absl::Status TemplatedSQLTVF::Resolve(
 
   // Create a separate new parser and parse the templated TVFs SQL query body.
   // Use the same ID string pool from the original parser.
-  ParserOptions parser_options(analyzer_options->id_string_pool(),
-                               analyzer_options->arena(),
-                               analyzer_options->language());
+  ParserOptions parser_options(analyzer_options.id_string_pool(),
+                               analyzer_options.arena(),
+                               analyzer_options.language());
   std::unique_ptr<ParserOutput> parser_output;
   bool at_end_of_input = false;
   ParseResumeLocation this_parse_resume_location(parse_resume_location_);
   ZETASQL_RETURN_IF_ERROR(ForwardNestedResolutionAnalysisError(
       ParseNextStatement(&this_parse_resume_location, parser_options,
                          &parser_output, &at_end_of_input),
-      analyzer_options->error_message_options()));
+      analyzer_options.error_message_options()));
   if (parser_output->statement()->node_kind() != AST_QUERY_STATEMENT) {
     // TODO: Attach proper error locations to the returned Status.
     return MakeTVFQueryAnalysisError("SQL body is not a query");
   }
 
-  if (resolution_catalog_ != nullptr) {
-    catalog = resolution_catalog_;
-  }
-
   // Create a separate new resolver and resolve the TVF's SQL query body, using
   // the specified function arguments. Note that if this resolver uses the
   // catalog passed into the class constructor, then the catalog may include
   // names that were not available when the function was initially declared.
-  Resolver resolver(catalog, type_factory, analyzer_options);
+  Resolver resolver(catalog, type_factory, &analyzer_options);
   std::optional<TVFRelation> specified_output_schema;
   if (signatures_[0].result_type().options().has_relation_input_schema()) {
     specified_output_schema =
@@ -194,12 +269,13 @@ absl::Status TemplatedSQLTVF::Resolve(
           static_cast<const ASTQueryStatement*>(parser_output->statement()),
           specified_output_schema, allow_query_parameters_, &function_arguments,
           &function_table_arguments, &resolved_sql_body, &tvf_body_name_list),
-      analyzer_options->error_message_options()));
+      analyzer_options.error_message_options()));
   // TODO: Attach proper error locations to the returned Status.
   ZETASQL_RET_CHECK_EQ(RESOLVED_QUERY_STMT, resolved_sql_body->node_kind());
 
   // Construct the output schema for the TemplatedSQLTVFSignature return object.
-  TVFRelation return_tvf_relation({});
+  ResolvedCall resolved_call;
+  TVFRelation& return_tvf_relation = resolved_call.output_schema;
   if (specified_output_schema) {
     return_tvf_relation = *specified_output_schema;
   } else if (tvf_body_name_list->is_value_table()) {
@@ -230,22 +306,13 @@ absl::Status TemplatedSQLTVF::Resolve(
     return_tvf_relation = TVFRelation(output_schema_columns);
   }
 
-  TVFSignatureOptions tvf_signature_options;
-  tvf_signature_options.additional_deprecation_warnings =
-      concrete_signature.AdditionalDeprecationWarnings();
-
-  // Return the final TVFSignature and resolved templated query.
-  std::unique_ptr<const ResolvedQueryStmt> resolved_templated_query(
-      static_cast<const ResolvedQueryStmt*>(resolved_sql_body.release()));
-  tvf_signature->reset(new TemplatedSQLTVFSignature(
-      input_arguments, return_tvf_relation, tvf_signature_options,
-      std::move(resolved_templated_query), GetArgumentNames()));
-  if (anonymization_info_ != nullptr) {
-    auto anonymization_info =
-        std::make_unique<AnonymizationInfo>(*anonymization_info_);
-    tvf_signature->get()->SetAnonymizationInfo(std::move(anonymization_info));
-  }
-  return absl::OkStatus();
+  // The query refers to IdStrings of the statement's IdStringPool, which must
+  // live as long as the query, since it may outlive the statement.
+  resolved_call.resolved_templated_query.reset(
+      static_cast<const ResolvedQueryStmt*>(resolved_sql_body.release()),
+      [id_string_pool = analyzer_options.id_string_pool()](
+          const ResolvedQueryStmt* query) { delete query; });
+  return resolved_call;
 }
 
 absl::Status TemplatedSQLTVF::CheckIsValid() const {
@@ -18,6 +18,7 @@
 #define ZETASQL_PUBLIC_TEMPLATED_SQL_TVF_H_
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -25,14 +26,19 @@
 #include "zetasql/public/catalog.h"
 #include "zetasql/public/error_helpers.h"
 #include "zetasql/public/function_signature.h"
+#include "zetasql/public/language_options.h"
 #include "zetasql/public/options.pb.h"
 #include "zetasql/public/parse_resume_location.h"
 #include "zetasql/public/table_valued_function.h"
 #include "zetasql/public/type.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
 #include "absl/base/macros.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 
 // This file includes interfaces and classes related to templated SQL
 // TVFs.  It includes classes to represent TemplatedSQLTVFs and their
@@ -54,6 +60,14 @@ class TableValuedFunctionProto;
 // may have templated types like "ANY TYPE" or "ANY TABLE". In this case,
 // ZetaSQL cannot resolve the <query> right away and must defer this work
 // until later when the function is called with concrete argument types.
+//
+// By default the <query> is parsed and resolved again for every call. If
+// set_cache_resolved_calls(true) is called, the resolved query and output
+// schema are instead cached for each combination of concrete scalar argument
+// types, table argument schemas, LanguageOptions, Catalog and TypeFactory that
+// the function is called with, and shared by all such calls, also across
+// statements and threads. Calls are not cached if the function allows query
+// parameters.
 class TemplatedSQLTVF : public TableValuedFunction {
  public:
   // Constructs a new templated SQL TVF named <function_name_path>, with a
@@ -90,6 +104,18 @@ class TemplatedSQLTVF : public TableValuedFunction {
     allow_query_parameters_ = allow;
   }
 
+  // If true, resolved calls are cached, as described in the class comment.
+  // Types created while resolving a call are owned by the TypeFactory passed
+  // to Resolve(), so this may only be enabled if all the TypeFactories this
+  // function is called with outlive it, or ClearResolvedCallCache() is called
+  // before destroying them. Failed calls are not cached.
+  void set_cache_resolved_calls(bool cache_resolved_calls) {
+    cache_resolved_calls_ = cache_resolved_calls;
+  }
+  bool cache_resolved_calls() const { return cache_resolved_calls_; }
+
+  void ClearResolvedCallCache();
+
   absl::Status Serialize(FileDescriptorSetMap* file_descriptor_set_map,
                          TableValuedFunctionProto* proto) const override;
 
@@ -122,6 +148,72 @@ class TemplatedSQLTVF : public TableValuedFunction {
   }
 
  private:
+  // The resolved query and output schema of a call. 'resolved_templated_query'
+  // is shared by the TemplatedSQLTVFSignatures of all the calls it is cached
+  // for.
+  struct ResolvedCall {
+    std::shared_ptr<const ResolvedQueryStmt> resolved_templated_query;
+    TVFRelation output_schema = TVFRelation({});
+  };
+
+  // One argument of a resolved call: the type of a scalar argument, or the
+  // schema of a table argument.
+  struct ResolvedCallArgument {
+    const Type* type;
+    std::optional<TVFRelation> relation;
+
+    bool operator==(const ResolvedCallArgument& other) const {
+      return type == other.type && relation == other.relation;
+    }
+
+    // TVFRelations compare their column types with Type::Equals(), so only
+    // their column names are hashed.
+    template <typename H>
+    friend H AbslHashValue(H h, const ResolvedCallArgument& argument) {
+      h = H::combine(std::move(h), argument.type,
+                     argument.relation.has_value());
+      if (argument.relation.has_value()) {
+        h = H::combine(std::move(h), argument.relation->is_value_table());
+        for (const TVFRelation::Column& column : argument.relation->columns()) {
+          h = H::combine(std::move(h), column.name);
+        }
+      }
+      return h;
+    }
+  };
+
+  struct ResolvedCallKey {
+    const Catalog* catalog;
+    const TypeFactory* type_factory;
+    LanguageOptions language_options;
+    std::vector<ResolvedCallArgument> arguments;
+
+    bool operator==(const ResolvedCallKey& other) const {
+      return catalog == other.catalog && type_factory == other.type_factory &&
+             arguments == other.arguments &&
+             language_options == other.language_options;
+    }
+
+    template <typename H>
+    friend H AbslHashValue(H h, const ResolvedCallKey& key) {
+      return H::combine(std::move(h), key.catalog, key.type_factory,
+                        key.language_options, key.arguments);
+    }
+  };
+
+  // Returns the key that a call with 'input_arguments' is cached with, or
+  // nullopt if the call must not be cached.
+  std::optional<ResolvedCallKey> MakeResolvedCallKey(
+      const AnalyzerOptions& analyzer_options,
+      const std::vector<TVFInputArgumentType>& input_arguments,
+      const Catalog* catalog, const TypeFactory* type_factory) const;
+
+  // Parses and resolves the SQL body for a call with 'input_arguments'.
+  absl::StatusOr<ResolvedCall> ResolveCall(
+      const AnalyzerOptions& analyzer_options,
+      const std::vector<TVFInputArgumentType>& input_arguments,
+      Catalog* catalog, TypeFactory* type_factory) const;
+
   // Performs some quick sanity checks on the function signature before starting
   // nested analysis.
   absl::Status CheckIsValid() const;
@@ -156,6 +248,11 @@ class TemplatedSQLTVF : public TableValuedFunction {
 
   // If true, the analyzer allows query parameters within the SQL function body.
   bool allow_query_parameters_ = false;
+
+  bool cache_resolved_calls_ = false;
+  mutable absl::Mutex mutex_;
+  mutable absl::flat_hash_map<ResolvedCallKey, ResolvedCall> resolved_calls_
+      ABSL_GUARDED_BY(mutex_);
 };
 
 // The TemplatedSQLTVF::Resolve method returns an instance of this class. It
@@ -163,13 +260,13 @@ class TemplatedSQLTVF : public TableValuedFunction {
 // it in the context of all the provided input arguments.
 class TemplatedSQLTVFSignature : public TVFSignature {
  public:
-  // Represents a TVF call that returns 'output_schema'. Takes ownership of
-  // 'resolved_templated_query'.
+  // Represents a TVF call that returns 'output_schema'. Shares ownership of
+  // 'resolved_templated_query', which may be that of other calls too.
   TemplatedSQLTVFSignature(
       const std::vector<TVFInputArgumentType>& input_arguments,
       const TVFRelation& output_schema,
       const TVFSignatureOptions& tvf_signature_options,
-      std::unique_ptr<const ResolvedQueryStmt> resolved_templated_query,
+      std::shared_ptr<const ResolvedQueryStmt> resolved_templated_query,
       const std::vector<std::string>& arg_name_list)
       : TVFSignature(input_arguments, output_schema, tvf_signature_options),
         resolved_templated_query_(std::move(resolved_templated_query)),
@@ -192,7 +289,7 @@ class TemplatedSQLTVFSignature : public TVFSignature {
   }
 
  private:
-  std::unique_ptr<const ResolvedQueryStmt> resolved_templated_query_;
+  std::shared_ptr<const ResolvedQueryStmt> resolved_templated_query_;
   const std::vector<std::string> arg_name_list_;
 };
 
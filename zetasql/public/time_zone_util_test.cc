@@ -41,4 +41,21 @@ TEST(TimeZoneTests, KyivTimezone) {
   }
 }
 
+TEST(TimeZoneTests, MakeTimeZoneIsRepeatable) {
+  // Different spellings of the same offset load the same time zone.
+  absl::TimeZone tz1;
+  ZETASQL_ASSERT_OK(functions::MakeTimeZone("+5:30", &tz1));
+  absl::TimeZone tz2;
+  ZETASQL_ASSERT_OK(functions::MakeTimeZone("+05:30", &tz2));
+  EXPECT_EQ(tz1, tz2);
+  EXPECT_EQ(tz1, absl::FixedTimeZone(5 * 60 * 60 + 30 * 60));
+
+  for (int i = 0; i < 2; ++i) {
+    ZETASQL_ASSERT_OK(functions::MakeTimeZone("America/Los_Angeles", &tz1));
+    EXPECT_EQ(tz1.name(), "America/Los_Angeles");
+    EXPECT_FALSE(functions::MakeTimeZone("America/Nowhere", &tz1).ok());
+    EXPECT_FALSE(functions::MakeTimeZone("+25:00", &tz1).ok());
+  }
+}
+
 }  // namespace zetasql
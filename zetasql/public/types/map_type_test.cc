@@ -18,8 +18,10 @@
 
 #include <initializer_list>
 #include <string>
+#include <thread>  // NOLINT
 #include <tuple>
 #include <utility>
+#include <vector>
 
 #include "zetasql/base/testing/status_matchers.h"  
 #include "zetasql/public/language_options.h"
@@ -372,6 +374,95 @@ TEST(TypeFactoryTest, MapTypesAreCached) {
       << "Expected the two type pointers to be identical";
 }
 
+TEST(TypeFactoryTest, CachedTypesFromManyThreads) {
+  TypeFactory factory;
+  const Type* struct_type;
+  ZETASQL_ASSERT_OK(factory.MakeStructType({{"a", types::Int32Type()}}, &struct_type));
+
+  constexpr int kNumThreads = 8;
+  std::vector<const Type*> array_types(kNumThreads);
+  std::vector<const Type*> map_types(kNumThreads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&, i]() {
+      for (int j = 0; j < 1000; ++j) {
+        ZETASQL_ASSERT_OK(factory.MakeArrayType(struct_type, &array_types[i]));
+        ZETASQL_ASSERT_OK_AND_ASSIGN(map_types[i],
+                             factory.MakeMapType(struct_type, struct_type));
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (int i = 1; i < kNumThreads; ++i) {
+    EXPECT_EQ(array_types[0], array_types[i]);
+    EXPECT_EQ(map_types[0], map_types[i]);
+  }
+}
+
+TEST(TypeFactoryTest, InternStructTypes) {
+  TypeFactoryOptions options;
+  options.intern_struct_types = true;
+  TypeFactory factory(options);
+
+  const Type* struct1;
+  const Type* struct2;
+  ZETASQL_ASSERT_OK(factory.MakeStructType(
+      {{"a", types::Int64Type()}, {"b", types::StringType()}}, &struct1));
+  ZETASQL_ASSERT_OK(factory.MakeStructType(
+      {{"a", types::Int64Type()}, {"b", types::StringType()}}, &struct2));
+  EXPECT_EQ(struct1, struct2);
+
+  // Equal nested types are interned too, since arrays are already cached.
+  const Type* array1;
+  const Type* array2;
+  const Type* nested1;
+  const Type* nested2;
+  ZETASQL_ASSERT_OK(factory.MakeArrayType(struct1, &array1));
+  ZETASQL_ASSERT_OK(factory.MakeArrayType(struct2, &array2));
+  ZETASQL_ASSERT_OK(factory.MakeStructType({{"x", array1}}, &nested1));
+  ZETASQL_ASSERT_OK(factory.MakeStructType({{"x", array2}}, &nested2));
+  EXPECT_EQ(nested1, nested2);
+
+  // Field name case is observable, so such structs are distinct types that
+  // are still Equals().
+  const Type* struct3;
+  ZETASQL_ASSERT_OK(factory.MakeStructType(
+      {{"A", types::Int64Type()}, {"b", types::StringType()}}, &struct3));
+  EXPECT_NE(struct1, struct3);
+  EXPECT_TRUE(struct1->Equals(struct3));
+
+  const Type* struct4;
+  ZETASQL_ASSERT_OK(factory.MakeStructType(
+      {{"a", types::Int64Type()}, {"b", types::BytesType()}}, &struct4));
+  EXPECT_NE(struct1, struct4);
+  EXPECT_FALSE(struct1->Equals(struct4));
+  EXPECT_FALSE(struct1->Equivalent(struct4));
+}
+
+TEST(TypeFactoryTest, StructTypeEqualsAcrossFactories) {
+  TypeFactory factory1;
+  TypeFactory factory2;
+  const Type* struct1;
+  const Type* struct2;
+  const Type* struct3;
+  const Type* struct4;
+  ZETASQL_ASSERT_OK(factory1.MakeStructType(
+      {{"a", types::Int64Type()}, {"b", types::Int64ArrayType()}}, &struct1));
+  ZETASQL_ASSERT_OK(factory2.MakeStructType(
+      {{"A", types::Int64Type()}, {"b", types::Int64ArrayType()}}, &struct2));
+  ZETASQL_ASSERT_OK(factory2.MakeStructType(
+      {{"c", types::Int64Type()}, {"b", types::Int64ArrayType()}}, &struct3));
+  ZETASQL_ASSERT_OK(factory2.MakeStructType(
+      {{"a", types::Int64Type()}, {"b", types::DoubleArrayType()}}, &struct4));
+  EXPECT_TRUE(struct1->Equals(struct2));
+  EXPECT_FALSE(struct1->Equals(struct3));
+  EXPECT_TRUE(struct1->Equivalent(struct3));
+  EXPECT_FALSE(struct1->Equals(struct4));
+  EXPECT_FALSE(struct1->Equivalent(struct4));
+}
+
 TEST_P(MapTestAllSimpleTypes, MapWithSimpleTypesUsesStaticFactory) {
   TypeFactory factory;
   TypeKind type_kind = GetParam();
@@ -1112,13 +1112,13 @@ absl::Status SimpleType::DeserializeValueContent(const ValueProto& value_proto,
       if (!value_proto.has_string_value()) {
         return TypeMismatchError(value_proto);
       }
-      value->set(new internal::StringRef(value_proto.string_value()));
+      value->set(internal::StringRef::Create(value_proto.string_value()));
       break;
     case TYPE_BYTES:
       if (!value_proto.has_bytes_value()) {
         return TypeMismatchError(value_proto);
       }
-      value->set(new internal::StringRef(value_proto.bytes_value()));
+      value->set(internal::StringRef::Create(value_proto.bytes_value()));
       break;
     case TYPE_DATE:
       if (!value_proto.has_date_value()) {
@@ -34,7 +34,10 @@
 #include "zetasql/public/options.pb.h"
 #include "zetasql/public/strings.h"
 #include "zetasql/public/type.pb.h"
+#include "zetasql/public/types/array_type.h"
+#include "zetasql/public/types/enum_type.h"
 #include "zetasql/public/types/internal_utils.h"
+#include "zetasql/public/types/proto_type.h"
 #include "zetasql/public/types/type.h"
 #include "zetasql/public/types/type_modifiers.h"
 #include "zetasql/public/types/type_parameters.h"
@@ -61,7 +64,42 @@ StructType::StructType(const TypeFactory* factory,
                        std::vector<StructField> fields, int nesting_depth)
     : ContainerType(factory, TYPE_STRUCT),
       fields_(std::move(fields)),
-      nesting_depth_(nesting_depth) {}
+      nesting_depth_(nesting_depth) {
+  equals_fingerprint_ = absl::HashOf(TYPE_STRUCT, fields_.size());
+  equivalent_fingerprint_ = equals_fingerprint_;
+  for (const StructField& field : fields_) {
+    // Field names are compared case-insensitively by FieldEqualsImpl().
+    equals_fingerprint_ = absl::HashOf(
+        equals_fingerprint_, GetNormalizedAndCasefoldedString(field.name),
+        StructuralFingerprint(field.type, /*equivalent=*/false));
+    equivalent_fingerprint_ =
+        absl::HashOf(equivalent_fingerprint_,
+                     StructuralFingerprint(field.type, /*equivalent=*/true));
+  }
+}
+
+size_t StructType::StructuralFingerprint(const Type* type, bool equivalent) {
+  switch (type->kind()) {
+    case TYPE_STRUCT:
+      return equivalent ? type->AsStruct()->equivalent_fingerprint_
+                        : type->AsStruct()->equals_fingerprint_;
+    case TYPE_ARRAY:
+      return absl::HashOf(
+          TYPE_ARRAY,
+          StructuralFingerprint(type->AsArray()->element_type(), equivalent));
+    // Equal and equivalent protos and enums always have the same full name.
+    case TYPE_PROTO:
+      return absl::HashOf(TYPE_PROTO,
+                          absl::string_view(type->AsProto()->descriptor()
+                                                ->full_name()));
+    case TYPE_ENUM:
+      return absl::HashOf(TYPE_ENUM,
+                          absl::string_view(type->AsEnum()->enum_descriptor()
+                                                ->full_name()));
+    default:
+      return absl::HashOf(type->kind());
+  }
+}
 
 bool StructType::IsSupportedType(
     const LanguageOptions& language_options) const {
@@ -395,7 +433,12 @@ bool StructType::FieldEqualsImpl(const StructType::StructField& field1,
 
 bool StructType::EqualsImpl(const StructType* const type1,
                             const StructType* const type2, bool equivalent) {
-  if (type1->num_fields() != type2->num_fields()) {
+  if (type1 == type2) {
+    return true;
+  }
+  if (StructuralFingerprint(type1, equivalent) !=
+          StructuralFingerprint(type2, equivalent) ||
+      type1->num_fields() != type2->num_fields()) {
     return false;
   }
   for (int idx = 0; idx < type1->num_fields(); ++idx) {
@@ -208,8 +208,18 @@ class StructType : public ContainerType {
   absl::Status DeserializeValueContent(const ValueProto& value_proto,
                                        ValueContent* value) const override;
 
+  // Returns a hash of 'type' that is the same for any two types that are
+  // Equals(), or Equivalent() if 'equivalent' is true. It is precomputed for
+  // struct types, so that EqualsImpl() can usually tell two unequal structs
+  // apart without comparing them field by field.
+  static size_t StructuralFingerprint(const Type* type, bool equivalent);
+
   const std::vector<StructField> fields_;
 
+  // StructuralFingerprint() of this type for Equals() and Equivalent().
+  size_t equals_fingerprint_;
+  size_t equivalent_fingerprint_;
+
   // The deepest nesting depth in the type tree rooted at this StructType, i.e.,
   // the maximum nesting_depth of the field types, plus 1 for the StructType
   // itself. If all fields are simple types, then this is 1.
@@ -16,8 +16,10 @@
 
 #include "zetasql/public/types/type_deserializer.h"
 
+#include <cstdint>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "google/protobuf/descriptor.h"
@@ -35,6 +37,7 @@
 #include "zetasql/public/types/type_factory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "zetasql/base/ret_check.h"
 #include "zetasql/base/status_macros.h"
@@ -68,9 +71,54 @@ absl::Status ValidateTypeProto(const TypeProto& type_proto) {
 
 }  // namespace
 
+int64_t TypeDeserializerCache::size() const {
+  absl::MutexLock lock(&mutex_);
+  return types_.size();
+}
+
+const Type* TypeDeserializerCache::Lookup(const std::string& key) const {
+  absl::MutexLock lock(&mutex_);
+  auto it = types_.find(key);
+  return it == types_.end() ? nullptr : it->second;
+}
+
+void TypeDeserializerCache::Insert(std::string key, const Type* type) {
+  absl::MutexLock lock(&mutex_);
+  types_.try_emplace(std::move(key), type);
+}
+
+std::string TypeDeserializer::MakeCacheKey(const TypeProto& type_proto) const {
+  // The addresses of the objects that the Type depends on, then the proto.
+  std::string key;
+  const auto append_address = [&key](const void* address) {
+    key.append(reinterpret_cast<const char*>(&address), sizeof(address));
+  };
+  append_address(type_factory_);
+  append_address(extended_type_deserializer_);
+  for (const google::protobuf::DescriptorPool* pool : descriptor_pools_) {
+    append_address(pool);
+  }
+  type_proto.AppendToString(&key);
+  return key;
+}
+
 absl::StatusOr<const Type*> TypeDeserializer::Deserialize(
     const TypeProto& type_proto) const {
   ZETASQL_RET_CHECK_NE(type_factory_, nullptr);
+  if (cache_ == nullptr || Type::IsSimpleType(type_proto.type_kind())) {
+    return DeserializeUncached(type_proto);
+  }
+  std::string key = MakeCacheKey(type_proto);
+  if (const Type* type = cache_->Lookup(key); type != nullptr) {
+    return type;
+  }
+  ZETASQL_ASSIGN_OR_RETURN(const Type* type, DeserializeUncached(type_proto));
+  cache_->Insert(std::move(key), type);
+  return type;
+}
+
+absl::StatusOr<const Type*> TypeDeserializer::DeserializeUncached(
+    const TypeProto& type_proto) const {
   ZETASQL_RETURN_IF_ERROR(ValidateTypeProto(type_proto));
 
   if (Type::IsSimpleType(type_proto.type_kind())) {
@@ -17,14 +17,20 @@
 #ifndef ZETASQL_PUBLIC_TYPES_TYPE_DESERIALIZER_H_
 #define ZETASQL_PUBLIC_TYPES_TYPE_DESERIALIZER_H_
 
+#include <cstdint>
+#include <string>
+
 #include "zetasql/base/logging.h"
 #include "google/protobuf/descriptor.h"
 #include "zetasql/public/type.pb.h"
 #include "zetasql/public/types/extended_type.h"
 #include "zetasql/public/types/type.h"
 #include "zetasql/public/types/type_factory.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 
 namespace zetasql {
@@ -64,6 +70,39 @@ class ExtendedTypeDeserializer {
   ExtendedTypeDeserializer() = default;
 };
 
+// A thread-safe memo of the Types returned by the TypeDeserializers that it
+// is set on (see TypeDeserializer::set_cache()), for callers that deserialize
+// many TypeProtos of the same types, such as the columns of a large catalog.
+// A TypeProto that was deserialized before with the same TypeFactory,
+// DescriptorPools and ExtendedTypeDeserializer returns the same Type without
+// looking up descriptors or calling into the TypeFactory again.
+//
+// The cached Types are owned by the TypeFactories of the deserializers, so the
+// cache must not be used after any of those, or of their DescriptorPools, is
+// destroyed.
+class TypeDeserializerCache {
+ public:
+  TypeDeserializerCache() = default;
+#ifndef SWIG
+  TypeDeserializerCache(const TypeDeserializerCache&) = delete;
+  TypeDeserializerCache& operator=(const TypeDeserializerCache&) = delete;
+#endif  // SWIG
+
+  // Returns the number of cached Types.
+  int64_t size() const;
+
+ private:
+  friend class TypeDeserializer;
+
+  // Returns the cached Type for `key`, or nullptr.
+  const Type* Lookup(const std::string& key) const;
+  void Insert(std::string key, const Type* type);
+
+  mutable absl::Mutex mutex_;
+  // Keyed on the identity of the deserializer and the serialized TypeProto.
+  absl::flat_hash_map<std::string, const Type*> types_ ABSL_GUARDED_BY(mutex_);
+};
+
 // TypeDeserializer is responsible for deserialization of ZetaSQL built-in
 // and extended types. Types will be deserialized using the TypeFactory, list of
 // DescriptorPools and optional ExtendedTypeDeserializer stored in an instance
@@ -107,6 +146,12 @@ class TypeDeserializer {
   // should be either static or owned by TypeFactory.
   absl::StatusOr<const Type*> Deserialize(const TypeProto& type_proto) const;
 
+  // Memoizes the Types returned by Deserialize() in `cache`, which may be
+  // shared with other TypeDeserializers and must outlive this object. Types
+  // are not memoized by default.
+  void set_cache(TypeDeserializerCache* cache) { cache_ = cache; }
+  TypeDeserializerCache* cache() const { return cache_; }
+
   // Deserializes FileDescriptorSets saved to TypeProto by
   // Type::SerializeToSelfContainedProto. This function must be called to
   // populate DescriptorPools provided to TypeDeserializer before a call to
@@ -125,12 +170,21 @@ class TypeDeserializer {
   }
 
  private:
+  // Deserializes `type_proto` without looking it up in `cache_`.
+  absl::StatusOr<const Type*> DeserializeUncached(
+      const TypeProto& type_proto) const;
+
+  // Returns the key of `type_proto` in `cache_`.
+  std::string MakeCacheKey(const TypeProto& type_proto) const;
+
   // Not owned.
   TypeFactory* type_factory_;
   // Not owned.
   absl::Span<const google::protobuf::DescriptorPool* const> descriptor_pools_;
   // Not owned.
   const ExtendedTypeDeserializer* extended_type_deserializer_ = nullptr;
+  // Not owned. May be null.
+  TypeDeserializerCache* cache_ = nullptr;
 };
 
 }  // namespace zetasql
@@ -0,0 +1,88 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/types/type_deserializer.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "google/protobuf/descriptor.h"
+#include "zetasql/public/type.pb.h"
+#include "zetasql/public/types/array_type.h"
+#include "zetasql/public/types/enum_type.h"
+#include "zetasql/public/types/proto_type.h"
+#include "zetasql/public/types/struct_type.h"
+#include "zetasql/public/types/type.h"
+#include "zetasql/public/types/type_factory.h"
+#include "zetasql/testdata/test_schema.pb.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+namespace {
+
+TEST(TypeDeserializerTest, CacheReturnsTheSameTypes) {
+  TypeFactory source_factory;
+  const ProtoType* proto_type;
+  ZETASQL_ASSERT_OK(source_factory.MakeProtoType(
+      zetasql_test__::KitchenSinkPB::descriptor(), &proto_type));
+  const EnumType* enum_type;
+  ZETASQL_ASSERT_OK(source_factory.MakeEnumType(
+      zetasql_test__::TestEnum_descriptor(), &enum_type));
+  const ArrayType* array_type;
+  ZETASQL_ASSERT_OK(source_factory.MakeArrayType(enum_type, &array_type));
+  const StructType* struct_type;
+  ZETASQL_ASSERT_OK(source_factory.MakeStructType(
+      {{"a", proto_type}, {"b", array_type}}, &struct_type));
+  TypeProto type_proto;
+  ZETASQL_ASSERT_OK(struct_type->SerializeToProtoAndFileDescriptors(&type_proto));
+
+  const std::vector<const google::protobuf::DescriptorPool*> pools = {
+      google::protobuf::DescriptorPool::generated_pool()};
+  TypeDeserializerCache cache;
+  TypeFactory type_factory;
+  TypeDeserializer deserializer(&type_factory, pools);
+  deserializer.set_cache(&cache);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(const Type* first,
+                       deserializer.Deserialize(type_proto));
+  EXPECT_TRUE(first->Equals(struct_type));
+  const int64_t size = cache.size();
+  EXPECT_GT(size, 0);
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(const Type* second,
+                       TypeDeserializer(deserializer).Deserialize(type_proto));
+  EXPECT_EQ(second, first);
+  EXPECT_EQ(cache.size(), size);
+
+  // Types of other TypeFactories are cached separately.
+  TypeFactory other_factory;
+  TypeDeserializer other_deserializer(&other_factory, pools);
+  other_deserializer.set_cache(&cache);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(const Type* other,
+                       other_deserializer.Deserialize(type_proto));
+  EXPECT_NE(other, first);
+  EXPECT_TRUE(other->Equals(first));
+  EXPECT_GT(cache.size(), size);
+
+  // Errors are not cached.
+  TypeProto invalid_proto;
+  invalid_proto.set_type_kind(TYPE_ARRAY);
+  EXPECT_FALSE(deserializer.Deserialize(invalid_proto).ok());
+  EXPECT_FALSE(deserializer.Deserialize(invalid_proto).ok());
+}
+
+}  // namespace
+}  // namespace zetasql
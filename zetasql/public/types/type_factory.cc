@@ -64,6 +64,7 @@
 #include "absl/container/inlined_vector.h"
 #include "absl/container/node_hash_map.h"
 #include "absl/flags/flag.h"
+#include "absl/hash/hash.h"
 #include "zetasql/base/check.h"
 #include "absl/meta/type_traits.h"
 #include "absl/status/status.h"
@@ -218,6 +219,7 @@ static TypeFactory* s_type_factory() {
 TypeFactory::TypeFactory(const TypeFactoryOptions& options)
     : store_(new internal::TypeStore(
           options.keep_alive_while_referenced_from_value)),
+      intern_struct_types_(options.intern_struct_types),
       nesting_depth_limit_(
           absl::GetFlag(FLAGS_zetasql_type_factory_nesting_depth_limit)),
       estimated_memory_used_by_types_(0) {
@@ -241,16 +243,14 @@ TypeFactory::~TypeFactory() {
 }
 
 int TypeFactory::nesting_depth_limit() const {
-  absl::MutexLock l(&store_->mutex_);
-  return nesting_depth_limit_;
+  return nesting_depth_limit_.load(std::memory_order_relaxed);
 }
 
 void TypeFactory::set_nesting_depth_limit(int value) {
   // We don't want to have to check the depth for simple types, so a depth of
   // 0 must be allowed.
   ABSL_DCHECK_GE(value, 0);
-  absl::MutexLock l(&store_->mutex_);
-  nesting_depth_limit_ = value;
+  nesting_depth_limit_.store(value, std::memory_order_relaxed);
 }
 
 int64_t TypeFactory::GetEstimatedOwnedMemoryBytesSize() const {
@@ -272,6 +272,7 @@ int64_t TypeFactory::GetEstimatedOwnedMemoryBytesSize() const {
          internal::GetExternallyAllocatedMemoryEstimate(cached_enum_types_) +
          internal::GetExternallyAllocatedMemoryEstimate(cached_range_types_) +
          internal::GetExternallyAllocatedMemoryEstimate(cached_map_types_) +
+         internal::GetExternallyAllocatedMemoryEstimate(cached_struct_types_) +
          internal::GetExternallyAllocatedMemoryEstimate(
              cached_proto_types_with_catalog_name_) +
          internal::GetExternallyAllocatedMemoryEstimate(
@@ -307,6 +308,15 @@ template <class TYPE>
 const auto* TypeFactory::MakeTypeWithChildElementType(
     const Type* element_type,
     absl::flat_hash_map<const Type*, const TYPE*>& cache) {
+  {
+    absl::ReaderMutexLock lock(&store_->mutex_);
+    auto it = cache.find(element_type);
+    if (it != cache.end()) {
+      return it->second;
+    }
+  }
+  absl::MutexLock lock(&store_->mutex_);
+  // Another thread may have created the type after the lookup above.
   auto& cached_result = cache[element_type];
   if (cached_result == nullptr) {
     cached_result = TakeOwnershipLocked(new TYPE(this, element_type));
@@ -360,7 +370,6 @@ absl::Status TypeFactory::MakeArrayType(const Type* element_type,
     return ::zetasql_base::InvalidArgumentErrorBuilder()
            << "Array type would exceed nesting depth limit of " << depth_limit;
   }
-  absl::MutexLock lock(&store_->mutex_);
   *result = MakeTypeWithChildElementType(element_type, cached_array_types_);
   return absl::OkStatus();
 }
@@ -398,6 +407,27 @@ absl::Status TypeFactory::MakeStructTypeFromVector(
     }
     AddDependency(field.type);
   }
+  if (intern_struct_types_) {
+    {
+      absl::ReaderMutexLock lock(&store_->mutex_);
+      auto it = cached_struct_types_.find(absl::MakeConstSpan(fields));
+      if (it != cached_struct_types_.end()) {
+        *result = *it;
+        return absl::OkStatus();
+      }
+    }
+    absl::MutexLock lock(&store_->mutex_);
+    // Another thread may have created the type after the lookup above.
+    auto it = cached_struct_types_.find(absl::MakeConstSpan(fields));
+    if (it != cached_struct_types_.end()) {
+      *result = *it;
+      return absl::OkStatus();
+    }
+    *result = TakeOwnershipLocked(
+        new StructType(this, std::move(fields), max_nesting_depth + 1));
+    cached_struct_types_.insert(*result);
+    return absl::OkStatus();
+  }
   // We calculate <max_nesting_depth> in the previous loop. We also need to
   // increment it to take into account the struct itself.
   *result = TakeOwnership(
@@ -405,6 +435,26 @@ absl::Status TypeFactory::MakeStructTypeFromVector(
   return absl::OkStatus();
 }
 
+size_t TypeFactory::StructFieldsHash::operator()(StructFields fields) const {
+  size_t hash = absl::HashOf(fields.size());
+  for (const StructType::StructField& field : fields) {
+    hash = absl::HashOf(hash, field.name, field.type);
+  }
+  return hash;
+}
+
+bool TypeFactory::StructFieldsEq::FieldsEqual(StructFields fields1,
+                                              StructFields fields2) {
+  if (fields1.size() != fields2.size()) return false;
+  for (int i = 0; i < fields1.size(); ++i) {
+    if (fields1[i].type != fields2[i].type ||
+        fields1[i].name != fields2[i].name) {
+      return false;
+    }
+  }
+  return true;
+}
+
 absl::Status TypeFactory::MakeStructTypeFromVector(
     std::vector<StructType::StructField> fields, const Type** result) {
   return MakeStructTypeFromVector(std::move(fields),
@@ -432,9 +482,51 @@ const EnumType*& TypeFactory::FindOrCreateCachedType(
   }
 }
 
+const ProtoType* TypeFactory::FindCachedType(
+    const google::protobuf::Descriptor* descriptor,
+    absl::Span<const std::string> catalog_name_path) const {
+  if (catalog_name_path.empty()) {
+    auto it = cached_proto_types_.find(descriptor);
+    return it == cached_proto_types_.end() ? nullptr : it->second;
+  }
+  auto catalog_it =
+      cached_catalog_names_.find(IdentifierPathToString(catalog_name_path));
+  if (catalog_it == cached_catalog_names_.end()) return nullptr;
+  auto it = cached_proto_types_with_catalog_name_.find(
+      std::make_pair(descriptor, &catalog_it->second));
+  return it == cached_proto_types_with_catalog_name_.end() ? nullptr
+                                                           : it->second;
+}
+
+const EnumType* TypeFactory::FindCachedType(
+    const google::protobuf::EnumDescriptor* descriptor,
+    absl::Span<const std::string> catalog_name_path, bool is_opaque) const {
+  if (catalog_name_path.empty() && !is_opaque) {
+    auto it = cached_enum_types_.find(descriptor);
+    return it == cached_enum_types_.end() ? nullptr : it->second;
+  }
+  const internal::CatalogName* catalog = nullptr;
+  if (!catalog_name_path.empty()) {
+    auto catalog_it =
+        cached_catalog_names_.find(IdentifierPathToString(catalog_name_path));
+    if (catalog_it == cached_catalog_names_.end()) return nullptr;
+    catalog = &catalog_it->second;
+  }
+  auto it = cached_enum_types_with_extra_attributes_.find(
+      std::make_tuple(descriptor, catalog, is_opaque));
+  return it == cached_enum_types_with_extra_attributes_.end() ? nullptr
+                                                              : it->second;
+}
+
 const ProtoType* TypeFactory::MakeProtoTypeImpl(
     const google::protobuf::Descriptor* descriptor,
     absl::Span<const std::string> catalog_name_path) {
+  {
+    absl::ReaderMutexLock lock(&store_->mutex_);
+    const ProtoType* cached_type =
+        FindCachedType(descriptor, catalog_name_path);
+    if (cached_type != nullptr) return cached_type;
+  }
   absl::MutexLock lock(&store_->mutex_);
 
   const internal::CatalogName* cached_catalog =
@@ -453,6 +545,12 @@ const ProtoType* TypeFactory::MakeProtoTypeImpl(
 const EnumType* TypeFactory::MakeEnumTypeImpl(
     const google::protobuf::EnumDescriptor* descriptor,
     absl::Span<const std::string> catalog_name_path, bool is_opaque) {
+  {
+    absl::ReaderMutexLock lock(&store_->mutex_);
+    const EnumType* cached_type =
+        FindCachedType(descriptor, catalog_name_path, is_opaque);
+    if (cached_type != nullptr) return cached_type;
+  }
   absl::MutexLock lock(&store_->mutex_);
 
   const internal::CatalogName* cached_catalog =
@@ -556,7 +654,6 @@ absl::Status TypeFactory::MakeRangeType(const Type* element_type,
     return ::zetasql_base::InvalidArgumentErrorBuilder()
            << "Range type would exceed nesting depth limit of " << depth_limit;
   }
-  absl::MutexLock lock(&store_->mutex_);
   *result = MakeTypeWithChildElementType(element_type, cached_range_types_);
   return absl::OkStatus();
 }
@@ -609,8 +706,15 @@ absl::StatusOr<const Type*> TypeFactory::MakeMapType(const Type* key_type,
 
   // Cannot use TypeFactory::MakeTypeWithChildElementType here because we have a
   // pair of types.
-  absl::MutexLock lock(&store_->mutex_);
   auto type_pair = std::make_pair(key_type, value_type);
+  {
+    absl::ReaderMutexLock lock(&store_->mutex_);
+    auto it = cached_map_types_.find(type_pair);
+    if (it != cached_map_types_.end()) {
+      return it->second;
+    }
+  }
+  absl::MutexLock lock(&store_->mutex_);
   auto it = cached_map_types_.find(type_pair);
   if (it == cached_map_types_.end()) {
     auto [inserted_it, _] = cached_map_types_.insert(
@@ -1458,6 +1562,12 @@ void TypeFactory::AddDependency(const Type* other_type) {
   // is the static factory (since the static factory is never destroyed).
   if (other_store == store_ || other_store == s_type_factory()->store_) return;
 
+  {
+    absl::ReaderMutexLock l(&store_->mutex_);
+    if (store_->depends_on_factories_.contains(other_store)) {
+      return;  // Already had it.
+    }
+  }
   {
     absl::MutexLock l(&store_->mutex_);
     if (!zetasql_base::InsertIfNotPresent(&store_->depends_on_factories_, other_store)) {
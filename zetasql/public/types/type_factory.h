@@ -82,6 +82,15 @@ struct TypeFactoryOptions {
     keep_alive_while_referenced_from_value = false;
     return *this;
   }
+
+  // If this option is enabled, MakeStructType() returns the same StructType
+  // for all calls with the same field names and field type pointers, so that
+  // Equals() on such types, and on arrays of them, is a pointer comparison.
+  // Since array and proto types are already cached, this makes equal struct
+  // types built from the same factory pointer-equal at any nesting depth,
+  // unless their field names only differ in case. Costs a hash lookup per
+  // MakeStructType() call.
+  bool intern_struct_types = false;
 };
 
 namespace internal {  // For internal use only
@@ -432,8 +441,8 @@ class TypeFactory {
   // it cannot destruct. Use kint32max for no limit (the default).
   // The limit value must be >= 0. The default value of this field can be
   // overidden with FLAGS_zetasql_type_factory_nesting_depth_limit.
-  int nesting_depth_limit() const ABSL_LOCKS_EXCLUDED(store_->mutex_);
-  void set_nesting_depth_limit(int value) ABSL_LOCKS_EXCLUDED(store_->mutex_);
+  int nesting_depth_limit() const;
+  void set_nesting_depth_limit(int value);
 
   // Estimate memory size allocated to store TypeFactory's data in bytes
   int64_t GetEstimatedOwnedMemoryBytesSize() const;
@@ -475,6 +484,19 @@ class TypeFactory {
       absl::Span<const std::string> catalog_name_path, bool is_opaque)
       ABSL_LOCKS_EXCLUDED(store_->mutex_);
 
+  // Return the cached type for the arguments of MakeProtoTypeImpl() or
+  // MakeEnumTypeImpl(), or NULL if none has been created yet. These only need
+  // a shared lock, so that looking up types that already exist does not
+  // serialize concurrent callers.
+  const ProtoType* FindCachedType(
+      const google::protobuf::Descriptor* descriptor,
+      absl::Span<const std::string> catalog_name_path) const
+      ABSL_SHARED_LOCKS_REQUIRED(store_->mutex_);
+  const EnumType* FindCachedType(
+      const google::protobuf::EnumDescriptor* descriptor,
+      absl::Span<const std::string> catalog_name_path, bool is_opaque) const
+      ABSL_SHARED_LOCKS_REQUIRED(store_->mutex_);
+
   const ProtoType*& FindOrCreateCachedType(const google::protobuf::Descriptor* descriptor,
                                            const internal::CatalogName* catalog)
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(store_->mutex_);
@@ -497,12 +519,13 @@ class TypeFactory {
       const google::protobuf::FieldDescriptor* field_descr, TypeKind kind,
       absl::Span<const std::string> catalog_name_path, const Type** type);
 
-  // Returns an ArrayType or RangeType.
+  // Returns an ArrayType or RangeType. Only takes an exclusive lock if the
+  // type is not in 'cache' yet.
   template <class TYPE>
   const auto* MakeTypeWithChildElementType(
       const Type* element_type,
       absl::flat_hash_map<const Type*, const TYPE*>& cache)
-      ABSL_EXCLUSIVE_LOCKS_REQUIRED(store_->mutex_);
+      ABSL_LOCKS_EXCLUDED(store_->mutex_);
 
   // Implementation of MakeUnwrappedTypeFromProto above that detects invalid use
   // of type annotations with recursive protos by storing all visited message
@@ -558,9 +581,41 @@ class TypeFactory {
   // Cached extended types.
   TypeFlatHashSet<> cached_extended_types_ ABSL_GUARDED_BY(store_->mutex_);
 
+  // Hash and equality for 'cached_struct_types_', which also accept the
+  // fields of a struct type that has not been created yet. Two struct types
+  // are only interned together if their field names are identical and their
+  // field types are the same pointers.
+  using StructFields = absl::Span<const StructType::StructField>;
+  struct StructFieldsHash {
+    using is_transparent = void;
+    size_t operator()(StructFields fields) const;
+    size_t operator()(const StructType* type) const {
+      return (*this)(type->fields());
+    }
+  };
+  struct StructFieldsEq {
+    using is_transparent = void;
+    static StructFields Fields(const StructType* type) {
+      return type->fields();
+    }
+    static StructFields Fields(StructFields fields) { return fields; }
+    template <typename A, typename B>
+    bool operator()(const A& a, const B& b) const {
+      return FieldsEqual(Fields(a), Fields(b));
+    }
+    static bool FieldsEqual(StructFields fields1, StructFields fields2);
+  };
+
+  // Interned struct types, if 'intern_struct_types_'.
+  absl::flat_hash_set<const StructType*, StructFieldsHash, StructFieldsEq>
+      cached_struct_types_ ABSL_GUARDED_BY(store_->mutex_);
+
   internal::TypeStore* store_;  // Stores created types.
 
-  int nesting_depth_limit_ ABSL_GUARDED_BY(store_->mutex_);
+  const bool intern_struct_types_;
+
+  // Read without a lock on every MakeArrayType() and similar call.
+  std::atomic<int> nesting_depth_limit_;
 
   // Stores estimation of how much memory was allocated by instances
   // of types owned by this TypeFactory (in bytes)
@@ -17,6 +17,7 @@
 #ifndef ZETASQL_PUBLIC_TYPES_VALUE_REPRESENTATIONS_H_
 #define ZETASQL_PUBLIC_TYPES_VALUE_REPRESENTATIONS_H_
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <optional>
@@ -31,9 +32,11 @@
 #include "zetasql/public/numeric_value.h"
 #include "zetasql/public/token_list.h"  
 #include "zetasql/public/value_content.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/cord.h"
 #include "absl/types/optional.h"
 #include "absl/types/variant.h"
+#include "zetasql/base/arena.h"
 #include "zetasql/base/compact_reference_counted.h"
 
 // This file contains classes that are used to represent values of ZetaSQL
@@ -49,6 +52,7 @@
 namespace zetasql {
 
 class ProtoType;
+class ScopedValueStringArena;
 class Type;
 
 namespace internal {  // For ZetaSQL internal use only
@@ -139,6 +143,18 @@ class ValueContentContainerRef final
 // -------------------------------------------------------
 // ProtoRep
 // -------------------------------------------------------
+// The byte ranges of the fields in a serialized proto, so that fields can be
+// read without scanning the whole proto. Built by BuildProtoFieldIndex() in
+// public/proto_util.h.
+struct ProtoFieldIndex {
+  // Maps a field number to the [begin, end) offsets of its (tag, value) pairs,
+  // in wire order. Adjacent pairs of the same field share one range.
+  absl::flat_hash_map<int, std::vector<std::pair<int, int>>> field_ranges;
+
+  // An approximation of the memory used by this object.
+  int64_t physical_byte_size = 0;
+};
+
 // Even though Cord is internally reference counted, ProtoRep is reference
 // counted so that the internal representation can keep track of state
 // associated with a ProtoRep (specifically, already deserialized fields).
@@ -152,13 +168,36 @@ class ProtoRep final
   ProtoRep(const ProtoRep&) = delete;
   ProtoRep& operator=(const ProtoRep&) = delete;
 
+  ~ProtoRep() { delete field_index_.load(std::memory_order_relaxed); }
+
   const absl::Cord& value() const { return value_; }
   uint64_t physical_byte_size() const {
     return sizeof(ProtoRep) + value_.size();
   }
 
+  // Returns the index of the fields in value(), or nullptr if none has been
+  // set. The index is not included in physical_byte_size(), which must not
+  // change over the lifetime of a Value.
+  const ProtoFieldIndex* field_index() const {
+    return field_index_.load(std::memory_order_acquire);
+  }
+
+  // Sets the index of the fields in value(), unless another thread set one
+  // first. Returns the index that is set.
+  const ProtoFieldIndex* SetFieldIndex(
+      std::unique_ptr<const ProtoFieldIndex> field_index) const {
+    const ProtoFieldIndex* expected = nullptr;
+    if (field_index_.compare_exchange_strong(expected, field_index.get(),
+                                             std::memory_order_acq_rel)) {
+      return field_index.release();
+    }
+    return expected;
+  }
+
  private:
   const absl::Cord value_;
+  // Owned. Mutable because it is derived from 'value_'.
+  mutable std::atomic<const ProtoFieldIndex*> field_index_ = nullptr;
 };
 
 class GeographyRef final
@@ -239,14 +278,59 @@ class StringRef final
   StringRef(const StringRef&) = delete;
   StringRef& operator=(const StringRef&) = delete;
 
+  // Returns a new StringRef holding 'value'. It is allocated from the arena of
+  // the innermost ScopedValueStringArena of the current thread if there is
+  // one, and from the heap otherwise.
+  static StringRef* Create(std::string value) {
+    if (arena_ == nullptr) {
+      return new StringRef(std::move(value));
+    }
+    StringRef* ref = new (arena_->AllocAligned(sizeof(StringRef),
+                                               alignof(StringRef)))
+        StringRef(std::move(value));
+    ref->arena_allocated_ = true;
+    return ref;
+  }
+
   const std::string& value() const { return value_; }
 
   uint64_t physical_byte_size() const {
     return sizeof(StringRef) + value_.size() * sizeof(char);
   }
 
+  // A hash of value() that a user of this class may cache here, so that the
+  // Values sharing this StringRef (e.g., the entries of a dictionary-encoded
+  // column) only need to compute it once. 0 means that it is not set yet. See
+  // InternalValue::StringContentHash().
+  uint32_t cached_hash() const {
+    return cached_hash_.load(std::memory_order_relaxed);
+  }
+  void set_cached_hash(uint32_t hash) const {
+    cached_hash_.store(hash, std::memory_order_relaxed);
+  }
+
  private:
+  friend class zetasql_base::refcount::CompactReferenceCounted<StringRef,
+                                                               int64_t>;
+  friend class ::zetasql::ScopedValueStringArena;
+
+  void OnRefCountIsZero() const {
+    if (arena_allocated_) {
+      // The memory is released with the arena. Strings that do not fit into
+      // the std::string inline buffer still own a heap allocation.
+      this->~StringRef();
+    } else {
+      delete this;
+    }
+  }
+
+  // The arena of the innermost ScopedValueStringArena of this thread.
+  static inline thread_local zetasql_base::UnsafeArena* arena_ = nullptr;
+
   const std::string value_;
+  bool arena_allocated_ = false;
+  // Fits into the padding after 'arena_allocated_'.
+  mutable std::atomic<uint32_t> cached_hash_ = 0;
 };
 
 // -------------------------------------------------------
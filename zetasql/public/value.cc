@@ -259,6 +259,38 @@ absl::StatusOr<Value> Value::MakeArrayInternal(bool already_validated,
   return result;
 }
 
+template <typename T>
+absl::StatusOr<Value> Value::MakePackedArrayInternal(
+    const ArrayType* array_type, TypeKind element_kind, std::vector<T> values,
+    std::vector<bool> is_null) {
+  ZETASQL_RET_CHECK(array_type->element_type()->kind() == element_kind)
+      << "Packed array elements must be of type "
+      << array_type->element_type()->DebugString();
+  ZETASQL_RET_CHECK(is_null.empty() || is_null.size() == values.size())
+      << "Packed array has " << values.size() << " elements but "
+      << is_null.size() << " null flags";
+
+  Value result(array_type, /*is_null=*/false, kPreservesOrder);
+  result.container_ptr_ = new internal::ValueContentContainerRef(
+      std::make_unique<TypedList>(std::move(values), std::move(is_null)),
+      /*preserves_order=*/true);
+  return result;
+}
+
+absl::StatusOr<Value> Value::MakePackedArray(const ArrayType* array_type,
+                                             std::vector<int64_t> values,
+                                             std::vector<bool> is_null) {
+  return MakePackedArrayInternal(array_type, TYPE_INT64, std::move(values),
+                                 std::move(is_null));
+}
+
+absl::StatusOr<Value> Value::MakePackedArray(const ArrayType* array_type,
+                                             std::vector<double> values,
+                                             std::vector<bool> is_null) {
+  return MakePackedArrayInternal(array_type, TYPE_DOUBLE, std::move(values),
+                                 std::move(is_null));
+}
+
 absl::StatusOr<Value> Value::MakeStructInternal(bool already_validated,
                                                 const StructType* struct_type,
                                                 std::vector<Value> values) {
@@ -538,6 +570,101 @@ uint64_t Value::physical_byte_size() const {
   return physical_size;
 }
 
+const void* ValueMemoryTracker::GetSharedContent(const Value& value) {
+  if (!value.has_content()) {
+    return nullptr;
+  }
+  switch (value.metadata_.type_kind()) {
+    case TYPE_ARRAY:
+    case TYPE_STRUCT:
+    case TYPE_RANGE:
+      return value.container_ptr_;
+    case TYPE_MAP:
+      return value.map_ptr_;
+    case TYPE_STRING:
+    case TYPE_BYTES:
+      return value.string_ptr_;
+    case TYPE_PROTO:
+      return value.proto_ptr_;
+    case TYPE_GEOGRAPHY:
+      return value.geography_ptr_;
+    case TYPE_NUMERIC:
+      return value.numeric_ptr_;
+    case TYPE_BIGNUMERIC:
+      return value.bignumeric_ptr_;
+    case TYPE_JSON:
+      return value.json_ptr_;
+    case TYPE_TOKENLIST:
+      return value.tokenlist_ptr_;
+    default:
+      // Either inline content or content of an extended type, whose sharing
+      // we know nothing about.
+      return nullptr;
+  }
+}
+
+uint64_t ValueMemoryTracker::Update(const Value& value, bool add) {
+  const void* content = GetSharedContent(value);
+  if (content == nullptr) {
+    return value.physical_byte_size();
+  }
+
+  if (add) {
+    if (++ref_counts_[content] > 1) {
+      return Value::shallow_physical_byte_size();
+    }
+  } else {
+    auto it = ref_counts_.find(content);
+    ABSL_DCHECK(it != ref_counts_.end());
+    if (it == ref_counts_.end()) {
+      return Value::shallow_physical_byte_size();
+    }
+    if (--it->second > 0) {
+      return Value::shallow_physical_byte_size();
+    }
+    ref_counts_.erase(it);
+  }
+
+  // 'value' is the first or last tracked reference to 'content'.
+  uint64_t num_bytes = Value::shallow_physical_byte_size();
+  if (value.DoesTypeUseValueList()) {
+    const Value::TypedList* const list_ptr =
+        static_cast<const Value::TypedList*>(value.container_ptr_->value());
+    if (list_ptr->is_packed()) {
+      // Packed elements do not reference any shared content.
+      return num_bytes + value.container_ptr_->physical_byte_size();
+    }
+    num_bytes += sizeof(internal::ValueContentContainerRef) +
+                 sizeof(Value::TypedList);
+    for (const Value& element : list_ptr->values()) {
+      num_bytes += Update(element, add);
+    }
+  } else if (value.DoesTypeUseValueMap()) {
+    num_bytes += sizeof(internal::ValueContentMapRef) + sizeof(Value::TypedMap);
+    for (const auto& [entry_key, entry_value] :
+         static_cast<const Value::TypedMap*>(value.map_ptr_->value())
+             ->entries()) {
+      num_bytes += Update(entry_key, add) + Update(entry_value, add);
+    }
+  } else {
+    return value.physical_byte_size();
+  }
+  return num_bytes;
+}
+
+uint64_t ValueMemoryTracker::Add(const Value& value) {
+  const uint64_t num_bytes = Update(value, /*add=*/true);
+  byte_size_ += num_bytes;
+  return num_bytes;
+}
+
+uint64_t ValueMemoryTracker::Remove(const Value& value) {
+  const uint64_t num_bytes = Update(value, /*add=*/false);
+  ABSL_DCHECK_LE(num_bytes, byte_size_);
+  byte_size_ -= num_bytes;
+  return num_bytes;
+}
+
 absl::Cord Value::ToCord() const {
   ABSL_CHECK(!is_null()) << "Null value";
   switch (metadata_.type_kind()) {
@@ -1754,6 +1881,22 @@ Value::Metadata::Metadata(const Type* type, bool is_null,
 Value::TypedList::~TypedList() {
 }
 
+void Value::TypedList::MaterializeValues() const {
+  const int64_t size = num_elements();
+  values_.reserve(size);
+  for (int64_t i = 0; i < size; ++i) {
+    if (packed_kind_ == TYPE_INT64) {
+      values_.push_back(packed_is_null(i)
+                            ? Value::NullInt64()
+                            : Value::Int64(packed_int64_values_[i]));
+    } else {
+      values_.push_back(packed_is_null(i)
+                            ? Value::NullDouble()
+                            : Value::Double(packed_double_values_[i]));
+    }
+  }
+}
+
 Value::TypedMap::~TypedMap() {
 }
 
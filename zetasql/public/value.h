@@ -55,6 +55,7 @@
 #include "absl/time/civil_time.h"
 #include "absl/time/time.h"
 #include "absl/types/span.h"
+#include "zetasql/base/arena.h"
 #include "zetasql/base/map_view.h"
 
 namespace zetasql {
@@ -126,9 +127,18 @@ class Value {
   TypeKind type_kind() const;
 
   // Returns the estimated size of the in-memory C++ representation of this
-  // value.
+  // value. This is a deep size: ref-counted content (strings, protos, arrays,
+  // ...) is included even if it is shared with other Values, so summing it
+  // over several Values can overcount. Use ValueMemoryTracker to account for
+  // a collection of Values that may share content.
   uint64_t physical_byte_size() const;
 
+  // Returns the size of this Value object alone, excluding any content that it
+  // references.
+  static constexpr uint64_t shallow_physical_byte_size() {
+    return sizeof(Value);
+  }
+
   // Returns true if the value is null.
   bool is_null() const;
 
@@ -270,9 +280,24 @@ class Value {
   int num_elements() const;
 
   // Array-specific methods. REQUIRES: !is_null(), type_kind() == TYPE_ARRAY.
+  //
+  // For an array created with MakePackedArray(), element() and elements()
+  // create a Value per element on their first call.
   const Value& element(int i) const;
   const std::vector<Value>& elements() const;
 
+  // Returns true if this array was created with MakePackedArray(), in which
+  // case its elements can be read without creating Values with
+  // packed_int64_elements() or packed_double_elements() and
+  // packed_element_is_null().
+  bool has_packed_elements() const;
+  // Require has_packed_elements() and an element type of INT64 or DOUBLE,
+  // respectively. The entries for NULL elements are 0.
+  absl::Span<const int64_t> packed_int64_elements() const;
+  absl::Span<const double> packed_double_elements() const;
+  // Requires has_packed_elements().
+  bool packed_element_is_null(int i) const;
+
   // Map-specific methods. REQUIRES: !is_null(), type_kind() == TYPE_MAP.
   // Returns the entries of the map. Note that a stable order is not guaranteed.
   zetasql_base::MapView<Value, Value> map_entries() const;
@@ -665,6 +690,23 @@ class Value {
   static absl::StatusOr<Value> MakeArray(const ArrayType* array_type,
                                          std::initializer_list<Value> values);
 
+  // Creates an array of the given 'array_type', whose element type must be
+  // INT64 or DOUBLE respectively, with the elements 'values'. If 'is_null' is
+  // not empty, it must have the same size as 'values', and element 'i' is
+  // NULL if 'is_null[i]' is true.
+  //
+  // The elements are stored in a single buffer instead of one Value each,
+  // which takes less memory and lets functions such as ARRAY_SUM read them
+  // without creating Values (see has_packed_elements()). The array is
+  // otherwise equivalent to one created with MakeArray().
+  // 'array_type' must outlive the returned object.
+  static absl::StatusOr<Value> MakePackedArray(const ArrayType* array_type,
+                                               std::vector<int64_t> values,
+                                               std::vector<bool> is_null = {});
+  static absl::StatusOr<Value> MakePackedArray(const ArrayType* array_type,
+                                               std::vector<double> values,
+                                               std::vector<bool> is_null = {});
+
   // Creates an array of the specified 'array_type' and given 'values'.
   // The type of each value must be the same as array_type->element_type().
   // This precondition is tested only during debug mode, and will result in
@@ -767,6 +809,7 @@ class Value {
  private:
   // For access to StringRef and TypedList.
   FRIEND_TEST(ValueTest, PhysicalByteSize);
+  FRIEND_TEST(ValueTest, ValueMemoryTrackerCountsSharedContentOnce);
   // For access to GetContent() and MakeArrayInternal
   FRIEND_TEST(TypeTest, FormatValueContentArraySQLLiteralMode);
   FRIEND_TEST(TypeTest, FormatValueContentArraySQLExpressionMode);
@@ -789,6 +832,7 @@ class Value {
   friend class InternalValue;  // Defined in zetasql/common/internal_value.h.
   friend struct InternalComparer;  // Defined in value.cc.
   friend struct InternalHasher;    // Defined in value.cc
+  friend class ValueMemoryTracker;
   class TypedList;                 // Defined in value_inl.h
   class TypedMap;                  // Defined in value_inl.h
 
@@ -897,6 +941,12 @@ class Value {
   // Creates a struct of the given 'struct_type' initialized by moving from
   // 'values'. Each value must have the proper type. This property is validated
   // if 'already_validated' is false or we are in debug mode.
+  // Implements MakePackedArray() for a packed element type T.
+  template <typename T>
+  static absl::StatusOr<Value> MakePackedArrayInternal(
+      const ArrayType* array_type, TypeKind element_kind,
+      std::vector<T> values, std::vector<bool> is_null);
+
   static absl::StatusOr<Value> MakeStructInternal(bool already_validated,
                                                   const StructType* struct_type,
                                                   std::vector<Value> values);
@@ -1104,6 +1154,86 @@ static_assert(sizeof(Value) == sizeof(int64_t) * 2, "Value size mismatch");
 // Allow Value to be logged.
 std::ostream& operator<<(std::ostream& out, const Value& value);
 
+// While an instance is alive, STRING and BYTES Values created on the current
+// thread allocate their content from 'arena' instead of the heap, so that all
+// of them are released together when 'arena' is reset or destroyed. Strings
+// short enough for the inline buffer of std::string then need no heap
+// allocation at all; longer ones still allocate their characters.
+//
+// Every Value created in the scope, and every copy of it, must be destroyed
+// before 'arena' is reset or destroyed. Copying a Value shares its content, so
+// results that need to outlive 'arena' must be rebuilt outside of the scope.
+// Scopes can be nested; the innermost one is used.
+//
+// Example:
+//   zetasql_base::UnsafeArena arena(/*block_size=*/64 << 10);
+//   {
+//     ScopedValueStringArena scope(&arena);
+//     ... evaluate a statement and consume its results ...
+//   }
+//   arena.Reset();
+class ScopedValueStringArena {
+ public:
+  explicit ScopedValueStringArena(zetasql_base::UnsafeArena* arena)
+      : previous_arena_(internal::StringRef::arena_) {
+    internal::StringRef::arena_ = arena;
+  }
+  ~ScopedValueStringArena() { internal::StringRef::arena_ = previous_arena_; }
+
+  ScopedValueStringArena(const ScopedValueStringArena&) = delete;
+  ScopedValueStringArena& operator=(const ScopedValueStringArena&) = delete;
+
+ private:
+  zetasql_base::UnsafeArena* const previous_arena_;
+};
+
+// Accounts for the memory used by a collection of Values, counting content
+// that several of them share only once. Copying a STRING, BYTES, PROTO, ARRAY,
+// STRUCT, RANGE, MAP, GEOGRAPHY, JSON, NUMERIC, BIGNUMERIC or TOKENLIST Value
+// shares its content, which physical_byte_size() would charge once per copy.
+//
+// Add() and Remove() return the number of bytes by which the collection grew
+// or shrank: the shallow size of the Value, plus the size of any content that
+// it is the first (or last) tracked Value to reference. Elements of arrays,
+// structs and maps are tracked recursively, so that content shared between
+// containers is also counted once. Content must not be mutated while it is
+// tracked, and every added Value must be removed before the tracker is
+// destroyed if the returned sizes are used to balance a MemoryAccountant.
+//
+// Not thread-safe.
+class ValueMemoryTracker {
+ public:
+  ValueMemoryTracker() = default;
+  ValueMemoryTracker(const ValueMemoryTracker&) = delete;
+  ValueMemoryTracker& operator=(const ValueMemoryTracker&) = delete;
+
+  // Starts tracking 'value' and returns the number of newly used bytes.
+  uint64_t Add(const Value& value);
+
+  // Stops tracking a Value previously passed to Add() (or one that shares its
+  // content) and returns the number of bytes that are no longer used.
+  uint64_t Remove(const Value& value);
+
+  // Returns the number of bytes used by the tracked Values.
+  uint64_t byte_size() const { return byte_size_; }
+
+  // Returns the number of distinct shared buffers referenced by the tracked
+  // Values.
+  int64_t num_shared_buffers() const { return ref_counts_.size(); }
+
+ private:
+  // Returns the shared, immutable content of 'value', or nullptr if it does
+  // not have any (or if it is not known to be ref-counted).
+  static const void* GetSharedContent(const Value& value);
+
+  // Returns the bytes that 'value' adds to (or removes from) the collection.
+  uint64_t Update(const Value& value, bool add);
+
+  // Reference counts of the shared content of the tracked Values.
+  absl::flat_hash_map<const void*, int64_t> ref_counts_;
+  uint64_t byte_size_ = 0;
+};
+
 namespace values {
 
 // Constructors below wrap the respective static methods in Value class. See
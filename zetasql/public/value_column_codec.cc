@@ -0,0 +1,531 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/value_column_codec.h"
+
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/base/endian.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/functions/date_time_util.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/type.pb.h"
+#include "zetasql/public/value.h"
+#include "zetasql/public/value.pb.h"
+#include "absl/base/casts.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+namespace {
+
+// The first byte of the encodings of EncodeTableResult().
+constexpr char kTableResultVersion = 1;
+
+absl::Status InvalidEncoding() {
+  return zetasql_base::OutOfRangeErrorBuilder() << "Invalid encoded value column";
+}
+
+void PutVarint(uint64_t value, std::string* output) {
+  while (value >= 0x80) {
+    output->push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  output->push_back(static_cast<char>(value));
+}
+
+void PutFixed32(uint32_t value, std::string* output) {
+  char buffer[sizeof(value)];
+  zetasql_base::LittleEndian::Store32(buffer, value);
+  output->append(buffer, sizeof(buffer));
+}
+
+void PutFixed64(uint64_t value, std::string* output) {
+  char buffer[sizeof(value)];
+  zetasql_base::LittleEndian::Store64(buffer, value);
+  output->append(buffer, sizeof(buffer));
+}
+
+void PutBytes(absl::string_view bytes, std::string* output) {
+  PutVarint(bytes.size(), output);
+  output->append(bytes);
+}
+
+// Reads the encodings of PutVarint() and friends from the front of an input.
+// Each method returns false at the end of the input.
+class Reader {
+ public:
+  explicit Reader(absl::string_view* input) : input_(input) {}
+
+  bool ReadVarint(uint64_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (input_->empty()) return false;
+      const uint8_t byte = static_cast<uint8_t>(input_->front());
+      input_->remove_prefix(1);
+      *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+  }
+
+  bool ReadFixed32(uint32_t* value) {
+    if (input_->size() < sizeof(*value)) return false;
+    *value = zetasql_base::LittleEndian::Load32(input_->data());
+    input_->remove_prefix(sizeof(*value));
+    return true;
+  }
+
+  bool ReadFixed64(uint64_t* value) {
+    if (input_->size() < sizeof(*value)) return false;
+    *value = zetasql_base::LittleEndian::Load64(input_->data());
+    input_->remove_prefix(sizeof(*value));
+    return true;
+  }
+
+  // 'bytes' points into the input.
+  bool ReadRaw(uint64_t size, absl::string_view* bytes) {
+    if (input_->size() < size) return false;
+    *bytes = input_->substr(0, size);
+    input_->remove_prefix(size);
+    return true;
+  }
+
+  bool ReadBytes(absl::string_view* bytes) {
+    uint64_t size;
+    return ReadVarint(&size) && ReadRaw(size, bytes);
+  }
+
+ private:
+  absl::string_view* input_;
+};
+
+// Appends the kinds of 'type' and of the types that it is made of to
+// 'output', so that columns of a different shape are detected on decoding.
+void EncodeTypeShape(const Type* type, std::string* output) {
+  PutVarint(type->kind(), output);
+  if (type->IsArray()) {
+    EncodeTypeShape(type->AsArray()->element_type(), output);
+  } else if (type->IsStruct()) {
+    PutVarint(type->AsStruct()->num_fields(), output);
+    for (const StructField& field : type->AsStruct()->fields()) {
+      EncodeTypeShape(field.type, output);
+    }
+  }
+}
+
+absl::Status EncodeColumn(const Type* type,
+                          absl::Span<const Value* const> values,
+                          std::string* output) {
+  PutVarint(values.size(), output);
+  std::string nulls((values.size() + 7) / 8, '\0');
+  std::vector<const Value*> non_nulls;
+  non_nulls.reserve(values.size());
+  for (int i = 0; i < values.size(); ++i) {
+    const Value& value = *values[i];
+    ZETASQL_RET_CHECK(value.is_valid());
+    ZETASQL_RET_CHECK(value.type()->Equals(type))
+        << "Value of type " << value.type()->DebugString()
+        << " in a column of type " << type->DebugString();
+    if (value.is_null()) {
+      nulls[i / 8] |= static_cast<char>(1 << (i % 8));
+    } else {
+      non_nulls.push_back(&value);
+    }
+  }
+  output->append(nulls);
+
+  switch (type->kind()) {
+    case TYPE_BOOL:
+      for (const Value* value : non_nulls) {
+        output->push_back(value->bool_value() ? 1 : 0);
+      }
+      return absl::OkStatus();
+    case TYPE_INT32:
+      for (const Value* value : non_nulls) {
+        PutFixed32(static_cast<uint32_t>(value->int32_value()), output);
+      }
+      return absl::OkStatus();
+    case TYPE_DATE:
+      for (const Value* value : non_nulls) {
+        PutFixed32(static_cast<uint32_t>(value->date_value()), output);
+      }
+      return absl::OkStatus();
+    case TYPE_ENUM:
+      for (const Value* value : non_nulls) {
+        PutFixed32(static_cast<uint32_t>(value->enum_value()), output);
+      }
+      return absl::OkStatus();
+    case TYPE_UINT32:
+      for (const Value* value : non_nulls) {
+        PutFixed32(value->uint32_value(), output);
+      }
+      return absl::OkStatus();
+    case TYPE_FLOAT:
+      for (const Value* value : non_nulls) {
+        PutFixed32(absl::bit_cast<uint32_t>(value->float_value()), output);
+      }
+      return absl::OkStatus();
+    case TYPE_INT64:
+      for (const Value* value : non_nulls) {
+        PutFixed64(static_cast<uint64_t>(value->int64_value()), output);
+      }
+      return absl::OkStatus();
+    case TYPE_UINT64:
+      for (const Value* value : non_nulls) {
+        PutFixed64(value->uint64_value(), output);
+      }
+      return absl::OkStatus();
+    case TYPE_DOUBLE:
+      for (const Value* value : non_nulls) {
+        PutFixed64(absl::bit_cast<uint64_t>(value->double_value()), output);
+      }
+      return absl::OkStatus();
+    case TYPE_STRING:
+      for (const Value* value : non_nulls) {
+        PutBytes(value->string_value(), output);
+      }
+      return absl::OkStatus();
+    case TYPE_BYTES:
+      for (const Value* value : non_nulls) {
+        PutBytes(value->bytes_value(), output);
+      }
+      return absl::OkStatus();
+    case TYPE_TIMESTAMP:
+      // Seconds since the epoch, rounded down, and the nanoseconds after them.
+      for (const Value* value : non_nulls) {
+        const absl::Time time = value->ToTime();
+        const int64_t seconds = absl::ToUnixSeconds(time);
+        const int64_t nanos =
+            (time - absl::FromUnixSeconds(seconds)) / absl::Nanoseconds(1);
+        PutFixed64(static_cast<uint64_t>(seconds), output);
+        PutFixed32(static_cast<uint32_t>(nanos), output);
+      }
+      return absl::OkStatus();
+    case TYPE_ARRAY: {
+      std::vector<const Value*> elements;
+      for (const Value* value : non_nulls) {
+        PutVarint(value->num_elements(), output);
+        for (int i = 0; i < value->num_elements(); ++i) {
+          elements.push_back(&value->element(i));
+        }
+      }
+      return EncodeColumn(type->AsArray()->element_type(), elements, output);
+    }
+    case TYPE_STRUCT: {
+      const StructType* struct_type = type->AsStruct();
+      std::vector<const Value*> fields(non_nulls.size());
+      for (int field = 0; field < struct_type->num_fields(); ++field) {
+        for (int i = 0; i < non_nulls.size(); ++i) {
+          fields[i] = &non_nulls[i]->field(field);
+        }
+        ZETASQL_RETURN_IF_ERROR(
+            EncodeColumn(struct_type->field(field).type, fields, output));
+      }
+      return absl::OkStatus();
+    }
+    default: {
+      ValueProto value_proto;
+      std::string bytes;
+      for (const Value* value : non_nulls) {
+        ZETASQL_RETURN_IF_ERROR(value->Serialize(&value_proto));
+        bytes.clear();
+        ZETASQL_RET_CHECK(value_proto.SerializeToString(&bytes));
+        PutBytes(bytes, output);
+      }
+      return absl::OkStatus();
+    }
+  }
+}
+
+absl::Status DecodeColumn(const Type* type, Reader& reader,
+                          std::vector<Value>* values);
+
+// Decodes the 'num_non_nulls' non-NULL values of type 'type' of a column into
+// 'values'.
+absl::Status DecodeNonNulls(const Type* type, uint64_t num_non_nulls,
+                            Reader& reader, std::vector<Value>* values) {
+  values->reserve(num_non_nulls);
+  switch (type->kind()) {
+    case TYPE_BOOL:
+      for (uint64_t i = 0; i < num_non_nulls; ++i) {
+        absl::string_view byte;
+        if (!reader.ReadRaw(1, &byte) || (byte[0] != 0 && byte[0] != 1)) {
+          return InvalidEncoding();
+        }
+        values->push_back(Value::Bool(byte[0] == 1));
+      }
+      return absl::OkStatus();
+    case TYPE_INT32:
+    case TYPE_DATE:
+    case TYPE_ENUM:
+    case TYPE_UINT32:
+    case TYPE_FLOAT:
+      for (uint64_t i = 0; i < num_non_nulls; ++i) {
+        uint32_t bits;
+        if (!reader.ReadFixed32(&bits)) return InvalidEncoding();
+        switch (type->kind()) {
+          case TYPE_INT32:
+            values->push_back(Value::Int32(static_cast<int32_t>(bits)));
+            break;
+          case TYPE_DATE:
+            values->push_back(Value::Date(static_cast<int32_t>(bits)));
+            break;
+          case TYPE_ENUM:
+            values->push_back(
+                Value::Enum(type->AsEnum(), static_cast<int32_t>(bits)));
+            if (!values->back().is_valid()) return InvalidEncoding();
+            break;
+          case TYPE_UINT32:
+            values->push_back(Value::Uint32(bits));
+            break;
+          default:
+            values->push_back(Value::Float(absl::bit_cast<float>(bits)));
+            break;
+        }
+      }
+      return absl::OkStatus();
+    case TYPE_INT64:
+    case TYPE_UINT64:
+    case TYPE_DOUBLE:
+      for (uint64_t i = 0; i < num_non_nulls; ++i) {
+        uint64_t bits;
+        if (!reader.ReadFixed64(&bits)) return InvalidEncoding();
+        if (type->kind() == TYPE_INT64) {
+          values->push_back(Value::Int64(static_cast<int64_t>(bits)));
+        } else if (type->kind() == TYPE_UINT64) {
+          values->push_back(Value::Uint64(bits));
+        } else {
+          values->push_back(Value::Double(absl::bit_cast<double>(bits)));
+        }
+      }
+      return absl::OkStatus();
+    case TYPE_STRING:
+    case TYPE_BYTES:
+      for (uint64_t i = 0; i < num_non_nulls; ++i) {
+        absl::string_view bytes;
+        if (!reader.ReadBytes(&bytes)) return InvalidEncoding();
+        values->push_back(type->kind() == TYPE_STRING ? Value::String(bytes)
+                                                      : Value::Bytes(bytes));
+      }
+      return absl::OkStatus();
+    case TYPE_TIMESTAMP:
+      for (uint64_t i = 0; i < num_non_nulls; ++i) {
+        uint64_t seconds;
+        uint32_t nanos;
+        if (!reader.ReadFixed64(&seconds) || !reader.ReadFixed32(&nanos) ||
+            nanos >= 1000000000) {
+          return InvalidEncoding();
+        }
+        const absl::Time time =
+            absl::FromUnixSeconds(static_cast<int64_t>(seconds)) +
+            absl::Nanoseconds(nanos);
+        if (!functions::IsValidTime(time)) return InvalidEncoding();
+        values->push_back(Value::Timestamp(time));
+      }
+      return absl::OkStatus();
+    case TYPE_ARRAY: {
+      std::vector<uint64_t> sizes(num_non_nulls);
+      uint64_t num_elements = 0;
+      for (uint64_t& size : sizes) {
+        if (!reader.ReadVarint(&size)) return InvalidEncoding();
+        num_elements += size;
+      }
+      const ArrayType* array_type = type->AsArray();
+      std::vector<Value> elements;
+      ZETASQL_RETURN_IF_ERROR(
+          DecodeColumn(array_type->element_type(), reader, &elements));
+      if (elements.size() != num_elements) return InvalidEncoding();
+      auto next_element = elements.begin();
+      for (uint64_t size : sizes) {
+        // The sum of 'sizes' may have overflowed.
+        if (size > static_cast<uint64_t>(elements.end() - next_element)) {
+          return InvalidEncoding();
+        }
+        std::vector<Value> array_elements(
+            std::make_move_iterator(next_element),
+            std::make_move_iterator(next_element + size));
+        next_element += size;
+        ZETASQL_ASSIGN_OR_RETURN(Value array,
+                         Value::MakeArrayFromValidatedInputs(
+                             array_type, std::move(array_elements)));
+        values->push_back(std::move(array));
+      }
+      return absl::OkStatus();
+    }
+    case TYPE_STRUCT: {
+      const StructType* struct_type = type->AsStruct();
+      std::vector<std::vector<Value>> fields(struct_type->num_fields());
+      for (int field = 0; field < struct_type->num_fields(); ++field) {
+        ZETASQL_RETURN_IF_ERROR(DecodeColumn(struct_type->field(field).type, reader,
+                                     &fields[field]));
+        if (fields[field].size() != num_non_nulls) return InvalidEncoding();
+      }
+      for (uint64_t i = 0; i < num_non_nulls; ++i) {
+        std::vector<Value> struct_fields;
+        struct_fields.reserve(fields.size());
+        for (std::vector<Value>& field : fields) {
+          struct_fields.push_back(std::move(field[i]));
+        }
+        ZETASQL_ASSIGN_OR_RETURN(Value value,
+                         Value::MakeStructFromValidatedInputs(
+                             struct_type, std::move(struct_fields)));
+        values->push_back(std::move(value));
+      }
+      return absl::OkStatus();
+    }
+    default: {
+      ValueProto value_proto;
+      for (uint64_t i = 0; i < num_non_nulls; ++i) {
+        absl::string_view bytes;
+        if (!reader.ReadBytes(&bytes) ||
+            !value_proto.ParseFromArray(bytes.data(),
+                                        static_cast<int>(bytes.size()))) {
+          return InvalidEncoding();
+        }
+        ZETASQL_ASSIGN_OR_RETURN(Value value, Value::Deserialize(value_proto, type));
+        values->push_back(std::move(value));
+      }
+      return absl::OkStatus();
+    }
+  }
+}
+
+absl::Status DecodeColumn(const Type* type, Reader& reader,
+                          std::vector<Value>* values) {
+  uint64_t num_values;
+  absl::string_view nulls;
+  if (!reader.ReadVarint(&num_values) ||
+      !reader.ReadRaw((num_values + 7) / 8, &nulls)) {
+    return InvalidEncoding();
+  }
+  auto is_null = [&nulls](uint64_t i) {
+    return (static_cast<uint8_t>(nulls[i / 8]) >> (i % 8) & 1) != 0;
+  };
+  uint64_t num_non_nulls = 0;
+  for (uint64_t i = 0; i < num_values; ++i) {
+    if (!is_null(i)) ++num_non_nulls;
+  }
+  std::vector<Value> non_nulls;
+  ZETASQL_RETURN_IF_ERROR(DecodeNonNulls(type, num_non_nulls, reader, &non_nulls));
+
+  values->reserve(values->size() + num_values);
+  auto next_non_null = non_nulls.begin();
+  for (uint64_t i = 0; i < num_values; ++i) {
+    if (is_null(i)) {
+      values->push_back(Value::Null(type));
+    } else {
+      values->push_back(std::move(*next_non_null++));
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::Status EncodeValueColumn(const Type* type,
+                               absl::Span<const Value> values,
+                               std::string* output) {
+  std::vector<const Value*> pointers;
+  pointers.reserve(values.size());
+  for (const Value& value : values) {
+    pointers.push_back(&value);
+  }
+  return EncodeColumn(type, pointers, output);
+}
+
+absl::Status DecodeValueColumn(const Type* type, absl::string_view* input,
+                               std::vector<Value>* values) {
+  Reader reader(input);
+  return DecodeColumn(type, reader, values);
+}
+
+absl::StatusOr<std::string> EncodeTableResult(EvaluatorTableIterator* iter) {
+  const int num_columns = iter->NumColumns();
+  std::vector<std::vector<Value>> columns(num_columns);
+  while (iter->NextRow()) {
+    for (int i = 0; i < num_columns; ++i) {
+      columns[i].push_back(iter->GetValue(i));
+    }
+  }
+  ZETASQL_RETURN_IF_ERROR(iter->Status());
+
+  std::string output(1, kTableResultVersion);
+  PutVarint(num_columns, &output);
+  for (int i = 0; i < num_columns; ++i) {
+    PutBytes(iter->GetColumnName(i), &output);
+    std::string shape;
+    EncodeTypeShape(iter->GetColumnType(i), &shape);
+    PutBytes(shape, &output);
+  }
+  for (int i = 0; i < num_columns; ++i) {
+    ZETASQL_RETURN_IF_ERROR(
+        EncodeValueColumn(iter->GetColumnType(i), columns[i], &output));
+  }
+  return output;
+}
+
+absl::StatusOr<DecodedTableResult> DecodeTableResult(
+    absl::string_view encoded, absl::Span<const Type* const> column_types) {
+  Reader reader(&encoded);
+  absl::string_view version;
+  uint64_t num_columns;
+  if (!reader.ReadRaw(1, &version) || version[0] != kTableResultVersion ||
+      !reader.ReadVarint(&num_columns) ||
+      num_columns != column_types.size()) {
+    return InvalidEncoding();
+  }
+  DecodedTableResult result;
+  for (const Type* type : column_types) {
+    absl::string_view name;
+    absl::string_view shape;
+    if (!reader.ReadBytes(&name) || !reader.ReadBytes(&shape)) {
+      return InvalidEncoding();
+    }
+    std::string expected_shape;
+    EncodeTypeShape(type, &expected_shape);
+    if (shape != expected_shape) {
+      return zetasql_base::OutOfRangeErrorBuilder()
+             << "Encoded column " << name << " is not of type "
+             << type->DebugString();
+    }
+    result.column_names.emplace_back(name);
+  }
+  result.columns.resize(num_columns);
+  for (int i = 0; i < num_columns; ++i) {
+    ZETASQL_RETURN_IF_ERROR(
+        DecodeColumn(column_types[i], reader, &result.columns[i]));
+    if (i > 0 && result.columns[i].size() != result.columns[0].size()) {
+      return InvalidEncoding();
+    }
+  }
+  if (!encoded.empty()) return InvalidEncoding();
+  result.num_rows = num_columns == 0 ? 0 : result.columns[0].size();
+  return result;
+}
+
+}  // namespace zetasql
@@ -0,0 +1,82 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_VALUE_COLUMN_CODEC_H_
+#define ZETASQL_PUBLIC_VALUE_COLUMN_CODEC_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+namespace zetasql {
+
+// A compact binary encoding of many Values of the same type, for callers
+// that store or send whole columns or query results, where one ValueProto per
+// Value (see Value::Serialize()) is expensive to build and to parse.
+//
+// The type is not part of the encoding: as for Value::Deserialize(), the
+// decoder is given it. Values are laid out by column, with a bitmap of the
+// NULLs, the non-NULL BOOL, INT32, INT64, UINT32, UINT64, FLOAT, DOUBLE,
+// DATE, TIMESTAMP and ENUM values in fixed-width little-endian form, and
+// STRING and BYTES values with their length. The elements of ARRAYs and the
+// fields of STRUCTs are encoded as columns of their own. Values of other
+// types are encoded as ValueProtos. The order kind of arrays is not
+// preserved, as with ValueProtos.
+//
+// The encoding is stable across processes and releases.
+
+// Appends the encoding of 'values' to 'output'. All of 'values' must be valid
+// and have type 'type'.
+absl::Status EncodeValueColumn(const Type* type,
+                               absl::Span<const Value> values,
+                               std::string* output);
+
+// Decodes a column of Values of type 'type' that EncodeValueColumn() encoded
+// at the front of '*input', appends them to 'values', and removes the column
+// from '*input'. Returns an OutOfRange error if the encoding is invalid.
+absl::Status DecodeValueColumn(const Type* type, absl::string_view* input,
+                               std::vector<Value>* values);
+
+// The rows of a query result, by column, as decoded by DecodeTableResult().
+struct DecodedTableResult {
+  std::vector<std::string> column_names;
+  // One vector of 'num_rows' Values for each column.
+  std::vector<std::vector<Value>> columns;
+  int64_t num_rows = 0;
+};
+
+// Reads all the rows of 'iter' and returns their encoding, with the names and
+// the shape of the types of the columns stored once. Returns the error of
+// 'iter', if any.
+absl::StatusOr<std::string> EncodeTableResult(EvaluatorTableIterator* iter);
+
+// Decodes an encoding returned by EncodeTableResult() for columns of types
+// 'column_types'. Returns an OutOfRange error if the encoding is invalid or
+// is for columns of other kinds of types.
+absl::StatusOr<DecodedTableResult> DecodeTableResult(
+    absl::string_view encoded, absl::Span<const Type* const> column_types);
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_VALUE_COLUMN_CODEC_H_
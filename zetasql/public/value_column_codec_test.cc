@@ -0,0 +1,157 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/value_column_codec.h"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/numeric_value.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/types/type_factory.h"
+#include "zetasql/public/value.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+
+namespace zetasql {
+namespace {
+
+using ::testing::ElementsAre;
+using ::zetasql_base::testing::StatusIs;
+
+void ExpectRoundTrip(const Type* type, const std::vector<Value>& values) {
+  std::string encoded;
+  ZETASQL_ASSERT_OK(EncodeValueColumn(type, values, &encoded));
+  // Another column after this one must be left alone.
+  ZETASQL_ASSERT_OK(EncodeValueColumn(type, {Value::Null(type)}, &encoded));
+
+  absl::string_view input = encoded;
+  std::vector<Value> decoded;
+  ZETASQL_ASSERT_OK(DecodeValueColumn(type, &input, &decoded));
+  ASSERT_EQ(decoded.size(), values.size()) << type->DebugString();
+  for (int i = 0; i < values.size(); ++i) {
+    EXPECT_TRUE(decoded[i].type()->Equals(type));
+    EXPECT_EQ(decoded[i], values[i]) << values[i].FullDebugString();
+  }
+  decoded.clear();
+  ZETASQL_ASSERT_OK(DecodeValueColumn(type, &input, &decoded));
+  EXPECT_THAT(decoded, ElementsAre(Value::Null(type)));
+  EXPECT_TRUE(input.empty());
+}
+
+TEST(ValueColumnCodecTest, RoundTripsScalars) {
+  ExpectRoundTrip(types::Int64Type(),
+                  {Value::Int64(1), Value::NullInt64(), Value::Int64(-5),
+                   Value::Int64(std::numeric_limits<int64_t>::min())});
+  ExpectRoundTrip(types::Int32Type(), {Value::Int32(-3), Value::NullInt32()});
+  ExpectRoundTrip(types::Uint32Type(), {Value::Uint32(4000000000u)});
+  ExpectRoundTrip(types::Uint64Type(),
+                  {Value::Uint64(std::numeric_limits<uint64_t>::max())});
+  ExpectRoundTrip(types::BoolType(),
+                  {Value::Bool(true), Value::NullBool(), Value::Bool(false)});
+  ExpectRoundTrip(types::FloatType(), {Value::Float(1.5f)});
+  ExpectRoundTrip(types::DoubleType(),
+                  {Value::Double(-0.25), Value::NullDouble(),
+                   Value::Double(std::numeric_limits<double>::quiet_NaN())});
+  ExpectRoundTrip(types::StringType(),
+                  {Value::String(""), Value::String("abc"), Value::NullString()});
+  ExpectRoundTrip(types::BytesType(), {Value::Bytes(std::string("\0\1", 2))});
+  ExpectRoundTrip(types::DateType(), {Value::Date(-100), Value::Date(18000)});
+  ExpectRoundTrip(
+      types::TimestampType(),
+      {Value::Timestamp(absl::FromUnixNanos(-1)),
+       Value::Timestamp(absl::FromUnixSeconds(1600000000) +
+                        absl::Nanoseconds(123456789)),
+       Value::NullTimestamp()});
+  // Other types are encoded as ValueProtos.
+  ExpectRoundTrip(types::NumericType(),
+                  {Value::Numeric(NumericValue(12345)), Value::NullNumeric()});
+  ExpectRoundTrip(types::Int64Type(), {});
+}
+
+TEST(ValueColumnCodecTest, RoundTripsArraysAndStructs) {
+  TypeFactory type_factory;
+  const ArrayType* array_type;
+  ZETASQL_ASSERT_OK(type_factory.MakeArrayType(types::Int64Type(), &array_type));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      Value array, Value::MakeArray(array_type, {Value::Int64(1),
+                                                 Value::NullInt64(),
+                                                 Value::Int64(3)}));
+  ExpectRoundTrip(array_type, {array, Value::Null(array_type),
+                               Value::EmptyArray(array_type), array});
+
+  const StructType* struct_type;
+  ZETASQL_ASSERT_OK(type_factory.MakeStructType(
+      {{"a", array_type}, {"b", types::StringType()}}, &struct_type));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      Value first, Value::MakeStruct(struct_type, {array, Value::String("x")}));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      Value second, Value::MakeStruct(struct_type, {Value::Null(array_type),
+                                                    Value::NullString()}));
+  ExpectRoundTrip(struct_type, {first, Value::Null(struct_type), second});
+}
+
+TEST(ValueColumnCodecTest, RejectsInvalidEncodings) {
+  std::string encoded;
+  ZETASQL_ASSERT_OK(EncodeValueColumn(types::StringType(),
+                              {Value::String("abc")}, &encoded));
+  std::vector<Value> decoded;
+  absl::string_view truncated(encoded.data(), encoded.size() - 1);
+  EXPECT_THAT(DecodeValueColumn(types::StringType(), &truncated, &decoded),
+              StatusIs(absl::StatusCode::kOutOfRange));
+
+  EXPECT_FALSE(
+      EncodeValueColumn(types::Int64Type(), {Value::String("a")}, &encoded)
+          .ok());
+}
+
+TEST(ValueColumnCodecTest, RoundTripsTableResults) {
+  SimpleTable table("t", {{"a", types::Int64Type()},
+                          {"b", types::StringType()}});
+  table.SetContents({{Value::Int64(1), Value::String("x")},
+                     {Value::NullInt64(), Value::String("y")}});
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       table.CreateEvaluatorTableIterator({0, 1}));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::string encoded, EncodeTableResult(iter.get()));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      DecodedTableResult result,
+      DecodeTableResult(encoded, {types::Int64Type(), types::StringType()}));
+  EXPECT_THAT(result.column_names, ElementsAre("a", "b"));
+  EXPECT_EQ(result.num_rows, 2);
+  EXPECT_THAT(result.columns[0],
+              ElementsAre(Value::Int64(1), Value::NullInt64()));
+  EXPECT_THAT(result.columns[1],
+              ElementsAre(Value::String("x"), Value::String("y")));
+
+  EXPECT_THAT(
+      DecodeTableResult(encoded, {types::Int64Type(), types::BytesType()}),
+      StatusIs(absl::StatusCode::kOutOfRange));
+  EXPECT_THAT(DecodeTableResult(encoded, {types::Int64Type()}),
+              StatusIs(absl::StatusCode::kOutOfRange));
+}
+
+}  // namespace
+}  // namespace zetasql
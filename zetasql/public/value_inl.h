@@ -47,6 +47,7 @@
 #include "zetasql/public/types/value_representations.h"
 #include "zetasql/public/value.h"  
 #include "zetasql/public/value_content.h"
+#include "absl/base/call_once.h"
 #include "absl/container/btree_map.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/hash/hash.h"
@@ -64,14 +65,49 @@ class Value::TypedList : public internal::ValueContentContainer {
  public:
   explicit TypedList(std::vector<Value>&& values)
       : values_(std::move(values)) {}
+  // Creates a packed list of INT64 or DOUBLE elements, see MakePackedArray().
+  TypedList(std::vector<int64_t>&& packed_values, std::vector<bool>&& is_null)
+      : packed_kind_(TYPE_INT64),
+        packed_int64_values_(std::move(packed_values)),
+        packed_is_null_(std::move(is_null)) {}
+  TypedList(std::vector<double>&& packed_values, std::vector<bool>&& is_null)
+      : packed_kind_(TYPE_DOUBLE),
+        packed_double_values_(std::move(packed_values)),
+        packed_is_null_(std::move(is_null)) {}
   TypedList(const TypedList&) = delete;
   TypedList& operator=(const TypedList&) = delete;
   ~TypedList() override;
 
-  const std::vector<Value>& values() const { return values_; }
+  // For a packed list, the Values are only created on the first call.
+  const std::vector<Value>& values() const {
+    if (is_packed()) {
+      absl::call_once(materialize_once_, &TypedList::MaterializeValues, this);
+    }
+    return values_;
+  }
+
+  // Returns true if the elements are stored in 'packed_int64_values()' or
+  // 'packed_double_values()' rather than as Values.
+  bool is_packed() const { return packed_kind_ != TYPE_UNKNOWN; }
+  absl::Span<const int64_t> packed_int64_values() const {
+    return packed_int64_values_;
+  }
+  absl::Span<const double> packed_double_values() const {
+    return packed_double_values_;
+  }
+  bool packed_is_null(int64_t i) const {
+    return !packed_is_null_.empty() && packed_is_null_[i];
+  }
 
   uint64_t physical_byte_size() const override {
     uint64_t size = sizeof(TypedList);
+    if (is_packed()) {
+      // Also counts the Values that values() may create, without creating
+      // them. INT64 and DOUBLE Values have no other content.
+      return size + packed_int64_values_.size() * sizeof(int64_t) +
+             packed_double_values_.size() * sizeof(double) +
+             packed_is_null_.size() / 8 + num_elements() * sizeof(Value);
+    }
     for (const Value& value : values_) {
       size += value.physical_byte_size();
     }
@@ -79,16 +115,41 @@ class Value::TypedList : public internal::ValueContentContainer {
   }
 
   internal::ValueContentContainerElement element(int i) const override {
+    if (is_packed()) {
+      if (packed_is_null(i)) {
+        return internal::ValueContentContainerElement();
+      }
+      return internal::ValueContentContainerElement(
+          packed_kind_ == TYPE_INT64
+              ? ValueContent::Create(packed_int64_values_.at(i))
+              : ValueContent::Create(packed_double_values_.at(i)));
+    }
     if (values_.at(i).is_null()) {
       return internal::ValueContentContainerElement();
     }
     return internal::ValueContentContainerElement(values_.at(i).GetContent());
   }
 
-  int64_t num_elements() const override { return values_.size(); }
+  int64_t num_elements() const override {
+    if (is_packed()) {
+      return packed_kind_ == TYPE_INT64 ? packed_int64_values_.size()
+                                        : packed_double_values_.size();
+    }
+    return values_.size();
+  }
 
  private:
-  std::vector<Value> values_;
+  void MaterializeValues() const;
+
+  // TYPE_INT64 or TYPE_DOUBLE for a packed list.
+  const TypeKind packed_kind_ = TYPE_UNKNOWN;
+  const std::vector<int64_t> packed_int64_values_;
+  const std::vector<double> packed_double_values_;
+  // Empty if no element is NULL.
+  const std::vector<bool> packed_is_null_;
+
+  mutable absl::once_flag materialize_once_;
+  mutable std::vector<Value> values_;
 };
 
 struct ValueComparator {
@@ -240,7 +301,7 @@ inline Value::Value(double value)
 
 inline Value::Value(TypeKind type_kind, std::string value)
     : metadata_(type_kind),
-      string_ptr_(new internal::StringRef(std::move(value))) {
+      string_ptr_(internal::StringRef::Create(std::move(value))) {
   ABSL_CHECK(type_kind == TYPE_STRING ||
         type_kind == TYPE_BYTES);
 }
@@ -638,14 +699,16 @@ inline const tokens::TokenList& Value::tokenlist_value() const {
 }
 
 inline bool Value::empty() const {
-  return elements().empty();
+  return num_elements() == 0;
 }
 
 inline int Value::num_elements() const {
   if (type()->IsMap()) {
     return static_cast<int>(map_entries().size());
   }
-  return static_cast<int>(elements().size());
+  ABSL_CHECK_EQ(TYPE_ARRAY, metadata_.type_kind());
+  ABSL_CHECK(!is_null()) << "Null value";
+  return static_cast<int>(container_ptr_->value()->num_elements());
 }
 
 inline int Value::num_fields() const {
@@ -656,6 +719,29 @@ inline const Value& Value::field(int i) const {
   return fields()[i];
 }
 
+inline bool Value::has_packed_elements() const {
+  ABSL_CHECK_EQ(TYPE_ARRAY, metadata_.type_kind());
+  ABSL_CHECK(!is_null()) << "Null value";
+  return container_ptr_->value()->GetAs<TypedList>()->is_packed();
+}
+
+inline absl::Span<const int64_t> Value::packed_int64_elements() const {
+  ABSL_CHECK(has_packed_elements());
+  ABSL_CHECK_EQ(TYPE_INT64, type()->AsArray()->element_type()->kind());
+  return container_ptr_->value()->GetAs<TypedList>()->packed_int64_values();
+}
+
+inline absl::Span<const double> Value::packed_double_elements() const {
+  ABSL_CHECK(has_packed_elements());
+  ABSL_CHECK_EQ(TYPE_DOUBLE, type()->AsArray()->element_type()->kind());
+  return container_ptr_->value()->GetAs<TypedList>()->packed_double_values();
+}
+
+inline bool Value::packed_element_is_null(int i) const {
+  ABSL_DCHECK(has_packed_elements());
+  return container_ptr_->value()->GetAs<TypedList>()->packed_is_null(i);
+}
+
 inline const Value& Value::element(int i) const {
   ABSL_CHECK(type()->IsArray());
   return elements()[i];
@@ -521,6 +521,33 @@ TEST_F(ValueTest, StringNonNull) {
   EXPECT_EQ("foo", value_copy.string_value());
 }
 
+TEST_F(ValueTest, StringsInArena) {
+  zetasql_base::UnsafeArena arena(/*block_size=*/1024);
+  {
+    Value heap_value = Value::String("heap");
+    ScopedValueStringArena scope(&arena);
+    EXPECT_TRUE(arena.is_empty());
+    Value value = Value::String("foo");
+    Value long_value = Value::Bytes(std::string(100, 'x'));
+    EXPECT_FALSE(arena.is_empty());
+    {
+      zetasql_base::UnsafeArena inner_arena(/*block_size=*/1024);
+      ScopedValueStringArena inner_scope(&inner_arena);
+      EXPECT_EQ("bar", Value::String("bar").string_value());
+      EXPECT_FALSE(inner_arena.is_empty());
+    }
+    Value value_copy = value;
+    EXPECT_EQ("foo", value_copy.string_value());
+    EXPECT_EQ(std::string(100, 'x'), long_value.bytes_value());
+    EXPECT_EQ("heap", heap_value.string_value());
+  }
+  // All Values were destroyed, so the arena can be reset, and Values created
+  // outside of a scope do not use it.
+  arena.Reset();
+  EXPECT_EQ("baz", Value::String("baz").string_value());
+  EXPECT_TRUE(arena.is_empty());
+}
+
 void disguised_move(Value& o1, Value& o2) {  // NOLINT
   o1 = std::move(o2);
 }
@@ -1972,6 +1999,47 @@ TEST_F(ValueTest, InvalidArrayConstruction) {
 #endif
 }
 
+TEST_F(ValueTest, PackedArray) {
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      Value packed,
+      Value::MakePackedArray(Int64ArrayType(), std::vector<int64_t>{1, 0, 3},
+                             {false, true, false}));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      Value unpacked,
+      Value::MakeArray(Int64ArrayType(), {Int64(1), NullInt64(), Int64(3)}));
+  EXPECT_TRUE(packed.has_packed_elements());
+  EXPECT_FALSE(unpacked.has_packed_elements());
+  EXPECT_THAT(packed.packed_int64_elements(), ElementsAre(1, 0, 3));
+  EXPECT_FALSE(packed.packed_element_is_null(0));
+  EXPECT_TRUE(packed.packed_element_is_null(1));
+  EXPECT_EQ(3, packed.num_elements());
+  // Already counts the Values that elements() creates.
+  const uint64_t physical_byte_size = packed.physical_byte_size();
+  EXPECT_GT(physical_byte_size, 3 * sizeof(Value));
+
+  // Packed arrays are otherwise like any other array.
+  EXPECT_EQ(unpacked, packed);
+  EXPECT_EQ(absl::HashOf(unpacked), absl::HashOf(packed));
+  EXPECT_EQ(unpacked.DebugString(), packed.DebugString());
+  EXPECT_EQ(NullInt64(), packed.element(1));
+  EXPECT_EQ(unpacked.elements(), packed.elements());
+  EXPECT_EQ(physical_byte_size, packed.physical_byte_size());
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      packed, Value::MakePackedArray(DoubleArrayType(),
+                                     std::vector<double>{1.5, -2}));
+  EXPECT_THAT(packed.packed_double_elements(), ElementsAre(1.5, -2));
+  EXPECT_FALSE(packed.packed_element_is_null(1));
+  EXPECT_EQ(Double(-2), packed.element(1));
+
+  EXPECT_THAT(
+      Value::MakePackedArray(DoubleArrayType(), std::vector<int64_t>{1}),
+      StatusIs(absl::StatusCode::kInternal));
+  EXPECT_THAT(Value::MakePackedArray(Int64ArrayType(),
+                                     std::vector<int64_t>{1}, {false, true}),
+              StatusIs(absl::StatusCode::kInternal));
+}
+
 TEST_F(ValueTest, NumericArray) {
   Value v = TestGetSQL(values::Int64Array({1, 2}));
   EXPECT_EQ("Array[Int64(1), Int64(2)]", v.FullDebugString());
@@ -4548,6 +4616,50 @@ TEST_F(ValueTest, PhysicalByteSize) {
             Map({std::make_pair(map_string, map_int64)}).physical_byte_size());
 }
 
+TEST_F(ValueTest, ValueMemoryTrackerCountsSharedContentOnce) {
+  const Value str = Value::String(std::string(100, 'a'));
+  const Value str_copy = str;
+  const Value other_str = Value::String(std::string(100, 'a'));
+  const Value int64 = Value::Int64(1);
+
+  ValueMemoryTracker tracker;
+  EXPECT_EQ(str.physical_byte_size(), tracker.Add(str));
+  // A copy shares the content of 'str' and only adds its shallow size.
+  EXPECT_EQ(Value::shallow_physical_byte_size(), tracker.Add(str_copy));
+  // An equal Value with its own content is charged in full.
+  EXPECT_EQ(other_str.physical_byte_size(), tracker.Add(other_str));
+  EXPECT_EQ(int64.physical_byte_size(), tracker.Add(int64));
+  EXPECT_EQ(2, tracker.num_shared_buffers());
+  EXPECT_EQ(2 * str.physical_byte_size() + sizeof(Value) +
+                int64.physical_byte_size(),
+            tracker.byte_size());
+
+  // An array whose elements share content with each other and with 'str'.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      const Value shared_array,
+      Value::MakeArray(types::StringArrayType(), {str, str_copy, str}));
+  EXPECT_EQ(sizeof(Value) + sizeof(internal::ValueContentContainerRef) +
+                sizeof(Value::TypedList) + 3 * sizeof(Value),
+            tracker.Add(shared_array));
+  EXPECT_LT(tracker.byte_size(), 3 * str.physical_byte_size() +
+                                     shared_array.physical_byte_size());
+  // A second reference to the array does not visit its elements again.
+  EXPECT_EQ(sizeof(Value), tracker.Add(shared_array));
+
+  // Removing every Value releases exactly the bytes that were added, and the
+  // last reference to shared content releases it.
+  EXPECT_EQ(sizeof(Value), tracker.Remove(shared_array));
+  EXPECT_EQ(sizeof(Value) + sizeof(internal::ValueContentContainerRef) +
+                sizeof(Value::TypedList) + 3 * sizeof(Value),
+            tracker.Remove(shared_array));
+  EXPECT_EQ(sizeof(Value), tracker.Remove(str));
+  EXPECT_EQ(str.physical_byte_size(), tracker.Remove(str_copy));
+  EXPECT_EQ(other_str.physical_byte_size(), tracker.Remove(other_str));
+  EXPECT_EQ(int64.physical_byte_size(), tracker.Remove(int64));
+  EXPECT_EQ(0, tracker.byte_size());
+  EXPECT_EQ(0, tracker.num_shared_buffers());
+}
+
 // Roundtrips Value through ValueProto and back.
 static void SerializeDeserialize(const Value& value) {
   ValueProto value_proto;
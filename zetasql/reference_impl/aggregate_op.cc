@@ -16,7 +16,11 @@
 
 // This file contains the code for evaluating aggregate functions.
 
+#include <cmath>
 #include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <string>
@@ -24,6 +28,8 @@
 #include <utility>
 #include <vector>
 
+#include "zetasql/public/interval_value.h"
+#include "zetasql/public/numeric_value.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/value.h"
 #include "zetasql/reference_impl/common.h"
@@ -34,6 +40,8 @@
 #include "zetasql/reference_impl/tuple_comparator.h"
 #include "zetasql/reference_impl/variable_id.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
+#include "absl/algorithm/container.h"
+#include "absl/base/casts.h"
 #include "absl/cleanup/cleanup.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
@@ -49,6 +57,7 @@
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "zetasql/base/map_util.h"
+#include "zetasql/base/exactfloat.h"
 #include "zetasql/base/source_location.h"
 #include "zetasql/base/ret_check.h"
 #include "zetasql/base/status.h"
@@ -296,9 +305,13 @@ class OrderByAccumulator : public IntermediateAggregateAccumulator {
   bool Accumulate(const TupleData& input_row, const Value& value,
                   bool* stop_accumulation, absl::Status* status) override {
     *stop_accumulation = false;
-    auto input = std::make_unique<TupleData>(input_row);
-    input->AddSlots(1);
-    input->mutable_slot(input->num_slots() - 1)->SetValue(value);
+    // Allocate the extra slot for 'value' up front rather than growing a copy.
+    auto input = std::make_unique<TupleData>(input_row.num_slots() + 1,
+                                             context_->tuple_arena());
+    for (int i = 0; i < input_row.num_slots(); ++i) {
+      *input->mutable_slot(i) = input_row.slot(i);
+    }
+    input->mutable_slot(input_row.num_slots())->SetValue(value);
     return inputs_.PushBack(std::move(input), status);
   }
 
@@ -436,6 +449,65 @@ absl::StatusOr<Value> GetValueSortKey(const Value& value,
   return values::Bytes(sort_key);
 }
 
+// Computes the collation keys of a GROUP BY key or DISTINCT argument like
+// GetValueSortKey(), remembering those of the last distinct strings it has
+// seen. The same few strings usually make up the keys of many rows, and
+// looking them up is much cheaper than computing an ICU sort key again. The
+// keys of binary collations are the UTF-8 strings themselves, and are never
+// computed by ICU. Used by one thread at a time.
+class CollationKeyCache {
+ public:
+  // The cache is cleared when it exceeds this many strings.
+  static constexpr int kMaxEntries = 1024;
+
+  // 'collator' is not owned, and must outlive this object.
+  explicit CollationKeyCache(const ZetaSqlCollator* collator)
+      : collator_(*collator) {}
+
+  CollationKeyCache(const CollationKeyCache&) = delete;
+  CollationKeyCache& operator=(const CollationKeyCache&) = delete;
+
+  absl::StatusOr<Value> GetSortKey(const Value& value) {
+    ZETASQL_RET_CHECK(value.type()->IsString())
+        << "Cannot get sort key for value in non-String type: "
+        << value.type()->DebugString();
+    if (value.is_null()) {
+      return values::NullBytes();
+    }
+    if (collator_.IsBinaryComparison()) {
+      return values::Bytes(value.string_value());
+    }
+    auto it = sort_keys_.find(value.string_value());
+    if (it != sort_keys_.end()) {
+      return it->second;
+    }
+    ZETASQL_ASSIGN_OR_RETURN(Value sort_key, GetValueSortKey(value, collator_));
+    if (sort_keys_.size() >= kMaxEntries) {
+      sort_keys_.clear();
+    }
+    sort_keys_.emplace(value.string_value(), sort_key);
+    return sort_key;
+  }
+
+ private:
+  const ZetaSqlCollator& collator_;
+  absl::flat_hash_map<std::string, Value> sort_keys_;
+};
+
+// Returns a CollationKeyCache for each collator in 'collators', or NULL where
+// there is no collator.
+std::vector<std::unique_ptr<CollationKeyCache>> MakeCollationKeyCaches(
+    const CollatorList& collators) {
+  std::vector<std::unique_ptr<CollationKeyCache>> caches;
+  caches.reserve(collators.size());
+  for (const std::unique_ptr<const ZetaSqlCollator>& collator : collators) {
+    caches.push_back(collator == nullptr
+                         ? nullptr
+                         : std::make_unique<CollationKeyCache>(collator.get()));
+  }
+  return caches;
+}
+
 bool IsGroupingFunction(const AggregateFunctionCallExpr* func_expr) {
   ABSL_DCHECK(func_expr != nullptr);
   const BuiltinAggregateFunction* builtin_func =
@@ -467,7 +539,11 @@ class DistinctAccumulator : public IntermediateAggregateAccumulator {
       std::unique_ptr<const ZetaSqlCollator> collator)
       : distinct_values_(context->memory_accountant()),
         accumulator_(std::move(accumulator)),
-        collator_(std::move(collator)) {}
+        collator_(std::move(collator)),
+        sort_keys_(collator_ == nullptr
+                       ? nullptr
+                       : std::make_unique<CollationKeyCache>(collator_.get())) {
+  }
 
   absl::Status Reset() override {
     distinct_values_.Clear();
@@ -484,11 +560,11 @@ class DistinctAccumulator : public IntermediateAggregateAccumulator {
     bool distinct;
 
     Value value_to_insert;
-    if (collator_ == nullptr) {
+    if (sort_keys_ == nullptr) {
       value_to_insert = value;
     } else {
       absl::StatusOr<Value> collated_distinct_key =
-          GetValueSortKey(value, *(collator_));
+          sort_keys_->GetSortKey(value);
       if (!collated_distinct_key.ok()) {
         *status = collated_distinct_key.status();
         return false;
@@ -517,6 +593,7 @@ class DistinctAccumulator : public IntermediateAggregateAccumulator {
   ValueHashSet distinct_values_;
   std::unique_ptr<IntermediateAggregateAccumulator> accumulator_;
   const std::unique_ptr<const ZetaSqlCollator> collator_;
+  const std::unique_ptr<CollationKeyCache> sort_keys_;
 };
 
 // Accumulator that discards NULL values.
@@ -796,7 +873,8 @@ class WithGroupRowsAccumulator : public IntermediateAggregateAccumulator {
                   bool* stop_accumulation, absl::Status* status) override {
     *stop_accumulation = false;
 
-    auto input = std::make_unique<TupleData>(input_row);
+    auto input =
+        std::make_unique<TupleData>(input_row, context_->tuple_arena());
     return inputs_.PushBack(std::move(input), status);
   }
 
@@ -1180,6 +1258,465 @@ absl::StatusOr<Value> AggregateArg::EvalAgg(
   return status_or_result.value();
 }
 
+namespace {
+
+// Base class of the SlidingWindowAccumulators. Evaluates the argument of the
+// aggregate on each row entering the window and keeps the values of the rows
+// in the window, so that subclasses can undo their contribution when they
+// leave it.
+class SlidingWindowAccumulatorBase : public SlidingWindowAccumulator {
+ public:
+  // 'input_field' is NULL for COUNT(*).
+  SlidingWindowAccumulatorBase(absl::Span<const TupleData* const> params,
+                               const ValueExpr* input_field,
+                               const Type* output_type,
+                               ResolvedFunctionCallBase::ErrorMode error_mode,
+                               EvaluationContext* context)
+      : params_and_input_row_(ConcatSpans(
+            params, absl::Span<const TupleData* const>({nullptr}))),
+        input_field_(input_field),
+        output_type_(output_type),
+        error_mode_(error_mode),
+        context_(context) {}
+
+  SlidingWindowAccumulatorBase(const SlidingWindowAccumulatorBase&) = delete;
+  SlidingWindowAccumulatorBase& operator=(
+      const SlidingWindowAccumulatorBase&) = delete;
+
+  bool Add(const TupleData& input_row, absl::Status* status) final {
+    // COUNT(*) counts every row, as if its argument were a non-NULL value.
+    Value value = Bool(true);
+    if (input_field_ != nullptr) {
+      params_and_input_row_.back() = &input_row;
+      std::shared_ptr<TupleSlot::SharedProtoState> shared_state;
+      VirtualTupleSlot slot(&value, &shared_state);
+      if (!input_field_->Eval(params_and_input_row_, context_, &slot,
+                              status)) {
+        return false;
+      }
+    }
+    AddValue(value);
+    window_.push_back(std::move(value));
+    return true;
+  }
+
+  void RemoveFront() final {
+    ABSL_DCHECK(!window_.empty());
+    RemoveFrontValue(window_.front());
+    window_.pop_front();
+    ++num_removed_;
+  }
+
+  void Reset() final {
+    num_removed_ += window_.size();
+    window_.clear();
+    ResetState();
+  }
+
+  absl::StatusOr<Value> GetResult() final {
+    absl::StatusOr<Value> result = GetResultInternal();
+    if (!result.ok() && ShouldSuppressError(result.status(), error_mode_)) {
+      return Value::Null(output_type_);
+    }
+    return result;
+  }
+
+ protected:
+  // Adds 'value' to the state. 'value' is about to become the last value of
+  // the window.
+  virtual void AddValue(const Value& value) = 0;
+  // Removes 'value', the first value of the window, from the state.
+  virtual void RemoveFrontValue(const Value& value) = 0;
+  virtual void ResetState() = 0;
+  virtual absl::StatusOr<Value> GetResultInternal() = 0;
+
+  const Type* output_type() const { return output_type_; }
+
+  // Rows are numbered in the order they were added. Returns the number of the
+  // first row of the window, and of the next row to be added.
+  int64_t begin_position() const { return num_removed_; }
+  int64_t end_position() const {
+    return num_removed_ + static_cast<int64_t>(window_.size());
+  }
+  // Returns the value of row 'position', which must be in the window.
+  const Value& value_at(int64_t position) const {
+    return window_[position - num_removed_];
+  }
+
+ private:
+  std::vector<const TupleData*> params_and_input_row_;
+  const ValueExpr* input_field_;
+  const Type* output_type_;
+  const ResolvedFunctionCallBase::ErrorMode error_mode_;
+  EvaluationContext* context_;
+  std::deque<Value> window_;
+  int64_t num_removed_ = 0;
+};
+
+// COUNT(*), COUNT and COUNTIF.
+class CountSlidingWindowAccumulator final
+    : public SlidingWindowAccumulatorBase {
+ public:
+  CountSlidingWindowAccumulator(absl::Span<const TupleData* const> params,
+                                const ValueExpr* input_field, bool is_countif,
+                                const Type* output_type,
+                                ResolvedFunctionCallBase::ErrorMode error_mode,
+                                EvaluationContext* context)
+      : SlidingWindowAccumulatorBase(params, input_field, output_type,
+                                     error_mode, context),
+        is_countif_(is_countif) {}
+
+ private:
+  bool IsCounted(const Value& value) const {
+    return !value.is_null() && (!is_countif_ || value.bool_value());
+  }
+
+  void AddValue(const Value& value) override {
+    if (IsCounted(value)) ++count_;
+  }
+  void RemoveFrontValue(const Value& value) override {
+    if (IsCounted(value)) --count_;
+  }
+  void ResetState() override { count_ = 0; }
+  absl::StatusOr<Value> GetResultInternal() override {
+    return Value::Int64(count_);
+  }
+
+  const bool is_countif_;
+  int64_t count_ = 0;
+};
+
+// SUM over INT64 or UINT64. Like the regular accumulator, sums in 128 bits
+// and only reports an overflow if the sum of the window does not fit.
+template <typename T, typename SumT>
+class IntegerSumSlidingWindowAccumulator final
+    : public SlidingWindowAccumulatorBase {
+ public:
+  using SlidingWindowAccumulatorBase::SlidingWindowAccumulatorBase;
+
+ private:
+  void AddValue(const Value& value) override {
+    if (value.is_null()) return;
+    sum_ += value.Get<T>();
+    ++count_;
+  }
+  void RemoveFrontValue(const Value& value) override {
+    if (value.is_null()) return;
+    sum_ -= value.Get<T>();
+    --count_;
+  }
+  void ResetState() override {
+    sum_ = 0;
+    count_ = 0;
+  }
+  absl::StatusOr<Value> GetResultInternal() override {
+    if (count_ == 0) return Value::Null(output_type());
+    if (sum_ > std::numeric_limits<T>::max() ||
+        sum_ < std::numeric_limits<T>::min()) {
+      return ::zetasql_base::OutOfRangeErrorBuilder()
+             << (std::is_signed_v<T> ? "int64 overflow" : "uint64 overflow");
+    }
+    return Value::Make<T>(static_cast<T>(sum_));
+  }
+
+  SumT sum_ = 0;
+  int64_t count_ = 0;
+};
+
+// SUM over DOUBLE. The sum of the finite values is exact, so removing a value
+// restores the previous sum exactly. Non-finite values are counted instead,
+// since they cannot be subtracted back out.
+class DoubleSumSlidingWindowAccumulator final
+    : public SlidingWindowAccumulatorBase {
+ public:
+  using SlidingWindowAccumulatorBase::SlidingWindowAccumulatorBase;
+
+ private:
+  void AddValue(const Value& value) override { Update(value, +1); }
+  void RemoveFrontValue(const Value& value) override { Update(value, -1); }
+
+  void Update(const Value& value, int delta) {
+    if (value.is_null()) return;
+    count_ += delta;
+    const double d = value.double_value();
+    if (std::isnan(d)) {
+      num_nans_ += delta;
+    } else if (std::isinf(d)) {
+      (d > 0 ? num_positive_infinities_ : num_negative_infinities_) += delta;
+    } else if (delta > 0) {
+      finite_sum_ = finite_sum_ + d;
+    } else {
+      finite_sum_ = finite_sum_ - d;
+    }
+  }
+
+  void ResetState() override {
+    finite_sum_ = 0;
+    count_ = 0;
+    num_nans_ = 0;
+    num_positive_infinities_ = 0;
+    num_negative_infinities_ = 0;
+  }
+
+  absl::StatusOr<Value> GetResultInternal() override {
+    if (count_ == 0) return Value::NullDouble();
+    if (num_nans_ > 0 ||
+        (num_positive_infinities_ > 0 && num_negative_infinities_ > 0)) {
+      return Value::Double(std::numeric_limits<double>::quiet_NaN());
+    }
+    if (num_positive_infinities_ > 0) {
+      return Value::Double(std::numeric_limits<double>::infinity());
+    }
+    if (num_negative_infinities_ > 0) {
+      return Value::Double(-std::numeric_limits<double>::infinity());
+    }
+    if (finite_sum_ > std::numeric_limits<double>::max() ||
+        finite_sum_ < -std::numeric_limits<double>::max()) {
+      return ::zetasql_base::OutOfRangeErrorBuilder() << "double overflow";
+    }
+    return Value::Double(finite_sum_.ToDouble());
+  }
+
+  zetasql_base::ExactFloat finite_sum_ = 0;
+  int64_t count_ = 0;
+  int64_t num_nans_ = 0;
+  int64_t num_positive_infinities_ = 0;
+  int64_t num_negative_infinities_ = 0;
+};
+
+// SUM or AVG over NUMERIC or BIGNUMERIC, and SUM over INTERVAL, whose
+// SumAggregators support subtraction.
+template <typename T>
+class ExactSumSlidingWindowAccumulator final
+    : public SlidingWindowAccumulatorBase {
+ public:
+  ExactSumSlidingWindowAccumulator(
+      absl::Span<const TupleData* const> params, const ValueExpr* input_field,
+      bool is_avg, const Type* output_type,
+      ResolvedFunctionCallBase::ErrorMode error_mode,
+      EvaluationContext* context)
+      : SlidingWindowAccumulatorBase(params, input_field, output_type,
+                                     error_mode, context),
+        is_avg_(is_avg) {}
+
+ private:
+  void AddValue(const Value& value) override {
+    if (value.is_null()) return;
+    aggregator_.Add(value.Get<T>());
+    ++count_;
+  }
+  void RemoveFrontValue(const Value& value) override {
+    if (value.is_null()) return;
+    aggregator_.Subtract(value.Get<T>());
+    --count_;
+  }
+  void ResetState() override {
+    aggregator_ = typename T::SumAggregator();
+    count_ = 0;
+  }
+  absl::StatusOr<Value> GetResultInternal() override {
+    if (count_ == 0) return Value::Null(output_type());
+    if constexpr (!std::is_same_v<T, IntervalValue>) {
+      if (is_avg_) {
+        ZETASQL_ASSIGN_OR_RETURN(T average, aggregator_.GetAverage(count_));
+        return Value::Make<T>(average);
+      }
+    }
+    ZETASQL_ASSIGN_OR_RETURN(T sum, aggregator_.GetSum());
+    return Value::Make<T>(sum);
+  }
+
+  const bool is_avg_;
+  typename T::SumAggregator aggregator_;
+  int64_t count_ = 0;
+};
+
+// MIN or MAX, using a monotonic deque of the positions of the rows that may
+// still become the extremum of the window: each one holds a value strictly
+// better than all values added after it, so the front is the extremum.
+class MinMaxSlidingWindowAccumulator final
+    : public SlidingWindowAccumulatorBase {
+ public:
+  MinMaxSlidingWindowAccumulator(absl::Span<const TupleData* const> params,
+                                 const ValueExpr* input_field, bool is_max,
+                                 const Type* output_type,
+                                 ResolvedFunctionCallBase::ErrorMode error_mode,
+                                 EvaluationContext* context)
+      : SlidingWindowAccumulatorBase(params, input_field, output_type,
+                                     error_mode, context),
+        is_max_(is_max) {}
+
+ private:
+  // Returns true if 'x' is a strictly better extremum than 'y'.
+  bool IsBetter(const Value& x, const Value& y) const {
+    return is_max_ ? y.LessThan(x) : x.LessThan(y);
+  }
+
+  void AddValue(const Value& value) override {
+    if (value.is_null()) return;
+    while (!candidates_.empty() &&
+           !IsBetter(value_at(candidates_.back()), value)) {
+      candidates_.pop_back();
+    }
+    candidates_.push_back(end_position());
+  }
+  void RemoveFrontValue(const Value& value) override {
+    if (!candidates_.empty() && candidates_.front() == begin_position()) {
+      candidates_.pop_front();
+    }
+  }
+  void ResetState() override { candidates_.clear(); }
+  absl::StatusOr<Value> GetResultInternal() override {
+    if (candidates_.empty()) return Value::Null(output_type());
+    return value_at(candidates_.front());
+  }
+
+  const bool is_max_;
+  std::deque<int64_t> candidates_;
+};
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<SlidingWindowAccumulator>>
+AggregateArg::CreateSlidingWindowAccumulator(
+    absl::Span<const TupleData* const> params,
+    EvaluationContext* context) const {
+  const auto* function = dynamic_cast<const BuiltinAggregateFunction*>(
+      aggregate_function()->function());
+  if (function == nullptr || distinct() || having_expr() != nullptr ||
+      !order_by_keys().empty() || limit() != nullptr ||
+      group_rows_subquery_ != nullptr || filter() != nullptr ||
+      !collation_list().empty() || parameter_list_size() != 0 ||
+      num_input_fields() > 1) {
+    return nullptr;
+  }
+  const ValueExpr* input = num_input_fields() == 0 ? nullptr : input_field(0);
+  const Type* output_type = aggregate_function()->output_type();
+  if (function->kind() == FunctionKind::kCount) {
+    return std::make_unique<CountSlidingWindowAccumulator>(
+        params, input, /*is_countif=*/false, output_type, error_mode_,
+        context);
+  }
+  if (input == nullptr) return nullptr;
+  const TypeKind input_type_kind = input_type()->kind();
+  switch (function->kind()) {
+    case FunctionKind::kCountIf:
+      return std::make_unique<CountSlidingWindowAccumulator>(
+          params, input, /*is_countif=*/true, output_type, error_mode_,
+          context);
+    case FunctionKind::kSum:
+    case FunctionKind::kAvg: {
+      const bool is_avg = function->kind() == FunctionKind::kAvg;
+      switch (input_type_kind) {
+        case TYPE_INT64:
+          if (is_avg) break;
+          return std::make_unique<
+              IntegerSumSlidingWindowAccumulator<int64_t, __int128>>(
+              params, input, output_type, error_mode_, context);
+        case TYPE_UINT64:
+          if (is_avg) break;
+          return std::make_unique<
+              IntegerSumSlidingWindowAccumulator<uint64_t, unsigned __int128>>(
+              params, input, output_type, error_mode_, context);
+        case TYPE_DOUBLE:
+          if (is_avg) break;
+          return std::make_unique<DoubleSumSlidingWindowAccumulator>(
+              params, input, output_type, error_mode_, context);
+        case TYPE_NUMERIC:
+          return std::make_unique<
+              ExactSumSlidingWindowAccumulator<NumericValue>>(
+              params, input, is_avg, output_type, error_mode_, context);
+        case TYPE_BIGNUMERIC:
+          return std::make_unique<
+              ExactSumSlidingWindowAccumulator<BigNumericValue>>(
+              params, input, is_avg, output_type, error_mode_, context);
+        case TYPE_INTERVAL:
+          if (is_avg) break;
+          return std::make_unique<
+              ExactSumSlidingWindowAccumulator<IntervalValue>>(
+              params, input, /*is_avg=*/false, output_type, error_mode_,
+              context);
+        default:
+          break;
+      }
+      // AVG over INT64, UINT64 and DOUBLE keeps a running mean in long
+      // double whose rounding depends on the whole sequence of inputs, so it
+      // cannot be undone exactly. AVG over INTERVAL rounds depending on the
+      // timestamp scale.
+      return nullptr;
+    }
+    case FunctionKind::kMin:
+    case FunctionKind::kMax:
+      switch (input_type_kind) {
+        // The regular accumulator compares these types the same way as
+        // Value::LessThan() does.
+        case TYPE_INT32:
+        case TYPE_INT64:
+        case TYPE_UINT32:
+        case TYPE_UINT64:
+        case TYPE_BOOL:
+        case TYPE_DATE:
+        case TYPE_DATETIME:
+        case TYPE_NUMERIC:
+        case TYPE_BIGNUMERIC:
+        case TYPE_STRING:
+        case TYPE_BYTES:
+          return std::make_unique<MinMaxSlidingWindowAccumulator>(
+              params, input, function->kind() == FunctionKind::kMax,
+              output_type, error_mode_, context);
+        default:
+          return nullptr;
+      }
+    default:
+      return nullptr;
+  }
+}
+
+absl::StatusOr<std::unique_ptr<AggregateArg>>
+AggregateArg::CreateFinalAggregate(const VariableId& partial_variable) const {
+  const auto* function = dynamic_cast<const BuiltinAggregateFunction*>(
+      aggregate_function()->function());
+  if (function == nullptr || distinct() || having_expr() != nullptr ||
+      !order_by_keys().empty() || limit() != nullptr ||
+      group_rows_subquery_ != nullptr || !collation_list().empty() ||
+      parameter_list_size() != 0 ||
+      error_mode_ != ResolvedFunctionCallBase::DEFAULT_ERROR_MODE) {
+    return nullptr;
+  }
+  FunctionKind final_kind;
+  switch (function->kind()) {
+    case FunctionKind::kCount:
+    case FunctionKind::kCountIf:
+      // The partial counts are never NULL.
+      final_kind = FunctionKind::kSum;
+      break;
+    case FunctionKind::kSum:
+    case FunctionKind::kMin:
+    case FunctionKind::kMax:
+    case FunctionKind::kAnyValue:
+    case FunctionKind::kLogicalAnd:
+    case FunctionKind::kLogicalOr:
+    case FunctionKind::kBitAnd:
+    case FunctionKind::kBitOr:
+    case FunctionKind::kBitXor:
+      // A part without rows produces NULL, which the final aggregate ignores.
+      final_kind = function->kind();
+      break;
+    default:
+      return nullptr;
+  }
+  const Type* partial_type = aggregate_function()->output_type();
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<DerefExpr> partial,
+                   DerefExpr::Create(partial_variable, partial_type));
+  std::vector<std::unique_ptr<ValueExpr>> arguments;
+  arguments.push_back(std::move(partial));
+  return AggregateArg::Create(
+      variable(),
+      std::make_unique<BuiltinAggregateFunction>(
+          final_kind, partial_type, /*num_input_fields=*/1, partial_type),
+      std::move(arguments));
+}
+
 std::string AggregateArg::DebugInternal(const std::string& indent,
                                         bool verbose) const {
   std::string result;
@@ -1336,6 +1873,59 @@ absl::StatusOr<std::unique_ptr<AggregateOp>> AggregateOp::Create(
                       std::move(grouping_sets)));
 }
 
+absl::Status AggregateOp::SetPivot(
+    const VariableId& pivot_variable,
+    std::vector<std::unique_ptr<ValueExpr>> pivot_values,
+    std::vector<int> pivot_value_indexes) {
+  ZETASQL_RET_CHECK(grouping_sets_.empty());
+  ZETASQL_RET_CHECK_EQ(pivot_value_indexes.size(), aggregators().size());
+  for (const std::unique_ptr<ValueExpr>& pivot_value : pivot_values) {
+    ZETASQL_RET_CHECK(SupportsPivotDispatch(pivot_value->output_type()))
+        << pivot_value->output_type()->DebugString();
+  }
+  for (const int index : pivot_value_indexes) {
+    ZETASQL_RET_CHECK_GE(index, 0);
+    ZETASQL_RET_CHECK_LT(index, pivot_values.size());
+  }
+  pivot_ = std::make_unique<Pivot>();
+  pivot_->variable = pivot_variable;
+  pivot_->values = std::move(pivot_values);
+  pivot_->value_indexes = std::move(pivot_value_indexes);
+  return absl::OkStatus();
+}
+
+bool AggregateOp::SupportsPivotDispatch(const Type* type) {
+  switch (type->kind()) {
+    case TYPE_INT32:
+    case TYPE_INT64:
+    case TYPE_UINT32:
+    case TYPE_UINT64:
+    case TYPE_BOOL:
+    case TYPE_STRING:
+    case TYPE_BYTES:
+    case TYPE_DATE:
+    case TYPE_TIMESTAMP:
+    case TYPE_DATETIME:
+    case TYPE_TIME:
+    case TYPE_NUMERIC:
+    case TYPE_BIGNUMERIC:
+    case TYPE_ENUM:
+      return true;
+    default:
+      // Floating point values have several representations of equal values,
+      // and so do the values of many other types.
+      return false;
+  }
+}
+
+bool AggregateOp::UsesStreamingPath() const {
+  return input_is_grouped_by_keys_ && !keys().empty() &&
+         grouping_sets_.empty() && pivot_ == nullptr &&
+         absl::c_none_of(aggregators(), [](const AggregateArg* aggregator) {
+           return IsGroupingFunction(aggregator->aggregate_function());
+         });
+}
+
 absl::Status AggregateOp::SetSchemasForEvaluation(
     absl::Span<const TupleSchema* const> params_schemas) {
   ZETASQL_RETURN_IF_ERROR(mutable_input()->SetSchemasForEvaluation(params_schemas));
@@ -1353,6 +1943,61 @@ absl::Status AggregateOp::SetSchemasForEvaluation(
         arg->SetSchemasForEvaluation(*input_schema, params_schemas));
   }
 
+  if (pivot_ != nullptr) {
+    for (const std::unique_ptr<ValueExpr>& pivot_value : pivot_->values) {
+      ZETASQL_RETURN_IF_ERROR(pivot_value->SetSchemasForEvaluation(params_schemas));
+    }
+    const std::optional<int> slot =
+        input_schema->FindIndexForVariable(pivot_->variable);
+    ZETASQL_RET_CHECK(slot.has_value()) << pivot_->variable;
+    pivot_->slot = slot.value();
+  }
+
+  // Coarser grouping sets are derived from the finest one if it is among the
+  // grouping sets, so that aggregating the finest groups does not fail (e.g.,
+  // on overflow) where the grouping sets themselves would not. Collated keys
+  // that compare equal may have different values in different finest groups.
+  derives_grouping_sets_ = false;
+  rollup_aggregators_.clear();
+  finest_grouping_set_ = 0;
+  for (const int64_t grouping_set : grouping_sets_) {
+    finest_grouping_set_ |= grouping_set;
+  }
+  if (grouping_sets_.size() < 2 ||
+      !absl::c_linear_search(grouping_sets_, finest_grouping_set_) ||
+      absl::c_any_of(keys(), [](const KeyArg* key) {
+        return key->collation() != nullptr;
+      })) {
+    return absl::OkStatus();
+  }
+  // The schema of the finest groups, as returned by the aggregation of the
+  // input before the grouping set offset is removed.
+  std::vector<VariableId> finest_group_variables;
+  for (const KeyArg* key : keys()) {
+    finest_group_variables.push_back(key->variable());
+  }
+  finest_group_variables.push_back(VariableId("grouping_set_offset"));
+  for (const AggregateArg* aggregator : aggregators()) {
+    finest_group_variables.push_back(aggregator->variable());
+  }
+  const TupleSchema finest_group_schema(finest_group_variables);
+  std::vector<std::unique_ptr<AggregateArg>> rollup_aggregators;
+  for (const AggregateArg* aggregator : aggregators()) {
+    if (IsGroupingFunction(aggregator->aggregate_function())) {
+      rollup_aggregators.push_back(nullptr);
+      continue;
+    }
+    // Summing partial sums of floating point values changes the result.
+    if (aggregator->type()->IsFloatingPoint()) return absl::OkStatus();
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<AggregateArg> rollup_aggregator,
+                     aggregator->CreateFinalAggregate(aggregator->variable()));
+    if (rollup_aggregator == nullptr) return absl::OkStatus();
+    ZETASQL_RETURN_IF_ERROR(rollup_aggregator->SetSchemasForEvaluation(
+        finest_group_schema, params_schemas));
+    rollup_aggregators.push_back(std::move(rollup_aggregator));
+  }
+  derives_grouping_sets_ = true;
+  rollup_aggregators_ = std::move(rollup_aggregators);
   return absl::OkStatus();
 }
 
@@ -1463,18 +2108,351 @@ class GroupValue {
   AccumulatorList accumulator_list_;
 };
 
+// Maps the grouping keys of a hash aggregation to their GroupValues. The keys
+// are the TupleDatas passed to Insert(), which must outlive the map.
+//
+// A single key of a fixed-width integer type is the common case for GROUP BY
+// with many groups. It is looked up by its 64 bits in a map of integers, which
+// stores them inline next to their hash bits, so a lookup neither hashes nor
+// compares a TupleData, and NULL has its own group. Other keys use a map keyed
+// by the TupleData.
+class GroupMap {
+ public:
+  using Allocator = TupleArenaAllocator<
+      std::pair<const TupleDataPtr, std::unique_ptr<GroupValue>>>;
+  using PackedAllocator = TupleArenaAllocator<
+      std::pair<const int64_t, std::unique_ptr<GroupValue>>>;
+
+  // 'key_types' are the types of the slots of the keys. If 'arena' is
+  // non-NULL, the maps are allocated from it (see TupleArenaAllocator).
+  GroupMap(std::vector<const Type*> key_types, zetasql_base::UnsafeArena* arena)
+      : packed_(key_types.size() == 1 && IsPackable(key_types[0]->kind())),
+        tuple_map_(/*bucket_count=*/0, TupleKeyHash(key_types),
+                   TupleKeyEq(key_types), Allocator(arena)),
+        packed_map_(PackedAllocator(arena)) {}
+
+  GroupMap(const GroupMap&) = delete;
+  GroupMap& operator=(const GroupMap&) = delete;
+
+  // Returns the GroupValue for 'key', or NULL if there is none.
+  absl::StatusOr<std::unique_ptr<GroupValue>*> Find(const TupleData& key) {
+    if (!packed_) {
+      return zetasql_base::FindOrNull(tuple_map_, TupleDataPtr(&key));
+    }
+    const Value& value = key.slot(0).value();
+    if (value.is_null()) {
+      return null_group_ == nullptr ? nullptr : &null_group_;
+    }
+    ZETASQL_ASSIGN_OR_RETURN(const int64_t packed_key, Pack(value));
+    return zetasql_base::FindOrNull(packed_map_, packed_key);
+  }
+
+  // Adds 'key', which must not be in the map yet.
+  absl::Status Insert(const TupleData* key, std::unique_ptr<GroupValue> value) {
+    if (!packed_) {
+      ZETASQL_RET_CHECK(
+          tuple_map_.emplace(TupleDataPtr(key), std::move(value)).second);
+      return absl::OkStatus();
+    }
+    const Value& key_value = key->slot(0).value();
+    if (key_value.is_null()) {
+      ZETASQL_RET_CHECK(null_group_ == nullptr);
+      null_group_ = std::move(value);
+      return absl::OkStatus();
+    }
+    ZETASQL_ASSIGN_OR_RETURN(const int64_t packed_key, Pack(key_value));
+    ZETASQL_RET_CHECK(packed_map_.emplace(packed_key, std::move(value)).second);
+    return absl::OkStatus();
+  }
+
+  bool empty() const {
+    return tuple_map_.empty() && packed_map_.empty() && null_group_ == nullptr;
+  }
+
+  // Calls 'fn(group_value)' for each group, in no particular order.
+  template <typename Fn>
+  absl::Status ForEach(Fn fn) {
+    for (auto& [key, group_value] : tuple_map_) {
+      ZETASQL_RETURN_IF_ERROR(fn(group_value));
+    }
+    for (auto& [key, group_value] : packed_map_) {
+      ZETASQL_RETURN_IF_ERROR(fn(group_value));
+    }
+    if (null_group_ != nullptr) {
+      ZETASQL_RETURN_IF_ERROR(fn(null_group_));
+    }
+    return absl::OkStatus();
+  }
+
+  void clear() {
+    tuple_map_.clear();
+    packed_map_.clear();
+    null_group_.reset();
+  }
+
+ private:
+  // Returns true if the non-NULL Values of 'kind' are equal if and only if
+  // Pack() returns the same integer for them.
+  static bool IsPackable(TypeKind kind) {
+    switch (kind) {
+      case TYPE_INT32:
+      case TYPE_INT64:
+      case TYPE_UINT32:
+      case TYPE_UINT64:
+      case TYPE_BOOL:
+      case TYPE_DATE:
+      case TYPE_ENUM:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  static absl::StatusOr<int64_t> Pack(const Value& value) {
+    switch (value.type_kind()) {
+      case TYPE_INT32:
+        return value.int32_value();
+      case TYPE_INT64:
+        return value.int64_value();
+      case TYPE_UINT32:
+        return value.uint32_value();
+      case TYPE_UINT64:
+        return absl::bit_cast<int64_t>(value.uint64_value());
+      case TYPE_BOOL:
+        return value.bool_value() ? 1 : 0;
+      case TYPE_DATE:
+        return value.date_value();
+      case TYPE_ENUM:
+        return value.enum_value();
+      default:
+        ZETASQL_RET_CHECK_FAIL() << "Unexpected packed key type: "
+                         << value.type()->DebugString();
+    }
+  }
+
+  const bool packed_;
+  // Used unless 'packed_'.
+  absl::flat_hash_map<TupleDataPtr, std::unique_ptr<GroupValue>, TupleKeyHash,
+                      TupleKeyEq, Allocator>
+      tuple_map_;
+  // Used if 'packed_', for the non-NULL keys and the NULL key respectively.
+  absl::flat_hash_map<int64_t, std::unique_ptr<GroupValue>,
+                      absl::Hash<int64_t>, std::equal_to<int64_t>,
+                      PackedAllocator>
+      packed_map_;
+  std::unique_ptr<GroupValue> null_group_;
+};
+
+// Aggregates an input in which rows with equal keys are adjacent. Each group
+// is returned as soon as the first row of the next group (or the end of the
+// input) is seen, so only the accumulators of one group are live at a time.
+class StreamingAggregateTupleIterator : public TupleIterator {
+ public:
+  StreamingAggregateTupleIterator(
+      absl::Span<const TupleData* const> params,
+      absl::Span<const KeyArg* const> keys,
+      absl::Span<const AggregateArg* const> aggregators,
+      CollatorList collators, int num_extra_slots,
+      std::unique_ptr<TupleIterator> input_iter,
+      std::unique_ptr<TupleSchema> output_schema, EvaluationContext* context)
+      : params_(params.begin(), params.end()),
+        keys_(keys.begin(), keys.end()),
+        aggregators_(aggregators.begin(), aggregators.end()),
+        collators_(std::move(collators)),
+        sort_keys_(MakeCollationKeyCaches(collators_)),
+        num_extra_slots_(num_extra_slots),
+        input_iter_(std::move(input_iter)),
+        output_schema_(std::move(output_schema)),
+        context_(context) {}
+
+  StreamingAggregateTupleIterator(const StreamingAggregateTupleIterator&) =
+      delete;
+  StreamingAggregateTupleIterator& operator=(
+      const StreamingAggregateTupleIterator&) = delete;
+
+  const TupleSchema& Schema() const override { return *output_schema_; }
+
+  TupleData* Next() override {
+    if (done_) return nullptr;
+    if (num_next_calls_ %
+            absl::GetFlag(
+                FLAGS_zetasql_call_verify_not_aborted_rows_period) ==
+        0) {
+      absl::Status status = context_->VerifyNotAborted();
+      if (!status.ok()) {
+        status_ = status;
+        done_ = true;
+        return nullptr;
+      }
+    }
+    ++num_next_calls_;
+
+    absl::StatusOr<std::unique_ptr<TupleData>> status_or_group =
+        ReadNextGroup();
+    if (!status_or_group.ok()) {
+      status_ = status_or_group.status();
+      done_ = true;
+      return nullptr;
+    }
+    current_ = std::move(status_or_group).value();
+    if (current_ == nullptr) done_ = true;
+    return current_.get();
+  }
+
+  absl::Status Status() const override { return status_; }
+
+  void Close() override { input_iter_->Close(); }
+
+  std::string DebugString() const override {
+    return AggregateOp::GetIteratorDebugString(input_iter_->DebugString());
+  }
+
+ private:
+  // Consumes the input up to and including the first row of the group after
+  // the next one, and returns the next group, or NULL at the end of the input.
+  absl::StatusOr<std::unique_ptr<TupleData>> ReadNextGroup() {
+    while (true) {
+      const TupleData* next_input = input_iter_->Next();
+      if (next_input == nullptr) {
+        ZETASQL_RETURN_IF_ERROR(input_iter_->Status());
+        if (group_key_ == nullptr) return nullptr;
+        return FinishGroup();
+      }
+
+      auto key_data = std::make_unique<TupleData>(keys_.size());
+      auto collated_key_data = std::make_unique<TupleData>(keys_.size());
+      ZETASQL_RETURN_IF_ERROR(
+          EvaluateKey(*next_input, key_data.get(), collated_key_data.get()));
+
+      std::unique_ptr<TupleData> finished_group;
+      if (group_key_ == nullptr ||
+          !(*collated_key_data == *group_collated_key_)) {
+        if (group_key_ != nullptr) {
+          ZETASQL_ASSIGN_OR_RETURN(finished_group, FinishGroup());
+        }
+        ZETASQL_RETURN_IF_ERROR(
+            StartGroup(std::move(key_data), std::move(collated_key_data)));
+      }
+
+      absl::Status status;
+      for (AggregateArgAccumulatorParam& accumulator_param : accumulators_) {
+        if (accumulator_param.stop_bit) continue;
+        if (!accumulator_param.accumulator->Accumulate(
+                *next_input, &accumulator_param.stop_bit, &status)) {
+          return status;
+        }
+      }
+
+      if (finished_group != nullptr) return finished_group;
+    }
+  }
+
+  absl::Status EvaluateKey(const TupleData& input_row, TupleData* key_data,
+                           TupleData* collated_key_data) {
+    const std::vector<const TupleData*> params_and_input_tuple =
+        ConcatSpans(absl::Span<const TupleData* const>(params_), {&input_row});
+    for (int i = 0; i < keys_.size(); ++i) {
+      TupleSlot* slot = key_data->mutable_slot(i);
+      absl::Status status;
+      if (!keys_[i]->value_expr()->EvalSimple(params_and_input_tuple, context_,
+                                              slot, &status)) {
+        return status;
+      }
+      // Whether two arrays without a known order belong to the same group
+      // is itself non-deterministic. Unlike the hash-based path, we do not
+      // track collisions and just flag any such key beyond the first group.
+      if (num_groups_ > 0 && context_->IsDeterministicOutput() &&
+          InternalValue::ContainsArrayWithUncertainOrder(slot->value())) {
+        context_->SetNonDeterministicOutput();
+      }
+      Value* collated_slot_value =
+          collated_key_data->mutable_slot(i)->mutable_value();
+      if (sort_keys_[i] == nullptr) {
+        *collated_slot_value = slot->value();
+      } else {
+        ZETASQL_ASSIGN_OR_RETURN(*collated_slot_value,
+                         sort_keys_[i]->GetSortKey(slot->value()));
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status StartGroup(std::unique_ptr<TupleData> key_data,
+                          std::unique_ptr<TupleData> collated_key_data) {
+    group_key_ = std::move(key_data);
+    group_collated_key_ = std::move(collated_key_data);
+    accumulators_.clear();
+    accumulators_.reserve(aggregators_.size());
+    for (const AggregateArg* aggregator : aggregators_) {
+      AggregateArgAccumulatorParam accumulator_param;
+      ZETASQL_ASSIGN_OR_RETURN(accumulator_param.accumulator,
+                       aggregator->CreateAccumulator(params_, context_));
+      accumulator_param.is_grouping_function = false;
+      accumulator_param.stop_bit = false;
+      accumulators_.push_back(std::move(accumulator_param));
+    }
+    return absl::OkStatus();
+  }
+
+  absl::StatusOr<std::unique_ptr<TupleData>> FinishGroup() {
+    std::unique_ptr<TupleData> tuple = std::move(group_key_);
+    group_collated_key_.reset();
+    tuple->AddSlots(static_cast<int>(accumulators_.size()) + num_extra_slots_);
+    for (int i = 0; i < accumulators_.size(); ++i) {
+      ZETASQL_ASSIGN_OR_RETURN(Value value,
+                       accumulators_[i].accumulator->GetFinalResult(
+                           /*inputs_in_defined_order=*/false));
+      tuple->mutable_slot(static_cast<int>(keys_.size()) + i)->SetValue(value);
+    }
+    accumulators_.clear();
+    if (num_groups_ == 0) {
+      for (const KeyArg* key : keys_) {
+        if (key->type()->IsFloatingPoint()) {
+          context_->SetNonDeterministicOutput();
+        }
+      }
+    }
+    ++num_groups_;
+    return tuple;
+  }
+
+  const std::vector<const TupleData*> params_;
+  const std::vector<const KeyArg*> keys_;
+  const std::vector<const AggregateArg*> aggregators_;
+  const CollatorList collators_;
+  const std::vector<std::unique_ptr<CollationKeyCache>> sort_keys_;
+  const int num_extra_slots_;
+  const std::unique_ptr<TupleIterator> input_iter_;
+  const std::unique_ptr<TupleSchema> output_schema_;
+  EvaluationContext* context_;
+
+  // The key of the group being accumulated, or NULL before the first row.
+  std::unique_ptr<TupleData> group_key_;
+  std::unique_ptr<TupleData> group_collated_key_;
+  AccumulatorList accumulators_;
+
+  std::unique_ptr<TupleData> current_;
+  int64_t num_groups_ = 0;
+  bool done_ = false;
+  absl::Status status_;
+  int64_t num_next_calls_ = 0;
+};
+
 }  // namespace
 
-absl::StatusOr<std::unique_ptr<TupleIterator>> AggregateOp::CreateIterator(
+absl::StatusOr<std::unique_ptr<TupleIterator>> AggregateOp::CreateIteratorImpl(
     absl::Span<const TupleData* const> params, int num_extra_slots,
     EvaluationContext* context) const {
   ZETASQL_ASSIGN_OR_RETURN(
       std::unique_ptr<TupleIterator> input_iter,
       input()->CreateIterator(params, /*num_extra_slots=*/0, context));
 
-  // The key is owned by the <group_map_keys_memory> defined below.
-  absl::flat_hash_map<TupleDataPtr, std::unique_ptr<GroupValue>> group_map;
-  std::vector<std::unique_ptr<TupleData>> group_map_keys_memory;
+  // The keys of the GroupMap below are owned by <group_map_keys_memory>. Both
+  // are filled once and allocated from the tuple arena, if any.
+  std::vector<std::unique_ptr<TupleData>,
+              TupleArenaAllocator<std::unique_ptr<TupleData>>>
+      group_map_keys_memory{TupleArenaAllocator<std::unique_ptr<TupleData>>(
+          context->tuple_arena())};
 
   CollatorList collators;
 
@@ -1497,6 +2475,15 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> AggregateOp::CreateIterator(
     collators.push_back(std::move(collator));
   }
 
+  if (UsesStreamingPath()) {
+    std::unique_ptr<TupleIterator> iter =
+        std::make_unique<StreamingAggregateTupleIterator>(
+            params, keys(), aggregators(), std::move(collators),
+            num_extra_slots, std::move(input_iter), CreateOutputSchema(),
+            context);
+    return MaybeReorder(std::move(iter), context);
+  }
+
   // When array values without known orders are used as grouping keys, we can't
   // know if two rows that have arrays with the same bag of values will group
   // together (by that key) or not. The query is non-deterministic. Tracking
@@ -1571,13 +2558,30 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> AggregateOp::CreateIterator(
   UnorderedArrayCollisionTracker unordered_array_collision_tracker;
 
   absl::Status status;
-  std::vector<int64_t> grouping_sets = grouping_sets_;
+  // When the other grouping sets are derived from the finest one, only the
+  // finest one is aggregated over the input.
+  std::vector<int64_t> grouping_sets =
+      derives_grouping_sets_ ? std::vector<int64_t>{finest_grouping_set_}
+                             : grouping_sets_;
   bool has_grouping_sets = !grouping_sets.empty();
   // The number of keys in AggregateOp.
   int key_size = static_cast<int>(keys().size());
   // The number of actual keys used for grouping. For grouping sets, we group by
   // an extra key - grouping set offset.
   int grouping_key_size = has_grouping_sets ? key_size + 1 : key_size;
+  // Hash the keys of 'group_map' by the types of 'collated_key_data' below.
+  std::vector<const Type*> key_types;
+  key_types.reserve(grouping_key_size);
+  for (int i = 0; i < key_size; ++i) {
+    key_types.push_back(collators[i] == nullptr ? keys()[i]->type()
+                                                : types::BytesType());
+  }
+  if (has_grouping_sets) {
+    key_types.push_back(types::Int32Type());
+  }
+  GroupMap group_map(std::move(key_types), context->tuple_arena());
+  const std::vector<std::unique_ptr<CollationKeyCache>> sort_keys =
+      MakeCollationKeyCaches(collators);
   // To simplify the code below, when it's a regular group by query without
   // GROUPING SETS/CUBE/ROLLUP, we also convert the group-by keys to a grouping
   // set id with value -1. Theoretically we can use (1 << n) - 1 to represent
@@ -1588,12 +2592,57 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> AggregateOp::CreateIterator(
   if (grouping_sets.empty()) {
     grouping_sets.push_back(kNoGroupingSetId);
   }
+  // The parameters followed by the current input tuple.
+  std::vector<const TupleData*> params_and_input_tuple =
+      ConcatSpans(params, absl::Span<const TupleData* const>({nullptr}));
+  // With a pivot, maps each pivot value to the indexes of the aggregators that
+  // read the rows of that value, so that each row is dispatched to its
+  // aggregators with one lookup. As with IS NOT DISTINCT FROM, a NULL pivot
+  // value matches the rows of NULL. Rows of no pivot value are not aggregated,
+  // but still start their groups.
+  absl::flat_hash_map<Value, std::vector<int>> aggregators_for_pivot_value;
+  if (pivot_ != nullptr) {
+    std::vector<Value> pivot_values;
+    pivot_values.reserve(pivot_->values.size());
+    for (const std::unique_ptr<ValueExpr>& pivot_value : pivot_->values) {
+      TupleSlot slot;
+      if (!pivot_value->EvalSimple(params, context, &slot, &status)) {
+        return status;
+      }
+      pivot_values.push_back(slot.value());
+    }
+    for (int i = 0; i < pivot_->value_indexes.size(); ++i) {
+      aggregators_for_pivot_value[pivot_values[pivot_->value_indexes[i]]]
+          .push_back(i);
+    }
+  }
+  // When it's a grouping set query,  We also need to group by an additional
+  // grouping set offset to allow duplicated grouping sets in the query. In
+  // this case, it's guaranteed the last key is always the offset.
+  //
+  // 'key_data' and 'collated_key_data' are handed over to 'group_map' when
+  // they start a new group, and are otherwise reused for the next input, so
+  // that rows of existing groups do not allocate.
+  std::unique_ptr<TupleData> key_data;
+  // If collator is present for <key_data[i]>, <collated_key_data[i]> is
+  // collation_key for value of <key_data[i]>. Otherwise,
+  // <collated_key_data[i]> is the same as <key_data[i]>.
+  std::unique_ptr<TupleData> collated_key_data;
+  // If GROUPING function call is present in the AggregateOp, it needs a
+  // special input data with only 0 or 1 when conducting aggregation, rather
+  // than the original input rows. grouping_value_data[i] is 0 if the key at
+  // index is in the current grouping set, otherwise its value is 1. The
+  // grouping accumulator will calculate the output of the GROUPING function
+  // with this input data and its argument key index. Basically the
+  // accumulator just returns grouping_value_data.slot(key_index).
+  TupleData grouping_value_data(grouping_key_size);
   while (true) {
     const TupleData* next_input = input_iter->Next();
     if (next_input == nullptr) {
       ZETASQL_RETURN_IF_ERROR(input_iter->Status());
       break;
     }
+    params_and_input_tuple.back() = next_input;
 
     for (int offset = 0; offset < grouping_sets.size(); ++offset) {
       int64_t grouping_set = grouping_sets[offset];
@@ -1601,24 +2650,14 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> AggregateOp::CreateIterator(
       // query, rather than a regular query.
       bool is_grouping_set = grouping_set != kNoGroupingSetId;
       // Determine the key to 'group_to_accumulator_map'.
-      const std::vector<const TupleData*> params_and_input_tuple =
-          ConcatSpans(params, {next_input});
-      // When it's a grouping set query,  We also need to group by an additional
-      // grouping set offset to allow duplicated grouping sets in the query. In
-      // this case, it's guaranteed the last key is always the offset.
-      auto key_data = std::make_unique<TupleData>(grouping_key_size);
-      // If collator is present for <key_data[i]>, <collated_key_data[i]> is
-      // collation_key for value of <key_data[i]>. Otherwise,
-      // <collated_key_data[i]> is the same as <key_data[i]>.
-      auto collated_key_data = std::make_unique<TupleData>(grouping_key_size);
-      // If GROUPING function call is present in the AggregateOp, it needs a
-      // special input data with only 0 or 1 when conducting aggregation, rather
-      // than the original input rows. grouping_value_data[i] is 0 if the key at
-      // index is in the current grouping set, otherwise its value is 1. The
-      // grouping accumulator will calculate the output of the GROUPING function
-      // with this input data and its argument key index. Basically the
-      // accumulator just returns grouping_value_data.slot(key_index).
-      auto grouping_value_data = std::make_unique<TupleData>(grouping_key_size);
+      if (key_data == nullptr) {
+        key_data = std::make_unique<TupleData>(grouping_key_size,
+                                               context->tuple_arena());
+      }
+      if (collated_key_data == nullptr) {
+        collated_key_data = std::make_unique<TupleData>(
+            grouping_key_size, context->tuple_arena());
+      }
 
       for (int i = 0; i < key_size; ++i) {
         TupleSlot* slot = key_data->mutable_slot(i);
@@ -1634,11 +2673,11 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> AggregateOp::CreateIterator(
         if (is_grouping_set && (grouping_set & (1ull << i)) == 0) {
           // The current grouping set doesn't contains keys[i].
           slot->SetValue(Value::Null(key->type()));
-          grouping_value_data->mutable_slot(i)->SetValue(Value::Int64(1));
+          grouping_value_data.mutable_slot(i)->SetValue(Value::Int64(1));
         } else {
           // The current grouping set contains keys[i] or it's a regular group
           // by query.
-          grouping_value_data->mutable_slot(i)->SetValue(Value::Int64(0));
+          grouping_value_data.mutable_slot(i)->SetValue(Value::Int64(0));
         }
 
         if (  // Once we know the query is known to be non-deterministic, we
@@ -1654,11 +2693,11 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> AggregateOp::CreateIterator(
 
         Value* collated_slot_value =
             collated_key_data->mutable_slot(i)->mutable_value();
-        if (collators[i] == nullptr) {
+        if (sort_keys[i] == nullptr) {
           *collated_slot_value = slot->value();
         } else {
           ZETASQL_ASSIGN_OR_RETURN(*collated_slot_value,
-                           GetValueSortKey(slot->value(), *(collators[i])));
+                           sort_keys[i]->GetSortKey(slot->value()));
         }
       }
       if (is_grouping_set) {
@@ -1672,8 +2711,8 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> AggregateOp::CreateIterator(
       // Look up the value in 'group_to_accumulator_map', initializing a new
       // one if necessary.
       AccumulatorList* accumulators = nullptr;
-      std::unique_ptr<GroupValue>* found_group_value =
-          zetasql_base::FindOrNull(group_map, TupleDataPtr(collated_key_data.get()));
+      ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<GroupValue>* found_group_value,
+                       group_map.Find(*collated_key_data));
       if (found_group_value == nullptr) {
         // Create the new GroupValue.
         ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<GroupValue> inserted_group_value,
@@ -1694,20 +2733,30 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> AggregateOp::CreateIterator(
         }
 
         // Insert the new GroupValue.
-        ZETASQL_RET_CHECK(group_map
-                      .emplace(TupleDataPtr(collated_key_data.get()),
-                               std::move(inserted_group_value))
-                      .second);
+        ZETASQL_RETURN_IF_ERROR(group_map.Insert(collated_key_data.get(),
+                                         std::move(inserted_group_value)));
         group_map_keys_memory.push_back(std::move(collated_key_data));
       } else {
         accumulators = (*found_group_value)->mutable_accumulator_list();
-        key_data.reset();
-        collated_key_data.reset();
-        grouping_value_data.reset();
       }
 
       // Accumulate.
       ZETASQL_RET_CHECK_EQ(accumulators->size(), aggregators().size());
+      if (pivot_ != nullptr) {
+        const std::vector<int>* aggregator_indexes = zetasql_base::FindOrNull(
+            aggregators_for_pivot_value,
+            next_input->slot(pivot_->slot).value());
+        if (aggregator_indexes == nullptr) continue;
+        for (const int i : *aggregator_indexes) {
+          AggregateArgAccumulatorParam& accumulator_param = (*accumulators)[i];
+          if (accumulator_param.stop_bit) continue;
+          if (!accumulator_param.accumulator->Accumulate(
+                  *next_input, &accumulator_param.stop_bit, &status)) {
+            return status;
+          }
+        }
+        continue;
+      }
       bool all_accumulators_stopped = true;
       for (auto& accumulator_param : *accumulators) {
         bool& stop_bit = accumulator_param.stop_bit;
@@ -1717,7 +2766,7 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> AggregateOp::CreateIterator(
         // which contains either 0 or 1 for each key index.
         const TupleData* actual_next_input = next_input;
         if (accumulator_param.is_grouping_function) {
-          actual_next_input = grouping_value_data.get();
+          actual_next_input = &grouping_value_data;
         }
         if (!accumulator_param.accumulator->Accumulate(*actual_next_input,
                                                        &stop_bit, &status)) {
@@ -1735,35 +2784,45 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> AggregateOp::CreateIterator(
   }
 
   // Build the tuples that the iterator should return.
-  auto tuples = std::make_unique<TupleDataDeque>(context->memory_accountant());
-  for (auto& entry : group_map) {
-    // Destruction of the 'group_value' will clear all memory used by its
-    // members.
-    std::unique_ptr<GroupValue> group_value = std::move(entry.second);
-    AccumulatorList& accumulators = *group_value->mutable_accumulator_list();
-
-    std::unique_ptr<TupleData> tuple = group_value->ConsumeKey();
-    tuple->AddSlots(accumulators.size() + num_extra_slots);
-
-    for (int i = 0; i < accumulators.size(); ++i) {
-      AggregateArgAccumulator& accumulator = *accumulators[i].accumulator;
-      ZETASQL_ASSIGN_OR_RETURN(Value value, accumulator.GetFinalResult(
-                                        /*inputs_in_defined_order=*/false));
-      tuple->mutable_slot(grouping_key_size + i)->SetValue(value);
-    }
-    // This can free up considerable memory. E.g., for STRING_AGG.
-    accumulators.clear();
-
-    if (!tuples->PushBack(std::move(tuple), &status)) {
-      return status;
-    }
-  }
+  auto tuples = std::make_unique<TupleDataDeque>(context->memory_accountant(),
+                                                 context->tuple_arena());
+  ZETASQL_RETURN_IF_ERROR(group_map.ForEach(
+      [&](std::unique_ptr<GroupValue>& entry) -> absl::Status {
+        // Destruction of the 'group_value' will clear all memory used by its
+        // members.
+        std::unique_ptr<GroupValue> group_value = std::move(entry);
+        AccumulatorList& accumulators =
+            *group_value->mutable_accumulator_list();
+
+        std::unique_ptr<TupleData> tuple = group_value->ConsumeKey();
+        tuple->AddSlots(accumulators.size() + num_extra_slots);
+
+        for (int i = 0; i < accumulators.size(); ++i) {
+          AggregateArgAccumulator& accumulator = *accumulators[i].accumulator;
+          ZETASQL_ASSIGN_OR_RETURN(Value value,
+                           accumulator.GetFinalResult(
+                               /*inputs_in_defined_order=*/false));
+          tuple->mutable_slot(grouping_key_size + i)->SetValue(value);
+        }
+        // This can free up considerable memory. E.g., for STRING_AGG.
+        accumulators.clear();
+
+        if (!tuples->PushBack(std::move(tuple), &status)) {
+          return status;
+        }
+        return absl::OkStatus();
+      }));
 
   // Clears <group_map_keys_memory> and <group_map> to reclaim the memory since
   // they are not used anymore.
   group_map_keys_memory.clear();
   group_map.clear();
 
+  if (derives_grouping_sets_) {
+    ZETASQL_ASSIGN_OR_RETURN(tuples, DeriveGroupingSets(params, std::move(tuples),
+                                                num_extra_slots, context));
+  }
+
   if (tuples->IsEmpty()) {
     if (keys().empty()) {
       // We are doing full aggregation over empty input, so we must compute
@@ -1838,6 +2897,136 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> AggregateOp::CreateIterator(
   return MaybeReorder(std::move(iter), context);
 }
 
+absl::StatusOr<std::unique_ptr<TupleDataDeque>> AggregateOp::DeriveGroupingSets(
+    absl::Span<const TupleData* const> params,
+    std::unique_ptr<TupleDataDeque> finest_groups, int num_extra_slots,
+    EvaluationContext* context) const {
+  const int key_size = static_cast<int>(keys().size());
+  const std::vector<const TupleData*> finest_rows =
+      finest_groups->GetTuplePtrs();
+  std::vector<const Type*> key_types;
+  key_types.reserve(key_size + 1);
+  for (const KeyArg* key : keys()) {
+    key_types.push_back(key->type());
+  }
+  key_types.push_back(types::Int32Type());
+
+  absl::Status status;
+  auto tuples = std::make_unique<TupleDataDeque>(context->memory_accountant(),
+                                                 context->tuple_arena());
+  // The input of GROUPING() calls, as in CreateIteratorImpl().
+  TupleData grouping_value_data(key_size + 1);
+  for (int offset = 0; offset < grouping_sets_.size(); ++offset) {
+    const int64_t grouping_set = grouping_sets_[offset];
+    for (int i = 0; i < key_size; ++i) {
+      grouping_value_data.mutable_slot(i)->SetValue(
+          Value::Int64((grouping_set & (1ull << i)) == 0 ? 1 : 0));
+    }
+    // GROUPING() calls have the same value for all the groups of a grouping
+    // set.
+    std::vector<Value> grouping_values(aggregators().size());
+    for (int i = 0; i < aggregators().size(); ++i) {
+      if (rollup_aggregators_[i] != nullptr) continue;
+      ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<AggregateArgAccumulator> accumulator,
+                       aggregators()[i]->CreateAccumulator(params, context));
+      bool stop_bit = false;
+      if (!accumulator->Accumulate(grouping_value_data, &stop_bit, &status)) {
+        return status;
+      }
+      ZETASQL_ASSIGN_OR_RETURN(grouping_values[i],
+                       accumulator->GetFinalResult(
+                           /*inputs_in_defined_order=*/false));
+    }
+
+    // The keys of 'group_map' are owned by 'group_map_keys_memory'.
+    std::vector<std::unique_ptr<TupleData>> group_map_keys_memory;
+    GroupMap group_map(key_types, context->tuple_arena());
+    std::unique_ptr<TupleData> key_data;
+    for (const TupleData* finest_row : finest_rows) {
+      if (key_data == nullptr) {
+        key_data =
+            std::make_unique<TupleData>(key_size + 1, context->tuple_arena());
+      }
+      for (int i = 0; i < key_size; ++i) {
+        key_data->mutable_slot(i)->SetValue(
+            (grouping_set & (1ull << i)) == 0
+                ? Value::Null(keys()[i]->type())
+                : finest_row->slot(i).value());
+      }
+      key_data->mutable_slot(key_size)->SetValue(Value::Int32(offset));
+
+      AccumulatorList* accumulators = nullptr;
+      ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<GroupValue>* found_group_value,
+                       group_map.Find(*key_data));
+      if (found_group_value == nullptr) {
+        auto group_map_key =
+            std::make_unique<TupleData>(*key_data, context->tuple_arena());
+        ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<GroupValue> inserted_group_value,
+                         GroupValue::Create(std::move(key_data),
+                                            context->memory_accountant()));
+        accumulators = inserted_group_value->mutable_accumulator_list();
+        accumulators->reserve(rollup_aggregators_.size());
+        for (const std::unique_ptr<AggregateArg>& rollup_aggregator :
+             rollup_aggregators_) {
+          AggregateArgAccumulatorParam accumulator_param;
+          if (rollup_aggregator != nullptr) {
+            ZETASQL_ASSIGN_OR_RETURN(
+                accumulator_param.accumulator,
+                rollup_aggregator->CreateAccumulator(params, context));
+          }
+          accumulator_param.is_grouping_function = rollup_aggregator == nullptr;
+          accumulator_param.stop_bit = false;
+          accumulators->push_back(std::move(accumulator_param));
+        }
+        ZETASQL_RETURN_IF_ERROR(group_map.Insert(group_map_key.get(),
+                                         std::move(inserted_group_value)));
+        group_map_keys_memory.push_back(std::move(group_map_key));
+      } else {
+        accumulators = (*found_group_value)->mutable_accumulator_list();
+      }
+
+      for (AggregateArgAccumulatorParam& accumulator_param : *accumulators) {
+        if (accumulator_param.is_grouping_function ||
+            accumulator_param.stop_bit) {
+          continue;
+        }
+        if (!accumulator_param.accumulator->Accumulate(
+                *finest_row, &accumulator_param.stop_bit, &status)) {
+          return status;
+        }
+      }
+    }
+
+    ZETASQL_RETURN_IF_ERROR(group_map.ForEach(
+        [&](std::unique_ptr<GroupValue>& entry) -> absl::Status {
+          std::unique_ptr<GroupValue> group_value = std::move(entry);
+          AccumulatorList& accumulators =
+              *group_value->mutable_accumulator_list();
+          std::unique_ptr<TupleData> tuple = group_value->ConsumeKey();
+          tuple->AddSlots(static_cast<int>(accumulators.size()) +
+                          num_extra_slots);
+          for (int i = 0; i < accumulators.size(); ++i) {
+            if (accumulators[i].is_grouping_function) {
+              tuple->mutable_slot(key_size + 1 + i)
+                  ->SetValue(grouping_values[i]);
+              continue;
+            }
+            ZETASQL_ASSIGN_OR_RETURN(Value value,
+                             accumulators[i].accumulator->GetFinalResult(
+                                 /*inputs_in_defined_order=*/false));
+            tuple->mutable_slot(key_size + 1 + i)->SetValue(value);
+          }
+          accumulators.clear();
+          if (!tuples->PushBack(std::move(tuple), &status)) {
+            return status;
+          }
+          return absl::OkStatus();
+        }));
+    group_map.clear();
+  }
+  return tuples;
+}
+
 std::unique_ptr<TupleSchema> AggregateOp::CreateOutputSchema() const {
   std::vector<VariableId> vars;
   vars.reserve(keys().size() + aggregators().size());
@@ -1860,7 +3049,8 @@ std::string AggregateOp::DebugInternal(const std::string& indent,
   bool has_grouping_sets = !grouping_sets_.empty();
   std::string args_debug_string = ArgDebugString(
       {"keys", "aggregators", "input"}, {kN, kN, k1}, indent, verbose,
-      /*more_children=*/has_grouping_sets);
+      /*more_children=*/has_grouping_sets || input_is_grouped_by_keys_ ||
+          pivot_ != nullptr);
   // Only append grouping_sets debug string to AggregateOp when it's not empty.
   std::string grouping_sets_debug_string = "";
   if (has_grouping_sets) {
@@ -1872,10 +3062,107 @@ std::string AggregateOp::DebugInternal(const std::string& indent,
                       }),
         "]");
   }
+  if (input_is_grouped_by_keys_) {
+    absl::StrAppend(&grouping_sets_debug_string, indent, kIndentFork,
+                    "input_is_grouped_by_keys: true");
+  }
+  if (pivot_ != nullptr) {
+    absl::StrAppend(
+        &grouping_sets_debug_string, indent, kIndentFork,
+        "pivot: $", pivot_->variable.ToString(), " IN (",
+        absl::StrJoin(pivot_->values, ", ",
+                      [&](std::string* out,
+                          const std::unique_ptr<ValueExpr>& pivot_value) {
+                        absl::StrAppend(out, pivot_value->DebugInternal(
+                                                 indent, verbose));
+                      }),
+        "), pivot_value_indexes: [",
+        absl::StrJoin(pivot_->value_indexes, ","), "]");
+  }
   return absl::StrCat("AggregateOp(", args_debug_string,
                       grouping_sets_debug_string, ")");
 }
 
+RelationalProperties AggregateOp::DeriveProperties() const {
+  RelationalProperties properties;
+  if (keys().empty()) return properties;
+  if (grouping_sets_.empty()) {
+    for (const KeyArg* key : keys()) {
+      properties.unique_key.push_back(key->variable());
+    }
+  }
+  if (UsesStreamingPath()) {
+    // The groups come out in input order, so an input ordering on the
+    // variables the keys dereference carries over to the keys.
+    absl::flat_hash_map<VariableId, VariableId> key_for_input_variable;
+    for (const KeyArg* key : keys()) {
+      const auto* deref = dynamic_cast<const DerefExpr*>(key->value_expr());
+      if (deref != nullptr && key->collation() == nullptr) {
+        key_for_input_variable.try_emplace(deref->name(), key->variable());
+      }
+    }
+    for (const RelationalProperties::OrderingKey& input_key :
+         input()->DeriveProperties().ordering) {
+      const VariableId* key_variable =
+          zetasql_base::FindOrNull(key_for_input_variable, input_key.variable);
+      if (key_variable == nullptr) break;
+      RelationalProperties::OrderingKey ordering_key = input_key;
+      ordering_key.variable = *key_variable;
+      properties.ordering.push_back(ordering_key);
+    }
+    return properties;
+  }
+  // The hash-based path sorts the groups on the keys in ascending order.
+  for (const KeyArg* key : keys()) {
+    if (key->collation() != nullptr) break;
+    RelationalProperties::OrderingKey ordering_key;
+    ordering_key.variable = key->variable();
+    properties.ordering.push_back(ordering_key);
+  }
+  return properties;
+}
+
+std::vector<const Type*> AggregateOp::GetOutputTypes() const {
+  std::vector<const Type*> types;
+  types.reserve(keys().size() + aggregators().size());
+  for (const KeyArg* key : keys()) {
+    types.push_back(key->type());
+  }
+  for (const AggregateArg* aggregator : aggregators()) {
+    types.push_back(aggregator->type());
+  }
+  return types;
+}
+
+absl::StatusOr<std::unique_ptr<AggregateOp>> AggregateOp::CreateFinalAggregate(
+    std::unique_ptr<RelationalOp> input,
+    absl::Span<const VariableId> input_variables) const {
+  ZETASQL_RET_CHECK_EQ(input_variables.size(), keys().size() + aggregators().size());
+  if (!grouping_sets_.empty() || pivot_ != nullptr) return nullptr;
+
+  std::vector<std::unique_ptr<KeyArg>> final_keys;
+  for (int i = 0; i < keys().size(); ++i) {
+    const KeyArg* key = keys()[i];
+    // Collated keys that compare equal may have different values in different
+    // shards.
+    if (key->collation() != nullptr) return nullptr;
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<DerefExpr> deref,
+                     DerefExpr::Create(input_variables[i], key->type()));
+    final_keys.push_back(
+        std::make_unique<KeyArg>(key->variable(), std::move(deref)));
+  }
+  std::vector<std::unique_ptr<AggregateArg>> final_aggregators;
+  for (int i = 0; i < aggregators().size(); ++i) {
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<AggregateArg> final_aggregator,
+                     aggregators()[i]->CreateFinalAggregate(
+                         input_variables[keys().size() + i]));
+    if (final_aggregator == nullptr) return nullptr;
+    final_aggregators.push_back(std::move(final_aggregator));
+  }
+  return Create(std::move(final_keys), std::move(final_aggregators),
+                std::move(input), /*grouping_sets=*/{});
+}
+
 AggregateOp::AggregateOp(std::vector<std::unique_ptr<KeyArg>> keys,
                          std::vector<std::unique_ptr<AggregateArg>> aggregators,
                          std::unique_ptr<RelationalOp> input,
@@ -2015,7 +3302,7 @@ class TupleDataDequeIterator : public TupleIterator {
 
 }  // namespace
 
-absl::StatusOr<std::unique_ptr<TupleIterator>> GroupRowsOp::CreateIterator(
+absl::StatusOr<std::unique_ptr<TupleIterator>> GroupRowsOp::CreateIteratorImpl(
     absl::Span<const TupleData* const> params, int num_extra_slots,
     EvaluationContext* context) const {
   if (context->active_group_rows() == nullptr) {
@@ -2077,7 +3364,7 @@ std::string RowsForUdaOp::IteratorDebugString() const {
   return GetIteratorDebugString("<outer_from_clause>");
 }
 
-absl::StatusOr<std::unique_ptr<TupleIterator>> RowsForUdaOp::CreateIterator(
+absl::StatusOr<std::unique_ptr<TupleIterator>> RowsForUdaOp::CreateIteratorImpl(
     absl::Span<const TupleData* const> params, int num_extra_slots,
     EvaluationContext* context) const {
   if (context->active_group_rows() == nullptr) {
@@ -16,7 +16,9 @@
 
 // Tests of aggregate function code.
 
+#include <algorithm>
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <ostream>
 #include <string>
@@ -44,7 +46,9 @@
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "google/protobuf/wire_format_lite.h"
@@ -480,9 +484,198 @@ TEST_P(AggregateFunctionTemplateTest, AggregateFunctionTest) {
       << "Aggregate function: " << fct.debug_name();
 }
 
+// Accumulates the input with AccumulateBatch() and, if TupleColumn supports
+// its type, with AccumulateColumn().
+TEST_P(AggregateFunctionTemplateTest, BatchedAggregateFunctionTest) {
+  const AggregateFunctionTemplate& t = GetParam();
+  BuiltinAggregateFunction fct(t.kind, t.result.type(), /*num_input_fields=*/1,
+                               t.argument_type());
+  bool stop_accumulation;
+  absl::Status status;
+  {
+    EvaluationContext context((EvaluationOptions()));
+    ZETASQL_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<AggregateAccumulator> accumulator,
+        fct.CreateAccumulator(/*args=*/{}, /*collator_list=*/{}, &context));
+    ASSERT_TRUE(
+        accumulator->AccumulateBatch(t.values, &stop_accumulation, &status))
+        << status;
+    EXPECT_THAT(accumulator->GetFinalResult(/*inputs_in_defined_order=*/false),
+                IsOkAndHolds(t.result))
+        << "Aggregate function: " << fct.debug_name();
+  }
+  if (!TupleColumn::SupportsType(t.argument_type())) return;
+  TupleColumn column(t.argument_type());
+  for (const Value& value : t.values) {
+    column.Append(value);
+  }
+  EvaluationContext context((EvaluationOptions()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<AggregateAccumulator> accumulator,
+      fct.CreateAccumulator(/*args=*/{}, /*collator_list=*/{}, &context));
+  ASSERT_TRUE(
+      accumulator->AccumulateColumn(column, &stop_accumulation, &status))
+      << status;
+  EXPECT_THAT(accumulator->GetFinalResult(/*inputs_in_defined_order=*/false),
+              IsOkAndHolds(t.result))
+      << "Aggregate function: " << fct.debug_name();
+}
+
+// Splits the input at every position, accumulates the two parts separately and
+// merges the second accumulator into the first.
+TEST_P(AggregateFunctionTemplateTest, MergedAggregateFunctionTest) {
+  const AggregateFunctionTemplate& t = GetParam();
+  BuiltinAggregateFunction fct(t.kind, t.result.type(), /*num_input_fields=*/1,
+                               t.argument_type());
+  if (!fct.SupportsMergingAccumulators()) return;
+  for (int split = 0; split <= t.values.size(); ++split) {
+    EvaluationContext context((EvaluationOptions()));
+    ZETASQL_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<AggregateAccumulator> first,
+        fct.CreateAccumulator(/*args=*/{}, /*collator_list=*/{}, &context));
+    ZETASQL_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<AggregateAccumulator> second,
+        fct.CreateAccumulator(/*args=*/{}, /*collator_list=*/{}, &context));
+    ASSERT_TRUE(first->SupportsMerge());
+    for (int i = 0; i < t.values.size(); ++i) {
+      AggregateAccumulator* accumulator = i < split ? first.get() : second.get();
+      bool stop_accumulation;
+      absl::Status status;
+      ASSERT_TRUE(
+          accumulator->Accumulate(t.values[i], &stop_accumulation, &status))
+          << status;
+    }
+    ZETASQL_ASSERT_OK(first->Merge(second.get()));
+    EXPECT_THAT(first->GetFinalResult(/*inputs_in_defined_order=*/false),
+                IsOkAndHolds(t.result))
+        << "Aggregate function: " << fct.debug_name() << ", split: " << split;
+    EXPECT_EQ(t.is_deterministic, context.IsDeterministicOutput())
+        << "Aggregate function: " << fct.debug_name() << ", split: " << split;
+  }
+}
+
+// Like MergedAggregateFunctionTest, but the second accumulator is merged
+// through its serialized partial state.
+TEST_P(AggregateFunctionTemplateTest, SerializedAggregateFunctionTest) {
+  const AggregateFunctionTemplate& t = GetParam();
+  BuiltinAggregateFunction fct(t.kind, t.result.type(), /*num_input_fields=*/1,
+                               t.argument_type());
+  if (!fct.SupportsSerializingAccumulators()) return;
+  for (int split = 0; split <= t.values.size(); ++split) {
+    EvaluationContext context((EvaluationOptions()));
+    ZETASQL_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<AggregateAccumulator> first,
+        fct.CreateAccumulator(/*args=*/{}, /*collator_list=*/{}, &context));
+    ZETASQL_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<AggregateAccumulator> second,
+        fct.CreateAccumulator(/*args=*/{}, /*collator_list=*/{}, &context));
+    for (int i = 0; i < t.values.size(); ++i) {
+      AggregateAccumulator* accumulator = i < split ? first.get() : second.get();
+      bool stop_accumulation;
+      absl::Status status;
+      ASSERT_TRUE(
+          accumulator->Accumulate(t.values[i], &stop_accumulation, &status))
+          << status;
+    }
+    ZETASQL_ASSERT_OK_AND_ASSIGN(const std::string state,
+                         second->SerializePartialState());
+    ZETASQL_ASSERT_OK(first->MergeSerializedPartialState(state));
+    EXPECT_THAT(first->GetFinalResult(/*inputs_in_defined_order=*/false),
+                IsOkAndHolds(t.result))
+        << "Aggregate function: " << fct.debug_name() << ", split: " << split;
+
+    EXPECT_THAT(first->MergeSerializedPartialState(state.substr(1)),
+                StatusIs(absl::StatusCode::kOutOfRange));
+  }
+}
+
+// Slides windows of every width over the input and checks that the
+// SlidingWindowAccumulator agrees with aggregating each window from scratch.
+TEST_P(AggregateFunctionTemplateTest, SlidingWindowAggregateFunctionTest) {
+  const AggregateFunctionTemplate& t = GetParam();
+  const VariableId x("x");
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_x, DerefExpr::Create(x, t.argument_type()));
+  std::vector<std::unique_ptr<ValueExpr>> args;
+  args.push_back(std::move(deref_x));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto agg,
+      AggregateArg::Create(VariableId("agg"),
+                           std::make_unique<BuiltinAggregateFunction>(
+                               t.kind, t.result.type(),
+                               /*num_input_fields=*/1, t.argument_type()),
+                           std::move(args)));
+  ZETASQL_ASSERT_OK(
+      agg->SetSchemasForEvaluation(TupleSchema({x}), EmptyParamsSchemas()));
+
+  std::vector<std::vector<Value>> input_values;
+  for (const Value& value : t.values) {
+    input_values.push_back({value});
+  }
+  const std::vector<TupleData> tuples = CreateTestTupleDatas(input_values);
+  std::vector<const TupleData*> rows;
+  for (const TupleData& tuple : tuples) {
+    rows.push_back(&tuple);
+  }
+
+  EvaluationContext context((EvaluationOptions()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<SlidingWindowAccumulator> accumulator,
+      agg->CreateSlidingWindowAccumulator(EmptyParams(), &context));
+  if (accumulator == nullptr) return;
+  for (int width = 1; width <= rows.size(); ++width) {
+    accumulator->Reset();
+    for (int end = 1; end <= rows.size(); ++end) {
+      absl::Status status;
+      ASSERT_TRUE(accumulator->Add(*rows[end - 1], &status)) << status;
+      if (end > width) accumulator->RemoveFront();
+      const int begin = std::max(0, end - width);
+      const absl::StatusOr<Value> expected = agg->EvalAgg(
+          absl::MakeConstSpan(rows).subspan(begin, end - begin), EmptyParams(),
+          &context);
+      const absl::StatusOr<Value> actual = accumulator->GetResult();
+      if (expected.ok()) {
+        EXPECT_THAT(actual, IsOkAndHolds(expected.value()))
+            << t << ", window: [" << begin << ", " << end << ")";
+      } else {
+        EXPECT_THAT(actual, StatusIs(expected.status().code()))
+            << t << ", window: [" << begin << ", " << end << ")";
+      }
+    }
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(AggregateFunction, AggregateFunctionTemplateTest,
                          ValuesIn(AggregateFunctionTemplates()));
 
+TEST(EvalAggTest, SumInt64Column) {
+  constexpr int64_t kMax = std::numeric_limits<int64_t>::max();
+  BuiltinAggregateFunction sum(FunctionKind::kSum, types::Int64Type(),
+                               /*num_input_fields=*/1, types::Int64Type());
+  EvaluationContext context((EvaluationOptions()));
+  // Intermediate sums overflow INT64, but the final one does not.
+  TupleColumn column(types::Int64Type());
+  for (int i = 0; i < 100; ++i) {
+    column.Append(Int64(i % 2 == 0 ? kMax : -kMax + 1));
+  }
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<AggregateAccumulator> accumulator,
+      sum.CreateAccumulator(/*args=*/{}, /*collator_list=*/{}, &context));
+  bool stop_accumulation;
+  absl::Status status;
+  ASSERT_TRUE(
+      accumulator->AccumulateColumn(column, &stop_accumulation, &status));
+  EXPECT_THAT(accumulator->GetFinalResult(/*inputs_in_defined_order=*/false),
+              IsOkAndHolds(Int64(50)));
+
+  column.Append(NullInt64());
+  column.Append(Int64(kMax));
+  ZETASQL_ASSERT_OK(accumulator->Reset());
+  ASSERT_TRUE(
+      accumulator->AccumulateColumn(column, &stop_accumulation, &status));
+  EXPECT_THAT(accumulator->GetFinalResult(/*inputs_in_defined_order=*/false),
+              StatusIs(absl::StatusCode::kOutOfRange));
+}
+
 TEST(EvalAggTest, AnyDeterministic) {
   BuiltinAggregateFunction fct(FunctionKind::kAnyValue, Int64Type(),
                                /*num_input_fields=*/1, Int64Type());
@@ -522,6 +715,64 @@ TEST(EvalAggTest, SumNumericOverflow) {
   EXPECT_TRUE(context.IsDeterministicOutput());
 }
 
+TEST(EvalAggTest, MergeAvg) {
+  BuiltinAggregateFunction fct(FunctionKind::kAvg, DoubleType(),
+                               /*num_input_fields=*/1, Int64Type());
+  EvaluationContext context((EvaluationOptions()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<AggregateAccumulator> first,
+      fct.CreateAccumulator(/*args=*/{}, /*collator_list=*/{}, &context));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<AggregateAccumulator> second,
+      fct.CreateAccumulator(/*args=*/{}, /*collator_list=*/{}, &context));
+  bool stop_accumulation;
+  absl::Status status;
+  ASSERT_TRUE(first->Accumulate(Int64(1), &stop_accumulation, &status));
+  for (const Value& value : {Int64(2), NullInt64(), Int64(6)}) {
+    ASSERT_TRUE(second->Accumulate(value, &stop_accumulation, &status));
+  }
+  ZETASQL_ASSERT_OK(first->Merge(second.get()));
+  EXPECT_THAT(first->GetFinalResult(/*inputs_in_defined_order=*/false),
+              IsOkAndHolds(Double(3.0)));
+}
+
+TEST(EvalAggTest, MergeStringAggWithDelimiter) {
+  BuiltinAggregateFunction fct(FunctionKind::kStringAgg, StringType(),
+                               /*num_input_fields=*/1, StringType());
+  EvaluationContext context((EvaluationOptions()));
+  const std::vector<Value> args = {String("|")};
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<AggregateAccumulator> first,
+      fct.CreateAccumulator(args, /*collator_list=*/{}, &context));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<AggregateAccumulator> second,
+      fct.CreateAccumulator(args, /*collator_list=*/{}, &context));
+  bool stop_accumulation;
+  absl::Status status;
+  ASSERT_TRUE(first->Accumulate(String("a"), &stop_accumulation, &status));
+  ASSERT_TRUE(second->Accumulate(String("b"), &stop_accumulation, &status));
+  ASSERT_TRUE(second->Accumulate(String("c"), &stop_accumulation, &status));
+  ZETASQL_ASSERT_OK(first->Merge(second.get()));
+  EXPECT_THAT(first->GetFinalResult(/*inputs_in_defined_order=*/false),
+              IsOkAndHolds(String("a|b|c")));
+}
+
+TEST(EvalAggTest, MergeNotSupported) {
+  BuiltinAggregateFunction fct(FunctionKind::kStddevPop, DoubleType(),
+                               /*num_input_fields=*/1, DoubleType());
+  EXPECT_FALSE(fct.SupportsMergingAccumulators());
+  EvaluationContext context((EvaluationOptions()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<AggregateAccumulator> first,
+      fct.CreateAccumulator(/*args=*/{}, /*collator_list=*/{}, &context));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<AggregateAccumulator> second,
+      fct.CreateAccumulator(/*args=*/{}, /*collator_list=*/{}, &context));
+  EXPECT_FALSE(first->SupportsMerge());
+  EXPECT_THAT(first->Merge(second.get()),
+              StatusIs(absl::StatusCode::kInternal));
+}
+
 TEST(OrderPreservationTest, GroupByAggregate) {
   TypeFactory type_factory;
   VariableId a("a"), b("b"), c1("c1"), c2("c2"), k("k"), n("n"), d("d");
@@ -791,6 +1042,245 @@ TEST(CreateIteratorTest, AggregateAll) {
                HasSubstr("Out of memory")));
 }
 
+TEST(CreateIteratorTest, AggregateInputGroupedByKeys) {
+  VariableId a("a"), b("b"), k("k"), s("s"), c("c");
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_a, DerefExpr::Create(a, Int64Type()));
+  std::vector<std::unique_ptr<KeyArg>> keys;
+  keys.push_back(std::make_unique<KeyArg>(k, std::move(deref_a)));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_b, DerefExpr::Create(b, Int64Type()));
+  std::vector<std::unique_ptr<ValueExpr>> args_for_s;
+  args_for_s.push_back(std::move(deref_b));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto arg_s,
+      AggregateArg::Create(s,
+                           std::make_unique<BuiltinAggregateFunction>(
+                               FunctionKind::kSum, Int64Type(),
+                               /*num_input_fields=*/1, Int64Type()),
+                           std::move(args_for_s)));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto arg_c,
+      AggregateArg::Create(c, std::make_unique<BuiltinAggregateFunction>(
+                                  FunctionKind::kCount, Int64Type(),
+                                  /*num_input_fields=*/0, EmptyStructType())));
+
+  std::vector<std::unique_ptr<AggregateArg>> aggregators;
+  aggregators.push_back(std::move(arg_s));
+  aggregators.push_back(std::move(arg_c));
+
+  // The input is grouped but in descending key order, which the hash-based
+  // path would not preserve.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto aggregate_op,
+      AggregateOp::Create(std::move(keys), std::move(aggregators),
+                          absl::WrapUnique(new TestRelationalOp(
+                              {a, b},
+                              CreateTestTupleDatas({{Int64(3), Int64(10)},
+                                                    {Int64(3), Int64(20)},
+                                                    {Int64(2), Int64(5)},
+                                                    {Int64(1), NullInt64()},
+                                                    {Int64(1), Int64(1)}}),
+                              /*preserves_order=*/true)),
+                          /*grouping_sets=*/{}));
+  aggregate_op->set_input_is_grouped_by_keys(true);
+  EXPECT_EQ(
+      "AggregateOp(\n"
+      "+-keys: {\n"
+      "| +-$k := $a},\n"
+      "+-aggregators: {\n"
+      "| +-$s := Sum($b),\n"
+      "| +-$c := Count()},\n"
+      "+-input: TestRelationalOp\n"
+      "+-input_is_grouped_by_keys: true)",
+      aggregate_op->DebugString());
+  ZETASQL_ASSERT_OK(aggregate_op->SetSchemasForEvaluation(EmptyParamsSchemas()));
+
+  EvaluationContext context((EvaluationOptions()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<TupleIterator> iter,
+                       aggregate_op->CreateIterator(
+                           EmptyParams(), /*num_extra_slots=*/1, &context));
+  EXPECT_EQ(iter->DebugString(), "AggregationTupleIterator(TestTupleIterator)");
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::vector<TupleData> data,
+                       ReadFromTupleIterator(iter.get()));
+  ASSERT_EQ(data.size(), 3);
+  EXPECT_EQ(Tuple(&iter->Schema(), &data[0]).DebugString(), "<k:3,s:30,c:2>");
+  EXPECT_EQ(Tuple(&iter->Schema(), &data[1]).DebugString(), "<k:2,s:5,c:1>");
+  EXPECT_EQ(Tuple(&iter->Schema(), &data[2]).DebugString(), "<k:1,s:1,c:2>");
+  // Check for the extra slot.
+  EXPECT_EQ(data[0].num_slots(), 4);
+  EXPECT_TRUE(context.IsDeterministicOutput());
+
+  // Cancellation is checked before producing each group.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      iter, aggregate_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/0,
+                                         &context));
+  ZETASQL_ASSERT_OK(context.CancelStatement());
+  EXPECT_EQ(iter->Next(), nullptr);
+  EXPECT_THAT(iter->Status(), StatusIs(absl::StatusCode::kCancelled, _));
+}
+
+// Groups the rows of 'input' by their STRING column with 'collation', and
+// returns the number of rows of each group, ordered by the group key.
+static std::vector<std::string> CountByCollatedKey(
+    absl::string_view collation, std::vector<TupleData> input,
+    bool input_is_grouped_by_keys) {
+  VariableId a("a"), k("k"), c("c");
+
+  auto deref_a = DerefExpr::Create(a, StringType()).value();
+  std::vector<std::unique_ptr<KeyArg>> keys;
+  keys.push_back(std::make_unique<KeyArg>(k, std::move(deref_a)));
+  keys.back()->set_collation(ConstExpr::Create(String(collation)).value());
+
+  std::vector<std::unique_ptr<AggregateArg>> aggregators;
+  aggregators.push_back(
+      AggregateArg::Create(c, std::make_unique<BuiltinAggregateFunction>(
+                                  FunctionKind::kCount, Int64Type(),
+                                  /*num_input_fields=*/0, EmptyStructType()))
+          .value());
+
+  auto aggregate_op =
+      AggregateOp::Create(std::move(keys), std::move(aggregators),
+                          absl::WrapUnique(new TestRelationalOp(
+                              {a}, std::move(input), /*preserves_order=*/true)),
+                          /*grouping_sets=*/{})
+          .value();
+  aggregate_op->set_input_is_grouped_by_keys(input_is_grouped_by_keys);
+  ZETASQL_CHECK_OK(aggregate_op->SetSchemasForEvaluation(EmptyParamsSchemas()));
+
+  EvaluationContext context((EvaluationOptions()));
+  std::unique_ptr<TupleIterator> iter =
+      aggregate_op
+          ->CreateIterator(EmptyParams(), /*num_extra_slots=*/0, &context)
+          .value();
+  std::vector<TupleData> data = ReadFromTupleIterator(iter.get()).value();
+  std::vector<std::string> groups;
+  for (const TupleData& group : data) {
+    groups.push_back(Tuple(&iter->Schema(), &group).DebugString());
+  }
+  std::sort(groups.begin(), groups.end());
+  return groups;
+}
+
+TEST(CreateIteratorTest, AggregateCollatedStringKey) {
+  // "A" and "a" belong to the same group with the case-insensitive collation,
+  // which is keyed by the first of them.
+  EXPECT_THAT(CountByCollatedKey("und:ci",
+                                 CreateTestTupleDatas({{String("a")},
+                                                       {String("b")},
+                                                       {String("A")},
+                                                       {NullString()},
+                                                       {String("a")}}),
+                                 /*input_is_grouped_by_keys=*/false),
+              ElementsAre("<k:\"a\",c:3>", "<k:\"b\",c:1>", "<k:NULL,c:1>"));
+  EXPECT_THAT(CountByCollatedKey("und:ci",
+                                 CreateTestTupleDatas({{String("a")},
+                                                       {String("A")},
+                                                       {String("b")},
+                                                       {String("B")}}),
+                                 /*input_is_grouped_by_keys=*/true),
+              ElementsAre("<k:\"a\",c:2>", "<k:\"b\",c:2>"));
+  EXPECT_THAT(CountByCollatedKey("binary",
+                                 CreateTestTupleDatas({{String("a")},
+                                                       {String("b")},
+                                                       {String("A")},
+                                                       {String("a")}}),
+                                 /*input_is_grouped_by_keys=*/false),
+              ElementsAre("<k:\"A\",c:1>", "<k:\"a\",c:2>", "<k:\"b\",c:1>"));
+
+  // More distinct keys than the sort keys that are remembered at a time.
+  const int kNumKeys = 1500;
+  std::vector<std::vector<Value>> rows;
+  for (const absl::string_view prefix : {"key", "KEY", "Key"}) {
+    for (int i = 0; i < kNumKeys; ++i) {
+      rows.push_back({String(absl::StrCat(prefix, i))});
+    }
+  }
+  std::vector<std::string> groups =
+      CountByCollatedKey("und:ci", CreateTestTupleDatas(rows),
+                         /*input_is_grouped_by_keys=*/false);
+  ASSERT_EQ(groups.size(), kNumKeys);
+  for (const std::string& group : groups) {
+    EXPECT_THAT(group, HasSubstr("\",c:3>"));
+  }
+}
+
+// Returns the groups of COUNT(*) GROUP BY 'input', which has one column of
+// type 'type', sorted by their debug strings.
+static std::vector<std::string> CountByKey(const Type* type,
+                                           std::vector<TupleData> input) {
+  VariableId a("a"), k("k"), c("c");
+
+  std::vector<std::unique_ptr<KeyArg>> keys;
+  keys.push_back(
+      std::make_unique<KeyArg>(k, DerefExpr::Create(a, type).value()));
+
+  std::vector<std::unique_ptr<AggregateArg>> aggregators;
+  aggregators.push_back(
+      AggregateArg::Create(c, std::make_unique<BuiltinAggregateFunction>(
+                                  FunctionKind::kCount, Int64Type(),
+                                  /*num_input_fields=*/0, EmptyStructType()))
+          .value());
+
+  auto aggregate_op =
+      AggregateOp::Create(std::move(keys), std::move(aggregators),
+                          absl::WrapUnique(new TestRelationalOp(
+                              {a}, std::move(input), /*preserves_order=*/true)),
+                          /*grouping_sets=*/{})
+          .value();
+  ZETASQL_CHECK_OK(aggregate_op->SetSchemasForEvaluation(EmptyParamsSchemas()));
+
+  EvaluationContext context((EvaluationOptions()));
+  std::unique_ptr<TupleIterator> iter =
+      aggregate_op
+          ->CreateIterator(EmptyParams(), /*num_extra_slots=*/0, &context)
+          .value();
+  std::vector<TupleData> data = ReadFromTupleIterator(iter.get()).value();
+  std::vector<std::string> groups;
+  for (const TupleData& group : data) {
+    groups.push_back(Tuple(&iter->Schema(), &group).DebugString());
+  }
+  std::sort(groups.begin(), groups.end());
+  return groups;
+}
+
+TEST(CreateIteratorTest, AggregateFixedWidthKey) {
+  // A single fixed-width key is grouped by its bits, with NULL in a group of
+  // its own.
+  EXPECT_THAT(CountByKey(Int64Type(), CreateTestTupleDatas({{Int64(-1)},
+                                                            {NullInt64()},
+                                                            {Int64(0)},
+                                                            {Int64(-1)},
+                                                            {NullInt64()}})),
+              ElementsAre("<k:-1,c:2>", "<k:0,c:1>", "<k:NULL,c:2>"));
+  EXPECT_THAT(
+      CountByKey(Uint64Type(),
+                 CreateTestTupleDatas(
+                     {{Uint64(std::numeric_limits<uint64_t>::max())},
+                      {Uint64(0)},
+                      {Uint64(std::numeric_limits<uint64_t>::max())}})),
+      ElementsAre("<k:0,c:1>", "<k:18446744073709551615,c:2>"));
+  EXPECT_THAT(CountByKey(BoolType(), CreateTestTupleDatas({{Bool(true)},
+                                                           {Bool(false)},
+                                                           {NullBool()},
+                                                           {Bool(true)}})),
+              ElementsAre("<k:NULL,c:1>", "<k:false,c:1>", "<k:true,c:2>"));
+
+  // Many groups.
+  const int kNumKeys = 10000;
+  std::vector<std::vector<Value>> rows;
+  for (int i = 0; i < 2 * kNumKeys; ++i) {
+    rows.push_back({Int32(i % kNumKeys)});
+  }
+  std::vector<std::string> groups =
+      CountByKey(Int32Type(), CreateTestTupleDatas(rows));
+  ASSERT_EQ(groups.size(), kNumKeys);
+  for (const std::string& group : groups) {
+    EXPECT_THAT(group, HasSubstr(",c:2>"));
+  }
+}
+
 TEST(CreateIteratorTest, AggregateOrderBy) {
   TypeFactory type_factory;
   VariableId a("a"), b("b"), c("c"), d("d"), e("e"), f("f"), g("g"), h("h"),
@@ -1965,5 +2455,209 @@ TEST(EvalAggTest, GroupingFunctionTest) {
   EXPECT_THAT(reference, EqualsValue(expected));
 }
 
+TEST(EvalAggTest, GroupingSetsDerivedFromFinestGroupingSet) {
+  // The following code builds an AggregateOp for the query
+  // "SELECT key, value, COUNT(*), SUM(key), GROUPING(value)
+  // FROM KeyValue GROUP BY ROLLUP(key, value)"
+  VariableId col_key("col_key"), col_value("col_value"), key("key"),
+      value("value"), agg_count("count"), agg_sum("sum"),
+      agg_grouping_value("grouping_value");
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_col_key,
+                       DerefExpr::Create(col_key, types::Int64Type()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_col_value,
+                       DerefExpr::Create(col_value, types::StringType()));
+  std::vector<std::unique_ptr<KeyArg>> keys;
+  keys.push_back(std::make_unique<KeyArg>(key, std::move(deref_col_key)));
+  keys.push_back(std::make_unique<KeyArg>(value, std::move(deref_col_value)));
+
+  std::vector<std::unique_ptr<AggregateArg>> aggregators;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto count,
+      AggregateArg::Create(agg_count,
+                           std::make_unique<BuiltinAggregateFunction>(
+                               FunctionKind::kCount, Int64Type(),
+                               /*num_input_fields=*/0, EmptyStructType()),
+                           {}));
+  aggregators.push_back(std::move(count));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto sum_arg,
+                       DerefExpr::Create(col_key, Int64Type()));
+  std::vector<std::unique_ptr<ValueExpr>> sum_args;
+  sum_args.push_back(std::move(sum_arg));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto sum, AggregateArg::Create(agg_sum,
+                                     std::make_unique<BuiltinAggregateFunction>(
+                                         FunctionKind::kSum, Int64Type(),
+                                         /*num_input_fields=*/1, Int64Type()),
+                                     std::move(sum_args)));
+  aggregators.push_back(std::move(sum));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<ValueExpr> grouping_value_arg,
+                       ConstExpr::Create(Value::Int64(1)));
+  std::vector<std::unique_ptr<ValueExpr>> grouping_value_args;
+  grouping_value_args.push_back(std::move(grouping_value_arg));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto grouping,
+      AggregateArg::Create(agg_grouping_value,
+                           std::make_unique<BuiltinAggregateFunction>(
+                               FunctionKind::kGrouping, Int64Type(),
+                               /*num_input_fields=*/1, Int64Type()),
+                           std::move(grouping_value_args)));
+  aggregators.push_back(std::move(grouping));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<AggregateOp> aggregate_op,
+      AggregateOp::Create(std::move(keys), std::move(aggregators),
+                          absl::WrapUnique(new TestRelationalOp(
+                              {col_key, col_value},
+                              CreateTestTupleDatas({{Int64(1), String("a")},
+                                                    {Int64(2), String("b")},
+                                                    {Int64(1), String("a")},
+                                                    {Int64(2), NullString()}}),
+                              /*preserves_order=*/true)),
+                          /*grouping_sets=*/{3, 1, 0}));
+  ZETASQL_ASSERT_OK(
+      aggregate_op->SetSchemasForEvaluation(EmptyParamsSchemas()));
+  EXPECT_TRUE(aggregate_op->derives_grouping_sets());
+
+  EvaluationContext context((EvaluationOptions()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<TupleIterator> iter,
+                       aggregate_op->CreateIterator(
+                           EmptyParams(), /*num_extra_slots=*/0, &context));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::vector<TupleData> data,
+                       ReadFromTupleIterator(iter.get()));
+  std::vector<std::string> tuples;
+  for (const TupleData& tuple : data) {
+    tuples.push_back(Tuple(&iter->Schema(), &tuple).DebugString());
+  }
+  EXPECT_THAT(
+      tuples,
+      ElementsAre("<key:NULL,value:NULL,count:4,sum:6,grouping_value:1>",
+                  "<key:1,value:NULL,count:2,sum:2,grouping_value:1>",
+                  "<key:1,value:\"a\",count:2,sum:2,grouping_value:0>",
+                  "<key:2,value:NULL,count:1,sum:2,grouping_value:0>",
+                  "<key:2,value:NULL,count:2,sum:4,grouping_value:1>",
+                  "<key:2,value:\"b\",count:1,sum:2,grouping_value:0>"));
+
+  // Aggregates without a final aggregate are computed for every grouping set
+  // over the input.
+  std::vector<std::unique_ptr<KeyArg>> distinct_keys;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto distinct_key_expr,
+                       DerefExpr::Create(col_key, Int64Type()));
+  distinct_keys.push_back(
+      std::make_unique<KeyArg>(key, std::move(distinct_key_expr)));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto distinct_arg,
+                       DerefExpr::Create(col_value, StringType()));
+  std::vector<std::unique_ptr<ValueExpr>> distinct_args;
+  distinct_args.push_back(std::move(distinct_arg));
+  std::vector<std::unique_ptr<AggregateArg>> distinct_aggregators;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto count_distinct,
+      AggregateArg::Create(agg_count,
+                           std::make_unique<BuiltinAggregateFunction>(
+                               FunctionKind::kCount, Int64Type(),
+                               /*num_input_fields=*/1, StringType()),
+                           std::move(distinct_args), AggregateArg::kDistinct));
+  distinct_aggregators.push_back(std::move(count_distinct));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      aggregate_op,
+      AggregateOp::Create(std::move(distinct_keys),
+                          std::move(distinct_aggregators),
+                          absl::WrapUnique(new TestRelationalOp(
+                              {col_key, col_value},
+                              CreateTestTupleDatas({{Int64(1), String("a")},
+                                                    {Int64(1), String("b")},
+                                                    {Int64(2), String("a")}}),
+                              /*preserves_order=*/true)),
+                          /*grouping_sets=*/{1, 0}));
+  ZETASQL_ASSERT_OK(
+      aggregate_op->SetSchemasForEvaluation(EmptyParamsSchemas()));
+  EXPECT_FALSE(aggregate_op->derives_grouping_sets());
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      iter, aggregate_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/0,
+                                         &context));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(data, ReadFromTupleIterator(iter.get()));
+  tuples.clear();
+  for (const TupleData& tuple : data) {
+    tuples.push_back(Tuple(&iter->Schema(), &tuple).DebugString());
+  }
+  EXPECT_THAT(tuples, ElementsAre("<key:NULL,count:2>", "<key:1,count:2>",
+                                  "<key:2,count:1>"));
+}
+
+TEST(EvalAggTest, PivotDispatchesRowsByPivotValue) {
+  // The following code builds an AggregateOp for the query
+  // "SELECT * FROM (SELECT key, value, num FROM T)
+  // PIVOT(SUM(num) FOR value IN ('a', 'b'))", with one more COUNT(*) for the
+  // NULL pivot value.
+  VariableId col_key("col_key"), col_value("col_value"), col_num("col_num"),
+      key("key"), sum_a("sum_a"), sum_b("sum_b"), count_null("count_null");
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_col_key,
+                       DerefExpr::Create(col_key, Int64Type()));
+  std::vector<std::unique_ptr<KeyArg>> keys;
+  keys.push_back(std::make_unique<KeyArg>(key, std::move(deref_col_key)));
+
+  std::vector<std::unique_ptr<AggregateArg>> aggregators;
+  for (const VariableId& sum_variable : {sum_a, sum_b}) {
+    ZETASQL_ASSERT_OK_AND_ASSIGN(auto sum_arg,
+                         DerefExpr::Create(col_num, Int64Type()));
+    std::vector<std::unique_ptr<ValueExpr>> sum_args;
+    sum_args.push_back(std::move(sum_arg));
+    ZETASQL_ASSERT_OK_AND_ASSIGN(
+        auto sum,
+        AggregateArg::Create(sum_variable,
+                             std::make_unique<BuiltinAggregateFunction>(
+                                 FunctionKind::kSum, Int64Type(),
+                                 /*num_input_fields=*/1, Int64Type()),
+                             std::move(sum_args)));
+    aggregators.push_back(std::move(sum));
+  }
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto count,
+      AggregateArg::Create(count_null,
+                           std::make_unique<BuiltinAggregateFunction>(
+                               FunctionKind::kCount, Int64Type(),
+                               /*num_input_fields=*/0, EmptyStructType()),
+                           {}));
+  aggregators.push_back(std::move(count));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<AggregateOp> aggregate_op,
+      AggregateOp::Create(
+          std::move(keys), std::move(aggregators),
+          absl::WrapUnique(new TestRelationalOp(
+              {col_key, col_value, col_num},
+              CreateTestTupleDatas({{Int64(1), String("a"), Int64(10)},
+                                    {Int64(1), String("b"), Int64(20)},
+                                    {Int64(1), String("a"), Int64(30)},
+                                    {Int64(2), NullString(), Int64(40)},
+                                    {Int64(2), String("c"), Int64(50)}}),
+              /*preserves_order=*/true)),
+          /*grouping_sets=*/{}));
+  EXPECT_TRUE(AggregateOp::SupportsPivotDispatch(StringType()));
+  EXPECT_FALSE(AggregateOp::SupportsPivotDispatch(DoubleType()));
+  std::vector<std::unique_ptr<ValueExpr>> pivot_values;
+  for (const Value& value : {String("a"), String("b"), NullString()}) {
+    ZETASQL_ASSERT_OK_AND_ASSIGN(auto pivot_value, ConstExpr::Create(value));
+    pivot_values.push_back(std::move(pivot_value));
+  }
+  ZETASQL_ASSERT_OK(aggregate_op->SetPivot(col_value, std::move(pivot_values),
+                                   /*pivot_value_indexes=*/{0, 1, 2}));
+  ZETASQL_ASSERT_OK(
+      aggregate_op->SetSchemasForEvaluation(EmptyParamsSchemas()));
+
+  EvaluationContext context((EvaluationOptions()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<TupleIterator> iter,
+                       aggregate_op->CreateIterator(
+                           EmptyParams(), /*num_extra_slots=*/0, &context));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::vector<TupleData> data,
+                       ReadFromTupleIterator(iter.get()));
+  std::vector<std::string> tuples;
+  for (const TupleData& tuple : data) {
+    tuples.push_back(Tuple(&iter->Schema(), &tuple).DebugString());
+  }
+  EXPECT_THAT(tuples,
+              ElementsAre("<key:1,sum_a:40,sum_b:20,count_null:0>",
+                          "<key:2,sum_a:NULL,sum_b:NULL,count_null:1>"));
+}
+
 }  // namespace
 }  // namespace zetasql
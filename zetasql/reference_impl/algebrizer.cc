@@ -61,6 +61,8 @@
 #include "zetasql/reference_impl/common.h"
 #include "zetasql/reference_impl/evaluation.h"
 #include "zetasql/reference_impl/function.h"
+#include "zetasql/reference_impl/functions/json.h"
+#include "zetasql/reference_impl/join_key_filter.h"
 #include "zetasql/reference_impl/operator.h"
 #include "zetasql/reference_impl/parameters.h"
 #include "zetasql/reference_impl/proto_util.h"
@@ -108,6 +110,10 @@ namespace zetasql {
 
 namespace {
 
+// The smallest number of constant elements of an IN list for which it is
+// evaluated with a hash lookup, rather than by comparing with each element.
+constexpr int kMinInListSizeForHashLookup = 16;
+
 constexpr FunctionSignatureId kCollationSupportedAnalyticFunctions[] = {
     FN_COUNT,
     FN_MIN,
@@ -991,10 +997,26 @@ absl::StatusOr<std::unique_ptr<ValueExpr>> Algebrizer::AlgebrizeCoalesce(
   return result;
 }
 
-// In(v, v1, v2, ...) = WithExpr(x:=v, Or(x=v1, x=v2, ...))
+// In(v, v1, v2, ...) = WithExpr(x:=v, Or(x=v1, x=v2, ...)), or
+// InListExpr(v, {v1, v2, ...}) if v1, v2, ... are enough constants.
 absl::StatusOr<std::unique_ptr<ValueExpr>> Algebrizer::AlgebrizeIn(
     const Type* output_type, std::vector<std::unique_ptr<ValueExpr>> args) {
   ZETASQL_RET_CHECK_GE(args.size(), 2);
+  if (args.size() - 1 >= kMinInListSizeForHashLookup &&
+      InListExpr::SupportsType(args[0]->output_type())) {
+    std::vector<Value> elements;
+    elements.reserve(args.size() - 1);
+    for (int i = 1; i < args.size(); ++i) {
+      if (!args[i]->IsConstant() ||
+          !args[i]->output_type()->Equals(args[0]->output_type())) {
+        break;
+      }
+      elements.push_back(static_cast<const ConstExpr*>(args[i].get())->value());
+    }
+    if (elements.size() == args.size() - 1) {
+      return InListExpr::Create(std::move(args[0]), elements);
+    }
+  }
   const VariableId x = variable_gen_->GetNewVariableName("x");
   std::vector<std::unique_ptr<ValueExpr>> or_args;
   for (int i = 0; i < args.size() - 1; ++i) {
@@ -1459,6 +1481,11 @@ Algebrizer::AlgebrizeAggregateFnWithAlgebrizedArguments(
         function = std::make_unique<BinaryStatFunction>(kind, type, input_type);
         break;
       }
+    case FunctionKind::kHllCountInit:
+    case FunctionKind::kHllCountMerge:
+    case FunctionKind::kHllCountMergePartial:
+      function = std::make_unique<HllCountFunction>(kind, type, input_type);
+      break;
     default: {
       ZETASQL_RET_CHECK(aggregate_function->function()->IsZetaSQLBuiltin());
       function = std::make_unique<BuiltinAggregateFunction>(
@@ -1476,7 +1503,7 @@ Algebrizer::AlgebrizeAggregateFnWithAlgebrizedArguments(
 
   if (!aggregate_function->collation_list().empty() &&
       distinctness != AggregateArg::kDistinct && kind != FunctionKind::kMin &&
-      kind != FunctionKind::kMax) {
+      kind != FunctionKind::kMax && kind != FunctionKind::kHllCountInit) {
     return ::zetasql_base::InvalidArgumentErrorBuilder()
            << "Collation is not supported for aggregate function " << name
            << " without DISTINCT";
@@ -1752,6 +1779,113 @@ Algebrizer::AlgebrizeGetProtoFieldOfPath(
   return base_expr;
 }
 
+// Returns true if 'type' can be part of the key of a MemoizedSubqueryExpr,
+// i.e., if Value::Equals() only holds for Values that no expression can tell
+// apart. This excludes floating point types (-0.0 equals 0.0), arrays (which
+// may be compared ignoring order), and types with a semantic notion of
+// equality such as INTERVAL and JSON.
+static bool IsMemoizationKeyType(const Type* type) {
+  switch (type->kind()) {
+    case TYPE_BOOL:
+    case TYPE_INT32:
+    case TYPE_INT64:
+    case TYPE_UINT32:
+    case TYPE_UINT64:
+    case TYPE_STRING:
+    case TYPE_BYTES:
+    case TYPE_DATE:
+    case TYPE_TIMESTAMP:
+    case TYPE_DATETIME:
+    case TYPE_TIME:
+    case TYPE_NUMERIC:
+    case TYPE_BIGNUMERIC:
+    case TYPE_ENUM:
+      return true;
+    case TYPE_STRUCT:
+      for (const StructField& field : type->AsStruct()->fields()) {
+        if (!IsMemoizationKeyType(field.type)) return false;
+      }
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns true if the result of 'subquery_expr' is determined by the values of
+// its correlated parameters for the duration of a statement. Volatile
+// functions and random sampling make the result vary between evaluations, and
+// function arguments, GROUP_ROWS(), recursive references and catalog column
+// references are inputs that are not correlated parameters.
+static absl::StatusOr<bool> IsMemoizableSubquery(
+    const ResolvedSubqueryExpr* subquery_expr) {
+  // ResolvedASTVisitor that looks for nodes that prevent memoization.
+  class MemoizableSubqueryVisitor : public ResolvedASTVisitor {
+   public:
+    MemoizableSubqueryVisitor() = default;
+    MemoizableSubqueryVisitor(const MemoizableSubqueryVisitor&) = delete;
+    MemoizableSubqueryVisitor& operator=(const MemoizableSubqueryVisitor&) =
+        delete;
+
+    bool memoizable() const { return memoizable_; }
+
+    absl::Status DefaultVisit(const ResolvedNode* node) override {
+      if (!memoizable_) return absl::OkStatus();
+      switch (node->node_kind()) {
+        case RESOLVED_FUNCTION_CALL:
+        case RESOLVED_AGGREGATE_FUNCTION_CALL:
+        case RESOLVED_ANALYTIC_FUNCTION_CALL:
+          if (node->GetAs<ResolvedFunctionCallBase>()
+                  ->function()
+                  ->function_options()
+                  .volatility == FunctionEnums::VOLATILE) {
+            memoizable_ = false;
+            return absl::OkStatus();
+          }
+          break;
+        case RESOLVED_ARGUMENT_REF:
+        case RESOLVED_CATALOG_COLUMN_REF:
+        case RESOLVED_GROUP_ROWS_SCAN:
+        case RESOLVED_RECURSIVE_REF_SCAN:
+        case RESOLVED_RELATION_ARGUMENT_SCAN:
+        case RESOLVED_SAMPLE_SCAN:
+        case RESOLVED_TVFSCAN:
+        case RESOLVED_ANONYMIZED_AGGREGATE_SCAN:
+        case RESOLVED_DIFFERENTIAL_PRIVACY_AGGREGATE_SCAN:
+        case RESOLVED_AGGREGATION_THRESHOLD_AGGREGATE_SCAN:
+          memoizable_ = false;
+          return absl::OkStatus();
+        default:
+          break;
+      }
+      return ResolvedASTVisitor::DefaultVisit(node);
+    }
+
+   private:
+    bool memoizable_ = true;
+  };
+
+  MemoizableSubqueryVisitor visitor;
+  ZETASQL_RETURN_IF_ERROR(subquery_expr->subquery()->Accept(&visitor));
+  return visitor.memoizable();
+}
+
+absl::StatusOr<std::optional<std::vector<VariableId>>>
+Algebrizer::GetSubqueryMemoizationKey(
+    const ResolvedSubqueryExpr* subquery_expr) {
+  ZETASQL_ASSIGN_OR_RETURN(const bool memoizable,
+                   IsMemoizableSubquery(subquery_expr));
+  if (!memoizable) return std::nullopt;
+  std::vector<VariableId> key;
+  for (const auto& parameter : subquery_expr->parameter_list()) {
+    if (!IsMemoizationKeyType(parameter->column().type())) return std::nullopt;
+    const absl::StatusOr<VariableId> variable =
+        column_to_variable_->LookupVariableNameForColumn(parameter->column());
+    if (!variable.ok()) return std::nullopt;
+    key.push_back(variable.value());
+  }
+  return key;
+}
+
 absl::StatusOr<std::unique_ptr<ValueExpr>> Algebrizer::AlgebrizeSubqueryExpr(
     const ResolvedSubqueryExpr* subquery_expr) {
   // Access 'parameters' to suppress the resolver check for non-accessed
@@ -1759,6 +1893,20 @@ absl::StatusOr<std::unique_ptr<ValueExpr>> Algebrizer::AlgebrizeSubqueryExpr(
   for (const auto& parameter : subquery_expr->parameter_list()) {
     parameter->column();
   }
+  std::optional<std::vector<VariableId>> memoization_key;
+  if (algebrizer_options_.memoize_subqueries) {
+    ZETASQL_ASSIGN_OR_RETURN(memoization_key,
+                     GetSubqueryMemoizationKey(subquery_expr));
+  }
+  // Wraps 'expr' in a MemoizedSubqueryExpr if 'memoization_key' is set.
+  auto maybe_memoize = [&memoization_key](std::unique_ptr<ValueExpr> expr)
+      -> absl::StatusOr<std::unique_ptr<ValueExpr>> {
+    if (!memoization_key.has_value()) return expr;
+    ZETASQL_ASSIGN_OR_RETURN(
+        auto memoized_expr,
+        MemoizedSubqueryExpr::Create(*memoization_key, std::move(expr)));
+    return std::unique_ptr<ValueExpr>(std::move(memoized_expr));
+  };
   // We will restore 'column_to_variable_' after algebrizing the subquery
   // to avoid any side-effect caused by the subquery.
   const ColumnToVariableMapping::Map original_column_to_variable =
@@ -1777,7 +1925,7 @@ absl::StatusOr<std::unique_ptr<ValueExpr>> Algebrizer::AlgebrizeSubqueryExpr(
       // testing of this feature.
       ZETASQL_ASSIGN_OR_RETURN(auto subquery_valueop,
                        ExistsExpr::Create(std::move(relation)));
-      return std::unique_ptr<ValueExpr>(std::move(subquery_valueop));
+      return maybe_memoize(std::move(subquery_valueop));
     }
     case ResolvedSubqueryExpr::SCALAR: {
       // A single column which may be a struct or an array.
@@ -1790,7 +1938,7 @@ absl::StatusOr<std::unique_ptr<ValueExpr>> Algebrizer::AlgebrizeSubqueryExpr(
       ZETASQL_ASSIGN_OR_RETURN(
           auto single_value_expr,
           SingleValueExpr::Create(std::move(deref), std::move(relation)));
-      return std::unique_ptr<ValueExpr>(std::move(single_value_expr));
+      return maybe_memoize(std::move(single_value_expr));
     }
     case ResolvedSubqueryExpr::ARRAY: {
       // Either a single scalar column or a struct column.
@@ -1799,7 +1947,7 @@ absl::StatusOr<std::unique_ptr<ValueExpr>> Algebrizer::AlgebrizeSubqueryExpr(
           NestSingleColumnRelation(output_columns, std::move(relation),
                                    /*is_with_table=*/false));
       column_to_variable_->set_map(original_column_to_variable);
-      return nest_expr;
+      return maybe_memoize(std::move(nest_expr));
     }
     case ResolvedSubqueryExpr::IN:
     case ResolvedSubqueryExpr::LIKE_ANY:
@@ -1814,6 +1962,34 @@ absl::StatusOr<std::unique_ptr<ValueExpr>> Algebrizer::AlgebrizeSubqueryExpr(
       column_to_variable_->set_map(original_column_to_variable);
       ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ValueExpr> in_value,
                        AlgebrizeExpression(subquery_expr->in_expr()));
+      const Type* haystack_type = scan->column_list()[0].type();
+      if (memoization_key.has_value() && !haystack_type->IsArray()) {
+        // Memoize the haystack as an array, and search that instead of
+        // re-evaluating the subquery for each 'in_value'. The array stands
+        // for a relation, so like a WITH table it is bounded by the
+        // statement's memory budget rather than by max_value_byte_size.
+        const ArrayType* haystack_array_type;
+        ZETASQL_RETURN_IF_ERROR(
+            type_factory_->MakeArrayType(haystack_type, &haystack_array_type));
+        ZETASQL_ASSIGN_OR_RETURN(auto deref_haystack_var,
+                         DerefExpr::Create(haystack_var, haystack_type));
+        ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ValueExpr> haystack_array,
+                         ArrayNestExpr::Create(
+                             haystack_array_type, std::move(deref_haystack_var),
+                             std::move(relation), /*is_with_table=*/true));
+        ZETASQL_ASSIGN_OR_RETURN(haystack_array,
+                         maybe_memoize(std::move(haystack_array)));
+        const VariableId element_var =
+            variable_gen_->GetNewVariableName("_in_element");
+        ZETASQL_ASSIGN_OR_RETURN(
+            std::unique_ptr<RelationalOp> haystack_rel,
+            ArrayScanOp::Create(element_var, VariableId(), /* position */
+                                {},                         /* fields */
+                                std::move(haystack_array)));
+        return AlgebrizeInLikeAnyLikeAllRelation(
+            std::move(in_value), subquery_expr->subquery_type(), element_var,
+            std::move(haystack_rel), subquery_expr->in_collation());
+      }
       return AlgebrizeInLikeAnyLikeAllRelation(
           std::move(in_value), subquery_expr->subquery_type(), haystack_var,
           std::move(relation), subquery_expr->in_collation());
@@ -2014,6 +2190,359 @@ Algebrizer::AlgebrizeStandaloneExpression(const ResolvedExpr* expr) {
   return WrapWithRootExpr(std::move(value_expr));
 }
 
+// Returns true if 'expr' is a deterministic function call or cast whose
+// inputs are all literals. See AlgebrizerOptions::fold_constants.
+static bool IsFoldableConstant(const ResolvedExpr* expr) {
+  switch (expr->node_kind()) {
+    case RESOLVED_LITERAL:
+      return true;
+    case RESOLVED_CAST: {
+      const ResolvedCast* cast = expr->GetAs<ResolvedCast>();
+      return cast->format() == nullptr && cast->time_zone() == nullptr &&
+             cast->extended_cast() == nullptr &&
+             IsFoldableConstant(cast->expr());
+    }
+    case RESOLVED_FUNCTION_CALL: {
+      const ResolvedFunctionCall* function_call =
+          expr->GetAs<ResolvedFunctionCall>();
+      if (function_call->function()->function_options().volatility !=
+              FunctionEnums::IMMUTABLE ||
+          !function_call->generic_argument_list().empty()) {
+        return false;
+      }
+      for (const auto& argument : function_call->argument_list()) {
+        if (!IsFoldableConstant(argument.get())) return false;
+      }
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+// Returns true if 'function_call' only evaluates its first argument
+// unconditionally, or evaluates no argument unconditionally because it
+// catches their errors. Subexpressions of its other arguments must not be
+// hoisted by AlgebrizerOptions::eliminate_common_subexpressions.
+static bool IsConditionalFunction(const ResolvedFunctionCall* function_call,
+                                  bool* catches_errors) {
+  const std::string& name = function_call->function()->Name();
+  *catches_errors =
+      name == "iferror" || name == "iserror" || name == "nulliferror";
+  return *catches_errors || name == "if" || name == "ifnull" ||
+         name == "coalesce" || name == "$case_no_value" ||
+         name == "$case_with_value" || name == "$and" || name == "$or";
+}
+
+// Returns true if 'expr1' and 'expr2' are expressions accepted by
+// CollectCommonSubexpressionCandidates() that compute the same value.
+static bool IsSameCommonSubexpression(const ResolvedExpr* expr1,
+                                      const ResolvedExpr* expr2) {
+  if (expr1->node_kind() != expr2->node_kind() ||
+      !expr1->type()->Equals(expr2->type())) {
+    return false;
+  }
+  switch (expr1->node_kind()) {
+    case RESOLVED_LITERAL:
+      return expr1->GetAs<ResolvedLiteral>()->value() ==
+             expr2->GetAs<ResolvedLiteral>()->value();
+    case RESOLVED_PARAMETER: {
+      const ResolvedParameter* param1 = expr1->GetAs<ResolvedParameter>();
+      const ResolvedParameter* param2 = expr2->GetAs<ResolvedParameter>();
+      return param1->name() == param2->name() &&
+             param1->position() == param2->position();
+    }
+    case RESOLVED_COLUMN_REF:
+      return expr1->GetAs<ResolvedColumnRef>()->column() ==
+             expr2->GetAs<ResolvedColumnRef>()->column();
+    case RESOLVED_GET_STRUCT_FIELD: {
+      const ResolvedGetStructField* field1 =
+          expr1->GetAs<ResolvedGetStructField>();
+      const ResolvedGetStructField* field2 =
+          expr2->GetAs<ResolvedGetStructField>();
+      return field1->field_idx() == field2->field_idx() &&
+             IsSameCommonSubexpression(field1->expr(), field2->expr());
+    }
+    case RESOLVED_CAST: {
+      const ResolvedCast* cast1 = expr1->GetAs<ResolvedCast>();
+      const ResolvedCast* cast2 = expr2->GetAs<ResolvedCast>();
+      return cast1->return_null_on_error() == cast2->return_null_on_error() &&
+             IsSameCommonSubexpression(cast1->expr(), cast2->expr());
+    }
+    case RESOLVED_FUNCTION_CALL: {
+      const ResolvedFunctionCall* call1 = expr1->GetAs<ResolvedFunctionCall>();
+      const ResolvedFunctionCall* call2 = expr2->GetAs<ResolvedFunctionCall>();
+      if (call1->function() != call2->function() ||
+          call1->error_mode() != call2->error_mode() ||
+          call1->argument_list_size() != call2->argument_list_size() ||
+          call1->collation_list_size() != call2->collation_list_size()) {
+        return false;
+      }
+      for (int i = 0; i < call1->collation_list_size(); ++i) {
+        if (!call1->collation_list(i).Equals(call2->collation_list(i))) {
+          return false;
+        }
+      }
+      for (int i = 0; i < call1->argument_list_size(); ++i) {
+        if (!IsSameCommonSubexpression(call1->argument_list(i),
+                                       call2->argument_list(i))) {
+          return false;
+        }
+      }
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+// Returns true if 'expr' can be computed in a slot of a ComputeOp whose input
+// has the columns in 'available_columns', i.e., it only consists of the node
+// kinds handled by IsSameCommonSubexpression(), without volatile functions.
+// If so, and 'unconditional' is true, appends the function calls and casts
+// in 'expr' that are evaluated whenever 'expr' is to 'candidates', children
+// first.
+static bool CollectCommonSubexpressionCandidates(
+    const ResolvedExpr* expr, bool unconditional,
+    const ColumnToVariableMapping::Map& available_columns,
+    std::vector<const ResolvedExpr*>* candidates) {
+  switch (expr->node_kind()) {
+    case RESOLVED_LITERAL:
+    case RESOLVED_PARAMETER:
+      return true;
+    case RESOLVED_COLUMN_REF:
+      return available_columns.contains(
+          expr->GetAs<ResolvedColumnRef>()->column());
+    case RESOLVED_GET_STRUCT_FIELD:
+      return CollectCommonSubexpressionCandidates(
+          expr->GetAs<ResolvedGetStructField>()->expr(), unconditional,
+          available_columns, candidates);
+    case RESOLVED_CAST: {
+      const ResolvedCast* cast = expr->GetAs<ResolvedCast>();
+      if (cast->format() != nullptr || cast->time_zone() != nullptr ||
+          cast->extended_cast() != nullptr ||
+          !CollectCommonSubexpressionCandidates(cast->expr(), unconditional,
+                                                available_columns,
+                                                candidates)) {
+        return false;
+      }
+      break;
+    }
+    case RESOLVED_FUNCTION_CALL: {
+      const ResolvedFunctionCall* function_call =
+          expr->GetAs<ResolvedFunctionCall>();
+      bool catches_errors = false;
+      const bool conditional =
+          IsConditionalFunction(function_call, &catches_errors);
+      bool ok = function_call->function()->function_options().volatility !=
+                    FunctionEnums::VOLATILE &&
+                function_call->generic_argument_list().empty();
+      for (int i = 0; i < function_call->argument_list_size(); ++i) {
+        const bool argument_unconditional =
+            unconditional && !catches_errors && (!conditional || i == 0);
+        ok &= CollectCommonSubexpressionCandidates(
+            function_call->argument_list(i), argument_unconditional,
+            available_columns, candidates);
+      }
+      if (!ok) return false;
+      break;
+    }
+    default:
+      return false;
+  }
+  if (unconditional) candidates->push_back(expr);
+  return true;
+}
+
+// Returns the extraction computed by 'expr' if it is a call of a JSON
+// extraction function with a constant path on a column that can be grouped
+// by AlgebrizerOptions::group_json_extractions.
+static std::optional<JsonPathExtraction> GetJsonPathExtraction(
+    const ResolvedExpr* expr, const LanguageOptions& language_options) {
+  if (expr->node_kind() != RESOLVED_FUNCTION_CALL) return std::nullopt;
+  const ResolvedFunctionCall* function_call =
+      expr->GetAs<ResolvedFunctionCall>();
+  if (!function_call->function()->IsZetaSQLBuiltin() ||
+      function_call->error_mode() !=
+          ResolvedFunctionCallBase::DEFAULT_ERROR_MODE ||
+      function_call->argument_list_size() < 1 ||
+      function_call->argument_list_size() > 2 ||
+      function_call->argument_list(0)->node_kind() != RESOLVED_COLUMN_REF) {
+    return std::nullopt;
+  }
+  absl::StatusOr<FunctionKind> kind = BuiltinFunctionCatalog::GetKindByName(
+      function_call->function()->FullName(/*include_group=*/false));
+  if (!kind.ok()) return std::nullopt;
+  JsonPathExtraction extraction{.kind = *kind, .json_path = "$"};
+  if (function_call->argument_list_size() == 2) {
+    const ResolvedExpr* path = function_call->argument_list(1);
+    if (path->node_kind() != RESOLVED_LITERAL) return std::nullopt;
+    const Value& value = path->GetAs<ResolvedLiteral>()->value();
+    if (value.type_kind() != TYPE_STRING || value.is_null()) {
+      return std::nullopt;
+    }
+    extraction.json_path = value.string_value();
+  }
+  if (!CanExtractJsonPathTogether(extraction,
+                                  function_call->argument_list(0)->type(),
+                                  language_options)) {
+    return std::nullopt;
+  }
+  return extraction;
+}
+
+absl::StatusOr<std::unique_ptr<ValueExpr>>
+Algebrizer::AlgebrizeAndFoldConstant(const ResolvedExpr* expr) {
+  folding_constant_ = true;
+  absl::StatusOr<std::unique_ptr<ValueExpr>> val_op = AlgebrizeExpression(expr);
+  folding_constant_ = false;
+  ZETASQL_RETURN_IF_ERROR(val_op.status());
+
+  ZETASQL_RETURN_IF_ERROR(
+      (*val_op)->SetSchemasForEvaluation(/*params_schemas=*/{}));
+  EvaluationContext context((EvaluationOptions()));
+  context.SetLanguageOptions(language_options_);
+  TupleSlot result;
+  absl::Status status;
+  if (!(*val_op)->EvalSimple(/*params=*/{}, &context, &result, &status) ||
+      context.default_time_zone_initialized() ||
+      !context.IsDeterministicOutput()) {
+    // Leave errors to evaluation, where 'expr' may not even be evaluated. A
+    // ConstExpr would also lose the non-determinism of e.g. ARRAY_SUM() of
+    // doubles, which evaluation reports through the statement's context.
+    return val_op;
+  }
+  return ConstExpr::Create(result.value());
+}
+
+absl::StatusOr<std::vector<std::unique_ptr<ExprArg>>>
+Algebrizer::AlgebrizeCommonSubexpressions(
+    absl::Span<const ResolvedExpr* const> exprs) {
+  // Bounds the quadratic search below for very large projections.
+  constexpr int kMaxCandidates = 1000;
+
+  std::vector<const ResolvedExpr*> candidates;
+  for (const ResolvedExpr* expr : exprs) {
+    CollectCommonSubexpressionCandidates(expr, /*unconditional=*/true,
+                                         column_to_variable_->map(),
+                                         &candidates);
+  }
+  if (candidates.size() > kMaxCandidates) candidates.resize(kMaxCandidates);
+
+  // Children come before their parents in 'candidates', so visit them in
+  // reverse to hoist the largest repeated expressions. Anything inside an
+  // occurrence of a hoisted expression is read from its slot.
+  std::vector<std::unique_ptr<ExprArg>> args;
+  absl::flat_hash_set<const ResolvedNode*> covered;
+  for (int i = static_cast<int>(candidates.size()) - 1; i >= 0; --i) {
+    const ResolvedExpr* candidate = candidates[i];
+    if (covered.contains(candidate) ||
+        absl::c_any_of(common_subexpressions_, [candidate](const auto& entry) {
+          return IsSameCommonSubexpression(candidate, entry.first);
+        })) {
+      continue;
+    }
+    std::vector<const ResolvedExpr*> occurrences = {candidate};
+    for (int j = i - 1; j >= 0; --j) {
+      if (!covered.contains(candidates[j]) &&
+          IsSameCommonSubexpression(candidate, candidates[j])) {
+        occurrences.push_back(candidates[j]);
+      }
+    }
+    if (occurrences.size() < 2) continue;
+
+    for (const ResolvedExpr* occurrence : occurrences) {
+      std::vector<const ResolvedNode*> descendants;
+      occurrence->GetDescendantsSatisfying(&ResolvedNode::IsExpression,
+                                           &descendants);
+      covered.insert(descendants.begin(), descendants.end());
+    }
+    // 'candidate' may read the slots of the expressions hoisted before it,
+    // which precede it in the ComputeOp.
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ValueExpr> value_expr,
+                     AlgebrizeExpression(candidate));
+    const VariableId variable = variable_gen_->GetNewVariableName("cse");
+    args.push_back(std::make_unique<ExprArg>(variable, std::move(value_expr)));
+    common_subexpressions_.emplace_back(candidate, variable);
+  }
+  return args;
+}
+
+absl::StatusOr<std::vector<std::unique_ptr<ExprArg>>>
+Algebrizer::AlgebrizeJsonExtractions(
+    absl::Span<const ResolvedExpr* const> exprs) {
+  std::vector<const ResolvedExpr*> candidates;
+  for (const ResolvedExpr* expr : exprs) {
+    CollectCommonSubexpressionCandidates(expr, /*unconditional=*/true,
+                                         column_to_variable_->map(),
+                                         &candidates);
+  }
+
+  // The distinct extractions from each column, in order of appearance.
+  struct Group {
+    const ResolvedExpr* input;
+    std::vector<const ResolvedExpr*> calls;
+    std::vector<JsonPathExtraction> extractions;
+  };
+  std::vector<Group> groups;
+  absl::flat_hash_map<ResolvedColumn, int> group_index;
+  for (const ResolvedExpr* candidate : candidates) {
+    std::optional<JsonPathExtraction> extraction =
+        GetJsonPathExtraction(candidate, language_options_);
+    if (!extraction.has_value()) continue;
+    const ResolvedExpr* input =
+        candidate->GetAs<ResolvedFunctionCall>()->argument_list(0);
+    auto [it, inserted] = group_index.try_emplace(
+        input->GetAs<ResolvedColumnRef>()->column(), groups.size());
+    if (inserted) groups.push_back({.input = input});
+    Group& group = groups[it->second];
+    if (absl::c_any_of(group.calls, [candidate](const ResolvedExpr* call) {
+          return IsSameCommonSubexpression(candidate, call);
+        })) {
+      continue;
+    }
+    group.calls.push_back(candidate);
+    group.extractions.push_back(*std::move(extraction));
+  }
+
+  std::vector<std::unique_ptr<ExprArg>> args;
+  for (const Group& group : groups) {
+    if (group.calls.size() < 2) continue;
+    std::vector<StructType::StructField> fields;
+    fields.reserve(group.calls.size());
+    for (const ResolvedExpr* call : group.calls) {
+      fields.push_back({"", call->type()});
+    }
+    const StructType* struct_type;
+    ZETASQL_RETURN_IF_ERROR(type_factory_->MakeStructType(fields, &struct_type));
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<BuiltinScalarFunction> function,
+                     CreateJsonMultiExtractFunction(
+                         group.input->type(), group.extractions, struct_type));
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ValueExpr> input,
+                     AlgebrizeExpression(group.input));
+    std::vector<std::unique_ptr<ValueExpr>> arguments;
+    arguments.push_back(std::move(input));
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ValueExpr> value_expr,
+                     ScalarFunctionCallExpr::Create(std::move(function),
+                                                    std::move(arguments)));
+    const VariableId struct_variable =
+        variable_gen_->GetNewVariableName("json");
+    args.push_back(
+        std::make_unique<ExprArg>(struct_variable, std::move(value_expr)));
+
+    for (int i = 0; i < group.calls.size(); ++i) {
+      ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ValueExpr> deref,
+                       DerefExpr::Create(struct_variable, struct_type));
+      ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ValueExpr> field,
+                       FieldValueExpr::Create(i, std::move(deref)));
+      const VariableId variable = variable_gen_->GetNewVariableName("json");
+      args.push_back(std::make_unique<ExprArg>(variable, std::move(field)));
+      common_subexpressions_.emplace_back(group.calls[i], variable);
+    }
+  }
+  return args;
+}
+
 absl::StatusOr<std::unique_ptr<ValueExpr>> Algebrizer::AlgebrizeExpression(
     const ResolvedExpr* expr) {
   ZETASQL_RETURN_IF_NOT_ENOUGH_STACK(
@@ -2026,6 +2555,34 @@ absl::StatusOr<std::unique_ptr<ValueExpr>> Algebrizer::AlgebrizeExpression(
            << expr->type()->TypeName(language_options_.product_mode());
   }
 
+  if (algebrizer_options_.fold_constants && !folding_constant_ &&
+      (expr->node_kind() == RESOLVED_FUNCTION_CALL ||
+       expr->node_kind() == RESOLVED_CAST) &&
+      IsFoldableConstant(expr)) {
+    return AlgebrizeAndFoldConstant(expr);
+  }
+  for (const auto& [common_subexpression, variable] : common_subexpressions_) {
+    if (IsSameCommonSubexpression(expr, common_subexpression)) {
+      return DerefExpr::Create(variable, expr->type());
+    }
+  }
+  // The slots of 'common_subexpressions_' are not visible to the operators of
+  // subqueries or to lambda bodies.
+  const bool hide_common_subexpressions =
+      !common_subexpressions_.empty() &&
+      (expr->node_kind() == RESOLVED_SUBQUERY_EXPR ||
+       (expr->node_kind() == RESOLVED_FUNCTION_CALL &&
+        !expr->GetAs<ResolvedFunctionCall>()->generic_argument_list().empty()));
+  if (hide_common_subexpressions) {
+    std::vector<std::pair<const ResolvedExpr*, VariableId>> saved =
+        std::move(common_subexpressions_);
+    common_subexpressions_.clear();
+    absl::StatusOr<std::unique_ptr<ValueExpr>> val_op =
+        AlgebrizeExpression(expr);
+    common_subexpressions_ = std::move(saved);
+    return val_op;
+  }
+
   std::unique_ptr<ValueExpr> val_op;
   switch (expr->node_kind()) {
     case RESOLVED_LITERAL: {
@@ -2270,9 +2827,10 @@ absl::StatusOr<std::unique_ptr<ValueExpr>> Algebrizer::AlgebrizeExpression(
   return val_op;
 }
 
-// Returns the set of columns referenced by 'expr'.
+// Returns the set of columns referenced by 'node', which is usually an
+// expression.
 static absl::StatusOr<absl::flat_hash_set<ResolvedColumn>> GetReferencedColumns(
-    const ResolvedExpr* expr) {
+    const ResolvedNode* node) {
   // ResolvedASTVisitor that records the set of referenced columns.
   class ReferencedColumnsVisitor : public ResolvedASTVisitor {
    public:
@@ -2296,7 +2854,78 @@ static absl::StatusOr<absl::flat_hash_set<ResolvedColumn>> GetReferencedColumns(
   };
 
   ReferencedColumnsVisitor visitor;
-  ZETASQL_RETURN_IF_ERROR(expr->Accept(&visitor));
+  ZETASQL_RETURN_IF_ERROR(node->Accept(&visitor));
+  return visitor.columns();
+}
+
+// Returns a superset of the columns that 'node' reads after they are produced
+// by a scan, which is every column referenced by an expression plus every
+// column that a scan passes to a node that may read its columns by position or
+// identity. For example, in
+//   SELECT a FROM (SELECT * FROM Table WHERE b > 0)
+// the ResolvedFilterScan only reads 'b' and passes through its other columns,
+// so column 'c' of 'Table' is not read, while the ResolvedProjectScan of the
+// subquery makes every one of its columns available to its parent.
+static absl::StatusOr<absl::flat_hash_set<ResolvedColumn>> GetColumnsReadByNode(
+    const ResolvedNode* node) {
+  // ResolvedASTVisitor that records the set of read columns.
+  class ReadColumnsVisitor : public ResolvedASTVisitor {
+   public:
+    ReadColumnsVisitor() = default;
+    ReadColumnsVisitor(const ReadColumnsVisitor&) = delete;
+    ReadColumnsVisitor& operator=(const ReadColumnsVisitor&) = delete;
+
+    const absl::flat_hash_set<ResolvedColumn>& columns() const {
+      return columns_;
+    }
+
+    absl::Status DefaultVisit(const ResolvedNode* node) override {
+      if (node->IsScan() && (parents_.empty() || !ReadsInputColumnsByReference(
+                                                     parents_.back()))) {
+        for (const ResolvedColumn& column :
+             node->GetAs<ResolvedScan>()->column_list()) {
+          columns_.insert(column);
+        }
+      }
+      parents_.push_back(node);
+      const absl::Status status = node->ChildrenAccept(this);
+      parents_.pop_back();
+      return status;
+    }
+
+    absl::Status VisitResolvedColumnRef(
+        const ResolvedColumnRef* node) override {
+      columns_.insert(node->column());
+      return DefaultVisit(node);
+    }
+
+   private:
+    // Returns true if 'node' only reads the columns of its input scans through
+    // ResolvedColumnRefs, other than by passing them through to its own
+    // column list.
+    static bool ReadsInputColumnsByReference(const ResolvedNode* node) {
+      switch (node->node_kind()) {
+        case RESOLVED_PROJECT_SCAN:
+        case RESOLVED_FILTER_SCAN:
+        case RESOLVED_JOIN_SCAN:
+        case RESOLVED_ARRAY_SCAN:
+        case RESOLVED_AGGREGATE_SCAN:
+        case RESOLVED_ANALYTIC_SCAN:
+        case RESOLVED_ORDER_BY_SCAN:
+        case RESOLVED_LIMIT_OFFSET_SCAN:
+        case RESOLVED_SAMPLE_SCAN:
+          return true;
+        default:
+          return false;
+      }
+    }
+
+    absl::flat_hash_set<ResolvedColumn> columns_;
+    std::vector<const ResolvedNode*> parents_;
+  };
+
+  ReadColumnsVisitor visitor;
+  ZETASQL_RETURN_IF_ERROR(node->Accept(&visitor));
   return visitor.columns();
 }
 
@@ -2502,9 +3131,30 @@ absl::StatusOr<std::unique_ptr<RelationalOp>> Algebrizer::AlgebrizeTableScan(
       }
     }
 
-    return EvaluatorTableScanOp::Create(
-        table_scan->table(), table_scan->alias(), column_idx_list, column_names,
-        variables, std::move(and_filters), std::move(system_time_expr));
+    ZETASQL_ASSIGN_OR_RETURN(
+        std::unique_ptr<EvaluatorTableScanOp> scan_op,
+        EvaluatorTableScanOp::Create(
+            table_scan->table(), table_scan->alias(), column_idx_list,
+            column_names, variables, std::move(and_filters),
+            std::move(system_time_expr)));
+    if (referenced_columns_.has_value()) {
+      std::vector<int> referenced_columns;
+      for (int i = 0; i < column_list.size(); ++i) {
+        if (referenced_columns_->contains(column_list[i])) {
+          referenced_columns.push_back(i);
+        }
+      }
+      scan_op->set_referenced_columns(std::move(referenced_columns));
+    }
+    if (algebrizer_options_.use_join_key_filters) {
+      for (int i = 0; i < column_list.size(); ++i) {
+        auto [it, inserted] = table_scan_variables_.try_emplace(
+            variables[i], TableScanColumn{column_list[i], scan_op.get()});
+        // Be conservative if a variable is somehow produced by two scans.
+        if (!inserted) it->second.scan = nullptr;
+      }
+    }
+    return scan_op;
   }
 }
 
@@ -2679,8 +3329,51 @@ absl::Status Algebrizer::TryAlgebrizeFilterConjunctAsColumnFilterArgs(
       and_filters->push_back(std::move(filter));
       break;
     }
-    case FilterConjunctInfo::kOther:
+    case FilterConjunctInfo::kOther: {
+      // Of the other conjuncts, only <column> IS NULL and <column> LIKE
+      // <pattern> are pushed down. (IS NULL does not have its own kind because
+      // it is not NULL when its argument is NULL.)
+      if (conjunct_info.conjunct->node_kind() != RESOLVED_FUNCTION_CALL) break;
+      const ResolvedFunctionCall* function_call =
+          conjunct_info.conjunct->GetAs<ResolvedFunctionCall>();
+      if (!function_call->function()->IsZetaSQLBuiltin()) break;
+      const std::string name =
+          function_call->function()->FullName(/*include_group=*/false);
+      if (name != "$is_null" && name != "$like") break;
+
+      ZETASQL_RET_CHECK(!conjunct_info.arguments.empty());
+      if (conjunct_info.arguments[0]->node_kind() != RESOLVED_COLUMN_REF) {
+        return absl::OkStatus();
+      }
+      const ResolvedColumn& column =
+          conjunct_info.arguments[0]->GetAs<ResolvedColumnRef>()->column();
+      const std::pair<VariableId, int>* variable_and_column_idx =
+          zetasql_base::FindOrNull(column_info_map, column);
+      if (variable_and_column_idx == nullptr) return absl::OkStatus();
+
+      std::unique_ptr<ColumnFilterArg> filter;
+      if (name == "$is_null") {
+        ZETASQL_ASSIGN_OR_RETURN(filter, IsNullColumnFilterArg::Create(
+                                     variable_and_column_idx->first,
+                                     variable_and_column_idx->second));
+      } else {
+        ZETASQL_RET_CHECK_EQ(conjunct_info.arguments.size(), 2);
+        // With a collation, matching values need not start with the pattern's
+        // prefix byte-for-byte.
+        if (!function_call->collation_list().empty()) break;
+        if (Intersects(conjunct_info.argument_columns[1], table_columns)) {
+          return absl::OkStatus();
+        }
+        ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ValueExpr> pattern,
+                         AlgebrizeExpression(conjunct_info.arguments[1]));
+        ZETASQL_ASSIGN_OR_RETURN(filter, PrefixColumnFilterArg::Create(
+                                     variable_and_column_idx->first,
+                                     variable_and_column_idx->second,
+                                     std::move(pattern)));
+      }
+      and_filters->push_back(std::move(filter));
       break;
+    }
   }
 
   return absl::OkStatus();
@@ -2697,6 +3390,11 @@ absl::Status Algebrizer::TryAlgebrizeFilterConjunctAsColumnFilterArgs(
 //
 //  t1 and t4 would have one reference, while t2 and t3 would have zero
 //  references.
+//
+// A reference that may be evaluated more than once, because it is inside a
+// subquery expression or the recursive term of a recursive query, counts as
+// more than one reference, so that the WITH entry is evaluated once instead of
+// being inlined and recomputed each time.
 class FindWithEntryReferenceCountVisitor : public ResolvedASTVisitor {
  public:
   static absl::StatusOr<absl::flat_hash_map<std::string, int>> Run(
@@ -2760,17 +3458,41 @@ class FindWithEntryReferenceCountVisitor : public ResolvedASTVisitor {
     return absl::OkStatus();
   }
 
+  absl::Status VisitResolvedSubqueryExpr(
+      const ResolvedSubqueryExpr* expr) override {
+    ++num_repeated_scopes_;
+    const absl::Status status = expr->ChildrenAccept(this);
+    --num_repeated_scopes_;
+    return status;
+  }
+
+  absl::Status VisitResolvedRecursiveScan(
+      const ResolvedRecursiveScan* scan) override {
+    ZETASQL_RETURN_IF_ERROR(scan->non_recursive_term()->Accept(this));
+    ++num_repeated_scopes_;
+    const absl::Status status = scan->recursive_term()->Accept(this);
+    --num_repeated_scopes_;
+    ZETASQL_RETURN_IF_ERROR(status);
+    if (scan->recursion_depth_modifier() != nullptr) {
+      ZETASQL_RETURN_IF_ERROR(scan->recursion_depth_modifier()->Accept(this));
+    }
+    return absl::OkStatus();
+  }
+
   absl::Status VisitResolvedWithRefScan(
       const ResolvedWithRefScan* scan) override {
     auto it = reference_count_.find(scan->with_query_name());
     if (it != reference_count_.end()) {
-      ++it->second;
+      it->second += num_repeated_scopes_ > 0 ? 2 : 1;
     }
     return absl::OkStatus();
   }
 
  private:
   absl::flat_hash_map<std::string, int> reference_count_;
+  // The number of enclosing nodes whose descendants may be evaluated more than
+  // once.
+  int num_repeated_scopes_ = 0;
 };
 
 absl::StatusOr<std::unique_ptr<RelationalOp>> Algebrizer::AlgebrizeWithScan(
@@ -2932,6 +3654,15 @@ absl::StatusOr<std::unique_ptr<RelationalOp>>
 Algebrizer::AlgebrizeArrayScanWithoutJoin(
     const ResolvedArrayScan* array_scan,
     std::vector<FilterConjunctInfo*>* active_conjuncts) {
+  if (algebrizer_options_.stream_generated_arrays) {
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<RelationalOp> generate_array_scan,
+                     MaybeAlgebrizeGenerateArrayScan(array_scan));
+    if (generate_array_scan != nullptr) {
+      return MaybeApplyFilterConjuncts(std::move(generate_array_scan),
+                                       active_conjuncts);
+    }
+  }
+
   int element_column_count = array_scan->array_expr_list_size();
   std::vector<VariableId> element_list(element_column_count);
   std::vector<std::unique_ptr<ValueExpr>> array_list(element_column_count);
@@ -2966,6 +3697,57 @@ Algebrizer::AlgebrizeArrayScanWithoutJoin(
   return MaybeApplyFilterConjuncts(std::move(rel_op), active_conjuncts);
 }
 
+absl::StatusOr<std::unique_ptr<RelationalOp>>
+Algebrizer::MaybeAlgebrizeGenerateArrayScan(
+    const ResolvedArrayScan* array_scan) {
+  if (array_scan->array_expr_list_size() != 1 ||
+      array_scan->array_zip_mode() != nullptr ||
+      array_scan->array_expr_list(0)->node_kind() != RESOLVED_FUNCTION_CALL) {
+    return nullptr;
+  }
+  const ResolvedFunctionCall* function_call =
+      array_scan->array_expr_list(0)->GetAs<ResolvedFunctionCall>();
+  // SAFE calls return NULL instead of an error, which a scan cannot do once
+  // it has produced rows.
+  if (!function_call->function()->IsZetaSQLBuiltin() ||
+      function_call->error_mode() != ResolvedFunctionCall::DEFAULT_ERROR_MODE) {
+    return nullptr;
+  }
+  switch (function_call->signature().context_id()) {
+    case FN_GENERATE_ARRAY_INT64:
+    case FN_GENERATE_ARRAY_UINT64:
+    case FN_GENERATE_ARRAY_NUMERIC:
+    case FN_GENERATE_ARRAY_BIGNUMERIC:
+    case FN_GENERATE_ARRAY_DOUBLE:
+    case FN_GENERATE_DATE_ARRAY:
+    case FN_GENERATE_TIMESTAMP_ARRAY:
+      break;
+    default:
+      return nullptr;
+  }
+  const Type* element_type = function_call->type()->AsArray()->element_type();
+  if (!GenerateArrayScanOp::SupportsElementType(element_type)) {
+    return nullptr;
+  }
+
+  std::vector<std::unique_ptr<ValueExpr>> arguments;
+  arguments.reserve(function_call->argument_list_size());
+  for (const std::unique_ptr<const ResolvedExpr>& argument :
+       function_call->argument_list()) {
+    ZETASQL_ASSIGN_OR_RETURN(arguments.emplace_back(),
+                     AlgebrizeExpression(argument.get()));
+  }
+  const VariableId element = column_to_variable_->GetVariableNameFromColumn(
+      array_scan->element_column_list(0));
+  VariableId position;
+  if (array_scan->array_offset_column() != nullptr) {
+    position = column_to_variable_->GetVariableNameFromColumn(
+        array_scan->array_offset_column()->column());
+  }
+  return GenerateArrayScanOp::Create(element, position, element_type,
+                                     std::move(arguments));
+}
+
 absl::StatusOr<std::unique_ptr<RelationalOp>>
 Algebrizer::AlgebrizeLimitOffsetScan(const ResolvedLimitOffsetScan* scan) {
   ZETASQL_RET_CHECK(scan->limit() != nullptr);
@@ -3019,6 +3801,124 @@ absl::Status Algebrizer::AddFilterConjunctsTo(
   return absl::OkStatus();
 }
 
+namespace {
+
+// The fraction of its input rows that a filter conjunct is assumed to keep
+// when estimating row counts.
+constexpr double kDefaultFilterSelectivity = 0.25;
+
+// Returns an estimate of the number of rows produced by 'scan', based on the
+// Table::GetRowCountEstimate() of the tables it scans, or nullopt if there is
+// none. Only used to pick the build side of inner hash joins, so it only
+// needs to be good enough to tell a big input from a small one.
+std::optional<double> EstimateRowCount(const ResolvedScan* scan) {
+  switch (scan->node_kind()) {
+    case RESOLVED_TABLE_SCAN: {
+      const std::optional<int64_t> estimate =
+          scan->GetAs<ResolvedTableScan>()->table()->GetRowCountEstimate();
+      if (!estimate.has_value()) return std::nullopt;
+      return static_cast<double>(*estimate);
+    }
+    case RESOLVED_SINGLE_ROW_SCAN:
+      return 1;
+    case RESOLVED_FILTER_SCAN: {
+      const std::optional<double> input_estimate =
+          EstimateRowCount(scan->GetAs<ResolvedFilterScan>()->input_scan());
+      if (!input_estimate.has_value()) return std::nullopt;
+      return *input_estimate * kDefaultFilterSelectivity;
+    }
+    case RESOLVED_PROJECT_SCAN:
+      return EstimateRowCount(scan->GetAs<ResolvedProjectScan>()->input_scan());
+    case RESOLVED_ORDER_BY_SCAN:
+      return EstimateRowCount(scan->GetAs<ResolvedOrderByScan>()->input_scan());
+    case RESOLVED_ANALYTIC_SCAN:
+      return EstimateRowCount(
+          scan->GetAs<ResolvedAnalyticScan>()->input_scan());
+    case RESOLVED_AGGREGATE_SCAN: {
+      const auto* aggregate_scan = scan->GetAs<ResolvedAggregateScan>();
+      if (aggregate_scan->group_by_list().empty() &&
+          aggregate_scan->grouping_set_list().empty()) {
+        return 1;
+      }
+      // Grouping can only reduce the number of rows.
+      return EstimateRowCount(aggregate_scan->input_scan());
+    }
+    case RESOLVED_LIMIT_OFFSET_SCAN: {
+      const auto* limit_scan = scan->GetAs<ResolvedLimitOffsetScan>();
+      const std::optional<double> input_estimate =
+          EstimateRowCount(limit_scan->input_scan());
+      if (limit_scan->limit() != nullptr &&
+          limit_scan->limit()->Is<ResolvedLiteral>()) {
+        const Value& limit =
+            limit_scan->limit()->GetAs<ResolvedLiteral>()->value();
+        if (limit.type()->IsInt64() && !limit.is_null()) {
+          const double limit_rows = static_cast<double>(limit.int64_value());
+          return input_estimate.has_value()
+                     ? std::min(*input_estimate, limit_rows)
+                     : limit_rows;
+        }
+      }
+      return input_estimate;
+    }
+    case RESOLVED_JOIN_SCAN: {
+      const auto* join_scan = scan->GetAs<ResolvedJoinScan>();
+      const std::optional<double> left_estimate =
+          EstimateRowCount(join_scan->left_scan());
+      const std::optional<double> right_estimate =
+          EstimateRowCount(join_scan->right_scan());
+      if (!left_estimate.has_value() || !right_estimate.has_value()) {
+        return std::nullopt;
+      }
+      if (join_scan->join_expr() == nullptr) {
+        return *left_estimate * *right_estimate;
+      }
+      // Assume the join condition matches each row with about one row of the
+      // other input.
+      return std::max(*left_estimate, *right_estimate);
+    }
+    default:
+      return std::nullopt;
+  }
+}
+
+// Returns true if 'column' is produced by a ResolvedTableScan in 'scan' whose
+// rows reach the output of 'scan' only through filters, projections, sorts
+// and the non-NULL-extended sides of joins. Dropping the rows of the table
+// scan with some value of 'column' then only drops the output rows of 'scan'
+// with that value.
+bool IsRowPreservingTableScanColumn(const ResolvedScan* scan,
+                                    const ResolvedColumn& column) {
+  switch (scan->node_kind()) {
+    case RESOLVED_TABLE_SCAN:
+      return absl::c_linear_search(scan->column_list(), column);
+    case RESOLVED_FILTER_SCAN:
+      return IsRowPreservingTableScanColumn(
+          scan->GetAs<ResolvedFilterScan>()->input_scan(), column);
+    case RESOLVED_PROJECT_SCAN:
+      return IsRowPreservingTableScanColumn(
+          scan->GetAs<ResolvedProjectScan>()->input_scan(), column);
+    case RESOLVED_ORDER_BY_SCAN:
+      return IsRowPreservingTableScanColumn(
+          scan->GetAs<ResolvedOrderByScan>()->input_scan(), column);
+    case RESOLVED_JOIN_SCAN: {
+      const auto* join_scan = scan->GetAs<ResolvedJoinScan>();
+      const ResolvedJoinScan::JoinType join_type = join_scan->join_type();
+      if ((join_type == ResolvedJoinScan::INNER ||
+           join_type == ResolvedJoinScan::LEFT) &&
+          IsRowPreservingTableScanColumn(join_scan->left_scan(), column)) {
+        return true;
+      }
+      return (join_type == ResolvedJoinScan::INNER ||
+              join_type == ResolvedJoinScan::RIGHT) &&
+             IsRowPreservingTableScanColumn(join_scan->right_scan(), column);
+    }
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
 absl::StatusOr<std::unique_ptr<RelationalOp>> Algebrizer::AlgebrizeJoinScan(
     const ResolvedJoinScan* join_scan,
     std::vector<FilterConjunctInfo*>* active_conjuncts) {
@@ -3045,7 +3945,127 @@ absl::StatusOr<std::unique_ptr<RelationalOp>> Algebrizer::AlgebrizeJoinScan(
       };
   return AlgebrizeJoinScanInternal(
       join_kind, join_scan->join_expr(), join_scan->left_scan(),
-      right_scan->column_list(), right_scan_algebrizer_cb, active_conjuncts);
+      right_scan->column_list(), right_scan_algebrizer_cb, active_conjuncts,
+      right_scan);
+}
+
+// Returns true if Value::LessThan() orders non-NULL values of 'type' like
+// SQL comparisons, so that the RangeJoinExprs of a BETWEEN can index them and
+// a merge join can compare them.
+static bool LessThanMatchesSqlOrder(const Type* type) {
+  switch (type->kind()) {
+    case TYPE_INT32:
+    case TYPE_INT64:
+    case TYPE_UINT32:
+    case TYPE_UINT64:
+    case TYPE_BOOL:
+    case TYPE_STRING:
+    case TYPE_BYTES:
+    case TYPE_DATE:
+    case TYPE_TIMESTAMP:
+    case TYPE_DATETIME:
+    case TYPE_TIME:
+    case TYPE_NUMERIC:
+    case TYPE_BIGNUMERIC:
+      return true;
+    default:
+      // Floating point types are excluded because of NaN and signed zeros.
+      return false;
+  }
+}
+
+// Returns the ordering for a merge join of 'left' and 'right' on
+// 'hash_join_equality_exprs', or std::nullopt if the inputs are not known to
+// be sorted on the join keys in the same directions. On success,
+// 'hash_join_equality_exprs' are reordered to follow the ordering.
+static std::optional<std::vector<RelationalProperties::OrderingKey>>
+GetMergeJoinOrdering(
+    const RelationalOp& left, const RelationalOp& right,
+    std::vector<JoinOp::HashJoinEqualityExprs>* hash_join_equality_exprs) {
+  const RelationalProperties left_properties = left.DeriveProperties();
+  const RelationalProperties right_properties = right.DeriveProperties();
+  const int num_keys = hash_join_equality_exprs->size();
+  if (num_keys == 0 || left_properties.ordering.size() < num_keys ||
+      right_properties.ordering.size() < num_keys) {
+    return std::nullopt;
+  }
+  std::vector<RelationalProperties::OrderingKey> ordering;
+  std::vector<int> permutation;
+  std::vector<bool> used(num_keys, false);
+  for (int i = 0; i < num_keys; ++i) {
+    const RelationalProperties::OrderingKey& left_key =
+        left_properties.ordering[i];
+    const RelationalProperties::OrderingKey& right_key =
+        right_properties.ordering[i];
+    if (left_key.descending != right_key.descending ||
+        left_key.nulls_first != right_key.nulls_first) {
+      return std::nullopt;
+    }
+    int match = -1;
+    for (int j = 0; j < num_keys && match < 0; ++j) {
+      if (used[j]) continue;
+      const ExprArg& left_expr = *(*hash_join_equality_exprs)[j].left_expr;
+      const ExprArg& right_expr = *(*hash_join_equality_exprs)[j].right_expr;
+      const auto* left_deref =
+          dynamic_cast<const DerefExpr*>(left_expr.value_expr());
+      const auto* right_deref =
+          dynamic_cast<const DerefExpr*>(right_expr.value_expr());
+      if (left_deref != nullptr && right_deref != nullptr &&
+          left_deref->name() == left_key.variable &&
+          right_deref->name() == right_key.variable &&
+          left_expr.type()->Equals(right_expr.type()) &&
+          LessThanMatchesSqlOrder(left_expr.type())) {
+        match = j;
+      }
+    }
+    if (match < 0) return std::nullopt;
+    used[match] = true;
+    permutation.push_back(match);
+    ordering.push_back(left_key);
+  }
+
+  std::vector<JoinOp::HashJoinEqualityExprs> reordered;
+  reordered.reserve(num_keys);
+  for (int j : permutation) {
+    reordered.push_back(std::move((*hash_join_equality_exprs)[j]));
+  }
+  *hash_join_equality_exprs = std::move(reordered);
+  return ordering;
+}
+
+absl::StatusOr<std::vector<JoinOp::JoinKeyFilterSpec>>
+Algebrizer::AddJoinKeyFilters(
+    JoinOp::JoinKind join_kind, const ResolvedScan* probe_scan,
+    absl::Span<const JoinOp::HashJoinEqualityExprs> hash_join_equality_exprs) {
+  std::vector<JoinOp::JoinKeyFilterSpec> specs;
+  // Left tuples that match no right tuple only contribute to the output of
+  // left outer, full outer and anti joins.
+  if (join_kind != JoinOp::kInnerJoin && join_kind != JoinOp::kSemiJoin &&
+      join_kind != JoinOp::kRightOuterJoin) {
+    return specs;
+  }
+  for (int i = 0; i < hash_join_equality_exprs.size(); ++i) {
+    const ExprArg& left_expr = *hash_join_equality_exprs[i].left_expr;
+    const ExprArg& right_expr = *hash_join_equality_exprs[i].right_expr;
+    // Equalities between different types (e.g., INT64 = UINT64) and
+    // collated equalities, whose keys are not column references, are skipped.
+    if (!left_expr.type()->Equals(right_expr.type()) ||
+        !JoinKeyFilter::SupportsType(left_expr.type())) {
+      continue;
+    }
+    const auto* deref = dynamic_cast<const DerefExpr*>(left_expr.value_expr());
+    if (deref == nullptr) continue;
+    const auto it = table_scan_variables_.find(deref->name());
+    if (it == table_scan_variables_.end() || it->second.scan == nullptr ||
+        !IsRowPreservingTableScanColumn(probe_scan, it->second.column)) {
+      continue;
+    }
+    const int filter_id = next_join_key_filter_id_++;
+    ZETASQL_RETURN_IF_ERROR(
+        it->second.scan->AddJoinKeyFilter(filter_id, deref->name()));
+    specs.push_back({.equality_index = i, .filter_id = filter_id});
+  }
+  return specs;
 }
 
 absl::StatusOr<std::unique_ptr<RelationalOp>>
@@ -3054,7 +4074,8 @@ Algebrizer::AlgebrizeJoinScanInternal(
     const ResolvedScan* left_scan,
     const std::vector<ResolvedColumn>& right_output_column_list,
     const ScanAlgebrizerCallback& right_scan_algebrizer_cb,
-    std::vector<FilterConjunctInfo*>* active_conjuncts) {
+    std::vector<FilterConjunctInfo*>* active_conjuncts,
+    const ResolvedScan* right_scan) {
   std::vector<std::unique_ptr<FilterConjunctInfo>> conjunct_infos;
   if (join_expr != nullptr) {
     ZETASQL_RETURN_IF_ERROR(AddFilterConjunctsTo(join_expr, &conjunct_infos));
@@ -3160,6 +4181,39 @@ Algebrizer::AlgebrizeJoinScanInternal(
     info->redundant = true;
   }
 
+  // JoinOp builds its hash table (or range index) on the right input. For
+  // inner joins, which are symmetric, swap the inputs if the left one is
+  // estimated to be smaller, taking the conjuncts pushed down into each input
+  // into account. The outputs of an inner join are not NULL-extended, so
+  // only the inputs and the columns used to split the join condition change.
+  bool swap_join_inputs = false;
+  if (algebrizer_options_.use_row_count_estimates &&
+      join_kind == JoinOp::kInnerJoin && right_scan != nullptr) {
+    const std::optional<double> left_row_count_estimate =
+        EstimateRowCount(left_scan);
+    const std::optional<double> right_row_count_estimate =
+        EstimateRowCount(right_scan);
+    if (left_row_count_estimate.has_value() &&
+        right_row_count_estimate.has_value()) {
+      const double left_rows =
+          *left_row_count_estimate *
+          std::pow(kDefaultFilterSelectivity,
+                   left_conjuncts_with_push_down.size());
+      const double right_rows =
+          *right_row_count_estimate *
+          std::pow(kDefaultFilterSelectivity,
+                   right_conjuncts_with_push_down.size());
+      swap_join_inputs = left_rows < right_rows;
+    }
+  }
+  if (swap_join_inputs) {
+    std::swap(left, right);
+  }
+  const absl::flat_hash_set<ResolvedColumn>& join_left_columns =
+      swap_join_inputs ? right_output_columns : left_output_columns;
+  const absl::flat_hash_set<ResolvedColumn>& join_right_columns =
+      swap_join_inputs ? left_output_columns : right_output_columns;
+
   // Incorporate conjuncts into the hash join where allowed/possible.
   std::vector<JoinOp::HashJoinEqualityExprs> hash_join_equality_exprs;
   if (algebrizer_options_.allow_hash_join) {
@@ -3168,8 +4222,11 @@ Algebrizer::AlgebrizeJoinScanInternal(
       case JoinOp::kLeftOuterJoin:
       case JoinOp::kRightOuterJoin:
       case JoinOp::kFullOuterJoin:
+      case JoinOp::kSemiJoin:
+      case JoinOp::kAntiJoin:
+      case JoinOp::kNullAwareAntiJoin:
         ZETASQL_RETURN_IF_ERROR(AlgebrizeJoinConditionForHashJoin(
-            left_output_columns, right_output_columns,
+            join_left_columns, join_right_columns,
             &join_condition_conjuncts_with_push_down,
             &hash_join_equality_exprs));
         break;
@@ -3180,6 +4237,29 @@ Algebrizer::AlgebrizeJoinScanInternal(
     }
   }
 
+  // Without hash join equalities, index the right side by range if possible.
+  std::optional<JoinOp::RangeJoinExprs> range_join_exprs;
+  if (algebrizer_options_.allow_range_join &&
+      hash_join_equality_exprs.empty()) {
+    switch (join_kind) {
+      case JoinOp::kInnerJoin:
+      case JoinOp::kLeftOuterJoin:
+      case JoinOp::kRightOuterJoin:
+      case JoinOp::kFullOuterJoin:
+      case JoinOp::kSemiJoin:
+      case JoinOp::kAntiJoin:
+        ZETASQL_ASSIGN_OR_RETURN(range_join_exprs,
+                         AlgebrizeJoinConditionForRangeJoin(
+                             join_left_columns, join_right_columns,
+                             join_condition_conjuncts_with_push_down));
+        break;
+      case JoinOp::kNullAwareAntiJoin:
+      case JoinOp::kCrossApply:
+      case JoinOp::kOuterApply:
+        break;
+    }
+  }
+
   // Algebrize all of the non-redundant remaining conjuncts for use in the join
   // condition. Iterate in reverse order to de-stackify the ordering.
   std::vector<std::unique_ptr<ValueExpr>> algebrized_conjuncts;
@@ -3214,6 +4294,9 @@ Algebrizer::AlgebrizeJoinScanInternal(
   switch (join_kind) {
     case JoinOp::kInnerJoin:
     case JoinOp::kCrossApply:
+    case JoinOp::kSemiJoin:
+    case JoinOp::kAntiJoin:
+    case JoinOp::kNullAwareAntiJoin:
       // no NULL-extension of left or right input
       break;
     case JoinOp::kLeftOuterJoin:
@@ -3231,13 +4314,40 @@ Algebrizer::AlgebrizeJoinScanInternal(
       break;
   }
 
+  // Merge the inputs instead of hashing the right one if both are already
+  // sorted on the join keys.
+  std::optional<std::vector<RelationalProperties::OrderingKey>>
+      merge_join_ordering;
+  if (algebrizer_options_.allow_merge_join &&
+      join_kind != JoinOp::kNullAwareAntiJoin) {
+    merge_join_ordering =
+        GetMergeJoinOrdering(*left, *right, &hash_join_equality_exprs);
+  }
+
+  // Let the hash table filter the table scans of the probe (left) input.
+  std::vector<JoinOp::JoinKeyFilterSpec> join_key_filters;
+  const ResolvedScan* probe_scan = swap_join_inputs ? right_scan : left_scan;
+  if (algebrizer_options_.use_join_key_filters && probe_scan != nullptr &&
+      !merge_join_ordering.has_value()) {
+    ZETASQL_ASSIGN_OR_RETURN(join_key_filters,
+                     AddJoinKeyFilters(join_kind, probe_scan,
+                                       hash_join_equality_exprs));
+  }
+
   // Algebrize the join.
   ZETASQL_ASSIGN_OR_RETURN(
-      std::unique_ptr<RelationalOp> join_op,
+      std::unique_ptr<JoinOp> join_op,
       JoinOp::Create(join_kind, std::move(hash_join_equality_exprs),
                      std::move(remaining_join_expr), std::move(left),
                      std::move(right), std::move(left_output),
-                     std::move(right_output)));
+                     std::move(right_output), std::move(range_join_exprs)));
+  if (!join_key_filters.empty()) {
+    ZETASQL_RETURN_IF_ERROR(join_op->SetJoinKeyFilters(std::move(join_key_filters)));
+  }
+  if (merge_join_ordering.has_value()) {
+    ZETASQL_RETURN_IF_ERROR(
+        join_op->SetMergeJoinOrdering(std::move(merge_join_ordering).value()));
+  }
 
   return join_op;
 }
@@ -3270,7 +4380,10 @@ absl::Status Algebrizer::NarrowJoinKindForFilterConjunct(
   switch (*join_kind) {
     case JoinOp::kInnerJoin:
     case JoinOp::kCrossApply:
-      // Handled above.
+    case JoinOp::kSemiJoin:
+    case JoinOp::kAntiJoin:
+    case JoinOp::kNullAwareAntiJoin:
+      // Handled above, or not introduced for join scans.
       ZETASQL_RET_CHECK_FAIL()
           << "Unexpected join kind in TightenJoinKindForFilterConjunct(): "
           << JoinOp::JoinKindToString(*join_kind);
@@ -3360,6 +4473,11 @@ absl::Status Algebrizer::CanPushFilterConjunctIntoJoin(
     case JoinOp::kFullOuterJoin:
       // Analogous to left/right outer join.
       return absl::OkStatus();
+    case JoinOp::kSemiJoin:
+    case JoinOp::kAntiJoin:
+    case JoinOp::kNullAwareAntiJoin:
+      // Not introduced for join scans (see GetSemiJoinInfo()).
+      return absl::OkStatus();
   }
 }
 
@@ -3467,6 +4585,128 @@ Algebrizer::TryAlgebrizeFilterConjunctAsHashJoinEqualityExprs(
 
   return true;
 }
+
+absl::StatusOr<std::optional<JoinOp::RangeJoinExprs>>
+Algebrizer::AlgebrizeJoinConditionForRangeJoin(
+    const absl::flat_hash_set<ResolvedColumn>& left_output_columns,
+    const absl::flat_hash_set<ResolvedColumn>& right_output_columns,
+    absl::Span<FilterConjunctInfo* const> conjuncts_with_push_down) {
+  for (auto i = conjuncts_with_push_down.rbegin();
+       i != conjuncts_with_push_down.rend(); ++i) {
+    const FilterConjunctInfo* conjunct_info = *i;
+    ZETASQL_RET_CHECK(!conjunct_info->redundant);
+    if (!conjunct_info->is_non_volatile ||
+        conjunct_info->conjunct->node_kind() != RESOLVED_FUNCTION_CALL) {
+      continue;
+    }
+    const ResolvedFunctionCall* function_call =
+        conjunct_info->conjunct->GetAs<ResolvedFunctionCall>();
+    if (!function_call->function()->IsZetaSQLBuiltin()) continue;
+    switch (function_call->signature().context_id()) {
+      case FN_RANGE_OVERLAPS:
+      case FN_RANGE_CONTAINS_RANGE:
+      case FN_RANGE_CONTAINS_ELEMENT:
+        break;
+      case FN_BETWEEN: {
+        ZETASQL_ASSIGN_OR_RETURN(
+            std::optional<JoinOp::RangeJoinExprs> range_join_exprs,
+            TryAlgebrizeBetweenForRangeJoin(*conjunct_info, left_output_columns,
+                                            right_output_columns));
+        if (range_join_exprs.has_value()) return range_join_exprs;
+        continue;
+      }
+      default:
+        continue;
+    }
+
+    ZETASQL_RET_CHECK_EQ(conjunct_info->arguments.size(), 2);
+    const ResolvedExpr* left_arg = conjunct_info->arguments[0];
+    const ResolvedExpr* right_arg = conjunct_info->arguments[1];
+    if (IsSubsetOf(conjunct_info->argument_columns[0], right_output_columns) &&
+        IsSubsetOf(conjunct_info->argument_columns[1], left_output_columns)) {
+      std::swap(left_arg, right_arg);
+    } else if (!IsSubsetOf(conjunct_info->argument_columns[0],
+                           left_output_columns) ||
+               !IsSubsetOf(conjunct_info->argument_columns[1],
+                           right_output_columns)) {
+      continue;
+    }
+
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ValueExpr> algebrized_left_arg,
+                     AlgebrizeExpression(left_arg));
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ValueExpr> algebrized_right_arg,
+                     AlgebrizeExpression(right_arg));
+    JoinOp::RangeJoinExprs range_join_exprs;
+    range_join_exprs.left_expr = std::make_unique<ExprArg>(
+        variable_gen_->GetNewVariableName("r1"),
+        std::move(algebrized_left_arg));
+    range_join_exprs.right_expr = std::make_unique<ExprArg>(
+        variable_gen_->GetNewVariableName("r2"),
+        std::move(algebrized_right_arg));
+    return range_join_exprs;
+  }
+  return std::nullopt;
+}
+
+absl::StatusOr<std::optional<JoinOp::RangeJoinExprs>>
+Algebrizer::TryAlgebrizeBetweenForRangeJoin(
+    const FilterConjunctInfo& conjunct_info,
+    const absl::flat_hash_set<ResolvedColumn>& left_output_columns,
+    const absl::flat_hash_set<ResolvedColumn>& right_output_columns) {
+  const ResolvedFunctionCall* function_call =
+      conjunct_info.conjunct->GetAs<ResolvedFunctionCall>();
+  ZETASQL_RET_CHECK_EQ(conjunct_info.arguments.size(), 3);
+  // A collated BETWEEN compares collation keys instead of the values.
+  if (!function_call->collation_list().empty()) return std::nullopt;
+  const Type* type = conjunct_info.arguments[0]->type();
+  for (const ResolvedExpr* argument : conjunct_info.arguments) {
+    if (!argument->type()->Equals(type)) return std::nullopt;
+  }
+  if (!LessThanMatchesSqlOrder(type)) return std::nullopt;
+
+  // The element must come from one side and both bounds from the other, and
+  // neither may be constant.
+  const absl::flat_hash_set<ResolvedColumn>& element_columns =
+      conjunct_info.argument_columns[0];
+  if (element_columns.empty() || (conjunct_info.argument_columns[1].empty() &&
+                                  conjunct_info.argument_columns[2].empty())) {
+    return std::nullopt;
+  }
+  const bool bounds_on_left =
+      IsSubsetOf(conjunct_info.argument_columns[1], left_output_columns) &&
+      IsSubsetOf(conjunct_info.argument_columns[2], left_output_columns) &&
+      IsSubsetOf(element_columns, right_output_columns);
+  const bool bounds_on_right =
+      IsSubsetOf(conjunct_info.argument_columns[1], right_output_columns) &&
+      IsSubsetOf(conjunct_info.argument_columns[2], right_output_columns) &&
+      IsSubsetOf(element_columns, left_output_columns);
+  if (!bounds_on_left && !bounds_on_right) return std::nullopt;
+
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ValueExpr> element,
+                   AlgebrizeExpression(conjunct_info.arguments[0]));
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ValueExpr> lower_bound,
+                   AlgebrizeExpression(conjunct_info.arguments[1]));
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ValueExpr> upper_bound,
+                   AlgebrizeExpression(conjunct_info.arguments[2]));
+  auto element_arg = std::make_unique<ExprArg>(
+      variable_gen_->GetNewVariableName("r1"), std::move(element));
+  auto lower_bound_arg = std::make_unique<ExprArg>(
+      variable_gen_->GetNewVariableName("r2"), std::move(lower_bound));
+  auto upper_bound_arg = std::make_unique<ExprArg>(
+      variable_gen_->GetNewVariableName("r3"), std::move(upper_bound));
+  JoinOp::RangeJoinExprs range_join_exprs;
+  if (bounds_on_right) {
+    range_join_exprs.left_expr = std::move(element_arg);
+    range_join_exprs.right_expr = std::move(lower_bound_arg);
+    range_join_exprs.right_upper_bound_expr = std::move(upper_bound_arg);
+  } else {
+    range_join_exprs.left_expr = std::move(lower_bound_arg);
+    range_join_exprs.left_upper_bound_expr = std::move(upper_bound_arg);
+    range_join_exprs.right_expr = std::move(element_arg);
+  }
+  return range_join_exprs;
+}
+
 absl::Status Algebrizer::RemapJoinColumns(
     const ResolvedColumnList& columns,
     std::vector<std::unique_ptr<ExprArg>>* output) {
@@ -3495,6 +4735,22 @@ Algebrizer::AlgebrizeFilterScanInternal(
   ZETASQL_RET_CHECK(filter_expr != nullptr);
   std::vector<std::unique_ptr<FilterConjunctInfo>> conjunct_infos;
   ZETASQL_RETURN_IF_ERROR(AddFilterConjunctsTo(filter_expr, &conjunct_infos));
+  // Set aside the conjuncts that become semi joins or anti joins. They are
+  // applied on top of the filter, so they must not be pushed down.
+  std::vector<SemiJoinInfo> semi_joins;
+  if (algebrizer_options_.allow_semi_join) {
+    std::vector<std::unique_ptr<FilterConjunctInfo>> other_conjunct_infos;
+    for (std::unique_ptr<FilterConjunctInfo>& info : conjunct_infos) {
+      ZETASQL_ASSIGN_OR_RETURN(std::optional<SemiJoinInfo> semi_join,
+                       GetSemiJoinInfo(info->conjunct));
+      if (semi_join.has_value()) {
+        semi_joins.push_back(std::move(semi_join).value());
+      } else {
+        other_conjunct_infos.push_back(std::move(info));
+      }
+    }
+    conjunct_infos = std::move(other_conjunct_infos);
+  }
   // Push the new conjuncts onto 'active_conjuncts' in reverse order (because
   // it's a stack).
   for (auto i = conjunct_infos.rbegin(); i != conjunct_infos.rend(); ++i) {
@@ -3522,8 +4778,13 @@ Algebrizer::AlgebrizeFilterScanInternal(
   }
 
   // Algebrize the filter.
-  return ApplyAlgebrizedFilterConjuncts(std::move(input),
-                                        std::move(algebrized_conjuncts));
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<RelationalOp> rel_op,
+                   ApplyAlgebrizedFilterConjuncts(
+                       std::move(input), std::move(algebrized_conjuncts)));
+  for (const SemiJoinInfo& semi_join : semi_joins) {
+    ZETASQL_ASSIGN_OR_RETURN(rel_op, AlgebrizeSemiJoin(semi_join, std::move(rel_op)));
+  }
+  return rel_op;
 }
 
 absl::StatusOr<std::unique_ptr<RelationalOp>> Algebrizer::AlgebrizeFilterScan(
@@ -3539,6 +4800,219 @@ absl::StatusOr<std::unique_ptr<RelationalOp>> Algebrizer::AlgebrizeFilterScan(
                                      active_conjuncts);
 }
 
+absl::StatusOr<std::optional<Algebrizer::SemiJoinInfo>>
+Algebrizer::GetSemiJoinInfo(const ResolvedExpr* conjunct) {
+  bool negated = false;
+  if (conjunct->node_kind() == RESOLVED_FUNCTION_CALL) {
+    const ResolvedFunctionCall* function_call =
+        conjunct->GetAs<ResolvedFunctionCall>();
+    if (!function_call->function()->IsZetaSQLBuiltin() ||
+        function_call->function()->FullName(/*include_group=*/false) !=
+            "$not") {
+      return std::nullopt;
+    }
+    ZETASQL_RET_CHECK_EQ(function_call->argument_list_size(), 1);
+    negated = true;
+    conjunct = function_call->argument_list(0);
+  }
+  if (conjunct->node_kind() != RESOLVED_SUBQUERY_EXPR) return std::nullopt;
+  const ResolvedSubqueryExpr* subquery_expr =
+      conjunct->GetAs<ResolvedSubqueryExpr>();
+
+  // The right-hand side of the join is evaluated once instead of once per row,
+  // which requires the same conditions as memoizing the subquery.
+  ZETASQL_ASSIGN_OR_RETURN(const bool memoizable,
+                   IsMemoizableSubquery(subquery_expr));
+  if (!memoizable) return std::nullopt;
+
+  SemiJoinInfo info;
+  info.subquery_expr = subquery_expr;
+  switch (subquery_expr->subquery_type()) {
+    case ResolvedSubqueryExpr::IN: {
+      if (!subquery_expr->parameter_list().empty() ||
+          !subquery_expr->in_collation().Empty()) {
+        return std::nullopt;
+      }
+      const ResolvedScan* scan = subquery_expr->subquery();
+      ZETASQL_RET_CHECK_EQ(scan->column_list_size(), 1);
+      const Type* haystack_type = scan->column_list(0).type();
+      // The hash join requires equal types. Arrays are not hashed for SQL
+      // equality, and a struct compares as NULL to another struct only if
+      // no other field differs, which the null-aware anti join cannot tell.
+      if (!subquery_expr->in_expr()->type()->Equals(haystack_type) ||
+          haystack_type->IsArray() || (negated && haystack_type->IsStruct())) {
+        return std::nullopt;
+      }
+      info.kind = negated ? JoinOp::kNullAwareAntiJoin : JoinOp::kSemiJoin;
+      info.right_scan = scan;
+      return info;
+    }
+    case ResolvedSubqueryExpr::EXISTS: {
+      // Uncorrelated EXISTS subqueries are memoized instead.
+      if (subquery_expr->parameter_list().empty()) return std::nullopt;
+      const ResolvedScan* scan = subquery_expr->subquery();
+      // The select list of an EXISTS subquery does not matter.
+      if (scan->node_kind() == RESOLVED_PROJECT_SCAN) {
+        scan = scan->GetAs<ResolvedProjectScan>()->input_scan();
+      }
+      if (scan->node_kind() != RESOLVED_FILTER_SCAN) return std::nullopt;
+      const ResolvedFilterScan* filter_scan = scan->GetAs<ResolvedFilterScan>();
+
+      for (const auto& parameter : subquery_expr->parameter_list()) {
+        info.parameter_columns.insert(parameter->column());
+      }
+      ZETASQL_ASSIGN_OR_RETURN(const absl::flat_hash_set<ResolvedColumn> input_columns,
+                       GetReferencedColumns(filter_scan->input_scan()));
+      if (Intersects(input_columns, info.parameter_columns)) {
+        return std::nullopt;
+      }
+
+      std::vector<std::unique_ptr<FilterConjunctInfo>> conjunct_infos;
+      ZETASQL_RETURN_IF_ERROR(
+          AddFilterConjunctsTo(filter_scan->filter_expr(), &conjunct_infos));
+      for (const std::unique_ptr<FilterConjunctInfo>& conjunct_info :
+           conjunct_infos) {
+        if (Intersects(conjunct_info->referenced_columns,
+                       info.parameter_columns)) {
+          info.join_conjuncts.push_back(conjunct_info->conjunct);
+        } else {
+          info.right_conjuncts.push_back(conjunct_info->conjunct);
+        }
+      }
+      info.kind = negated ? JoinOp::kAntiJoin : JoinOp::kSemiJoin;
+      info.right_scan = filter_scan->input_scan();
+      return info;
+    }
+    default:
+      return std::nullopt;
+  }
+}
+
+absl::StatusOr<std::unique_ptr<RelationalOp>> Algebrizer::AlgebrizeSemiJoin(
+    const SemiJoinInfo& info, std::unique_ptr<RelationalOp> input) {
+  const ResolvedSubqueryExpr* subquery_expr = info.subquery_expr;
+  ZETASQL_RETURN_IF_ERROR(CheckHints(subquery_expr->hint_list()));
+  // As in AlgebrizeSubqueryExpr(), restore 'column_to_variable_' after
+  // algebrizing the subquery.
+  const ColumnToVariableMapping::Map original_column_to_variable =
+      column_to_variable_->map();
+
+  std::unique_ptr<RelationalOp> right;
+  std::vector<JoinOp::HashJoinEqualityExprs> hash_join_equality_exprs;
+  std::vector<std::unique_ptr<ValueExpr>> algebrized_conjuncts;
+  if (subquery_expr->subquery_type() == ResolvedSubqueryExpr::IN) {
+    ZETASQL_ASSIGN_OR_RETURN(right, AlgebrizeScan(info.right_scan));
+    const ResolvedColumn& haystack_column = info.right_scan->column_list(0);
+    ZETASQL_ASSIGN_OR_RETURN(
+        std::unique_ptr<ValueExpr> haystack,
+        DerefExpr::Create(
+            column_to_variable_->GetVariableNameFromColumn(haystack_column),
+            haystack_column.type()));
+    // The IN expression cannot reference columns produced by the subquery.
+    column_to_variable_->set_map(original_column_to_variable);
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ValueExpr> in_value,
+                     AlgebrizeExpression(subquery_expr->in_expr()));
+    JoinOp::HashJoinEqualityExprs equality_exprs;
+    equality_exprs.left_expr = std::make_unique<ExprArg>(
+        variable_gen_->GetNewVariableName("a1"), std::move(in_value));
+    equality_exprs.right_expr = std::make_unique<ExprArg>(
+        variable_gen_->GetNewVariableName("b1"), std::move(haystack));
+    hash_join_equality_exprs.push_back(std::move(equality_exprs));
+  } else {
+    const ResolvedScan* subquery = subquery_expr->subquery();
+    if (subquery->node_kind() == RESOLVED_PROJECT_SCAN) {
+      // Dummy accesses for CheckFieldsAccessed(); the select list of an
+      // EXISTS subquery has no effect.
+      const ResolvedProjectScan* project_scan =
+          subquery->GetAs<ResolvedProjectScan>();
+      ZETASQL_RETURN_IF_ERROR(CheckHints(project_scan->hint_list()));
+      project_scan->column_list();
+      for (const auto& computed_column : project_scan->expr_list()) {
+        computed_column->MarkFieldsAccessed();
+      }
+      subquery = project_scan->input_scan();
+    }
+    ZETASQL_RET_CHECK_EQ(subquery->node_kind(), RESOLVED_FILTER_SCAN);
+    ZETASQL_RETURN_IF_ERROR(CheckHints(subquery->hint_list()));
+    subquery->column_list();
+
+    // Algebrize the right-hand side, pushing down the uncorrelated conjuncts
+    // as in AlgebrizeFilterScanInternal().
+    std::vector<std::unique_ptr<FilterConjunctInfo>> right_conjunct_infos;
+    for (const ResolvedExpr* conjunct : info.right_conjuncts) {
+      ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<FilterConjunctInfo> conjunct_info,
+                       FilterConjunctInfo::Create(conjunct));
+      right_conjunct_infos.push_back(std::move(conjunct_info));
+    }
+    std::vector<FilterConjunctInfo*> active_conjuncts;
+    for (auto i = right_conjunct_infos.rbegin();
+         i != right_conjunct_infos.rend(); ++i) {
+      active_conjuncts.push_back(i->get());
+    }
+    ZETASQL_ASSIGN_OR_RETURN(right, AlgebrizeScan(info.right_scan, &active_conjuncts));
+    std::vector<std::unique_ptr<ValueExpr>> algebrized_right_conjuncts;
+    for (const std::unique_ptr<FilterConjunctInfo>& conjunct_info :
+         right_conjunct_infos) {
+      if (!conjunct_info->redundant) {
+        ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ValueExpr> algebrized_conjunct,
+                         AlgebrizeExpression(conjunct_info->conjunct));
+        algebrized_right_conjuncts.push_back(std::move(algebrized_conjunct));
+      }
+    }
+    ZETASQL_ASSIGN_OR_RETURN(
+        right, ApplyAlgebrizedFilterConjuncts(
+                   std::move(right), std::move(algebrized_right_conjuncts)));
+
+    // The correlated conjuncts form the join condition. Equalities between
+    // the correlated parameters and the subquery become hash join keys.
+    absl::flat_hash_set<ResolvedColumn> right_columns(
+        info.right_scan->column_list().begin(),
+        info.right_scan->column_list().end());
+    for (const ResolvedExpr* conjunct : info.join_conjuncts) {
+      ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<FilterConjunctInfo> conjunct_info,
+                       FilterConjunctInfo::Create(conjunct));
+      if (algebrizer_options_.allow_hash_join) {
+        JoinOp::HashJoinEqualityExprs equality_exprs;
+        ZETASQL_ASSIGN_OR_RETURN(
+            const bool is_hash_join_equality,
+            TryAlgebrizeFilterConjunctAsHashJoinEqualityExprs(
+                *conjunct_info, info.parameter_columns, right_columns,
+                hash_join_equality_exprs.size(), &equality_exprs));
+        if (is_hash_join_equality) {
+          hash_join_equality_exprs.push_back(std::move(equality_exprs));
+          continue;
+        }
+      }
+      ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ValueExpr> algebrized_conjunct,
+                       AlgebrizeExpression(conjunct));
+      algebrized_conjuncts.push_back(std::move(algebrized_conjunct));
+    }
+    column_to_variable_->set_map(original_column_to_variable);
+  }
+
+  std::unique_ptr<ValueExpr> remaining_condition;
+  if (algebrized_conjuncts.empty()) {
+    ZETASQL_ASSIGN_OR_RETURN(remaining_condition,
+                     ConstExpr::Create(values::Bool(true)));
+  } else if (algebrized_conjuncts.size() == 1) {
+    remaining_condition = std::move(algebrized_conjuncts[0]);
+  } else {
+    ZETASQL_ASSIGN_OR_RETURN(remaining_condition,
+                     BuiltinScalarFunction::CreateCall(
+                         FunctionKind::kAnd, language_options_,
+                         types::BoolType(), std::move(algebrized_conjuncts),
+                         ResolvedFunctionCallBase::DEFAULT_ERROR_MODE));
+  }
+
+  ZETASQL_ASSIGN_OR_RETURN(
+      std::unique_ptr<RelationalOp> join_op,
+      JoinOp::Create(info.kind, std::move(hash_join_equality_exprs),
+                     std::move(remaining_condition), std::move(input),
+                     std::move(right), /*left_outputs=*/{},
+                     /*right_outputs=*/{}));
+  return join_op;
+}
+
 absl::StatusOr<std::unique_ptr<RelationalOp>>
 Algebrizer::ApplyAlgebrizedFilterConjuncts(
     std::unique_ptr<RelationalOp> input,
@@ -3597,11 +5071,12 @@ absl::StatusOr<std::unique_ptr<RelationalOp>> Algebrizer::AlgebrizeSampleScan(
              << "RESERVOIR/PERCENT is not supported";
     }
 
-    // Handle SYSTEM/PERCENT as BERNOULLI/PERCENT.
+    // Handle SYSTEM/PERCENT as block sampling where the table supports it,
+    // and otherwise as BERNOULLI/PERCENT.
     // Handle SYSTEM/ROWS as RESERVOIR/ROWS.
     if (zetasql_base::CaseEqual(method, "SYSTEM")) {
       if (unit == zetasql::ResolvedSampleScanEnums::PERCENT) {
-        return SampleScanOp::Method::kBernoulliPercent;
+        return SampleScanOp::Method::kSystemPercent;
       }
       if (unit == zetasql::ResolvedSampleScanEnums::ROWS) {
         return SampleScanOp::Method::kReservoirRows;
@@ -3621,7 +5096,8 @@ absl::StatusOr<std::unique_ptr<RelationalOp>> Algebrizer::AlgebrizeSampleScan(
   // Per spec:
   // - if the sampling method is BERNOULLI, the size must be a DOUBLE.
   // - if the sampling method is RESERVOIR, the size must be a INT64.
-  if (method == SampleScanOp::Method::kBernoulliPercent &&
+  if ((method == SampleScanOp::Method::kBernoulliPercent ||
+       method == SampleScanOp::Method::kSystemPercent) &&
       !size->output_type()->IsNumerical()) {
     return zetasql_base::InvalidArgumentErrorBuilder()
            << "Expected size to be a DOUBLE";
@@ -4043,6 +5519,51 @@ absl::StatusOr<std::unique_ptr<AggregateArg>> Algebrizer::AlgebrizeGroupingCall(
                               std::move(args));
 }
 
+namespace {
+
+// Returns the input variables that 'keys' dereference, or std::nullopt if
+// some key is not a plain column reference or has a collation, in which case
+// we cannot reason about the order of the input on it.
+std::optional<std::vector<RelationalProperties::OrderingKey>>
+GetInputOrderingForKeys(absl::Span<const std::unique_ptr<KeyArg>> keys) {
+  std::vector<RelationalProperties::OrderingKey> ordering;
+  for (const std::unique_ptr<KeyArg>& key : keys) {
+    const auto* deref = dynamic_cast<const DerefExpr*>(key->value_expr());
+    if (deref == nullptr || key->collation() != nullptr) return std::nullopt;
+    ordering.push_back(
+        RelationalProperties::OrderingKey::FromKeyArg(deref->name(), *key));
+  }
+  return ordering;
+}
+
+// Returns true if 'input' is known to produce its rows sorted on 'keys'.
+bool InputIsSortedByKeys(const RelationalOp& input,
+                         absl::Span<const std::unique_ptr<KeyArg>> keys) {
+  if (keys.empty()) return false;
+  const std::optional<std::vector<RelationalProperties::OrderingKey>>
+      ordering = GetInputOrderingForKeys(keys);
+  return ordering.has_value() &&
+         input.DeriveProperties().IsOrderedBy(ordering.value());
+}
+
+// Returns true if 'input' is known to produce the rows with equal 'keys'
+// consecutively.
+bool InputIsGroupedByKeys(const RelationalOp& input,
+                          absl::Span<const std::unique_ptr<KeyArg>> keys) {
+  if (keys.empty()) return false;
+  const std::optional<std::vector<RelationalProperties::OrderingKey>>
+      ordering = GetInputOrderingForKeys(keys);
+  if (!ordering.has_value()) return false;
+  std::vector<VariableId> variables;
+  variables.reserve(ordering->size());
+  for (const RelationalProperties::OrderingKey& key : ordering.value()) {
+    variables.push_back(key.variable);
+  }
+  return input.DeriveProperties().IsGroupedBy(variables);
+}
+
+}  // namespace
+
 absl::StatusOr<std::unique_ptr<AggregateOp>>
 Algebrizer::AlgebrizeAggregateScanBase(
     const ResolvedAggregateScanBase* aggregate_scan,
@@ -4183,8 +5704,13 @@ Algebrizer::AlgebrizeAggregateScanBase(
   }
   absl::c_sort(grouping_sets);
 
-  return AggregateOp::Create(std::move(keys), std::move(aggregators),
-                             std::move(input), grouping_sets);
+  const bool input_is_grouped_by_keys =
+      grouping_sets.empty() && InputIsGroupedByKeys(*input, keys);
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<AggregateOp> aggregate_op,
+                   AggregateOp::Create(std::move(keys), std::move(aggregators),
+                                       std::move(input), grouping_sets));
+  aggregate_op->set_input_is_grouped_by_keys(input_is_grouped_by_keys);
+  return aggregate_op;
 }
 
 namespace {
@@ -5172,9 +6698,29 @@ absl::StatusOr<std::unique_ptr<RelationalOp>> Algebrizer::AlgebrizeProjectScan(
       std::unique_ptr<RelationalOp> input,
       AlgebrizeScan(resolved_project->input_scan(), &input_active_conjuncts));
 
-  // Assign variables to the new columns and algebrize their definitions.
+  // Assign variables to the new columns and algebrize their definitions,
+  // after any common subexpressions.
   std::vector<std::unique_ptr<ExprArg>> arguments;
-  arguments.reserve(defined_columns_and_exprs.size());
+  ZETASQL_RET_CHECK(common_subexpressions_.empty());
+  if (algebrizer_options_.eliminate_common_subexpressions ||
+      algebrizer_options_.group_json_extractions) {
+    std::vector<const ResolvedExpr*> exprs;
+    exprs.reserve(defined_columns_and_exprs.size());
+    for (const auto& entry : defined_columns_and_exprs) {
+      exprs.push_back(entry.second);
+    }
+    if (algebrizer_options_.group_json_extractions) {
+      ZETASQL_ASSIGN_OR_RETURN(arguments, AlgebrizeJsonExtractions(exprs));
+    }
+    if (algebrizer_options_.eliminate_common_subexpressions) {
+      ZETASQL_ASSIGN_OR_RETURN(std::vector<std::unique_ptr<ExprArg>> cse_args,
+                       AlgebrizeCommonSubexpressions(exprs));
+      for (std::unique_ptr<ExprArg>& arg : cse_args) {
+        arguments.push_back(std::move(arg));
+      }
+    }
+  }
+  arguments.reserve(arguments.size() + defined_columns_and_exprs.size());
   for (const auto& entry : defined_columns_and_exprs) {
     const ResolvedColumn& column = entry.first;
     const ResolvedExpr* expr = entry.second;
@@ -5185,6 +6731,7 @@ absl::StatusOr<std::unique_ptr<RelationalOp>> Algebrizer::AlgebrizeProjectScan(
     arguments.push_back(
         std::make_unique<ExprArg>(variable, std::move(argument)));
   }
+  common_subexpressions_.clear();
 
   // If no columns were defined by this project then just drop it.
   if (!arguments.empty()) {
@@ -5236,9 +6783,14 @@ absl::StatusOr<std::unique_ptr<SortOp>> Algebrizer::AlgebrizeOrderByScan(
   for (const auto& arg : keys) {
     ZETASQL_RETURN_IF_ERROR(ValidateTypeSupportsOrderComparison(arg->type()));
   }
-  return SortOp::Create(std::move(keys), std::move(values), std::move(limit),
-                        std::move(offset), std::move(input), scan->is_ordered(),
-                        /*is_stable_sort=*/false);
+  const bool input_is_sorted = InputIsSortedByKeys(*input, keys);
+  ZETASQL_ASSIGN_OR_RETURN(
+      std::unique_ptr<SortOp> sort_op,
+      SortOp::Create(std::move(keys), std::move(values), std::move(limit),
+                     std::move(offset), std::move(input), scan->is_ordered(),
+                     /*is_stable_sort=*/false));
+  sort_op->set_input_is_sorted(input_is_sorted);
+  return sort_op;
 }
 
 absl::StatusOr<std::unique_ptr<AggregateOp>> Algebrizer::AlgebrizePivotScan(
@@ -5314,6 +6866,21 @@ absl::StatusOr<std::unique_ptr<AggregateOp>> Algebrizer::AlgebrizePivotScan(
         std::move(algebrized_groupby_elem)));
   }
 
+  // When the pivot values can be hashed, the AggregateOp hands each row to the
+  // aggregators of its pivot value with one lookup. Otherwise, each aggregator
+  // filters the rows of its pivot value.
+  const bool dispatch_pivot_values =
+      AggregateOp::SupportsPivotDispatch(pivot_scan->for_expr()->type());
+  std::vector<std::unique_ptr<ValueExpr>> algebrized_pivot_values;
+  std::vector<int> pivot_value_indexes;
+  if (dispatch_pivot_values) {
+    for (const auto& pivot_value : pivot_scan->pivot_value_list()) {
+      ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ValueExpr> algebrized_pivot_value,
+                       AlgebrizeExpression(pivot_value.get()));
+      algebrized_pivot_values.push_back(std::move(algebrized_pivot_value));
+    }
+  }
+
   // Generate an aggregator for each pivot-expr/pivot-value combination.
   std::vector<std::unique_ptr<AggregateArg>> aggregators;
   for (const auto& pivot_column : pivot_scan->pivot_column_list()) {
@@ -5324,24 +6891,29 @@ absl::StatusOr<std::unique_ptr<AggregateOp>> Algebrizer::AlgebrizePivotScan(
     VariableId agg_result_var =
         column_to_variable_->GetVariableNameFromColumn(pivot_column->column());
 
-    // Generate an expression which compares the FOR expr result to the pivot
-    // value, which will be used as the filter to the aggregate arg.
-    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ValueExpr> algebrized_pivot_value,
-                     AlgebrizeExpression(pivot_value));
+    std::unique_ptr<ValueExpr> algebrized_compare;
+    if (dispatch_pivot_values) {
+      pivot_value_indexes.push_back(pivot_column->pivot_value_index());
+    } else {
+      // Generate an expression which compares the FOR expr result to the
+      // pivot value, which will be used as the filter to the aggregate arg.
+      ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ValueExpr> algebrized_pivot_value,
+                       AlgebrizeExpression(pivot_value));
 
-    ZETASQL_ASSIGN_OR_RETURN(
-        std::unique_ptr<ValueExpr> algebrized_for_expr_result_ref,
-        DerefExpr::Create(for_expr_var, pivot_scan->for_expr()->type()));
+      ZETASQL_ASSIGN_OR_RETURN(
+          std::unique_ptr<ValueExpr> algebrized_for_expr_result_ref,
+          DerefExpr::Create(for_expr_var, pivot_scan->for_expr()->type()));
 
-    std::vector<std::unique_ptr<ValueExpr>> compare_fn_args;
-    compare_fn_args.push_back(std::move(algebrized_for_expr_result_ref));
-    compare_fn_args.push_back(std::move(algebrized_pivot_value));
+      std::vector<std::unique_ptr<ValueExpr>> compare_fn_args;
+      compare_fn_args.push_back(std::move(algebrized_for_expr_result_ref));
+      compare_fn_args.push_back(std::move(algebrized_pivot_value));
 
-    ZETASQL_ASSIGN_OR_RETURN(
-        std::unique_ptr<ScalarFunctionCallExpr> algebrized_compare,
-        BuiltinScalarFunction::CreateCall(
-            FunctionKind::kIsNotDistinct, language_options_,
-            type_factory_->get_bool(), std::move(compare_fn_args)));
+      ZETASQL_ASSIGN_OR_RETURN(
+          algebrized_compare,
+          BuiltinScalarFunction::CreateCall(
+              FunctionKind::kIsNotDistinct, language_options_,
+              type_factory_->get_bool(), std::move(compare_fn_args)));
+    }
 
     std::vector<std::unique_ptr<ValueExpr>> algebrized_arguments;
     int pivot_expr_idx = pivot_column->pivot_expr_index();
@@ -5379,6 +6951,11 @@ absl::StatusOr<std::unique_ptr<AggregateOp>> Algebrizer::AlgebrizePivotScan(
       auto agg_op,
       AggregateOp::Create(std::move(keys), std::move(aggregators),
                           std::move(wrapped_input), /*grouping_sets=*/{}));
+  if (dispatch_pivot_values) {
+    ZETASQL_RETURN_IF_ERROR(agg_op->SetPivot(for_expr_var,
+                                     std::move(algebrized_pivot_values),
+                                     std::move(pivot_value_indexes)));
+  }
   return agg_op;
 }
 
@@ -5505,7 +7082,8 @@ absl::StatusOr<std::unique_ptr<RelationalOp>> Algebrizer::AlgebrizeScan(
     }
     case RESOLVED_TVFSCAN: {
       ZETASQL_ASSIGN_OR_RETURN(rel_op,
-                       AlgebrizeTvfScan(scan->GetAs<ResolvedTVFScan>()));
+                       AlgebrizeTvfScan(scan->GetAs<ResolvedTVFScan>(),
+                                        active_conjuncts));
       break;
     }
     default:
@@ -5665,6 +7243,9 @@ Algebrizer::AlgebrizeQueryStatementAsRelation(
   ZETASQL_RETURN_IF_ERROR(CheckHints(query->hint_list()));
   const ResolvedScan* scan = query->query();
   ZETASQL_RETURN_IF_ERROR(CheckHints(scan->hint_list()));
+  if (algebrizer_options_.report_referenced_columns) {
+    ZETASQL_ASSIGN_OR_RETURN(referenced_columns_, GetColumnsReadByNode(query));
+  }
   ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<RelationalOp> relation, AlgebrizeScan(scan));
 
   for (const std::unique_ptr<const ResolvedOutputColumn>& output_column :
@@ -5742,6 +7323,14 @@ absl::StatusOr<std::unique_ptr<ValueExpr>> Algebrizer::AlgebrizeDMLStatement(
                    CreateDMLOutputTypeWithReturning(
                        table_array_type, returning_array_type, type_factory_));
 
+  std::vector<DMLUpdateValueExpr::JoinKey> join_keys;
+  if (ast_root->node_kind() == RESOLVED_UPDATE_STMT) {
+    ZETASQL_ASSIGN_OR_RETURN(
+        join_keys,
+        AlgebrizeUpdateJoinKeys(ast_root->GetAs<ResolvedUpdateStmt>(),
+                                resolved_expr_map.get()));
+  }
+
   // It is safe to move 'column_to_variable_' into the DML ValueExpr because
   // this algebrizer can only be used once. Also, 'column_to_variable_' is
   // passed as a const, so we can be sure that no new query parameters or
@@ -5770,7 +7359,8 @@ absl::StatusOr<std::unique_ptr<ValueExpr>> Algebrizer::AlgebrizeDMLStatement(
               dml_output_type, ast_root->GetAs<ResolvedUpdateStmt>(),
               &column_list, std::move(returning_column_values),
               std::move(column_to_variable_), std::move(resolved_scan_map),
-              std::move(resolved_expr_map), std::move(column_expr_map)));
+              std::move(resolved_expr_map), std::move(column_expr_map),
+              std::move(join_keys)));
       break;
     }
     case RESOLVED_INSERT_STMT: {
@@ -5794,6 +7384,85 @@ absl::StatusOr<std::unique_ptr<ValueExpr>> Algebrizer::AlgebrizeDMLStatement(
   return WrapWithRootExpr(std::move(value_expr));
 }
 
+// Returns true if two Values of 'type' that are equal in SQL are also
+// identical Values, so that they can be looked up in a hash table.
+static bool IsUpdateJoinKeyType(const Type* type) {
+  switch (type->kind()) {
+    case TYPE_INT32:
+    case TYPE_INT64:
+    case TYPE_UINT32:
+    case TYPE_UINT64:
+    case TYPE_BOOL:
+    case TYPE_STRING:
+    case TYPE_BYTES:
+    case TYPE_DATE:
+    case TYPE_TIMESTAMP:
+    case TYPE_ENUM:
+    case TYPE_NUMERIC:
+    case TYPE_BIGNUMERIC:
+      return true;
+    default:
+      return false;
+  }
+}
+
+absl::StatusOr<std::vector<DMLUpdateValueExpr::JoinKey>>
+Algebrizer::AlgebrizeUpdateJoinKeys(const ResolvedUpdateStmt* stmt,
+                                    ResolvedExprMap* resolved_expr_map) {
+  std::vector<DMLUpdateValueExpr::JoinKey> join_keys;
+  if (stmt->table_scan() == nullptr || stmt->from_scan() == nullptr) {
+    return join_keys;
+  }
+  const absl::flat_hash_set<ResolvedColumn> target_columns(
+      stmt->table_scan()->column_list().begin(),
+      stmt->table_scan()->column_list().end());
+  const absl::flat_hash_set<ResolvedColumn> from_columns(
+      stmt->from_scan()->column_list().begin(),
+      stmt->from_scan()->column_list().end());
+
+  std::vector<std::unique_ptr<FilterConjunctInfo>> conjunct_infos;
+  ZETASQL_RETURN_IF_ERROR(AddFilterConjunctsTo(stmt->where_expr(), &conjunct_infos));
+  for (const std::unique_ptr<FilterConjunctInfo>& info : conjunct_infos) {
+    if (!info->is_non_volatile) continue;
+    if (info->kind != FilterConjunctInfo::kEquals) continue;
+    // Collated strings can be equal without being identical.
+    if (!info->conjunct->GetAs<ResolvedFunctionCall>()
+             ->collation_list()
+             .empty()) {
+      continue;
+    }
+    ZETASQL_RET_CHECK_EQ(info->arguments.size(), 2);
+    const ResolvedExpr* target = info->arguments[0];
+    const ResolvedExpr* from = info->arguments[1];
+    if (!target->type()->Equals(from->type()) ||
+        !IsUpdateJoinKeyType(target->type())) {
+      continue;
+    }
+    const absl::flat_hash_set<ResolvedColumn>* target_arg_columns =
+        &info->argument_columns[0];
+    const absl::flat_hash_set<ResolvedColumn>* from_arg_columns =
+        &info->argument_columns[1];
+    if (target_arg_columns->empty() || from_arg_columns->empty()) continue;
+    if (IsSubsetOf(*target_arg_columns, from_columns) &&
+        IsSubsetOf(*from_arg_columns, target_columns)) {
+      std::swap(target, from);
+      std::swap(target_arg_columns, from_arg_columns);
+    }
+    if (!IsSubsetOf(*target_arg_columns, target_columns) ||
+        !IsSubsetOf(*from_arg_columns, from_columns)) {
+      continue;
+    }
+
+    ZETASQL_RETURN_IF_ERROR(PopulateResolvedExprMap(target, resolved_expr_map));
+    ZETASQL_RETURN_IF_ERROR(PopulateResolvedExprMap(from, resolved_expr_map));
+    DMLUpdateValueExpr::JoinKey join_key;
+    join_key.target = target;
+    join_key.from = from;
+    join_keys.push_back(join_key);
+  }
+  return join_keys;
+}
+
 absl::Status Algebrizer::AlgebrizeDescendantsOfDMLStatement(
     const ResolvedStatement* ast_root, ResolvedScanMap* resolved_scan_map,
     ResolvedExprMap* resolved_expr_map, ColumnExprMap* column_expr_map,
@@ -6235,6 +7904,10 @@ absl::Status Algebrizer::AlgebrizeStatement(
       ZETASQL_RETURN_IF_ERROR(CheckHints(stmt->hint_list()));
       const ResolvedScan* scan = stmt->query();
       ZETASQL_RETURN_IF_ERROR(CheckHints(scan->hint_list()));
+      if (algebrizer_options.report_referenced_columns) {
+        ZETASQL_ASSIGN_OR_RETURN(single_use_algebrizer.referenced_columns_,
+                         GetColumnsReadByNode(stmt));
+      }
       ResolvedColumnList output_column_list;
       for (const auto& it :
            ast_root->GetAs<ResolvedQueryStmt>()->output_column_list()) {
@@ -6348,7 +8021,9 @@ Algebrizer::AlgebrizeRecursiveScan(
                  recursive_scan->column_list()));
 
   // Create a variable to hold the result from the previous iteration.
-  // ResolvedRecursiveRefScan nodes will derefrence this.
+  // ResolvedRecursiveRefScan nodes will derefrence this. Only the new rows of
+  // the previous iteration, rather than all rows produced so far, feed the
+  // next iteration (i.e., semi-naive evaluation).
   VariableId recursive_var =
       variable_gen_->GetNewVariableName("$recursive_var");
   ZETASQL_ASSIGN_OR_RETURN(const ArrayType* recursive_table_type,
@@ -6668,7 +8343,8 @@ Algebrizer::AlgebrizeGroupRowsScan(
 }
 
 absl::StatusOr<std::unique_ptr<RelationalOp>> Algebrizer::AlgebrizeTvfScan(
-    const ResolvedTVFScan* tvf_scan) {
+    const ResolvedTVFScan* tvf_scan,
+    std::vector<FilterConjunctInfo*>* active_conjuncts) {
   // Algebrize input arguments.
   std::vector<TVFOp::TVFOpArgument> arguments;
   for (int i = 0; i < tvf_scan->argument_list().size(); ++i) {
@@ -6730,6 +8406,8 @@ absl::StatusOr<std::unique_ptr<RelationalOp>> Algebrizer::AlgebrizeTvfScan(
   output_columns.reserve(tvf_scan->column_list().size());
   std::vector<VariableId> variables;
   variables.reserve(tvf_scan->column_list().size());
+  TableScanColumnInfoMap column_info_map;
+  column_info_map.reserve(tvf_scan->column_list().size());
   for (int i = 0; i < tvf_scan->column_list_size(); ++i) {
     const ResolvedColumn& column = tvf_scan->column_list(i);
     const TVFSchemaColumn& signature_column =
@@ -6739,14 +8417,31 @@ absl::StatusOr<std::unique_ptr<RelationalOp>> Algebrizer::AlgebrizeTvfScan(
         << column.type()->DebugString()
         << " != " << signature_column.type->DebugString();
     output_columns.push_back(signature_column);
-    variables.push_back(column_to_variable_->GetVariableNameFromColumn(column));
+    const VariableId variable =
+        column_to_variable_->GetVariableNameFromColumn(column);
+    variables.push_back(variable);
+    ZETASQL_RET_CHECK(
+        column_info_map.emplace(column, std::make_pair(variable, i)).second);
+  }
+
+  // As for table scans, the TVF may ignore the filters, so the conjuncts stay
+  // in a filter above it.
+  std::vector<std::unique_ptr<ColumnFilterArg>> and_filters;
+  if (algebrizer_options_.push_down_filters) {
+    // Iterate over 'active_conjuncts' in reverse order because it's a stack.
+    for (auto i = active_conjuncts->rbegin(); i != active_conjuncts->rend();
+         ++i) {
+      ZETASQL_RETURN_IF_ERROR(TryAlgebrizeFilterConjunctAsColumnFilterArgs(
+          column_info_map, **i, &and_filters));
+    }
   }
 
   ZETASQL_ASSIGN_OR_RETURN(
       std::unique_ptr<TVFOp> tvf_op,
       TVFOp::Create(tvf_scan->tvf(), std::move(arguments),
                     std::move(output_columns), std::move(variables),
-                    tvf_scan->function_call_signature()));
+                    tvf_scan->function_call_signature(),
+                    std::move(and_filters)));
   return std::move(tvf_op);
 }
 
@@ -76,6 +76,30 @@ struct AlgebrizerOptions {
   // compatible filter immediately above the join.
   bool allow_hash_join = false;
 
+  // If true, the algebrizer indexes the right-hand side of a join by range
+  // when the join condition has no hash join equalities but has a
+  // RANGE_OVERLAPS(), RANGE_CONTAINS() or BETWEEN conjunct between the two
+  // sides.
+  bool allow_range_join = false;
+
+  // If true, a join with hash join equalities whose inputs are both known to
+  // be sorted on the join keys (see RelationalOp::DeriveProperties()) merges
+  // them instead of building a hash table on the right input.
+  bool allow_merge_join = false;
+
+  // If true, the algebrizer swaps the inputs of an inner join when the
+  // Table::GetRowCountEstimate() of the tables they scan suggests that the
+  // left input is smaller, so that the hash table is built on the smaller
+  // input. Filters are assumed to keep a fixed fraction of their input rows.
+  bool use_row_count_estimates = false;
+
+  // If true, the hash table of an inner, semi or right outer hash join is
+  // also used to filter the probe-side (left) input: a table scan that produces
+  // a join key of the probe side, and whose rows reach the join one-to-one
+  // through filters, projections and joins, skips the rows whose key is not in
+  // the hash table. See JoinOp::SetJoinKeyFilters().
+  bool use_join_key_filters = false;
+
   // If true, the algebrizer attempts to use a single operator for ORDER BY
   // LIMIT instead of LimitOp(SortOp), which saves memory.
   bool allow_order_by_limit_operator = false;
@@ -95,6 +119,52 @@ struct AlgebrizerOptions {
   // evaluated up front, and the result stored in an in-memory array, which will
   // then be dereferenced when the WITH entry is referenced.
   bool inline_with_entries = false;
+
+  // If true, subqueries whose result is determined by the values of their
+  // correlated parameters are wrapped in a MemoizedSubqueryExpr, so that they
+  // are evaluated at most once per statement for each combination of those
+  // values (and once per statement if they are not correlated).
+  bool memoize_subqueries = false;
+
+  // If true, filter conjuncts of the form [NOT] EXISTS(<subquery>) and
+  // <expr> [NOT] IN (<subquery>) are algebrized as semi joins or anti joins of
+  // the filter input with the subquery when the subquery can be evaluated
+  // independently of the filter input, instead of evaluating the subquery for
+  // each input row.
+  bool allow_semi_join = false;
+
+  // If true, EvaluatorTableScanOps in a query statement pass the columns of the
+  // scan that the query reads to
+  // EvaluatorTableIterator::SetReferencedColumns().
+  bool report_referenced_columns = false;
+
+  // If true, scalar function calls and casts that are deterministic
+  // (FunctionEnums::IMMUTABLE) and whose inputs are all literals are evaluated
+  // once during algebrization and replaced by a ConstExpr, unless their
+  // evaluation fails or depends on the default time zone.
+  bool fold_constants = false;
+
+  // If true, non-volatile function calls and casts that occur more than once
+  // in the expressions of a ResolvedProjectScan are computed once per row in
+  // an extra slot of the ComputeOp and read from there. Only occurrences that
+  // are evaluated unconditionally (e.g., not inside a branch of IF or CASE)
+  // are counted, so that hoisting an expression never produces an error that
+  // the original query would not.
+  bool eliminate_common_subexpressions = false;
+
+  // If true, JSON_EXTRACT, JSON_EXTRACT_SCALAR, JSON_QUERY and JSON_VALUE
+  // calls with different constant paths on the same column in the
+  // expressions of a ResolvedProjectScan are computed together in an extra
+  // slot of the ComputeOp, so that each input document is scanned or parsed
+  // only once per row. Only calls that are evaluated unconditionally are
+  // grouped, like for 'eliminate_common_subexpressions'.
+  bool group_json_extractions = false;
+
+  // If true, UNNEST of a GENERATE_ARRAY, GENERATE_DATE_ARRAY or
+  // GENERATE_TIMESTAMP_ARRAY call is algebrized as a GenerateArrayScanOp,
+  // which produces the elements one at a time instead of building the array.
+  // The limits on the size of generated arrays then do not apply.
+  bool stream_generated_arrays = false;
 };
 
 struct AnonymizationOptions {
@@ -259,6 +329,10 @@ class Algebrizer {
       std::unique_ptr<ValueExpr> filter, const ResolvedExpr* expr);
   absl::StatusOr<std::unique_ptr<ValueExpr>> AlgebrizeSubqueryExpr(
       const ResolvedSubqueryExpr* subquery_expr);
+  // Returns the variables of the correlated parameters of 'subquery_expr' if
+  // it can be wrapped in a MemoizedSubqueryExpr, or std::nullopt otherwise.
+  absl::StatusOr<std::optional<std::vector<VariableId>>>
+  GetSubqueryMemoizationKey(const ResolvedSubqueryExpr* subquery_expr);
   absl::StatusOr<std::unique_ptr<ValueExpr>> AlgebrizeWithExpr(
       const ResolvedWithExpr* with_expr);
   absl::StatusOr<std::unique_ptr<ValueExpr>> AlgebrizeInArray(
@@ -327,6 +401,26 @@ class Algebrizer {
   absl::StatusOr<std::unique_ptr<ValueExpr>> AlgebrizeExpression(
       const ResolvedExpr* expr);
 
+  // Algebrizes 'expr', whose inputs are all literals, and replaces it with a
+  // ConstExpr of its value if it can be evaluated without an EvaluationContext
+  // of the statement and its output is deterministic. See
+  // AlgebrizerOptions::fold_constants.
+  absl::StatusOr<std::unique_ptr<ValueExpr>> AlgebrizeAndFoldConstant(
+      const ResolvedExpr* expr);
+
+  // Returns an ExprArg for each expression that is repeated in 'exprs' and
+  // should be computed only once, and adds it to 'common_subexpressions_'. See
+  // AlgebrizerOptions::eliminate_common_subexpressions.
+  absl::StatusOr<std::vector<std::unique_ptr<ExprArg>>>
+  AlgebrizeCommonSubexpressions(absl::Span<const ResolvedExpr* const> exprs);
+
+  // Returns an ExprArg for each group of JSON extractions from the same column
+  // in 'exprs' that should be computed together, followed by an ExprArg for
+  // each extraction in the group, and adds the latter to
+  // 'common_subexpressions_'. See AlgebrizerOptions::group_json_extractions.
+  absl::StatusOr<std::vector<std::unique_ptr<ExprArg>>>
+  AlgebrizeJsonExtractions(absl::Span<const ResolvedExpr* const> exprs);
+
   // Wraps 'value_expr' in a RootExpr to manage ownership of some objects
   // required by the algebrized tree.
   absl::StatusOr<std::unique_ptr<ValueExpr>> WrapWithRootExpr(
@@ -426,7 +520,17 @@ class Algebrizer {
       const ResolvedScan* left_scan,
       const std::vector<ResolvedColumn>& right_output_column_list,
       const ScanAlgebrizerCallback& right_scan_algebrizer_cb,
-      std::vector<FilterConjunctInfo*>* active_conjuncts);
+      std::vector<FilterConjunctInfo*>* active_conjuncts,
+      // The right input, if it is a ResolvedScan, for choosing the build side
+      // of an inner join and for join key filters. May be NULL.
+      const ResolvedScan* right_scan = nullptr);
+  // Makes the table scans of 'probe_scan' that produce the left side of
+  // 'hash_join_equality_exprs' skip the rows whose key is not in the hash
+  // table of the join, if that does not change the result of a 'join_kind'
+  // join. Returns the JoinKeyFilterSpecs for JoinOp::SetJoinKeyFilters().
+  absl::StatusOr<std::vector<JoinOp::JoinKeyFilterSpec>> AddJoinKeyFilters(
+      JoinOp::JoinKind join_kind, const ResolvedScan* probe_scan,
+      absl::Span<const JoinOp::HashJoinEqualityExprs> hash_join_equality_exprs);
   absl::StatusOr<std::unique_ptr<RelationalOp>> AlgebrizeFilterScan(
       const ResolvedFilterScan* filter_scan,
       std::vector<FilterConjunctInfo*>* active_conjuncts);
@@ -483,6 +587,11 @@ class Algebrizer {
   absl::StatusOr<std::unique_ptr<RelationalOp>> AlgebrizeArrayScanWithoutJoin(
       const ResolvedArrayScan* array_scan,
       std::vector<FilterConjunctInfo*>* active_conjuncts);
+  // Returns a GenerateArrayScanOp for 'array_scan' if it is the UNNEST of a
+  // single GENERATE_ARRAY, GENERATE_DATE_ARRAY or GENERATE_TIMESTAMP_ARRAY
+  // call, or nullptr otherwise.
+  absl::StatusOr<std::unique_ptr<RelationalOp>> MaybeAlgebrizeGenerateArrayScan(
+      const ResolvedArrayScan* array_scan);
   absl::StatusOr<std::unique_ptr<RelationalOp>> AlgebrizeLimitOffsetScan(
       const ResolvedLimitOffsetScan* scan);
   absl::StatusOr<std::unique_ptr<RelationalOp>> AlgebrizeWithScan(
@@ -492,7 +601,8 @@ class Algebrizer {
   absl::StatusOr<std::unique_ptr<RelationalOp>> AlgebrizeGroupRowsScan(
       const ResolvedGroupRowsScan* group_rows_scan);
   absl::StatusOr<std::unique_ptr<RelationalOp>> AlgebrizeTvfScan(
-      const ResolvedTVFScan* tvf_scan);
+      const ResolvedTVFScan* tvf_scan,
+      std::vector<FilterConjunctInfo*>* active_conjuncts);
   absl::StatusOr<std::unique_ptr<RelationalOp>> AlgebrizeTableScan(
       const ResolvedTableScan* table_scan,
       std::vector<FilterConjunctInfo*>* active_conjuncts);
@@ -635,6 +745,16 @@ class Algebrizer {
       ResolvedExprMap* resolved_expr_map, ColumnExprMap* column_expr_map,
       const ResolvedTableScan** resolved_table_scan);
 
+  // Returns the equality conjuncts of the WHERE clause of 'stmt' that an
+  // UPDATE with a FROM clause can hash join on, and adds the algebrized sides
+  // of those conjuncts to 'resolved_expr_map'. A conjunct qualifies if it is
+  // non-volatile, one side only references columns of the table being updated
+  // and the other only columns of the FROM scan, and both sides have a type
+  // for which equal values are always identical Values.
+  absl::StatusOr<std::vector<DMLUpdateValueExpr::JoinKey>>
+  AlgebrizeUpdateJoinKeys(const ResolvedUpdateStmt* stmt,
+                          ResolvedExprMap* resolved_expr_map);
+
   // Populates the 'returning_column_list' and 'returning_column_values' from
   // the returning clause found in this dml statement. 'returning_column_list'
   // is used to create the returning output table array type,
@@ -787,6 +907,64 @@ class Algebrizer {
       int num_previous_equality_exprs,
       JoinOp::HashJoinEqualityExprs* equality_exprs);
 
+  // If some entry in 'conjuncts_with_push_down' (all of which must be
+  // non-redundant) can be represented with a RangeJoinExprs object, returns
+  // one. Else returns std::nullopt. Unlike with hash joins, the conjunct is
+  // not marked as redundant, because the index only narrows down the right
+  // tuples that the conjunct is evaluated on.
+  absl::StatusOr<std::optional<JoinOp::RangeJoinExprs>>
+  AlgebrizeJoinConditionForRangeJoin(
+      const absl::flat_hash_set<ResolvedColumn>& left_output_columns,
+      const absl::flat_hash_set<ResolvedColumn>& right_output_columns,
+      absl::Span<FilterConjunctInfo* const> conjuncts_with_push_down);
+
+  // Returns the RangeJoinExprs for the BETWEEN in 'conjunct_info', if its
+  // element is determined by one side of the join and both bounds by the
+  // other. Else returns std::nullopt.
+  absl::StatusOr<std::optional<JoinOp::RangeJoinExprs>>
+  TryAlgebrizeBetweenForRangeJoin(
+      const FilterConjunctInfo& conjunct_info,
+      const absl::flat_hash_set<ResolvedColumn>& left_output_columns,
+      const absl::flat_hash_set<ResolvedColumn>& right_output_columns);
+
+  // Describes a filter conjunct that is algebrized as a semi join or anti join
+  // of the filter input with a subquery (see
+  // AlgebrizerOptions::allow_semi_join).
+  struct SemiJoinInfo {
+    JoinOp::JoinKind kind = JoinOp::kSemiJoin;
+
+    // The [NOT] EXISTS or [NOT] IN subquery.
+    const ResolvedSubqueryExpr* subquery_expr = nullptr;
+
+    // The right-hand side of the join. For IN, this is the subquery, and its
+    // only column is hashed against the IN expression. For EXISTS, this is the
+    // input of the filter of the subquery.
+    const ResolvedScan* right_scan = nullptr;
+
+    // For EXISTS, the conjuncts of the filter of the subquery that do not
+    // reference the correlated parameters. They are applied to 'right_scan'.
+    std::vector<const ResolvedExpr*> right_conjuncts;
+
+    // For EXISTS, the conjuncts of the filter of the subquery that reference
+    // the correlated parameters. They form the join condition.
+    std::vector<const ResolvedExpr*> join_conjuncts;
+
+    // For EXISTS, the columns of the correlated parameters.
+    absl::flat_hash_set<ResolvedColumn> parameter_columns;
+  };
+
+  // Returns the SemiJoinInfo for 'conjunct', or nullopt if 'conjunct' cannot
+  // be algebrized as a semi join or anti join. Semi joins are used for
+  // EXISTS subqueries whose correlated parameters only appear in a filter on
+  // top of the subquery, and for uncorrelated IN subqueries. Anti joins are
+  // used for the negations of those.
+  static absl::StatusOr<std::optional<SemiJoinInfo>> GetSemiJoinInfo(
+      const ResolvedExpr* conjunct);
+
+  // Returns the semi join or anti join of 'input' described by 'info'.
+  absl::StatusOr<std::unique_ptr<RelationalOp>> AlgebrizeSemiJoin(
+      const SemiJoinInfo& info, std::unique_ptr<RelationalOp> input);
+
   // Creates a new variable for each column and returns a vector of arguments,
   // each assigning the new variable from a DerefExpr of the old variable.
   absl::Status RemapJoinColumns(const ResolvedColumnList& columns,
@@ -1002,6 +1180,23 @@ class Algebrizer {
   // Maps system variables to variable ids.  Not owned.
   SystemVariablesAlgebrizerMap* system_variables_map_;
 
+  // If 'algebrizer_options_.report_referenced_columns' is true and a query
+  // statement is being algebrized, contains every column that the statement
+  // reads after it is produced by a scan (see GetColumnsReadByNode()). Columns
+  // of ResolvedTableScans that are not in this set are never read.
+  std::optional<absl::flat_hash_set<ResolvedColumn>> referenced_columns_;
+
+  // True while AlgebrizeAndFoldConstant() algebrizes an expression, so that
+  // its subexpressions are not folded separately.
+  bool folding_constant_ = false;
+
+  // The expressions returned by AlgebrizeCommonSubexpressions() for the
+  // ComputeOp that is being algebrized, and their variables.
+  // AlgebrizeExpression() replaces matching expressions by a reference to the
+  // variable.
+  std::vector<std::pair<const ResolvedExpr*, VariableId>>
+      common_subexpressions_;
+
   // Maps named WITH subquery to an argument (variable, ValueExpr). Used to
   // algebrize WithRef scans referencing named subqueries.
   //
@@ -1082,6 +1277,18 @@ class Algebrizer {
   // ResolvedCatalogColumnRef.
   std::optional<absl::flat_hash_map<const Column*, VariableId>>
       catalog_column_ref_variables_;
+
+  // If 'algebrizer_options_.use_join_key_filters' is true, maps the variable
+  // of each column of an algebrized ResolvedTableScan to the column and the
+  // scan (not owned), for AddJoinKeyFilters().
+  struct TableScanColumn {
+    ResolvedColumn column;
+    EvaluatorTableScanOp* scan;
+  };
+  absl::flat_hash_map<VariableId, TableScanColumn> table_scan_variables_;
+
+  // The id of the next JoinKeyFilter created by AddJoinKeyFilters().
+  int next_join_key_filter_id_ = 0;
 };
 
 }  // namespace zetasql
@@ -40,8 +40,10 @@
 #include "zetasql/public/table_valued_function.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/value.h"
+#include "zetasql/reference_impl/evaluation.h"
 #include "zetasql/reference_impl/operator.h"
 #include "zetasql/reference_impl/parameters.h"
+#include "zetasql/reference_impl/tuple.h"
 #include "zetasql/reference_impl/variable_generator.h"
 #include "zetasql/reference_impl/variable_id.h"
 #include "zetasql/resolved_ast/make_node_vector.h"
@@ -2069,4 +2071,114 @@ TEST_F(StatementAlgebrizerTest, TVF) {
             "| +-$o2})");
 }
 
+class FilterPushdownAlgebrizerTest : public StatementAlgebrizerTest {
+ protected:
+  void SetUp() override {
+    algebrizer_options_.push_down_filters = true;
+    StatementAlgebrizerTest::SetUp();
+  }
+};
+
+TEST_F(FilterPushdownAlgebrizerTest, TVFColumnFilters) {
+  TVFRelation tvf_output_schema({
+      {"o1", Int64Type()},
+      {"o2", DoubleType()},
+  });
+
+  FixedOutputSchemaTVF tvf(
+      {"tvf_no_args"},
+      FunctionSignature(FunctionArgumentType::RelationWithSchema(
+                            tvf_output_schema,
+                            /*extra_relation_input_columns_allowed=*/false),
+                        FunctionArgumentTypeList(), /*context_ptr=*/nullptr),
+      tvf_output_schema);
+
+  ResolvedColumn o1(1, IdString::MakeGlobal("tvf_no_args"),
+                    IdString::MakeGlobal("o1"), types::Int64Type());
+  ResolvedColumn o2(2, IdString::MakeGlobal("tvf_no_args"),
+                    IdString::MakeGlobal("o2"), types::DoubleType());
+
+  std::vector<TVFInputArgumentType> signature_arguments;
+  auto signature =
+      std::make_shared<TVFSignature>(signature_arguments, tvf_output_schema);
+
+  auto tvf_scan =
+      MakeResolvedTVFScan({o1, o2}, &tvf, signature, /*argument_list=*/{},
+                          /*column_index_list=*/{0, 1}, /*alias=*/"");
+
+  // Build the filter o2 = 2.5 above the TVF scan.
+  std::unique_ptr<const Function> equal_function(
+      new Function("$equal", Function::kZetaSQLFunctionGroupName,
+                   Function::SCALAR));
+  FunctionSignature equal_signature(BoolType(), {DoubleType(), DoubleType()},
+                                    -1 /* context_id */);
+  auto filter_expr = MakeResolvedFunctionCall(
+      BoolType(), equal_function.get(), equal_signature,
+      MakeNodeVectorP<const ResolvedExpr>(
+          MakeResolvedColumnRef(DoubleType(), o2, kNonCorrelated),
+          MakeResolvedLiteral(Value::Double(2.5))),
+      DEFAULT_ERROR_MODE);
+  auto filter_scan = MakeResolvedFilterScan({o1, o2}, std::move(tvf_scan),
+                                            std::move(filter_expr));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<const AlgebraNode> algebrized_scan,
+                       algebrizer_->AlgebrizeScan(filter_scan.get()));
+  const std::string debug_string = algebrized_scan->DebugString();
+  // The filter is pushed into the TVF on its second output column, but stays
+  // above it because the TVF need not apply it.
+  EXPECT_THAT(debug_string,
+              HasSubstr("FilterOp(\n"
+                        "+-condition: Equal($o2, ConstExpr(2.5)),\n"
+                        "+-input: TvfOp("));
+  EXPECT_THAT(debug_string,
+              HasSubstr("and_filters: {\n"
+                        "  | +-InListColumnFilterArg($o2, column_idx: 1, "
+                        "elements: (ConstExpr(2.5)))}"));
+}
+
+class ConstantFoldingAlgebrizerTest : public AlgebrizerTestBase {
+ protected:
+  void SetUp() override {
+    algebrizer_options_.fold_constants = true;
+    AlgebrizerTestBase::SetUp();
+  }
+};
+
+TEST_F(ConstantFoldingAlgebrizerTest, KeepsNonDeterministicOutput) {
+  std::unique_ptr<const Function> add_function(new Function(
+      "$add", Function::kZetaSQLFunctionGroupName, Function::SCALAR));
+  FunctionSignature add_signature(Int64Type(), {Int64Type(), Int64Type()},
+                                  -1 /* context_id */);
+  auto add = MakeResolvedFunctionCall(
+      Int64Type(), add_function.get(), add_signature,
+      MakeNodeVectorP<const ResolvedExpr>(MakeResolvedLiteral(Int64(1)),
+                                          MakeResolvedLiteral(Int64(2))),
+      DEFAULT_ERROR_MODE);
+  TestAlgebrizeExpression(add.get(), "ConstExpr(3)");
+
+  // The sum of doubles depends on the order of the additions, which the
+  // evaluation must still report.
+  std::unique_ptr<const Function> array_sum_function(new Function(
+      "array_sum", Function::kZetaSQLFunctionGroupName, Function::SCALAR));
+  FunctionSignature array_sum_signature(DoubleType(), {DoubleArrayType()},
+                                        -1 /* context_id */);
+  auto array_sum = MakeResolvedFunctionCall(
+      DoubleType(), array_sum_function.get(), array_sum_signature,
+      MakeNodeVectorP<const ResolvedExpr>(
+          MakeResolvedLiteral(values::DoubleArray({1.1, 2.2}))),
+      DEFAULT_ERROR_MODE);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<ValueExpr> expr,
+                       algebrizer_->AlgebrizeExpression(array_sum.get()));
+  EXPECT_THAT(expr->DebugString(), HasSubstr("ArraySum("));
+
+  ZETASQL_ASSERT_OK(expr->SetSchemasForEvaluation(/*params_schemas=*/{}));
+  EvaluationContext context((EvaluationOptions()));
+  TupleSlot result;
+  absl::Status status;
+  ASSERT_TRUE(expr->EvalSimple(/*params=*/{}, &context, &result, &status))
+      << status;
+  EXPECT_EQ(result.value(), Double(1.1 + 2.2));
+  EXPECT_FALSE(context.IsDeterministicOutput());
+}
+
 }  // namespace zetasql
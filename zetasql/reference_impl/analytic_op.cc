@@ -34,6 +34,7 @@
 #include "zetasql/public/type.pb.h"
 #include "zetasql/public/value.h"
 #include "zetasql/reference_impl/evaluation.h"
+#include "zetasql/reference_impl/function.h"
 #include "zetasql/reference_impl/operator.h"
 #include "zetasql/reference_impl/tuple.h"
 #include "zetasql/reference_impl/tuple_comparator.h"
@@ -1883,10 +1884,162 @@ absl::Status WindowFrameArg::IsStaticallyEmpty(
   return absl::OkStatus();
 }
 
+namespace {
+
+// Evaluates an aggregate over a cumulative window by adding each row to a
+// SlidingWindowAccumulator that is reset at the start of every partition.
+class CumulativeAggregateEvaluator : public StreamingAnalyticArgEvaluator {
+ public:
+  CumulativeAggregateEvaluator(
+      std::unique_ptr<SlidingWindowAccumulator> accumulator,
+      std::unique_ptr<TupleComparator> comparator,
+      std::vector<int> slots_for_values, EvaluationContext* context)
+      : accumulator_(std::move(accumulator)),
+        comparator_(std::move(comparator)),
+        slots_for_values_(std::move(slots_for_values)),
+        context_(context) {}
+
+  CumulativeAggregateEvaluator(const CumulativeAggregateEvaluator&) = delete;
+  CumulativeAggregateEvaluator& operator=(
+      const CumulativeAggregateEvaluator&) = delete;
+
+  bool Eval(const TupleData* previous_row, const TupleData& row, Value* value,
+            absl::Status* status) override {
+    if (previous_row == nullptr) {
+      accumulator_->Reset();
+    } else if (!comparator_->IsUniquelyOrdered({previous_row, &row},
+                                               slots_for_values_)) {
+      // Same as WindowFrameArg::GetWindows(): the windows of ROWS frames
+      // depend on the order of peers that are not equal.
+      context_->SetNonDeterministicOutput();
+    }
+    if (!accumulator_->Add(row, status)) return false;
+    absl::StatusOr<Value> result = accumulator_->GetResult();
+    if (!result.ok()) {
+      *status = result.status();
+      return false;
+    }
+    *value = std::move(result).value();
+    return true;
+  }
+
+ private:
+  const std::unique_ptr<SlidingWindowAccumulator> accumulator_;
+  const std::unique_ptr<TupleComparator> comparator_;
+  const std::vector<int> slots_for_values_;
+  EvaluationContext* context_;
+};
+
+// Evaluates ROW_NUMBER, RANK or DENSE_RANK.
+class NumberingEvaluator : public StreamingAnalyticArgEvaluator {
+ public:
+  enum Kind { kRowNumber, kRank, kDenseRank };
+
+  // 'comparator' is NULL for ROW_NUMBER.
+  NumberingEvaluator(Kind kind, std::unique_ptr<TupleComparator> comparator,
+                     EvaluationContext* context)
+      : kind_(kind), comparator_(std::move(comparator)), context_(context) {}
+
+  NumberingEvaluator(const NumberingEvaluator&) = delete;
+  NumberingEvaluator& operator=(const NumberingEvaluator&) = delete;
+
+  bool Eval(const TupleData* previous_row, const TupleData& row, Value* value,
+            absl::Status* status) override {
+    if (previous_row == nullptr) {
+      row_number_ = 1;
+      rank_ = 1;
+    } else {
+      ++row_number_;
+      switch (kind_) {
+        case kRowNumber:
+          // Same as RowNumberFunction::Eval(): we cannot tell whether the
+          // order is total, so partitions of more than one row are
+          // non-deterministic.
+          context_->SetNonDeterministicOutput();
+          break;
+        case kRank:
+          if ((*comparator_)(previous_row, &row)) rank_ = row_number_;
+          break;
+        case kDenseRank:
+          if ((*comparator_)(previous_row, &row)) ++rank_;
+          break;
+      }
+    }
+    *value = Value::Int64(kind_ == kRowNumber ? row_number_ : rank_);
+    return true;
+  }
+
+ private:
+  const Kind kind_;
+  const std::unique_ptr<TupleComparator> comparator_;
+  EvaluationContext* context_;
+  int64_t row_number_ = 0;
+  int64_t rank_ = 0;
+};
+
+}  // namespace
+
 // -------------------------------------------------------
 // AggregateAnalyticArg
 // -------------------------------------------------------
 
+// Returns true if neither the start nor the end of the non-empty 'windows'
+// ever moves backwards, so that a SlidingWindowAccumulator can compute them.
+static bool WindowsSlideForward(absl::Span<const AnalyticWindow> windows) {
+  int prev_start = 0;
+  int prev_end = 0;
+  for (const AnalyticWindow& window : windows) {
+    if (window.num_tuples == 0) continue;
+    const int end = window.start_tuple_id + window.num_tuples;
+    if (window.start_tuple_id < prev_start || end < prev_end) return false;
+    prev_start = window.start_tuple_id;
+    prev_end = end;
+  }
+  return true;
+}
+
+// Computes the aggregate on each of 'windows', which must slide forward, by
+// adding the rows that enter the window and removing those that leave it.
+static absl::Status EvalSlidingWindows(
+    absl::Span<const TupleData* const> partition,
+    absl::Span<const AnalyticWindow> windows, const AggregateArg& aggregator,
+    SlidingWindowAccumulator* accumulator,
+    absl::Span<const TupleData* const> params, EvaluationContext* context,
+    std::vector<Value>* values) {
+  // The rows of 'partition' in [begin, end) are in the window of
+  // 'accumulator'.
+  int begin = 0;
+  int end = 0;
+  uint64_t num_windows = 0;
+  for (const AnalyticWindow& window : windows) {
+    if (window.num_tuples == 0) {
+      ZETASQL_ASSIGN_OR_RETURN(const Value agg_value,
+                       aggregator.EvalAgg(/*group=*/{}, params, context));
+      values->emplace_back(agg_value);
+    } else {
+      const int window_end = window.start_tuple_id + window.num_tuples;
+      if (window.start_tuple_id >= end) {
+        // No row of the previous window is left, and the rows in between
+        // belong to no window, so we do not even evaluate them.
+        accumulator->Reset();
+        begin = window.start_tuple_id;
+        end = window.start_tuple_id;
+      }
+      absl::Status status;
+      for (; end < window_end; ++end) {
+        if (!accumulator->Add(*partition[end], &status)) return status;
+      }
+      for (; begin < window.start_tuple_id; ++begin) {
+        accumulator->RemoveFront();
+      }
+      ZETASQL_ASSIGN_OR_RETURN(const Value agg_value, accumulator->GetResult());
+      values->emplace_back(agg_value);
+    }
+    ZETASQL_RETURN_IF_ERROR(PeriodicallyVerifyNotAborted(context, ++num_windows));
+  }
+  return absl::OkStatus();
+}
+
 absl::Status AggregateAnalyticArg::SetSchemasForEvaluation(
     const TupleSchema& partition_schema,
     absl::Span<const TupleSchema* const> params_schemas) {
@@ -1913,6 +2066,19 @@ absl::Status AggregateAnalyticArg::Eval(
       *partition_schema_, partition, order_keys, params, context, &windows,
       &window_frame_is_deterministic));
 
+  ZETASQL_ASSIGN_OR_RETURN(
+      std::unique_ptr<SlidingWindowAccumulator> sliding_window_accumulator,
+      aggregator_->CreateSlidingWindowAccumulator(params, context));
+  if (sliding_window_accumulator != nullptr && WindowsSlideForward(windows)) {
+    ZETASQL_RETURN_IF_ERROR(EvalSlidingWindows(
+        partition, windows, *aggregator_, sliding_window_accumulator.get(),
+        params, context, values));
+    if (!window_frame_is_deterministic) {
+      context->SetNonDeterministicOutput();
+    }
+    return absl::OkStatus();
+  }
+
   uint64_t num_windows = 0;
   for (const AnalyticWindow& window : windows) {
     // Call AggregateArg::EvalAgg to evaluate the argument expressions and
@@ -1933,6 +2099,27 @@ absl::Status AggregateAnalyticArg::Eval(
   return absl::OkStatus();
 }
 
+absl::StatusOr<std::unique_ptr<StreamingAnalyticArgEvaluator>>
+AggregateAnalyticArg::CreateStreamingEvaluator(
+    absl::Span<const KeyArg* const> order_keys,
+    absl::Span<const TupleData* const> params,
+    EvaluationContext* context) const {
+  if (!window_frame_->IsCumulative()) return nullptr;
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<SlidingWindowAccumulator> accumulator,
+                   aggregator_->CreateSlidingWindowAccumulator(params, context));
+  if (accumulator == nullptr) return nullptr;
+  std::vector<int> slots_for_keys;
+  std::vector<int> slots_for_values;
+  ZETASQL_RETURN_IF_ERROR(GetSlotsForKeysAndValues(*partition_schema_, order_keys,
+                                           &slots_for_keys, &slots_for_values));
+  ZETASQL_ASSIGN_OR_RETURN(
+      std::unique_ptr<TupleComparator> comparator,
+      TupleComparator::Create(order_keys, slots_for_keys, params, context));
+  return std::make_unique<CumulativeAggregateEvaluator>(
+      std::move(accumulator), std::move(comparator),
+      std::move(slots_for_values), context);
+}
+
 std::string AggregateAnalyticArg::DebugInternal(const std::string& indent,
                                                 bool verbose) const {
   return absl::StrCat("AggregateAnalyticArg(",
@@ -2053,6 +2240,36 @@ absl::Status NonAggregateAnalyticArg::Eval(
       error_mode_, context, values);
 }
 
+absl::StatusOr<std::unique_ptr<StreamingAnalyticArgEvaluator>>
+NonAggregateAnalyticArg::CreateStreamingEvaluator(
+    absl::Span<const KeyArg* const> order_keys,
+    absl::Span<const TupleData* const> params,
+    EvaluationContext* context) const {
+  const AnalyticFunctionBody* function = function_call_->function();
+  NumberingEvaluator::Kind kind;
+  if (dynamic_cast<const RowNumberFunction*>(function) != nullptr) {
+    kind = NumberingEvaluator::kRowNumber;
+  } else if (dynamic_cast<const RankFunction*>(function) != nullptr) {
+    kind = NumberingEvaluator::kRank;
+  } else if (dynamic_cast<const DenseRankFunction*>(function) != nullptr) {
+    kind = NumberingEvaluator::kDenseRank;
+  } else {
+    return nullptr;
+  }
+  std::unique_ptr<TupleComparator> comparator;
+  if (function->RequireTupleComparator()) {
+    std::vector<int> order_key_slot_idxs;
+    ZETASQL_RETURN_IF_ERROR(GetSlotsForKeysAndValues(*partition_schema_, order_keys,
+                                             &order_key_slot_idxs,
+                                             /*slots_for_values=*/nullptr));
+    ZETASQL_ASSIGN_OR_RETURN(comparator,
+                     TupleComparator::Create(order_keys, order_key_slot_idxs,
+                                             params, context));
+  }
+  return std::make_unique<NumberingEvaluator>(kind, std::move(comparator),
+                                              context);
+}
+
 std::string NonAggregateAnalyticArg::DebugInternal(const std::string& indent,
                                                    bool verbose) const {
   std::string result("NonAggregateAnalyticArg(");
@@ -2201,7 +2418,7 @@ class AnalyticTupleIterator : public TupleIterator {
         return nullptr;
       }
       first_tuple_in_current_partition =
-          std::make_unique<TupleData>(*input_data);
+          std::make_unique<TupleData>(*input_data, context_->tuple_arena());
     } else {
       first_tuple_in_current_partition =
           std::move(first_tuple_in_next_partition_);
@@ -2233,13 +2450,15 @@ class AnalyticTupleIterator : public TupleIterator {
         // We are done loading the current partition. 'input_data' belongs in
         // the next partition.
         first_tuple_in_next_partition_ =
-            std::make_unique<TupleData>(*input_data);
+            std::make_unique<TupleData>(*input_data, context_->tuple_arena());
         break;
       }
       // 'input_data' belongs in the current partition (which we are still
       // loading).
       if (!remaining_current_partition_.PushBack(
-              std::make_unique<TupleData>(*input_data), &status_)) {
+              std::make_unique<TupleData>(*input_data,
+                                          context_->tuple_arena()),
+              &status_)) {
         return nullptr;
       }
     }
@@ -2257,6 +2476,8 @@ class AnalyticTupleIterator : public TupleIterator {
 
   absl::Status Status() const override { return status_; }
 
+  void Close() override { input_iter_->Close(); }
+
   std::string DebugString() const override {
     return AnalyticOp::GetIteratorDebugString(input_iter_->DebugString());
   }
@@ -2304,9 +2525,106 @@ class AnalyticTupleIterator : public TupleIterator {
   absl::Status status_;
   int64_t num_next_calls_ = 0;
 };
+
+// Like AnalyticTupleIterator, but computes the analytic arguments of each row
+// as soon as it is read, with one StreamingAnalyticArgEvaluator per argument,
+// instead of buffering each partition.
+class StreamingAnalyticTupleIterator : public TupleIterator {
+ public:
+  StreamingAnalyticTupleIterator(
+      absl::Span<const KeyArg* const> partition_keys,
+      std::vector<std::unique_ptr<StreamingAnalyticArgEvaluator>> evaluators,
+      std::unique_ptr<TupleIterator> input_iter,
+      std::unique_ptr<TupleComparator> partition_comparator,
+      std::unique_ptr<TupleSchema> output_schema, EvaluationContext* context)
+      : partition_keys_(partition_keys.begin(), partition_keys.end()),
+        evaluators_(std::move(evaluators)),
+        input_iter_(std::move(input_iter)),
+        partition_comparator_(std::move(partition_comparator)),
+        output_schema_(std::move(output_schema)),
+        context_(context) {}
+
+  StreamingAnalyticTupleIterator(const StreamingAnalyticTupleIterator&) =
+      delete;
+  StreamingAnalyticTupleIterator& operator=(
+      const StreamingAnalyticTupleIterator&) = delete;
+
+  const TupleSchema& Schema() const override { return *output_schema_; }
+
+  TupleData* Next() override {
+    if (num_next_calls_ %
+            absl::GetFlag(
+                FLAGS_zetasql_call_verify_not_aborted_rows_period) ==
+        0) {
+      absl::Status status = context_->VerifyNotAborted();
+      if (!status.ok()) {
+        status_ = status;
+        return nullptr;
+      }
+    }
+    ++num_next_calls_;
+
+    const TupleData* input_data = input_iter_->Next();
+    if (input_data == nullptr) {
+      status_ = input_iter_->Status();
+      if (status_.ok() && has_current_) {
+        // Partitioning by a floating point type is a non-deterministic
+        // operation unless the output is empty.
+        for (const KeyArg* key : partition_keys_) {
+          if (key->type()->IsFloatingPoint()) {
+            context_->SetNonDeterministicOutput();
+          }
+        }
+      }
+      return nullptr;
+    }
+
+    std::swap(current_, previous_);
+    current_ = *input_data;
+    const bool starts_partition =
+        !has_current_ || (*partition_comparator_)(previous_, current_) ||
+        (*partition_comparator_)(current_, previous_);
+    has_current_ = true;
+
+    const TupleData* previous_row = starts_partition ? nullptr : &previous_;
+    const int first_arg_slot = input_iter_->Schema().num_variables();
+    for (int i = 0; i < evaluators_.size(); ++i) {
+      Value value;
+      if (!evaluators_[i]->Eval(previous_row, current_, &value, &status_)) {
+        return nullptr;
+      }
+      current_.mutable_slot(first_arg_slot + i)->SetValue(std::move(value));
+    }
+    return &current_;
+  }
+
+  absl::Status Status() const override { return status_; }
+
+  void Close() override { input_iter_->Close(); }
+
+  std::string DebugString() const override {
+    return AnalyticOp::GetIteratorDebugString(input_iter_->DebugString());
+  }
+
+ private:
+  const std::vector<const KeyArg*> partition_keys_;
+  const std::vector<std::unique_ptr<StreamingAnalyticArgEvaluator>>
+      evaluators_;
+  std::unique_ptr<TupleIterator> input_iter_;
+  std::unique_ptr<TupleComparator> partition_comparator_;
+  std::unique_ptr<TupleSchema> output_schema_;
+  // The last row returned, and the one before it. Only valid if
+  // 'has_current_' is true.
+  TupleData current_;
+  TupleData previous_;
+  bool has_current_ = false;
+  EvaluationContext* context_;
+  absl::Status status_;
+  int64_t num_next_calls_ = 0;
+};
 }  // namespace
 
-absl::StatusOr<std::unique_ptr<TupleIterator>> AnalyticOp::CreateIterator(
+absl::StatusOr<std::unique_ptr<TupleIterator>> AnalyticOp::CreateIteratorImpl(
     absl::Span<const TupleData* const> params, int num_extra_slots,
     EvaluationContext* context) const {
   ZETASQL_ASSIGN_OR_RETURN(
@@ -2330,9 +2648,29 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> AnalyticOp::CreateIterator(
       TupleComparator::Create(partition_keys(), slots_for_partition_keys,
                               params, context));
 
-  iter = std::make_unique<AnalyticTupleIterator>(
-      params, partition_keys(), order_keys(), analytic_args(), std::move(iter),
-      std::move(partition_comparator), CreateOutputSchema(), context);
+  // If every argument can be computed from the rows read so far, stream the
+  // input instead of buffering each partition.
+  std::vector<std::unique_ptr<StreamingAnalyticArgEvaluator>> evaluators;
+  for (const AnalyticArg* arg : analytic_args()) {
+    ZETASQL_ASSIGN_OR_RETURN(
+        std::unique_ptr<StreamingAnalyticArgEvaluator> evaluator,
+        arg->CreateStreamingEvaluator(order_keys(), params, context));
+    if (evaluator == nullptr) {
+      evaluators.clear();
+      break;
+    }
+    evaluators.push_back(std::move(evaluator));
+  }
+  if (!evaluators.empty()) {
+    iter = std::make_unique<StreamingAnalyticTupleIterator>(
+        partition_keys(), std::move(evaluators), std::move(iter),
+        std::move(partition_comparator), CreateOutputSchema(), context);
+  } else {
+    iter = std::make_unique<AnalyticTupleIterator>(
+        params, partition_keys(), order_keys(), analytic_args(),
+        std::move(iter), std::move(partition_comparator), CreateOutputSchema(),
+        context);
+  }
   if (is_order_preserving()) {
     return iter;
   } else {
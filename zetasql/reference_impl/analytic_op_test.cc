@@ -64,6 +64,7 @@ using ::testing::ElementsAre;
 using ::testing::HasSubstr;
 using ::testing::TestWithParam;
 using ::testing::ValuesIn;
+using ::zetasql_base::testing::IsOkAndHolds;
 using ::zetasql_base::testing::StatusIs;
 
 namespace zetasql {
@@ -3232,6 +3233,71 @@ void AddColumn(const VariableId& var, absl::Span<const Value> column_values,
   }
 }
 
+// Evaluates an aggregate over the windows of 'frame' on a partition with one
+// INT64 column, using the incremental path when the aggregate supports it.
+static absl::StatusOr<std::vector<Value>> EvalAggregateOverWindows(
+    FunctionKind kind, AnalyticWindowFrameParam frame,
+    absl::Span<const Value> column) {
+  const VariableId c("c");
+  ZETASQL_ASSIGN_OR_RETURN(auto deref_c, DerefExpr::Create(c, Int64Type()));
+  std::vector<std::unique_ptr<ValueExpr>> args;
+  args.push_back(std::move(deref_c));
+  ZETASQL_ASSIGN_OR_RETURN(auto agg,
+                   AggregateArg::Create(
+                       VariableId("agg"),
+                       std::make_unique<BuiltinAggregateFunction>(
+                           kind, Int64Type(), /*num_input_fields=*/1,
+                           Int64Type()),
+                       std::move(args)));
+  ZETASQL_ASSIGN_OR_RETURN(
+      auto analytic,
+      AggregateAnalyticArg::Create(
+          AnalyticWindowTest::CreateWindowFrameFromParam(frame),
+          std::move(agg), DEFAULT_ERROR_MODE));
+  const TupleSchema schema({c});
+  ZETASQL_RETURN_IF_ERROR(
+      analytic->SetSchemasForEvaluation(schema, EmptyParamsSchemas()));
+
+  std::vector<std::vector<Value>> input_values;
+  for (const Value& value : column) {
+    input_values.push_back({value});
+  }
+  const std::vector<TupleData> tuples = CreateTestTupleDatas(input_values);
+  EvaluationContext context((EvaluationOptions()));
+  std::vector<Value> values;
+  ZETASQL_RETURN_IF_ERROR(analytic->Eval(GetTupleDataPtrs(tuples),
+                                 /*order_keys=*/{}, EmptyParams(), &context,
+                                 &values));
+  return values;
+}
+
+TEST(AggregateAnalyticArgTest, SlidingWindows) {
+  const std::vector<Value> column = {Int64(3), NullInt64(), Int64(5),
+                                     Int64(1), Int64(4),    Int64(2)};
+  EXPECT_THAT(EvalAggregateOverWindows(
+                  FunctionKind::kMax,
+                  AnalyticWindowTest::CreateOffsetPrecedingOffsetFollowing(
+                      WindowFrameArg::kRows, 1, 1),
+                  column),
+              IsOkAndHolds(ElementsAre(Int64(3), Int64(5), Int64(5), Int64(5),
+                                       Int64(4), Int64(4))));
+  EXPECT_THAT(EvalAggregateOverWindows(
+                  FunctionKind::kSum,
+                  AnalyticWindowTest::CreateOffsetFollowingOffsetFollowing(
+                      WindowFrameArg::kRows, 2, 3),
+                  column),
+              IsOkAndHolds(ElementsAre(Int64(6), Int64(5), Int64(6), Int64(2),
+                                       NullInt64(), NullInt64())));
+  // Consecutive windows do not overlap.
+  EXPECT_THAT(EvalAggregateOverWindows(
+                  FunctionKind::kCount,
+                  AnalyticWindowTest::CreateCurrentRowCurrentRow(
+                      WindowFrameArg::kRows),
+                  column),
+              IsOkAndHolds(ElementsAre(Int64(1), Int64(0), Int64(1), Int64(1),
+                                       Int64(1), Int64(1))));
+}
+
 class AnalyticOpTest : public ::testing::TestWithParam<bool> {};
 
 INSTANTIATE_TEST_SUITE_P(AnalyticOpTests, AnalyticOpTest, ::testing::Bool());
@@ -3538,5 +3604,127 @@ TEST_P(AnalyticOpTest, AnalyticOpTest) {
                        HasSubstr("Out of memory")));
 }
 
+
+// An AnalyticOp whose arguments depend only on the preceding rows of each
+// partition streams its input, so it needs no intermediate memory.
+TEST(AnalyticOpStreamingTest, StreamsCumulativeArguments) {
+  VariableId a("a"), b("b"), c("c");
+  VariableId row_number("row_number"), rank("rank"), dense_rank("dense_rank"),
+      sum("sum");
+  const std::vector<VariableId> input_variables = {a, b, c};
+  const std::vector<TupleData> input_tuples =
+      CreateTestTupleDatas({{Int64(0), Int64(1), Int64(1)},
+                            {Int64(0), Int64(1), Int64(2)},
+                            {Int64(0), Int64(2), NullInt64()},
+                            {Int64(0), Int64(3), Int64(4)},
+                            {Int64(1), Int64(1), Int64(5)},
+                            {Int64(1), Int64(2), Int64(6)}});
+  auto input_op = std::make_unique<TestRelationalOp>(
+      input_variables, input_tuples, /*preserves_order=*/true);
+
+  // ROW_NUMBER() OVER (PARTITION BY a ORDER BY b)
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto analytic1,
+      NonAggregateAnalyticArg::Create(
+          row_number, nullptr /* window_frame */,
+          std::make_unique<RowNumberFunction>(), {} /* non_const_arguments */,
+          {} /* const_arguments */, DEFAULT_ERROR_MODE));
+
+  // RANK() OVER (PARTITION BY a ORDER BY b)
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto analytic2,
+      NonAggregateAnalyticArg::Create(
+          rank, nullptr /* window_frame */, std::make_unique<RankFunction>(),
+          {} /* non_const_arguments */, {} /* const_arguments */,
+          DEFAULT_ERROR_MODE));
+
+  // DENSE_RANK() OVER (PARTITION BY a ORDER BY b)
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto analytic3,
+      NonAggregateAnalyticArg::Create(
+          dense_rank, nullptr /* window_frame */,
+          std::make_unique<DenseRankFunction>(), {} /* non_const_arguments */,
+          {} /* const_arguments */, DEFAULT_ERROR_MODE));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_c, DerefExpr::Create(c, Int64Type()));
+  std::vector<std::unique_ptr<ValueExpr>> sum_args;
+  sum_args.push_back(std::move(deref_c));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto agg,
+      AggregateArg::Create(sum,
+                           std::make_unique<BuiltinAggregateFunction>(
+                               FunctionKind::kSum, Int64Type(),
+                               /*num_input_fields=*/1, Int64Type()),
+                           std::move(sum_args)));
+
+  // SUM(c) OVER (PARTITION BY a ORDER BY b
+  //              ROWS BETWEEN UNBOUNDED PRECEDING AND CURRENT ROW)
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto analytic4,
+      AggregateAnalyticArg::Create(
+          AnalyticWindowTest::CreateWindowFrameFromParam(
+              AnalyticWindowTest::CreateUnboundedPrecedingCurrentRow(
+                  WindowFrameArg::kRows)),
+          std::move(agg), DEFAULT_ERROR_MODE));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_a, DerefExpr::Create(a, Int64Type()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_b, DerefExpr::Create(b, Int64Type()));
+
+  std::vector<std::unique_ptr<KeyArg>> partition_keys;
+  partition_keys.emplace_back(
+      std::make_unique<KeyArg>(a, std::move(deref_a), KeyArg::kNotApplicable));
+
+  std::vector<std::unique_ptr<KeyArg>> order_keys;
+  order_keys.emplace_back(
+      std::make_unique<KeyArg>(b, std::move(deref_b), KeyArg::kAscending));
+
+  std::vector<std::unique_ptr<AnalyticArg>> analytic_args;
+  analytic_args.push_back(std::move(analytic1));
+  analytic_args.push_back(std::move(analytic2));
+  analytic_args.push_back(std::move(analytic3));
+  analytic_args.push_back(std::move(analytic4));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto analytic_op,
+      AnalyticOp::Create(std::move(partition_keys), std::move(order_keys),
+                         std::move(analytic_args), std::move(input_op),
+                         /*preserves_order=*/true));
+  ZETASQL_ASSERT_OK(analytic_op->SetSchemasForEvaluation(EmptyParamsSchemas()));
+
+  std::vector<VariableId> expected_variables = input_variables;
+  std::vector<TupleData> expected_tuples = input_tuples;
+  AddColumn(row_number,
+            {Int64(1), Int64(2), Int64(3), Int64(4), Int64(1), Int64(2)},
+            &expected_variables, &expected_tuples);
+  AddColumn(rank, {Int64(1), Int64(1), Int64(3), Int64(4), Int64(1), Int64(2)},
+            &expected_variables, &expected_tuples);
+  AddColumn(dense_rank,
+            {Int64(1), Int64(1), Int64(2), Int64(3), Int64(1), Int64(2)},
+            &expected_variables, &expected_tuples);
+  AddColumn(sum, {Int64(1), Int64(3), Int64(3), Int64(7), Int64(5), Int64(11)},
+            &expected_variables, &expected_tuples);
+  const TupleSchema expected_output_schema(expected_variables);
+
+  // A memory bound that is too low to buffer a partition does not matter.
+  EvaluationContext context(GetIntermediateMemoryEvaluationOptions(
+      /*total_bytes=*/1));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<TupleIterator> iter,
+      analytic_op->CreateIterator(EmptyParams(),
+                                  /*num_extra_slots=*/1, &context));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::vector<TupleData> data,
+                       ReadFromTupleIterator(iter.get()));
+  ASSERT_EQ(data.size(), expected_tuples.size());
+  for (int i = 0; i < expected_tuples.size(); ++i) {
+    EXPECT_EQ(
+        Tuple(&expected_output_schema, &data[i]).DebugString(),
+        Tuple(&expected_output_schema, &expected_tuples[i]).DebugString());
+    EXPECT_EQ(data[i].num_slots(), expected_output_schema.num_variables() + 1);
+  }
+  // ROW_NUMBER() is not deterministic because of the ties in the first
+  // partition.
+  EXPECT_FALSE(context.IsDeterministicOutput());
+}
+
 }  // namespace
 }  // namespace zetasql
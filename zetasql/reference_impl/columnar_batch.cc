@@ -0,0 +1,214 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/reference_impl/columnar_batch.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/reference_impl/tuple.h"
+#include "zetasql/reference_impl/variable_id.h"
+#include "zetasql/base/check.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+bool TupleColumn::SupportsType(const Type* type) {
+  switch (type->kind()) {
+    case TYPE_INT64:
+    case TYPE_DOUBLE:
+    case TYPE_BOOL:
+    case TYPE_STRING:
+    case TYPE_BYTES:
+      return true;
+    default:
+      return false;
+  }
+}
+
+TupleColumn::TupleColumn(const Type* type) : type_(type) {
+  ABSL_DCHECK(SupportsType(type)) << type->DebugString();
+}
+
+void TupleColumn::Resize(int size) {
+  size_ = size;
+  validity_.assign((size + kBitsPerWord - 1) / kBitsPerWord, 0);
+  switch (type_kind()) {
+    case TYPE_INT64:
+      int64_values_.resize(size);
+      break;
+    case TYPE_DOUBLE:
+      double_values_.resize(size);
+      break;
+    case TYPE_BOOL:
+      bool_values_.resize(size);
+      break;
+    case TYPE_STRING:
+    case TYPE_BYTES:
+      string_values_.resize(size);
+      break;
+    default:
+      ABSL_LOG(FATAL) << "Unsupported type: " << type_->DebugString();
+  }
+}
+
+void TupleColumn::Append(const Value& value) {
+  ABSL_DCHECK(value.type()->Equals(type_));
+  const int i = size_;
+  ++size_;
+  if (size_ > validity_.size() * kBitsPerWord) {
+    validity_.push_back(0);
+  }
+  switch (type_kind()) {
+    case TYPE_INT64:
+      int64_values_.resize(size_);
+      if (!value.is_null()) int64_values_[i] = value.int64_value();
+      break;
+    case TYPE_DOUBLE:
+      double_values_.resize(size_);
+      if (!value.is_null()) double_values_[i] = value.double_value();
+      break;
+    case TYPE_BOOL:
+      bool_values_.resize(size_);
+      if (!value.is_null()) bool_values_[i] = value.bool_value();
+      break;
+    case TYPE_STRING:
+      string_values_.resize(size_);
+      if (!value.is_null()) string_values_[i] = value.string_value();
+      break;
+    case TYPE_BYTES:
+      string_values_.resize(size_);
+      if (!value.is_null()) string_values_[i] = value.bytes_value();
+      break;
+    default:
+      ABSL_LOG(FATAL) << "Unsupported type: " << type_->DebugString();
+  }
+  if (value.is_null()) {
+    SetNull(i);
+  } else {
+    SetValid(i);
+  }
+}
+
+Value TupleColumn::GetValue(int i) const {
+  ABSL_DCHECK_LT(i, size_);
+  if (IsNull(i)) return Value::Null(type_);
+  switch (type_kind()) {
+    case TYPE_INT64:
+      return Value::Int64(int64_values_[i]);
+    case TYPE_DOUBLE:
+      return Value::Double(double_values_[i]);
+    case TYPE_BOOL:
+      return Value::Bool(bool_values_[i] != 0);
+    case TYPE_STRING:
+      return Value::String(string_values_[i]);
+    case TYPE_BYTES:
+      return Value::Bytes(string_values_[i]);
+    default:
+      ABSL_LOG(FATAL) << "Unsupported type: " << type_->DebugString();
+  }
+}
+
+void TupleColumn::SetValidityToIntersection(const TupleColumn& x,
+                                            const TupleColumn& y) {
+  ABSL_DCHECK_EQ(x.size(), size_);
+  ABSL_DCHECK_EQ(y.size(), size_);
+  for (int i = 0; i < validity_.size(); ++i) {
+    validity_[i] = x.validity_[i] & y.validity_[i];
+  }
+}
+
+void TupleColumn::SetValidityFrom(const TupleColumn& x) {
+  ABSL_DCHECK_EQ(x.size(), size_);
+  validity_ = x.validity_;
+}
+
+void TupleColumn::SetAllValid() {
+  std::fill(validity_.begin(), validity_.end(), ~uint64_t{0});
+}
+
+bool TupleColumn::HasNulls() const {
+  const int num_full_words = size_ / kBitsPerWord;
+  for (int i = 0; i < num_full_words; ++i) {
+    if (validity_[i] != ~uint64_t{0}) return true;
+  }
+  const int num_remaining_bits = size_ % kBitsPerWord;
+  if (num_remaining_bits == 0) return false;
+  const uint64_t mask = (uint64_t{1} << num_remaining_bits) - 1;
+  return (validity_[num_full_words] & mask) != mask;
+}
+
+ColumnarTupleBatch::ColumnarTupleBatch(
+    const TupleSchema* schema, absl::Span<const Type* const> column_types)
+    : schema_(schema) {
+  ABSL_DCHECK_EQ(column_types.size(), schema->num_variables());
+  columns_.reserve(column_types.size());
+  for (const Type* type : column_types) {
+    if (type != nullptr && TupleColumn::SupportsType(type)) {
+      columns_.push_back(std::make_unique<TupleColumn>(type));
+    } else {
+      columns_.push_back(nullptr);
+    }
+  }
+}
+
+const TupleColumn* ColumnarTupleBatch::column_for_variable(
+    const VariableId& variable) const {
+  const std::optional<int> idx = schema_->FindIndexForVariable(variable);
+  if (!idx.has_value()) return nullptr;
+  return column(idx.value());
+}
+
+absl::Status ColumnarTupleBatch::Load(const TupleDataBatch& batch) {
+  num_rows_ = batch.size();
+  for (int i = 0; i < columns_.size(); ++i) {
+    TupleColumn* column = columns_[i].get();
+    if (column == nullptr) continue;
+    column->Clear();
+    for (const TupleData* row : batch.rows()) {
+      ZETASQL_RET_CHECK_LT(i, row->num_slots());
+      const Value& value = row->slot(i).value();
+      ZETASQL_RET_CHECK(value.type()->Equals(column->type()))
+          << "Column " << i << " of type " << column->type()->DebugString()
+          << " cannot hold a value of type " << value.type()->DebugString();
+      column->Append(value);
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ColumnarTupleBatch::Store(const TupleColumn& column, int slot_idx,
+                                       TupleDataBatch* batch) {
+  ZETASQL_RET_CHECK_EQ(column.size(), batch->size());
+  for (int i = 0; i < batch->size(); ++i) {
+    TupleData* row = batch->row(i);
+    ZETASQL_RET_CHECK_LT(slot_idx, row->num_slots());
+    row->mutable_slot(slot_idx)->SetValue(column.GetValue(i));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace zetasql
@@ -0,0 +1,180 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Columnar representation of a TupleDataBatch. Instead of one heap-allocated
+// Value per slot, each column of simple type is stored as a dense array of
+// native values plus a validity bitmap, so that kernels (e.g.,
+// BuiltinScalarFunction::EvalColumns()) can run tight loops over contiguous
+// memory.
+
+#ifndef ZETASQL_REFERENCE_IMPL_COLUMNAR_BATCH_H_
+#define ZETASQL_REFERENCE_IMPL_COLUMNAR_BATCH_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/reference_impl/tuple.h"
+#include "zetasql/reference_impl/variable_id.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+namespace zetasql {
+
+// A column of values of a single simple type. NULLs are represented by a
+// cleared bit in the validity bitmap; the corresponding element of the value
+// array is unspecified.
+//
+// STRING and BYTES columns store absl::string_views that point into the Values
+// they were appended from, so those Values must outlive the column.
+class TupleColumn {
+ public:
+  // Returns true if 'type' can be stored in a TupleColumn. Only INT64, DOUBLE,
+  // BOOL, STRING and BYTES are supported.
+  static bool SupportsType(const Type* type);
+
+  // 'type' must satisfy SupportsType().
+  explicit TupleColumn(const Type* type);
+
+  TupleColumn(const TupleColumn&) = delete;
+  TupleColumn& operator=(const TupleColumn&) = delete;
+
+  const Type* type() const { return type_; }
+  TypeKind type_kind() const { return type_->kind(); }
+
+  int size() const { return size_; }
+
+  // Removes all the values. Memory is retained for reuse.
+  void Clear() { Resize(0); }
+
+  // Sets the number of values to 'size'. All the values are NULL afterwards;
+  // the caller is expected to fill in the value array and call SetValid() on
+  // the non-NULL elements.
+  void Resize(int size);
+
+  // Appends 'value', which must have type 'type()'.
+  void Append(const Value& value);
+
+  // Returns the 'i'-th value. STRING and BYTES payloads are copied.
+  Value GetValue(int i) const;
+
+  bool IsNull(int i) const {
+    return (validity_[i / kBitsPerWord] & (uint64_t{1} << (i % kBitsPerWord))) ==
+           0;
+  }
+  void SetValid(int i) {
+    validity_[i / kBitsPerWord] |= uint64_t{1} << (i % kBitsPerWord);
+  }
+  void SetNull(int i) {
+    validity_[i / kBitsPerWord] &= ~(uint64_t{1} << (i % kBitsPerWord));
+  }
+
+  // Sets the validity bitmap of this column to the conjunction of those of
+  // 'x' and 'y', which must have the same size as this column. This is the
+  // NULL semantics of most scalar functions.
+  void SetValidityToIntersection(const TupleColumn& x, const TupleColumn& y);
+
+  // Copies the validity bitmap of 'x', which must have the same size as this
+  // column.
+  void SetValidityFrom(const TupleColumn& x);
+
+  // Marks every value as non-NULL.
+  void SetAllValid();
+
+  // Returns true if any value is NULL.
+  bool HasNulls() const;
+
+  // Typed views of the value array. Only the one matching 'type_kind()' may be
+  // used. BOOL values are stored as 0 or 1.
+  absl::Span<const int64_t> int64_values() const { return int64_values_; }
+  absl::Span<int64_t> mutable_int64_values() {
+    return absl::MakeSpan(int64_values_);
+  }
+  absl::Span<const double> double_values() const { return double_values_; }
+  absl::Span<double> mutable_double_values() {
+    return absl::MakeSpan(double_values_);
+  }
+  absl::Span<const uint8_t> bool_values() const { return bool_values_; }
+  absl::Span<uint8_t> mutable_bool_values() {
+    return absl::MakeSpan(bool_values_);
+  }
+  absl::Span<const absl::string_view> string_values() const {
+    return string_values_;
+  }
+
+ private:
+  static constexpr int kBitsPerWord = 64;
+
+  const Type* type_;
+  int size_ = 0;
+  // Bit 'i' is set if the 'i'-th value is not NULL.
+  std::vector<uint64_t> validity_;
+  std::vector<int64_t> int64_values_;
+  std::vector<double> double_values_;
+  std::vector<uint8_t> bool_values_;
+  std::vector<absl::string_view> string_values_;
+};
+
+// A columnar copy of (some of) the slots of a TupleDataBatch. Column 'i'
+// corresponds to variable 'i' of the schema and to slot 'i' of the rows.
+// Columns whose type is not supported by TupleColumn are not materialized,
+// and callers must read them from the rows instead.
+class ColumnarTupleBatch {
+ public:
+  // 'column_types[i]' is the type of variable 'i' of 'schema', or NULL if that
+  // column should not be materialized.
+  ColumnarTupleBatch(const TupleSchema* schema,
+                     absl::Span<const Type* const> column_types);
+
+  ColumnarTupleBatch(const ColumnarTupleBatch&) = delete;
+  ColumnarTupleBatch& operator=(const ColumnarTupleBatch&) = delete;
+
+  const TupleSchema& schema() const { return *schema_; }
+
+  int num_columns() const { return static_cast<int>(columns_.size()); }
+  int num_rows() const { return num_rows_; }
+
+  // Returns NULL if column 'i' is not materialized.
+  const TupleColumn* column(int i) const { return columns_[i].get(); }
+  TupleColumn* mutable_column(int i) { return columns_[i].get(); }
+
+  // Returns the column for 'variable', or NULL if 'variable' is not in the
+  // schema or its column is not materialized.
+  const TupleColumn* column_for_variable(const VariableId& variable) const;
+
+  // Replaces the contents of the materialized columns with the corresponding
+  // slots of the rows of 'batch'. The Values in 'batch' must outlive any use
+  // of STRING or BYTES columns.
+  absl::Status Load(const TupleDataBatch& batch);
+
+  // Overwrites slot 'slot_idx' of each row of 'batch' with the corresponding
+  // value of 'column', which must have exactly one value per row.
+  static absl::Status Store(const TupleColumn& column, int slot_idx,
+                            TupleDataBatch* batch);
+
+ private:
+  const TupleSchema* schema_;
+  std::vector<std::unique_ptr<TupleColumn>> columns_;
+  int num_rows_ = 0;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_REFERENCE_IMPL_COLUMNAR_BATCH_H_
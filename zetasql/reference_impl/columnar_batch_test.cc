@@ -0,0 +1,412 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/reference_impl/columnar_batch.h"
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/types/type_factory.h"
+#include "zetasql/public/value.h"
+#include "zetasql/reference_impl/columnar_kernels.h"
+#include "zetasql/reference_impl/evaluation.h"
+#include "zetasql/reference_impl/function.h"
+#include "zetasql/reference_impl/tuple.h"
+#include "zetasql/reference_impl/tuple_test_util.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+
+namespace zetasql {
+namespace {
+
+using ::testing::HasSubstr;
+using ::zetasql_base::testing::StatusIs;
+
+// Returns a column of type 'type' holding 'values'.
+std::unique_ptr<TupleColumn> MakeColumn(const Type* type,
+                                        absl::Span<const Value> values) {
+  auto column = std::make_unique<TupleColumn>(type);
+  for (const Value& value : values) {
+    column->Append(value);
+  }
+  return column;
+}
+
+std::vector<Value> GetValues(const TupleColumn& column) {
+  std::vector<Value> values;
+  for (int i = 0; i < column.size(); ++i) {
+    values.push_back(column.GetValue(i));
+  }
+  return values;
+}
+
+TEST(TupleColumn, SupportsType) {
+  EXPECT_TRUE(TupleColumn::SupportsType(types::Int64Type()));
+  EXPECT_TRUE(TupleColumn::SupportsType(types::DoubleType()));
+  EXPECT_TRUE(TupleColumn::SupportsType(types::BoolType()));
+  EXPECT_TRUE(TupleColumn::SupportsType(types::StringType()));
+  EXPECT_TRUE(TupleColumn::SupportsType(types::BytesType()));
+  EXPECT_FALSE(TupleColumn::SupportsType(types::Int32Type()));
+  EXPECT_FALSE(TupleColumn::SupportsType(types::NumericType()));
+  EXPECT_FALSE(TupleColumn::SupportsType(types::Int64ArrayType()));
+}
+
+TEST(TupleColumn, AppendAndGetValue) {
+  // Cross a word boundary of the validity bitmap.
+  std::vector<Value> values;
+  for (int i = 0; i < 70; ++i) {
+    values.push_back(i % 3 == 0 ? Value::NullInt64() : Value::Int64(i));
+  }
+  std::unique_ptr<TupleColumn> column =
+      MakeColumn(types::Int64Type(), values);
+  EXPECT_EQ(column->size(), 70);
+  EXPECT_TRUE(column->HasNulls());
+  EXPECT_TRUE(column->IsNull(0));
+  EXPECT_FALSE(column->IsNull(1));
+  EXPECT_TRUE(column->IsNull(69));
+  EXPECT_EQ(column->int64_values()[68], 68);
+  EXPECT_EQ(GetValues(*column), values);
+
+  const std::vector<Value> strings = {Value::String("a"), Value::NullString(),
+                                      Value::String("bc")};
+  std::unique_ptr<TupleColumn> string_column =
+      MakeColumn(types::StringType(), strings);
+  EXPECT_EQ(string_column->string_values()[2], "bc");
+  EXPECT_EQ(GetValues(*string_column), strings);
+
+  string_column->Clear();
+  EXPECT_EQ(string_column->size(), 0);
+  EXPECT_FALSE(string_column->HasNulls());
+}
+
+TEST(ColumnarTupleBatch, LoadAndStore) {
+  VariableId a("a"), b("b"), c("c");
+  const TupleSchema schema({a, b, c});
+  std::vector<TupleData> rows = {
+      CreateTestTupleData(
+          {Value::Int64(1), Value::Double(1.5), Value::Int32(1)}),
+      CreateTestTupleData(
+          {Value::NullInt64(), Value::Double(2.5), Value::Int32(2)})};
+  TupleDataBatch batch;
+  for (TupleData& row : rows) {
+    batch.AddRow(&row);
+  }
+
+  ColumnarTupleBatch columnar(
+      &schema, {types::Int64Type(), types::DoubleType(), types::Int32Type()});
+  ZETASQL_ASSERT_OK(columnar.Load(batch));
+  EXPECT_EQ(columnar.num_columns(), 3);
+  EXPECT_EQ(columnar.num_rows(), 2);
+  ASSERT_NE(columnar.column(0), nullptr);
+  EXPECT_EQ(GetValues(*columnar.column(0)),
+            std::vector<Value>({Value::Int64(1), Value::NullInt64()}));
+  EXPECT_EQ(columnar.column_for_variable(b), columnar.column(1));
+  // INT32 is not supported, so the column is not materialized.
+  EXPECT_EQ(columnar.column(2), nullptr);
+  EXPECT_EQ(columnar.column_for_variable(VariableId("d")), nullptr);
+
+  ZETASQL_ASSERT_OK(ColumnarTupleBatch::Store(*columnar.column(1), /*slot_idx=*/0,
+                                      &batch));
+  EXPECT_EQ(rows[0].slot(0).value(), Value::Double(1.5));
+  EXPECT_EQ(rows[1].slot(0).value(), Value::Double(2.5));
+
+  // Loading slots with the wrong type fails.
+  ColumnarTupleBatch mistyped(
+      &schema, {types::StringType(), nullptr, nullptr});
+  EXPECT_THAT(mistyped.Load(batch), StatusIs(absl::StatusCode::kInternal));
+}
+
+// Checks that EvalColumns() on 'x' and 'y' produces the same results as
+// calling Eval() on each row.
+void ExpectColumnarMatchesRowwise(const BuiltinScalarFunction& fn,
+                                  absl::Span<const Value> x,
+                                  absl::Span<const Value> y) {
+  ASSERT_EQ(x.size(), y.size());
+  EvaluationContext context((EvaluationOptions()));
+  std::unique_ptr<TupleColumn> x_column = MakeColumn(x[0].type(), x);
+  std::unique_ptr<TupleColumn> y_column = MakeColumn(y[0].type(), y);
+  ASSERT_TRUE(fn.SupportsEvalColumns({x[0].type(), y[0].type()}));
+
+  TupleColumn result(fn.output_type());
+  absl::Status status;
+  ASSERT_TRUE(fn.EvalColumns({x_column.get(), y_column.get()}, &context,
+                             &result, &status))
+      << status;
+  ASSERT_EQ(result.size(), x.size());
+  for (int i = 0; i < x.size(); ++i) {
+    Value expected;
+    ASSERT_TRUE(fn.Eval(/*params=*/{}, {x[i], y[i]}, &context, &expected,
+                        &status))
+        << status;
+    EXPECT_EQ(result.GetValue(i), expected)
+        << fn.debug_name() << "(" << x[i] << ", " << y[i] << ")";
+  }
+}
+
+TEST(EvalColumns, Arithmetic) {
+  const std::vector<Value> x = {Value::Int64(1), Value::NullInt64(),
+                                Value::Int64(-7), Value::Int64(100)};
+  const std::vector<Value> y = {Value::Int64(2), Value::Int64(3),
+                                Value::NullInt64(), Value::Int64(-100)};
+  for (FunctionKind kind : {FunctionKind::kAdd, FunctionKind::kSubtract,
+                            FunctionKind::kMultiply}) {
+    ExpectColumnarMatchesRowwise(ArithmeticFunction(kind, types::Int64Type()),
+                                 x, y);
+  }
+
+  const std::vector<Value> dx = {Value::Double(1.5), Value::NullDouble(),
+                                 Value::Double(-7)};
+  const std::vector<Value> dy = {Value::Double(0.5), Value::Double(3),
+                                 Value::Double(2)};
+  for (FunctionKind kind : {FunctionKind::kAdd, FunctionKind::kSubtract,
+                            FunctionKind::kMultiply, FunctionKind::kDivide}) {
+    ExpectColumnarMatchesRowwise(ArithmeticFunction(kind, types::DoubleType()),
+                                 dx, dy);
+  }
+}
+
+TEST(EvalColumns, ArithmeticError) {
+  EvaluationContext context((EvaluationOptions()));
+  ArithmeticFunction add(FunctionKind::kAdd, types::Int64Type());
+  std::unique_ptr<TupleColumn> x = MakeColumn(
+      types::Int64Type(),
+      {Value::Int64(1), Value::Int64(std::numeric_limits<int64_t>::max())});
+  std::unique_ptr<TupleColumn> y =
+      MakeColumn(types::Int64Type(), {Value::Int64(1), Value::Int64(1)});
+  TupleColumn result(types::Int64Type());
+  absl::Status status;
+  EXPECT_FALSE(add.EvalColumns({x.get(), y.get()}, &context, &result, &status));
+  EXPECT_THAT(status, StatusIs(absl::StatusCode::kOutOfRange,
+                               HasSubstr("int64 overflow")));
+
+  // Overflow in a NULL row is not an error.
+  x->SetNull(1);
+  status = absl::OkStatus();
+  EXPECT_TRUE(add.EvalColumns({x.get(), y.get()}, &context, &result, &status));
+  EXPECT_TRUE(result.IsNull(1));
+}
+
+TEST(EvalColumns, Comparison) {
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const std::vector<std::vector<Value>> inputs[] = {
+      {{Value::Int64(1), Value::Int64(2), Value::NullInt64(), Value::Int64(3)},
+       {Value::Int64(1), Value::Int64(1), Value::Int64(4), Value::Int64(5)}},
+      {{Value::Double(1), Value::Double(nan), Value::Double(-0.0)},
+       {Value::Double(2), Value::Double(nan), Value::Double(0.0)}},
+      {{Value::Bool(true), Value::Bool(false), Value::NullBool()},
+       {Value::Bool(false), Value::Bool(false), Value::Bool(true)}},
+      {{Value::String("a"), Value::String("b"), Value::String("\xc3\xa9")},
+       {Value::String("b"), Value::String("b"), Value::String("z")}},
+  };
+  for (const std::vector<std::vector<Value>>& input : inputs) {
+    for (FunctionKind kind : {FunctionKind::kEqual, FunctionKind::kLess,
+                              FunctionKind::kLessOrEqual}) {
+      ExpectColumnarMatchesRowwise(ComparisonFunction(kind, types::BoolType()),
+                                   input[0], input[1]);
+    }
+  }
+}
+
+TEST(ColumnarKernels, Int64Overflow) {
+  constexpr int64_t kMax = std::numeric_limits<int64_t>::max();
+  constexpr int64_t kMin = std::numeric_limits<int64_t>::lowest();
+  std::vector<int64_t> out(3);
+  EXPECT_FALSE(columnar_kernels::AddInt64({1, -5, kMax}, {2, 5, 0},
+                                          absl::MakeSpan(out)));
+  EXPECT_EQ(out, std::vector<int64_t>({3, 0, kMax}));
+  EXPECT_TRUE(columnar_kernels::AddInt64({1, kMax, 0}, {2, 1, 0},
+                                         absl::MakeSpan(out)));
+  EXPECT_TRUE(columnar_kernels::AddInt64({kMin, 0, 0}, {-1, 0, 0},
+                                         absl::MakeSpan(out)));
+  EXPECT_FALSE(columnar_kernels::SubtractInt64({kMin, 0, 5}, {0, kMax, 7},
+                                               absl::MakeSpan(out)));
+  EXPECT_EQ(out, std::vector<int64_t>({kMin, -kMax, -2}));
+  EXPECT_TRUE(columnar_kernels::SubtractInt64({0, 0, 0}, {0, kMin, 0},
+                                              absl::MakeSpan(out)));
+  EXPECT_FALSE(columnar_kernels::MultiplyInt64({0, -1, 3}, {kMin, kMax, 4},
+                                               absl::MakeSpan(out)));
+  EXPECT_TRUE(columnar_kernels::MultiplyInt64({-1, 0, 0}, {kMin, 0, 0},
+                                              absl::MakeSpan(out)));
+}
+
+TEST(ColumnarKernels, SumInt64) {
+  constexpr int64_t kMax = std::numeric_limits<int64_t>::max();
+  constexpr int64_t kMin = std::numeric_limits<int64_t>::lowest();
+  EXPECT_TRUE(columnar_kernels::SumInt64({}) == 0);
+  EXPECT_TRUE(columnar_kernels::SumInt64({1, -5, 7}) == 3);
+  std::vector<int64_t> values(1000, kMax);
+  EXPECT_TRUE(columnar_kernels::SumInt64(values) ==
+              static_cast<__int128>(kMax) * 1000);
+  values.assign(1001, kMin);
+  values.back() = -1;
+  EXPECT_TRUE(columnar_kernels::SumInt64(values) ==
+              static_cast<__int128>(kMin) * 1000 - 1);
+}
+
+TEST(ColumnarKernels, Double) {
+  const double inf = std::numeric_limits<double>::infinity();
+  const double max = std::numeric_limits<double>::max();
+  std::vector<double> out(2);
+  EXPECT_FALSE(columnar_kernels::BinaryDouble(std::plus<double>(), {1, 2},
+                                              {3, 4}, absl::MakeSpan(out)));
+  EXPECT_EQ(out, std::vector<double>({4, 6}));
+  EXPECT_TRUE(columnar_kernels::BinaryDouble(std::plus<double>(), {1, max},
+                                             {3, max}, absl::MakeSpan(out)));
+  EXPECT_TRUE(columnar_kernels::BinaryDouble(std::plus<double>(), {1, inf},
+                                             {3, 0}, absl::MakeSpan(out)));
+  EXPECT_TRUE(
+      columnar_kernels::DivideDouble({1, 2}, {3, 0}, absl::MakeSpan(out)));
+}
+
+TEST(EvalColumns, ArithmeticRecheck) {
+  // Infinite inputs make the kernel report possible overflow, but the
+  // scalar re-check accepts them.
+  const double inf = std::numeric_limits<double>::infinity();
+  ExpectColumnarMatchesRowwise(
+      ArithmeticFunction(FunctionKind::kAdd, types::DoubleType()),
+      {Value::Double(inf), Value::Double(1)},
+      {Value::Double(1), Value::Double(2)});
+
+  // Division by zero in a NULL row is not an error.
+  EvaluationContext context((EvaluationOptions()));
+  ArithmeticFunction divide(FunctionKind::kDivide, types::DoubleType());
+  std::unique_ptr<TupleColumn> x = MakeColumn(
+      types::DoubleType(), {Value::Double(1), Value::NullDouble()});
+  std::unique_ptr<TupleColumn> y =
+      MakeColumn(types::DoubleType(), {Value::Double(2), Value::Double(0)});
+  TupleColumn result(types::DoubleType());
+  absl::Status status;
+  ASSERT_TRUE(
+      divide.EvalColumns({x.get(), y.get()}, &context, &result, &status));
+  EXPECT_EQ(GetValues(result),
+            std::vector<Value>({Value::Double(0.5), Value::NullDouble()}));
+
+  // But it is an error in a non-NULL row.
+  y = MakeColumn(types::DoubleType(), {Value::Double(0), Value::Double(0)});
+  EXPECT_FALSE(
+      divide.EvalColumns({x.get(), y.get()}, &context, &result, &status));
+  EXPECT_THAT(status, StatusIs(absl::StatusCode::kOutOfRange,
+                               HasSubstr("division by zero")));
+}
+
+TEST(EvalColumns, Logical) {
+  // All 9 combinations of TRUE, FALSE and NULL.
+  std::vector<Value> x, y;
+  for (const Value& a : {Value::Bool(true), Value::Bool(false),
+                         Value::NullBool()}) {
+    for (const Value& b : {Value::Bool(true), Value::Bool(false),
+                           Value::NullBool()}) {
+      x.push_back(a);
+      y.push_back(b);
+    }
+  }
+  ExpectColumnarMatchesRowwise(
+      LogicalFunction(FunctionKind::kAnd, types::BoolType()), x, y);
+  ExpectColumnarMatchesRowwise(
+      LogicalFunction(FunctionKind::kOr, types::BoolType()), x, y);
+
+  EvaluationContext context((EvaluationOptions()));
+  LogicalFunction not_fn(FunctionKind::kNot, types::BoolType());
+  std::unique_ptr<TupleColumn> column = MakeColumn(types::BoolType(), x);
+  ASSERT_TRUE(not_fn.SupportsEvalColumns({types::BoolType()}));
+  TupleColumn result(types::BoolType());
+  absl::Status status;
+  ASSERT_TRUE(not_fn.EvalColumns({column.get()}, &context, &result, &status));
+  for (int i = 0; i < x.size(); ++i) {
+    Value expected;
+    ASSERT_TRUE(not_fn.Eval(/*params=*/{}, {x[i]}, &context, &expected,
+                            &status));
+    EXPECT_EQ(result.GetValue(i), expected);
+  }
+}
+
+TEST(EvalColumns, Is) {
+  EvaluationContext context((EvaluationOptions()));
+  const std::vector<Value> values = {Value::Bool(true), Value::Bool(false),
+                                     Value::NullBool()};
+  std::unique_ptr<TupleColumn> column = MakeColumn(types::BoolType(), values);
+  for (FunctionKind kind : {FunctionKind::kIsNull, FunctionKind::kIsTrue,
+                            FunctionKind::kIsFalse}) {
+    IsFunction fn(kind, types::BoolType());
+    ASSERT_TRUE(fn.SupportsEvalColumns({types::BoolType()}));
+    TupleColumn result(types::BoolType());
+    absl::Status status;
+    ASSERT_TRUE(fn.EvalColumns({column.get()}, &context, &result, &status));
+    EXPECT_FALSE(result.HasNulls());
+    for (int i = 0; i < values.size(); ++i) {
+      Value expected;
+      ASSERT_TRUE(
+          fn.Eval(/*params=*/{}, {values[i]}, &context, &expected, &status));
+      EXPECT_EQ(result.GetValue(i), expected);
+    }
+  }
+  EXPECT_FALSE(IsFunction(FunctionKind::kIsTrue, types::BoolType())
+                   .SupportsEvalColumns({types::Int64Type()}));
+}
+
+TEST(EvalColumns, NetParseIP) {
+  EvaluationContext context((EvaluationOptions()));
+  NetFunction parse_ip(FunctionKind::kNetParseIP, types::Int64Type());
+  ASSERT_TRUE(parse_ip.SupportsEvalColumns({types::StringType()}));
+  EXPECT_FALSE(NetFunction(FunctionKind::kNetFormatIP, types::StringType())
+                   .SupportsEvalColumns({types::Int64Type()}));
+
+  for (const std::vector<Value>& values :
+       {std::vector<Value>{Value::String("1.2.3.4"),
+                           Value::String("255.255.255.255")},
+        std::vector<Value>{Value::String("0.0.0.1"), Value::NullString(),
+                           Value::String("10.0.0.0")}}) {
+    std::unique_ptr<TupleColumn> column =
+        MakeColumn(types::StringType(), values);
+    TupleColumn result(types::Int64Type());
+    absl::Status status;
+    ASSERT_TRUE(
+        parse_ip.EvalColumns({column.get()}, &context, &result, &status))
+        << status;
+    for (int i = 0; i < values.size(); ++i) {
+      Value expected;
+      ASSERT_TRUE(parse_ip.Eval(/*params=*/{}, {values[i]}, &context,
+                                &expected, &status));
+      EXPECT_EQ(result.GetValue(i), expected);
+    }
+  }
+
+  std::unique_ptr<TupleColumn> bad = MakeColumn(
+      types::StringType(), {Value::String("1.2.3.4"), Value::String("x")});
+  TupleColumn result(types::Int64Type());
+  absl::Status status;
+  EXPECT_FALSE(parse_ip.EvalColumns({bad.get()}, &context, &result, &status));
+  EXPECT_THAT(status, StatusIs(absl::StatusCode::kOutOfRange,
+                               HasSubstr("unparseable IP-address")));
+}
+
+TEST(EvalColumns, Unsupported) {
+  ArithmeticFunction add(FunctionKind::kAdd, types::NumericType());
+  EXPECT_FALSE(
+      add.SupportsEvalColumns({types::NumericType(), types::NumericType()}));
+  ArithmeticFunction mod(FunctionKind::kMod, types::Int64Type());
+  EXPECT_FALSE(mod.SupportsEvalColumns({types::Int64Type(), types::Int64Type()}));
+  ComparisonFunction less(FunctionKind::kLess, types::BoolType());
+  EXPECT_FALSE(
+      less.SupportsEvalColumns({types::Int64Type(), types::DoubleType()}));
+}
+
+}  // namespace
+}  // namespace zetasql
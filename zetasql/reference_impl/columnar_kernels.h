@@ -0,0 +1,176 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Elementwise kernels over the dense arrays of a TupleColumn. They back the
+// BuiltinScalarFunction::EvalColumns() overrides, which ComputeOp and FilterOp
+// reach through ScalarFunctionCallExpr::EvalBatch() when reading in batches.
+//
+// The kernels are written as branch-free loops over contiguous memory so that
+// the compiler can vectorize them for whatever instruction set the build
+// targets (SSE/AVX2 on x86, NEON on ARM), without intrinsics. They do not
+// report errors per element. Instead, arithmetic kernels return true if some
+// element *might* have failed (e.g., overflowed), in which case the caller
+// re-checks the valid rows with the scalar functions from
+// public/functions/arithmetics.h to produce the exact error.
+//
+// Elements corresponding to NULL rows are computed as well and must be
+// ignored by the caller.
+
+#ifndef ZETASQL_REFERENCE_IMPL_COLUMNAR_KERNELS_H_
+#define ZETASQL_REFERENCE_IMPL_COLUMNAR_KERNELS_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "zetasql/base/check.h"
+#include "absl/base/casts.h"
+#include "absl/types/span.h"
+
+namespace zetasql {
+namespace columnar_kernels {
+
+// Sets 'out[i]' to 'x[i] + y[i]', wrapping on overflow. Returns true if any
+// element overflowed.
+inline bool AddInt64(absl::Span<const int64_t> x, absl::Span<const int64_t> y,
+                     absl::Span<int64_t> out) {
+  ABSL_DCHECK_EQ(x.size(), out.size());
+  ABSL_DCHECK_EQ(y.size(), out.size());
+  uint64_t overflow = 0;
+  for (size_t i = 0; i < out.size(); ++i) {
+    const uint64_t a = static_cast<uint64_t>(x[i]);
+    const uint64_t b = static_cast<uint64_t>(y[i]);
+    const uint64_t r = a + b;
+    // Overflow iff the operands have the same sign and the result does not.
+    overflow |= (a ^ r) & (b ^ r);
+    out[i] = static_cast<int64_t>(r);
+  }
+  return (overflow >> 63) != 0;
+}
+
+// Sets 'out[i]' to 'x[i] - y[i]', wrapping on overflow. Returns true if any
+// element overflowed.
+inline bool SubtractInt64(absl::Span<const int64_t> x,
+                          absl::Span<const int64_t> y,
+                          absl::Span<int64_t> out) {
+  ABSL_DCHECK_EQ(x.size(), out.size());
+  ABSL_DCHECK_EQ(y.size(), out.size());
+  uint64_t overflow = 0;
+  for (size_t i = 0; i < out.size(); ++i) {
+    const uint64_t a = static_cast<uint64_t>(x[i]);
+    const uint64_t b = static_cast<uint64_t>(y[i]);
+    const uint64_t r = a - b;
+    // Overflow iff the operands have different signs and the result does not
+    // have the sign of 'a'.
+    overflow |= (a ^ b) & (a ^ r);
+    out[i] = static_cast<int64_t>(r);
+  }
+  return (overflow >> 63) != 0;
+}
+
+// Sets 'out[i]' to 'x[i] * y[i]', wrapping on overflow. Returns true if any
+// element overflowed.
+inline bool MultiplyInt64(absl::Span<const int64_t> x,
+                          absl::Span<const int64_t> y,
+                          absl::Span<int64_t> out) {
+  ABSL_DCHECK_EQ(x.size(), out.size());
+  ABSL_DCHECK_EQ(y.size(), out.size());
+  bool overflow = false;
+  for (size_t i = 0; i < out.size(); ++i) {
+    long long r;  // NOLINT(runtime/int)
+    overflow |= __builtin_smulll_overflow(x[i], y[i], &r);
+    out[i] = static_cast<int64_t>(r);
+  }
+  return overflow;
+}
+
+// Returns the sum of 'values', which cannot overflow. Additions of __int128
+// are not vectorized, so this sums the low 32 bits (unsigned) and the high 32
+// bits (signed) of the elements separately in 64-bit lanes, which cannot
+// overflow for up to 2^32 elements, and combines the two sums per block of
+// that many elements.
+inline __int128 SumInt64(absl::Span<const int64_t> values) {
+  constexpr size_t kBlockSize = size_t{1} << 32;
+  __int128 sum = 0;
+  for (size_t begin = 0; begin < values.size(); begin += kBlockSize) {
+    const size_t end = std::min(values.size(), begin + kBlockSize);
+    uint64_t low = 0;
+    int64_t high = 0;
+    for (size_t i = begin; i < end; ++i) {
+      low += static_cast<uint32_t>(values[i]);
+      high += values[i] >> 32;
+    }
+    sum += static_cast<__int128>(high) * (int64_t{1} << 32) + low;
+  }
+  return sum;
+}
+
+// Returns true if any element of 'values' is infinite or NaN.
+inline bool AnyNonFinite(absl::Span<const double> values) {
+  constexpr uint64_t kExponentMask = uint64_t{0x7ff} << 52;
+  bool non_finite = false;
+  for (size_t i = 0; i < values.size(); ++i) {
+    non_finite |=
+        (absl::bit_cast<uint64_t>(values[i]) & kExponentMask) == kExponentMask;
+  }
+  return non_finite;
+}
+
+// Returns true if any element of 'values' is zero.
+inline bool AnyZero(absl::Span<const double> values) {
+  bool zero = false;
+  for (size_t i = 0; i < values.size(); ++i) {
+    zero |= values[i] == 0;
+  }
+  return zero;
+}
+
+// Sets 'out[i]' to 'op(x[i], y[i])'. Returns true if any result is infinite
+// or NaN, which may be an overflow.
+template <typename Op>
+inline bool BinaryDouble(Op op, absl::Span<const double> x,
+                         absl::Span<const double> y, absl::Span<double> out) {
+  ABSL_DCHECK_EQ(x.size(), out.size());
+  ABSL_DCHECK_EQ(y.size(), out.size());
+  for (size_t i = 0; i < out.size(); ++i) {
+    out[i] = op(x[i], y[i]);
+  }
+  return AnyNonFinite(absl::Span<const double>(out));
+}
+
+// Sets 'out[i]' to 'x[i] / y[i]'. Returns true if any divisor is zero or any
+// result is infinite or NaN.
+inline bool DivideDouble(absl::Span<const double> x,
+                         absl::Span<const double> y, absl::Span<double> out) {
+  if (AnyZero(y)) return true;
+  return BinaryDouble([](double a, double b) { return a / b; }, x, y, out);
+}
+
+// Sets 'out[i]' to 'cmp(x[i], y[i])' (0 or 1).
+template <typename T, typename Cmp>
+inline void Compare(Cmp cmp, absl::Span<const T> x, absl::Span<const T> y,
+                    absl::Span<uint8_t> out) {
+  ABSL_DCHECK_EQ(x.size(), out.size());
+  ABSL_DCHECK_EQ(y.size(), out.size());
+  for (size_t i = 0; i < out.size(); ++i) {
+    out[i] = cmp(x[i], y[i]) ? 1 : 0;
+  }
+}
+
+}  // namespace columnar_kernels
+}  // namespace zetasql
+
+#endif  // ZETASQL_REFERENCE_IMPL_COLUMNAR_KERNELS_H_
@@ -21,9 +21,11 @@
 #include <utility>
 #include <vector>
 
+#include "zetasql/public/options.pb.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/type.pb.h"
 #include "zetasql/public/value.h"
+#include "absl/container/btree_set.h"
 #include "absl/status/status.h"
 #include "absl/types/span.h"
 #include "zetasql/base/ret_check.h"
@@ -31,6 +33,39 @@
 
 namespace zetasql {
 
+// Rewrites for constructs which the reference implementation is not able to
+// successfully execute using a direct implementation, and thus requires the
+// rewriter. These rewrites are enabled for the reference even when using the
+// reference impl as a baseline for compliance tests.
+absl::btree_set<ResolvedASTRewrite> MinimalRewritesForReference() {
+  return {
+      // Probably don't add to this list without a very good reason to do so.
+      // Features that are rewrite *only* without direct implementation support
+      // in the reference implementation are not as well tested as features with
+      // both implementations.
+      // clang-format off
+      // (broken link) start
+      REWRITE_INLINE_SQL_TVFS,
+      // TODO: Remove this after resolving memory leak in direct UDA eval.
+      REWRITE_INLINE_SQL_UDAS,
+      REWRITE_INLINE_SQL_VIEWS,
+      // (broken link) end
+      // clang-format on
+  };
+}
+
+absl::btree_set<ResolvedASTRewrite> RewritesWithNativeSupportInReference() {
+  // The compliance tests run the reference implementation without these
+  // rewrites, so their direct implementations are as well tested.
+  return {
+      REWRITE_FLATTEN,
+      REWRITE_PIVOT,
+      REWRITE_UNPIVOT,
+      REWRITE_WITH_EXPR,
+      REWRITE_BUILTIN_FUNCTION_INLINER,
+  };
+}
+
 absl::Status ValidateTypeSupportsEqualityComparison(const Type* type) {
   switch (type->kind()) {
     case TYPE_INT32:
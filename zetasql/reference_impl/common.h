@@ -22,14 +22,27 @@
 #include <vector>
 
 #include "zetasql/public/collator.h"
+#include "zetasql/public/options.pb.h"
 #include "zetasql/public/type.h"
 #include "zetasql/resolved_ast/resolved_collation.h"
+#include "absl/container/btree_set.h"
 #include "absl/status/status.h"
 #include "absl/types/span.h"
 #include "zetasql/base/status.h"
 
 namespace zetasql {
 
+// Returns the rewrites for constructs which the reference implementation is
+// not able to execute using a direct implementation. Constructs of all the
+// other rewrites are evaluated natively.
+absl::btree_set<ResolvedASTRewrite> MinimalRewritesForReference();
+
+// Returns the rewrites whose constructs the reference implementation evaluates
+// natively with the same results, so that they can be skipped. Constructs of
+// rewrites that are not listed, like REWRITE_ANONYMIZATION, may have no direct
+// implementation.
+absl::btree_set<ResolvedASTRewrite> RewritesWithNativeSupportInReference();
+
 // Returns OK if 'type' supports equality comparison, error status otherwise.
 absl::Status ValidateTypeSupportsEqualityComparison(const Type* type);
 
@@ -0,0 +1,475 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Measures the parser, analyzer and reference implementation on the SQL of
+// the analyzer and compliance test files, to find performance regressions
+// between versions. There is one benchmark per file, e.g.
+// "analyzer/aggregation.test", which processes each statement of the file
+// through the phases that it succeeds in, and reports per iteration:
+//   - parse_us, analyze_us, analyze_no_rewrites_us, algebrize_us,
+//     execute_us: the time of each phase, where analyze_us uses the default
+//     rewrites and analyze_no_rewrites_us none,
+//   - allocs, allocated_bytes: the number and size of heap allocations,
+//   - peak_memory_bytes: the largest MemoryAccountant usage of an execution,
+// and the number of statements that reach each phase.
+//
+// Statements are analyzed with all released language features against the
+// sample catalog, plus the tables that the [prepare_database] cases of a
+// compliance file create. Only queries are algebrized and executed. Cases
+// that fail, like the error cases of the analyzer tests, stop at the phase
+// that fails; cases with options that change how they are analyzed, like
+// [parameters=...], usually fail.
+//
+// To compare two versions, write the results of each as JSON and compare
+// them with the compare.py tool of the benchmark library:
+//   corpus_benchmark --benchmark_out=old.json --benchmark_out_format=json
+//   compare.py benchmarks old.json new.json
+// --benchmark_filter=analyzer/ or =compliance/ selects a corpus.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/base/file_util.h"
+#include "zetasql/parser/parser.h"
+#include "zetasql/public/analyzer.h"
+#include "zetasql/public/analyzer_options.h"
+#include "zetasql/public/analyzer_output.h"
+#include "zetasql/public/evaluator.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/language_options.h"
+#include "zetasql/public/multi_catalog.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/types/type_factory.h"
+#include "zetasql/public/value.h"
+#include "zetasql/reference_impl/operator_profile.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/testdata/sample_catalog.h"
+#include "benchmark/benchmark.h"
+#include "zetasql/base/check.h"
+#include "absl/status/status.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "zetasql/base/path.h"
+#include "re2/re2.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+namespace {
+
+// Counted by the replacement operator new below.
+std::atomic<int64_t> num_allocs{0};
+std::atomic<int64_t> num_allocated_bytes{0};
+
+// The directories of the corpora, relative to the source root, and the
+// prefixes of their benchmark names.
+constexpr struct {
+  const char* name;
+  const char* directory;
+} kCorpora[] = {
+    {"analyzer", "zetasql/analyzer/testdata"},
+    {"compliance", "zetasql/compliance/testdata"},
+};
+
+LanguageOptions CorpusLanguageOptions() {
+  LanguageOptions language_options;
+  language_options.EnableMaximumLanguageFeatures();
+  language_options.SetSupportsAllStatementKinds();
+  return language_options;
+}
+
+// The catalog that all statements are analyzed against. Building it is
+// expensive, so it is shared by all files.
+SimpleCatalog* GetSampleCatalog() {
+  static SampleCatalog* sample_catalog =
+      new SampleCatalog(CorpusLanguageOptions());
+  return sample_catalog->catalog();
+}
+
+// Returns 'sql' with each alternation of the analyzer tests, like
+// "{{KeyValue.|}}", replaced by its first alternative.
+std::string KeepFirstAlternatives(absl::string_view sql) {
+  std::string result;
+  while (true) {
+    const size_t start = sql.find("{{");
+    const size_t end =
+        start == sql.npos ? sql.npos : sql.find("}}", start + 2);
+    if (end == sql.npos) {
+      break;
+    }
+    const absl::string_view alternatives =
+        sql.substr(start + 2, end - start - 2);
+    absl::StrAppend(&result, sql.substr(0, start),
+                    alternatives.substr(0, alternatives.find('|')));
+    sql.remove_prefix(end + 2);
+  }
+  absl::StrAppend(&result, sql);
+  return result;
+}
+
+struct TestCase {
+  std::string sql;
+  // Whether the case has the [prepare_database] option.
+  bool prepare_database = false;
+};
+
+// Splits the contents of a file-based test into the inputs of its cases. The
+// cases are separated by "==" lines, and the input of a case is the text up
+// to its first "--" line, without its leading option and comment lines.
+std::vector<TestCase> SplitTestCases(absl::string_view contents) {
+  std::vector<TestCase> cases;
+  TestCase current;
+  std::vector<absl::string_view> sql_lines;
+  bool in_input = true;
+  auto finish_case = [&]() {
+    current.sql = KeepFirstAlternatives(
+        absl::StripAsciiWhitespace(absl::StrJoin(sql_lines, "\n")));
+    if (!current.sql.empty()) {
+      cases.push_back(std::move(current));
+    }
+    current = TestCase();
+    sql_lines.clear();
+    in_input = true;
+  };
+  for (absl::string_view line : absl::StrSplit(contents, '\n')) {
+    if (line == "==") {
+      finish_case();
+    } else if (!in_input) {
+      continue;
+    } else if (line == "--") {
+      in_input = false;
+    } else if (sql_lines.empty() && absl::StartsWith(line, "[")) {
+      if (absl::StartsWith(line, "[prepare_database")) {
+        current.prepare_database = true;
+      }
+    } else if (sql_lines.empty() &&
+               (absl::StartsWith(line, "#") ||
+                absl::StripAsciiWhitespace(line).empty())) {
+      continue;
+    } else {
+      // A leading backslash escapes lines like "--" and "==".
+      absl::ConsumePrefix(&line, "\\");
+      sql_lines.push_back(line);
+    }
+  }
+  finish_case();
+  return cases;
+}
+
+// A statement of a file, and the phases that it succeeds in.
+struct Statement {
+  std::string sql;
+  bool analyzes = false;
+  bool analyzes_without_rewrites = false;
+  bool algebrizes = false;
+  bool executes = false;
+};
+
+absl::Status ExecuteToEnd(const PreparedQuery& query,
+                          OperatorProfile* profile) {
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> iter,
+                   query.ExecuteAfterPrepareWithProfile(
+                       PreparedQuery::QueryOptions(), profile));
+  while (iter->NextRow()) {
+    for (int i = 0; i < iter->NumColumns(); ++i) {
+      benchmark::DoNotOptimize(iter->GetValue(i));
+    }
+  }
+  return iter->Status();
+}
+
+// The statements of one test file, with the tables of its [prepare_database]
+// cases. Loaded when its benchmark first runs, so that filtered out files
+// cost nothing.
+class CorpusFile {
+ public:
+  explicit CorpusFile(std::string path)
+      : path_(std::move(path)),
+        tables_("prepared_database", &type_factory_),
+        analyzer_options_(CorpusLanguageOptions()),
+        no_rewrites_options_(CorpusLanguageOptions()) {
+    no_rewrites_options_.set_enabled_rewrites({});
+    evaluator_options_.type_factory = &type_factory_;
+  }
+
+  CorpusFile(const CorpusFile&) = delete;
+  CorpusFile& operator=(const CorpusFile&) = delete;
+
+  void Run(benchmark::State& state);
+
+ private:
+  void Load();
+
+  // Creates the table of a [prepare_database] case, which is a
+  // CREATE TABLE ... AS SELECT. Returns false if it is not supported.
+  bool PrepareTable(absl::string_view sql);
+
+  Statement ClassifyStatement(std::string sql);
+
+  const std::string path_;
+  bool loaded_ = false;
+  TypeFactory type_factory_;
+  // The tables of the [prepare_database] cases, shadowing those of the sample
+  // catalog.
+  SimpleCatalog tables_;
+  std::unique_ptr<MultiCatalog> catalog_;
+  AnalyzerOptions analyzer_options_;
+  AnalyzerOptions no_rewrites_options_;
+  EvaluatorOptions evaluator_options_;
+  std::vector<Statement> statements_;
+};
+
+void CorpusFile::Load() {
+  ZETASQL_CHECK_OK(MultiCatalog::Create("corpus", {&tables_, GetSampleCatalog()},
+                                &catalog_));
+  std::string contents;
+  ZETASQL_CHECK_OK(internal::GetContents(path_, &contents));
+  for (TestCase& test_case : SplitTestCases(contents)) {
+    if (test_case.prepare_database) {
+      PrepareTable(test_case.sql);
+    } else {
+      statements_.push_back(ClassifyStatement(std::move(test_case.sql)));
+    }
+  }
+  loaded_ = true;
+}
+
+bool CorpusFile::PrepareTable(absl::string_view sql) {
+  static const LazyRE2 kCreateTableAsSelect = {
+      R"re((?is)\s*CREATE\s+(?:TEMP\s+|TEMPORARY\s+)?TABLE\s+(\w+)\s+AS\s+(.*))re"};
+  std::string name;
+  std::string query_sql;
+  if (!RE2::FullMatch(sql, *kCreateTableAsSelect, &name, &query_sql)) {
+    return false;
+  }
+  PreparedQuery query(query_sql, evaluator_options_);
+  if (!query.Prepare(analyzer_options_, catalog_.get()).ok()) {
+    return false;
+  }
+  absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>> iter =
+      query.Execute();
+  if (!iter.ok()) {
+    return false;
+  }
+  std::vector<SimpleTable::NameAndType> columns;
+  for (int i = 0; i < (*iter)->NumColumns(); ++i) {
+    columns.emplace_back((*iter)->GetColumnName(i), (*iter)->GetColumnType(i));
+  }
+  std::vector<std::vector<Value>> rows;
+  while ((*iter)->NextRow()) {
+    std::vector<Value>& row = rows.emplace_back();
+    for (int i = 0; i < (*iter)->NumColumns(); ++i) {
+      row.push_back((*iter)->GetValue(i));
+    }
+  }
+  if (!(*iter)->Status().ok()) {
+    return false;
+  }
+  auto table = std::make_unique<SimpleTable>(name, columns);
+  table->SetContents(rows);
+  return tables_.AddOwnedTableIfNotPresent(name, std::move(table));
+}
+
+Statement CorpusFile::ClassifyStatement(std::string sql) {
+  Statement statement;
+  statement.sql = std::move(sql);
+  TypeFactory type_factory;
+  std::unique_ptr<const AnalyzerOutput> output;
+  statement.analyzes_without_rewrites =
+      AnalyzeStatement(statement.sql, no_rewrites_options_, catalog_.get(),
+                       &type_factory, &output)
+          .ok();
+  statement.analyzes = AnalyzeStatement(statement.sql, analyzer_options_,
+                                        catalog_.get(), &type_factory, &output)
+                           .ok();
+  if (!statement.analyzes ||
+      !output->resolved_statement()->Is<ResolvedQueryStmt>()) {
+    return statement;
+  }
+  PreparedQuery query(output->resolved_statement()->GetAs<ResolvedQueryStmt>(),
+                      evaluator_options_);
+  statement.algebrizes =
+      query.Prepare(analyzer_options_, catalog_.get()).ok();
+  if (statement.algebrizes) {
+    OperatorProfile profile;
+    statement.executes = ExecuteToEnd(query, &profile).ok();
+  }
+  return statement;
+}
+
+void CorpusFile::Run(benchmark::State& state) {
+  if (!loaded_) {
+    Load();
+  }
+  const LanguageOptions language_options = CorpusLanguageOptions();
+  const ParserOptions parser_options(language_options);
+
+  absl::Duration parse_time;
+  absl::Duration analyze_time;
+  absl::Duration analyze_no_rewrites_time;
+  absl::Duration algebrize_time;
+  absl::Duration execute_time;
+  int64_t peak_memory_bytes = 0;
+  const int64_t allocs_before = num_allocs.load(std::memory_order_relaxed);
+  const int64_t allocated_bytes_before =
+      num_allocated_bytes.load(std::memory_order_relaxed);
+  for (auto s : state) {
+    TypeFactory type_factory;
+    for (const Statement& statement : statements_) {
+      absl::Time start = absl::Now();
+      std::unique_ptr<ParserOutput> parser_output;
+      ParseStatement(statement.sql, parser_options, &parser_output)
+          .IgnoreError();
+      absl::Time end = absl::Now();
+      parse_time += end - start;
+
+      std::unique_ptr<const AnalyzerOutput> output;
+      if (statement.analyzes_without_rewrites) {
+        start = end;
+        ZETASQL_CHECK_OK(AnalyzeStatement(statement.sql, no_rewrites_options_,
+                                  catalog_.get(), &type_factory, &output));
+        end = absl::Now();
+        analyze_no_rewrites_time += end - start;
+      }
+      if (!statement.analyzes) {
+        continue;
+      }
+      start = end;
+      ZETASQL_CHECK_OK(AnalyzeStatement(statement.sql, analyzer_options_,
+                                catalog_.get(), &type_factory, &output));
+      end = absl::Now();
+      analyze_time += end - start;
+      if (!statement.algebrizes) {
+        continue;
+      }
+
+      start = end;
+      PreparedQuery query(
+          output->resolved_statement()->GetAs<ResolvedQueryStmt>(),
+          evaluator_options_);
+      ZETASQL_CHECK_OK(query.Prepare(analyzer_options_, catalog_.get()));
+      end = absl::Now();
+      algebrize_time += end - start;
+      if (!statement.executes) {
+        continue;
+      }
+
+      start = end;
+      OperatorProfile profile;
+      ZETASQL_CHECK_OK(ExecuteToEnd(query, &profile));
+      end = absl::Now();
+      execute_time += end - start;
+      peak_memory_bytes =
+          std::max(peak_memory_bytes, profile.GetPeakMemoryBytes());
+    }
+  }
+
+  auto per_iteration = [](double value) {
+    return benchmark::Counter(value, benchmark::Counter::kAvgIterations);
+  };
+  state.counters["parse_us"] =
+      per_iteration(absl::ToDoubleMicroseconds(parse_time));
+  state.counters["analyze_us"] =
+      per_iteration(absl::ToDoubleMicroseconds(analyze_time));
+  state.counters["analyze_no_rewrites_us"] =
+      per_iteration(absl::ToDoubleMicroseconds(analyze_no_rewrites_time));
+  state.counters["algebrize_us"] =
+      per_iteration(absl::ToDoubleMicroseconds(algebrize_time));
+  state.counters["execute_us"] =
+      per_iteration(absl::ToDoubleMicroseconds(execute_time));
+  state.counters["allocs"] = per_iteration(static_cast<double>(
+      num_allocs.load(std::memory_order_relaxed) - allocs_before));
+  state.counters["allocated_bytes"] = per_iteration(static_cast<double>(
+      num_allocated_bytes.load(std::memory_order_relaxed) -
+      allocated_bytes_before));
+  state.counters["peak_memory_bytes"] =
+      static_cast<double>(peak_memory_bytes);
+
+  auto count = [this](bool Statement::*phase) {
+    return static_cast<double>(
+        std::count_if(statements_.begin(), statements_.end(),
+                      [phase](const Statement& s) { return s.*phase; }));
+  };
+  state.counters["statements"] = static_cast<double>(statements_.size());
+  state.counters["analyzed"] = count(&Statement::analyzes);
+  state.counters["algebrized"] = count(&Statement::algebrizes);
+  state.counters["executed"] = count(&Statement::executes);
+}
+
+void RegisterCorpusBenchmarks() {
+  for (const auto& corpus : kCorpora) {
+    std::vector<std::string> paths;
+    ZETASQL_CHECK_OK(internal::Match(
+        zetasql_base::JoinPath(internal::TestSrcRootDir(), corpus.directory,
+                               "*.test"),
+        &paths));
+    ABSL_CHECK(!paths.empty()) << "No test files found in " << corpus.directory;
+    std::sort(paths.begin(), paths.end());
+    for (const std::string& path : paths) {
+      // Never destroyed, like the registered benchmarks.
+      CorpusFile* file = new CorpusFile(path);
+      benchmark::RegisterBenchmark(
+          absl::StrCat(corpus.name, "/", zetasql_base::Basename(path)).c_str(),
+          [file](benchmark::State& state) { file->Run(state); })
+          ->Unit(benchmark::kMillisecond);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace zetasql
+
+// Counts the heap allocations of the whole process for the allocs and
+// allocated_bytes counters. The other forms of operator new and delete, like
+// the array forms, call these.
+void* operator new(size_t size) {
+  zetasql::num_allocs.fetch_add(1, std::memory_order_relaxed);
+  zetasql::num_allocated_bytes.fetch_add(static_cast<int64_t>(size),
+                                         std::memory_order_relaxed);
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    std::abort();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  zetasql::RegisterCorpusBenchmarks();
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -16,6 +16,7 @@
 
 #include "zetasql/reference_impl/evaluation.h"
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -29,15 +30,21 @@
 #include "zetasql/public/functions/datetime.pb.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/value.h"
+#include "zetasql/reference_impl/function.h"
+#include "zetasql/reference_impl/operator_profile.h"
 #include "zetasql/reference_impl/tuple.h"
+#include "absl/base/optimization.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/container/node_hash_set.h"
 #include "absl/flags/flag.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "zetasql/base/arena.h"
 #include "zetasql/base/map_util.h"
 #include "zetasql/base/source_location.h"
 #include "zetasql/base/ret_check.h"
@@ -48,6 +55,10 @@ ABSL_FLAG(
     int64_t, zetasql_call_verify_not_aborted_rows_period, 1000,
     "Only call EvaluationContext::VerifyNotAborted() every this many rows");
 
+ABSL_FLAG(int64_t, zetasql_verify_not_aborted_clock_period, 64,
+          "Only read the clock to check the statement deadline on every this "
+          "many calls to EvaluationContext::VerifyNotAborted()");
+
 namespace zetasql {
 
 absl::Status ValidateFirstColumnPrimaryKey(
@@ -86,11 +97,74 @@ absl::Status ValidateFirstColumnPrimaryKey(
   return absl::OkStatus();
 }
 
+SubqueryResultCache::SubqueryResultCache(int max_entries, int64_t max_bytes,
+                                         MemoryAccountant* accountant)
+    : max_entries_(max_entries),
+      max_bytes_(max_bytes),
+      accountant_(accountant) {}
+
+SubqueryResultCache::~SubqueryResultCache() {
+  accountant_->ReturnBytes(num_bytes_);
+}
+
+bool SubqueryResultCache::EntryKey::operator==(const EntryKey& other) const {
+  if (subquery != other.subquery || key.size() != other.key.size()) {
+    return false;
+  }
+  for (int i = 0; i < key.size(); ++i) {
+    if (!key[i].Equals(other.key[i])) return false;
+  }
+  return true;
+}
+
+const Value* SubqueryResultCache::Lookup(const void* subquery,
+                                         absl::Span<const Value> key) {
+  const auto it = index_.find(EntryKey{subquery, key});
+  if (it == index_.end()) return nullptr;
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return &it->second->result;
+}
+
+void SubqueryResultCache::Insert(const void* subquery, std::vector<Value> key,
+                                 Value result) {
+  int64_t num_bytes = sizeof(Entry) + result.physical_byte_size();
+  for (const Value& value : key) {
+    num_bytes += value.physical_byte_size();
+  }
+  if (num_bytes > max_bytes_) return;
+  while (!entries_.empty() && (num_entries() >= max_entries_ ||
+                               num_bytes_ + num_bytes > max_bytes_)) {
+    EvictOne();
+  }
+  absl::Status status;
+  while (!accountant_->RequestBytes(num_bytes, &status)) {
+    // Other operators may be using the memory. Give up some of ours, and if
+    // there is nothing left to give, do not cache 'result'.
+    if (entries_.empty()) return;
+    EvictOne();
+  }
+  num_bytes_ += num_bytes;
+  entries_.push_front(
+      Entry{subquery, std::move(key), std::move(result), num_bytes});
+  const Entry& entry = entries_.front();
+  ABSL_DCHECK(!index_.contains(EntryKey{entry.subquery, entry.key}));
+  index_[EntryKey{entry.subquery, entry.key}] = entries_.begin();
+}
+
+void SubqueryResultCache::EvictOne() {
+  const Entry& entry = entries_.back();
+  index_.erase(EntryKey{entry.subquery, entry.key});
+  accountant_->ReturnBytes(entry.num_bytes);
+  num_bytes_ -= entry.num_bytes;
+  entries_.pop_back();
+}
+
 EvaluationContext::EvaluationContext(const EvaluationOptions& options)
     : EvaluationContext(
           options,
           std::make_shared<MemoryAccountant>(options.max_intermediate_byte_size,
-                                             "max_intermediate_byte_size"),
+                                             "max_intermediate_byte_size",
+                                             options.memory_pool),
           /*parent_context=*/nullptr) {}
 EvaluationContext::EvaluationContext(
     const EvaluationOptions& options,
@@ -99,7 +173,17 @@ EvaluationContext::EvaluationContext(
     : options_(options),
       memory_accountant_(memory_accountant),
       deterministic_output_(true),
-      parent_context_(parent_context) {}
+      parent_context_(parent_context),
+      proto_field_index_reservation_(memory_accountant_.get()) {}
+
+EvaluationContext::~EvaluationContext() {
+  if (tracer() == nullptr) return;
+  absl::MutexLock lock(&trace_mutex_);
+  for (const auto& [function, calls] : traced_function_calls_) {
+    tracer()->RecordFunctionCalls(calls.function_name, calls.num_calls,
+                                  calls.wall_time);
+  }
+}
 
 std::unique_ptr<EvaluationContext> EvaluationContext::MakeChildContext() const {
   EvaluationContext* mutable_parent_ref = const_cast<EvaluationContext*>(this);
@@ -108,12 +192,66 @@ std::unique_ptr<EvaluationContext> EvaluationContext::MakeChildContext() const {
   child_context->SetLanguageOptions(language_options_);
   child_context->SetSessionUser(session_user_);
   child_context->SetStatementEvaluationDeadline(statement_eval_deadline_);
+  child_context->set_operator_profile(operator_profile_);
+  child_context->row_range_table_ = row_range_table_;
+  child_context->row_range_ = row_range_;
   if (!IsDeterministicOutput()) {
     child_context->SetNonDeterministicOutput();
   }
   return child_context;
 }
 
+absl::string_view EvaluationContext::GetTracedOperatorName(
+    const RelationalOp* op) {
+  if (parent_context_ != nullptr) {
+    return parent_context_->GetTracedOperatorName(op);
+  }
+  absl::MutexLock lock(&trace_mutex_);
+  auto [it, inserted] = traced_operator_names_.try_emplace(op);
+  if (inserted) it->second = OperatorName(op);
+  return it->second;
+}
+
+void EvaluationContext::RecordTracedFunctionCall(
+    const ScalarFunctionBody* function, absl::Duration wall_time) {
+  if (parent_context_ != nullptr) {
+    parent_context_->RecordTracedFunctionCall(function, wall_time);
+    return;
+  }
+  absl::MutexLock lock(&trace_mutex_);
+  auto [it, inserted] = traced_function_calls_.try_emplace(function);
+  TracedFunctionCalls& calls = it->second;
+  // The name is copied because 'function' may be destroyed before this
+  // context reports it.
+  if (inserted) calls.function_name = function->debug_name();
+  ++calls.num_calls;
+  calls.wall_time += wall_time;
+}
+
+zetasql_base::UnsafeArena* EvaluationContext::tuple_arena() {
+  if (!options_.use_tuple_arena) return nullptr;
+  if (parent_context_ != nullptr) return parent_context_->tuple_arena();
+  if (tuple_arena_ == nullptr) {
+    tuple_arena_ = std::make_unique<zetasql_base::UnsafeArena>(
+        /*block_size=*/64 * 1024);
+  }
+  if (tuple_arena_->status().bytes_allocated() >=
+      options_.max_intermediate_byte_size) {
+    return nullptr;
+  }
+  return tuple_arena_.get();
+}
+
+SubqueryResultCache* EvaluationContext::subquery_result_cache() {
+  if (options_.max_cached_subquery_results <= 0) return nullptr;
+  if (subquery_result_cache_ == nullptr) {
+    subquery_result_cache_ = std::make_unique<SubqueryResultCache>(
+        options_.max_cached_subquery_results,
+        options_.max_subquery_cache_byte_size, memory_accountant_.get());
+  }
+  return subquery_result_cache_.get();
+}
+
 absl::Status EvaluationContext::AddTableAsArray(
     absl::string_view table_name, bool is_value_table, Value array,
     const LanguageOptions& language_options) {
@@ -157,9 +295,15 @@ absl::Status EvaluationContext::AddFunctionArgumentRef(std::string arg_name,
 absl::Status EvaluationContext::VerifyNotAborted() const {
   ZETASQL_RETURN_IF_NOT_ENOUGH_STACK(
       "Out of stack space due to deeply nested evaluation");
-  if (cancelled_) {
+  if (ABSL_PREDICT_FALSE(cancelled_.load(std::memory_order_relaxed))) {
     return zetasql_base::CancelledErrorBuilder() << "The statement has been cancelled";
   }
+  if (ABSL_PREDICT_TRUE(statement_eval_deadline_ == absl::InfiniteFuture() ||
+                        --calls_until_deadline_check_ > 0)) {
+    return absl::OkStatus();
+  }
+  calls_until_deadline_check_ =
+      absl::GetFlag(FLAGS_zetasql_verify_not_aborted_clock_period);
   if (clock_->TimeNow() > statement_eval_deadline_) {
     return zetasql_base::ResourceExhaustedErrorBuilder()
            << "The statement has been aborted because the statement deadline ("
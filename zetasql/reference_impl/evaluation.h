@@ -17,8 +17,10 @@
 #ifndef ZETASQL_REFERENCE_IMPL_EVALUATION_H_
 #define ZETASQL_REFERENCE_IMPL_EVALUATION_H_
 
+#include <atomic>
 #include <cstdint>
 #include <functional>
+#include <list>
 #include <map>
 #include <memory>
 #include <optional>
@@ -27,23 +29,34 @@
 #include <vector>
 
 #include "zetasql/public/civil_time.h"
+#include "zetasql/public/evaluator_executor.h"
+#include "zetasql/public/evaluator_tracer.h"
 #include "zetasql/public/language_options.h"
+#include "zetasql/public/memory_pool.h"
 #include "zetasql/public/value.h"
+#include "zetasql/reference_impl/join_key_filter.h"
 #include "zetasql/reference_impl/tuple.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
 #include "zetasql/base/case.h"
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/node_hash_map.h"
 #include "absl/flags/declare.h"
 #include "absl/random/random.h"
+#include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "zetasql/base/arena.h"
 #include "zetasql/base/map_util.h"
 #include "zetasql/base/status.h"
 #include "zetasql/base/clock.h"
 
 // See description in the cc file.
 ABSL_DECLARE_FLAG(int64_t, zetasql_call_verify_not_aborted_rows_period);
+ABSL_DECLARE_FLAG(int64_t, zetasql_verify_not_aborted_clock_period);
 
 namespace zetasql {
 
@@ -82,6 +95,13 @@ struct EvaluationOptions {
   // TupleSlots (to avoid extra deserialization).
   bool store_proto_field_value_maps = false;
 
+  // If true, the first read of fields from a large proto Value also builds an
+  // index of where all its fields are, and attaches it to the Value. Later
+  // reads of other fields, or of the same fields by operators that do not see
+  // the stored proto field values, then only parse the fields they read. The
+  // memory for the indexes counts towards 'max_intermediate_byte_size'.
+  bool use_proto_field_index = false;
+
   // If true, the reference implementation will use the TopNAccumulator instead
   // of LimitAccumulator(OrderByAccumulator) when possible in order to save
   // memory. Not safe to use in compliance or random query tests because it
@@ -98,6 +118,54 @@ struct EvaluationOptions {
   // limit results in an error.
   int64_t max_intermediate_byte_size = 128 * 1024 * 1024;
 
+  // If non-null, the bytes counted towards 'max_intermediate_byte_size' are
+  // also reserved from this pool. Not owned.
+  MemoryPool* memory_pool = nullptr;
+
+  // If positive, operators that consume their entire input (e.g., SortOp)
+  // read it with TupleIterator::NextBatch() using batches of this many tuples
+  // instead of calling TupleIterator::Next() once per tuple.
+  int tuple_batch_size = 0;
+
+  // The maximum number of threads that an operator may use for work that can
+  // be done in parallel (e.g., building the hash table of a hash join). The
+  // calling thread counts as one of them, so 1 disables parallelism.
+  int num_threads = 1;
+
+  // If non-null, runs the helper tasks of the operators that use more than
+  // one thread instead of new threads. Not owned.
+  EvaluatorExecutor* executor = nullptr;
+
+  // If non-null, receives the iterator creations and row counts of the
+  // RelationalOps and the calls of the scalar functions of the evaluation.
+  // Not owned.
+  EvaluatorTracer* tracer = nullptr;
+
+  // If positive, table scans that are not split across threads (see
+  // 'num_threads') read their EvaluatorTableIterator on a background thread,
+  // up to this many rows ahead of the consumers of the rows. This hides the
+  // waits of iterators that do I/O in NextRow().
+  int scan_prefetch_rows = 0;
+
+  // If non-empty, operators that support it (currently SortOp without a
+  // LIMIT) write intermediate tuples to temporary files in this directory
+  // instead of failing when they would exceed 'max_intermediate_byte_size'.
+  std::string spill_directory;
+
+  // If true, the tuples that operators accumulate (e.g., the input of a sort,
+  // or the groups of an aggregation) allocate their slots from an arena owned
+  // by the EvaluationContext instead of from the heap. The arena is freed all
+  // at once when the statement completes. See EvaluationContext::tuple_arena().
+  bool use_tuple_arena = false;
+
+  // The maximum number of subquery results that a statement may cache (see
+  // SubqueryResultCache). 0 disables the cache.
+  int max_cached_subquery_results = 1024;
+
+  // The maximum number of bytes that a statement may use for cached subquery
+  // results. These bytes also count against 'max_intermediate_byte_size'.
+  int64_t max_subquery_cache_byte_size = 16 * 1024 * 1024;
+
   // If true, the results of DML statements will include all rows in the
   // modified table; otherwise, only modified rows (i.e. those matching the
   // WHERE clause) are included. For DELETE, 'modified rows' means the rows to
@@ -108,7 +176,11 @@ struct EvaluationOptions {
   bool return_all_rows_for_dml = true;
 };
 
+class OperatorProfile;
 class ProtoFieldReader;
+class RelationalOp;
+class ScalarFunctionBody;
+class Table;
 
 // Base class for C++ values which can be associated with a variable.
 class CppValueBase {
@@ -116,6 +188,61 @@ class CppValueBase {
   virtual ~CppValueBase() = default;
 };
 
+// Caches the results of subqueries for the duration of a statement, keyed on
+// the subquery and on the values of its correlated variables (the key is empty
+// for uncorrelated subqueries). When the cache is full, the least recently used
+// results are evicted. The cached bytes are charged to a MemoryAccountant; a
+// result that does not fit is simply not cached.
+class SubqueryResultCache {
+ public:
+  // Does not take ownership of 'accountant', which must outlive this object.
+  SubqueryResultCache(int max_entries, int64_t max_bytes,
+                      MemoryAccountant* accountant);
+  SubqueryResultCache(const SubqueryResultCache&) = delete;
+  SubqueryResultCache& operator=(const SubqueryResultCache&) = delete;
+  ~SubqueryResultCache();
+
+  // Returns the result cached for 'subquery' and 'key', or NULL. The returned
+  // Value remains valid until the next call to Insert().
+  const Value* Lookup(const void* subquery, absl::Span<const Value> key);
+
+  // Caches 'result' for 'subquery' and 'key', which must not be cached yet.
+  void Insert(const void* subquery, std::vector<Value> key, Value result);
+
+  int num_entries() const { return static_cast<int>(entries_.size()); }
+
+ private:
+  struct Entry {
+    const void* subquery;
+    std::vector<Value> key;
+    Value result;
+    int64_t num_bytes;
+  };
+
+  // Refers to the key of an Entry, or to the arguments of Lookup().
+  struct EntryKey {
+    const void* subquery;
+    absl::Span<const Value> key;
+
+    template <typename H>
+    friend H AbslHashValue(H h, const EntryKey& k) {
+      return H::combine(std::move(h), k.subquery, k.key);
+    }
+    bool operator==(const EntryKey& other) const;
+  };
+
+  // Evicts the least recently used entry.
+  void EvictOne();
+
+  const int max_entries_;
+  const int64_t max_bytes_;
+  MemoryAccountant* accountant_;
+  int64_t num_bytes_ = 0;
+  // Most recently used first.
+  std::list<Entry> entries_;
+  absl::flat_hash_map<EntryKey, std::list<Entry>::iterator> index_;
+};
+
 // Contains state about the evaluation in progress.
 class EvaluationContext {
  public:
@@ -127,6 +254,9 @@ class EvaluationContext {
   explicit EvaluationContext(const EvaluationOptions& options);
   EvaluationContext(const EvaluationContext&) = delete;
   EvaluationContext& operator=(const EvaluationContext&) = delete;
+  // Reports the function calls recorded by RecordTracedFunctionCall() to
+  // EvaluationOptions::tracer.
+  ~EvaluationContext();
 
   // Creates a local evaluator that inherits statement level properties
   // from the parent evaluator. Useful for executing SQL defined
@@ -141,6 +271,39 @@ class EvaluationContext {
 
   MemoryAccountant* memory_accountant() { return memory_accountant_.get(); }
 
+  // Returns the arena that TupleDatas accumulated by operators should allocate
+  // their slots from (see TupleArenaAllocator), or NULL if they should use the
+  // heap. The arena belongs to the root context, which child contexts share,
+  // and is freed with it, so such TupleDatas must not outlive that context.
+  //
+  // Returns NULL unless EvaluationOptions::use_tuple_arena is set. Also returns
+  // NULL once the arena has allocated 'max_intermediate_byte_size' bytes: arena
+  // memory is not reused when a TupleData is destroyed, and this bounds the
+  // amount of it that can pile up.
+  zetasql_base::UnsafeArena* tuple_arena();
+
+  // If non-NULL, RelationalOp::CreateIterator() records the runtime statistics
+  // of each operator into 'profile', which must outlive the iterators created
+  // with this context. Child contexts inherit the profile.
+  void set_operator_profile(OperatorProfile* profile) {
+    operator_profile_ = profile;
+  }
+  OperatorProfile* operator_profile() const { return operator_profile_; }
+
+  // Returns EvaluationOptions::tracer, which is NULL unless tracing was
+  // requested.
+  EvaluatorTracer* tracer() const { return options_.tracer; }
+
+  // Returns the name of 'op' that is reported to tracer(). Computed once per
+  // operator for the root context, and valid until it is destroyed.
+  // Thread-safe.
+  absl::string_view GetTracedOperatorName(const RelationalOp* op);
+
+  // Records a call of 'function' that took 'wall_time', to be reported to
+  // tracer() when the root context is destroyed. Thread-safe.
+  void RecordTracedFunctionCall(const ScalarFunctionBody* function,
+                                absl::Duration wall_time);
+
   // Returns the `value` associated with `arg_name` or an invalid Value.
   Value GetFunctionArgumentRef(std::string arg_name);
   // Returns true if there is a `value` associated with `arg_name` already
@@ -193,6 +356,12 @@ class EvaluationContext {
   // zone information.
   absl::TimeZone GetDefaultTimeZone();
 
+  // Returns true if the default time zone has been set or used, e.g., by a
+  // function whose result depends on it.
+  bool default_time_zone_initialized() const {
+    return default_timezone_.has_value();
+  }
+
   // If necessary, (lazily) initializes the random number generator. Lazy
   // initialization saves time for most evaluations, which don't require random
   // numbers.
@@ -249,8 +418,8 @@ class EvaluationContext {
   // the statement is still being evaluated after that time it will be aborted
   // and an error will be returned.
   void SetStatementEvaluationDeadlineFromNow(absl::Duration time_limit) {
-    statement_eval_deadline_ =
-        ::zetasql_base::Clock::RealClock()->TimeNow() + time_limit;
+    SetStatementEvaluationDeadline(
+        ::zetasql_base::Clock::RealClock()->TimeNow() + time_limit);
   }
 
   // Sets the statement evaluation deadline.
@@ -258,6 +427,8 @@ class EvaluationContext {
   // aborted and an error will be returned.
   void SetStatementEvaluationDeadline(absl::Time statement_deadline) {
     statement_eval_deadline_ = statement_deadline;
+    // The next VerifyNotAborted() reads the clock.
+    calls_until_deadline_check_ = 0;
   }
 
   void SetSessionUser(absl::string_view session_user) {
@@ -287,7 +458,7 @@ class EvaluationContext {
   // callbacks are just a way of notifying user code that the statement has been
   // cancelled if we are stuck in a user's EvaluatorTableIterator.
   absl::Status CancelStatement() {
-    cancelled_ = true;
+    cancelled_.store(true, std::memory_order_relaxed);
     // Call all the callbacks, returning the first non-OK error code.
     absl::Status ret = absl::OkStatus();
     for (const CancelCallback& cb : cancel_cbs_) {
@@ -303,14 +474,25 @@ class EvaluationContext {
   // cancellation callbacks.
   void ClearDeadlineAndCancellationState() {
     SetStatementEvaluationDeadline(absl::InfiniteFuture());
-    cancelled_ = false;
+    cancelled_.store(false, std::memory_order_relaxed);
     cancel_cbs_.clear();
   }
 
-  // Returns an error if the statement has been aborted. This function is
-  // expensive (it gets the current time).
+  // Returns an error if the statement has been aborted. Cancellation is
+  // checked on every call, with a single atomic load. The clock is only read
+  // when there is a deadline, and then only on every
+  // --zetasql_verify_not_aborted_clock_period'th call, so a passed deadline
+  // may be noticed that many calls late.
   absl::Status VerifyNotAborted() const;
 
+  // Reserves 'num_bytes' for a ProtoFieldIndex built during this evaluation
+  // (see EvaluationOptions::use_proto_field_index). Returns false if that
+  // would exceed the memory limit.
+  bool ReserveProtoFieldIndexBytes(int64_t num_bytes) {
+    absl::Status status;
+    return proto_field_index_reservation_.Increase(num_bytes, &status);
+  }
+
   int num_proto_deserializations() const { return num_proto_deserializations_; }
 
   void set_num_proto_deserializations(int n) {
@@ -371,11 +553,50 @@ class EvaluationContext {
   // Deletes the C++ value associated with the given variable Id.
   void ClearCppValue(VariableId variable) { cpp_values_.erase(variable); }
 
+  // Returns the cache of subquery results for this statement, or NULL if it
+  // is disabled by EvaluationOptions::max_cached_subquery_results.
+  SubqueryResultCache* subquery_result_cache();
+
   const TupleDataDeque* active_group_rows() const { return active_group_rows_; }
   void set_active_group_rows(const TupleDataDeque* group_rows) {
     active_group_rows_ = group_rows;
   }
 
+  // Returns the JoinKeyFilter with id 'filter_id' that a JoinOp published for
+  // the scans of its probe side, or NULL. A JoinOp publishes its filters only
+  // while it creates the iterator of its probe side, and the scans that apply
+  // a filter keep a reference to it.
+  std::shared_ptr<const JoinKeyFilter> GetJoinKeyFilter(int filter_id) const {
+    auto it = join_key_filters_.find(filter_id);
+    return it == join_key_filters_.end() ? nullptr : it->second;
+  }
+  // Publishes 'filter' under 'filter_id', or withdraws the filter with that id
+  // if 'filter' is NULL.
+  void SetJoinKeyFilter(int filter_id,
+                        std::shared_ptr<const JoinKeyFilter> filter) {
+    if (filter == nullptr) {
+      join_key_filters_.erase(filter_id);
+    } else {
+      join_key_filters_[filter_id] = std::move(filter);
+    }
+  }
+
+  // Restricts the scans of 'table' to its rows in [begin_row, end_row), as
+  // numbered by EvaluatorTableIterator::SetRowRange(), e.g. to evaluate a query
+  // over only the rows appended to 'table' since an earlier evaluation. At most
+  // one table can be restricted.
+  void SetTableRowRange(const Table* table, int64_t begin_row,
+                        int64_t end_row) {
+    row_range_table_ = table;
+    row_range_ = {begin_row, end_row};
+  }
+  // Returns the range of rows passed to SetTableRowRange() for 'table', if any.
+  std::optional<std::pair<int64_t, int64_t>> GetTableRowRange(
+      const Table* table) const {
+    if (table == nullptr || table != row_range_table_) return std::nullopt;
+    return row_range_;
+  }
+
   // UDF argument references
   std::map<std::string, Value, zetasql_base::CaseLess>
       udf_argument_references_;
@@ -403,16 +624,29 @@ class EvaluationContext {
 
   const EvaluationOptions options_;
   std::shared_ptr<MemoryAccountant> memory_accountant_;
+  // Lazily created by tuple_arena() in the root context. Declared early so that
+  // it outlives the other members, in case any of them hold TupleDatas.
+  std::unique_ptr<zetasql_base::UnsafeArena> tuple_arena_;
   // Tables added by AddTableAsArray().
   std::map<std::string, Value, std::less<>> tables_;
 
   const TupleDataDeque* active_group_rows_ = nullptr;
+  // Published by SetJoinKeyFilter().
+  absl::flat_hash_map<int, std::shared_ptr<const JoinKeyFilter>>
+      join_key_filters_;
+  // Set by SetTableRowRange().
+  const Table* row_range_table_ = nullptr;
+  std::pair<int64_t, int64_t> row_range_;
   // Indicates that the result of evaluation is non-deterministic.
   bool deterministic_output_;
   LanguageOptions language_options_;
   // Default is no deadline.
   absl::Time statement_eval_deadline_ = absl::InfiniteFuture();
-  bool cancelled_ = false;
+  // Number of VerifyNotAborted() calls left before it next reads the clock.
+  mutable int64_t calls_until_deadline_check_ = 0;
+  // Atomic so that CancelStatement() may be called from another thread while
+  // the statement is being evaluated.
+  std::atomic<bool> cancelled_{false};
   std::vector<CancelCallback> cancel_cbs_;
 
   // Used to obtain the current timestamp.
@@ -454,6 +688,30 @@ class EvaluationContext {
   // A reference to the EvaluationContext that created this context by
   // calling `MakeChildContext`. Always nullptr if not created this way.
   EvaluationContext* parent_context_ = nullptr;
+
+  // Not owned. NULL unless profiling was requested.
+  OperatorProfile* operator_profile_ = nullptr;
+
+  // The state for tracer(), which only the root context uses.
+  struct TracedFunctionCalls {
+    std::string function_name;
+    int64_t num_calls = 0;
+    absl::Duration wall_time;
+  };
+  absl::Mutex trace_mutex_;
+  // Node-based so that the returned names stay valid.
+  absl::node_hash_map<const RelationalOp*, std::string> traced_operator_names_
+      ABSL_GUARDED_BY(trace_mutex_);
+  absl::flat_hash_map<const ScalarFunctionBody*, TracedFunctionCalls>
+      traced_function_calls_ ABSL_GUARDED_BY(trace_mutex_);
+
+  // Memory of the ProtoFieldIndexes built by this context. They may outlive
+  // it, attached to proto Values, but are only accounted for until then.
+  MemoryReservation proto_field_index_reservation_;
+
+  // Lazily created by subquery_result_cache(). Declared last so that it
+  // returns its bytes to 'memory_accountant_' before that is destroyed.
+  std::unique_ptr<SubqueryResultCache> subquery_result_cache_;
 };
 
 // Returns true if we should suppress 'error' (which must not be OK) in
@@ -16,16 +16,26 @@
 
 #include <cstdint>
 #include <memory>
+#include <string>
 
 #include "zetasql/public/language_options.h"
+#include "zetasql/public/value.h"
 #include "zetasql/reference_impl/evaluation.h"
+#include "zetasql/reference_impl/tuple.h"
+#include "zetasql/base/testing/status_matchers.h"
+#include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/flags/flag.h"
+#include "absl/status/status.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "zetasql/base/clock.h"
 
 namespace zetasql {
 namespace {
 
+using ::zetasql_base::testing::StatusIs;
+
 TEST(EvaluationContext, ChildContextTest) {
   EvaluationOptions options;
   options.always_use_stable_sort = true;
@@ -61,6 +71,22 @@ TEST(EvaluationContext, ChildContextTest) {
   EXPECT_EQ(context.memory_accountant(), child_context->memory_accountant());
 }
 
+TEST(EvaluationContext, TupleArena) {
+  EXPECT_EQ(EvaluationContext(EvaluationOptions()).tuple_arena(), nullptr);
+
+  EvaluationOptions options;
+  options.use_tuple_arena = true;
+  options.max_intermediate_byte_size = 1024 * 1024;
+  EvaluationContext context(options);
+  zetasql_base::UnsafeArena* arena = context.tuple_arena();
+  ASSERT_NE(arena, nullptr);
+  EXPECT_EQ(context.MakeChildContext()->tuple_arena(), arena);
+
+  // Once the arena reaches 'max_intermediate_byte_size', tuples use the heap.
+  arena->AllocAligned(options.max_intermediate_byte_size, /*align=*/8);
+  EXPECT_EQ(context.tuple_arena(), nullptr);
+}
+
 TEST(EvaluationContext, ChildContextCalledFirstTest) {
   EvaluationContext context = EvaluationContext(EvaluationOptions());
   std::unique_ptr<EvaluationContext> child_context = context.MakeChildContext();
@@ -100,5 +126,101 @@ TEST(EvaluationContext, ParentContextCalledFirstTest) {
   EXPECT_EQ(ts1, ts2);
 }
 
+TEST(SubqueryResultCache, EvictsLeastRecentlyUsed) {
+  MemoryAccountant accountant(/*total_num_bytes=*/1024 * 1024);
+  {
+    SubqueryResultCache cache(/*max_entries=*/2, /*max_bytes=*/1024 * 1024,
+                              &accountant);
+    const int subquery1 = 0;
+    const int subquery2 = 0;
+    cache.Insert(&subquery1, {Value::Int64(1)}, Value::Bool(true));
+    cache.Insert(&subquery2, {Value::Int64(1)}, Value::Bool(false));
+    EXPECT_EQ(cache.num_entries(), 2);
+    EXPECT_LT(accountant.remaining_bytes(), 1024 * 1024);
+
+    // Same key, different subqueries.
+    ASSERT_NE(cache.Lookup(&subquery1, {Value::Int64(1)}), nullptr);
+    EXPECT_EQ(*cache.Lookup(&subquery1, {Value::Int64(1)}), Value::Bool(true));
+    EXPECT_EQ(cache.Lookup(&subquery1, {Value::Int64(2)}), nullptr);
+
+    // 'subquery2' is the least recently used, so it is evicted.
+    cache.Insert(&subquery1, {Value::Int64(2)}, Value::Bool(false));
+    EXPECT_EQ(cache.num_entries(), 2);
+    EXPECT_EQ(cache.Lookup(&subquery2, {Value::Int64(1)}), nullptr);
+    EXPECT_NE(cache.Lookup(&subquery1, {Value::Int64(1)}), nullptr);
+    EXPECT_NE(cache.Lookup(&subquery1, {Value::Int64(2)}), nullptr);
+  }
+  // The cache returns its bytes when it is destroyed.
+  EXPECT_EQ(accountant.remaining_bytes(), 1024 * 1024);
+}
+
+TEST(SubqueryResultCache, RespectsMemoryBounds) {
+  MemoryAccountant accountant(/*total_num_bytes=*/1024 * 1024);
+  const int subquery = 0;
+  const Value large_result = Value::String(std::string(4096, 'a'));
+  {
+    // Results larger than the cache are not cached.
+    SubqueryResultCache cache(/*max_entries=*/10, /*max_bytes=*/1024,
+                              &accountant);
+    cache.Insert(&subquery, {}, large_result);
+    EXPECT_EQ(cache.num_entries(), 0);
+    EXPECT_EQ(cache.Lookup(&subquery, {}), nullptr);
+  }
+  {
+    // Results that do not fit in the MemoryAccountant are not cached either.
+    MemoryAccountant small_accountant(/*total_num_bytes=*/1024);
+    SubqueryResultCache cache(/*max_entries=*/10, /*max_bytes=*/1024 * 1024,
+                              &small_accountant);
+    cache.Insert(&subquery, {}, large_result);
+    EXPECT_EQ(cache.num_entries(), 0);
+    EXPECT_EQ(small_accountant.remaining_bytes(), 1024);
+  }
+  EXPECT_EQ(accountant.remaining_bytes(), 1024 * 1024);
+}
+
+TEST(EvaluationContext, SubqueryResultCache) {
+  EvaluationContext context((EvaluationOptions()));
+  EXPECT_NE(context.subquery_result_cache(), nullptr);
+
+  EvaluationOptions options;
+  options.max_cached_subquery_results = 0;
+  EvaluationContext context_without_cache(options);
+  EXPECT_EQ(context_without_cache.subquery_result_cache(), nullptr);
+}
+
+TEST(EvaluationContext, VerifyNotAbortedReadsClockPeriodically) {
+  absl::SetFlag(&FLAGS_zetasql_verify_not_aborted_clock_period, 3);
+  zetasql_base::SimulatedClock clock(absl::UnixEpoch());
+  EvaluationContext context((EvaluationOptions()));
+  context.SetClockAndClearCurrentTimestamp(&clock);
+
+  // Without a deadline the clock is never read.
+  clock.AdvanceTime(absl::Seconds(100));
+  ZETASQL_EXPECT_OK(context.VerifyNotAborted());
+
+  // Setting a deadline makes the next call read the clock.
+  context.SetStatementEvaluationDeadline(clock.TimeNow() - absl::Seconds(1));
+  EXPECT_THAT(context.VerifyNotAborted(),
+              StatusIs(absl::StatusCode::kResourceExhausted));
+
+  context.SetStatementEvaluationDeadline(clock.TimeNow() + absl::Seconds(1));
+  ZETASQL_EXPECT_OK(context.VerifyNotAborted());
+  clock.AdvanceTime(absl::Seconds(2));
+  // The passed deadline is only noticed on the third call.
+  ZETASQL_EXPECT_OK(context.VerifyNotAborted());
+  ZETASQL_EXPECT_OK(context.VerifyNotAborted());
+  EXPECT_THAT(context.VerifyNotAborted(),
+              StatusIs(absl::StatusCode::kResourceExhausted));
+
+  // Cancellation is noticed on the next call.
+  context.ClearDeadlineAndCancellationState();
+  ZETASQL_EXPECT_OK(context.VerifyNotAborted());
+  ZETASQL_ASSERT_OK(context.CancelStatement());
+  EXPECT_THAT(context.VerifyNotAborted(),
+              StatusIs(absl::StatusCode::kCancelled));
+
+  absl::SetFlag(&FLAGS_zetasql_verify_not_aborted_clock_period, 64);
+}
+
 }  // namespace
 }  // namespace zetasql
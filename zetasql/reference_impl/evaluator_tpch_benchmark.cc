@@ -0,0 +1,341 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Measures the reference implementation on TPC-H style queries over
+// synthetic tables, through PreparedQuery. Each benchmark takes the scale, in
+// thousandths of a TPC-H scale factor (so 1 has 6000 lineitem rows), and the
+// number of evaluation threads. Besides the total time, each one reports:
+//   - items_per_second: lineitem rows processed per second,
+//   - analyze_us, algebrize_us, execute_us: the time of each phase per
+//     iteration,
+//   - peak_memory_bytes: the largest MemoryAccountant usage observed.
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/analyzer.h"
+#include "zetasql/public/analyzer_options.h"
+#include "zetasql/public/analyzer_output.h"
+#include "zetasql/public/evaluator.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/language_options.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/types/type_factory.h"
+#include "zetasql/public/value.h"
+#include "zetasql/reference_impl/operator_profile.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "benchmark/benchmark.h"
+#include "zetasql/base/check.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+namespace {
+
+// The number of rows of each table at scale 1.
+constexpr int kCustomersPerScale = 150;
+constexpr int kOrdersPerScale = 1500;
+// Each order has between 1 and 7 lineitems, 4 on average.
+constexpr int kMaxLineitemsPerOrder = 7;
+
+// 1992-01-01 and the number of days of order dates after it.
+constexpr int32_t kFirstOrderDate = 8035;
+constexpr int kNumOrderDates = 2400;
+
+constexpr const char* kRegionNames[] = {"AFRICA", "AMERICA", "ASIA", "EUROPE",
+                                        "MIDDLE EAST"};
+constexpr const char* kMarketSegments[] = {"AUTOMOBILE", "BUILDING",
+                                           "FURNITURE", "HOUSEHOLD",
+                                           "MACHINERY"};
+constexpr const char* kOrderPriorities[] = {"1-URGENT", "2-HIGH", "3-MEDIUM",
+                                            "4-NOT SPECIFIED", "5-LOW"};
+constexpr int kNumNations = 25;
+
+// A catalog with the tables region, nation, customer, orders and lineitem,
+// with the columns of their TPC-H namesakes that the queries below use.
+// Decimal columns are DOUBLEs. The contents are pseudo-random, but the same
+// for every run with the same scale.
+class TpchCatalog {
+ public:
+  explicit TpchCatalog(int scale) : catalog_("tpch", &type_factory_) {
+    catalog_.AddZetaSQLFunctions(LanguageOptions());
+    std::mt19937_64 random(scale);
+
+    std::vector<std::vector<Value>> rows;
+    for (int i = 0; i < static_cast<int>(std::size(kRegionNames)); ++i) {
+      rows.push_back({values::Int64(i), values::String(kRegionNames[i])});
+    }
+    AddTable("region",
+             {{"r_regionkey", types::Int64Type()},
+              {"r_name", types::StringType()}},
+             rows);
+
+    rows.clear();
+    for (int i = 0; i < kNumNations; ++i) {
+      rows.push_back(
+          {values::Int64(i), values::String(absl::StrCat("N", i)),
+           values::Int64(i % static_cast<int>(std::size(kRegionNames)))});
+    }
+    AddTable("nation",
+             {{"n_nationkey", types::Int64Type()},
+              {"n_name", types::StringType()},
+              {"n_regionkey", types::Int64Type()}},
+             rows);
+
+    const int num_customers = kCustomersPerScale * scale;
+    rows.clear();
+    for (int i = 0; i < num_customers; ++i) {
+      rows.push_back(
+          {values::Int64(i), values::String(absl::StrCat("Customer#", i)),
+           values::Int64(Uniform(random, kNumNations)),
+           values::Double(Uniform(random, 1100000) / 100.0 - 1000),
+           values::String(
+               kMarketSegments[Uniform(random, std::size(kMarketSegments))])});
+    }
+    AddTable("customer",
+             {{"c_custkey", types::Int64Type()},
+              {"c_name", types::StringType()},
+              {"c_nationkey", types::Int64Type()},
+              {"c_acctbal", types::DoubleType()},
+              {"c_mktsegment", types::StringType()}},
+             rows);
+
+    std::vector<std::vector<Value>> lineitem_rows;
+    rows.clear();
+    for (int i = 0; i < kOrdersPerScale * scale; ++i) {
+      const int32_t order_date =
+          kFirstOrderDate +
+          static_cast<int32_t>(Uniform(random, kNumOrderDates));
+      const int num_lineitems = 1 + Uniform(random, kMaxLineitemsPerOrder);
+      double total_price = 0;
+      for (int line = 1; line <= num_lineitems; ++line) {
+        const double quantity = 1 + Uniform(random, 50);
+        const double price = quantity * (900 + Uniform(random, 100000) / 100.0);
+        const double discount = Uniform(random, 11) / 100.0;
+        const double tax = Uniform(random, 9) / 100.0;
+        const int32_t ship_date =
+            order_date + 1 + static_cast<int32_t>(Uniform(random, 121));
+        total_price += price * (1 - discount) * (1 + tax);
+        lineitem_rows.push_back(
+            {values::Int64(i), values::Int64(line), values::Double(quantity),
+             values::Double(price), values::Double(discount),
+             values::Double(tax),
+             values::String(Uniform(random, 2) == 0 ? "R" : "N"),
+             values::String(ship_date < kFirstOrderDate + 1200 ? "F" : "O"),
+             values::Date(ship_date)});
+      }
+      const char* priority =
+          kOrderPriorities[Uniform(random, std::size(kOrderPriorities))];
+      rows.push_back(
+          {values::Int64(i), values::Int64(Uniform(random, num_customers)),
+           values::Double(total_price), values::Date(order_date),
+           values::String(priority)});
+    }
+    AddTable("orders",
+             {{"o_orderkey", types::Int64Type()},
+              {"o_custkey", types::Int64Type()},
+              {"o_totalprice", types::DoubleType()},
+              {"o_orderdate", types::DateType()},
+              {"o_orderpriority", types::StringType()}},
+             rows);
+    num_lineitems_ = static_cast<int64_t>(lineitem_rows.size());
+    AddTable("lineitem",
+             {{"l_orderkey", types::Int64Type()},
+              {"l_linenumber", types::Int64Type()},
+              {"l_quantity", types::DoubleType()},
+              {"l_extendedprice", types::DoubleType()},
+              {"l_discount", types::DoubleType()},
+              {"l_tax", types::DoubleType()},
+              {"l_returnflag", types::StringType()},
+              {"l_linestatus", types::StringType()},
+              {"l_shipdate", types::DateType()}},
+             lineitem_rows);
+  }
+
+  TpchCatalog(const TpchCatalog&) = delete;
+  TpchCatalog& operator=(const TpchCatalog&) = delete;
+
+  SimpleCatalog* catalog() { return &catalog_; }
+  TypeFactory* type_factory() { return &type_factory_; }
+  int64_t num_lineitems() const { return num_lineitems_; }
+
+ private:
+  static int64_t Uniform(std::mt19937_64& random, int64_t n) {
+    return static_cast<int64_t>(random() % n);
+  }
+
+  void AddTable(const std::string& name,
+                const std::vector<SimpleTable::NameAndType>& columns,
+                const std::vector<std::vector<Value>>& rows) {
+    auto table = std::make_unique<SimpleTable>(name, columns);
+    table->SetContents(rows);
+    catalog_.AddOwnedTable(std::move(table));
+  }
+
+  TypeFactory type_factory_;
+  SimpleCatalog catalog_;
+  int64_t num_lineitems_ = 0;
+};
+
+// Pricing summary report.
+constexpr char kQ1[] = R"sql(
+SELECT l_returnflag, l_linestatus, SUM(l_quantity) AS sum_qty,
+       SUM(l_extendedprice) AS sum_base_price,
+       SUM(l_extendedprice * (1 - l_discount)) AS sum_disc_price,
+       SUM(l_extendedprice * (1 - l_discount) * (1 + l_tax)) AS sum_charge,
+       AVG(l_quantity) AS avg_qty, AVG(l_discount) AS avg_disc,
+       COUNT(*) AS count_order
+FROM lineitem
+WHERE l_shipdate <= DATE '1998-09-02'
+GROUP BY l_returnflag, l_linestatus
+ORDER BY l_returnflag, l_linestatus)sql";
+
+// Shipping priority.
+constexpr char kQ3[] = R"sql(
+SELECT l_orderkey, SUM(l_extendedprice * (1 - l_discount)) AS revenue,
+       o_orderdate
+FROM customer, orders, lineitem
+WHERE c_mktsegment = 'BUILDING' AND c_custkey = o_custkey
+  AND l_orderkey = o_orderkey AND o_orderdate < DATE '1995-03-15'
+  AND l_shipdate > DATE '1995-03-15'
+GROUP BY l_orderkey, o_orderdate
+ORDER BY revenue DESC, o_orderdate
+LIMIT 10)sql";
+
+// Local volume, without the supplier table.
+constexpr char kQ5[] = R"sql(
+SELECT n_name, SUM(l_extendedprice * (1 - l_discount)) AS revenue
+FROM customer, orders, lineitem, nation, region
+WHERE c_custkey = o_custkey AND l_orderkey = o_orderkey
+  AND c_nationkey = n_nationkey AND n_regionkey = r_regionkey
+  AND r_name = 'ASIA' AND o_orderdate >= DATE '1994-01-01'
+  AND o_orderdate < DATE '1995-01-01'
+GROUP BY n_name
+ORDER BY revenue DESC)sql";
+
+// Forecasting revenue change.
+constexpr char kQ6[] = R"sql(
+SELECT SUM(l_extendedprice * l_discount) AS revenue
+FROM lineitem
+WHERE l_shipdate >= DATE '1994-01-01' AND l_shipdate < DATE '1995-01-01'
+  AND l_discount BETWEEN 0.05 AND 0.07 AND l_quantity < 24)sql";
+
+// Customer distribution.
+constexpr char kQ13[] = R"sql(
+SELECT c_count, COUNT(*) AS custdist
+FROM (
+  SELECT c_custkey, COUNT(o_orderkey) AS c_count
+  FROM customer LEFT OUTER JOIN orders
+    ON c_custkey = o_custkey AND o_orderpriority != '1-URGENT'
+  GROUP BY c_custkey)
+GROUP BY c_count
+ORDER BY custdist DESC, c_count DESC)sql";
+
+// Large volume customers.
+constexpr char kQ18[] = R"sql(
+SELECT c_name, c_custkey, o_orderkey, o_orderdate, o_totalprice,
+       SUM(l_quantity) AS quantity
+FROM customer, orders, lineitem
+WHERE o_orderkey IN (
+    SELECT l_orderkey FROM lineitem
+    GROUP BY l_orderkey HAVING SUM(l_quantity) > 250)
+  AND c_custkey = o_custkey AND o_orderkey = l_orderkey
+GROUP BY c_name, c_custkey, o_orderkey, o_orderdate, o_totalprice
+ORDER BY o_totalprice DESC, o_orderdate
+LIMIT 100)sql";
+
+void RunQuery(benchmark::State& state, const char* sql) {
+  TpchCatalog tpch(state.range(0));
+  AnalyzerOptions analyzer_options;
+  EvaluatorOptions evaluator_options;
+  evaluator_options.type_factory = tpch.type_factory();
+  evaluator_options.num_threads = state.range(1);
+  evaluator_options.max_intermediate_byte_size = int64_t{1} << 32;
+
+  absl::Duration analyze_time;
+  absl::Duration algebrize_time;
+  absl::Duration execute_time;
+  int64_t peak_memory_bytes = 0;
+  for (auto s : state) {
+    absl::Time start = absl::Now();
+    std::unique_ptr<const AnalyzerOutput> output;
+    ZETASQL_CHECK_OK(AnalyzeStatement(sql, analyzer_options, tpch.catalog(),
+                              tpch.type_factory(), &output));
+    absl::Time end = absl::Now();
+    analyze_time += end - start;
+
+    start = end;
+    PreparedQuery query(
+        output->resolved_statement()->GetAs<ResolvedQueryStmt>(),
+        evaluator_options);
+    ZETASQL_CHECK_OK(query.Prepare(analyzer_options, tpch.catalog()));
+    end = absl::Now();
+    algebrize_time += end - start;
+
+    start = end;
+    OperatorProfile profile;
+    {
+      auto iter = query.ExecuteAfterPrepareWithProfile(
+          PreparedQuery::QueryOptions(), &profile);
+      ZETASQL_CHECK_OK(iter.status());
+      while ((*iter)->NextRow()) {
+        benchmark::DoNotOptimize((*iter)->GetValue(0));
+      }
+      ZETASQL_CHECK_OK((*iter)->Status());
+    }
+    end = absl::Now();
+    execute_time += end - start;
+    peak_memory_bytes =
+        std::max(peak_memory_bytes, profile.GetPeakMemoryBytes());
+  }
+
+  state.SetItemsProcessed(state.iterations() * tpch.num_lineitems());
+  state.counters["analyze_us"] = benchmark::Counter(
+      absl::ToDoubleMicroseconds(analyze_time),
+      benchmark::Counter::kAvgIterations);
+  state.counters["algebrize_us"] = benchmark::Counter(
+      absl::ToDoubleMicroseconds(algebrize_time),
+      benchmark::Counter::kAvgIterations);
+  state.counters["execute_us"] = benchmark::Counter(
+      absl::ToDoubleMicroseconds(execute_time),
+      benchmark::Counter::kAvgIterations);
+  state.counters["peak_memory_bytes"] =
+      static_cast<double>(peak_memory_bytes);
+}
+
+void ApplyScalesAndThreads(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"scale", "threads"})
+      ->ArgsProduct({{1, 10}, {1, 4}})
+      ->Unit(benchmark::kMillisecond);
+}
+
+BENCHMARK_CAPTURE(RunQuery, Q1, kQ1)->Apply(ApplyScalesAndThreads);
+BENCHMARK_CAPTURE(RunQuery, Q3, kQ3)->Apply(ApplyScalesAndThreads);
+BENCHMARK_CAPTURE(RunQuery, Q5, kQ5)->Apply(ApplyScalesAndThreads);
+BENCHMARK_CAPTURE(RunQuery, Q6, kQ6)->Apply(ApplyScalesAndThreads);
+BENCHMARK_CAPTURE(RunQuery, Q13, kQ13)->Apply(ApplyScalesAndThreads);
+BENCHMARK_CAPTURE(RunQuery, Q18, kQ18)->Apply(ApplyScalesAndThreads);
+
+}  // namespace
+}  // namespace zetasql
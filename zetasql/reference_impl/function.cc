@@ -62,12 +62,18 @@
 #include "zetasql/public/functions/differential_privacy.pb.h"
 #include "zetasql/public/functions/distance.h"
 #include "zetasql/public/interval_value.h"
+#include "zetasql/public/value.pb.h"
 #include "zetasql/public/types/timestamp_util.h"
 #include "zetasql/public/types/type.h"
+#include "zetasql/reference_impl/columnar_batch.h"
+#include "zetasql/reference_impl/columnar_kernels.h"
 #include "zetasql/reference_impl/functions/like.h"
+#include "zetasql/reference_impl/functions/regexp_cache.h"
+#include "zetasql/reference_impl/hll_sketch.h"
 #include "zetasql/reference_impl/operator.h"
 #include "zetasql/reference_impl/tuple.h"
 #include "absl/base/attributes.h"
+#include "absl/base/casts.h"
 #include "absl/base/const_init.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
@@ -83,6 +89,7 @@
 #include "google/protobuf/dynamic_message.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/wire_format_lite.h"
 #include "zetasql/public/functions/string_format.h"
 #include "zetasql/public/functions/generate_array.h"
 #include "zetasql/public/functions/json.h"
@@ -133,6 +140,7 @@
 #include "algorithms/quantiles.h"
 #include "zetasql/base/map_util.h"
 #include "zetasql/base/exactfloat.h"
+#include "zetasql/base/endian.h"
 #include "re2/re2.h"
 #include "zetasql/base/ret_check.h"
 #include "zetasql/base/status_builder.h"
@@ -420,6 +428,17 @@ absl::Status GenerateArray(BigNumericValue start, BigNumericValue end,
                                                 values);
 }
 
+// Generates an INT64 or DOUBLE array from start to end inclusive with the
+// specified step size. The elements are packed, see Value::MakePackedArray().
+template <typename T>
+absl::StatusOr<Value> GeneratePackedArray(const ArrayType* array_type, T start,
+                                          T end, T step) {
+  std::vector<T> values;
+  ZETASQL_RETURN_IF_ERROR(
+      (functions::GenerateArray<T, T>(start, end, step, &values)));
+  return Value::MakePackedArray(array_type, std::move(values));
+}
+
 // Define a a similar function to Value::Date(int32_t) for template matching
 // to be happy.
 Value MakeDate(int64_t in) { return Value::Date(in); }
@@ -996,6 +1015,14 @@ FunctionMap::FunctionMap() {
                      "Net.Ipv4_from_int64");
     RegisterFunction(FunctionKind::kNetIPv4ToInt64, "net.ipv4_to_int64",
                      "Net.Ipv4_to_int64");
+    RegisterFunction(FunctionKind::kHllCountInit, "hll_count.init",
+                     "Hll_count.Init");
+    RegisterFunction(FunctionKind::kHllCountMerge, "hll_count.merge",
+                     "Hll_count.Merge");
+    RegisterFunction(FunctionKind::kHllCountMergePartial,
+                     "hll_count.merge_partial", "Hll_count.Merge_partial");
+    RegisterFunction(FunctionKind::kHllCountExtract, "hll_count.extract",
+                     "Hll_count.Extract");
     RegisterFunction(FunctionKind::kDenseRank, "dense_rank", "Dense_rank");
     RegisterFunction(FunctionKind::kRank, "rank", "Rank");
     RegisterFunction(FunctionKind::kRowNumber, "row_number", "Row_number");
@@ -2089,6 +2116,20 @@ static absl::StatusOr<const InlineLambdaExpr*> GetLambdaArgumentForArrayZip(
   return inline_lambda_expr;
 }
 
+// Returns the value of the STRING argument 'arg' if it is a non-NULL constant,
+// e.g., the format string of a FORMAT_* or PARSE_* function.
+static std::optional<absl::string_view> GetConstantStringArgument(
+    const AlgebraArg& arg) {
+  const ValueExpr* value_expr = arg.value_expr();
+  if (value_expr == nullptr || !value_expr->IsConstant() ||
+      !value_expr->output_type()->IsString()) {
+    return std::nullopt;
+  }
+  const Value& value = static_cast<const ConstExpr*>(value_expr)->value();
+  if (value.is_null()) return std::nullopt;
+  return value.string_value();
+}
+
 absl::StatusOr<BuiltinScalarFunction*>
 BuiltinScalarFunction::CreateValidatedRaw(
     FunctionKind kind, const LanguageOptions& language_options,
@@ -2304,8 +2345,29 @@ BuiltinScalarFunction::CreateValidatedRaw(
     case FunctionKind::kCodePointsToString:
     case FunctionKind::kCodePointsToBytes:
       return new CodePointsToFunction(kind, output_type);
-    case FunctionKind::kFormat:
-      return new FormatFunction(output_type);
+    case FunctionKind::kFormat: {
+      // The pattern is processed here, once, when it is a constant. If that
+      // fails, the error is left to be reported when a row is evaluated.
+      std::unique_ptr<const functions::StringFormatPlan> format_plan;
+      if (std::optional<absl::string_view> format =
+              GetConstantStringArgument(*arguments[0]);
+          format.has_value()) {
+        std::vector<const Type*> types;
+        for (int i = 1; i < arguments.size(); ++i) {
+          if (arguments[i]->value_expr() == nullptr) break;
+          types.push_back(arguments[i]->value_expr()->output_type());
+        }
+        if (types.size() == arguments.size() - 1) {
+          absl::StatusOr<std::unique_ptr<const functions::StringFormatPlan>>
+              plan = functions::StringFormatPlan::Create(
+                  *format, std::move(types), language_options.product_mode(),
+                  /*canonicalize_zero=*/true,
+                  language_options.product_mode() == PRODUCT_EXTERNAL);
+          if (plan.ok()) format_plan = *std::move(plan);
+        }
+      }
+      return new FormatFunction(output_type, std::move(format_plan));
+    }
     case FunctionKind::kRegexpContains:
     case FunctionKind::kRegexpMatch:
     case FunctionKind::kRegexpExtract:
@@ -2461,8 +2523,16 @@ BuiltinScalarFunction::CreateValidatedRaw(
       return new ExtractDatetimeFromFunction(kind, output_type);
     case FunctionKind::kFormatDate:
     case FunctionKind::kFormatDatetime:
-    case FunctionKind::kFormatTimestamp:
-      return new FormatDateDatetimeTimestampFunction(kind, output_type);
+    case FunctionKind::kFormatTimestamp: {
+      std::unique_ptr<const functions::DateTimeFormatPlan> format_plan;
+      if (std::optional<absl::string_view> format =
+              GetConstantStringArgument(*arguments[0]);
+          format.has_value()) {
+        format_plan = functions::DateTimeFormatPlan::Compile(*format);
+      }
+      return new FormatDateDatetimeTimestampFunction(kind, output_type,
+                                                     std::move(format_plan));
+    }
     case FunctionKind::kFormatTime:
       return new FormatTimeFunction(kind, output_type);
     case FunctionKind::kTimestamp:
@@ -2500,8 +2570,16 @@ BuiltinScalarFunction::CreateValidatedRaw(
       return new ParseDatetimeFunction(kind, output_type);
     case FunctionKind::kParseTime:
       return new ParseTimeFunction(kind, output_type);
-    case FunctionKind::kParseTimestamp:
-      return new ParseTimestampFunction(kind, output_type);
+    case FunctionKind::kParseTimestamp: {
+      std::unique_ptr<const functions::TimestampParsePlan> parse_plan;
+      if (std::optional<absl::string_view> format =
+              GetConstantStringArgument(*arguments[0]);
+          format.has_value()) {
+        parse_plan = functions::TimestampParsePlan::Compile(*format);
+      }
+      return new ParseTimestampFunction(kind, output_type,
+                                        std::move(parse_plan));
+    }
     case FunctionKind::kIntervalCtor:
     case FunctionKind::kMakeInterval:
     case FunctionKind::kJustifyHours:
@@ -2525,6 +2603,8 @@ BuiltinScalarFunction::CreateValidatedRaw(
     case FunctionKind::kNetIPv4FromInt64:
     case FunctionKind::kNetIPv4ToInt64:
       return new NetFunction(kind, output_type);
+    case FunctionKind::kHllCountExtract:
+      return new HllCountExtractFunction(output_type);
     case FunctionKind::kMakeProto:
       ZETASQL_RET_CHECK_FAIL() << "MakeProto needs extra parameters";
       break;
@@ -2617,25 +2697,27 @@ BuiltinScalarFunction::CreateValidated(
 }
 
 namespace {
-absl::StatusOr<std::unique_ptr<RE2>> GetLikePatternRegexp(
-    const ValueExpr& arg) {
+// The minimum number of '%<literal>%' patterns for which a LIKE ANY matches
+// all of them at once with a LikeContainsAnyMatcher.
+constexpr int kMinPatternsForContainsAny = 4;
+
+absl::StatusOr<std::unique_ptr<const functions::LikeMatcher>>
+GetLikePatternMatcher(const ValueExpr& arg) {
   if (arg.IsConstant() &&
       (arg.output_type()->IsString() || arg.output_type()->IsBytes())) {
     const ConstExpr& pattern_expr = static_cast<const ConstExpr&>(arg);
     if (!pattern_expr.value().is_null()) {
-      // Build and precompile the regexp.
+      // Build and precompile the matcher.
       const std::string& pattern =
           pattern_expr.value().type_kind() == TYPE_STRING
               ? pattern_expr.value().string_value()
               : pattern_expr.value().bytes_value();
-      std::unique_ptr<RE2> regexp;
-      ZETASQL_RETURN_IF_ERROR(functions::CreateLikeRegexp(
-          pattern, arg.output_type()->kind(), &regexp));
-      return regexp;
+      return functions::LikeMatcher::Create(pattern,
+                                            arg.output_type()->kind());
     }
   }
   // The pattern is not a constant expression or it is null; build and
-  // compile the regexp at evaluation time.
+  // compile the matcher at evaluation time.
   return nullptr;
 }
 }  // namespace
@@ -2644,32 +2726,65 @@ absl::StatusOr<std::unique_ptr<BuiltinScalarFunction>>
 BuiltinScalarFunction::CreateLikeFunction(
     FunctionKind kind, const Type* output_type,
     absl::Span<const std::unique_ptr<AlgebraArg>> arguments) {
-  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<RE2> regexp,
-                   GetLikePatternRegexp(*arguments[1]->value_expr()));
-  return std::make_unique<LikeFunction>(kind, output_type, std::move(regexp));
+  ZETASQL_ASSIGN_OR_RETURN(
+      std::unique_ptr<const functions::LikeMatcher> matcher,
+      GetLikePatternMatcher(*arguments[1]->value_expr()));
+  return std::make_unique<LikeFunction>(kind, output_type, std::move(matcher));
 }
 
 absl::StatusOr<std::unique_ptr<BuiltinScalarFunction>>
 BuiltinScalarFunction::CreateLikeAnyAllFunction(
     FunctionKind kind, const Type* output_type,
     absl::Span<const std::unique_ptr<AlgebraArg>> arguments) {
-  std::vector<std::unique_ptr<RE2>> regexp;
+  std::vector<std::unique_ptr<const functions::LikeMatcher>> matchers;
   if (kind == FunctionKind::kLikeAny || kind == FunctionKind::kNotLikeAny ||
       kind == FunctionKind::kLikeAll || kind == FunctionKind::kNotLikeAll) {
     for (int i = 1; i < arguments.size(); ++i) {
-      ZETASQL_ASSIGN_OR_RETURN(regexp.emplace_back(),
-                       GetLikePatternRegexp(*arguments[i]->value_expr()));
+      ZETASQL_ASSIGN_OR_RETURN(matchers.emplace_back(),
+                       GetLikePatternMatcher(*arguments[i]->value_expr()));
+    }
+  }
+
+  if (kind == FunctionKind::kLikeAny) {
+    // Match all the '%<literal>%' patterns at once if there are enough of
+    // them, which is the common shape of a LIKE ANY over a list of keywords.
+    std::vector<absl::string_view> literals;
+    std::vector<int> other_pattern_idxs;
+    for (int i = 0; i < matchers.size(); ++i) {
+      absl::string_view literal;
+      if (matchers[i] != nullptr &&
+          matchers[i]->GetContainedLiteral(&literal)) {
+        literals.push_back(literal);
+      } else {
+        other_pattern_idxs.push_back(i);
+      }
+    }
+    if (literals.size() >= kMinPatternsForContainsAny) {
+      std::unique_ptr<const functions::LikeContainsAnyMatcher> contains_any =
+          functions::LikeContainsAnyMatcher::Create(
+              literals, arguments[0]->value_expr()->output_type()->kind());
+      if (contains_any != nullptr) {
+        std::vector<std::unique_ptr<const functions::LikeMatcher>>
+            other_matchers;
+        other_matchers.reserve(other_pattern_idxs.size());
+        for (int idx : other_pattern_idxs) {
+          other_matchers.push_back(std::move(matchers[idx]));
+        }
+        return std::make_unique<LikeAnyAllFunction>(
+            kind, output_type, std::move(other_matchers),
+            std::move(contains_any), std::move(other_pattern_idxs));
+      }
     }
   }
   return std::unique_ptr<BuiltinScalarFunction>(
-      new LikeAnyAllFunction(kind, output_type, std::move(regexp)));
+      new LikeAnyAllFunction(kind, output_type, std::move(matchers)));
 }
 
 absl::StatusOr<std::unique_ptr<BuiltinScalarFunction>>
 BuiltinScalarFunction::CreateLikeAnyAllArrayFunction(
     FunctionKind kind, const Type* output_type,
     absl::Span<const std::unique_ptr<AlgebraArg>> arguments) {
-  std::vector<std::unique_ptr<RE2>> regexp;
+  std::vector<std::unique_ptr<const functions::LikeMatcher>> matchers;
 
   // The second argument to this function will be an array.
   // Theses values are unpacked in order to generate the regular expressions
@@ -2684,14 +2799,14 @@ BuiltinScalarFunction::CreateLikeAnyAllArrayFunction(
       for (int i = 0; i < pattern_list->value().num_elements(); ++i) {
         ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<const ConstExpr> pattern,
                          ConstExpr::Create(pattern_list->value().element(i)));
-        ZETASQL_ASSIGN_OR_RETURN(regexp.emplace_back(),
-                         GetLikePatternRegexp(*pattern.get()));
+        ZETASQL_ASSIGN_OR_RETURN(matchers.emplace_back(),
+                         GetLikePatternMatcher(*pattern.get()));
       }
     }
   }
 
   return std::make_unique<LikeAnyAllArrayFunction>(kind, output_type,
-                                                   std::move(regexp));
+                                                   std::move(matchers));
 }
 
 absl::StatusOr<std::unique_ptr<ScalarFunctionCallExpr>>
@@ -2751,6 +2866,22 @@ absl::StatusOr<std::unique_ptr<const functions::RegExp>> CreateRegexp(
   }
 }
 
+// Like CreateRegexp(), but for a pattern that is not constant: the compiled
+// regexp is shared with other rows and statements using the same pattern.
+absl::StatusOr<std::shared_ptr<const functions::RegExp>> GetCachedRegexp(
+    const Value& arg) {
+  ZETASQL_RET_CHECK(!arg.is_null());
+  if (arg.type_kind() == TYPE_STRING) {
+    return RegexpCache::Global().GetRegExp(arg.string_value(), TYPE_STRING);
+  } else if (arg.type_kind() == TYPE_BYTES) {
+    return RegexpCache::Global().GetRegExp(arg.bytes_value(), TYPE_BYTES);
+  } else {
+    return ::zetasql_base::UnimplementedErrorBuilder()
+           << "Unsupported argument type for Regexp functions."
+           << arg.type()->ShortTypeName(ProductMode::PRODUCT_INTERNAL);
+  }
+}
+
 }  // namespace
 
 absl::StatusOr<std::unique_ptr<BuiltinScalarFunction>>
@@ -2788,6 +2919,43 @@ bool BuiltinScalarFunction::HasNulls(absl::Span<const Value> args) {
   }
   return false;
 }
+
+bool BuiltinScalarFunction::EvalColumns(
+    absl::Span<const TupleColumn* const> args, EvaluationContext* context,
+    TupleColumn* result, absl::Status* status) const {
+  *status = ::zetasql_base::UnimplementedErrorBuilder()
+            << "Columnar evaluation is not supported for " << debug_name();
+  return false;
+}
+
+// Returns true if 'arg_types' has exactly two elements with the same kind.
+static bool IsHomogeneousBinary(absl::Span<const Type* const> arg_types) {
+  return arg_types.size() == 2 &&
+         arg_types[0]->kind() == arg_types[1]->kind() &&
+         TupleColumn::SupportsType(arg_types[0]);
+}
+
+// Evaluates 'fn' on each pair of elements of 'x' and 'y' that is not NULL in
+// 'result', and stores the output in 'out'. Used by the EvalColumns()
+// implementations; the validity bitmap of 'result' must already be set.
+template <typename InType, typename OutType, typename Fn>
+static bool InvokeBinaryOnColumns(Fn fn, absl::Span<const InType> x,
+                                  absl::Span<const InType> y,
+                                  const TupleColumn& result,
+                                  absl::Span<OutType> out,
+                                  absl::Status* status) {
+  if (!result.HasNulls()) {
+    for (int i = 0; i < out.size(); ++i) {
+      if (ABSL_PREDICT_FALSE(!fn(x[i], y[i], &out[i], status))) return false;
+    }
+    return true;
+  }
+  for (int i = 0; i < out.size(); ++i) {
+    if (result.IsNull(i)) continue;
+    if (ABSL_PREDICT_FALSE(!fn(x[i], y[i], &out[i], status))) return false;
+  }
+  return true;
+}
 // REQUIRES: all inputs are non-null.
 static Value FindNaN(absl::Span<const Value> args) {
   for (const auto& value : args) {
@@ -2941,11 +3109,14 @@ absl::StatusOr<Value> FormatFunction::Eval(
   bool is_null;
   absl::Span<const Value> values(args);
   values.remove_prefix(1);
-  ZETASQL_RETURN_IF_ERROR(functions::StringFormatUtf8(
-      args[0].string_value(), values,
-      context->GetLanguageOptions().product_mode(), &output,
-      &is_null, true, context->GetLanguageOptions().product_mode() ==
-          PRODUCT_EXTERNAL));
+  if (format_plan_ != nullptr) {
+    ZETASQL_RETURN_IF_ERROR(format_plan_->Format(values, &output, &is_null));
+  } else {
+    ZETASQL_RETURN_IF_ERROR(functions::StringFormatUtf8(
+        args[0].string_value(), values,
+        context->GetLanguageOptions().product_mode(), &output, &is_null, true,
+        context->GetLanguageOptions().product_mode() == PRODUCT_EXTERNAL));
+  }
   Value value;
   if (is_null) {
     value = Value::NullString();
@@ -2978,12 +3149,18 @@ absl::StatusOr<Value> GenerateArrayFunction::Eval(
   }
 
   const bool has_step = args.size() >= 3;
+  const ArrayType* array_type = output_type()->AsArray();
+  // Set for the packed INT64 and DOUBLE arrays, otherwise built from
+  // 'range_values'.
+  Value array_value;
   std::vector<Value> range_values;
   switch (args[0].type_kind()) {
     case TYPE_INT64:
-      ZETASQL_RETURN_IF_ERROR(GenerateArray(
-          args[0].int64_value(), args[1].int64_value(),
-          has_step ? args[2].int64_value() : 1, context, &range_values));
+      ZETASQL_ASSIGN_OR_RETURN(array_value,
+                       GeneratePackedArray<int64_t>(
+                           array_type, args[0].int64_value(),
+                           args[1].int64_value(),
+                           has_step ? args[2].int64_value() : 1));
       break;
     case TYPE_UINT64:
       ZETASQL_RETURN_IF_ERROR(GenerateArray(
@@ -3003,9 +3180,11 @@ absl::StatusOr<Value> GenerateArrayFunction::Eval(
           &range_values));
       break;
     case TYPE_DOUBLE:
-      ZETASQL_RETURN_IF_ERROR(GenerateArray(
-          args[0].double_value(), args[1].double_value(),
-          has_step ? args[2].double_value() : 1.0, context, &range_values));
+      ZETASQL_ASSIGN_OR_RETURN(array_value,
+                       GeneratePackedArray<double>(
+                           array_type, args[0].double_value(),
+                           args[1].double_value(),
+                           has_step ? args[2].double_value() : 1.0));
       break;
     case TYPE_DATE: {
       int64_t step = 1;
@@ -3035,7 +3214,9 @@ absl::StatusOr<Value> GenerateArrayFunction::Eval(
       return ::zetasql_base::UnimplementedErrorBuilder()
              << "Unsupported argument type for generate_array.";
   }
-  Value array_value = Value::Array(output_type()->AsArray(), range_values);
+  if (!array_value.is_valid()) {
+    array_value = Value::Array(array_type, range_values);
+  }
   if (array_value.physical_byte_size() >
       context->options().max_value_byte_size) {
     return MakeMaxArrayValueByteSizeExceededError(
@@ -3524,6 +3705,106 @@ bool ArithmeticFunction::Eval(absl::Span<const TupleData* const> params,
   return false;
 }
 
+bool ArithmeticFunction::SupportsEvalColumns(
+    absl::Span<const Type* const> arg_types) const {
+  if (!IsHomogeneousBinary(arg_types) ||
+      !arg_types[0]->Equals(output_type())) {
+    return false;
+  }
+  switch (FCT(kind(), arg_types[0]->kind())) {
+    case FCT(FunctionKind::kAdd, TYPE_INT64):
+    case FCT(FunctionKind::kSubtract, TYPE_INT64):
+    case FCT(FunctionKind::kMultiply, TYPE_INT64):
+    case FCT(FunctionKind::kAdd, TYPE_DOUBLE):
+    case FCT(FunctionKind::kSubtract, TYPE_DOUBLE):
+    case FCT(FunctionKind::kMultiply, TYPE_DOUBLE):
+    case FCT(FunctionKind::kDivide, TYPE_DOUBLE):
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool ArithmeticFunction::EvalColumns(absl::Span<const TupleColumn* const> args,
+                                     EvaluationContext* context,
+                                     TupleColumn* result,
+                                     absl::Status* status) const {
+  ABSL_DCHECK_EQ(2, args.size());
+  const TupleColumn& x = *args[0];
+  const TupleColumn& y = *args[1];
+  result->Resize(x.size());
+  result->SetValidityToIntersection(x, y);
+
+  // Each case runs the vectorizable kernel over all rows first. Only if the
+  // kernel reports that some row may have failed do we rerun the scalar
+  // function over the valid rows, to find out whether a non-NULL row really
+  // failed and to produce the same error as Eval().
+  switch (FCT(kind(), x.type_kind())) {
+    case FCT(FunctionKind::kAdd, TYPE_INT64):
+      if (!columnar_kernels::AddInt64(x.int64_values(), y.int64_values(),
+                                      result->mutable_int64_values())) {
+        return true;
+      }
+      return InvokeBinaryOnColumns(
+          &functions::Add<int64_t>, x.int64_values(), y.int64_values(),
+          *result, result->mutable_int64_values(), status);
+    case FCT(FunctionKind::kSubtract, TYPE_INT64):
+      if (!columnar_kernels::SubtractInt64(x.int64_values(), y.int64_values(),
+                                           result->mutable_int64_values())) {
+        return true;
+      }
+      return InvokeBinaryOnColumns(
+          &functions::Subtract<int64_t>, x.int64_values(), y.int64_values(),
+          *result, result->mutable_int64_values(), status);
+    case FCT(FunctionKind::kMultiply, TYPE_INT64):
+      if (!columnar_kernels::MultiplyInt64(x.int64_values(), y.int64_values(),
+                                           result->mutable_int64_values())) {
+        return true;
+      }
+      return InvokeBinaryOnColumns(
+          &functions::Multiply<int64_t>, x.int64_values(), y.int64_values(),
+          *result, result->mutable_int64_values(), status);
+    case FCT(FunctionKind::kAdd, TYPE_DOUBLE):
+      if (!columnar_kernels::BinaryDouble(std::plus<double>(),
+                                          x.double_values(), y.double_values(),
+                                          result->mutable_double_values())) {
+        return true;
+      }
+      return InvokeBinaryOnColumns(
+          &functions::Add<double>, x.double_values(), y.double_values(),
+          *result, result->mutable_double_values(), status);
+    case FCT(FunctionKind::kSubtract, TYPE_DOUBLE):
+      if (!columnar_kernels::BinaryDouble(std::minus<double>(),
+                                          x.double_values(), y.double_values(),
+                                          result->mutable_double_values())) {
+        return true;
+      }
+      return InvokeBinaryOnColumns(
+          &functions::Subtract<double>, x.double_values(), y.double_values(),
+          *result, result->mutable_double_values(), status);
+    case FCT(FunctionKind::kMultiply, TYPE_DOUBLE):
+      if (!columnar_kernels::BinaryDouble(std::multiplies<double>(),
+                                          x.double_values(), y.double_values(),
+                                          result->mutable_double_values())) {
+        return true;
+      }
+      return InvokeBinaryOnColumns(
+          &functions::Multiply<double>, x.double_values(), y.double_values(),
+          *result, result->mutable_double_values(), status);
+    case FCT(FunctionKind::kDivide, TYPE_DOUBLE):
+      if (!columnar_kernels::DivideDouble(x.double_values(), y.double_values(),
+                                          result->mutable_double_values())) {
+        return true;
+      }
+      return InvokeBinaryOnColumns(
+          &functions::Divide<double>, x.double_values(), y.double_values(),
+          *result, result->mutable_double_values(), status);
+  }
+  *status = ::zetasql_base::UnimplementedErrorBuilder()
+            << "Unsupported columnar arithmetic function: " << debug_name();
+  return false;
+}
+
 static bool IsDistinctFromInt64UInt64(Value int64_value, Value uint64_value) {
   if (int64_value.is_null() || uint64_value.is_null()) {
     return int64_value.is_null() != uint64_value.is_null();
@@ -3749,6 +4030,73 @@ bool ComparisonFunction::Eval(absl::Span<const TupleData* const> params,
   return false;
 }
 
+bool ComparisonFunction::SupportsEvalColumns(
+    absl::Span<const Type* const> arg_types) const {
+  if (!IsHomogeneousBinary(arg_types)) return false;
+  return kind() == FunctionKind::kEqual || kind() == FunctionKind::kLess ||
+         kind() == FunctionKind::kLessOrEqual;
+}
+
+template <typename T>
+static bool CompareColumns(FunctionKind kind, absl::Span<const T> x,
+                           absl::Span<const T> y, TupleColumn* result,
+                           absl::Status* status) {
+  switch (kind) {
+    case FunctionKind::kEqual:
+      columnar_kernels::Compare(std::equal_to<T>(), x, y,
+                                result->mutable_bool_values());
+      return true;
+    case FunctionKind::kLess:
+      columnar_kernels::Compare(std::less<T>(), x, y,
+                                result->mutable_bool_values());
+      return true;
+    case FunctionKind::kLessOrEqual:
+      columnar_kernels::Compare(std::less_equal<T>(), x, y,
+                                result->mutable_bool_values());
+      return true;
+    default:
+      *status = ::zetasql_base::UnimplementedErrorBuilder()
+                << "Unsupported columnar comparison function";
+      return false;
+  }
+}
+
+bool ComparisonFunction::EvalColumns(absl::Span<const TupleColumn* const> args,
+                                     EvaluationContext* context,
+                                     TupleColumn* result,
+                                     absl::Status* status) const {
+  ABSL_DCHECK_EQ(2, args.size());
+  const TupleColumn& x = *args[0];
+  const TupleColumn& y = *args[1];
+  result->Resize(x.size());
+  result->SetValidityToIntersection(x, y);
+
+  // Bitwise comparison of the native values has the same semantics as the
+  // row-based Eval() for these types; in particular comparisons with NaN
+  // return false.
+  switch (x.type_kind()) {
+    case TYPE_INT64:
+      return CompareColumns(kind(), x.int64_values(), y.int64_values(), result,
+                            status);
+    case TYPE_DOUBLE:
+      return CompareColumns(kind(), x.double_values(), y.double_values(),
+                            result, status);
+    case TYPE_BOOL:
+      return CompareColumns(kind(), x.bool_values(), y.bool_values(), result,
+                            status);
+    case TYPE_STRING:
+    case TYPE_BYTES:
+      return CompareColumns(kind(), x.string_values(), y.string_values(),
+                            result, status);
+    default:
+      *status = ::zetasql_base::UnimplementedErrorBuilder()
+                << "Unsupported columnar comparison function: " << debug_name()
+                << " with inputs " << TypeKind_Name(x.type_kind()) << " and "
+                << TypeKind_Name(y.type_kind());
+      return false;
+  }
+}
+
 bool ExistsFunction::Eval(absl::Span<const TupleData* const> params,
                           absl::Span<const Value> args,
                           EvaluationContext* context, Value* result,
@@ -3787,18 +4135,31 @@ bool ArrayConcatFunction::Eval(absl::Span<const TupleData* const> params,
     }
     num_values += input_array.num_elements();
   }
-  std::vector<Value> values;
-  values.reserve(num_values);
   auto is_ordered = InternalValue::kPreservesOrder;
+  const Value* only_non_empty_array = nullptr;
   for (const Value& input_array : args) {
     if (InternalValue::GetOrderKind(input_array) ==
         InternalValue::kIgnoresOrder) {
       is_ordered = InternalValue::kIgnoresOrder;
     }
-    for (int i = 0; i < input_array.num_elements(); ++i) {
-      values.push_back(input_array.element(i));
+    if (input_array.num_elements() == num_values) {
+      only_non_empty_array = &input_array;
     }
   }
+  // If all the elements come from one array, the result can share its
+  // elements instead of copying them.
+  if (only_non_empty_array != nullptr && num_values > 0 &&
+      InternalValue::GetOrderKind(*only_non_empty_array) == is_ordered &&
+      only_non_empty_array->type()->Equals(output_type())) {
+    *result = *only_non_empty_array;
+    return true;
+  }
+  std::vector<Value> values;
+  values.reserve(num_values);
+  for (const Value& input_array : args) {
+    const std::vector<Value>& elements = input_array.elements();
+    values.insert(values.end(), elements.begin(), elements.end());
+  }
   *result = InternalValue::ArrayNotChecked(output_type()->AsArray(), is_ordered,
                                            std::move(values));
   return true;
@@ -3817,12 +4178,32 @@ bool ArrayLengthFunction::Eval(absl::Span<const TupleData* const> params,
   return true;
 }
 
+LambdaEvaluationContext::LambdaEvaluationContext(
+    absl::Span<const TupleData* const> params, EvaluationContext* context)
+    : context_(context) {
+  params_and_args_.reserve(params.size() + 1);
+  params_and_args_.assign(params.begin(), params.end());
+  params_and_args_.push_back(&args_data_);
+}
+
 absl::StatusOr<Value> LambdaEvaluationContext::EvaluateLambda(
     const InlineLambdaExpr* lambda, absl::Span<const Value> args) {
+  ZETASQL_RET_CHECK_EQ(args.size(), lambda->num_args())
+      << "Number of arguments doesn't match number of values provided for "
+         "lambda: "
+      << lambda->DebugString();
+  if (args_data_.num_slots() != args.size()) {
+    args_data_.Clear();
+    args_data_.AddSlots(static_cast<int>(args.size()));
+  }
+  for (int i = 0; i < args.size(); ++i) {
+    args_data_.mutable_slot(i)->SetValue(args[i]);
+  }
   Value result;
   VirtualTupleSlot lambda_body_slot(&result, &shared_proto_state_);
   absl::Status status;
-  if (!lambda->Eval(params_, context_, &lambda_body_slot, &status, args)) {
+  if (!lambda->EvalBody(params_and_args_, context_, &lambda_body_slot,
+                        &status)) {
     ZETASQL_RET_CHECK(!status.ok());
     return status;
   }
@@ -3848,26 +4229,33 @@ absl::StatusOr<Value> ArrayFilterFunction::Eval(
     evaluation_context->SetNonDeterministicOutput();
   }
 
+  const std::vector<Value>& elements = args[0].elements();
   std::vector<Value> filtered_values;
   bool two_argument_lambda = lambda_->num_args() == 2;
-  for (int i = 0; i < args[0].num_elements(); ++i) {
-    const Value& array_element = args[0].element(i);
-    std::vector<Value> lambda_args = {array_element};
-    if (two_argument_lambda) {
-      // If a two-argument lambda is supplied, the lambda receives an additional
-      // parameter specifying the zero-based array index of the array element
-      // passed in for the first parameter.
-      lambda_args.push_back(Value::Int64(i));
-    }
-    ZETASQL_ASSIGN_OR_RETURN(Value lambda_result,
-                     context.EvaluateLambda(lambda_, lambda_args));
+  for (int i = 0; i < elements.size(); ++i) {
+    const Value& array_element = elements[i];
+    // If a two-argument lambda is supplied, the lambda receives an additional
+    // parameter specifying the zero-based array index of the array element
+    // passed in for the first parameter.
+    ZETASQL_ASSIGN_OR_RETURN(
+        Value lambda_result,
+        two_argument_lambda
+            ? context.EvaluateLambda(lambda_, {array_element, Value::Int64(i)})
+            : context.EvaluateLambda(lambda_, {array_element}));
     ZETASQL_RET_CHECK(lambda_result.type()->IsBool());
     if (!lambda_result.is_null() && lambda_result.bool_value()) {
-      filtered_values.push_back(std::move(array_element));
+      filtered_values.push_back(array_element);
     }
   }
 
-  return Value::MakeArray(args[0].type()->AsArray(), filtered_values);
+  // If every element is kept, the result can share the elements of the input.
+  if (filtered_values.size() == elements.size() &&
+      InternalValue::GetOrderKind(args[0]) == InternalValue::kPreservesOrder) {
+    return args[0];
+  }
+  return InternalValue::ArrayNotChecked(args[0].type()->AsArray(),
+                                        InternalValue::kPreservesOrder,
+                                        std::move(filtered_values));
 }
 
 absl::StatusOr<Value> ArrayIncludesFunctionWithLambda::Eval(
@@ -3881,8 +4269,7 @@ absl::StatusOr<Value> ArrayIncludesFunctionWithLambda::Eval(
   }
 
   bool found = false;
-  for (int i = 0; i < args[0].num_elements(); ++i) {
-    const Value& array_element = args[0].element(i);
+  for (const Value& array_element : args[0].elements()) {
     ZETASQL_ASSIGN_OR_RETURN(Value lambda_result,
                      context.EvaluateLambda(lambda_, {array_element}));
     ZETASQL_RET_CHECK(lambda_result.type()->IsBool());
@@ -3913,24 +4300,25 @@ absl::StatusOr<Value> ArrayTransformFunction::Eval(
     evaluation_context->SetNonDeterministicOutput();
   }
 
+  const std::vector<Value>& elements = args[0].elements();
   std::vector<Value> transformed_values;
+  transformed_values.reserve(elements.size());
   bool two_argument_lambda = lambda_->num_args() == 2;
-  for (int i = 0; i < args[0].num_elements(); ++i) {
-    const Value& array_element = args[0].element(i);
-    Value lambda_body_value;
-    std::vector<Value> lambda_args = {array_element};
-    if (two_argument_lambda) {
-      // If a two-argument lambda is supplied, the lambda receives an additional
-      // parameter specifying the zero-based array index of the array element
-      // passed in for the first parameter.
-      lambda_args.push_back(Value::Int64(i));
-    }
-    ZETASQL_ASSIGN_OR_RETURN(lambda_body_value,
-                     context.EvaluateLambda(lambda_, lambda_args));
+  for (int i = 0; i < elements.size(); ++i) {
+    const Value& array_element = elements[i];
+    // If a two-argument lambda is supplied, the lambda receives an additional
+    // parameter specifying the zero-based array index of the array element
+    // passed in for the first parameter.
+    ZETASQL_ASSIGN_OR_RETURN(
+        Value lambda_body_value,
+        two_argument_lambda
+            ? context.EvaluateLambda(lambda_, {array_element, Value::Int64(i)})
+            : context.EvaluateLambda(lambda_, {array_element}));
     transformed_values.push_back(std::move(lambda_body_value));
   }
 
-  return Value::MakeArray(this->output_type()->AsArray(), transformed_values);
+  return Value::MakeArray(this->output_type()->AsArray(),
+                          std::move(transformed_values));
 }
 
 bool ArrayElementFunction::Eval(absl::Span<const TupleData* const> params,
@@ -4020,9 +4408,14 @@ absl::StatusOr<Value> ArrayReverseFunction::Eval(
 
   MaybeSetNonDeterministicArrayOutput(args[0], context);
 
-  std::vector<Value> elements = args[0].elements();
-  std::reverse(elements.begin(), elements.end());
-  return Value::Array(output_type()->AsArray(), elements);
+  if (args[0].num_elements() <= 1 &&
+      InternalValue::GetOrderKind(args[0]) == InternalValue::kPreservesOrder) {
+    return args[0];
+  }
+  const std::vector<Value>& elements = args[0].elements();
+  return InternalValue::ArrayNotChecked(
+      args[0].type()->AsArray(), InternalValue::kPreservesOrder,
+      std::vector<Value>(elements.rbegin(), elements.rend()));
 }
 
 absl::StatusOr<Value> ArrayIsDistinctFunction::Eval(
@@ -4059,6 +4452,19 @@ absl::StatusOr<Value> ArrayIsDistinctFunction::Eval(
   return Value::Bool(true);
 }
 
+// Returns true if the array 'array' with packed elements 'values' (see
+// Value::MakePackedArray()) has an element equal to 'target'.
+template <typename T>
+static bool PackedArrayIncludes(const Value& array, absl::Span<const T> values,
+                                T target) {
+  for (int i = 0; i < values.size(); ++i) {
+    if (values[i] == target && !array.packed_element_is_null(i)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 absl::StatusOr<Value> ArrayIncludesFunction::Eval(
     absl::Span<const TupleData* const> params, absl::Span<const Value> args,
     EvaluationContext* context) const {
@@ -4069,6 +4475,18 @@ absl::StatusOr<Value> ArrayIncludesFunction::Eval(
 
   // Find the target.
   const Value& target = args[1];
+  if (args[0].has_packed_elements()) {
+    const TypeKind element_kind =
+        args[0].type()->AsArray()->element_type()->kind();
+    if (element_kind == TYPE_INT64 && target.type_kind() == TYPE_INT64) {
+      return Value::Bool(PackedArrayIncludes(
+          args[0], args[0].packed_int64_elements(), target.int64_value()));
+    }
+    if (element_kind == TYPE_DOUBLE && target.type_kind() == TYPE_DOUBLE) {
+      return Value::Bool(PackedArrayIncludes(
+          args[0], args[0].packed_double_elements(), target.double_value()));
+    }
+  }
   for (const Value& element : args[0].elements()) {
     Value equals = element.SqlEquals(target);
     ZETASQL_RET_CHECK(equals.is_valid())
@@ -4203,12 +4621,50 @@ absl::StatusOr<Value> ArraySliceFunction::Eval(
   }
   start = std::max(int64_t{0}, start);
   end = std::min(int64_t{array_length - 1}, end);
+  // A slice of the whole array shares the elements of the input.
+  if (start == 0 && end == array_length - 1 &&
+      InternalValue::GetOrderKind(args[0]) == InternalValue::kPreservesOrder) {
+    return args[0];
+  }
   const std::vector<Value>& elements = args[0].elements();
-  std::vector<Value> result(elements.begin() + start,
-                            elements.begin() + end + 1);
-  Value output = Value::Array(output_type()->AsArray(), result);
-  ZETASQL_RET_CHECK(output.is_valid());
-  return output;
+  return InternalValue::ArrayNotChecked(
+      args[0].type()->AsArray(), InternalValue::kPreservesOrder,
+      std::vector<Value>(elements.begin() + start, elements.begin() + end + 1));
+}
+
+// Returns the minimum (if 'is_min') or maximum non-NULL element of the array
+// 'array' with packed elements 'values' (see Value::MakePackedArray()), or
+// NULL if there is none. As for other arrays, the result is NaN if any
+// element is NaN.
+template <typename T>
+static Value PackedArrayMinMax(const Value& array, absl::Span<const T> values,
+                               bool is_min) {
+  std::optional<T> result;
+  for (int i = 0; i < values.size(); ++i) {
+    if (array.packed_element_is_null(i)) {
+      continue;
+    }
+    const T value = values[i];
+    if (!result.has_value()) {
+      result = value;
+    } else if constexpr (std::is_floating_point_v<T>) {
+      if (std::isnan(value) || std::isnan(*result)) {
+        result = std::numeric_limits<T>::quiet_NaN();
+      } else {
+        result = is_min ? std::min(*result, value) : std::max(*result, value);
+      }
+    } else {
+      result = is_min ? std::min(*result, value) : std::max(*result, value);
+    }
+  }
+  if (!result.has_value()) {
+    return Value::Null(array.type()->AsArray()->element_type());
+  }
+  if constexpr (std::is_floating_point_v<T>) {
+    return Value::Double(*result);
+  } else {
+    return Value::Int64(*result);
+  }
 }
 
 absl::StatusOr<Value> ArrayMinMaxFunction::Eval(
@@ -4220,6 +4676,14 @@ absl::StatusOr<Value> ArrayMinMaxFunction::Eval(
   if (args[0].is_null() || args[0].is_empty_array()) {
     return Value::Null(output_type());
   }
+  if (args[0].has_packed_elements() && output_type()->IsInt64()) {
+    return PackedArrayMinMax(args[0], args[0].packed_int64_elements(),
+                             kind() == FunctionKind::kArrayMin);
+  }
+  if (args[0].has_packed_elements() && output_type()->IsDouble()) {
+    return PackedArrayMinMax(args[0], args[0].packed_double_elements(),
+                             kind() == FunctionKind::kArrayMin);
+  }
   bool has_ties = false;
 
   Value output_null = Value::Null(output_type());
@@ -4932,6 +5396,61 @@ static absl::StatusOr<Value> AggregateIntervalArrayAvgValue(
   return Value::NullInterval();
 }
 
+// Computes ARRAY_SUM (if 'is_sum') or ARRAY_AVG of the array 'array' with
+// packed elements 'values' (see Value::MakePackedArray()), like the functions
+// above do for arrays of Values.
+template <typename T>
+static absl::StatusOr<Value> AggregatePackedArraySumAvgValue(
+    const Value& array, absl::Span<const T> values, bool is_sum,
+    const Type* output_type) {
+  using SumType = std::conditional_t<std::is_floating_point_v<T>,
+                                     zetasql_base::ExactFloat, __int128>;
+  SumType sum = 0;
+  long double avg = 0;
+  int64_t non_null_count = 0;
+  for (int i = 0; i < values.size(); ++i) {
+    if (array.packed_element_is_null(i)) {
+      continue;
+    }
+    non_null_count++;
+    if (is_sum) {
+      sum += values[i];
+      continue;
+    }
+    long double delta;
+    absl::Status status;
+    // Use Donald Knuth's iterative running mean algorithm to compute average.
+    const double value = static_cast<double>(values[i]);
+    if (!functions::Subtract(static_cast<long double>(value), avg, &delta,
+                             &status) ||
+        !functions::Add(avg, delta / non_null_count, &avg, &status)) {
+      return status;
+    }
+  }
+  if (non_null_count == 0) {
+    return Value::Null(output_type);
+  }
+  if (!is_sum) {
+    ZETASQL_RET_CHECK_OK(ValidateNoDoubleOverflow(avg));
+    return Value::Double(static_cast<double>(avg));
+  }
+  if constexpr (std::is_floating_point_v<T>) {
+    if (sum.is_finite() && (sum > std::numeric_limits<double>::max() ||
+                            sum < -std::numeric_limits<double>::max())) {
+      return ::zetasql_base::OutOfRangeErrorBuilder()
+             << "ARRAY_SUM double overflow";
+    }
+    return Value::Double(sum.ToDouble());
+  } else {
+    if (sum > std::numeric_limits<int64_t>::max() ||
+        sum < std::numeric_limits<int64_t>::min()) {
+      return ::zetasql_base::OutOfRangeErrorBuilder()
+             << "ARRAY_SUM int64_t overflow";
+    }
+    return Value::Int64(static_cast<int64_t>(sum));
+  }
+}
+
 absl::StatusOr<Value> ArraySumAvgFunction::Eval(
     absl::Span<const TupleData* const> params, absl::Span<const Value> args,
     EvaluationContext* context) const {
@@ -4958,6 +5477,18 @@ absl::StatusOr<Value> ArraySumAvgFunction::Eval(
   }
   Value output = Value::Null(output_type());
 
+  if (args[0].has_packed_elements()) {
+    const bool is_sum = kind() == FunctionKind::kArraySum;
+    if (element_type->IsInt64()) {
+      return AggregatePackedArraySumAvgValue(
+          args[0], args[0].packed_int64_elements(), is_sum, output_type());
+    }
+    if (element_type->IsDouble()) {
+      return AggregatePackedArraySumAvgValue(
+          args[0], args[0].packed_double_elements(), is_sum, output_type());
+    }
+  }
+
   switch (FCT(kind(), element_type->kind())) {
     // ARRAY_SUM
     case FCT(FunctionKind::kArraySum, TYPE_INT32):
@@ -5161,6 +5692,46 @@ bool IsFunction::Eval(absl::Span<const TupleData* const> params,
   }
 }
 
+bool IsFunction::SupportsEvalColumns(
+    absl::Span<const Type* const> arg_types) const {
+  if (arg_types.size() != 1 || !TupleColumn::SupportsType(arg_types[0])) {
+    return false;
+  }
+  return kind() == FunctionKind::kIsNull || arg_types[0]->IsBool();
+}
+
+bool IsFunction::EvalColumns(absl::Span<const TupleColumn* const> args,
+                             EvaluationContext* context, TupleColumn* result,
+                             absl::Status* status) const {
+  ABSL_DCHECK_EQ(1, args.size());
+  const TupleColumn& x = *args[0];
+  result->Resize(x.size());
+  absl::Span<uint8_t> out = result->mutable_bool_values();
+  switch (kind()) {
+    case FunctionKind::kIsNull:
+      for (int i = 0; i < x.size(); ++i) {
+        out[i] = x.IsNull(i) ? 1 : 0;
+      }
+      break;
+    case FunctionKind::kIsTrue:
+    case FunctionKind::kIsFalse: {
+      const uint8_t expected = kind() == FunctionKind::kIsTrue ? 1 : 0;
+      const absl::Span<const uint8_t> values = x.bool_values();
+      for (int i = 0; i < x.size(); ++i) {
+        out[i] = (!x.IsNull(i) && values[i] == expected) ? 1 : 0;
+      }
+      break;
+    }
+    default:
+      *status = ::zetasql_base::UnimplementedErrorBuilder()
+                << "Unexpected function: " << debug_name();
+      return false;
+  }
+  // The result is never NULL.
+  result->SetAllValid();
+  return true;
+}
+
 absl::StatusOr<Value> CastFunction::Eval(
     absl::Span<const TupleData* const> params, absl::Span<const Value> args,
     EvaluationContext* context) const {
@@ -5318,6 +5889,67 @@ bool LogicalFunction::Eval(absl::Span<const TupleData* const> params,
   return false;
 }
 
+bool LogicalFunction::SupportsEvalColumns(
+    absl::Span<const Type* const> arg_types) const {
+  if (arg_types.empty()) return false;
+  for (const Type* type : arg_types) {
+    if (!type->IsBool()) return false;
+  }
+  switch (kind()) {
+    case FunctionKind::kAnd:
+    case FunctionKind::kOr:
+      return true;
+    case FunctionKind::kNot:
+      return arg_types.size() == 1;
+    default:
+      return false;
+  }
+}
+
+bool LogicalFunction::EvalColumns(absl::Span<const TupleColumn* const> args,
+                                  EvaluationContext* context,
+                                  TupleColumn* result,
+                                  absl::Status* status) const {
+  const int num_rows = args[0]->size();
+  result->Resize(num_rows);
+  absl::Span<uint8_t> out = result->mutable_bool_values();
+  if (kind() == FunctionKind::kNot) {
+    const absl::Span<const uint8_t> x = args[0]->bool_values();
+    for (int i = 0; i < num_rows; ++i) {
+      out[i] = x[i] ^ 1;
+    }
+    result->SetValidityFrom(*args[0]);
+    return true;
+  }
+  if (kind() != FunctionKind::kAnd && kind() != FunctionKind::kOr) {
+    *status = ::zetasql_base::UnimplementedErrorBuilder()
+              << "Unsupported columnar logical function: " << debug_name();
+    return false;
+  }
+
+  // For AND, 'decided' tracks the rows with a known FALSE argument, and
+  // 'all_valid' the rows where every argument is non-NULL; OR is the same
+  // with TRUE. A row is non-NULL if it is decided or all its arguments are
+  // non-NULL, and then its value is the value of the decided argument, or
+  // the identity of the operator if it is not decided.
+  const uint8_t decisive_value = kind() == FunctionKind::kAnd ? 0 : 1;
+  std::vector<uint8_t> decided(num_rows, 0);
+  std::vector<uint8_t> all_valid(num_rows, 1);
+  for (const TupleColumn* arg : args) {
+    const absl::Span<const uint8_t> x = arg->bool_values();
+    for (int i = 0; i < num_rows; ++i) {
+      const uint8_t valid = arg->IsNull(i) ? 0 : 1;
+      all_valid[i] &= valid;
+      decided[i] |= valid & (x[i] == decisive_value ? 1 : 0);
+    }
+  }
+  for (int i = 0; i < num_rows; ++i) {
+    out[i] = decided[i] ? decisive_value : decisive_value ^ 1;
+    if (decided[i] | all_valid[i]) result->SetValid(i);
+  }
+  return true;
+}
+
 std::string BuiltinAggregateFunction::debug_name() const {
   return BuiltinFunctionCatalog::GetDebugNameByKind(kind());
 }
@@ -5328,7 +5960,198 @@ namespace {
 // does an OR of all input values including NULLs and returns false for empty
 // input.
 
-// Accumulator implementation for BuiltinAggregateFunction.
+// Returns true if BuiltinAggregateAccumulator::Merge() supports the aggregate
+// function 'kind' over inputs of type 'input_kind'.
+bool IsMergeableBuiltinAggregate(FunctionKind kind, TypeKind input_kind) {
+  switch (kind) {
+    case FunctionKind::kAnyValue:
+    case FunctionKind::kArrayAgg:
+    case FunctionKind::kCount:
+      return true;
+    default:
+      break;
+  }
+  switch (FCT(kind, input_kind)) {
+    case FCT(FunctionKind::kCountIf, TYPE_BOOL):
+    case FCT(FunctionKind::kStringAgg, TYPE_STRING):
+    case FCT(FunctionKind::kStringAgg, TYPE_BYTES):
+    case FCT(FunctionKind::kSum, TYPE_INT64):
+    case FCT(FunctionKind::kSum, TYPE_UINT64):
+    case FCT(FunctionKind::kSum, TYPE_DOUBLE):
+    case FCT(FunctionKind::kSum, TYPE_NUMERIC):
+    case FCT(FunctionKind::kSum, TYPE_BIGNUMERIC):
+    case FCT(FunctionKind::kSum, TYPE_INTERVAL):
+    case FCT(FunctionKind::kAvg, TYPE_INT64):
+    case FCT(FunctionKind::kAvg, TYPE_UINT64):
+    case FCT(FunctionKind::kAvg, TYPE_DOUBLE):
+    case FCT(FunctionKind::kAvg, TYPE_NUMERIC):
+    case FCT(FunctionKind::kAvg, TYPE_BIGNUMERIC):
+    case FCT(FunctionKind::kAvg, TYPE_INTERVAL):
+      return true;
+    default:
+      break;
+  }
+  if (kind != FunctionKind::kMin && kind != FunctionKind::kMax) return false;
+  switch (input_kind) {
+    case TYPE_BOOL:
+    case TYPE_INT32:
+    case TYPE_INT64:
+    case TYPE_UINT32:
+    case TYPE_UINT64:
+    case TYPE_FLOAT:
+    case TYPE_DOUBLE:
+    case TYPE_NUMERIC:
+    case TYPE_BIGNUMERIC:
+    case TYPE_STRING:
+    case TYPE_BYTES:
+    case TYPE_DATE:
+    case TYPE_TIMESTAMP:
+    case TYPE_DATETIME:
+    case TYPE_TIME:
+    case TYPE_INTERVAL:
+    case TYPE_ENUM:
+    case TYPE_ARRAY:
+    case TYPE_RANGE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool IsFiniteSum(long double value) { return std::isfinite(value); }
+bool IsFiniteSum(const zetasql_base::ExactFloat& value) {
+  return value.is_finite();
+}
+double SumToDouble(long double value) { return static_cast<double>(value); }
+double SumToDouble(const zetasql_base::ExactFloat& value) {
+  return value.ToDouble();
+}
+
+// Writes the encoding of AggregateAccumulator::SerializePartialState(): fixed
+// width little-endian integers, and length-prefixed bytes.
+class PartialStateWriter {
+ public:
+  void WriteInt64(int64_t value) {
+    char buffer[sizeof(int64_t)];
+    zetasql_base::LittleEndian::Store64(buffer, value);
+    bytes_.append(buffer, sizeof(buffer));
+  }
+
+  void WriteUint128(unsigned __int128 value) {
+    WriteInt64(static_cast<int64_t>(static_cast<uint64_t>(value)));
+    WriteInt64(static_cast<int64_t>(static_cast<uint64_t>(value >> 64)));
+  }
+
+  void WriteBytes(absl::string_view value) {
+    WriteInt64(static_cast<int64_t>(value.size()));
+    bytes_.append(value);
+  }
+
+  absl::Status WriteValue(const Value& value) {
+    ValueProto value_proto;
+    ZETASQL_RETURN_IF_ERROR(value.Serialize(&value_proto));
+    WriteBytes(value_proto.SerializeAsString());
+    return absl::OkStatus();
+  }
+
+  // Writes 'value' as the doubles whose exact sum it is, since its precision
+  // may exceed that of a double. 'T' is long double or ExactFloat.
+  template <typename T>
+  absl::Status WriteAsSumOfDoubles(T value) {
+    std::vector<double> terms;
+    if (!IsFiniteSum(value)) {
+      // Infinity or NaN.
+      terms.push_back(SumToDouble(value));
+    } else {
+      while (!(value == T(0))) {
+        const double term = SumToDouble(value);
+        if (!std::isfinite(term)) {
+          return ::zetasql_base::OutOfRangeErrorBuilder()
+                 << "Partial aggregate state overflows double";
+        }
+        terms.push_back(term);
+        value = value - T(term);
+      }
+    }
+    WriteInt64(static_cast<int64_t>(terms.size()));
+    for (double term : terms) {
+      WriteInt64(absl::bit_cast<int64_t>(term));
+    }
+    return absl::OkStatus();
+  }
+
+  std::string Release() { return std::move(bytes_); }
+
+ private:
+  std::string bytes_;
+};
+
+// Reads what PartialStateWriter wrote. The Read methods return false if the
+// bytes are truncated or malformed.
+class PartialStateReader {
+ public:
+  explicit PartialStateReader(absl::string_view bytes) : bytes_(bytes) {}
+
+  bool ReadInt64(int64_t* value) {
+    if (bytes_.size() < sizeof(int64_t)) return false;
+    *value =
+        static_cast<int64_t>(zetasql_base::LittleEndian::Load64(bytes_.data()));
+    bytes_.remove_prefix(sizeof(int64_t));
+    return true;
+  }
+
+  bool ReadUint128(unsigned __int128* value) {
+    int64_t low, high;
+    if (!ReadInt64(&low) || !ReadInt64(&high)) return false;
+    *value = (static_cast<unsigned __int128>(static_cast<uint64_t>(high))
+              << 64) |
+             static_cast<uint64_t>(low);
+    return true;
+  }
+
+  bool ReadBytes(absl::string_view* value) {
+    int64_t size;
+    if (!ReadInt64(&size) || size < 0 || size > bytes_.size()) return false;
+    *value = bytes_.substr(0, size);
+    bytes_.remove_prefix(size);
+    return true;
+  }
+
+  bool ReadValue(const Type* type, Value* value) {
+    absl::string_view bytes;
+    ValueProto value_proto;
+    if (!ReadBytes(&bytes) || !value_proto.ParseFromString(bytes)) {
+      return false;
+    }
+    absl::StatusOr<Value> deserialized = Value::Deserialize(value_proto, type);
+    if (!deserialized.ok()) return false;
+    *value = *std::move(deserialized);
+    return true;
+  }
+
+  template <typename T>
+  bool ReadSumOfDoubles(T* value) {
+    int64_t num_terms;
+    if (!ReadInt64(&num_terms) || num_terms < 0 ||
+        num_terms > bytes_.size() / sizeof(int64_t)) {
+      return false;
+    }
+    *value = T(0);
+    for (int64_t i = 0; i < num_terms; ++i) {
+      int64_t bits;
+      if (!ReadInt64(&bits)) return false;
+      *value = *value + T(absl::bit_cast<double>(bits));
+    }
+    return true;
+  }
+
+  bool done() const { return bytes_.empty(); }
+
+ private:
+  absl::string_view bytes_;
+};
+
+// Accumulator implementation for BuiltinAggregateFunction.
 class BuiltinAggregateAccumulator : public AggregateAccumulator {
  public:
   static absl::StatusOr<std::unique_ptr<BuiltinAggregateAccumulator>> Create(
@@ -5359,9 +6182,29 @@ class BuiltinAggregateAccumulator : public AggregateAccumulator {
   bool Accumulate(const Value& value, bool* stop_accumulation,
                   absl::Status* status) override;
 
+  // SUM and AVG over INT64, DOUBLE and NUMERIC accumulate batches directly,
+  // other aggregates one value at a time.
+  bool AccumulateBatch(absl::Span<const Value> values, bool* stop_accumulation,
+                       absl::Status* status) override;
+
+  bool AccumulateColumn(const TupleColumn& column, bool* stop_accumulation,
+                        absl::Status* status) override;
+
   absl::StatusOr<Value> GetFinalResult(bool inputs_in_defined_order) override;
 
+  bool SupportsMerge() const override {
+    return IsMergeableBuiltinAggregate(function_->kind(), input_type_->kind());
+  }
+
+  absl::Status Merge(AggregateAccumulator* other) override;
+
+  absl::StatusOr<std::string> SerializePartialState() override;
+
+  absl::Status MergeSerializedPartialState(absl::string_view state) override;
+
  private:
+  // The first byte of SerializePartialState().
+  static constexpr char kPartialStateVersion = 1;
 
   BuiltinAggregateAccumulator(const BuiltinAggregateFunction* function,
                               const Type* input_type,
@@ -5376,6 +6219,10 @@ class BuiltinAggregateAccumulator : public AggregateAccumulator {
 
   absl::StatusOr<Value> GetFinalResultInternal(bool inputs_in_defined_order);
 
+  // Adds 'x' to the running mean 'out_double_' of AVG over INT64, UINT64 or
+  // DOUBLE. 'count_' must already count 'x'.
+  bool AddToMean(long double x, absl::Status* status);
+
   MemoryAccountant* accountant() { return context_->memory_accountant(); }
 
   const BuiltinAggregateFunction* function_;
@@ -6189,6 +7036,131 @@ absl::Status BuiltinAggregateAccumulator::Reset() {
   return absl::OkStatus();
 }  // NOLINT(readability/fn_size)
 
+bool BuiltinAggregateAccumulator::AddToMean(long double x,
+                                            absl::Status* status) {
+  // Iterative algorithm that is less likely to overflow in the common case
+  // (lots of values of similar magnitude), and is supposedly attributed to
+  // Knuth.
+  long double delta;
+  return functions::Subtract(x, out_double_, &delta, status) &&
+         functions::Add(out_double_, delta / count_, &out_double_, status);
+}
+
+bool BuiltinAggregateAccumulator::AccumulateBatch(
+    absl::Span<const Value> values, bool* stop_accumulation,
+    absl::Status* status) {
+  *stop_accumulation = false;
+  switch (FCT(function_->kind(), input_type_->kind())) {
+    case FCT(FunctionKind::kSum, TYPE_INT64):
+      for (const Value& value : values) {
+        if (value.is_null()) {
+          has_null_ = true;
+          continue;
+        }
+        ++count_;
+        out_int128_ += value.int64_value();
+      }
+      return true;
+    case FCT(FunctionKind::kSum, TYPE_DOUBLE):
+      for (const Value& value : values) {
+        if (value.is_null()) {
+          has_null_ = true;
+          continue;
+        }
+        ++count_;
+        out_exact_float_ += value.double_value();
+      }
+      return true;
+    case FCT(FunctionKind::kSum, TYPE_NUMERIC):
+    case FCT(FunctionKind::kAvg, TYPE_NUMERIC):
+      for (const Value& value : values) {
+        if (value.is_null()) {
+          has_null_ = true;
+          continue;
+        }
+        ++count_;
+        numeric_aggregator_.Add(value.numeric_value());
+      }
+      return true;
+    case FCT(FunctionKind::kAvg, TYPE_INT64):
+    case FCT(FunctionKind::kAvg, TYPE_DOUBLE):
+      for (const Value& value : values) {
+        if (value.is_null()) {
+          has_null_ = true;
+          continue;
+        }
+        ++count_;
+        if (!AddToMean(value.ToDouble(), status)) return false;
+      }
+      return true;
+    default:
+      return AggregateAccumulator::AccumulateBatch(values, stop_accumulation,
+                                                   status);
+  }
+}
+
+bool BuiltinAggregateAccumulator::AccumulateColumn(const TupleColumn& column,
+                                                   bool* stop_accumulation,
+                                                   absl::Status* status) {
+  *stop_accumulation = false;
+  if (column.type_kind() != input_type_->kind()) {
+    return AggregateAccumulator::AccumulateColumn(column, stop_accumulation,
+                                                  status);
+  }
+  const bool has_nulls = column.HasNulls();
+  switch (FCT(function_->kind(), input_type_->kind())) {
+    case FCT(FunctionKind::kSum, TYPE_INT64): {
+      absl::Span<const int64_t> values = column.int64_values();
+      if (!has_nulls) {
+        count_ += values.size();
+        out_int128_ += columnar_kernels::SumInt64(values);
+        return true;
+      }
+      for (int i = 0; i < column.size(); ++i) {
+        if (column.IsNull(i)) {
+          has_null_ = true;
+          continue;
+        }
+        ++count_;
+        out_int128_ += values[i];
+      }
+      return true;
+    }
+    case FCT(FunctionKind::kSum, TYPE_DOUBLE): {
+      // ExactFloat makes the sum independent of the order of the values, so
+      // it is not split into vectorized partial sums.
+      absl::Span<const double> values = column.double_values();
+      for (int i = 0; i < column.size(); ++i) {
+        if (has_nulls && column.IsNull(i)) {
+          has_null_ = true;
+          continue;
+        }
+        ++count_;
+        out_exact_float_ += values[i];
+      }
+      return true;
+    }
+    case FCT(FunctionKind::kAvg, TYPE_INT64):
+    case FCT(FunctionKind::kAvg, TYPE_DOUBLE):
+      for (int i = 0; i < column.size(); ++i) {
+        if (has_nulls && column.IsNull(i)) {
+          has_null_ = true;
+          continue;
+        }
+        ++count_;
+        // Like Value::ToDouble(), which Accumulate() uses.
+        const double x = column.type_kind() == TYPE_INT64
+                             ? static_cast<double>(column.int64_values()[i])
+                             : column.double_values()[i];
+        if (!AddToMean(x, status)) return false;
+      }
+      return true;
+    default:
+      return AggregateAccumulator::AccumulateColumn(column, stop_accumulation,
+                                                    status);
+  }
+}
+
 bool BuiltinAggregateAccumulator::Accumulate(const Value& value,
                                              bool* stop_accumulation,
                                              absl::Status* status) {
@@ -6240,15 +7212,7 @@ bool BuiltinAggregateAccumulator::Accumulate(const Value& value,
     case FCT(FunctionKind::kAvg, TYPE_INT64):
     case FCT(FunctionKind::kAvg, TYPE_UINT64):
     case FCT(FunctionKind::kAvg, TYPE_DOUBLE): {
-      // Iterative algorithm that is less likely to overflow in the common
-      // case (lots of values of similar magnitude), and is supposedly
-      // attributed to Knuth.
-      long double delta;
-      if (!functions::Subtract((long double)value.ToDouble(), out_double_,
-                               &delta, status) ||
-          !functions::Add(out_double_, delta / count_, &out_double_, status)) {
-        return false;
-      }
+      if (!AddToMean(value.ToDouble(), status)) return false;
       break;
     }
     case FCT(FunctionKind::kAvg, TYPE_NUMERIC): {
@@ -6912,6 +7876,333 @@ absl::StatusOr<Value> BuiltinAggregateAccumulator::GetFinalResult(
   return result;
 }
 
+absl::Status BuiltinAggregateAccumulator::Merge(
+    AggregateAccumulator* other_accumulator) {
+  ZETASQL_RET_CHECK(SupportsMerge()) << "Merge() is not supported for "
+                             << function_->debug_name();
+  BuiltinAggregateAccumulator* other =
+      dynamic_cast<BuiltinAggregateAccumulator*>(other_accumulator);
+  ZETASQL_RET_CHECK(other != nullptr);
+  ZETASQL_RET_CHECK(other->function_->kind() == function_->kind());
+  ZETASQL_RET_CHECK(other->input_type_->Equals(input_type_));
+
+  int64_t additional_bytes_to_request = 0;
+  absl::Status status;
+  switch (function_->kind()) {
+    case FunctionKind::kAnyValue:
+      if (!any_value_.is_valid()) {
+        any_value_ = std::move(other->any_value_);
+        if (any_value_.is_valid()) {
+          additional_bytes_to_request = any_value_.physical_byte_size();
+        }
+      } else if (other->any_value_.is_valid() &&
+                 !any_value_.Equals(other->any_value_)) {
+        context_->SetNonDeterministicOutput();
+      }
+      break;
+    case FunctionKind::kArrayAgg:
+      array_agg_.reserve(array_agg_.size() + other->array_agg_.size());
+      for (Value& value : other->array_agg_) {
+        additional_bytes_to_request += value.physical_byte_size();
+        array_agg_.push_back(std::move(value));
+      }
+      other->array_agg_.clear();
+      break;
+    case FunctionKind::kCount:
+      break;
+    case FunctionKind::kCountIf:
+      countif_ += other->countif_;
+      break;
+    case FunctionKind::kStringAgg:
+      if (other->count_ > 0) {
+        if (count_ > 0) {
+          additional_bytes_to_request += delimiter_.size();
+          absl::StrAppend(&out_string_, delimiter_);
+        }
+        additional_bytes_to_request += other->out_string_.size();
+        absl::StrAppend(&out_string_, other->out_string_);
+      }
+      break;
+    case FunctionKind::kMin:
+    case FunctionKind::kMax:
+      // The minimum (maximum) of the partial minimums (maximums) is the
+      // overall one, so feed 'other's result through Accumulate(), which
+      // already knows how to compare every supported type (and collation).
+      if (other->count_ > 0) {
+        ZETASQL_ASSIGN_OR_RETURN(
+            const Value other_result,
+            other->GetFinalResultInternal(/*inputs_in_defined_order=*/false));
+        const int64_t count = count_;
+        bool stop_accumulation;
+        if (!Accumulate(other_result, &stop_accumulation, &status)) {
+          return status;
+        }
+        count_ = count;
+      }
+      break;
+    default:
+      switch (FCT(function_->kind(), input_type_->kind())) {
+        case FCT(FunctionKind::kSum, TYPE_INT64):
+          out_int128_ += other->out_int128_;
+          break;
+        case FCT(FunctionKind::kSum, TYPE_UINT64):
+          out_uint128_ += other->out_uint128_;
+          break;
+        case FCT(FunctionKind::kSum, TYPE_DOUBLE):
+          out_exact_float_ += other->out_exact_float_;
+          break;
+        case FCT(FunctionKind::kSum, TYPE_NUMERIC):
+        case FCT(FunctionKind::kAvg, TYPE_NUMERIC):
+          numeric_aggregator_.MergeWith(other->numeric_aggregator_);
+          break;
+        case FCT(FunctionKind::kSum, TYPE_BIGNUMERIC):
+        case FCT(FunctionKind::kAvg, TYPE_BIGNUMERIC):
+          bignumeric_aggregator_.MergeWith(other->bignumeric_aggregator_);
+          break;
+        case FCT(FunctionKind::kSum, TYPE_INTERVAL):
+        case FCT(FunctionKind::kAvg, TYPE_INTERVAL):
+          interval_aggregator_.MergeWith(other->interval_aggregator_);
+          break;
+        case FCT(FunctionKind::kAvg, TYPE_INT64):
+        case FCT(FunctionKind::kAvg, TYPE_UINT64):
+        case FCT(FunctionKind::kAvg, TYPE_DOUBLE): {
+          if (other->count_ == 0) break;
+          if (count_ == 0) {
+            out_double_ = other->out_double_;
+            break;
+          }
+          // Combines the two running means weighted by their counts, in the
+          // same overflow-averse form as Accumulate().
+          long double delta;
+          if (!functions::Subtract(other->out_double_, out_double_, &delta,
+                                   &status) ||
+              !functions::Add(out_double_,
+                              delta * other->count_ / (count_ + other->count_),
+                              &out_double_, &status)) {
+            return status;
+          }
+          break;
+        }
+        default:
+          ZETASQL_RET_CHECK_FAIL() << "Unexpected mergeable aggregate "
+                           << function_->debug_name();
+      }
+      break;
+  }
+  count_ += other->count_;
+  has_null_ |= other->has_null_;
+
+  if (!accountant()->RequestBytes(additional_bytes_to_request, &status)) {
+    return status;
+  }
+  requested_bytes_ += additional_bytes_to_request;
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::string>
+BuiltinAggregateAccumulator::SerializePartialState() {
+  ZETASQL_RET_CHECK(SupportsMerge())
+      << "SerializePartialState() is not supported for "
+      << function_->debug_name();
+  PartialStateWriter writer;
+  writer.WriteInt64(kPartialStateVersion);
+  writer.WriteInt64(static_cast<int64_t>(function_->kind()));
+  writer.WriteInt64(input_type_->kind());
+  writer.WriteInt64(count_);
+  writer.WriteInt64(has_null_ ? 1 : 0);
+  switch (function_->kind()) {
+    case FunctionKind::kAnyValue:
+      writer.WriteInt64(any_value_.is_valid() ? 1 : 0);
+      if (any_value_.is_valid()) {
+        ZETASQL_RETURN_IF_ERROR(writer.WriteValue(any_value_));
+      }
+      break;
+    case FunctionKind::kArrayAgg:
+      writer.WriteInt64(static_cast<int64_t>(array_agg_.size()));
+      for (const Value& value : array_agg_) {
+        ZETASQL_RETURN_IF_ERROR(writer.WriteValue(value));
+      }
+      break;
+    case FunctionKind::kCount:
+      break;
+    case FunctionKind::kCountIf:
+      writer.WriteInt64(countif_);
+      break;
+    case FunctionKind::kStringAgg:
+      writer.WriteBytes(out_string_);
+      break;
+    case FunctionKind::kMin:
+    case FunctionKind::kMax:
+      // Like Merge(), only the result is kept, and it is accumulated again on
+      // the other side.
+      if (count_ > 0) {
+        ZETASQL_ASSIGN_OR_RETURN(
+            const Value result,
+            GetFinalResultInternal(/*inputs_in_defined_order=*/false));
+        ZETASQL_RETURN_IF_ERROR(writer.WriteValue(result));
+      }
+      break;
+    default:
+      switch (FCT(function_->kind(), input_type_->kind())) {
+        case FCT(FunctionKind::kSum, TYPE_INT64):
+          writer.WriteUint128(static_cast<unsigned __int128>(out_int128_));
+          break;
+        case FCT(FunctionKind::kSum, TYPE_UINT64):
+          writer.WriteUint128(out_uint128_);
+          break;
+        case FCT(FunctionKind::kSum, TYPE_DOUBLE):
+          ZETASQL_RETURN_IF_ERROR(writer.WriteAsSumOfDoubles(out_exact_float_));
+          break;
+        case FCT(FunctionKind::kSum, TYPE_NUMERIC):
+        case FCT(FunctionKind::kAvg, TYPE_NUMERIC):
+          writer.WriteBytes(numeric_aggregator_.SerializeAsProtoBytes());
+          break;
+        case FCT(FunctionKind::kSum, TYPE_BIGNUMERIC):
+        case FCT(FunctionKind::kAvg, TYPE_BIGNUMERIC):
+          writer.WriteBytes(bignumeric_aggregator_.SerializeAsProtoBytes());
+          break;
+        case FCT(FunctionKind::kSum, TYPE_INTERVAL):
+        case FCT(FunctionKind::kAvg, TYPE_INTERVAL):
+          writer.WriteBytes(interval_aggregator_.SerializeAsProtoBytes());
+          break;
+        case FCT(FunctionKind::kAvg, TYPE_INT64):
+        case FCT(FunctionKind::kAvg, TYPE_UINT64):
+        case FCT(FunctionKind::kAvg, TYPE_DOUBLE):
+          ZETASQL_RETURN_IF_ERROR(writer.WriteAsSumOfDoubles(out_double_));
+          break;
+        default:
+          ZETASQL_RET_CHECK_FAIL() << "Unexpected mergeable aggregate "
+                           << function_->debug_name();
+      }
+      break;
+  }
+  return writer.Release();
+}
+
+absl::Status BuiltinAggregateAccumulator::MergeSerializedPartialState(
+    absl::string_view state) {
+  ZETASQL_RET_CHECK(SupportsMerge())
+      << "MergeSerializedPartialState() is not supported for "
+      << function_->debug_name();
+  const absl::Status invalid_state_error =
+      ::zetasql_base::OutOfRangeErrorBuilder()
+      << "Invalid partial aggregate state for " << function_->debug_name();
+
+  // The state is decoded into a new accumulator, which is then merged.
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<BuiltinAggregateAccumulator> other,
+                   Create(function_, input_type_, args_, CollatorList(),
+                          context_));
+  PartialStateReader reader(state);
+  int64_t version, kind, input_kind, count, has_null;
+  if (!reader.ReadInt64(&version) || version != kPartialStateVersion ||
+      !reader.ReadInt64(&kind) ||
+      kind != static_cast<int64_t>(function_->kind()) ||
+      !reader.ReadInt64(&input_kind) || input_kind != input_type_->kind() ||
+      !reader.ReadInt64(&count) || count < 0 || !reader.ReadInt64(&has_null)) {
+    return invalid_state_error;
+  }
+  other->has_null_ = has_null != 0;
+  bool ok = true;
+  switch (function_->kind()) {
+    case FunctionKind::kAnyValue: {
+      int64_t is_valid;
+      ok = reader.ReadInt64(&is_valid) &&
+           (is_valid == 0 || reader.ReadValue(input_type_, &other->any_value_));
+      break;
+    }
+    case FunctionKind::kArrayAgg: {
+      int64_t size;
+      ok = reader.ReadInt64(&size) && size >= 0;
+      for (int64_t i = 0; ok && i < size; ++i) {
+        ok = reader.ReadValue(input_type_, &other->array_agg_.emplace_back());
+      }
+      break;
+    }
+    case FunctionKind::kCount:
+      break;
+    case FunctionKind::kCountIf:
+      ok = reader.ReadInt64(&other->countif_);
+      break;
+    case FunctionKind::kStringAgg: {
+      absl::string_view out_string;
+      ok = reader.ReadBytes(&out_string);
+      other->out_string_ = std::string(out_string);
+      break;
+    }
+    case FunctionKind::kMin:
+    case FunctionKind::kMax:
+      if (count > 0) {
+        Value result;
+        if (!reader.ReadValue(function_->output_type(), &result)) {
+          return invalid_state_error;
+        }
+        bool stop_accumulation;
+        absl::Status status;
+        if (!other->Accumulate(result, &stop_accumulation, &status)) {
+          return status;
+        }
+      }
+      break;
+    default:
+      switch (FCT(function_->kind(), input_type_->kind())) {
+        case FCT(FunctionKind::kSum, TYPE_INT64): {
+          unsigned __int128 sum;
+          ok = reader.ReadUint128(&sum);
+          other->out_int128_ = static_cast<__int128>(sum);
+          break;
+        }
+        case FCT(FunctionKind::kSum, TYPE_UINT64):
+          ok = reader.ReadUint128(&other->out_uint128_);
+          break;
+        case FCT(FunctionKind::kSum, TYPE_DOUBLE):
+          ok = reader.ReadSumOfDoubles(&other->out_exact_float_);
+          break;
+        case FCT(FunctionKind::kAvg, TYPE_INT64):
+        case FCT(FunctionKind::kAvg, TYPE_UINT64):
+        case FCT(FunctionKind::kAvg, TYPE_DOUBLE):
+          ok = reader.ReadSumOfDoubles(&other->out_double_);
+          break;
+        default: {
+          absl::string_view bytes;
+          if (!reader.ReadBytes(&bytes)) return invalid_state_error;
+          switch (input_type_->kind()) {
+            case TYPE_NUMERIC: {
+              auto aggregator =
+                  NumericValue::SumAggregator::DeserializeFromProtoBytes(bytes);
+              if (!aggregator.ok()) return invalid_state_error;
+              other->numeric_aggregator_ = *aggregator;
+              break;
+            }
+            case TYPE_BIGNUMERIC: {
+              auto aggregator =
+                  BigNumericValue::SumAggregator::DeserializeFromProtoBytes(
+                      bytes);
+              if (!aggregator.ok()) return invalid_state_error;
+              other->bignumeric_aggregator_ = *aggregator;
+              break;
+            }
+            case TYPE_INTERVAL: {
+              auto aggregator =
+                  IntervalValue::SumAggregator::DeserializeFromProtoBytes(
+                      bytes);
+              if (!aggregator.ok()) return invalid_state_error;
+              other->interval_aggregator_ = *aggregator;
+              break;
+            }
+            default:
+              ZETASQL_RET_CHECK_FAIL() << "Unexpected mergeable aggregate "
+                               << function_->debug_name();
+          }
+          break;
+        }
+      }
+      break;
+  }
+  if (!ok || !reader.done()) return invalid_state_error;
+  other->count_ = count;
+  return Merge(other.get());
+}
+
 template <typename T>
 absl::StatusOr<Value> ComputePercentileCont(absl::Span<const Value> values_arg,
                                             T percentile, bool ignore_nulls) {
@@ -8087,6 +9378,14 @@ BuiltinAggregateFunction::CreateAccumulator(absl::Span<const Value> args,
                                              std::move(collator_list), context);
 }
 
+bool BuiltinAggregateFunction::SupportsMergingAccumulators() const {
+  return IsMergeableBuiltinAggregate(kind(), input_type()->kind());
+}
+
+bool BuiltinAggregateFunction::SupportsSerializingAccumulators() const {
+  return SupportsMergingAccumulators();
+}
+
 namespace {
 
 bool IsDeletableSketchInitFunction(FunctionKind kind) {
@@ -8369,6 +9668,192 @@ BinaryStatFunction::CreateAccumulator(absl::Span<const Value> args,
 
 namespace {
 
+// Accumulator implementation for HllCountFunction. HLL_COUNT.INIT adds its
+// input values to a new sketch, while HLL_COUNT.MERGE and
+// HLL_COUNT.MERGE_PARTIAL merge their input sketches.
+class HllCountAccumulator : public AggregateAccumulator {
+ public:
+  static absl::StatusOr<std::unique_ptr<HllCountAccumulator>> Create(
+      const HllCountFunction* function, absl::Span<const Value> args,
+      CollatorList collator_list, EvaluationContext* context) {
+    int64_t precision = HllSketch::kDefaultPrecision;
+    if (function->kind() == FunctionKind::kHllCountInit && !args.empty()) {
+      if (args[0].is_null()) {
+        return ::zetasql_base::OutOfRangeErrorBuilder()
+               << "Illegal NULL precision in HLL_COUNT.INIT";
+      }
+      precision = args[0].int64_value();
+      if (precision < HllSketch::kMinPrecision ||
+          precision > HllSketch::kMaxPrecision) {
+        return ::zetasql_base::OutOfRangeErrorBuilder()
+               << "HLL_COUNT.INIT precision must be between "
+               << HllSketch::kMinPrecision << " and "
+               << HllSketch::kMaxPrecision << ", but was " << precision;
+      }
+    }
+    auto accumulator = absl::WrapUnique(new HllCountAccumulator(
+        function, static_cast<int>(precision), std::move(collator_list),
+        context));
+    ZETASQL_RETURN_IF_ERROR(accumulator->Reset());
+    return accumulator;
+  }
+
+  HllCountAccumulator(const HllCountAccumulator&) = delete;
+  HllCountAccumulator& operator=(const HllCountAccumulator&) = delete;
+
+  ~HllCountAccumulator() override {
+    context_->memory_accountant()->ReturnBytes(requested_bytes_);
+  }
+
+  absl::Status Reset() final {
+    sketch_.reset();
+    return UpdateRequestedBytes();
+  }
+
+  bool Accumulate(const Value& value, bool* stop_accumulation,
+                  absl::Status* status) override {
+    *stop_accumulation = false;
+    if (value.is_null()) return true;
+    *status = AccumulateInternal(value);
+    return status->ok();
+  }
+
+  absl::StatusOr<Value> GetFinalResult(bool inputs_in_defined_order) override {
+    if (function_->kind() == FunctionKind::kHllCountMerge) {
+      return Value::Int64(sketch_.has_value() ? sketch_->Estimate() : 0);
+    }
+    if (!sketch_.has_value()) return Value::NullBytes();
+    return Value::Bytes(sketch_->Serialize());
+  }
+
+  bool SupportsMerge() const override { return true; }
+
+  absl::Status Merge(AggregateAccumulator* other_accumulator) override {
+    HllCountAccumulator* other =
+        dynamic_cast<HllCountAccumulator*>(other_accumulator);
+    ZETASQL_RET_CHECK(other != nullptr);
+    ZETASQL_RET_CHECK(other->function_->kind() == function_->kind());
+    if (!other->sketch_.has_value()) return absl::OkStatus();
+    ZETASQL_RETURN_IF_ERROR(MergeSketch(*other->sketch_));
+    return UpdateRequestedBytes();
+  }
+
+  // The state is the serialized sketch, or empty if there is none yet.
+  absl::StatusOr<std::string> SerializePartialState() override {
+    return sketch_.has_value() ? sketch_->Serialize() : std::string();
+  }
+
+  absl::Status MergeSerializedPartialState(absl::string_view state) override {
+    if (state.empty()) return absl::OkStatus();
+    absl::StatusOr<HllSketch> sketch = HllSketch::Deserialize(state);
+    if (!sketch.ok()) return InvalidSketchError();
+    ZETASQL_RETURN_IF_ERROR(MergeSketch(*sketch));
+    return UpdateRequestedBytes();
+  }
+
+ private:
+  HllCountAccumulator(const HllCountFunction* function, int precision,
+                      CollatorList collator_list, EvaluationContext* context)
+      : function_(function),
+        precision_(precision),
+        collator_list_(std::move(collator_list)),
+        context_(context) {}
+
+  absl::Status AccumulateInternal(const Value& value) {
+    if (function_->kind() == FunctionKind::kHllCountInit) {
+      if (!sketch_.has_value()) {
+        sketch_.emplace(value.type_kind(), precision_);
+      }
+      if (!collator_list_.empty() && value.type_kind() == TYPE_STRING &&
+          !collator_list_[0]->IsBinaryComparison()) {
+        // Values that are equal under the collation have the same sort key.
+        absl::Cord sort_key;
+        ZETASQL_RETURN_IF_ERROR(
+            collator_list_[0]->GetSortKeyUtf8(value.string_value(), &sort_key));
+        ZETASQL_RETURN_IF_ERROR(sketch_->Add(Value::String(std::string(sort_key))));
+      } else {
+        ZETASQL_RETURN_IF_ERROR(sketch_->Add(value));
+      }
+    } else {
+      absl::StatusOr<HllSketch> sketch =
+          HllSketch::Deserialize(value.bytes_value());
+      if (!sketch.ok()) return InvalidSketchError();
+      ZETASQL_RETURN_IF_ERROR(MergeSketch(*sketch));
+    }
+    return UpdateRequestedBytes();
+  }
+
+  absl::Status MergeSketch(const HllSketch& sketch) {
+    if (!sketch_.has_value()) {
+      sketch_ = sketch;
+      return absl::OkStatus();
+    }
+    if (!sketch_->Merge(sketch).ok()) return InvalidSketchError();
+    return absl::OkStatus();
+  }
+
+  absl::Status InvalidSketchError() const {
+    return ::zetasql_base::OutOfRangeErrorBuilder()
+           << "Invalid or incompatible sketch in "
+           << (function_->kind() == FunctionKind::kHllCountMerge
+                   ? "HLL_COUNT.MERGE"
+                   : "HLL_COUNT.MERGE_PARTIAL");
+  }
+
+  // Requests or returns bytes from the memory accountant so that
+  // 'requested_bytes_' covers the accumulator and its sketch.
+  absl::Status UpdateRequestedBytes() {
+    const int64_t bytes =
+        sizeof(*this) +
+        (sketch_.has_value() ? sketch_->GetEstimatedOwnedMemoryBytesSize() : 0);
+    if (bytes > requested_bytes_) {
+      absl::Status status;
+      if (!context_->memory_accountant()->RequestBytes(
+              bytes - requested_bytes_, &status)) {
+        return status;
+      }
+    } else {
+      context_->memory_accountant()->ReturnBytes(requested_bytes_ - bytes);
+    }
+    requested_bytes_ = bytes;
+    return absl::OkStatus();
+  }
+
+  const HllCountFunction* function_;
+  const int precision_;  // Only for HLL_COUNT.INIT.
+  const CollatorList collator_list_;
+  EvaluationContext* context_;
+
+  int64_t requested_bytes_ = 0;
+  std::optional<HllSketch> sketch_;  // Unset until there is an input.
+};
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<AggregateAccumulator>>
+HllCountFunction::CreateAccumulator(absl::Span<const Value> args,
+                                    CollatorList collator_list,
+                                    EvaluationContext* context) const {
+  return HllCountAccumulator::Create(this, args, std::move(collator_list),
+                                     context);
+}
+
+absl::StatusOr<Value> HllCountExtractFunction::Eval(
+    absl::Span<const TupleData* const> params, absl::Span<const Value> args,
+    EvaluationContext* context) const {
+  ZETASQL_RET_CHECK_EQ(args.size(), 1);
+  if (args[0].is_null()) return Value::Int64(0);
+  const absl::StatusOr<HllSketch> sketch =
+      HllSketch::Deserialize(args[0].bytes_value());
+  if (!sketch.ok()) {
+    return ::zetasql_base::OutOfRangeErrorBuilder()
+           << "Invalid sketch in HLL_COUNT.EXTRACT";
+  }
+  return Value::Int64(sketch->Estimate());
+}
+
+namespace {
+
 bool IsTrue(const Value& value) {
   return !value.is_null() && value.bool_value();
 }
@@ -8431,7 +9916,7 @@ absl::StatusOr<Value> LikeFunction::Eval(
   QuantifiedLikeEvaluationParams quantified_like_eval_params(
       /*search_value=*/args[0],
       /*pattern_elements=*/args.subspan(1),
-      /*pattern_regex=*/&regexp_,
+      /*pattern_matchers=*/matchers_,
       /*operation_type=*/QuantifiedLikeEvaluationParams::kLike,
       /*is_not=*/false);
   return EvaluateQuantifiedLike(quantified_like_eval_params);
@@ -8455,11 +9940,38 @@ absl::StatusOr<Value> LikeAnyAllFunction::Eval(
   }
 
   ZETASQL_RET_CHECK_LE(1, args.size());
-  ZETASQL_RET_CHECK_EQ(regexp_.size(), args.size() - 1);
+  if (contains_any_ != nullptr) {
+    ZETASQL_RET_CHECK_EQ(operation_type,
+                 QuantifiedLikeEvaluationParams::kLikeAny);
+    ZETASQL_RET_CHECK_EQ(matchers_.size(), other_pattern_idxs_.size());
+    const Value& search_value = args[0];
+    if (search_value.is_null()) {
+      return Value::Null(output_type());
+    }
+    // The patterns matched by 'contains_any_' are non-NULL constants, so the
+    // result is TRUE if any of them matches, regardless of the others.
+    if (contains_any_->MatchAny(search_value.type_kind() == TYPE_STRING
+                                    ? search_value.string_value()
+                                    : search_value.bytes_value())) {
+      return Value::Bool(true);
+    }
+    std::vector<Value> other_patterns;
+    other_patterns.reserve(other_pattern_idxs_.size());
+    for (int idx : other_pattern_idxs_) {
+      ZETASQL_RET_CHECK_LT(idx + 1, args.size());
+      other_patterns.push_back(args[idx + 1]);
+    }
+    QuantifiedLikeEvaluationParams quantified_like_eval_params(
+        search_value, other_patterns,
+        /*pattern_matchers=*/matchers_, operation_type, /*is_not=*/false);
+    return EvaluateQuantifiedLike(quantified_like_eval_params);
+  }
+
+  ZETASQL_RET_CHECK_EQ(matchers_.size(), args.size() - 1);
   QuantifiedLikeEvaluationParams quantified_like_eval_params(
       /*search_value=*/args[0],
       /*pattern_elements=*/args.subspan(1),
-      /*pattern_regex=*/&regexp_,
+      /*pattern_matchers=*/matchers_,
       /*operation_type=*/operation_type,
       /*is_not=*/is_not_);
   return EvaluateQuantifiedLike(quantified_like_eval_params);
@@ -8512,7 +10024,7 @@ absl::StatusOr<Value> LikeAnyAllArrayFunction::Eval(
     return EvaluateQuantifiedLike(quantified_like_eval_params);
   }
   QuantifiedLikeEvaluationParams quantified_like_eval_params(
-      *search_value, pattern_elements->elements(), &regexp_, operation_type,
+      *search_value, pattern_elements->elements(), matchers_, operation_type,
       is_not_);
   return EvaluateQuantifiedLike(quantified_like_eval_params);
 }
@@ -9061,6 +10573,49 @@ bool NetFunction::Eval(absl::Span<const TupleData* const> params,
   return false;
 }
 
+bool NetFunction::SupportsEvalColumns(
+    absl::Span<const Type* const> arg_types) const {
+  return kind() == FunctionKind::kNetParseIP && arg_types.size() == 1 &&
+         arg_types[0]->IsString();
+}
+
+bool NetFunction::EvalColumns(absl::Span<const TupleColumn* const> args,
+                              EvaluationContext* context, TupleColumn* result,
+                              absl::Status* status) const {
+  ABSL_DCHECK_EQ(1, args.size());
+  ABSL_DCHECK(kind() == FunctionKind::kNetParseIP);
+  const TupleColumn& x = *args[0];
+  result->Resize(x.size());
+  absl::Span<int64_t> out = result->mutable_int64_values();
+  if (!x.HasNulls()) {
+    if (!functions::net::ParseIPBatch(x.string_values(), out, status)) {
+      return false;
+    }
+    result->SetAllValid();
+    return true;
+  }
+
+  // The string_views of NULL rows are unspecified, so only the non-NULL rows
+  // are parsed.
+  std::vector<int> rows;
+  std::vector<absl::string_view> inputs;
+  for (int i = 0; i < x.size(); ++i) {
+    if (!x.IsNull(i)) {
+      rows.push_back(i);
+      inputs.push_back(x.string_values()[i]);
+    }
+  }
+  std::vector<int64_t> outputs(inputs.size());
+  if (!functions::net::ParseIPBatch(inputs, absl::MakeSpan(outputs), status)) {
+    return false;
+  }
+  for (int i = 0; i < rows.size(); ++i) {
+    out[rows[i]] = outputs[i];
+  }
+  result->SetValidityFrom(x);
+  return true;
+}
+
 bool StringFunction::Eval(absl::Span<const TupleData* const> params,
                           absl::Span<const Value> args,
                           EvaluationContext* context, Value* result,
@@ -9344,10 +10899,10 @@ absl::StatusOr<Value> RegexpFunction::Eval(
     absl::Span<const TupleData* const> params, absl::Span<const Value> args,
     EvaluationContext* context) const {
   if (HasNulls(args)) return Value::Null(output_type());
-  std::unique_ptr<const functions::RegExp> runtime_regexp;
+  std::shared_ptr<const functions::RegExp> runtime_regexp;
   const functions::RegExp* regexp = const_regexp_.get();
   if (regexp == nullptr) {
-    ZETASQL_ASSIGN_OR_RETURN(runtime_regexp, CreateRegexp(args[1]));
+    ZETASQL_ASSIGN_OR_RETURN(runtime_regexp, GetCachedRegexp(args[1]));
     regexp = runtime_regexp.get();
   }
   switch (FCT(kind(), args[0].type_kind())) {
@@ -9663,11 +11218,144 @@ absl::StatusOr<Value> FilterFieldsFunction::Eval(
                       mutable_root_message->SerializeAsCord());
 }
 
+// Returns true if a message of type <descriptor> may fail IsInitialized(),
+// i.e. it or any message reachable from it, including through extensions known
+// to its pool, has a required field.
+static bool MayHaveRequiredFields(
+    const google::protobuf::Descriptor* descriptor,
+    absl::flat_hash_set<const google::protobuf::Descriptor*>* visited) {
+  if (!visited->insert(descriptor).second) {
+    return false;
+  }
+  std::vector<const google::protobuf::FieldDescriptor*> fields;
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    fields.push_back(descriptor->field(i));
+  }
+  if (descriptor->extension_range_count() > 0) {
+    descriptor->file()->pool()->FindAllExtensions(descriptor, &fields);
+  }
+  for (const google::protobuf::FieldDescriptor* field : fields) {
+    if (field->is_required()) {
+      return true;
+    }
+    if (field->message_type() != nullptr &&
+        MayHaveRequiredFields(field->message_type(), visited)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns true if an occurrence of <field> with tag <tag_and_type> is parsed as
+// <field>, rather than as an unknown field.
+static bool IsParsedAsField(const google::protobuf::FieldDescriptor* field,
+                            uint32_t tag_and_type) {
+  using google::protobuf::internal::WireFormatLite;
+  const WireFormatLite::WireType wire_type =
+      WireFormatLite::GetTagWireType(tag_and_type);
+  return wire_type == WireFormatLite::WireTypeForFieldType(
+                          static_cast<WireFormatLite::FieldType>(
+                              field->type())) ||
+         (field->is_packable() &&
+          wire_type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+}
+
+// Sets the top-level <field> of <parent_proto> to <new_field_value> without
+// parsing the message: the byte ranges of all other fields are copied
+// verbatim, and the encoding of <new_field_value> is appended. A oneof member
+// replaces the other members of its oneof, as with reflection.
+static absl::StatusOr<Value> SpliceProtoField(
+    const Value& parent_proto, const google::protobuf::FieldDescriptor* field,
+    FieldFormat::Format format, const Value& new_field_value,
+    EvaluationContext* context) {
+  using google::protobuf::internal::WireFormatLite;
+  const google::protobuf::OneofDescriptor* oneof =
+      new_field_value.is_null() ? nullptr : field->real_containing_oneof();
+  const absl::Cord bytes = parent_proto.ToCord();
+  absl::Cord spliced;
+  {
+    google::protobuf::io::CordInputStream cord_stream(&bytes);
+    google::protobuf::io::CodedInputStream in(&cord_stream);
+    // The byte range [kept_begin, kept_end) is copied once it cannot be
+    // extended any more.
+    int kept_begin = 0;
+    int kept_end = 0;
+    uint32_t tag_and_type;
+    while (0 < (tag_and_type = in.ReadTag())) {
+      const int tag_number = WireFormatLite::GetTagFieldNumber(tag_and_type);
+      if (!WireFormatLite::SkipField(&in, tag_and_type)) {
+        return ::zetasql_base::OutOfRangeErrorBuilder()
+               << "Corrupted protocol buffer: Failed to skip field with tag "
+               << "number " << tag_number << " in "
+               << field->containing_type()->full_name();
+      }
+      const google::protobuf::FieldDescriptor* replaced_field = nullptr;
+      if (tag_number == field->number()) {
+        replaced_field = field;
+      } else if (oneof != nullptr) {
+        const google::protobuf::FieldDescriptor* tag_field =
+            field->containing_type()->FindFieldByNumber(tag_number);
+        if (tag_field != nullptr && tag_field->containing_oneof() == oneof) {
+          replaced_field = tag_field;
+        }
+      }
+      if (replaced_field != nullptr &&
+          IsParsedAsField(replaced_field, tag_and_type)) {
+        spliced.Append(bytes.Subcord(kept_begin, kept_end - kept_begin));
+        kept_begin = in.CurrentPosition();
+      }
+      kept_end = in.CurrentPosition();
+    }
+    spliced.Append(bytes.Subcord(kept_begin, kept_end - kept_begin));
+  }
+
+  google::protobuf::io::CordOutputStream cord_output;
+  {
+    google::protobuf::io::CodedOutputStream coded_output(&cord_output);
+    bool nondeterministic = false;
+    ZETASQL_RETURN_IF_ERROR(ProtoUtil::WriteField(ProtoUtil::WriteFieldOptions(), field,
+                                          format, new_field_value,
+                                          &nondeterministic, &coded_output));
+    if (nondeterministic) {
+      context->SetNonDeterministicOutput();
+    }
+  }
+  spliced.Append(cord_output.Consume());
+  return Value::Proto(parent_proto.type()->AsProto(), spliced);
+}
+
+// Returns the format to use with SpliceProtoField() for <path>, or nullopt if
+// <path> must be replaced with reflection. Splicing only applies to top-level
+// fields of messages that cannot be uninitialized, since REPLACE_FIELDS()
+// rejects uninitialized protos.
+static std::optional<FieldFormat::Format> GetSpliceFormat(
+    const std::vector<const google::protobuf::FieldDescriptor*>& path) {
+  if (path.size() != 1) {
+    return std::nullopt;
+  }
+  const google::protobuf::FieldDescriptor* field = path[0];
+  if (field->enum_type() != nullptr && field->enum_type()->is_closed()) {
+    // Reflection keeps unknown values of closed enums as unknown fields.
+    return std::nullopt;
+  }
+  absl::flat_hash_set<const google::protobuf::Descriptor*> visited;
+  if (MayHaveRequiredFields(field->containing_type(), &visited)) {
+    return std::nullopt;
+  }
+  const FieldFormat::Format format = ProtoType::GetFormatAnnotation(field);
+  if (!ProtoUtil::CheckIsSupportedFieldFormat(format, field).ok()) {
+    return std::nullopt;
+  }
+  return format;
+}
+
 // Sets the proto field denoted by <path> to <new_field_value>. The first proto
-// field in <path> is looked up with regards to <parent_proto>.
+// field in <path> is looked up with regards to <parent_proto>. If
+// <splice_format> is set, the field is replaced by SpliceProtoField().
 static absl::StatusOr<Value> ReplaceProtoFields(
     const Value parent_proto,
     const std::vector<const google::protobuf::FieldDescriptor*>& path,
+    std::optional<FieldFormat::Format> splice_format,
     const Value new_field_value, EvaluationContext* context) {
   // TODO: Refactor this to code to modify the serialized proto
   // instead of using reflection
@@ -9687,6 +11375,10 @@ static absl::StatusOr<Value> ReplaceProtoFields(
     return MakeEvalError() << "REPLACE_FIELDS() cannot be used to clear a "
                               "field of a map entry";
   }
+  if (splice_format.has_value()) {
+    return SpliceProtoField(parent_proto, path.back(), *splice_format,
+                            new_field_value, context);
+  }
   google::protobuf::DynamicMessageFactory factory;
   auto mutable_root_message =
       absl::WrapUnique(parent_proto.ToMessage(&factory));
@@ -9752,6 +11444,7 @@ static absl::StatusOr<Value> ReplaceProtoFields(
 static absl::StatusOr<Value> ReplaceStructFields(
     const Value parent_struct,
     const ReplaceFieldsFunction::StructAndProtoPath& path, int path_index,
+    std::optional<FieldFormat::Format> splice_format,
     const Value new_field_value, EvaluationContext* context) {
   ZETASQL_RET_CHECK(parent_struct.type()->IsStruct());
   std::vector<Value> new_struct_values = parent_struct.fields();
@@ -9761,7 +11454,7 @@ static absl::StatusOr<Value> ReplaceStructFields(
         new_field,
         ReplaceStructFields(
             parent_struct.fields()[path.struct_index_path[path_index]], path,
-            path_index + 1, new_field_value, context));
+            path_index + 1, splice_format, new_field_value, context));
   } else if (!path.field_descriptor_path.empty()) {
     // We have found the last Struct field in <path>. If <path> then traverses
     // into a nested proto, write <new_field_value> to the final proto field.
@@ -9771,12 +11464,25 @@ static absl::StatusOr<Value> ReplaceStructFields(
     ZETASQL_ASSIGN_OR_RETURN(new_field,
                      ReplaceProtoFields(
                          parent_struct.fields()[path.struct_index_path.back()],
-                         path.field_descriptor_path, new_field_value, context));
+                         path.field_descriptor_path, splice_format,
+                         new_field_value, context));
   }
   new_struct_values[path.struct_index_path[path_index]] = new_field;
   return Value::Struct(parent_struct.type()->AsStruct(), new_struct_values);
 }
 
+ReplaceFieldsFunction::ReplaceFieldsFunction(
+    const Type* output_type, const std::vector<StructAndProtoPath>& field_paths)
+    : SimpleBuiltinScalarFunction(FunctionKind::kReplaceFields, output_type),
+      field_paths_(field_paths) {
+  for (const StructAndProtoPath& path : field_paths_) {
+    splice_formats_.push_back(
+        path.field_descriptor_path.empty()
+            ? std::nullopt
+            : GetSpliceFormat(path.field_descriptor_path));
+  }
+}
+
 absl::StatusOr<Value> ReplaceFieldsFunction::Eval(
     absl::Span<const TupleData* const> params, absl::Span<const Value> args,
     EvaluationContext* context) const {
@@ -9788,13 +11494,14 @@ absl::StatusOr<Value> ReplaceFieldsFunction::Eval(
   for (int i = 0; i < field_paths_.size(); ++i) {
     if (output_type()->IsStruct()) {
       ZETASQL_ASSIGN_OR_RETURN(
-          output, ReplaceStructFields(output, field_paths_[i],
-                                      /*path_index=*/0, args[i + 1], context));
+          output,
+          ReplaceStructFields(output, field_paths_[i], /*path_index=*/0,
+                              splice_formats_[i], args[i + 1], context));
     } else {
       ZETASQL_ASSIGN_OR_RETURN(
           output,
           ReplaceProtoFields(output, field_paths_[i].field_descriptor_path,
-                             args[i + 1], context));
+                             splice_formats_[i], args[i + 1], context));
     }
   }
   return output;
@@ -9886,6 +11593,30 @@ absl::StatusOr<Value> FormatDateDatetimeTimestampFunction::Eval(
   ABSL_DCHECK_LE(args.size(), 3);
   if (HasNulls(args)) return Value::Null(output_type());
   std::string result_string;
+  if (format_plan_ != nullptr) {
+    bool formatted = false;
+    switch (args[1].type_kind()) {
+      case TYPE_DATE:
+        formatted =
+            format_plan_->FormatDate(args[1].date_value(), &result_string);
+        break;
+      case TYPE_DATETIME:
+        formatted = format_plan_->FormatDatetime(args[1].datetime_value(),
+                                                 &result_string);
+        break;
+      case TYPE_TIMESTAMP:
+        // The plan has no subsecond elements, so the precision of the
+        // timestamp does not matter.
+        if (args.size() == 2) {
+          formatted = format_plan_->FormatTimestamp(
+              args[1].ToTime(), context->GetDefaultTimeZone(), &result_string);
+        }
+        break;
+      default:
+        break;
+    }
+    if (formatted) return Value::String(std::move(result_string));
+  }
   switch (args[1].type_kind()) {
     case TYPE_DATE:
       ZETASQL_RETURN_IF_ERROR(functions::FormatDateToString(
@@ -10306,6 +12037,15 @@ absl::StatusOr<Value> ParseTimestampFunction::Eval(
     EvaluationContext* context) const {
   ZETASQL_RET_CHECK(args.size() == 2 || args.size() == 3);
   if (HasNulls(args)) return Value::Null(output_type());
+  if (parse_plan_ != nullptr && args.size() == 2) {
+    // The plan has no subsecond elements, so the result has the precision of
+    // both modes.
+    absl::Time timestamp;
+    if (parse_plan_->Parse(args[1].string_value(),
+                           context->GetDefaultTimeZone(), &timestamp)) {
+      return Value::Timestamp(timestamp);
+    }
+  }
   if (context->GetLanguageOptions().LanguageFeatureEnabled(
           FEATURE_TIMESTAMP_NANOS)) {
     absl::Time timestamp;
@@ -10353,16 +12093,14 @@ absl::StatusOr<Value> DateTimeTruncFunction::Eval(
       return values::Date(date);
     }
     case TYPE_TIMESTAMP: {
-      int64_t int64_timestamp;
-      if (args.size() == 2) {
-        ZETASQL_RETURN_IF_ERROR(functions::TimestampTrunc(args[0].ToUnixMicros(),
-                                                  context->GetDefaultTimeZone(),
-                                                  part, &int64_timestamp));
-      } else {
-        ZETASQL_RETURN_IF_ERROR(functions::TimestampTrunc(args[0].ToUnixMicros(),
-                                                  args[2].string_value(), part,
-                                                  &int64_timestamp));
+      absl::TimeZone timezone = context->GetDefaultTimeZone();
+      if (args.size() == 3) {
+        ZETASQL_RETURN_IF_ERROR(
+            functions::MakeTimeZone(args[2].string_value(), &timezone));
       }
+      ZETASQL_ASSIGN_OR_RETURN(
+          int64_t int64_timestamp,
+          TruncateTimestamp(args[0].ToUnixMicros(), timezone, part));
       return Value::TimestampFromUnixMicros(int64_timestamp);
     }
     case TYPE_DATETIME: {
@@ -10384,6 +12122,50 @@ absl::StatusOr<Value> DateTimeTruncFunction::Eval(
   }
 }
 
+absl::StatusOr<int64_t> DateTimeTruncFunction::TruncateTimestamp(
+    int64_t timestamp, absl::TimeZone timezone,
+    functions::DateTimestampPart part) const {
+  int64_t truncated;
+  if (part != functions::DAY && part != functions::HOUR) {
+    ZETASQL_RETURN_IF_ERROR(
+        functions::TimestampTrunc(timestamp, timezone, part, &truncated));
+    return truncated;
+  }
+  {
+    absl::MutexLock lock(&mutex_);
+    if (last_interval_.part == part && last_interval_.timezone == timezone &&
+        timestamp >= last_interval_.begin && timestamp < last_interval_.end) {
+      return last_interval_.truncated;
+    }
+  }
+  ZETASQL_RETURN_IF_ERROR(
+      functions::TimestampTrunc(timestamp, timezone, part, &truncated));
+
+  // As long as the UTC offset does not change, civil time advances with the
+  // timestamp, so everything up to the next civil day or hour truncates the
+  // same way.
+  const absl::Time time = absl::FromUnixMicros(timestamp);
+  const int64_t offset = timezone.At(time).offset;
+  const int64_t unit_seconds = part == functions::DAY ? 24 * 60 * 60 : 60 * 60;
+  const int64_t civil_seconds = absl::ToUnixSeconds(time) + offset;
+  int64_t remainder = civil_seconds % unit_seconds;
+  if (remainder < 0) remainder += unit_seconds;
+  absl::Time end =
+      absl::FromUnixSeconds(civil_seconds - remainder + unit_seconds - offset);
+  absl::TimeZone::CivilTransition transition;
+  if (timezone.NextTransition(time, &transition)) {
+    end = std::min(end, timezone.At(transition.to).trans);
+  }
+
+  absl::MutexLock lock(&mutex_);
+  last_interval_.timezone = timezone;
+  last_interval_.part = part;
+  last_interval_.begin = timestamp;
+  last_interval_.end = absl::ToUnixMicros(end);
+  last_interval_.truncated = truncated;
+  return truncated;
+}
+
 absl::StatusOr<Value> LastDayFunction::Eval(
     absl::Span<const TupleData* const> params, absl::Span<const Value> args,
     EvaluationContext* context) const {
@@ -10989,11 +12771,10 @@ absl::StatusOr<Value> ExtractOneofCaseFunction::Eval(
     return Value::NullString();
   }
 
-  google::protobuf::DynamicMessageFactory factory;
-  auto root_message = absl::WrapUnique(args[0].ToMessage(&factory));
-  const google::protobuf::Reflection* reflection = root_message->GetReflection();
-  const google::protobuf::FieldDescriptor* set_oneof_field =
-      reflection->GetOneofFieldDescriptor(*root_message, oneof_desc_);
+  // Scans the wire format for the oneof's member tags instead of parsing the
+  // whole message.
+  ZETASQL_ASSIGN_OR_RETURN(const google::protobuf::FieldDescriptor* set_oneof_field,
+                   ReadSetOneofField(oneof_desc_, args[0].ToCord()));
   if (set_oneof_field == nullptr) {
     return Value::String("");
   }
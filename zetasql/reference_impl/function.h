@@ -32,13 +32,17 @@
 #include "zetasql/public/function_signature.h"
 #include "zetasql/public/functions/array_zip_mode.pb.h"
 #include "zetasql/public/functions/date_time_util.h"
+#include "zetasql/public/functions/like.h"
+#include "zetasql/public/functions/parse_date_time.h"
 #include "zetasql/public/functions/regexp.h"
+#include "zetasql/public/functions/string_format.h"
 #include "zetasql/public/language_options.h"
 #include "zetasql/public/proto/type_annotation.pb.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/types/type.h"
 #include "zetasql/public/types/type_factory.h"
 #include "zetasql/public/value.h"
+#include "zetasql/reference_impl/columnar_batch.h"
 #include "zetasql/reference_impl/common.h"
 #include "zetasql/reference_impl/evaluation.h"
 #include "zetasql/reference_impl/operator.h"
@@ -46,10 +50,12 @@
 #include "zetasql/reference_impl/tuple_comparator.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
 #include "zetasql/base/check.h"
+#include "absl/base/thread_annotations.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "re2/re2.h"
 #include "zetasql/base/status.h"
@@ -111,6 +117,9 @@ enum class FunctionKind {
   kVarSamp,
   kElementwiseSum,
   kElementwiseAvg,
+  kHllCountInit,
+  kHllCountMerge,
+  kHllCountMergePartial,
   // Anonymization functions (broken link)
   kAnonSum,
   kAnonSumWithReportProto,
@@ -452,6 +461,8 @@ enum class FunctionKind {
   kNetIPTrunc,
   kNetIPv4FromInt64,
   kNetIPv4ToInt64,
+  // HLL_COUNT scalar functions
+  kHllCountExtract,
   // Numbering functions
   kDenseRank,
   kRank,
@@ -546,6 +557,21 @@ class BuiltinScalarFunction : public ScalarFunctionBody {
   // Returns true if any of the input values is null.
   static bool HasNulls(absl::Span<const Value> args);
 
+  // Returns true if EvalColumns() supports arguments of types 'arg_types'.
+  virtual bool SupportsEvalColumns(
+      absl::Span<const Type* const> arg_types) const {
+    return false;
+  }
+
+  // Columnar form of Eval(). Evaluates the function on each row of 'args',
+  // which all have the same size, and stores the results in 'result', which
+  // has type output_type(). Must only be called if SupportsEvalColumns()
+  // returns true for the types of 'args'. On failure, populates 'status' and
+  // returns false, in which case 'result' is unspecified.
+  virtual bool EvalColumns(absl::Span<const TupleColumn* const> args,
+                           EvaluationContext* context, TupleColumn* result,
+                           absl::Status* status) const;
+
   // Validates the input types according to the language options, and returns a
   // ScalarFunctionCallExpr upon success.
   //
@@ -662,6 +688,14 @@ class BuiltinAggregateFunction : public AggregateFunctionBody {
       absl::Span<const Value> args, CollatorList collator_list,
       EvaluationContext* context) const override;
 
+  // True for COUNT, COUNTIF, SUM, AVG, MIN, MAX, ANY_VALUE, ARRAY_AGG and
+  // STRING_AGG over the input types they accumulate natively.
+  bool SupportsMergingAccumulators() const override;
+
+  // Same as SupportsMergingAccumulators(): every mergeable accumulator can
+  // serialize what Merge() combines.
+  bool SupportsSerializingAccumulators() const override;
+
  private:
   const FunctionKind kind_;
 };
@@ -679,6 +713,27 @@ class BinaryStatFunction : public BuiltinAggregateFunction {
   absl::StatusOr<std::unique_ptr<AggregateAccumulator>> CreateAccumulator(
       absl::Span<const Value> args, CollatorList collator_list,
       EvaluationContext* context) const override;
+
+  bool SupportsMergingAccumulators() const override { return false; }
+};
+
+// Implements HLL_COUNT.INIT, HLL_COUNT.MERGE and HLL_COUNT.MERGE_PARTIAL with
+// the sketches of hll_sketch.h.
+class HllCountFunction : public BuiltinAggregateFunction {
+ public:
+  HllCountFunction(FunctionKind kind, const Type* output_type,
+                   const Type* input_type)
+      : BuiltinAggregateFunction(kind, output_type, /*num_input_fields=*/1,
+                                 input_type, /*ignores_null=*/true) {}
+
+  HllCountFunction(const HllCountFunction&) = delete;
+  HllCountFunction& operator=(const HllCountFunction&) = delete;
+
+  absl::StatusOr<std::unique_ptr<AggregateAccumulator>> CreateAccumulator(
+      absl::Span<const Value> args, CollatorList collator_list,
+      EvaluationContext* context) const override;
+
+  bool SupportsMergingAccumulators() const override { return true; }
 };
 
 using ContextAwareFunctionEvaluator = std::function<absl::StatusOr<Value>(
@@ -758,6 +813,11 @@ class ArithmeticFunction : public BuiltinScalarFunction {
   bool Eval(absl::Span<const TupleData* const> params,
             absl::Span<const Value> args, EvaluationContext* context,
             Value* result, absl::Status* status) const override;
+  bool SupportsEvalColumns(
+      absl::Span<const Type* const> arg_types) const override;
+  bool EvalColumns(absl::Span<const TupleColumn* const> args,
+                   EvaluationContext* context, TupleColumn* result,
+                   absl::Status* status) const override;
 
  private:
   // Helper function to add/subtract INTERVAL.
@@ -772,6 +832,11 @@ class ComparisonFunction : public BuiltinScalarFunction {
   bool Eval(absl::Span<const TupleData* const> params,
             absl::Span<const Value> args, EvaluationContext* context,
             Value* result, absl::Status* status) const override;
+  bool SupportsEvalColumns(
+      absl::Span<const Type* const> arg_types) const override;
+  bool EvalColumns(absl::Span<const TupleColumn* const> args,
+                   EvaluationContext* context, TupleColumn* result,
+                   absl::Status* status) const override;
 };
 
 class LogicalFunction : public BuiltinScalarFunction {
@@ -780,6 +845,11 @@ class LogicalFunction : public BuiltinScalarFunction {
   bool Eval(absl::Span<const TupleData* const> params,
             absl::Span<const Value> args, EvaluationContext* context,
             Value* result, absl::Status* status) const override;
+  bool SupportsEvalColumns(
+      absl::Span<const Type* const> arg_types) const override;
+  bool EvalColumns(absl::Span<const TupleColumn* const> args,
+                   EvaluationContext* context, TupleColumn* result,
+                   absl::Status* status) const override;
 };
 
 class ExistsFunction : public BuiltinScalarFunction {
@@ -803,17 +873,25 @@ class ArrayLengthFunction : public BuiltinScalarFunction {
 class LambdaEvaluationContext {
  public:
   LambdaEvaluationContext(absl::Span<const TupleData* const> params,
-                          EvaluationContext* context)
-      : params_(params), context_(context) {}
+                          EvaluationContext* context);
+
+  LambdaEvaluationContext(const LambdaEvaluationContext&) = delete;
+  LambdaEvaluationContext& operator=(const LambdaEvaluationContext&) = delete;
 
  public:
+  // Evaluates `lambda` with `args` as argument values. The arguments are
+  // stored in the same TupleData on every call, so evaluating a lambda for
+  // each element of an array does not allocate per element.
   absl::StatusOr<Value> EvaluateLambda(const InlineLambdaExpr* lambda,
                                        absl::Span<const Value> args);
 
  private:
-  // Params to be passed to lambda. Used when a lambda needs to fetch a value
-  // outside of its argument list, for example, a query parameter.
-  absl::Span<const TupleData* const> params_;
+  // Params to be passed to lambda, followed by `args_data_`. The params are
+  // used when a lambda needs to fetch a value outside of its argument list,
+  // for example, a query parameter.
+  std::vector<const TupleData*> params_and_args_;
+  // The argument values of the current call to EvaluateLambda().
+  TupleData args_data_;
   EvaluationContext* context_;
   std::shared_ptr<TupleSlot::SharedProtoState> shared_proto_state_;
 };
@@ -1012,6 +1090,11 @@ class IsFunction : public BuiltinScalarFunction {
   bool Eval(absl::Span<const TupleData* const> params,
             absl::Span<const Value> args, EvaluationContext* context,
             Value* result, absl::Status* status) const override;
+  bool SupportsEvalColumns(
+      absl::Span<const Type* const> arg_types) const override;
+  bool EvalColumns(absl::Span<const TupleColumn* const> args,
+                   EvaluationContext* context, TupleColumn* result,
+                   absl::Status* status) const override;
 };
 
 class CastFunction : public SimpleBuiltinScalarFunction {
@@ -1046,9 +1129,9 @@ class BitCastFunction : public BuiltinScalarFunction {
 class LikeFunction : public SimpleBuiltinScalarFunction {
  public:
   LikeFunction(FunctionKind kind, const Type* output_type,
-               std::unique_ptr<RE2> regexp)
+               std::unique_ptr<const functions::LikeMatcher> matcher)
       : SimpleBuiltinScalarFunction(kind, output_type) {
-    regexp_.push_back(std::move(regexp));
+    matchers_.push_back(std::move(matcher));
     has_collation_ = kind == FunctionKind::kLikeWithCollation;
   }
   absl::StatusOr<Value> Eval(absl::Span<const TupleData* const> params,
@@ -1059,8 +1142,8 @@ class LikeFunction : public SimpleBuiltinScalarFunction {
   LikeFunction& operator=(const LikeFunction&) = delete;
 
  private:
-  // Regexp precompiled at prepare time; null if cannot be precompiled.
-  std::vector<std::unique_ptr<RE2>> regexp_;
+  // Pattern precompiled at prepare time; null if cannot be precompiled.
+  std::vector<std::unique_ptr<const functions::LikeMatcher>> matchers_;
   bool has_collation_;
 };
 
@@ -1068,10 +1151,20 @@ class LikeFunction : public SimpleBuiltinScalarFunction {
 //   <expr> [NOT] LIKE ANY|ALL (pattern1, pattern2, ...)
 class LikeAnyAllFunction : public SimpleBuiltinScalarFunction {
  public:
-  LikeAnyAllFunction(FunctionKind kind, const Type* output_type,
-                     std::vector<std::unique_ptr<RE2>> regexp)
+  // 'matchers[i]' is the matcher precompiled for the i-th pattern, or NULL if
+  // it cannot be precompiled. If 'contains_any' is not NULL, 'kind' must be
+  // kLikeAny, 'contains_any' matches all the patterns except the ones at
+  // 'other_pattern_idxs', and 'matchers' only has the matchers for those.
+  LikeAnyAllFunction(
+      FunctionKind kind, const Type* output_type,
+      std::vector<std::unique_ptr<const functions::LikeMatcher>> matchers,
+      std::unique_ptr<const functions::LikeContainsAnyMatcher> contains_any =
+          nullptr,
+      std::vector<int> other_pattern_idxs = {})
       : SimpleBuiltinScalarFunction(kind, output_type),
-        regexp_(std::move(regexp)) {
+        matchers_(std::move(matchers)),
+        contains_any_(std::move(contains_any)),
+        other_pattern_idxs_(std::move(other_pattern_idxs)) {
     ABSL_CHECK(kind == FunctionKind::kLikeAny || kind == FunctionKind::kNotLikeAny ||
           kind == FunctionKind::kLikeAnyWithCollation ||
           kind == FunctionKind::kNotLikeAnyWithCollation ||
@@ -1096,7 +1189,11 @@ class LikeAnyAllFunction : public SimpleBuiltinScalarFunction {
   LikeAnyAllFunction& operator=(const LikeAnyAllFunction&) = delete;
 
  private:
-  std::vector<std::unique_ptr<RE2>> regexp_;
+  std::vector<std::unique_ptr<const functions::LikeMatcher>> matchers_;
+  // Matches the '%<literal>%' patterns of a LIKE ANY with many of them at
+  // once.
+  std::unique_ptr<const functions::LikeContainsAnyMatcher> contains_any_;
+  std::vector<int> other_pattern_idxs_;
   bool has_collation_;
   bool is_not_;
 };
@@ -1105,10 +1202,11 @@ class LikeAnyAllFunction : public SimpleBuiltinScalarFunction {
 //   <expr> [NOT] LIKE ANY|ALL UNNEST(<array-expression>)
 class LikeAnyAllArrayFunction : public SimpleBuiltinScalarFunction {
  public:
-  LikeAnyAllArrayFunction(FunctionKind kind, const Type* output_type,
-                          std::vector<std::unique_ptr<RE2>> regexp)
+  LikeAnyAllArrayFunction(
+      FunctionKind kind, const Type* output_type,
+      std::vector<std::unique_ptr<const functions::LikeMatcher>> matchers)
       : SimpleBuiltinScalarFunction(kind, output_type),
-        regexp_(std::move(regexp)) {
+        matchers_(std::move(matchers)) {
     ABSL_CHECK(kind == FunctionKind::kLikeAnyArray ||
           kind == FunctionKind::kLikeAnyArrayWithCollation ||
           kind == FunctionKind::kNotLikeAnyArray ||
@@ -1135,7 +1233,7 @@ class LikeAnyAllArrayFunction : public SimpleBuiltinScalarFunction {
   LikeAnyAllArrayFunction& operator=(const LikeAnyAllArrayFunction&) = delete;
 
  private:
-  std::vector<std::unique_ptr<RE2>> regexp_;
+  std::vector<std::unique_ptr<const functions::LikeMatcher>> matchers_;
   bool is_not_;
   bool has_collation_;
 };
@@ -1221,8 +1319,25 @@ class CodePointsToFunction : public SimpleBuiltinScalarFunction {
 
 class FormatFunction : public SimpleBuiltinScalarFunction {
  public:
-  explicit FormatFunction(const Type* output_type)
-      : SimpleBuiltinScalarFunction(FunctionKind::kFormat, output_type) {}
+  // 'format_plan' is optional. If it is set, it is used to format every row
+  // instead of parsing the format string again, which must then be constant.
+  FormatFunction(const Type* output_type,
+                 std::unique_ptr<const functions::StringFormatPlan> format_plan)
+      : SimpleBuiltinScalarFunction(FunctionKind::kFormat, output_type),
+        format_plan_(std::move(format_plan)) {}
+  absl::StatusOr<Value> Eval(absl::Span<const TupleData* const> params,
+                             absl::Span<const Value> args,
+                             EvaluationContext* context) const override;
+
+ private:
+  const std::unique_ptr<const functions::StringFormatPlan> format_plan_;
+};
+
+class HllCountExtractFunction : public SimpleBuiltinScalarFunction {
+ public:
+  explicit HllCountExtractFunction(const Type* output_type)
+      : SimpleBuiltinScalarFunction(FunctionKind::kHllCountExtract,
+                                    output_type) {}
   absl::StatusOr<Value> Eval(absl::Span<const TupleData* const> params,
                              absl::Span<const Value> args,
                              EvaluationContext* context) const override;
@@ -1262,6 +1377,12 @@ class NetFunction : public BuiltinScalarFunction {
   bool Eval(absl::Span<const TupleData* const> params,
             absl::Span<const Value> args, EvaluationContext* context,
             Value* result, absl::Status* status) const override;
+  // Only NET.PARSE_IP() is supported.
+  bool SupportsEvalColumns(
+      absl::Span<const Type* const> arg_types) const override;
+  bool EvalColumns(absl::Span<const TupleColumn* const> args,
+                   EvaluationContext* context, TupleColumn* result,
+                   absl::Status* status) const override;
 };
 
 class StringFunction : public BuiltinScalarFunction {
@@ -1428,9 +1549,7 @@ class ReplaceFieldsFunction : public SimpleBuiltinScalarFunction {
   };
 
   ReplaceFieldsFunction(const Type* output_type,
-                        const std::vector<StructAndProtoPath>& field_paths)
-      : SimpleBuiltinScalarFunction(FunctionKind::kReplaceFields, output_type),
-        field_paths_(field_paths) {}
+                        const std::vector<StructAndProtoPath>& field_paths);
 
   absl::StatusOr<Value> Eval(absl::Span<const TupleData* const> params,
                              absl::Span<const Value> args,
@@ -1438,6 +1557,10 @@ class ReplaceFieldsFunction : public SimpleBuiltinScalarFunction {
 
  private:
   const std::vector<StructAndProtoPath> field_paths_;
+  // For each entry of 'field_paths_', the format with which the proto field is
+  // encoded when it can be spliced into the serialized proto instead of being
+  // set with reflection, or nullopt.
+  std::vector<std::optional<FieldFormat::Format>> splice_formats_;
 };
 
 class NullaryFunction : public SimpleBuiltinScalarFunction {
@@ -1458,10 +1581,20 @@ class DateTimeUnaryFunction : public SimpleBuiltinScalarFunction {
 
 class FormatDateDatetimeTimestampFunction : public SimpleBuiltinScalarFunction {
  public:
-  using SimpleBuiltinScalarFunction::SimpleBuiltinScalarFunction;
+  // 'format_plan' is compiled from a constant format string at prepare time;
+  // null if the format is not constant or cannot be compiled.
+  FormatDateDatetimeTimestampFunction(
+      FunctionKind kind, const Type* output_type,
+      std::unique_ptr<const functions::DateTimeFormatPlan> format_plan)
+      : SimpleBuiltinScalarFunction(kind, output_type),
+        format_plan_(std::move(format_plan)) {}
+
   absl::StatusOr<Value> Eval(absl::Span<const TupleData* const> params,
                              absl::Span<const Value> args,
                              EvaluationContext* context) const override;
+
+ private:
+  const std::unique_ptr<const functions::DateTimeFormatPlan> format_plan_;
 };
 
 class FormatTimeFunction : public SimpleBuiltinScalarFunction {
@@ -1546,10 +1679,20 @@ class ParseTimeFunction : public SimpleBuiltinScalarFunction {
 
 class ParseTimestampFunction : public SimpleBuiltinScalarFunction {
  public:
-  using SimpleBuiltinScalarFunction::SimpleBuiltinScalarFunction;
+  // 'parse_plan' is compiled from a constant format string at prepare time;
+  // null if the format is not constant or cannot be compiled.
+  ParseTimestampFunction(
+      FunctionKind kind, const Type* output_type,
+      std::unique_ptr<const functions::TimestampParsePlan> parse_plan)
+      : SimpleBuiltinScalarFunction(kind, output_type),
+        parse_plan_(std::move(parse_plan)) {}
+
   absl::StatusOr<Value> Eval(absl::Span<const TupleData* const> params,
                              absl::Span<const Value> args,
                              EvaluationContext* context) const override;
+
+ private:
+  const std::unique_ptr<const functions::TimestampParsePlan> parse_plan_;
 };
 
 class DateTimeDiffFunction : public SimpleBuiltinScalarFunction {
@@ -1566,6 +1709,28 @@ class DateTimeTruncFunction : public SimpleBuiltinScalarFunction {
   absl::StatusOr<Value> Eval(absl::Span<const TupleData* const> params,
                              absl::Span<const Value> args,
                              EvaluationContext* context) const override;
+
+ private:
+  // The TIMESTAMPs in [begin, end), in microseconds, which all truncate to
+  // <truncated> for <part> in <timezone>.
+  struct TruncatedInterval {
+    absl::TimeZone timezone;
+    functions::DateTimestampPart part = functions::DAY;
+    int64_t begin = 0;
+    int64_t end = 0;
+    int64_t truncated = 0;
+  };
+
+  // Like functions::TimestampTrunc(). Rows of daily or hourly rollups are
+  // usually clustered in time, so the interval around the last DAY or HOUR
+  // truncation is kept to answer the following rows without converting them
+  // to civil time.
+  absl::StatusOr<int64_t> TruncateTimestamp(
+      int64_t timestamp, absl::TimeZone timezone,
+      functions::DateTimestampPart part) const;
+
+  mutable absl::Mutex mutex_;
+  mutable TruncatedInterval last_interval_ ABSL_GUARDED_BY(mutex_);
 };
 
 class LastDayFunction : public SimpleBuiltinScalarFunction {
@@ -0,0 +1,295 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Measures the per-row cost of hot scalar functions called through
+// BuiltinScalarFunction::Eval(), as the reference implementation evaluates
+// them, including the Value wrapping and dispatch around the kernels that
+// public/functions/functions_benchmark.cc measures directly. Arguments that
+// are constant in typical queries, like LIKE patterns and PARSE_TIMESTAMP
+// formats, are constants when the function is created, so that functions that
+// precompile them do so. Each benchmark cycles through a fixed set of
+// pseudo-random rows and reports items_per_second as the number of rows
+// processed.
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/cast.h"
+#include "zetasql/public/language_options.h"
+#include "zetasql/public/numeric_value.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/reference_impl/evaluation.h"
+#include "zetasql/reference_impl/function.h"
+#include "zetasql/reference_impl/operator.h"
+#include "benchmark/benchmark.h"
+#include "zetasql/base/check.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+namespace {
+
+// The number of distinct rows each benchmark cycles through.
+constexpr int kNumRows = 1024;
+
+LanguageOptions MaximumLanguageOptions() {
+  LanguageOptions options;
+  options.EnableMaximumLanguageFeatures();
+  return options;
+}
+
+// Evaluates the function 'kind' on each of 'rows' in turn. The function is
+// created with the values of the first row as constant arguments.
+void RunFunction(benchmark::State& state, FunctionKind kind,
+                 const Type* output_type,
+                 const std::vector<std::vector<Value>>& rows) {
+  std::vector<std::unique_ptr<AlgebraArg>> arguments;
+  for (const Value& value : rows[0]) {
+    auto expr = ConstExpr::Create(value);
+    ZETASQL_CHECK_OK(expr.status());
+    arguments.push_back(std::make_unique<ExprArg>(*std::move(expr)));
+  }
+  const LanguageOptions language_options = MaximumLanguageOptions();
+  auto function = BuiltinScalarFunction::CreateValidated(
+      kind, language_options, output_type, arguments);
+  ZETASQL_CHECK_OK(function.status());
+
+  EvaluationContext context{/*options=*/{}};
+  context.SetLanguageOptions(language_options);
+  context.SetDefaultTimeZone(absl::UTCTimeZone());
+  int i = 0;
+  for (auto s : state) {
+    Value result;
+    absl::Status status;
+    benchmark::DoNotOptimize((*function)->Eval(
+        /*params=*/{}, rows[i++ % kNumRows], &context, &result, &status));
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Returns strings with lengths uniformly distributed in [min_length,
+// max_length] characters. If 'unicode' is true, about a quarter of the
+// characters are two or three byte UTF-8 sequences.
+std::vector<std::string> MakeStrings(int min_length, int max_length,
+                                     bool unicode) {
+  static constexpr const char* kNonAscii[] = {"é", "ß", "Ж", "中"};
+  std::mt19937 random(min_length * 31 + max_length);
+  std::vector<std::string> strings;
+  for (int i = 0; i < kNumRows; ++i) {
+    const int length =
+        min_length + static_cast<int>(random() % (max_length - min_length + 1));
+    std::string str;
+    for (int j = 0; j < length; ++j) {
+      if (unicode && random() % 4 == 0) {
+        str.append(kNonAscii[random() % 4]);
+      } else {
+        str.push_back(static_cast<char>('A' + random() % 52));
+      }
+    }
+    strings.push_back(std::move(str));
+  }
+  return strings;
+}
+
+// Strings of words separated by spaces, some of which contain "abc".
+std::vector<std::string> MakeText() {
+  std::mt19937 random(kNumRows);
+  std::vector<std::string> strings;
+  for (int i = 0; i < kNumRows; ++i) {
+    std::string str;
+    const int num_words = 1 + random() % 10;
+    for (int j = 0; j < num_words; ++j) {
+      if (j > 0) str.push_back(' ');
+      const int word = random() % 100;
+      absl::StrAppend(&str, word < 10 ? "abc" : "word", word);
+    }
+    strings.push_back(std::move(str));
+  }
+  return strings;
+}
+
+// Rows of STRING values from 'strings', followed by 'constants'.
+std::vector<std::vector<Value>> MakeStringRows(
+    const std::vector<std::string>& strings,
+    const std::vector<Value>& constants) {
+  std::vector<std::vector<Value>> rows;
+  for (const std::string& str : strings) {
+    std::vector<Value> row = {values::String(str)};
+    row.insert(row.end(), constants.begin(), constants.end());
+    rows.push_back(std::move(row));
+  }
+  return rows;
+}
+
+void BM_Substr(benchmark::State& state) {
+  RunFunction(state, FunctionKind::kSubstr, types::StringType(),
+              MakeStringRows(MakeStrings(0, 64, state.range(0) != 0),
+                             {values::Int64(3), values::Int64(10)}));
+}
+BENCHMARK(BM_Substr)->ArgName("unicode")->Arg(0)->Arg(1);
+
+void BM_Lower(benchmark::State& state) {
+  RunFunction(state, FunctionKind::kLower, types::StringType(),
+              MakeStringRows(MakeStrings(0, 64, state.range(0) != 0), {}));
+}
+BENCHMARK(BM_Lower)->ArgName("unicode")->Arg(0)->Arg(1);
+
+void BM_Like(benchmark::State& state, const char* pattern) {
+  RunFunction(state, FunctionKind::kLike, types::BoolType(),
+              MakeStringRows(MakeText(), {values::String(pattern)}));
+}
+BENCHMARK_CAPTURE(BM_Like, prefix, "abc%");
+BENCHMARK_CAPTURE(BM_Like, contains, "%abc%");
+BENCHMARK_CAPTURE(BM_Like, pieces, "%abc%word%");
+BENCHMARK_CAPTURE(BM_Like, underscore, "%abc_ %");
+
+void BM_RegexpContains(benchmark::State& state) {
+  RunFunction(state, FunctionKind::kRegexpContains, types::BoolType(),
+              MakeStringRows(MakeText(), {values::String("abc[0-9]+")}));
+}
+BENCHMARK(BM_RegexpContains);
+
+void BM_RegexpExtract(benchmark::State& state) {
+  RunFunction(state, FunctionKind::kRegexpExtract, types::StringType(),
+              MakeStringRows(MakeText(), {values::String("abc([0-9]+)")}));
+}
+BENCHMARK(BM_RegexpExtract);
+
+void BM_JsonExtract(benchmark::State& state) {
+  std::mt19937 random(kNumRows);
+  std::vector<std::string> documents;
+  for (int i = 0; i < kNumRows; ++i) {
+    std::string elements;
+    const int num_elements = random() % 5;
+    for (int j = 0; j < num_elements; ++j) {
+      absl::StrAppend(&elements, j > 0 ? "," : "", R"({"c": ")",
+                      random() % 1000, R"(", "d": [1, 2, 3]})");
+    }
+    documents.push_back(absl::StrCat(R"({"id": )", i, R"(, "a": {"b": [)",
+                                     elements, R"(]}, "e": "tail"})"));
+  }
+  RunFunction(state, FunctionKind::kJsonExtract, types::StringType(),
+              MakeStringRows(documents, {values::String("$.a.b[1].c")}));
+}
+BENCHMARK(BM_JsonExtract);
+
+void BM_ParseTimestamp(benchmark::State& state) {
+  std::mt19937 random(kNumRows);
+  std::vector<std::vector<Value>> rows;
+  for (int i = 0; i < kNumRows; ++i) {
+    rows.push_back({values::String("%Y-%m-%d %H:%M:%S"),
+                    values::String(absl::FormatTime(
+                        "%Y-%m-%d %H:%M:%S",
+                        absl::FromUnixSeconds(random() % (1LL << 31)),
+                        absl::UTCTimeZone()))});
+  }
+  RunFunction(state, FunctionKind::kParseTimestamp, types::TimestampType(),
+              rows);
+}
+BENCHMARK(BM_ParseTimestamp);
+
+// Integers with up to 18 digits, about half of them negative.
+std::vector<int64_t> MakeInt64s() {
+  std::mt19937_64 random(kNumRows);
+  std::vector<int64_t> values;
+  for (int i = 0; i < kNumRows; ++i) {
+    const int64_t magnitude =
+        static_cast<int64_t>(random() % 1000000000000000000ULL) >>
+        (random() % 60);
+    values.push_back(random() % 2 == 0 ? magnitude : -magnitude);
+  }
+  return values;
+}
+
+// CAST(STRING AS INT64), which goes through the same conversion functions as
+// the evaluator's casts.
+void BM_CastStringToInt64(benchmark::State& state) {
+  std::vector<Value> inputs;
+  for (int64_t value : MakeInt64s()) {
+    inputs.push_back(values::String(absl::StrCat(value)));
+  }
+  const LanguageOptions language_options = MaximumLanguageOptions();
+  int i = 0;
+  for (auto s : state) {
+    benchmark::DoNotOptimize(CastValue(inputs[i++ % kNumRows],
+                                       absl::UTCTimeZone(), language_options,
+                                       types::Int64Type()));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CastStringToInt64);
+
+void BM_NumericArithmetic(benchmark::State& state, FunctionKind kind) {
+  const std::vector<int64_t> int64s = MakeInt64s();
+  std::vector<std::vector<Value>> rows;
+  for (int i = 0; i < kNumRows; ++i) {
+    // Two fractional digits, as for amounts of money.
+    rows.push_back(
+        {values::Numeric(NumericValue::FromScaledValue(int64s[i] / 10000000)),
+         values::Numeric(NumericValue::FromScaledValue(
+             int64s[(i + 1) % kNumRows] / 10000000))});
+  }
+  RunFunction(state, kind, types::NumericType(), rows);
+}
+BENCHMARK_CAPTURE(BM_NumericArithmetic, add, FunctionKind::kAdd);
+BENCHMARK_CAPTURE(BM_NumericArithmetic, multiply, FunctionKind::kMultiply);
+BENCHMARK_CAPTURE(BM_NumericArithmetic, divide, FunctionKind::kDivide);
+
+void BM_CosineDistance(benchmark::State& state) {
+  std::mt19937 random(state.range(0));
+  std::uniform_real_distribution<double> distribution(-1, 1);
+  std::vector<Value> vectors;
+  for (int i = 0; i < kNumRows; ++i) {
+    std::vector<Value> elements;
+    for (int j = 0; j < state.range(0); ++j) {
+      elements.push_back(values::Double(distribution(random)));
+    }
+    vectors.push_back(values::Array(types::DoubleArrayType(), elements));
+  }
+  std::vector<std::vector<Value>> rows;
+  for (int i = 0; i < kNumRows; ++i) {
+    rows.push_back({vectors[i], vectors[(i + 1) % kNumRows]});
+  }
+  RunFunction(state, FunctionKind::kCosineDistance, types::DoubleType(), rows);
+}
+BENCHMARK(BM_CosineDistance)->Range(8, 1024);
+
+void BM_Hash(benchmark::State& state, FunctionKind kind) {
+  std::vector<std::vector<Value>> rows;
+  for (const std::string& str :
+       MakeStrings(state.range(0), state.range(0), /*unicode=*/false)) {
+    rows.push_back({values::Bytes(str)});
+  }
+  RunFunction(state, kind,
+              kind == FunctionKind::kFarmFingerprint ? types::Int64Type()
+                                                     : types::BytesType(),
+              rows);
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_CAPTURE(BM_Hash, md5, FunctionKind::kMd5)->Range(16, 4096);
+BENCHMARK_CAPTURE(BM_Hash, sha256, FunctionKind::kSha256)->Range(16, 4096);
+BENCHMARK_CAPTURE(BM_Hash, farm_fingerprint, FunctionKind::kFarmFingerprint)
+    ->Range(16, 4096);
+
+}  // namespace
+}  // namespace zetasql
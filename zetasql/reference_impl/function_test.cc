@@ -23,10 +23,14 @@
 
 #include "zetasql/common/evaluator_registration_utils.h"
 #include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/collator.h"
 #include "zetasql/public/interval_value.h"
+#include "zetasql/public/language_options.h"
 #include "zetasql/public/types/type_factory.h"
 #include "zetasql/reference_impl/evaluation.h"
+#include "zetasql/reference_impl/functions/collator_cache.h"
 #include "zetasql/reference_impl/functions/hash.h"
+#include "zetasql/reference_impl/functions/regexp_cache.h"
 #include "zetasql/reference_impl/operator.h"
 #include "zetasql/reference_impl/tuple.h"
 #include "gmock/gmock.h"
@@ -35,6 +39,8 @@
 
 namespace zetasql {
 
+using ::zetasql_base::testing::IsOkAndHolds;
+
 TEST(SafeInvokeUnary, DoesNotLeakStatus) {
   ArithmeticFunction unary_minus_fn(FunctionKind::kSafeNegate,
                                     types::Int64Type());
@@ -68,6 +74,199 @@ TEST(SafeInvokeBinary, DoesNotLeakStatus) {
   ZETASQL_EXPECT_OK(status);
 }
 
+TEST(RegexpCacheTest, SharesCompiledPatterns) {
+  RegexpCache cache(/*capacity=*/2);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const functions::RegExp> a,
+                       cache.GetRegExp("a+", TYPE_STRING));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const functions::RegExp> a_again,
+                       cache.GetRegExp("a+", TYPE_STRING));
+  EXPECT_EQ(a.get(), a_again.get());
+  // STRING and BYTES patterns are compiled with different options.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const functions::RegExp> a_bytes,
+                       cache.GetRegExp("a+", TYPE_BYTES));
+  EXPECT_NE(a.get(), a_bytes.get());
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const functions::LikeMatcher> like,
+                       cache.GetLikeMatcher("a%", TYPE_STRING));
+  EXPECT_TRUE(like->Match("abc"));
+  EXPECT_EQ(cache.size(), 3);
+
+  // Invalid patterns are not cached.
+  EXPECT_FALSE(cache.GetRegExp("(", TYPE_STRING).ok());
+  EXPECT_EQ(cache.size(), 3);
+
+  // "a+" is the least recently used STRING pattern, so it is evicted, but the
+  // caller's reference stays valid.
+  ZETASQL_ASSERT_OK(cache.GetRegExp("b+", TYPE_STRING).status());
+  ZETASQL_ASSERT_OK(cache.GetRegExp("c+", TYPE_STRING).status());
+  EXPECT_EQ(cache.size(), 4);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(a_again, cache.GetRegExp("a+", TYPE_STRING));
+  EXPECT_NE(a.get(), a_again.get());
+  bool matches = false;
+  absl::Status status;
+  ASSERT_TRUE(a->Match("aa", &matches, &status));
+  EXPECT_TRUE(matches);
+}
+
+TEST(CollatorCacheTest, SharesCollators) {
+  CollatorCache cache(/*capacity=*/2);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const ZetaSqlCollator> ci,
+                       cache.GetCollator("und:ci"));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const ZetaSqlCollator> ci_again,
+                       cache.GetCollator("und:ci"));
+  EXPECT_EQ(ci.get(), ci_again.get());
+  EXPECT_EQ(ci->GetCollationName(), "und:ci");
+
+  // Invalid collation names are not cached.
+  EXPECT_FALSE(cache.GetCollator("und:xx").ok());
+  EXPECT_EQ(cache.size(), 1);
+
+  // Once the cache is full, further collators are built for each caller.
+  ZETASQL_ASSERT_OK(cache.GetCollator("binary").status());
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const ZetaSqlCollator> cs,
+                       cache.GetCollator("und:cs"));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const ZetaSqlCollator> cs_again,
+                       cache.GetCollator("und:cs"));
+  EXPECT_NE(cs.get(), cs_again.get());
+  EXPECT_EQ(cache.size(), 2);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(ci_again, cache.GetCollator("und:ci"));
+  EXPECT_EQ(ci.get(), ci_again.get());
+}
+
+TEST(DateTimeTruncFunctionTest, TimestampTruncAcrossTransitions) {
+  absl::TimeZone timezone;
+  ZETASQL_ASSERT_OK(functions::MakeTimeZone("America/Los_Angeles", &timezone));
+  DateTimeTruncFunction trunc_fn(FunctionKind::kTimestampTrunc,
+                                 types::TimestampType());
+  EvaluationContext context{/*options=*/{}};
+  context.SetDefaultTimeZone(timezone);
+
+  // Step through the days around both daylight saving time transitions of
+  // 2023, with the reused intervals spanning the transitions.
+  for (const absl::CivilDay day :
+       {absl::CivilDay(2023, 3, 11), absl::CivilDay(2023, 11, 4)}) {
+    const int64_t begin =
+        absl::ToUnixMicros(absl::FromCivil(day, absl::UTCTimeZone()));
+    for (functions::DateTimestampPart part :
+         {functions::DAY, functions::HOUR, functions::MINUTE}) {
+      const Value part_value =
+          Value::Enum(types::DatePartEnumType(), static_cast<int>(part));
+      for (int64_t micros = begin; micros < begin + 3 * 86400000000LL;
+           micros += 7 * 60 * 1000000LL + 1) {
+        int64_t expected;
+        ZETASQL_ASSERT_OK(
+            functions::TimestampTrunc(micros, timezone, part, &expected));
+        const Value timestamp = Value::TimestampFromUnixMicros(micros);
+        EXPECT_THAT(trunc_fn.Eval(/*params=*/{}, {timestamp, part_value},
+                                  &context),
+                    IsOkAndHolds(Value::TimestampFromUnixMicros(expected)))
+            << timestamp.DebugString();
+        ZETASQL_ASSERT_OK(
+            functions::TimestampTrunc(micros, "+05:30", part, &expected));
+        EXPECT_THAT(
+            trunc_fn.Eval(/*params=*/{},
+                          {timestamp, part_value, Value::String("+05:30")},
+                          &context),
+            IsOkAndHolds(Value::TimestampFromUnixMicros(expected)))
+            << timestamp.DebugString();
+      }
+    }
+  }
+}
+
+TEST(LikeAnyAllFunctionTest, LikeAnyWithManyContainsPatterns) {
+  std::vector<std::unique_ptr<AlgebraArg>> arguments;
+  std::vector<Value> args = {Value::String(""),    Value::String("%foo%"),
+                             Value::String("%bar%"), Value::String("%baz%"),
+                             Value::String("%qux%"), Value::String("a_c")};
+  for (const Value& arg : args) {
+    ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<ConstExpr> expr,
+                         ConstExpr::Create(arg));
+    arguments.push_back(std::make_unique<ExprArg>(std::move(expr)));
+  }
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<BuiltinScalarFunction> like_any,
+      BuiltinScalarFunction::CreateValidated(
+          FunctionKind::kLikeAny, LanguageOptions(), types::BoolType(),
+          arguments));
+
+  EvaluationContext context{/*options=*/{}};
+  auto eval = [&](const Value& search_value) -> absl::StatusOr<Value> {
+    args[0] = search_value;
+    Value result;
+    absl::Status status;
+    if (!like_any->Eval(/*params=*/{}, args, &context, &result, &status)) {
+      return status;
+    }
+    return result;
+  };
+  EXPECT_THAT(eval(Value::String("xbazy")), IsOkAndHolds(Value::Bool(true)));
+  EXPECT_THAT(eval(Value::String("abc")), IsOkAndHolds(Value::Bool(true)));
+  EXPECT_THAT(eval(Value::String("fo")), IsOkAndHolds(Value::Bool(false)));
+  EXPECT_THAT(eval(Value::NullString()), IsOkAndHolds(Value::NullBool()));
+}
+
+TEST(ArrayFunctionsTest, ShareElementsOfWholeInputArray) {
+  TypeFactory factory;
+  const ArrayType* array_type;
+  ZETASQL_ASSERT_OK(factory.MakeArrayType(factory.get_string(), &array_type));
+  const Value array = Value::Array(
+      array_type, {Value::String("a"), Value::String("b"), Value::String("c")});
+  auto shares_elements = [&array](const Value& result) {
+    return &result.elements() == &array.elements();
+  };
+  EvaluationContext context{/*options=*/{}};
+
+  std::vector<VariableId> lambda_arg_vars = {VariableId("e")};
+  std::unique_ptr<InlineLambdaExpr> keep_all = InlineLambdaExpr::Create(
+      lambda_arg_vars, ConstExpr::Create(Value::Bool(true)).value());
+  ArrayFilterFunction filter_fn(FunctionKind::kArrayFilter, array_type,
+                                keep_all.get());
+  ZETASQL_ASSERT_OK_AND_ASSIGN(Value filtered,
+                       filter_fn.Eval(/*params=*/{}, {array}, &context));
+  EXPECT_TRUE(shares_elements(filtered));
+
+  ArraySliceFunction slice_fn(FunctionKind::kArraySlice, array_type);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      Value slice,
+      slice_fn.Eval(/*params=*/{}, {array, Value::Int64(0), Value::Int64(5)},
+                    &context));
+  EXPECT_TRUE(shares_elements(slice));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      slice,
+      slice_fn.Eval(/*params=*/{}, {array, Value::Int64(1), Value::Int64(-1)},
+                    &context));
+  EXPECT_FALSE(shares_elements(slice));
+  EXPECT_EQ(slice, Value::Array(array_type, {Value::String("b"),
+                                             Value::String("c")}));
+
+  ArrayReverseFunction reverse_fn(array_type);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(Value reversed,
+                       reverse_fn.Eval(/*params=*/{}, {array}, &context));
+  EXPECT_EQ(reversed,
+            Value::Array(array_type, {Value::String("c"), Value::String("b"),
+                                      Value::String("a")}));
+
+  ArrayConcatFunction concat_fn(FunctionKind::kArrayConcat, array_type);
+  Value concat;
+  absl::Status status;
+  ASSERT_TRUE(concat_fn.Eval(/*params=*/{},
+                             {Value::EmptyArray(array_type), array}, &context,
+                             &concat, &status));
+  EXPECT_TRUE(shares_elements(concat));
+  ASSERT_TRUE(concat_fn.Eval(/*params=*/{}, {array, reversed}, &context,
+                             &concat, &status));
+  EXPECT_EQ(concat.num_elements(), 6);
+
+  // An array that ignores order is copied, so that the result preserves it.
+  const Value unordered = InternalValue::Array(
+      array_type, {Value::String("a"), Value::String("b")},
+      InternalValue::kIgnoresOrder);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(filtered,
+                       filter_fn.Eval(/*params=*/{}, {unordered}, &context));
+  EXPECT_EQ(InternalValue::GetOrderKind(filtered),
+            InternalValue::kPreservesOrder);
+}
+
 TEST(NonDeterministicEvaluationContextTest, ArrayFilterTransformFunctionTest) {
   TypeFactory factory;
   const ArrayType* array_type;
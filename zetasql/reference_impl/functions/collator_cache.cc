@@ -0,0 +1,75 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/reference_impl/functions/collator_cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "zetasql/public/collator.h"
+#include "zetasql/base/check.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+CollatorCache::CollatorCache(int64_t capacity) : capacity_(capacity) {
+  ABSL_CHECK_GT(capacity, 0);
+}
+
+CollatorCache& CollatorCache::Global() {
+  static CollatorCache* cache = new CollatorCache(kDefaultCapacity);
+  return *cache;
+}
+
+absl::StatusOr<std::shared_ptr<const ZetaSqlCollator>>
+CollatorCache::GetCollator(absl::string_view collation_name) {
+  {
+    absl::MutexLock lock(&mutex_);
+    auto it = collators_.find(collation_name);
+    if (it != collators_.end()) {
+      return it->second;
+    }
+  }
+
+  // 'mutex_' is not held while building the collator, which loads the
+  // collation rules of ICU, so that other threads can look up other collators
+  // in the meantime.
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<const ZetaSqlCollator> collator,
+                   MakeSqlCollator(collation_name));
+  std::shared_ptr<const ZetaSqlCollator> result = std::move(collator);
+
+  absl::MutexLock lock(&mutex_);
+  if (static_cast<int64_t>(collators_.size()) >= capacity_) {
+    auto it = collators_.find(collation_name);
+    return it != collators_.end() ? it->second : result;
+  }
+  // If another thread built the same collator in the meantime, use its one.
+  auto [it, inserted] =
+      collators_.try_emplace(std::string(collation_name), std::move(result));
+  return it->second;
+}
+
+int64_t CollatorCache::size() const {
+  absl::MutexLock lock(&mutex_);
+  return collators_.size();
+}
+
+}  // namespace zetasql
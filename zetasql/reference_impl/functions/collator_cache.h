@@ -0,0 +1,71 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_REFERENCE_IMPL_FUNCTIONS_COLLATOR_CACHE_H_
+#define ZETASQL_REFERENCE_IMPL_FUNCTIONS_COLLATOR_CACHE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "zetasql/public/collator.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+
+namespace zetasql {
+
+// A bounded, thread-safe cache of the collators for the collation names of
+// the functions with collation, like $like_with_collation or
+// $replace_with_collation, which receive the name as an argument of each call.
+// It is shared by all evaluations in the process, so that each collation is
+// only built once, instead of once per row. Collation names come from COLLATE
+// clauses, so there are few of them; once the cache is full, the collators of
+// further names are built for each caller and not cached. Names that are not
+// valid collations are not cached.
+class CollatorCache {
+ public:
+  // The maximum number of collators in Global().
+  static constexpr int64_t kDefaultCapacity = 1024;
+
+  // 'capacity' is the maximum number of collators, and must be positive.
+  explicit CollatorCache(int64_t capacity);
+
+  CollatorCache(const CollatorCache&) = delete;
+  CollatorCache& operator=(const CollatorCache&) = delete;
+
+  // Returns the cache that is shared by the whole process.
+  static CollatorCache& Global();
+
+  // Returns the collator for 'collation_name', like MakeSqlCollator().
+  absl::StatusOr<std::shared_ptr<const ZetaSqlCollator>> GetCollator(
+      absl::string_view collation_name);
+
+  // Returns the number of cached collators.
+  int64_t size() const;
+
+ private:
+  const int64_t capacity_;
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, std::shared_ptr<const ZetaSqlCollator>>
+      collators_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_REFERENCE_IMPL_FUNCTIONS_COLLATOR_CACHE_H_
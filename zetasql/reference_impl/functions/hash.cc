@@ -44,6 +44,20 @@ static functions::Hasher::Algorithm GetHasherAlgorithm(FunctionKind kind) {
   }
 }
 
+// Returns the Hasher for 'algorithm' of the calling thread. A Hasher is not
+// thread-safe, while HashFunction instances are global (b/299648584), but
+// creating a Hasher for every row would allocate it every time.
+static functions::Hasher& GetThreadLocalHasher(
+    functions::Hasher::Algorithm algorithm) {
+  static constexpr int kNumAlgorithms = functions::Hasher::kSha512 + 1;
+  thread_local std::unique_ptr<functions::Hasher> hashers[kNumAlgorithms];
+  std::unique_ptr<functions::Hasher>& hasher = hashers[algorithm];
+  if (hasher == nullptr) {
+    hasher = functions::Hasher::Create(algorithm);
+  }
+  return *hasher;
+}
+
 class HashFunction : public SimpleBuiltinScalarFunction {
  public:
   explicit HashFunction(FunctionKind kind);
@@ -80,9 +94,7 @@ absl::StatusOr<Value> HashFunction::Eval(
                                       ? args[0].bytes_value()
                                       : args[0].string_value();
 
-  // Create a new hasher on every invocation for thread safety, because the
-  // HashFunction instance is global (b/299648584)
-  return Value::Bytes(functions::Hasher::Create(algorithm_)->Hash(input));
+  return Value::Bytes(GetThreadLocalHasher(algorithm_).Hash(input));
 }
 
 absl::StatusOr<Value> FarmFingerprintFunction::Eval(
@@ -32,10 +32,14 @@
 #include "zetasql/public/language_options.h"
 #include "zetasql/public/type.pb.h"
 #include "zetasql/public/types/array_type.h"
+#include "zetasql/public/types/struct_type.h"
+#include "zetasql/public/types/type.h"
 #include "zetasql/public/types/type_factory.h"
 #include "zetasql/public/value.h"
 #include "zetasql/reference_impl/function.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "zetasql/base/ret_check.h"
 
 namespace zetasql {
@@ -64,19 +68,30 @@ absl::StatusOr<JSONValueConstRef> GetJSONValueConstRef(
   return json_storage.GetConstRef();
 }
 
-absl::StatusOr<JSONValue> GetJSONValueCopy(
-    const Value& json, const LanguageOptions& language_options) {
-  JSONParsingOptions json_parsing_options = JSONParsingOptions{
-      .wide_number_mode = (language_options.LanguageFeatureEnabled(
-                               FEATURE_JSON_STRICT_NUMBER_PARSING)
-                               ? JSONParsingOptions::WideNumberMode::kExact
-                               : JSONParsingOptions::WideNumberMode::kRound)};
-
+// Returns a mutable copy of `json` for the functions that modify a JSON
+// document. The estimated size of the copy is charged to `reservation`, which
+// the caller holds while it modifies the copy, so that documents that do not
+// fit into the memory limit fail the evaluation. Validated documents are
+// charged before they are copied.
+absl::StatusOr<JSONValue> GetJSONValueCopy(const Value& json,
+                                           EvaluationContext* context,
+                                           MemoryReservation& reservation) {
+  absl::Status status;
   if (json.is_validated_json()) {
+    if (!reservation.Increase(json.json_value().SpaceUsed(), &status)) {
+      return status;
+    }
     return JSONValue::CopyFrom(json.json_value());
   }
-  return JSONValue::ParseJSONString(json.json_value_unparsed(),
-                                    json_parsing_options);
+  ZETASQL_ASSIGN_OR_RETURN(
+      JSONValue copy,
+      JSONValue::ParseJSONString(
+          json.json_value_unparsed(),
+          GetJSONParsingOptions(context->GetLanguageOptions())));
+  if (!reservation.Increase(copy.GetConstRef().SpaceUsed(), &status)) {
+    return status;
+  }
+  return copy;
 }
 
 // Create a StrictJSONPathIterator from `path`. Returns an error if
@@ -130,6 +145,34 @@ void MaybeSetNonDeterministicContext(const Value& arg,
   }
 }
 
+// Computes several JSON_EXTRACT, JSON_EXTRACT_SCALAR, JSON_QUERY and
+// JSON_VALUE calls with constant paths on the same input, and returns their
+// results as the fields of a STRUCT. See CreateJsonMultiExtractFunction().
+class JsonMultiExtractFunction : public SimpleBuiltinScalarFunction {
+ public:
+  JsonMultiExtractFunction(
+      std::vector<std::unique_ptr<functions::JsonPathEvaluator>> evaluators,
+      std::vector<bool> scalar, const StructType* output_type)
+      : SimpleBuiltinScalarFunction(FunctionKind::kJsonExtract, output_type),
+        evaluators_(std::move(evaluators)),
+        scalar_(std::move(scalar)) {
+    for (const auto& evaluator : evaluators_) {
+      evaluator_ptrs_.push_back(evaluator.get());
+    }
+  }
+
+  std::string debug_name() const override { return "JsonMultiExtract"; }
+
+  absl::StatusOr<Value> Eval(absl::Span<const TupleData* const> params,
+                             absl::Span<const Value> args,
+                             EvaluationContext* context) const override;
+
+ private:
+  std::vector<std::unique_ptr<functions::JsonPathEvaluator>> evaluators_;
+  std::vector<const functions::JsonPathEvaluator*> evaluator_ptrs_;
+  std::vector<bool> scalar_;
+};
+
 // Implementation of:
 // JSON_EXTRACT/JSON_QUERY(string, string) -> string
 // JSON_EXTRACT/JSON_QUERY(json, string) -> json
@@ -316,8 +359,8 @@ absl::StatusOr<Value> JsonExtractJson(
       output_string_or = evaluator.ExtractScalar(json.json_value());
     } else {
       ZETASQL_ASSIGN_OR_RETURN(JSONValue input_json,
-                       JSONValue::ParseJSONString(json.json_value_unparsed(),
-                                                  parsing_options));
+                       evaluator.ParseJSONAlongPath(
+                           json.json_value_unparsed(), parsing_options));
       output_string_or = evaluator.ExtractScalar(input_json.GetConstRef());
     }
     if (output_string_or.has_value()) {
@@ -330,8 +373,8 @@ absl::StatusOr<Value> JsonExtractJson(
       output_json_or = evaluator.Extract(json.json_value());
     } else {
       ZETASQL_ASSIGN_OR_RETURN(input_json,
-                       JSONValue::ParseJSONString(json.json_value_unparsed(),
-                                                  parsing_options));
+                       evaluator.ParseJSONAlongPath(
+                           json.json_value_unparsed(), parsing_options));
       output_json_or = evaluator.Extract(input_json.GetConstRef());
     }
     if (output_json_or.has_value()) {
@@ -463,6 +506,50 @@ absl::StatusOr<Value> JsonExtractFunction::Eval(
   }
 }
 
+absl::StatusOr<Value> JsonMultiExtractFunction::Eval(
+    absl::Span<const TupleData* const> params, absl::Span<const Value> args,
+    EvaluationContext* context) const {
+  ZETASQL_RET_CHECK_EQ(args.size(), 1);
+  const StructType* struct_type = output_type()->AsStruct();
+  ZETASQL_RET_CHECK_EQ(struct_type->num_fields(), evaluators_.size());
+  std::vector<Value> fields;
+  fields.reserve(evaluators_.size());
+  if (args[0].is_null()) {
+    for (int i = 0; i < struct_type->num_fields(); ++i) {
+      fields.push_back(Value::Null(struct_type->field(i).type));
+    }
+  } else if (args[0].type_kind() == TYPE_STRING) {
+    std::vector<std::optional<std::string>> values;
+    ZETASQL_RETURN_IF_ERROR(functions::JsonPathEvaluator::ExtractMany(
+        args[0].string_value(), evaluator_ptrs_, scalar_, &values));
+    for (std::optional<std::string>& value : values) {
+      fields.push_back(value.has_value() ? Value::String(*std::move(value))
+                                         : Value::NullString());
+    }
+  } else {
+    JSONValue json_backing;
+    ZETASQL_ASSIGN_OR_RETURN(
+        JSONValueConstRef json,
+        GetJSONValueConstRef(
+            args[0], GetJSONParsingOptions(context->GetLanguageOptions()),
+            json_backing));
+    for (int i = 0; i < evaluators_.size(); ++i) {
+      if (scalar_[i]) {
+        std::optional<std::string> value = evaluators_[i]->ExtractScalar(json);
+        fields.push_back(value.has_value() ? Value::String(*std::move(value))
+                                           : Value::NullString());
+      } else {
+        std::optional<JSONValueConstRef> value = evaluators_[i]->Extract(json);
+        fields.push_back(value.has_value()
+                             ? Value::Json(JSONValue::CopyFrom(*value))
+                             : Value::Null(struct_type->field(i).type));
+      }
+    }
+  }
+  // The field types have been checked by CreateJsonMultiExtractFunction().
+  return Value::UnsafeStruct(struct_type, std::move(fields));
+}
+
 // Helper function for the string version of JSON_VALUE_ARRAY and
 // JSON_EXTRACT_STRING_ARRAY.
 absl::StatusOr<Value> JsonExtractStringArrayString(
@@ -511,8 +598,8 @@ absl::StatusOr<Value> JsonExtractStringArrayJson(
     output = evaluator.ExtractStringArray(json.json_value());
   } else {
     ZETASQL_ASSIGN_OR_RETURN(JSONValue input_json,
-                     JSONValue::ParseJSONString(json.json_value_unparsed(),
-                                                parsing_options));
+                     evaluator.ParseJSONAlongPath(
+                         json.json_value_unparsed(), parsing_options));
     output = evaluator.ExtractStringArray(input_json.GetConstRef());
   }
   if (output.has_value()) {
@@ -542,8 +629,8 @@ absl::StatusOr<Value> JsonExtractArrayJson(
     output = evaluator.ExtractArray(json.json_value());
   } else {
     ZETASQL_ASSIGN_OR_RETURN(input_json,
-                     JSONValue::ParseJSONString(json.json_value_unparsed(),
-                                                parsing_options));
+                     evaluator.ParseJSONAlongPath(
+                         json.json_value_unparsed(), parsing_options));
     output = evaluator.ExtractArray(input_json.GetConstRef());
   }
   if (output.has_value()) {
@@ -640,7 +727,7 @@ absl::StatusOr<Value> ToJsonStringFunction::Eval(
                    : JSONParsingOptions::WideNumberMode::kRound),
           .canonicalize_zero = true}));
   MaybeSetNonDeterministicContext(args[0], context);
-  return Value::String(output);
+  return Value::StringValue(std::move(output));
 }
 
 absl::StatusOr<Value> ParseJsonFunction::Eval(
@@ -1140,9 +1227,15 @@ absl::StatusOr<Value> JsonRemoveFunction::Eval(
   if (args[0].is_null()) {
     return Value::NullJson();
   }
+  // Without a path to remove the input is returned as is, which shares its
+  // document instead of copying it.
+  if (path_iterators.empty() && args[0].is_validated_json()) {
+    return args[0];
+  }
 
+  MemoryReservation reservation(context->memory_accountant());
   ZETASQL_ASSIGN_OR_RETURN(JSONValue result,
-                   GetJSONValueCopy(args[0], context->GetLanguageOptions()));
+                   GetJSONValueCopy(args[0], context, reservation));
   JSONValueRef ref = result.GetRef();
 
   for (auto& path_iterator : path_iterators) {
@@ -1200,12 +1293,17 @@ absl::StatusOr<Value> JsonArrayInsertAppendFunction::Eval(
 
   const LanguageOptions& language_options = context->GetLanguageOptions();
 
+  ZETASQL_RET_CHECK(args.back().type()->IsBool());
+  // Check if `{insert,append}_each_element` is NULL.
+  if (args.back().is_null() && args[0].is_validated_json()) {
+    return args[0];
+  }
+
+  MemoryReservation reservation(context->memory_accountant());
   ZETASQL_ASSIGN_OR_RETURN(JSONValue result,
-                   GetJSONValueCopy(args[0], language_options));
+                   GetJSONValueCopy(args[0], context, reservation));
   JSONValueRef ref = result.GetRef();
 
-  ZETASQL_RET_CHECK(args.back().type()->IsBool());
-  // Check if `{insert,append}_each_element` is NULL.
   if (args.back().is_null()) {
     return Value::Json(std::move(result));
   }
@@ -1267,12 +1365,18 @@ absl::StatusOr<Value> JsonSetFunction::Eval(
   }
 
   const LanguageOptions& language_options = context->GetLanguageOptions();
-  ZETASQL_ASSIGN_OR_RETURN(JSONValue result,
-                   GetJSONValueCopy(args[0], language_options));
-  JSONValueRef ref = result.GetRef();
 
   ZETASQL_RET_CHECK(args.back().type()->IsBool());
   // Check if `create_if_missing` is NULL.
+  if (args.back().is_null() && args[0].is_validated_json()) {
+    return args[0];
+  }
+
+  MemoryReservation reservation(context->memory_accountant());
+  ZETASQL_ASSIGN_OR_RETURN(JSONValue result,
+                   GetJSONValueCopy(args[0], context, reservation));
+  JSONValueRef ref = result.GetRef();
+
   if (args.back().is_null()) {
     return Value::Json(std::move(result));
   }
@@ -1335,10 +1439,11 @@ absl::StatusOr<Value> JsonStripNullsFunction::Eval(
   // Step 3) If json_path, include_arrays or remove_empty is NULL return
   // json_expr.
   if (args[1].is_null() || args[2].is_null() || args[3].is_null()) {
-    return Value::Json(JSONValue::CopyFrom(args[0].json_value()));
+    return args[0];
   }
+  MemoryReservation reservation(context->memory_accountant());
   ZETASQL_ASSIGN_OR_RETURN(JSONValue result,
-                   GetJSONValueCopy(args[0], context->GetLanguageOptions()));
+                   GetJSONValueCopy(args[0], context, reservation));
 
   // Step 4) Execute JSON_STRIP_NULLS function and return result.
   ZETASQL_RETURN_IF_ERROR(functions::JsonStripNulls(result.GetRef(), *path_iterator,
@@ -1347,8 +1452,83 @@ absl::StatusOr<Value> JsonStripNullsFunction::Eval(
   return Value::Json(std::move(result));
 }
 
+bool IsSqlStandardJsonFunction(FunctionKind kind) {
+  return kind == FunctionKind::kJsonQuery || kind == FunctionKind::kJsonValue;
+}
+
+bool IsScalarJsonFunction(FunctionKind kind) {
+  return kind == FunctionKind::kJsonValue ||
+         kind == FunctionKind::kJsonExtractScalar;
+}
+
 }  // namespace
 
+bool CanExtractJsonPathTogether(const JsonPathExtraction& extraction,
+                                const Type* input_type,
+                                const LanguageOptions& language_options) {
+  switch (extraction.kind) {
+    case FunctionKind::kJsonExtract:
+    case FunctionKind::kJsonExtractScalar:
+    case FunctionKind::kJsonQuery:
+    case FunctionKind::kJsonValue:
+      break;
+    default:
+      return false;
+  }
+  if (!input_type->IsString() && !input_type->IsJson()) {
+    return false;
+  }
+  // Invalid paths are left to JsonExtractFunction, so that they are only
+  // reported for the rows that evaluate the call.
+  if (!functions::JsonPathEvaluator::Create(
+           extraction.json_path, IsSqlStandardJsonFunction(extraction.kind),
+           /*enable_special_character_escaping_in_values=*/true,
+           /*enable_special_character_escaping_in_keys=*/true)
+           .ok()) {
+    return false;
+  }
+  if (extraction.kind == FunctionKind::kJsonQuery && input_type->IsJson() &&
+      language_options.LanguageFeatureEnabled(FEATURE_JSON_QUERY_LAX)) {
+    absl::StatusOr<bool> is_lax =
+        functions::json_internal::IsValidAndLaxJSONPath(extraction.json_path);
+    if (!is_lax.ok() || *is_lax) {
+      return false;
+    }
+  }
+  return true;
+}
+
+absl::StatusOr<std::unique_ptr<BuiltinScalarFunction>>
+CreateJsonMultiExtractFunction(const Type* input_type,
+                               absl::Span<const JsonPathExtraction> extractions,
+                               const StructType* output_type) {
+  ZETASQL_RET_CHECK(input_type->IsString() || input_type->IsJson());
+  ZETASQL_RET_CHECK_EQ(output_type->num_fields(), extractions.size());
+  std::vector<std::unique_ptr<functions::JsonPathEvaluator>> evaluators;
+  std::vector<bool> scalar;
+  for (int i = 0; i < extractions.size(); ++i) {
+    const JsonPathExtraction& extraction = extractions[i];
+    ZETASQL_RET_CHECK(IsScalarJsonFunction(extraction.kind) ||
+              extraction.kind == FunctionKind::kJsonExtract ||
+              extraction.kind == FunctionKind::kJsonQuery);
+    const Type* expected_type =
+        IsScalarJsonFunction(extraction.kind) || input_type->IsString()
+            ? types::StringType()
+            : types::JsonType();
+    ZETASQL_RET_CHECK(output_type->field(i).type->Equals(expected_type));
+    ZETASQL_ASSIGN_OR_RETURN(
+        std::unique_ptr<functions::JsonPathEvaluator> evaluator,
+        functions::JsonPathEvaluator::Create(
+            extraction.json_path, IsSqlStandardJsonFunction(extraction.kind),
+            /*enable_special_character_escaping_in_values=*/true,
+            /*enable_special_character_escaping_in_keys=*/true));
+    evaluators.push_back(std::move(evaluator));
+    scalar.push_back(IsScalarJsonFunction(extraction.kind));
+  }
+  return std::make_unique<JsonMultiExtractFunction>(
+      std::move(evaluators), std::move(scalar), output_type);
+}
+
 void RegisterBuiltinJsonFunctions() {
   BuiltinFunctionRegistry::RegisterScalarFunction(
       {FunctionKind::kJsonExtract, FunctionKind::kJsonExtractScalar,
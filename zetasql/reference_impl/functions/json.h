@@ -17,6 +17,17 @@
 #ifndef ZETASQL_REFERENCE_IMPL_FUNCTIONS_JSON_H_
 #define ZETASQL_REFERENCE_IMPL_FUNCTIONS_JSON_H_
 
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/language_options.h"
+#include "zetasql/public/types/struct_type.h"
+#include "zetasql/public/types/type.h"
+#include "zetasql/reference_impl/function.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+
 namespace zetasql {
 
 // This module registers the following function implementations: JSON_EXTRACT,
@@ -24,6 +35,30 @@ namespace zetasql {
 // TO_JSON_STRING.
 void RegisterBuiltinJsonFunctions();
 
+// A call of JSON_EXTRACT, JSON_EXTRACT_SCALAR, JSON_QUERY or JSON_VALUE with a
+// constant path.
+struct JsonPathExtraction {
+  FunctionKind kind;
+  std::string json_path;
+};
+
+// Returns true if CreateJsonMultiExtractFunction() can compute 'extraction'
+// on an input of type 'input_type' with the same result and errors as the
+// function call, e.g., 'json_path' must be valid.
+bool CanExtractJsonPathTogether(const JsonPathExtraction& extraction,
+                                const Type* input_type,
+                                const LanguageOptions& language_options);
+
+// Returns a function that computes all of 'extractions' on its only argument,
+// of type 'input_type', and returns their results as the fields of a STRUCT
+// of type 'output_type'. A STRING argument is scanned only once for all the
+// paths, and an unvalidated JSON argument is parsed only once. Each of
+// 'extractions' must satisfy CanExtractJsonPathTogether().
+absl::StatusOr<std::unique_ptr<BuiltinScalarFunction>>
+CreateJsonMultiExtractFunction(const Type* input_type,
+                               absl::Span<const JsonPathExtraction> extractions,
+                               const StructType* output_type);
+
 }  // namespace zetasql
 
 #endif  // ZETASQL_REFERENCE_IMPL_FUNCTIONS_JSON_H_
@@ -25,17 +25,18 @@
 #include "zetasql/public/functions/string_with_collation.h"
 #include "zetasql/public/types/type_factory.h"
 #include "zetasql/public/value.h"
+#include "zetasql/reference_impl/functions/collator_cache.h"
+#include "zetasql/reference_impl/functions/regexp_cache.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
-#include "re2/re2.h"
 #include "zetasql/base/ret_check.h"
 #include "zetasql/base/status_macros.h"
 
 namespace zetasql {
 
 absl::StatusOr<Value> LikeImpl(const Value& lhs, const Value& rhs,
-                               const RE2* regexp) {
+                               const functions::LikeMatcher* matcher) {
   if (lhs.is_null() || rhs.is_null()) {
     return Value::Null(types::BoolType());
   }
@@ -43,17 +44,18 @@ absl::StatusOr<Value> LikeImpl(const Value& lhs, const Value& rhs,
   const std::string& text =
       lhs.type_kind() == TYPE_STRING ? lhs.string_value() : lhs.bytes_value();
 
-  if (regexp != nullptr) {
-    // Regexp is precompiled
-    return Value::Bool(RE2::FullMatch(text, *regexp));
+  if (matcher != nullptr) {
+    // Pattern is precompiled
+    return Value::Bool(matcher->Match(text));
   } else {
-    // Regexp is not precompiled, compile it on the fly
+    // Pattern is not precompiled, compile it on the fly unless the same
+    // pattern was compiled recently.
     const std::string& pattern =
         rhs.type_kind() == TYPE_STRING ? rhs.string_value() : rhs.bytes_value();
-    std::unique_ptr<RE2> regexp;
-    ZETASQL_RETURN_IF_ERROR(
-        functions::CreateLikeRegexp(pattern, lhs.type_kind(), &regexp));
-    return Value::Bool(RE2::FullMatch(text, *regexp));
+    ZETASQL_ASSIGN_OR_RETURN(
+        std::shared_ptr<const functions::LikeMatcher> runtime_matcher,
+        RegexpCache::Global().GetLikeMatcher(pattern, lhs.type_kind()));
+    return Value::Bool(runtime_matcher->Match(text));
   }
 }
 
@@ -109,21 +111,23 @@ Value LogicalNot(const Value& value) {
 absl::Status ValidateQuantifiedLikeEvaluationParams(
     const QuantifiedLikeEvaluationParams& params) {
   if (params.collation_str.empty()) {
-    ZETASQL_RET_CHECK(params.pattern_regex != nullptr) << "Pattern regex is null";
     // For cases with pattern is a subquery expression creating an ARRAY, the
-    // number of regexps will be less than the number of elements and the regexp
-    ZETASQL_RET_CHECK_LE(params.pattern_regex->size(), params.pattern_elements.size())
-        << "Number of regexps is greater than the number of elements";
+    // number of matchers will be less than the number of elements.
+    ZETASQL_RET_CHECK_LE(params.pattern_matchers.size(),
+                 params.pattern_elements.size())
+        << "Number of matchers is greater than the number of elements";
+  } else {
+    ZETASQL_RET_CHECK(params.pattern_matchers.empty());
   }
   return absl::OkStatus();
 }
 
-absl::StatusOr<std::unique_ptr<const ZetaSqlCollator>> BuildCollator(
+absl::StatusOr<std::shared_ptr<const ZetaSqlCollator>> BuildCollator(
     const std::string& collation_str) {
   if (collation_str.empty()) {
     return nullptr;
   }
-  return zetasql::MakeSqlCollator(collation_str);
+  return CollatorCache::Global().GetCollator(collation_str);
 }
 
 absl::StatusOr<Value> EvaluateQuantifiedLike(
@@ -137,7 +141,7 @@ absl::StatusOr<Value> EvaluateQuantifiedLike(
     return Value::Bool(false);
   }
 
-  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<const ZetaSqlCollator> collator,
+  ZETASQL_ASSIGN_OR_RETURN(std::shared_ptr<const ZetaSqlCollator> collator,
                    BuildCollator(params.collation_str));
   if (!params.collation_str.empty()) {
     ZETASQL_RET_CHECK(collator != nullptr);
@@ -163,11 +167,13 @@ absl::StatusOr<Value> EvaluateQuantifiedLike(
       local_result = Value::Bool(result);
     } else {
       // If collator is absent, invoke like without collation
-      const RE2* current_regexp = i < params.pattern_regex->size()
-                                      ? params.pattern_regex->at(i).get()
-                                      : nullptr;
-      ZETASQL_ASSIGN_OR_RETURN(local_result, LikeImpl(params.search_value,
-                                              pattern_element, current_regexp));
+      const functions::LikeMatcher* current_matcher =
+          i < params.pattern_matchers.size()
+              ? params.pattern_matchers[i].get()
+              : nullptr;
+      ZETASQL_ASSIGN_OR_RETURN(local_result,
+                       LikeImpl(params.search_value, pattern_element,
+                                current_matcher));
     }
 
     // If NOT LIKE ANY/ALL, flip the result.
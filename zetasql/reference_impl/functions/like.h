@@ -21,6 +21,7 @@
 #include <string>
 #include <vector>
 
+#include "zetasql/public/functions/like.h"
 #include "zetasql/public/proto/type_annotation.pb.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/types/type.h"
@@ -28,7 +29,6 @@
 #include "zetasql/base/check.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
-#include "re2/re2.h"
 
 namespace zetasql {
 
@@ -46,12 +46,13 @@ struct QuantifiedLikeEvaluationParams {
   // The RHS pattern elements of like and quantified like operators.
   // pattern_elements should be non-empty.
   const absl::Span<const Value> pattern_elements;
-  // The RHS pattern regex of like and quantified like operators.
-  // pattern_regex is used for comparison for cases without collation.
-  // pattern_regex should be null when collation is specified. If collation_str
-  // is empty (collation not specified), then pattern_regex and pattern_elements
-  // must contain same number of elements.
-  const std::vector<std::unique_ptr<RE2>>* pattern_regex;
+  // The matchers precompiled for the RHS pattern elements of like and
+  // quantified like operators, which are used for comparison for cases without
+  // collation. pattern_matchers should be empty when collation is specified.
+  // A NULL matcher, or a missing one for a trailing pattern element, means
+  // that the pattern element is compiled at evaluation time.
+  const absl::Span<const std::unique_ptr<const functions::LikeMatcher>>
+      pattern_matchers;
   const OperationType operation_type;
   // Indicates whether quantified LIKE is has a preceding NOT operator.
   const bool is_not;
@@ -62,11 +63,12 @@ struct QuantifiedLikeEvaluationParams {
   QuantifiedLikeEvaluationParams() = delete;
   QuantifiedLikeEvaluationParams(
       const Value& search_value, absl::Span<const Value> pattern_elements,
-      const std::vector<std::unique_ptr<RE2>>* pattern_regex,
+      absl::Span<const std::unique_ptr<const functions::LikeMatcher>>
+          pattern_matchers,
       OperationType operation_type, bool is_not)
       : search_value(search_value),
         pattern_elements(pattern_elements),
-        pattern_regex(pattern_regex),
+        pattern_matchers(pattern_matchers),
         operation_type(operation_type),
         is_not(is_not) {}
 
@@ -76,7 +78,6 @@ struct QuantifiedLikeEvaluationParams {
                                  const std::string& collation_str)
       : search_value(search_value),
         pattern_elements(pattern_elements),
-        pattern_regex(nullptr),
         operation_type(operation_type),
         is_not(is_not),
         collation_str(collation_str) {}
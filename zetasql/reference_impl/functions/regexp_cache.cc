@@ -0,0 +1,116 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/reference_impl/functions/regexp_cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "zetasql/public/functions/like.h"
+#include "zetasql/public/functions/regexp.h"
+#include "zetasql/public/type.pb.h"
+#include "zetasql/base/check.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+template <typename T>
+absl::StatusOr<std::shared_ptr<const T>>
+RegexpCache::LruCache<T>::GetOrCompile(
+    absl::string_view pattern,
+    absl::FunctionRef<absl::StatusOr<std::unique_ptr<const T>>()> compile) {
+  {
+    absl::MutexLock lock(&mutex_);
+    auto it = index_.find(pattern);
+    if (it != index_.end()) {
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return it->second->second;
+    }
+  }
+
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<const T> compiled, compile());
+  std::shared_ptr<const T> result = std::move(compiled);
+
+  absl::MutexLock lock(&mutex_);
+  auto [it, inserted] = index_.try_emplace(std::string(pattern));
+  if (!inserted) {
+    // Another thread compiled the same pattern in the meantime.
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->second;
+  }
+  entries_.emplace_front(std::string(pattern), result);
+  it->second = entries_.begin();
+  if (static_cast<int64_t>(entries_.size()) > capacity_) {
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+  return result;
+}
+
+template <typename T>
+int64_t RegexpCache::LruCache<T>::size() const {
+  absl::MutexLock lock(&mutex_);
+  return entries_.size();
+}
+
+RegexpCache::RegexpCache(int64_t capacity)
+    : utf8_regexps_(capacity),
+      bytes_regexps_(capacity),
+      string_like_matchers_(capacity),
+      bytes_like_matchers_(capacity) {
+  ABSL_CHECK_GT(capacity, 0);
+}
+
+RegexpCache& RegexpCache::Global() {
+  static RegexpCache* cache = new RegexpCache(kDefaultCapacity);
+  return *cache;
+}
+
+absl::StatusOr<std::shared_ptr<const functions::RegExp>> RegexpCache::GetRegExp(
+    absl::string_view pattern, TypeKind type) {
+  ZETASQL_RET_CHECK(type == TYPE_STRING || type == TYPE_BYTES);
+  if (type == TYPE_STRING) {
+    return utf8_regexps_.GetOrCompile(
+        pattern, [pattern]() { return functions::MakeRegExpUtf8(pattern); });
+  }
+  return bytes_regexps_.GetOrCompile(
+      pattern, [pattern]() { return functions::MakeRegExpBytes(pattern); });
+}
+
+absl::StatusOr<std::shared_ptr<const functions::LikeMatcher>>
+RegexpCache::GetLikeMatcher(absl::string_view pattern, TypeKind type) {
+  ZETASQL_RET_CHECK(type == TYPE_STRING || type == TYPE_BYTES);
+  auto compile = [pattern, type]() {
+    return functions::LikeMatcher::Create(pattern, type);
+  };
+  return type == TYPE_STRING
+             ? string_like_matchers_.GetOrCompile(pattern, compile)
+             : bytes_like_matchers_.GetOrCompile(pattern, compile);
+}
+
+int64_t RegexpCache::size() const {
+  return utf8_regexps_.size() + bytes_regexps_.size() +
+         string_like_matchers_.size() + bytes_like_matchers_.size();
+}
+
+}  // namespace zetasql
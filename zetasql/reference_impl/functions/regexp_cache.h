@@ -0,0 +1,109 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_REFERENCE_IMPL_FUNCTIONS_REGEXP_CACHE_H_
+#define ZETASQL_REFERENCE_IMPL_FUNCTIONS_REGEXP_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "zetasql/public/functions/like.h"
+#include "zetasql/public/functions/regexp.h"
+#include "zetasql/public/type.pb.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+
+namespace zetasql {
+
+// A bounded, thread-safe cache of compiled regular expressions for the
+// patterns of REGEXP_* functions and LIKE that are not constant, and so could
+// not be compiled when the function was prepared. It is shared by all
+// evaluations in the process, so that applying the same patterns (e.g., from
+// a table of rules) to many rows only compiles each of them once. Whenever
+// the cache is full, the least recently used pattern is evicted, but it stays
+// alive for as long as a caller still holds it. Patterns that fail to compile
+// are not cached.
+class RegexpCache {
+ public:
+  // The maximum number of patterns of each kind in Global().
+  static constexpr int64_t kDefaultCapacity = 4096;
+
+  // 'capacity' is the maximum number of patterns of each kind, and must be
+  // positive.
+  explicit RegexpCache(int64_t capacity);
+
+  RegexpCache(const RegexpCache&) = delete;
+  RegexpCache& operator=(const RegexpCache&) = delete;
+
+  // Returns the cache that is shared by the whole process.
+  static RegexpCache& Global();
+
+  // Returns the RegExp for a REGEXP_* pattern of type 'type', which must be
+  // TYPE_STRING or TYPE_BYTES, like MakeRegExpUtf8() or MakeRegExpBytes().
+  absl::StatusOr<std::shared_ptr<const functions::RegExp>> GetRegExp(
+      absl::string_view pattern, TypeKind type);
+
+  // Returns the matcher for a LIKE pattern of type 'type', which must be
+  // TYPE_STRING or TYPE_BYTES, like functions::LikeMatcher::Create().
+  absl::StatusOr<std::shared_ptr<const functions::LikeMatcher>> GetLikeMatcher(
+      absl::string_view pattern, TypeKind type);
+
+  // Returns the number of cached patterns of all kinds.
+  int64_t size() const;
+
+ private:
+  // A least-recently-used cache of compiled patterns of one kind.
+  template <typename T>
+  class LruCache {
+   public:
+    explicit LruCache(int64_t capacity) : capacity_(capacity) {}
+
+    // Returns the entry for 'pattern', calling 'compile' to add it if it is
+    // missing. 'mutex_' is not held while 'compile' runs, so that other
+    // threads can look up other patterns in the meantime.
+    absl::StatusOr<std::shared_ptr<const T>> GetOrCompile(
+        absl::string_view pattern,
+        absl::FunctionRef<absl::StatusOr<std::unique_ptr<const T>>()> compile);
+
+    int64_t size() const;
+
+   private:
+    using Entry = std::pair<std::string, std::shared_ptr<const T>>;
+
+    const int64_t capacity_;
+    mutable absl::Mutex mutex_;
+    // Most recently used first.
+    std::list<Entry> entries_ ABSL_GUARDED_BY(mutex_);
+    absl::flat_hash_map<std::string, typename std::list<Entry>::iterator>
+        index_ ABSL_GUARDED_BY(mutex_);
+  };
+
+  LruCache<functions::RegExp> utf8_regexps_;
+  LruCache<functions::RegExp> bytes_regexps_;
+  LruCache<functions::LikeMatcher> string_like_matchers_;
+  LruCache<functions::LikeMatcher> bytes_like_matchers_;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_REFERENCE_IMPL_FUNCTIONS_REGEXP_CACHE_H_
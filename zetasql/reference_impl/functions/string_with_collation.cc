@@ -27,6 +27,7 @@
 #include "zetasql/public/value.h"
 #include "zetasql/reference_impl/evaluation.h"
 #include "zetasql/reference_impl/function.h"
+#include "zetasql/reference_impl/functions/collator_cache.h"
 #include "zetasql/reference_impl/functions/like.h"
 #include "zetasql/reference_impl/tuple.h"
 #include "absl/status/statusor.h"
@@ -83,8 +84,8 @@ template <typename OutType, typename FunctionType, class... Args>
 bool InvokeWithCollation(FunctionType function, Value* result,
                          absl::Status* status, absl::string_view collation_name,
                          Args... args) {
-  absl::StatusOr<std::unique_ptr<const ZetaSqlCollator>> collator_or_status =
-      MakeSqlCollator(collation_name);
+  absl::StatusOr<std::shared_ptr<const ZetaSqlCollator>> collator_or_status =
+      CollatorCache::Global().GetCollator(collation_name);
   if (!collator_or_status.ok()) {
     *status = collator_or_status.status();
     return false;
@@ -101,8 +102,8 @@ template <typename FunctionType, class... Args>
 bool InvokeStringWithCollation(FunctionType function, Value* result,
                                absl::Status* status,
                                absl::string_view collation_name, Args... args) {
-  absl::StatusOr<std::unique_ptr<const ZetaSqlCollator>> collator_or_status =
-      MakeSqlCollator(collation_name);
+  absl::StatusOr<std::shared_ptr<const ZetaSqlCollator>> collator_or_status =
+      CollatorCache::Global().GetCollator(collation_name);
   if (!collator_or_status.ok()) {
     *status = collator_or_status.status();
     return false;
@@ -178,8 +179,8 @@ absl::StatusOr<Value> SplitWithCollationFunction::Eval(
   std::vector<absl::string_view> parts;
   std::vector<Value> values;
 
-  absl::StatusOr<std::unique_ptr<const ZetaSqlCollator>> collator_or_status =
-      MakeSqlCollator(args[0].string_value());
+  absl::StatusOr<std::shared_ptr<const ZetaSqlCollator>> collator_or_status =
+      CollatorCache::Global().GetCollator(args[0].string_value());
   if (!collator_or_status.ok()) {
     return collator_or_status.status();
   }
@@ -208,8 +209,8 @@ absl::StatusOr<Value> CollationKeyFunction::Eval(
     return Value::NullBytes();
   }
 
-  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<const ZetaSqlCollator> collator,
-                   MakeSqlCollator(args[1].string_value()));
+  ZETASQL_ASSIGN_OR_RETURN(std::shared_ptr<const ZetaSqlCollator> collator,
+                   CollatorCache::Global().GetCollator(args[1].string_value()));
   absl::Cord cord;
   ZETASQL_RETURN_IF_ERROR(collator->GetSortKeyUtf8(args[0].string_value(), &cord));
   return Value::Bytes(cord.Flatten());
@@ -0,0 +1,308 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/reference_impl/hll_sketch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/functions/hash.h"
+#include "zetasql/public/type.pb.h"
+#include "zetasql/public/value.h"
+#include "zetasql/base/check.h"
+#include "absl/algorithm/container.h"
+#include "absl/base/casts.h"
+#include "absl/log/log.h"
+#include "absl/numeric/bits.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "zetasql/base/endian.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+namespace {
+
+// The serialized form of a sketch is a header of kHeaderSize bytes:
+//   version, type kind, precision, representation
+// followed by the sorted hashes as little endian 64-bit integers for a sparse
+// sketch, or by the 2^precision registers for a dense one.
+constexpr uint8_t kVersion = 1;
+constexpr int kHeaderSize = 4;
+constexpr uint8_t kSparse = 0;
+constexpr uint8_t kDense = 1;
+
+absl::Status InvalidSketchError() {
+  return absl::OutOfRangeError("Invalid HLL++ sketch");
+}
+
+// Returns the hash of a value of a type for which HllSketch::SupportsType().
+uint64_t HashValue(const Value& value) {
+  std::string bytes;
+  switch (value.type_kind()) {
+    case TYPE_INT64:
+      bytes.resize(sizeof(int64_t));
+      zetasql_base::LittleEndian::Store64(
+          bytes.data(), absl::bit_cast<uint64_t>(value.int64_value()));
+      break;
+    case TYPE_UINT64:
+      bytes.resize(sizeof(uint64_t));
+      zetasql_base::LittleEndian::Store64(bytes.data(), value.uint64_value());
+      break;
+    case TYPE_NUMERIC:
+      bytes = value.numeric_value().SerializeAsProtoBytes();
+      break;
+    case TYPE_BIGNUMERIC:
+      bytes = value.bignumeric_value().SerializeAsProtoBytes();
+      break;
+    case TYPE_STRING:
+      return absl::bit_cast<uint64_t>(
+          functions::FarmFingerprint(value.string_value()));
+    case TYPE_BYTES:
+      return absl::bit_cast<uint64_t>(
+          functions::FarmFingerprint(value.bytes_value()));
+    default:
+      ABSL_LOG(FATAL) << "Unsupported type: " << value.type()->DebugString();
+  }
+  return absl::bit_cast<uint64_t>(functions::FarmFingerprint(bytes));
+}
+
+// Returns the largest value of a register at 'precision'.
+uint8_t MaxRegisterValue(int precision) { return 64 - precision + 1; }
+
+}  // namespace
+
+bool HllSketch::SupportsType(TypeKind type_kind) {
+  switch (type_kind) {
+    case TYPE_INT64:
+    case TYPE_UINT64:
+    case TYPE_NUMERIC:
+    case TYPE_BIGNUMERIC:
+    case TYPE_STRING:
+    case TYPE_BYTES:
+      return true;
+    default:
+      return false;
+  }
+}
+
+HllSketch::HllSketch(TypeKind type_kind, int precision)
+    : type_kind_(type_kind), precision_(precision) {
+  ABSL_DCHECK(SupportsType(type_kind));
+  ABSL_DCHECK_GE(precision, kMinPrecision);
+  ABSL_DCHECK_LE(precision, kMaxPrecision);
+}
+
+absl::StatusOr<HllSketch> HllSketch::Deserialize(absl::string_view bytes) {
+  if (bytes.size() < kHeaderSize ||
+      static_cast<uint8_t>(bytes[0]) != kVersion) {
+    return InvalidSketchError();
+  }
+  const TypeKind type_kind =
+      static_cast<TypeKind>(static_cast<uint8_t>(bytes[1]));
+  const int precision = static_cast<uint8_t>(bytes[2]);
+  if (!SupportsType(type_kind) || precision < kMinPrecision ||
+      precision > kMaxPrecision) {
+    return InvalidSketchError();
+  }
+  HllSketch sketch(type_kind, precision);
+  absl::string_view data = bytes.substr(kHeaderSize);
+  switch (static_cast<uint8_t>(bytes[3])) {
+    case kSparse: {
+      if (data.size() % sizeof(uint64_t) != 0 ||
+          data.size() / sizeof(uint64_t) > sketch.MaxSparseSize()) {
+        return InvalidSketchError();
+      }
+      sketch.sparse_hashes_.reserve(data.size() / sizeof(uint64_t));
+      uint64_t previous = 0;
+      for (size_t i = 0; i < data.size(); i += sizeof(uint64_t)) {
+        const uint64_t hash = zetasql_base::LittleEndian::Load64(&data[i]);
+        // The hashes are written in increasing order.
+        if (i > 0 && hash <= previous) {
+          return InvalidSketchError();
+        }
+        sketch.sparse_hashes_.insert(hash);
+        previous = hash;
+      }
+      break;
+    }
+    case kDense: {
+      if (data.size() != size_t{1} << precision) {
+        return InvalidSketchError();
+      }
+      sketch.registers_.assign(data.begin(), data.end());
+      const uint8_t max_value = MaxRegisterValue(precision);
+      if (absl::c_any_of(sketch.registers_,
+                         [max_value](uint8_t r) { return r > max_value; })) {
+        return InvalidSketchError();
+      }
+      break;
+    }
+    default:
+      return InvalidSketchError();
+  }
+  return sketch;
+}
+
+std::string HllSketch::Serialize() const {
+  std::string bytes;
+  bytes.push_back(kVersion);
+  bytes.push_back(static_cast<char>(type_kind_));
+  bytes.push_back(static_cast<char>(precision_));
+  if (registers_.empty()) {
+    bytes.push_back(kSparse);
+    std::vector<uint64_t> hashes(sparse_hashes_.begin(), sparse_hashes_.end());
+    std::sort(hashes.begin(), hashes.end());
+    bytes.resize(kHeaderSize + hashes.size() * sizeof(uint64_t));
+    char* out = &bytes[kHeaderSize];
+    for (const uint64_t hash : hashes) {
+      zetasql_base::LittleEndian::Store64(out, hash);
+      out += sizeof(uint64_t);
+    }
+  } else {
+    bytes.push_back(kDense);
+    bytes.append(registers_.begin(), registers_.end());
+  }
+  return bytes;
+}
+
+absl::Status HllSketch::Add(const Value& value) {
+  ZETASQL_RET_CHECK(!value.is_null());
+  ZETASQL_RET_CHECK_EQ(value.type_kind(), type_kind_);
+  AddHash(HashValue(value));
+  return absl::OkStatus();
+}
+
+void HllSketch::AddHash(uint64_t hash) {
+  if (!registers_.empty()) {
+    AddHashToRegisters(hash);
+    return;
+  }
+  sparse_hashes_.insert(hash);
+  if (sparse_hashes_.size() > MaxSparseSize()) {
+    ConvertToDense();
+  }
+}
+
+void HllSketch::AddHashToRegisters(uint64_t hash) {
+  const uint64_t index = hash >> (64 - precision_);
+  // The position of the first 1 in the bits after the index, or one past
+  // the last bit if they are all 0.
+  const uint8_t value = static_cast<uint8_t>(
+      std::min(absl::countl_zero(hash << precision_), 64 - precision_) + 1);
+  uint8_t& r = registers_[index];
+  r = std::max(r, value);
+}
+
+void HllSketch::ConvertToDense() {
+  registers_.assign(size_t{1} << precision_, 0);
+  for (const uint64_t hash : sparse_hashes_) {
+    AddHashToRegisters(hash);
+  }
+  sparse_hashes_ = absl::flat_hash_set<uint64_t>();
+}
+
+void HllSketch::DowngradeTo(int precision) {
+  ABSL_DCHECK_LT(precision, precision_);
+  const int shift = precision_ - precision;
+  precision_ = precision;
+  if (registers_.empty()) {
+    // The hashes do not depend on the precision, but fewer of them fit.
+    if (sparse_hashes_.size() > MaxSparseSize()) {
+      ConvertToDense();
+    }
+    return;
+  }
+  // The last 'shift' bits of an index become the first bits after the index
+  // at the lower precision.
+  std::vector<uint8_t> registers(size_t{1} << precision, 0);
+  const uint64_t low_bits_mask = (uint64_t{1} << shift) - 1;
+  for (uint64_t index = 0; index < registers_.size(); ++index) {
+    const uint8_t old_value = registers_[index];
+    if (old_value == 0) continue;
+    const uint64_t low_bits = index & low_bits_mask;
+    const uint8_t value =
+        low_bits == 0
+            ? old_value + shift
+            : static_cast<uint8_t>(shift - absl::bit_width(low_bits) + 1);
+    uint8_t& r = registers[index >> shift];
+    r = std::max(r, value);
+  }
+  registers_ = std::move(registers);
+}
+
+absl::Status HllSketch::Merge(const HllSketch& other) {
+  if (other.type_kind_ != type_kind_) {
+    return absl::OutOfRangeError("Cannot merge HLL++ sketches of other types");
+  }
+  if (other.precision_ < precision_) {
+    DowngradeTo(other.precision_);
+  }
+  if (other.precision_ > precision_) {
+    HllSketch downgraded = other;
+    downgraded.DowngradeTo(precision_);
+    return Merge(downgraded);
+  }
+  if (other.registers_.empty()) {
+    for (const uint64_t hash : other.sparse_hashes_) {
+      AddHash(hash);
+    }
+    return absl::OkStatus();
+  }
+  if (registers_.empty()) {
+    ConvertToDense();
+  }
+  // A plain loop over both arrays, which compilers vectorize.
+  uint8_t* registers = registers_.data();
+  const uint8_t* other_registers = other.registers_.data();
+  const size_t size = registers_.size();
+  for (size_t i = 0; i < size; ++i) {
+    registers[i] = std::max(registers[i], other_registers[i]);
+  }
+  return absl::OkStatus();
+}
+
+int64_t HllSketch::Estimate() const {
+  if (registers_.empty()) {
+    return static_cast<int64_t>(sparse_hashes_.size());
+  }
+  const double m = static_cast<double>(registers_.size());
+  double sum = 0;
+  int64_t num_zeros = 0;
+  for (const uint8_t r : registers_) {
+    sum += std::ldexp(1.0, -r);
+    num_zeros += r == 0;
+  }
+  const double alpha = 0.7213 / (1 + 1.079 / m);
+  double estimate = alpha * m * m / sum;
+  // Linear counting is more accurate for small cardinalities. 64-bit hashes
+  // need no correction for large ones.
+  if (estimate <= 2.5 * m && num_zeros > 0) {
+    estimate = m * std::log(m / static_cast<double>(num_zeros));
+  }
+  return std::llround(estimate);
+}
+
+int64_t HllSketch::GetEstimatedOwnedMemoryBytesSize() const {
+  return sizeof(HllSketch) + registers_.capacity() +
+         sparse_hashes_.capacity() * (sizeof(uint64_t) + 1);
+}
+
+}  // namespace zetasql
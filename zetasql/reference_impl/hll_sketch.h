@@ -0,0 +1,109 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_REFERENCE_IMPL_HLL_SKETCH_H_
+#define ZETASQL_REFERENCE_IMPL_HLL_SKETCH_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/type.pb.h"
+#include "zetasql/public/value.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace zetasql {
+
+// A HyperLogLog++ sketch of the distinct values of one type, for the
+// HLL_COUNT.* functions of the reference implementation.
+//
+// Like HLL++, a sketch starts out sparse: it keeps the 64-bit hashes of the
+// values it has seen, so small cardinalities are counted exactly. Once that
+// would take more space than the dense representation, it switches to an
+// array of 2^precision one-byte registers, which is what sketches are
+// merged with. Sketches of the same type but different precisions can be
+// merged; the result has the lower precision.
+//
+// Serialize() produces a compact encoding that Deserialize() accepts, so that
+// partial sketches can be stored as BYTES and merged later, e.g. by separate
+// shards. The encoding is specific to this implementation, and is not that of
+// any other engine.
+class HllSketch {
+ public:
+  static constexpr int kMinPrecision = 10;
+  static constexpr int kMaxPrecision = 24;
+  static constexpr int kDefaultPrecision = 15;
+
+  // Returns whether values of 'type_kind' can be added to a sketch.
+  static bool SupportsType(TypeKind type_kind);
+
+  // 'type_kind' must be supported, and 'precision' within [kMinPrecision,
+  // kMaxPrecision].
+  HllSketch(TypeKind type_kind, int precision);
+
+  // Parses a sketch returned by Serialize(). Returns an OutOfRange error if
+  // 'bytes' is not such a sketch.
+  static absl::StatusOr<HllSketch> Deserialize(absl::string_view bytes);
+
+  std::string Serialize() const;
+
+  TypeKind type_kind() const { return type_kind_; }
+  int precision() const { return precision_; }
+
+  // Adds 'value', which must be a non-NULL value of 'type_kind()'.
+  absl::Status Add(const Value& value);
+
+  // Merges 'other' into this sketch, as if the values added to 'other' had
+  // been added to this one. Returns an OutOfRange error if 'other' is a
+  // sketch of another type.
+  absl::Status Merge(const HllSketch& other);
+
+  // Returns the estimated number of distinct values added to the sketch.
+  int64_t Estimate() const;
+
+  // Returns the approximate number of bytes used by the sketch.
+  int64_t GetEstimatedOwnedMemoryBytesSize() const;
+
+ private:
+  // Adds a value with hash 'hash' to the sketch.
+  void AddHash(uint64_t hash);
+  void AddHashToRegisters(uint64_t hash);
+
+  // The largest number of hashes that are kept in 'sparse_hashes_', so that
+  // they take less space than 'registers_' would.
+  int64_t MaxSparseSize() const { return (int64_t{1} << precision_) / 8; }
+
+  void ConvertToDense();
+
+  // Lowers the precision of the sketch to 'precision'.
+  void DowngradeTo(int precision);
+
+  TypeKind type_kind_;
+  int precision_;
+  // The hashes of the distinct values, while the sketch is sparse.
+  absl::flat_hash_set<uint64_t> sparse_hashes_;
+  // The registers, indexed by the first 'precision_' bits of the hashes, once
+  // the sketch is dense. Each holds the largest position of the first 1 in
+  // the remaining bits of the hashes that go there, or 0 if there are none.
+  std::vector<uint8_t> registers_;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_REFERENCE_IMPL_HLL_SKETCH_H_
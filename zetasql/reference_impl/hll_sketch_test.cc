@@ -0,0 +1,119 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/reference_impl/hll_sketch.h"
+
+#include <cstdint>
+#include <string>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/type.pb.h"
+#include "zetasql/public/value.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+
+namespace zetasql {
+namespace {
+
+using ::zetasql_base::testing::IsOkAndHolds;
+using ::zetasql_base::testing::StatusIs;
+
+HllSketch MakeSketch(int64_t begin, int64_t end,
+                     int precision = HllSketch::kDefaultPrecision) {
+  HllSketch sketch(TYPE_INT64, precision);
+  for (int64_t i = begin; i < end; ++i) {
+    ZETASQL_EXPECT_OK(sketch.Add(Value::Int64(i)));
+  }
+  return sketch;
+}
+
+TEST(HllSketchTest, CountsSmallCardinalitiesExactly) {
+  HllSketch sketch(TYPE_STRING, HllSketch::kDefaultPrecision);
+  EXPECT_EQ(sketch.Estimate(), 0);
+  for (int i = 0; i < 3; ++i) {
+    ZETASQL_ASSERT_OK(sketch.Add(Value::String("a")));
+    ZETASQL_ASSERT_OK(sketch.Add(Value::String("b")));
+  }
+  EXPECT_EQ(sketch.Estimate(), 2);
+  EXPECT_EQ(MakeSketch(0, 1000).Estimate(), 1000);
+}
+
+TEST(HllSketchTest, EstimatesLargeCardinalities) {
+  for (int64_t count : {10000, 100000, 1000000}) {
+    const int64_t estimate = MakeSketch(0, count).Estimate();
+    EXPECT_NEAR(estimate, count, count * 0.03) << count;
+  }
+}
+
+TEST(HllSketchTest, SerializeRoundTrip) {
+  for (int64_t count : {0, 10, 100000}) {
+    const HllSketch sketch = MakeSketch(0, count);
+    ZETASQL_ASSERT_OK_AND_ASSIGN(HllSketch parsed,
+                         HllSketch::Deserialize(sketch.Serialize()));
+    EXPECT_EQ(parsed.type_kind(), TYPE_INT64);
+    EXPECT_EQ(parsed.precision(), HllSketch::kDefaultPrecision);
+    EXPECT_EQ(parsed.Estimate(), sketch.Estimate()) << count;
+    EXPECT_EQ(parsed.Serialize(), sketch.Serialize()) << count;
+  }
+}
+
+TEST(HllSketchTest, RejectsInvalidSketches) {
+  const std::string sparse = MakeSketch(0, 10).Serialize();
+  const std::string dense = MakeSketch(0, 100000).Serialize();
+  for (const std::string& bytes :
+       {std::string(), std::string("abc"),
+        // Truncated.
+        sparse.substr(0, sparse.size() - 1), dense.substr(0, dense.size() - 1),
+        // Unknown version.
+        std::string("\x02") + sparse.substr(1),
+        // Precision out of range.
+        sparse.substr(0, 2) + std::string("\x09") + sparse.substr(3)}) {
+    EXPECT_THAT(HllSketch::Deserialize(bytes),
+                StatusIs(absl::StatusCode::kOutOfRange));
+  }
+}
+
+TEST(HllSketchTest, MergeMatchesUnion) {
+  for (int64_t count : {100, 100000}) {
+    HllSketch left = MakeSketch(0, count);
+    ZETASQL_ASSERT_OK(left.Merge(MakeSketch(count / 2, count * 2)));
+    EXPECT_EQ(left.Serialize(), MakeSketch(0, count * 2).Serialize()) << count;
+  }
+}
+
+TEST(HllSketchTest, MergeLowersPrecision) {
+  HllSketch sketch = MakeSketch(0, 50000, /*precision=*/16);
+  ZETASQL_ASSERT_OK(sketch.Merge(MakeSketch(50000, 100000, /*precision=*/12)));
+  EXPECT_EQ(sketch.precision(), 12);
+  EXPECT_EQ(sketch.Serialize(),
+            MakeSketch(0, 100000, /*precision=*/12).Serialize());
+
+  HllSketch low = MakeSketch(0, 10, /*precision=*/12);
+  ZETASQL_ASSERT_OK(low.Merge(MakeSketch(0, 100000, /*precision=*/16)));
+  EXPECT_EQ(low.precision(), 12);
+  EXPECT_EQ(low.Serialize(),
+            MakeSketch(0, 100000, /*precision=*/12).Serialize());
+}
+
+TEST(HllSketchTest, MergeRejectsOtherTypes) {
+  HllSketch sketch = MakeSketch(0, 10);
+  EXPECT_THAT(sketch.Merge(HllSketch(TYPE_STRING, 15)),
+              StatusIs(absl::StatusCode::kOutOfRange));
+}
+
+}  // namespace
+}  // namespace zetasql
@@ -0,0 +1,120 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/reference_impl/join_key_filter.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "absl/hash/hash.h"
+#include "absl/numeric/bits.h"
+
+namespace zetasql {
+
+bool JoinKeyFilter::SupportsType(const Type* type) {
+  // Floating point types are excluded because Value equality differs from
+  // SQL equality for them (e.g., for NaN), and compound types because their
+  // keys are rarely selective.
+  switch (type->kind()) {
+    case TYPE_INT32:
+    case TYPE_INT64:
+    case TYPE_UINT32:
+    case TYPE_UINT64:
+    case TYPE_BOOL:
+    case TYPE_STRING:
+    case TYPE_BYTES:
+    case TYPE_DATE:
+    case TYPE_TIMESTAMP:
+    case TYPE_DATETIME:
+    case TYPE_TIME:
+    case TYPE_ENUM:
+    case TYPE_NUMERIC:
+    case TYPE_BIGNUMERIC:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void JoinKeyFilter::Add(const Value& key) {
+  if (key.is_null()) return;
+  if (is_exact()) {
+    exact_keys_.insert(key);
+    if (exact_keys_.size() > static_cast<size_t>(kMaxExactKeys)) {
+      ConvertToBloomFilter();
+    }
+    return;
+  }
+  AddHash(absl::HashOf(key));
+}
+
+bool JoinKeyFilter::MayContain(const Value& key) const {
+  if (key.is_null()) return false;
+  if (is_exact()) {
+    return exact_keys_.contains(key);
+  }
+  return HasHash(absl::HashOf(key));
+}
+
+std::unique_ptr<ColumnFilter> JoinKeyFilter::MakeColumnFilter() const {
+  if (!is_exact()) return nullptr;
+  const std::vector<Value> keys(exact_keys_.begin(), exact_keys_.end());
+  return std::make_unique<ColumnFilter>(keys);
+}
+
+// The bits of a hash are those at 'hash + i * delta' for i < kNumProbes, which
+// is double hashing as in Kirsch and Mitzenmacher.
+void JoinKeyFilter::AddHash(uint64_t hash) {
+  const uint64_t delta = (hash >> 32) | 1;
+  uint64_t bit = hash;
+  for (int i = 0; i < kNumProbes; ++i, bit += delta) {
+    const uint64_t index = bit & bloom_mask_;
+    bloom_bits_[index / 64] |= uint64_t{1} << (index % 64);
+  }
+}
+
+bool JoinKeyFilter::HasHash(uint64_t hash) const {
+  const uint64_t delta = (hash >> 32) | 1;
+  uint64_t bit = hash;
+  for (int i = 0; i < kNumProbes; ++i, bit += delta) {
+    const uint64_t index = bit & bloom_mask_;
+    if ((bloom_bits_[index / 64] & (uint64_t{1} << (index % 64))) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void JoinKeyFilter::ConvertToBloomFilter() {
+  const uint64_t num_keys = std::max<uint64_t>(
+      max_num_keys_, static_cast<uint64_t>(exact_keys_.size()));
+  const uint64_t num_bits =
+      std::max<uint64_t>(absl::bit_ceil(num_keys * kBitsPerKey), 64);
+  bloom_bits_.assign(num_bits / 64, 0);
+  bloom_mask_ = num_bits - 1;
+  for (const Value& key : exact_keys_) {
+    AddHash(absl::HashOf(key));
+  }
+  exact_keys_.clear();
+}
+
+}  // namespace zetasql
@@ -0,0 +1,89 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_REFERENCE_IMPL_JOIN_KEY_FILTER_H_
+#define ZETASQL_REFERENCE_IMPL_JOIN_KEY_FILTER_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "absl/container/flat_hash_set.h"
+
+namespace zetasql {
+
+// A filter on one join key of the build side of a hash join. The probe side
+// applies it while scanning its table, to discard the rows that cannot match
+// any build row before they go through the rest of the plan.
+//
+// MayContain() returns true for every key passed to Add(), and false for most
+// others. Up to kMaxExactKeys distinct keys are kept exactly; beyond that, the
+// filter becomes a Bloom filter over the hashes of the keys, with a false
+// positive rate of about 1%.
+//
+// Keys are matched with Value equality, like the hash table of the join, so
+// only types for which that agrees with SQL equality (see SupportsType()) can
+// be filtered.
+class JoinKeyFilter {
+ public:
+  static constexpr int kMaxExactKeys = 1024;
+
+  // Returns whether keys of 'type' can be filtered.
+  static bool SupportsType(const Type* type);
+
+  // 'max_num_keys' is an upper bound on the number of distinct keys that will
+  // be added, which sizes the Bloom filter.
+  explicit JoinKeyFilter(int64_t max_num_keys) : max_num_keys_(max_num_keys) {}
+
+  JoinKeyFilter(const JoinKeyFilter&) = delete;
+  JoinKeyFilter& operator=(const JoinKeyFilter&) = delete;
+
+  // Adds 'key'. NULL keys are ignored, since they never match.
+  void Add(const Value& key);
+
+  // Returns false if 'key' is NULL or was definitely not added.
+  bool MayContain(const Value& key) const;
+
+  // Returns a kInList ColumnFilter with the keys, for
+  // EvaluatorTableIterator::SetColumnFilterMap(), or nullptr if the filter is
+  // no longer exact.
+  std::unique_ptr<ColumnFilter> MakeColumnFilter() const;
+
+  bool is_exact() const { return bloom_bits_.empty(); }
+
+ private:
+  static constexpr int kBitsPerKey = 10;
+  static constexpr int kNumProbes = 7;
+
+  void AddHash(uint64_t hash);
+  bool HasHash(uint64_t hash) const;
+  void ConvertToBloomFilter();
+
+  const int64_t max_num_keys_;
+  // The keys, while the filter is exact.
+  absl::flat_hash_set<Value> exact_keys_;
+  // The bits of the Bloom filter, whose number is a power of 2, once the
+  // filter is not exact.
+  std::vector<uint64_t> bloom_bits_;
+  uint64_t bloom_mask_ = 0;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_REFERENCE_IMPL_JOIN_KEY_FILTER_H_
@@ -0,0 +1,83 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/reference_impl/join_key_filter.h"
+
+#include <cstdint>
+#include <memory>
+
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+
+namespace zetasql {
+namespace {
+
+using ::testing::UnorderedElementsAre;
+
+TEST(JoinKeyFilter, Exact) {
+  JoinKeyFilter filter(/*max_num_keys=*/4);
+  filter.Add(values::Int64(1));
+  filter.Add(values::Int64(3));
+  filter.Add(values::Int64(3));
+  filter.Add(values::NullInt64());
+  EXPECT_TRUE(filter.is_exact());
+  EXPECT_TRUE(filter.MayContain(values::Int64(1)));
+  EXPECT_TRUE(filter.MayContain(values::Int64(3)));
+  EXPECT_FALSE(filter.MayContain(values::Int64(2)));
+  EXPECT_FALSE(filter.MayContain(values::NullInt64()));
+
+  std::unique_ptr<ColumnFilter> column_filter = filter.MakeColumnFilter();
+  ASSERT_NE(column_filter, nullptr);
+  EXPECT_EQ(column_filter->kind(), ColumnFilter::kInList);
+  EXPECT_THAT(column_filter->in_list(),
+              UnorderedElementsAre(values::Int64(1), values::Int64(3)));
+}
+
+TEST(JoinKeyFilter, BloomFilter) {
+  constexpr int64_t kNumKeys = 10000;
+  JoinKeyFilter filter(kNumKeys);
+  for (int64_t i = 0; i < kNumKeys; ++i) {
+    filter.Add(values::String(absl::StrCat("key", 2 * i)));
+  }
+  EXPECT_FALSE(filter.is_exact());
+  EXPECT_EQ(filter.MakeColumnFilter(), nullptr);
+
+  int64_t num_false_positives = 0;
+  for (int64_t i = 0; i < kNumKeys; ++i) {
+    // No false negatives.
+    EXPECT_TRUE(filter.MayContain(values::String(absl::StrCat("key", 2 * i))));
+    if (filter.MayContain(values::String(absl::StrCat("key", 2 * i + 1)))) {
+      ++num_false_positives;
+    }
+  }
+  EXPECT_LT(num_false_positives, kNumKeys / 20);
+  EXPECT_FALSE(filter.MayContain(values::NullString()));
+}
+
+TEST(JoinKeyFilter, SupportsType) {
+  EXPECT_TRUE(JoinKeyFilter::SupportsType(types::Int64Type()));
+  EXPECT_TRUE(JoinKeyFilter::SupportsType(types::StringType()));
+  EXPECT_TRUE(JoinKeyFilter::SupportsType(types::DateType()));
+  EXPECT_FALSE(JoinKeyFilter::SupportsType(types::DoubleType()));
+  EXPECT_FALSE(JoinKeyFilter::SupportsType(types::Int64ArrayType()));
+}
+
+}  // namespace
+}  // namespace zetasql
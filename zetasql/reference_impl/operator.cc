@@ -45,6 +45,12 @@ AlgebraArg::AlgebraArg(const VariableId& variable,
 
 AlgebraArg::~AlgebraArg() = default;
 
+std::unique_ptr<AlgebraNode> AlgebraArg::ReplaceNode(
+    std::unique_ptr<AlgebraNode> node) {
+  std::swap(node_, node);
+  return node;
+}
+
 const ValueExpr* AlgebraArg::value_expr() const {
   return node() ? node()->AsValueExpr() : nullptr;
 }
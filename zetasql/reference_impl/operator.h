@@ -40,6 +40,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <optional>
@@ -54,6 +55,7 @@
 #include "zetasql/public/table_valued_function.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/value.h"
+#include "zetasql/reference_impl/columnar_batch.h"
 #include "zetasql/reference_impl/common.h"
 #include "zetasql/reference_impl/evaluation.h"
 #include "zetasql/reference_impl/tuple.h"
@@ -65,6 +67,7 @@
 #include "zetasql/resolved_ast/resolved_column.h"
 #include "zetasql/resolved_ast/resolved_node.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/container/node_hash_map.h"
 #include "absl/hash/hash.h"
 #include "zetasql/base/check.h"
@@ -116,6 +119,9 @@ class AlgebraArg {
   bool has_node() const { return node_ != nullptr; }
   const AlgebraNode* node() const { return node_.get(); }
   AlgebraNode* mutable_node() { return node_.get(); }
+  // Replaces the node of this argument with 'node' and returns the old one.
+  // Used to take algebrized plans apart (see plan_fragments.h).
+  std::unique_ptr<AlgebraNode> ReplaceNode(std::unique_ptr<AlgebraNode> node);
 
   bool has_variable() const { return variable_.is_valid(); }
   const VariableId& variable() const { return variable_; }
@@ -525,6 +531,13 @@ class WindowFrameArg final : public AlgebraArg {
   absl::Status SetSchemasForEvaluation(
       absl::Span<const TupleSchema* const> params_schemas);
 
+  // Returns true for ROWS BETWEEN UNBOUNDED PRECEDING AND CURRENT ROW, where
+  // the window of each row is the prefix of the partition that ends at it.
+  bool IsCumulative() const {
+    return window_frame_type_ == kRows && start_boundary_arg_->IsUnbounded() &&
+           end_boundary_arg_->IsCurrentRow();
+  }
+
   // Computes the window for each tuple in <partition> (which has TupleSchema
   // <schema>). <windows> stores the computed windows, which correspond 1:1 with
   // <partition>.  <order_keys> specifies the ordering keys and directions of
@@ -650,6 +663,28 @@ class AggregateArgAccumulator {
       bool inputs_in_defined_order) = 0;
 };
 
+// Accumulator for an aggregate over a window that slides forward over a
+// sequence of rows: rows enter at the end of the window and leave from its
+// front in the order they entered. Each step costs amortized O(1) instead of
+// re-aggregating the whole window.
+class SlidingWindowAccumulator {
+ public:
+  virtual ~SlidingWindowAccumulator() = default;
+
+  // Adds 'input_row' to the end of the window. On failure, returns false and
+  // populates 'status'. Does not return absl::Status for performance reasons.
+  virtual bool Add(const TupleData& input_row, absl::Status* status) = 0;
+
+  // Removes the row at the front of the window, which must not be empty.
+  virtual void RemoveFront() = 0;
+
+  // Removes all the rows from the window.
+  virtual void Reset() = 0;
+
+  // Returns the aggregate of the rows currently in the window.
+  virtual absl::StatusOr<Value> GetResult() = 0;
+};
+
 // Operator argument class used by AggregateOp for aggregated arguments.
 class AggregateArg final : public ExprArg {
  public:
@@ -691,6 +726,24 @@ class AggregateArg final : public ExprArg {
                                 absl::Span<const TupleData* const> params,
                                 EvaluationContext* context) const;
 
+  // Returns a SlidingWindowAccumulator for this aggregation, or NULL if it
+  // cannot be evaluated incrementally. Only COUNT, COUNTIF, MIN, MAX, and
+  // SUM and AVG over exact types are supported, and only without modifiers
+  // such as DISTINCT, ORDER BY or HAVING.
+  absl::StatusOr<std::unique_ptr<SlidingWindowAccumulator>>
+  CreateSlidingWindowAccumulator(absl::Span<const TupleData* const> params,
+                                 EvaluationContext* context) const;
+
+  // Returns an aggregate that populates 'variable()' by combining the values
+  // of this aggregate over disjoint parts of the input, which it reads from
+  // 'partial_variable', into its value over the whole input (e.g., SUM for
+  // COUNT). Returns NULL if there is no such aggregate. Only COUNT, COUNTIF,
+  // SUM, MIN, MAX, ANY_VALUE, LOGICAL_AND, LOGICAL_OR, BIT_AND, BIT_OR and
+  // BIT_XOR are supported, and only without modifiers such as DISTINCT,
+  // ORDER BY, HAVING or SAFE.
+  absl::StatusOr<std::unique_ptr<AggregateArg>> CreateFinalAggregate(
+      const VariableId& partial_variable) const;
+
   const AggregateFunctionCallExpr* aggregate_function() const;
 
   std::string DebugInternal(const std::string& indent,
@@ -767,6 +820,20 @@ class AggregateArg final : public ExprArg {
   const std::vector<ResolvedCollation> collation_list_;
 };
 
+// Computes the value of an AnalyticArg for each row of a partition as soon as
+// the row is read, without buffering the partition.
+class StreamingAnalyticArgEvaluator {
+ public:
+  virtual ~StreamingAnalyticArgEvaluator() = default;
+
+  // Populates 'value' with the value of the argument for 'row'.
+  // 'previous_row' is the row before 'row' in the same partition, or NULL if
+  // 'row' starts a new partition. On failure, returns false and populates
+  // 'status'.
+  virtual bool Eval(const TupleData* previous_row, const TupleData& row,
+                    Value* value, absl::Status* status) = 0;
+};
+
 // Abstract expression argument class that specifies an analytic function and
 // a window frame if available for AnalyticOp.
 class AnalyticArg : public ExprArg {
@@ -789,6 +856,16 @@ class AnalyticArg : public ExprArg {
                             EvaluationContext* context,
                             std::vector<Value>* values) const = 0;
 
+  // Returns an evaluator that computes this argument one row at a time, or
+  // NULL if the value for a row can depend on the rows after it. Must be
+  // called after SetSchemasForEvaluation().
+  virtual absl::StatusOr<std::unique_ptr<StreamingAnalyticArgEvaluator>>
+  CreateStreamingEvaluator(absl::Span<const KeyArg* const> order_keys,
+                           absl::Span<const TupleData* const> params,
+                           EvaluationContext* context) const {
+    return nullptr;
+  }
+
  protected:
   // Takes ownership of <window_frame>.
   AnalyticArg(const VariableId& variable, const Type* type,
@@ -829,6 +906,13 @@ class AggregateAnalyticArg final : public AnalyticArg {
                     EvaluationContext* context,
                     std::vector<Value>* values) const override;
 
+  // Supports cumulative windows (ROWS BETWEEN UNBOUNDED PRECEDING AND CURRENT
+  // ROW) over aggregates that support CreateSlidingWindowAccumulator().
+  absl::StatusOr<std::unique_ptr<StreamingAnalyticArgEvaluator>>
+  CreateStreamingEvaluator(absl::Span<const KeyArg* const> order_keys,
+                           absl::Span<const TupleData* const> params,
+                           EvaluationContext* context) const override;
+
   std::string DebugInternal(const std::string& indent,
                             bool verbose) const override;
 
@@ -872,6 +956,12 @@ class NonAggregateAnalyticArg final : public AnalyticArg {
                     EvaluationContext* context,
                     std::vector<Value>* values) const override;
 
+  // Supports ROW_NUMBER, RANK and DENSE_RANK.
+  absl::StatusOr<std::unique_ptr<StreamingAnalyticArgEvaluator>>
+  CreateStreamingEvaluator(absl::Span<const KeyArg* const> order_keys,
+                           absl::Span<const TupleData* const> params,
+                           EvaluationContext* context) const override;
+
   std::string DebugInternal(const std::string& indent,
                             bool verbose) const override;
 
@@ -1016,6 +1106,67 @@ class HalfUnboundedColumnFilterArg final : public ColumnFilterArg {
   std::unique_ptr<ValueExpr> arg_;
 };
 
+// Represents a ColumnFilter for <column> IS NULL.
+class IsNullColumnFilterArg final : public ColumnFilterArg {
+ public:
+  IsNullColumnFilterArg(const IsNullColumnFilterArg&) = delete;
+  IsNullColumnFilterArg& operator=(const IsNullColumnFilterArg&) = delete;
+
+  // 'variable' is the VariableId used for the column for debug
+  // logging. 'column_idx' is the index of the column in the scan (not the
+  // Table).
+  static absl::StatusOr<std::unique_ptr<IsNullColumnFilterArg>> Create(
+      const VariableId& variable, int column_idx);
+
+  absl::Status SetSchemasForEvaluation(
+      absl::Span<const TupleSchema* const> params_schemas) override;
+
+  absl::StatusOr<std::unique_ptr<ColumnFilter>> Eval(
+      absl::Span<const TupleData* const> params,
+      EvaluationContext* context) const override;
+
+  std::string DebugInternal(const std::string& indent,
+                            bool verbose) const override;
+
+ private:
+  IsNullColumnFilterArg(const VariableId& variable, int column_idx);
+
+  const VariableId variable_;
+};
+
+// Represents a ColumnFilter for <column> LIKE <pattern>, where <pattern> is a
+// STRING or BYTES expression. The filter is the prefix of the pattern up to its
+// first wildcard or escape character, which every matching value starts with.
+class PrefixColumnFilterArg final : public ColumnFilterArg {
+ public:
+  PrefixColumnFilterArg(const PrefixColumnFilterArg&) = delete;
+  PrefixColumnFilterArg& operator=(const PrefixColumnFilterArg&) = delete;
+
+  // 'variable' is the VariableId used for the column for debug
+  // logging. 'column_idx' is the index of the column in the scan (not the
+  // Table).
+  static absl::StatusOr<std::unique_ptr<PrefixColumnFilterArg>> Create(
+      const VariableId& variable, int column_idx,
+      std::unique_ptr<ValueExpr> pattern);
+
+  absl::Status SetSchemasForEvaluation(
+      absl::Span<const TupleSchema* const> params_schemas) override;
+
+  absl::StatusOr<std::unique_ptr<ColumnFilter>> Eval(
+      absl::Span<const TupleData* const> params,
+      EvaluationContext* context) const override;
+
+  std::string DebugInternal(const std::string& indent,
+                            bool verbose) const override;
+
+ private:
+  PrefixColumnFilterArg(const VariableId& variable, int column_idx,
+                        std::unique_ptr<ValueExpr> pattern);
+
+  const VariableId variable_;
+  std::unique_ptr<ValueExpr> pattern_;
+};
+
 // Abstract base class for an operator.
 class AlgebraNode {
  public:
@@ -1183,6 +1334,47 @@ class ValueExpr : public AlgebraNode {
   const Type* output_type_;
 };
 
+// Physical properties of the tuples produced by a RelationalOp, as derived by
+// RelationalOp::DeriveProperties(). They describe the order in which the
+// iterator returns tuples when EvaluationOptions::scramble_undefined_orderings
+// is false; operators that rely on them must not do so when scrambling.
+struct RelationalProperties {
+  struct OrderingKey {
+    // Returns the ordering that 'key' sorts 'variable' by.
+    static OrderingKey FromKeyArg(const VariableId& variable,
+                                  const KeyArg& key);
+
+    bool operator==(const OrderingKey& that) const {
+      return variable == that.variable && descending == that.descending &&
+             nulls_first == that.nulls_first;
+    }
+
+    VariableId variable;
+    bool descending = false;
+    // True if NULLs come before all other values.
+    bool nulls_first = true;
+  };
+
+  // Returns true if the tuples are sorted on 'keys', i.e., 'keys' is a prefix
+  // of 'ordering'.
+  bool IsOrderedBy(absl::Span<const OrderingKey> keys) const;
+
+  // Returns true if tuples with equal values of 'variables' are adjacent,
+  // i.e., the first 'variables.size()' keys of 'ordering' are 'variables' in
+  // some order and direction.
+  bool IsGroupedBy(absl::Span<const VariableId> variables) const;
+
+  // E.g., "ordering: [$a ASC NULLS FIRST, $b DESC NULLS LAST], unique: [$a]".
+  std::string DebugString() const;
+
+  // The tuples are sorted lexicographically on these keys. Empty if nothing is
+  // known about the order.
+  std::vector<OrderingKey> ordering;
+  // If non-empty, no two tuples have the same values for all of these
+  // variables.
+  std::vector<VariableId> unique_key;
+};
+
 // Abstract base class for relational operators.
 class RelationalOp : public AlgebraNode {
  public:
@@ -1212,9 +1404,12 @@ class RelationalOp : public AlgebraNode {
   // wraps it in a PassThroughTupleIterator to allow for cancellation while it
   // is running. This method is only public for internal purposes. Users should
   // call Eval() instead.
-  virtual absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
+  //
+  // If 'context' has an OperatorProfile, the iterator is wrapped to record the
+  // runtime statistics of this operator into it.
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
       absl::Span<const TupleData* const> params, int num_extra_slots,
-      EvaluationContext* context) const = 0;
+      EvaluationContext* context) const;
 
   // Returns a copy of the output schema of the TupleIterator corresponding to
   // this operator.
@@ -1243,7 +1438,20 @@ class RelationalOp : public AlgebraNode {
   // Relational operators typically do not preserve order.
   virtual bool may_preserve_order() const { return false; }
 
+  // Derives the properties of the output of this operator from those of its
+  // inputs. The default knows nothing about the output. Used by the
+  // algebrizer to avoid redundant work (e.g., sorting an input that is already
+  // sorted).
+  virtual RelationalProperties DeriveProperties() const {
+    return RelationalProperties();
+  }
+
  protected:
+  // Creates the iterator for CreateIterator(). Implemented by each operator.
+  virtual absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIteratorImpl(
+      absl::Span<const TupleData* const> params, int num_extra_slots,
+      EvaluationContext* context) const = 0;
+
   // Depending on the EvaluationOptions in 'context', either returns 'iter' or a
   // ReorderingTupleIterator that wraps 'iter'.
   absl::StatusOr<std::unique_ptr<TupleIterator>> MaybeReorder(
@@ -1280,10 +1488,48 @@ class EvaluatorTableScanOp final : public RelationalOp {
   static absl::StatusOr<std::unique_ptr<ColumnFilter>> IntersectColumnFilters(
       absl::Span<const std::unique_ptr<ColumnFilter>> filters);
 
+  // Evaluates 'and_filters' and returns the intersection of the ColumnFilters
+  // of each column, keyed on ColumnFilterArg::column_idx(). Also used by
+  // TVFOp.
+  static absl::StatusOr<absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>>>
+  EvalColumnFilterMap(
+      absl::Span<const std::unique_ptr<ColumnFilterArg>> and_filters,
+      absl::Span<const TupleData* const> params, EvaluationContext* context);
+
+  // Sets the indexes of the columns in the scan (not the Table) that are read
+  // by the query, which are passed to
+  // EvaluatorTableIterator::SetReferencedColumns(). If this is not called,
+  // every column may be read.
+  void set_referenced_columns(std::vector<int> referenced_columns) {
+    referenced_columns_ = std::move(referenced_columns);
+  }
+
+  const Table* table() const { return table_; }
+
+  // Makes the scan discard the rows whose value of 'variable', which must be
+  // one of the variables of the scan, is not in the JoinKeyFilter published
+  // with id 'filter_id' in the EvaluationContext (see
+  // JoinOp::SetJoinKeyFilters()) when the iterator is created. An exact
+  // filter is also passed to the EvaluatorTableIterator as a ColumnFilter.
+  absl::Status AddJoinKeyFilter(int filter_id, const VariableId& variable);
+
+  // Returns a new EvaluatorTableIterator over the table, with its read time,
+  // referenced columns and column filters already set.
+  using TableIteratorFactory = std::function<
+      absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>>()>;
+
+  // Evaluates the read time and the column filters of the scan for 'params'
+  // and returns a factory for iterators that use them. The factory does not
+  // touch 'context' and may outlive this call. Also used by UnionAllOp to read
+  // several tables at once.
+  absl::StatusOr<TableIteratorFactory> CreateTableIteratorFactory(
+      absl::Span<const TupleData* const> params,
+      EvaluationContext* context) const;
+
   absl::Status SetSchemasForEvaluation(
       absl::Span<const TupleSchema* const> params_schemas) override;
 
-  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIteratorImpl(
       absl::Span<const TupleData* const> params, int num_extra_slots,
       EvaluationContext* context) const override;
 
@@ -1311,7 +1557,75 @@ class EvaluatorTableScanOp final : public RelationalOp {
   const std::vector<std::string> column_names_;
   const std::vector<VariableId> variables_;
   std::vector<std::unique_ptr<ColumnFilterArg>> and_filters_;
+  // Returns the published JoinKeyFilters of 'join_key_filters_', with the
+  // index of the column in the scan that each one applies to.
+  std::vector<std::pair<int, std::shared_ptr<const JoinKeyFilter>>>
+  GetJoinKeyFilters(const EvaluationContext* context) const;
+
   std::unique_ptr<ValueExpr> read_time_;
+  std::optional<std::vector<int>> referenced_columns_;
+  // The ids of the JoinKeyFilters added by AddJoinKeyFilter(), with the index
+  // of the column in the scan that each one applies to.
+  std::vector<std::pair<int, int>> join_key_filters_;
+};
+
+// Receives the rows sent to the exchanges between the fragments of a plan
+// (see plan_fragments.h). Implemented by the engine that runs the fragments,
+// over its own transport.
+class ExchangeReceiver {
+ public:
+  virtual ~ExchangeReceiver() = default;
+
+  // Returns an iterator over the rows that all the senders of exchange
+  // 'exchange_id' have sent, in any order. The columns of the rows have
+  // 'column_types'. May be called several times if the ExchangeOp is
+  // evaluated several times.
+  virtual absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>> Receive(
+      int exchange_id, absl::Span<const Type* const> column_types) = 0;
+};
+
+// Produces the rows received from exchange 'exchange_id' through an
+// ExchangeReceiver, which must outlive the op.
+class ExchangeOp final : public RelationalOp {
+ public:
+  ExchangeOp(const ExchangeOp&) = delete;
+  ExchangeOp& operator=(const ExchangeOp&) = delete;
+
+  static std::string GetIteratorDebugString(int exchange_id);
+
+  // Each of 'columns' has a variable and a type, and no expression.
+  static absl::StatusOr<std::unique_ptr<ExchangeOp>> Create(
+      int exchange_id, std::vector<std::unique_ptr<ExprArg>> columns,
+      ExchangeReceiver* receiver);
+
+  absl::Status SetSchemasForEvaluation(
+      absl::Span<const TupleSchema* const> params_schemas) override;
+
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIteratorImpl(
+      absl::Span<const TupleData* const> params, int num_extra_slots,
+      EvaluationContext* context) const override;
+
+  // Returns the schema consisting of the variables of the 'columns' passed to
+  // Create().
+  std::unique_ptr<TupleSchema> CreateOutputSchema() const override;
+
+  std::string IteratorDebugString() const override;
+
+  std::string DebugInternal(const std::string& indent,
+                            bool verbose) const override;
+
+  int exchange_id() const { return exchange_id_; }
+
+ private:
+  enum ArgKind { kColumn };
+
+  ExchangeOp(int exchange_id, std::vector<std::unique_ptr<ExprArg>> columns,
+             ExchangeReceiver* receiver);
+
+  absl::Span<const ExprArg* const> columns() const;
+
+  const int exchange_id_;
+  ExchangeReceiver* const receiver_;
 };
 
 // Produces a relation from a TVF.
@@ -1346,16 +1660,21 @@ class TVFOp final : public RelationalOp {
     const Model* model;
   };
 
+  // 'and_filters' are ColumnFilterArgs on the columns at those indexes of
+  // 'output_columns'. They are passed to the EvaluatorTableIterator of the TVF,
+  // which may use them to avoid producing rows that would be filtered out
+  // later, but need not.
   static absl::StatusOr<std::unique_ptr<TVFOp>> Create(
       const TableValuedFunction* tvf, std::vector<TVFOpArgument> arguments,
       std::vector<TVFSchemaColumn> output_columns,
       std::vector<VariableId> variables,
-      std::shared_ptr<FunctionSignature> function_call_signature);
+      std::shared_ptr<FunctionSignature> function_call_signature,
+      std::vector<std::unique_ptr<ColumnFilterArg>> and_filters = {});
 
   absl::Status SetSchemasForEvaluation(
       absl::Span<const TupleSchema* const> params_schemas) override;
 
-  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIteratorImpl(
       absl::Span<const TupleData* const> params, int num_extra_slots,
       EvaluationContext* context) const override;
 
@@ -1368,7 +1687,8 @@ class TVFOp final : public RelationalOp {
   TVFOp(const TableValuedFunction* tvf, std::vector<TVFOpArgument> arguments,
         std::vector<TVFSchemaColumn> output_columns,
         std::vector<VariableId> variables,
-        std::shared_ptr<FunctionSignature> function_call_signature);
+        std::shared_ptr<FunctionSignature> function_call_signature,
+        std::vector<std::unique_ptr<ColumnFilterArg>> and_filters);
 
   // The invoked table valued function.
   const TableValuedFunction* tvf_;
@@ -1380,6 +1700,8 @@ class TVFOp final : public RelationalOp {
   const std::vector<VariableId> variables_;
   // Signature of the invocation. Set only if invocation is ambiguous.
   const std::shared_ptr<FunctionSignature> function_call_signature_;
+  // Filters on 'output_columns_' for the TVF to push down, if it can.
+  std::vector<std::unique_ptr<ColumnFilterArg>> and_filters_;
 };
 
 // Evaluates some expressions and makes them available to 'body'. Each
@@ -1400,7 +1722,7 @@ class LetOp final : public RelationalOp {
   absl::Status SetSchemasForEvaluation(
       absl::Span<const TupleSchema* const> params_schemas) override;
 
-  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIteratorImpl(
       absl::Span<const TupleData* const> params, int num_extra_slots,
       EvaluationContext* context) const override;
 
@@ -1455,6 +1777,17 @@ class LetOp final : public RelationalOp {
 // have correlated parameters; their inputs must be evaluated only once for
 // correctness. Correlated input of cross/outer apply may be evaluated multiple
 // times even if no correlated references are present.
+//
+// Semi join outputs each left tuple that joins with at least one right tuple,
+// and anti join outputs each left tuple that joins with none. Both pass
+// through the variables from the left and nothing else; 'left_outputs' and
+// 'right_outputs' must be empty. A left tuple is output at most once, and the
+// search for joining right tuples stops at the first one. The left tuples are
+// output in the order of the left input. Null-aware anti join implements
+// 'left_expr NOT IN (right_expr, ...)': it is an anti join with exactly one
+// hash join equality in which a NULL in either expression joins with every
+// tuple on the other side, since the resulting NOT IN is not TRUE either.
+// None of the three may have correlated parameters.
 class JoinOp final : public RelationalOp {
  public:
   enum JoinKind {
@@ -1463,7 +1796,10 @@ class JoinOp final : public RelationalOp {
     kRightOuterJoin,
     kFullOuterJoin,
     kCrossApply,
-    kOuterApply
+    kOuterApply,
+    kSemiJoin,
+    kAntiJoin,
+    kNullAwareAntiJoin
   };
 
   // Represents an equality in the join condition where one side is determined
@@ -1478,6 +1814,38 @@ class JoinOp final : public RelationalOp {
     std::unique_ptr<ExprArg> right_expr;
   };
 
+  // Represents a RANGE_OVERLAPS(left_expr, right_expr) or RANGE_CONTAINS() in
+  // the join condition, where one side is determined by the left-hand side of
+  // the join and the other side by the right-hand side (which must not be
+  // correlated). At most one of the two is a RANGE element instead of a RANGE,
+  // for RANGE_CONTAINS(<range>, <element>). If present (and there are no
+  // HashJoinEqualityExprs), the right-hand side is indexed by its ranges and
+  // each left tuple is only evaluated against the right tuples whose range
+  // overlaps (or contains, or is contained in) its own. The predicate itself
+  // must still be part of the remaining condition.
+  //
+  // RangeJoinExprs also represent <element> BETWEEN <lower> AND <upper>, where
+  // the element is determined by one side of the join and both bounds by the
+  // other. Then 'left_expr' or 'right_expr' is the lower bound, and the
+  // corresponding '*_upper_bound_expr' the upper bound. Both are NULL for
+  // RANGE_OVERLAPS() and RANGE_CONTAINS().
+  struct RangeJoinExprs {
+    std::unique_ptr<ExprArg> left_expr;
+    std::unique_ptr<ExprArg> right_expr;
+    std::unique_ptr<ExprArg> left_upper_bound_expr;
+    std::unique_ptr<ExprArg> right_upper_bound_expr;
+  };
+
+  // Asks the join to build a JoinKeyFilter from the right-hand side keys of
+  // HashJoinEqualityExprs number 'equality_index', and to publish it in the
+  // EvaluationContext under 'filter_id' while it creates the iterator of the
+  // left input. The EvaluatorTableScanOps of the left input that were given
+  // the same id with AddJoinKeyFilter() then skip the rows that cannot join.
+  struct JoinKeyFilterSpec {
+    int equality_index;
+    int filter_id;
+  };
+
   JoinOp(const JoinOp&) = delete;
   JoinOp& operator=(const JoinOp&) = delete;
 
@@ -1487,18 +1855,22 @@ class JoinOp final : public RelationalOp {
       JoinKind join_kind, absl::string_view left_input_debug_string,
       absl::string_view right_input_debug_string);
 
-  // 'equality_exprs' must be empty for cross/outer apply.
+  // 'equality_exprs' must be empty for cross/outer apply and must have exactly
+  // one element for null-aware anti join. 'range_join_exprs' must be absent
+  // for cross/outer apply and null-aware anti join, and if 'equality_exprs' is
+  // non-empty.
   static absl::StatusOr<std::unique_ptr<JoinOp>> Create(
       JoinKind kind, std::vector<HashJoinEqualityExprs> equality_exprs,
       std::unique_ptr<ValueExpr> remaining_condition,
       std::unique_ptr<RelationalOp> left, std::unique_ptr<RelationalOp> right,
       std::vector<std::unique_ptr<ExprArg>> left_outputs,
-      std::vector<std::unique_ptr<ExprArg>> right_outputs);
+      std::vector<std::unique_ptr<ExprArg>> right_outputs,
+      std::optional<RangeJoinExprs> range_join_exprs = std::nullopt);
 
   absl::Status SetSchemasForEvaluation(
       absl::Span<const TupleSchema* const> params_schemas) override;
 
-  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIteratorImpl(
       absl::Span<const TupleData* const> params, int num_extra_slots,
       EvaluationContext* context) const override;
 
@@ -1507,17 +1879,48 @@ class JoinOp final : public RelationalOp {
   // on the join kind as described in the class comment.
   std::unique_ptr<TupleSchema> CreateOutputSchema() const override;
 
+  // Semi and anti joins have the properties of the left input.
+  RelationalProperties DeriveProperties() const override;
+
   std::string IteratorDebugString() const override;
 
   std::string DebugInternal(const std::string& indent,
                             bool verbose) const override;
 
+  // Returns true for semi join, anti join and null-aware anti join.
+  static bool IsSemiOrAntiJoin(JoinKind kind);
+
+  JoinKind join_kind() const { return join_kind_; }
+
+  const RelationalOp* left_input() const;
+  const RelationalOp* right_input() const;
+
+  // Only allowed for an inner, semi or right outer join with
+  // HashJoinEqualityExprs, where dropping left tuples that match no right
+  // tuple does not change the result.
+  absl::Status SetJoinKeyFilters(
+      std::vector<JoinKeyFilterSpec> join_key_filters);
+
+  // Declares that both inputs are sorted on the HashJoinEqualityExprs, which
+  // are then merged instead of hashed. 'ordering' has one key per
+  // HashJoinEqualityExprs, in the same order, for the variables of the left
+  // input; the right input must be sorted in the same directions. The right
+  // input is checked when it is materialized, and the join falls back to a
+  // hash join if it is not sorted, or if undefined orderings are scrambled.
+  // Not allowed for null-aware anti join.
+  absl::Status SetMergeJoinOrdering(
+      std::vector<RelationalProperties::OrderingKey> ordering);
+
  private:
   enum ArgKind {
     kLeftOutput,
     kRightOutput,
     kHashJoinEqualityLeftExprs,
     kHashJoinEqualityRightExprs,
+    kRangeJoinLeftExpr,
+    kRangeJoinRightExpr,
+    kRangeJoinLeftUpperBoundExpr,
+    kRangeJoinRightUpperBoundExpr,
     kRemainingCondition,
     kLeftInput,
     kRightInput
@@ -1526,6 +1929,10 @@ class JoinOp final : public RelationalOp {
   JoinOp(JoinKind kind,
          std::vector<std::unique_ptr<ExprArg>> hash_join_equality_left_exprs,
          std::vector<std::unique_ptr<ExprArg>> hash_join_equality_right_exprs,
+         std::vector<std::unique_ptr<ExprArg>> range_join_left_expr,
+         std::vector<std::unique_ptr<ExprArg>> range_join_right_expr,
+         std::vector<std::unique_ptr<ExprArg>> range_join_left_upper_bound_expr,
+         std::vector<std::unique_ptr<ExprArg>> range_join_right_upper_bound_expr,
          std::unique_ptr<ValueExpr> remaining_condition,
          std::unique_ptr<RelationalOp> left,
          std::unique_ptr<RelationalOp> right,
@@ -1538,13 +1945,21 @@ class JoinOp final : public RelationalOp {
   absl::Span<const ExprArg* const> hash_join_equality_right_exprs() const;
   absl::Span<ExprArg* const> mutable_hash_join_equality_right_exprs();
 
+  // Returns NULL if there are no RangeJoinExprs.
+  const ExprArg* range_join_left_expr() const;
+  ExprArg* mutable_range_join_left_expr();
+  const ExprArg* range_join_right_expr() const;
+  ExprArg* mutable_range_join_right_expr();
+  // Return NULL unless the RangeJoinExprs represent a BETWEEN.
+  const ExprArg* range_join_left_upper_bound_expr() const;
+  ExprArg* mutable_range_join_left_upper_bound_expr();
+  const ExprArg* range_join_right_upper_bound_expr() const;
+  ExprArg* mutable_range_join_right_upper_bound_expr();
+
   const ValueExpr* remaining_join_expr() const;
   ValueExpr* mutable_remaining_join_expr();
 
-  const RelationalOp* left_input() const;
   RelationalOp* mutable_left_input();
-
-  const RelationalOp* right_input() const;
   RelationalOp* mutable_right_input();
 
   absl::Span<const ExprArg* const> left_outputs() const;
@@ -1554,6 +1969,9 @@ class JoinOp final : public RelationalOp {
   absl::Span<ExprArg* const> mutable_right_outputs();
 
   const JoinKind join_kind_;
+  std::vector<JoinKeyFilterSpec> join_key_filters_;
+  // Set by SetMergeJoinOrdering(). Empty for a hash join.
+  std::vector<RelationalProperties::OrderingKey> merge_join_ordering_;
 };
 
 // Partitions the input using 'keys' and returns tuples constructed from
@@ -1582,7 +2000,7 @@ class AggregateOp final : public RelationalOp {
   absl::Status SetSchemasForEvaluation(
       absl::Span<const TupleSchema* const> params_schemas) override;
 
-  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIteratorImpl(
       absl::Span<const TupleData* const> params, int num_extra_slots,
       EvaluationContext* context) const override;
 
@@ -1595,6 +2013,60 @@ class AggregateOp final : public RelationalOp {
   std::string DebugInternal(const std::string& indent,
                             bool verbose) const override;
 
+  // Declares that rows of the input with equal keys are adjacent (e.g., the
+  // input is sorted on the keys). The iterator then aggregates in a streaming
+  // fashion: each group is returned as soon as the next one starts, and only
+  // the accumulators of the current group are held in memory. Groups come out
+  // in input order. Has no effect with grouping sets, GROUPING() calls, a
+  // pivot or without keys.
+  void set_input_is_grouped_by_keys(bool input_is_grouped_by_keys) {
+    input_is_grouped_by_keys_ = input_is_grouped_by_keys;
+  }
+  bool input_is_grouped_by_keys() const { return input_is_grouped_by_keys_; }
+
+  // Evaluates a PIVOT: aggregator 'i' only accumulates the input rows whose
+  // value of 'pivot_variable' is not distinct from the value of
+  // 'pivot_values[pivot_value_indexes[i]]'. Each input row is dispatched to
+  // its aggregators with one hash lookup, instead of evaluating a filter per
+  // aggregator and pivot value. 'pivot_values' are constant expressions
+  // (e.g., literals and parameters), which are evaluated once per iteration,
+  // of a type that SupportsPivotDispatch(). Requires no grouping sets.
+  absl::Status SetPivot(const VariableId& pivot_variable,
+                        std::vector<std::unique_ptr<ValueExpr>> pivot_values,
+                        std::vector<int> pivot_value_indexes);
+
+  // True if two non-NULL Values of 'type' are equal if and only if they are
+  // not distinct, so that SetPivot() can look them up by Value.
+  static bool SupportsPivotDispatch(const Type* type);
+
+  // True if the grouping sets include the finest one (their union, as with
+  // ROLLUP and CUBE) and every aggregator has a final aggregate (see
+  // AggregateArg::CreateFinalAggregate()) or is a GROUPING() call. The input
+  // is then only aggregated by the finest grouping set, and the groups of the
+  // other grouping sets are aggregated from the finest groups, so the work
+  // per input row does not grow with the number of grouping sets. Set by
+  // SetSchemasForEvaluation().
+  bool derives_grouping_sets() const { return derives_grouping_sets_; }
+
+  // The output is unique on the keys (without grouping sets). It is sorted
+  // on them too, either by the final sort of the hash-based path or because
+  // the streaming path keeps the order of an input sorted on the keys.
+  RelationalProperties DeriveProperties() const override;
+
+  // Returns the types of the variables of CreateOutputSchema().
+  std::vector<const Type*> GetOutputTypes() const;
+
+  // Returns the final phase of a two-phase aggregation, in which this op is
+  // the partial phase that runs on each shard of the input. The returned op
+  // reads the partial rows of all the shards from 'input', which has a
+  // variable in 'input_variables' for each variable of CreateOutputSchema(),
+  // and produces the output of this op over the whole input. Returns NULL if
+  // there are grouping sets or a pivot, or an aggregator has no final
+  // aggregate (see AggregateArg::CreateFinalAggregate()).
+  absl::StatusOr<std::unique_ptr<AggregateOp>> CreateFinalAggregate(
+      std::unique_ptr<RelationalOp> input,
+      absl::Span<const VariableId> input_variables) const;
+
  private:
   enum ArgKind { kKey, kAggregator, kInput };
 
@@ -1614,11 +2086,44 @@ class AggregateOp final : public RelationalOp {
 
   absl::Span<const int64_t> grouping_sets() const;
 
+  // True if the input is aggregated by StreamingAggregateTupleIterator (see
+  // set_input_is_grouped_by_keys()).
+  bool UsesStreamingPath() const;
+
+  // Returns the groups of every grouping set, given the groups of the finest
+  // one in 'finest_groups', when derives_grouping_sets(). The tuples of both
+  // have the keys, the grouping set offset and the aggregators, in that
+  // order, followed by 'num_extra_slots' slots.
+  absl::StatusOr<std::unique_ptr<TupleDataDeque>> DeriveGroupingSets(
+      absl::Span<const TupleData* const> params,
+      std::unique_ptr<TupleDataDeque> finest_groups, int num_extra_slots,
+      EvaluationContext* context) const;
+
   // Grouping sets stored using bit per "group by key", this also includes
   // grouping sets expanded from rollup or cube.
   // The least significant bit is for the first key, and so on. It means there
   // is no grouping sets when the vector is empty.
   std::vector<int64_t> grouping_sets_;
+
+  bool input_is_grouped_by_keys_ = false;
+
+  bool derives_grouping_sets_ = false;
+  // When derives_grouping_sets(), the union of 'grouping_sets_' and, for each
+  // aggregator, the final aggregate that combines its values over the finest
+  // groups, or NULL for GROUPING() calls.
+  int64_t finest_grouping_set_ = 0;
+  std::vector<std::unique_ptr<AggregateArg>> rollup_aggregators_;
+
+  // Set by SetPivot().
+  struct Pivot {
+    VariableId variable;
+    std::vector<std::unique_ptr<ValueExpr>> values;
+    std::vector<int> value_indexes;
+    // The slot of 'variable' in the input tuples. Set by
+    // SetSchemasForEvaluation().
+    int slot = -1;
+  };
+  std::unique_ptr<Pivot> pivot_;
 };
 
 // Represents scan operator for returning all rows corresponding to the current
@@ -1637,7 +2142,7 @@ class GroupRowsOp : public RelationalOp {
   absl::Status SetSchemasForEvaluation(
       absl::Span<const TupleSchema* const> params_schemas) override;
 
-  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIteratorImpl(
       absl::Span<const TupleData* const> params, int num_extra_slots,
       EvaluationContext* context) const override;
 
@@ -1675,7 +2180,7 @@ class RowsForUdaOp : public RelationalOp {
   absl::Status SetSchemasForEvaluation(
       absl::Span<const TupleSchema* const> params_schemas) override;
 
-  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIteratorImpl(
       absl::Span<const TupleData* const> params, int num_extra_slots,
       EvaluationContext* context) const override;
 
@@ -1724,7 +2229,7 @@ class AnalyticOp final : public RelationalOp {
   absl::Status SetSchemasForEvaluation(
       absl::Span<const TupleSchema* const> params_schemas) override;
 
-  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIteratorImpl(
       absl::Span<const TupleData* const> params, int num_extra_slots,
       EvaluationContext* context) const override;
 
@@ -1791,7 +2296,7 @@ class SortOp final : public RelationalOp {
   absl::Status SetSchemasForEvaluation(
       absl::Span<const TupleSchema* const> params_schemas) override;
 
-  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIteratorImpl(
       absl::Span<const TupleData* const> params, int num_extra_slots,
       EvaluationContext* context) const override;
 
@@ -1805,6 +2310,18 @@ class SortOp final : public RelationalOp {
 
   bool may_preserve_order() const override { return true; }
 
+  RelationalProperties DeriveProperties() const override;
+
+  // Declares that the input already arrives sorted on the keys, so the
+  // iterator can return the rows as they are read (applying the limit and
+  // offset, if any) instead of buffering and sorting them. Ignored when
+  // scrambling undefined orderings, so that tests still see every valid
+  // order.
+  void set_input_is_sorted(bool input_is_sorted) {
+    input_is_sorted_ = input_is_sorted;
+  }
+  bool input_is_sorted() const { return input_is_sorted_; }
+
  private:
   enum ArgKind { kKey, kValue, kLimit, kOffset, kInput };
 
@@ -1833,6 +2350,7 @@ class SortOp final : public RelationalOp {
   const bool has_limit_;
   const bool has_offset_;
   const bool is_stable_sort_;
+  bool input_is_sorted_ = false;
 };
 
 // Scans (or unnests) `arrays` as a relation. Each output tuple contains
@@ -1888,7 +2406,7 @@ class ArrayScanOp final : public RelationalOp {
   absl::Status SetSchemasForEvaluation(
       absl::Span<const TupleSchema* const> params_schemas) override;
 
-  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIteratorImpl(
       absl::Span<const TupleData* const> params, int num_extra_slots,
       EvaluationContext* context) const override;
 
@@ -1931,6 +2449,63 @@ class ArrayScanOp final : public RelationalOp {
   const ValueExpr* zip_mode_expr() const;
 };
 
+// Scans the elements of a GENERATE_ARRAY, GENERATE_DATE_ARRAY or
+// GENERATE_TIMESTAMP_ARRAY call one at a time as they are generated, instead
+// of evaluating the whole array and scanning it with an ArrayScanOp. This
+// takes constant memory, so the limits on the number of elements and the
+// size of generated arrays do not apply.
+class GenerateArrayScanOp final : public RelationalOp {
+ public:
+  GenerateArrayScanOp(const GenerateArrayScanOp&) = delete;
+  GenerateArrayScanOp& operator=(const GenerateArrayScanOp&) = delete;
+
+  static std::string GetIteratorDebugString(
+      absl::string_view arguments_debug_string);
+
+  // Returns true if the elements of an array of 'element_type' can be
+  // generated by this operator.
+  static bool SupportsElementType(const Type* element_type);
+
+  // `arguments` are the arguments of the generating function call: the start
+  // and end of the array, optionally followed by the step and, for dates and
+  // timestamps, the date part of the step. `element` and `position` may be
+  // invalid if the scan does not output them.
+  static absl::StatusOr<std::unique_ptr<GenerateArrayScanOp>> Create(
+      const VariableId& element, const VariableId& position,
+      const Type* element_type,
+      std::vector<std::unique_ptr<ValueExpr>> arguments);
+
+  absl::Status SetSchemasForEvaluation(
+      absl::Span<const TupleSchema* const> params_schemas) override;
+
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIteratorImpl(
+      absl::Span<const TupleData* const> params, int num_extra_slots,
+      EvaluationContext* context) const override;
+
+  // Returns the schema consisting of `element` followed by `position`, if
+  // they are valid.
+  std::unique_ptr<TupleSchema> CreateOutputSchema() const override;
+
+  std::string IteratorDebugString() const override;
+
+  std::string DebugInternal(const std::string& indent,
+                            bool verbose) const override;
+
+ private:
+  enum ArgKind { kElement, kPosition, kArgument };
+
+  GenerateArrayScanOp(const VariableId& element, const VariableId& position,
+                      const Type* element_type,
+                      std::vector<std::unique_ptr<ExprArg>> arguments);
+
+  const VariableId& element() const;   // May be empty, i.e., unused.
+  const VariableId& position() const;  // May be empty, i.e., unused.
+  absl::Span<const ExprArg* const> argument_list() const;
+  absl::Span<ExprArg* const> mutable_argument_list();
+
+  const Type* element_type_;
+};
+
 // Evaluates a set of keys for each row produced by an input iterator.
 // Emits a tuple for each key-set which is unique across all DistinctOp
 // evaluations made using the same DistinctScope.
@@ -1962,7 +2537,7 @@ class DistinctOp final : public RelationalOp {
   absl::Status SetSchemasForEvaluation(
       absl::Span<const TupleSchema* const> params_schemas) override;
 
-  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIteratorImpl(
       absl::Span<const TupleData* const> params, int num_extra_slots,
       EvaluationContext* context) const override;
 
@@ -1992,6 +2567,10 @@ class DistinctOp final : public RelationalOp {
 // constructed by evaluating M value operators. (The resolved AST allows for
 // union operations to arbitrarily remap the columns in an underlying scan,
 // although there may not be syntax to fully exploit that generality.)
+//
+// If every input is an EvaluatorTableScanOp and EvaluationOptions::num_threads
+// is greater than one, the tables are read concurrently and their rows are
+// interleaved in the output.
 class UnionAllOp final : public RelationalOp {
  public:
   UnionAllOp(const UnionAllOp&) = delete;
@@ -2009,7 +2588,7 @@ class UnionAllOp final : public RelationalOp {
   absl::Status SetSchemasForEvaluation(
       absl::Span<const TupleSchema* const> params_schemas) override;
 
-  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIteratorImpl(
       absl::Span<const TupleData* const> params, int num_extra_slots,
       EvaluationContext* context) const override;
 
@@ -2048,6 +2627,8 @@ class UnionAllOp final : public RelationalOp {
 // iteration, the assignments in <loop_assign> are executed.
 //
 // Variables are available in an expressions and in the body, once initialized.
+// The memory of their values is charged to the MemoryAccountant of the
+// evaluation until they are reassigned.
 //
 // In pseudo-code, the behavior of iterating through a LoopOp is as follows:
 //
@@ -2079,7 +2660,7 @@ class LoopOp final : public RelationalOp {
   absl::Status SetSchemasForEvaluation(
       absl::Span<const TupleSchema* const> params_schemas) override;
 
-  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIteratorImpl(
       absl::Span<const TupleData* const> params, int num_extra_slots,
       EvaluationContext* context) const override;
 
@@ -2143,7 +2724,7 @@ class ComputeOp final : public RelationalOp {
   absl::Status SetSchemasForEvaluation(
       absl::Span<const TupleSchema* const> params_schemas) override;
 
-  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIteratorImpl(
       absl::Span<const TupleData* const> params, int num_extra_slots,
       EvaluationContext* context) const override;
 
@@ -2156,6 +2737,9 @@ class ComputeOp final : public RelationalOp {
   std::string DebugInternal(const std::string& indent,
                             bool verbose) const override;
 
+  // Passes through the properties of the input.
+  RelationalProperties DeriveProperties() const override;
+
  private:
   enum ArgKind { kMap, kInput };
 
@@ -2185,7 +2769,7 @@ class FilterOp final : public RelationalOp {
   absl::Status SetSchemasForEvaluation(
       absl::Span<const TupleSchema* const> params_schemas) override;
 
-  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIteratorImpl(
       absl::Span<const TupleData* const> params, int num_extra_slots,
       EvaluationContext* context) const override;
 
@@ -2197,6 +2781,9 @@ class FilterOp final : public RelationalOp {
   std::string DebugInternal(const std::string& indent,
                             bool verbose) const override;
 
+  // Passes through the properties of the input.
+  RelationalProperties DeriveProperties() const override;
+
  private:
   enum ArgKind { kPredicate, kInput };
 
@@ -2227,7 +2814,7 @@ class LimitOp final : public RelationalOp {
   absl::Status SetSchemasForEvaluation(
       absl::Span<const TupleSchema* const> params_schemas) override;
 
-  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIteratorImpl(
       absl::Span<const TupleData* const> params, int num_extra_slots,
       EvaluationContext* context) const override;
 
@@ -2241,6 +2828,9 @@ class LimitOp final : public RelationalOp {
 
   bool may_preserve_order() const override { return true; }
 
+  // Passes through the properties of the input.
+  RelationalProperties DeriveProperties() const override;
+
  private:
   enum ArgKind { kRowCount, kOffset, kInput };
 
@@ -2267,8 +2857,15 @@ class SampleScanOp final : public RelationalOp {
     // Filter using bernoulli sampling. 'size' is a percentage in the range
     // [0, 100].
     kBernoulliPercent,
+    // Like kBernoulliPercent, but if the input is an EvaluatorTableScanOp
+    // whose iterator supports SetRowRange(), keeps or skips whole blocks of
+    // consecutive rows, and does not read the skipped blocks.
+    kSystemPercent,
     // Filter using reservoir sampling. 'size' is the number of rows and must
-    // be >= 0.
+    // be >= 0. Without a partition key, an EvaluatorTableScanOp input whose
+    // iterator supports SetRowRange() is sampled a morsel at a time, on up to
+    // EvaluationOptions::num_threads threads, and the morsels' reservoirs are
+    // merged.
     kReservoirRows
   };
 
@@ -2288,7 +2885,7 @@ class SampleScanOp final : public RelationalOp {
   absl::Status SetSchemasForEvaluation(
       absl::Span<const TupleSchema* const> params_schemas) override;
 
-  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIteratorImpl(
       absl::Span<const TupleData* const> params, int num_extra_slots,
       EvaluationContext* context) const override;
 
@@ -2354,7 +2951,7 @@ class EnumerateOp final : public RelationalOp {
   absl::Status SetSchemasForEvaluation(
       absl::Span<const TupleSchema* const> params_schemas) override;
 
-  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIteratorImpl(
       absl::Span<const TupleData* const> params, int num_extra_slots,
       EvaluationContext* context) const override;
 
@@ -2872,6 +3469,45 @@ class ExistsExpr final : public ValueExpr {
   RelationalOp* mutable_input();
 };
 
+// Evaluates 'subquery' (e.g., an ExistsExpr, SingleValueExpr or ArrayNestExpr)
+// at most once per statement for each combination of values of
+// 'correlated_variables', using EvaluationContext::subquery_result_cache().
+// The algebrizer only creates this node for subqueries whose result is
+// determined by the values of those variables.
+class MemoizedSubqueryExpr final : public ValueExpr {
+ public:
+  MemoizedSubqueryExpr(const MemoizedSubqueryExpr&) = delete;
+  MemoizedSubqueryExpr& operator=(const MemoizedSubqueryExpr&) = delete;
+
+  static absl::StatusOr<std::unique_ptr<MemoizedSubqueryExpr>> Create(
+      std::vector<VariableId> correlated_variables,
+      std::unique_ptr<ValueExpr> subquery);
+
+  absl::Status SetSchemasForEvaluation(
+      absl::Span<const TupleSchema* const> params_schemas) override;
+
+  bool Eval(absl::Span<const TupleData* const> params,
+            EvaluationContext* context, VirtualTupleSlot* result,
+            absl::Status* status) const override;
+
+  std::string DebugInternal(const std::string& indent,
+                            bool verbose) const override;
+
+ private:
+  enum ArgKind { kSubquery };
+
+  MemoizedSubqueryExpr(std::vector<VariableId> correlated_variables,
+                       std::unique_ptr<ValueExpr> subquery);
+
+  const ValueExpr* subquery() const;
+  ValueExpr* mutable_subquery();
+
+  const std::vector<VariableId> correlated_variables_;
+  // The index in 'params' and the slot of each of 'correlated_variables_'.
+  // Set by SetSchemasForEvaluation().
+  std::vector<std::pair<int, int>> correlated_slots_;
+};
+
 // Defines an executable function.
 class FunctionBody {
  public:
@@ -2951,12 +3587,76 @@ class AggregateAccumulator {
   virtual bool Accumulate(const Value& value, bool* stop_accumulation,
                           absl::Status* status) = 0;
 
+  // Batch form of Accumulate(). Accumulates each of 'values' in order, until
+  // 'stop_accumulation' is set. Accumulators of simple aggregates override
+  // this to avoid a virtual call and a dispatch on the function per value.
+  virtual bool AccumulateBatch(absl::Span<const Value> values,
+                               bool* stop_accumulation,
+                               absl::Status* status) {
+    *stop_accumulation = false;
+    for (const Value& value : values) {
+      if (!Accumulate(value, stop_accumulation, status)) return false;
+      if (*stop_accumulation) break;
+    }
+    return true;
+  }
+
+  // Columnar form of AccumulateBatch(), for a 'column' of the input type of
+  // the aggregate. Accumulators of simple aggregates override this to run a
+  // tight loop over the value array of 'column'.
+  virtual bool AccumulateColumn(const TupleColumn& column,
+                                bool* stop_accumulation,
+                                absl::Status* status) {
+    *stop_accumulation = false;
+    for (int i = 0; i < column.size(); ++i) {
+      if (!Accumulate(column.GetValue(i), stop_accumulation, status)) {
+        return false;
+      }
+      if (*stop_accumulation) break;
+    }
+    return true;
+  }
+
   // Returns the final result of the accumulation. 'inputs_in_defined_order'
   // should be true if the order that values wered passed to Accumulate() was
   // defined by ZetaSQL semantics. The value of 'inputs_in_defined_order' is
   // only important if we are doing compliance or random query testing.
   virtual absl::StatusOr<Value> GetFinalResult(
       bool inputs_in_defined_order) = 0;
+
+  // Returns true if this accumulator implements Merge().
+  virtual bool SupportsMerge() const { return false; }
+
+  // Merges the partial accumulation in 'other' into this one, so that
+  // GetFinalResult() returns what it would have returned if the values passed
+  // to 'other' had been passed to this accumulator after its own. 'other' must
+  // have been created by the same AggregateFunctionBody with the same
+  // arguments. It is left in an unspecified state and must be Reset() before
+  // it is used again. This allows the input to be partitioned (e.g., per
+  // thread or per morsel) and the partial results combined.
+  virtual absl::Status Merge(AggregateAccumulator* other) {
+    return absl::UnimplementedError(
+        "AggregateAccumulator::Merge() is not implemented");
+  }
+
+  // Returns the partial accumulation as bytes, which
+  // MergeSerializedPartialState() of an accumulator of the same
+  // AggregateFunctionBody and arguments merges like Merge() does, possibly in
+  // another process. Merging into a newly Reset() accumulator deserializes the
+  // state. The encoding is specific to this implementation and its version.
+  virtual absl::StatusOr<std::string> SerializePartialState() {
+    return absl::UnimplementedError(
+        "AggregateAccumulator::SerializePartialState() is not implemented");
+  }
+
+  // Merges a partial accumulation returned by SerializePartialState(). Returns
+  // an OutOfRange error if 'state' is not the state of a partial accumulation
+  // of the same aggregate.
+  virtual absl::Status MergeSerializedPartialState(absl::string_view state) {
+    return absl::UnimplementedError(
+        "AggregateAccumulator::MergeSerializedPartialState() is not "
+        "implemented");
+  }
 };
 
 // Defines an executable aggregate function.
@@ -2988,6 +3688,15 @@ class AggregateFunctionBody : public FunctionBody {
   CreateAccumulator(absl::Span<const Value> args, CollatorList collator_list,
                     EvaluationContext* context) const = 0;
 
+  // Returns true if the accumulators returned by CreateAccumulator() support
+  // AggregateAccumulator::Merge().
+  virtual bool SupportsMergingAccumulators() const { return false; }
+
+  // True if the accumulators created by CreateAccumulator() implement
+  // AggregateAccumulator::SerializePartialState() and
+  // AggregateAccumulator::MergeSerializedPartialState().
+  virtual bool SupportsSerializingAccumulators() const { return false; }
+
  private:
   const int num_input_fields_;
   const Type* input_type_;
@@ -3021,6 +3730,21 @@ class ScalarFunctionCallExpr final : public ValueExpr {
             EvaluationContext* context, VirtualTupleSlot* result,
             absl::Status* status) const override;
 
+  // Returns true if EvalBatch() may be called. That is the case if the function
+  // is a BuiltinScalarFunction that supports EvalColumns() on the argument
+  // types, errors are not suppressed, and every argument is a constant, a
+  // variable of the last schema passed to SetSchemasForEvaluation(), or
+  // another call that supports EvalBatch().
+  bool SupportsEvalBatch() const { return batch_schema_ != nullptr; }
+
+  // Columnar form of Eval(). Evaluates the call on each row of 'batch', where
+  // each row is the last element of the 'params' that Eval() would be passed
+  // and the other elements are not used, and stores the results in 'result',
+  // which has type output_type(). Must only be called if SupportsEvalBatch()
+  // returns true. On failure, populates 'status' and returns false.
+  bool EvalBatch(const TupleDataBatch& batch, EvaluationContext* context,
+                 TupleColumn* result, absl::Status* status) const;
+
   std::string DebugInternal(const std::string& indent,
                             bool verbose) const override;
 
@@ -3046,6 +3770,12 @@ class ScalarFunctionCallExpr final : public ValueExpr {
 
   std::unique_ptr<const ScalarFunctionBody> function_;
   const ResolvedFunctionCallBase::ErrorMode error_mode_;
+  // Set by SetSchemasForEvaluation() if SupportsEvalBatch() is true. A copy of
+  // the schema of the rows passed to EvalBatch(), and for each of its
+  // variables, the type of the column to load if an argument reads it, or
+  // NULL.
+  std::unique_ptr<const TupleSchema> batch_schema_;
+  std::vector<const Type*> batch_column_types_;
 };
 
 // Defines an aggregate function call with the given 'exprs' and 'arguments'.
@@ -3265,6 +3995,48 @@ class IfErrorExpr final : public ValueExpr {
   ValueExpr* mutable_handle_value();
 };
 
+// Operator backing IN with a list of constant elements, e.g.
+// x IN (1, 2, 3, ...). Looks 'value' up in a hash set of the elements rather
+// than comparing it with each of them, so that long lists take constant time
+// per row. Like IN, returns NULL if 'value' is NULL, or if it is not found and
+// one of the elements is NULL.
+class InListExpr final : public ValueExpr {
+ public:
+  InListExpr(const InListExpr&) = delete;
+  InListExpr& operator=(const InListExpr&) = delete;
+
+  // Returns whether the elements of an IN list can be of 'type', i.e. whether
+  // SQL equality of non-NULL values of 'type' is the same as Value equality.
+  static bool SupportsType(const Type* type);
+
+  // 'elements' must all be of the type of 'value', which must be supported.
+  static absl::StatusOr<std::unique_ptr<InListExpr>> Create(
+      std::unique_ptr<ValueExpr> value, absl::Span<const Value> elements);
+
+  absl::Status SetSchemasForEvaluation(
+      absl::Span<const TupleSchema* const> params_schemas) override;
+
+  bool Eval(absl::Span<const TupleData* const> params,
+            EvaluationContext* context, VirtualTupleSlot* result,
+            absl::Status* status) const override;
+
+  std::string DebugInternal(const std::string& indent,
+                            bool verbose) const override;
+
+ private:
+  enum ArgKind { kValue };
+
+  InListExpr(std::unique_ptr<ValueExpr> value,
+             absl::flat_hash_set<Value> elements, bool has_null_element);
+
+  const ValueExpr* value() const;
+  ValueExpr* mutable_value();
+
+  // The non-NULL elements.
+  const absl::flat_hash_set<Value> elements_;
+  const bool has_null_element_;
+};
+
 // Operator backing ISERROR. 'try_expr' is evaluated and if any unhandled errors
 // arise that would be absorbed in a SAFE function scenario, returns true.
 // Otherwise, returns false. It is not a regular function since its inputs
@@ -3378,6 +4150,13 @@ class InlineLambdaExpr : public AlgebraNode {
             EvaluationContext* context, VirtualTupleSlot* result,
             absl::Status* status, absl::Span<const Value> arg_values) const;
 
+  // Like Eval(), but with the argument values already in the last TupleData
+  // of `params_and_args`, which must have num_args() slots. Callers that
+  // evaluate the lambda for many elements use this to reuse one TupleData.
+  bool EvalBody(absl::Span<const TupleData* const> params_and_args,
+                EvaluationContext* context, VirtualTupleSlot* result,
+                absl::Status* status) const;
+
   std::string DebugInternal(const std::string& indent,
                             bool verbose) const override;
 
@@ -3658,6 +4437,18 @@ class DMLUpdateValueExpr final : public DMLValueExpr {
   DMLUpdateValueExpr(const DMLUpdateValueExpr&) = delete;
   DMLUpdateValueExpr& operator=(const DMLUpdateValueExpr&) = delete;
 
+  // A conjunct 'target = from' of the WHERE clause of an UPDATE with a FROM
+  // clause, where 'target' only references columns of the table being updated
+  // and 'from' only references columns of the FROM scan. Both expressions are
+  // in the ResolvedExprMap. If there are any join keys, Eval() builds a hash
+  // table of the FROM rows on the values of the 'from' expressions and only
+  // evaluates the WHERE clause for the FROM rows with matching values, instead
+  // of for every pair of rows.
+  struct JoinKey {
+    const ResolvedExpr* target;
+    const ResolvedExpr* from;
+  };
+
   // 'primary_key_type' may be NULL if the table doesn't have a primary key or
   // its primary key is not to be used in evaluting the DML expression.
   static absl::StatusOr<std::unique_ptr<DMLUpdateValueExpr>> Create(
@@ -3671,7 +4462,8 @@ class DMLUpdateValueExpr final : public DMLValueExpr {
       std::unique_ptr<const ColumnToVariableMapping> column_to_variable_mapping,
       std::unique_ptr<const ResolvedScanMap> resolved_scan_map,
       std::unique_ptr<const ResolvedExprMap> resolved_expr_map,
-      std::unique_ptr<const ColumnExprMap> column_expr_map);
+      std::unique_ptr<const ColumnExprMap> column_expr_map,
+      std::vector<JoinKey> join_keys = {});
 
   absl::Status SetSchemasForEvaluation(
       absl::Span<const TupleSchema* const> params_schemas) override;
@@ -3870,7 +4662,8 @@ class DMLUpdateValueExpr final : public DMLValueExpr {
       std::unique_ptr<const ColumnToVariableMapping> column_to_variable_mapping,
       std::unique_ptr<const ResolvedScanMap> resolved_scan_map,
       std::unique_ptr<const ResolvedExprMap> resolved_expr_map,
-      std::unique_ptr<const ColumnExprMap> column_expr_map);
+      std::unique_ptr<const ColumnExprMap> column_expr_map,
+      std::vector<JoinKey> join_keys);
 
   const ResolvedUpdateStmt* stmt() const {
     return resolved_node_->GetAs<ResolvedUpdateStmt>();
@@ -3924,14 +4717,26 @@ class DMLUpdateValueExpr final : public DMLValueExpr {
   //     - If 'where_expr->Eval()' returns true for more than one of them,
   //       returns an error. (This case corresponds to an otherwise
   //       non-deterministic UPDATE with join.)
+  //   If 'right_indexes' is non-NULL, only the entries of 'right_tuples' at
+  //   those indexes are considered. The others must not satisfy 'where_expr'.
   // The pointers in 'joined_tuple_datas' are only valid for the lifetime of
   // 'params', 'left_tuple', and 'right_tuples'.
   absl::Status GetJoinedTupleDatas(
       absl::Span<const TupleData* const> params, const TupleData* left_tuple,
       const std::vector<std::unique_ptr<TupleData>>* right_tuples,
-      const ValueExpr* where_expr, EvaluationContext* context,
+      const std::vector<int64_t>* right_indexes, const ValueExpr* where_expr,
+      EvaluationContext* context,
       std::vector<const TupleData*>* joined_tuple_datas) const;
 
+  // Evaluates the 'target' expressions of 'join_keys_' on 'params' and
+  // 'tuple' if 'is_target' is true, and the 'from' expressions otherwise, and
+  // returns them in 'key'. Returns false if any of them is NULL, in which case
+  // the row does not join with any row of the other side.
+  absl::StatusOr<bool> EvalJoinKey(absl::Span<const TupleData* const> params,
+                                   const TupleData* tuple, bool is_target,
+                                   EvaluationContext* context,
+                                   std::vector<Value>* key) const;
+
   // Modifies 'update_map' to incorporate the modifications represented by
   // 'update_item' for the row represented by 'tuples_for_row'. Also populates
   // 'update_target_column' with the ResolvedColumn leaf of
@@ -4020,6 +4825,8 @@ class DMLUpdateValueExpr final : public DMLValueExpr {
       absl::Span<const TupleData* const> tuples_for_row,
       const std::vector<Value>& original_elements, EvaluationContext* context,
       std::vector<UpdatedElement>* new_elements) const;
+
+  const std::vector<JoinKey> join_keys_;
 };
 
 // Represents a DML INSERT statement.
@@ -4160,7 +4967,7 @@ class RootOp final : public RelationalOp {
   absl::Status SetSchemasForEvaluation(
       absl::Span<const TupleSchema* const> params_schemas) override;
 
-  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIteratorImpl(
       absl::Span<const TupleData* const> params, int num_extra_slots,
       EvaluationContext* context) const override;
 
@@ -0,0 +1,199 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/reference_impl/operator_profile.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "google/protobuf/duration.pb.h"
+#include "zetasql/common/timer_util.h"
+#include "zetasql/public/proto/logging.pb.h"
+#include "zetasql/reference_impl/evaluation.h"
+#include "zetasql/reference_impl/operator.h"
+#include "zetasql/reference_impl/tuple.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "zetasql/base/map_util.h"
+
+namespace zetasql {
+
+namespace {
+
+// Forwards to another iterator and accumulates the statistics of its operator,
+// which it adds to the profile when destroyed.
+class ProfilingTupleIterator : public TupleIterator {
+ public:
+  ProfilingTupleIterator(const RelationalOp* op,
+                         std::unique_ptr<TupleIterator> iter,
+                         OperatorProfile::OperatorStats stats,
+                         OperatorProfile* profile, EvaluationContext* context)
+      : op_(op),
+        iter_(std::move(iter)),
+        stats_(std::move(stats)),
+        profile_(profile),
+        accountant_(context->memory_accountant()) {
+    UpdatePeakMemory();
+  }
+
+  ProfilingTupleIterator(const ProfilingTupleIterator&) = delete;
+  ProfilingTupleIterator& operator=(const ProfilingTupleIterator&) = delete;
+
+  ~ProfilingTupleIterator() override { profile_->AddStats(op_, stats_); }
+
+  const TupleSchema& Schema() const override { return iter_->Schema(); }
+
+  TupleData* Next() override {
+    internal::ElapsedTimer timer = internal::MakeTimerStarted();
+    TupleData* data = iter_->Next();
+    stats_.timed_value.Accumulate(timer);
+    if (data != nullptr) ++stats_.num_output_rows;
+    UpdatePeakMemory();
+    return data;
+  }
+
+  bool NextBatch(TupleDataBatch* batch) override {
+    internal::ElapsedTimer timer = internal::MakeTimerStarted();
+    const bool has_rows = iter_->NextBatch(batch);
+    stats_.timed_value.Accumulate(timer);
+    if (has_rows) stats_.num_output_rows += batch->size();
+    UpdatePeakMemory();
+    return has_rows;
+  }
+
+  absl::Status Status() const override { return iter_->Status(); }
+
+  bool PreservesOrder() const override { return iter_->PreservesOrder(); }
+
+  absl::Status DisableReordering() override {
+    return iter_->DisableReordering();
+  }
+
+  void Close() override { iter_->Close(); }
+
+  std::string DebugString() const override {
+    return absl::StrCat("ProfilingTupleIterator(", iter_->DebugString(), ")");
+  }
+
+ private:
+  void UpdatePeakMemory() {
+    if (accountant_ == nullptr) return;
+    stats_.peak_memory_bytes =
+        std::max(stats_.peak_memory_bytes,
+                 accountant_->total_num_bytes() - accountant_->remaining_bytes());
+  }
+
+  const RelationalOp* op_;
+  std::unique_ptr<TupleIterator> iter_;
+  OperatorProfile::OperatorStats stats_;
+  OperatorProfile* profile_;
+  const MemoryAccountant* accountant_;
+};
+
+absl::Duration FromProto(const google::protobuf::Duration& duration) {
+  return absl::Seconds(duration.seconds()) +
+         absl::Nanoseconds(duration.nanos());
+}
+
+void AppendOperator(const OperatorProfile& profile, const AlgebraNode* node,
+                    int depth, std::string* output) {
+  const RelationalOp* op = node->AsRelationalOp();
+  if (op != nullptr) {
+    const OperatorProfile::OperatorStats stats = profile.GetStats(op);
+    const ExecutionStats execution_stats =
+        stats.timed_value.ToExecutionStatsProto();
+    absl::StrAppend(
+        output, std::string(2 * depth, ' '), OperatorName(op),
+        ": iterators=", stats.num_iterators, " rows=", stats.num_output_rows,
+        " wall_time=", absl::FormatDuration(FromProto(
+                           execution_stats.wall_time())),
+        " cpu_time=", absl::FormatDuration(FromProto(
+                          execution_stats.cpu_time())),
+        " peak_memory_bytes=", stats.peak_memory_bytes);
+    if (stats.num_spilled_runs > 0) {
+      absl::StrAppend(output, " spilled_runs=", stats.num_spilled_runs);
+    }
+    absl::StrAppend(output, "\n");
+    ++depth;
+  }
+  for (const AlgebraArg* arg : node->GetArgs()) {
+    if (arg->has_node()) {
+      AppendOperator(profile, arg->node(), depth, output);
+    }
+  }
+}
+
+}  // namespace
+
+std::string OperatorName(const RelationalOp* op) {
+  const std::string debug_string = op->DebugString();
+  return std::string(absl::string_view(debug_string)
+                         .substr(0, debug_string.find_first_of("(\n")));
+}
+
+void OperatorProfile::OperatorStats::Merge(const OperatorStats& rhs) {
+  num_iterators += rhs.num_iterators;
+  num_output_rows += rhs.num_output_rows;
+  timed_value.Accumulate(rhs.timed_value);
+  peak_memory_bytes = std::max(peak_memory_bytes, rhs.peak_memory_bytes);
+  num_spilled_runs += rhs.num_spilled_runs;
+}
+
+void OperatorProfile::AddStats(const RelationalOp* op,
+                               const OperatorStats& stats) {
+  absl::MutexLock lock(&mutex_);
+  stats_[op].Merge(stats);
+}
+
+OperatorProfile::OperatorStats OperatorProfile::GetStats(
+    const RelationalOp* op) const {
+  absl::MutexLock lock(&mutex_);
+  return zetasql_base::FindWithDefault(stats_, op);
+}
+
+int64_t OperatorProfile::GetPeakMemoryBytes() const {
+  absl::MutexLock lock(&mutex_);
+  int64_t peak_memory_bytes = 0;
+  for (const auto& [op, stats] : stats_) {
+    peak_memory_bytes = std::max(peak_memory_bytes, stats.peak_memory_bytes);
+  }
+  return peak_memory_bytes;
+}
+
+std::unique_ptr<TupleIterator> OperatorProfile::WrapIterator(
+    const RelationalOp* op, std::unique_ptr<TupleIterator> iter,
+    const internal::ElapsedTimer& creation_timer, EvaluationContext* context) {
+  OperatorStats stats;
+  stats.num_iterators = 1;
+  stats.timed_value.Accumulate(creation_timer);
+  return std::make_unique<ProfilingTupleIterator>(op, std::move(iter),
+                                                  std::move(stats), this,
+                                                  context);
+}
+
+std::string OperatorProfile::DebugString(const RelationalOp* root) const {
+  std::string output;
+  AppendOperator(*this, root, /*depth=*/0, &output);
+  return output;
+}
+
+}  // namespace zetasql
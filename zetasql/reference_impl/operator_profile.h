@@ -0,0 +1,104 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_REFERENCE_IMPL_OPERATOR_PROFILE_H_
+#define ZETASQL_REFERENCE_IMPL_OPERATOR_PROFILE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "zetasql/common/timer_util.h"
+#include "zetasql/reference_impl/tuple.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+
+namespace zetasql {
+
+class EvaluationContext;
+class RelationalOp;
+
+// The runtime statistics of the RelationalOps of one evaluation, for an
+// EXPLAIN ANALYZE style rendering of the operator tree. Populated by
+// RelationalOp::CreateIterator() when the EvaluationContext has a profile.
+//
+// Statistics are inclusive: the time of an operator includes the time of the
+// inputs it pulls tuples from, as in the iterator model each Next() call of a
+// parent drives the Next() calls of its children.
+class OperatorProfile {
+ public:
+  struct OperatorStats {
+    // The number of iterators created for the operator. Greater than one for
+    // operators that are re-evaluated, like the right side of a correlated
+    // join.
+    int64_t num_iterators = 0;
+    // The number of tuples returned by those iterators.
+    int64_t num_output_rows = 0;
+    // The time spent creating the iterators and in their Next() and
+    // NextBatch() calls.
+    internal::TimedValue timed_value;
+    // The largest number of bytes allocated from the MemoryAccountant of the
+    // evaluation that was observed while the operator ran. The accountant is
+    // shared by the whole query, so this also includes the memory of other
+    // operators alive at that point.
+    int64_t peak_memory_bytes = 0;
+    // The number of sorted runs that the operator spilled to disk.
+    int64_t num_spilled_runs = 0;
+
+    void Merge(const OperatorStats& rhs);
+  };
+
+  OperatorProfile() = default;
+  OperatorProfile(const OperatorProfile&) = delete;
+  OperatorProfile& operator=(const OperatorProfile&) = delete;
+
+  // Adds 'stats' to the statistics of 'op'. Thread-safe.
+  void AddStats(const RelationalOp* op, const OperatorStats& stats);
+
+  // Returns the statistics of 'op', which are empty if it never ran.
+  OperatorStats GetStats(const RelationalOp* op) const;
+
+  // Returns the largest 'peak_memory_bytes' of any operator, which is the
+  // largest memory usage observed during the evaluation.
+  int64_t GetPeakMemoryBytes() const;
+
+  // Returns an iterator that forwards to 'iter' and records its statistics
+  // into this profile when it is destroyed. 'creation_timer' was started
+  // before 'iter' was created. This profile must outlive the iterator.
+  std::unique_ptr<TupleIterator> WrapIterator(
+      const RelationalOp* op, std::unique_ptr<TupleIterator> iter,
+      const internal::ElapsedTimer& creation_timer,
+      EvaluationContext* context);
+
+  // Returns the operator tree rooted at 'root', one RelationalOp per line,
+  // each annotated with its statistics. RelationalOps nested inside
+  // expressions, like subqueries, are included below the operator that
+  // evaluates them.
+  std::string DebugString(const RelationalOp* root) const;
+
+ private:
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<const RelationalOp*, OperatorStats> stats_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+// Returns the kind of 'op', e.g., "SortOp", without its arguments.
+std::string OperatorName(const RelationalOp* op);
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_REFERENCE_IMPL_OPERATOR_PROFILE_H_
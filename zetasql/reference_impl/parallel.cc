@@ -0,0 +1,136 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/reference_impl/parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/evaluator_executor.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+
+namespace zetasql {
+
+namespace {
+
+// The state that ParallelFor() shares with the tasks that it schedules on an
+// EvaluatorExecutor, which may only start after ParallelFor() returned.
+struct SharedTasks {
+  SharedTasks(int num_tasks, absl::FunctionRef<absl::Status(int)> fn)
+      : num_tasks(num_tasks), fn(fn) {}
+
+  // Runs tasks until all of them have started or one failed.
+  void RunTasks() ABSL_LOCKS_EXCLUDED(mutex) {
+    mutex.Lock();
+    while (next_task < num_tasks && first_error.ok()) {
+      const int task = next_task++;
+      ++num_running;
+      mutex.Unlock();
+      absl::Status status = fn(task);
+      mutex.Lock();
+      --num_running;
+      if (!status.ok() && first_error.ok()) first_error = std::move(status);
+    }
+    mutex.Unlock();
+  }
+
+  bool NoneRunning() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex) {
+    return num_running == 0;
+  }
+
+  const int num_tasks;
+  // Only called for the tasks taken from 'next_task', so only while
+  // ParallelFor() waits for them.
+  const absl::FunctionRef<absl::Status(int)> fn;
+  absl::Mutex mutex;
+  int next_task ABSL_GUARDED_BY(mutex) = 0;
+  int num_running ABSL_GUARDED_BY(mutex) = 0;
+  absl::Status first_error ABSL_GUARDED_BY(mutex);
+};
+
+absl::Status ParallelForOnExecutor(int num_threads, int num_tasks,
+                                   absl::FunctionRef<absl::Status(int)> fn,
+                                   EvaluatorExecutor* executor) {
+  auto shared = std::make_shared<SharedTasks>(num_tasks, fn);
+  for (int i = 1; i < num_threads; ++i) {
+    executor->Schedule([shared] { shared->RunTasks(); });
+  }
+  shared->RunTasks();
+  // No task can start anymore, but some may still be running.
+  absl::MutexLock lock(&shared->mutex);
+  shared->mutex.Await(
+      absl::Condition(shared.get(), &SharedTasks::NoneRunning));
+  return shared->first_error;
+}
+
+}  // namespace
+
+absl::Status ParallelFor(int num_threads, int num_tasks,
+                         absl::FunctionRef<absl::Status(int)> fn,
+                         EvaluatorExecutor* executor) {
+  num_threads = std::min(num_threads, num_tasks);
+  if (num_threads <= 1) {
+    for (int i = 0; i < num_tasks; ++i) {
+      absl::Status status = fn(i);
+      if (!status.ok()) return status;
+    }
+    return absl::OkStatus();
+  }
+  if (executor != nullptr) {
+    return ParallelForOnExecutor(num_threads, num_tasks, fn, executor);
+  }
+
+  std::atomic<int> next_task{0};
+  std::atomic<bool> failed{false};
+  absl::Mutex mutex;
+  // Guarded by 'mutex'.
+  absl::Status first_error;
+
+  auto run_tasks = [&]() {
+    while (!failed.load(std::memory_order_relaxed)) {
+      const int task = next_task.fetch_add(1, std::memory_order_relaxed);
+      if (task >= num_tasks) return;
+      absl::Status status = fn(task);
+      if (!status.ok()) {
+        absl::MutexLock lock(&mutex);
+        if (first_error.ok()) first_error = std::move(status);
+        failed.store(true, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  for (int i = 1; i < num_threads; ++i) {
+    threads.emplace_back(run_tasks);
+  }
+  run_tasks();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  absl::MutexLock lock(&mutex);
+  return first_error;
+}
+
+}  // namespace zetasql
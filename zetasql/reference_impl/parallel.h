@@ -0,0 +1,51 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Helpers for operators of the reference implementation that can use more
+// than one thread (see EvaluationOptions::num_threads and
+// EvaluationOptions::executor).
+//
+// Only work that does not touch the EvaluationContext may run on the helper
+// threads: the context (and hence ValueExpr evaluation) is not thread-safe.
+
+#ifndef ZETASQL_REFERENCE_IMPL_PARALLEL_H_
+#define ZETASQL_REFERENCE_IMPL_PARALLEL_H_
+
+#include "zetasql/public/evaluator_executor.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+
+namespace zetasql {
+
+// Calls 'fn(i)' for each 'i' in [0, num_tasks), using up to 'num_threads'
+// threads. The calling thread is one of them, so 'num_threads' <= 1 runs
+// every task inline, in order. Tasks are handed out in increasing order, but
+// may run concurrently and complete in any order.
+//
+// If any task fails, returns the error of one of the failed tasks (the first
+// one if 'num_threads' <= 1). Once a task fails, no new tasks are started.
+//
+// If 'executor' is non-null, the other threads are tasks scheduled on it
+// rather than new threads. The calling thread does not wait for the tasks
+// that have not started by the time it runs out of work, so this is correct
+// (if not parallel) even if the executor is busy with other work.
+absl::Status ParallelFor(int num_threads, int num_tasks,
+                         absl::FunctionRef<absl::Status(int)> fn,
+                         EvaluatorExecutor* executor = nullptr);
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_REFERENCE_IMPL_PARALLEL_H_
@@ -0,0 +1,152 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/reference_impl/parallel.h"
+
+#include <atomic>
+#include <functional>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/evaluator_executor.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+
+namespace zetasql {
+namespace {
+
+using ::testing::Each;
+using ::testing::ElementsAre;
+using ::testing::Eq;
+using ::zetasql_base::testing::StatusIs;
+
+TEST(ParallelForTest, RunsInlineWithOneThread) {
+  std::vector<int> order;
+  ZETASQL_EXPECT_OK(ParallelFor(/*num_threads=*/1, /*num_tasks=*/4, [&](int i) {
+    order.push_back(i);
+    return absl::OkStatus();
+  }));
+  EXPECT_THAT(order, ElementsAre(0, 1, 2, 3));
+}
+
+TEST(ParallelForTest, RunsEveryTaskOnce) {
+  for (int num_threads : {2, 4, 16}) {
+    std::vector<std::atomic<int>> counts(100);
+    ZETASQL_EXPECT_OK(ParallelFor(num_threads, counts.size(), [&](int i) {
+      counts[i].fetch_add(1);
+      return absl::OkStatus();
+    }));
+    std::vector<int> values;
+    for (const std::atomic<int>& count : counts) {
+      values.push_back(count.load());
+    }
+    EXPECT_THAT(values, Each(Eq(1))) << num_threads;
+  }
+}
+
+TEST(ParallelForTest, NoTasks) {
+  ZETASQL_EXPECT_OK(ParallelFor(/*num_threads=*/4, /*num_tasks=*/0,
+                        [](int) { return absl::InternalError("unexpected"); }));
+}
+
+TEST(ParallelForTest, ReturnsError) {
+  std::vector<int> order;
+  EXPECT_THAT(ParallelFor(/*num_threads=*/1, /*num_tasks=*/4,
+                          [&](int i) {
+                            order.push_back(i);
+                            return i == 1 ? absl::OutOfRangeError("task 1")
+                                          : absl::OkStatus();
+                          }),
+              StatusIs(absl::StatusCode::kOutOfRange));
+  EXPECT_THAT(order, ElementsAre(0, 1));
+
+  EXPECT_THAT(ParallelFor(/*num_threads=*/4, /*num_tasks=*/100,
+                          [](int i) {
+                            return i % 10 == 3 ? absl::OutOfRangeError("oops")
+                                               : absl::OkStatus();
+                          }),
+              StatusIs(absl::StatusCode::kOutOfRange));
+}
+
+// Runs each task on a thread of its own, or keeps it to run later.
+class TestExecutor : public EvaluatorExecutor {
+ public:
+  explicit TestExecutor(bool run_later) : run_later_(run_later) {}
+  ~TestExecutor() override {
+    for (std::thread& thread : threads_) thread.join();
+  }
+
+  void Schedule(std::function<void()> task) override {
+    if (run_later_) {
+      later_.push_back(std::move(task));
+    } else {
+      threads_.emplace_back(std::move(task));
+    }
+  }
+
+  void RunLater() {
+    for (std::function<void()>& task : later_) task();
+    later_.clear();
+  }
+
+  int num_scheduled() const { return threads_.size() + later_.size(); }
+
+ private:
+  const bool run_later_;
+  std::vector<std::thread> threads_;
+  std::vector<std::function<void()>> later_;
+};
+
+TEST(ParallelForTest, RunsTasksOnExecutor) {
+  TestExecutor executor(/*run_later=*/false);
+  std::vector<std::atomic<int>> counts(100);
+  ZETASQL_EXPECT_OK(ParallelFor(
+      /*num_threads=*/4, counts.size(),
+      [&](int i) {
+        counts[i].fetch_add(1);
+        return absl::OkStatus();
+      },
+      &executor));
+  std::vector<int> values;
+  for (const std::atomic<int>& count : counts) {
+    values.push_back(count.load());
+  }
+  EXPECT_THAT(values, Each(Eq(1)));
+  EXPECT_EQ(executor.num_scheduled(), 3);
+}
+
+TEST(ParallelForTest, DoesNotWaitForTasksThatHaveNotStarted) {
+  TestExecutor executor(/*run_later=*/true);
+  std::vector<int> order;
+  ZETASQL_EXPECT_OK(ParallelFor(
+      /*num_threads=*/4, /*num_tasks=*/4,
+      [&](int i) {
+        order.push_back(i);
+        return absl::OkStatus();
+      },
+      &executor));
+  EXPECT_THAT(order, ElementsAre(0, 1, 2, 3));
+  EXPECT_EQ(executor.num_scheduled(), 3);
+  // The late tasks find no work left.
+  executor.RunLater();
+  EXPECT_THAT(order, ElementsAre(0, 1, 2, 3));
+}
+
+}  // namespace
+}  // namespace zetasql
@@ -0,0 +1,183 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/reference_impl/plan_fragments.h"
+
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/type.h"
+#include "zetasql/reference_impl/operator.h"
+#include "zetasql/reference_impl/tuple.h"
+#include "zetasql/reference_impl/variable_generator.h"
+#include "zetasql/reference_impl/variable_id.h"
+#include "absl/memory/memory.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+namespace {
+
+// Returns the argument that holds the input of 'op' if 'op' is an operator
+// with a single input that SplitAtPartialAggregate() looks through, or NULL.
+AlgebraArg* GetSingleInputArg(RelationalOp* op) {
+  if (dynamic_cast<ComputeOp*>(op) == nullptr &&
+      dynamic_cast<FilterOp*>(op) == nullptr &&
+      dynamic_cast<SortOp*>(op) == nullptr &&
+      dynamic_cast<LimitOp*>(op) == nullptr &&
+      dynamic_cast<DistinctOp*>(op) == nullptr) {
+    return nullptr;
+  }
+  AlgebraArg* input = nullptr;
+  for (AlgebraArg* arg : op->GetMutableArgs()) {
+    if (arg->relational_op() == nullptr) continue;
+    if (input != nullptr) return nullptr;
+    input = arg;
+  }
+  return input;
+}
+
+// Returns the number of scans of 'table' in 'node' and its descendants.
+int CountTableScans(const AlgebraNode& node, const Table* table) {
+  const auto* scan = dynamic_cast<const EvaluatorTableScanOp*>(&node);
+  int count = scan != nullptr && scan->table() == table ? 1 : 0;
+  for (const AlgebraArg* arg : node.GetArgs()) {
+    if (arg->node() != nullptr) {
+      count += CountTableScans(*arg->node(), table);
+    }
+  }
+  return count;
+}
+
+// Returns whether 'op', which has one scan of 'table', produces the union of
+// its rows for any split of the rows of 'table' into parts (see
+// CanEvaluateOverAppendedRows()).
+bool IsDistributiveOverTable(const RelationalOp& op, const Table* table) {
+  if (dynamic_cast<const EvaluatorTableScanOp*>(&op) != nullptr) return true;
+  if (const auto* join = dynamic_cast<const JoinOp*>(&op); join != nullptr) {
+    const RelationalOp* input;
+    if (CountTableScans(*join->left_input(), table) == 1) {
+      switch (join->join_kind()) {
+        case JoinOp::kRightOuterJoin:
+        case JoinOp::kFullOuterJoin:
+          return false;
+        default:
+          input = join->left_input();
+      }
+    } else if (CountTableScans(*join->right_input(), table) == 1) {
+      switch (join->join_kind()) {
+        case JoinOp::kInnerJoin:
+        case JoinOp::kCrossApply:
+        case JoinOp::kRightOuterJoin:
+          input = join->right_input();
+          break;
+        default:
+          return false;
+      }
+    } else {
+      // 'table' is read by the join condition.
+      return false;
+    }
+    return IsDistributiveOverTable(*input, table);
+  }
+  if (dynamic_cast<const ComputeOp*>(&op) == nullptr &&
+      dynamic_cast<const FilterOp*>(&op) == nullptr) {
+    return false;
+  }
+  for (const AlgebraArg* arg : op.GetArgs()) {
+    if (arg->relational_op() != nullptr) {
+      return CountTableScans(*arg->relational_op(), table) == 1 &&
+             IsDistributiveOverTable(*arg->relational_op(), table);
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+absl::StatusOr<std::optional<PlanFragments>> SplitAtPartialAggregate(
+    int exchange_id, ExchangeReceiver* receiver,
+    VariableGenerator* variable_gen, std::unique_ptr<RelationalOp>* plan) {
+  ZETASQL_RET_CHECK(plan != nullptr && *plan != nullptr);
+
+  // The argument that holds the AggregateOp, or NULL if it is the root.
+  AlgebraArg* aggregate_arg = nullptr;
+  RelationalOp* op = plan->get();
+  while (dynamic_cast<AggregateOp*>(op) == nullptr) {
+    aggregate_arg = GetSingleInputArg(op);
+    if (aggregate_arg == nullptr) return std::nullopt;
+    op = aggregate_arg->mutable_relational_op();
+  }
+  const AggregateOp* aggregate = static_cast<const AggregateOp*>(op);
+
+  // The shard fragment produces the output variables of 'aggregate', which
+  // the final fragment populates again, so the exchange has new ones.
+  const std::vector<const Type*> types = aggregate->GetOutputTypes();
+  const std::unique_ptr<TupleSchema> schema = aggregate->CreateOutputSchema();
+  ZETASQL_RET_CHECK_EQ(types.size(), schema->num_variables());
+  std::vector<VariableId> partial_variables;
+  std::vector<std::unique_ptr<ExprArg>> columns;
+  for (int i = 0; i < types.size(); ++i) {
+    partial_variables.push_back(variable_gen->GetNewVariableName(
+        absl::StrCat(schema->variable(i).ToString(), "_partial")));
+    columns.push_back(
+        std::make_unique<ExprArg>(partial_variables.back(), types[i]));
+  }
+  ZETASQL_ASSIGN_OR_RETURN(
+      std::unique_ptr<ExchangeOp> exchange,
+      ExchangeOp::Create(exchange_id, std::move(columns), receiver));
+  ZETASQL_ASSIGN_OR_RETURN(
+      std::unique_ptr<AggregateOp> final_aggregate,
+      aggregate->CreateFinalAggregate(std::move(exchange), partial_variables));
+  if (final_aggregate == nullptr) return std::nullopt;
+
+  PlanFragments fragments;
+  if (aggregate_arg == nullptr) {
+    fragments.shard_fragment = std::move(*plan);
+    fragments.final_fragment = std::move(final_aggregate);
+  } else {
+    std::unique_ptr<AlgebraNode> shard_fragment =
+        aggregate_arg->ReplaceNode(std::move(final_aggregate));
+    fragments.shard_fragment =
+        absl::WrapUnique(shard_fragment.release()->AsMutableRelationalOp());
+    fragments.final_fragment = std::move(*plan);
+  }
+  return fragments;
+}
+
+bool CanEvaluateOverAppendedRows(const PlanFragments& fragments,
+                                 const Table* table) {
+  const auto* aggregate =
+      dynamic_cast<const AggregateOp*>(fragments.shard_fragment.get());
+  if (aggregate == nullptr || CountTableScans(*aggregate, table) != 1 ||
+      CountTableScans(*fragments.final_fragment, table) != 0) {
+    return false;
+  }
+  for (const AlgebraArg* arg : aggregate->GetArgs()) {
+    if (arg->relational_op() != nullptr) {
+      return CountTableScans(*arg->relational_op(), table) == 1 &&
+             IsDistributiveOverTable(*arg->relational_op(), table);
+    }
+  }
+  return false;
+}
+
+}  // namespace zetasql
@@ -0,0 +1,70 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_REFERENCE_IMPL_PLAN_FRAGMENTS_H_
+#define ZETASQL_REFERENCE_IMPL_PLAN_FRAGMENTS_H_
+
+#include <memory>
+#include <optional>
+
+#include "zetasql/public/catalog.h"
+#include "zetasql/reference_impl/operator.h"
+#include "zetasql/reference_impl/variable_generator.h"
+#include "absl/status/statusor.h"
+
+namespace zetasql {
+
+// An algebrized plan split at an exchange, for an input that is partitioned
+// into shards (e.g., a table whose rows are spread over several workers).
+struct PlanFragments {
+  // Runs on each shard, over the part of the input on that shard. Its output
+  // rows are sent to the exchange.
+  std::unique_ptr<RelationalOp> shard_fragment;
+  // Runs once, over the rows that all the shards sent to the exchange, which
+  // it reads through an ExchangeOp. Produces the output of the original plan.
+  std::unique_ptr<RelationalOp> final_fragment;
+};
+
+// Splits 'plan' into a partial aggregation that runs on each shard and a
+// final aggregation that combines the partial rows (see
+// AggregateOp::CreateFinalAggregate()). The split is at the first AggregateOp
+// below the ComputeOps, FilterOps, SortOps, LimitOps and DistinctOps at the
+// top of 'plan', so that the shard fragment is not correlated with the rest
+// of the plan. The final fragment reads exchange 'exchange_id' through
+// 'receiver', with new variables from 'variable_gen'.
+//
+// Returns std::nullopt and leaves 'plan' alone if there is no such
+// AggregateOp or it cannot be split. Otherwise consumes 'plan'.
+// SetSchemasForEvaluation() must be called on each fragment after the split.
+// 'plan' must not be wrapped in a RootOp yet.
+absl::StatusOr<std::optional<PlanFragments>> SplitAtPartialAggregate(
+    int exchange_id, ExchangeReceiver* receiver,
+    VariableGenerator* variable_gen, std::unique_ptr<RelationalOp>* plan);
+
+// Returns whether running the shard fragment of 'fragments' over the rows
+// appended to 'table', and merging its partial rows with those for the rows
+// that 'table' had before, gives the partial rows for all the rows of 'table'
+// as long as the other tables do not change. That is the case if 'table' is
+// only read once, by the shard fragment, through ComputeOps, FilterOps and
+// the sides of JoinOps whose rows are joined independently of each other
+// (e.g., either side of an inner join, or the left input of a left outer
+// join).
+bool CanEvaluateOverAppendedRows(const PlanFragments& fragments,
+                                 const Table* table);
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_REFERENCE_IMPL_PLAN_FRAGMENTS_H_
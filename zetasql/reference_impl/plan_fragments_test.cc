@@ -0,0 +1,199 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/reference_impl/plan_fragments.h"
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/reference_impl/evaluation.h"
+#include "zetasql/reference_impl/function.h"
+#include "zetasql/reference_impl/operator.h"
+#include "zetasql/reference_impl/test_relational_op.h"
+#include "zetasql/reference_impl/tuple.h"
+#include "zetasql/reference_impl/tuple_test_util.h"
+#include "zetasql/reference_impl/variable_generator.h"
+#include "zetasql/reference_impl/variable_id.h"
+#include "zetasql/testing/test_value.h"
+#include "zetasql/testing/using_test_value.cc"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+
+namespace zetasql {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+// Iterates over rows of Values.
+class RowsIterator : public EvaluatorTableIterator {
+ public:
+  RowsIterator(absl::Span<const Type* const> types,
+               std::vector<std::vector<Value>> rows)
+      : types_(types.begin(), types.end()), rows_(std::move(rows)) {}
+
+  int NumColumns() const override { return static_cast<int>(types_.size()); }
+  std::string GetColumnName(int i) const override {
+    return absl::StrCat("c", i);
+  }
+  const Type* GetColumnType(int i) const override { return types_[i]; }
+  bool NextRow() override { return ++row_ < rows_.size(); }
+  const Value& GetValue(int i) const override { return rows_[row_][i]; }
+  absl::Status Status() const override { return absl::OkStatus(); }
+  absl::Status Cancel() override { return absl::OkStatus(); }
+
+ private:
+  const std::vector<const Type*> types_;
+  const std::vector<std::vector<Value>> rows_;
+  int row_ = -1;
+};
+
+// Stands in for a transport: the rows of the shards are sent to it directly.
+class TestExchangeReceiver : public ExchangeReceiver {
+ public:
+  void Send(const TupleData& row) {
+    std::vector<Value> values;
+    for (const TupleSlot& slot : row.slots()) {
+      values.push_back(slot.value());
+    }
+    rows_.push_back(std::move(values));
+  }
+
+  absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>> Receive(
+      int exchange_id, absl::Span<const Type* const> column_types) override {
+    EXPECT_EQ(exchange_id, 7);
+    return std::make_unique<RowsIterator>(column_types, rows_);
+  }
+
+ private:
+  std::vector<std::vector<Value>> rows_;
+};
+
+std::unique_ptr<AggregateArg> MakeAggregate(const VariableId& variable,
+                                            FunctionKind kind,
+                                            const Type* output_type,
+                                            const VariableId& input) {
+  std::vector<std::unique_ptr<ValueExpr>> arguments;
+  arguments.push_back(DerefExpr::Create(input, Int64Type()).value());
+  return AggregateArg::Create(
+             variable,
+             std::make_unique<BuiltinAggregateFunction>(
+                 kind, output_type, /*num_input_fields=*/1, Int64Type()),
+             std::move(arguments))
+      .value();
+}
+
+// Returns SELECT a AS k, <aggregators> FROM <shard> GROUP BY a. Each run of
+// the input stands for a shard, with the same rows.
+std::unique_ptr<RelationalOp> MakeAggregateOp(
+    const VariableId& a, const VariableId& b,
+    std::vector<std::unique_ptr<AggregateArg>> aggregators) {
+  VariableId k("k");
+  std::vector<std::unique_ptr<KeyArg>> keys;
+  keys.push_back(
+      std::make_unique<KeyArg>(k, DerefExpr::Create(a, Int64Type()).value()));
+  return AggregateOp::Create(
+             std::move(keys), std::move(aggregators),
+             absl::WrapUnique(new TestRelationalOp(
+                 {a, b},
+                 CreateTestTupleDatas({{Int64(1), Int64(10)},
+                                       {Int64(2), Int64(5)},
+                                       {Int64(1), Int64(20)},
+                                       {NullInt64(), NullInt64()}}),
+                 /*preserves_order=*/true)),
+             /*grouping_sets=*/{})
+      .value();
+}
+
+TEST(PlanFragmentsTest, SplitAtPartialAggregate) {
+  VariableId a("a"), b("b"), c("c"), s("s"), m("m");
+  std::vector<std::unique_ptr<AggregateArg>> aggregators;
+  aggregators.push_back(MakeAggregate(c, FunctionKind::kCount, Int64Type(), b));
+  aggregators.push_back(MakeAggregate(s, FunctionKind::kSum, Int64Type(), b));
+  aggregators.push_back(MakeAggregate(m, FunctionKind::kMin, Int64Type(), b));
+  std::unique_ptr<RelationalOp> plan =
+      MakeAggregateOp(a, b, std::move(aggregators));
+
+  VariableGenerator variable_gen;
+  TestExchangeReceiver receiver;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::optional<PlanFragments> fragments,
+                       SplitAtPartialAggregate(/*exchange_id=*/7, &receiver,
+                                               &variable_gen, &plan));
+  ASSERT_TRUE(fragments.has_value());
+  EXPECT_EQ(plan, nullptr);
+  ZETASQL_ASSERT_OK(fragments->shard_fragment->SetSchemasForEvaluation({}));
+  ZETASQL_ASSERT_OK(fragments->final_fragment->SetSchemasForEvaluation({}));
+  EXPECT_THAT(fragments->final_fragment->DebugString(),
+              HasSubstr("ExchangeOp("));
+
+  EvaluationContext context((EvaluationOptions()));
+  for (int shard = 0; shard < 2; ++shard) {
+    ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<TupleIterator> iter,
+                         fragments->shard_fragment->CreateIterator(
+                             {}, /*num_extra_slots=*/0, &context));
+    ZETASQL_ASSERT_OK_AND_ASSIGN(std::vector<TupleData> data,
+                         ReadFromTupleIterator(iter.get()));
+    for (const TupleData& row : data) {
+      receiver.Send(row);
+    }
+  }
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<TupleIterator> iter,
+                       fragments->final_fragment->CreateIterator(
+                           {}, /*num_extra_slots=*/0, &context));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::vector<TupleData> data,
+                       ReadFromTupleIterator(iter.get()));
+  std::vector<std::string> groups;
+  for (const TupleData& group : data) {
+    groups.push_back(Tuple(&iter->Schema(), &group).DebugString());
+  }
+  std::sort(groups.begin(), groups.end());
+  EXPECT_THAT(groups, ElementsAre("<k:1,c:4,s:60,m:10>", "<k:2,c:2,s:10,m:5>",
+                                  "<k:NULL,c:0,s:NULL,m:NULL>"));
+}
+
+TEST(PlanFragmentsTest, AggregateWithoutFinalAggregateIsNotSplit) {
+  VariableId a("a"), b("b"), c("c");
+  std::vector<std::unique_ptr<AggregateArg>> aggregators;
+  aggregators.push_back(MakeAggregate(c, FunctionKind::kAvg, DoubleType(), b));
+  std::unique_ptr<RelationalOp> plan =
+      MakeAggregateOp(a, b, std::move(aggregators));
+  const RelationalOp* original_plan = plan.get();
+
+  VariableGenerator variable_gen;
+  TestExchangeReceiver receiver;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::optional<PlanFragments> fragments,
+                       SplitAtPartialAggregate(/*exchange_id=*/7, &receiver,
+                                               &variable_gen, &plan));
+  EXPECT_FALSE(fragments.has_value());
+  EXPECT_EQ(plan.get(), original_plan);
+}
+
+}  // namespace
+}  // namespace zetasql
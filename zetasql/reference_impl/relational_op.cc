@@ -19,6 +19,8 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <deque>
+#include <functional>
 #include <iterator>
 #include <map>
 #include <memory>
@@ -26,41 +28,57 @@
 #include <queue>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <tuple>
 #include <utility>
 #include <vector>
 
 #include "zetasql/common/internal_value.h"
 #include "zetasql/common/thread_stack.h"
+#include "zetasql/common/timer_util.h"
 #include "zetasql/public/catalog.h"
+#include "zetasql/public/evaluator_executor.h"
 #include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/evaluator_tracer.h"
 #include "zetasql/public/function_signature.h"
 #include "zetasql/public/functions/array_zip_mode.pb.h"
+#include "zetasql/public/functions/datetime.pb.h"
+#include "zetasql/public/functions/generate_array.h"
+#include "zetasql/public/numeric_value.h"
 #include "zetasql/public/table_valued_function.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/type.pb.h"
 #include "zetasql/public/value.h"
+#include "zetasql/reference_impl/columnar_batch.h"
 #include "zetasql/reference_impl/evaluation.h"
 #include "zetasql/reference_impl/function.h"
 #include "zetasql/reference_impl/operator.h"
+#include "zetasql/reference_impl/operator_profile.h"
+#include "zetasql/reference_impl/parallel.h"
+#include "zetasql/reference_impl/spill_file.h"
 #include "zetasql/reference_impl/tuple.h"
 #include "zetasql/reference_impl/tuple_comparator.h"
 #include "zetasql/reference_impl/variable_id.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
 #include "absl/algorithm/container.h"
+#include "absl/cleanup/cleanup.h"
 #include "absl/container/btree_set.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/flags/flag.h"
+#include "absl/hash/hash.h"
 #include "zetasql/base/check.h"
 #include "absl/memory/memory.h"
+#include "absl/numeric/bits.h"
 #include "absl/random/distributions.h"
 #include "absl/random/random.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
@@ -85,10 +103,139 @@ RelationalArg::~RelationalArg() = default;
 
 RelationalOp::~RelationalOp() = default;
 
+// -------------------------------------------------------
+// RelationalProperties
+// -------------------------------------------------------
+
+RelationalProperties::OrderingKey RelationalProperties::OrderingKey::FromKeyArg(
+    const VariableId& variable, const KeyArg& key) {
+  OrderingKey ordering_key;
+  ordering_key.variable = variable;
+  ordering_key.descending = key.is_descending();
+  // Matches TupleComparator: NULLs come first when ascending and last when
+  // descending, unless overridden.
+  ordering_key.nulls_first = key.is_descending()
+                                 ? key.null_order() == KeyArg::kNullsFirst
+                                 : key.null_order() != KeyArg::kNullsLast;
+  return ordering_key;
+}
+
+bool RelationalProperties::IsOrderedBy(
+    absl::Span<const OrderingKey> keys) const {
+  if (keys.size() > ordering.size()) return false;
+  return std::equal(keys.begin(), keys.end(), ordering.begin());
+}
+
+bool RelationalProperties::IsGroupedBy(
+    absl::Span<const VariableId> variables) const {
+  if (variables.size() > ordering.size()) return false;
+  absl::flat_hash_set<VariableId> prefix;
+  for (int i = 0; i < variables.size(); ++i) {
+    prefix.insert(ordering[i].variable);
+  }
+  absl::flat_hash_set<VariableId> grouped(variables.begin(), variables.end());
+  return prefix == grouped && grouped.size() == variables.size();
+}
+
+std::string RelationalProperties::DebugString() const {
+  std::string result = absl::StrCat(
+      "ordering: [",
+      absl::StrJoin(ordering, ", ",
+                    [](std::string* out, const OrderingKey& key) {
+                      absl::StrAppend(out, "$", key.variable.ToString(),
+                                      key.descending ? " DESC" : " ASC",
+                                      key.nulls_first ? " NULLS FIRST"
+                                                      : " NULLS LAST");
+                    }),
+      "]");
+  if (!unique_key.empty()) {
+    absl::StrAppend(&result, ", unique: [",
+                    absl::StrJoin(unique_key, ", ",
+                                  [](std::string* out, const VariableId& v) {
+                                    absl::StrAppend(out, "$", v.ToString());
+                                  }),
+                    "]");
+  }
+  return result;
+}
+
 // -------------------------------------------------------
 // RelationalOp
 // -------------------------------------------------------
 
+namespace {
+
+// Forwards to another iterator and reports the number of rows it returns to
+// an EvaluatorTracer every EvaluatorTracer::row_sample_interval() rows, and
+// when destroyed.
+class TracingTupleIterator : public TupleIterator {
+ public:
+  TracingTupleIterator(const RelationalOp* op, absl::string_view op_name,
+                       std::unique_ptr<TupleIterator> iter,
+                       EvaluatorTracer* tracer)
+      : op_(op),
+        op_name_(op_name),
+        iter_(std::move(iter)),
+        tracer_(tracer),
+        sample_interval_(std::max<int64_t>(1, tracer->row_sample_interval())),
+        rows_until_sample_(sample_interval_) {}
+
+  TracingTupleIterator(const TracingTupleIterator&) = delete;
+  TracingTupleIterator& operator=(const TracingTupleIterator&) = delete;
+
+  ~TracingTupleIterator() override {
+    tracer_->SampleRows(op_, op_name_, num_rows_);
+  }
+
+  const TupleSchema& Schema() const override { return iter_->Schema(); }
+
+  TupleData* Next() override {
+    TupleData* data = iter_->Next();
+    if (data != nullptr) AddRows(1);
+    return data;
+  }
+
+  bool NextBatch(TupleDataBatch* batch) override {
+    const bool has_rows = iter_->NextBatch(batch);
+    if (has_rows) AddRows(batch->size());
+    return has_rows;
+  }
+
+  absl::Status Status() const override { return iter_->Status(); }
+
+  bool PreservesOrder() const override { return iter_->PreservesOrder(); }
+
+  absl::Status DisableReordering() override {
+    return iter_->DisableReordering();
+  }
+
+  void Close() override { iter_->Close(); }
+
+  std::string DebugString() const override {
+    return absl::StrCat("TracingTupleIterator(", iter_->DebugString(), ")");
+  }
+
+ private:
+  void AddRows(int64_t num_rows) {
+    num_rows_ += num_rows;
+    rows_until_sample_ -= num_rows;
+    if (rows_until_sample_ > 0) return;
+    tracer_->SampleRows(op_, op_name_, num_rows_);
+    rows_until_sample_ = sample_interval_;
+  }
+
+  const RelationalOp* op_;
+  // Owned by the root EvaluationContext, which outlives the iterator.
+  absl::string_view op_name_;
+  std::unique_ptr<TupleIterator> iter_;
+  EvaluatorTracer* tracer_;
+  const int64_t sample_interval_;
+  int64_t rows_until_sample_;
+  int64_t num_rows_ = 0;
+};
+
+}  // namespace
+
 absl::Status RelationalOp::set_is_order_preserving(bool is_order_preserving) {
   ZETASQL_RET_CHECK(!is_order_preserving || may_preserve_order())
       << "Operator cannot preserve order";
@@ -117,6 +264,36 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> RelationalOp::Eval(
   return iter;
 }
 
+absl::StatusOr<std::unique_ptr<TupleIterator>> RelationalOp::CreateIterator(
+    absl::Span<const TupleData* const> params, int num_extra_slots,
+    EvaluationContext* context) const {
+  OperatorProfile* profile = context->operator_profile();
+  EvaluatorTracer* tracer = context->tracer();
+  if (profile == nullptr && tracer == nullptr) {
+    return CreateIteratorImpl(params, num_extra_slots, context);
+  }
+  const internal::ElapsedTimer timer = internal::MakeTimerStarted();
+  absl::string_view name;
+  if (tracer != nullptr) {
+    name = context->GetTracedOperatorName(this);
+    tracer->BeginCreateIterator(this, name);
+  }
+  absl::StatusOr<std::unique_ptr<TupleIterator>> iter =
+      CreateIteratorImpl(params, num_extra_slots, context);
+  if (tracer != nullptr) {
+    tracer->EndCreateIterator(this, name, iter.status());
+  }
+  ZETASQL_RETURN_IF_ERROR(iter.status());
+  if (tracer != nullptr) {
+    iter = std::make_unique<TracingTupleIterator>(this, name, *std::move(iter),
+                                                  tracer);
+  }
+  if (profile != nullptr) {
+    iter = profile->WrapIterator(this, *std::move(iter), timer, context);
+  }
+  return iter;
+}
+
 absl::StatusOr<std::unique_ptr<TupleIterator>> RelationalOp::MaybeReorder(
     std::unique_ptr<TupleIterator> iter, EvaluationContext* context) const {
   if (context->options().scramble_undefined_orderings) {
@@ -312,6 +489,97 @@ HalfUnboundedColumnFilterArg::HalfUnboundedColumnFilterArg(
       kind_(kind),
       arg_(std::move(arg)) {}
 
+// -------------------------------------------------------
+// IsNullColumnFilterArg
+// -------------------------------------------------------
+
+absl::StatusOr<std::unique_ptr<IsNullColumnFilterArg>>
+IsNullColumnFilterArg::Create(const VariableId& variable, int column_idx) {
+  return absl::WrapUnique(new IsNullColumnFilterArg(variable, column_idx));
+}
+
+absl::Status IsNullColumnFilterArg::SetSchemasForEvaluation(
+    absl::Span<const TupleSchema* const> params_schemas) {
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::unique_ptr<ColumnFilter>> IsNullColumnFilterArg::Eval(
+    absl::Span<const TupleData* const> params,
+    EvaluationContext* context) const {
+  return std::make_unique<ColumnFilter>(ColumnFilter::IsNull());
+}
+
+std::string IsNullColumnFilterArg::DebugInternal(const std::string& indent,
+                                                 bool verbose) const {
+  return absl::StrCat("IsNullColumnFilterArg($", variable_.ToString(),
+                      ", column_idx: ", column_idx(), ")");
+}
+
+IsNullColumnFilterArg::IsNullColumnFilterArg(const VariableId& variable,
+                                             int column_idx)
+    : ColumnFilterArg(column_idx), variable_(variable) {}
+
+// -------------------------------------------------------
+// PrefixColumnFilterArg
+// -------------------------------------------------------
+
+absl::StatusOr<std::unique_ptr<PrefixColumnFilterArg>>
+PrefixColumnFilterArg::Create(const VariableId& variable, int column_idx,
+                              std::unique_ptr<ValueExpr> pattern) {
+  ZETASQL_RET_CHECK(pattern->output_type()->IsString() ||
+            pattern->output_type()->IsBytes());
+  return absl::WrapUnique(
+      new PrefixColumnFilterArg(variable, column_idx, std::move(pattern)));
+}
+
+absl::Status PrefixColumnFilterArg::SetSchemasForEvaluation(
+    absl::Span<const TupleSchema* const> params_schemas) {
+  return pattern_->SetSchemasForEvaluation(params_schemas);
+}
+
+absl::StatusOr<std::unique_ptr<ColumnFilter>> PrefixColumnFilterArg::Eval(
+    absl::Span<const TupleData* const> params,
+    EvaluationContext* context) const {
+  TupleSlot pattern;
+  absl::Status status;
+  if (!pattern_->EvalSimple(params, context, &pattern, &status)) {
+    return status;
+  }
+
+  if (pattern.value().is_null()) {
+    // Return something that can't be matched.
+    return std::make_unique<ColumnFilter>(std::vector<Value>());
+  }
+
+  const bool is_string = pattern.value().type()->IsString();
+  const std::string& pattern_str = is_string ? pattern.value().string_value()
+                                             : pattern.value().bytes_value();
+  // Wildcards and escapes are ASCII, so they cannot occur within a multi-byte
+  // UTF-8 character and the prefix is valid UTF-8 if the pattern is.
+  const std::string prefix =
+      pattern_str.substr(0, pattern_str.find_first_of("%_\\"));
+  if (prefix.empty()) {
+    // Every non-NULL value matches.
+    return std::make_unique<ColumnFilter>(Value(), Value());
+  }
+  return std::make_unique<ColumnFilter>(ColumnFilter::Prefix(
+      is_string ? Value::String(prefix) : Value::Bytes(prefix)));
+}
+
+std::string PrefixColumnFilterArg::DebugInternal(const std::string& indent,
+                                                 bool verbose) const {
+  return absl::StrCat("PrefixColumnFilterArg($", variable_.ToString(),
+                      ", column_idx: ", column_idx(), ", pattern: ",
+                      pattern_->DebugInternal(indent, verbose), ")");
+}
+
+PrefixColumnFilterArg::PrefixColumnFilterArg(const VariableId& variable,
+                                             int column_idx,
+                                             std::unique_ptr<ValueExpr> pattern)
+    : ColumnFilterArg(column_idx),
+      variable_(variable),
+      pattern_(std::move(pattern)) {}
+
 // -------------------------------------------------------
 // EvaluatorTableScanOp
 // -------------------------------------------------------
@@ -334,15 +602,32 @@ EvaluatorTableScanOp::Create(
       std::move(and_filters), std::move(read_time)));
 }
 
+// Returns true if 'value' is a non-NULL STRING or BYTES value that starts with
+// 'prefix', which must be a non-NULL STRING or BYTES value.
+static bool StartsWithPrefix(const Value& value, const Value& prefix) {
+  if (value.is_null() || !value.type()->Equals(prefix.type())) return false;
+  if (prefix.type()->IsString()) {
+    return absl::StartsWith(value.string_value(), prefix.string_value());
+  }
+  return absl::StartsWith(value.bytes_value(), prefix.bytes_value());
+}
+
 absl::StatusOr<std::unique_ptr<ColumnFilter>>
 EvaluatorTableScanOp::IntersectColumnFilters(
     absl::Span<const std::unique_ptr<ColumnFilter>> filters) {
   // Invariant: a Value that matches all the ColumnFilters in entry.second is
-  // in the range ['lower_bound', 'upper_bound'] and in 'in_set'. We
-  // represent +/- infinity with invalid 'lower_bound'/'upper_bound'. We
-  // represent an 'in_set' consisting of all values with absl::nullopt.
+  // in the range ['lower_bound', 'upper_bound'], in 'in_set' and starts with
+  // 'prefix'. We represent +/- infinity with invalid
+  // 'lower_bound'/'upper_bound'. We represent an 'in_set' consisting of all
+  // values with absl::nullopt, and the lack of a prefix with an invalid
+  // 'prefix'.
   Value lower_bound;
   Value upper_bound;
+  Value prefix;
+  // True if there is a kIsNull filter. Only NULL matches it, and NULL does
+  // not match any other kind of filter.
+  bool has_is_null = false;
+  bool has_non_null = false;
 
   struct SqlLessThan {
     bool operator()(const Value& v1, const Value& v2) const {
@@ -353,8 +638,27 @@ EvaluatorTableScanOp::IntersectColumnFilters(
   std::optional<absl::btree_set<Value, SqlLessThan>> in_set;
 
   for (const std::unique_ptr<ColumnFilter>& filter : filters) {
+    if (filter->kind() == ColumnFilter::kIsNull) {
+      has_is_null = true;
+    } else {
+      has_non_null = true;
+    }
+
     // Intersect 'filter' with the state we have for its kind.
     switch (filter->kind()) {
+      case ColumnFilter::kIsNull:
+        break;
+      case ColumnFilter::kPrefix: {
+        const Value& new_prefix = filter->prefix();
+        ZETASQL_RET_CHECK(!new_prefix.is_null());
+        if (!prefix.is_valid() || StartsWithPrefix(new_prefix, prefix)) {
+          prefix = new_prefix;
+        } else if (!StartsWithPrefix(prefix, new_prefix)) {
+          // Nothing matches.
+          in_set = absl::btree_set<Value, SqlLessThan>();
+        }
+        break;
+      }
       case ColumnFilter::kRange:
         // Tighten the upper and lower bounds.
         if (!lower_bound.is_valid() ||
@@ -415,8 +719,29 @@ EvaluatorTableScanOp::IntersectColumnFilters(
     }
   }
 
+  if (has_is_null) {
+    if (has_non_null) {
+      // Nothing matches.
+      return std::make_unique<ColumnFilter>(std::vector<Value>());
+    }
+    return std::make_unique<ColumnFilter>(ColumnFilter::IsNull());
+  }
+
+  // A Value that starts with 'prefix' is at least 'prefix'. If it is also at
+  // least 'lower_bound' > 'prefix', then 'lower_bound' must start with
+  // 'prefix' as well.
+  if (prefix.is_valid() && !in_set.has_value() &&
+      ((upper_bound.is_valid() &&
+        upper_bound.SqlLessThan(prefix) == values::True()) ||
+       (lower_bound.is_valid() &&
+        prefix.SqlLessThan(lower_bound) == values::True() &&
+        !StartsWithPrefix(lower_bound, prefix)))) {
+    // Nothing matches.
+    in_set = absl::btree_set<Value, SqlLessThan>();
+  }
+
   // Take the intersection of the range represented by
-  // 'lower_bound'/'upper_bound' and the elements in 'in_set'.
+  // 'lower_bound'/'upper_bound', 'prefix' and the elements in 'in_set'.
   if (in_set.has_value()) {
     for (auto i = in_set.value().begin(); i != in_set.value().end();) {
       auto current = i;
@@ -426,7 +751,8 @@ EvaluatorTableScanOp::IntersectColumnFilters(
       if ((lower_bound.is_valid() &&
            value.SqlLessThan(lower_bound) == values::True()) ||
           (upper_bound.is_valid() &&
-           upper_bound.SqlLessThan(value) == values::True())) {
+           upper_bound.SqlLessThan(value) == values::True()) ||
+          (prefix.is_valid() && !StartsWithPrefix(value, prefix))) {
         i = in_set.value().erase(current);
         continue;
       }
@@ -441,11 +767,37 @@ EvaluatorTableScanOp::IntersectColumnFilters(
                 return v1.SqlLessThan(v2) == values::True();
               });
     return std::make_unique<ColumnFilter>(in_list);
+  } else if (prefix.is_valid()) {
+    // We can only return one ColumnFilter, and the prefix is usually more
+    // selective than the range.
+    return std::make_unique<ColumnFilter>(ColumnFilter::Prefix(prefix));
   } else {
     return std::make_unique<ColumnFilter>(lower_bound, upper_bound);
   }
 }
 
+absl::StatusOr<absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>>>
+EvaluatorTableScanOp::EvalColumnFilterMap(
+    absl::Span<const std::unique_ptr<ColumnFilterArg>> and_filters,
+    absl::Span<const TupleData* const> params, EvaluationContext* context) {
+  absl::flat_hash_map<int, std::vector<std::unique_ptr<ColumnFilter>>>
+      filter_list_map;
+  for (const std::unique_ptr<ColumnFilterArg>& arg : and_filters) {
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ColumnFilter> filter,
+                     arg->Eval(params, context));
+    filter_list_map[arg->column_idx()].push_back(std::move(filter));
+  }
+
+  absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map;
+  for (const auto& entry : filter_list_map) {
+    const int column_idx = entry.first;
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ColumnFilter> filter,
+                     IntersectColumnFilters(entry.second));
+    ZETASQL_RET_CHECK(filter_map.emplace(column_idx, std::move(filter)).second);
+  }
+  return filter_map;
+}
+
 absl::Status EvaluatorTableScanOp::SetSchemasForEvaluation(
     absl::Span<const TupleSchema* const> params_schemas) {
   for (std::unique_ptr<ColumnFilterArg>& filter : and_filters_) {
@@ -482,6 +834,41 @@ class EvaluatorTableTupleIterator : public TupleIterator {
   const TupleSchema& Schema() const override { return *schema_; }
 
   TupleData* Next() override {
+    if (!AdvanceToNextRow()) return nullptr;
+    CopyCurrentRow(&current_);
+    return &current_;
+  }
+
+  bool NextBatch(TupleDataBatch* batch) override {
+    batch->Clear();
+    while (!done_ && !batch->full()) {
+      if (!AdvanceToNextRow()) {
+        done_ = true;
+        if (!status_.ok()) return false;
+        break;
+      }
+      CopyCurrentRow(batch->AddOwnedRow(current_.num_slots()));
+    }
+    return !batch->empty();
+  }
+
+  absl::Status Status() const override { return status_; }
+
+  void Close() override {
+    if (closed_) return;
+    closed_ = true;
+    evaluator_table_iter_->Cancel().IgnoreError();
+  }
+
+  std::string DebugString() const override {
+    return EvaluatorTableScanOp::GetIteratorDebugString(name_);
+  }
+
+ private:
+  // Advances 'evaluator_table_iter_' to the next row. Returns false if there
+  // is no next row or if there is an error, in which case 'status_' is
+  // updated.
+  bool AdvanceToNextRow() {
     if (!called_next_) {
       evaluator_table_iter_->SetDeadline(
           context_->GetStatementEvaluationDeadline());
@@ -489,7 +876,7 @@ class EvaluatorTableTupleIterator : public TupleIterator {
     }
     if (!evaluator_table_iter_->NextRow()) {
       status_ = evaluator_table_iter_->Status();
-      return nullptr;
+      return false;
     }
 
     if (schema_->num_variables() != evaluator_table_iter_->NumColumns()) {
@@ -497,116 +884,753 @@ class EvaluatorTableTupleIterator : public TupleIterator {
                 << "EvaluatorTableTupleIterator::Next() found wrong number of "
                 << "columns: " << current_.num_slots() << " vs. "
                 << evaluator_table_iter_->NumColumns();
-      return nullptr;
+      return false;
     }
+    return true;
+  }
 
+  // Copies the current row of 'evaluator_table_iter_' into 'data'.
+  void CopyCurrentRow(TupleData* data) {
     for (int i = 0; i < schema_->num_variables(); ++i) {
-      current_.mutable_slot(i)->SetValue(evaluator_table_iter_->GetValue(i));
+      data->mutable_slot(i)->SetValue(evaluator_table_iter_->GetValue(i));
     }
-    return &current_;
-  }
-
-  absl::Status Status() const override { return status_; }
-
-  std::string DebugString() const override {
-    return EvaluatorTableScanOp::GetIteratorDebugString(name_);
   }
 
- private:
   const std::string name_;
   const std::unique_ptr<TupleSchema> schema_;
   EvaluationContext* context_;
   bool called_next_ = false;
+  // True if NextBatch() has reached the end of 'evaluator_table_iter_'.
+  bool done_ = false;
+  // True if Close() has cancelled 'evaluator_table_iter_'.
+  bool closed_ = false;
   std::unique_ptr<EvaluatorTableIterator> evaluator_table_iter_;
   TupleData current_;
   absl::Status status_;
 };
-}  // namespace
 
-absl::StatusOr<std::unique_ptr<TupleIterator>>
-EvaluatorTableScanOp::CreateIterator(absl::Span<const TupleData* const> params,
-                                     int num_extra_slots,
-                                     EvaluationContext* context) const {
-  std::optional<absl::Time> read_time;
-  if (read_time_ != nullptr) {
-    std::shared_ptr<TupleSlot::SharedProtoState> shared_state;
-    Value time_value;
-    VirtualTupleSlot result(&time_value, &shared_state);
-    absl::Status status;
-    if (!read_time_->Eval(params, context, &result, &status)) {
-      return status;
+// Like EvaluatorTableTupleIterator, but reads the table on a background thread
+// into a buffer of up to 'max_buffered_rows' rows, so that the waits of
+// EvaluatorTableIterator::NextRow() (e.g., for I/O) overlap with the consumers
+// of the rows on the calling thread. Once reading has started, only the
+// background thread uses the EvaluatorTableIterator, except for Cancel(),
+// which is thread-safe.
+class PrefetchingEvaluatorTableTupleIterator : public TupleIterator {
+ public:
+  PrefetchingEvaluatorTableTupleIterator(
+      absl::string_view name, std::unique_ptr<TupleSchema> schema,
+      int num_extra_slots, EvaluationContext* context,
+      std::unique_ptr<EvaluatorTableIterator> evaluator_table_iter,
+      int max_buffered_rows)
+      : name_(name),
+        schema_(std::move(schema)),
+        num_slots_(schema_->num_variables() + num_extra_slots),
+        context_(context),
+        evaluator_table_iter_(std::move(evaluator_table_iter)),
+        max_buffered_rows_(max_buffered_rows) {
+    context_->RegisterCancelCallback(
+        [this] { return evaluator_table_iter_->Cancel(); });
+  }
+
+  PrefetchingEvaluatorTableTupleIterator(
+      const PrefetchingEvaluatorTableTupleIterator&) = delete;
+  PrefetchingEvaluatorTableTupleIterator& operator=(
+      const PrefetchingEvaluatorTableTupleIterator&) = delete;
+
+  ~PrefetchingEvaluatorTableTupleIterator() override { StopReader(); }
+
+  const TupleSchema& Schema() const override { return *schema_; }
+
+  TupleData* Next() override {
+    if (!started_) {
+      started_ = true;
+      if (schema_->num_variables() != evaluator_table_iter_->NumColumns()) {
+        status_ = zetasql_base::InternalErrorBuilder()
+                  << "PrefetchingEvaluatorTableTupleIterator::Next() found "
+                  << "wrong number of columns: " << schema_->num_variables()
+                  << " vs. " << evaluator_table_iter_->NumColumns();
+        return nullptr;
+      }
+      // The deadline may change between creating the iterator and reading
+      // from it, so it is only passed on here.
+      evaluator_table_iter_->SetDeadline(
+          context_->GetStatementEvaluationDeadline());
+      StartReader();
     }
 
-    // The resolver should have already verified that the FOR SYSTEM TIME AS OF
-    // expression is a timestamp.
-    ZETASQL_RET_CHECK(time_value.type()->IsTimestamp());
-    read_time = time_value.ToTime();
+    absl::MutexLock lock(&mutex_);
+    mutex_.Await(absl::Condition(
+        this, &PrefetchingEvaluatorTableTupleIterator::HasRowOrIsDone));
+    if (buffer_.empty()) {
+      status_ = reader_status_;
+      return nullptr;
+    }
+    current_ = std::move(buffer_.front());
+    buffer_.pop_front();
+    return &current_;
   }
 
-  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> evaluator_table_iter,
-                   table_->CreateEvaluatorTableIterator(column_idxs_));
-  if (read_time.has_value()) {
-    ZETASQL_RETURN_IF_ERROR(evaluator_table_iter->SetReadTime(read_time.value()));
-  }
+  absl::Status Status() const override { return status_; }
 
-  absl::flat_hash_map<int, std::vector<std::unique_ptr<ColumnFilter>>>
-      filter_list_map;
-  for (const std::unique_ptr<ColumnFilterArg>& arg : and_filters_) {
-    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ColumnFilter> filter,
-                     arg->Eval(params, context));
-    filter_list_map[arg->column_idx()].push_back(std::move(filter));
-  }
+  void Close() override { StopReader(); }
 
-  absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map;
-  for (const auto& entry : filter_list_map) {
-    const int column_idx = entry.first;
-    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ColumnFilter> filter,
-                     IntersectColumnFilters(entry.second));
-    ZETASQL_RET_CHECK(filter_map.emplace(column_idx, std::move(filter)).second);
+  std::string DebugString() const override {
+    return EvaluatorTableScanOp::GetIteratorDebugString(name_);
   }
 
-  ZETASQL_RETURN_IF_ERROR(
-      evaluator_table_iter->SetColumnFilterMap(std::move(filter_map)));
-
-  std::unique_ptr<TupleIterator> tuple_iter =
-      std::make_unique<EvaluatorTableTupleIterator>(
-          table_->Name(), CreateOutputSchema(), num_extra_slots, context,
-          std::move(evaluator_table_iter));
-  return MaybeReorder(std::move(tuple_iter), context);
-}
+ private:
+  // Runs ReadRows() on 'reader_', or as a task of the executor of the
+  // evaluation if it has one.
+  void StartReader() {
+    EvaluatorExecutor* executor = context_->options().executor;
+    if (executor == nullptr) {
+      reader_ = std::thread([this] { ReadRows(); });
+      return;
+    }
+    executor->Schedule([this, task = reader_task_] {
+      {
+        absl::MutexLock lock(&task->mutex);
+        if (task->abandoned) return;
+        task->started = true;
+      }
+      ReadRows();
+      absl::MutexLock lock(&task->mutex);
+      task->finished = true;
+    });
+  }
 
-std::unique_ptr<TupleSchema> EvaluatorTableScanOp::CreateOutputSchema() const {
-  return std::make_unique<TupleSchema>(variables_);
-}
+  // Runs on 'reader_' or the executor task. Reads rows into 'buffer_' until
+  // the table ends, reading fails, or StopReader() is called.
+  void ReadRows() {
+    while (true) {
+      const bool has_row = evaluator_table_iter_->NextRow();
+      TupleData row(num_slots_);
+      if (has_row) {
+        for (int i = 0; i < schema_->num_variables(); ++i) {
+          row.mutable_slot(i)->SetValue(evaluator_table_iter_->GetValue(i));
+        }
+      }
 
-std::string EvaluatorTableScanOp::IteratorDebugString() const {
-  return GetIteratorDebugString(table_->Name());
-}
+      absl::MutexLock lock(&mutex_);
+      if (!has_row) {
+        reader_status_ = evaluator_table_iter_->Status();
+        reader_done_ = true;
+        return;
+      }
+      mutex_.Await(absl::Condition(
+          this, &PrefetchingEvaluatorTableTupleIterator::HasRoomOrIsStopping));
+      if (stopping_) {
+        reader_done_ = true;
+        return;
+      }
+      buffer_.push_back(std::move(row));
+    }
+  }
 
-std::string EvaluatorTableScanOp::DebugInternal(const std::string& indent,
-                                                bool verbose) const {
-  const std::string indent_input = absl::StrCat(indent, kIndentFork);
+  // Stops and joins the reader, if it is running, and frees the buffered
+  // rows. An executor task that has not started yet is abandoned instead.
+  void StopReader() {
+    bool reader_running;
+    {
+      absl::MutexLock lock(&mutex_);
+      if (stopping_) return;
+      stopping_ = true;
+      buffer_.clear();
+      reader_running = started_ && !reader_done_;
+    }
+    if (reader_running) {
+      // Unblocks a NextRow() that is waiting for more data.
+      evaluator_table_iter_->Cancel().IgnoreError();
+    }
+    if (reader_.joinable()) reader_.join();
+    absl::MutexLock lock(&reader_task_->mutex);
+    reader_task_->abandoned = true;
+    reader_task_->mutex.Await(
+        absl::Condition(reader_task_.get(), &ReaderTask::IsNotRunning));
+  }
 
-  std::vector<std::string> column_strings;
-  ABSL_CHECK_EQ(column_names_.size(), column_idxs_.size());
-  column_strings.reserve(column_names_.size());
-  for (int i = 0; i < column_names_.size(); ++i) {
-    column_strings.push_back(
-        absl::StrCat(column_names_[i], "#", column_idxs_[i]));
+  bool HasRowOrIsDone() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return !buffer_.empty() || reader_done_;
   }
 
-  std::vector<std::string> filter_strings;
-  filter_strings.reserve(and_filters_.size());
-  for (const std::unique_ptr<ColumnFilterArg>& filter : and_filters_) {
-    filter_strings.push_back(filter->DebugInternal(indent_input, verbose));
+  bool HasRoomOrIsStopping() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return static_cast<int64_t>(buffer_.size()) < max_buffered_rows_ ||
+           stopping_;
   }
 
-  return absl::StrCat(
-      "EvaluatorTableScanOp(", column_names_.empty() ? "" : indent_input,
-      absl::StrJoin(column_strings, indent_input),
-      filter_strings.empty() ? "" : indent_input,
-      absl::StrJoin(filter_strings, indent_input), indent_input,
-      "table: ", table_->Name(),
+  const std::string name_;
+  const std::unique_ptr<TupleSchema> schema_;
+  const int num_slots_;
+  EvaluationContext* context_;
+  const std::unique_ptr<EvaluatorTableIterator> evaluator_table_iter_;
+  const int max_buffered_rows_;
+
+  // True once the first call to Next() has started the reader.
+  bool started_ = false;
+  TupleData current_;
+  absl::Status status_;
+
+  // Protects the state shared with 'reader_'.
+  absl::Mutex mutex_;
+  // Rows read by 'reader_' but not yet returned by Next(), in table order.
+  std::deque<TupleData> buffer_ ABSL_GUARDED_BY(mutex_);
+  // True once 'reader_' has stopped adding rows to 'buffer_'.
+  bool reader_done_ ABSL_GUARDED_BY(mutex_) = false;
+  // The status of 'evaluator_table_iter_' once 'reader_' reached its end.
+  absl::Status reader_status_ ABSL_GUARDED_BY(mutex_);
+  // Set by StopReader() to make the reader exit.
+  bool stopping_ ABSL_GUARDED_BY(mutex_) = false;
+
+  // The state of the reader when it runs as a task of the executor, which
+  // may start after this iterator is destroyed.
+  struct ReaderTask {
+    bool IsNotRunning() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex) {
+      return !started || finished;
+    }
+
+    absl::Mutex mutex;
+    // Set by StopReader() to keep a task that has not started from reading.
+    bool abandoned ABSL_GUARDED_BY(mutex) = false;
+    bool started ABSL_GUARDED_BY(mutex) = false;
+    bool finished ABSL_GUARDED_BY(mutex) = false;
+  };
+  const std::shared_ptr<ReaderTask> reader_task_ =
+      std::make_shared<ReaderTask>();
+  // Declared last so that it is started after, and joined before, the
+  // destruction of the members it uses.
+  std::thread reader_;
+};
+
+// Like EvaluatorTableTupleIterator, but splits the table into morsels of
+// consecutive rows (see EvaluatorTableIterator::SetRowRange()) and reads them
+// with multiple threads. Morsels are read in waves of a few per thread, and
+// their rows are returned in table order, so the output is the same as for
+// EvaluatorTableTupleIterator. Only reading the table happens on the helper
+// threads; the consumers of the rows run on the calling thread.
+class ParallelEvaluatorTableTupleIterator : public TupleIterator {
+ public:
+  // Returns a new EvaluatorTableIterator for the scan, with its read time and
+  // column filters already set.
+  using IteratorFactory = std::function<
+      absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>>()>;
+
+  // The number of rows in a morsel.
+  static constexpr int64_t kRowsPerMorsel = 1024;
+  // The number of morsels per thread in a wave. More than one so that threads
+  // that get cheap morsels (e.g., mostly filtered out) can take more.
+  static constexpr int kMorselsPerThreadPerWave = 4;
+
+  ParallelEvaluatorTableTupleIterator(absl::string_view name,
+                                      std::unique_ptr<TupleSchema> schema,
+                                      int num_extra_slots,
+                                      EvaluationContext* context,
+                                      IteratorFactory iterator_factory,
+                                      int64_t num_rows, int num_threads)
+      : name_(name),
+        schema_(std::move(schema)),
+        num_slots_(schema_->num_variables() + num_extra_slots),
+        context_(context),
+        iterator_factory_(std::move(iterator_factory)),
+        num_rows_(num_rows),
+        num_threads_(num_threads) {
+    context_->RegisterCancelCallback([this] {
+      absl::MutexLock lock(&mutex_);
+      cancelled_ = true;
+      for (EvaluatorTableIterator* iter : wave_iters_) {
+        iter->Cancel().IgnoreError();
+      }
+      return absl::OkStatus();
+    });
+  }
+
+  ParallelEvaluatorTableTupleIterator(
+      const ParallelEvaluatorTableTupleIterator&) = delete;
+  ParallelEvaluatorTableTupleIterator& operator=(
+      const ParallelEvaluatorTableTupleIterator&) = delete;
+
+  const TupleSchema& Schema() const override { return *schema_; }
+
+  TupleData* Next() override {
+    while (next_row_in_wave_ == wave_rows_.size()) {
+      if (next_morsel_begin_ >= num_rows_) return nullptr;
+      status_ = ReadNextWave();
+      if (!status_.ok()) return nullptr;
+    }
+    return &wave_rows_[next_row_in_wave_++];
+  }
+
+  absl::Status Status() const override { return status_; }
+
+  void Close() override {
+    {
+      absl::MutexLock lock(&mutex_);
+      cancelled_ = true;
+    }
+    wave_rows_.clear();
+    next_row_in_wave_ = 0;
+  }
+
+  std::string DebugString() const override {
+    return EvaluatorTableScanOp::GetIteratorDebugString(name_);
+  }
+
+ private:
+  // Reads the next wave of morsels into 'wave_rows_'.
+  absl::Status ReadNextWave() {
+    // Creating and configuring the iterators happens on this thread, since
+    // Table::CreateEvaluatorTableIterator() need not be thread-safe.
+    std::vector<std::unique_ptr<EvaluatorTableIterator>> iters;
+    const int max_morsels = num_threads_ * kMorselsPerThreadPerWave;
+    while (iters.size() < max_morsels && next_morsel_begin_ < num_rows_) {
+      ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       iterator_factory_());
+      ZETASQL_RET_CHECK_EQ(iter->NumColumns(), schema_->num_variables())
+          << "ParallelEvaluatorTableTupleIterator found wrong number of "
+          << "columns";
+      const int64_t end =
+          std::min(num_rows_, next_morsel_begin_ + kRowsPerMorsel);
+      ZETASQL_RETURN_IF_ERROR(iter->SetRowRange(next_morsel_begin_, end));
+      iter->SetDeadline(context_->GetStatementEvaluationDeadline());
+      next_morsel_begin_ = end;
+      iters.push_back(std::move(iter));
+    }
+
+    {
+      absl::MutexLock lock(&mutex_);
+      if (cancelled_) {
+        return zetasql_base::CancelledErrorBuilder()
+               << "ParallelEvaluatorTableTupleIterator was cancelled";
+      }
+      for (const auto& iter : iters) {
+        wave_iters_.push_back(iter.get());
+      }
+    }
+
+    std::vector<std::vector<TupleData>> morsel_rows(iters.size());
+    const absl::Status status =
+        ParallelFor(
+            num_threads_, iters.size(),
+            [&](int morsel) {
+              EvaluatorTableIterator* iter = iters[morsel].get();
+              std::vector<TupleData>& rows = morsel_rows[morsel];
+              while (iter->NextRow()) {
+                TupleData& row = rows.emplace_back(num_slots_);
+                for (int i = 0; i < schema_->num_variables(); ++i) {
+                  row.mutable_slot(i)->SetValue(iter->GetValue(i));
+                }
+              }
+              return iter->Status();
+            },
+            context_->options().executor);
+
+    {
+      absl::MutexLock lock(&mutex_);
+      wave_iters_.clear();
+    }
+    ZETASQL_RETURN_IF_ERROR(status);
+
+    wave_rows_.clear();
+    next_row_in_wave_ = 0;
+    for (std::vector<TupleData>& rows : morsel_rows) {
+      for (TupleData& row : rows) {
+        wave_rows_.push_back(std::move(row));
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  const std::string name_;
+  const std::unique_ptr<TupleSchema> schema_;
+  const int num_slots_;
+  EvaluationContext* context_;
+  const IteratorFactory iterator_factory_;
+  const int64_t num_rows_;
+  const int num_threads_;
+
+  // The first row of the next morsel to read.
+  int64_t next_morsel_begin_ = 0;
+  // The rows of the current wave, in table order.
+  std::vector<TupleData> wave_rows_;
+  int64_t next_row_in_wave_ = 0;
+  absl::Status status_;
+
+  // Protects the state shared with the cancel callback, which may run on any
+  // thread.
+  absl::Mutex mutex_;
+  bool cancelled_ ABSL_GUARDED_BY(mutex_) = false;
+  // The iterators of the wave being read, if any.
+  std::vector<EvaluatorTableIterator*> wave_iters_ ABSL_GUARDED_BY(mutex_);
+};
+
+// Reads a table whose iterators support SetRowRange() in blocks of
+// consecutive rows, keeping each block with probability 'fraction' and never
+// reading the blocks that are skipped. Used for TABLESAMPLE SYSTEM. The rows of
+// the kept blocks are returned in table order.
+class BlockSampledEvaluatorTableTupleIterator : public TupleIterator {
+ public:
+  using IteratorFactory = EvaluatorTableScanOp::TableIteratorFactory;
+
+  // The number of rows in a block.
+  static constexpr int64_t kRowsPerBlock = 1024;
+
+  BlockSampledEvaluatorTableTupleIterator(
+      absl::string_view debug_string, std::unique_ptr<TupleSchema> schema,
+      int num_extra_slots, EvaluationContext* context,
+      IteratorFactory iterator_factory, int64_t num_rows, double fraction,
+      std::optional<int64_t> seed)
+      : debug_string_(debug_string),
+        schema_(std::move(schema)),
+        context_(context),
+        iterator_factory_(std::move(iterator_factory)),
+        num_rows_(num_rows),
+        fraction_(fraction),
+        bitgen_(seed.has_value() ? absl::BitGen(std::seed_seq{*seed})
+                                 : absl::BitGen()),
+        current_(schema_->num_variables() + num_extra_slots) {
+    context_->RegisterCancelCallback([this] {
+      absl::MutexLock lock(&mutex_);
+      cancelled_ = true;
+      if (block_iter_ != nullptr) {
+        block_iter_->Cancel().IgnoreError();
+      }
+      return absl::OkStatus();
+    });
+  }
+
+  BlockSampledEvaluatorTableTupleIterator(
+      const BlockSampledEvaluatorTableTupleIterator&) = delete;
+  BlockSampledEvaluatorTableTupleIterator& operator=(
+      const BlockSampledEvaluatorTableTupleIterator&) = delete;
+
+  const TupleSchema& Schema() const override { return *schema_; }
+
+  TupleData* Next() override {
+    while (block_iter_ == nullptr || !block_iter_->NextRow()) {
+      if (block_iter_ != nullptr) {
+        status_ = block_iter_->Status();
+        if (!status_.ok()) return nullptr;
+      }
+      status_ = StartNextSampledBlock();
+      if (!status_.ok() || block_iter_ == nullptr) return nullptr;
+    }
+    for (int i = 0; i < schema_->num_variables(); ++i) {
+      current_.mutable_slot(i)->SetValue(block_iter_->GetValue(i));
+    }
+    return &current_;
+  }
+
+  absl::Status Status() const override { return status_; }
+
+  void Close() override {
+    absl::MutexLock lock(&mutex_);
+    cancelled_ = true;
+    if (block_iter_ != nullptr) {
+      block_iter_->Cancel().IgnoreError();
+    }
+  }
+
+  std::string DebugString() const override { return debug_string_; }
+
+ private:
+  // Skips blocks until one is kept, and points 'block_iter_' at it. Sets
+  // 'block_iter_' to nullptr if there are no more blocks to keep.
+  absl::Status StartNextSampledBlock() {
+    std::unique_ptr<EvaluatorTableIterator> iter;
+    while (iter == nullptr && next_block_begin_ < num_rows_) {
+      const int64_t begin = next_block_begin_;
+      const int64_t end = std::min(num_rows_, begin + kRowsPerBlock);
+      next_block_begin_ = end;
+      if (!absl::Bernoulli(bitgen_, fraction_)) continue;
+
+      ZETASQL_ASSIGN_OR_RETURN(iter, iterator_factory_());
+      ZETASQL_RET_CHECK_EQ(iter->NumColumns(), schema_->num_variables())
+          << "BlockSampledEvaluatorTableTupleIterator found wrong number of "
+          << "columns";
+      ZETASQL_RETURN_IF_ERROR(iter->SetRowRange(begin, end));
+      iter->SetDeadline(context_->GetStatementEvaluationDeadline());
+    }
+
+    absl::MutexLock lock(&mutex_);
+    if (cancelled_) {
+      return zetasql_base::CancelledErrorBuilder()
+             << "BlockSampledEvaluatorTableTupleIterator was cancelled";
+    }
+    block_iter_ = std::move(iter);
+    return absl::OkStatus();
+  }
+
+  const std::string debug_string_;
+  const std::unique_ptr<TupleSchema> schema_;
+  EvaluationContext* context_;
+  const IteratorFactory iterator_factory_;
+  const int64_t num_rows_;
+  const double fraction_;
+  absl::BitGen bitgen_;
+
+  // The first row of the next block to consider.
+  int64_t next_block_begin_ = 0;
+  TupleData current_;
+  absl::Status status_;
+
+  // Protects the state shared with the cancel callback, which may run on any
+  // thread.
+  absl::Mutex mutex_;
+  bool cancelled_ ABSL_GUARDED_BY(mutex_) = false;
+  // The iterator over the current block, if any. Only this thread changes it,
+  // so it is read without 'mutex_' on this thread.
+  std::unique_ptr<EvaluatorTableIterator> block_iter_;
+};
+
+// Filters out the tuples of a table scan whose join key is not in the
+// JoinKeyFilter of its column. The EvaluatorTableIterator may ignore the
+// ColumnFilters made from the filters, so this must still check every tuple.
+class JoinKeyFilterTupleIterator : public TupleIterator {
+ public:
+  // Each entry of 'filters' is the index of a slot in the tuples of 'iter',
+  // and the filter that the value of the slot must match.
+  JoinKeyFilterTupleIterator(
+      std::unique_ptr<TupleIterator> iter,
+      std::vector<std::pair<int, std::shared_ptr<const JoinKeyFilter>>>
+          filters)
+      : iter_(std::move(iter)), filters_(std::move(filters)) {}
+
+  JoinKeyFilterTupleIterator(const JoinKeyFilterTupleIterator&) = delete;
+  JoinKeyFilterTupleIterator& operator=(const JoinKeyFilterTupleIterator&) =
+      delete;
+
+  const TupleSchema& Schema() const override { return iter_->Schema(); }
+
+  TupleData* Next() override {
+    while (true) {
+      TupleData* current = iter_->Next();
+      if (current == nullptr || Matches(*current)) return current;
+    }
+  }
+
+  bool NextBatch(TupleDataBatch* batch) override {
+    while (true) {
+      if (!iter_->NextBatch(batch)) return false;
+
+      // Compact the matching rows to the front of the batch.
+      int num_matches = 0;
+      for (int i = 0; i < batch->size(); ++i) {
+        TupleData* current = batch->row(i);
+        if (Matches(*current)) {
+          batch->SetRow(num_matches, current);
+          ++num_matches;
+        }
+      }
+      batch->Truncate(num_matches);
+      if (!batch->empty()) return true;
+    }
+  }
+
+  absl::Status Status() const override { return iter_->Status(); }
+
+  bool PreservesOrder() const override { return iter_->PreservesOrder(); }
+
+  absl::Status DisableReordering() override {
+    return iter_->DisableReordering();
+  }
+
+  void Close() override { iter_->Close(); }
+
+  std::string DebugString() const override { return iter_->DebugString(); }
+
+ private:
+  bool Matches(const TupleData& tuple) const {
+    for (const auto& [slot_idx, filter] : filters_) {
+      if (!filter->MayContain(tuple.slot(slot_idx).value())) return false;
+    }
+    return true;
+  }
+
+  std::unique_ptr<TupleIterator> iter_;
+  const std::vector<std::pair<int, std::shared_ptr<const JoinKeyFilter>>>
+      filters_;
+};
+}  // namespace
+
+absl::Status EvaluatorTableScanOp::AddJoinKeyFilter(
+    int filter_id, const VariableId& variable) {
+  auto it = std::find(variables_.begin(), variables_.end(), variable);
+  ZETASQL_RET_CHECK(it != variables_.end())
+      << "Join key " << variable << " is not produced by the scan of "
+      << table_->Name();
+  join_key_filters_.emplace_back(filter_id,
+                                 static_cast<int>(it - variables_.begin()));
+  return absl::OkStatus();
+}
+
+std::vector<std::pair<int, std::shared_ptr<const JoinKeyFilter>>>
+EvaluatorTableScanOp::GetJoinKeyFilters(
+    const EvaluationContext* context) const {
+  std::vector<std::pair<int, std::shared_ptr<const JoinKeyFilter>>> filters;
+  for (const auto& [filter_id, column] : join_key_filters_) {
+    std::shared_ptr<const JoinKeyFilter> filter =
+        context->GetJoinKeyFilter(filter_id);
+    if (filter != nullptr) filters.emplace_back(column, std::move(filter));
+  }
+  return filters;
+}
+
+absl::StatusOr<EvaluatorTableScanOp::TableIteratorFactory>
+EvaluatorTableScanOp::CreateTableIteratorFactory(
+    absl::Span<const TupleData* const> params,
+    EvaluationContext* context) const {
+  std::optional<absl::Time> read_time;
+  if (read_time_ != nullptr) {
+    std::shared_ptr<TupleSlot::SharedProtoState> shared_state;
+    Value time_value;
+    VirtualTupleSlot result(&time_value, &shared_state);
+    absl::Status status;
+    if (!read_time_->Eval(params, context, &result, &status)) {
+      return status;
+    }
+
+    // The resolver should have already verified that the FOR SYSTEM TIME AS OF
+    // expression is a timestamp.
+    ZETASQL_RET_CHECK(time_value.type()->IsTimestamp());
+    read_time = time_value.ToTime();
+  }
+
+  absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map;
+  ZETASQL_ASSIGN_OR_RETURN(filter_map,
+                   EvalColumnFilterMap(and_filters_, params, context));
+  for (const auto& [column, join_key_filter] : GetJoinKeyFilters(context)) {
+    std::unique_ptr<ColumnFilter> filter = join_key_filter->MakeColumnFilter();
+    if (filter == nullptr) continue;
+    auto [it, inserted] = filter_map.try_emplace(column, std::move(filter));
+    if (!inserted) {
+      std::vector<std::unique_ptr<ColumnFilter>> filters;
+      filters.push_back(std::move(it->second));
+      filters.push_back(std::move(filter));
+      ZETASQL_ASSIGN_OR_RETURN(it->second, IntersectColumnFilters(filters));
+    }
+  }
+
+  // Creates an iterator over the table with 'read_time' and a copy of
+  // 'filter_map'.
+  return [table = table_, column_idxs = column_idxs_,
+          referenced_columns = referenced_columns_, read_time,
+          filter_map = std::make_shared<const decltype(filter_map)>(
+              std::move(filter_map))]()
+             -> absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>> {
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> iter,
+                     table->CreateEvaluatorTableIterator(column_idxs));
+    if (read_time.has_value()) {
+      ZETASQL_RETURN_IF_ERROR(iter->SetReadTime(read_time.value()));
+    }
+    if (referenced_columns.has_value()) {
+      ZETASQL_RETURN_IF_ERROR(iter->SetReferencedColumns(referenced_columns.value()));
+    }
+    absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map_copy;
+    for (const auto& [column_idx, filter] : *filter_map) {
+      filter_map_copy.emplace(column_idx,
+                              std::make_unique<ColumnFilter>(*filter));
+    }
+    ZETASQL_RETURN_IF_ERROR(iter->SetColumnFilterMap(std::move(filter_map_copy)));
+    return iter;
+  };
+}
+
+absl::StatusOr<std::unique_ptr<TupleIterator>>
+EvaluatorTableScanOp::CreateIteratorImpl(
+    absl::Span<const TupleData* const> params, int num_extra_slots,
+    EvaluationContext* context) const {
+  // Outlives this method if the scan is split into morsels.
+  ZETASQL_ASSIGN_OR_RETURN(TableIteratorFactory create_table_iter,
+                   CreateTableIteratorFactory(params, context));
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> evaluator_table_iter,
+                   create_table_iter());
+
+  // A restricted scan is not split into morsels, whose iterators would read
+  // the whole table.
+  const std::optional<std::pair<int64_t, int64_t>> row_range =
+      context->GetTableRowRange(table_);
+  if (row_range.has_value()) {
+    ZETASQL_RETURN_IF_ERROR(evaluator_table_iter->SetRowRange(row_range->first,
+                                                      row_range->second));
+  }
+
+  std::unique_ptr<TupleIterator> tuple_iter;
+  const int num_threads = context->options().num_threads;
+  const std::optional<int64_t> num_rows =
+      num_threads > 1 && !row_range.has_value()
+          ? evaluator_table_iter->GetNumRowsForSplitting()
+          : std::nullopt;
+  if (num_rows.has_value() &&
+      num_rows.value() >
+          ParallelEvaluatorTableTupleIterator::kRowsPerMorsel) {
+    tuple_iter = std::make_unique<ParallelEvaluatorTableTupleIterator>(
+        table_->Name(), CreateOutputSchema(), num_extra_slots, context,
+        std::move(create_table_iter), num_rows.value(), num_threads);
+  } else if (context->options().scan_prefetch_rows > 0) {
+    tuple_iter = std::make_unique<PrefetchingEvaluatorTableTupleIterator>(
+        table_->Name(), CreateOutputSchema(), num_extra_slots, context,
+        std::move(evaluator_table_iter),
+        context->options().scan_prefetch_rows);
+  } else {
+    tuple_iter = std::make_unique<EvaluatorTableTupleIterator>(
+        table_->Name(), CreateOutputSchema(), num_extra_slots, context,
+        std::move(evaluator_table_iter));
+  }
+  std::vector<std::pair<int, std::shared_ptr<const JoinKeyFilter>>>
+      join_key_filters = GetJoinKeyFilters(context);
+  if (!join_key_filters.empty()) {
+    tuple_iter = std::make_unique<JoinKeyFilterTupleIterator>(
+        std::move(tuple_iter), std::move(join_key_filters));
+  }
+  return MaybeReorder(std::move(tuple_iter), context);
+}
+
+std::unique_ptr<TupleSchema> EvaluatorTableScanOp::CreateOutputSchema() const {
+  return std::make_unique<TupleSchema>(variables_);
+}
+
+std::string EvaluatorTableScanOp::IteratorDebugString() const {
+  return GetIteratorDebugString(table_->Name());
+}
+
+std::string EvaluatorTableScanOp::DebugInternal(const std::string& indent,
+                                                bool verbose) const {
+  const std::string indent_input = absl::StrCat(indent, kIndentFork);
+
+  std::vector<std::string> column_strings;
+  ABSL_CHECK_EQ(column_names_.size(), column_idxs_.size());
+  column_strings.reserve(column_names_.size());
+  for (int i = 0; i < column_names_.size(); ++i) {
+    column_strings.push_back(
+        absl::StrCat(column_names_[i], "#", column_idxs_[i]));
+  }
+
+  std::vector<std::string> filter_strings;
+  filter_strings.reserve(and_filters_.size());
+  for (const std::unique_ptr<ColumnFilterArg>& filter : and_filters_) {
+    filter_strings.push_back(filter->DebugInternal(indent_input, verbose));
+  }
+
+  std::vector<std::string> join_key_filter_strings;
+  join_key_filter_strings.reserve(join_key_filters_.size());
+  for (const auto& [filter_id, column] : join_key_filters_) {
+    join_key_filter_strings.push_back(
+        absl::StrCat("$", filter_id, " on ", variables_[column].ToString()));
+  }
+
+  return absl::StrCat(
+      "EvaluatorTableScanOp(", column_names_.empty() ? "" : indent_input,
+      absl::StrJoin(column_strings, indent_input),
+      filter_strings.empty() ? "" : indent_input,
+      absl::StrJoin(filter_strings, indent_input),
+      join_key_filter_strings.empty()
+          ? ""
+          : absl::StrCat(indent_input, "join_key_filters: ",
+                         absl::StrJoin(join_key_filter_strings, ", ")),
+      referenced_columns_.has_value()
+          ? absl::StrCat(indent_input, "referenced_columns: ",
+                         absl::StrJoin(referenced_columns_.value(), ", "))
+          : "",
+      indent_input, "table: ", table_->Name(),
       alias_.empty() ? "" : absl::StrCat(indent_input, "alias: ", alias_), ")");
 }
 
@@ -625,6 +1649,91 @@ EvaluatorTableScanOp::EvaluatorTableScanOp(
       and_filters_(std::move(and_filters)),
       read_time_(std::move(read_time)) {}
 
+// -------------------------------------------------------
+// ExchangeOp
+// -------------------------------------------------------
+
+std::string ExchangeOp::GetIteratorDebugString(int exchange_id) {
+  return EvaluatorTableScanOp::GetIteratorDebugString(
+      absl::StrCat("exchange ", exchange_id));
+}
+
+absl::StatusOr<std::unique_ptr<ExchangeOp>> ExchangeOp::Create(
+    int exchange_id, std::vector<std::unique_ptr<ExprArg>> columns,
+    ExchangeReceiver* receiver) {
+  ZETASQL_RET_CHECK(receiver != nullptr);
+  for (const std::unique_ptr<ExprArg>& column : columns) {
+    ZETASQL_RET_CHECK(column->has_variable());
+    ZETASQL_RET_CHECK(!column->has_node());
+  }
+  return absl::WrapUnique(
+      new ExchangeOp(exchange_id, std::move(columns), receiver));
+}
+
+absl::Status ExchangeOp::SetSchemasForEvaluation(
+    absl::Span<const TupleSchema* const> params_schemas) {
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::unique_ptr<TupleIterator>> ExchangeOp::CreateIteratorImpl(
+    absl::Span<const TupleData* const> params, int num_extra_slots,
+    EvaluationContext* context) const {
+  std::vector<const Type*> column_types;
+  column_types.reserve(columns().size());
+  for (const ExprArg* column : columns()) {
+    column_types.push_back(column->type());
+  }
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> evaluator_table_iter,
+                   receiver_->Receive(exchange_id_, column_types));
+  ZETASQL_RET_CHECK_EQ(evaluator_table_iter->NumColumns(), column_types.size());
+  for (int i = 0; i < column_types.size(); ++i) {
+    if (!evaluator_table_iter->GetColumnType(i)->Equals(column_types[i])) {
+      return zetasql_base::InternalErrorBuilder()
+             << "Exchange " << exchange_id_ << " received column " << i
+             << " of type "
+             << evaluator_table_iter->GetColumnType(i)->DebugString()
+             << " instead of " << column_types[i]->DebugString();
+    }
+  }
+  std::unique_ptr<TupleIterator> iter =
+      std::make_unique<EvaluatorTableTupleIterator>(
+          absl::StrCat("exchange ", exchange_id_), CreateOutputSchema(),
+          num_extra_slots, context, std::move(evaluator_table_iter));
+  return MaybeReorder(std::move(iter), context);
+}
+
+std::unique_ptr<TupleSchema> ExchangeOp::CreateOutputSchema() const {
+  std::vector<VariableId> variables;
+  variables.reserve(columns().size());
+  for (const ExprArg* column : columns()) {
+    variables.push_back(column->variable());
+  }
+  return std::make_unique<TupleSchema>(variables);
+}
+
+std::string ExchangeOp::IteratorDebugString() const {
+  return GetIteratorDebugString(exchange_id_);
+}
+
+std::string ExchangeOp::DebugInternal(const std::string& indent,
+                                      bool verbose) const {
+  return absl::StrCat("ExchangeOp(",
+                      ArgDebugString({"columns"}, {kN}, indent, verbose,
+                                     /*more_children=*/true),
+                      indent, kIndentFork, "exchange_id: ", exchange_id_, ")");
+}
+
+ExchangeOp::ExchangeOp(int exchange_id,
+                       std::vector<std::unique_ptr<ExprArg>> columns,
+                       ExchangeReceiver* receiver)
+    : exchange_id_(exchange_id), receiver_(receiver) {
+  SetArgs<ExprArg>(kColumn, std::move(columns));
+}
+
+absl::Span<const ExprArg* const> ExchangeOp::columns() const {
+  return GetArgs<ExprArg>(kColumn);
+}
+
 // -------------------------------------------------------
 // TVFOp
 // -------------------------------------------------------
@@ -750,6 +1859,12 @@ class EvaluatorTVFTupleIterator : public TupleIterator {
 
   absl::Status Status() const override { return status_; }
 
+  void Close() override {
+    if (closed_) return;
+    closed_ = true;
+    evaluator_table_iter_->Cancel().IgnoreError();
+  }
+
   std::string DebugString() const override {
     return EvaluatorTableScanOp::GetIteratorDebugString(name_);
   }
@@ -760,6 +1875,8 @@ class EvaluatorTVFTupleIterator : public TupleIterator {
   const std::vector<int64_t> tuple_indexes_;
   EvaluationContext* context_;
   bool called_next_ = false;
+  // True if Close() has cancelled 'evaluator_table_iter_'.
+  bool closed_ = false;
   std::unique_ptr<EvaluatorTableIterator> evaluator_table_iter_;
   TupleData current_;
   absl::Status status_;
@@ -770,22 +1887,29 @@ class EvaluatorTVFTupleIterator : public TupleIterator {
     const TableValuedFunction* tvf, std::vector<TVFOpArgument> arguments,
     std::vector<TVFSchemaColumn> output_columns,
     std::vector<VariableId> variables,
-    std::shared_ptr<FunctionSignature> function_call_signature) {
-  return absl::WrapUnique(
-      new TVFOp(tvf, std::move(arguments), std::move(output_columns),
-                std::move(variables), std::move(function_call_signature)));
+    std::shared_ptr<FunctionSignature> function_call_signature,
+    std::vector<std::unique_ptr<ColumnFilterArg>> and_filters) {
+  for (const std::unique_ptr<ColumnFilterArg>& filter : and_filters) {
+    ZETASQL_RET_CHECK_LT(filter->column_idx(), output_columns.size());
+  }
+  return absl::WrapUnique(new TVFOp(
+      tvf, std::move(arguments), std::move(output_columns),
+      std::move(variables), std::move(function_call_signature),
+      std::move(and_filters)));
 }
 
 TVFOp::TVFOp(const TableValuedFunction* tvf,
              std::vector<TVFOpArgument> arguments,
              std::vector<TVFSchemaColumn> output_columns,
              std::vector<VariableId> variables,
-             std::shared_ptr<FunctionSignature> function_call_signature)
+             std::shared_ptr<FunctionSignature> function_call_signature,
+             std::vector<std::unique_ptr<ColumnFilterArg>> and_filters)
     : tvf_(tvf),
       arguments_(std::move(arguments)),
       output_columns_(std::move(output_columns)),
       variables_(std::move(variables)),
-      function_call_signature_(std::move(function_call_signature)) {}
+      function_call_signature_(std::move(function_call_signature)),
+      and_filters_(std::move(and_filters)) {}
 
 absl::Status TVFOp::SetSchemasForEvaluation(
     absl::Span<const TupleSchema* const> params_schemas) {
@@ -801,10 +1925,13 @@ absl::Status TVFOp::SetSchemasForEvaluation(
       ZETASQL_RET_CHECK_FAIL() << "Unexpected TVFOpArgument";
     }
   }
+  for (std::unique_ptr<ColumnFilterArg>& filter : and_filters_) {
+    ZETASQL_RETURN_IF_ERROR(filter->SetSchemasForEvaluation(params_schemas));
+  }
   return absl::OkStatus();
 }
 
-absl::StatusOr<std::unique_ptr<TupleIterator>> TVFOp::CreateIterator(
+absl::StatusOr<std::unique_ptr<TupleIterator>> TVFOp::CreateIteratorImpl(
     absl::Span<const TupleData* const> params, int num_extra_slots,
     EvaluationContext* context) const {
   std::vector<TableValuedFunction::TvfEvaluatorArg> input_arguments;
@@ -869,6 +1996,22 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> TVFOp::CreateIterator(
     tuple_indexes.push_back(tuple_index);
   }
 
+  // The filters are on 'output_columns_', but the iterator is keyed on its own
+  // column indexes.
+  if (!and_filters_.empty()) {
+    absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map;
+    ZETASQL_ASSIGN_OR_RETURN(filter_map,
+                     EvaluatorTableScanOp::EvalColumnFilterMap(
+                         and_filters_, params, context));
+    absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> iterator_filter_map;
+    for (auto& [column_idx, filter] : filter_map) {
+      iterator_filter_map.emplace(static_cast<int>(tuple_indexes[column_idx]),
+                                  std::move(filter));
+    }
+    ZETASQL_RETURN_IF_ERROR(evaluator_table_iterator->SetColumnFilterMap(
+        std::move(iterator_filter_map)));
+  }
+
   std::unique_ptr<TupleIterator> tuple_iterator =
       std::make_unique<EvaluatorTVFTupleIterator>(
           tvf_->Name(), CreateOutputSchema(), num_extra_slots,
@@ -925,10 +2068,19 @@ std::string TVFOp::DebugInternal(const std::string& indent,
   }
   absl::StrAppend(&result, "}");
 
-  if (verbose && function_call_signature_) {
-    absl::StrAppend(
-        &result, indent_field, "function_call_signature: ",
-        function_call_signature_->DebugString(tvf_->Name(), verbose));
+  if (!and_filters_.empty()) {
+    absl::StrAppend(&result, indent_field, "and_filters: {");
+    for (const std::unique_ptr<ColumnFilterArg>& filter : and_filters_) {
+      absl::StrAppend(&result, indent_list,
+                      filter->DebugInternal(indent_nested, verbose));
+    }
+    absl::StrAppend(&result, "}");
+  }
+
+  if (verbose && function_call_signature_) {
+    absl::StrAppend(
+        &result, indent_field, "function_call_signature: ",
+        function_call_signature_->DebugString(tvf_->Name(), verbose));
   }
 
   absl::StrAppend(&result, ")");  // To match TvfOp(
@@ -1033,6 +2185,10 @@ class LetOpTupleIterator : public TupleIterator {
 
   TupleData* Next() override { return iter_->Next(); }
 
+  bool NextBatch(TupleDataBatch* batch) override {
+    return iter_->NextBatch(batch);
+  }
+
   absl::Status Status() const override { return iter_->Status(); }
 
   bool PreservesOrder() const override { return iter_->PreservesOrder(); }
@@ -1041,6 +2197,8 @@ class LetOpTupleIterator : public TupleIterator {
     return iter_->DisableReordering();
   }
 
+  void Close() override { iter_->Close(); }
+
   std::string DebugString() const override {
     return LetOp::GetIteratorDebugString(iter_->DebugString());
   }
@@ -1053,7 +2211,7 @@ class LetOpTupleIterator : public TupleIterator {
 };
 }  // namespace
 
-absl::StatusOr<std::unique_ptr<TupleIterator>> LetOp::CreateIterator(
+absl::StatusOr<std::unique_ptr<TupleIterator>> LetOp::CreateIteratorImpl(
     absl::Span<const TupleData* const> params, int num_extra_slots,
     EvaluationContext* context) const {
   // Initialize 'all_params' with 'params', then extend 'all_params' with new
@@ -1260,6 +2418,11 @@ class SortTupleIterator : public TupleIterator {
     return absl::OkStatus();
   }
 
+  void Close() override {
+    tuples_->Clear();
+    current_.reset();
+  }
+
   std::string DebugString() const override {
     return SortOp::GetIteratorDebugString(
         input_iter_for_debug_string_->DebugString());
@@ -1331,9 +2494,235 @@ class SortTupleIterator : public TupleIterator {
   bool enable_reordering_ = true;
   absl::Status status_;
 };
+
+// Merges runs of tuples that are each sorted by 'comparator' into a single
+// sorted sequence. All the runs except the last are in spill files; the last
+// one is in memory. Tuples that are equal with respect to 'comparator' are
+// returned in run order and then in their order within the run, so if each
+// run is stably sorted and the runs are in input order, the result is the
+// same as stably sorting the whole input. Never scrambles the order of equal
+// tuples.
+class MergingSortTupleIterator : public TupleIterator {
+ public:
+  MergingSortTupleIterator(
+      std::unique_ptr<TupleIterator> input_iter_for_debug_string,
+      std::unique_ptr<const TupleSchema> schema,
+      std::unique_ptr<TupleComparator> comparator,
+      std::vector<std::unique_ptr<TupleSpillFile>> spilled_runs,
+      std::unique_ptr<TupleDataDeque> last_run, EvaluationContext* context)
+      : input_iter_for_debug_string_(std::move(input_iter_for_debug_string)),
+        schema_(std::move(schema)),
+        comparator_(std::move(comparator)),
+        spilled_runs_(std::move(spilled_runs)),
+        last_run_(std::move(last_run)),
+        heads_(spilled_runs_.size() + 1),
+        context_(context) {}
+
+  MergingSortTupleIterator(const MergingSortTupleIterator&) = delete;
+  MergingSortTupleIterator& operator=(const MergingSortTupleIterator&) =
+      delete;
+
+  const TupleSchema& Schema() const override { return *schema_; }
+
+  TupleData* Next() override {
+    if (num_next_calls_ %
+            absl::GetFlag(
+                FLAGS_zetasql_call_verify_not_aborted_rows_period) ==
+        0) {
+      status_ = context_->VerifyNotAborted();
+      if (!status_.ok()) {
+        return nullptr;
+      }
+    }
+    if (num_next_calls_ == 0) {
+      for (int run = 0; run < heads_.size(); ++run) {
+        status_ = AdvanceRun(run);
+        if (!status_.ok()) {
+          return nullptr;
+        }
+      }
+    }
+    ++num_next_calls_;
+
+    if (heap_.empty()) return nullptr;
+    std::pop_heap(heap_.begin(), heap_.end(), [this](int run1, int run2) {
+      return RunComesAfter(run1, run2);
+    });
+    const int run = heap_.back();
+    heap_.pop_back();
+    // Reuse the previous output tuple to read the next tuple of 'run'.
+    current_.swap(heads_[run]);
+    status_ = AdvanceRun(run);
+    if (!status_.ok()) {
+      return nullptr;
+    }
+    return current_.get();
+  }
+
+  absl::Status Status() const override { return status_; }
+
+  bool PreservesOrder() const override { return true; }
+
+  absl::Status DisableReordering() override { return absl::OkStatus(); }
+
+  std::string DebugString() const override {
+    return SortOp::GetIteratorDebugString(
+        input_iter_for_debug_string_->DebugString());
+  }
+
+ private:
+  // Returns true if the head of 'run1' must be output after the head of
+  // 'run2'. Used as the ordering of 'heap_', so that the top of the heap is
+  // the run whose head comes first.
+  bool RunComesAfter(int run1, int run2) const {
+    const TupleData& head1 = *heads_[run1];
+    const TupleData& head2 = *heads_[run2];
+    if ((*comparator_)(head2, head1)) return true;
+    if ((*comparator_)(head1, head2)) return false;
+    return run1 > run2;
+  }
+
+  // Loads the next tuple of 'run' into 'heads_[run]' and adds 'run' to
+  // 'heap_', unless 'run' is exhausted.
+  absl::Status AdvanceRun(int run) {
+    if (run < spilled_runs_.size()) {
+      if (heads_[run] == nullptr) {
+        heads_[run] = std::make_unique<TupleData>();
+      }
+      ZETASQL_ASSIGN_OR_RETURN(const bool found,
+                       spilled_runs_[run]->Read(heads_[run].get()));
+      if (!found) return absl::OkStatus();
+    } else {
+      if (last_run_->IsEmpty()) return absl::OkStatus();
+      heads_[run] = last_run_->PopFront();
+    }
+    heap_.push_back(run);
+    std::push_heap(heap_.begin(), heap_.end(), [this](int run1, int run2) {
+      return RunComesAfter(run1, run2);
+    });
+    return absl::OkStatus();
+  }
+
+  // We store a TupleIterator instead of the debug string to avoid having to
+  // compute the debug string unnecessarily.
+  const std::unique_ptr<TupleIterator> input_iter_for_debug_string_;
+  const std::unique_ptr<const TupleSchema> schema_;
+  const std::unique_ptr<TupleComparator> comparator_;
+  std::vector<std::unique_ptr<TupleSpillFile>> spilled_runs_;
+  std::unique_ptr<TupleDataDeque> last_run_;
+  // The next tuple of each run. Run 'spilled_runs_.size()' is 'last_run_'.
+  std::vector<std::unique_ptr<TupleData>> heads_;
+  // The runs that are not exhausted, as a heap ordered by RunComesAfter().
+  std::vector<int> heap_;
+  int64_t num_next_calls_ = 0;
+  std::unique_ptr<TupleData> current_;
+  EvaluationContext* context_;
+  absl::Status status_;
+};
+
+// Evaluates the keys and values of a SortOp over an input that is already
+// sorted on the keys, returning the rows as they are read. Rows before
+// 'offset' are skipped and reading stops after 'limit' rows, if set.
+class SortedInputTupleIterator : public TupleIterator {
+ public:
+  SortedInputTupleIterator(absl::Span<const TupleData* const> params,
+                           absl::Span<const KeyArg* const> keys,
+                           absl::Span<const ExprArg* const> values,
+                           std::optional<int64_t> limit, int64_t offset,
+                           int num_extra_slots,
+                           std::unique_ptr<TupleIterator> input_iter,
+                           std::unique_ptr<const TupleSchema> schema,
+                           EvaluationContext* context)
+      : params_and_input_tuple_(ConcatSpans(
+            params, absl::Span<const TupleData* const>({nullptr}))),
+        keys_(keys.begin(), keys.end()),
+        values_(values.begin(), values.end()),
+        limit_(limit),
+        offset_(offset),
+        input_iter_(std::move(input_iter)),
+        schema_(std::move(schema)),
+        current_(static_cast<int>(keys.size() + values.size()) +
+                 num_extra_slots),
+        context_(context) {}
+
+  SortedInputTupleIterator(const SortedInputTupleIterator&) = delete;
+  SortedInputTupleIterator& operator=(const SortedInputTupleIterator&) =
+      delete;
+
+  const TupleSchema& Schema() const override { return *schema_; }
+
+  TupleData* Next() override {
+    if (limit_.has_value() && num_returned_ >= *limit_) return nullptr;
+    while (true) {
+      if (num_next_calls_ %
+              absl::GetFlag(
+                  FLAGS_zetasql_call_verify_not_aborted_rows_period) ==
+          0) {
+        absl::Status status = context_->VerifyNotAborted();
+        if (!status.ok()) {
+          status_ = status;
+          return nullptr;
+        }
+      }
+      ++num_next_calls_;
+
+      const TupleData* next_input = input_iter_->Next();
+      if (next_input == nullptr) {
+        status_ = input_iter_->Status();
+        return nullptr;
+      }
+      if (num_skipped_ < offset_) {
+        ++num_skipped_;
+        continue;
+      }
+      params_and_input_tuple_.back() = next_input;
+      for (int i = 0; i < keys_.size(); ++i) {
+        if (!keys_[i]->value_expr()->EvalSimple(params_and_input_tuple_,
+                                                context_,
+                                                current_.mutable_slot(i),
+                                                &status_)) {
+          return nullptr;
+        }
+      }
+      for (int i = 0; i < values_.size(); ++i) {
+        if (!values_[i]->value_expr()->EvalSimple(
+                params_and_input_tuple_, context_,
+                current_.mutable_slot(static_cast<int>(keys_.size()) + i),
+                &status_)) {
+          return nullptr;
+        }
+      }
+      ++num_returned_;
+      return &current_;
+    }
+  }
+
+  absl::Status Status() const override { return status_; }
+
+  void Close() override { input_iter_->Close(); }
+
+  std::string DebugString() const override {
+    return SortOp::GetIteratorDebugString(input_iter_->DebugString());
+  }
+
+ private:
+  std::vector<const TupleData*> params_and_input_tuple_;
+  const std::vector<const KeyArg*> keys_;
+  const std::vector<const ExprArg*> values_;
+  const std::optional<int64_t> limit_;
+  const int64_t offset_;
+  const std::unique_ptr<TupleIterator> input_iter_;
+  const std::unique_ptr<const TupleSchema> schema_;
+  TupleData current_;
+  int64_t num_skipped_ = 0;
+  int64_t num_returned_ = 0;
+  int64_t num_next_calls_ = 0;
+  EvaluationContext* context_;
+  absl::Status status_;
+};
 }  // namespace
 
-absl::StatusOr<std::unique_ptr<TupleIterator>> SortOp::CreateIterator(
+absl::StatusOr<std::unique_ptr<TupleIterator>> SortOp::CreateIteratorImpl(
     absl::Span<const TupleData* const> params, int num_extra_slots,
     EvaluationContext* context) const {
   Value limit_value;   // Invalid if no limit set.
@@ -1384,6 +2773,20 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> SortOp::CreateIterator(
       std::unique_ptr<TupleIterator> input_iter,
       input()->CreateIterator(params, /*num_extra_slots=*/0, context));
 
+  if (input_is_sorted_ && !context->options().scramble_undefined_orderings) {
+    std::optional<int64_t> limit;
+    int64_t offset = 0;
+    if (limit_offset.has_value()) {
+      limit = limit_offset->limit;
+      offset = limit_offset->offset;
+    }
+    std::unique_ptr<TupleIterator> iter =
+        std::make_unique<SortedInputTupleIterator>(
+            params, keys(), values(), limit, offset, num_extra_slots,
+            std::move(input_iter), CreateOutputSchema(), context);
+    return iter;
+  }
+
   std::vector<int> slots_for_keys;
   slots_for_keys.reserve(keys().size());
   for (int i = 0; i < keys().size(); ++i) {
@@ -1404,20 +2807,46 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> SortOp::CreateIterator(
   // contains all the rows.
   auto top_n_outputs = std::make_unique<TupleDataOrderedQueue>(
       *comparator, context->memory_accountant());
-  auto outputs = std::make_unique<TupleDataDeque>(context->memory_accountant());
+  auto outputs = std::make_unique<TupleDataDeque>(context->memory_accountant(),
+                                                  context->tuple_arena());
+  // If 'outputs' would exceed the memory limit and spilling is enabled, it is
+  // stably sorted and moved to a new element of 'spilled_runs'.
+  const std::string& spill_directory = context->options().spill_directory;
+  std::vector<std::unique_ptr<TupleSpillFile>> spilled_runs;
   absl::Status status;
-  while (true) {
-    const TupleData* next_input = input_iter->Next();
-    if (next_input == nullptr) {
-      ZETASQL_RETURN_IF_ERROR(input_iter->Status());
-      break;
+  std::vector<const TupleData*> params_and_input_tuple = ConcatSpans(
+      params, absl::Span<const TupleData* const>({nullptr}));
+  auto spill_outputs = [&]() -> absl::Status {
+    outputs->Sort(*comparator, /*use_stable_sort=*/true,
+                  context->options().num_threads, context->options().executor);
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<TupleSpillFile> run,
+                     TupleSpillFile::Create(spill_directory));
+    while (!outputs->IsEmpty()) {
+      ZETASQL_RETURN_IF_ERROR(run->Write(*outputs->PopFront()));
+    }
+    ZETASQL_RETURN_IF_ERROR(run->FinishWriting());
+    spilled_runs.push_back(std::move(run));
+    if (context->operator_profile() != nullptr) {
+      OperatorProfile::OperatorStats stats;
+      stats.num_spilled_runs = 1;
+      context->operator_profile()->AddStats(this, stats);
+    }
+    return absl::OkStatus();
+  };
+  // The tuple that the next input row is evaluated into. With a limit, it is
+  // reused when a row is discarded or when a row displaces the last one in
+  // 'top_n_outputs', so that steady state does not allocate.
+  std::unique_ptr<TupleData> next_output;
+  // Evaluates the keys and values of 'next_input' and adds the result to
+  // 'top_n_outputs' or 'outputs'.
+  auto add_input = [&](const TupleData* next_input) -> absl::Status {
+    params_and_input_tuple.back() = next_input;
+
+    if (next_output == nullptr) {
+      next_output = std::make_unique<TupleData>(
+          keys().size() + values().size() + num_extra_slots,
+          context->tuple_arena());
     }
-
-    const std::vector<const TupleData*> params_and_input_tuple =
-        ConcatSpans(params, {next_input});
-
-    auto next_output = std::make_unique<TupleData>(
-        keys().size() + values().size() + num_extra_slots);
     for (int i = 0; i < keys().size(); ++i) {
       TupleSlot* slot = next_output->mutable_slot(i);
       if (!keys()[i]->value_expr()->EvalSimple(params_and_input_tuple, context,
@@ -1434,18 +2863,58 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> SortOp::CreateIterator(
     }
 
     if (limit_offset.has_value()) {
+      // Once 'top_n_outputs' holds 'limit + offset' rows, a row that does not
+      // sort strictly before the last one would be inserted after it and
+      // immediately popped again (TupleDataOrderedQueue puts equal rows after
+      // the existing ones), so we can drop it without touching the queue.
+      const bool is_full = top_n_outputs->GetSize() - limit_offset->limit >=
+                           limit_offset->offset;
+      if (is_full && (top_n_outputs->IsEmpty() ||
+                      !(*comparator)(*next_output, top_n_outputs->Back()))) {
+        return absl::OkStatus();
+      }
       if (!top_n_outputs->Insert(std::move(next_output), &status)) {
         return status;
       }
       if (top_n_outputs->GetSize() - limit_offset->limit >
           limit_offset->offset) {
-        top_n_outputs->PopBack();
+        next_output = top_n_outputs->PopBack();
       }
-    } else {
+    } else if (spill_directory.empty()) {
+      if (!outputs->PushBack(std::move(next_output), &status)) {
+        return status;
+      }
+    } else if (!outputs->TryPushBack(&next_output, &status)) {
+      // If 'outputs' is empty, 'next_output' alone exceeds the limit.
+      if (outputs->IsEmpty() || !absl::IsResourceExhausted(status)) {
+        return status;
+      }
+      ZETASQL_RETURN_IF_ERROR(spill_outputs());
       if (!outputs->PushBack(std::move(next_output), &status)) {
         return status;
       }
     }
+    return absl::OkStatus();
+  };
+
+  const int batch_size = context->options().tuple_batch_size;
+  if (batch_size > 0) {
+    TupleDataBatch batch(batch_size);
+    while (input_iter->NextBatch(&batch)) {
+      for (const TupleData* next_input : batch.rows()) {
+        ZETASQL_RETURN_IF_ERROR(add_input(next_input));
+      }
+    }
+    ZETASQL_RETURN_IF_ERROR(input_iter->Status());
+  } else {
+    while (true) {
+      const TupleData* next_input = input_iter->Next();
+      if (next_input == nullptr) {
+        ZETASQL_RETURN_IF_ERROR(input_iter->Status());
+        break;
+      }
+      ZETASQL_RETURN_IF_ERROR(add_input(next_input));
+    }
   }
 
   // If there is a limit set, drop the first 'offset' entries from
@@ -1468,10 +2937,18 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> SortOp::CreateIterator(
     // order that is not actually required. This is better than silently
     // ignoring failures.
     is_uniquely_ordered = true;
+  } else if (!spilled_runs.empty()) {
+    ZETASQL_RET_CHECK(top_n_outputs->IsEmpty());
+    // The runs are merged stably (see MergingSortTupleIterator), and we cannot
+    // tell whether the output is uniquely ordered without reading it all back.
+    outputs->Sort(*comparator, /*use_stable_sort=*/true,
+                  context->options().num_threads, context->options().executor);
+    is_uniquely_ordered = false;
   } else {
     ZETASQL_RET_CHECK(top_n_outputs->IsEmpty());
     outputs->Sort(*comparator,
-                  context->options().always_use_stable_sort || is_stable_sort_);
+                  context->options().always_use_stable_sort || is_stable_sort_,
+                  context->options().num_threads, context->options().executor);
     const std::vector<const TupleData*> output_ptrs = outputs->GetTuplePtrs();
     is_uniquely_ordered =
         comparator->IsUniquelyOrdered(output_ptrs, slots_for_values);
@@ -1484,9 +2961,16 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> SortOp::CreateIterator(
   // try to access it again.
   top_n_outputs.reset();
 
-  std::unique_ptr<TupleIterator> iter = std::make_unique<SortTupleIterator>(
-      std::move(input_iter), CreateOutputSchema(), std::move(comparator),
-      std::move(outputs), context);
+  std::unique_ptr<TupleIterator> iter;
+  if (spilled_runs.empty()) {
+    iter = std::make_unique<SortTupleIterator>(
+        std::move(input_iter), CreateOutputSchema(), std::move(comparator),
+        std::move(outputs), context);
+  } else {
+    iter = std::make_unique<MergingSortTupleIterator>(
+        std::move(input_iter), CreateOutputSchema(), std::move(comparator),
+        std::move(spilled_runs), std::move(outputs), context);
+  }
   const bool scramble_undefined_orderings =
       context->options().scramble_undefined_orderings;
   if (!scramble_undefined_orderings || is_uniquely_ordered || is_stable_sort_) {
@@ -1531,6 +3015,7 @@ std::string SortOp::DebugInternal(const std::string& indent,
                                   bool verbose) const {
   return absl::StrCat(
       "SortOp(", is_order_preserving() ? "ordered" : "unordered",
+      input_is_sorted_ ? ", input_is_sorted" : "",
       ArgDebugString(
           {"keys", "values", "limit", "offset", "input"},
           {kN, kN, has_limit() ? k1 : k0, has_offset() ? k1 : k0, k1}, indent,
@@ -1538,6 +3023,18 @@ std::string SortOp::DebugInternal(const std::string& indent,
       ")");
 }
 
+RelationalProperties SortOp::DeriveProperties() const {
+  RelationalProperties properties;
+  for (const KeyArg* key : keys()) {
+    // A collated key is ordered by its collation key, which the properties
+    // cannot describe, so the known ordering ends here.
+    if (key->collation() != nullptr) break;
+    properties.ordering.push_back(
+        RelationalProperties::OrderingKey::FromKeyArg(key->variable(), *key));
+  }
+  return properties;
+}
+
 SortOp::SortOp(std::vector<std::unique_ptr<KeyArg>> keys,
                std::vector<std::unique_ptr<ExprArg>> values,
                std::unique_ptr<ValueExpr> limit,
@@ -1637,6 +3134,17 @@ absl::Status ComputeOp::SetSchemasForEvaluation(
   return absl::OkStatus();
 }
 
+// Returns 'expr' if it is a function call that can be evaluated on a whole
+// TupleDataBatch at once with 'context', or NULL otherwise.
+static const ScalarFunctionCallExpr* GetBatchEvaluableCall(
+    const ValueExpr* expr, const EvaluationContext* context) {
+  // Traced function calls are timed one row at a time.
+  if (context->tracer() != nullptr) return nullptr;
+  const auto* call = dynamic_cast<const ScalarFunctionCallExpr*>(expr);
+  if (call == nullptr || !call->SupportsEvalBatch()) return nullptr;
+  return call;
+}
+
 namespace {
 // Iterator corresponding to a ComputeOp. To return a tuple, it reads a tuple
 // from an underlying iterator and augments it with the result of evaluating a
@@ -1651,10 +3159,17 @@ class ComputeTupleIterator : public TupleIterator {
                        std::unique_ptr<TupleSchema> output_schema,
                        EvaluationContext* context)
       : expr_args_(expr_args.begin(), expr_args.end()),
-        params_(params.begin(), params.end()),
+        params_and_current_(
+            ConcatSpans(params, absl::Span<const TupleData* const>({nullptr}))),
         iter_(std::move(iter)),
         output_schema_(std::move(output_schema)),
-        context_(context) {}
+        context_(context) {
+    batch_calls_.reserve(expr_args_.size());
+    for (const ExprArg* expr_arg : expr_args_) {
+      batch_calls_.push_back(
+          GetBatchEvaluableCall(expr_arg->value_expr(), context_));
+    }
+  }
 
   ComputeTupleIterator(const ComputeTupleIterator&) = delete;
   ComputeTupleIterator& operator=(const ComputeTupleIterator&) = delete;
@@ -1667,39 +3182,98 @@ class ComputeTupleIterator : public TupleIterator {
       status_ = iter_->Status();
       return nullptr;
     }
+    if (!ComputeSlots(current)) return nullptr;
+    return current;
+  }
 
-    if (current->num_slots() < Schema().num_variables()) {
-      status_ = zetasql_base::InternalErrorBuilder()
-                << "ComputeTupleIterator::Next() found " << current->num_slots()
-                << " slots but expected at least " << Schema().num_variables();
-      return nullptr;
+  bool NextBatch(TupleDataBatch* batch) override {
+    if (!iter_->NextBatch(batch)) {
+      status_ = iter_->Status();
+      return false;
     }
-
+    for (const TupleData* current : batch->rows()) {
+      if (!CheckNumSlots(*current)) return false;
+    }
+    // Compute one variable at a time for the whole batch, since each one may
+    // depend on the previous ones. Calls that support it are evaluated
+    // column-wise; the others one row at a time.
+    const int num_input_variables = iter_->Schema().num_variables();
     for (int i = 0; i < expr_args_.size(); ++i) {
-      TupleSlot* slot =
-          current->mutable_slot(iter_->Schema().num_variables() + i);
-      absl::Status status;
-      if (!expr_args_[i]->value_expr()->EvalSimple(
-              ConcatSpans(absl::Span<const TupleData* const>(params_),
-                          {current}),
-              context_, slot, &status)) {
-        status_ = status;
-        return nullptr;
+      const int slot_idx = num_input_variables + i;
+      if (batch_calls_[i] != nullptr) {
+        TupleColumn column(batch_calls_[i]->output_type());
+        absl::Status status;
+        if (!batch_calls_[i]->EvalBatch(*batch, context_, &column, &status)) {
+          status_ = status;
+          return false;
+        }
+        status_ = ColumnarTupleBatch::Store(column, slot_idx, batch);
+        if (!status_.ok()) return false;
+        continue;
+      }
+      for (TupleData* current : batch->rows()) {
+        params_and_current_.back() = current;
+        if (!ComputeSlot(i, current->mutable_slot(slot_idx))) return false;
       }
     }
-
-    return current;
+    return true;
   }
 
   absl::Status Status() const override { return status_; }
 
+  void Close() override { iter_->Close(); }
+
   std::string DebugString() const override {
     return ComputeOp::GetIteratorDebugString(iter_->DebugString());
   }
 
  private:
+  // Returns false and updates 'status_' if 'current' does not have a slot for
+  // each variable of Schema().
+  bool CheckNumSlots(const TupleData& current) {
+    if (current.num_slots() < Schema().num_variables()) {
+      status_ = zetasql_base::InternalErrorBuilder()
+                << "ComputeTupleIterator::Next() found " << current.num_slots()
+                << " slots but expected at least " << Schema().num_variables();
+      return false;
+    }
+    return true;
+  }
+
+  // Populates the slots of 'current' that follow the variables of
+  // 'iter_->Schema()'. Returns false and updates 'status_' on error.
+  bool ComputeSlots(TupleData* current) {
+    if (!CheckNumSlots(*current)) return false;
+
+    params_and_current_.back() = current;
+    const int num_input_variables = iter_->Schema().num_variables();
+    for (int i = 0; i < expr_args_.size(); ++i) {
+      if (!ComputeSlot(i, current->mutable_slot(num_input_variables + i))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Evaluates 'expr_args_[i]' on 'params_and_current_' into 'slot'. Returns
+  // false and updates 'status_' on error.
+  bool ComputeSlot(int i, TupleSlot* slot) {
+    absl::Status status;
+    if (!expr_args_[i]->value_expr()->EvalSimple(params_and_current_, context_,
+                                                 slot, &status)) {
+      status_ = status;
+      return false;
+    }
+    return true;
+  }
+
   const std::vector<const ExprArg*> expr_args_;
-  const std::vector<const TupleData*> params_;
+  // For each element of 'expr_args_', the call to evaluate column-wise in
+  // NextBatch(), or NULL.
+  std::vector<const ScalarFunctionCallExpr*> batch_calls_;
+  // The parameters followed by the tuple currently being computed. Reused
+  // across tuples to avoid building a new vector for every evaluation.
+  std::vector<const TupleData*> params_and_current_;
 
   std::unique_ptr<TupleIterator> iter_;
   std::unique_ptr<TupleSchema> output_schema_;
@@ -1708,7 +3282,7 @@ class ComputeTupleIterator : public TupleIterator {
 };
 }  // namespace
 
-absl::StatusOr<std::unique_ptr<TupleIterator>> ComputeOp::CreateIterator(
+absl::StatusOr<std::unique_ptr<TupleIterator>> ComputeOp::CreateIteratorImpl(
     absl::Span<const TupleData* const> params, int num_extra_slots,
     EvaluationContext* context) const {
   ZETASQL_ASSIGN_OR_RETURN(
@@ -1740,6 +3314,10 @@ std::string ComputeOp::DebugInternal(const std::string& indent,
       ")");
 }
 
+RelationalProperties ComputeOp::DeriveProperties() const {
+  return input()->DeriveProperties();
+}
+
 ComputeOp::ComputeOp(std::vector<std::unique_ptr<ExprArg>> map,
                      std::unique_ptr<RelationalOp> input) {
   SetArg(kInput, std::make_unique<RelationalArg>(std::move(input)));
@@ -1796,7 +3374,12 @@ class FilterTupleIterator : public TupleIterator {
                       std::unique_ptr<TupleIterator> iter,
                       EvaluationContext* context)
       : predicate_(predicate),
-        params_(params.begin(), params.end()),
+        batch_predicate_(predicate->output_type()->IsBool()
+                             ? GetBatchEvaluableCall(predicate, context)
+                             : nullptr),
+        params_and_current_(
+            ConcatSpans(params, absl::Span<const TupleData* const>({nullptr}))),
+        matches_(types::BoolType()),
         iter_(std::move(iter)),
         context_(context) {}
 
@@ -1813,37 +3396,93 @@ class FilterTupleIterator : public TupleIterator {
         return nullptr;
       }
 
-      TupleSlot slot;
-      absl::Status status;
-      if (!predicate_->EvalSimple(
-              ConcatSpans(absl::Span<const TupleData* const>(params_),
-                          {current}),
-              context_, &slot, &status)) {
-        status_ = status;
-        return nullptr;
-      }
-      if (slot.value() == Bool(true)) {
+      bool matches;
+      if (!EvalPredicate(current, &matches)) return nullptr;
+      if (matches) {
         return current;
       }
     }
   }
 
+  bool NextBatch(TupleDataBatch* batch) override {
+    while (true) {
+      if (!iter_->NextBatch(batch)) {
+        status_ = iter_->Status();
+        return false;
+      }
+
+      // Compact the matching rows to the front of the batch.
+      int num_matches = 0;
+      if (batch_predicate_ != nullptr) {
+        absl::Status status;
+        if (!batch_predicate_->EvalBatch(*batch, context_, &matches_,
+                                         &status)) {
+          status_ = status;
+          return false;
+        }
+        const absl::Span<const uint8_t> values = matches_.bool_values();
+        for (int i = 0; i < batch->size(); ++i) {
+          if (!matches_.IsNull(i) && values[i] != 0) {
+            batch->SetRow(num_matches, batch->row(i));
+            ++num_matches;
+          }
+        }
+      } else {
+        for (int i = 0; i < batch->size(); ++i) {
+          TupleData* current = batch->row(i);
+          bool matches;
+          if (!EvalPredicate(current, &matches)) return false;
+          if (matches) {
+            batch->SetRow(num_matches, current);
+            ++num_matches;
+          }
+        }
+      }
+      batch->Truncate(num_matches);
+      if (!batch->empty()) return true;
+    }
+  }
+
   absl::Status Status() const override { return status_; }
 
+  void Close() override { iter_->Close(); }
+
   std::string DebugString() const override {
     return FilterOp::GetIteratorDebugString(iter_->DebugString());
   }
 
  private:
+  // Evaluates the predicate on 'current' and sets 'matches' to whether it is
+  // TRUE. Returns false and updates 'status_' on error.
+  bool EvalPredicate(const TupleData* current, bool* matches) {
+    params_and_current_.back() = current;
+    absl::Status status;
+    if (!predicate_->EvalSimple(params_and_current_, context_, &slot_,
+                                &status)) {
+      status_ = status;
+      return false;
+    }
+    *matches = slot_.value() == Bool(true);
+    return true;
+  }
+
   const ValueExpr* predicate_;
-  const std::vector<const TupleData*> params_;
+  // 'predicate_' if NextBatch() can evaluate it column-wise, or NULL.
+  const ScalarFunctionCallExpr* batch_predicate_;
+  // The parameters followed by the tuple currently being filtered. Reused
+  // across tuples to avoid building a new vector for every evaluation.
+  std::vector<const TupleData*> params_and_current_;
+  // Holds the result of the predicate.
+  TupleSlot slot_;
+  // Holds the result of 'batch_predicate_' for a batch.
+  TupleColumn matches_;
   std::unique_ptr<TupleIterator> iter_;
   absl::Status status_;
   EvaluationContext* context_;
 };
 }  // namespace
 
-absl::StatusOr<std::unique_ptr<TupleIterator>> FilterOp::CreateIterator(
+absl::StatusOr<std::unique_ptr<TupleIterator>> FilterOp::CreateIteratorImpl(
     absl::Span<const TupleData* const> params, int num_extra_slots,
     EvaluationContext* context) const {
   ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<TupleIterator> iter,
@@ -1868,6 +3507,10 @@ std::string FilterOp::DebugInternal(const std::string& indent,
       ArgDebugString({"condition", "input"}, {k1, k1}, indent, verbose), ")");
 }
 
+RelationalProperties FilterOp::DeriveProperties() const {
+  return input()->DeriveProperties();
+}
+
 FilterOp::FilterOp(std::unique_ptr<ValueExpr> predicate,
                    std::unique_ptr<RelationalOp> input) {
   SetArg(kPredicate, std::make_unique<ExprArg>(std::move(predicate)));
@@ -1962,41 +3605,84 @@ class LimitTupleIterator : public TupleIterator {
     return current;
   }
 
+  bool NextBatch(TupleDataBatch* batch) override {
+    while (true) {
+      // Don't return more than 'count_' tuples from 'iter_'.
+      if (next_iter_row_number_ >= offset_ &&
+          next_iter_row_number_ - offset_ >= count_) {
+        batch->Clear();
+        Finish(std::nullopt, batch);
+        return false;
+      }
+
+      if (!iter_->NextBatch(batch)) {
+        Finish(iter_->Status(), batch);
+        return false;
+      }
+      const int64_t first_row_number = next_iter_row_number_;
+      next_iter_row_number_ += batch->size();
+
+      // Drop the rows that precede 'offset_' and those past 'count_'.
+      const int64_t num_to_skip = std::clamp<int64_t>(
+          offset_ - first_row_number, 0, batch->size());
+      const int64_t num_output_so_far =
+          std::max<int64_t>(first_row_number - offset_, 0);
+      const int64_t num_to_keep = std::min<int64_t>(
+          count_ - num_output_so_far, batch->size() - num_to_skip);
+      batch->Truncate(static_cast<int>(num_to_skip + num_to_keep));
+      batch->RemovePrefix(static_cast<int>(num_to_skip));
+      if (!batch->empty()) return true;
+    }
+  }
+
   absl::Status Status() const override { return status_; }
 
+  void Close() override { iter_->Close(); }
+
   std::string DebugString() const override {
     return LimitOp::GetIteratorDebugString(iter_->DebugString());
   }
 
  private:
   // Update 'status_' and 'context_' to indicate that the iterator is done. If
-  // 'iter_' is done, 'iter_status' contains its status.
-  void Finish(std::optional<absl::Status> iter_status) {
+  // 'iter_' is done, 'iter_status' contains its status. If 'batch' is non-NULL,
+  // 'iter_' is being read with NextBatch() and 'batch' is used as scratch
+  // space for any further reads; it is empty on return.
+  void Finish(std::optional<absl::Status> iter_status,
+              TupleDataBatch* batch = nullptr) {
     if (iter_status.has_value()) {
       status_ = iter_status.value();
     }
     // The ZetaSQL behavior is non-deterministic if the underlying iterator
     // does not preserve order, there is more than one input tuple, there is at
     // least one output tuple, and not every input tuple is output.
-    const bool has_output = next_iter_row_number_ > offset_;
+    const bool has_output = next_iter_row_number_ > offset_ && count_ > 0;
     const bool output_everything = offset_ == 0 && iter_status.has_value();
     if (!iter_->PreservesOrder() && has_output && !output_everything) {
       // Read at least two rows from 'iter_' if possible, so that we can
       // determine if the input has more than one row.
       while (next_iter_row_number_ <= 1 && !iter_status.has_value()) {
-        const TupleData* current = iter_->Next();
-        if (current == nullptr) {
+        int64_t num_read = 0;
+        if (batch != nullptr) {
+          if (iter_->NextBatch(batch)) num_read = batch->size();
+          batch->Clear();
+        } else if (iter_->Next() != nullptr) {
+          num_read = 1;
+        }
+        if (num_read == 0) {
           status_ = iter_->Status();
           if (!status_.ok()) return;
           iter_status = status_;
           break;
         }
-        ++next_iter_row_number_;
+        next_iter_row_number_ += num_read;
       }
       if (next_iter_row_number_ >= 2) {
         context_->SetNonDeterministicOutput();
       }
     }
+    // The remaining input is not needed, so let 'iter_' stop producing it.
+    if (!iter_status.has_value()) iter_->Close();
   }
 
   const int64_t count_;
@@ -2009,7 +3695,7 @@ class LimitTupleIterator : public TupleIterator {
 };
 }  // namespace
 
-absl::StatusOr<std::unique_ptr<TupleIterator>> LimitOp::CreateIterator(
+absl::StatusOr<std::unique_ptr<TupleIterator>> LimitOp::CreateIteratorImpl(
     absl::Span<const TupleData* const> params, int num_extra_slots,
     EvaluationContext* context) const {
   TupleSlot count_slot;
@@ -2065,6 +3751,10 @@ std::string LimitOp::DebugInternal(const std::string& indent,
                       ")");
 }
 
+RelationalProperties LimitOp::DeriveProperties() const {
+  return input()->DeriveProperties();
+}
+
 LimitOp::LimitOp(std::unique_ptr<ValueExpr> row_count,
                  std::unique_ptr<ValueExpr> offset,
                  std::unique_ptr<RelationalOp> input) {
@@ -2158,6 +3848,8 @@ class SampleScanTupleIteratorBase : public TupleIterator {
 
   absl::Status Status() const override { return status_; }
 
+  void Close() override { iter_->Close(); }
+
   std::string DebugString() const override {
     return SampleScanOp::GetIteratorDebugString(iter_->DebugString());
   }
@@ -2221,18 +3913,20 @@ class SampleScanTupleIteratorBase : public TupleIterator {
   absl::Status status_;
 };
 
+// Keeps each row of 'iter' with probability 'percent' (a fraction in [0, 1]),
+// and gives the kept rows weight 'weight'.
 class BernoulliSampleScanTupleIterator : public SampleScanTupleIteratorBase {
  public:
-  BernoulliSampleScanTupleIterator(double percent, std::optional<int64_t> seed,
+  BernoulliSampleScanTupleIterator(double percent, double weight,
+                                   std::optional<int64_t> seed,
                                    EvaluationContext* context,
                                    std::unique_ptr<TupleIterator> iter,
                                    std::unique_ptr<TupleSchema> schema,
-                                   const VariableId& weight)
+                                   const VariableId& weight_variable)
       : SampleScanTupleIteratorBase(seed, context, std::move(iter),
-                                    std::move(schema), weight),
+                                    std::move(schema), weight_variable),
         percent_(percent),
-        // If percent is 0, WITH WEIGHT returns 0 rows so weight doesn't matter.
-        weight_(percent == 0 ? 0.0 : 1.0 / percent_) {}
+        weight_(weight) {}
 
   BernoulliSampleScanTupleIterator(const BernoulliSampleScanTupleIterator&) =
       delete;
@@ -2267,18 +3961,47 @@ class BernoulliSampleScanTupleIterator : public SampleScanTupleIteratorBase {
 
 class ReservoirSampleScanTupleIterator : public SampleScanTupleIteratorBase {
  public:
+  // A table scan input that is sampled a morsel at a time instead of through
+  // the input iterator (see BuildReservoirStateFromMorsels()).
+  struct MorselInput {
+    EvaluatorTableScanOp::TableIteratorFactory iterator_factory;
+    int num_columns;
+    // The number of slots of the rows, including extra slots.
+    int num_slots;
+    // The number of rows of the table, from GetNumRowsForSplitting().
+    int64_t num_rows;
+    int num_threads;
+    EvaluatorExecutor* executor;
+  };
+
+  // 'morsel_input' may only be set if 'partition_key' is empty. 'iter' is then
+  // only used for its schema.
   ReservoirSampleScanTupleIterator(
       int64_t reservoir_size, std::optional<int64_t> seed,
       EvaluationContext* context, absl::Span<const TupleData* const> params,
       std::unique_ptr<TupleIterator> iter, std::unique_ptr<TupleSchema> schema,
-      absl::Span<const KeyArg* const> partition_key, const VariableId& weight)
+      absl::Span<const KeyArg* const> partition_key, const VariableId& weight,
+      std::optional<MorselInput> morsel_input = std::nullopt)
       : SampleScanTupleIteratorBase(seed, context, std::move(iter),
                                     std::move(schema), weight),
         reservoir_size_(reservoir_size),
         params_(params),
-        partition_key_(partition_key) {}
-
-  ReservoirSampleScanTupleIterator(const ReservoirSampleScanTupleIterator&) =
+        partition_key_(partition_key),
+        morsel_input_(std::move(morsel_input)),
+        morsel_seed_(seed) {
+    if (morsel_input_.has_value()) {
+      context_->RegisterCancelCallback([this] {
+        absl::MutexLock lock(&mutex_);
+        cancelled_ = true;
+        for (EvaluatorTableIterator* iter : wave_iters_) {
+          iter->Cancel().IgnoreError();
+        }
+        return absl::OkStatus();
+      });
+    }
+  }
+
+  ReservoirSampleScanTupleIterator(const ReservoirSampleScanTupleIterator&) =
       delete;
   ReservoirSampleScanTupleIterator& operator=(
       const ReservoirSampleScanTupleIterator&) = delete;
@@ -2321,6 +4044,9 @@ class ReservoirSampleScanTupleIterator : public SampleScanTupleIteratorBase {
     if (reservoir_size_ == 0) {
       return Finish();
     }
+    if (morsel_input_.has_value()) {
+      return BuildReservoirStateFromMorsels();
+    }
 
     // Consume all input, assigning each input tuple a random integral
     // identifier. Within the tuple's partition, only keep that tuple in the
@@ -2365,6 +4091,124 @@ class ReservoirSampleScanTupleIterator : public SampleScanTupleIteratorBase {
     return absl::OkStatus();
   }
 
+  // Like BuildReservoirState(), for 'morsel_input_'. Each morsel gets its own
+  // reservoir and random generator, seeded from the morsel's index, and the
+  // morsels of a wave are read concurrently. Merging the reservoirs of the
+  // morsels gives a sample of the whole table. Only the rows in the
+  // reservoirs are copied, so memory use is proportional to the sample, not to
+  // the table. With REPEATABLE, the sample does not depend on the number of
+  // threads.
+  absl::Status BuildReservoirStateFromMorsels() {
+    const MorselInput& input = morsel_input_.value();
+    const int64_t rows_per_morsel =
+        ParallelEvaluatorTableTupleIterator::kRowsPerMorsel;
+    const int64_t num_morsels =
+        (input.num_rows + rows_per_morsel - 1) / rows_per_morsel;
+    const int max_morsels_per_wave =
+        std::max(1, input.num_threads) *
+        ParallelEvaluatorTableTupleIterator::kMorselsPerThreadPerWave;
+    const uint64_t base_seed = morsel_seed_.has_value()
+                                   ? static_cast<uint64_t>(*morsel_seed_)
+                                   : absl::Uniform<uint64_t>(bitgen_);
+
+    Reservoir reservoir;
+    reservoir.num_candidates_considered = 0;
+    for (int64_t next_morsel = 0; next_morsel < num_morsels;) {
+      ZETASQL_RETURN_IF_ERROR(context_->VerifyNotAborted());
+      // Creating and configuring the iterators happens on this thread, since
+      // Table::CreateEvaluatorTableIterator() need not be thread-safe.
+      const int64_t first_morsel = next_morsel;
+      std::vector<std::unique_ptr<EvaluatorTableIterator>> iters;
+      while (iters.size() < max_morsels_per_wave &&
+             next_morsel < num_morsels) {
+        ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> iter,
+                         input.iterator_factory());
+        ZETASQL_RET_CHECK_EQ(iter->NumColumns(), input.num_columns)
+            << "ReservoirSampleScanTupleIterator found wrong number of "
+            << "columns";
+        const int64_t begin = next_morsel * rows_per_morsel;
+        ZETASQL_RETURN_IF_ERROR(iter->SetRowRange(
+            begin, std::min(input.num_rows, begin + rows_per_morsel)));
+        iter->SetDeadline(context_->GetStatementEvaluationDeadline());
+        iters.push_back(std::move(iter));
+        ++next_morsel;
+      }
+
+      {
+        absl::MutexLock lock(&mutex_);
+        if (cancelled_) {
+          return zetasql_base::CancelledErrorBuilder()
+                 << "ReservoirSampleScanTupleIterator was cancelled";
+        }
+        for (const auto& iter : iters) {
+          wave_iters_.push_back(iter.get());
+        }
+      }
+
+      std::vector<Reservoir> morsel_reservoirs(iters.size());
+      const absl::Status status = ParallelFor(
+          input.num_threads, iters.size(), [&](int morsel) {
+            absl::BitGen bitgen(std::seed_seq{
+                base_seed, base_seed >> 32,
+                static_cast<uint64_t>(first_morsel + morsel)});
+            EvaluatorTableIterator* iter = iters[morsel].get();
+            Reservoir& morsel_reservoir = morsel_reservoirs[morsel];
+            morsel_reservoir.num_candidates_considered = 0;
+            while (iter->NextRow()) {
+              const uint32_t score = absl::Uniform<uint32_t>(bitgen);
+              ++morsel_reservoir.num_candidates_considered;
+              // Rows that would be evicted right away are not copied.
+              if (morsel_reservoir.entries.size() >= reservoir_size_ &&
+                  score >= morsel_reservoir.entries.top().score) {
+                continue;
+              }
+              TupleData row(input.num_slots);
+              for (int i = 0; i < input.num_columns; ++i) {
+                row.mutable_slot(i)->SetValue(iter->GetValue(i));
+              }
+              morsel_reservoir.entries.push({score, std::move(row)});
+              if (morsel_reservoir.entries.size() > reservoir_size_) {
+                morsel_reservoir.entries.pop();
+              }
+            }
+            return iter->Status();
+          },
+          input.executor);
+
+      {
+        absl::MutexLock lock(&mutex_);
+        wave_iters_.clear();
+      }
+      ZETASQL_RETURN_IF_ERROR(status);
+
+      // The lowest 'reservoir_size_' scores of the table are among the lowest
+      // 'reservoir_size_' scores of each morsel.
+      for (Reservoir& morsel_reservoir : morsel_reservoirs) {
+        reservoir.num_candidates_considered +=
+            morsel_reservoir.num_candidates_considered;
+        while (!morsel_reservoir.entries.empty()) {
+          reservoir.entries.push(morsel_reservoir.entries.top());
+          morsel_reservoir.entries.pop();
+          if (reservoir.entries.size() > reservoir_size_) {
+            reservoir.entries.pop();
+          }
+        }
+      }
+    }
+    saw_row_ = reservoir.num_candidates_considered > 0;
+    ZETASQL_RETURN_IF_ERROR(Finish());
+
+    if (reservoir.entries.empty()) return absl::OkStatus();
+    const double weight = (1.0 * reservoir.num_candidates_considered) /
+                          reservoir.entries.size();
+    while (!reservoir.entries.empty()) {
+      reservoir_output_.push_back(std::move(reservoir.entries.top().tuple));
+      reservoir.entries.pop();
+      ZETASQL_RETURN_IF_ERROR(SetWeight(weight, &reservoir_output_.back()));
+    }
+    return absl::OkStatus();
+  }
+
   absl::StatusOr<std::unique_ptr<TupleComparator>> MakeTupleComparator() {
     std::vector<int> compare_slots;
     compare_slots.reserve(partition_key_.size());
@@ -2405,10 +4249,22 @@ class ReservoirSampleScanTupleIterator : public SampleScanTupleIteratorBase {
   int reservoir_next_ = 0;
   // The sampled tuples from the input via reservoir sampling.
   std::vector<TupleData> reservoir_output_;
+
+  const std::optional<MorselInput> morsel_input_;
+  // The REPEATABLE seed, if any, from which the generators of the morsels of
+  // 'morsel_input_' are seeded.
+  const std::optional<int64_t> morsel_seed_;
+
+  // Protects the state shared with the cancel callback, which may run on any
+  // thread.
+  absl::Mutex mutex_;
+  bool cancelled_ ABSL_GUARDED_BY(mutex_) = false;
+  // The iterators of the morsels of 'morsel_input_' being read, if any.
+  std::vector<EvaluatorTableIterator*> wave_iters_ ABSL_GUARDED_BY(mutex_);
 };
 }  // namespace
 
-absl::StatusOr<std::unique_ptr<TupleIterator>> SampleScanOp::CreateIterator(
+absl::StatusOr<std::unique_ptr<TupleIterator>> SampleScanOp::CreateIteratorImpl(
     absl::Span<const TupleData* const> params, int num_extra_slots,
     EvaluationContext* context) const {
   absl::Status status;
@@ -2448,32 +4304,76 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> SampleScanOp::CreateIterator(
     // The input iterator needs to allocate an extra tuple slot for weight.
     num_extra_slots++;
   }
-  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<TupleIterator> iter,
-                   input()->CreateIterator(params, num_extra_slots, context));
-  const bool underlying_iter_preserves_order = iter->PreservesOrder();
 
+  double fraction = 1.0;
   if (method_ == Method::kReservoirRows) {
     if (size.int64_value() < 0) {
       return zetasql_base::OutOfRangeErrorBuilder()
              << "SampleScan requires non-negative size";
     }
-    iter = std::make_unique<ReservoirSampleScanTupleIterator>(
-        size.int64_value(), seed, context, params, std::move(iter),
-        CreateOutputSchema(), partition_key(), weight());
-  }
-  if (method_ == Method::kBernoulliPercent) {
-    if (size.is_null()) {
-      return zetasql_base::InvalidArgumentErrorBuilder()
-             << "PERCENT value must not be null";
-    }
+  } else {
     double value = size.ToDouble();
     if (value < 0 || value > 100) {
       return zetasql_base::OutOfRangeErrorBuilder()
              << "PERCENT value must be in the range [0, 100]";
     }
+    fraction = value / 100.0;
+  }
+  // If percent is 0, WITH WEIGHT returns 0 rows so weight doesn't matter.
+  const double percent_weight = fraction == 0 ? 0.0 : 1.0 / fraction;
+
+  // Table scans that can be split into row ranges are sampled without reading
+  // every row through a single iterator.
+  const auto* scan_op = dynamic_cast<const EvaluatorTableScanOp*>(input());
+  std::optional<EvaluatorTableScanOp::TableIteratorFactory> create_table_iter;
+  std::optional<int64_t> num_table_rows;
+  if (scan_op != nullptr &&
+      (method_ == Method::kSystemPercent ||
+       (method_ == Method::kReservoirRows && partition_key().empty()))) {
+    ZETASQL_ASSIGN_OR_RETURN(create_table_iter,
+                     scan_op->CreateTableIteratorFactory(params, context));
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> table_iter,
+                     (*create_table_iter)());
+    num_table_rows = table_iter->GetNumRowsForSplitting();
+  }
+
+  std::unique_ptr<TupleIterator> iter;
+  if (method_ == Method::kSystemPercent && num_table_rows.has_value()) {
+    iter = std::make_unique<BlockSampledEvaluatorTableTupleIterator>(
+        scan_op->IteratorDebugString(), scan_op->CreateOutputSchema(),
+        num_extra_slots, context, std::move(*create_table_iter),
+        num_table_rows.value(), fraction, seed);
+  } else {
+    ZETASQL_ASSIGN_OR_RETURN(iter,
+                     input()->CreateIterator(params, num_extra_slots, context));
+  }
+  const bool underlying_iter_preserves_order = iter->PreservesOrder();
+
+  if (method_ == Method::kReservoirRows) {
+    std::optional<ReservoirSampleScanTupleIterator::MorselInput> morsel_input;
+    if (num_table_rows.has_value()) {
+      morsel_input = ReservoirSampleScanTupleIterator::MorselInput{
+          .iterator_factory = std::move(*create_table_iter),
+          .num_columns = scan_op->CreateOutputSchema()->num_variables(),
+          .num_slots = scan_op->CreateOutputSchema()->num_variables() +
+                       num_extra_slots,
+          .num_rows = num_table_rows.value(),
+          .num_threads = context->options().num_threads,
+          .executor = context->options().executor};
+    }
+    iter = std::make_unique<ReservoirSampleScanTupleIterator>(
+        size.int64_value(), seed, context, params, std::move(iter),
+        CreateOutputSchema(), partition_key(), weight(),
+        std::move(morsel_input));
+  } else if (method_ == Method::kSystemPercent && num_table_rows.has_value()) {
+    // The blocks are already sampled, so every row is kept.
+    iter = std::make_unique<BernoulliSampleScanTupleIterator>(
+        /*percent=*/1.0, percent_weight, seed, context, std::move(iter),
+        CreateOutputSchema(), weight());
+  } else {
     iter = std::make_unique<BernoulliSampleScanTupleIterator>(
-        value / 100.0, seed, context, std::move(iter), CreateOutputSchema(),
-        weight());
+        fraction, percent_weight, seed, context, std::move(iter),
+        CreateOutputSchema(), weight());
   }
 
   // Scramble the output if the scrambling is enabled and either the underlying
@@ -2505,6 +4405,9 @@ std::string SampleScanOp::DebugInternal(const std::string& indent,
     case Method::kBernoulliPercent:
       absl::StrAppend(&result, "BERNOULLI");
       break;
+    case Method::kSystemPercent:
+      absl::StrAppend(&result, "SYSTEM");
+      break;
     case Method::kReservoirRows:
       absl::StrAppend(&result, "RESERVOIR");
       break;
@@ -2659,7 +4562,7 @@ class EnumerateTupleIterator : public TupleIterator {
 };
 }  // namespace
 
-absl::StatusOr<std::unique_ptr<TupleIterator>> EnumerateOp::CreateIterator(
+absl::StatusOr<std::unique_ptr<TupleIterator>> EnumerateOp::CreateIteratorImpl(
     absl::Span<const TupleData* const> params, int num_extra_slots,
     EvaluationContext* context) const {
   TupleSlot count_slot;
@@ -2714,21 +4617,80 @@ const std::string& JoinOp::JoinKindToString(JoinOp::JoinKind kind) {
       {JoinOp::kRightOuterJoin, "RIGHT OUTER"},
       {JoinOp::kFullOuterJoin, "FULL OUTER"},
       {JoinOp::kCrossApply, "CROSS APPLY"},
-      {JoinOp::kOuterApply, "OUTER APPLY"}};
+      {JoinOp::kOuterApply, "OUTER APPLY"},
+      {JoinOp::kSemiJoin, "SEMI"},
+      {JoinOp::kAntiJoin, "ANTI"},
+      {JoinOp::kNullAwareAntiJoin, "NULL-AWARE ANTI"}};
   return (*join_names)[kind];
 }
 
+bool JoinOp::IsSemiOrAntiJoin(JoinKind kind) {
+  return kind == kSemiJoin || kind == kAntiJoin || kind == kNullAwareAntiJoin;
+}
+
 absl::StatusOr<std::unique_ptr<JoinOp>> JoinOp::Create(
     JoinKind kind, std::vector<HashJoinEqualityExprs> equality_exprs,
     std::unique_ptr<ValueExpr> remaining_condition,
     std::unique_ptr<RelationalOp> left, std::unique_ptr<RelationalOp> right,
     std::vector<std::unique_ptr<ExprArg>> left_outputs,
-    std::vector<std::unique_ptr<ExprArg>> right_outputs) {
+    std::vector<std::unique_ptr<ExprArg>> right_outputs,
+    std::optional<RangeJoinExprs> range_join_exprs) {
   if (!equality_exprs.empty()) {
     ZETASQL_RET_CHECK(kind != kCrossApply && kind != kOuterApply)
         << JoinKindToString(kind)
         << " does not support hash join equality expressions";
   }
+  std::vector<std::unique_ptr<ExprArg>> range_join_left_expr;
+  std::vector<std::unique_ptr<ExprArg>> range_join_right_expr;
+  std::vector<std::unique_ptr<ExprArg>> range_join_left_upper_bound_expr;
+  std::vector<std::unique_ptr<ExprArg>> range_join_right_upper_bound_expr;
+  if (range_join_exprs.has_value()) {
+    ZETASQL_RET_CHECK(kind != kCrossApply && kind != kOuterApply &&
+              kind != kNullAwareAntiJoin)
+        << JoinKindToString(kind) << " does not support range join expressions";
+    ZETASQL_RET_CHECK(equality_exprs.empty())
+        << "Range join expressions require no hash join equality expressions";
+    const Type* left_type = range_join_exprs->left_expr->type();
+    const Type* right_type = range_join_exprs->right_expr->type();
+    const ExprArg* upper_bound_expr =
+        range_join_exprs->left_upper_bound_expr != nullptr
+            ? range_join_exprs->left_upper_bound_expr.get()
+            : range_join_exprs->right_upper_bound_expr.get();
+    if (upper_bound_expr != nullptr) {
+      // <element> BETWEEN <lower> AND <upper>.
+      ZETASQL_RET_CHECK(range_join_exprs->left_upper_bound_expr == nullptr ||
+                range_join_exprs->right_upper_bound_expr == nullptr);
+      ZETASQL_RET_CHECK(left_type->Equals(right_type) &&
+                left_type->Equals(upper_bound_expr->type()))
+          << left_type->DebugString() << " vs. " << right_type->DebugString()
+          << " vs. " << upper_bound_expr->type()->DebugString();
+      ZETASQL_RET_CHECK(!left_type->IsRangeType());
+      if (range_join_exprs->left_upper_bound_expr != nullptr) {
+        range_join_left_upper_bound_expr.push_back(
+            std::move(range_join_exprs->left_upper_bound_expr));
+      } else {
+        range_join_right_upper_bound_expr.push_back(
+            std::move(range_join_exprs->right_upper_bound_expr));
+      }
+    } else {
+      ZETASQL_RET_CHECK(left_type->IsRangeType() || right_type->IsRangeType());
+    }
+    const Type* left_element_type =
+        left_type->IsRangeType() ? left_type->AsRange()->element_type()
+                                 : left_type;
+    const Type* right_element_type =
+        right_type->IsRangeType() ? right_type->AsRange()->element_type()
+                                  : right_type;
+    ZETASQL_RET_CHECK(left_element_type->Equals(right_element_type))
+        << left_type->DebugString() << " vs. " << right_type->DebugString();
+    range_join_left_expr.push_back(std::move(range_join_exprs->left_expr));
+    range_join_right_expr.push_back(std::move(range_join_exprs->right_expr));
+  }
+  if (kind == kNullAwareAntiJoin) {
+    ZETASQL_RET_CHECK_EQ(equality_exprs.size(), 1)
+        << JoinKindToString(kind)
+        << " requires exactly one hash join equality expression";
+  }
   std::vector<std::unique_ptr<ExprArg>> hash_join_equality_left_exprs;
   hash_join_equality_left_exprs.reserve(equality_exprs.size());
   std::vector<std::unique_ptr<ExprArg>> hash_join_equality_right_exprs;
@@ -2750,9 +4712,12 @@ absl::StatusOr<std::unique_ptr<JoinOp>> JoinOp::Create(
 
   return absl::WrapUnique(new JoinOp(
       kind, std::move(hash_join_equality_left_exprs),
-      std::move(hash_join_equality_right_exprs), std::move(remaining_condition),
-      std::move(left), std::move(right), std::move(left_outputs),
-      std::move(right_outputs)));
+      std::move(hash_join_equality_right_exprs),
+      std::move(range_join_left_expr), std::move(range_join_right_expr),
+      std::move(range_join_left_upper_bound_expr),
+      std::move(range_join_right_upper_bound_expr),
+      std::move(remaining_condition), std::move(left), std::move(right),
+      std::move(left_outputs), std::move(right_outputs)));
 }
 
 absl::Status JoinOp::SetSchemasForEvaluation(
@@ -2770,6 +4735,9 @@ absl::Status JoinOp::SetSchemasForEvaluation(
     case kLeftOuterJoin:
     case kRightOuterJoin:
     case kFullOuterJoin:
+    case kSemiJoin:
+    case kAntiJoin:
+    case kNullAwareAntiJoin:
       // Uncorrelated right-hand side.
       ZETASQL_RETURN_IF_ERROR(
           mutable_right_input()->SetSchemasForEvaluation(params_schemas));
@@ -2792,6 +4760,29 @@ absl::Status JoinOp::SetSchemasForEvaluation(
         ConcatSpans(params_schemas, {right_schema.get()})));
   }
 
+  if (range_join_left_expr() != nullptr) {
+    ZETASQL_RETURN_IF_ERROR(mutable_range_join_left_expr()
+                        ->mutable_value_expr()
+                        ->SetSchemasForEvaluation(ConcatSpans(
+                            params_schemas, {left_schema.get()})));
+    ZETASQL_RETURN_IF_ERROR(mutable_range_join_right_expr()
+                        ->mutable_value_expr()
+                        ->SetSchemasForEvaluation(ConcatSpans(
+                            params_schemas, {right_schema.get()})));
+  }
+  if (range_join_left_upper_bound_expr() != nullptr) {
+    ZETASQL_RETURN_IF_ERROR(mutable_range_join_left_upper_bound_expr()
+                        ->mutable_value_expr()
+                        ->SetSchemasForEvaluation(ConcatSpans(
+                            params_schemas, {left_schema.get()})));
+  }
+  if (range_join_right_upper_bound_expr() != nullptr) {
+    ZETASQL_RETURN_IF_ERROR(mutable_range_join_right_upper_bound_expr()
+                        ->mutable_value_expr()
+                        ->SetSchemasForEvaluation(ConcatSpans(
+                            params_schemas, {right_schema.get()})));
+  }
+
   for (ExprArg* left_output : mutable_left_outputs()) {
     ZETASQL_RETURN_IF_ERROR(left_output->mutable_value_expr()->SetSchemasForEvaluation(
         ConcatSpans(params_schemas, {left_schema.get()})));
@@ -2909,12 +4900,522 @@ class UncorrelatedRightInput : public RightInputForJoin {
   }
 
   absl::Status RecordMatchingTupleJoined(int64_t index) override {
-    tuples_and_bits_[index].joined = true;
+    tuples_and_bits_[index].joined = true;
+    return absl::OkStatus();
+  }
+
+  absl::StatusOr<bool> DidMatchingTupleJoin(int64_t index) const override {
+    return tuples_and_bits_[index].joined;
+  }
+
+  std::string DebugString() const override {
+    return iter_for_debug_string_->DebugString();
+  }
+
+ private:
+  const std::unique_ptr<TupleSchema> schema_;
+  // We store a TupleIterator instead of the debug string to avoid computing the
+  // debug string unnecessarily.
+  const std::unique_ptr<TupleIterator> iter_for_debug_string_;
+
+  std::unique_ptr<TupleDataDeque> tuples_;
+  // TupleDatas owned by 'tuples_'.
+  std::vector<RightTupleAndJoinedBit> tuples_and_bits_;
+};
+
+class UncorrelatedHashedRightInput : public RightInputForJoin {
+ public:
+  // If 'null_aware' is true, a key containing a NULL matches every key on the
+  // other side (see JoinOp::kNullAwareAntiJoin).
+  static absl::StatusOr<std::unique_ptr<UncorrelatedHashedRightInput>> Create(
+      absl::Span<const TupleData* const> params,
+      absl::Span<const ExprArg* const> left_equality_exprs,
+      absl::Span<const ExprArg* const> right_equality_exprs,
+      std::unique_ptr<TupleSchema> schema,
+      std::unique_ptr<TupleDataDeque> right_tuples,
+      std::unique_ptr<TupleIterator> iter_for_debug_string, bool null_aware,
+      EvaluationContext* context) {
+    ZETASQL_RET_CHECK_EQ(left_equality_exprs.size(), right_equality_exprs.size());
+
+    std::vector<RightTupleAndJoinedBit> right_tuples_and_bits =
+        WrapWithJoinedBits(right_tuples->GetTuplePtrs());
+
+    // The keys must be computed on this thread because evaluating expressions
+    // uses 'context', which is not thread-safe. They end up in the hash tables,
+    // so they are charged to the accountant of the tuples until this object is
+    // destroyed.
+    MemoryReservation keys_reservation(context->memory_accountant());
+    std::vector<std::unique_ptr<TupleData>> keys;
+    keys.reserve(right_tuples_and_bits.size());
+    for (const auto& tuple_and_bit : right_tuples_and_bits) {
+      ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<TupleData> key,
+                       CreateTupleMapKey(params, *tuple_and_bit.tuple,
+                                         right_equality_exprs, context));
+      absl::Status status;
+      if (!keys_reservation.Increase(key->GetPhysicalByteSize() +
+                                         sizeof(std::unique_ptr<TupleData>) +
+                                         sizeof(RightTupleMap::value_type),
+                                     &status)) {
+        return status;
+      }
+      keys.push_back(std::move(key));
+    }
+
+    RightTupleList null_key_tuples;
+    if (null_aware) {
+      for (int64_t i = 0; i < keys.size(); ++i) {
+        if (HasNullSlot(*keys[i])) {
+          null_key_tuples.push_back(&right_tuples_and_bits[i]);
+        }
+      }
+    }
+
+    const int num_threads = context->options().num_threads;
+    int num_partitions = 1;
+    if (num_threads > 1 && keys.size() >= kMinTuplesForParallelBuild) {
+      while (num_partitions < num_threads) num_partitions *= 2;
+    }
+
+    const std::vector<const Type*> key_types =
+        GetTupleMapKeyTypes(right_equality_exprs);
+    const TupleKeyHash key_hash(key_types);
+    std::vector<RightTupleMap> right_tuple_maps;
+    right_tuple_maps.reserve(num_partitions);
+    for (int i = 0; i < num_partitions; ++i) {
+      right_tuple_maps.emplace_back(/*bucket_count=*/0, key_hash,
+                                    TupleKeyEq(key_types));
+    }
+    if (num_partitions == 1) {
+      RightTupleMap& right_tuple_map = right_tuple_maps[0];
+      for (int64_t i = 0; i < keys.size(); ++i) {
+        right_tuple_map[std::move(*keys[i])].push_back(
+            &right_tuples_and_bits[i]);
+      }
+    } else {
+      // Hash the keys in parallel, scatter the tuple indexes into partitions
+      // by the high bits of the hash, and then build the hash table of each
+      // partition in parallel. Tuples are scattered in input order, so each
+      // RightTupleList has the same order as it would with a single thread.
+      std::vector<size_t> hashes(keys.size());
+      const int64_t chunk_size =
+          (static_cast<int64_t>(keys.size()) + num_threads - 1) / num_threads;
+      EvaluatorExecutor* executor = context->options().executor;
+      ZETASQL_RETURN_IF_ERROR(ParallelFor(
+          num_threads, num_threads,
+          [&](int chunk) {
+            const int64_t end =
+                std::min<int64_t>(keys.size(), (chunk + 1) * chunk_size);
+            for (int64_t i = chunk * chunk_size; i < end; ++i) {
+              hashes[i] = key_hash(*keys[i]);
+            }
+            return absl::OkStatus();
+          },
+          executor));
+
+      std::vector<std::vector<int64_t>> tuples_by_partition(num_partitions);
+      for (int64_t i = 0; i < keys.size(); ++i) {
+        tuples_by_partition[PartitionForHash(hashes[i], num_partitions)]
+            .push_back(i);
+      }
+
+      ZETASQL_RETURN_IF_ERROR(ParallelFor(
+          num_threads, num_partitions,
+          [&](int partition) {
+            RightTupleMap& right_tuple_map = right_tuple_maps[partition];
+            right_tuple_map.reserve(tuples_by_partition[partition].size());
+            for (int64_t i : tuples_by_partition[partition]) {
+              right_tuple_map[std::move(*keys[i])].push_back(
+                  &right_tuples_and_bits[i]);
+            }
+            return absl::OkStatus();
+          },
+          executor));
+    }
+    return absl::WrapUnique(new UncorrelatedHashedRightInput(
+        params, left_equality_exprs, std::move(schema), std::move(right_tuples),
+        std::move(right_tuples_and_bits), std::move(right_tuple_maps),
+        std::move(keys_reservation), std::move(iter_for_debug_string),
+        null_aware, std::move(null_key_tuples), context));
+  }
+
+  bool IsCorrelated() const override { return false; }
+
+  const TupleSchema& Schema() const override { return *schema_; }
+
+  absl::Status ResetForLeftInput(const Tuple* left_input) override {
+    if (left_input == nullptr) {
+      matching_right_tuple_list_ = std::nullopt;
+    } else {
+      ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<TupleData> key,
+                       CreateTupleMapKey(params_, *left_input->data,
+                                         left_equality_exprs_, context_));
+      if (null_aware_ && HasNullSlot(*key)) {
+        // A NULL key matches every right tuple.
+        matching_right_tuple_list_ = std::nullopt;
+        return absl::OkStatus();
+      }
+      RightTupleMap& right_tuple_map =
+          right_tuple_maps_.size() == 1
+              ? right_tuple_maps_[0]
+              : right_tuple_maps_[PartitionForHash(
+                    right_tuple_maps_[0].hash_function()(*key),
+                    right_tuple_maps_.size())];
+      const auto it = right_tuple_map.find(*key);
+      if (it == right_tuple_map.end()) {
+        // No matching tuples.
+        matching_right_tuple_list_ = nullptr;
+      } else {
+        const TupleData& other_key = it->first;
+        matching_right_tuple_list_ = &it->second;
+        // We have to compare 'key' against 'other_key', because TupleData::==()
+        // uses Value::Equals(), which is more permissive than SQL equality. In
+        // particular, SQL specifies that the result of NULL = NULL is NULL and
+        // that the result of NaN = NaN is false, but NULL.Equals(NULL) and
+        // NaN.Equals(NaN) are both true.
+        ZETASQL_RET_CHECK_EQ(key->num_slots(), other_key.num_slots());
+        absl::Status status;
+        for (int i = 0; i < key->num_slots(); ++i) {
+          const ComparisonFunction equals_function(FunctionKind::kEqual,
+                                                   types::BoolType());
+          Value equals_result;
+          if (!equals_function.Eval(
+                  params_, {key->slot(i).value(), other_key.slot(i).value()},
+                  context_, &equals_result, &status)) {
+            return status;
+          }
+          if (equals_result != values::Bool(true)) {
+            matching_right_tuple_list_ = nullptr;
+            break;
+          }
+        }
+      }
+      if (null_aware_ && matching_right_tuple_list_ == nullptr &&
+          !null_key_tuples_.empty()) {
+        // Right tuples with a NULL key match every left tuple.
+        matching_right_tuple_list_ = &null_key_tuples_;
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  int64_t GetNumMatchingTuples() const override {
+    if (!matching_right_tuple_list_.has_value()) {
+      // No value -> iterate over everything.
+      return right_tuples_and_bits_.size();
+    }
+    if (matching_right_tuple_list_ == nullptr) {
+      // NULL value -> no matches.
+      return 0;
+    }
+    return matching_right_tuple_list_.value()->size();
+  }
+
+  const TupleData& GetMatchingTuple(int64_t index) const override {
+    if (!matching_right_tuple_list_.has_value()) {
+      // No value -> iterate over everything.
+      return *right_tuples_and_bits_[index].tuple;
+    }
+    // Otherwise iterate over the list.
+    return *(*matching_right_tuple_list_.value())[index]->tuple;
+  }
+
+  absl::Status RecordMatchingTupleJoined(int64_t index) override {
+    if (!matching_right_tuple_list_.has_value()) {
+      // No value -> iterate over everything.
+      right_tuples_and_bits_[index].joined = true;
+    } else {
+      // Otherwise iterate over the list.
+      (*matching_right_tuple_list_.value())[index]->joined = true;
+    }
+    return absl::OkStatus();
+  }
+
+  absl::StatusOr<bool> DidMatchingTupleJoin(int64_t index) const override {
+    if (!matching_right_tuple_list_.has_value()) {
+      // No value -> iterate over everything.
+      return right_tuples_and_bits_[index].joined;
+    } else {
+      // Otherwise iterate over the list.
+      return (*matching_right_tuple_list_.value())[index]->joined;
+    }
+  }
+
+  std::string DebugString() const override {
+    return iter_for_debug_string_->DebugString();
+  }
+
+  // Returns a JoinKeyFilter of the values of slot 'key_idx' of the keys, which
+  // have type 'type'.
+  std::unique_ptr<JoinKeyFilter> CreateJoinKeyFilter(int key_idx,
+                                                     const Type* type) const {
+    int64_t num_keys = 0;
+    for (const RightTupleMap& right_tuple_map : right_tuple_maps_) {
+      num_keys += right_tuple_map.size();
+    }
+    auto filter = std::make_unique<JoinKeyFilter>(num_keys);
+    for (const RightTupleMap& right_tuple_map : right_tuple_maps_) {
+      for (const auto& [key, tuples] : right_tuple_map) {
+        const Value& value = key.slot(key_idx).value();
+        // Undo the INT64 to UINT64 conversion of CreateTupleMapKey().
+        if (type->IsInt64() && value.type_kind() == TYPE_UINT64) {
+          filter->Add(
+              values::Int64(static_cast<int64_t>(value.uint64_value())));
+        } else {
+          filter->Add(value);
+        }
+      }
+    }
+    return filter;
+  }
+
+ private:
+  using RightTupleList = std::vector<RightTupleAndJoinedBit*>;
+  // Maps the values of the right-hand side join expressions to the
+  // corresponding right tuples.
+  using RightTupleMap =
+      absl::flat_hash_map<TupleData, RightTupleList, TupleKeyHash, TupleKeyEq>;
+
+  // The minimum number of right tuples for which the hash table is built with
+  // more than one thread. Below this, the overhead of starting threads
+  // dominates.
+  static constexpr int64_t kMinTuplesForParallelBuild = 1024;
+
+  // Returns the partition of a key with hash 'hash', given that there are
+  // 'num_partitions' partitions (a power of two). Uses the high bits of the
+  // hash, since absl::flat_hash_map uses the low bits to pick a bucket.
+  static int PartitionForHash(size_t hash, int num_partitions) {
+    if (num_partitions <= 1) return 0;
+    const int num_bits =
+        absl::countr_zero(static_cast<uint32_t>(num_partitions));
+    return static_cast<int>(static_cast<uint64_t>(hash) >> (64 - num_bits));
+  }
+
+  UncorrelatedHashedRightInput(
+      absl::Span<const TupleData* const> params,
+      absl::Span<const ExprArg* const> left_equality_exprs,
+      std::unique_ptr<TupleSchema> schema,
+      std::unique_ptr<TupleDataDeque> right_tuples,
+      // The TupleDatas in here are owned by 'right_tuples'.
+      std::vector<RightTupleAndJoinedBit> right_tuples_and_bits,
+      std::vector<RightTupleMap> right_tuple_maps,
+      MemoryReservation keys_reservation,
+      std::unique_ptr<TupleIterator> iter_for_debug_string, bool null_aware,
+      RightTupleList null_key_tuples, EvaluationContext* context)
+      : params_(params.begin(), params.end()),
+        left_equality_exprs_(left_equality_exprs.begin(),
+                             left_equality_exprs.end()),
+        schema_(std::move(schema)),
+        right_tuples_(std::move(right_tuples)),
+        right_tuples_and_bits_(std::move(right_tuples_and_bits)),
+        right_tuple_maps_(std::move(right_tuple_maps)),
+        keys_reservation_(std::move(keys_reservation)),
+        null_aware_(null_aware),
+        null_key_tuples_(std::move(null_key_tuples)),
+        iter_for_debug_string_(std::move(iter_for_debug_string)),
+        context_(context) {}
+
+  UncorrelatedHashedRightInput(const UncorrelatedHashedRightInput&) = delete;
+  UncorrelatedHashedRightInput& operator=(const UncorrelatedHashedRightInput&) =
+      delete;
+
+  // Returns true if some slot of 'key' is NULL.
+  static bool HasNullSlot(const TupleData& key) {
+    for (int i = 0; i < key.num_slots(); ++i) {
+      if (key.slot(i).value().is_null()) return true;
+    }
+    return false;
+  }
+
+  // Returns the slot types of the TupleMap keys created from 'args' by
+  // CreateTupleMapKey(), for hashing them.
+  static std::vector<const Type*> GetTupleMapKeyTypes(
+      absl::Span<const ExprArg* const> args) {
+    std::vector<const Type*> key_types;
+    key_types.reserve(args.size());
+    for (const ExprArg* arg : args) {
+      // Most INT64 keys are stored as UINT64 values, see below.
+      key_types.push_back(arg->type()->IsInt64() ? types::Uint64Type()
+                                                 : arg->type());
+    }
+    return key_types;
+  }
+
+  // Returns the TupleMap key corresponding to 'row' and 'args'.
+  static absl::StatusOr<std::unique_ptr<TupleData>> CreateTupleMapKey(
+      absl::Span<const TupleData* const> params, const TupleData& row,
+      absl::Span<const ExprArg* const> args, EvaluationContext* context) {
+    auto key = std::make_unique<TupleData>(args.size());
+    const std::vector<const TupleData*> params_and_row =
+        ConcatSpans(params, {&row});
+    for (int i = 0; i < args.size(); ++i) {
+      const ExprArg* arg = args[i];
+      TupleSlot* slot = key->mutable_slot(i);
+      absl::Status status;
+      if (!arg->value_expr()->EvalSimple(params_and_row, context, slot,
+                                         &status)) {
+        return status;
+      }
+      // Represent non-negative INT64 values with UINT64 values to support
+      // equalities of the form INT64 = UINT64 (or UINT64 = INT64).
+      if (slot->value().type_kind() == TYPE_INT64 && !slot->value().is_null()) {
+        const int64_t int64_value = slot->value().int64_value();
+        if (int64_value >= 0) {
+          slot->SetValue(values::Uint64(static_cast<uint64_t>(int64_value)));
+        }
+      }
+    }
+    return key;
+  }
+
+  const std::vector<const TupleData*> params_;
+  const std::vector<const ExprArg*> left_equality_exprs_;
+  const std::unique_ptr<TupleSchema> schema_;
+
+  std::unique_ptr<TupleDataDeque> right_tuples_;
+  // The TupleDatas in here are owned by 'right_tuples_'.
+  std::vector<RightTupleAndJoinedBit> right_tuples_and_bits_;
+  // One hash table per partition of the keys (see PartitionForHash()). There
+  // is only one partition unless the table was built with multiple threads.
+  std::vector<RightTupleMap> right_tuple_maps_;
+  // Accounts for the keys of 'right_tuple_maps_'.
+  MemoryReservation keys_reservation_;
+  const bool null_aware_;
+  // The right tuples whose key contains a NULL. Only populated if
+  // 'null_aware_' is true.
+  RightTupleList null_key_tuples_;
+  // The TupleList in 'right_tuple_maps_' corresponding to the current left
+  // tuple. NULL indicates there are no corresponding tuples. No value indicates
+  // that left tuple in the last call to ResetForLeftInput() was NULL (or, if
+  // 'null_aware_' is true, that its key contained a NULL) and therefore
+  // GetNumMatchingTuples()/etc. should iterate over everything.
+  std::optional<RightTupleList*> matching_right_tuple_list_ = nullptr;
+
+  // We store a TupleIterator instead of the debug string to avoid computing the
+  // debug string unnecessarily.
+  const std::unique_ptr<TupleIterator> iter_for_debug_string_;
+
+  EvaluationContext* context_;
+};
+
+// Represents the right-hand input side of a merge join, whose right tuples are
+// sorted on the keys of the HashJoinEqualityExprs. The left tuples are
+// expected in the same order, so the right tuples that match a left tuple are
+// found by advancing a cursor past the right tuples with smaller keys, and are
+// the run of right tuples with equal keys at the cursor. A left tuple whose
+// key is smaller than the previous one (which only happens if the left input
+// is not actually sorted) restarts the cursor, so the result is correct
+// regardless.
+class UncorrelatedSortedRightInput : public RightInputForJoin {
+ public:
+  // Returns true if 'right_tuples' are sorted on 'right_equality_exprs'
+  // according to 'ordering'. A merge join is only correct if they are.
+  static absl::StatusOr<bool> IsSorted(
+      absl::Span<const TupleData* const> params,
+      absl::Span<const ExprArg* const> right_equality_exprs,
+      absl::Span<const RelationalProperties::OrderingKey> ordering,
+      const TupleDataDeque& right_tuples, EvaluationContext* context) {
+    ZETASQL_RET_CHECK_EQ(ordering.size(), right_equality_exprs.size());
+    TupleData previous_key(right_equality_exprs.size());
+    TupleData key(right_equality_exprs.size());
+    const std::vector<const TupleData*> tuples = right_tuples.GetTuplePtrs();
+    for (int64_t i = 0; i < tuples.size(); ++i) {
+      ZETASQL_RETURN_IF_ERROR(
+          EvalKey(params, *tuples[i], right_equality_exprs, context, &key));
+      if (i > 0 && CompareKeys(ordering, previous_key, key) > 0) {
+        return false;
+      }
+      std::swap(previous_key, key);
+    }
+    return true;
+  }
+
+  // 'right_tuples' must be sorted (see IsSorted()).
+  static absl::StatusOr<std::unique_ptr<UncorrelatedSortedRightInput>> Create(
+      absl::Span<const TupleData* const> params,
+      absl::Span<const ExprArg* const> left_equality_exprs,
+      absl::Span<const ExprArg* const> right_equality_exprs,
+      absl::Span<const RelationalProperties::OrderingKey> ordering,
+      std::unique_ptr<TupleSchema> schema,
+      std::unique_ptr<TupleDataDeque> right_tuples,
+      std::unique_ptr<TupleIterator> iter_for_debug_string,
+      EvaluationContext* context) {
+    ZETASQL_RET_CHECK_EQ(left_equality_exprs.size(), right_equality_exprs.size());
+    ZETASQL_RET_CHECK_EQ(ordering.size(), right_equality_exprs.size());
+    return absl::WrapUnique(new UncorrelatedSortedRightInput(
+        params, left_equality_exprs, right_equality_exprs, ordering,
+        std::move(schema), std::move(right_tuples),
+        std::move(iter_for_debug_string), context));
+  }
+
+  UncorrelatedSortedRightInput(const UncorrelatedSortedRightInput&) = delete;
+  UncorrelatedSortedRightInput& operator=(const UncorrelatedSortedRightInput&) =
+      delete;
+
+  bool IsCorrelated() const override { return false; }
+
+  const TupleSchema& Schema() const override { return *schema_; }
+
+  absl::Status ResetForLeftInput(const Tuple* left_input) override {
+    if (left_input == nullptr) {
+      // Iterate over everything.
+      match_begin_ = std::nullopt;
+      return absl::OkStatus();
+    }
+    ZETASQL_RETURN_IF_ERROR(EvalKey(params_, *left_input->data, left_equality_exprs_,
+                            context_, &left_key_));
+    for (int i = 0; i < left_key_.num_slots(); ++i) {
+      if (left_key_.slot(i).value().is_null()) {
+        // NULL never equals anything.
+        match_begin_ = 0;
+        match_end_ = 0;
+        return absl::OkStatus();
+      }
+    }
+    if (has_previous_left_key_ &&
+        CompareKeys(ordering_, left_key_, previous_left_key_) < 0) {
+      // The left input is not sorted after all.
+      cursor_ = 0;
+    }
+
+    TupleData right_key(left_key_.num_slots());
+    int cmp = 1;
+    while (cursor_ < right_tuples_and_bits_.size()) {
+      ZETASQL_RETURN_IF_ERROR(EvalRightKey(cursor_, &right_key));
+      cmp = CompareKeys(ordering_, right_key, left_key_);
+      if (cmp >= 0) break;
+      ++cursor_;
+    }
+    match_end_ = cursor_;
+    if (cmp == 0) {
+      ++match_end_;
+      while (match_end_ < right_tuples_and_bits_.size()) {
+        ZETASQL_RETURN_IF_ERROR(EvalRightKey(match_end_, &right_key));
+        if (CompareKeys(ordering_, right_key, left_key_) != 0) break;
+        ++match_end_;
+      }
+    }
+    match_begin_ = cursor_;
+    std::swap(previous_left_key_, left_key_);
+    has_previous_left_key_ = true;
+    return absl::OkStatus();
+  }
+
+  int64_t GetNumMatchingTuples() const override {
+    if (!match_begin_.has_value()) return right_tuples_and_bits_.size();
+    return match_end_ - *match_begin_;
+  }
+
+  const TupleData& GetMatchingTuple(int64_t index) const override {
+    return *right_tuples_and_bits_[match_begin_.value_or(0) + index].tuple;
+  }
+
+  absl::Status RecordMatchingTupleJoined(int64_t index) override {
+    right_tuples_and_bits_[match_begin_.value_or(0) + index].joined = true;
     return absl::OkStatus();
   }
 
   absl::StatusOr<bool> DidMatchingTupleJoin(int64_t index) const override {
-    return tuples_and_bits_[index].joined;
+    return right_tuples_and_bits_[match_begin_.value_or(0) + index].joined;
   }
 
   std::string DebugString() const override {
@@ -2922,128 +5423,268 @@ class UncorrelatedRightInput : public RightInputForJoin {
   }
 
  private:
+  UncorrelatedSortedRightInput(
+      absl::Span<const TupleData* const> params,
+      absl::Span<const ExprArg* const> left_equality_exprs,
+      absl::Span<const ExprArg* const> right_equality_exprs,
+      absl::Span<const RelationalProperties::OrderingKey> ordering,
+      std::unique_ptr<TupleSchema> schema,
+      std::unique_ptr<TupleDataDeque> right_tuples,
+      std::unique_ptr<TupleIterator> iter_for_debug_string,
+      EvaluationContext* context)
+      : params_(params.begin(), params.end()),
+        left_equality_exprs_(left_equality_exprs.begin(),
+                             left_equality_exprs.end()),
+        right_equality_exprs_(right_equality_exprs.begin(),
+                              right_equality_exprs.end()),
+        ordering_(ordering.begin(), ordering.end()),
+        schema_(std::move(schema)),
+        right_tuples_(std::move(right_tuples)),
+        right_tuples_and_bits_(
+            WrapWithJoinedBits(right_tuples_->GetTuplePtrs())),
+        left_key_(left_equality_exprs.size()),
+        previous_left_key_(left_equality_exprs.size()),
+        iter_for_debug_string_(std::move(iter_for_debug_string)),
+        context_(context) {}
+
+  // Sets the slots of 'key' to 'args' evaluated on 'row'.
+  static absl::Status EvalKey(absl::Span<const TupleData* const> params,
+                              const TupleData& row,
+                              absl::Span<const ExprArg* const> args,
+                              EvaluationContext* context, TupleData* key) {
+    const std::vector<const TupleData*> params_and_row =
+        ConcatSpans(params, {&row});
+    for (int i = 0; i < args.size(); ++i) {
+      absl::Status status;
+      if (!args[i]->value_expr()->EvalSimple(params_and_row, context,
+                                             key->mutable_slot(i), &status)) {
+        return status;
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  // Compares 'key1' and 'key2' by 'ordering', returning a negative number,
+  // zero or a positive number. NULLs compare equal to each other here.
+  static int CompareKeys(
+      absl::Span<const RelationalProperties::OrderingKey> ordering,
+      const TupleData& key1, const TupleData& key2) {
+    for (int i = 0; i < ordering.size(); ++i) {
+      const Value& value1 = key1.slot(i).value();
+      const Value& value2 = key2.slot(i).value();
+      if (value1.is_null() || value2.is_null()) {
+        if (value1.is_null() == value2.is_null()) continue;
+        // NULLs are placed by 'nulls_first' regardless of the direction.
+        return value1.is_null() == ordering[i].nulls_first ? -1 : 1;
+      }
+      int cmp;
+      if (value1.LessThan(value2)) {
+        cmp = -1;
+      } else if (value2.LessThan(value1)) {
+        cmp = 1;
+      } else {
+        continue;
+      }
+      return ordering[i].descending ? -cmp : cmp;
+    }
+    return 0;
+  }
+
+  absl::Status EvalRightKey(int64_t index, TupleData* key) const {
+    return EvalKey(params_, *right_tuples_and_bits_[index].tuple,
+                   right_equality_exprs_, context_, key);
+  }
+
+  const std::vector<const TupleData*> params_;
+  const std::vector<const ExprArg*> left_equality_exprs_;
+  const std::vector<const ExprArg*> right_equality_exprs_;
+  const std::vector<RelationalProperties::OrderingKey> ordering_;
   const std::unique_ptr<TupleSchema> schema_;
+
+  std::unique_ptr<TupleDataDeque> right_tuples_;
+  // The TupleDatas in here are owned by 'right_tuples_'.
+  std::vector<RightTupleAndJoinedBit> right_tuples_and_bits_;
+
+  // The index of the first right tuple whose key is not smaller than the key
+  // of the last non-NULL left key.
+  int64_t cursor_ = 0;
+  // The right tuples in [match_begin_, match_end_) match the current left
+  // tuple. No value indicates that the left tuple in the last call to
+  // ResetForLeftInput() was NULL and therefore GetNumMatchingTuples()/etc.
+  // should iterate over everything.
+  std::optional<int64_t> match_begin_ = 0;
+  int64_t match_end_ = 0;
+  // Reused across calls to ResetForLeftInput().
+  TupleData left_key_;
+  TupleData previous_left_key_;
+  bool has_previous_left_key_ = false;
+
   // We store a TupleIterator instead of the debug string to avoid computing the
   // debug string unnecessarily.
   const std::unique_ptr<TupleIterator> iter_for_debug_string_;
 
-  std::unique_ptr<TupleDataDeque> tuples_;
-  // TupleDatas owned by 'tuples_'.
-  std::vector<RightTupleAndJoinedBit> tuples_and_bits_;
+  EvaluationContext* context_;
 };
 
-class UncorrelatedHashedRightInput : public RightInputForJoin {
+// Represents the right-hand input side of a join with JoinOp::RangeJoinExprs.
+// The right tuples are indexed by the bounds of their RANGE (or element, or
+// BETWEEN bounds): they are sorted by start, and a segment tree over the sorted
+// order holds the largest end of each segment. The right tuples that may join
+// with a left tuple are the ones that start before the left RANGE ends, which
+// is a prefix of the sorted order, and end after it starts, which rules out
+// whole segments at a time. Tuples whose RANGE (or element, or a BETWEEN
+// bound) is NULL join with nothing, since RANGE_OVERLAPS(), RANGE_CONTAINS()
+// and BETWEEN are not TRUE for them.
+class UncorrelatedRangeIndexedRightInput : public RightInputForJoin {
  public:
-  static absl::StatusOr<std::unique_ptr<UncorrelatedHashedRightInput>> Create(
-      absl::Span<const TupleData* const> params,
-      absl::Span<const ExprArg* const> left_equality_exprs,
-      absl::Span<const ExprArg* const> right_equality_exprs,
-      std::unique_ptr<TupleSchema> schema,
-      std::unique_ptr<TupleDataDeque> right_tuples,
-      std::unique_ptr<TupleIterator> iter_for_debug_string,
-      EvaluationContext* context) {
-    ZETASQL_RET_CHECK_EQ(left_equality_exprs.size(), right_equality_exprs.size());
-
+  // 'left_upper_bound_expr' and 'right_upper_bound_expr' are the
+  // RangeJoinExprs of the same name, and may be NULL.
+  static absl::StatusOr<std::unique_ptr<UncorrelatedRangeIndexedRightInput>>
+  Create(absl::Span<const TupleData* const> params, const ExprArg* left_expr,
+         const ExprArg* right_expr, const ExprArg* left_upper_bound_expr,
+         const ExprArg* right_upper_bound_expr,
+         std::unique_ptr<TupleSchema> schema,
+         std::unique_ptr<TupleDataDeque> right_tuples,
+         std::unique_ptr<TupleIterator> iter_for_debug_string,
+         EvaluationContext* context) {
     std::vector<RightTupleAndJoinedBit> right_tuples_and_bits =
         WrapWithJoinedBits(right_tuples->GetTuplePtrs());
-
-    auto right_tuple_map = std::make_unique<RightTupleMap>();
-    for (auto& tuple_and_bit : right_tuples_and_bits) {
-      ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<TupleData> key,
-                       CreateTupleMapKey(params, *tuple_and_bit.tuple,
-                                         right_equality_exprs, context));
-      (*right_tuple_map)[*key].push_back(&tuple_and_bit);
+    // Elements and BETWEEN bounds are closed intervals, while a RANGE
+    // excludes its end.
+    const bool right_end_is_inclusive = !right_expr->type()->IsRangeType();
+
+    std::vector<Entry> entries;
+    entries.reserve(right_tuples_and_bits.size());
+    for (int64_t i = 0; i < right_tuples_and_bits.size(); ++i) {
+      const TupleData& right_tuple = *right_tuples_and_bits[i].tuple;
+      ZETASQL_ASSIGN_OR_RETURN(const Value value,
+                       EvalExpr(params, right_tuple, right_expr, context));
+      if (value.is_null()) continue;
+      if (right_upper_bound_expr != nullptr) {
+        ZETASQL_ASSIGN_OR_RETURN(
+            const Value upper_bound,
+            EvalExpr(params, right_tuple, right_upper_bound_expr, context));
+        if (upper_bound.is_null()) continue;
+        entries.push_back({value, upper_bound, i});
+      } else if (right_end_is_inclusive) {
+        entries.push_back({value, value, i});
+      } else {
+        entries.push_back({value.start(), value.end(), i});
+      }
     }
-    return absl::WrapUnique(new UncorrelatedHashedRightInput(
-        params, left_equality_exprs, std::move(schema), std::move(right_tuples),
-        std::move(right_tuples_and_bits), std::move(right_tuple_map),
-        std::move(iter_for_debug_string), context));
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const Entry& a, const Entry& b) {
+                       return StartLessThan(a.start, b.start);
+                     });
+
+    return absl::WrapUnique(new UncorrelatedRangeIndexedRightInput(
+        params, left_expr, left_upper_bound_expr, std::move(schema),
+        std::move(right_tuples), std::move(right_tuples_and_bits),
+        std::move(entries),
+        /*left_end_is_inclusive=*/!left_expr->type()->IsRangeType(),
+        right_end_is_inclusive, std::move(iter_for_debug_string), context));
   }
 
+  UncorrelatedRangeIndexedRightInput(
+      const UncorrelatedRangeIndexedRightInput&) = delete;
+  UncorrelatedRangeIndexedRightInput& operator=(
+      const UncorrelatedRangeIndexedRightInput&) = delete;
+
   bool IsCorrelated() const override { return false; }
 
   const TupleSchema& Schema() const override { return *schema_; }
 
   absl::Status ResetForLeftInput(const Tuple* left_input) override {
     if (left_input == nullptr) {
-      matching_right_tuple_list_ = std::nullopt;
-    } else {
-      ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<TupleData> key,
-                       CreateTupleMapKey(params_, *left_input->data,
-                                         left_equality_exprs_, context_));
-      const auto it = right_tuple_map_->find(*key);
-      if (it == right_tuple_map_->end()) {
-        // No matching tuples.
-        matching_right_tuple_list_ = nullptr;
-      } else {
-        const TupleData& other_key = it->first;
-        matching_right_tuple_list_ = &it->second;
-        // We have to compare 'key' against 'other_key', because TupleData::==()
-        // uses Value::Equals(), which is more permissive than SQL equality. In
-        // particular, SQL specifies that the result of NULL = NULL is NULL and
-        // that the result of NaN = NaN is false, but NULL.Equals(NULL) and
-        // NaN.Equals(NaN) are both true.
-        ZETASQL_RET_CHECK_EQ(key->num_slots(), other_key.num_slots());
-        absl::Status status;
-        for (int i = 0; i < key->num_slots(); ++i) {
-          const ComparisonFunction equals_function(FunctionKind::kEqual,
-                                                   types::BoolType());
-          Value equals_result;
-          if (!equals_function.Eval(
-                  params_, {key->slot(i).value(), other_key.slot(i).value()},
-                  context_, &equals_result, &status)) {
-            return status;
-          }
-          if (equals_result != values::Bool(true)) {
-            matching_right_tuple_list_ = nullptr;
-            break;
-          }
-        }
+      matching_right_tuples_ = std::nullopt;
+      return absl::OkStatus();
+    }
+    matching_right_tuples_.emplace();
+    ZETASQL_ASSIGN_OR_RETURN(
+        const Value value,
+        EvalExpr(params_, *left_input->data, left_expr_, context_));
+    if (value.is_null()) {
+      return absl::OkStatus();
+    }
+    Value left_start = value;
+    Value left_end = value;
+    if (left_upper_bound_expr_ != nullptr) {
+      ZETASQL_ASSIGN_OR_RETURN(left_end, EvalExpr(params_, *left_input->data,
+                                          left_upper_bound_expr_, context_));
+      if (left_end.is_null()) {
+        return absl::OkStatus();
+      }
+    } else if (!left_end_is_inclusive_) {
+      left_start = value.start();
+      left_end = value.end();
+    }
+
+    // The entries that start before the left RANGE ends.
+    const int64_t num_candidates =
+        std::partition_point(entries_.begin(), entries_.end(),
+                             [&](const Entry& entry) {
+                               return StartsBefore(entry.start, left_end);
+                             }) -
+        entries_.begin();
+
+    // Visit the segments of the candidates that end after the left RANGE
+    // starts, as (node, first entry, segment size) tuples.
+    std::vector<int64_t> matching_indexes;
+    std::vector<std::tuple<int64_t, int64_t, int64_t>> stack = {
+        {1, 0, num_leaves_}};
+    while (!stack.empty()) {
+      const auto [node, first_entry, segment_size] = stack.back();
+      stack.pop_back();
+      if (first_entry >= num_candidates || max_end_[node] == nullptr ||
+          !EndsAfter(*max_end_[node], left_start)) {
+        continue;
       }
+      if (segment_size == 1) {
+        matching_indexes.push_back(entries_[first_entry].tuple_index);
+        continue;
+      }
+      const int64_t half = segment_size / 2;
+      stack.push_back({2 * node + 1, first_entry + half, half});
+      stack.push_back({2 * node, first_entry, half});
+    }
+
+    // Keep the order of the right input, like the other join inputs.
+    std::sort(matching_indexes.begin(), matching_indexes.end());
+    matching_right_tuples_->reserve(matching_indexes.size());
+    for (int64_t index : matching_indexes) {
+      matching_right_tuples_->push_back(&right_tuples_and_bits_[index]);
     }
     return absl::OkStatus();
   }
 
   int64_t GetNumMatchingTuples() const override {
-    if (!matching_right_tuple_list_.has_value()) {
-      // No value -> iterate over everything.
+    if (!matching_right_tuples_.has_value()) {
       return right_tuples_and_bits_.size();
     }
-    if (matching_right_tuple_list_ == nullptr) {
-      // NULL value -> no matches.
-      return 0;
-    }
-    return matching_right_tuple_list_.value()->size();
+    return matching_right_tuples_->size();
   }
 
   const TupleData& GetMatchingTuple(int64_t index) const override {
-    if (!matching_right_tuple_list_.has_value()) {
-      // No value -> iterate over everything.
+    if (!matching_right_tuples_.has_value()) {
       return *right_tuples_and_bits_[index].tuple;
     }
-    // Otherwise iterate over the list.
-    return *(*matching_right_tuple_list_.value())[index]->tuple;
+    return *(*matching_right_tuples_)[index]->tuple;
   }
 
   absl::Status RecordMatchingTupleJoined(int64_t index) override {
-    if (!matching_right_tuple_list_.has_value()) {
-      // No value -> iterate over everything.
+    if (!matching_right_tuples_.has_value()) {
       right_tuples_and_bits_[index].joined = true;
     } else {
-      // Otherwise iterate over the list.
-      (*matching_right_tuple_list_.value())[index]->joined = true;
+      (*matching_right_tuples_)[index]->joined = true;
     }
     return absl::OkStatus();
   }
 
   absl::StatusOr<bool> DidMatchingTupleJoin(int64_t index) const override {
-    if (!matching_right_tuple_list_.has_value()) {
-      // No value -> iterate over everything.
+    if (!matching_right_tuples_.has_value()) {
       return right_tuples_and_bits_[index].joined;
-    } else {
-      // Otherwise iterate over the list.
-      return (*matching_right_tuple_list_.value())[index]->joined;
     }
+    return (*matching_right_tuples_)[index]->joined;
   }
 
   std::string DebugString() const override {
@@ -3051,73 +5692,120 @@ class UncorrelatedHashedRightInput : public RightInputForJoin {
   }
 
  private:
-  using RightTupleList = std::vector<RightTupleAndJoinedBit*>;
-  // Maps the values of the right-hand side join expressions to the
-  // corresponding right tuples.
-  using RightTupleMap = absl::flat_hash_map<TupleData, RightTupleList>;
+  // The bounds of the RANGE of a right tuple, its element twice, or its
+  // BETWEEN bounds. A NULL 'start' or 'end' is unbounded.
+  struct Entry {
+    Value start;
+    Value end;
+    // Index into 'right_tuples_and_bits_'.
+    int64_t tuple_index;
+  };
 
-  UncorrelatedHashedRightInput(
-      absl::Span<const TupleData* const> params,
-      absl::Span<const ExprArg* const> left_equality_exprs,
-      std::unique_ptr<TupleSchema> schema,
+  UncorrelatedRangeIndexedRightInput(
+      absl::Span<const TupleData* const> params, const ExprArg* left_expr,
+      const ExprArg* left_upper_bound_expr, std::unique_ptr<TupleSchema> schema,
       std::unique_ptr<TupleDataDeque> right_tuples,
       // The TupleDatas in here are owned by 'right_tuples'.
       std::vector<RightTupleAndJoinedBit> right_tuples_and_bits,
-      std::unique_ptr<RightTupleMap> right_tuple_map,
+      std::vector<Entry> entries, bool left_end_is_inclusive,
+      bool right_end_is_inclusive,
       std::unique_ptr<TupleIterator> iter_for_debug_string,
       EvaluationContext* context)
       : params_(params.begin(), params.end()),
-        left_equality_exprs_(left_equality_exprs.begin(),
-                             left_equality_exprs.end()),
+        left_expr_(left_expr),
+        left_upper_bound_expr_(left_upper_bound_expr),
         schema_(std::move(schema)),
         right_tuples_(std::move(right_tuples)),
         right_tuples_and_bits_(std::move(right_tuples_and_bits)),
-        right_tuple_map_(std::move(right_tuple_map)),
+        entries_(std::move(entries)),
+        left_end_is_inclusive_(left_end_is_inclusive),
+        right_end_is_inclusive_(right_end_is_inclusive),
         iter_for_debug_string_(std::move(iter_for_debug_string)),
-        context_(context) {}
-
-  UncorrelatedHashedRightInput(const UncorrelatedHashedRightInput&) = delete;
-  UncorrelatedHashedRightInput& operator=(const UncorrelatedHashedRightInput&) =
-      delete;
+        context_(context) {
+    num_leaves_ = 1;
+    while (num_leaves_ < entries_.size()) num_leaves_ *= 2;
+    max_end_.resize(2 * num_leaves_, nullptr);
+    for (int64_t i = 0; i < entries_.size(); ++i) {
+      max_end_[num_leaves_ + i] = &entries_[i].end;
+    }
+    for (int64_t node = num_leaves_ - 1; node >= 1; --node) {
+      const Value* left_end = max_end_[2 * node];
+      const Value* right_end = max_end_[2 * node + 1];
+      max_end_[node] =
+          left_end == nullptr ||
+                  (right_end != nullptr && EndLessThan(*left_end, *right_end))
+              ? right_end
+              : left_end;
+    }
+  }
 
-  // Returns the TupleMap key corresponding to 'row' and 'args'.
-  static absl::StatusOr<std::unique_ptr<TupleData>> CreateTupleMapKey(
+  static absl::StatusOr<Value> EvalExpr(
       absl::Span<const TupleData* const> params, const TupleData& row,
-      absl::Span<const ExprArg* const> args, EvaluationContext* context) {
-    auto key = std::make_unique<TupleData>(args.size());
-    for (int i = 0; i < args.size(); ++i) {
-      const ExprArg* arg = args[i];
-      TupleSlot* slot = key->mutable_slot(i);
-      absl::Status status;
-      if (!arg->value_expr()->EvalSimple(ConcatSpans(params, {&row}), context,
-                                         slot, &status)) {
-        return status;
-      }
-      // Represent non-negative INT64 values with UINT64 values to support
-      // equalities of the form INT64 = UINT64 (or UINT64 = INT64).
-      if (slot->value().type_kind() == TYPE_INT64 && !slot->value().is_null()) {
-        const int64_t int64_value = slot->value().int64_value();
-        if (int64_value >= 0) {
-          slot->SetValue(values::Uint64(static_cast<uint64_t>(int64_value)));
-        }
-      }
+      const ExprArg* arg, EvaluationContext* context) {
+    TupleSlot slot;
+    absl::Status status;
+    if (!arg->value_expr()->EvalSimple(ConcatSpans(params, {&row}), context,
+                                       &slot, &status)) {
+      return status;
     }
-    return key;
+    return slot.value();
+  }
+
+  // Compares RANGE starts, where NULL is unbounded.
+  static bool StartLessThan(const Value& start1, const Value& start2) {
+    if (start2.is_null()) return false;
+    return start1.is_null() || start1.LessThan(start2);
+  }
+
+  // Compares RANGE ends, where NULL is unbounded.
+  static bool EndLessThan(const Value& end1, const Value& end2) {
+    if (end1.is_null()) return false;
+    return end2.is_null() || end1.LessThan(end2);
+  }
+
+  // Returns true if a right tuple that starts at 'start' starts before a left
+  // tuple that ends at 'left_end', i.e., the element, the upper bound or the
+  // exclusive end of its RANGE.
+  bool StartsBefore(const Value& start, const Value& left_end) const {
+    if (start.is_null()) return true;
+    if (left_end_is_inclusive_) return !left_end.LessThan(start);
+    return left_end.is_null() || start.LessThan(left_end);
+  }
+
+  // Returns true if a right tuple that ends at 'end', i.e., its element, its
+  // upper bound or the exclusive end of its RANGE, ends after a left tuple
+  // that starts at 'left_start'.
+  bool EndsAfter(const Value& end, const Value& left_start) const {
+    if (left_start.is_null()) return true;
+    if (right_end_is_inclusive_) return !end.LessThan(left_start);
+    return end.is_null() || left_start.LessThan(end);
   }
 
   const std::vector<const TupleData*> params_;
-  const std::vector<const ExprArg*> left_equality_exprs_;
+  const ExprArg* left_expr_;
+  const ExprArg* left_upper_bound_expr_;  // May be NULL
   const std::unique_ptr<TupleSchema> schema_;
 
   std::unique_ptr<TupleDataDeque> right_tuples_;
   // The TupleDatas in here are owned by 'right_tuples_'.
   std::vector<RightTupleAndJoinedBit> right_tuples_and_bits_;
-  std::unique_ptr<RightTupleMap> right_tuple_map_;
-  // The TupleList in 'right_tuple_map_' corresponding to the current left
-  // tuple. NULL indicates there are no corresponding tuples. No value indicates
-  // that left tuple in the last call to ResetForLeftInput() was NULL and
+  // The right tuples with a non-NULL RANGE (or element), sorted by start.
+  const std::vector<Entry> entries_;
+  // True if the left (right) tuples include their end, i.e., unless they are
+  // RANGEs.
+  const bool left_end_is_inclusive_;
+  const bool right_end_is_inclusive_;
+  // The segment tree over 'entries_'. Node 1 is the root, and the children of
+  // node i are 2i and 2i+1. The 'num_leaves_' leaves are the entries (padded
+  // to a power of two) and each node points to the largest end in its segment,
+  // or NULL if the segment is empty.
+  int64_t num_leaves_ = 0;
+  std::vector<const Value*> max_end_;
+
+  // The right tuples that may join with the left tuple of the last call to
+  // ResetForLeftInput(). No value indicates that that left tuple was NULL and
   // therefore GetNumMatchingTuples()/etc. should iterate over everything.
-  std::optional<RightTupleList*> matching_right_tuple_list_ = nullptr;
+  std::optional<std::vector<RightTupleAndJoinedBit*>> matching_right_tuples_;
 
   // We store a TupleIterator instead of the debug string to avoid computing the
   // debug string unnecessarily.
@@ -3144,7 +5832,9 @@ absl::Status ExtractFromRelationalOp(
       ZETASQL_RETURN_IF_ERROR(iter->Status());
       break;
     }
-    if (!tuples->PushBack(std::make_unique<TupleData>(*tuple), &status)) {
+    if (!tuples->PushBack(
+            std::make_unique<TupleData>(*tuple, context->tuple_arena()),
+            &status)) {
       return status;
     }
   }
@@ -3271,6 +5961,11 @@ class JoinTupleIterator : public TupleIterator {
   // 2) When we are done iterating over all the left tuples, we may have to loop
   //    over all the right tuples.
   // 2a) For each right tuple, we may have to left-pad NULLs.
+  //
+  // For semi and anti joins, the first joining right tuple decides the fate of
+  // the left tuple, so we skip the remaining right tuples and either output
+  // the left tuple (semi join) or drop it (anti join). Anti joins output the
+  // left tuples that would be right-padded with NULLs instead.
   TupleData* Next() override {
 
     if (!left_padding_right_tuples_ && !next_left_tuple_.has_value() &&
@@ -3312,6 +6007,20 @@ class JoinTupleIterator : public TupleIterator {
       }
       const bool joined = status_or_joined.value();
 
+      if (JoinOp::IsSemiOrAntiJoin(join_kind_) && next_right_tuple_idx_ >= 0 &&
+          joined) {
+        const absl::Status advance_status =
+            AdvanceToNextLeftTupleWithJoinCandidates();
+        if (!advance_status.ok()) {
+          status_ = advance_status;
+          return nullptr;
+        }
+        if (join_kind_ == JoinKind::kSemiJoin) {
+          return &output_tuple_;
+        }
+        continue;
+      }
+
       if (!left_padding_right_tuples_ && next_right_tuple_idx_ >= 0 && joined) {
         left_tuple_joined_ = true;
 
@@ -3339,6 +6048,8 @@ class JoinTupleIterator : public TupleIterator {
 
   absl::Status Status() const override { return status_; }
 
+  void Close() override { left_iter_->Close(); }
+
   std::string DebugString() const override {
     return JoinOp::GetIteratorDebugString(join_kind_, left_iter_->DebugString(),
                                           right_input_->DebugString());
@@ -3389,7 +6100,9 @@ class JoinTupleIterator : public TupleIterator {
       // output it. Advance to the next left tuple.
       ZETASQL_RET_CHECK(join_kind_ == JoinKind::kLeftOuterJoin ||
                 join_kind_ == JoinKind::kOuterApply ||
-                join_kind_ == JoinKind::kFullOuterJoin)
+                join_kind_ == JoinKind::kFullOuterJoin ||
+                join_kind_ == JoinKind::kAntiJoin ||
+                join_kind_ == JoinKind::kNullAwareAntiJoin)
           << JoinOp::JoinKindToString(join_kind_);
       return AdvanceToNextLeftTupleWithJoinCandidates();
     }
@@ -3487,10 +6200,13 @@ class JoinTupleIterator : public TupleIterator {
       case JoinKind::kInnerJoin:
       case JoinKind::kRightOuterJoin:
       case JoinKind::kCrossApply:
+      case JoinKind::kSemiJoin:
         return true;  // Don't pad with NULLs.
       case JoinKind::kLeftOuterJoin:
       case JoinKind::kOuterApply:
       case JoinKind::kFullOuterJoin:
+      case JoinKind::kAntiJoin:
+      case JoinKind::kNullAwareAntiJoin:
         next_right_tuple_idx_ = -1;
         return false;  // Pad with NULLs.
     }
@@ -3508,6 +6224,9 @@ class JoinTupleIterator : public TupleIterator {
       case JoinKind::kLeftOuterJoin:
       case JoinKind::kCrossApply:
       case JoinKind::kOuterApply:
+      case JoinKind::kSemiJoin:
+      case JoinKind::kAntiJoin:
+      case JoinKind::kNullAwareAntiJoin:
         done_ = true;
         return absl::OkStatus();
       case JoinKind::kRightOuterJoin:
@@ -3609,6 +6328,9 @@ class JoinTupleIterator : public TupleIterator {
       case JoinKind::kCrossApply:
       case JoinKind::kOuterApply:
       case JoinKind::kLeftOuterJoin:
+      case JoinKind::kSemiJoin:
+      case JoinKind::kAntiJoin:
+      case JoinKind::kNullAwareAntiJoin:
         ZETASQL_RET_CHECK(left_input != nullptr);
         ZETASQL_RET_CHECK_GE(output_tuple_.num_slots(),
                      left_input->schema->num_variables());
@@ -3649,6 +6371,9 @@ class JoinTupleIterator : public TupleIterator {
       case JoinKind::kFullOuterJoin:
       case JoinKind::kLeftOuterJoin:
       case JoinKind::kOuterApply:
+      case JoinKind::kSemiJoin:
+      case JoinKind::kAntiJoin:
+      case JoinKind::kNullAwareAntiJoin:
         break;
       case JoinKind::kInnerJoin:
       case JoinKind::kRightOuterJoin:
@@ -3728,34 +6453,78 @@ class JoinTupleIterator : public TupleIterator {
 
 }  // namespace
 
-absl::StatusOr<std::unique_ptr<TupleIterator>> JoinOp::CreateIterator(
+absl::StatusOr<std::unique_ptr<TupleIterator>> JoinOp::CreateIteratorImpl(
     absl::Span<const TupleData* const> params, int num_extra_slots,
     EvaluationContext* context) const {
 
   std::unique_ptr<RightInputForJoin> right_hand_side;
+  // The JoinKeyFilters to publish while the left iterator is created.
+  std::vector<std::pair<int, std::shared_ptr<const JoinKeyFilter>>>
+      join_key_filters;
   switch (join_kind_) {
     case kInnerJoin:
     case kLeftOuterJoin:
     case kRightOuterJoin:
-    case kFullOuterJoin: {
-      auto tuples =
-          std::make_unique<TupleDataDeque>(context->memory_accountant());
+    case kFullOuterJoin:
+    case kSemiJoin:
+    case kAntiJoin:
+    case kNullAwareAntiJoin: {
+      auto tuples = std::make_unique<TupleDataDeque>(
+          context->memory_accountant(), context->tuple_arena());
       std::unique_ptr<TupleIterator> iter_for_right_debug_string;
       ZETASQL_RETURN_IF_ERROR(ExtractFromRelationalOp(right_input(), params, context,
                                               tuples.get(),
                                               &iter_for_right_debug_string));
-      if (hash_join_equality_left_exprs().empty()) {
+      if (range_join_left_expr() != nullptr) {
+        ZETASQL_ASSIGN_OR_RETURN(
+            right_hand_side,
+            UncorrelatedRangeIndexedRightInput::Create(
+                params, range_join_left_expr(), range_join_right_expr(),
+                range_join_left_upper_bound_expr(),
+                range_join_right_upper_bound_expr(),
+                right_input()->CreateOutputSchema(), std::move(tuples),
+                std::move(iter_for_right_debug_string), context));
+      } else if (hash_join_equality_left_exprs().empty()) {
         right_hand_side = std::make_unique<UncorrelatedRightInput>(
             right_input()->CreateOutputSchema(), std::move(tuples),
             std::move(iter_for_right_debug_string));
       } else {
+        if (!merge_join_ordering_.empty() &&
+            !context->options().scramble_undefined_orderings) {
+          // Falls back to the hash join below if the right tuples turn out not
+          // to be sorted.
+          ZETASQL_ASSIGN_OR_RETURN(const bool is_sorted,
+                           UncorrelatedSortedRightInput::IsSorted(
+                               params, hash_join_equality_right_exprs(),
+                               merge_join_ordering_, *tuples, context));
+          if (is_sorted) {
+            ZETASQL_ASSIGN_OR_RETURN(
+                right_hand_side,
+                UncorrelatedSortedRightInput::Create(
+                    params, hash_join_equality_left_exprs(),
+                    hash_join_equality_right_exprs(), merge_join_ordering_,
+                    right_input()->CreateOutputSchema(), std::move(tuples),
+                    std::move(iter_for_right_debug_string), context));
+            break;
+          }
+        }
         ZETASQL_ASSIGN_OR_RETURN(
-            right_hand_side,
+            std::unique_ptr<UncorrelatedHashedRightInput> hashed_right_input,
             UncorrelatedHashedRightInput::Create(
                 params, hash_join_equality_left_exprs(),
                 hash_join_equality_right_exprs(),
                 right_input()->CreateOutputSchema(), std::move(tuples),
-                std::move(iter_for_right_debug_string), context));
+                std::move(iter_for_right_debug_string),
+                /*null_aware=*/join_kind_ == kNullAwareAntiJoin, context));
+        for (const JoinKeyFilterSpec& spec : join_key_filters_) {
+          join_key_filters.emplace_back(
+              spec.filter_id,
+              hashed_right_input->CreateJoinKeyFilter(
+                  spec.equality_index,
+                  hash_join_equality_right_exprs()[spec.equality_index]
+                      ->type()));
+        }
+        right_hand_side = std::move(hashed_right_input);
       }
       break;
     }
@@ -3767,17 +6536,64 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> JoinOp::CreateIterator(
     }
   }
 
+  for (auto& [filter_id, filter] : join_key_filters) {
+    context->SetJoinKeyFilter(filter_id, std::move(filter));
+  }
+  // The scans of the left input pick up the filters when their iterators are
+  // created, so the filters are only published for the call below.
+  absl::Cleanup unpublish_join_key_filters = [this, context] {
+    for (const JoinKeyFilterSpec& spec : join_key_filters_) {
+      context->SetJoinKeyFilter(spec.filter_id, nullptr);
+    }
+  };
   ZETASQL_ASSIGN_OR_RETURN(
       std::unique_ptr<TupleIterator> left_iter,
       left_input()->CreateIterator(params, /*num_extra_slots=*/0, context));
+  std::move(unpublish_join_key_filters).Invoke();
 
   std::unique_ptr<TupleIterator> iter = std::make_unique<JoinTupleIterator>(
       join_kind_, params, remaining_join_expr(), std::move(left_iter),
       left_outputs(), std::move(right_hand_side), right_outputs(),
       CreateOutputSchema(), num_extra_slots, context);
+  if (IsSemiOrAntiJoin(join_kind_)) {
+    // The output is a subsequence of the left input, which is scrambled on its
+    // own if necessary.
+    return iter;
+  }
   return MaybeReorder(std::move(iter), context);
 }
 
+absl::Status JoinOp::SetJoinKeyFilters(
+    std::vector<JoinKeyFilterSpec> join_key_filters) {
+  ZETASQL_RET_CHECK(join_kind_ == kInnerJoin || join_kind_ == kSemiJoin ||
+            join_kind_ == kRightOuterJoin)
+      << JoinKindToString(join_kind_);
+  for (const JoinKeyFilterSpec& spec : join_key_filters) {
+    ZETASQL_RET_CHECK_GE(spec.equality_index, 0);
+    ZETASQL_RET_CHECK_LT(spec.equality_index,
+                 hash_join_equality_right_exprs().size());
+  }
+  join_key_filters_ = std::move(join_key_filters);
+  return absl::OkStatus();
+}
+
+absl::Status JoinOp::SetMergeJoinOrdering(
+    std::vector<RelationalProperties::OrderingKey> ordering) {
+  ZETASQL_RET_CHECK(join_kind_ != kNullAwareAntiJoin && join_kind_ != kCrossApply &&
+            join_kind_ != kOuterApply)
+      << JoinKindToString(join_kind_);
+  ZETASQL_RET_CHECK_EQ(ordering.size(), hash_join_equality_right_exprs().size());
+  merge_join_ordering_ = std::move(ordering);
+  return absl::OkStatus();
+}
+
+RelationalProperties JoinOp::DeriveProperties() const {
+  if (IsSemiOrAntiJoin(join_kind_)) {
+    return left_input()->DeriveProperties();
+  }
+  return RelationalProperties();
+}
+
 std::unique_ptr<TupleSchema> JoinOp::CreateOutputSchema() const {
 
   const std::unique_ptr<TupleSchema> left_schema =
@@ -3800,6 +6616,9 @@ std::unique_ptr<TupleSchema> JoinOp::CreateOutputSchema() const {
     case JoinOp::kLeftOuterJoin:
     case JoinOp::kCrossApply:
     case JoinOp::kOuterApply:
+    case JoinOp::kSemiJoin:
+    case JoinOp::kAntiJoin:
+    case JoinOp::kNullAwareAntiJoin:
       output_variables.insert(output_variables.end(),
                               left_schema->variables().begin(),
                               left_schema->variables().end());
@@ -3824,6 +6643,9 @@ std::unique_ptr<TupleSchema> JoinOp::CreateOutputSchema() const {
     case JoinOp::kLeftOuterJoin:
     case JoinOp::kFullOuterJoin:
     case JoinOp::kOuterApply:
+    case JoinOp::kSemiJoin:
+    case JoinOp::kAntiJoin:
+    case JoinOp::kNullAwareAntiJoin:
       break;
   }
 
@@ -3856,17 +6678,26 @@ std::string JoinOp::DebugInternal(const std::string& indent,
                                    "right_outputs",
                                    "hash_join_equality_left_exprs",
                                    "hash_join_equality_right_exprs",
+                                   "range_join_left_expr",
+                                   "range_join_right_expr",
+                                   "range_join_left_upper_bound_expr",
+                                   "range_join_right_upper_bound_expr",
                                    "remaining_condition",
                                    "left_input",
                                    "right_input"};
   const ArgPrintMode left_output_mode =
       (join_kind_ == kRightOuterJoin || join_kind_ == kFullOuterJoin) ? kN : k0;
   const ArgPrintMode right_output_mode =
-      (join_kind_ == kInnerJoin || join_kind_ == kCrossApply) ? k0 : kN;
+      (join_kind_ == kInnerJoin || join_kind_ == kCrossApply ||
+       IsSemiOrAntiJoin(join_kind_))
+          ? k0
+          : kN;
   return absl::StrCat(
       "JoinOp(", JoinKindToString(join_kind_),
+      merge_join_ordering_.empty() ? "" : ", merge_join",
       ArgDebugString(*arg_names,
-                     {left_output_mode, right_output_mode, kN, kN, k1, k1, k1},
+                     {left_output_mode, right_output_mode, kN, kN, kOpt, kOpt,
+                      kOpt, kOpt, k1, k1, k1},
                      indent, verbose),
       ")");
 }
@@ -3875,6 +6706,10 @@ JoinOp::JoinOp(
     JoinKind kind,
     std::vector<std::unique_ptr<ExprArg>> hash_join_equality_left_exprs,
     std::vector<std::unique_ptr<ExprArg>> hash_join_equality_right_exprs,
+    std::vector<std::unique_ptr<ExprArg>> range_join_left_expr,
+    std::vector<std::unique_ptr<ExprArg>> range_join_right_expr,
+    std::vector<std::unique_ptr<ExprArg>> range_join_left_upper_bound_expr,
+    std::vector<std::unique_ptr<ExprArg>> range_join_right_upper_bound_expr,
     std::unique_ptr<ValueExpr> remaining_condition,
     std::unique_ptr<RelationalOp> left, std::unique_ptr<RelationalOp> right,
     std::vector<std::unique_ptr<ExprArg>> left_outputs,
@@ -3886,6 +6721,12 @@ JoinOp::JoinOp(
                    std::move(hash_join_equality_left_exprs));
   SetArgs<ExprArg>(kHashJoinEqualityRightExprs,
                    std::move(hash_join_equality_right_exprs));
+  SetArgs<ExprArg>(kRangeJoinLeftExpr, std::move(range_join_left_expr));
+  SetArgs<ExprArg>(kRangeJoinRightExpr, std::move(range_join_right_expr));
+  SetArgs<ExprArg>(kRangeJoinLeftUpperBoundExpr,
+                   std::move(range_join_left_upper_bound_expr));
+  SetArgs<ExprArg>(kRangeJoinRightUpperBoundExpr,
+                   std::move(range_join_right_upper_bound_expr));
   SetArg(kRemainingCondition,
          std::make_unique<ExprArg>(std::move(remaining_condition)));
   SetArg(kLeftInput, std::make_unique<RelationalArg>(std::move(left)));
@@ -3909,6 +6750,52 @@ absl::Span<ExprArg* const> JoinOp::mutable_hash_join_equality_right_exprs() {
   return GetMutableArgs<ExprArg>(kHashJoinEqualityRightExprs);
 }
 
+const ExprArg* JoinOp::range_join_left_expr() const {
+  absl::Span<const ExprArg* const> args = GetArgs<ExprArg>(kRangeJoinLeftExpr);
+  return args.empty() ? nullptr : args[0];
+}
+
+ExprArg* JoinOp::mutable_range_join_left_expr() {
+  absl::Span<ExprArg* const> args = GetMutableArgs<ExprArg>(kRangeJoinLeftExpr);
+  return args.empty() ? nullptr : args[0];
+}
+
+const ExprArg* JoinOp::range_join_right_expr() const {
+  absl::Span<const ExprArg* const> args =
+      GetArgs<ExprArg>(kRangeJoinRightExpr);
+  return args.empty() ? nullptr : args[0];
+}
+
+ExprArg* JoinOp::mutable_range_join_right_expr() {
+  absl::Span<ExprArg* const> args =
+      GetMutableArgs<ExprArg>(kRangeJoinRightExpr);
+  return args.empty() ? nullptr : args[0];
+}
+
+const ExprArg* JoinOp::range_join_left_upper_bound_expr() const {
+  absl::Span<const ExprArg* const> args =
+      GetArgs<ExprArg>(kRangeJoinLeftUpperBoundExpr);
+  return args.empty() ? nullptr : args[0];
+}
+
+ExprArg* JoinOp::mutable_range_join_left_upper_bound_expr() {
+  absl::Span<ExprArg* const> args =
+      GetMutableArgs<ExprArg>(kRangeJoinLeftUpperBoundExpr);
+  return args.empty() ? nullptr : args[0];
+}
+
+const ExprArg* JoinOp::range_join_right_upper_bound_expr() const {
+  absl::Span<const ExprArg* const> args =
+      GetArgs<ExprArg>(kRangeJoinRightUpperBoundExpr);
+  return args.empty() ? nullptr : args[0];
+}
+
+ExprArg* JoinOp::mutable_range_join_right_upper_bound_expr() {
+  absl::Span<ExprArg* const> args =
+      GetMutableArgs<ExprArg>(kRangeJoinRightUpperBoundExpr);
+  return args.empty() ? nullptr : args[0];
+}
+
 const ValueExpr* JoinOp::remaining_join_expr() const {
   return GetArg(kRemainingCondition)->node()->AsValueExpr();
 }
@@ -4028,22 +6915,36 @@ namespace {
 //   the corresponding field of the array element (which must be a struct if
 //   `field_list` is non-empty). This functionality is useful for scanning an
 //   table represented as an array (e.g., in the compliance tests).
+//
+// Every slot is set directly from the element in the array (or from a NULL
+// computed once per array, for padding), so each element Value is copied once.
 class ArrayScanTupleIterator : public TupleIterator {
  public:
   ArrayScanTupleIterator(
-      const std::vector<Value>& array_values, bool include_element,
+      std::vector<Value> array_values, bool include_element,
       bool include_position, int max_num_elements,
       absl::Span<const ArrayScanOp::FieldArg* const> field_list,
       std::unique_ptr<TupleSchema> schema, int num_extra_slots,
       EvaluationContext* context)
-      : array_values_(array_values),
+      : array_values_(std::move(array_values)),
         schema_(std::move(schema)),
         include_element_(include_element),
         include_position_(include_position),
         max_num_elements_(max_num_elements),
         field_list_(field_list.begin(), field_list.end()),
-        current_(schema_->num_variables() + num_extra_slots),
+        num_slots_(schema_->num_variables() + num_extra_slots),
+        current_(num_slots_),
         context_(context) {
+    array_lengths_.reserve(array_values_.size());
+    padding_values_.reserve(array_values_.size());
+    for (const Value& array : array_values_) {
+      const int length = array.is_null() ? 0 : array.num_elements();
+      array_lengths_.push_back(length);
+      padding_values_.push_back(
+          length < max_num_elements_
+              ? Value::Null(array.type()->AsArray()->element_type())
+              : Value());
+    }
     context_->RegisterCancelCallback([this] { return Cancel(); });
   }
 
@@ -4052,42 +6953,86 @@ class ArrayScanTupleIterator : public TupleIterator {
 
   const TupleSchema& Schema() const override { return *schema_; }
 
-  TupleData* Next() override {
+  TupleData* Next() override {
+    if (!HasNextElement()) return nullptr;
+    FillRow(&current_);
+    return &current_;
+  }
+
+  bool NextBatch(TupleDataBatch* batch) override {
+    batch->Clear();
+    while (!batch->full() && HasNextElement()) {
+      FillRow(batch->AddOwnedRow(num_slots_));
+    }
+    return !batch->empty();
+  }
+
+  absl::Status Status() const override { return status_; }
+
+  std::string DebugString() const override {
+    return ArrayScanOp::GetIteratorDebugString(absl::StrJoin(
+        array_values_, ", ", [](std::string* out, const Value& value) {
+          absl::StrAppend(out, value.DebugString());
+        }));
+  }
+
+  absl::Status Cancel() {
+    cancelled_ = true;
+    return absl::OkStatus();
+  }
+
+ private:
+  // Returns true if there is another element to return. Returns false at the
+  // end of the arrays or if the iterator was cancelled, in which case
+  // 'status_' is updated.
+  bool HasNextElement() {
     // If final array length is 0, we produce no output.
     if (max_num_elements_ == 0) {
-      return nullptr;
+      return false;
     }
 
-    bool has_multiple_columns = include_position_ || array_values_.size() > 1;
     if (next_element_idx_ == max_num_elements_) {
-      // Done iterating over the arrays. The output is non-deterministic if any
-      // of the arrays is unordered and has multiple elements, and the output
-      // tuple contains multiple columns (slots). The multiple columns can show
-      // up when there is an array offset column, or there are multiple arrays.
-      bool ignore_order = false;
-      for (const auto& array : array_values_) {
-        if (InternalValue::GetOrderKind(array) ==
-                InternalValue::kIgnoresOrder &&
-            !array.is_null() && array.num_elements() > 1) {
-          // We don't need to check if unordered array with more than 1 element
-          // contains equivalent elements. If that happens, it indicates a bug
-          // in the origin who provides the unordered array.
-          ignore_order = true;
-          break;
-        }
-      }
-      if (has_multiple_columns && ignore_order) {
-        context_->SetNonDeterministicOutput();
+      if (!finished_) {
+        finished_ = true;
+        MaybeSetNonDeterministicOutput();
       }
-      return nullptr;
+      return false;
     }
 
     if (cancelled_) {
       status_ = zetasql_base::CancelledErrorBuilder()
                 << "ArrayScanTupleIterator was cancelled";
-      return nullptr;
+      return false;
+    }
+    return true;
+  }
+
+  // Done iterating over the arrays. The output is non-deterministic if any of
+  // the arrays is unordered and has multiple elements, and the output tuple
+  // contains multiple columns (slots). The multiple columns can show up when
+  // there is an array offset column, or there are multiple arrays.
+  void MaybeSetNonDeterministicOutput() {
+    const bool has_multiple_columns =
+        include_position_ || array_values_.size() > 1;
+    bool ignore_order = false;
+    for (const auto& array : array_values_) {
+      if (InternalValue::GetOrderKind(array) == InternalValue::kIgnoresOrder &&
+          !array.is_null() && array.num_elements() > 1) {
+        // We don't need to check if unordered array with more than 1 element
+        // contains equivalent elements. If that happens, it indicates a bug
+        // in the origin who provides the unordered array.
+        ignore_order = true;
+        break;
+      }
+    }
+    if (has_multiple_columns && ignore_order) {
+      context_->SetNonDeterministicOutput();
     }
+  }
 
+  // Sets the slots of 'row' for the next element and advances to the element
+  // after it.
+  void FillRow(TupleData* row) {
     // We only prepend field list columns if they are populated.
     if (!field_list_.empty()) {
       ABSL_DCHECK(!array_values_[0].is_null());
@@ -4095,53 +7040,42 @@ class ArrayScanTupleIterator : public TupleIterator {
       const Value& element_of_first_array =
           array_values_[0].element(next_element_idx_);
       for (int i = 0; i < field_list_.size(); ++i) {
-        current_.mutable_slot(i)->SetValue(
+        row->mutable_slot(i)->SetValue(
             element_of_first_array.field(field_list_[i]->field_index()));
       }
     }
     int next_slot_idx = static_cast<int>(field_list_.size());
     if (include_element_) {
       for (int i = 0; i < array_values_.size(); ++i) {
-        Value value =
-            (array_values_[i].is_null() ||
-             next_element_idx_ >= array_values_[i].num_elements())
-                ? Null(array_values_[i].type()->AsArray()->element_type())
-                : array_values_[i].element(next_element_idx_);
-        current_.mutable_slot(next_slot_idx)->SetValue(value);
+        row->mutable_slot(next_slot_idx)
+            ->SetValue(next_element_idx_ < array_lengths_[i]
+                           ? array_values_[i].element(next_element_idx_)
+                           : padding_values_[i]);
         next_slot_idx++;
       }
     }
     if (include_position_) {
-      current_.mutable_slot(next_slot_idx)->SetValue(Int64(next_element_idx_));
+      row->mutable_slot(next_slot_idx)->SetValue(Int64(next_element_idx_));
     }
     ++next_element_idx_;
-
-    return &current_;
-  }
-
-  absl::Status Status() const override { return status_; }
-
-  std::string DebugString() const override {
-    return ArrayScanOp::GetIteratorDebugString(absl::StrJoin(
-        array_values_, ", ", [](std::string* out, const Value& value) {
-          absl::StrAppend(out, value.DebugString());
-        }));
-  }
-
-  absl::Status Cancel() {
-    cancelled_ = true;
-    return absl::OkStatus();
   }
 
- private:
   const std::vector<Value> array_values_;
   const std::unique_ptr<TupleSchema> schema_;
   const bool include_element_;
   const bool include_position_;
   const int max_num_elements_;
   const std::vector<const ArrayScanOp::FieldArg*> field_list_;
+  const int num_slots_;
+  // The number of elements of each of 'array_values_' (0 for NULL).
+  std::vector<int> array_lengths_;
+  // For each of 'array_values_' that is shorter than 'max_num_elements_', the
+  // NULL element with which it is padded.
+  std::vector<Value> padding_values_;
   TupleData current_;
   int next_element_idx_ = 0;
+  // True once the end of the arrays has been reached.
+  bool finished_ = false;
   bool cancelled_ = false;
   absl::Status status_;
   EvaluationContext* context_;
@@ -4154,7 +7088,7 @@ int OutputArrayLength(functions::ArrayZipEnums::ArrayZipMode mode,
 
 }  // namespace
 
-absl::StatusOr<std::unique_ptr<TupleIterator>> ArrayScanOp::CreateIterator(
+absl::StatusOr<std::unique_ptr<TupleIterator>> ArrayScanOp::CreateIteratorImpl(
     absl::Span<const TupleData* const> params, int num_extra_slots,
     EvaluationContext* context) const {
   absl::Span<const ExprArg* const> array_exprs = array_expr_list();
@@ -4200,7 +7134,7 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> ArrayScanOp::CreateIterator(
 
   std::unique_ptr<TupleIterator> iter = std::make_unique<
       ArrayScanTupleIterator>(
-      array_values, /*include_element=*/!elements().empty(),
+      std::move(array_values), /*include_element=*/!elements().empty(),
       /*include_position=*/position().is_valid(),
       /*max_num_elements=*/OutputArrayLength(mode, *min_length, *max_length),
       field_list(), CreateOutputSchema(), num_extra_slots, context);
@@ -4358,6 +7292,328 @@ const ValueExpr* ArrayScanOp::zip_mode_expr() const {
   return GetArg(kMode) != nullptr ? GetArg(kMode)->value_expr() : nullptr;
 }
 
+// -------------------------------------------------------
+// GenerateArrayScanOp
+// -------------------------------------------------------
+
+std::string GenerateArrayScanOp::GetIteratorDebugString(
+    absl::string_view arguments_debug_string) {
+  return absl::StrCat("GenerateArrayScanTupleIterator(", arguments_debug_string,
+                      ")");
+}
+
+bool GenerateArrayScanOp::SupportsElementType(const Type* element_type) {
+  switch (element_type->kind()) {
+    case TYPE_INT64:
+    case TYPE_UINT64:
+    case TYPE_NUMERIC:
+    case TYPE_BIGNUMERIC:
+    case TYPE_DOUBLE:
+    case TYPE_DATE:
+    case TYPE_TIMESTAMP:
+      return true;
+    default:
+      return false;
+  }
+}
+
+absl::StatusOr<std::unique_ptr<GenerateArrayScanOp>>
+GenerateArrayScanOp::Create(const VariableId& element,
+                            const VariableId& position,
+                            const Type* element_type,
+                            std::vector<std::unique_ptr<ValueExpr>> arguments) {
+  ZETASQL_RET_CHECK(SupportsElementType(element_type))
+      << element_type->DebugString();
+  ZETASQL_RET_CHECK_GE(arguments.size(), 2);
+  ZETASQL_RET_CHECK_LE(arguments.size(), 4);
+  std::vector<std::unique_ptr<ExprArg>> argument_args;
+  argument_args.reserve(arguments.size());
+  for (std::unique_ptr<ValueExpr>& argument : arguments) {
+    ZETASQL_RET_CHECK(argument != nullptr);
+    argument_args.push_back(std::make_unique<ExprArg>(std::move(argument)));
+  }
+  return absl::WrapUnique(new GenerateArrayScanOp(
+      element, position, element_type, std::move(argument_args)));
+}
+
+absl::Status GenerateArrayScanOp::SetSchemasForEvaluation(
+    absl::Span<const TupleSchema* const> params_schemas) {
+  for (ExprArg* argument : mutable_argument_list()) {
+    ZETASQL_RETURN_IF_ERROR(argument->mutable_value_expr()->SetSchemasForEvaluation(
+        params_schemas));
+  }
+  return absl::OkStatus();
+}
+
+namespace {
+
+// Returns one tuple for every generated element, with variables for the
+// element if 'include_element' is true and for its zero-based position if
+// 'include_position' is true, like ArrayScanTupleIterator.
+class GenerateArrayScanTupleIterator : public TupleIterator {
+ public:
+  // Sets its argument to the next element and returns true, or returns false
+  // once all the elements have been generated.
+  using NextElementFn = std::function<bool(Value*)>;
+
+  GenerateArrayScanTupleIterator(NextElementFn next_element,
+                                 std::string arguments_debug_string,
+                                 bool include_element, bool include_position,
+                                 std::unique_ptr<TupleSchema> schema,
+                                 int num_extra_slots,
+                                 EvaluationContext* context)
+      : next_element_(std::move(next_element)),
+        arguments_debug_string_(std::move(arguments_debug_string)),
+        schema_(std::move(schema)),
+        include_element_(include_element),
+        include_position_(include_position),
+        current_(schema_->num_variables() + num_extra_slots),
+        context_(context) {
+    context_->RegisterCancelCallback([this] { return Cancel(); });
+  }
+
+  GenerateArrayScanTupleIterator(const GenerateArrayScanTupleIterator&) =
+      delete;
+  GenerateArrayScanTupleIterator& operator=(
+      const GenerateArrayScanTupleIterator&) = delete;
+
+  const TupleSchema& Schema() const override { return *schema_; }
+
+  TupleData* Next() override {
+    if (cancelled_) {
+      status_ = zetasql_base::CancelledErrorBuilder()
+                << "GenerateArrayScanTupleIterator was cancelled";
+      return nullptr;
+    }
+    if (!next_element_(&element_)) {
+      return nullptr;
+    }
+    int next_slot_idx = 0;
+    if (include_element_) {
+      current_.mutable_slot(next_slot_idx)->SetValue(element_);
+      next_slot_idx++;
+    }
+    if (include_position_) {
+      current_.mutable_slot(next_slot_idx)->SetValue(Int64(next_position_));
+    }
+    ++next_position_;
+    return &current_;
+  }
+
+  absl::Status Status() const override { return status_; }
+
+  std::string DebugString() const override {
+    return GenerateArrayScanOp::GetIteratorDebugString(
+        arguments_debug_string_);
+  }
+
+  absl::Status Cancel() {
+    cancelled_ = true;
+    return absl::OkStatus();
+  }
+
+ private:
+  NextElementFn next_element_;
+  const std::string arguments_debug_string_;
+  const std::unique_ptr<TupleSchema> schema_;
+  const bool include_element_;
+  const bool include_position_;
+  TupleData current_;
+  Value element_;
+  int64_t next_position_ = 0;
+  bool cancelled_ = false;
+  absl::Status status_;
+  EvaluationContext* context_;
+};
+
+// Returns a NextElementFn for the elements from 'start' to 'end' with
+// 'step', which 'make_value' converts to Values.
+template <typename T, typename TStep, typename MakeValueFn>
+absl::StatusOr<GenerateArrayScanTupleIterator::NextElementFn>
+MakeGeneratedElementsFn(T start, T end, TStep step, MakeValueFn make_value) {
+  ZETASQL_ASSIGN_OR_RETURN(auto generator,
+                   (functions::MakeArrayGenerator<T, TStep>(start, end, step)));
+  return [generator = std::move(generator),
+          make_value](Value* element) mutable {
+    T value;
+    if (!generator.Next(&value)) {
+      return false;
+    }
+    *element = make_value(value);
+    return true;
+  };
+}
+
+// Returns a NextElementFn for the arguments 'args' of a GENERATE_ARRAY,
+// GENERATE_DATE_ARRAY or GENERATE_TIMESTAMP_ARRAY call without NULLs. These
+// are interpreted like in GenerateArrayFunction.
+absl::StatusOr<GenerateArrayScanTupleIterator::NextElementFn>
+MakeGeneratedElementsFn(absl::Span<const Value> args) {
+  const bool has_step = args.size() >= 3;
+  switch (args[0].type_kind()) {
+    case TYPE_INT64:
+      return MakeGeneratedElementsFn(
+          args[0].int64_value(), args[1].int64_value(),
+          has_step ? args[2].int64_value() : int64_t{1}, Value::Int64);
+    case TYPE_UINT64:
+      return MakeGeneratedElementsFn(
+          args[0].uint64_value(), args[1].uint64_value(),
+          has_step ? args[2].uint64_value() : uint64_t{1}, Value::Uint64);
+    case TYPE_NUMERIC:
+      return MakeGeneratedElementsFn(
+          args[0].numeric_value(), args[1].numeric_value(),
+          has_step ? args[2].numeric_value() : NumericValue(1LL),
+          Value::Numeric);
+    case TYPE_BIGNUMERIC:
+      return MakeGeneratedElementsFn(
+          args[0].bignumeric_value(), args[1].bignumeric_value(),
+          has_step ? args[2].bignumeric_value() : BigNumericValue(1),
+          Value::BigNumeric);
+    case TYPE_DOUBLE:
+      return MakeGeneratedElementsFn(args[0].double_value(),
+                                     args[1].double_value(),
+                                     has_step ? args[2].double_value() : 1.0,
+                                     Value::Double);
+    case TYPE_DATE: {
+      functions::DateIncrement increment;
+      increment.unit = functions::DAY;
+      increment.value = 1;
+      if (has_step) {
+        ZETASQL_RET_CHECK_EQ(args.size(), 4);
+        increment.unit =
+            static_cast<functions::DateTimestampPart>(args[3].enum_value());
+        increment.value = args[2].int64_value();
+      }
+      return MakeGeneratedElementsFn(
+          int64_t{args[0].date_value()}, int64_t{args[1].date_value()},
+          increment,
+          [](int64_t date) { return Value::Date(static_cast<int32_t>(date)); });
+    }
+    case TYPE_TIMESTAMP: {
+      // The resolver requires a step for GENERATE_TIMESTAMP_ARRAY.
+      ZETASQL_RET_CHECK_EQ(args.size(), 4);
+      functions::TimestampIncrement increment;
+      increment.unit =
+          static_cast<functions::DateTimestampPart>(args[3].enum_value());
+      increment.value = args[2].int64_value();
+      return MakeGeneratedElementsFn(args[0].ToTime(), args[1].ToTime(),
+                                     increment, Value::Timestamp);
+    }
+    default:
+      return ::zetasql_base::UnimplementedErrorBuilder()
+             << "Unsupported argument type for generate_array.";
+  }
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<TupleIterator>>
+GenerateArrayScanOp::CreateIteratorImpl(
+    absl::Span<const TupleData* const> params, int num_extra_slots,
+    EvaluationContext* context) const {
+  std::vector<Value> args;
+  args.reserve(argument_list().size());
+  for (const ExprArg* argument : argument_list()) {
+    TupleSlot slot;
+    absl::Status status;
+    if (!argument->value_expr()->EvalSimple(params, context, &slot,
+                                            &status)) {
+      return status;
+    }
+    args.push_back(slot.value());
+  }
+
+  GenerateArrayScanTupleIterator::NextElementFn next_element;
+  if (absl::c_any_of(args, [](const Value& arg) { return arg.is_null(); })) {
+    // The generated array is NULL, which UNNEST treats as an empty array.
+    next_element = [](Value*) { return false; };
+  } else {
+    ZETASQL_RET_CHECK(args[0].type()->Equals(element_type_));
+    ZETASQL_ASSIGN_OR_RETURN(next_element, MakeGeneratedElementsFn(args));
+  }
+  std::unique_ptr<TupleIterator> iter =
+      std::make_unique<GenerateArrayScanTupleIterator>(
+          std::move(next_element),
+          absl::StrJoin(args, ", ",
+                        [](std::string* out, const Value& value) {
+                          absl::StrAppend(out, value.DebugString());
+                        }),
+          /*include_element=*/element().is_valid(),
+          /*include_position=*/position().is_valid(), CreateOutputSchema(),
+          num_extra_slots, context);
+  return MaybeReorder(std::move(iter), context);
+}
+
+std::unique_ptr<TupleSchema> GenerateArrayScanOp::CreateOutputSchema() const {
+  std::vector<VariableId> vars;
+  if (element().is_valid()) {
+    vars.push_back(element());
+  }
+  if (position().is_valid()) {
+    vars.push_back(position());
+  }
+  return std::make_unique<TupleSchema>(vars);
+}
+
+std::string GenerateArrayScanOp::IteratorDebugString() const {
+  return GetIteratorDebugString("<arguments>");
+}
+
+std::string GenerateArrayScanOp::DebugInternal(const std::string& indent,
+                                               bool verbose) const {
+  std::string indent_child = indent + kIndentSpace;
+  std::string indent_input = indent + kIndentFork;
+  std::string out = "GenerateArrayScanOp(";
+  if (element().is_valid()) {
+    absl::StrAppend(&out, indent_input, GetArg(kElement)->DebugString(),
+                    " := element,");
+  }
+  if (position().is_valid()) {
+    absl::StrAppend(&out, indent_input, GetArg(kPosition)->DebugString(),
+                    " := position,");
+  }
+  for (const ExprArg* argument : argument_list()) {
+    absl::StrAppend(
+        &out, indent_input, "argument: ",
+        argument->value_expr()->DebugInternal(indent_child, verbose));
+  }
+  absl::StrAppend(&out, ")");
+  return out;
+}
+
+GenerateArrayScanOp::GenerateArrayScanOp(
+    const VariableId& element, const VariableId& position,
+    const Type* element_type, std::vector<std::unique_ptr<ExprArg>> arguments)
+    : element_type_(element_type) {
+  SetArg(kElement, !element.is_valid()
+                       ? nullptr
+                       : std::make_unique<ExprArg>(element, element_type));
+  SetArg(kPosition, !position.is_valid() ? nullptr
+                                         : std::make_unique<ExprArg>(
+                                               position, types::Int64Type()));
+  SetArgs(kArgument, std::move(arguments));
+}
+
+const VariableId& GenerateArrayScanOp::element() const {
+  static const VariableId* empty_str = new VariableId();
+  return GetArg(kElement) != nullptr ? GetArg(kElement)->variable()
+                                     : *empty_str;
+}
+
+const VariableId& GenerateArrayScanOp::position() const {
+  static const VariableId* empty_str = new VariableId();
+  return GetArg(kPosition) != nullptr ? GetArg(kPosition)->variable()
+                                      : *empty_str;
+}
+
+absl::Span<const ExprArg* const> GenerateArrayScanOp::argument_list() const {
+  return GetArgs<ExprArg>(kArgument);
+}
+
+absl::Span<ExprArg* const> GenerateArrayScanOp::mutable_argument_list() {
+  return GetMutableArgs<ExprArg>(kArgument);
+}
+
 // -------------------------------------------------------
 // DistinctOp
 // -------------------------------------------------------
@@ -4420,7 +7676,7 @@ class DistinctRowSetValueArg : public CppValueArg {
   std::unique_ptr<CppValueBase> CreateValue(
       EvaluationContext* context) const override {
     return std::make_unique<CppValue<DistinctRowSet>>(
-        context->memory_accountant());
+        context->memory_accountant(), context->tuple_arena());
   }
 };
 
@@ -4447,6 +7703,7 @@ class DistinctOpTupleIterator : public TupleIterator {
         row_set_(row_set),
         output_schema_(std::move(output_schema)),
         keys_(std::move(keys)),
+        key_row_(static_cast<int>(keys_.size())),
         keys_data_(static_cast<int>(keys_.size()) + num_extra_slots),
         context_(context) {}
 
@@ -4465,15 +7722,10 @@ class DistinctOpTupleIterator : public TupleIterator {
         return nullptr;
       }
 
-      // Generate a copy of the row data for the row set, ignoring any
-      // "extra slots".
-      auto keys_data_copy = std::make_unique<TupleData>(keys_.size());
-      for (int i = 0; i < keys_.size(); ++i) {
-        keys_data_copy->mutable_slot(i)->CopyFromSlot(keys_data_.slot(i));
-      }
-
-      if (row_set_->InsertRowIfNotPresent(std::move(keys_data_copy),
-                                          &status_)) {
+      if (row_set_->InsertRowIfNotPresent(key_row_, &status_)) {
+        for (int i = 0; i < keys_.size(); ++i) {
+          keys_data_.mutable_slot(i)->CopyFromSlot(key_row_.slot(i));
+        }
         return &keys_data_;
       }
       if (!status_.ok()) {
@@ -4484,20 +7736,22 @@ class DistinctOpTupleIterator : public TupleIterator {
 
   absl::Status Status() const override { return status_; }
 
+  void Close() override { input_iterator_->Close(); }
+
   std::string DebugString() const override {
     return absl::StrCat("DistinctOp: ", input_iterator_->DebugString());
   }
 
  private:
   // Given a TupleData produced by <input_iterator_>, evaluates each of the
-  // key expressions, storing the resuts in <keys_data_>. If unique
-  // <keys_data_> will then be returned by Next(); if seen before, the current
-  // row will be discarded.
+  // key expressions, storing the resuts in <key_row_>. If unique, they are
+  // copied to <keys_data_>, which will then be returned by Next(); if seen
+  // before, the current row will be discarded.
   bool EvaluateKeys(TupleData* input_data) {
     for (int i = 0; i < keys_.size(); ++i) {
       const KeyArg* key = keys_.at(i);
       if (!key->value_expr()->EvalSimple(
-              {input_data}, context_, keys_data_.mutable_slot(i), &status_)) {
+              {input_data}, context_, key_row_.mutable_slot(i), &status_)) {
         return false;
       }
     }
@@ -4508,6 +7762,8 @@ class DistinctOpTupleIterator : public TupleIterator {
   DistinctRowSet* row_set_;
   const std::unique_ptr<const TupleSchema> output_schema_;
   absl::Span<const KeyArg* const> keys_;
+  // The keys of the current row, without the "extra slots".
+  TupleData key_row_;
   TupleData keys_data_;
   EvaluationContext* const context_;
   absl::Status status_;
@@ -4519,7 +7775,7 @@ std::unique_ptr<CppValueArg> DistinctOp::MakeCppValueArgForRowSet(
   return std::make_unique<DistinctRowSetValueArg>(var);
 }
 
-absl::StatusOr<std::unique_ptr<TupleIterator>> DistinctOp::CreateIterator(
+absl::StatusOr<std::unique_ptr<TupleIterator>> DistinctOp::CreateIteratorImpl(
     absl::Span<const TupleData* const> params, int num_extra_slots,
     EvaluationContext* context) const {
   ZETASQL_ASSIGN_OR_RETURN(
@@ -4658,8 +7914,61 @@ class UnionAllTupleIterator : public TupleIterator {
     return &data_;
   }
 
+  bool NextBatch(TupleDataBatch* batch) override {
+    batch->Clear();
+    if (input_batch_ == nullptr) {
+      input_batch_ = std::make_unique<TupleDataBatch>(batch->capacity());
+      params_and_input_ = ConcatSpans(
+          absl::Span<const TupleData* const>(params_),
+          absl::Span<const TupleData* const>({nullptr}));
+    }
+    while (iter_idx_ < iters_.size()) {
+      TupleIterator* iter = iters_[iter_idx_].get();
+      if (!iter->NextBatch(input_batch_.get())) {
+        absl::Status iter_status = iter->Status();
+        if (!iter_status.ok()) {
+          status_ = iter_status;
+          return false;
+        }
+        ++iter_idx_;
+        continue;
+      }
+
+      absl::Span<const ExprArg* const> values = values_[iter_idx_];
+      if (values.size() != output_schema_->num_variables()) {
+        status_ = zetasql_base::InternalErrorBuilder()
+                  << "UnionAllTupleIterator::NextBatch() expected "
+                  << output_schema_->num_variables() << " values, but found "
+                  << values.size();
+        return false;
+      }
+
+      for (const TupleData* input : input_batch_->rows()) {
+        params_and_input_.back() = input;
+        TupleData* output = batch->AddOwnedRow(data_.num_slots());
+        for (int i = 0; i < values.size(); ++i) {
+          absl::Status status;
+          if (!values[i]->value_expr()->EvalSimple(params_and_input_, context_,
+                                                   output->mutable_slot(i),
+                                                   &status)) {
+            status_ = status;
+            return false;
+          }
+        }
+      }
+      return true;
+    }
+    return false;
+  }
+
   absl::Status Status() const override { return status_; }
 
+  void Close() override {
+    for (const std::unique_ptr<TupleIterator>& iter : iters_) {
+      iter->Close();
+    }
+  }
+
   std::string DebugString() const override {
     std::vector<std::string> iter_strings;
     iter_strings.reserve(iters_.size());
@@ -4697,12 +8006,205 @@ class UnionAllTupleIterator : public TupleIterator {
   std::vector<std::unique_ptr<TupleIterator>> iters_;
   int iter_idx_ = 0;  // Index of the current iterator in 'iters_'.
   TupleData data_;
+  // Used by NextBatch() to read from 'iters_'. Allocated on first use.
+  std::unique_ptr<TupleDataBatch> input_batch_;
+  // 'params_' followed by the current input tuple. Only used by NextBatch().
+  std::vector<const TupleData*> params_and_input_;
   absl::Status status_;
   EvaluationContext* context_;
 };
+
+// Like UnionAllTupleIterator, but for a UnionAllOp whose inputs are all
+// EvaluatorTableScanOps: reads the tables with multiple threads, in waves that
+// each read the next block of rows of several of the tables, one table per
+// task. The rows of a wave are returned before the next wave is read, so the
+// output interleaves the tables, which UNION ALL allows. The interleaving only
+// depends on the number of threads. As for
+// ParallelEvaluatorTableTupleIterator, only reading the tables happens on the
+// helper threads; 'values' are evaluated on the calling thread.
+class ParallelUnionAllScanTupleIterator : public TupleIterator {
+ public:
+  // The maximum number of rows read from one table in a wave.
+  static constexpr int64_t kRowsPerBlock = 1024;
+  // The number of tables per thread in a wave. More than one so that threads
+  // that get cheap tables can take more.
+  static constexpr int kBlocksPerThreadPerWave = 4;
+
+  struct Input {
+    const EvaluatorTableScanOp* scan_op;
+    std::unique_ptr<EvaluatorTableIterator> iter;
+    // The number of columns of 'scan_op' and 'iter'.
+    int num_columns;
+    absl::Span<const ExprArg* const> values;
+    bool done = false;
+  };
+
+  ParallelUnionAllScanTupleIterator(absl::Span<const TupleData* const> params,
+                                    std::vector<Input> inputs,
+                                    std::unique_ptr<TupleSchema> output_schema,
+                                    int num_extra_slots,
+                                    EvaluationContext* context, int num_threads)
+      : params_and_input_(ConcatSpans(
+            params, absl::Span<const TupleData* const>({nullptr}))),
+        inputs_(std::move(inputs)),
+        output_schema_(std::move(output_schema)),
+        data_(output_schema_->num_variables() + num_extra_slots),
+        context_(context),
+        num_threads_(num_threads) {
+    for (Input& input : inputs_) {
+      input.iter->SetDeadline(context_->GetStatementEvaluationDeadline());
+    }
+    context_->RegisterCancelCallback([this] {
+      absl::MutexLock lock(&mutex_);
+      cancelled_ = true;
+      for (EvaluatorTableIterator* iter : wave_iters_) {
+        iter->Cancel().IgnoreError();
+      }
+      return absl::OkStatus();
+    });
+  }
+
+  ParallelUnionAllScanTupleIterator(const ParallelUnionAllScanTupleIterator&) =
+      delete;
+  ParallelUnionAllScanTupleIterator& operator=(
+      const ParallelUnionAllScanTupleIterator&) = delete;
+
+  const TupleSchema& Schema() const override { return *output_schema_; }
+
+  TupleData* Next() override {
+    while (next_row_in_wave_ == wave_rows_.size()) {
+      if (next_input_ == inputs_.size()) return nullptr;
+      status_ = ReadNextWave();
+      if (!status_.ok()) return nullptr;
+    }
+    const int row = next_row_in_wave_++;
+    params_and_input_.back() = &wave_rows_[row];
+    absl::Span<const ExprArg* const> values =
+        inputs_[wave_row_inputs_[row]].values;
+    for (int i = 0; i < values.size(); ++i) {
+      absl::Status status;
+      if (!values[i]->value_expr()->EvalSimple(
+              params_and_input_, context_, data_.mutable_slot(i), &status)) {
+        status_ = status;
+        return nullptr;
+      }
+    }
+    return &data_;
+  }
+
+  absl::Status Status() const override { return status_; }
+
+  void Close() override {
+    {
+      absl::MutexLock lock(&mutex_);
+      cancelled_ = true;
+    }
+    wave_rows_.clear();
+    wave_row_inputs_.clear();
+    next_row_in_wave_ = 0;
+  }
+
+  std::string DebugString() const override {
+    std::vector<std::string> iter_strings;
+    iter_strings.reserve(inputs_.size());
+    for (const Input& input : inputs_) {
+      iter_strings.push_back(input.scan_op->IteratorDebugString());
+    }
+    return UnionAllOp::GetIteratorDebugString(iter_strings);
+  }
+
+ private:
+  // Reads the next block of up to num_threads_ * kBlocksPerThreadPerWave
+  // unfinished inputs into 'wave_rows_'.
+  absl::Status ReadNextWave() {
+    std::vector<int> wave_inputs;
+    const int max_blocks = num_threads_ * kBlocksPerThreadPerWave;
+    for (int i = next_input_;
+         i < inputs_.size() && wave_inputs.size() < max_blocks; ++i) {
+      if (!inputs_[i].done) wave_inputs.push_back(i);
+    }
+
+    {
+      absl::MutexLock lock(&mutex_);
+      if (cancelled_) {
+        return zetasql_base::CancelledErrorBuilder()
+               << "ParallelUnionAllScanTupleIterator was cancelled";
+      }
+      for (int i : wave_inputs) {
+        wave_iters_.push_back(inputs_[i].iter.get());
+      }
+    }
+
+    std::vector<std::vector<TupleData>> block_rows(wave_inputs.size());
+    std::vector<char> block_finished(wave_inputs.size(), false);
+    const absl::Status status =
+        ParallelFor(
+            num_threads_, wave_inputs.size(),
+            [&](int block) {
+              const Input& input = inputs_[wave_inputs[block]];
+              std::vector<TupleData>& rows = block_rows[block];
+              while (rows.size() < kRowsPerBlock) {
+                if (!input.iter->NextRow()) {
+                  block_finished[block] = true;
+                  return input.iter->Status();
+                }
+                TupleData& row = rows.emplace_back(input.num_columns);
+                for (int i = 0; i < input.num_columns; ++i) {
+                  row.mutable_slot(i)->SetValue(input.iter->GetValue(i));
+                }
+              }
+              return absl::OkStatus();
+            },
+            context_->options().executor);
+
+    {
+      absl::MutexLock lock(&mutex_);
+      wave_iters_.clear();
+    }
+    ZETASQL_RETURN_IF_ERROR(status);
+
+    wave_rows_.clear();
+    wave_row_inputs_.clear();
+    next_row_in_wave_ = 0;
+    for (int block = 0; block < wave_inputs.size(); ++block) {
+      const int input = wave_inputs[block];
+      inputs_[input].done = block_finished[block];
+      for (TupleData& row : block_rows[block]) {
+        wave_rows_.push_back(std::move(row));
+        wave_row_inputs_.push_back(input);
+      }
+    }
+    while (next_input_ < inputs_.size() && inputs_[next_input_].done) {
+      ++next_input_;
+    }
+    return absl::OkStatus();
+  }
+
+  // 'params' followed by the current input tuple.
+  std::vector<const TupleData*> params_and_input_;
+  std::vector<Input> inputs_;
+  const std::unique_ptr<TupleSchema> output_schema_;
+  TupleData data_;
+  EvaluationContext* context_;
+  const int num_threads_;
+  // The index of the first input that is not done.
+  int next_input_ = 0;
+  // The rows of the current wave, and the index of the input of each.
+  std::vector<TupleData> wave_rows_;
+  std::vector<int> wave_row_inputs_;
+  int64_t next_row_in_wave_ = 0;
+  absl::Status status_;
+
+  // Protects the state shared with the cancel callback, which may run on any
+  // thread.
+  absl::Mutex mutex_;
+  bool cancelled_ ABSL_GUARDED_BY(mutex_) = false;
+  // The iterators of the wave being read, if any.
+  std::vector<EvaluatorTableIterator*> wave_iters_ ABSL_GUARDED_BY(mutex_);
+};
 }  // namespace
 
-absl::StatusOr<std::unique_ptr<TupleIterator>> UnionAllOp::CreateIterator(
+absl::StatusOr<std::unique_ptr<TupleIterator>> UnionAllOp::CreateIteratorImpl(
     absl::Span<const TupleData* const> params, int num_extra_slots,
     EvaluationContext* context) const {
   std::vector<absl::Span<const ExprArg* const>> tuple_values;
@@ -4711,6 +8213,41 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> UnionAllOp::CreateIterator(
     tuple_values.push_back(values(i));
   }
 
+  // Read the tables concurrently if every input is a table scan.
+  std::vector<const EvaluatorTableScanOp*> scan_ops;
+  const int num_threads = context->options().num_threads;
+  if (num_threads > 1 && num_rel() > 1) {
+    for (int i = 0; i < num_rel(); ++i) {
+      const auto* scan_op = dynamic_cast<const EvaluatorTableScanOp*>(rel(i));
+      if (scan_op == nullptr) break;
+      scan_ops.push_back(scan_op);
+    }
+  }
+  if (scan_ops.size() == num_rel()) {
+    std::vector<ParallelUnionAllScanTupleIterator::Input> inputs;
+    inputs.reserve(num_rel());
+    for (int i = 0; i < num_rel(); ++i) {
+      const EvaluatorTableScanOp* scan_op = scan_ops[i];
+      ZETASQL_ASSIGN_OR_RETURN(
+          EvaluatorTableScanOp::TableIteratorFactory create_table_iter,
+          scan_op->CreateTableIteratorFactory(params, context));
+      ParallelUnionAllScanTupleIterator::Input& input = inputs.emplace_back();
+      input.scan_op = scan_op;
+      ZETASQL_ASSIGN_OR_RETURN(input.iter, create_table_iter());
+      input.num_columns = scan_op->CreateOutputSchema()->num_variables();
+      ZETASQL_RET_CHECK_EQ(input.iter->NumColumns(), input.num_columns)
+          << "UnionAllOp found wrong number of columns in "
+          << scan_op->IteratorDebugString();
+      input.values = values(i);
+      ZETASQL_RET_CHECK_EQ(input.values.size(), num_variables());
+    }
+    std::unique_ptr<TupleIterator> iter =
+        std::make_unique<ParallelUnionAllScanTupleIterator>(
+            params, std::move(inputs), CreateOutputSchema(), num_extra_slots,
+            context, num_threads);
+    return MaybeReorder(std::move(iter), context);
+  }
+
   std::vector<std::unique_ptr<TupleIterator>> iters;
   iters.reserve(num_rel());
   for (int i = 0; i < num_rel(); ++i) {
@@ -4972,6 +8509,10 @@ class LoopTupleIterator : public TupleIterator {
     return data;
   }
 
+  void Close() override {
+    if (iter_ != nullptr) iter_->Close();
+  }
+
   std::string DebugString() const override {
     return absl::StrCat("LoopTupleIterator: inner iterator: ",
                         (iter_ != nullptr ? iter_->DebugString() : "nullptr"));
@@ -4982,6 +8523,7 @@ class LoopTupleIterator : public TupleIterator {
                     int num_extra_slots, EvaluationContext* context)
       : op_(op),
         loop_variables_(std::make_unique<TupleData>(op->num_variables())),
+        loop_variable_reservations_(op->num_variables()),
         params_and_loop_variables_(
             ConcatSpans(absl::Span<const TupleData* const>(params),
                         {loop_variables_.get()})),
@@ -5006,6 +8548,7 @@ class LoopTupleIterator : public TupleIterator {
                 loop_variables_->mutable_slot(i), &status)) {
           return status;
         }
+        ZETASQL_RETURN_IF_ERROR(ReserveLoopVariable(i));
       }
       ZETASQL_ASSIGN_OR_RETURN(data, BeginNextIteration());
 
@@ -5039,7 +8582,25 @@ class LoopTupleIterator : public TupleIterator {
               loop_variables_->mutable_slot(var_index), &status)) {
         return status;
       }
+      ZETASQL_RETURN_IF_ERROR(ReserveLoopVariable(var_index));
+    }
+    return absl::OkStatus();
+  }
+
+  // Charges the value of loop variable 'i' to the MemoryAccountant in place of
+  // its previous value. For a recursive query, the loop variables hold the rows
+  // produced by the previous iteration, which are the working set of the next
+  // one.
+  absl::Status ReserveLoopVariable(int i) {
+    loop_variable_reservations_[i].reset();
+    auto reservation =
+        std::make_unique<MemoryReservation>(context_->memory_accountant());
+    absl::Status status;
+    if (!reservation->Increase(
+            loop_variables_->slot(i).value().physical_byte_size(), &status)) {
+      return status;
     }
+    loop_variable_reservations_[i] = std::move(reservation);
     return absl::OkStatus();
   }
 
@@ -5070,6 +8631,9 @@ class LoopTupleIterator : public TupleIterator {
   // Additional TupleData to store loop variables.
   const std::unique_ptr<TupleData> loop_variables_;
 
+  // The memory charged for each entry of 'loop_variables_'.
+  std::vector<std::unique_ptr<MemoryReservation>> loop_variable_reservations_;
+
   // All TupleData parameters to be passed into child expressions/iterators.
   // Contains a copy of params passed to constructor with <variables_> appended.
   const std::vector<const TupleData*> params_and_loop_variables_;
@@ -5097,7 +8661,7 @@ class LoopTupleIterator : public TupleIterator {
 
 }  // namespace
 
-absl::StatusOr<std::unique_ptr<TupleIterator>> LoopOp::CreateIterator(
+absl::StatusOr<std::unique_ptr<TupleIterator>> LoopOp::CreateIteratorImpl(
     absl::Span<const TupleData* const> params, int num_extra_slots,
     EvaluationContext* context) const {
   return LoopTupleIterator::Create(this, params, num_extra_slots, context);
@@ -5117,7 +8681,7 @@ absl::Status RootOp::SetSchemasForEvaluation(
   return mutable_input()->SetSchemasForEvaluation(params_schemas);
 }
 
-absl::StatusOr<std::unique_ptr<TupleIterator>> RootOp::CreateIterator(
+absl::StatusOr<std::unique_ptr<TupleIterator>> RootOp::CreateIteratorImpl(
     absl::Span<const TupleData* const> params, int num_extra_slots,
     EvaluationContext* context) const {
   return input()->CreateIterator(params, num_extra_slots, context);
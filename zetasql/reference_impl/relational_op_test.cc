@@ -19,6 +19,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <functional>
+#include <limits>
 #include <map>
 #include <memory>
 #include <optional>
@@ -53,6 +54,7 @@
 #include "zetasql/testing/using_test_value.cc"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/algorithm/container.h"
 #include "absl/flags/flag.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
@@ -73,13 +75,16 @@ using ::std::nullopt;
 using ::testing::_;
 using ::testing::ContainsRegex;
 using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
 using ::testing::Eq;
 using ::testing::HasSubstr;
 using ::testing::IsEmpty;
 using ::testing::IsNull;
+using ::testing::Not;
 using ::testing::Pointee;
 using ::testing::PrintToString;
 using ::testing::SizeIs;
+using ::testing::UnorderedElementsAreArray;
 using ::zetasql_base::testing::IsOkAndHolds;
 using ::zetasql_base::testing::StatusIs;
 
@@ -100,6 +105,12 @@ void PrintTo(const ColumnFilter& filter, std::ostream* os) {
     case ColumnFilter::kInList:
       *os << "<in_list: " << PrintToString(filter.in_list()) << ">";
       break;
+    case ColumnFilter::kIsNull:
+      *os << "<is_null>";
+      break;
+    case ColumnFilter::kPrefix:
+      *os << "<prefix: " << filter.prefix() << ">";
+      break;
     default:
       *os << "Unsupported ColumnFilter Kind";
       break;
@@ -429,6 +440,61 @@ TEST(ColumnFilterArgTest, HalfUnbounded) {
   }
 }
 
+TEST(ColumnFilterArgTest, IsNull) {
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto arg, IsNullColumnFilterArg::Create(
+                                     VariableId("foo"), /*column_idx=*/3));
+  EXPECT_EQ(arg->column_idx(), 3);
+  EXPECT_EQ(arg->DebugString(), "IsNullColumnFilterArg($foo, column_idx: 3)");
+  ZETASQL_ASSERT_OK(arg->SetSchemasForEvaluation(EmptyParamsSchemas()));
+
+  EvaluationContext context((EvaluationOptions()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<ColumnFilter> column_filter,
+                       arg->Eval(EmptyParams(), &context));
+  EXPECT_EQ(column_filter->kind(), ColumnFilter::kIsNull);
+}
+
+TEST(ColumnFilterArgTest, Prefix) {
+  VariableId p("p");
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_p, DerefExpr::Create(p, StringType()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto arg, PrefixColumnFilterArg::Create(
+                    VariableId("foo"), /*column_idx=*/3, std::move(deref_p)));
+  EXPECT_EQ(arg->column_idx(), 3);
+  EXPECT_EQ(arg->DebugString(),
+            "PrefixColumnFilterArg($foo, column_idx: 3, pattern: $p)");
+
+  const TupleSchema params_schemas({p});
+  ZETASQL_ASSERT_OK(arg->SetSchemasForEvaluation({&params_schemas}));
+
+  EvaluationContext context((EvaluationOptions()));
+  for (const auto& [pattern, prefix] :
+       std::vector<std::pair<std::string, std::string>>{{"abc%", "abc"},
+                                                        {"ab_c%", "ab"},
+                                                        {"ab\\%c", "ab"},
+                                                        {"abc", "abc"}}) {
+    const TupleData params_data = CreateTupleDataFromValues({String(pattern)});
+    ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<ColumnFilter> column_filter,
+                         arg->Eval({&params_data}, &context));
+    ASSERT_EQ(column_filter->kind(), ColumnFilter::kPrefix) << pattern;
+    EXPECT_EQ(column_filter->prefix(), String(prefix)) << pattern;
+  }
+
+  // A pattern that starts with a wildcard matches every non-NULL value.
+  const TupleData params_wildcard_data =
+      CreateTupleDataFromValues({String("%abc")});
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<ColumnFilter> column_filter_wildcard,
+                       arg->Eval({&params_wildcard_data}, &context));
+  ASSERT_EQ(column_filter_wildcard->kind(), ColumnFilter::kRange);
+  EXPECT_FALSE(column_filter_wildcard->lower_bound().is_valid());
+  EXPECT_FALSE(column_filter_wildcard->upper_bound().is_valid());
+
+  const TupleData params_null_data = CreateTupleDataFromValues({NullString()});
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<ColumnFilter> column_filter_null,
+                       arg->Eval({&params_null_data}, &context));
+  ASSERT_EQ(column_filter_null->kind(), ColumnFilter::kInList);
+  EXPECT_THAT(column_filter_null->in_list(), IsEmpty());
+}
+
 MATCHER_P2(IsRangeColumnFilterWith, lower_bound, upper_bound, "") {
   if (arg.kind() != ColumnFilter::kRange) return false;
   if (lower_bound.is_valid() != arg.lower_bound().is_valid() ||
@@ -448,6 +514,14 @@ MATCHER_P(IsListColumnFilterWith, in_list, "") {
   return arg.kind() == ColumnFilter::kInList && arg.in_list() == in_list;
 }
 
+MATCHER(IsIsNullColumnFilter, "") {
+  return arg.kind() == ColumnFilter::kIsNull;
+}
+
+MATCHER_P(IsPrefixColumnFilterWith, prefix, "") {
+  return arg.kind() == ColumnFilter::kPrefix && arg.prefix().Equals(prefix);
+}
+
 TEST(IntersectColumnFiltersTest, OneRangeFilter) {
   std::vector<std::unique_ptr<ColumnFilter>> filters;
   filters.push_back(std::make_unique<ColumnFilter>(Int64(10), Int64(20)));
@@ -661,6 +735,81 @@ TEST(IntersectColumnFiltersTest, DisjointRangesAndInList) {
       IsOkAndHolds(Pointee(IsListColumnFilterWith(std::vector<Value>()))));
 }
 
+TEST(IntersectColumnFiltersTest, TwoIsNullFilters) {
+  std::vector<std::unique_ptr<ColumnFilter>> filters;
+  filters.push_back(std::make_unique<ColumnFilter>(ColumnFilter::IsNull()));
+  filters.push_back(std::make_unique<ColumnFilter>(ColumnFilter::IsNull()));
+  EXPECT_THAT(EvaluatorTableScanOp::IntersectColumnFilters(filters),
+              IsOkAndHolds(Pointee(IsIsNullColumnFilter())));
+}
+
+TEST(IntersectColumnFiltersTest, IsNullAndRange) {
+  std::vector<std::unique_ptr<ColumnFilter>> filters;
+  filters.push_back(std::make_unique<ColumnFilter>(ColumnFilter::IsNull()));
+  filters.push_back(std::make_unique<ColumnFilter>(Value(), Value()));
+  EXPECT_THAT(
+      EvaluatorTableScanOp::IntersectColumnFilters(filters),
+      IsOkAndHolds(Pointee(IsListColumnFilterWith(std::vector<Value>()))));
+}
+
+TEST(IntersectColumnFiltersTest, NestedPrefixes) {
+  std::vector<std::unique_ptr<ColumnFilter>> filters;
+  filters.push_back(
+      std::make_unique<ColumnFilter>(ColumnFilter::Prefix(String("ab"))));
+  filters.push_back(
+      std::make_unique<ColumnFilter>(ColumnFilter::Prefix(String("abc"))));
+  filters.push_back(
+      std::make_unique<ColumnFilter>(ColumnFilter::Prefix(String("a"))));
+  EXPECT_THAT(EvaluatorTableScanOp::IntersectColumnFilters(filters),
+              IsOkAndHolds(Pointee(IsPrefixColumnFilterWith(String("abc")))));
+}
+
+TEST(IntersectColumnFiltersTest, DisjointPrefixes) {
+  std::vector<std::unique_ptr<ColumnFilter>> filters;
+  filters.push_back(
+      std::make_unique<ColumnFilter>(ColumnFilter::Prefix(String("ab"))));
+  filters.push_back(
+      std::make_unique<ColumnFilter>(ColumnFilter::Prefix(String("ac"))));
+  EXPECT_THAT(
+      EvaluatorTableScanOp::IntersectColumnFilters(filters),
+      IsOkAndHolds(Pointee(IsListColumnFilterWith(std::vector<Value>()))));
+}
+
+TEST(IntersectColumnFiltersTest, PrefixAndOverlappingRange) {
+  std::vector<std::unique_ptr<ColumnFilter>> filters;
+  filters.push_back(
+      std::make_unique<ColumnFilter>(ColumnFilter::Prefix(String("ab"))));
+  filters.push_back(
+      std::make_unique<ColumnFilter>(String("abc"), String("b")));
+  EXPECT_THAT(EvaluatorTableScanOp::IntersectColumnFilters(filters),
+              IsOkAndHolds(Pointee(IsPrefixColumnFilterWith(String("ab")))));
+}
+
+TEST(IntersectColumnFiltersTest, PrefixAndDisjointRanges) {
+  for (const auto& [lower_bound, upper_bound] :
+       std::vector<std::pair<Value, Value>>{{String("ac"), Value()},
+                                            {Value(), String("aa")}}) {
+    std::vector<std::unique_ptr<ColumnFilter>> filters;
+    filters.push_back(
+        std::make_unique<ColumnFilter>(ColumnFilter::Prefix(String("ab"))));
+    filters.push_back(std::make_unique<ColumnFilter>(lower_bound, upper_bound));
+    EXPECT_THAT(
+        EvaluatorTableScanOp::IntersectColumnFilters(filters),
+        IsOkAndHolds(Pointee(IsListColumnFilterWith(std::vector<Value>()))));
+  }
+}
+
+TEST(IntersectColumnFiltersTest, PrefixAndInList) {
+  std::vector<std::unique_ptr<ColumnFilter>> filters;
+  filters.push_back(std::make_unique<ColumnFilter>(
+      std::vector<Value>({String("a"), String("abc"), String("b")})));
+  filters.push_back(
+      std::make_unique<ColumnFilter>(ColumnFilter::Prefix(String("ab"))));
+  EXPECT_THAT(EvaluatorTableScanOp::IntersectColumnFilters(filters),
+              IsOkAndHolds(Pointee(
+                  IsListColumnFilterWith(std::vector<Value>{String("abc")}))));
+}
+
 EvaluationOptions GetScramblingEvaluationOptions() {
   EvaluationOptions options;
   options.scramble_undefined_orderings = true;
@@ -809,6 +958,320 @@ TEST_F(CreateIteratorTest, EvaluatorTableScanOpFailure) {
   EXPECT_THAT(status, StatusIs(absl::StatusCode::kOutOfRange, error));
 }
 
+TEST_F(CreateIteratorTest, EvaluatorTableScanOpWithThreads) {
+  VariableId x("x"), y("y"), z("z");
+
+  std::vector<std::vector<Value>> rows;
+  for (int64_t i = 0; i < 5000; ++i) {
+    rows.push_back({Int64(i), Int64(i % 7), String(absl::StrCat("row", i))});
+  }
+  EvaluatorTestTable table("TestTable",
+                           {{"column0", types::Int64Type()},
+                            {"column1", types::Int64Type()},
+                            {"column2", types::StringType()}},
+                           rows, /*end_status=*/absl::OkStatus(),
+                           /*column_filter_idxs=*/{1});
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto array_expr, ConstExpr::Create(Int64Array({2, 5})));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto filter,
+                       InArrayColumnFilterArg::Create(y, /*column_idx=*/1,
+                                                      std::move(array_expr)));
+  std::vector<std::unique_ptr<ColumnFilterArg>> and_filters;
+  and_filters.push_back(std::move(filter));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto scan_op,
+      EvaluatorTableScanOp::Create(
+          &table, /*alias=*/"", {2, 1, 0}, {"column2", "column1", "column0"},
+          {z, y, x}, std::move(and_filters), /*read_time=*/nullptr));
+
+  auto evaluate = [&scan_op](int num_threads) {
+    EvaluationOptions options;
+    options.num_threads = num_threads;
+    EvaluationContext context(options);
+    std::vector<std::string> output;
+    absl::StatusOr<std::unique_ptr<TupleIterator>> iter =
+        scan_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/1, &context);
+    ZETASQL_EXPECT_OK(iter.status());
+    if (!iter.ok()) return output;
+    EXPECT_EQ((*iter)->DebugString(), "EvaluatorTableTupleIterator(TestTable)");
+    EXPECT_TRUE((*iter)->PreservesOrder());
+    absl::StatusOr<std::vector<TupleData>> data =
+        ReadFromTupleIterator(iter->get());
+    ZETASQL_EXPECT_OK(data.status());
+    if (!data.ok()) return output;
+    for (const TupleData& tuple : *data) {
+      EXPECT_EQ(tuple.num_slots(), 4);
+      output.push_back(tuple.DebugString());
+    }
+    return output;
+  };
+
+  const std::vector<std::string> expected = evaluate(/*num_threads=*/1);
+  EXPECT_EQ(expected.size(), 1428);
+  EXPECT_THAT(evaluate(/*num_threads=*/4), ElementsAreArray(expected));
+  EXPECT_THAT(evaluate(/*num_threads=*/3), ElementsAreArray(expected));
+}
+
+TEST_F(CreateIteratorTest, EvaluatorTableScanOpWithThreadsFailure) {
+  const std::string error = "Failed to read row from TestTable";
+  const absl::Status failure = zetasql_base::OutOfRangeErrorBuilder() << error;
+
+  std::vector<std::vector<Value>> rows;
+  for (int64_t i = 0; i < 5000; ++i) {
+    rows.push_back({Int64(i)});
+  }
+  EvaluatorTestTable table("TestTable", {{"column0", types::Int64Type()}},
+                           rows, failure);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto scan_op, EvaluatorTableScanOp::Create(&table, /*alias=*/"", {0},
+                                                 {"column0"}, {VariableId("x")},
+                                                 /*and_filters=*/{},
+                                                 /*read_time=*/nullptr));
+
+  EvaluationOptions options;
+  options.num_threads = 4;
+  EvaluationContext context(options);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<TupleIterator> iter,
+      scan_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/0, &context));
+  absl::Status status;
+  ReadFromTupleIteratorFull(iter.get(), &status);
+  EXPECT_THAT(status, StatusIs(absl::StatusCode::kOutOfRange, error));
+}
+
+TEST_F(CreateIteratorTest, EvaluatorTableScanOpWithPrefetching) {
+  std::vector<std::vector<Value>> rows;
+  for (int64_t i = 0; i < 100; ++i) {
+    rows.push_back({Int64(i)});
+  }
+  const std::string error = "Failed to read row from TestTable";
+  const absl::Status failure = zetasql_base::OutOfRangeErrorBuilder() << error;
+  int64_t num_cancel_calls = 0;
+  EvaluatorTestTable table(
+      "TestTable", {{"column0", types::Int64Type()}}, rows, failure,
+      /*column_filter_idxs=*/{}, [&num_cancel_calls] { ++num_cancel_calls; });
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto scan_op, EvaluatorTableScanOp::Create(&table, /*alias=*/"", {0},
+                                                 {"column0"}, {VariableId("x")},
+                                                 /*and_filters=*/{},
+                                                 /*read_time=*/nullptr));
+
+  EvaluationOptions options;
+  options.scan_prefetch_rows = 8;
+  EvaluationContext context(options);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<TupleIterator> iter,
+      scan_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/1, &context));
+  EXPECT_EQ(iter->DebugString(), "EvaluatorTableTupleIterator(TestTable)");
+  absl::Status status;
+  std::vector<TupleData> data = ReadFromTupleIteratorFull(iter.get(), &status);
+  EXPECT_THAT(status, StatusIs(absl::StatusCode::kOutOfRange, error));
+  ASSERT_EQ(data.size(), rows.size());
+  for (int64_t i = 0; i < data.size(); ++i) {
+    EXPECT_EQ(data[i].num_slots(), 2);
+    EXPECT_EQ(data[i].slot(0).value(), rows[i][0]);
+  }
+  EXPECT_EQ(num_cancel_calls, 0);
+
+  // Closing the iterator while the reader is ahead stops the reader.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      iter,
+      scan_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/0, &context));
+  const TupleData* tuple = iter->Next();
+  ASSERT_NE(tuple, nullptr);
+  EXPECT_EQ(tuple->slot(0).value(), Int64(0));
+  iter->Close();
+  EXPECT_EQ(num_cancel_calls, 1);
+  EXPECT_EQ(iter->Next(), nullptr);
+}
+
+TEST_F(CreateIteratorTest, UnionAllOfTableScansWithThreads) {
+  // Tables of different sizes, including empty ones, so that some finish in
+  // the first wave and others only after several waves.
+  std::vector<std::unique_ptr<EvaluatorTestTable>> tables;
+  for (int64_t num_rows : {3000, 0, 5, 2500, 1024, 0}) {
+    std::vector<std::vector<Value>> rows;
+    for (int64_t i = 0; i < num_rows; ++i) {
+      rows.push_back({Int64(static_cast<int64_t>(tables.size())), Int64(i)});
+    }
+    tables.push_back(std::make_unique<EvaluatorTestTable>(
+        absl::StrCat("TestTable", tables.size()),
+        std::vector<std::pair<std::string, const Type*>>{
+            {"table", types::Int64Type()}, {"row", types::Int64Type()}},
+        rows, /*end_status=*/absl::OkStatus()));
+  }
+  std::vector<std::string> scan_debug_strings;
+  for (const auto& table : tables) {
+    scan_debug_strings.push_back(
+        EvaluatorTableScanOp::GetIteratorDebugString(table->Name()));
+  }
+  const std::string debug_string =
+      UnionAllOp::GetIteratorDebugString(scan_debug_strings);
+
+  const VariableId a("a"), b("b");
+  std::vector<UnionAllOp::Input> union_inputs;
+  for (int i = 0; i < tables.size(); ++i) {
+    const VariableId table_var(absl::StrCat("t", i));
+    const VariableId row_var(absl::StrCat("r", i));
+    ZETASQL_ASSERT_OK_AND_ASSIGN(
+        auto scan_op,
+        EvaluatorTableScanOp::Create(tables[i].get(), /*alias=*/"", {0, 1},
+                                     {"table", "row"}, {table_var, row_var},
+                                     /*and_filters=*/{},
+                                     /*read_time=*/nullptr));
+    ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_table,
+                         DerefExpr::Create(table_var, Int64Type()));
+    ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_row,
+                         DerefExpr::Create(row_var, Int64Type()));
+    UnionAllOp::Input& input = union_inputs.emplace_back();
+    input.first = std::move(scan_op);
+    input.second.push_back(
+        std::make_unique<ExprArg>(a, std::move(deref_table)));
+    input.second.push_back(std::make_unique<ExprArg>(b, std::move(deref_row)));
+  }
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto union_all_op,
+                       UnionAllOp::Create(std::move(union_inputs)));
+  ZETASQL_ASSERT_OK(union_all_op->SetSchemasForEvaluation(EmptyParamsSchemas()));
+
+  auto evaluate = [&union_all_op, &debug_string](int num_threads) {
+    EvaluationOptions options;
+    options.num_threads = num_threads;
+    EvaluationContext context(options);
+    std::vector<std::string> output;
+    absl::StatusOr<std::unique_ptr<TupleIterator>> iter =
+        union_all_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/1,
+                                     &context);
+    ZETASQL_EXPECT_OK(iter.status());
+    if (!iter.ok()) return output;
+    EXPECT_EQ((*iter)->DebugString(), debug_string);
+    absl::StatusOr<std::vector<TupleData>> data =
+        ReadFromTupleIterator(iter->get());
+    ZETASQL_EXPECT_OK(data.status());
+    if (!data.ok()) return output;
+    for (const TupleData& tuple : *data) {
+      EXPECT_EQ(tuple.num_slots(), 3);
+      output.push_back(tuple.DebugString());
+    }
+    return output;
+  };
+
+  const std::vector<std::string> expected = evaluate(/*num_threads=*/1);
+  EXPECT_EQ(expected.size(), 6529);
+  EXPECT_THAT(evaluate(/*num_threads=*/4), UnorderedElementsAreArray(expected));
+  EXPECT_THAT(evaluate(/*num_threads=*/2), UnorderedElementsAreArray(expected));
+}
+
+TEST_F(CreateIteratorTest, SystemSampleOfTableScanSkipsBlocks) {
+  std::vector<std::vector<Value>> rows;
+  for (int64_t i = 0; i < 10000; ++i) {
+    rows.push_back({Int64(i)});
+  }
+  EvaluatorTestTable table("TestTable", {{"column0", types::Int64Type()}},
+                           rows, /*end_status=*/absl::OkStatus());
+  const VariableId x("x"), w("w");
+
+  auto sample = [&](double percent) {
+    std::vector<int64_t> output;
+    absl::StatusOr<std::unique_ptr<EvaluatorTableScanOp>> scan_op =
+        EvaluatorTableScanOp::Create(&table, /*alias=*/"", {0}, {"column0"},
+                                     {x}, /*and_filters=*/{},
+                                     /*read_time=*/nullptr);
+    ZETASQL_EXPECT_OK(scan_op.status());
+    absl::StatusOr<std::unique_ptr<SampleScanOp>> sample_op =
+        SampleScanOp::Create(SampleScanOp::Method::kSystemPercent,
+                             ConstExpr::Create(Double(percent)).value(),
+                             ConstExpr::Create(Int64(7)).value(),
+                             std::move(scan_op).value(),
+                             /*partition_key=*/{}, w);
+    ZETASQL_EXPECT_OK(sample_op.status());
+    ZETASQL_EXPECT_OK((*sample_op)->SetSchemasForEvaluation(EmptyParamsSchemas()));
+    EvaluationContext context((EvaluationOptions()));
+    absl::StatusOr<std::unique_ptr<TupleIterator>> iter =
+        (*sample_op)
+            ->CreateIterator(EmptyParams(), /*num_extra_slots=*/0, &context);
+    ZETASQL_EXPECT_OK(iter.status());
+    absl::StatusOr<std::vector<TupleData>> data =
+        ReadFromTupleIterator(iter->get());
+    ZETASQL_EXPECT_OK(data.status());
+    for (const TupleData& tuple : *data) {
+      output.push_back(tuple.slot(0).value().int64_value());
+      EXPECT_EQ(tuple.slot(1).value(), Double(100 / percent));
+    }
+    return output;
+  };
+
+  EXPECT_THAT(sample(100), SizeIs(rows.size()));
+  EXPECT_THAT(sample(0), IsEmpty());
+  const std::vector<int64_t> output = sample(50);
+  // Blocks of 1024 rows are kept or skipped as a whole, in table order.
+  std::map<int64_t, int64_t> rows_per_block;
+  for (int64_t i = 0; i < output.size(); ++i) {
+    if (i > 0 && output[i] % 1024 != 0) {
+      EXPECT_EQ(output[i], output[i - 1] + 1);
+    }
+    ++rows_per_block[output[i] / 1024];
+  }
+  for (const auto& [block, num_rows] : rows_per_block) {
+    EXPECT_EQ(num_rows, std::min<int64_t>(1024, rows.size() - block * 1024));
+  }
+  EXPECT_LT(output.size(), rows.size());
+  // The same seed gives the same sample.
+  EXPECT_EQ(sample(50), output);
+}
+
+TEST_F(CreateIteratorTest, ReservoirSampleOfTableScanWithThreads) {
+  std::vector<std::vector<Value>> rows;
+  for (int64_t i = 0; i < 5000; ++i) {
+    rows.push_back({Int64(i)});
+  }
+  EvaluatorTestTable table("TestTable", {{"column0", types::Int64Type()}},
+                           rows, /*end_status=*/absl::OkStatus());
+  const VariableId x("x"), w("w");
+
+  auto sample = [&](int64_t size, int num_threads) {
+    std::vector<int64_t> output;
+    absl::StatusOr<std::unique_ptr<EvaluatorTableScanOp>> scan_op =
+        EvaluatorTableScanOp::Create(&table, /*alias=*/"", {0}, {"column0"},
+                                     {x}, /*and_filters=*/{},
+                                     /*read_time=*/nullptr);
+    ZETASQL_EXPECT_OK(scan_op.status());
+    absl::StatusOr<std::unique_ptr<SampleScanOp>> sample_op =
+        SampleScanOp::Create(SampleScanOp::Method::kReservoirRows,
+                             ConstExpr::Create(Int64(size)).value(),
+                             ConstExpr::Create(Int64(7)).value(),
+                             std::move(scan_op).value(),
+                             /*partition_key=*/{}, w);
+    ZETASQL_EXPECT_OK(sample_op.status());
+    ZETASQL_EXPECT_OK((*sample_op)->SetSchemasForEvaluation(EmptyParamsSchemas()));
+    EvaluationOptions options;
+    options.num_threads = num_threads;
+    EvaluationContext context(options);
+    absl::StatusOr<std::unique_ptr<TupleIterator>> iter =
+        (*sample_op)
+            ->CreateIterator(EmptyParams(), /*num_extra_slots=*/0, &context);
+    ZETASQL_EXPECT_OK(iter.status());
+    absl::StatusOr<std::vector<TupleData>> data =
+        ReadFromTupleIterator(iter->get());
+    ZETASQL_EXPECT_OK(data.status());
+    for (const TupleData& tuple : *data) {
+      output.push_back(tuple.slot(0).value().int64_value());
+      EXPECT_EQ(tuple.slot(1).value(),
+                Double(1.0 * rows.size() / std::min<int64_t>(size, 5000)));
+    }
+    absl::c_sort(output);
+    return output;
+  };
+
+  const std::vector<int64_t> expected = sample(/*size=*/100, /*num_threads=*/1);
+  EXPECT_THAT(expected, SizeIs(100));
+  EXPECT_EQ(absl::c_adjacent_find(expected), expected.end());
+  EXPECT_EQ(sample(/*size=*/100, /*num_threads=*/4), expected);
+  EXPECT_EQ(sample(/*size=*/100, /*num_threads=*/3), expected);
+  EXPECT_THAT(sample(/*size=*/10000, /*num_threads=*/4), SizeIs(rows.size()));
+  EXPECT_THAT(sample(/*size=*/0, /*num_threads=*/4), IsEmpty());
+}
+
 TEST_F(CreateIteratorTest, EvaluatorTableScanOpCancellation) {
   int64_t num_cancel_calls = 0;
   const std::function<void()> cancel_cb = [&num_cancel_calls]() {
@@ -945,7 +1408,7 @@ class TestCppValuesOp : public RelationalOp {
     return absl::OkStatus();
   }
 
-  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIteratorImpl(
       absl::Span<const TupleData* const> params, int num_extra_slots,
       EvaluationContext* context) const override {
     std::vector<TupleData> tuple_data;
@@ -2557,6 +3020,392 @@ TEST_F(CreateIteratorTest, FullOuterHashJoin) {
                        HasSubstr("Out of memory")));
 }
 
+TEST_F(CreateIteratorTest, FullOuterHashJoinWithThreads) {
+  VariableId x("x"), y("y"), a("a"), b("b");
+
+  // Enough right tuples to build the hash table in parallel, with several
+  // tuples per key and some keys that do not match.
+  std::vector<std::vector<Value>> left_values;
+  for (int64_t i = 0; i < 2000; ++i) {
+    left_values.push_back({Int64(i)});
+  }
+  std::vector<std::vector<Value>> right_values;
+  for (int64_t i = 0; i < 4500; ++i) {
+    right_values.push_back({Int64(1000 + i % 1500)});
+  }
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_x, DerefExpr::Create(x, Int64Type()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_y, DerefExpr::Create(y, Int64Type()));
+  JoinOp::HashJoinEqualityExprs equality_expr;
+  equality_expr.left_expr = std::make_unique<ExprArg>(a, std::move(deref_x));
+  equality_expr.right_expr = std::make_unique<ExprArg>(b, std::move(deref_y));
+  std::vector<JoinOp::HashJoinEqualityExprs> equality_exprs;
+  equality_exprs.push_back(std::move(equality_expr));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto true_expr, ConstExpr::Create(Bool(true)));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto join_op,
+      JoinOp::Create(
+          JoinOp::kFullOuterJoin, std::move(equality_exprs),
+          std::move(true_expr),
+          absl::WrapUnique(new TestRelationalOp(
+              {x}, CreateTestTupleDatas(left_values), /*preserves_order=*/true)),
+          absl::WrapUnique(new TestRelationalOp(
+              {y}, CreateTestTupleDatas(right_values),
+              /*preserves_order=*/true)),
+          /*left_outputs=*/{}, /*right_outputs=*/{}));
+  ZETASQL_ASSERT_OK(join_op->SetSchemasForEvaluation(EmptyParamsSchemas()));
+
+  auto evaluate = [&join_op](int num_threads) {
+    EvaluationOptions options;
+    options.num_threads = num_threads;
+    EvaluationContext context(options);
+    std::vector<std::string> output;
+    absl::StatusOr<std::unique_ptr<TupleIterator>> iter =
+        join_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/0, &context);
+    ZETASQL_EXPECT_OK(iter.status());
+    if (!iter.ok()) return output;
+    absl::StatusOr<std::vector<TupleData>> data =
+        ReadFromTupleIterator(iter->get());
+    ZETASQL_EXPECT_OK(data.status());
+    if (!data.ok()) return output;
+    for (const TupleData& tuple : *data) {
+      output.push_back(tuple.DebugString());
+    }
+    return output;
+  };
+
+  const std::vector<std::string> expected = evaluate(/*num_threads=*/1);
+  // Keys [1000, 2000) match three times each. Keys [0, 1000) only appear on
+  // the left and keys [2000, 2500) only on the right (three times each).
+  EXPECT_EQ(expected.size(), 3000 + 1000 + 1500);
+  EXPECT_THAT(evaluate(/*num_threads=*/4), ElementsAreArray(expected));
+  EXPECT_THAT(evaluate(/*num_threads=*/3), ElementsAreArray(expected));
+}
+
+// Returns the values of the left input of a hash join of the given 'kind' of
+// 'left_values' and 'right_values' (each a single INT64 column), or an empty
+// vector and a test failure on error.
+static std::vector<Value> EvaluateSemiOrAntiHashJoin(
+    JoinOp::JoinKind kind, const std::vector<std::vector<Value>>& left_values,
+    const std::vector<std::vector<Value>>& right_values) {
+  VariableId x("x"), y("y"), a("a"), b("b");
+  std::vector<Value> output;
+
+  auto deref_x = DerefExpr::Create(x, Int64Type());
+  auto deref_y = DerefExpr::Create(y, Int64Type());
+  ZETASQL_EXPECT_OK(deref_x.status());
+  ZETASQL_EXPECT_OK(deref_y.status());
+  if (!deref_x.ok() || !deref_y.ok()) return output;
+  JoinOp::HashJoinEqualityExprs equality_expr;
+  equality_expr.left_expr =
+      std::make_unique<ExprArg>(a, std::move(deref_x).value());
+  equality_expr.right_expr =
+      std::make_unique<ExprArg>(b, std::move(deref_y).value());
+  std::vector<JoinOp::HashJoinEqualityExprs> equality_exprs;
+  equality_exprs.push_back(std::move(equality_expr));
+
+  auto true_expr = ConstExpr::Create(Bool(true));
+  ZETASQL_EXPECT_OK(true_expr.status());
+  if (!true_expr.ok()) return output;
+  absl::StatusOr<std::unique_ptr<JoinOp>> join_op = JoinOp::Create(
+      kind, std::move(equality_exprs), std::move(true_expr).value(),
+      absl::WrapUnique(new TestRelationalOp(
+          {x}, CreateTestTupleDatas(left_values), /*preserves_order=*/true)),
+      absl::WrapUnique(new TestRelationalOp(
+          {y}, CreateTestTupleDatas(right_values), /*preserves_order=*/true)),
+      /*left_outputs=*/{}, /*right_outputs=*/{});
+  ZETASQL_EXPECT_OK(join_op.status());
+  if (!join_op.ok()) return output;
+  EXPECT_THAT((*join_op)->CreateOutputSchema()->variables(), ElementsAre(x));
+  ZETASQL_EXPECT_OK((*join_op)->SetSchemasForEvaluation(EmptyParamsSchemas()));
+
+  EvaluationContext context((EvaluationOptions()));
+  absl::StatusOr<std::unique_ptr<TupleIterator>> iter =
+      (*join_op)->CreateIterator(EmptyParams(), /*num_extra_slots=*/0,
+                                 &context);
+  ZETASQL_EXPECT_OK(iter.status());
+  if (!iter.ok()) return output;
+  EXPECT_TRUE((*iter)->PreservesOrder());
+  absl::StatusOr<std::vector<TupleData>> data =
+      ReadFromTupleIterator(iter->get());
+  ZETASQL_EXPECT_OK(data.status());
+  if (!data.ok()) return output;
+  for (const TupleData& tuple : *data) {
+    output.push_back(tuple.slot(0).value());
+  }
+  return output;
+}
+
+TEST_F(CreateIteratorTest, SemiAndAntiHashJoin) {
+  const std::vector<std::vector<Value>> left = {
+      {Int64(1)}, {Int64(2)}, {Int64(2)}, {Int64(3)}, {NullInt64()}};
+  const std::vector<std::vector<Value>> right = {
+      {Int64(2)}, {Int64(2)}, {Int64(4)}, {NullInt64()}};
+
+  // Each matching left tuple is output once, in the order of the left input.
+  EXPECT_THAT(EvaluateSemiOrAntiHashJoin(JoinOp::kSemiJoin, left, right),
+              ElementsAre(Int64(2), Int64(2)));
+  EXPECT_THAT(EvaluateSemiOrAntiHashJoin(JoinOp::kAntiJoin, left, right),
+              ElementsAre(Int64(1), Int64(3), NullInt64()));
+  EXPECT_THAT(EvaluateSemiOrAntiHashJoin(JoinOp::kSemiJoin, left, {}),
+              IsEmpty());
+  EXPECT_THAT(EvaluateSemiOrAntiHashJoin(JoinOp::kAntiJoin, left, {}),
+              ElementsAre(Int64(1), Int64(2), Int64(2), Int64(3), NullInt64()));
+}
+
+// The keys of a hash join are charged to the same MemoryAccountant as its right
+// tuples, for as long as the iterator holds them.
+TEST_F(CreateIteratorTest, HashJoinChargesKeysToMemoryAccountant) {
+  VariableId x("x"), y("y"), a("a"), b("b");
+  // Returns the number of bytes in use once an inner join of x and y has built
+  // its right input, with x = y as the hash join equality if 'hashed' is true.
+  auto get_used_bytes = [&](bool hashed) -> absl::StatusOr<int64_t> {
+    std::vector<JoinOp::HashJoinEqualityExprs> equality_exprs;
+    if (hashed) {
+      ZETASQL_ASSIGN_OR_RETURN(auto deref_x, DerefExpr::Create(x, Int64Type()));
+      ZETASQL_ASSIGN_OR_RETURN(auto deref_y, DerefExpr::Create(y, Int64Type()));
+      JoinOp::HashJoinEqualityExprs equality_expr;
+      equality_expr.left_expr =
+          std::make_unique<ExprArg>(a, std::move(deref_x));
+      equality_expr.right_expr =
+          std::make_unique<ExprArg>(b, std::move(deref_y));
+      equality_exprs.push_back(std::move(equality_expr));
+    }
+    ZETASQL_ASSIGN_OR_RETURN(auto true_expr, ConstExpr::Create(Bool(true)));
+    ZETASQL_ASSIGN_OR_RETURN(
+        std::unique_ptr<JoinOp> join_op,
+        JoinOp::Create(
+            JoinOp::kInnerJoin, std::move(equality_exprs),
+            std::move(true_expr),
+            absl::WrapUnique(new TestRelationalOp(
+                {x}, CreateTestTupleDatas({{Int64(1)}}),
+                /*preserves_order=*/true)),
+            absl::WrapUnique(new TestRelationalOp(
+                {y},
+                CreateTestTupleDatas({{Int64(1)}, {Int64(2)}, {Int64(3)}}),
+                /*preserves_order=*/true)),
+            /*left_outputs=*/{}, /*right_outputs=*/{}));
+    ZETASQL_RETURN_IF_ERROR(join_op->SetSchemasForEvaluation(EmptyParamsSchemas()));
+
+    EvaluationContext context(GetIntermediateMemoryEvaluationOptions(
+        /*total_bytes=*/1 << 20));
+    const MemoryAccountant* accountant = context.memory_accountant();
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<TupleIterator> iter,
+                     join_op->CreateIterator(
+                         EmptyParams(), /*num_extra_slots=*/0, &context));
+    const int64_t used_bytes =
+        accountant->total_num_bytes() - accountant->remaining_bytes();
+    iter.reset();
+    EXPECT_EQ(accountant->remaining_bytes(), accountant->total_num_bytes());
+    return used_bytes;
+  };
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(const int64_t nested_loop_bytes,
+                       get_used_bytes(/*hashed=*/false));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(const int64_t hash_join_bytes,
+                       get_used_bytes(/*hashed=*/true));
+  EXPECT_GT(nested_loop_bytes, 0);
+  EXPECT_GT(hash_join_bytes, nested_loop_bytes);
+}
+
+TEST_F(CreateIteratorTest, NullAwareAntiJoin) {
+  const std::vector<std::vector<Value>> left = {
+      {Int64(1)}, {Int64(2)}, {Int64(3)}, {NullInt64()}};
+
+  // x NOT IN (2, 4) is NULL for x = NULL.
+  EXPECT_THAT(EvaluateSemiOrAntiHashJoin(JoinOp::kNullAwareAntiJoin, left,
+                                         {{Int64(2)}, {Int64(4)}}),
+              ElementsAre(Int64(1), Int64(3)));
+  // x NOT IN (2, NULL) is never TRUE.
+  EXPECT_THAT(EvaluateSemiOrAntiHashJoin(JoinOp::kNullAwareAntiJoin, left,
+                                         {{Int64(2)}, {NullInt64()}}),
+              IsEmpty());
+  // x NOT IN (empty) is TRUE, even for x = NULL.
+  EXPECT_THAT(
+      EvaluateSemiOrAntiHashJoin(JoinOp::kNullAwareAntiJoin, left, {}),
+      ElementsAre(Int64(1), Int64(2), Int64(3), NullInt64()));
+}
+
+// Returns the values of a join of the given 'kind' of 'left_values' and
+// 'right_values' (each a single column with a DATE range or a DATE) with
+// RangeJoinExprs on the two columns and a TRUE remaining condition, or an
+// empty vector and a test failure on error.
+static std::vector<std::vector<Value>> EvaluateRangeJoin(
+    JoinOp::JoinKind kind, const Type* left_type,
+    const std::vector<std::vector<Value>>& left_values, const Type* right_type,
+    const std::vector<std::vector<Value>>& right_values) {
+  VariableId x("x"), y("y"), a("a"), b("b");
+  std::vector<std::vector<Value>> output;
+
+  auto deref_x = DerefExpr::Create(x, left_type);
+  auto deref_y = DerefExpr::Create(y, right_type);
+  ZETASQL_EXPECT_OK(deref_x.status());
+  ZETASQL_EXPECT_OK(deref_y.status());
+  if (!deref_x.ok() || !deref_y.ok()) return output;
+  JoinOp::RangeJoinExprs range_join_exprs;
+  range_join_exprs.left_expr =
+      std::make_unique<ExprArg>(a, std::move(deref_x).value());
+  range_join_exprs.right_expr =
+      std::make_unique<ExprArg>(b, std::move(deref_y).value());
+
+  auto true_expr = ConstExpr::Create(Bool(true));
+  ZETASQL_EXPECT_OK(true_expr.status());
+  if (!true_expr.ok()) return output;
+  absl::StatusOr<std::unique_ptr<JoinOp>> join_op = JoinOp::Create(
+      kind, /*equality_exprs=*/{}, std::move(true_expr).value(),
+      absl::WrapUnique(new TestRelationalOp(
+          {x}, CreateTestTupleDatas(left_values), /*preserves_order=*/true)),
+      absl::WrapUnique(new TestRelationalOp(
+          {y}, CreateTestTupleDatas(right_values), /*preserves_order=*/true)),
+      /*left_outputs=*/{}, /*right_outputs=*/{},
+      std::move(range_join_exprs));
+  ZETASQL_EXPECT_OK(join_op.status());
+  if (!join_op.ok()) return output;
+  ZETASQL_EXPECT_OK((*join_op)->SetSchemasForEvaluation(EmptyParamsSchemas()));
+
+  EvaluationContext context((EvaluationOptions()));
+  absl::StatusOr<std::unique_ptr<TupleIterator>> iter =
+      (*join_op)->CreateIterator(EmptyParams(), /*num_extra_slots=*/0,
+                                 &context);
+  ZETASQL_EXPECT_OK(iter.status());
+  if (!iter.ok()) return output;
+  EXPECT_TRUE((*iter)->PreservesOrder());
+  absl::StatusOr<std::vector<TupleData>> data =
+      ReadFromTupleIterator(iter->get());
+  ZETASQL_EXPECT_OK(data.status());
+  if (!data.ok()) return output;
+  for (const TupleData& tuple : *data) {
+    std::vector<Value>& values = output.emplace_back();
+    for (const TupleSlot& slot : tuple.slots()) {
+      values.push_back(slot.value());
+    }
+  }
+  return output;
+}
+
+TEST_F(CreateIteratorTest, RangeJoin) {
+  const RangeType* range_type = types::DateRangeType();
+  auto range = [](const Value& start, const Value& end) {
+    return Value::MakeRange(start, end).value();
+  };
+  const Value unbounded = NullDate();
+  const Value null_range = Value::Null(range_type);
+
+  const std::vector<std::vector<Value>> right = {
+      {range(Date(10), Date(20))}, {range(Date(0), Date(5))},
+      {range(unbounded, Date(3))}, {null_range},
+      {range(Date(15), unbounded)}, {range(Date(5), Date(10))}};
+
+  // Only the right tuples that overlap the left range are joined, in the order
+  // of the right input.
+  EXPECT_THAT(
+      EvaluateRangeJoin(JoinOp::kInnerJoin, range_type,
+                        {{range(Date(4), Date(11))}}, range_type, right),
+      ElementsAre(
+          ElementsAre(range(Date(4), Date(11)), range(Date(10), Date(20))),
+          ElementsAre(range(Date(4), Date(11)), range(Date(0), Date(5))),
+          ElementsAre(range(Date(4), Date(11)), range(Date(5), Date(10)))));
+  // Ranges that end where the left range starts, or start where it ends, do
+  // not overlap it. An unbounded left range overlaps every right range.
+  EXPECT_THAT(
+      EvaluateRangeJoin(JoinOp::kLeftOuterJoin, range_type,
+                        {{range(Date(3), Date(5))},
+                         {null_range},
+                         {range(unbounded, unbounded)}},
+                        range_type, right),
+      ElementsAre(
+          ElementsAre(range(Date(3), Date(5)), range(Date(0), Date(5))),
+          ElementsAre(null_range, null_range),
+          ElementsAre(range(unbounded, unbounded), range(Date(10), Date(20))),
+          ElementsAre(range(unbounded, unbounded), range(Date(0), Date(5))),
+          ElementsAre(range(unbounded, unbounded), range(unbounded, Date(3))),
+          ElementsAre(range(unbounded, unbounded), range(Date(15), unbounded)),
+          ElementsAre(range(unbounded, unbounded), range(Date(5), Date(10)))));
+  // A left element matches the right ranges that contain it.
+  EXPECT_THAT(
+      EvaluateRangeJoin(JoinOp::kSemiJoin, DateType(),
+                        {{Date(2)}, {Date(12)}, {Date(100)}, {NullDate()}},
+                        range_type, {{range(Date(0), Date(5))},
+                                     {range(Date(10), Date(12))},
+                                     {range(Date(50), unbounded)}}),
+      ElementsAre(ElementsAre(Date(2)), ElementsAre(Date(100))));
+  // A left range matches the right elements that it contains.
+  EXPECT_THAT(
+      EvaluateRangeJoin(JoinOp::kInnerJoin, range_type,
+                        {{range(Date(5), Date(10))}}, DateType(),
+                        {{Date(10)}, {Date(7)}, {NullDate()}, {Date(5)},
+                         {Date(4)}}),
+      ElementsAre(ElementsAre(range(Date(5), Date(10)), Date(7)),
+                  ElementsAre(range(Date(5), Date(10)), Date(5))));
+}
+
+TEST_F(CreateIteratorTest, SemiJoinShortCircuits) {
+  VariableId x("x"), y("y");
+
+  // The condition x < y fails with division by zero if it is evaluated for
+  // the last right tuple, which cannot happen if the join stops at the first
+  // joining right tuple.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_x, DerefExpr::Create(x, Int64Type()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_y, DerefExpr::Create(y, Int64Type()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto one, ConstExpr::Create(Int64(1)));
+  std::vector<std::unique_ptr<ValueExpr>> div_args;
+  div_args.push_back(std::move(one));
+  div_args.push_back(std::move(deref_y));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto div_expr, ScalarFunctionCallExpr::Create(
+                         CreateFunction(FunctionKind::kDiv, Int64Type()),
+                         std::move(div_args)));
+  std::vector<std::unique_ptr<ValueExpr>> less_args;
+  less_args.push_back(std::move(deref_x));
+  less_args.push_back(std::move(div_expr));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto condition, ScalarFunctionCallExpr::Create(
+                          CreateFunction(FunctionKind::kLess, BoolType()),
+                          std::move(less_args)));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto join_op,
+      JoinOp::Create(
+          JoinOp::kSemiJoin, EmptyHashJoinEqualityExprs(), std::move(condition),
+          absl::WrapUnique(new TestRelationalOp(
+              {x}, CreateTestTupleDatas({{Int64(0)}, {Int64(0)}}),
+              /*preserves_order=*/true)),
+          absl::WrapUnique(new TestRelationalOp(
+              {y}, CreateTestTupleDatas({{Int64(1)}, {Int64(0)}}),
+              /*preserves_order=*/true)),
+          /*left_outputs=*/{}, /*right_outputs=*/{}));
+  EXPECT_EQ(
+      "JoinOp(SEMI\n"
+      "+-remaining_condition: Less($x, Div(ConstExpr(1), $y)),\n"
+      "+-left_input: TestRelationalOp,\n"
+      "+-right_input: TestRelationalOp)",
+      join_op->DebugString());
+  ZETASQL_ASSERT_OK(join_op->SetSchemasForEvaluation(EmptyParamsSchemas()));
+
+  EvaluationContext context((EvaluationOptions()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<TupleIterator> iter,
+      join_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/0, &context));
+  EXPECT_EQ(iter->DebugString(),
+            "JoinTupleIterator(SEMI, left=TestTupleIterator, "
+            "right=TestTupleIterator)");
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::vector<TupleData> data,
+                       ReadFromTupleIterator(iter.get()));
+  EXPECT_EQ(data.size(), 2);
+
+  // The output is the left input as is, so it is only scrambled if the left
+  // input is.
+  EvaluationContext scramble_context(GetScramblingEvaluationOptions());
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<TupleIterator> scramble_iter,
+      join_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/0,
+                              &scramble_context));
+  EXPECT_THAT(scramble_iter->DebugString(),
+              Not(HasSubstr("ReorderingTupleIterator(JoinTupleIterator")));
+}
+
 TEST_F(CreateIteratorTest, SortOpTotalOrder) {
   VariableId a("a"), b("b"), c("c"), param("param"), k("k"), v1("v1"), v2("v2"),
       v3("v3");
@@ -2690,10 +3539,56 @@ TEST_F(CreateIteratorTest, SortOpTotalOrder) {
                        HasSubstr("Out of memory")));
 }
 
-TEST_F(CreateIteratorTest, SortOpIgnoresOrder) {
-  VariableId a("a"), b("b"), k("k"), v("v");
+TEST_F(CreateIteratorTest, SortOpCollatedStringKey) {
+  VariableId a("a"), b("b"), k1("k1"), k2("k2");
 
-  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_a, DerefExpr::Create(a, Int64Type()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_a, DerefExpr::Create(a, StringType()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_b, DerefExpr::Create(b, Int64Type()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto collation, ConstExpr::Create(String("und:ci")));
+
+  std::vector<std::unique_ptr<KeyArg>> keys;
+  keys.push_back(
+      std::make_unique<KeyArg>(k1, std::move(deref_a), KeyArg::kAscending));
+  keys.back()->set_collation(std::move(collation));
+  keys.push_back(
+      std::make_unique<KeyArg>(k2, std::move(deref_b), KeyArg::kDescending));
+
+  auto input = absl::WrapUnique(new TestRelationalOp(
+      {a, b},
+      CreateTestTupleDatas({{String("b"), Int64(1)},
+                            {String("A"), Int64(2)},
+                            {NullString(), Int64(3)},
+                            {String("a"), Int64(4)},
+                            {String("C"), Int64(5)}}),
+      /*preserves_order=*/true));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto sort_op,
+      SortOp::Create(std::move(keys), /*values=*/{},
+                     /*limit=*/nullptr, /*offset=*/nullptr, std::move(input),
+                     /*is_order_preserving=*/true,
+                     /*is_stable_sort=*/false));
+  ZETASQL_ASSERT_OK(sort_op->SetSchemasForEvaluation(EmptyParamsSchemas()));
+
+  EvaluationContext context((EvaluationOptions()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<TupleIterator> iter,
+      sort_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/0, &context));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::vector<TupleData> data,
+                       ReadFromTupleIterator(iter.get()));
+  // "A" and "a" are equal with the collation, so they are ordered by 'b'.
+  ASSERT_EQ(data.size(), 5);
+  const std::vector<std::string> expected = {
+      "<k1:NULL,k2:3>", "<k1:\"a\",k2:4>", "<k1:\"A\",k2:2>",
+      "<k1:\"b\",k2:1>", "<k1:\"C\",k2:5>"};
+  for (int i = 0; i < data.size(); ++i) {
+    EXPECT_EQ(Tuple(&iter->Schema(), &data[i]).DebugString(), expected[i]);
+  }
+}
+
+TEST_F(CreateIteratorTest, SortOpIgnoresOrder) {
+  VariableId a("a"), b("b"), k("k"), v("v");
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_a, DerefExpr::Create(a, Int64Type()));
 
   std::vector<std::unique_ptr<KeyArg>> keys;
   keys.push_back(
@@ -3118,6 +4013,186 @@ TEST_F(CreateIteratorTest, SortOpPartialInputReordersTest) {
   }
 }
 
+TEST_F(CreateIteratorTest, SortOpSpillsToDisk) {
+  VariableId a("a"), b("b"), k("k"), v("v");
+
+  // Many tuples with few distinct keys, so that the order of equal keys is
+  // observable.
+  std::vector<std::vector<Value>> input_values;
+  for (int64_t i = 0; i < 1000; ++i) {
+    input_values.push_back({Int64(i % 17), String(absl::StrCat("row", i))});
+  }
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_a, DerefExpr::Create(a, Int64Type()));
+  std::vector<std::unique_ptr<KeyArg>> keys;
+  keys.push_back(
+      std::make_unique<KeyArg>(k, std::move(deref_a), KeyArg::kAscending));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_b, DerefExpr::Create(b, StringType()));
+  std::vector<std::unique_ptr<ExprArg>> values;
+  values.push_back(std::make_unique<ExprArg>(v, std::move(deref_b)));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto sort_op,
+      SortOp::Create(std::move(keys), std::move(values),
+                     /*limit=*/nullptr, /*offset=*/nullptr,
+                     absl::WrapUnique(new TestRelationalOp(
+                         {a, b}, CreateTestTupleDatas(input_values),
+                         /*preserves_order=*/true)),
+                     /*is_order_preserving=*/true,
+                     /*is_stable_sort=*/true));
+  ZETASQL_ASSERT_OK(sort_op->SetSchemasForEvaluation(EmptyParamsSchemas()));
+
+  auto evaluate = [&sort_op](const EvaluationOptions& options)
+      -> absl::StatusOr<std::vector<std::string>> {
+    EvaluationContext context(options);
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<TupleIterator> iter,
+                     sort_op->CreateIterator(EmptyParams(),
+                                             /*num_extra_slots=*/1, &context));
+    EXPECT_TRUE(iter->PreservesOrder());
+    ZETASQL_ASSIGN_OR_RETURN(std::vector<TupleData> data,
+                     ReadFromTupleIterator(iter.get()));
+    std::vector<std::string> output;
+    for (const TupleData& tuple : data) {
+      EXPECT_EQ(tuple.num_slots(), 3);
+      EXPECT_FALSE(tuple.slot(2).value().is_valid());
+      output.push_back(tuple.DebugString());
+    }
+    return output;
+  };
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(const std::vector<std::string> expected,
+                       evaluate(EvaluationOptions()));
+  ASSERT_EQ(expected.size(), 1000);
+
+  // Without a spill directory, the memory limit is an error.
+  EvaluationOptions options = GetIntermediateMemoryEvaluationOptions(
+      /*total_bytes=*/20000);
+  EXPECT_THAT(evaluate(options),
+              StatusIs(absl::StatusCode::kResourceExhausted,
+                       HasSubstr("Out of memory")));
+
+  // With one, the tuples are sorted in several runs and merged.
+  options.spill_directory = ::testing::TempDir();
+  EXPECT_THAT(evaluate(options), IsOkAndHolds(ElementsAreArray(expected)));
+
+  // A single tuple that does not fit is still an error.
+  options.max_intermediate_byte_size = 1;
+  EXPECT_THAT(evaluate(options),
+              StatusIs(absl::StatusCode::kResourceExhausted,
+                       HasSubstr("Out of memory")));
+}
+
+TEST_F(CreateIteratorTest, SortOpSortsInParallel) {
+  VariableId a("a"), b("b"), k("k"), v("v");
+
+  // Enough tuples for several chunks, with few distinct keys, so that the
+  // order of equal keys is observable.
+  std::vector<std::vector<Value>> input_values;
+  for (int64_t i = 0; i < 10000; ++i) {
+    input_values.push_back({Int64((i * 7919) % 101), Int64(i)});
+  }
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_a, DerefExpr::Create(a, Int64Type()));
+  std::vector<std::unique_ptr<KeyArg>> keys;
+  keys.push_back(
+      std::make_unique<KeyArg>(k, std::move(deref_a), KeyArg::kDescending));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_b, DerefExpr::Create(b, Int64Type()));
+  std::vector<std::unique_ptr<ExprArg>> values;
+  values.push_back(std::make_unique<ExprArg>(v, std::move(deref_b)));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto sort_op,
+      SortOp::Create(std::move(keys), std::move(values),
+                     /*limit=*/nullptr, /*offset=*/nullptr,
+                     absl::WrapUnique(new TestRelationalOp(
+                         {a, b}, CreateTestTupleDatas(input_values),
+                         /*preserves_order=*/true)),
+                     /*is_order_preserving=*/true,
+                     /*is_stable_sort=*/true));
+  ZETASQL_ASSERT_OK(sort_op->SetSchemasForEvaluation(EmptyParamsSchemas()));
+
+  auto evaluate = [&sort_op](int num_threads)
+      -> absl::StatusOr<std::vector<std::string>> {
+    EvaluationOptions options;
+    options.num_threads = num_threads;
+    EvaluationContext context(options);
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<TupleIterator> iter,
+                     sort_op->CreateIterator(EmptyParams(),
+                                             /*num_extra_slots=*/0, &context));
+    ZETASQL_ASSIGN_OR_RETURN(std::vector<TupleData> data,
+                     ReadFromTupleIterator(iter.get()));
+    std::vector<std::string> output;
+    for (const TupleData& tuple : data) {
+      output.push_back(tuple.DebugString());
+    }
+    return output;
+  };
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(const std::vector<std::string> expected,
+                       evaluate(/*num_threads=*/1));
+  ASSERT_EQ(expected.size(), 10000);
+  // The sort is stable regardless of the number of threads, including ones
+  // that do not divide the chunks into pairs evenly.
+  EXPECT_THAT(evaluate(/*num_threads=*/4),
+              IsOkAndHolds(ElementsAreArray(expected)));
+  EXPECT_THAT(evaluate(/*num_threads=*/3),
+              IsOkAndHolds(ElementsAreArray(expected)));
+}
+
+TEST_F(CreateIteratorTest, SortOpNormalizedSortKeys) {
+  VariableId a("a"), b("b"), c("c"), k1("k1"), k2("k2"), v("v");
+
+  // The keys are encoded into byte strings, so this covers the cases where
+  // the encoding has to match Value comparisons: NULL, NaN, the two zeros,
+  // and strings that are prefixes of each other or contain NUL bytes.
+  const std::vector<std::vector<Value>> input_values = {
+      {Double(1), String("a"), Int64(0)},
+      {Double(std::numeric_limits<double>::quiet_NaN()), String("b"),
+       Int64(1)},
+      {Double(-0.0), String("x"), Int64(2)},
+      {Double(0.0), String("y"), Int64(3)},
+      {NullDouble(), String("z"), Int64(4)},
+      {Double(-std::numeric_limits<double>::infinity()), String("q"),
+       Int64(5)},
+      {Double(1), String(std::string("a\0", 2)), Int64(6)},
+      {Double(1), String("ab"), Int64(7)},
+      {Double(-2.5), String("c"), Int64(8)}};
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_a, DerefExpr::Create(a, DoubleType()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_b, DerefExpr::Create(b, StringType()));
+  std::vector<std::unique_ptr<KeyArg>> keys;
+  keys.push_back(
+      std::make_unique<KeyArg>(k1, std::move(deref_a), KeyArg::kAscending));
+  keys.push_back(
+      std::make_unique<KeyArg>(k2, std::move(deref_b), KeyArg::kDescending));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_c, DerefExpr::Create(c, Int64Type()));
+  std::vector<std::unique_ptr<ExprArg>> values;
+  values.push_back(std::make_unique<ExprArg>(v, std::move(deref_c)));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto sort_op,
+      SortOp::Create(std::move(keys), std::move(values),
+                     /*limit=*/nullptr, /*offset=*/nullptr,
+                     absl::WrapUnique(new TestRelationalOp(
+                         {a, b, c}, CreateTestTupleDatas(input_values),
+                         /*preserves_order=*/true)),
+                     /*is_order_preserving=*/true,
+                     /*is_stable_sort=*/true));
+  ZETASQL_ASSERT_OK(sort_op->SetSchemasForEvaluation(EmptyParamsSchemas()));
+
+  EvaluationContext context((EvaluationOptions()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<TupleIterator> iter,
+      sort_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/0, &context));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::vector<TupleData> data,
+                       ReadFromTupleIterator(iter.get()));
+  std::vector<int64_t> output;
+  for (const TupleData& tuple : data) {
+    output.push_back(tuple.slot(2).value().int64_value());
+  }
+  EXPECT_THAT(output, ElementsAre(4, 1, 5, 8, 3, 2, 7, 6, 0));
+}
+
 TEST_F(CreateIteratorTest, SortOpTotalOrderWithLimitAndOffset) {
   VariableId a("a"), b("b"), c("c"), param("param"), k("k"), v1("v1"), v2("v2"),
       v3("v3"), limit("limit"), offset("offset");
@@ -3245,6 +4320,136 @@ TEST_F(CreateIteratorTest, SortOpTotalOrderWithLimitAndOffset) {
                        HasSubstr("Out of memory")));
 }
 
+TEST_F(CreateIteratorTest, SortOpWithLimitAndOffsetManyRows) {
+  VariableId a("a"), b("b"), k("k"), v("v");
+
+  // Keys repeat, so rows with equal keys compete for the last output slots.
+  std::vector<std::vector<Value>> input_values;
+  for (int64_t i = 0; i < 100; ++i) {
+    input_values.push_back({Int64(i % 3), Int64(i)});
+  }
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_a, DerefExpr::Create(a, Int64Type()));
+  std::vector<std::unique_ptr<KeyArg>> keys;
+  keys.push_back(
+      std::make_unique<KeyArg>(k, std::move(deref_a), KeyArg::kAscending));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_b, DerefExpr::Create(b, Int64Type()));
+  std::vector<std::unique_ptr<ExprArg>> values;
+  values.push_back(std::make_unique<ExprArg>(v, std::move(deref_b)));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto limit_expr, ConstExpr::Create(Int64(5)));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto offset_expr, ConstExpr::Create(Int64(2)));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto sort_op,
+      SortOp::Create(std::move(keys), std::move(values), std::move(limit_expr),
+                     std::move(offset_expr),
+                     absl::WrapUnique(new TestRelationalOp(
+                         {a, b}, CreateTestTupleDatas(input_values),
+                         /*preserves_order=*/true)),
+                     /*is_order_preserving=*/true,
+                     /*is_stable_sort=*/false));
+  ZETASQL_ASSERT_OK(sort_op->SetSchemasForEvaluation(EmptyParamsSchemas()));
+
+  // Memory for the top 7 rows is enough, no matter how many rows there are.
+  EvaluationContext context(GetIntermediateMemoryEvaluationOptions(
+      /*total_bytes=*/7 * 1000));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<TupleIterator> iter,
+      sort_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/0, &context));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::vector<TupleData> data,
+                       ReadFromTupleIterator(iter.get()));
+  // The first seven rows with key 0 are 0, 3, ..., 18, in input order.
+  std::vector<Value> output_values;
+  for (const TupleData& tuple : data) {
+    EXPECT_EQ(tuple.slot(0).value(), Int64(0));
+    output_values.push_back(tuple.slot(1).value());
+  }
+  EXPECT_THAT(output_values,
+              ElementsAre(Int64(6), Int64(9), Int64(12), Int64(15), Int64(18)));
+}
+
+TEST_F(CreateIteratorTest, SortOpInputIsSorted) {
+  VariableId a("a"), b("b"), k1("k1"), v1("v1"), k2("k2"), v2("v2");
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_a, DerefExpr::Create(a, Int64Type()));
+  std::vector<std::unique_ptr<KeyArg>> inner_keys;
+  inner_keys.push_back(
+      std::make_unique<KeyArg>(k1, std::move(deref_a), KeyArg::kAscending));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_b, DerefExpr::Create(b, Int64Type()));
+  std::vector<std::unique_ptr<ExprArg>> inner_values;
+  inner_values.push_back(std::make_unique<ExprArg>(v1, std::move(deref_b)));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto inner_sort_op,
+      SortOp::Create(std::move(inner_keys), std::move(inner_values),
+                     /*limit=*/nullptr, /*offset=*/nullptr,
+                     absl::WrapUnique(new TestRelationalOp(
+                         {a, b},
+                         CreateTestTupleDatas({{Int64(3), Int64(30)},
+                                               {NullInt64(), Int64(0)},
+                                               {Int64(1), Int64(10)},
+                                               {Int64(2), Int64(20)}}),
+                         /*preserves_order=*/true)),
+                     /*is_order_preserving=*/true,
+                     /*is_stable_sort=*/false));
+  EXPECT_EQ(inner_sort_op->DeriveProperties().DebugString(),
+            "ordering: [$k1 ASC NULLS FIRST]");
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_k1, DerefExpr::Create(k1, Int64Type()));
+  std::vector<std::unique_ptr<KeyArg>> keys;
+  keys.push_back(
+      std::make_unique<KeyArg>(k2, std::move(deref_k1), KeyArg::kAscending));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto deref_v1, DerefExpr::Create(v1, Int64Type()));
+  std::vector<std::unique_ptr<ExprArg>> values;
+  values.push_back(std::make_unique<ExprArg>(v2, std::move(deref_v1)));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto limit_expr, ConstExpr::Create(Int64(2)));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto offset_expr, ConstExpr::Create(Int64(1)));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto sort_op,
+      SortOp::Create(std::move(keys), std::move(values), std::move(limit_expr),
+                     std::move(offset_expr), std::move(inner_sort_op),
+                     /*is_order_preserving=*/true,
+                     /*is_stable_sort=*/false));
+  sort_op->set_input_is_sorted(true);
+  EXPECT_EQ(sort_op->DebugString(),
+            "SortOp(ordered, input_is_sorted\n"
+            "+-keys: {\n"
+            "| +-$k2 := $k1},\n"
+            "+-values: {\n"
+            "| +-$v2 := $v1},\n"
+            "+-limit: ConstExpr(2),\n"
+            "+-offset: ConstExpr(1),\n"
+            "+-input: SortOp(ordered\n"
+            "  +-keys: {\n"
+            "  | +-$k1 := $a},\n"
+            "  +-values: {\n"
+            "  | +-$v1 := $b},\n"
+            "  +-input: TestRelationalOp))");
+  ZETASQL_ASSERT_OK(sort_op->SetSchemasForEvaluation(EmptyParamsSchemas()));
+
+  // The result is the same whether the input is streamed or, when orderings
+  // are scrambled, sorted again.
+  for (bool scramble : {false, true}) {
+    EvaluationOptions options;
+    options.scramble_undefined_orderings = scramble;
+    EvaluationContext context(options);
+    ZETASQL_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<TupleIterator> iter,
+        sort_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/1, &context));
+    EXPECT_TRUE(iter->PreservesOrder());
+    ZETASQL_ASSERT_OK_AND_ASSIGN(std::vector<TupleData> data,
+                         ReadFromTupleIterator(iter.get()));
+    ASSERT_EQ(data.size(), 2);
+    EXPECT_THAT(data[0].slots(),
+                ElementsAre(IsTupleSlotWith(Int64(1), IsNull()),
+                            IsTupleSlotWith(Int64(10), IsNull()), _));
+    EXPECT_THAT(data[1].slots(),
+                ElementsAre(IsTupleSlotWith(Int64(2), IsNull()),
+                            IsTupleSlotWith(Int64(20), IsNull()), _));
+  }
+}
+
 TEST_F(CreateIteratorTest, ArrayScanOp) {
   VariableId a("a"), p("p"), param("param");
 
@@ -3322,6 +4527,74 @@ TEST_F(CreateIteratorTest, ArrayScanOp) {
   EXPECT_FALSE(iter->PreservesOrder());
 }
 
+TEST_F(CreateIteratorTest, GenerateArrayScanOp) {
+  VariableId a("a"), p("p");
+  std::vector<std::unique_ptr<ValueExpr>> arguments;
+  for (int64_t argument : {1, 100000, 3}) {
+    ZETASQL_ASSERT_OK_AND_ASSIGN(arguments.emplace_back(),
+                         ConstExpr::Create(Int64(argument)));
+  }
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto scan_op,
+      GenerateArrayScanOp::Create(/*element=*/a, /*position=*/p,
+                                  types::Int64Type(), std::move(arguments)));
+  EXPECT_EQ(scan_op->IteratorDebugString(),
+            "GenerateArrayScanTupleIterator(<arguments>)");
+  EXPECT_EQ(
+      "GenerateArrayScanOp(\n"
+      "+-$a := element,\n"
+      "+-$p := position,\n"
+      "+-argument: ConstExpr(1)\n"
+      "+-argument: ConstExpr(100000)\n"
+      "+-argument: ConstExpr(3))",
+      scan_op->DebugString());
+  EXPECT_THAT(scan_op->CreateOutputSchema()->variables(), ElementsAre(a, p));
+
+  // More elements than GENERATE_ARRAY allows in an array.
+  EvaluationContext context((EvaluationOptions()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<TupleIterator> iter,
+      scan_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/0, &context));
+  EXPECT_EQ(iter->DebugString(),
+            "GenerateArrayScanTupleIterator(1, 100000, 3)");
+  EXPECT_TRUE(iter->PreservesOrder());
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::vector<TupleData> data,
+                       ReadFromTupleIterator(iter.get()));
+  ASSERT_EQ(data.size(), 33334);
+  EXPECT_EQ(Tuple(&iter->Schema(), &data[0]).DebugString(), "<a:1,p:0>");
+  EXPECT_EQ(Tuple(&iter->Schema(), &data.back()).DebugString(),
+            "<a:100000,p:33333>");
+
+  // A NULL argument produces no rows, and an invalid step is an error.
+  arguments.clear();
+  for (const Value& argument : {Date(10), NullDate()}) {
+    ZETASQL_ASSERT_OK_AND_ASSIGN(arguments.emplace_back(),
+                         ConstExpr::Create(argument));
+  }
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      scan_op, GenerateArrayScanOp::Create(/*element=*/a, VariableId(),
+                                           types::DateType(),
+                                           std::move(arguments)));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      iter,
+      scan_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/0, &context));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(data, ReadFromTupleIterator(iter.get()));
+  EXPECT_TRUE(data.empty());
+
+  arguments.clear();
+  for (int64_t argument : {1, 10, 0}) {
+    ZETASQL_ASSERT_OK_AND_ASSIGN(arguments.emplace_back(),
+                         ConstExpr::Create(Int64(argument)));
+  }
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      scan_op, GenerateArrayScanOp::Create(/*element=*/a, VariableId(),
+                                           types::Int64Type(),
+                                           std::move(arguments)));
+  EXPECT_THAT(
+      scan_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/0, &context),
+      StatusIs(absl::StatusCode::kOutOfRange, HasSubstr("step cannot be 0")));
+}
+
 TEST_F(CreateIteratorTest, ArrayScanOpNonDeterministic) {
   VariableId a("a"), p("p");
   ZETASQL_ASSERT_OK_AND_ASSIGN(
@@ -3468,6 +4741,47 @@ TEST_F(CreateIteratorTest, ArrayScanOpMultiwayUnnest) {
   EXPECT_TRUE(context2.IsDeterministicOutput());
 }
 
+TEST_F(CreateIteratorTest, ArrayScanOpMultiwayUnnestNextBatch) {
+  VariableId arr1("arr1"), arr2("arr2"), p("p");
+  std::vector<Value> elements1, elements2;
+  for (int64_t i = 0; i < 1000; ++i) {
+    elements1.push_back(Int64(i));
+    if (i < 600) elements2.push_back(String(absl::StrCat("s", i)));
+  }
+  std::vector<std::unique_ptr<ValueExpr>> arrays;
+  arrays.push_back(
+      ConstExpr::Create(Array(elements1, kPreservesOrder)).value());
+  arrays.push_back(
+      ConstExpr::Create(Array(elements2, kPreservesOrder)).value());
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto mode_expr, ConstExpr::Create(Value::Enum(
+                                           types::ArrayZipModeEnumType(),
+                                           functions::ArrayZipEnums::PAD)));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto scan_op,
+      ArrayScanOp::Create(/*elements=*/{arr1, arr2}, /*position=*/p,
+                          /*arrays=*/std::move(arrays),
+                          /*zip_mode_expr=*/std::move(mode_expr)));
+
+  EvaluationContext context((EvaluationOptions()));
+  for (int batch_size : {1, 7, 256}) {
+    ZETASQL_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<TupleIterator> iter,
+        scan_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/1,
+                                &context));
+    ZETASQL_ASSERT_OK_AND_ASSIGN(std::vector<TupleData> data,
+                         ReadFromTupleIteratorInBatches(iter.get(), batch_size));
+    ASSERT_EQ(data.size(), elements1.size());
+    for (int64_t i = 0; i < data.size(); ++i) {
+      EXPECT_EQ(data[i].num_slots(), 4);
+      EXPECT_EQ(data[i].slot(0).value(), elements1[i]);
+      EXPECT_EQ(data[i].slot(1).value(),
+                i < elements2.size() ? elements2[i] : NullString());
+      EXPECT_EQ(data[i].slot(2).value(), Int64(i));
+    }
+  }
+  EXPECT_TRUE(context.IsDeterministicOutput());
+}
+
 static std::unique_ptr<ValueExpr> DivByZeroErrorExpr() {
   std::vector<std::unique_ptr<ValueExpr>> div_args;
   div_args.push_back(ConstExpr::Create(Int64(1)).value());
@@ -3819,6 +5133,19 @@ TEST_F(CreateIteratorTest, UnionAllOp) {
                                           HasRawPointer(shared_states[3][1])),
                           _));
 
+  // Read the same rows in batches that do not line up with the inputs.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(iter, union_all_op->CreateIterator(EmptyParams(),
+                                                          /*num_extra_slots=*/1,
+                                                          &context));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(data, ReadFromTupleIteratorInBatches(
+                                 iter.get(), /*batch_size=*/3));
+  ASSERT_EQ(data.size(), 4);
+  for (int i = 0; i < data.size(); ++i) {
+    EXPECT_THAT(data[i].slots(),
+                ElementsAre(IsTupleSlotWith(Int64(i + 1), IsNull()),
+                            IsTupleSlotWith(GetProtoValue(i + 1), _), _));
+  }
+
   // Check that scrambling works.
   EvaluationContext scramble_context(GetScramblingEvaluationOptions());
   ZETASQL_ASSERT_OK_AND_ASSIGN(iter, union_all_op->CreateIterator(EmptyParams(),
@@ -4191,6 +5518,20 @@ TEST_F(CreateIteratorTest, FilterOp) {
               ElementsAre(IsTupleSlotWith(Int64(2), IsNull()),
                           IsTupleSlotWith(Int64(20), IsNull()), _));
 
+  // Read the same rows in batches. The first input batch has only one match.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(iter, filter_op->CreateIterator(
+                                 {&params_data}, /*num_extra_slots=*/1,
+                                 &context));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(data, ReadFromTupleIteratorInBatches(
+                                 iter.get(), /*batch_size=*/2));
+  ASSERT_EQ(data.size(), 2);
+  EXPECT_THAT(data[0].slots(),
+              ElementsAre(IsTupleSlotWith(Int64(1), IsNull()),
+                          IsTupleSlotWith(Int64(10), IsNull()), _));
+  EXPECT_THAT(data[1].slots(),
+              ElementsAre(IsTupleSlotWith(Int64(2), IsNull()),
+                          IsTupleSlotWith(Int64(20), IsNull()), _));
+
   // Check that scrambling works.
   EvaluationContext scramble_context(GetScramblingEvaluationOptions());
   ZETASQL_ASSERT_OK_AND_ASSIGN(
@@ -4201,6 +5542,190 @@ TEST_F(CreateIteratorTest, FilterOp) {
   EXPECT_FALSE(iter->PreservesOrder());
 }
 
+// Returns a call of the builtin 'kind' on 'x' and 'y'.
+static std::unique_ptr<ScalarFunctionCallExpr> BinaryCall(
+    FunctionKind kind, const Type* output_type, std::unique_ptr<ValueExpr> x,
+    std::unique_ptr<ValueExpr> y) {
+  std::vector<std::unique_ptr<ValueExpr>> args;
+  args.push_back(std::move(x));
+  args.push_back(std::move(y));
+  return ScalarFunctionCallExpr::Create(CreateFunction(kind, output_type),
+                                        std::move(args), DEFAULT_ERROR_MODE)
+      .value();
+}
+
+// ComputeOp and FilterOp evaluate calls that support it column-wise when read
+// in batches. The results must not depend on how the rows are read.
+TEST_F(CreateIteratorTest, ComputeOpAndFilterOpEvalBatch) {
+  VariableId a("a"), b("b"), sum("sum"), small("small");
+  std::vector<std::vector<Value>> rows;
+  for (int64_t i = 0; i < 100; ++i) {
+    rows.push_back({i % 7 == 0 ? NullInt64() : Int64(i), Int64(2 * i)});
+  }
+  const std::vector<TupleData> test_values = CreateTestTupleDatas(rows);
+
+  // $sum := Add($a, $b), $small := Less($sum, 150), then filter on
+  // Less(Add($a, $b), $sum + 1) which is TRUE exactly when $sum is not NULL.
+  std::vector<std::unique_ptr<ExprArg>> map;
+  std::unique_ptr<ScalarFunctionCallExpr> sum_expr =
+      BinaryCall(FunctionKind::kAdd, Int64Type(),
+                 DerefExpr::Create(a, Int64Type()).value(),
+                 DerefExpr::Create(b, Int64Type()).value());
+  const ScalarFunctionCallExpr* sum_call = sum_expr.get();
+  map.push_back(std::make_unique<ExprArg>(sum, std::move(sum_expr)));
+  std::unique_ptr<ScalarFunctionCallExpr> small_expr =
+      BinaryCall(FunctionKind::kLess, BoolType(),
+                 DerefExpr::Create(sum, Int64Type()).value(),
+                 ConstExpr::Create(Int64(150)).value());
+  const ScalarFunctionCallExpr* small_call = small_expr.get();
+  map.push_back(std::make_unique<ExprArg>(small, std::move(small_expr)));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto compute_op,
+      ComputeOp::Create(std::move(map),
+                        absl::WrapUnique(new TestRelationalOp(
+                            {a, b}, test_values, /*preserves_order=*/true))));
+
+  std::unique_ptr<ScalarFunctionCallExpr> predicate = BinaryCall(
+      FunctionKind::kLess, BoolType(),
+      BinaryCall(FunctionKind::kAdd, Int64Type(),
+                 DerefExpr::Create(a, Int64Type()).value(),
+                 DerefExpr::Create(b, Int64Type()).value()),
+      BinaryCall(FunctionKind::kAdd, Int64Type(),
+                 DerefExpr::Create(sum, Int64Type()).value(),
+                 ConstExpr::Create(Int64(1)).value()));
+  const ScalarFunctionCallExpr* predicate_call = predicate.get();
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto filter_op,
+      FilterOp::Create(std::move(predicate), std::move(compute_op)));
+  ZETASQL_ASSERT_OK(filter_op->SetSchemasForEvaluation(EmptyParamsSchemas()));
+  EXPECT_TRUE(sum_call->SupportsEvalBatch());
+  EXPECT_TRUE(small_call->SupportsEvalBatch());
+  EXPECT_TRUE(predicate_call->SupportsEvalBatch());
+
+  EvaluationContext context((EvaluationOptions()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<TupleIterator> iter,
+      filter_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/0,
+                                &context));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(const std::vector<TupleData> expected,
+                       ReadFromTupleIterator(iter.get()));
+  ASSERT_EQ(expected.size(), 85);
+  for (const TupleData& data : expected) {
+    const int64_t i = data.slot(0).value().int64_value();
+    EXPECT_EQ(data.slot(2).value(), Int64(3 * i));
+    EXPECT_EQ(data.slot(3).value(), Bool(3 * i < 150));
+  }
+
+  for (int batch_size : {1, 6, 256}) {
+    ZETASQL_ASSERT_OK_AND_ASSIGN(
+        iter, filter_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/0,
+                                        &context));
+    ZETASQL_ASSERT_OK_AND_ASSIGN(std::vector<TupleData> data,
+                         ReadFromTupleIteratorInBatches(iter.get(), batch_size));
+    ASSERT_EQ(data.size(), expected.size());
+    for (int i = 0; i < data.size(); ++i) {
+      for (int j = 0; j < 4; ++j) {
+        EXPECT_EQ(data[i].slot(j).value(), expected[i].slot(j).value())
+            << "batch_size " << batch_size << " row " << i << " slot " << j;
+      }
+    }
+  }
+}
+
+// Covers the logical and IS kernels, whose NULL handling differs from that of
+// the other functions, through FilterOp.
+TEST_F(CreateIteratorTest, FilterOpEvalBatchLogicalAndIs) {
+  VariableId a("a"), b("b");
+  std::vector<std::vector<Value>> rows;
+  for (const Value& x : {Bool(true), Bool(false), NullBool()}) {
+    for (const Value& y : {Bool(true), Bool(false), NullBool()}) {
+      rows.push_back({x, y});
+    }
+  }
+  const std::vector<TupleData> test_values = CreateTestTupleDatas(rows);
+
+  // (NOT $a) OR ($b IS NULL) OR ($a AND $b)
+  std::vector<std::unique_ptr<ValueExpr>> not_args;
+  not_args.push_back(DerefExpr::Create(a, BoolType()).value());
+  std::vector<std::unique_ptr<ValueExpr>> is_null_args;
+  is_null_args.push_back(DerefExpr::Create(b, BoolType()).value());
+  std::vector<std::unique_ptr<ValueExpr>> or_args;
+  or_args.push_back(
+      ScalarFunctionCallExpr::Create(
+          CreateFunction(FunctionKind::kNot, BoolType()), std::move(not_args),
+          DEFAULT_ERROR_MODE)
+          .value());
+  or_args.push_back(ScalarFunctionCallExpr::Create(
+                        CreateFunction(FunctionKind::kIsNull, BoolType()),
+                        std::move(is_null_args), DEFAULT_ERROR_MODE)
+                        .value());
+  or_args.push_back(BinaryCall(FunctionKind::kAnd, BoolType(),
+                               DerefExpr::Create(a, BoolType()).value(),
+                               DerefExpr::Create(b, BoolType()).value()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<ScalarFunctionCallExpr> predicate,
+                       ScalarFunctionCallExpr::Create(
+                           CreateFunction(FunctionKind::kOr, BoolType()),
+                           std::move(or_args), DEFAULT_ERROR_MODE));
+  const ScalarFunctionCallExpr* predicate_call = predicate.get();
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto filter_op,
+      FilterOp::Create(std::move(predicate),
+                       absl::WrapUnique(new TestRelationalOp(
+                           {a, b}, test_values, /*preserves_order=*/true))));
+  ZETASQL_ASSERT_OK(filter_op->SetSchemasForEvaluation(EmptyParamsSchemas()));
+  EXPECT_TRUE(predicate_call->SupportsEvalBatch());
+
+  EvaluationContext context((EvaluationOptions()));
+  for (int batch_size : {1, 4, 9}) {
+    ZETASQL_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<TupleIterator> iter,
+        filter_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/0,
+                                  &context));
+    ZETASQL_ASSERT_OK_AND_ASSIGN(std::vector<TupleData> data,
+                         ReadFromTupleIteratorInBatches(iter.get(), batch_size));
+    std::vector<std::vector<Value>> values;
+    for (const TupleData& row : data) {
+      values.push_back({row.slot(0).value(), row.slot(1).value()});
+    }
+    EXPECT_THAT(values,
+                ElementsAre(ElementsAre(Bool(true), Bool(true)),
+                            ElementsAre(Bool(true), NullBool()),
+                            ElementsAre(Bool(false), Bool(true)),
+                            ElementsAre(Bool(false), Bool(false)),
+                            ElementsAre(Bool(false), NullBool()),
+                            ElementsAre(NullBool(), NullBool())))
+        << "batch_size " << batch_size;
+  }
+}
+
+// Errors from column-wise evaluation are reported like row-wise ones.
+TEST_F(CreateIteratorTest, ComputeOpEvalBatchError) {
+  VariableId a("a"), b("b"), sum("sum");
+  const std::vector<TupleData> test_values = CreateTestTupleDatas(
+      {{Int64(1), Int64(2)},
+       {Int64(std::numeric_limits<int64_t>::max()), Int64(1)}});
+  std::vector<std::unique_ptr<ExprArg>> map;
+  map.push_back(std::make_unique<ExprArg>(
+      sum, BinaryCall(FunctionKind::kAdd, Int64Type(),
+                      DerefExpr::Create(a, Int64Type()).value(),
+                      DerefExpr::Create(b, Int64Type()).value())));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto compute_op,
+      ComputeOp::Create(std::move(map),
+                        absl::WrapUnique(new TestRelationalOp(
+                            {a, b}, test_values, /*preserves_order=*/true))));
+  ZETASQL_ASSERT_OK(compute_op->SetSchemasForEvaluation(EmptyParamsSchemas()));
+
+  EvaluationContext context((EvaluationOptions()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<TupleIterator> iter,
+      compute_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/0,
+                                 &context));
+  EXPECT_THAT(ReadFromTupleIteratorInBatches(iter.get(), /*batch_size=*/2),
+              StatusIs(absl::StatusCode::kOutOfRange,
+                       HasSubstr("int64 overflow")));
+}
+
 TEST_F(CreateIteratorTest, LimitOp_OrderedInput) {
   VariableId a("a"), b("b"), row_count("row_count"), offset("offset");
   const std::vector<TupleData> test_values =
@@ -4363,6 +5888,102 @@ TEST_F(CreateIteratorTest, LimitOp_OrderedInput) {
   EXPECT_TRUE(scramble_context.IsDeterministicOutput());
 }
 
+TEST_F(CreateIteratorTest, LimitOp_NextBatch) {
+  VariableId a("a");
+  std::vector<std::vector<Value>> values;
+  for (int i = 0; i < 7; ++i) {
+    values.push_back({Int64(i)});
+  }
+  const std::vector<TupleData> test_values = CreateTestTupleDatas(values);
+
+  // Compares reading with Next() and NextBatch() for every combination of
+  // limit, offset and batch size that straddles the input boundaries.
+  EvaluationContext context((EvaluationOptions()));
+  for (int64_t limit = 0; limit <= 8; ++limit) {
+    for (int64_t offset = 0; offset <= 8; ++offset) {
+      for (int batch_size = 1; batch_size <= 4; ++batch_size) {
+        ZETASQL_ASSERT_OK_AND_ASSIGN(auto row_count, ConstExpr::Create(Int64(limit)));
+        ZETASQL_ASSERT_OK_AND_ASSIGN(auto offset_expr,
+                             ConstExpr::Create(Int64(offset)));
+        ZETASQL_ASSERT_OK_AND_ASSIGN(
+            auto limit_op,
+            LimitOp::Create(std::move(row_count), std::move(offset_expr),
+                            absl::WrapUnique(new TestRelationalOp(
+                                {a}, test_values, /*preserves_order=*/true)),
+                            /*is_order_preserving=*/true));
+        ZETASQL_ASSERT_OK(limit_op->SetSchemasForEvaluation(EmptyParamsSchemas()));
+
+        ZETASQL_ASSERT_OK_AND_ASSIGN(
+            std::unique_ptr<TupleIterator> iter,
+            limit_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/1,
+                                     &context));
+        ZETASQL_ASSERT_OK_AND_ASSIGN(std::vector<TupleData> expected,
+                             ReadFromTupleIterator(iter.get()));
+
+        ZETASQL_ASSERT_OK_AND_ASSIGN(
+            iter, limit_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/1,
+                                           &context));
+        ZETASQL_ASSERT_OK_AND_ASSIGN(
+            std::vector<TupleData> actual,
+            ReadFromTupleIteratorInBatches(iter.get(), batch_size));
+        ASSERT_EQ(actual.size(), expected.size())
+            << "limit " << limit << " offset " << offset << " batch size "
+            << batch_size;
+        for (int i = 0; i < actual.size(); ++i) {
+          EXPECT_EQ(actual[i].num_slots(), 2);
+          EXPECT_EQ(actual[i].slot(0).value(), expected[i].slot(0).value());
+        }
+      }
+    }
+  }
+}
+
+TEST_F(CreateIteratorTest, LimitOpCancelsTableScan) {
+  int64_t num_cancel_calls = 0;
+  const std::function<void()> cancel_cb = [&num_cancel_calls]() {
+    ++num_cancel_calls;
+  };
+  EvaluatorTestTable table("TestTable", {{"column0", types::Int64Type()}},
+                           {{Int64(10)}, {Int64(20)}, {Int64(30)}},
+                           absl::OkStatus(), /*column_filter_idxs=*/{},
+                           cancel_cb);
+
+  // Returns the number of tuples read through a LIMIT of 'limit'.
+  auto read_with_limit = [&table](int64_t limit) -> absl::StatusOr<int> {
+    ZETASQL_ASSIGN_OR_RETURN(
+        auto scan_op, EvaluatorTableScanOp::Create(
+                          &table, /*alias=*/"", {0}, {"column0"},
+                          {VariableId("x")}, /*and_filters=*/{},
+                          /*read_time=*/nullptr));
+    ZETASQL_ASSIGN_OR_RETURN(auto row_count, ConstExpr::Create(Int64(limit)));
+    ZETASQL_ASSIGN_OR_RETURN(auto offset, ConstExpr::Create(Int64(0)));
+    ZETASQL_ASSIGN_OR_RETURN(auto limit_op,
+                     LimitOp::Create(std::move(row_count), std::move(offset),
+                                     std::move(scan_op),
+                                     /*is_order_preserving=*/true));
+    ZETASQL_RETURN_IF_ERROR(
+        limit_op->SetSchemasForEvaluation(EmptyParamsSchemas()));
+
+    EvaluationContext context((EvaluationOptions()));
+    ZETASQL_ASSIGN_OR_RETURN(
+        std::unique_ptr<TupleIterator> iter,
+        limit_op->CreateIterator(EmptyParams(), /*num_extra_slots=*/0,
+                                 &context));
+    ZETASQL_ASSIGN_OR_RETURN(std::vector<TupleData> data,
+                     ReadFromTupleIterator(iter.get()));
+    return static_cast<int>(data.size());
+  };
+
+  // Reaching the limit before the end of the table cancels the table scan.
+  EXPECT_THAT(read_with_limit(2), IsOkAndHolds(2));
+  EXPECT_EQ(num_cancel_calls, 1);
+
+  // Reading the whole table does not.
+  num_cancel_calls = 0;
+  EXPECT_THAT(read_with_limit(5), IsOkAndHolds(3));
+  EXPECT_EQ(num_cancel_calls, 0);
+}
+
 TEST_F(CreateIteratorTest, LimitOp_UnorderedInput) {
   VariableId a("a"), b("b"), row_count("row_count"), offset("offset");
   const std::vector<TupleData> test_values =
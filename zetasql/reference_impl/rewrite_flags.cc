@@ -21,6 +21,7 @@
 
 #include "zetasql/common/options_utils.h"
 #include "zetasql/public/options.pb.h"
+#include "zetasql/reference_impl/common.h"
 #include "absl/container/btree_set.h"
 #include "absl/flags/flag.h"
 #include "absl/strings/str_cat.h"
@@ -32,27 +33,6 @@ static RewriteSet DefaultRewrites() {
   return RewriteSet(AnalyzerOptions().enabled_rewrites());
 }
 
-// Rewrites for constructs which the reference implementation is not able to
-// successfully execute using a direct implementation, and thus requires the
-// rewriter. These rewrites are enabled for the reference even when using the
-// reference impl as a baseline for compliance tests.
-absl::btree_set<ResolvedASTRewrite> MinimalRewritesForReference() {
-  return {
-      // Probably don't add to this list without a very good reason to do so.
-      // Features that are rewrite *only* without direct implementation support
-      // in the reference implementation are not as well tested as features with
-      // both implementations.
-      // clang-format off
-      // (broken link) start
-      REWRITE_INLINE_SQL_TVFS,
-      // TODO: Remove this after resolving memory leak in direct UDA eval.
-      REWRITE_INLINE_SQL_UDAS,
-      REWRITE_INLINE_SQL_VIEWS,
-      // (broken link) end
-      // clang-format on
-  };
-}
-
 static const RewriteSet& MinimalRewrites() {
   static const auto* minimal_rewrites =
       new RewriteSet({MinimalRewritesForReference()});
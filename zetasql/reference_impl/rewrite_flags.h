@@ -21,13 +21,12 @@
 
 #include "zetasql/public/analyzer_options.h"
 #include "zetasql/public/options.pb.h"
+#include "zetasql/reference_impl/common.h"
 #include "absl/container/btree_set.h"
 #include "absl/flags/declare.h"
 
 namespace zetasql {
 
-absl::btree_set<ResolvedASTRewrite> MinimalRewritesForReference();
-
 // Wrapper around a set of ResolvedASTRewrite to represent the value
 // of the 'rewrites' flag. It is necessary to allow AbslParseFlag() and
 // AbslUnparseFlag() to go in the zetasql namespace instead of the absl
@@ -0,0 +1,176 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/reference_impl/spill_file.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/public/value.pb.h"
+#include "zetasql/reference_impl/tuple.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "zetasql/base/path.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+namespace {
+
+// Precedes each slot in the file.
+enum SlotMarker : uint8_t {
+  kInvalidValue = 0,
+  kValidValue = 1,
+};
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<TupleSpillFile>> TupleSpillFile::Create(
+    absl::string_view directory) {
+  std::string path =
+      zetasql_base::JoinPath(directory, "zetasql_spill_XXXXXX");
+  const int fd = mkstemp(path.data());
+  if (fd < 0) {
+    return zetasql_base::InternalErrorBuilder()
+           << "Failed to create spill file " << path << ": "
+           << std::strerror(errno);
+  }
+  // Unlink the file right away so it never outlives this object.
+  unlink(path.c_str());
+  FILE* file = fdopen(fd, "w+b");
+  if (file == nullptr) {
+    const int error = errno;
+    close(fd);
+    return zetasql_base::InternalErrorBuilder()
+           << "Failed to open spill file " << path << ": "
+           << std::strerror(error);
+  }
+  return absl::WrapUnique(new TupleSpillFile(std::move(path), file));
+}
+
+TupleSpillFile::~TupleSpillFile() { fclose(file_); }
+
+absl::Status TupleSpillFile::WriteBytes(const void* data, size_t size) {
+  if (size > 0 && fwrite(data, 1, size, file_) != size) {
+    return zetasql_base::ResourceExhaustedErrorBuilder()
+           << "Failed to write " << size << " bytes to spill file " << path_
+           << ": " << std::strerror(errno);
+  }
+  num_bytes_ += size;
+  return absl::OkStatus();
+}
+
+absl::Status TupleSpillFile::ReadBytes(void* data, size_t size) {
+  if (size > 0 && fread(data, 1, size, file_) != size) {
+    return zetasql_base::InternalErrorBuilder()
+           << "Failed to read " << size << " bytes from spill file " << path_
+           << (feof(file_) ? ": unexpected end of file" : "");
+  }
+  return absl::OkStatus();
+}
+
+absl::Status TupleSpillFile::Write(const TupleData& tuple) {
+  ZETASQL_RET_CHECK(!finished_writing_);
+  if (num_slots_ < 0) {
+    num_slots_ = tuple.num_slots();
+    slot_types_.resize(num_slots_, nullptr);
+  }
+  ZETASQL_RET_CHECK_EQ(tuple.num_slots(), num_slots_);
+
+  for (int i = 0; i < num_slots_; ++i) {
+    const Value& value = tuple.slot(i).value();
+    if (!value.is_valid()) {
+      const uint8_t marker = kInvalidValue;
+      ZETASQL_RETURN_IF_ERROR(WriteBytes(&marker, sizeof(marker)));
+      continue;
+    }
+    if (slot_types_[i] == nullptr) {
+      slot_types_[i] = value.type();
+    } else {
+      ZETASQL_RET_CHECK(value.type()->Equals(slot_types_[i]))
+          << "Slot " << i << " of a spilled tuple has type "
+          << value.type()->DebugString() << " instead of "
+          << slot_types_[i]->DebugString();
+    }
+
+    ValueProto value_proto;
+    ZETASQL_RETURN_IF_ERROR(value.Serialize(&value_proto));
+    buffer_.clear();
+    ZETASQL_RET_CHECK(value_proto.SerializeToString(&buffer_));
+    const uint8_t marker = kValidValue;
+    const uint32_t size = static_cast<uint32_t>(buffer_.size());
+    ZETASQL_RETURN_IF_ERROR(WriteBytes(&marker, sizeof(marker)));
+    ZETASQL_RETURN_IF_ERROR(WriteBytes(&size, sizeof(size)));
+    ZETASQL_RETURN_IF_ERROR(WriteBytes(buffer_.data(), buffer_.size()));
+  }
+  ++num_tuples_;
+  return absl::OkStatus();
+}
+
+absl::Status TupleSpillFile::FinishWriting() {
+  ZETASQL_RET_CHECK(!finished_writing_);
+  finished_writing_ = true;
+  if (fflush(file_) != 0 || fseek(file_, 0, SEEK_SET) != 0) {
+    return zetasql_base::ResourceExhaustedErrorBuilder()
+           << "Failed to flush spill file " << path_ << ": "
+           << std::strerror(errno);
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<bool> TupleSpillFile::Read(TupleData* tuple) {
+  ZETASQL_RET_CHECK(finished_writing_);
+  if (num_tuples_read_ == num_tuples_) return false;
+
+  tuple->Clear();
+  tuple->AddSlots(num_slots_);
+  for (int i = 0; i < num_slots_; ++i) {
+    uint8_t marker;
+    ZETASQL_RETURN_IF_ERROR(ReadBytes(&marker, sizeof(marker)));
+    if (marker == kInvalidValue) continue;
+    ZETASQL_RET_CHECK_EQ(marker, kValidValue);
+    ZETASQL_RET_CHECK(slot_types_[i] != nullptr);
+
+    uint32_t size;
+    ZETASQL_RETURN_IF_ERROR(ReadBytes(&size, sizeof(size)));
+    buffer_.resize(size);
+    ZETASQL_RETURN_IF_ERROR(ReadBytes(buffer_.data(), size));
+    ValueProto value_proto;
+    ZETASQL_RET_CHECK(value_proto.ParseFromString(buffer_));
+    ZETASQL_ASSIGN_OR_RETURN(Value value,
+                     Value::Deserialize(value_proto, slot_types_[i]));
+    tuple->mutable_slot(i)->SetValue(std::move(value));
+  }
+  ++num_tuples_read_;
+  return true;
+}
+
+}  // namespace zetasql
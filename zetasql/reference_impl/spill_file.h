@@ -0,0 +1,103 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Temporary files used by operators of the reference implementation to move
+// intermediate tuples out of memory when they would exceed
+// EvaluationOptions::max_intermediate_byte_size (see
+// EvaluationOptions::spill_directory).
+
+#ifndef ZETASQL_REFERENCE_IMPL_SPILL_FILE_H_
+#define ZETASQL_REFERENCE_IMPL_SPILL_FILE_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/type.h"
+#include "zetasql/reference_impl/tuple.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace zetasql {
+
+// A sequence of TupleDatas stored in an anonymous temporary file. Tuples are
+// first written with Write(), then FinishWriting() is called, and then they
+// are read back in the same order with Read().
+//
+// Only the slot Values are stored; TupleSlot::SharedProtoState is not. Every
+// tuple must have the same number of slots, and the valid Values of a given
+// slot must all have the same type. Invalid Values (e.g., unset extra slots)
+// round-trip as invalid Values.
+class TupleSpillFile {
+ public:
+  // Creates an empty file in 'directory'. The file is unlinked as soon as it
+  // is opened, so the operating system reclaims its space when this object is
+  // destroyed, even if the process crashes.
+  static absl::StatusOr<std::unique_ptr<TupleSpillFile>> Create(
+      absl::string_view directory);
+
+  TupleSpillFile(const TupleSpillFile&) = delete;
+  TupleSpillFile& operator=(const TupleSpillFile&) = delete;
+
+  ~TupleSpillFile();
+
+  // Appends 'tuple' to the file. Must not be called after FinishWriting(). On
+  // failure, the file is left in an unspecified state and must not be read.
+  absl::Status Write(const TupleData& tuple);
+
+  // Flushes the written tuples and prepares the file for reading.
+  absl::Status FinishWriting();
+
+  // Reads the next tuple into 'tuple'. Returns false if there are no more
+  // tuples. Must be called after FinishWriting().
+  absl::StatusOr<bool> Read(TupleData* tuple);
+
+  // The number of tuples written to the file.
+  int64_t num_tuples() const { return num_tuples_; }
+
+  // The number of bytes written to the file.
+  int64_t num_bytes() const { return num_bytes_; }
+
+ private:
+  TupleSpillFile(std::string path, FILE* file)
+      : path_(std::move(path)), file_(file) {}
+
+  absl::Status WriteBytes(const void* data, size_t size);
+  absl::Status ReadBytes(void* data, size_t size);
+
+  // For error messages only; the file is already unlinked.
+  const std::string path_;
+  FILE* file_;
+  bool finished_writing_ = false;
+  int64_t num_tuples_ = 0;
+  int64_t num_bytes_ = 0;
+  int64_t num_tuples_read_ = 0;
+
+  // The number of slots of each tuple, or -1 if nothing has been written yet.
+  int num_slots_ = -1;
+  // The type of the valid Values of each slot. NULL if that slot has not had a
+  // valid Value yet.
+  std::vector<const Type*> slot_types_;
+  // Scratch space for (de)serialization.
+  std::string buffer_;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_REFERENCE_IMPL_SPILL_FILE_H_
@@ -0,0 +1,103 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/reference_impl/spill_file.h"
+
+#include <memory>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/types/type_factory.h"
+#include "zetasql/public/value.h"
+#include "zetasql/reference_impl/tuple.h"
+#include "zetasql/reference_impl/tuple_test_util.h"
+#include "zetasql/testing/test_value.h"
+#include "zetasql/testing/using_test_value.cc"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+
+namespace zetasql {
+namespace {
+
+using ::testing::HasSubstr;
+using ::zetasql_base::testing::IsOkAndHolds;
+using ::zetasql_base::testing::StatusIs;
+
+TEST(TupleSpillFileTest, RoundTrip) {
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<TupleSpillFile> file,
+                       TupleSpillFile::Create(::testing::TempDir()));
+
+  const Value array = Array({Int64(1), NullInt64()});
+  std::vector<TupleData> tuples = {
+      CreateTestTupleData({Int64(1), String("foo"), array, Double(1.5)}),
+      CreateTestTupleData({NullInt64(), String(""), Value::Null(array.type()),
+                           NullDouble()}),
+      CreateTestTupleData({Int64(3), String("bar"), array, Double(-0.0)}),
+  };
+  // Leave an unset extra slot in each tuple.
+  for (TupleData& tuple : tuples) {
+    tuple.AddSlots(1);
+    ZETASQL_ASSERT_OK(file->Write(tuple));
+  }
+  EXPECT_EQ(file->num_tuples(), 3);
+  EXPECT_GT(file->num_bytes(), 0);
+  ZETASQL_ASSERT_OK(file->FinishWriting());
+  EXPECT_THAT(file->Write(tuples[0]), StatusIs(absl::StatusCode::kInternal));
+
+  TupleData tuple;
+  for (const TupleData& expected : tuples) {
+    ASSERT_THAT(file->Read(&tuple), IsOkAndHolds(true));
+    ASSERT_EQ(tuple.num_slots(), expected.num_slots());
+    for (int i = 0; i < tuple.num_slots() - 1; ++i) {
+      EXPECT_EQ(tuple.slot(i).value(), expected.slot(i).value()) << i;
+      EXPECT_TRUE(
+          tuple.slot(i).value().type()->Equals(expected.slot(i).value().type()))
+          << i;
+    }
+    EXPECT_FALSE(tuple.slot(tuple.num_slots() - 1).value().is_valid());
+  }
+  EXPECT_THAT(file->Read(&tuple), IsOkAndHolds(false));
+}
+
+TEST(TupleSpillFileTest, Empty) {
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<TupleSpillFile> file,
+                       TupleSpillFile::Create(::testing::TempDir()));
+  TupleData tuple;
+  EXPECT_THAT(file->Read(&tuple), StatusIs(absl::StatusCode::kInternal));
+  ZETASQL_ASSERT_OK(file->FinishWriting());
+  EXPECT_THAT(file->Read(&tuple), IsOkAndHolds(false));
+  EXPECT_EQ(file->num_bytes(), 0);
+}
+
+TEST(TupleSpillFileTest, Errors) {
+  EXPECT_THAT(TupleSpillFile::Create("/nonexistent/directory"),
+              StatusIs(absl::StatusCode::kInternal,
+                       HasSubstr("Failed to create spill file")));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<TupleSpillFile> file,
+                       TupleSpillFile::Create(::testing::TempDir()));
+  ZETASQL_ASSERT_OK(file->Write(CreateTestTupleData({Int64(1)})));
+  // Different number of slots.
+  EXPECT_THAT(file->Write(CreateTestTupleData({Int64(1), Int64(2)})),
+              StatusIs(absl::StatusCode::kInternal));
+  // Different type.
+  EXPECT_THAT(file->Write(CreateTestTupleData({String("a")})),
+              StatusIs(absl::StatusCode::kInternal));
+}
+
+}  // namespace
+}  // namespace zetasql
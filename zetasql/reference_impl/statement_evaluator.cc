@@ -45,9 +45,12 @@
 #include "zetasql/resolved_ast/resolved_node_kind.pb.h"
 #include "zetasql/scripting/error_helpers.h"
 #include "zetasql/scripting/script_exception.pb.h"
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/string_view.h"
 #include "zetasql/base/ret_check.h"
 #include "zetasql/base/status.h"
 #include "zetasql/base/status_payload.h"
@@ -164,10 +167,11 @@ StatementEvaluatorImpl::StatementEvaluation::resolved_statement() const {
 
 const ResolvedExpr*
 StatementEvaluatorImpl::ExpressionEvaluation::resolved_expr() const {
-  if (analyzer_output_ == nullptr) {
+  if (analyzed_expression_ == nullptr ||
+      analyzed_expression_->analyzer_output == nullptr) {
     return nullptr;
   }
-  return analyzer_output_->resolved_expr();
+  return analyzed_expression_->analyzer_output->resolved_expr();
 }
 
 absl::Status StatementEvaluatorImpl::Evaluation::Evaluate(
@@ -192,25 +196,9 @@ absl::Status StatementEvaluatorImpl::Evaluation::EvaluateInternal(
       script_executor.GetKnownSystemVariables();
   analyzer_options.CreateDefaultArenasIfNotSet();
 
-  // Create a catalog which supports script variables, alongside whatever
-  // user-defined symbols have been provided when the StatementEvaluatorImpl
-  // object was created.
-  SimpleCatalog variables_catalog("script_variables",
-                                  evaluator->type_factory());
-  std::vector<std::unique_ptr<SimpleConstant>> constants;
-  const VariableMap& variables = script_executor.GetCurrentVariables();
-  for (const std::pair<const IdString, Value>& variable : variables) {
-    std::unique_ptr<SimpleConstant> constant;
-    ZETASQL_RETURN_IF_ERROR(SimpleConstant::Create({variable.first.ToString()},
-                                           variable.second, &constant));
-    variables_catalog.AddConstant(constant.get());
-    constants.push_back(std::move(constant));
-  }
-
-  std::unique_ptr<MultiCatalog> combined_catalog;
-  ZETASQL_RETURN_IF_ERROR(MultiCatalog::Create(
-      "combined_catalog", {&variables_catalog, evaluator->catalog_},
-      &combined_catalog));
+  ZETASQL_ASSIGN_OR_RETURN(Catalog* catalog,
+                   GetCatalog(segment, script_executor.GetCurrentVariables(),
+                              analyzer_options));
 
   // Force usage of ERROR_MESSAGE_WITH_PAYLOAD so that the script executor can
   // fill in the context of the error, relative to the entire script.
@@ -224,9 +212,39 @@ absl::Status StatementEvaluatorImpl::Evaluation::EvaluateInternal(
                        evaluator->parameters()),
                    script_executor.GetCurrentStackFrame()->parsed_script(),
                    segment.range(), &filtered_parameters);
-  return EvaluateImpl(segment.GetSegmentText(), analyzer_options,
-                      combined_catalog.get(), evaluator_options,
-                      system_variables, filtered_parameters);
+  return EvaluateImpl(segment.GetSegmentText(), analyzer_options, catalog,
+                      evaluator_options, system_variables, filtered_parameters);
+}
+
+absl::StatusOr<Catalog*> StatementEvaluatorImpl::Evaluation::GetCatalog(
+    const ScriptSegment& segment, const VariableMap& variables,
+    const AnalyzerOptions& analyzer_options) {
+  ZETASQL_ASSIGN_OR_RETURN(variables_catalog_,
+                   evaluator_->MakeVariablesCatalog(variables));
+  return variables_catalog_->combined_catalog.get();
+}
+
+absl::StatusOr<std::unique_ptr<StatementEvaluatorImpl::VariablesCatalog>>
+StatementEvaluatorImpl::MakeVariablesCatalog(const VariableMap& variables) {
+  // Create a catalog which supports script variables, alongside whatever
+  // user-defined symbols have been provided when the StatementEvaluatorImpl
+  // object was created.
+  auto catalog = std::make_unique<VariablesCatalog>();
+  catalog->variables_catalog =
+      std::make_unique<SimpleCatalog>("script_variables", type_factory());
+  for (const std::pair<const IdString, Value>& variable : variables) {
+    std::unique_ptr<SimpleConstant> constant;
+    ZETASQL_RETURN_IF_ERROR(SimpleConstant::Create({variable.first.ToString()},
+                                           variable.second, &constant));
+    catalog->variables_catalog->AddConstant(constant.get());
+    catalog->constants.emplace(
+        absl::AsciiStrToLower(variable.first.ToStringView()),
+        std::move(constant));
+  }
+  ZETASQL_RETURN_IF_ERROR(MultiCatalog::Create(
+      "combined_catalog", {catalog->variables_catalog.get(), catalog_},
+      &catalog->combined_catalog));
+  return catalog;
 }
 
 absl::Status StatementEvaluatorImpl::StatementEvaluation::Analyze(
@@ -419,14 +437,106 @@ StatementEvaluatorImpl::StatementEvaluation::DoDmlSideEffects(
   return num_rows_modified;
 }
 
+bool StatementEvaluatorImpl::AnalyzedExpression::IsReusable(
+    absl::string_view sql, const VariableMap& variables,
+    const AnalyzerOptions& analyzer_options) const {
+  if (analyzer_output == nullptr || !cacheable || this->sql != sql ||
+      default_time_zone != analyzer_options.default_time_zone()) {
+    return false;
+  }
+  const auto& constants = catalog->constants;
+  if (constants.size() != variables.size()) {
+    return false;
+  }
+  for (const auto& [name, value] : variables) {
+    auto it = constants.find(absl::AsciiStrToLower(name.ToStringView()));
+    if (it == constants.end() || !it->second->type()->Equals(value.type())) {
+      return false;
+    }
+  }
+  auto same_types = [](const auto& lhs, const auto& rhs) {
+    return absl::c_equal(lhs, rhs, [](const auto& lhs, const auto& rhs) {
+      return lhs.first == rhs.first && lhs.second->Equals(rhs.second);
+    });
+  };
+  return same_types(query_parameters, analyzer_options.query_parameters()) &&
+         same_types(system_variables, analyzer_options.system_variables()) &&
+         absl::c_equal(positional_query_parameters,
+                       analyzer_options.positional_query_parameters(),
+                       [](const Type* lhs, const Type* rhs) {
+                         return lhs->Equals(rhs);
+                       });
+}
+
+namespace {
+// Returns true if the analysis of <expr> remains valid as long as the types of
+// the script variables do not change. Expressions that reference tables or
+// non-builtin functions are analyzed again on every evaluation, since the
+// script may redefine those.
+bool IsCacheable(const ResolvedExpr* expr) {
+  std::vector<const ResolvedNode*> found_nodes;
+  expr->GetDescendantsWithKinds(
+      {RESOLVED_SUBQUERY_EXPR, RESOLVED_FUNCTION_CALL}, &found_nodes);
+  for (const ResolvedNode* node : found_nodes) {
+    if (node->node_kind() == RESOLVED_SUBQUERY_EXPR ||
+        !node->GetAs<ResolvedFunctionCall>()->function()->IsZetaSQLBuiltin()) {
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+absl::StatusOr<Catalog*>
+StatementEvaluatorImpl::ExpressionEvaluation::GetCatalog(
+    const ScriptSegment& segment, const VariableMap& variables,
+    const AnalyzerOptions& analyzer_options) {
+  auto& analyzed_expressions = evaluator()->analyzed_expressions_;
+  if (analyzed_expressions.size() >= kMaxAnalyzedExpressions) {
+    analyzed_expressions.clear();
+  }
+  std::unique_ptr<AnalyzedExpression>& analyzed_expression =
+      analyzed_expressions[{segment.node(), target_type_}];
+  if (analyzed_expression != nullptr &&
+      analyzed_expression->IsReusable(segment.GetSegmentText(), variables,
+                                      analyzer_options)) {
+    for (const auto& [name, value] : variables) {
+      ZETASQL_RETURN_IF_ERROR(
+          analyzed_expression->catalog->constants
+              .at(absl::AsciiStrToLower(name.ToStringView()))
+              ->SetValue(value));
+    }
+  } else {
+    auto new_expression = std::make_unique<AnalyzedExpression>();
+    new_expression->sql = std::string(segment.GetSegmentText());
+    new_expression->query_parameters = analyzer_options.query_parameters();
+    new_expression->positional_query_parameters =
+        analyzer_options.positional_query_parameters();
+    new_expression->system_variables = analyzer_options.system_variables();
+    new_expression->default_time_zone = analyzer_options.default_time_zone();
+    ZETASQL_ASSIGN_OR_RETURN(new_expression->catalog,
+                     evaluator()->MakeVariablesCatalog(variables));
+    analyzed_expression = std::move(new_expression);
+  }
+  analyzed_expression_ = analyzed_expression.get();
+  return analyzed_expression_->catalog->combined_catalog.get();
+}
+
 absl::Status StatementEvaluatorImpl::ExpressionEvaluation::EvaluateImpl(
     absl::string_view sql, const AnalyzerOptions& analyzer_options,
     Catalog* catalog, const EvaluatorOptions& evaluator_options,
     const SystemVariableValuesMap& system_variables,
     std::variant<ParameterValueList, ParameterValueMap> parameters) {
-  ZETASQL_RETURN_IF_ERROR(AnalyzeExpressionForAssignmentToType(
-      sql, analyzer_options, catalog, type_factory(), target_type_,
-      &analyzer_output_));
+  ZETASQL_RET_CHECK(analyzed_expression_ != nullptr);
+  if (analyzed_expression_->analyzer_output == nullptr) {
+    std::unique_ptr<const AnalyzerOutput> analyzer_output;
+    ZETASQL_RETURN_IF_ERROR(AnalyzeExpressionForAssignmentToType(
+        sql, analyzer_options, catalog, type_factory(), target_type_,
+        &analyzer_output));
+    analyzed_expression_->cacheable =
+        IsCacheable(analyzer_output->resolved_expr());
+    analyzed_expression_->analyzer_output = std::move(analyzer_output);
+  }
   PreparedExpression prepared_expr(resolved_expr(), evaluator_options);
   ZETASQL_RETURN_IF_ERROR(prepared_expr.Prepare(analyzer_options, nullptr));
   if (std::holds_alternative<ParameterValueList>(parameters)) {
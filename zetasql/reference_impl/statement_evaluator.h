@@ -27,13 +27,19 @@
 #include "zetasql/public/evaluator.h"
 #include "zetasql/public/evaluator_table_iterator.h"
 #include "zetasql/public/language_options.h"
+#include "zetasql/public/multi_catalog.h"
 #include "zetasql/public/options.pb.h"
 #include "zetasql/public/parse_resume_location.h"
+#include "zetasql/public/simple_catalog.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
 #include "zetasql/scripting/parsed_script.h"
 #include "zetasql/scripting/script_executor.h"
+#include "zetasql/scripting/script_segment.h"
+#include "zetasql/scripting/type_aliases.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/time/time.h"
 #include "absl/types/optional.h"
 
 namespace zetasql {
@@ -178,6 +184,50 @@ class StatementEvaluatorImpl : public StatementEvaluator {
   }
 
  private:
+  // A catalog of the script variables, as SimpleConstants, on top of the
+  // user-defined symbols provided when the StatementEvaluatorImpl object was
+  // created.
+  struct VariablesCatalog {
+    std::unique_ptr<SimpleCatalog> variables_catalog;
+    // Keyed by the lowercase name of the variable.
+    absl::flat_hash_map<std::string, std::unique_ptr<SimpleConstant>>
+        constants;
+    std::unique_ptr<MultiCatalog> combined_catalog;
+  };
+
+  // An expression analyzed by EvaluateScalarExpression(), along with the
+  // catalog and the options it was analyzed with. Expressions that a script
+  // evaluates repeatedly, such as loop conditions, are only analyzed again if
+  // their text, or the types of the variables, query parameters or system
+  // variables, have changed. Otherwise, only the values of the constants for
+  // the variables are replaced before the expression is prepared again.
+  struct AnalyzedExpression {
+    std::string sql;
+    QueryParametersMap query_parameters;
+    std::vector<const Type*> positional_query_parameters;
+    SystemVariablesMap system_variables;
+    absl::TimeZone default_time_zone;
+    std::unique_ptr<VariablesCatalog> catalog;
+    // NULL until the expression has been analyzed successfully.
+    std::unique_ptr<const AnalyzerOutput> analyzer_output;
+    // False if <analyzer_output> references catalog objects, other than the
+    // variables, that the script may redefine.
+    bool cacheable = false;
+
+    // Returns true if <analyzer_output> can be reused to evaluate text <sql>
+    // with <variables> and <analyzer_options>.
+    bool IsReusable(absl::string_view sql, const VariableMap& variables,
+                    const AnalyzerOptions& analyzer_options) const;
+  };
+
+  // The maximum number of entries of <analyzed_expressions_>. All entries are
+  // dropped when it is exceeded, which only happens when a script generates
+  // many expressions, for example with EXECUTE IMMEDIATE.
+  static constexpr int kMaxAnalyzedExpressions = 1000;
+
+  absl::StatusOr<std::unique_ptr<VariablesCatalog>> MakeVariablesCatalog(
+      const VariableMap& variables);
+
   // Represents the evaluation of a single statement or expression, using
   // derived classes StatementEvaluation and ExpressionEvaluation, respectively.
   //
@@ -211,6 +261,14 @@ class StatementEvaluatorImpl : public StatementEvaluator {
         const SystemVariableValuesMap& system_variables,
         std::variant<ParameterValueList, ParameterValueMap> parameters) = 0;
 
+    // Returns the catalog to analyze <segment> with, which includes the script
+    // <variables>. The catalog must remain valid while this object is alive.
+    virtual absl::StatusOr<Catalog*> GetCatalog(
+        const ScriptSegment& segment, const VariableMap& variables,
+        const AnalyzerOptions& analyzer_options);
+
+    StatementEvaluatorImpl* evaluator() const { return evaluator_; }
+
     absl::Status SetTableContents(const Table* table,
                                   const std::vector<std::vector<Value>>& rows) {
       return evaluator_->callback_->SetTableContents(table, rows);
@@ -223,6 +281,9 @@ class StatementEvaluatorImpl : public StatementEvaluator {
 
     // Set during Evaluate().
     StatementEvaluatorImpl* evaluator_ = nullptr;
+
+    // Set by GetCatalog(), unless overridden.
+    std::unique_ptr<VariablesCatalog> variables_catalog_;
   };
 
   class StatementEvaluation : public Evaluation {
@@ -286,10 +347,16 @@ class StatementEvaluatorImpl : public StatementEvaluator {
         std::variant<ParameterValueList, ParameterValueMap> parameters)
         override;
 
+    absl::StatusOr<Catalog*> GetCatalog(
+        const ScriptSegment& segment, const VariableMap& variables,
+        const AnalyzerOptions& analyzer_options) override;
+
    private:
     const Type* target_type_;
 
-    std::unique_ptr<const AnalyzerOutput> analyzer_output_;
+    // Owned by <analyzed_expressions_> of the evaluator, set from
+    // GetCatalog().
+    AnalyzedExpression* analyzed_expression_ = nullptr;
 
     // Set from Execute().
     Value result_;
@@ -304,6 +371,11 @@ class StatementEvaluatorImpl : public StatementEvaluator {
   TypeFactory* type_factory_;
   Catalog* catalog_;
   StatementEvaluatorCallback* callback_;
+
+  // Keyed by the AST node of the expression and its target type.
+  absl::flat_hash_map<std::pair<const ASTNode*, const Type*>,
+                      std::unique_ptr<AnalyzedExpression>>
+      analyzed_expressions_;
 };
 
 }  // namespace zetasql
@@ -0,0 +1,170 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/reference_impl/statement_evaluator.h"
+
+#include <memory>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/parser/parse_tree.h"
+#include "zetasql/public/analyzer_options.h"
+#include "zetasql/public/analyzer_output.h"
+#include "zetasql/public/builtin_function_options.h"
+#include "zetasql/public/evaluator.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/types/type_factory.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/scripting/control_flow_graph.h"
+#include "zetasql/scripting/script_executor.h"
+#include "zetasql/scripting/script_segment.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+
+namespace zetasql {
+namespace {
+
+using ::zetasql_base::testing::IsOkAndHolds;
+
+// Counts the scalar expression evaluations.
+class CountingCallback : public StatementEvaluatorCallback {
+ public:
+  CountingCallback() : StatementEvaluatorCallback(/*bytes_per_iterator=*/0) {}
+
+  void OnScalarExpressionResult(
+      const ScriptSegment& segment, const ResolvedExpr* resolved_expr,
+      const absl::StatusOr<Value>& status_or_result) override {
+    ++num_evaluations_;
+  }
+
+  int num_evaluations() const { return num_evaluations_; }
+
+ private:
+  int num_evaluations_ = 0;
+};
+
+class StatementEvaluatorImplTest : public ::testing::Test {
+ protected:
+  StatementEvaluatorImplTest() : catalog_("catalog", &type_factory_) {
+    catalog_.AddBuiltinFunctions(
+        BuiltinFunctionOptions::AllReleasedFunctions());
+    // Every analysis of an expression goes through this callback, whereas
+    // reusing a cached analysis does not.
+    analyzer_options_.SetPreRewriteCallback(
+        [this](const AnalyzerOutput& output) {
+          if (output.resolved_expr() != nullptr) {
+            ++num_expression_analyses_;
+          }
+          return absl::OkStatus();
+        });
+    evaluator_options_.type_factory = &type_factory_;
+    evaluator_ = std::make_unique<StatementEvaluatorImpl>(
+        analyzer_options_, evaluator_options_, ParameterValueMap(),
+        &type_factory_, &catalog_, &callback_);
+  }
+
+  // Returns an executor of 'script', which must outlive it.
+  std::unique_ptr<ScriptExecutor> CreateExecutor(absl::string_view script) {
+    ScriptExecutorOptions options;
+    options.PopulateFromAnalyzerOptions(analyzer_options_);
+    return ScriptExecutor::Create(script, options, evaluator_.get()).value();
+  }
+
+  // Returns the DEFAULT expression of the DECLARE statement that 'executor' is
+  // about to execute.
+  static const ASTExpression* GetDefaultValue(const ScriptExecutor& executor) {
+    return executor.GetCurrentNode()
+        ->ast_node()
+        ->GetAsOrDie<ASTVariableDeclaration>()
+        ->default_value();
+  }
+
+  TypeFactory type_factory_;
+  SimpleCatalog catalog_;
+  AnalyzerOptions analyzer_options_;
+  EvaluatorOptions evaluator_options_;
+  CountingCallback callback_;
+  std::unique_ptr<StatementEvaluatorImpl> evaluator_;
+  int num_expression_analyses_ = 0;
+};
+
+TEST_F(StatementEvaluatorImplTest, RepeatedExpressionIsAnalyzedOnce) {
+  constexpr absl::string_view kScript =
+      "DECLARE i INT64 DEFAULT 0;\n"
+      "WHILE i < 5 DO\n"
+      "  SET i = i + 1;\n"
+      "END WHILE;\n";
+  std::unique_ptr<ScriptExecutor> executor = CreateExecutor(kScript);
+  while (!executor->IsComplete()) {
+    ZETASQL_ASSERT_OK(executor->ExecuteNext());
+  }
+  // The DEFAULT expression once, the loop condition six times and the SET
+  // expression five times, but each of them is only analyzed once.
+  EXPECT_EQ(callback_.num_evaluations(), 12);
+  EXPECT_EQ(num_expression_analyses_, 3);
+}
+
+TEST_F(StatementEvaluatorImplTest, DifferentTargetTypeIsAnalyzedAgain) {
+  constexpr absl::string_view kScript = "DECLARE x INT64 DEFAULT 1 + 2;";
+  std::unique_ptr<ScriptExecutor> executor = CreateExecutor(kScript);
+  const ScriptSegment segment =
+      ScriptSegment::FromASTNode(kScript, GetDefaultValue(*executor));
+
+  EXPECT_THAT(evaluator_->EvaluateScalarExpression(*executor, segment,
+                                                   types::Int64Type()),
+              IsOkAndHolds(Value::Int64(3)));
+  EXPECT_THAT(evaluator_->EvaluateScalarExpression(*executor, segment,
+                                                   types::Int64Type()),
+              IsOkAndHolds(Value::Int64(3)));
+  EXPECT_EQ(num_expression_analyses_, 1);
+
+  // The same AST node with another target type is a separate entry.
+  EXPECT_THAT(evaluator_->EvaluateScalarExpression(*executor, segment,
+                                                   types::DoubleType()),
+              IsOkAndHolds(Value::Double(3)));
+  EXPECT_EQ(num_expression_analyses_, 2);
+  EXPECT_THAT(evaluator_->EvaluateScalarExpression(*executor, segment,
+                                                   types::Int64Type()),
+              IsOkAndHolds(Value::Int64(3)));
+  EXPECT_EQ(num_expression_analyses_, 2);
+}
+
+// The cache is keyed by the address of the AST node, which may be reused by
+// the node of another script once the first one is freed. Pairing the same
+// node with the text of another script of the same length simulates that.
+TEST_F(StatementEvaluatorImplTest, ReusedAstNodeAddressIsAnalyzedAgain) {
+  constexpr absl::string_view kScript = "DECLARE x INT64 DEFAULT 1 + 2;";
+  constexpr absl::string_view kOtherScript = "DECLARE x INT64 DEFAULT 5 * 7;";
+  std::unique_ptr<ScriptExecutor> executor = CreateExecutor(kScript);
+  const ASTExpression* default_value = GetDefaultValue(*executor);
+
+  EXPECT_THAT(evaluator_->EvaluateScalarExpression(
+                  *executor, ScriptSegment::FromASTNode(kScript, default_value),
+                  types::Int64Type()),
+              IsOkAndHolds(Value::Int64(3)));
+  EXPECT_THAT(
+      evaluator_->EvaluateScalarExpression(
+          *executor, ScriptSegment::FromASTNode(kOtherScript, default_value),
+          types::Int64Type()),
+      IsOkAndHolds(Value::Int64(35)));
+  EXPECT_EQ(num_expression_analyses_, 2);
+}
+
+}  // namespace
+}  // namespace zetasql
@@ -17,8 +17,12 @@
 #include "zetasql/reference_impl/tuple.h"
 
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <deque>
+#include <limits>
 #include <memory>
+#include <numeric>
 #include <optional>
 #include <string>
 #include <utility>
@@ -26,11 +30,18 @@
 
 #include "zetasql/base/logging.h"
 #include "zetasql/public/value.h"
+#include "zetasql/reference_impl/parallel.h"
+#include "absl/base/casts.h"
+#include "absl/base/optimization.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/hash/hash.h"
+#include "absl/log/log.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/span.h"
 #include "zetasql/base/map_util.h"
 
@@ -79,7 +90,14 @@ std::string TupleSchema::DebugString() const {
 
 int64_t TupleSlot::GetPhysicalByteSize() const {
   if (!value_.is_valid()) return sizeof(TupleSlot);
-  int64_t num_bytes = value_.physical_byte_size() + sizeof(shared_proto_state_);
+  return value_.physical_byte_size() + GetPhysicalByteSizeExcludingValue();
+}
+
+int64_t TupleSlot::GetPhysicalByteSizeExcludingValue() const {
+  if (!value_.is_valid()) {
+    return sizeof(TupleSlot) - Value::shallow_physical_byte_size();
+  }
+  int64_t num_bytes = sizeof(shared_proto_state_);
   if (shared_proto_state_ != nullptr) {
     num_bytes += sizeof(*shared_proto_state_);
     if (shared_proto_state_->has_value()) {
@@ -101,6 +119,168 @@ int64_t TupleSlot::GetPhysicalByteSize() const {
   return num_bytes;
 }
 
+// -------------------------------------------------------
+// TupleKeyHash and TupleKeyEq
+// -------------------------------------------------------
+
+namespace {
+
+// Returns the content of a non-NULL 'value' of kind 'kind'.
+template <TypeKind kind>
+auto SlotContent(const Value& value) {
+  if constexpr (kind == TYPE_INT32) return value.int32_value();
+  if constexpr (kind == TYPE_INT64) return value.int64_value();
+  if constexpr (kind == TYPE_UINT32) return value.uint32_value();
+  if constexpr (kind == TYPE_UINT64) return value.uint64_value();
+  if constexpr (kind == TYPE_BOOL) return value.bool_value();
+  if constexpr (kind == TYPE_DATE) return value.date_value();
+  if constexpr (kind == TYPE_STRING) {
+    return absl::string_view(value.string_value());
+  }
+  if constexpr (kind == TYPE_BYTES) {
+    return absl::string_view(value.bytes_value());
+  }
+}
+
+size_t HashAnySlot(const Value& value) { return absl::HashOf(value); }
+
+bool AnySlotEquals(const Value& value1, const Value& value2) {
+  return value1.Equals(value2);
+}
+
+template <TypeKind kind>
+bool HasKind(const Value& value) {
+  return value.is_valid() && value.type_kind() == kind;
+}
+
+template <TypeKind kind>
+size_t HashSlotOfKind(const Value& value) {
+  if (ABSL_PREDICT_FALSE(!HasKind<kind>(value))) {
+    return HashAnySlot(value);
+  }
+  if (value.is_null()) {
+    return absl::HashOf(kind);
+  }
+  if constexpr (kind == TYPE_STRING || kind == TYPE_BYTES) {
+    // Cached with the string, so that copies of the same string (e.g., from a
+    // dictionary-encoded column) are only hashed once.
+    return absl::HashOf(kind, InternalValue::StringContentHash(value));
+  }
+  return absl::HashOf(kind, SlotContent<kind>(value));
+}
+
+template <TypeKind kind>
+bool SlotOfKindEquals(const Value& value1, const Value& value2) {
+  if (ABSL_PREDICT_FALSE(!HasKind<kind>(value1) || !HasKind<kind>(value2))) {
+    return AnySlotEquals(value1, value2);
+  }
+  if (value1.is_null() || value2.is_null()) {
+    return value1.is_null() == value2.is_null();
+  }
+  if constexpr (kind == TYPE_STRING || kind == TYPE_BYTES) {
+    if (InternalValue::SharesStringContent(value1, value2)) return true;
+  }
+  return SlotContent<kind>(value1) == SlotContent<kind>(value2);
+}
+
+}  // namespace
+
+TupleKeyHash::SlotHashFn TupleKeyHash::GetSlotHashFn(const Type* type) {
+  switch (type == nullptr ? TYPE_UNKNOWN : type->kind()) {
+    case TYPE_INT32:
+      return &HashSlotOfKind<TYPE_INT32>;
+    case TYPE_INT64:
+      return &HashSlotOfKind<TYPE_INT64>;
+    case TYPE_UINT32:
+      return &HashSlotOfKind<TYPE_UINT32>;
+    case TYPE_UINT64:
+      return &HashSlotOfKind<TYPE_UINT64>;
+    case TYPE_BOOL:
+      return &HashSlotOfKind<TYPE_BOOL>;
+    case TYPE_DATE:
+      return &HashSlotOfKind<TYPE_DATE>;
+    case TYPE_STRING:
+      return &HashSlotOfKind<TYPE_STRING>;
+    case TYPE_BYTES:
+      return &HashSlotOfKind<TYPE_BYTES>;
+    default:
+      return &HashAnySlot;
+  }
+}
+
+TupleKeyEq::SlotEqFn TupleKeyEq::GetSlotEqFn(const Type* type) {
+  switch (type == nullptr ? TYPE_UNKNOWN : type->kind()) {
+    case TYPE_INT32:
+      return &SlotOfKindEquals<TYPE_INT32>;
+    case TYPE_INT64:
+      return &SlotOfKindEquals<TYPE_INT64>;
+    case TYPE_UINT32:
+      return &SlotOfKindEquals<TYPE_UINT32>;
+    case TYPE_UINT64:
+      return &SlotOfKindEquals<TYPE_UINT64>;
+    case TYPE_BOOL:
+      return &SlotOfKindEquals<TYPE_BOOL>;
+    case TYPE_DATE:
+      return &SlotOfKindEquals<TYPE_DATE>;
+    case TYPE_STRING:
+      return &SlotOfKindEquals<TYPE_STRING>;
+    case TYPE_BYTES:
+      return &SlotOfKindEquals<TYPE_BYTES>;
+    default:
+      return &AnySlotEquals;
+  }
+}
+
+TupleKeyHash::TupleKeyHash(absl::Span<const Type* const> slot_types) {
+  slot_hash_fns_.reserve(slot_types.size());
+  for (const Type* type : slot_types) {
+    slot_hash_fns_.push_back(GetSlotHashFn(type));
+  }
+}
+
+size_t TupleKeyHash::operator()(const TupleData& data) const {
+  const int num_slots = data.num_slots();
+  size_t hash = absl::HashOf(num_slots);
+  for (int i = 0; i < num_slots; ++i) {
+    const Value& value = data.slot(i).value();
+    hash = absl::HashOf(hash, i < slot_hash_fns_.size()
+                                  ? slot_hash_fns_[i](value)
+                                  : HashAnySlot(value));
+  }
+  return hash;
+}
+
+TupleKeyEq::TupleKeyEq(absl::Span<const Type* const> slot_types) {
+  slot_eq_fns_.reserve(slot_types.size());
+  for (const Type* type : slot_types) {
+    slot_eq_fns_.push_back(GetSlotEqFn(type));
+  }
+}
+
+bool TupleKeyEq::operator()(const TupleData& data1,
+                            const TupleData& data2) const {
+  const int num_slots = data1.num_slots();
+  if (num_slots != data2.num_slots()) return false;
+  for (int i = 0; i < num_slots; ++i) {
+    const Value& value1 = data1.slot(i).value();
+    const Value& value2 = data2.slot(i).value();
+    if (!(i < slot_eq_fns_.size() ? slot_eq_fns_[i](value1, value2)
+                                  : AnySlotEquals(value1, value2))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<const Type*> GetSlotTypes(const TupleData& data) {
+  std::vector<const Type*> types;
+  types.reserve(data.num_slots());
+  for (const TupleSlot& slot : data.slots()) {
+    types.push_back(slot.value().is_valid() ? slot.value().type() : nullptr);
+  }
+  return types;
+}
+
 // -------------------------------------------------------
 // Tuple-related functions
 // -------------------------------------------------------
@@ -126,7 +306,7 @@ Tuple ConcatTuples(absl::Span<const Tuple> tuples,
   for (const Tuple& tuple : tuples) {
     const std::vector<VariableId>& tuple_vars = tuple.schema->variables();
     vars.insert(vars.end(), tuple_vars.begin(), tuple_vars.end());
-    const std::vector<TupleSlot>& tuple_slots = tuple.data->slots();
+    const TupleData::SlotVector& tuple_slots = tuple.data->slots();
     slots.insert(slots.end(),
                  // Drop any extra slots in 'tuple_slots'.
                  tuple_slots.begin(), tuple_slots.begin() + tuple_vars.size());
@@ -136,6 +316,36 @@ Tuple ConcatTuples(absl::Span<const Tuple> tuples,
   return Tuple(new_schema->get(), new_data->get());
 }
 
+// -------------------------------------------------------
+// MemoryAccountant
+// -------------------------------------------------------
+
+bool MemoryAccountant::GrowPoolReservation(int64_t used_bytes,
+                                           absl::Status* status) {
+  // Reserve a whole chunk if possible, but never more than this accountant
+  // can allocate, and just what is needed when the pool is nearly exhausted.
+  const int64_t chunk_bytes = std::min<int64_t>(
+      kPoolReservationChunkBytes, total_num_bytes_ - pool_reserved_bytes_);
+  const int64_t needed_bytes = used_bytes - pool_reserved_bytes_;
+  if (chunk_bytes > needed_bytes) {
+    absl::Status unused_status;
+    if (pool_->Reserve(chunk_bytes, &unused_status)) {
+      pool_reserved_bytes_ += chunk_bytes;
+      return true;
+    }
+  }
+  if (!pool_->Reserve(needed_bytes, status)) return false;
+  pool_reserved_bytes_ += needed_bytes;
+  return true;
+}
+
+void MemoryAccountant::ShrinkPoolReservation() {
+  const int64_t kept_bytes =
+      total_num_bytes_ - remaining_bytes_ + kPoolReservationChunkBytes;
+  pool_->Release(pool_reserved_bytes_ - kept_bytes);
+  pool_reserved_bytes_ = kept_bytes;
+}
+
 // -------------------------------------------------------
 // TupleDataDeque
 // -------------------------------------------------------
@@ -149,32 +359,227 @@ absl::Status TupleDataDeque::SetSlot(int slot_idx, std::vector<Value> values) {
     TupleData* tuple = entry.second.get();
 
     TupleSlot* slot = tuple->mutable_slot(slot_idx);
-    const int64_t old_slot_size = slot->GetPhysicalByteSize();
-    slot->SetValue(std::move(values[i]));
-    const int64_t new_slot_size = slot->GetPhysicalByteSize();
+    TupleSlot new_slot;
+    new_slot.SetValue(std::move(values[i]));
 
-    accountant_->ReturnBytes(byte_size);
-    byte_size += (new_slot_size - old_slot_size);
-    if (!accountant_->RequestBytes(byte_size, &status)) {
+    // Track the new value before untracking the old one, so that content they
+    // share is not charged for again.
+    const int64_t new_value_size = value_tracker_.Add(new_slot.value());
+    const int64_t old_value_size = value_tracker_.Remove(slot->value());
+    const int64_t overhead_delta =
+        new_slot.GetPhysicalByteSizeExcludingValue() -
+        slot->GetPhysicalByteSizeExcludingValue();
+    const int64_t delta = overhead_delta + new_value_size - old_value_size;
+    if (delta > 0 && !accountant_->RequestBytes(delta, &status)) {
+      value_tracker_.Add(slot->value());
+      value_tracker_.Remove(new_slot.value());
       return status;
     }
+    if (delta < 0) {
+      accountant_->ReturnBytes(-delta);
+    }
+    byte_size += overhead_delta;
+    *slot = std::move(new_slot);
 
     ++i;
   }
   return absl::OkStatus();
 }
 
-void TupleDataDeque::Sort(const TupleComparator& comparator,
-                          bool use_stable_sort) {
-  auto entry_comparator = [&comparator](const Entry& entry1,
-                                        const Entry& entry2) {
-    return comparator(entry1.second, entry2.second);
+// Sorts [begin, end) with 'less', using std::stable_sort or std::sort. With
+// 'num_threads' > 1, large ranges are sorted in equal-sized chunks in
+// parallel, and then adjacent pairs of sorted ranges are merged in rounds, the
+// merges of each round in parallel. std::inplace_merge puts equal elements of
+// the first range first, so the result is stably sorted if the chunks are.
+// 'less' must not touch the EvaluationContext, which is not thread-safe. The
+// helper threads are tasks of 'executor' if it is non-null.
+template <typename Iterator, typename Less>
+static void SortRange(Iterator begin, Iterator end, const Less& less,
+                      bool use_stable_sort, int num_threads,
+                      EvaluatorExecutor* executor) {
+  auto sort_chunk = [&](Iterator chunk_begin, Iterator chunk_end) {
+    if (use_stable_sort) {
+      std::stable_sort(chunk_begin, chunk_end, less);
+    } else {
+      std::sort(chunk_begin, chunk_end, less);
+    }
   };
-  if (use_stable_sort) {
-    std::stable_sort(datas_.begin(), datas_.end(), entry_comparator);
-  } else {
-    std::sort(datas_.begin(), datas_.end(), entry_comparator);
+
+  // Smaller ranges are not worth handing to the helper threads.
+  constexpr int64_t kMinElementsPerSortChunk = 1024;
+  const int64_t size = end - begin;
+  const int64_t num_chunks =
+      num_threads > 1
+          ? std::min<int64_t>(num_threads, size / kMinElementsPerSortChunk)
+          : 1;
+  if (num_chunks <= 1) {
+    sort_chunk(begin, end);
+    return;
+  }
+
+  std::vector<int64_t> chunk_begins(num_chunks + 1);
+  for (int64_t i = 0; i <= num_chunks; ++i) {
+    chunk_begins[i] = size * i / num_chunks;
+  }
+  // The tasks never fail.
+  ParallelFor(num_threads, num_chunks,
+              [&](int chunk) {
+                sort_chunk(begin + chunk_begins[chunk],
+                           begin + chunk_begins[chunk + 1]);
+                return absl::OkStatus();
+              },
+              executor)
+      .IgnoreError();
+  for (int64_t width = 1; width < num_chunks; width *= 2) {
+    const int64_t num_merges = (num_chunks + 2 * width - 1) / (2 * width);
+    ParallelFor(num_threads, num_merges,
+                [&](int merge) {
+                  const int64_t first = 2 * width * merge;
+                  const int64_t middle = std::min(first + width, num_chunks);
+                  const int64_t last = std::min(first + 2 * width, num_chunks);
+                  if (middle < last) {
+                    std::inplace_merge(begin + chunk_begins[first],
+                                       begin + chunk_begins[middle],
+                                       begin + chunk_begins[last], less);
+                  }
+                  return absl::OkStatus();
+                },
+                executor)
+        .IgnoreError();
+  }
+}
+
+// Reorders 'tuples' so that the i-th entry is the 'order[i]'-th entry of the
+// original 'tuples'.
+template <typename Deque>
+static void PermuteTuples(absl::Span<const int64_t> order, Deque* tuples) {
+  Deque sorted(tuples->get_allocator());
+  for (const int64_t i : order) {
+    sorted.push_back(std::move((*tuples)[i]));
+  }
+  *tuples = std::move(sorted);
+}
+
+// Sorts 'tuples' with 'comparator' by comparing their normalized sort keys
+// (see TupleComparator::AppendNormalizedSortKey()), which must be supported.
+// Returns false without modifying 'tuples' if there is not enough memory for
+// the sort keys or a key cannot be computed.
+template <typename Deque>
+static bool SortWithNormalizedSortKeys(const TupleComparator& comparator,
+                                       bool use_stable_sort, int num_threads,
+                                       EvaluatorExecutor* executor,
+                                       MemoryAccountant* accountant,
+                                       Deque* tuples) {
+  std::vector<std::string> sort_keys;
+  sort_keys.reserve(tuples->size());
+  int64_t num_bytes = 0;
+  absl::Status status;
+  for (const auto& entry : *tuples) {
+    std::string& sort_key = sort_keys.emplace_back();
+    const int64_t entry_bytes = sizeof(std::string);
+    if (!comparator.AppendNormalizedSortKey(*entry.second, &sort_key).ok() ||
+        !accountant->RequestBytes(entry_bytes + sort_key.size(), &status)) {
+      accountant->ReturnBytes(num_bytes);
+      return false;
+    }
+    num_bytes += entry_bytes + sort_key.size();
+  }
+
+  std::vector<int64_t> order(tuples->size());
+  std::iota(order.begin(), order.end(), 0);
+  SortRange(
+      order.begin(), order.end(),
+      [&sort_keys](int64_t i1, int64_t i2) {
+        return sort_keys[i1] < sort_keys[i2];
+      },
+      use_stable_sort, num_threads, executor);
+  PermuteTuples(order, tuples);
+  accountant->ReturnBytes(num_bytes);
+  return true;
+}
+
+// Sorts 'tuples' with 'comparator', using precomputed collation sort keys.
+// Returns false without modifying 'tuples' if there is not enough memory for
+// the sort keys.
+template <typename Deque>
+static bool SortWithCollationSortKeys(const TupleComparator& comparator,
+                                      bool use_stable_sort, int num_threads,
+                                      EvaluatorExecutor* executor,
+                                      MemoryAccountant* accountant,
+                                      Deque* tuples) {
+  const int num_sort_keys = comparator.num_collation_sort_keys();
+  std::vector<std::string> sort_keys;
+  sort_keys.reserve(tuples->size() * num_sort_keys);
+  int64_t num_bytes = 0;
+  absl::Status status;
+  for (const auto& entry : *tuples) {
+    absl::StatusOr<int64_t> entry_bytes =
+        comparator.AppendCollationSortKeys(*entry.second, &sort_keys);
+    if (!entry_bytes.ok() || !accountant->RequestBytes(*entry_bytes, &status)) {
+      accountant->ReturnBytes(num_bytes);
+      return false;
+    }
+    num_bytes += *entry_bytes;
+  }
+
+  std::vector<int64_t> order(tuples->size());
+  std::iota(order.begin(), order.end(), 0);
+  SortRange(
+      order.begin(), order.end(),
+      [&](int64_t i1, int64_t i2) {
+        return comparator.Compare(*(*tuples)[i1].second,
+                                  &sort_keys[i1 * num_sort_keys],
+                                  *(*tuples)[i2].second,
+                                  &sort_keys[i2 * num_sort_keys]);
+      },
+      use_stable_sort, num_threads, executor);
+  PermuteTuples(order, tuples);
+  accountant->ReturnBytes(num_bytes);
+  return true;
+}
+
+void TupleDataDeque::Sort(const TupleComparator& comparator,
+                          bool use_stable_sort, int num_threads,
+                          EvaluatorExecutor* executor) {
+  if (datas_.size() <= 1) return;
+  // Comparing the normalized sort keys of the tuples as byte strings is much
+  // cheaper than comparing their Values key by key. Failing that, computing
+  // the collation sort key of every tuple once is much cheaper than comparing
+  // strings with the collator in each of the O(n log n) comparisons.
+  if (comparator.SupportsNormalizedSortKeys() &&
+      SortWithNormalizedSortKeys(comparator, use_stable_sort, num_threads,
+                                 executor, accountant_, &datas_)) {
+    return;
+  }
+  if (comparator.num_collation_sort_keys() > 0 &&
+      SortWithCollationSortKeys(comparator, use_stable_sort, num_threads,
+                                executor, accountant_, &datas_)) {
+    return;
+  }
+  SortRange(
+      datas_.begin(), datas_.end(),
+      [&comparator](const Entry& entry1, const Entry& entry2) {
+        return comparator(entry1.second, entry2.second);
+      },
+      use_stable_sort, num_threads, executor);
+}
+
+// -------------------------------------------------------
+// TupleIterator
+// -------------------------------------------------------
+
+bool TupleIterator::NextBatch(TupleDataBatch* batch) {
+  batch->Clear();
+  while (!next_batch_done_ && !batch->full()) {
+    const TupleData* data = Next();
+    if (data == nullptr) {
+      next_batch_done_ = true;
+      if (!Status().ok()) return false;
+      break;
+    }
+    batch->AddOwnedRowCopy(*data);
   }
+  return !batch->empty();
 }
 
 // -------------------------------------------------------
@@ -232,4 +637,278 @@ TupleData* ReorderingTupleIterator::Next() {
   return &current_batch_[index];
 }
 
+// -------------------------------------------------------
+// ValueHashSet
+// -------------------------------------------------------
+
+namespace {
+
+// Returns whether non-NULL values of 'kind' can be stored as the 64-bit keys
+// of ValueHashSet::CompactKeys.
+bool IsCompactKeyKind(TypeKind kind) {
+  switch (kind) {
+    case TYPE_INT32:
+    case TYPE_INT64:
+    case TYPE_UINT32:
+    case TYPE_UINT64:
+    case TYPE_BOOL:
+    case TYPE_DATE:
+    case TYPE_FLOAT:
+    case TYPE_DOUBLE:
+    case TYPE_STRING:
+    case TYPE_BYTES:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns a key for 'value' whose unsigned order is that of the values.
+uint64_t OrderedKey(int64_t value) {
+  return absl::bit_cast<uint64_t>(value) ^ (uint64_t{1} << 63);
+}
+
+// Like above, but all NaNs have the same key, and so do 0 and -0, since they
+// are equal for grouping.
+uint64_t OrderedKey(double value) {
+  if (std::isnan(value)) {
+    value = std::numeric_limits<double>::quiet_NaN();
+  } else if (value == 0) {
+    value = 0;
+  }
+  const uint64_t bits = absl::bit_cast<uint64_t>(value);
+  return (bits >> 63) != 0 ? ~bits : bits | (uint64_t{1} << 63);
+}
+
+}  // namespace
+
+// The keys are either the values themselves, for integer-like and floating
+// point values, or the offset and size of their bytes in 'strings_', for
+// STRING and BYTES values. Strings are hashed whenever the hash set needs it
+// and compared byte by byte, so that hash collisions never merge distinct
+// values.
+class ValueHashSet::CompactKeys {
+ public:
+  explicit CompactKeys(TypeKind type_kind)
+      : type_kind_(type_kind),
+        is_string_(type_kind == TYPE_STRING || type_kind == TYPE_BYTES),
+        hashed_keys_(/*bucket_count=*/0, KeyHash{this}, KeyEq{this}) {}
+
+  CompactKeys(const CompactKeys&) = delete;
+  CompactKeys& operator=(const CompactKeys&) = delete;
+
+  TypeKind type_kind() const { return type_kind_; }
+
+  // Like ValueHashSet::Insert(), for a non-NULL 'value' of 'type_kind()'.
+  bool Insert(const Value& value, MemoryAccountant* accountant, bool* inserted,
+              absl::Status* status) {
+    *inserted = false;
+    const size_t strings_size = strings_.size();
+    uint64_t key;
+    uint64_t byte_size = sizeof(uint64_t);
+    if (is_string_) {
+      const std::string& bytes = type_kind_ == TYPE_STRING
+                                     ? value.string_value()
+                                     : value.bytes_value();
+      // The candidate is appended to 'strings_' first, so that it can be
+      // compared like the keys that are already there.
+      strings_.append(bytes);
+      key = (static_cast<uint64_t>(strings_size) << kSizeBits) | bytes.size();
+      byte_size += bytes.size();
+    } else {
+      key = KeyOf(value);
+    }
+    if (Contains(key)) {
+      strings_.resize(strings_size);
+      return true;
+    }
+    if (!accountant->RequestBytes(byte_size, status)) {
+      strings_.resize(strings_size);
+      return false;
+    }
+    InsertNew(key);
+    requested_bytes_ += byte_size;
+    *inserted = true;
+    return true;
+  }
+
+  // Returns the bytes that were requested by Insert().
+  uint64_t requested_bytes() const { return requested_bytes_; }
+
+ private:
+  static constexpr int kSizeBits = 16;
+  static_assert(kMaxCompactStringSize < (int64_t{1} << kSizeBits));
+
+  // Whether the keys in 'sorted_keys_' are in increasing or decreasing order,
+  // or were moved to 'hashed_keys_'.
+  enum class Order { kUnknown, kAscending, kDescending, kHashed };
+
+  struct KeyHash {
+    size_t operator()(uint64_t key) const {
+      return keys->is_string_ ? absl::HashOf(keys->StringOf(key))
+                              : absl::HashOf(key);
+    }
+    const CompactKeys* keys;
+  };
+  struct KeyEq {
+    bool operator()(uint64_t key1, uint64_t key2) const {
+      return keys->Equals(key1, key2);
+    }
+    const CompactKeys* keys;
+  };
+
+  uint64_t KeyOf(const Value& value) const {
+    switch (type_kind_) {
+      case TYPE_INT32:
+        return OrderedKey(int64_t{value.int32_value()});
+      case TYPE_INT64:
+        return OrderedKey(value.int64_value());
+      case TYPE_UINT32:
+        return value.uint32_value();
+      case TYPE_UINT64:
+        return value.uint64_value();
+      case TYPE_BOOL:
+        return value.bool_value();
+      case TYPE_DATE:
+        return OrderedKey(int64_t{value.date_value()});
+      case TYPE_FLOAT:
+        return OrderedKey(double{value.float_value()});
+      case TYPE_DOUBLE:
+        return OrderedKey(value.double_value());
+      default:
+        ABSL_LOG(FATAL) << "Unexpected type kind: "
+                        << TypeKind_Name(type_kind_);
+    }
+  }
+
+  absl::string_view StringOf(uint64_t key) const {
+    return absl::string_view(strings_).substr(
+        key >> kSizeBits, key & ((uint64_t{1} << kSizeBits) - 1));
+  }
+
+  bool Equals(uint64_t key1, uint64_t key2) const {
+    return is_string_ ? StringOf(key1) == StringOf(key2) : key1 == key2;
+  }
+
+  bool Less(uint64_t key1, uint64_t key2) const {
+    return is_string_ ? StringOf(key1) < StringOf(key2) : key1 < key2;
+  }
+
+  // Returns whether 'key' can be appended to 'sorted_keys_'.
+  bool IsInOrder(uint64_t key) const {
+    const uint64_t last = sorted_keys_.back();
+    switch (order_) {
+      case Order::kUnknown:
+        return true;
+      case Order::kAscending:
+        return Less(last, key);
+      case Order::kDescending:
+        return Less(key, last);
+      case Order::kHashed:
+        return false;
+    }
+  }
+
+  bool Contains(uint64_t key) const {
+    if (order_ == Order::kHashed) {
+      return hashed_keys_.contains(key);
+    }
+    if (sorted_keys_.empty()) return false;
+    if (Equals(key, sorted_keys_.back())) return true;
+    if (IsInOrder(key)) return false;
+    auto less = [this](uint64_t key1, uint64_t key2) {
+      return Less(key1, key2);
+    };
+    return order_ == Order::kAscending
+               ? std::binary_search(sorted_keys_.begin(), sorted_keys_.end(),
+                                    key, less)
+               : std::binary_search(sorted_keys_.rbegin(),
+                                    sorted_keys_.rend(), key, less);
+  }
+
+  // Inserts 'key', which must not be in the set yet.
+  void InsertNew(uint64_t key) {
+    if (order_ == Order::kHashed) {
+      hashed_keys_.insert(key);
+      return;
+    }
+    if (sorted_keys_.empty()) {
+      sorted_keys_.push_back(key);
+      return;
+    }
+    if (IsInOrder(key)) {
+      if (order_ == Order::kUnknown) {
+        order_ = Less(sorted_keys_.back(), key) ? Order::kAscending
+                                                : Order::kDescending;
+      }
+      sorted_keys_.push_back(key);
+      return;
+    }
+    hashed_keys_.reserve(sorted_keys_.size() + 1);
+    hashed_keys_.insert(sorted_keys_.begin(), sorted_keys_.end());
+    hashed_keys_.insert(key);
+    sorted_keys_ = std::vector<uint64_t>();
+    order_ = Order::kHashed;
+  }
+
+  const TypeKind type_kind_;
+  const bool is_string_;
+  Order order_ = Order::kUnknown;
+  std::vector<uint64_t> sorted_keys_;
+  absl::flat_hash_set<uint64_t, KeyHash, KeyEq> hashed_keys_;
+  // The bytes of all STRING or BYTES keys.
+  std::string strings_;
+  uint64_t requested_bytes_ = 0;
+};
+
+ValueHashSet::ValueHashSet(MemoryAccountant* accountant)
+    : accountant_(accountant) {}
+
+ValueHashSet::~ValueHashSet() { Clear(); }
+
+bool ValueHashSet::Insert(const Value& value, bool* inserted,
+                          absl::Status* status) {
+  *inserted = false;
+  if (value.is_valid() && !value.is_null() &&
+      IsCompactKeyKind(value.type_kind()) &&
+      (value.type_kind() != TYPE_STRING ||
+       value.string_value().size() <= kMaxCompactStringSize) &&
+      (value.type_kind() != TYPE_BYTES ||
+       value.bytes_value().size() <= kMaxCompactStringSize)) {
+    if (compact_keys_ == nullptr) {
+      compact_keys_ = std::make_unique<CompactKeys>(value.type_kind());
+    }
+    if (compact_keys_->type_kind() == value.type_kind()) {
+      return compact_keys_->Insert(value, accountant_, inserted, status);
+    }
+  }
+  if (values_.empty()) {
+    // Specialize the hashing to the type of the first value.
+    const Type* type = value.is_valid() ? value.type() : nullptr;
+    values_ = ValueSet(/*bucket_count=*/0, ValueHash{type}, ValueEq{type});
+  }
+  if (values_.contains(value)) {
+    return true;
+  }
+  const uint64_t byte_size = value_tracker_.Add(value);
+  if (!accountant_->RequestBytes(byte_size, status)) {
+    value_tracker_.Remove(value);
+    return false;
+  }
+  values_.insert(value);
+  *inserted = true;
+  return true;
+}
+
+void ValueHashSet::Clear() {
+  if (compact_keys_ != nullptr) {
+    accountant_->ReturnBytes(compact_keys_->requested_bytes());
+    compact_keys_.reset();
+  }
+  for (const Value& value : values_) {
+    accountant_->ReturnBytes(value_tracker_.Remove(value));
+  }
+  values_.clear();
+}
+
 }  // namespace zetasql
@@ -29,11 +29,14 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "zetasql/base/logging.h"
 #include "zetasql/common/internal_value.h"
+#include "zetasql/public/evaluator_executor.h"
+#include "zetasql/public/memory_pool.h"
 #include "zetasql/public/proto_util.h"
 #include "zetasql/public/value.h"
 #include "zetasql/reference_impl/tuple_comparator.h"
@@ -48,6 +51,7 @@
 #include "absl/strings/substitute.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
+#include "zetasql/base/arena.h"
 #include "zetasql/base/flat_set.h"
 #include "zetasql/base/map_util.h"
 #include "zetasql/base/ret_check.h"
@@ -335,6 +339,11 @@ class TupleSlot {
   // Returns an approximation of the amount of memory used to store this slot.
   int64_t GetPhysicalByteSize() const;
 
+  // Like GetPhysicalByteSize(), but excludes value().physical_byte_size(). For
+  // callers that account for the value separately, e.g., with a
+  // ValueMemoryTracker.
+  int64_t GetPhysicalByteSizeExcludingValue() const;
+
   bool operator==(const TupleSlot& s) const { return value_ == s.value_; }
 
   template <typename H>
@@ -477,15 +486,92 @@ inline void TupleSlot::CopyFromSlot(const TupleSlot& other) {
 }
 
 // Stores the contents of a tuple, which is essentially a vector of TupleSlots.
+// STL allocator for the slots of a TupleData, and for the containers that
+// operators accumulate TupleDatas in (e.g., TupleDataDeque and DistinctRowSet).
+// Allocates from 'arena' if it is non-NULL, and from the heap otherwise. Arena
+// memory is only released along with the arena (see
+// EvaluationContext::tuple_arena()), which must outlive every TupleData and
+// container allocated from it. Not releasing it piecemeal also keeps such
+// TupleDatas destructible on the helper threads of parallel.h. Since memory
+// that a container frees (e.g., when a hash table grows) is not reused, only
+// containers that are filled once per statement should use an arena.
+//
+// Copy-constructing a TupleData allocates from the heap, so copies can outlive
+// the arena. Moving one keeps its allocator.
+template <typename T>
+class TupleArenaAllocator {
+ public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::false_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+  using is_always_equal = std::false_type;
+
+  TupleArenaAllocator() = default;
+  explicit TupleArenaAllocator(zetasql_base::UnsafeArena* arena)
+      : arena_(arena) {}
+  template <typename U>
+  TupleArenaAllocator(const TupleArenaAllocator<U>& other)  // NOLINT
+      : arena_(other.arena()) {}
+
+  T* allocate(size_t n) {
+    if (arena_ == nullptr) {
+      return std::allocator<T>().allocate(n);
+    }
+    return static_cast<T*>(arena_->AllocAligned(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* p, size_t n) {
+    if (arena_ == nullptr) {
+      std::allocator<T>().deallocate(p, n);
+    }
+  }
+
+  TupleArenaAllocator select_on_container_copy_construction() const {
+    return TupleArenaAllocator();
+  }
+
+  zetasql_base::UnsafeArena* arena() const { return arena_; }
+
+  template <typename U>
+  bool operator==(const TupleArenaAllocator<U>& other) const {
+    return arena_ == other.arena();
+  }
+  template <typename U>
+  bool operator!=(const TupleArenaAllocator<U>& other) const {
+    return arena_ != other.arena();
+  }
+
+ private:
+  zetasql_base::UnsafeArena* arena_ = nullptr;
+};
+
 class TupleData {
  public:
+  using SlotVector = std::vector<TupleSlot, TupleArenaAllocator<TupleSlot>>;
+
   TupleData() {}
 
   explicit TupleData(int num_slots) : slots_(num_slots) {}
 
+  // Like above, but allocates the slots from 'arena' if it is non-NULL. See
+  // TupleArenaAllocator.
+  TupleData(int num_slots, zetasql_base::UnsafeArena* arena)
+      : slots_(num_slots, TupleArenaAllocator<TupleSlot>(arena)) {}
+
   explicit TupleData(absl::Span<const TupleSlot> slots)
       : slots_(slots.begin(), slots.end()) {}
 
+  TupleData(const TupleData&) = default;
+  TupleData(TupleData&&) = default;
+  TupleData& operator=(const TupleData&) = default;
+  TupleData& operator=(TupleData&&) = default;
+
+  // Copies 'other', allocating the slots from 'arena' if it is non-NULL. See
+  // TupleArenaAllocator.
+  TupleData(const TupleData& other, zetasql_base::UnsafeArena* arena)
+      : slots_(other.slots_, TupleArenaAllocator<TupleSlot>(arena)) {}
+
   void Clear() { slots_.clear(); }
 
   void AddSlots(int num_slots) { slots_.resize(slots_.size() + num_slots); }
@@ -503,11 +589,11 @@ class TupleData {
 
   const TupleSlot& slot(int i) const { return slots_[i]; }
 
-  const std::vector<TupleSlot>& slots() const { return slots_; }
+  const SlotVector& slots() const { return slots_; }
 
   // Returns an approximation of the memory size of this TupleData.
   int64_t GetPhysicalByteSize() const {
-    int64_t num_bytes = sizeof(std::vector<TupleSlot>);
+    int64_t num_bytes = sizeof(SlotVector);
     for (const TupleSlot& slot : slots()) {
       num_bytes += slot.GetPhysicalByteSize();
     }
@@ -543,8 +629,7 @@ class TupleData {
   }
 
  private:
-  std::vector<TupleSlot> slots_;
-  // Allow copy/assign/move.
+  SlotVector slots_;
 };
 
 // Wraps a const TupleData* but hashes as the underlying TupleData.
@@ -561,6 +646,60 @@ struct TupleDataPtr {
   }
 };
 
+// Hash and equality functors for hash containers of TupleDatas whose slots
+// have known types, such as the keys of a hash join or GROUP BY. The function
+// used for each slot is chosen once from its type, so that hashing a row of
+// simple values does not dispatch through Type for every value the way
+// AbslHashValue(Value) and Value::Equals() do. Slots beyond the given types,
+// and values whose TypeKind turns out to differ from the slot type, use those
+// generic functions. Either way, TupleKeyEq agrees with TupleData::operator==
+// and equal TupleDatas have equal TupleKeyHash values, as long as the two
+// functors of a container are constructed from the same types.
+class TupleKeyHash {
+ public:
+  // Hashes every slot with AbslHashValue(Value).
+  TupleKeyHash() = default;
+  explicit TupleKeyHash(absl::Span<const Type* const> slot_types);
+
+  size_t operator()(const TupleData& data) const;
+  size_t operator()(const TupleDataPtr& data) const {
+    return (*this)(*data.data);
+  }
+
+  // Hashes a single value of type 'type' (or of any type, if 'type' is
+  // nullptr) the way a slot of that type would be hashed.
+  using SlotHashFn = size_t (*)(const Value& value);
+  static SlotHashFn GetSlotHashFn(const Type* type);
+
+ private:
+  std::vector<SlotHashFn> slot_hash_fns_;
+};
+
+class TupleKeyEq {
+ public:
+  // Compares every slot with Value::Equals().
+  TupleKeyEq() = default;
+  explicit TupleKeyEq(absl::Span<const Type* const> slot_types);
+
+  bool operator()(const TupleData& data1, const TupleData& data2) const;
+  bool operator()(const TupleDataPtr& data1, const TupleDataPtr& data2) const {
+    return (*this)(*data1.data, *data2.data);
+  }
+
+  // Compares two values of type 'type' (or of any type, if 'type' is nullptr)
+  // the way slots of that type would be compared.
+  using SlotEqFn = bool (*)(const Value& value1, const Value& value2);
+  static SlotEqFn GetSlotEqFn(const Type* type);
+
+ private:
+  std::vector<SlotEqFn> slot_eq_fns_;
+};
+
+// Returns the types of the values in 'data', for constructing a TupleKeyHash
+// and TupleKeyEq when the key types are only known from the first key. Invalid
+// values get a nullptr type.
+std::vector<const Type*> GetSlotTypes(const TupleData& data);
+
 struct Tuple {
  public:
   Tuple(const TupleSchema* schema_in, const TupleData* data_in)
@@ -638,17 +777,29 @@ inline std::vector<const TupleData*> StripSharedPtrs(
 // of them.
 class MemoryAccountant {
  public:
+  // The granularity of the reservations from a MemoryPool, so that most
+  // RequestBytes() and ReturnBytes() calls do not touch the pool.
+  static constexpr int64_t kPoolReservationChunkBytes = 1 << 20;
+
   // Constructs a MemoryAccountant that can allocate at most 'total_num_bytes'
-  // at once.
+  // at once. If 'pool' is non-null, the allocated bytes are also reserved
+  // from it (in chunks of kPoolReservationChunkBytes), and requests fail if it
+  // runs out, as they do when this accountant does. 'pool' must outlive the
+  // accountant.
   explicit MemoryAccountant(int64_t total_num_bytes,
-                            absl::string_view name = "")
+                            absl::string_view name = "",
+                            MemoryPool* pool = nullptr)
       : total_num_bytes_(total_num_bytes),
         remaining_bytes_(total_num_bytes),
-        name_(name) {}
+        name_(name),
+        pool_(pool) {}
 
   MemoryAccountant(const MemoryAccountant&) = delete;
   MemoryAccountant& operator=(const MemoryAccountant&) = delete;
-  ~MemoryAccountant() { ABSL_DCHECK_EQ(remaining_bytes_, total_num_bytes_); }
+  ~MemoryAccountant() {
+    ABSL_DCHECK_EQ(remaining_bytes_, total_num_bytes_);
+    if (pool_reserved_bytes_ > 0) pool_->Release(pool_reserved_bytes_);
+  }
 
   // If there are 'num_bytes' available, updates the number of remaining bytes
   // accordingly and returns true. Else returns false and populates
@@ -663,7 +814,13 @@ class MemoryAccountant {
 
       return false;
     }
+    const int64_t used_bytes = total_num_bytes_ - remaining_bytes_ + num_bytes;
+    if (pool_ != nullptr && used_bytes > pool_reserved_bytes_ &&
+        !GrowPoolReservation(used_bytes, status)) {
+      return false;
+    }
     remaining_bytes_ -= num_bytes;
+    if (used_bytes > peak_bytes_) peak_bytes_ = used_bytes;
     return true;
   }
 
@@ -672,22 +829,46 @@ class MemoryAccountant {
   void ReturnBytes(int64_t num_bytes) {
     remaining_bytes_ += num_bytes;
     ABSL_DCHECK_LE(remaining_bytes_, total_num_bytes_);
+    if (pool_reserved_bytes_ - (total_num_bytes_ - remaining_bytes_) >
+        2 * kPoolReservationChunkBytes) {
+      ShrinkPoolReservation();
+    }
   }
 
   int64_t remaining_bytes() const { return remaining_bytes_; }
 
+  int64_t total_num_bytes() const { return total_num_bytes_; }
+
+  // The largest number of bytes that were allocated at once.
+  int64_t peak_bytes() const { return peak_bytes_; }
+
  private:
+  // Grows the reservation from 'pool_' so that it covers 'used_bytes'. Returns
+  // false and populates 'status' if the pool does not have enough bytes.
+  bool GrowPoolReservation(int64_t used_bytes, absl::Status* status);
+
+  // Returns the bytes reserved from 'pool_' beyond a chunk of headroom.
+  void ShrinkPoolReservation();
+
   const int64_t total_num_bytes_;
   int64_t remaining_bytes_;
   std::string name_;
+  MemoryPool* const pool_;
+  // The number of bytes reserved from 'pool_', which is at least the number
+  // of allocated bytes.
+  int64_t pool_reserved_bytes_ = 0;
+  int64_t peak_bytes_ = 0;
 };
 
 // Holds a deque of TupleDatas whose memory usage is tracked by a
 // MemoryAccountant, which is not owned by this object.
 class TupleDataDeque {
  public:
-  explicit TupleDataDeque(MemoryAccountant* accountant)
-      : accountant_(accountant) {}
+  // If 'arena' is non-NULL, the deque allocates its entries from it (see
+  // TupleArenaAllocator).
+  explicit TupleDataDeque(MemoryAccountant* accountant,
+                          zetasql_base::UnsafeArena* arena = nullptr)
+      : accountant_(accountant), datas_(TupleArenaAllocator<Entry>(arena)) {}
 
   TupleDataDeque(const TupleDataDeque&) = delete;
   TupleDataDeque& operator=(const TupleDataDeque&) = delete;
@@ -703,11 +884,26 @@ class TupleDataDeque {
   // this object are unaccounted for. This method does not return absl::Status
   // for performance reasons.
   bool PushBack(std::unique_ptr<TupleData> data, absl::Status* status) {
-    const int64_t byte_size = data->GetPhysicalByteSize() + sizeof(Entry);
-    if (!accountant_->RequestBytes(byte_size, status)) {
+    return TryPushBack(&data, status);
+  }
+
+  // Like PushBack(), but on failure leaves '*data' unchanged so that the
+  // caller can try again after freeing some memory (e.g., by spilling tuples
+  // to disk).
+  bool TryPushBack(std::unique_ptr<TupleData>* data, absl::Status* status) {
+    // Content shared by several tuples (e.g., STRING or PROTO values copied
+    // from the same input) is only charged for once.
+    int64_t overhead = sizeof(Entry) + sizeof(TupleData::SlotVector);
+    int64_t value_bytes = 0;
+    for (const TupleSlot& slot : (*data)->slots()) {
+      overhead += slot.GetPhysicalByteSizeExcludingValue();
+      value_bytes += value_tracker_.Add(slot.value());
+    }
+    if (!accountant_->RequestBytes(overhead + value_bytes, status)) {
+      UntrackValues(**data);
       return false;
     }
-    datas_.emplace_back(byte_size, std::move(data));
+    datas_.emplace_back(overhead, std::move(*data));
     return true;
   }
 
@@ -715,7 +911,7 @@ class TupleDataDeque {
   std::unique_ptr<TupleData> PopFront() {
     Entry entry = std::move(datas_.front());
     datas_.pop_front();
-    accountant_->ReturnBytes(entry.first);
+    accountant_->ReturnBytes(entry.first + UntrackValues(*entry.second));
     return std::move(entry.second);
   }
 
@@ -741,17 +937,36 @@ class TupleDataDeque {
   // into the appropriate slots. Also updates the memory accountant accordingly.
   absl::Status SetSlot(int slot_idx, std::vector<Value> values);
 
-  // Sorts the deque using std::sort or std::stable_sort.
-  void Sort(const TupleComparator& comparator, bool use_stable_sort);
+  // Sorts the deque using std::sort or std::stable_sort. With 'num_threads' >
+  // 1, large deques are sorted in chunks on up to 'num_threads' threads (tasks
+  // of 'executor' if it is non-null, see ParallelFor()), which are then merged
+  // stably, so the result is the same as with one thread if 'use_stable_sort'
+  // is true.
+  void Sort(const TupleComparator& comparator, bool use_stable_sort,
+            int num_threads = 1, EvaluatorExecutor* executor = nullptr);
 
  private:
-  // Stores a TupleData and its memory size.
+  // Stores a TupleData and its memory size, excluding the slot values, which
+  // are accounted for by 'value_tracker_'.
   using Entry = std::pair<int64_t, std::unique_ptr<TupleData>>;
 
+  // Stops tracking the slot values of 'data' and returns the number of bytes
+  // that they no longer use.
+  int64_t UntrackValues(const TupleData& data) {
+    int64_t num_bytes = 0;
+    for (const TupleSlot& slot : data.slots()) {
+      num_bytes += value_tracker_.Remove(slot.value());
+    }
+    return num_bytes;
+  }
+
   MemoryAccountant* accountant_;
 
   // Stores TupleDatas and their memory sizes.
-  std::deque<Entry> datas_;
+  std::deque<Entry, TupleArenaAllocator<Entry>> datas_;
+
+  // Tracks the memory used by the slot values of 'datas_'.
+  ValueMemoryTracker value_tracker_;
 };
 
 // Represents an ordered queue of TupleDatas whose memory usage is tracked by a
@@ -799,6 +1014,10 @@ class TupleDataOrderedQueue {
     return std::move(value_entry.second);
   }
 
+  // Returns a reference to the last element of the queue, which must be
+  // non-empty.
+  const TupleData& Back() const { return *std::prev(entries_.end())->first; }
+
   // Returns the last element of the queue, which must be non-empty.
   std::unique_ptr<TupleData> PopBack() {
     auto iter = entries_.end();
@@ -879,8 +1098,13 @@ class MemoryReservation {
 // Used memory is freed back to the accountant in the destructor.
 class DistinctRowSet {
  public:
-  explicit DistinctRowSet(MemoryAccountant* accountant)
-      : memory_reservation_(accountant) {}
+  // If 'arena' is non-NULL, the set allocates its hash table from it (see
+  // TupleArenaAllocator).
+  explicit DistinctRowSet(MemoryAccountant* accountant,
+                          zetasql_base::UnsafeArena* arena = nullptr)
+      : rows_(TupleArenaAllocator<std::unique_ptr<TupleData>>(arena)),
+        rows_set_(TupleArenaAllocator<TupleDataPtr>(arena)),
+        memory_reservation_(accountant) {}
   DistinctRowSet(const DistinctRowSet&) = delete;
   DistinctRowSet& operator=(const DistinctRowSet&) = delete;
 
@@ -892,20 +1116,52 @@ class DistinctRowSet {
   //     describing the error.
   bool InsertRowIfNotPresent(std::unique_ptr<TupleData> row,
                              absl::Status* status) {
-    if (!zetasql_base::InsertIfNotPresent(&rows_set_, TupleDataPtr(row.get()))) {
+    if (IsPresent(*row)) {
       // Duplicate; not inserted
       return false;
     }
+    return InsertNewRow(std::move(row), status);
+  }
+
+  // Like above, but copies 'row' only if it is inserted, so that duplicates,
+  // which are common in recursive queries over graphs, do not allocate.
+  bool InsertRowIfNotPresent(const TupleData& row, absl::Status* status) {
+    if (IsPresent(row)) {
+      return false;
+    }
+    return InsertNewRow(std::make_unique<TupleData>(row), status);
+  }
+
+ private:
+  using RowsSet = absl::flat_hash_set<TupleDataPtr, TupleKeyHash, TupleKeyEq,
+                                      TupleArenaAllocator<TupleDataPtr>>;
+
+  bool IsPresent(const TupleData& row) {
+    if (rows_set_.empty()) {
+      // Specialize the hashing to the types of the first row.
+      const std::vector<const Type*> slot_types = GetSlotTypes(row);
+      rows_set_ = RowsSet(/*bucket_count=*/0, TupleKeyHash(slot_types),
+                          TupleKeyEq(slot_types), rows_set_.get_allocator());
+      return false;
+    }
+    return rows_set_.contains(TupleDataPtr(&row));
+  }
+
+  // Reserves the memory of 'row' before adding it, so that 'rows_set_' never
+  // points to a row that was not kept.
+  bool InsertNewRow(std::unique_ptr<TupleData> row, absl::Status* status) {
     if (!memory_reservation_.Increase(row->GetPhysicalByteSize(), status)) {
       return false;
     }
+    rows_set_.insert(TupleDataPtr(row.get()));
     rows_.push_back(std::move(row));
     return true;
   }
 
- private:
-  std::vector<std::unique_ptr<TupleData>> rows_;
-  absl::flat_hash_set<TupleDataPtr> rows_set_;
+  std::vector<std::unique_ptr<TupleData>,
+              TupleArenaAllocator<std::unique_ptr<TupleData>>>
+      rows_;
+  RowsSet rows_set_;
   MemoryReservation memory_reservation_;
 };
 
@@ -936,7 +1192,11 @@ class ArrayBuilder {
   // the same type. This is not verified here for performance reasons.
   ABSL_MUST_USE_RESULT bool PushBackUnsafe(Value&& value,
                                            absl::Status* status) {
-    if (!reservation_.Increase(value.physical_byte_size(), status)) {
+    // Elements that share content (e.g., the same STRING repeated) only
+    // charge for it once.
+    const uint64_t byte_size = value_tracker_.Add(value);
+    if (!reservation_.Increase(byte_size, status)) {
+      value_tracker_.Remove(value);
       return false;
     }
     values_.push_back(std::move(value));
@@ -947,8 +1207,9 @@ class ArrayBuilder {
   // PushBack(), returning a MemoryReservation to track freeing the value back
   // to the memory accountant.
   //
-  // The size of returned memory reservation is the sum of the element sizes,
-  // which is slightly less than the size of the returned array value. This
+  // The size of returned memory reservation is the sum of the element sizes
+  // (counting content shared between elements once), which is slightly less
+  // than the size of the returned array value. This
   // saves a couple of unnecessary allocate/free operations and the difference
   // is expected to be negligible.
   //
@@ -967,47 +1228,168 @@ class ArrayBuilder {
  private:
   MemoryReservation reservation_;
   std::vector<Value> values_;
+  // Tracks the memory used by 'values_'.
+  ValueMemoryTracker value_tracker_;
 };
 
 // Represents a hash set of values with memory tracked by a MemoryAccountant.
+//
+// Non-NULL values of the simple types that DISTINCT aggregates usually see are
+// not stored as Values. Integer-like and floating point values are stored as
+// 64-bit keys, and short STRING and BYTES values as spans of one shared
+// buffer, which only costs their bytes. Those keys are kept in a vector for as
+// long as they arrive sorted (ascending or descending), since each one then
+// only needs to be compared with the previous one. They move to a hash set
+// when the first key arrives out of order.
 class ValueHashSet {
  public:
-  explicit ValueHashSet(MemoryAccountant* accountant)
-      : accountant_(accountant) {}
+  // STRING and BYTES values up to this size are stored compactly. Longer ones
+  // are stored as Values, so that copies of them share their content.
+  static constexpr int64_t kMaxCompactStringSize = 256;
+
+  explicit ValueHashSet(MemoryAccountant* accountant);
 
   ValueHashSet(const ValueHashSet&) = delete;
   ValueHashSet& operator=(const ValueHashSet&) = delete;
 
-  ~ValueHashSet() { Clear(); }
+  ~ValueHashSet();
 
   // If 'value' is in the underlying set, sets 'inserted' to false and returns
   // true. Otherwise requests bytes. If that succeeds, inserts 'value' into the
   // underlying set, sets 'inserted' to true, and returns false. Otherwise,
   // populates 'status' and returns false.
-  bool Insert(const Value& value, bool* inserted, absl::Status* status) {
-    *inserted = false;
-    if (values_.contains(value)) {
-      return true;
-    }
-    if (!accountant_->RequestBytes(value.physical_byte_size(), status)) {
-      return false;
+  bool Insert(const Value& value, bool* inserted, absl::Status* status);
+
+  // Clear the hash set.
+  void Clear();
+
+ private:
+  // The compactly stored values, which all have the same type kind.
+  class CompactKeys;
+
+  struct ValueHash {
+    explicit ValueHash(const Type* type = nullptr)
+        : fn(TupleKeyHash::GetSlotHashFn(type)) {}
+    size_t operator()(const Value& value) const { return fn(value); }
+    TupleKeyHash::SlotHashFn fn;
+  };
+  struct ValueEq {
+    explicit ValueEq(const Type* type = nullptr)
+        : fn(TupleKeyEq::GetSlotEqFn(type)) {}
+    bool operator()(const Value& value1, const Value& value2) const {
+      return fn(value1, value2);
     }
-    values_.insert(value);
-    *inserted = true;
-    return true;
+    TupleKeyEq::SlotEqFn fn;
+  };
+  using ValueSet = absl::flat_hash_set<Value, ValueHash, ValueEq>;
+
+  MemoryAccountant* accountant_;
+  // Created for the first value that can be stored compactly. Values of
+  // other type kinds are stored in 'values_'.
+  std::unique_ptr<CompactKeys> compact_keys_;
+  ValueSet values_;
+  // Tracks the memory used by 'values_', whose elements may share content.
+  ValueMemoryTracker value_tracker_;
+};
+
+// A batch of TupleDatas returned by TupleIterator::NextBatch(). A batch holds
+// at most capacity() rows. Each row is either borrowed from the iterator that
+// produced the batch (AddRow()) or stored in the batch itself (AddOwnedRow()).
+// Storage for owned rows is recycled by Clear(), so an iterator that refills
+// the same batch does not reallocate the slot vectors of its rows.
+class TupleDataBatch {
+ public:
+  // The number of rows in a batch if the caller does not specify otherwise.
+  static constexpr int kDefaultCapacity = 256;
+
+  explicit TupleDataBatch(int capacity = kDefaultCapacity)
+      : capacity_(capacity) {
+    ABSL_DCHECK_GT(capacity, 0);
+    rows_.reserve(capacity);
   }
 
-  // Clear the hash set.
+  TupleDataBatch(const TupleDataBatch&) = delete;
+  TupleDataBatch& operator=(const TupleDataBatch&) = delete;
+
+  int capacity() const { return capacity_; }
+
+  int size() const { return static_cast<int>(rows_.size()); }
+
+  bool empty() const { return rows_.empty(); }
+
+  bool full() const { return size() >= capacity_; }
+
+  TupleData* row(int i) const { return rows_[i]; }
+
+  absl::Span<TupleData* const> rows() const { return rows_; }
+
+  // Removes all the rows. Owned storage is retained for reuse.
   void Clear() {
-    for (const Value& value : values_) {
-      accountant_->ReturnBytes(value.physical_byte_size());
+    rows_.clear();
+    num_owned_rows_ = 0;
+  }
+
+  // Appends 'data', which is not owned by this object and must remain valid
+  // as long as it is in the batch.
+  void AddRow(TupleData* data) {
+    ABSL_DCHECK(!full());
+    rows_.push_back(data);
+  }
+
+  // Appends a row with exactly 'num_slots' slots that is owned by this object
+  // and returns it. The slots may still hold Values from a previous batch, so
+  // the caller must overwrite every slot that it reads later.
+  TupleData* AddOwnedRow(int num_slots) {
+    TupleData* data = NextOwnedRow();
+    if (data->num_slots() < num_slots) {
+      data->AddSlots(num_slots - data->num_slots());
+    } else if (data->num_slots() > num_slots) {
+      data->RemoveSlots(data->num_slots() - num_slots);
     }
-    values_.clear();
+    return data;
+  }
+
+  // Appends a copy of 'data' that is owned by this object and returns it.
+  TupleData* AddOwnedRowCopy(const TupleData& data) {
+    TupleData* copy = NextOwnedRow();
+    *copy = data;
+    return copy;
+  }
+
+  // Replaces the 'i'-th row with 'data', which must be a row of this batch.
+  // Used together with Truncate() to filter a batch in place.
+  void SetRow(int i, TupleData* data) { rows_[i] = data; }
+
+  // Drops all but the first 'num_rows' rows.
+  void Truncate(int num_rows) {
+    ABSL_DCHECK_LE(num_rows, size());
+    rows_.resize(num_rows);
+  }
+
+  // Drops the first 'num_rows' rows.
+  void RemovePrefix(int num_rows) {
+    ABSL_DCHECK_LE(num_rows, size());
+    rows_.erase(rows_.begin(), rows_.begin() + num_rows);
   }
 
  private:
-  MemoryAccountant* accountant_;
-  absl::flat_hash_set<Value> values_;
+  TupleData* NextOwnedRow() {
+    ABSL_DCHECK(!full());
+    if (num_owned_rows_ == owned_rows_.size()) {
+      owned_rows_.emplace_back();
+    }
+    TupleData* data = &owned_rows_[num_owned_rows_];
+    ++num_owned_rows_;
+    rows_.push_back(data);
+    return data;
+  }
+
+  const int capacity_;
+  std::vector<TupleData*> rows_;
+  // A std::deque so that appending does not invalidate pointers in 'rows_'.
+  std::deque<TupleData> owned_rows_;
+  // The number of elements of 'owned_rows_' in use by the current batch.
+  int num_owned_rows_ = 0;
 };
 
 // An iterator over TupleDatas. Particularly useful as a representation of a
@@ -1043,6 +1425,23 @@ class TupleIterator {
   // TupleData into a wider TupleData with more slots.
   virtual TupleData* Next() = 0;
 
+  // Batch form of Next(). Clears 'batch' and fills it with at most
+  // 'batch->capacity()' tuples. Returns true if 'batch' is non-empty. Returns
+  // false if there are no more tuples or if there is an error, in which case
+  // the caller must call Status() to distinguish between success and
+  // failure. The behavior of NextBatch() is undefined after it has returned
+  // false.
+  //
+  // The rows of 'batch' remain valid until the next call to NextBatch(), and
+  // the caller may modify them under the same rules as the return value of
+  // Next(). Callers must not interleave calls to Next() and NextBatch() on the
+  // same iterator.
+  //
+  // The default implementation copies the tuples returned by Next() into
+  // 'batch'. Iterators on hot paths override it to avoid the copy and to pay
+  // their per-call overhead once per batch instead of once per tuple.
+  virtual bool NextBatch(TupleDataBatch* batch);
+
   // Returns the current status.
   virtual absl::Status Status() const = 0;
 
@@ -1065,12 +1464,25 @@ class TupleIterator {
   // PreservesOrder().
   virtual absl::Status DisableReordering() { return absl::OkStatus(); }
 
+  // Signals that the caller will not call Next() or NextBatch() again, e.g.,
+  // because a LIMIT or an EXISTS has seen enough tuples. Iterators forward the
+  // signal to their inputs and release buffered tuples, and scans cancel their
+  // EvaluatorTableIterators so that the tables can stop producing rows. Only
+  // Status() and DebugString() may be called afterwards. Does not change the
+  // result of Status(). Does nothing by default.
+  virtual void Close() {}
+
   // Returns a debug string that consists mostly of the kinds of the iterators
   // that are stacked (e.g.,
   // "FilterTupleIterator(ComputeTupleIterator(EvaluatorTableIterator))". In
   // most cases, more detailed information is available from the RelationalOp
   // corresponding to the iterator.
   virtual std::string DebugString() const = 0;
+
+ private:
+  // True if the default implementation of NextBatch() has seen Next() return
+  // NULL.
+  bool next_batch_done_ = false;
 };
 
 // Wraps another iterator and scrambles its order. The scrambling is
@@ -1099,6 +1511,11 @@ class ReorderingTupleIterator : public TupleIterator {
     return absl::OkStatus();
   }
 
+  void Close() override {
+    current_batch_.clear();
+    iter_->Close();
+  }
+
   std::string DebugString() const override {
     return absl::StrCat("ReorderingTupleIterator(", iter_->DebugString(), ")");
   }
@@ -1141,29 +1558,47 @@ class PassThroughTupleIterator : public TupleIterator {
   const TupleSchema& Schema() const override { return schema_; }
 
   TupleData* Next() override {
-    if (iter_ == nullptr) {
-      absl::StatusOr<std::unique_ptr<TupleIterator>> status_or_iter =
-          iterator_factory_();
-      if (!status_or_iter.ok()) {
-        iterator_factory_status_ = status_or_iter.status();
-        return nullptr;
-      }
-      iter_ = std::move(status_or_iter).value();
-    }
+    if (!MaybeCreateIterator()) return nullptr;
     return iter_->Next();
   }
 
+  bool NextBatch(TupleDataBatch* batch) override {
+    if (!MaybeCreateIterator()) {
+      batch->Clear();
+      return false;
+    }
+    return iter_->NextBatch(batch);
+  }
+
   absl::Status Status() const override {
     if (iter_ == nullptr) return iterator_factory_status_;
     return iter_->Status();
   }
 
+  void Close() override {
+    if (iter_ != nullptr) iter_->Close();
+  }
+
   std::string DebugString() const override {
     return absl::StrCat("PassThroughTupleIterator(Factory for ",
                         debug_string_factory_(), ")");
   }
 
  private:
+  // Creates 'iter_' if it does not exist yet. Returns false and updates
+  // 'iterator_factory_status_' on failure.
+  bool MaybeCreateIterator() {
+    if (iter_ != nullptr) return true;
+    absl::StatusOr<std::unique_ptr<TupleIterator>> status_or_iter =
+        iterator_factory_();
+    if (!status_or_iter.ok()) {
+      iterator_factory_status_ = status_or_iter.status();
+      return false;
+    }
+    iter_ = std::move(status_or_iter).value();
+    return true;
+  }
+
   const IteratorFactory iterator_factory_;
   const TupleSchema schema_;
   const DebugStringFactory debug_string_factory_;
@@ -16,6 +16,7 @@
 
 #include "zetasql/reference_impl/tuple_comparator.h"
 
+#include <cmath>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -32,9 +33,12 @@
 #include "zetasql/reference_impl/common.h"
 #include "zetasql/reference_impl/operator.h"
 #include "zetasql/reference_impl/tuple.h"
+#include "absl/base/casts.h"
+#include "absl/base/optimization.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
 #include "absl/strings/string_view.h"
 #include "zetasql/base/source_location.h"
 #include "zetasql/base/ret_check.h"
@@ -118,74 +122,306 @@ absl::StatusOr<std::unique_ptr<TupleComparator>> TupleComparator::Create(
                                               extra_sort_key_slots, collators));
 }
 
-bool TupleComparator::operator()(const TupleData& t1,
-                                 const TupleData& t2) const {
+// Compares two values with Value::Equals() and Value::LessThan().
+static int CompareValues(const Value& v1, const Value& v2) {
+  if (v1.Equals(v2)) return 0;
+  return v1.LessThan(v2) ? -1 : 1;
+}
+
+template <typename T>
+static int CompareContent(const T& x, const T& y) {
+  return x < y ? -1 : (y < x ? 1 : 0);
+}
+
+// Compares two values of TypeKind 'kind' without dispatching through Type, or
+// with CompareValues() if they turn out to have some other kind.
+template <TypeKind kind>
+static int CompareValuesOfKind(const Value& v1, const Value& v2) {
+  if (ABSL_PREDICT_FALSE(v1.type_kind() != kind || v2.type_kind() != kind)) {
+    return CompareValues(v1, v2);
+  }
+  if constexpr (kind == TYPE_INT32) {
+    return CompareContent(v1.int32_value(), v2.int32_value());
+  } else if constexpr (kind == TYPE_INT64) {
+    return CompareContent(v1.int64_value(), v2.int64_value());
+  } else if constexpr (kind == TYPE_UINT32) {
+    return CompareContent(v1.uint32_value(), v2.uint32_value());
+  } else if constexpr (kind == TYPE_UINT64) {
+    return CompareContent(v1.uint64_value(), v2.uint64_value());
+  } else if constexpr (kind == TYPE_BOOL) {
+    return CompareContent(v1.bool_value(), v2.bool_value());
+  } else if constexpr (kind == TYPE_DATE) {
+    return CompareContent(v1.date_value(), v2.date_value());
+  } else if constexpr (kind == TYPE_STRING) {
+    if (InternalValue::SharesStringContent(v1, v2)) return 0;
+    return v1.string_value().compare(v2.string_value());
+  } else {
+    static_assert(kind == TYPE_BYTES);
+    if (InternalValue::SharesStringContent(v1, v2)) return 0;
+    return v1.bytes_value().compare(v2.bytes_value());
+  }
+}
+
+TupleComparator::ValueCompareFn TupleComparator::GetValueCompareFn(
+    const Type* type) {
+  if (type == nullptr) return &CompareValues;
+  switch (type->kind()) {
+    case TYPE_INT32:
+      return &CompareValuesOfKind<TYPE_INT32>;
+    case TYPE_INT64:
+      return &CompareValuesOfKind<TYPE_INT64>;
+    case TYPE_UINT32:
+      return &CompareValuesOfKind<TYPE_UINT32>;
+    case TYPE_UINT64:
+      return &CompareValuesOfKind<TYPE_UINT64>;
+    case TYPE_BOOL:
+      return &CompareValuesOfKind<TYPE_BOOL>;
+    case TYPE_DATE:
+      return &CompareValuesOfKind<TYPE_DATE>;
+    case TYPE_STRING:
+      return &CompareValuesOfKind<TYPE_STRING>;
+    case TYPE_BYTES:
+      return &CompareValuesOfKind<TYPE_BYTES>;
+    default:
+      return &CompareValues;
+  }
+}
+
+TupleComparator::TupleComparator(absl::Span<const KeyArg* const> keys,
+                                 absl::Span<const int> slots_for_keys,
+                                 absl::Span<const int> extra_sort_key_slots,
+                                 std::shared_ptr<const CollatorList> collators)
+    : keys_(keys.begin(), keys.end()),
+      slots_for_keys_(slots_for_keys.begin(), slots_for_keys.end()),
+      extra_sort_key_slots_(extra_sort_key_slots.begin(),
+                            extra_sort_key_slots.end()),
+      collators_(collators) {
+  key_comparators_.reserve(keys_.size() + extra_sort_key_slots_.size());
   for (int i = 0; i < keys_.size(); ++i) {
     const KeyArg* key = keys_[i];
+    KeyComparator& key_comparator = key_comparators_.emplace_back();
+    key_comparator.slot_idx = slots_for_keys_[i];
+    key_comparator.descending = key->is_descending();
+    // NULLS FIRST is the default for ASC order, and NULLS LAST for DESC order.
+    key_comparator.nulls_first =
+        key->is_descending() ? key->null_order() == KeyArg::kNullsFirst
+                             : key->null_order() != KeyArg::kNullsLast;
     const ZetaSqlCollator* collator = (*collators_)[i].get();
+    if (collator != nullptr && collator->IsBinaryComparison()) {
+      // Equivalent to comparing the UTF-8 encodings.
+      collator = nullptr;
+    }
+    key_comparator.collator = collator;
+    key_comparator.sort_key_idx =
+        collator == nullptr ? -1 : num_collation_sort_keys_++;
+    key_comparator.compare = GetValueCompareFn(key->type());
+    key_comparator.kind = key->type()->kind();
+    if (!SupportsNormalizedSortKey(key_comparator.kind)) {
+      supports_normalized_sort_keys_ = false;
+    }
+  }
+  // The sort specification for extra sort keys is ASC, NULLS FIRST. Their
+  // types are not known here.
+  for (const int slot_idx : extra_sort_key_slots_) {
+    key_comparators_.push_back({slot_idx, /*descending=*/false,
+                                /*nulls_first=*/true, /*collator=*/nullptr,
+                                /*sort_key_idx=*/-1,
+                                GetValueCompareFn(/*type=*/nullptr),
+                                TYPE_UNKNOWN});
+    supports_normalized_sort_keys_ = false;
+  }
+}
+
+// Appends the low 'num_bytes' bytes of 'bits' in big-endian order, inverted if
+// 'descending', so that larger 'bits' give larger (or, if 'descending',
+// smaller) byte strings.
+static void AppendBigEndian(uint64_t bits, int num_bytes, bool descending,
+                            std::string* key) {
+  if (descending) bits = ~bits;
+  for (int shift = 8 * (num_bytes - 1); shift >= 0; shift -= 8) {
+    key->push_back(static_cast<char>((bits >> shift) & 0xff));
+  }
+}
 
-    const int slot_idx = slots_for_keys_[i];
-    const Value& v1 = t1.slot(slot_idx).value();
-    const Value& v2 = t2.slot(slot_idx).value();
+// Appends 'bytes' with each 0x00 escaped as 0x00 0xff and a 0x00 0x00
+// terminator, inverted if 'descending'. This keeps the order of the byte
+// strings when another key follows, since the terminator is smaller than any
+// byte or escape that could follow a shared prefix.
+static void AppendEscapedBytes(absl::string_view bytes, bool descending,
+                               std::string* key) {
+  const char flip = descending ? '\xff' : '\0';
+  for (const char c : bytes) {
+    key->push_back(static_cast<char>(c ^ flip));
+    if (c == '\0') key->push_back(static_cast<char>('\xff' ^ flip));
+  }
+  key->push_back(flip);
+  key->push_back(flip);
+}
 
-    if (v1.is_null() || v2.is_null()) {
-      if (v1.is_null() && v2.is_null()) {  // NULLs are considered equal.
-        continue;
-      }
-      if (key->is_descending()) {
-        // NULLS LAST is the default for DESC order.
-        const bool nulls_last = key->null_order() != KeyArg::kNullsFirst;
-        // Non-null sorts after null except with nulls-first ordering.
-        return nulls_last ? !v1.is_null() : v1.is_null();
-      } else {
-        // NULLS FIRST is the default for ASC order.
-        const bool nulls_first = key->null_order() != KeyArg::kNullsLast;
-        // Null sorts before non-null except with nulls-last ordering.
-        return nulls_first ? !v2.is_null() : v2.is_null();
-      }
-    }
+// Returns the bits of 'd' as an unsigned integer that orders doubles like
+// Value::LessThan(): NaN first, and -0 equal to +0.
+static uint64_t OrderedDoubleBits(double d) {
+  if (std::isnan(d)) return 0;
+  if (d == 0) d = 0;
+  const uint64_t bits = absl::bit_cast<uint64_t>(d);
+  // Negative numbers sort in the reverse order of their magnitudes.
+  return (bits >> 63) != 0 ? ~bits : bits | (uint64_t{1} << 63);
+}
 
-    if (collator != nullptr) {
-      ABSL_DCHECK(v1.type()->IsString());
-      ABSL_DCHECK(v2.type()->IsString());
-      absl::Status status;
-      int64_t result =
-          collator->CompareUtf8(v1.string_value(), v2.string_value(), &status);
-      ZETASQL_DCHECK_OK(status);
-      if (result != 0) {  // v1 != v2
-        if (key->is_descending()) {
-          return result > 0;  // v1 > v2
-        } else {
-          return result < 0;  // v1 < v2
-        }
-      }
-    } else {
-      if (!v1.Equals(v2)) {
-        if (key->is_descending()) {
-          return v2.LessThan(v1);
+// Same as OrderedDoubleBits(), for floats.
+static uint32_t OrderedFloatBits(float f) {
+  if (std::isnan(f)) return 0;
+  if (f == 0) f = 0;
+  const uint32_t bits = absl::bit_cast<uint32_t>(f);
+  return (bits >> 31) != 0 ? ~bits : bits | (uint32_t{1} << 31);
+}
+
+bool TupleComparator::SupportsNormalizedSortKey(TypeKind kind) {
+  switch (kind) {
+    case TYPE_INT32:
+    case TYPE_INT64:
+    case TYPE_UINT32:
+    case TYPE_UINT64:
+    case TYPE_BOOL:
+    case TYPE_DATE:
+    case TYPE_FLOAT:
+    case TYPE_DOUBLE:
+    case TYPE_STRING:
+    case TYPE_BYTES:
+      return true;
+    default:
+      return false;
+  }
+}
+
+absl::Status TupleComparator::AppendNormalizedSortKey(const TupleData& t,
+                                                      std::string* key) const {
+  ZETASQL_RET_CHECK(supports_normalized_sort_keys_);
+  for (const KeyComparator& key_comparator : key_comparators_) {
+    const Value& value = t.slot(key_comparator.slot_idx).value();
+    // The NULL marker is not inverted for DESC order, since 'nulls_first'
+    // already takes the direction into account.
+    if (value.is_null()) {
+      key->push_back(key_comparator.nulls_first ? '\0' : '\2');
+      continue;
+    }
+    key->push_back('\1');
+    ZETASQL_RET_CHECK_EQ(value.type_kind(), key_comparator.kind);
+    const bool descending = key_comparator.descending;
+    switch (key_comparator.kind) {
+      case TYPE_INT32:
+        AppendBigEndian(static_cast<uint32_t>(value.int32_value()) ^
+                            (uint32_t{1} << 31),
+                        /*num_bytes=*/4, descending, key);
+        break;
+      case TYPE_INT64:
+        AppendBigEndian(static_cast<uint64_t>(value.int64_value()) ^
+                            (uint64_t{1} << 63),
+                        /*num_bytes=*/8, descending, key);
+        break;
+      case TYPE_UINT32:
+        AppendBigEndian(value.uint32_value(), /*num_bytes=*/4, descending, key);
+        break;
+      case TYPE_UINT64:
+        AppendBigEndian(value.uint64_value(), /*num_bytes=*/8, descending, key);
+        break;
+      case TYPE_BOOL:
+        AppendBigEndian(value.bool_value() ? 1 : 0, /*num_bytes=*/1, descending,
+                        key);
+        break;
+      case TYPE_DATE:
+        AppendBigEndian(static_cast<uint32_t>(value.date_value()) ^
+                            (uint32_t{1} << 31),
+                        /*num_bytes=*/4, descending, key);
+        break;
+      case TYPE_FLOAT:
+        AppendBigEndian(OrderedFloatBits(value.float_value()),
+                        /*num_bytes=*/4, descending, key);
+        break;
+      case TYPE_DOUBLE:
+        AppendBigEndian(OrderedDoubleBits(value.double_value()),
+                        /*num_bytes=*/8, descending, key);
+        break;
+      case TYPE_STRING:
+        if (key_comparator.collator != nullptr) {
+          absl::Cord sort_key;
+          ZETASQL_RETURN_IF_ERROR(key_comparator.collator->GetSortKeyUtf8(
+              value.string_value(), &sort_key));
+          AppendEscapedBytes(std::string(sort_key), descending, key);
         } else {
-          return v1.LessThan(v2);
+          AppendEscapedBytes(value.string_value(), descending, key);
         }
-      }
+        break;
+      case TYPE_BYTES:
+        AppendEscapedBytes(value.bytes_value(), descending, key);
+        break;
+      default:
+        ZETASQL_RET_CHECK_FAIL() << "Unsupported normalized sort key type "
+                         << Type::TypeKindToString(key_comparator.kind,
+                                                   PRODUCT_INTERNAL);
     }
   }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<int64_t> TupleComparator::AppendCollationSortKeys(
+    const TupleData& t, std::vector<std::string>* sort_keys) const {
+  int64_t num_bytes = 0;
+  for (const KeyComparator& key : key_comparators_) {
+    if (key.collator == nullptr) continue;
+    const Value& value = t.slot(key.slot_idx).value();
+    if (value.is_null()) {
+      // Not used, since NULLs are compared without their sort key.
+      sort_keys->emplace_back();
+      continue;
+    }
+    ZETASQL_RET_CHECK(value.type()->IsString());
+    absl::Cord sort_key;
+    ZETASQL_RETURN_IF_ERROR(
+        key.collator->GetSortKeyUtf8(value.string_value(), &sort_key));
+    num_bytes += sizeof(std::string) + sort_key.size();
+    sort_keys->emplace_back(sort_key);
+  }
+  return num_bytes;
+}
 
-  // Sort by extra sort keys.
-  for (int i = 0; i < extra_sort_key_slots_.size(); ++i) {
-    const int slot_idx = extra_sort_key_slots_[i];
-    const Value& v1 = t1.slot(slot_idx).value();
-    const Value& v2 = t2.slot(slot_idx).value();
+bool TupleComparator::Compare(const TupleData& t1,
+                              const std::string* sort_keys1,
+                              const TupleData& t2,
+                              const std::string* sort_keys2) const {
+  for (const KeyComparator& key : key_comparators_) {
+    const Value& v1 = t1.slot(key.slot_idx).value();
+    const Value& v2 = t2.slot(key.slot_idx).value();
 
     if (v1.is_null() || v2.is_null()) {
-      if (v1.is_null() && v2.is_null()) {  // NULLs are considered equal
+      if (v1.is_null() && v2.is_null()) {  // NULLs are considered equal.
         continue;
       }
-      // NULLS FIRST is the default behavior
-      return !v2.is_null();
+      return key.nulls_first ? v1.is_null() : v2.is_null();
+    }
+
+    // For DESC order, 't1' is less than 't2' if 'v2' is less than 'v1'.
+    const Value& lhs = key.descending ? v2 : v1;
+    const Value& rhs = key.descending ? v1 : v2;
+    int64_t result;
+    if (key.collator == nullptr) {
+      result = key.compare(lhs, rhs);
+    } else if (sort_keys1 != nullptr) {
+      const std::string& lhs_sort_key =
+          (key.descending ? sort_keys2 : sort_keys1)[key.sort_key_idx];
+      const std::string& rhs_sort_key =
+          (key.descending ? sort_keys1 : sort_keys2)[key.sort_key_idx];
+      result = lhs_sort_key.compare(rhs_sort_key);
+    } else {
+      ABSL_DCHECK(v1.type()->IsString());
+      ABSL_DCHECK(v2.type()->IsString());
+      absl::Status status;
+      result = key.collator->CompareUtf8(lhs.string_value(), rhs.string_value(),
+                                         &status);
+      ZETASQL_DCHECK_OK(status);
     }
-    // ASC by default.
-    if (!v1.Equals(v2)) {
-      return v1.LessThan(v2);
+    if (result != 0) {
+      return result < 0;
     }
   }
   // The keys are equal.
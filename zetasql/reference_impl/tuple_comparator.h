@@ -17,12 +17,16 @@
 #ifndef ZETASQL_REFERENCE_IMPL_TUPLE_COMPARATOR_H_
 #define ZETASQL_REFERENCE_IMPL_TUPLE_COMPARATOR_H_
 
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "zetasql/common/internal_value.h"
 #include "zetasql/public/collator.h"
+#include "zetasql/public/value.h"
 #include "zetasql/reference_impl/common.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
 #include "zetasql/base/status.h"
@@ -52,7 +56,9 @@ class TupleComparator {
       absl::Span<const TupleData* const> params, EvaluationContext* context);
 
   // Returns true if t1 is less than t2.
-  bool operator()(const TupleData& t1, const TupleData& t2) const;
+  bool operator()(const TupleData& t1, const TupleData& t2) const {
+    return Compare(t1, /*sort_keys1=*/nullptr, t2, /*sort_keys2=*/nullptr);
+  }
 
   // t1 and t2  must not be NULL.
   bool operator()(const TupleData* t1, const TupleData* t2) const {
@@ -82,16 +88,75 @@ class TupleComparator {
 
   const std::vector<const KeyArg*>& keys() const { return keys_; }
 
+  // Comparing two strings with a (non-binary) collator is expensive, so a
+  // caller that compares every tuple many times, like a sort, can instead
+  // compute the collation sort keys of each tuple once with
+  // AppendCollationSortKeys() and pass them to Compare().
+
+  // Returns the number of collation sort keys of a tuple.
+  int num_collation_sort_keys() const { return num_collation_sort_keys_; }
+
+  // Appends the num_collation_sort_keys() collation sort keys of 't' to
+  // 'sort_keys', and returns their total size in bytes.
+  absl::StatusOr<int64_t> AppendCollationSortKeys(
+      const TupleData& t, std::vector<std::string>* sort_keys) const;
+
+  // Returns true if t1 is less than t2. 'sort_keys1' and 'sort_keys2' are
+  // either both NULL or point to the collation sort keys of t1 and t2.
+  bool Compare(const TupleData& t1, const std::string* sort_keys1,
+               const TupleData& t2, const std::string* sort_keys2) const;
+
+  // Cheaper still, a sort can encode all the keys of each tuple into one
+  // normalized sort key with AppendNormalizedSortKey(), and then compare the
+  // tuples by comparing their normalized sort keys as byte strings.
+
+  // Returns true if every key has a type that AppendNormalizedSortKey()
+  // supports.
+  bool SupportsNormalizedSortKeys() const {
+    return supports_normalized_sort_keys_;
+  }
+
+  // Appends the normalized sort key of 't' to 'key'. For any two tuples, their
+  // normalized sort keys compare like the tuples do with this comparator, and
+  // are equal if and only if neither tuple is less than the other. Requires
+  // SupportsNormalizedSortKeys().
+  absl::Status AppendNormalizedSortKey(const TupleData& t,
+                                       std::string* key) const;
+
  private:
+  // Three-way compares two non-NULL values of a sort key, returning a negative
+  // number, 0 or a positive number.
+  using ValueCompareFn = int (*)(const Value& v1, const Value& v2);
+
+  // Everything needed to compare a sort key, fixed when the comparator is
+  // created so that comparisons do not need to consult the KeyArg or dispatch
+  // on the key type.
+  struct KeyComparator {
+    int slot_idx;
+    bool descending;
+    // Whether NULLs sort before non-NULLs.
+    bool nulls_first;
+    // NULL if the key has no collation, or a binary one.
+    const ZetaSqlCollator* collator;
+    // The index of the key among the collation sort keys of a tuple, or -1 if
+    // 'collator' is NULL.
+    int sort_key_idx;
+    ValueCompareFn compare;
+    // The type kind of the key, for AppendNormalizedSortKey().
+    TypeKind kind;
+  };
+
   TupleComparator(absl::Span<const KeyArg* const> keys,
                   absl::Span<const int> slots_for_keys,
                   absl::Span<const int> extra_sort_key_slots,
-                  std::shared_ptr<const CollatorList> collators)
-      : keys_(keys.begin(), keys.end()),
-        slots_for_keys_(slots_for_keys.begin(), slots_for_keys.end()),
-        extra_sort_key_slots_(extra_sort_key_slots.begin(),
-                              extra_sort_key_slots.end()),
-        collators_(collators) {}
+                  std::shared_ptr<const CollatorList> collators);
+
+  // Returns the comparison function for non-NULL values of type 'type' (or of
+  // any type, if 'type' is NULL).
+  static ValueCompareFn GetValueCompareFn(const Type* type);
+
+  // Returns true if AppendNormalizedSortKey() can encode keys of type 'kind'.
+  static bool SupportsNormalizedSortKey(TypeKind kind);
 
   const std::vector<const KeyArg*> keys_;
   const std::vector<int> slots_for_keys_;
@@ -107,6 +172,12 @@ class TupleComparator {
   // compared based on their UTF-8 encoding.
   // We use std::shared_ptr<const ...> to allow the comparator to be copied.
   const std::shared_ptr<const CollatorList> collators_;
+
+  // One for each of 'keys_' followed by one for each of
+  // 'extra_sort_key_slots_'.
+  std::vector<KeyComparator> key_comparators_;
+  int num_collation_sort_keys_ = 0;
+  bool supports_normalized_sort_keys_ = true;
 };
 
 }  // namespace zetasql
@@ -17,13 +17,16 @@
 #include "zetasql/reference_impl/tuple.h"
 
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "google/protobuf/descriptor.h"
 #include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/memory_pool.h"
 #include "zetasql/public/types/type_factory.h"
 #include "zetasql/public/value.h"
 #include "zetasql/reference_impl/operator.h"
@@ -34,7 +37,10 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
 
+using ::testing::Each;
 using ::testing::ElementsAre;
 using ::testing::HasSubstr;
 using ::zetasql_base::testing::StatusIs;
@@ -103,6 +109,30 @@ TEST(TupleSlotTest, GetPhysicalByteSize) {
   EXPECT_GT(shared_state_slot.GetPhysicalByteSize(), last_byte_size);
 }
 
+TEST(TupleDataTest, ArenaSlots) {
+  zetasql_base::UnsafeArena arena(/*block_size=*/1024);
+  const size_t arena_bytes = arena.status().bytes_allocated();
+  TupleData data(/*num_slots=*/2, &arena);
+  EXPECT_EQ(data.slots().get_allocator().arena(), &arena);
+  EXPECT_GT(arena.status().bytes_allocated(), arena_bytes);
+  data.mutable_slot(0)->SetValue(Int64(10));
+  data.mutable_slot(3)->SetValue(String("foo"));
+  EXPECT_EQ(4, data.num_slots());
+
+  // Copies use the heap unless given an arena, so they may outlive 'arena'.
+  const TupleData heap_copy(data);
+  EXPECT_EQ(heap_copy.slots().get_allocator().arena(), nullptr);
+  EXPECT_EQ(heap_copy, data);
+  const TupleData arena_copy(data, &arena);
+  EXPECT_EQ(arena_copy.slots().get_allocator().arena(), &arena);
+  EXPECT_EQ(arena_copy, data);
+
+  // Moves keep the arena.
+  TupleData moved(std::move(data));
+  EXPECT_EQ(moved.slots().get_allocator().arena(), &arena);
+  EXPECT_EQ(moved, heap_copy);
+}
+
 TEST(TupleDataTest, BasicTests) {
   TupleData data(/*num_slots=*/3);
   EXPECT_EQ(3, data.num_slots());
@@ -115,7 +145,7 @@ TEST(TupleDataTest, BasicTests) {
   EXPECT_EQ(Int64(20), data.slot(1).value());
   EXPECT_EQ(Int64(30), data.slot(2).value());
 
-  const std::vector<TupleSlot>& slots = data.slots();
+  const TupleData::SlotVector& slots = data.slots();
   EXPECT_EQ(Int64(10), slots[0].value());
   EXPECT_EQ(Int64(20), slots[1].value());
   EXPECT_EQ(Int64(30), slots[2].value());
@@ -171,6 +201,64 @@ TEST(TupleDataTest, Equals) {
   EXPECT_FALSE(data1.Equals(data4));
 }
 
+TEST(TupleKeyHashTest, ConsistentWithTupleDataEquals) {
+  const std::vector<const Type*> key_types = {
+      types::Int64Type(), types::StringType(), Int64ArrayType()};
+  const TupleKeyHash hash(key_types);
+  const TupleKeyEq eq(key_types);
+
+  // The last slot has no expected type, and one row has a UINT64 value in the
+  // INT64 slot.
+  const std::vector<TupleData> datas = {
+      CreateTupleDataFromValues(
+          {Int64(1), String("a"), Int64Array({1, 2}), Bool(true)}),
+      CreateTupleDataFromValues(
+          {Int64(1), String("b"), Int64Array({1, 2}), Bool(true)}),
+      CreateTupleDataFromValues(
+          {Int64(1), String("a"), Int64Array({1, 3}), Bool(true)}),
+      CreateTupleDataFromValues(
+          {Int64(1), String("a"), Int64Array({1, 2}), Bool(false)}),
+      CreateTupleDataFromValues(
+          {NullInt64(), String("a"), Int64Array({1, 2}), Bool(true)}),
+      CreateTupleDataFromValues(
+          {Int64(2), NullString(), Int64Array({1, 2}), Bool(true)}),
+      CreateTupleDataFromValues(
+          {Uint64(1), String("a"), Int64Array({1, 2}), Bool(true)}),
+      CreateTupleDataFromValues({Int64(1), String("a"), Int64Array({1, 2})}),
+  };
+  for (const TupleData& data1 : datas) {
+    for (const TupleData& data2 : datas) {
+      EXPECT_EQ(eq(data1, data2), data1 == data2)
+          << data1.DebugString() << " vs " << data2.DebugString();
+    }
+    const TupleData copy = data1;
+    EXPECT_TRUE(eq(data1, copy));
+    EXPECT_EQ(hash(data1), hash(copy));
+    EXPECT_EQ(hash(data1), hash(TupleDataPtr(&copy)));
+  }
+}
+
+TEST(TupleKeyHashTest, StringHashIsCachedWithContent) {
+  for (const Type* type : {types::StringType(), types::BytesType()}) {
+    const TupleKeyHash::SlotHashFn hash = TupleKeyHash::GetSlotHashFn(type);
+    const TupleKeyEq::SlotEqFn eq = TupleKeyEq::GetSlotEqFn(type);
+    const Value value = type->IsString() ? String("abc") : Bytes("abc");
+    const Value shared = value;
+    const Value separate = type->IsString() ? String("abc") : Bytes("abc");
+    const Value other = type->IsString() ? String("abd") : Bytes("abd");
+
+    const size_t value_hash = hash(value);
+    EXPECT_EQ(hash(value), value_hash);
+    EXPECT_EQ(hash(shared), value_hash);
+    EXPECT_EQ(hash(separate), value_hash);
+    EXPECT_NE(hash(other), value_hash);
+    EXPECT_TRUE(eq(value, shared));
+    EXPECT_TRUE(eq(value, separate));
+    EXPECT_FALSE(eq(value, other));
+    EXPECT_FALSE(eq(value, Value::Null(type)));
+  }
+}
+
 TEST(Tuple, DebugString) {
   TupleSchema schema({VariableId("foo"), VariableId("bar")});
   TupleData data = CreateTupleDataFromValues({Int64(10), NullInt64()});
@@ -270,6 +358,39 @@ TEST(MemoryAccountant, BasicTest) {
   accountant.ReturnBytes(50);
 }
 
+TEST(MemoryAccountant, ReservesFromPool) {
+  constexpr int64_t kChunkBytes = MemoryAccountant::kPoolReservationChunkBytes;
+  MemoryPool pool(/*max_bytes=*/3 * kChunkBytes, /*parent=*/nullptr,
+                  "test_pool");
+  absl::Status status;
+  {
+    MemoryAccountant accountant(/*total_num_bytes=*/10 * kChunkBytes,
+                                "test_limit", &pool);
+    // Small requests reserve a whole chunk from the pool.
+    EXPECT_TRUE(accountant.RequestBytes(100, &status));
+    ZETASQL_EXPECT_OK(status);
+    EXPECT_EQ(pool.reserved_bytes(), kChunkBytes);
+
+    // Running out of the pool fails like running out of the accountant.
+    EXPECT_FALSE(accountant.RequestBytes(3 * kChunkBytes, &status));
+    EXPECT_THAT(status,
+                StatusIs(absl::StatusCode::kResourceExhausted,
+                         HasSubstr("Out of memory for MemoryPool(test_pool)")));
+    EXPECT_EQ(accountant.remaining_bytes(), 10 * kChunkBytes - 100);
+    status = absl::OkStatus();
+
+    EXPECT_TRUE(accountant.RequestBytes(2 * kChunkBytes, &status));
+    ZETASQL_EXPECT_OK(status);
+    EXPECT_EQ(accountant.peak_bytes(), 2 * kChunkBytes + 100);
+
+    // Returned bytes go back to the pool, except for a chunk of headroom.
+    accountant.ReturnBytes(2 * kChunkBytes);
+    accountant.ReturnBytes(100);
+    EXPECT_EQ(pool.reserved_bytes(), kChunkBytes);
+  }
+  EXPECT_EQ(pool.reserved_bytes(), 0);
+}
+
 TEST(TupleDataDeque, PushAndPopTest) {
   MemoryAccountant accountant(/*total_num_bytes=*/1000, "test_limit");
 
@@ -341,6 +462,27 @@ TEST(TupleDataDeque, DestructorTest) {
   EXPECT_EQ(accountant.remaining_bytes(), 1000);
 }
 
+TEST(TupleDataDeque, ArenaEntries) {
+  zetasql_base::UnsafeArena arena(/*block_size=*/1024);
+  const size_t arena_bytes = arena.status().bytes_allocated();
+  MemoryAccountant accountant(/*total_num_bytes=*/1000, "test_limit");
+  {
+    TupleDataDeque deque(&accountant, &arena);
+    absl::Status status;
+    for (int i = 0; i < 3; ++i) {
+      ASSERT_TRUE(deque.PushBack(std::make_unique<TupleData>(
+                                     CreateTupleDataFromValues({Int64(i)})),
+                                 &status));
+    }
+    EXPECT_GT(arena.status().bytes_allocated(), arena_bytes);
+    // The arena does not change what is charged to the accountant.
+    EXPECT_LT(accountant.remaining_bytes(), 1000);
+    EXPECT_EQ(deque.PopFront()->slot(0).value(), Int64(0));
+    EXPECT_EQ(deque.GetSize(), 2);
+  }
+  EXPECT_EQ(accountant.remaining_bytes(), 1000);
+}
+
 TEST(TupleDataDeque, SetSlotTest) {
   MemoryAccountant accountant(/*total_num_bytes=*/10000, "test_limit");
   TupleDataDeque deque(&accountant);
@@ -419,6 +561,59 @@ TEST(TupleDataDeque, SetSlotTest) {
   }
 }
 
+TEST(TupleDataDeque, SharedContentChargedOnce) {
+  const Value big_string = String(std::string(1000, 'x'));
+  TupleData data(/*num_slots=*/1);
+  data.mutable_slot(0)->SetValue(big_string);
+  const int64_t tuple_size = data.GetPhysicalByteSize();
+
+  // Each tuple copies 'big_string', so its content is only charged for by the
+  // first tuple.
+  MemoryAccountant accountant(/*total_num_bytes=*/tuple_size * 3, "test_limit");
+  TupleDataDeque deque(&accountant);
+  const int num_tuples = 10;
+  for (int i = 0; i < num_tuples; ++i) {
+    absl::Status status;
+    ASSERT_TRUE(deque.PushBack(std::make_unique<TupleData>(data), &status))
+        << status;
+  }
+
+  // A distinct string of the same size is charged in full.
+  std::unique_ptr<TupleData> other_data = std::make_unique<TupleData>(1);
+  other_data->mutable_slot(0)->SetValue(String(std::string(1000, 'x')));
+  absl::Status status;
+  ASSERT_TRUE(deque.TryPushBack(&other_data, &status)) << status;
+  other_data = std::make_unique<TupleData>(1);
+  other_data->mutable_slot(0)->SetValue(String(std::string(1000, 'y')));
+  EXPECT_FALSE(deque.TryPushBack(&other_data, &status));
+  EXPECT_THAT(status, StatusIs(absl::StatusCode::kResourceExhausted));
+  EXPECT_NE(other_data, nullptr);
+
+  deque.Clear();
+  EXPECT_EQ(accountant.remaining_bytes(), tuple_size * 3);
+}
+
+TEST(ValueHashSet, SharedContentChargedOnce) {
+  const Value big_string = String(std::string(1000, 'x'));
+  MemoryAccountant accountant(/*total_num_bytes=*/10000, "test_limit");
+  ValueHashSet set(&accountant);
+
+  bool inserted;
+  absl::Status status;
+  ASSERT_TRUE(set.Insert(big_string, &inserted, &status));
+  const int64_t one_string_bytes = 10000 - accountant.remaining_bytes();
+
+  // An array of copies of 'big_string' only charges for the array itself.
+  ASSERT_TRUE(set.Insert(
+      Value::Array(types::StringArrayType(), {big_string, big_string}),
+      &inserted, &status));
+  EXPECT_TRUE(inserted);
+  EXPECT_LT(10000 - accountant.remaining_bytes(), 2 * one_string_bytes);
+
+  set.Clear();
+  EXPECT_EQ(accountant.remaining_bytes(), 10000);
+}
+
 TEST(TupleDataOrderedQueue, InsertAndPopTest) {
   VariableId k1("k1"), k2("k2");
   TupleSchema schema({k1});
@@ -564,6 +759,97 @@ TEST(ValueHashSet, DestructorTest) {
   EXPECT_EQ(accountant.remaining_bytes(), 1000);
 }
 
+// Inserts 'values' into 'set' and returns which of them were inserted.
+std::vector<bool> InsertAll(ValueHashSet& set, absl::Span<const Value> values) {
+  std::vector<bool> inserted_values;
+  for (const Value& value : values) {
+    bool inserted;
+    absl::Status status;
+    EXPECT_TRUE(set.Insert(value, &inserted, &status));
+    ZETASQL_EXPECT_OK(status);
+    inserted_values.push_back(inserted);
+  }
+  return inserted_values;
+}
+
+TEST(ValueHashSet, CompactKeys) {
+  MemoryAccountant accountant(/*total_num_bytes=*/10000, "test_limit");
+  ValueHashSet set(&accountant);
+  EXPECT_THAT(InsertAll(set, {Int64(3), Int64(1), Int64(3), Int64(-2),
+                              Int64(1), NullInt64(), NullInt64()}),
+              ElementsAre(true, true, false, true, false, true, false));
+  set.Clear();
+  EXPECT_EQ(accountant.remaining_bytes(), 10000);
+
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_THAT(InsertAll(set, {Double(0), Double(-0.0), Double(nan),
+                              Double(-nan), Double(-1), Double(1)}),
+              ElementsAre(true, false, true, false, true, true));
+  set.Clear();
+
+  const std::string long_string(ValueHashSet::kMaxCompactStringSize + 1, 'x');
+  EXPECT_THAT(
+      InsertAll(set, {String("b"), String(""), String("b"), String(long_string),
+                      String(""), String(long_string), String("a")}),
+      ElementsAre(true, true, false, true, false, false, true));
+  set.Clear();
+  EXPECT_EQ(accountant.remaining_bytes(), 10000);
+}
+
+TEST(ValueHashSet, SortedThenUnorderedKeys) {
+  MemoryAccountant accountant(/*total_num_bytes=*/100000, "test_limit");
+  ValueHashSet set(&accountant);
+  for (const bool ascending : {true, false}) {
+    std::vector<Value> ints;
+    std::vector<Value> strings;
+    for (int i = 0; i < 100; ++i) {
+      const int key = 2 * (ascending ? i : 99 - i);
+      ints.push_back(Int64(key));
+      strings.push_back(String(absl::StrCat("k", 1000 + key)));
+    }
+    // Neither is in order with the keys above.
+    const Value missing_int = Int64(51);
+    const Value missing_string = String("k1051");
+    for (const auto& [values, missing] :
+         {std::make_pair(ints, missing_int),
+          std::make_pair(strings, missing_string)}) {
+      EXPECT_THAT(InsertAll(set, values), Each(true)) << ascending;
+      // Keys are found whether they come in order or not.
+      EXPECT_THAT(InsertAll(set, {values[50], values.back(), values[0]}),
+                  Each(false));
+      // The first new key out of order moves the keys to a hash set.
+      EXPECT_THAT(InsertAll(set, {missing, missing}), ElementsAre(true, false));
+      EXPECT_THAT(InsertAll(set, values), Each(false));
+      set.Clear();
+      EXPECT_EQ(accountant.remaining_bytes(), 100000);
+    }
+  }
+  EXPECT_THAT(InsertAll(set, {Int64(5), Int64(7), Int64(6), Int64(9), Int64(5),
+                              Int64(6), Int64(8)}),
+              ElementsAre(true, true, true, true, false, false, true));
+}
+
+TEST(ValueHashSet, StringsChargeTheirBytes) {
+  MemoryAccountant accountant(/*total_num_bytes=*/1000, "test_limit");
+  ValueHashSet set(&accountant);
+  int num_strings = 0;
+  while (true) {
+    bool inserted;
+    absl::Status status;
+    if (!set.Insert(String(absl::StrCat(std::string(16, 'x'), num_strings)),
+                    &inserted, &status)) {
+      EXPECT_THAT(status, StatusIs(absl::StatusCode::kResourceExhausted));
+      break;
+    }
+    ASSERT_TRUE(inserted);
+    ++num_strings;
+  }
+  // Each string costs its bytes and an 8-byte key.
+  EXPECT_GE(num_strings, 1000 / (8 + 16 + 3));
+  set.Clear();
+  EXPECT_EQ(accountant.remaining_bytes(), 1000);
+}
+
 TEST(MemoryReservation, Basic) {
   MemoryAccountant accountant(/*total_num_bytes=*/1000, "test_limit");
   MemoryReservation res(&accountant);
@@ -624,6 +910,59 @@ TEST(MemoryReservation, AccountantDestroyedAfterMove) {
   res1.reset();
 }
 
+TEST(DistinctRowSet, InsertRowIfNotPresent) {
+  TupleData row(1);
+  row.mutable_slot(0)->SetValue(Int64(1));
+  const int64_t row_size = row.GetPhysicalByteSize();
+  MemoryAccountant accountant(/*total_num_bytes=*/2 * row_size, "test_limit");
+  {
+    DistinctRowSet row_set(&accountant);
+    absl::Status status;
+    EXPECT_TRUE(row_set.InsertRowIfNotPresent(row, &status));
+    EXPECT_EQ(row_size, accountant.remaining_bytes());
+
+    // Duplicates are not inserted and do not charge memory.
+    EXPECT_FALSE(row_set.InsertRowIfNotPresent(row, &status));
+    EXPECT_FALSE(row_set.InsertRowIfNotPresent(
+        std::make_unique<TupleData>(row), &status));
+    ZETASQL_EXPECT_OK(status);
+    EXPECT_EQ(row_size, accountant.remaining_bytes());
+
+    row.mutable_slot(0)->SetValue(Int64(2));
+    EXPECT_TRUE(row_set.InsertRowIfNotPresent(row, &status));
+    EXPECT_EQ(0, accountant.remaining_bytes());
+
+    // A row that does not fit is not inserted, so inserting it again fails
+    // the same way instead of finding a duplicate.
+    row.mutable_slot(0)->SetValue(Int64(3));
+    EXPECT_FALSE(row_set.InsertRowIfNotPresent(row, &status));
+    EXPECT_THAT(status, StatusIs(absl::StatusCode::kResourceExhausted));
+    status = absl::OkStatus();
+    EXPECT_FALSE(row_set.InsertRowIfNotPresent(row, &status));
+    EXPECT_THAT(status, StatusIs(absl::StatusCode::kResourceExhausted));
+  }
+  EXPECT_EQ(2 * row_size, accountant.remaining_bytes());
+}
+
+TEST(DistinctRowSet, Arena) {
+  zetasql_base::UnsafeArena arena(/*block_size=*/1024);
+  const size_t arena_bytes = arena.status().bytes_allocated();
+  MemoryAccountant accountant(/*total_num_bytes=*/10000, "test_limit");
+  {
+    DistinctRowSet row_set(&accountant, &arena);
+    absl::Status status;
+    for (int i = 0; i < 20; ++i) {
+      EXPECT_TRUE(row_set.InsertRowIfNotPresent(
+          CreateTupleDataFromValues({Int64(i)}), &status));
+      EXPECT_FALSE(row_set.InsertRowIfNotPresent(
+          CreateTupleDataFromValues({Int64(i)}), &status));
+    }
+    ZETASQL_EXPECT_OK(status);
+    EXPECT_GT(arena.status().bytes_allocated(), arena_bytes);
+  }
+  EXPECT_EQ(accountant.remaining_bytes(), 10000);
+}
+
 TEST(ArrayBuilder, Basic) {
   MemoryAccountant accountant(/*total_num_bytes=*/1000, "test_limit");
   ArrayBuilder builder(&accountant);
@@ -910,5 +1249,63 @@ TEST(PassThroughTupleIterator, Success) {
   EXPECT_EQ(data[1].num_slots(), 2);
 }
 
+TEST(TupleDataBatch, OwnedRowsAreRecycled) {
+  TupleDataBatch batch(/*capacity=*/2);
+  EXPECT_EQ(batch.capacity(), 2);
+  EXPECT_TRUE(batch.empty());
+
+  TupleData* row0 = batch.AddOwnedRow(/*num_slots=*/3);
+  TupleData* row1 =
+      batch.AddOwnedRowCopy(CreateTupleDataFromValues({Int64(1)}));
+  EXPECT_EQ(row0->num_slots(), 3);
+  EXPECT_EQ(row1->num_slots(), 1);
+  EXPECT_EQ(row1->slot(0).value(), Int64(1));
+  EXPECT_TRUE(batch.full());
+  EXPECT_THAT(batch.rows(), ElementsAre(row0, row1));
+
+  batch.Clear();
+  EXPECT_TRUE(batch.empty());
+  EXPECT_EQ(batch.AddOwnedRow(/*num_slots=*/2), row0);
+  EXPECT_EQ(row0->num_slots(), 2);
+
+  TupleData borrowed(/*num_slots=*/1);
+  batch.AddRow(&borrowed);
+  batch.RemovePrefix(1);
+  EXPECT_THAT(batch.rows(), ElementsAre(&borrowed));
+  batch.Truncate(0);
+  EXPECT_TRUE(batch.empty());
+}
+
+TEST(TupleIterator, DefaultNextBatch) {
+  VariableId foo("foo");
+  const std::vector<TupleData> values = {CreateTupleDataFromValues({Int64(1)}),
+                                         CreateTupleDataFromValues({Int64(2)}),
+                                         CreateTupleDataFromValues({Int64(3)})};
+  TestTupleIterator iter({foo}, values, /*preserves_order=*/true,
+                         /*end_status=*/absl::OkStatus());
+  TupleDataBatch batch(/*capacity=*/2);
+  ASSERT_TRUE(iter.NextBatch(&batch));
+  ASSERT_EQ(batch.size(), 2);
+  EXPECT_EQ(batch.row(0)->slot(0).value(), Int64(1));
+  EXPECT_EQ(batch.row(1)->slot(0).value(), Int64(2));
+  ASSERT_TRUE(iter.NextBatch(&batch));
+  ASSERT_EQ(batch.size(), 1);
+  EXPECT_EQ(batch.row(0)->slot(0).value(), Int64(3));
+  EXPECT_FALSE(iter.NextBatch(&batch));
+  EXPECT_TRUE(batch.empty());
+  ZETASQL_EXPECT_OK(iter.Status());
+}
+
+TEST(TupleIterator, DefaultNextBatchFails) {
+  VariableId foo("foo");
+  const std::vector<TupleData> values = {CreateTupleDataFromValues({Int64(1)})};
+  TestTupleIterator iter({foo}, values, /*preserves_order=*/true,
+                         zetasql_base::InternalErrorBuilder() << "Iterator failure");
+  TupleDataBatch batch;
+  EXPECT_FALSE(iter.NextBatch(&batch));
+  EXPECT_THAT(iter.Status(),
+              StatusIs(absl::StatusCode::kInternal, "Iterator failure"));
+}
+
 }  // namespace
 }  // namespace zetasql
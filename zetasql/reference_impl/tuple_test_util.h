@@ -119,6 +119,21 @@ inline absl::StatusOr<std::vector<TupleData>> ReadFromTupleIterator(
   return data;
 }
 
+// Same as ReadFromTupleIterator(), but reads 'iter' with NextBatch() using
+// batches of at most 'batch_size' tuples.
+inline absl::StatusOr<std::vector<TupleData>> ReadFromTupleIteratorInBatches(
+    TupleIterator* iter, int batch_size) {
+  std::vector<TupleData> tuples;
+  TupleDataBatch batch(batch_size);
+  while (iter->NextBatch(&batch)) {
+    for (const TupleData* data : batch.rows()) {
+      tuples.push_back(*data);
+    }
+  }
+  ZETASQL_RETURN_IF_ERROR(iter->Status());
+  return tuples;
+}
+
 // Returns a TupleData corresponding to 'values' where all slots have trivial
 // SharedProtoStates, which are also added to 'shared_states' if it is non-NULL.
 inline TupleData CreateTestTupleData(
@@ -39,7 +39,9 @@
 #include "zetasql/public/types/type.h"
 #include "zetasql/public/types/type_factory.h"
 #include "zetasql/public/value.h"
+#include "zetasql/reference_impl/columnar_batch.h"
 #include "zetasql/reference_impl/evaluation.h"
+#include "zetasql/reference_impl/function.h"
 #include "zetasql/reference_impl/operator.h"
 #include "zetasql/reference_impl/tuple.h"
 #include "zetasql/reference_impl/variable_generator.h"
@@ -605,6 +607,32 @@ ValueExpr* FieldValueExpr::mutable_input() {
 // ProtoFieldReader
 // -------------------------------------------------------
 
+// Protos smaller than this are always read without a ProtoFieldIndex, because
+// the index would not save much work.
+static constexpr int64_t kMinProtoBytesForFieldIndex = 1024;
+
+// Returns the ProtoFieldIndex of 'proto_rep', building it if necessary and
+// allowed. Returns nullptr if the proto should be read without an index.
+static const internal::ProtoFieldIndex* GetProtoFieldIndex(
+    const InternalValue::ProtoRep& proto_rep, EvaluationContext* context) {
+  if (!context->options().use_proto_field_index ||
+      proto_rep.value().size() < kMinProtoBytesForFieldIndex) {
+    return nullptr;
+  }
+  const internal::ProtoFieldIndex* field_index = proto_rep.field_index();
+  if (field_index != nullptr) {
+    return field_index;
+  }
+  absl::StatusOr<std::unique_ptr<internal::ProtoFieldIndex>> new_index =
+      BuildProtoFieldIndex(proto_rep.value());
+  // A corrupted proto is read without an index, to report the same error.
+  if (!new_index.ok() || !context->ReserveProtoFieldIndexBytes(
+                             (*new_index)->physical_byte_size)) {
+    return nullptr;
+  }
+  return proto_rep.SetFieldIndex(*std::move(new_index));
+}
+
 bool ProtoFieldReader::GetFieldValue(const TupleSlot& proto_slot,
                                      EvaluationContext* context,
                                      Value* field_value,
@@ -662,8 +690,14 @@ bool ProtoFieldReader::GetFieldValue(const TupleSlot& proto_slot,
     value_list_owner = std::make_unique<ProtoFieldValueList>();
     value_list = value_list_owner.get();
 
-    const absl::Status read_status = ReadProtoFields(
-        field_infos, proto_value.ToCord(), value_list_owner.get());
+    const absl::Cord& proto_bytes = value_map_key.proto_rep->value();
+    const internal::ProtoFieldIndex* field_index =
+        GetProtoFieldIndex(*value_map_key.proto_rep, context);
+    const absl::Status read_status =
+        field_index == nullptr
+            ? ReadProtoFields(field_infos, proto_bytes, value_list_owner.get())
+            : ReadProtoFields(field_infos, proto_bytes, *field_index,
+                              value_list_owner.get());
     if (!read_status.ok()) {
       *status = read_status;
       return false;
@@ -989,6 +1023,8 @@ bool ExistsExpr::Eval(absl::Span<const TupleData* const> params,
     result->SetValue(Bool(false));
     return true;
   }
+  // One tuple decides the result, so the rest of the input is not needed.
+  iter->Close();
 
   result->SetValue(Bool(true));
   return true;
@@ -1013,6 +1049,91 @@ RelationalOp* ExistsExpr::mutable_input() {
   return GetMutableArg(kInput)->mutable_node()->AsMutableRelationalOp();
 }
 
+// -------------------------------------------------------
+// MemoizedSubqueryExpr
+// -------------------------------------------------------
+
+absl::StatusOr<std::unique_ptr<MemoizedSubqueryExpr>>
+MemoizedSubqueryExpr::Create(std::vector<VariableId> correlated_variables,
+                             std::unique_ptr<ValueExpr> subquery) {
+  return absl::WrapUnique(new MemoizedSubqueryExpr(
+      std::move(correlated_variables), std::move(subquery)));
+}
+
+absl::Status MemoizedSubqueryExpr::SetSchemasForEvaluation(
+    absl::Span<const TupleSchema* const> params_schemas) {
+  correlated_slots_.clear();
+  for (const VariableId& variable : correlated_variables_) {
+    std::optional<std::pair<int, int>> correlated_slot;
+    for (int i = 0; i < params_schemas.size(); ++i) {
+      std::optional<int> slot =
+          params_schemas[i]->FindIndexForVariable(variable);
+      if (slot.has_value()) {
+        ZETASQL_RET_CHECK(!correlated_slot.has_value())
+            << "Duplicate name detected: " << variable;
+        correlated_slot = std::make_pair(i, slot.value());
+      }
+    }
+    ZETASQL_RET_CHECK(correlated_slot.has_value()) << "Missing name: " << variable;
+    correlated_slots_.push_back(correlated_slot.value());
+  }
+  return mutable_subquery()->SetSchemasForEvaluation(params_schemas);
+}
+
+bool MemoizedSubqueryExpr::Eval(absl::Span<const TupleData* const> params,
+                                EvaluationContext* context,
+                                VirtualTupleSlot* result,
+                                absl::Status* status) const {
+  SubqueryResultCache* cache = context->subquery_result_cache();
+  if (cache == nullptr) {
+    return subquery()->Eval(params, context, result, status);
+  }
+
+  std::vector<Value> key;
+  key.reserve(correlated_slots_.size());
+  for (const auto& [idx_in_params, slot] : correlated_slots_) {
+    key.push_back(params[idx_in_params]->slot(slot).value());
+  }
+  const Value* cached_result = cache->Lookup(this, key);
+  if (cached_result != nullptr) {
+    result->SetValue(*cached_result);
+    return true;
+  }
+
+  if (!subquery()->Eval(params, context, result, status)) return false;
+  cache->Insert(this, std::move(key), *result->mutable_value());
+  return true;
+}
+
+std::string MemoizedSubqueryExpr::DebugInternal(const std::string& indent,
+                                                bool verbose) const {
+  std::vector<std::string> variables;
+  variables.reserve(correlated_variables_.size());
+  for (const VariableId& variable : correlated_variables_) {
+    variables.push_back(absl::StrCat("$", variable.ToString()));
+  }
+  return absl::StrCat(
+      "MemoizedSubqueryExpr(correlated_variables=[",
+      absl::StrJoin(variables, ", "), "]",
+      ArgDebugString({"subquery"}, {k1}, indent, verbose), ")");
+}
+
+MemoizedSubqueryExpr::MemoizedSubqueryExpr(
+    std::vector<VariableId> correlated_variables,
+    std::unique_ptr<ValueExpr> subquery)
+    : ValueExpr(subquery->output_type()),
+      correlated_variables_(std::move(correlated_variables)) {
+  SetArg(kSubquery, std::make_unique<ExprArg>(std::move(subquery)));
+}
+
+const ValueExpr* MemoizedSubqueryExpr::subquery() const {
+  return GetArg(kSubquery)->node()->AsValueExpr();
+}
+
+ValueExpr* MemoizedSubqueryExpr::mutable_subquery() {
+  return GetMutableArg(kSubquery)->mutable_node()->AsMutableValueExpr();
+}
+
 // -------------------------------------------------------
 // ScalarFunctionCallExpr
 // -------------------------------------------------------
@@ -1056,9 +1177,88 @@ absl::Status ScalarFunctionCallExpr::SetSchemasForEvaluation(
               params_schemas));
     }
   }
+
+  batch_schema_.reset();
+  batch_column_types_.clear();
+  const auto* builtin =
+      dynamic_cast<const BuiltinScalarFunction*>(function_.get());
+  if (builtin == nullptr ||
+      error_mode_ != ResolvedFunctionCallBase::DEFAULT_ERROR_MODE ||
+      params_schemas.empty() || !TupleColumn::SupportsType(output_type())) {
+    return absl::OkStatus();
+  }
+  const TupleSchema* batch_schema = params_schemas.back();
+  std::vector<const Type*> column_types(batch_schema->num_variables(),
+                                        nullptr);
+  std::vector<const Type*> arg_types;
+  arg_types.reserve(args.size());
+  for (const AlgebraArg* arg : args) {
+    const ValueExpr* expr = arg->value_expr();
+    if (expr == nullptr || !TupleColumn::SupportsType(expr->output_type())) {
+      return absl::OkStatus();
+    }
+    if (const auto* deref = dynamic_cast<const DerefExpr*>(expr);
+        deref != nullptr) {
+      const std::optional<int> idx =
+          batch_schema->FindIndexForVariable(deref->name());
+      if (!idx.has_value()) return absl::OkStatus();
+      column_types[idx.value()] = expr->output_type();
+    } else if (const auto* call =
+                   dynamic_cast<const ScalarFunctionCallExpr*>(expr);
+               call != nullptr) {
+      if (!call->SupportsEvalBatch()) return absl::OkStatus();
+    } else if (dynamic_cast<const ConstExpr*>(expr) == nullptr) {
+      return absl::OkStatus();
+    }
+    arg_types.push_back(expr->output_type());
+  }
+  if (!builtin->SupportsEvalColumns(arg_types)) return absl::OkStatus();
+
+  batch_schema_ = std::make_unique<const TupleSchema>(batch_schema->variables());
+  batch_column_types_ = std::move(column_types);
   return absl::OkStatus();
 }
 
+bool ScalarFunctionCallExpr::EvalBatch(const TupleDataBatch& batch,
+                                       EvaluationContext* context,
+                                       TupleColumn* result,
+                                       absl::Status* status) const {
+  ABSL_DCHECK(SupportsEvalBatch());
+  ColumnarTupleBatch columns(batch_schema_.get(), batch_column_types_);
+  *status = columns.Load(batch);
+  if (!status->ok()) return false;
+
+  const auto& args = GetArgs<AlgebraArg>(kArgument);
+  std::vector<const TupleColumn*> arg_columns;
+  arg_columns.reserve(args.size());
+  // Holds the columns of the arguments that are not read from 'batch'.
+  std::vector<std::unique_ptr<TupleColumn>> computed_columns;
+  for (const AlgebraArg* arg : args) {
+    const ValueExpr* expr = arg->value_expr();
+    if (const auto* deref = dynamic_cast<const DerefExpr*>(expr);
+        deref != nullptr) {
+      arg_columns.push_back(columns.column_for_variable(deref->name()));
+      continue;
+    }
+    auto column = std::make_unique<TupleColumn>(expr->output_type());
+    if (const auto* call = dynamic_cast<const ScalarFunctionCallExpr*>(expr);
+        call != nullptr) {
+      if (!call->EvalBatch(batch, context, column.get(), status)) {
+        return false;
+      }
+    } else {
+      const Value& value = static_cast<const ConstExpr*>(expr)->value();
+      for (int i = 0; i < batch.size(); ++i) {
+        column->Append(value);
+      }
+    }
+    arg_columns.push_back(column.get());
+    computed_columns.push_back(std::move(column));
+  }
+  return static_cast<const BuiltinScalarFunction*>(function_.get())
+      ->EvalColumns(arg_columns, context, result, status);
+}
+
 bool ScalarFunctionCallExpr::Eval(absl::Span<const TupleData* const> params,
                                   EvaluationContext* context,
                                   VirtualTupleSlot* result,
@@ -1080,8 +1280,17 @@ bool ScalarFunctionCallExpr::Eval(absl::Span<const TupleData* const> params,
     }
   }
 
-  if (!function_->Eval(params, call_args, context, result->mutable_value(),
-                       status)) {
+  bool ok;
+  if (context->tracer() == nullptr) {
+    ok = function_->Eval(params, call_args, context, result->mutable_value(),
+                         status);
+  } else {
+    const absl::Time start = absl::Now();
+    ok = function_->Eval(params, call_args, context, result->mutable_value(),
+                         status);
+    context->RecordTracedFunctionCall(function_.get(), absl::Now() - start);
+  }
+  if (!ok) {
     if (ShouldSuppressError(*status, error_mode_)) {
       *status = absl::OkStatus();
       result->SetValue(Value::Null(output_type()));
@@ -1424,6 +1633,91 @@ ValueExpr* IfErrorExpr::mutable_handle_value() {
   return GetMutableArg(kHandleValue)->mutable_node()->AsMutableValueExpr();
 }
 
+// -------------------------------------------------------
+// InListExpr
+// -------------------------------------------------------
+
+bool InListExpr::SupportsType(const Type* type) {
+  switch (type->kind()) {
+    case TYPE_BOOL:
+    case TYPE_INT32:
+    case TYPE_INT64:
+    case TYPE_UINT32:
+    case TYPE_UINT64:
+    case TYPE_STRING:
+    case TYPE_BYTES:
+    case TYPE_DATE:
+      return true;
+    default:
+      // Floating point types are excluded because of NaN and -0.0, and
+      // others because their Value equality is stricter than SQL equality.
+      return false;
+  }
+}
+
+absl::StatusOr<std::unique_ptr<InListExpr>> InListExpr::Create(
+    std::unique_ptr<ValueExpr> value, absl::Span<const Value> elements) {
+  const Type* type = value->output_type();
+  ZETASQL_RET_CHECK(SupportsType(type)) << type->DebugString();
+  absl::flat_hash_set<Value> element_set;
+  element_set.reserve(elements.size());
+  bool has_null_element = false;
+  for (const Value& element : elements) {
+    ZETASQL_RET_CHECK(element.type()->Equals(type));
+    if (element.is_null()) {
+      has_null_element = true;
+    } else {
+      element_set.insert(element);
+    }
+  }
+  return absl::WrapUnique(new InListExpr(
+      std::move(value), std::move(element_set), has_null_element));
+}
+
+absl::Status InListExpr::SetSchemasForEvaluation(
+    absl::Span<const TupleSchema* const> params_schemas) {
+  return mutable_value()->SetSchemasForEvaluation(params_schemas);
+}
+
+bool InListExpr::Eval(absl::Span<const TupleData* const> params,
+                      EvaluationContext* context, VirtualTupleSlot* result,
+                      absl::Status* status) const {
+  TupleSlot slot;
+  if (!value()->EvalSimple(params, context, &slot, status)) return false;
+  if (slot.value().is_null()) {
+    result->SetValue(Value::NullBool());
+  } else if (elements_.contains(slot.value())) {
+    result->SetValue(Bool(true));
+  } else {
+    result->SetValue(has_null_element_ ? Value::NullBool() : Bool(false));
+  }
+  return true;
+}
+
+std::string InListExpr::DebugInternal(const std::string& indent,
+                                      bool verbose) const {
+  return absl::StrCat(
+      "InListExpr(", ArgDebugString({"value"}, {k1}, indent, verbose),
+      ", num_distinct_elements: ", elements_.size() + has_null_element_, ")");
+}
+
+InListExpr::InListExpr(std::unique_ptr<ValueExpr> value,
+                       absl::flat_hash_set<Value> elements,
+                       bool has_null_element)
+    : ValueExpr(types::BoolType()),
+      elements_(std::move(elements)),
+      has_null_element_(has_null_element) {
+  SetArg(kValue, std::make_unique<ExprArg>(std::move(value)));
+}
+
+const ValueExpr* InListExpr::value() const {
+  return GetArg(kValue)->node()->AsValueExpr();
+}
+
+ValueExpr* InListExpr::mutable_value() {
+  return GetMutableArg(kValue)->mutable_node()->AsMutableValueExpr();
+}
+
 // -------------------------------------------------------
 // IsErrorExpr
 // -------------------------------------------------------
@@ -1743,12 +2037,18 @@ bool InlineLambdaExpr::Eval(absl::Span<const TupleData* const> params,
   }
 
   // Evaluate lambda body with the new data.
-  if (!GetArg(kBody)->value_expr()->Eval(
-          ConcatSpans(params, {array_element_data.get()}), context, result,
-          status)) {
-    return false;
-  }
-  return true;
+  return EvalBody(ConcatSpans(params, {array_element_data.get()}), context,
+                  result, status);
+}
+
+bool InlineLambdaExpr::EvalBody(
+    absl::Span<const TupleData* const> params_and_args,
+    EvaluationContext* context, VirtualTupleSlot* result,
+    absl::Status* status) const {
+  ABSL_DCHECK(!params_and_args.empty());
+  ABSL_DCHECK_EQ(params_and_args.back()->num_slots(), num_args());
+  return GetArg(kBody)->value_expr()->Eval(params_and_args, context, result,
+                                           status);
 }
 
 size_t InlineLambdaExpr::num_args() const {
@@ -2212,10 +2512,12 @@ absl::Status DMLValueExpr::EvalGeneratedColumnsByTopologicalOrder(
 }
 
 // Evaluates 'op' on 'params', then populates 'schema' and 'datas' with the
-// corresponding TupleSchema and TupleDatas.
+// corresponding TupleSchema and TupleDatas. The memory of 'datas' is charged to
+// 'reservation', which must outlive them.
 static absl::Status EvalRelationalOp(
     const RelationalOp& op, absl::Span<const TupleData* const> params,
-    EvaluationContext* context, std::unique_ptr<TupleSchema>* schema,
+    EvaluationContext* context, MemoryReservation* reservation,
+    std::unique_ptr<TupleSchema>* schema,
     std::vector<std::unique_ptr<TupleData>>* datas) {
   ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<TupleIterator> iter,
                    op.CreateIterator(params, /*num_extra_slots=*/0, context));
@@ -2232,6 +2534,10 @@ static absl::Status EvalRelationalOp(
       ZETASQL_RETURN_IF_ERROR(iter->Status());
       break;
     }
+    absl::Status status;
+    if (!reservation->Increase(data->GetPhysicalByteSize(), &status)) {
+      return status;
+    }
     datas->push_back(std::make_unique<TupleData>(*data));
   }
   return absl::OkStatus();
@@ -2302,10 +2608,11 @@ absl::StatusOr<Value> DMLDeleteValueExpr::Eval(
   ZETASQL_ASSIGN_OR_RETURN(const RelationalOp* relational_op,
                    LookupResolvedScan(stmt()->table_scan()));
 
+  MemoryReservation reservation(context->memory_accountant());
   std::unique_ptr<TupleSchema> tuple_schema;
   std::vector<std::unique_ptr<TupleData>> tuple_datas;
   ZETASQL_RETURN_IF_ERROR(EvalRelationalOp(*relational_op, params, context,
-                                   &tuple_schema, &tuple_datas));
+                                   &reservation, &tuple_schema, &tuple_datas));
   for (const std::unique_ptr<TupleData>& tuple_data : tuple_datas) {
     // It is expensive to call this for every row, but this code is only used
     // for compliance testing, so it's ok.
@@ -2382,13 +2689,14 @@ absl::StatusOr<std::unique_ptr<DMLUpdateValueExpr>> DMLUpdateValueExpr::Create(
     std::unique_ptr<const ColumnToVariableMapping> column_to_variable_mapping,
     std::unique_ptr<const ResolvedScanMap> resolved_scan_map,
     std::unique_ptr<const ResolvedExprMap> resolved_expr_map,
-    std::unique_ptr<const ColumnExprMap> column_expr_map) {
+    std::unique_ptr<const ColumnExprMap> column_expr_map,
+    std::vector<JoinKey> join_keys) {
   return absl::WrapUnique(new DMLUpdateValueExpr(
       table, table_array_type, returning_array_type, primary_key_type,
       dml_output_type, resolved_node, column_list,
       std::move(returning_column_values), std::move(column_to_variable_mapping),
       std::move(resolved_scan_map), std::move(resolved_expr_map),
-      std::move(column_expr_map)));
+      std::move(column_expr_map), std::move(join_keys)));
 }
 
 absl::Status DMLUpdateValueExpr::SetSchemasForEvaluation(
@@ -2419,6 +2727,20 @@ absl::Status DMLUpdateValueExpr::SetSchemasForEvaluation(
                    LookupResolvedExpr(stmt()->where_expr()));
   ZETASQL_RETURN_IF_ERROR(where_expr->SetSchemasForEvaluation(joined_schemas));
 
+  if (!join_keys_.empty()) {
+    ZETASQL_RET_CHECK(from_scan_schema != nullptr);
+    for (const JoinKey& join_key : join_keys_) {
+      ZETASQL_ASSIGN_OR_RETURN(ValueExpr * target_expr,
+                       LookupResolvedExpr(join_key.target));
+      ZETASQL_RETURN_IF_ERROR(target_expr->SetSchemasForEvaluation(
+          ConcatSpans(params_schemas, {table_scan_schema.get()})));
+      ZETASQL_ASSIGN_OR_RETURN(ValueExpr * from_expr,
+                       LookupResolvedExpr(join_key.from));
+      ZETASQL_RETURN_IF_ERROR(from_expr->SetSchemasForEvaluation(
+          ConcatSpans(params_schemas, {from_scan_schema.get()})));
+    }
+  }
+
   for (const std::unique_ptr<const ResolvedUpdateItem>& update_item :
        stmt()->update_item_list()) {
     ZETASQL_RETURN_IF_ERROR(
@@ -2446,11 +2768,16 @@ absl::Status DMLUpdateValueExpr::SetSchemasForEvaluation(
 absl::StatusOr<Value> DMLUpdateValueExpr::Eval(
     absl::Span<const TupleData* const> params,
     EvaluationContext* context) const {
+  // Accounts for the memory of the materialized tuples and of 'join_index'.
+  MemoryReservation reservation(context->memory_accountant());
   // Schema of tuples from the from scan. NULL if there is no from scan.
   std::unique_ptr<TupleSchema> from_schema;
   // Consists of one tuple per row of the table in the from scan. NULL if there
   // is no from scan.
   std::unique_ptr<std::vector<std::unique_ptr<TupleData>>> from_tuples;
+  // Maps the values of the 'from' expressions of 'join_keys_' to the indexes
+  // of the entries of 'from_tuples' with those values.
+  absl::flat_hash_map<std::vector<Value>, std::vector<int64_t>> join_index;
 
   if (stmt()->from_scan() != nullptr) {
     ZETASQL_ASSIGN_OR_RETURN(const RelationalOp* relational_op,
@@ -2459,7 +2786,27 @@ absl::StatusOr<Value> DMLUpdateValueExpr::Eval(
     std::unique_ptr<TupleSchema> from_schema;
     from_tuples = std::make_unique<std::vector<std::unique_ptr<TupleData>>>();
     ZETASQL_RETURN_IF_ERROR(EvalRelationalOp(*relational_op, params, context,
-                                     &from_schema, from_tuples.get()));
+                                     &reservation, &from_schema,
+                                     from_tuples.get()));
+
+    if (!join_keys_.empty()) {
+      std::vector<Value> key;
+      for (int64_t i = 0; i < from_tuples->size(); ++i) {
+        ZETASQL_ASSIGN_OR_RETURN(const bool has_key,
+                         EvalJoinKey(params, (*from_tuples)[i].get(),
+                                     /*is_target=*/false, context, &key));
+        if (!has_key) continue;
+        int64_t num_bytes = sizeof(int64_t);
+        for (const Value& value : key) {
+          num_bytes += value.physical_byte_size();
+        }
+        absl::Status status;
+        if (!reservation.Increase(num_bytes, &status)) {
+          return status;
+        }
+        join_index[key].push_back(i);
+      }
+    }
   }
 
   ZETASQL_ASSIGN_OR_RETURN(const ValueExpr* where_expr,
@@ -2475,17 +2822,29 @@ absl::StatusOr<Value> DMLUpdateValueExpr::Eval(
   std::unique_ptr<TupleSchema> tuple_schema;
   std::vector<std::unique_ptr<TupleData>> tuples;
   ZETASQL_RETURN_IF_ERROR(EvalRelationalOp(*relational_op, params, context,
-                                   &tuple_schema, &tuples));
+                                   &reservation, &tuple_schema, &tuples));
+  const std::vector<int64_t> no_from_indexes;
+  std::vector<Value> key;
   for (const std::unique_ptr<TupleData>& tuple_data : tuples) {
     // It is expensive to call this for every row, but this code is only used
     // for compliance testing, so it's ok.
     ZETASQL_RETURN_IF_ERROR(context->VerifyNotAborted());
 
     const Tuple tuple(tuple_schema.get(), tuple_data.get());
+    // The indexes of the 'from_tuples' that may match 'tuple', or NULL for
+    // all of them.
+    const std::vector<int64_t>* from_indexes = nullptr;
+    if (from_tuples != nullptr && !join_keys_.empty()) {
+      ZETASQL_ASSIGN_OR_RETURN(const bool has_key,
+                       EvalJoinKey(params, tuple_data.get(),
+                                   /*is_target=*/true, context, &key));
+      if (has_key) from_indexes = zetasql_base::FindOrNull(join_index, key);
+      if (from_indexes == nullptr) from_indexes = &no_from_indexes;
+    }
     std::vector<const TupleData*> joined_tuple_datas;
-    ZETASQL_RETURN_IF_ERROR(GetJoinedTupleDatas(params, tuple_data.get(),
-                                        from_tuples.get(), where_expr, context,
-                                        &joined_tuple_datas));
+    ZETASQL_RETURN_IF_ERROR(GetJoinedTupleDatas(
+        params, tuple_data.get(), from_tuples.get(), from_indexes, where_expr,
+        context, &joined_tuple_datas));
     if (joined_tuple_datas.empty()) {
       ZETASQL_ASSIGN_OR_RETURN(const std::vector<Value> dml_output_row,
                        GetScannedTupleAsColumnValues(*column_list_, tuple));
@@ -2709,13 +3068,15 @@ DMLUpdateValueExpr::DMLUpdateValueExpr(
     std::unique_ptr<const ColumnToVariableMapping> column_to_variable_mapping,
     std::unique_ptr<const ResolvedScanMap> resolved_scan_map,
     std::unique_ptr<const ResolvedExprMap> resolved_expr_map,
-    std::unique_ptr<const ColumnExprMap> column_expr_map)
+    std::unique_ptr<const ColumnExprMap> column_expr_map,
+    std::vector<JoinKey> join_keys)
     : DMLValueExpr(table, table_array_type, returning_array_type,
                    primary_key_type, dml_output_type, resolved_node,
                    column_list, std::move(returning_column_values),
                    std::move(column_to_variable_mapping),
                    std::move(resolved_scan_map), std::move(resolved_expr_map),
-                   std::move(column_expr_map)) {}
+                   std::move(column_expr_map)),
+      join_keys_(std::move(join_keys)) {}
 
 absl::Status DMLUpdateValueExpr::SetSchemasForEvaluationOfUpdateItem(
     const ResolvedUpdateItem* update_item,
@@ -2892,7 +3253,8 @@ absl::Status DMLUpdateValueExpr::SetSchemasForEvaluationOfNestedInsert(
 absl::Status DMLUpdateValueExpr::GetJoinedTupleDatas(
     absl::Span<const TupleData* const> params, const TupleData* left_tuple,
     const std::vector<std::unique_ptr<TupleData>>* right_tuples,
-    const ValueExpr* where_expr, EvaluationContext* context,
+    const std::vector<int64_t>* right_indexes, const ValueExpr* where_expr,
+    EvaluationContext* context,
     std::vector<const TupleData*>* joined_tuple_datas) const {
   joined_tuple_datas->clear();
 
@@ -2906,9 +3268,15 @@ absl::Status DMLUpdateValueExpr::GetJoinedTupleDatas(
     return absl::OkStatus();
   }
 
-  for (const std::unique_ptr<TupleData>& right_tuple : *right_tuples) {
+  const int64_t num_candidates = right_indexes != nullptr
+                                     ? right_indexes->size()
+                                     : right_tuples->size();
+  for (int64_t i = 0; i < num_candidates; ++i) {
+    const TupleData* right_tuple =
+        (*right_tuples)[right_indexes != nullptr ? (*right_indexes)[i] : i]
+            .get();
     const std::vector<const TupleData*> candidate_joined_tuple_datas =
-        ConcatSpans(params, {left_tuple, right_tuple.get()});
+        ConcatSpans(params, {left_tuple, right_tuple});
     ZETASQL_ASSIGN_OR_RETURN(
         const Value where_value,
         EvalExpr(*where_expr, candidate_joined_tuple_datas, context));
@@ -2927,6 +3295,24 @@ absl::Status DMLUpdateValueExpr::GetJoinedTupleDatas(
   return absl::OkStatus();
 }
 
+absl::StatusOr<bool> DMLUpdateValueExpr::EvalJoinKey(
+    absl::Span<const TupleData* const> params, const TupleData* tuple,
+    bool is_target, EvaluationContext* context,
+    std::vector<Value>* key) const {
+  key->clear();
+  for (const JoinKey& join_key : join_keys_) {
+    ZETASQL_ASSIGN_OR_RETURN(
+        const ValueExpr* expr,
+        LookupResolvedExpr(is_target ? join_key.target : join_key.from));
+    ZETASQL_ASSIGN_OR_RETURN(Value value,
+                     EvalExpr(*expr, ConcatSpans(params, {tuple}), context));
+    // NULL is not equal to anything, so the WHERE clause cannot be true.
+    if (value.is_null()) return false;
+    key->push_back(std::move(value));
+  }
+  return true;
+}
+
 absl::Status DMLUpdateValueExpr::AddToUpdateMap(
     const ResolvedUpdateItem* update_item,
     absl::Span<const TupleData* const> tuples_for_row,
@@ -3378,10 +3764,11 @@ absl::Status DMLUpdateValueExpr::ProcessNestedInsert(
     ZETASQL_ASSIGN_OR_RETURN(const RelationalOp* relational_op,
                      LookupResolvedScan(nested_insert->query()));
 
+    MemoryReservation reservation(context->memory_accountant());
     std::unique_ptr<TupleSchema> tuple_schema;
     std::vector<std::unique_ptr<TupleData>> tuples;
     ZETASQL_RETURN_IF_ERROR(EvalRelationalOp(*relational_op, tuples_for_row, context,
-                                     &tuple_schema, &tuples));
+                                     &reservation, &tuple_schema, &tuples));
 
     const std::optional<int> opt_query_output_variable_slot =
         tuple_schema->FindIndexForVariable(query_output_variable_id);
@@ -3694,10 +4081,11 @@ absl::Status DMLInsertValueExpr::PopulateColumnsToInsert(
     ZETASQL_ASSIGN_OR_RETURN(const RelationalOp* relational_op,
                      LookupResolvedScan(query));
 
+    MemoryReservation reservation(context->memory_accountant());
     std::unique_ptr<TupleSchema> tuple_schema;
     std::vector<std::unique_ptr<TupleData>> tuples;
     ZETASQL_RETURN_IF_ERROR(EvalRelationalOp(*relational_op, params, context,
-                                     &tuple_schema, &tuples));
+                                     &reservation, &tuple_schema, &tuples));
 
     for (const std::unique_ptr<TupleData>& tuple : tuples) {
       // It is expensive to call this for every row, but this code is only used
@@ -3775,10 +4163,11 @@ absl::Status DMLInsertValueExpr::PopulateRowsInOriginalTable(
   ZETASQL_ASSIGN_OR_RETURN(const RelationalOp* relational_op,
                    LookupResolvedScan(stmt()->table_scan()));
 
+  MemoryReservation reservation(context->memory_accountant());
   std::unique_ptr<TupleSchema> tuple_schema;
   std::vector<std::unique_ptr<TupleData>> tuples;
   ZETASQL_RETURN_IF_ERROR(EvalRelationalOp(*relational_op, params, context,
-                                   &tuple_schema, &tuples));
+                                   &reservation, &tuple_schema, &tuples));
 
   for (const std::unique_ptr<TupleData>& tuple : tuples) {
     // It is expensive to call this for every row, but this code is only used
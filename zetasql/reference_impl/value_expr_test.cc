@@ -30,6 +30,7 @@
 #include "zetasql/base/logging.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/message.h"
+#include "google/protobuf/unknown_field_set.h"
 #include "zetasql/common/internal_value.h"
 #include "zetasql/common/status_payload_utils.h"
 #include "zetasql/base/testing/status_matchers.h"
@@ -526,6 +527,40 @@ TEST_F(EvalTest, IfExpr) {
   EXPECT_THAT(EvalExpr(*if_op_null, EmptyParams()), IsOkAndHolds(Int64(1)));
 }
 
+TEST_F(EvalTest, InListExpr) {
+  std::vector<Value> elements;
+  for (int i = 0; i < 1000; ++i) {
+    elements.push_back(Int64(i * 2));
+  }
+  const std::vector<Value> elements_with_null = {Int64(1), NullInt64()};
+  EXPECT_TRUE(InListExpr::SupportsType(types::Int64Type()));
+  EXPECT_FALSE(InListExpr::SupportsType(types::DoubleType()));
+
+  struct TestCase {
+    Value value;
+    absl::Span<const Value> elements;
+    Value expected;
+  };
+  for (const TestCase& test :
+       std::vector<TestCase>{{Int64(10), elements, Bool(true)},
+                             {Int64(11), elements, Bool(false)},
+                             {NullInt64(), elements, NullBool()},
+                             {Int64(1), elements_with_null, Bool(true)},
+                             {Int64(2), elements_with_null, NullBool()},
+                             {NullInt64(), elements_with_null, NullBool()}}) {
+    ZETASQL_ASSERT_OK_AND_ASSIGN(auto value_expr, ConstExpr::Create(test.value));
+    ZETASQL_ASSERT_OK_AND_ASSIGN(
+        auto in_list_expr,
+        InListExpr::Create(std::move(value_expr), test.elements));
+    EXPECT_THAT(EvalExpr(*in_list_expr, EmptyParams()),
+                IsOkAndHolds(test.expected))
+        << test.value;
+  }
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto string_expr, ConstExpr::Create(String("a")));
+  EXPECT_FALSE(InListExpr::Create(std::move(string_expr), elements).ok());
+}
+
 TEST_F(EvalTest, WithExpr) {
   VariableId a("a"), x("x"), y("y");
 
@@ -848,6 +883,51 @@ TEST_F(EvalTest, ExistsExpr) {
   EXPECT_THAT(EvalExpr(*exists2, EmptyParams()), IsOkAndHolds(Bool(true)));
 }
 
+TEST_F(EvalTest, MemoizedSubqueryExpr) {
+  VariableId a("a"), p("p");
+  auto input = absl::WrapUnique(
+      new TestRelationalOp({a}, CreateTestTupleDatas({{Int64(1)}}),
+                           /*preserves_order=*/true));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto exists, ExistsExpr::Create(std::move(input)));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto memoized, MemoizedSubqueryExpr::Create({p}, std::move(exists)));
+  const TupleSchema params_schema({p});
+  ZETASQL_ASSERT_OK(memoized->SetSchemasForEvaluation({&params_schema}));
+  EXPECT_EQ(
+      "MemoizedSubqueryExpr(correlated_variables=[$p]\n"
+      "+-subquery: ExistsExpr(\n"
+      "  +-input: TestRelationalOp))",
+      memoized->DebugString());
+
+  EvaluationContext context((EvaluationOptions()));
+  SubqueryResultCache* cache = context.subquery_result_cache();
+  ASSERT_NE(cache, nullptr);
+  const TupleData params1 = CreateTestTupleData({Int64(1)});
+  const TupleData params2 = CreateTestTupleData({Int64(2)});
+  EXPECT_THAT(EvalExpr(*memoized, {&params1}, &context),
+              IsOkAndHolds(Bool(true)));
+  EXPECT_EQ(cache->num_entries(), 1);
+  EXPECT_THAT(EvalExpr(*memoized, {&params1}, &context),
+              IsOkAndHolds(Bool(true)));
+  EXPECT_EQ(cache->num_entries(), 1);
+  EXPECT_THAT(EvalExpr(*memoized, {&params2}, &context),
+              IsOkAndHolds(Bool(true)));
+  EXPECT_EQ(cache->num_entries(), 2);
+
+  // A cached result is returned without evaluating the subquery.
+  cache->Insert(memoized.get(), {Int64(3)}, Bool(false));
+  const TupleData params3 = CreateTestTupleData({Int64(3)});
+  EXPECT_THAT(EvalExpr(*memoized, {&params3}, &context),
+              IsOkAndHolds(Bool(false)));
+
+  // Without a cache, the subquery is evaluated every time.
+  EvaluationOptions options;
+  options.max_cached_subquery_results = 0;
+  EvaluationContext context_without_cache(options);
+  EXPECT_THAT(EvalExpr(*memoized, {&params3}, &context_without_cache),
+              IsOkAndHolds(Bool(true)));
+}
+
 TEST_F(EvalTest, DerefExprDuplicateIds) {
   const VariableId v("v");
   const VariableId w("w");
@@ -3127,6 +3207,50 @@ TEST_F(ProtoEvalTest, GetProtoFieldExprLastFieldOccurrence) {
   EXPECT_EQ(7, p.int32_val());
 }
 
+TEST_F(ProtoEvalTest, GetProtoFieldExprUsesFieldIndex) {
+  zetasql_test__::KitchenSinkPB p;
+  p.set_int32_val(5);
+  p.set_string_val(std::string(2000, 'x'));
+  absl::Cord bytes;
+  ABSL_CHECK(p.SerializePartialToCord(&bytes));
+  const Value proto_value = Value::Proto(MakeProtoType(&p), bytes);
+  p.clear_string_val();
+  absl::Cord small_bytes;
+  ABSL_CHECK(p.SerializePartialToCord(&small_bytes));
+  const Value small_proto_value = Value::Proto(MakeProtoType(&p), small_bytes);
+
+  EvaluationOptions options;
+  options.use_proto_field_index = true;
+  EvaluationContext context(options);
+  TupleSlot proto_slot;
+  proto_slot.SetValue(proto_value);
+  EXPECT_THAT(EvalGetProtoFieldExpr(proto_slot, "int32_val",
+                                    /*get_has_bit=*/false, &context),
+              IsOkAndHolds(IsTupleSlotWith(Int32(5), _)));
+  const internal::ProtoFieldIndex* field_index =
+      InternalValue::GetProtoRep(proto_value)->field_index();
+  ASSERT_NE(field_index, nullptr);
+
+  // Another copy of the Value, in a slot without the shared proto state, is
+  // read with the same index.
+  TupleSlot other_proto_slot;
+  other_proto_slot.SetValue(proto_value);
+  EXPECT_THAT(EvalGetProtoFieldExpr(other_proto_slot, "string_val",
+                                    /*get_has_bit=*/false, &context),
+              IsOkAndHolds(IsTupleSlotWith(String(std::string(2000, 'x')), _)));
+  EXPECT_EQ(InternalValue::GetProtoRep(proto_value)->field_index(),
+            field_index);
+
+  // Small protos are read without an index.
+  TupleSlot small_proto_slot;
+  small_proto_slot.SetValue(small_proto_value);
+  EXPECT_THAT(EvalGetProtoFieldExpr(small_proto_slot, "int32_val",
+                                    /*get_has_bit=*/false, &context),
+              IsOkAndHolds(IsTupleSlotWith(Int32(5), _)));
+  EXPECT_EQ(InternalValue::GetProtoRep(small_proto_value)->field_index(),
+            nullptr);
+}
+
 TEST_F(ProtoEvalTest, GetProtoFieldExprOutOfBoundsInt32) {
   zetasql_test__::KitchenSinkPB p;
   // Append int32_val field with value 1. Streams are scoped to be closed
@@ -3336,5 +3460,54 @@ TEST_F(ProtoEvalTest, GetProtoFieldExprsMultipleFieldsMultipleRows) {
   }
 }
 
+TEST_F(ProtoEvalTest, ReplaceFieldsSplicesTopLevelFields) {
+  zetasql_test__::RecursivePB p;
+  p.set_int64_val(1);
+  p.mutable_recursive_pb()->set_int64_val(2);
+  p.add_repeated_recursive_pb()->set_int64_val(3);
+  p.GetReflection()->MutableUnknownFields(&p)->AddVarint(99, 4);
+  absl::Cord bytes;
+  ABSL_CHECK(p.SerializePartialToCord(&bytes));
+  // A second occurrence of 'recursive_pb' is merged into the first one, and
+  // must be replaced as well.
+  zetasql_test__::RecursivePB more;
+  more.mutable_recursive_pb()->mutable_recursive_pb()->set_int64_val(5);
+  absl::Cord more_bytes;
+  ABSL_CHECK(more.SerializePartialToCord(&more_bytes));
+  bytes.Append(more_bytes);
+  const ProtoType* proto_type = MakeProtoType(&p);
+
+  zetasql_test__::RecursivePB new_recursive_pb;
+  new_recursive_pb.set_int64_val(6);
+  absl::Cord new_recursive_pb_bytes;
+  ABSL_CHECK(new_recursive_pb.SerializePartialToCord(&new_recursive_pb_bytes));
+
+  const google::protobuf::Descriptor* descriptor = p.GetDescriptor();
+  std::vector<ReplaceFieldsFunction::StructAndProtoPath> field_paths = {
+      {{}, {descriptor->FindFieldByName("int64_val")}},
+      {{}, {descriptor->FindFieldByName("recursive_pb")}}};
+  std::vector<std::unique_ptr<ValueExpr>> arguments;
+  for (const Value& value :
+       {Value::Proto(proto_type, bytes), Value::NullInt64(),
+        Value::Proto(proto_type, new_recursive_pb_bytes)}) {
+    ZETASQL_ASSERT_OK_AND_ASSIGN(auto const_value, ConstExpr::Create(value));
+    arguments.push_back(std::move(const_value));
+  }
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto fct_op,
+      ScalarFunctionCallExpr::Create(
+          std::make_unique<ReplaceFieldsFunction>(proto_type, field_paths),
+          std::move(arguments)));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(Value result, EvalExpr(*fct_op, EmptyParams()));
+
+  zetasql_test__::RecursivePB expected;
+  expected.mutable_recursive_pb()->set_int64_val(6);
+  expected.add_repeated_recursive_pb()->set_int64_val(3);
+  expected.GetReflection()->MutableUnknownFields(&expected)->AddVarint(99, 4);
+  zetasql_test__::RecursivePB actual;
+  ASSERT_TRUE(actual.ParsePartialFromCord(result.ToCord()));
+  EXPECT_EQ(actual.DebugString(), expected.DebugString());
+}
+
 }  // namespace
 }  // namespace zetasql
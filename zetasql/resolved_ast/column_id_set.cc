@@ -0,0 +1,246 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/column_id_set.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/base/logging.h"
+#include "absl/numeric/bits.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+
+namespace zetasql {
+
+namespace {
+
+uint64_t BitForColumnId(int column_id) {
+  return uint64_t{1} << (column_id % 64);
+}
+
+size_t CountBits(const std::vector<uint64_t>& bitset) {
+  size_t count = 0;
+  for (uint64_t word : bitset) {
+    count += absl::popcount(word);
+  }
+  return count;
+}
+
+}  // namespace
+
+bool ColumnIdSet::insert(int column_id) {
+  ABSL_DCHECK_GT(column_id, 0) << "column_id should be positive";
+  if (is_bitset_) {
+    const size_t word = column_id / 64;
+    if (word >= bitset_.size()) {
+      bitset_.resize(word + 1);
+    }
+    const uint64_t bit = BitForColumnId(column_id);
+    if ((bitset_[word] & bit) != 0) return false;
+    bitset_[word] |= bit;
+    ++bitset_size_;
+    return true;
+  }
+  auto it = std::lower_bound(sorted_ids_.begin(), sorted_ids_.end(), column_id);
+  if (it != sorted_ids_.end() && *it == column_id) return false;
+  sorted_ids_.insert(it, column_id);
+  if (sorted_ids_.size() > kMaxInlineColumnIds) {
+    MaybeSwitchToBitset();
+  }
+  return true;
+}
+
+bool ColumnIdSet::erase(int column_id) {
+  if (is_bitset_) {
+    const size_t word = column_id / 64;
+    if (column_id < 0 || word >= bitset_.size()) return false;
+    const uint64_t bit = BitForColumnId(column_id);
+    if ((bitset_[word] & bit) == 0) return false;
+    bitset_[word] &= ~bit;
+    --bitset_size_;
+    return true;
+  }
+  auto it = std::lower_bound(sorted_ids_.begin(), sorted_ids_.end(), column_id);
+  if (it == sorted_ids_.end() || *it != column_id) return false;
+  sorted_ids_.erase(it);
+  return true;
+}
+
+bool ColumnIdSet::contains(int column_id) const {
+  if (is_bitset_) {
+    const size_t word = column_id / 64;
+    return column_id >= 0 && word < bitset_.size() &&
+           (bitset_[word] & BitForColumnId(column_id)) != 0;
+  }
+  return std::binary_search(sorted_ids_.begin(), sorted_ids_.end(),
+                            column_id);
+}
+
+void ColumnIdSet::clear() {
+  sorted_ids_.clear();
+  is_bitset_ = false;
+  bitset_.clear();
+  bitset_size_ = 0;
+}
+
+void ColumnIdSet::InsertAll(const ColumnIdSet& other) {
+  if (is_bitset_ && other.is_bitset_) {
+    if (bitset_.size() < other.bitset_.size()) {
+      bitset_.resize(other.bitset_.size());
+    }
+    for (size_t word = 0; word < other.bitset_.size(); ++word) {
+      bitset_[word] |= other.bitset_[word];
+    }
+    bitset_size_ = CountBits(bitset_);
+    return;
+  }
+  if (!is_bitset_ && !other.is_bitset_) {
+    absl::InlinedVector<int, kMaxInlineColumnIds> merged;
+    merged.reserve(sorted_ids_.size() + other.sorted_ids_.size());
+    std::set_union(sorted_ids_.begin(), sorted_ids_.end(),
+                   other.sorted_ids_.begin(), other.sorted_ids_.end(),
+                   std::back_inserter(merged));
+    sorted_ids_ = std::move(merged);
+    if (sorted_ids_.size() > kMaxInlineColumnIds) {
+      MaybeSwitchToBitset();
+    }
+    return;
+  }
+  other.ForEach([this](int column_id) { insert(column_id); });
+}
+
+void ColumnIdSet::EraseAll(const ColumnIdSet& other) {
+  if (!is_bitset_) {
+    sorted_ids_.erase(
+        std::remove_if(sorted_ids_.begin(), sorted_ids_.end(),
+                       [&other](int id) { return other.contains(id); }),
+        sorted_ids_.end());
+    return;
+  }
+  if (other.is_bitset_) {
+    const size_t num_words = std::min(bitset_.size(), other.bitset_.size());
+    for (size_t word = 0; word < num_words; ++word) {
+      bitset_[word] &= ~other.bitset_[word];
+    }
+    bitset_size_ = CountBits(bitset_);
+    return;
+  }
+  for (int column_id : other.sorted_ids_) {
+    erase(column_id);
+  }
+}
+
+void ColumnIdSet::IntersectWith(const ColumnIdSet& other) {
+  if (!is_bitset_) {
+    sorted_ids_.erase(
+        std::remove_if(sorted_ids_.begin(), sorted_ids_.end(),
+                       [&other](int id) { return !other.contains(id); }),
+        sorted_ids_.end());
+    return;
+  }
+  if (other.is_bitset_) {
+    if (bitset_.size() > other.bitset_.size()) {
+      bitset_.resize(other.bitset_.size());
+    }
+    for (size_t word = 0; word < bitset_.size(); ++word) {
+      bitset_[word] &= other.bitset_[word];
+    }
+    bitset_size_ = CountBits(bitset_);
+    return;
+  }
+  // The intersection is no larger than 'other', so it goes back to sorted ids.
+  absl::InlinedVector<int, kMaxInlineColumnIds> intersection;
+  for (int column_id : other.sorted_ids_) {
+    if (contains(column_id)) intersection.push_back(column_id);
+  }
+  clear();
+  sorted_ids_ = std::move(intersection);
+}
+
+bool ColumnIdSet::IsSubsetOf(const ColumnIdSet& other) const {
+  if (size() > other.size()) return false;
+  if (is_bitset_ && other.is_bitset_) {
+    for (size_t word = 0; word < bitset_.size(); ++word) {
+      const uint64_t other_word =
+          word < other.bitset_.size() ? other.bitset_[word] : 0;
+      if ((bitset_[word] & ~other_word) != 0) return false;
+    }
+    return true;
+  }
+  bool is_subset = true;
+  ForEach([&](int column_id) {
+    if (is_subset && !other.contains(column_id)) is_subset = false;
+  });
+  return is_subset;
+}
+
+bool ColumnIdSet::Intersects(const ColumnIdSet& other) const {
+  if (is_bitset_ && other.is_bitset_) {
+    const size_t num_words = std::min(bitset_.size(), other.bitset_.size());
+    for (size_t word = 0; word < num_words; ++word) {
+      if ((bitset_[word] & other.bitset_[word]) != 0) return true;
+    }
+    return false;
+  }
+  // Iterate over the smaller set.
+  const ColumnIdSet& smaller = size() <= other.size() ? *this : other;
+  const ColumnIdSet& larger = size() <= other.size() ? other : *this;
+  bool intersects = false;
+  smaller.ForEach([&](int column_id) {
+    if (!intersects && larger.contains(column_id)) intersects = true;
+  });
+  return intersects;
+}
+
+std::vector<int> ColumnIdSet::ToVector() const {
+  std::vector<int> column_ids;
+  column_ids.reserve(size());
+  ForEach([&column_ids](int column_id) { column_ids.push_back(column_id); });
+  return column_ids;
+}
+
+bool ColumnIdSet::operator==(const ColumnIdSet& other) const {
+  return size() == other.size() && IsSubsetOf(other);
+}
+
+std::string ColumnIdSet::DebugString() const {
+  return absl::StrCat("{", absl::StrJoin(ToVector(), ", "), "}");
+}
+
+void ColumnIdSet::MaybeSwitchToBitset() {
+  ABSL_DCHECK(!is_bitset_);
+  ABSL_DCHECK_GT(sorted_ids_.size(), kMaxInlineColumnIds);
+  const size_t num_words = sorted_ids_.back() / 64 + 1;
+  if (num_words * sizeof(uint64_t) > sorted_ids_.size() * sizeof(int)) {
+    return;
+  }
+  bitset_.assign(num_words, 0);
+  for (int column_id : sorted_ids_) {
+    bitset_[column_id / 64] |= BitForColumnId(column_id);
+  }
+  bitset_size_ = sorted_ids_.size();
+  is_bitset_ = true;
+  sorted_ids_.clear();
+  sorted_ids_.shrink_to_fit();
+}
+
+}  // namespace zetasql
@@ -0,0 +1,116 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_RESOLVED_AST_COLUMN_ID_SET_H_
+#define ZETASQL_RESOLVED_AST_COLUMN_ID_SET_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/inlined_vector.h"
+#include "absl/numeric/bits.h"
+
+namespace zetasql {
+
+// A set of ResolvedColumn column_ids, for the column-set algebra done while
+// resolving and rewriting queries.
+//
+// Most of these sets are tiny, so a ColumnIdSet stores its ids in a sorted
+// inline vector and does not allocate until it has more than
+// kMaxInlineColumnIds of them. Once a set is large enough that a bitset
+// indexed by column_id is not much bigger than the sorted vector, it switches
+// to the bitset, so large sets still have constant-time insert(), erase() and
+// contains(). column_ids are allocated densely by the ColumnFactory, so this
+// happens for the large sets of wide queries.
+//
+// Since ResolvedColumns compare and hash by column_id, a ColumnIdSet can
+// replace an absl::flat_hash_set<ResolvedColumn> that is only used to test
+// membership.
+class ColumnIdSet {
+ public:
+  ColumnIdSet() = default;
+  ColumnIdSet(const ColumnIdSet&) = default;
+  ColumnIdSet(ColumnIdSet&&) = default;
+  ColumnIdSet& operator=(const ColumnIdSet&) = default;
+  ColumnIdSet& operator=(ColumnIdSet&&) = default;
+
+  // Returns true if 'column_id' was not in the set already. 'column_id' must
+  // be positive.
+  bool insert(int column_id);
+  // Returns true if 'column_id' was in the set.
+  bool erase(int column_id);
+  bool contains(int column_id) const;
+
+  size_t size() const {
+    return is_bitset_ ? bitset_size_ : sorted_ids_.size();
+  }
+  bool empty() const { return size() == 0; }
+  void clear();
+
+  // Adds the ids of 'other' to this set (union).
+  void InsertAll(const ColumnIdSet& other);
+  // Removes the ids of 'other' from this set (difference).
+  void EraseAll(const ColumnIdSet& other);
+  // Removes the ids that are not in 'other' from this set (intersection).
+  void IntersectWith(const ColumnIdSet& other);
+
+  bool IsSubsetOf(const ColumnIdSet& other) const;
+  bool Intersects(const ColumnIdSet& other) const;
+
+  // Calls 'fn(column_id)' for each id in the set, in ascending order.
+  template <typename Fn>
+  void ForEach(Fn fn) const {
+    if (!is_bitset_) {
+      for (int column_id : sorted_ids_) fn(column_id);
+      return;
+    }
+    for (size_t word = 0; word < bitset_.size(); ++word) {
+      for (uint64_t bits = bitset_[word]; bits != 0; bits &= bits - 1) {
+        fn(static_cast<int>(word * 64 + absl::countr_zero(bits)));
+      }
+    }
+  }
+
+  // Returns the ids in ascending order.
+  std::vector<int> ToVector() const;
+
+  bool operator==(const ColumnIdSet& other) const;
+  bool operator!=(const ColumnIdSet& other) const { return !(*this == other); }
+
+  std::string DebugString() const;
+
+ private:
+  static constexpr int kMaxInlineColumnIds = 8;
+
+  // Switches to the bitset if it would take at most as many bytes as the
+  // sorted ids, which must have more than kMaxInlineColumnIds elements.
+  void MaybeSwitchToBitset();
+
+  // The ids in ascending order, if !is_bitset_.
+  absl::InlinedVector<int, kMaxInlineColumnIds> sorted_ids_;
+
+  // If is_bitset_, bit (id % 64) of bitset_[id / 64] is set for each id in
+  // the set, and bitset_size_ is the number of ids.
+  bool is_bitset_ = false;
+  std::vector<uint64_t> bitset_;
+  size_t bitset_size_ = 0;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_RESOLVED_AST_COLUMN_ID_SET_H_
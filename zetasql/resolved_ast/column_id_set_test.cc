@@ -0,0 +1,137 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/column_id_set.h"
+
+#include <set>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+using ::testing::IsEmpty;
+
+ColumnIdSet MakeSet(const std::vector<int>& column_ids) {
+  ColumnIdSet set;
+  for (int column_id : column_ids) set.insert(column_id);
+  return set;
+}
+
+// Returns the ids in [first, last) that are multiples of 'step'.
+std::vector<int> Range(int first, int last, int step = 1) {
+  std::vector<int> column_ids;
+  for (int column_id = first; column_id < last; column_id += step) {
+    column_ids.push_back(column_id);
+  }
+  return column_ids;
+}
+
+TEST(ColumnIdSet, InsertEraseContains) {
+  ColumnIdSet set;
+  EXPECT_TRUE(set.empty());
+  EXPECT_TRUE(set.insert(5));
+  EXPECT_TRUE(set.insert(2));
+  EXPECT_FALSE(set.insert(5));
+  EXPECT_EQ(set.size(), 2);
+  EXPECT_TRUE(set.contains(2));
+  EXPECT_TRUE(set.contains(5));
+  EXPECT_FALSE(set.contains(3));
+  EXPECT_THAT(set.ToVector(), ElementsAre(2, 5));
+  EXPECT_EQ(set.DebugString(), "{2, 5}");
+
+  EXPECT_TRUE(set.erase(2));
+  EXPECT_FALSE(set.erase(2));
+  EXPECT_THAT(set.ToVector(), ElementsAre(5));
+  set.clear();
+  EXPECT_TRUE(set.empty());
+  EXPECT_THAT(set.ToVector(), IsEmpty());
+}
+
+TEST(ColumnIdSet, LargeSets) {
+  // Dense ids switch to the bitset, and sparse ids stay sorted. Both must
+  // behave the same.
+  for (int step : {1, 3, 1000}) {
+    const std::vector<int> column_ids = Range(1, 200 * step, step);
+    ColumnIdSet set;
+    // Insert in descending order, to check that the ids are sorted.
+    for (auto it = column_ids.rbegin(); it != column_ids.rend(); ++it) {
+      EXPECT_TRUE(set.insert(*it));
+    }
+    EXPECT_EQ(set.size(), column_ids.size());
+    EXPECT_THAT(set.ToVector(), ElementsAreArray(column_ids));
+    EXPECT_TRUE(set.contains(1 + 100 * step));
+    EXPECT_FALSE(set.contains(200 * step));
+    EXPECT_FALSE(set.contains(1000000));
+
+    EXPECT_TRUE(set.erase(1 + 100 * step));
+    EXPECT_FALSE(set.erase(1 + 100 * step));
+    EXPECT_FALSE(set.contains(1 + 100 * step));
+    EXPECT_EQ(set.size(), column_ids.size() - 1);
+    EXPECT_TRUE(set.insert(1000000));
+    EXPECT_TRUE(set.contains(1000000));
+  }
+}
+
+TEST(ColumnIdSet, SetAlgebra) {
+  // Small and large sets, in every combination.
+  const std::vector<std::vector<int>> id_lists = {
+      {}, {1, 4, 7}, {2, 4, 6, 8}, Range(1, 300, 2), Range(100, 400),
+      Range(7, 70000, 7)};
+  for (const std::vector<int>& ids1 : id_lists) {
+    for (const std::vector<int>& ids2 : id_lists) {
+      const std::set<int> set1(ids1.begin(), ids1.end());
+      const std::set<int> set2(ids2.begin(), ids2.end());
+      std::vector<int> expected_union;
+      std::vector<int> expected_difference;
+      std::vector<int> expected_intersection;
+      for (int id : set1) {
+        (set2.count(id) > 0 ? expected_intersection : expected_difference)
+            .push_back(id);
+      }
+      std::set<int> all = set1;
+      all.insert(set2.begin(), set2.end());
+      expected_union.assign(all.begin(), all.end());
+
+      ColumnIdSet result = MakeSet(ids1);
+      result.InsertAll(MakeSet(ids2));
+      EXPECT_THAT(result.ToVector(), ElementsAreArray(expected_union));
+
+      result = MakeSet(ids1);
+      result.EraseAll(MakeSet(ids2));
+      EXPECT_THAT(result.ToVector(), ElementsAreArray(expected_difference));
+      EXPECT_EQ(result.size(), expected_difference.size());
+
+      result = MakeSet(ids1);
+      result.IntersectWith(MakeSet(ids2));
+      EXPECT_THAT(result.ToVector(), ElementsAreArray(expected_intersection));
+      EXPECT_EQ(result.size(), expected_intersection.size());
+
+      EXPECT_EQ(MakeSet(ids1).IsSubsetOf(MakeSet(ids2)),
+                expected_difference.empty());
+      EXPECT_EQ(MakeSet(ids1).Intersects(MakeSet(ids2)),
+                !expected_intersection.empty());
+      EXPECT_EQ(MakeSet(ids1) == MakeSet(ids2), set1 == set2);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace zetasql
@@ -112,17 +112,22 @@ void QueryExpression::ClearAllClauses() {
 
 std::string QueryExpression::GetSQLQuery() const {
   std::string sql;
+  AppendSQLQuery(&sql);
+  return sql;
+}
+
+void QueryExpression::AppendSQLQuery(std::string* sql) const {
   if (!with_list_.empty()) {
-    absl::StrAppend(&sql, "WITH ");
+    absl::StrAppend(sql, "WITH ");
     if (with_recursive_) {
-      absl::StrAppend(&sql, "RECURSIVE ");
+      absl::StrAppend(sql, "RECURSIVE ");
     }
-    absl::StrAppend(&sql, JoinListWithAliases(with_list_, ", "), " ");
+    absl::StrAppend(sql, JoinListWithAliases(with_list_, ", "), " ");
   }
   if (!select_list_.empty()) {
     ABSL_DCHECK(set_op_type_.empty() && set_op_modifier_.empty() &&
            set_op_scan_list_.empty());
-    absl::StrAppend(&sql, "SELECT ",
+    absl::StrAppend(sql, "SELECT ",
                     anonymization_options_.empty()
                         ? ""
                         : absl::StrCat(anonymization_options_, " "),
@@ -150,21 +155,21 @@ std::string QueryExpression::GetSQLQuery() const {
       if (i > 0) {
         if (set_op_column_propagation_mode_ == "FULL" ||
             set_op_column_propagation_mode_ == "LEFT") {
-          absl::StrAppend(&sql, " ", set_op_column_propagation_mode_);
+          absl::StrAppend(sql, " ", set_op_column_propagation_mode_);
         }
-        absl::StrAppend(&sql, " ", set_op_type_);
+        absl::StrAppend(sql, " ", set_op_type_);
         if (i == 1) {
-          absl::StrAppend(&sql, " ", query_hints_);
+          absl::StrAppend(sql, " ", query_hints_);
         }
-        absl::StrAppend(&sql, " ", set_op_modifier_);
+        absl::StrAppend(sql, " ", set_op_modifier_);
         if (set_op_column_propagation_mode_ == "STRICT") {
-          absl::StrAppend(&sql, " ", set_op_column_propagation_mode_);
+          absl::StrAppend(sql, " ", set_op_column_propagation_mode_);
         }
         if (!set_op_column_match_mode_.empty()) {
-          absl::StrAppend(&sql, " ", set_op_column_match_mode_);
+          absl::StrAppend(sql, " ", set_op_column_match_mode_);
           if (set_op_column_match_mode_ == "CORRESPONDING BY") {
             absl::StrAppend(
-                &sql, " (",
+                sql, " (",
                 absl::StrJoin(
                     corresponding_set_op_output_column_list_, ", ",
                     [](std::string* out,
@@ -176,39 +181,41 @@ std::string QueryExpression::GetSQLQuery() const {
           }
         }
       }
-      absl::StrAppend(&sql, "(", qe->GetSQLQuery(), ")");
+      absl::StrAppend(sql, "(");
+      qe->AppendSQLQuery(sql);
+      absl::StrAppend(sql, ")");
     }
   }
 
   if (!from_.empty()) {
-    absl::StrAppend(&sql, " FROM ", from_);
+    absl::StrAppend(sql, " FROM ", from_);
   }
 
   if (!pivot_.empty()) {
-    absl::StrAppend(&sql, pivot_);
+    absl::StrAppend(sql, pivot_);
   }
   if (!unpivot_.empty()) {
-    absl::StrAppend(&sql, unpivot_);
+    absl::StrAppend(sql, unpivot_);
   }
 
   if (!where_.empty()) {
-    absl::StrAppend(&sql, " WHERE ", where_);
+    absl::StrAppend(sql, " WHERE ", where_);
   }
 
   if (group_by_all_) {
     absl::StrAppend(
-        &sql, " GROUP ",
+        sql, " GROUP ",
         group_by_hints_.empty() ? "" : absl::StrCat(group_by_hints_, " "),
         "BY ALL");
   } else if (!group_by_list_.empty()) {
     absl::StrAppend(
-        &sql, " GROUP ",
+        sql, " GROUP ",
         group_by_hints_.empty() ? "" : absl::StrCat(group_by_hints_, " "),
         "BY ");
     // Legacy ROLLUP
     if (!rollup_column_id_list_.empty()) {
       absl::StrAppend(
-          &sql, "ROLLUP(",
+          sql, "ROLLUP(",
           absl::StrJoin(rollup_column_id_list_, ", ",
                         [this](std::string* out, int column_id) {
                           absl::StrAppend(
@@ -277,16 +284,16 @@ std::string QueryExpression::GetSQLQuery() const {
       // rather than GROUPING SETS(ROLLUP(x, y)) where there is only a rollup.
       if (grouping_set_strs.size() > 1 ||
           grouping_set_id_list_.front().kind == GroupingSetKind::kGroupingSet) {
-        absl::StrAppend(&sql, " GROUPING SETS(",
+        absl::StrAppend(sql, " GROUPING SETS(",
                         absl::StrJoin(grouping_set_strs, ", "), ")");
       } else {
-        absl::StrAppend(&sql, " ", grouping_set_strs.front());
+        absl::StrAppend(sql, " ", grouping_set_strs.front());
       }
     } else {
       // We assume while iterating the group_by_list_, the entries will be
       // sorted by the column id.
       absl::StrAppend(
-          &sql,
+          sql,
           absl::StrJoin(
               group_by_list_, ", ",
               [](std::string* out,
@@ -298,20 +305,18 @@ std::string QueryExpression::GetSQLQuery() const {
 
   if (!order_by_list_.empty()) {
     absl::StrAppend(
-        &sql, " ORDER ",
+        sql, " ORDER ",
         order_by_hints_.empty() ? "" : absl::StrCat(order_by_hints_, " "),
         "BY ", absl::StrJoin(order_by_list_, ", "));
   }
 
   if (!limit_.empty()) {
-    absl::StrAppend(&sql, " LIMIT ", limit_);
+    absl::StrAppend(sql, " LIMIT ", limit_);
   }
 
   if (!offset_.empty()) {
-    absl::StrAppend(&sql, " OFFSET ", offset_);
+    absl::StrAppend(sql, " OFFSET ", offset_);
   }
-
-  return sql;
 }
 
 bool QueryExpression::CanFormSQLQuery() const {
@@ -321,9 +326,11 @@ bool QueryExpression::CanFormSQLQuery() const {
 void QueryExpression::Wrap(absl::string_view alias) {
   ABSL_DCHECK(CanFormSQLQuery());
   ABSL_DCHECK(!alias.empty());
-  const std::string sql = GetSQLQuery();
+  std::string sql = "(";
+  AppendSQLQuery(&sql);
+  absl::StrAppend(&sql, ") AS ", alias);
   ClearAllClauses();
-  from_ = absl::StrCat("(", sql, ") AS ", alias);
+  from_ = std::move(sql);
 }
 
 bool QueryExpression::TrySetWithClause(
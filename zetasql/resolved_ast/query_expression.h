@@ -56,6 +56,11 @@ class QueryExpression {
 
   std::string GetSQLQuery() const;
 
+  // Appends the SQL query of GetSQLQuery() to <sql>. Nested queries, such as
+  // the inputs of set operations, are appended directly to the same buffer
+  // rather than built as separate strings and then concatenated.
+  void AppendSQLQuery(std::string* sql) const;
+
   // Mutates the QueryExpression, wrapping its previous form as a subquery in
   // the from_ clause, with the given <alias>.
   void Wrap(absl::string_view alias);
@@ -130,7 +135,7 @@ class QueryExpression {
 
   void ResetSelectClause();
 
-  const std::string FromClause() const { return from_; }
+  const std::string& FromClause() const { return from_; }
 
   // Returns an immutable reference to select_list_. For QueryExpression built
   // from a SetOp scan, it returns the select_list_ of its first subquery.
@@ -0,0 +1,49 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_RESOLVED_AST_RESOLVED_AST_FINGERPRINT_H_
+#define ZETASQL_RESOLVED_AST_RESOLVED_AST_FINGERPRINT_H_
+
+#include <cstdint>
+
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/resolved_node.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+
+namespace zetasql {
+
+// Returns a structural fingerprint of the tree rooted at <node>, which may be
+// NULL. Trees with the same node kinds and field values everywhere have the
+// same fingerprint, and different trees have different fingerprints with high
+// probability.
+//
+// Fields are fingerprinted as cheaply as possible: Types, AnnotationMaps,
+// catalog objects and shared call infos by address, ResolvedColumns by id and
+// type, and FunctionSignatures by their argument and result types. So
+// fingerprints are only comparable within one analysis, such as between the
+// input and the output of a rewriter, and are not stable across processes.
+//
+// If <scan_fingerprints> is non-NULL, the fingerprints of all scans in the
+// tree, including <node>, are added to it.
+absl::StatusOr<uint64_t> FingerprintResolvedAST(
+    const ResolvedNode* node,
+    absl::flat_hash_map<const ResolvedScan*, uint64_t>* scan_fingerprints =
+        nullptr);
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_RESOLVED_AST_RESOLVED_AST_FINGERPRINT_H_
@@ -0,0 +1,147 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Compares ResolvedNode::SaveTo()/RestoreFrom() with
+// SaveToCompact()/RestoreFromCompact() on an analyzed query.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/check.h"
+#include "google/protobuf/descriptor.h"
+#include "zetasql/public/analyzer.h"
+#include "zetasql/public/analyzer_options.h"
+#include "zetasql/public/analyzer_output.h"
+#include "zetasql/public/id_string.h"
+#include "zetasql/public/type.h"
+#include "zetasql/resolved_ast/resolved_node.h"
+#include "zetasql/resolved_ast/serialization.pb.h"
+#include "zetasql/testdata/sample_catalog.h"
+#include "benchmark/benchmark.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+namespace {
+
+// A query with many columns, function calls, and repeated types.
+std::string MakeQuery() {
+  std::vector<std::string> branches;
+  for (int i = 0; i < 20; ++i) {
+    branches.push_back(absl::StrCat(
+        "SELECT kv.Key + ", i, " AS k, CONCAT(kv.Value, '", i,
+        "') AS v, STRUCT(kv.Key AS a, t.key AS b) AS s "
+        "FROM KeyValue kv JOIN TestTable t ON kv.Key = t.key "
+        "WHERE kv.Value LIKE 'a%' AND kv.Key > ",
+        i));
+  }
+  return absl::StrCat(
+      "SELECT k, COUNT(*) AS n, STRING_AGG(v) AS vs, ANY_VALUE(s) AS s FROM (",
+      absl::StrJoin(branches, " UNION ALL "), ") GROUP BY k ORDER BY n DESC");
+}
+
+struct Fixture {
+  Fixture() {
+    options.CreateDefaultArenasIfNotSet();
+    ZETASQL_CHECK_OK(AnalyzeStatement(MakeQuery(), options, catalog.catalog(),
+                              catalog.type_factory(), &output));
+  }
+
+  ResolvedNode::RestoreParams MakeRestoreParams(
+      const FileDescriptorSetMap& map) {
+    std::vector<const google::protobuf::DescriptorPool*> pools;
+    for (const auto& entry : map) pools.push_back(entry.first);
+    return ResolvedNode::RestoreParams(pools, catalog.catalog(),
+                                       catalog.type_factory(), &string_pool);
+  }
+
+  SampleCatalog catalog;
+  AnalyzerOptions options;
+  IdStringPool string_pool;
+  std::unique_ptr<const AnalyzerOutput> output;
+};
+
+Fixture& GetFixture() {
+  static Fixture* fixture = new Fixture();
+  return *fixture;
+}
+
+void BM_SaveToProto(benchmark::State& state) {
+  Fixture& fixture = GetFixture();
+  size_t bytes = 0;
+  for (auto s : state) {
+    FileDescriptorSetMap map;
+    AnyResolvedNodeProto proto;
+    ZETASQL_CHECK_OK(fixture.output->resolved_statement()->SaveTo(&map, &proto));
+    std::string serialized = proto.SerializeAsString();
+    bytes = serialized.size();
+    benchmark::DoNotOptimize(serialized);
+  }
+  state.counters["bytes"] = static_cast<double>(bytes);
+}
+BENCHMARK(BM_SaveToProto);
+
+void BM_SaveToCompact(benchmark::State& state) {
+  Fixture& fixture = GetFixture();
+  size_t bytes = 0;
+  for (auto s : state) {
+    FileDescriptorSetMap map;
+    std::string serialized;
+    ZETASQL_CHECK_OK(
+        fixture.output->resolved_statement()->SaveToCompact(&map, &serialized));
+    bytes = serialized.size();
+    benchmark::DoNotOptimize(serialized);
+  }
+  state.counters["bytes"] = static_cast<double>(bytes);
+}
+BENCHMARK(BM_SaveToCompact);
+
+void BM_RestoreFromProto(benchmark::State& state) {
+  Fixture& fixture = GetFixture();
+  FileDescriptorSetMap map;
+  AnyResolvedNodeProto proto;
+  ZETASQL_CHECK_OK(fixture.output->resolved_statement()->SaveTo(&map, &proto));
+  const std::string serialized = proto.SerializeAsString();
+  const ResolvedNode::RestoreParams params = fixture.MakeRestoreParams(map);
+  for (auto s : state) {
+    AnyResolvedNodeProto parsed;
+    ABSL_CHECK(parsed.ParseFromString(serialized));
+    auto restored = ResolvedNode::RestoreFrom(parsed, params);
+    ZETASQL_CHECK_OK(restored.status());
+    benchmark::DoNotOptimize(restored);
+  }
+}
+BENCHMARK(BM_RestoreFromProto);
+
+void BM_RestoreFromCompact(benchmark::State& state) {
+  Fixture& fixture = GetFixture();
+  FileDescriptorSetMap map;
+  std::string serialized;
+  ZETASQL_CHECK_OK(
+      fixture.output->resolved_statement()->SaveToCompact(&map, &serialized));
+  const ResolvedNode::RestoreParams params = fixture.MakeRestoreParams(map);
+  for (auto s : state) {
+    auto restored = ResolvedNode::RestoreFromCompact(serialized, params);
+    ZETASQL_CHECK_OK(restored.status());
+    benchmark::DoNotOptimize(restored);
+  }
+}
+BENCHMARK(BM_RestoreFromCompact);
+
+}  // namespace
+}  // namespace zetasql
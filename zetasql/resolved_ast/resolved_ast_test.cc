@@ -1058,6 +1058,58 @@ TEST_F(ResolvedASTTest, TableDeserialization) {
   EXPECT_EQ(table.GetSerializationId(), got_table->GetSerializationId());
 }
 
+TEST_F(ResolvedASTTest, CompactSerializationRoundTrip) {
+  SimpleColumn column_a("bar" /* table_name */, "a" /* name */,
+                        types::Int64Type());
+  SimpleColumn column_b("bar" /* table_name */, "b" /* name */,
+                        types::StringType());
+  SimpleTable table("bar", {&column_a, &column_b}, false /* takes_ownership */,
+                    123 /* id */);
+  SimpleCatalog catalog("foo");
+  catalog.AddTable(&table);
+  TypeFactory factory;
+  std::unique_ptr<const AnalyzerOutput> output;
+  ZETASQL_ASSERT_OK(zetasql::AnalyzeStatement(
+      "select a, b, a as c, 'x' from bar t1 join bar t2 using (a, b);",
+      AnalyzerOptions(), &catalog, &factory, &output));
+  const ResolvedStatement* statement = output->resolved_statement();
+
+  std::string compact;
+  FileDescriptorSetMap map;
+  ZETASQL_ASSERT_OK(statement->SaveToCompact(&map, &compact));
+  AnyResolvedNodeProto proto;
+  FileDescriptorSetMap proto_map;
+  ZETASQL_ASSERT_OK(statement->SaveTo(&proto_map, &proto));
+  EXPECT_LT(compact.size(), proto.ByteSizeLong());
+
+  std::vector<const google::protobuf::DescriptorPool*> pools;
+  for (const auto& entry : map) pools.push_back(entry.first);
+  IdStringPool string_pool;
+  ResolvedNode::RestoreParams restore_params(pools, &catalog, &factory,
+                                             &string_pool);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ResolvedNode> restored,
+      ResolvedNode::RestoreFromCompact(compact, restore_params));
+  EXPECT_EQ(statement->DebugString(), restored->DebugString());
+  const auto* query = restored->GetAs<ResolvedQueryStmt>();
+  const auto* project = query->query()->GetAs<ResolvedProjectScan>();
+  EXPECT_EQ(project->column_list(0).column_id(),
+            statement->GetAs<ResolvedQueryStmt>()
+                ->query()
+                ->GetAs<ResolvedProjectScan>()
+                ->column_list(0)
+                .column_id());
+
+  // Truncated or corrupted input is rejected.
+  EXPECT_THAT(ResolvedNode::RestoreFromCompact(
+                  absl::string_view(compact).substr(0, compact.size() - 1),
+                  restore_params),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ResolvedNode::RestoreFromCompact(absl::StrCat(compact, "x"),
+                                               restore_params),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 TEST_F(ResolvedASTTest, FieldDescriptorSerialization) {
   SimpleCatalog catalog("foo");
   TypeFactory factory;
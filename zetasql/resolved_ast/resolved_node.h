@@ -41,6 +41,11 @@ namespace zetasql {
 
 class ResolvedASTVisitor;
 
+namespace internal {
+class CompactResolvedASTReader;
+class CompactResolvedASTWriter;
+}  // namespace internal
+
 // This is the base class for the resolved AST.
 // Subclasses are in the generated file resolved_ast.h.
 // ResolvedNodeKind enum is in the generated file resolved_node_kind.h.
@@ -160,6 +165,24 @@ class ResolvedNode {
   static absl::StatusOr<std::unique_ptr<ResolvedNode>> RestoreFrom(
       const AnyResolvedNodeProto& proto, const RestoreParams& params);
 
+  // SaveToCompact() serializes the tree rooted at this node into <output>, in
+  // a compact binary format that is smaller and faster to restore than the
+  // AnyResolvedNodeProto from SaveTo(). Types, FunctionSignatures, catalog
+  // objects and other scalars are stored once in a dictionary, along with all
+  // strings and ResolvedColumns, and are restored once each. Like SaveTo(),
+  // it does not mark any fields as accessed, and does not save parse
+  // locations.
+  //
+  // The format is only meant for shipping a tree between processes running
+  // the same version of this library, and has no compatibility guarantees.
+  absl::Status SaveToCompact(FileDescriptorSetMap* file_descriptor_set_map,
+                             std::string* output) const;
+
+  // Deserializes the output of SaveToCompact(). The requirements on <params>
+  // are the same as for RestoreFrom().
+  static absl::StatusOr<std::unique_ptr<ResolvedNode>> RestoreFromCompact(
+      absl::string_view input, const RestoreParams& params);
+
   // Specifies that <node> should be annotated with <annotation> in its tree
   // dump.
   struct NodeAnnotation {
@@ -369,6 +392,13 @@ class ResolvedNode {
     return node->CheckFieldsAccessedImpl(root);
   }
 
+  // Helper function to implement SaveToCompact(), which writes the fields of
+  // this node, including inherited ones, to <writer>.
+  virtual absl::Status SaveFieldsToCompact(
+      internal::CompactResolvedASTWriter* writer) const {
+    return absl::OkStatus();
+  }
+
   // Given a vector of unique_ptrs, this returns a vector of raw pointers.
   // The output vector then owns the pointers, and the input vector is cleared.
   template <class T>
@@ -407,6 +437,8 @@ class ResolvedNode {
   friend class ResolvedComputedColumn;
   friend class ResolvedMakeProtoField;
   friend class ResolvedOutputColumn;
+  // SaveToCompact() calls SaveFieldsToCompact() on every node.
+  friend class internal::CompactResolvedASTWriter;
 
   std::unique_ptr<ParseLocationRange> parse_location_range_;  // May be NULL.
 };
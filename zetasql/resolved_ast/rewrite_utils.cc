@@ -33,6 +33,7 @@
 #include "zetasql/public/types/simple_value.h"
 #include "zetasql/public/types/type.h"
 #include "zetasql/public/types/type_factory.h"
+#include "zetasql/resolved_ast/column_id_set.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
 #include "zetasql/resolved_ast/resolved_ast_builder.h"
 #include "zetasql/resolved_ast/resolved_ast_deep_copy_visitor.h"
@@ -261,7 +262,7 @@ absl::Status RemoveUnusedColumnRefs(
     std::vector<std::unique_ptr<const ResolvedColumnRef>>& column_refs) {
   std::vector<std::unique_ptr<const ResolvedColumnRef>> refs;
   ZETASQL_RETURN_IF_ERROR(CollectColumnRefs(node, &refs));
-  absl::flat_hash_set<int> referenced_column_ids;
+  ColumnIdSet referenced_column_ids;
   for (const auto& ref : refs) {
     referenced_column_ids.insert(ref->column().column_id());
   }
@@ -1481,7 +1482,7 @@ class CorrelatedColumnRefCollector : public ResolvedASTVisitor {
   }
 
   absl::flat_hash_set<ResolvedColumn> correlated_columns_;
-  absl::flat_hash_set<int> uncorrelated_column_ids_;
+  ColumnIdSet uncorrelated_column_ids_;
 };
 
 absl::StatusOr<absl::flat_hash_set<ResolvedColumn>> GetCorrelatedColumnSet(
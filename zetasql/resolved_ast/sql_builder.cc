@@ -377,6 +377,13 @@ std::string SQLBuilder::QueryFragment::GetSQL() const {
   return text;
 }
 
+std::string SQLBuilder::QueryFragment::ReleaseSQL() {
+  if (query_expression != nullptr) {
+    return query_expression->GetSQLQuery();
+  }
+  return std::move(text);
+}
+
 SQLBuilder::~SQLBuilder() {}
 
 void SQLBuilder::DumpQueryFragmentStack() {
@@ -394,8 +401,8 @@ void SQLBuilder::PushQueryFragment(
 }
 
 void SQLBuilder::PushQueryFragment(const ResolvedNode* node,
-                                   const std::string& text) {
-  PushQueryFragment(std::make_unique<QueryFragment>(node, text));
+                                   std::string text) {
+  PushQueryFragment(std::make_unique<QueryFragment>(node, std::move(text)));
 }
 
 void SQLBuilder::PushQueryFragment(const ResolvedNode* node,
@@ -733,21 +740,21 @@ absl::Status SQLBuilder::VisitResolvedFunctionCall(
   for (const auto& argument : node->argument_list()) {
     ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> result,
                      ProcessNode(argument.get()));
-    inputs.push_back(result->GetSQL());
+    inputs.push_back(result->ReleaseSQL());
   }
   for (const auto& argument : node->generic_argument_list()) {
     if (argument->expr() != nullptr) {
       ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> result,
                        ProcessNode(argument->expr()));
-      inputs.push_back(result->GetSQL());
+      inputs.push_back(result->ReleaseSQL());
     } else if (argument->inline_lambda() != nullptr) {
       ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> result,
                        ProcessNode(argument->inline_lambda()));
-      inputs.push_back(result->GetSQL());
+      inputs.push_back(result->ReleaseSQL());
     } else if (argument->sequence() != nullptr) {
       ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> result,
                        ProcessNode(argument->sequence()));
-      inputs.push_back(result->GetSQL());
+      inputs.push_back(result->ReleaseSQL());
     } else {
       ZETASQL_RET_CHECK_FAIL() << "Unexpected function call argument: "
                        << argument->DebugString();
@@ -857,7 +864,7 @@ absl::Status SQLBuilder::VisitResolvedAggregateFunctionCall(
     for (const auto& argument : node->argument_list()) {
       ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> result,
                        ProcessNode(argument.get()));
-      inputs.push_back(result->GetSQL());
+      inputs.push_back(result->ReleaseSQL());
     }
 
     if (node->distinct()) {
@@ -884,7 +891,7 @@ absl::Status SQLBuilder::VisitResolvedAggregateFunctionCall(
     // This modifier can apply to COUNT(*), in which case there won't be any
     // inputs. Push it into the vector as a dummy input.
     if (inputs.empty()) {
-      inputs.push_back(result->GetSQL());
+      inputs.push_back(result->ReleaseSQL());
     } else {
       absl::StrAppend(&inputs.back(), result->GetSQL());
     }
@@ -895,7 +902,7 @@ absl::Status SQLBuilder::VisitResolvedAggregateFunctionCall(
     for (const auto& order_by_item : node->order_by_item_list()) {
       ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> result,
                        ProcessNode(order_by_item.get()));
-      order_by_arguments.push_back(result->GetSQL());
+      order_by_arguments.push_back(result->ReleaseSQL());
     }
     ZETASQL_RET_CHECK(!inputs.empty());
     absl::StrAppend(&inputs.back(), " ORDER BY ",
@@ -963,7 +970,7 @@ absl::Status SQLBuilder::VisitResolvedAnalyticFunctionCall(
     for (const auto& argument : node->argument_list()) {
       ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> result,
                        ProcessNode(argument.get()));
-      inputs.push_back(result->GetSQL());
+      inputs.push_back(result->ReleaseSQL());
     }
     if (node->distinct()) {
       inputs[0] = absl::StrCat("distinct ", inputs[0]);
@@ -1029,7 +1036,7 @@ absl::Status SQLBuilder::VisitResolvedWindowPartitioning(
   for (const auto& column_ref : node->partition_by_list()) {
     ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> result,
                      ProcessNode(column_ref.get()));
-    partition_by_list_sql.push_back(result->GetSQL());
+    partition_by_list_sql.push_back(result->ReleaseSQL());
   }
 
   std::string sql = "PARTITION";
@@ -1052,7 +1059,7 @@ absl::Status SQLBuilder::VisitResolvedWindowOrdering(
   for (const auto& order_by_item : node->order_by_item_list()) {
     ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> result,
                      ProcessNode(order_by_item.get()));
-    order_by_list_sql.push_back(result->GetSQL());
+    order_by_list_sql.push_back(result->ReleaseSQL());
   }
 
   std::string sql = "ORDER";
@@ -1736,7 +1743,7 @@ absl::StatusOr<std::string> SQLBuilder::GetHintListString(
   for (const auto& hint : hint_list) {
     ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> result,
                      ProcessNode(hint.get()));
-    hint_list_sql.push_back(result->GetSQL());
+    hint_list_sql.push_back(result->ReleaseSQL());
   }
 
   return absl::StrJoin(hint_list_sql, ", ");
@@ -4098,7 +4105,7 @@ absl::Status SQLBuilder::VisitResolvedOrderByScan(
   for (const auto& order_by_item : node->order_by_item_list()) {
     ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> item_result,
                      ProcessNode(order_by_item.get()));
-    order_by_list.push_back(item_result->GetSQL());
+    order_by_list.push_back(item_result->ReleaseSQL());
   }
   ZETASQL_RET_CHECK(
       query_expression->TrySetOrderByClause(order_by_list, order_by_hint_list));
@@ -4599,7 +4606,7 @@ absl::Status SQLBuilder::VisitResolvedQueryStmt(const ResolvedQueryStmt* node) {
     ZETASQL_RET_CHECK_EQ(query_expression->SelectList().size(), 1);
     query_expression->SetSelectAsModifier("AS VALUE");
   }
-  absl::StrAppend(&sql, query_expression->GetSQLQuery());
+  query_expression->AppendSQLQuery(&sql);
 
   PushQueryFragment(node, sql);
   return absl::OkStatus();
@@ -4761,7 +4768,8 @@ absl::Status SQLBuilder::GetCreateViewStatement(
     ZETASQL_RET_CHECK_EQ(query_expression->SelectList().size(), 1);
     query_expression->SetSelectAsModifier("AS VALUE");
   }
-  absl::StrAppend(&sql, " AS ", query_expression->GetSQLQuery());
+  absl::StrAppend(&sql, " AS ");
+  query_expression->AppendSQLQuery(&sql);
 
   PushQueryFragment(node, sql);
   return absl::OkStatus();
@@ -4832,7 +4840,7 @@ absl::Status SQLBuilder::GetPartitionByListString(
   for (const auto& partition_by_expr : partition_by_list) {
     ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> expr,
                      ProcessNode(partition_by_expr.get()));
-    expressions.push_back(expr->GetSQL());
+    expressions.push_back(expr->ReleaseSQL());
   }
   absl::StrAppend(sql, absl::StrJoin(expressions, ","));
 
@@ -4848,7 +4856,7 @@ absl::Status SQLBuilder::GetTableAndColumnInfoList(
   for (const auto& table_and_column_info : table_and_column_info_list) {
     ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> expr,
                      ProcessNode(table_and_column_info.get()));
-    expressions.push_back(expr->GetSQL());
+    expressions.push_back(expr->ReleaseSQL());
   }
   absl::StrAppend(sql, absl::StrJoin(expressions, ","));
 
@@ -4869,7 +4877,7 @@ absl::Status SQLBuilder::GetPrivilegesString(
   for (const auto& privilege : node->privilege_list()) {
     ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> result,
                      ProcessNode(privilege.get()));
-    privilege_list_sql.push_back(result->GetSQL());
+    privilege_list_sql.push_back(result->ReleaseSQL());
   }
 
   *sql = absl::StrCat(
@@ -5258,7 +5266,8 @@ absl::Status SQLBuilder::VisitResolvedCreateTableAsSelectStmt(
     ZETASQL_RET_CHECK_EQ(query_expression->SelectList().size(), 1);
     query_expression->SetSelectAsModifier(" AS VALUE");
   }
-  absl::StrAppend(&sql, " AS ", query_expression->GetSQLQuery());
+  absl::StrAppend(&sql, " AS ");
+  query_expression->AppendSQLQuery(&sql);
 
   PushQueryFragment(node, sql);
   return absl::OkStatus();
@@ -5406,7 +5415,8 @@ absl::Status SQLBuilder::VisitResolvedCreateModelStmt(
                     ")");
   } else if (query_expression) {
     // Append SELECT statement.
-    absl::StrAppend(&sql, " AS ", query_expression->GetSQLQuery());
+    absl::StrAppend(&sql, " AS ");
+    query_expression->AppendSQLQuery(&sql);
   }
 
   PushQueryFragment(node, sql);
@@ -5507,7 +5517,7 @@ absl::Status SQLBuilder::VisitResolvedCreateIndexStmt(
       const ResolvedExpr* argument = node->storing_expression_list(i);
       ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> result,
                        ProcessNode(argument));
-      argument_list.push_back(result->GetSQL());
+      argument_list.push_back(result->ReleaseSQL());
     }
     absl::StrAppend(
         &sql, "STORING(",
@@ -5581,7 +5591,8 @@ absl::Status SQLBuilder::VisitResolvedCreateMaterializedViewStmt(
       ZETASQL_RET_CHECK_EQ(query_expression->SelectList().size(), 1);
       query_expression->SetSelectAsModifier(" AS VALUE");
     }
-    absl::StrAppend(&sql, " AS ", query_expression->GetSQLQuery());
+    absl::StrAppend(&sql, " AS ");
+    query_expression->AppendSQLQuery(&sql);
   } else if (node->replica_source() != nullptr) {
     ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> result,
                      ProcessNode(node->replica_source()));
@@ -5788,7 +5799,8 @@ absl::Status SQLBuilder::VisitResolvedCreateTableFunctionStmt(
     ZETASQL_ASSIGN_OR_RETURN(QueryExpression * query_result,
                      ProcessQuery(node->query(), node->output_column_list()));
     std::unique_ptr<QueryExpression> query_expression(query_result);
-    absl::StrAppend(&sql, " AS ", query_expression->GetSQLQuery());
+    absl::StrAppend(&sql, " AS ");
+    query_expression->AppendSQLQuery(&sql);
   } else if (!node->code().empty()) {
     if (is_external_language) {
       absl::StrAppend(&sql, " AS ", ToStringLiteral(node->code()));
@@ -5896,7 +5908,8 @@ absl::Status SQLBuilder::VisitResolvedExportDataStmt(
     ZETASQL_RET_CHECK_EQ(query_expression->SelectList().size(), 1);
     query_expression->SetSelectAsModifier("AS VALUE");
   }
-  absl::StrAppend(&sql, "AS ", query_expression->GetSQLQuery());
+  absl::StrAppend(&sql, "AS ");
+  query_expression->AppendSQLQuery(&sql);
 
   PushQueryFragment(node, sql);
   return absl::OkStatus();
@@ -5962,7 +5975,7 @@ absl::Status SQLBuilder::VisitResolvedCallStmt(const ResolvedCallStmt* node) {
     const ResolvedExpr* argument = node->argument_list(i);
     ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> result,
                      ProcessNode(argument));
-    argument_list.push_back(result->GetSQL());
+    argument_list.push_back(result->ReleaseSQL());
   }
   absl::StrAppend(&sql, "(", absl::StrJoin(argument_list, ", "), ")");
   PushQueryFragment(node, sql);
@@ -6377,7 +6390,7 @@ absl::Status SQLBuilder::VisitResolvedDropPrivilegeRestrictionStmt(
   for (const auto& privilege : node->column_privilege_list()) {
     ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> result,
                      ProcessNode(privilege.get()));
-    privilege_list_sql.push_back(result->GetSQL());
+    privilege_list_sql.push_back(result->ReleaseSQL());
   }
   absl::StrAppend(&sql, absl::StrJoin(privilege_list_sql, ", "));
   absl::StrAppend(&sql, " ON ", node->object_type(), " ",
@@ -6459,7 +6472,7 @@ absl::Status SQLBuilder::VisitResolvedDMLDefault(
 absl::Status SQLBuilder::VisitResolvedDMLValue(const ResolvedDMLValue* node) {
   ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> result,
                    ProcessNode(node->value()));
-  PushQueryFragment(node, result->GetSQL());
+  PushQueryFragment(node, result->ReleaseSQL());
   return absl::OkStatus();
 }
 
@@ -6482,7 +6495,7 @@ absl::Status SQLBuilder::VisitResolvedUpdateItem(
     for (const auto& array_item : node->array_update_list()) {
       ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> fragment,
                        ProcessNode(array_item.get()));
-      sql_fragments.push_back(fragment->GetSQL());
+      sql_fragments.push_back(fragment->ReleaseSQL());
     }
 
     PushQueryFragment(node, absl::StrJoin(sql_fragments, ", "));
@@ -6594,7 +6607,7 @@ absl::Status SQLBuilder::VisitResolvedUpdateArrayItem(
   // Clear the offset_sql.
   update_item_targets_and_offsets_.back().back().second.clear();
 
-  PushQueryFragment(node, update->GetSQL());
+  PushQueryFragment(node, update->ReleaseSQL());
   return absl::OkStatus();
 }
 
@@ -6682,7 +6695,7 @@ absl::Status SQLBuilder::VisitResolvedInsertRow(const ResolvedInsertRow* node) {
   for (const auto& value : node->value_list()) {
     ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> result,
                      ProcessNode(value.get()));
-    values_sql.push_back(result->GetSQL());
+    values_sql.push_back(result->ReleaseSQL());
   }
   PushQueryFragment(node,
                     absl::StrCat("(", absl::StrJoin(values_sql, ", "), ")"));
@@ -6736,7 +6749,7 @@ absl::Status SQLBuilder::VisitResolvedInsertStmt(
     for (const auto& row : node->row_list()) {
       ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> result,
                        ProcessNode(row.get()));
-      rows_sql.push_back(result->GetSQL());
+      rows_sql.push_back(result->ReleaseSQL());
     }
     absl::StrAppend(&sql, "VALUES ", absl::StrJoin(rows_sql, ", "));
   } else {
@@ -7268,7 +7281,7 @@ absl::StatusOr<std::string> SQLBuilder::GetGranteeListSQL(
          grantee_expr_list) {
       ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> result,
                        ProcessNode(grantee.get()));
-      grantee_string_list.push_back(result->GetSQL());
+      grantee_string_list.push_back(result->ReleaseSQL());
     }
     absl::StrAppend(&sql, prefix, absl::StrJoin(grantee_string_list, ", "));
   }
@@ -7287,7 +7300,7 @@ absl::Status SQLBuilder::VisitResolvedAlterPrivilegeRestrictionStmt(
   for (const auto& privilege : node->column_privilege_list()) {
     ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> result,
                      ProcessNode(privilege.get()));
-    privilege_list_sql.push_back(result->GetSQL());
+    privilege_list_sql.push_back(result->ReleaseSQL());
   }
   absl::StrAppend(&sql, absl::StrJoin(privilege_list_sql, ", "));
 
@@ -7445,7 +7458,7 @@ std::string SQLBuilder::sql() {
 
     std::unique_ptr<QueryFragment> query_fragment = PopQueryFragment();
     ABSL_DCHECK(query_fragments_.empty());
-    sql_ = query_fragment->GetSQL();
+    sql_ = query_fragment->ReleaseSQL();
     ZETASQL_DCHECK_OK(query_fragment->node->CheckFieldsAccessed()) << "sql is\n"
                                                            << sql_;
   }
@@ -7468,7 +7481,7 @@ absl::Status SQLBuilder::VisitResolvedCreatePrivilegeRestrictionStmt(
   for (const auto& privilege : node->column_privilege_list()) {
     ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> result,
                      ProcessNode(privilege.get()));
-    privilege_list_sql.push_back(result->GetSQL());
+    privilege_list_sql.push_back(result->ReleaseSQL());
   }
   absl::StrAppend(&sql, absl::StrJoin(privilege_list_sql, ", "));
   absl::StrAppend(&sql, " ON ", node->object_type(), " ",
@@ -7644,7 +7657,7 @@ absl::StatusOr<std::string> SQLBuilder::GetUpdateItemListSQL(
                      ProcessNode(update_item.get()));
     update_item_targets_and_offsets_.pop_back();
 
-    update_item_list_sql.push_back(result->GetSQL());
+    update_item_list_sql.push_back(result->ReleaseSQL());
   }
   return absl::StrJoin(update_item_list_sql, ", ");
 }
@@ -442,6 +442,12 @@ class SQLBuilder : public ResolvedASTVisitor {
 
     std::string GetSQL() const;
 
+    // Like GetSQL(), but moves the text out of the QueryFragment instead of
+    // copying it, so that the SQL of large subtrees is not copied at every
+    // level of the tree. The QueryFragment must not be used for its SQL
+    // afterward.
+    std::string ReleaseSQL();
+
     // Associated resolved node tree for the QueryFragment.
     const ResolvedNode* node = nullptr;
 
@@ -450,7 +456,7 @@ class SQLBuilder : public ResolvedASTVisitor {
 
    private:
     // Associated sql text for the QueryFragment.
-    const std::string text;
+    std::string text;
   };
 
   // Dumps all the QueryFragment in query_fragments_ (if any).
@@ -463,7 +469,7 @@ class SQLBuilder : public ResolvedASTVisitor {
 
   // Helper functions which creates QueryFragment from the passed params and
   // push it on query_fragments_.
-  void PushQueryFragment(const ResolvedNode* node, const std::string& text);
+  void PushQueryFragment(const ResolvedNode* node, std::string text);
   void PushQueryFragment(const ResolvedNode* node,
                          QueryExpression* query_expression);
 
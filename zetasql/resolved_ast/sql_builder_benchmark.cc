@@ -0,0 +1,88 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Measures SQLBuilder on large analyzed queries, both wide (many UNION ALL
+// inputs) and deep (many levels of nested subqueries).
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/analyzer.h"
+#include "zetasql/public/analyzer_options.h"
+#include "zetasql/public/analyzer_output.h"
+#include "zetasql/resolved_ast/sql_builder.h"
+#include "zetasql/testdata/sample_catalog.h"
+#include "benchmark/benchmark.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+namespace {
+
+// A UNION ALL of <num_branches> queries with joins and function calls.
+std::string MakeWideQuery(int num_branches) {
+  std::vector<std::string> branches;
+  for (int i = 0; i < num_branches; ++i) {
+    branches.push_back(absl::StrCat(
+        "SELECT kv.Key + ", i, " AS k, CONCAT(kv.Value, '", i,
+        "') AS v FROM KeyValue kv JOIN TestTable t ON kv.Key = t.key "
+        "WHERE kv.Value LIKE 'a%' AND kv.Key > ",
+        i));
+  }
+  return absl::StrJoin(branches, " UNION ALL ");
+}
+
+// <depth> levels of subqueries, each filtering and projecting its input.
+std::string MakeDeepQuery(int depth) {
+  std::string query = "SELECT Key AS k, Value AS v FROM KeyValue";
+  for (int i = 0; i < depth; ++i) {
+    query = absl::StrCat("SELECT k + 1 AS k, CONCAT(v, 'x') AS v FROM (", query,
+                         ") WHERE k > ", i);
+  }
+  return query;
+}
+
+void RunSQLBuilder(benchmark::State& state, const std::string& query) {
+  SampleCatalog catalog;
+  AnalyzerOptions options;
+  std::unique_ptr<const AnalyzerOutput> output;
+  ZETASQL_CHECK_OK(AnalyzeStatement(query, options, catalog.catalog(),
+                            catalog.type_factory(), &output));
+  size_t bytes = 0;
+  for (auto s : state) {
+    SQLBuilder builder;
+    ZETASQL_CHECK_OK(builder.Process(*output->resolved_statement()));
+    std::string sql = builder.sql();
+    bytes = sql.size();
+    benchmark::DoNotOptimize(sql);
+  }
+  state.counters["bytes"] = static_cast<double>(bytes);
+}
+
+void BM_SQLBuilderWideQuery(benchmark::State& state) {
+  RunSQLBuilder(state, MakeWideQuery(state.range(0)));
+}
+BENCHMARK(BM_SQLBuilderWideQuery)->Range(8, 512);
+
+void BM_SQLBuilderDeepQuery(benchmark::State& state) {
+  RunSQLBuilder(state, MakeDeepQuery(state.range(0)));
+}
+BENCHMARK(BM_SQLBuilderDeepQuery)->Range(8, 256);
+
+}  // namespace
+}  // namespace zetasql
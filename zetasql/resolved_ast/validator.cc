@@ -55,6 +55,7 @@
 #include "zetasql/public/value.h"
 #include "zetasql/resolved_ast/node_sources.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/resolved_ast_fingerprint.h"
 #include "zetasql/resolved_ast/resolved_column.h"
 #include "zetasql/resolved_ast/resolved_node_kind.pb.h"
 #include "zetasql/resolved_ast/rewrite_utils.h"
@@ -66,6 +67,7 @@
 #include "zetasql/base/check.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
@@ -102,6 +104,25 @@ namespace zetasql {
       "Out of stack space due to deeply nested query expression during query " \
       "validation")
 
+absl::Status ValidatedScans::Seal() {
+  ZETASQL_RET_CHECK(!sealed_);
+  sealed_ = true;
+  if (validated_root_ != nullptr && !recorded_scans_.empty()) {
+    absl::flat_hash_map<const ResolvedScan*, uint64_t> fingerprints;
+    ZETASQL_RETURN_IF_ERROR(
+        FingerprintResolvedAST(validated_root_, &fingerprints).status());
+    for (const auto& [scan, column_ids] : recorded_scans_) {
+      const uint64_t* fingerprint =
+          zetasql_base::FindOrNull(fingerprints, scan);
+      ZETASQL_RET_CHECK(fingerprint != nullptr);
+      scans_by_fingerprint_.emplace(*fingerprint, column_ids);
+    }
+  }
+  validated_root_ = nullptr;
+  recorded_scans_.clear();
+  return absl::OkStatus();
+}
+
 Validator::Validator(const LanguageOptions& language_options,
                      ValidatorOptions validator_options)
     : options_(validator_options), language_options_(language_options) {}
@@ -487,6 +508,7 @@ absl::Status Validator::ValidateFinalState() {
 absl::Status Validator::ValidateStandaloneResolvedExpr(
     const ResolvedExpr* expr) {
   Reset();
+  ZETASQL_RETURN_IF_ERROR(StartValidatedScans(expr));
   const absl::Status status =
       ValidateResolvedExpr({} /* visible_columns */,
                            {} /* visible_parameters */,
@@ -505,7 +527,9 @@ absl::Status Validator::ValidateStandaloneResolvedExpr(
                   {{error_context_, "(validation failed here)"}}, false});
   }
 
-  return ValidateFinalState();
+  ZETASQL_RETURN_IF_ERROR(ValidateFinalState());
+  FinishValidatedScans(expr);
+  return absl::OkStatus();
 }
 
 absl::Status Validator::ValidateResolvedExpr(
@@ -1420,6 +1444,7 @@ absl::Status Validator::AddColumnFromComputedColumn(
     ZETASQL_RETURN_IF_ERROR(CheckUniqueColumnId(side_effect_column));
     visible_columns->insert(side_effect_column);
     unconsumed_side_effect_columns_.insert(side_effect_column.column_id());
+    ++side_effect_column_count_;
   }
   return absl::OkStatus();
 }
@@ -2137,6 +2162,10 @@ absl::Status Validator::CheckUniqueColumnId(const ResolvedColumn& column) {
       zetasql_base::InsertIfNotPresent(&column_ids_seen_, column.column_id()))
       << "Duplicate column id " << column.column_id() << " in column "
       << column.DebugString();
+  if (options_.validated_scans != nullptr &&
+      !options_.validated_scans->sealed()) {
+    options_.validated_scans->column_ids_.push_back(column.column_id());
+  }
   return absl::OkStatus();
 }
 
@@ -2951,6 +2980,7 @@ absl::Status Validator::ValidateResolvedWithScan(
 absl::Status Validator::ValidateResolvedWithRefScan(
     const ResolvedWithRefScan* scan) {
   scan->MarkFieldsAccessed();
+  ++with_ref_scan_count_;
   // Make sure column ids are unique
   for (const ResolvedColumn& column : scan->column_list()) {
     ZETASQL_RETURN_IF_ERROR(CheckUniqueColumnId(column));
@@ -3041,13 +3071,68 @@ void Validator::Reset() {
   context_stack_.clear();
   error_context_ = nullptr;
   unconsumed_side_effect_columns_.clear();
+  with_ref_scan_count_ = 0;
+  side_effect_column_count_ = 0;
+  scan_fingerprints_.clear();
+}
+
+absl::Status Validator::StartValidatedScans(const ResolvedNode* root) {
+  ValidatedScans* validated_scans = options_.validated_scans;
+  if (validated_scans == nullptr) return absl::OkStatus();
+  if (!validated_scans->sealed()) {
+    validated_scans->validated_root_ = nullptr;
+    validated_scans->column_ids_.clear();
+    validated_scans->recorded_scans_.clear();
+  } else if (!validated_scans->scans_by_fingerprint_.empty()) {
+    ZETASQL_RETURN_IF_ERROR(
+        FingerprintResolvedAST(root, &scan_fingerprints_).status());
+  }
+  return absl::OkStatus();
+}
+
+void Validator::FinishValidatedScans(const ResolvedNode* root) {
+  ValidatedScans* validated_scans = options_.validated_scans;
+  if (validated_scans != nullptr && !validated_scans->sealed()) {
+    validated_scans->validated_root_ = root;
+  }
+}
+
+bool Validator::IsOutsideOfEnclosingContexts(
+    const std::set<ResolvedColumn>& visible_parameters) const {
+  return visible_parameters.empty() && nested_recursive_context_count_ == 0 &&
+         nested_recursive_scans_.empty() &&
+         !input_columns_for_group_rows_.has_value() &&
+         current_create_table_function_stmt_ == nullptr &&
+         allowed_argument_kinds_.empty();
+}
+
+absl::StatusOr<bool> Validator::SkipValidatedScan(const ResolvedScan* scan) {
+  const uint64_t* fingerprint =
+      zetasql_base::FindOrNull(scan_fingerprints_, scan);
+  if (fingerprint == nullptr) return false;
+  const ValidatedScans& validated_scans = *options_.validated_scans;
+  const ValidatedScans::ColumnIdRange* column_ids = zetasql_base::FindOrNull(
+      validated_scans.scans_by_fingerprint_, *fingerprint);
+  if (column_ids == nullptr) return false;
+  // The scan is still valid, but its columns must not clash with the columns
+  // of the rest of the tree.
+  for (int i = column_ids->begin; i < column_ids->end; ++i) {
+    const int column_id = validated_scans.column_ids_[i];
+    VALIDATOR_RET_CHECK(
+        zetasql_base::InsertIfNotPresent(&column_ids_seen_, column_id))
+        << "Duplicate column id " << column_id;
+  }
+  return true;
 }
 
 absl::Status Validator::ValidateResolvedStatement(
     const ResolvedStatement* statement) {
   Reset();
+  ZETASQL_RETURN_IF_ERROR(StartValidatedScans(statement));
   ZETASQL_RETURN_IF_ERROR(ValidateResolvedStatementInternal(statement));
-  return ValidateFinalState();
+  ZETASQL_RETURN_IF_ERROR(ValidateFinalState());
+  FinishValidatedScans(statement);
+  return absl::OkStatus();
 }
 
 absl::Status Validator::ValidateResolvedStatementInternal(
@@ -4688,6 +4773,20 @@ absl::Status Validator::ValidateResolvedScan(
   VALIDATOR_RET_CHECK(nullptr != scan);
   PushErrorContext push(this, scan);
 
+  // Scans that do not depend on enclosing nodes are skipped if an identical
+  // scan was validated before, and recorded otherwise.
+  ValidatedScans* validated_scans = options_.validated_scans;
+  const bool skip_or_record = validated_scans != nullptr &&
+                              IsOutsideOfEnclosingContexts(visible_parameters);
+  if (skip_or_record && validated_scans->sealed()) {
+    ZETASQL_ASSIGN_OR_RETURN(const bool skipped, SkipValidatedScan(scan));
+    if (skipped) return absl::OkStatus();
+  }
+  const int column_ids_begin =
+      validated_scans != nullptr ? validated_scans->column_ids_.size() : 0;
+  const int64_t with_ref_scan_count = with_ref_scan_count_;
+  const int64_t side_effect_column_count = side_effect_column_count_;
+
   // We assign the status in each switch branch and call ZETASQL_RETURN_IF_ERROR only
   // once. This is because ZETASQL_RETURN_IF_ERROR introduces temporary variables on
   // each call, which are not eliminated between the switch branches. This
@@ -4809,6 +4908,14 @@ absl::Status Validator::ValidateResolvedScan(
 
   ZETASQL_RETURN_IF_ERROR(ValidateHintList(scan->hint_list()));
 
+  if (skip_or_record && !validated_scans->sealed() &&
+      with_ref_scan_count == with_ref_scan_count_ &&
+      side_effect_column_count == side_effect_column_count_) {
+    validated_scans->recorded_scans_.emplace_back(
+        scan, ValidatedScans::ColumnIdRange{
+                  column_ids_begin,
+                  static_cast<int>(validated_scans->column_ids_.size())});
+  }
   return absl::OkStatus();
 }
 
@@ -17,6 +17,7 @@
 #ifndef ZETASQL_RESOLVED_AST_VALIDATOR_H_
 #define ZETASQL_RESOLVED_AST_VALIDATOR_H_
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <optional>
@@ -32,14 +33,59 @@
 #include "zetasql/resolved_ast/resolved_ast.h"
 #include "zetasql/resolved_ast/resolved_ast_enums.pb.h"
 #include "zetasql/resolved_ast/resolved_column.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
 #include "zetasql/base/status.h"
 #include "zetasql/base/status_builder.h"
 namespace zetasql {
 
+// The scans that one Validator found valid, so that a later Validator can skip
+// the scans of another tree that are structurally identical to them, such as
+// the parts of a statement that rewriters left unchanged.
+//
+// Only scans that are valid wherever they appear are recorded: those that do
+// not reference columns, WITH queries, recursive queries or function arguments
+// of enclosing nodes. Both Validators must use the same LanguageOptions and
+// ValidatorOptions. See ValidatorOptions::validated_scans.
+class ValidatedScans {
+ public:
+  ValidatedScans() = default;
+  ValidatedScans(const ValidatedScans&) = delete;
+  ValidatedScans& operator=(const ValidatedScans&) = delete;
+
+  // Fingerprints the recorded scans, after which Validators use this object to
+  // skip scans rather than to record them. Must be called while the validated
+  // tree is still alive and unchanged, e.g. before the first rewriter runs. If
+  // the validation failed, nothing is skipped.
+  absl::Status Seal();
+
+  bool sealed() const { return sealed_; }
+
+ private:
+  friend class Validator;
+
+  // A range of 'column_ids_'.
+  struct ColumnIdRange {
+    int begin;
+    int end;
+  };
+
+  // The tree that was validated successfully, or NULL.
+  const ResolvedNode* validated_root_ = nullptr;
+  // The ids of the columns defined in the validated tree, in validation order,
+  // so that the ids defined in a scan are a contiguous range.
+  std::vector<int> column_ids_;
+  // The recorded scans, until Seal() is called.
+  std::vector<std::pair<const ResolvedScan*, ColumnIdRange>> recorded_scans_;
+  // The ids of the columns defined in the recorded scans, by their fingerprint.
+  absl::flat_hash_map<uint64_t, ColumnIdRange> scans_by_fingerprint_;
+  bool sealed_ = false;
+};
+
 // Options to disable certain validations. Options are used to retroactively
 // add validations of invariants even if some client code still needs to be
 // cleaned up. A non-default ValidatorOptions in client code signals a cleanup
@@ -55,6 +101,11 @@ struct ValidatorOptions {
   // are checked.
   // TODO: Add validation for non anonymization options and hints.
   AllowedHintsAndOptions allowed_hints_and_options;
+
+  // If non-NULL, and not sealed yet, the Validator records the scans it finds
+  // valid in <validated_scans>. If sealed, the Validator skips the scans that
+  // are identical to one of those, and only validates the rest of the tree.
+  ValidatedScans* validated_scans = nullptr;
 };
 
 // Used to validate generated Resolved AST structures.
@@ -79,6 +130,22 @@ class Validator {
   // ValidateStandaloneExpr().
   absl::Status ValidateFinalState();
 
+  // Called at the start and at the successful end of each entry point, to
+  // prepare and to complete ValidatorOptions::validated_scans.
+  absl::Status StartValidatedScans(const ResolvedNode* root);
+  void FinishValidatedScans(const ResolvedNode* root);
+
+  // Returns true if scans validated with <visible_parameters> in the current
+  // state do not depend on any enclosing node, other than for the uniqueness
+  // of column ids.
+  bool IsOutsideOfEnclosingContexts(
+      const std::set<ResolvedColumn>& visible_parameters) const;
+
+  // Returns true if <scan> is identical to one in the sealed
+  // ValidatorOptions::validated_scans, after checking that its column ids are
+  // unique.
+  absl::StatusOr<bool> SkipValidatedScan(const ResolvedScan* scan);
+
   // Statements.
   absl::Status ValidateResolvedStatementInternal(
       const ResolvedStatement* statement);
@@ -824,6 +891,17 @@ class Validator {
   // empty.
   absl::flat_hash_set<int> unconsumed_side_effect_columns_;
 
+  // The number of ResolvedWithRefScans and side effect columns seen so far.
+  // Scans that contain either are not recorded in
+  // ValidatorOptions::validated_scans, since their validity depends on the
+  // nodes around them.
+  int64_t with_ref_scan_count_ = 0;
+  int64_t side_effect_column_count_ = 0;
+
+  // The fingerprints of the scans in the tree being validated, if
+  // ValidatorOptions::validated_scans is sealed.
+  absl::flat_hash_map<const ResolvedScan*, uint64_t> scan_fingerprints_;
+
   // The node at the top of the stack is the innermost node being validated.
   std::vector<const ResolvedNode*> context_stack_;
 
@@ -1883,6 +1883,89 @@ TEST(ValidateTest, ErrorWhenSideEffectColumnIsNotConsumed) {
                         HasSubstr("unconsumed_side_effect_columns_.empty()")));
 }
 
+// Returns a SELECT of <value> as <column> from <input_scan>.
+ResolvedProjectScanBuilder MakeProjectScan(
+    const ResolvedColumn& column, int64_t value,
+    std::unique_ptr<const ResolvedScan> input_scan) {
+  return ResolvedProjectScanBuilder()
+      .add_column_list(column)
+      .add_expr_list(ResolvedComputedColumnBuilder()
+                         .set_column(column)
+                         .set_expr(ResolvedLiteralBuilder()
+                                       .set_value(Value::Int64(value))
+                                       .set_type(types::Int64Type())))
+      .set_input_scan(std::move(input_scan));
+}
+
+TEST(ValidateTest, ValidatedScansStillCheckUniqueColumnIds) {
+  IdStringPool pool;
+  ResolvedColumn column_x(/*column_id=*/1, pool.Make("t"), pool.Make("x"),
+                          types::Int64Type());
+  ResolvedColumn column_y(/*column_id=*/2, pool.Make("t"), pool.Make("y"),
+                          types::Int64Type());
+  auto make_query = [&](const ResolvedColumn& column,
+                        std::unique_ptr<const ResolvedScan> scan) {
+    return ResolvedQueryStmtBuilder()
+        .add_output_column_list(
+            ResolvedOutputColumnBuilder().set_column(column).set_name("c"))
+        .set_query(std::move(scan))
+        .Build();
+  };
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto validated,
+      make_query(column_x,
+                 MakeProjectScan(column_x, 1, MakeResolvedSingleRowScan())
+                     .Build()
+                     .value()));
+
+  ValidatedScans validated_scans;
+  ValidatorOptions validator_options;
+  validator_options.validated_scans = &validated_scans;
+  ZETASQL_ASSERT_OK(Validator(LanguageOptions(), validator_options)
+                .ValidateResolvedStatement(validated.get()));
+  ZETASQL_ASSERT_OK(validated_scans.Seal());
+  EXPECT_TRUE(validated_scans.sealed());
+
+  // An identical copy of the validated scan is skipped.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto unchanged,
+      make_query(column_x,
+                 MakeProjectScan(column_x, 1, MakeResolvedSingleRowScan())
+                     .Build()
+                     .value()));
+  ZETASQL_EXPECT_OK(Validator(LanguageOptions(), validator_options)
+                .ValidateResolvedStatement(unchanged.get()));
+
+  // A new scan on top of it is validated, including against the columns of
+  // the skipped scan.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto rewritten,
+      make_query(column_y,
+                 MakeProjectScan(column_y, 2,
+                                 MakeProjectScan(column_x, 1,
+                                                 MakeResolvedSingleRowScan())
+                                     .Build()
+                                     .value())
+                     .Build()
+                     .value()));
+  ZETASQL_EXPECT_OK(Validator(LanguageOptions(), validator_options)
+                .ValidateResolvedStatement(rewritten.get()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto duplicate_column,
+      make_query(column_x,
+                 MakeProjectScan(column_x, 2,
+                                 MakeProjectScan(column_x, 1,
+                                                 MakeResolvedSingleRowScan())
+                                     .Build()
+                                     .value())
+                     .Build()
+                     .value()));
+  EXPECT_THAT(Validator(LanguageOptions(), validator_options)
+                  .ValidateResolvedStatement(duplicate_column.get()),
+              StatusIs(absl::StatusCode::kInternal,
+                       HasSubstr("Duplicate column id 1")));
+}
+
 }  // namespace
 }  // namespace testing
 }  // namespace zetasql
@@ -22,6 +22,8 @@
 #include "zetasql/parser/parser.h"
 #include "zetasql/scripting/error_helpers.h"
 #include "zetasql/scripting/script_executor_impl.h"
+#include "zetasql/scripting/script_executor_state.pb.h"
+#include "zetasql/scripting/serialization_helpers.h"
 #include "absl/status/statusor.h"
 #include "zetasql/base/status.h"
 
@@ -72,6 +74,20 @@ absl::StatusOr<std::unique_ptr<ScriptExecutor>> ScriptExecutor::CreateFromAST(
                                     statement_evaluator);
 }
 
+absl::StatusOr<ScriptExecutorStateDeltaProto> ScriptExecutor::GetStateDelta(
+    const ScriptExecutorStateProto& base) const {
+  ZETASQL_ASSIGN_OR_RETURN(ScriptExecutorStateProto state, GetState());
+  return ComputeScriptExecutorStateDelta(base, state);
+}
+
+absl::Status ScriptExecutor::SetStateFromDelta(
+    const ScriptExecutorStateProto& base,
+    const ScriptExecutorStateDeltaProto& delta) {
+  ZETASQL_ASSIGN_OR_RETURN(ScriptExecutorStateProto state,
+                   ApplyScriptExecutorStateDelta(base, delta));
+  return SetState(state);
+}
+
 absl::Status StatementEvaluator::AssignSystemVariable(
     ScriptExecutor* executor, const ASTSystemVariableAssignment* ast_assignment,
     const Value& value) {
@@ -322,6 +322,21 @@ class ScriptExecutor {
   // stack. See ScriptExecutorStateProto definition for detail.
   virtual absl::Status SetState(const ScriptExecutorStateProto& state) = 0;
 
+  // Gets the changes of the state of the currently executing script since
+  // <base>, a state previously returned by GetState(). Only variables that were
+  // added, changed or removed are included, and procedure definitions that
+  // <base> already contains are referenced by fingerprint, so that the size of
+  // a delta is proportional to what changed since <base>. See
+  // ScriptExecutorStateDeltaProto for detail.
+  virtual absl::StatusOr<ScriptExecutorStateDeltaProto> GetStateDelta(
+      const ScriptExecutorStateProto& base) const;
+
+  // Sets the state of the currently executing script to <base> with <delta>
+  // applied. <delta> must have been returned by GetStateDelta() for <base>.
+  virtual absl::Status SetStateFromDelta(
+      const ScriptExecutorStateProto& base,
+      const ScriptExecutorStateDeltaProto& delta);
+
   // Get the predefined variables that were created before script run and exist
   // outside of the script scope.
   virtual VariableSet GetPredefinedVariableNames() const = 0;
@@ -0,0 +1,159 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/scripting/script_executor.h"
+
+#include <algorithm>
+#include <memory>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/common/testing/proto_matchers.h"
+#include "zetasql/public/analyzer_options.h"
+#include "zetasql/public/builtin_function_options.h"
+#include "zetasql/public/evaluator.h"
+#include "zetasql/public/id_string.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/types/type_factory.h"
+#include "zetasql/public/value.h"
+#include "zetasql/reference_impl/statement_evaluator.h"
+#include "zetasql/scripting/script_executor_state.pb.h"
+#include "zetasql/scripting/variable.pb.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+
+namespace zetasql {
+namespace {
+
+using ::testing::HasSubstr;
+using ::zetasql::testing::EqualsProto;
+using ::zetasql_base::testing::StatusIs;
+
+constexpr absl::string_view kScript =
+    "DECLARE x INT64 DEFAULT 1;\n"
+    "DECLARE s STRING DEFAULT 'abc';\n"
+    "SET x = x + 1;\n"
+    "DECLARE y ARRAY<INT64> DEFAULT [1, 2, 3];\n"
+    "SET s = CONCAT(s, 'd');\n"
+    "SET x = x * 10;\n";
+
+// The variables of a stack frame are serialized in no particular order, so
+// sort them by name before comparing two states.
+ScriptExecutorStateProto SortVariables(ScriptExecutorStateProto state) {
+  for (ScriptExecutorStateProto::StackFrame& frame :
+       *state.mutable_callstack()) {
+    std::sort(frame.mutable_variables()->begin(),
+              frame.mutable_variables()->end(),
+              [](const Variable& a, const Variable& b) {
+                return a.name() < b.name();
+              });
+  }
+  return state;
+}
+
+class ScriptExecutorStateDeltaTest : public ::testing::Test {
+ protected:
+  ScriptExecutorStateDeltaTest() : catalog_("catalog", &type_factory_) {
+    catalog_.AddBuiltinFunctions(
+        BuiltinFunctionOptions::AllReleasedFunctions());
+    evaluator_options_.type_factory = &type_factory_;
+    evaluator_ = std::make_unique<StatementEvaluatorImpl>(
+        analyzer_options_, evaluator_options_, ParameterValueMap(),
+        &type_factory_, &catalog_, &callback_);
+  }
+
+  std::unique_ptr<ScriptExecutor> CreateExecutor() {
+    ScriptExecutorOptions options;
+    options.PopulateFromAnalyzerOptions(analyzer_options_);
+    return ScriptExecutor::Create(kScript, options, evaluator_.get()).value();
+  }
+
+  static void ExecuteStatements(ScriptExecutor* executor, int count) {
+    for (int i = 0; i < count; ++i) {
+      ZETASQL_ASSERT_OK(executor->ExecuteNext());
+    }
+  }
+
+  TypeFactory type_factory_;
+  SimpleCatalog catalog_;
+  AnalyzerOptions analyzer_options_;
+  EvaluatorOptions evaluator_options_;
+  StatementEvaluatorCallback callback_{/*bytes_per_iterator=*/0};
+  std::unique_ptr<StatementEvaluatorImpl> evaluator_;
+};
+
+TEST_F(ScriptExecutorStateDeltaTest, RoundTrip) {
+  std::unique_ptr<ScriptExecutor> executor = CreateExecutor();
+  ExecuteStatements(executor.get(), 2);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(ScriptExecutorStateProto base, executor->GetState());
+
+  // Changes 'x' and 's' and declares 'y'.
+  ExecuteStatements(executor.get(), 3);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(ScriptExecutorStateDeltaProto delta,
+                       executor->GetStateDelta(base));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(ScriptExecutorStateProto full, executor->GetState());
+  ASSERT_EQ(delta.callstack_size(), 1);
+  EXPECT_EQ(delta.callstack(0).changed_variables_size(), 3);
+  EXPECT_EQ(delta.callstack(0).removed_variable_names_size(), 0);
+
+  std::unique_ptr<ScriptExecutor> restored = CreateExecutor();
+  ZETASQL_ASSERT_OK(restored->SetStateFromDelta(base, delta));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(ScriptExecutorStateProto restored_state,
+                       restored->GetState());
+  EXPECT_THAT(SortVariables(restored_state), EqualsProto(SortVariables(full)));
+
+  // Both executors carry on from the same statement.
+  ExecuteStatements(executor.get(), 1);
+  ExecuteStatements(restored.get(), 1);
+  ASSERT_TRUE(executor->IsComplete());
+  ASSERT_TRUE(restored->IsComplete());
+  EXPECT_EQ(restored->GetCurrentVariables().at(IdString::MakeGlobal("x")),
+            Value::Int64(20));
+  EXPECT_EQ(restored->GetCurrentVariables().at(IdString::MakeGlobal("s")),
+            Value::String("abcd"));
+}
+
+TEST_F(ScriptExecutorStateDeltaTest, UnchangedStateHasNoChangedVariables) {
+  std::unique_ptr<ScriptExecutor> executor = CreateExecutor();
+  ExecuteStatements(executor.get(), 2);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(ScriptExecutorStateProto base, executor->GetState());
+  ZETASQL_ASSERT_OK_AND_ASSIGN(ScriptExecutorStateDeltaProto delta,
+                       executor->GetStateDelta(base));
+  ASSERT_EQ(delta.callstack_size(), 1);
+  EXPECT_EQ(delta.callstack(0).changed_variables_size(), 0);
+  EXPECT_EQ(delta.callstack(0).removed_variable_names_size(), 0);
+}
+
+TEST_F(ScriptExecutorStateDeltaTest, MismatchedBaseState) {
+  std::unique_ptr<ScriptExecutor> executor = CreateExecutor();
+  ExecuteStatements(executor.get(), 2);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(ScriptExecutorStateProto base, executor->GetState());
+  ExecuteStatements(executor.get(), 3);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(ScriptExecutorStateDeltaProto delta,
+                       executor->GetStateDelta(base));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(ScriptExecutorStateProto other_base,
+                       CreateExecutor()->GetState());
+
+  std::unique_ptr<ScriptExecutor> restored = CreateExecutor();
+  EXPECT_THAT(
+      restored->SetStateFromDelta(other_base, delta),
+      StatusIs(absl::StatusCode::kInternal,
+               HasSubstr("not computed from the given base state")));
+}
+
+}  // namespace
+}  // namespace zetasql
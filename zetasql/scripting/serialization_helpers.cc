@@ -24,7 +24,13 @@
 #include <vector>
 
 #include "zetasql/scripting/procedure_extension.pb.h"
+#include "zetasql/scripting/script_executor_state.pb.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "farmhash.h"
+#include "google/protobuf/util/message_differencer.h"
 
 namespace zetasql {
 
@@ -189,4 +195,136 @@ absl::Status DeserializeParametersProto(
   return absl::OkStatus();
 }
 
+namespace {
+using StackFrameProto = ScriptExecutorStateProto::StackFrame;
+using StackFrameDeltaProto = ScriptExecutorStateDeltaProto::StackFrameDelta;
+using ProcedureDefinitionProto = ScriptExecutorStateProto::ProcedureDefinition;
+
+uint64_t FingerprintProto(const google::protobuf::Message& proto) {
+  return farmhash::Fingerprint64(proto.SerializeAsString());
+}
+
+// Variable names are case-insensitive.
+absl::flat_hash_map<std::string, const VariableProto*> GetVariablesByName(
+    const google::protobuf::RepeatedPtrField<VariableProto>& variables) {
+  absl::flat_hash_map<std::string, const VariableProto*> variables_by_name;
+  for (const VariableProto& variable : variables) {
+    variables_by_name.emplace(absl::AsciiStrToLower(variable.name()),
+                              &variable);
+  }
+  return variables_by_name;
+}
+}  // namespace
+
+absl::StatusOr<ScriptExecutorStateDeltaProto> ComputeScriptExecutorStateDelta(
+    const ScriptExecutorStateProto& base,
+    const ScriptExecutorStateProto& state) {
+  ScriptExecutorStateDeltaProto delta;
+  delta.set_base_fingerprint(FingerprintProto(base));
+  delta.set_state_byte_size(state.ByteSizeLong());
+  *delta.mutable_state() = state;
+  delta.mutable_state()->clear_callstack();
+
+  absl::flat_hash_set<uint64_t> base_procedure_fingerprints;
+  for (const StackFrameProto& frame : base.callstack()) {
+    if (frame.has_procedure_definition()) {
+      base_procedure_fingerprints.insert(
+          FingerprintProto(frame.procedure_definition()));
+    }
+  }
+  for (int i = 0; i < state.callstack_size(); ++i) {
+    const StackFrameProto& frame = state.callstack(i);
+    StackFrameDeltaProto* frame_delta = delta.add_callstack();
+    if (frame.has_procedure_definition()) {
+      const uint64_t fingerprint =
+          FingerprintProto(frame.procedure_definition());
+      frame_delta->set_procedure_definition_fingerprint(fingerprint);
+      if (!base_procedure_fingerprints.contains(fingerprint)) {
+        *frame_delta->mutable_procedure_definition() =
+            frame.procedure_definition();
+      }
+    }
+
+    absl::flat_hash_map<std::string, const VariableProto*> base_variables;
+    if (i < base.callstack_size()) {
+      base_variables = GetVariablesByName(base.callstack(i).variables());
+    }
+    for (const VariableProto& variable : frame.variables()) {
+      auto it = base_variables.find(absl::AsciiStrToLower(variable.name()));
+      if (it == base_variables.end() ||
+          !google::protobuf::util::MessageDifferencer::Equals(*it->second,
+                                                    variable)) {
+        *frame_delta->add_changed_variables() = variable;
+      }
+    }
+    if (i < base.callstack_size()) {
+      const absl::flat_hash_map<std::string, const VariableProto*> variables =
+          GetVariablesByName(frame.variables());
+      for (const VariableProto& variable : base.callstack(i).variables()) {
+        if (!variables.contains(absl::AsciiStrToLower(variable.name()))) {
+          frame_delta->add_removed_variable_names(variable.name());
+        }
+      }
+    }
+
+    *frame_delta->mutable_frame() = frame;
+    frame_delta->mutable_frame()->clear_procedure_definition();
+    frame_delta->mutable_frame()->clear_variables();
+  }
+  return delta;
+}
+
+absl::StatusOr<ScriptExecutorStateProto> ApplyScriptExecutorStateDelta(
+    const ScriptExecutorStateProto& base,
+    const ScriptExecutorStateDeltaProto& delta) {
+  ZETASQL_RET_CHECK_EQ(delta.base_fingerprint(), FingerprintProto(base))
+      << "State delta was not computed from the given base state";
+  absl::flat_hash_map<uint64_t, const ProcedureDefinitionProto*>
+      base_procedures;
+  for (const StackFrameProto& frame : base.callstack()) {
+    if (frame.has_procedure_definition()) {
+      base_procedures.emplace(FingerprintProto(frame.procedure_definition()),
+                              &frame.procedure_definition());
+    }
+  }
+
+  ScriptExecutorStateProto state = delta.state();
+  for (int i = 0; i < delta.callstack_size(); ++i) {
+    const StackFrameDeltaProto& frame_delta = delta.callstack(i);
+    StackFrameProto* frame = state.add_callstack();
+    *frame = frame_delta.frame();
+    if (frame_delta.has_procedure_definition()) {
+      *frame->mutable_procedure_definition() =
+          frame_delta.procedure_definition();
+    } else if (frame_delta.has_procedure_definition_fingerprint()) {
+      auto it =
+          base_procedures.find(frame_delta.procedure_definition_fingerprint());
+      ZETASQL_RET_CHECK(it != base_procedures.end())
+          << "Procedure definition of stack frame " << i
+          << " not found in the base state";
+      *frame->mutable_procedure_definition() = *it->second;
+    }
+
+    if (i < base.callstack_size()) {
+      absl::flat_hash_set<std::string> replaced_variables;
+      for (const std::string& name : frame_delta.removed_variable_names()) {
+        replaced_variables.insert(absl::AsciiStrToLower(name));
+      }
+      for (const VariableProto& variable : frame_delta.changed_variables()) {
+        replaced_variables.insert(absl::AsciiStrToLower(variable.name()));
+      }
+      for (const VariableProto& variable : base.callstack(i).variables()) {
+        if (!replaced_variables.contains(
+                absl::AsciiStrToLower(variable.name()))) {
+          *frame->add_variables() = variable;
+        }
+      }
+    }
+    for (const VariableProto& variable : frame_delta.changed_variables()) {
+      *frame->add_variables() = variable;
+    }
+  }
+  return state;
+}
+
 }  // namespace zetasql
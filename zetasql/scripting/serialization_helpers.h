@@ -67,6 +67,17 @@ absl::Status DeserializeParametersProto(
     google::protobuf::DescriptorPool* descriptor_pool, IdStringPool* id_string_pool,
     TypeFactory* type_factory);
 
+// Returns the changes of <state> relative to <base>.
+absl::StatusOr<ScriptExecutorStateDeltaProto> ComputeScriptExecutorStateDelta(
+    const ScriptExecutorStateProto& base,
+    const ScriptExecutorStateProto& state);
+
+// Returns <base> with <delta> applied. Returns an error if <delta> was not
+// computed from <base>.
+absl::StatusOr<ScriptExecutorStateProto> ApplyScriptExecutorStateDelta(
+    const ScriptExecutorStateProto& base,
+    const ScriptExecutorStateDeltaProto& delta);
+
 }  // namespace zetasql
 
 #endif  // ZETASQL_SCRIPTING_SERIALIZATION_HELPERS_H_
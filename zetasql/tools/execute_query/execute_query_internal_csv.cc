@@ -25,8 +25,10 @@
 
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "zetasql/public/evaluator_table_iterator.h"
 #include "zetasql/public/simple_catalog.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/value.h"
@@ -35,47 +37,114 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "riegeli/bytes/fd_reader.h"
 #include "riegeli/csv/csv_reader.h"
 #include "zetasql/base/status_macros.h"
 
 namespace zetasql {
+namespace {
+
+// Reads the rows of a CSV file one at a time, so that scanning a table never
+// holds more than one row in memory. Only the fields of the scanned columns
+// are converted to Values.
+class CsvEvaluatorTableIterator : public EvaluatorTableIterator {
+ public:
+  CsvEvaluatorTableIterator(absl::string_view path,
+                            std::shared_ptr<const std::vector<std::string>>
+                                column_names,
+                            absl::Span<const int> columns)
+      : path_(path),
+        csv_reader_(riegeli::FdReader(path_)),
+        column_names_(std::move(column_names)),
+        columns_(columns.begin(), columns.end()),
+        values_(columns.size()) {}
+
+  int NumColumns() const override { return static_cast<int>(columns_.size()); }
+  std::string GetColumnName(int i) const override {
+    return (*column_names_)[columns_[i]];
+  }
+  const Type* GetColumnType(int i) const override {
+    return types::StringType();
+  }
+  const Value& GetValue(int i) const override { return values_[i]; }
+  absl::Status Status() const override { return status_; }
+  absl::Status Cancel() override {
+    status_ = absl::CancelledError("CSV table scan was cancelled");
+    return absl::OkStatus();
+  }
+
+  bool NextRow() override {
+    if (!status_.ok() || done_) return false;
+    if (!header_read_) {
+      header_read_ = true;
+      if (!csv_reader_.ReadRecord(record_)) return Finish();
+    }
+    if (!csv_reader_.ReadRecord(record_)) return Finish();
+    if (record_.size() != column_names_->size()) {
+      status_ = zetasql_base::UnknownErrorBuilder()
+                << "CSV file " << path_ << " has a header row with "
+                << column_names_->size() << " columns, but row "
+                << csv_reader_.last_record_index() << " has " << record_.size()
+                << " fields";
+      return false;
+    }
+    for (int i = 0; i < columns_.size(); ++i) {
+      values_[i] = Value::String(std::move(record_[columns_[i]]));
+    }
+    return true;
+  }
+
+ private:
+  bool Finish() {
+    done_ = true;
+    if (!csv_reader_.Close()) status_ = csv_reader_.status();
+    return false;
+  }
+
+  const std::string path_;
+  riegeli::CsvReader<riegeli::FdReader<>> csv_reader_;
+  const std::shared_ptr<const std::vector<std::string>> column_names_;
+  const std::vector<int> columns_;
+  std::vector<std::string> record_;
+  std::vector<Value> values_;
+  absl::Status status_;
+  bool header_read_ = false;
+  bool done_ = false;
+};
+
+}  // namespace
 
 absl::StatusOr<std::unique_ptr<SimpleTable>> MakeTableFromCsvFile(
     absl::string_view table_name, absl::string_view path) {
+  // Only the header row is read here. The rows are read by each scan of the
+  // table, see CsvEvaluatorTableIterator.
   riegeli::CsvReader csv_reader{riegeli::FdReader(path)};
-
   std::vector<std::string> record;
   if (!csv_reader.ReadRecord(record)) {
     if (!csv_reader.ok()) return csv_reader.status();
     return zetasql_base::UnknownErrorBuilder()
            << "CSV file " << path << " does not contain a header row";
   }
+  if (!csv_reader.Close()) return csv_reader.status();
+
   std::vector<SimpleTable::NameAndType> columns;
   columns.reserve(record.size());
   for (const std::string& column_name : record) {
     columns.emplace_back(column_name, types::StringType());
   }
-
-  std::vector<std::vector<Value>> contents;
-  while (csv_reader.ReadRecord(record)) {
-    if (record.size() != columns.size()) {
-      return zetasql_base::UnknownErrorBuilder()
-             << "CSV file " << path << " has a header row with "
-             << columns.size() << " columns, but row "
-             << csv_reader.last_record_index() << " has " << record.size()
-             << " fields";
-    }
-    std::vector<Value>& row = contents.emplace_back();
-    row.reserve(record.size());
-    for (const std::string& field : record) {
-      row.push_back(Value::String(field));
-    }
-  }
-  if (!csv_reader.Close()) return csv_reader.status();
+  auto column_names =
+      std::make_shared<const std::vector<std::string>>(std::move(record));
 
   auto table = std::make_unique<SimpleTable>(table_name, columns);
-  table->SetContents(contents);
+  // Make a copy, because we cannot trust the lifetime of `path`.
+  std::string string_path = std::string(path);
+  table->SetEvaluatorTableIteratorFactory(
+      [string_path, column_names](absl::Span<const int> columns)
+          -> absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>> {
+        return std::make_unique<CsvEvaluatorTableIterator>(
+            string_path, column_names, columns);
+      });
   return table;
 }
 
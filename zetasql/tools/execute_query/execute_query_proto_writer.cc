@@ -34,6 +34,7 @@
 #include "zetasql/resolved_ast/resolved_node.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
+#include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
 #include "zetasql/base/status_macros.h"
 
@@ -50,12 +51,9 @@ ExecuteQueryStreamProtobufWriter::ExecuteQueryStreamProtobufWriter(
   }
 }
 
-absl::Status ExecuteQueryStreamProtobufWriter::executed(
-    const ResolvedNode& ast, std::unique_ptr<EvaluatorTableIterator> iter) {
-  // Use a new pool every time to not retain the generated proto descriptors
-  google::protobuf::DescriptorPool pool{parent_descriptor_pool_};
-  pool.AllowUnknownDependencies();
-
+// Sets the options for the descriptors of the protos generated for the query
+// results.
+static IteratorProtoDescriptorOptions MakeIteratorProtoDescriptorOptions() {
   IteratorProtoDescriptorOptions options;
 
   options.filename = "<generated>";
@@ -70,9 +68,18 @@ absl::Status ExecuteQueryStreamProtobufWriter::executed(
     cttpo.sql_table_options.allow_anonymous_field_name = true;
     cttpo.sql_table_options.allow_duplicate_field_names = true;
   }
+  return options;
+}
 
-  ZETASQL_ASSIGN_OR_RETURN(const IteratorProtoDescriptors descriptors,
-                   ConvertIteratorToProto(*iter, options, pool));
+absl::Status ExecuteQueryStreamProtobufWriter::executed(
+    const ResolvedNode& ast, std::unique_ptr<EvaluatorTableIterator> iter) {
+  // Use a new pool every time to not retain the generated proto descriptors
+  google::protobuf::DescriptorPool pool{parent_descriptor_pool_};
+  pool.AllowUnknownDependencies();
+
+  ZETASQL_ASSIGN_OR_RETURN(
+      const IteratorProtoDescriptors descriptors,
+      ConvertIteratorToProto(*iter, MakeIteratorProtoDescriptorOptions(), pool));
 
   google::protobuf::DynamicMessageFactory message_factory;
   message_factory.SetDelegateToGeneratedFactory(true);
@@ -84,6 +91,43 @@ absl::Status ExecuteQueryStreamProtobufWriter::executed(
   return proto_writer_func_(*msg);
 }
 
+ExecuteQueryStreamSerializedProtobufWriter::
+    ExecuteQueryStreamSerializedProtobufWriter(
+        const google::protobuf::DescriptorPool* parent_descriptor_pool,
+        std::ostream& stream)
+    : parent_descriptor_pool_{parent_descriptor_pool}, stream_{stream} {
+  if (!parent_descriptor_pool_) {
+    ABSL_LOG(WARNING) << "Parent descriptor pool is missing; encoding of "
+                    "non-primitive types may be incomplete";
+  }
+}
+
+absl::Status ExecuteQueryStreamSerializedProtobufWriter::executed(
+    const ResolvedNode& ast, std::unique_ptr<EvaluatorTableIterator> iter) {
+  // Use a new pool every time to not retain the generated proto descriptors
+  google::protobuf::DescriptorPool pool{parent_descriptor_pool_};
+  pool.AllowUnknownDependencies();
+
+  ZETASQL_ASSIGN_OR_RETURN(
+      const IteratorProtoDescriptors descriptors,
+      ConvertIteratorToProto(*iter, MakeIteratorProtoDescriptorOptions(), pool));
+
+  google::protobuf::DynamicMessageFactory message_factory;
+  message_factory.SetDelegateToGeneratedFactory(true);
+
+  {
+    google::protobuf::io::OstreamOutputStream zerocopy{&stream_};
+    google::protobuf::io::CodedOutputStream output{&zerocopy};
+    ZETASQL_RETURN_IF_ERROR(SerializeProtoFromIterator(*iter, *descriptors.table,
+                                               message_factory, output));
+  }
+  if (!stream_.good()) {
+    return absl::UnknownError("Writing serialized proto failed");
+  }
+
+  return absl::OkStatus();
+}
+
 absl::Status ExecuteQueryWriteTextproto(const google::protobuf::Message& msg,
                                         std::ostream& stream) {
   google::protobuf::io::OstreamOutputStream zerocopy{&stream};
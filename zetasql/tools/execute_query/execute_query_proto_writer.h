@@ -50,6 +50,27 @@ class ExecuteQueryStreamProtobufWriter : public ExecuteQueryWriter {
   std::function<absl::Status(const google::protobuf::Message& msg)> proto_writer_func_;
 };
 
+// Writes the query results in the wire format of the same "Table" message that
+// ExecuteQueryStreamProtobufWriter builds, streaming one row at a time instead
+// of building the message.
+class ExecuteQueryStreamSerializedProtobufWriter : public ExecuteQueryWriter {
+ public:
+  ExecuteQueryStreamSerializedProtobufWriter(
+      const google::protobuf::DescriptorPool* parent_descriptor_pool,
+      std::ostream& stream);
+  ExecuteQueryStreamSerializedProtobufWriter(
+      const ExecuteQueryStreamSerializedProtobufWriter&) = delete;
+  ExecuteQueryStreamSerializedProtobufWriter& operator=(
+      const ExecuteQueryStreamSerializedProtobufWriter&) = delete;
+
+  absl::Status executed(const ResolvedNode& ast,
+                        std::unique_ptr<EvaluatorTableIterator> iter) override;
+
+ private:
+  const google::protobuf::DescriptorPool* parent_descriptor_pool_;
+  std::ostream& stream_;
+};
+
 absl::Status ExecuteQueryWriteTextproto(const google::protobuf::Message& msg,
                                         std::ostream& stream);
 
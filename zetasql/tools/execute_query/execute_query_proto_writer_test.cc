@@ -123,6 +123,34 @@ TEST(ExecuteQueryStreamProtobufWriter, Executed) {
   }));
 }
 
+TEST(ExecuteQueryStreamSerializedProtobufWriter, Executed) {
+  const std::vector<SimpleTable::NameAndType> columns{
+      {"key", types::Int32Type()},
+      {"name", types::StringType()},
+  };
+  SimpleTable table{"DataTable", columns};
+  table.SetContents({
+      {values::Int32(1), values::String("test")},
+      {values::Int32(2), values::NullString()},
+  });
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       table.CreateEvaluatorTableIterator({0, 1}));
+
+  std::ostringstream stream;
+  ExecuteQueryStreamSerializedProtobufWriter writer{
+      google::protobuf::DescriptorPool::generated_pool(), stream};
+  ZETASQL_ASSERT_OK(writer.executed(*MakeResolvedLiteral(), std::move(iter)));
+
+  // The generated "Table" message has the same field numbers as IteratorProto.
+  IteratorProto got;
+  ASSERT_TRUE(got.ParseFromString(stream.str()));
+  EXPECT_THAT(got, EqualsProto(R"pb(
+                row { key: 1 name: "test" }
+                row { key: 2 }
+              )pb"));
+}
+
 TEST(ExecuteQueryWriteTextprotoTest, Basic) {
   const std::vector<SimpleTable::NameAndType> columns{
       {"key", types::Int32Type()},
@@ -136,8 +136,12 @@ ABSL_FLAG(
 ABSL_FLAG(std::string, output_mode, "box",
           "Format to use for query results. Available choices:"
           "\nbox - Tabular format for human consumption"
+          "\ncsv - Comma-separated values, streamed without buffering "
+          "the whole result"
           "\njson - JSON serialization"
-          "\ntextproto - Protocol buffer text format");
+          "\ntextproto - Protocol buffer text format"
+          "\nbinproto - Protocol buffer wire format, streamed without "
+          "buffering the whole result");
 
 ABSL_FLAG(std::string, sql_mode, "query",
           "How to interpret the input sql. Available choices:"
@@ -360,6 +364,16 @@ absl::StatusOr<std::unique_ptr<ExecuteQueryWriter>> MakeWriterFromFlags(
   if (mode == "box") {
     return std::make_unique<ExecuteQueryStreamWriter>(output);
   }
+  if (mode == "csv") {
+    return std::make_unique<ExecuteQueryCsvWriter>(output);
+  }
+
+  if (mode == "binproto") {
+    const google::protobuf::DescriptorPool* pool = config.descriptor_pool();
+    ZETASQL_RET_CHECK_NE(pool, nullptr);
+    return std::make_unique<ExecuteQueryStreamSerializedProtobufWriter>(pool,
+                                                                        output);
+  }
 
   std::function<absl::Status(const google::protobuf::Message& msg, std::ostream&)>
       proto_writer_func;
@@ -337,6 +337,16 @@ TEST(MakeWriterFromFlagsTest, Box) {
 )");
 }
 
+TEST(MakeWriterFromFlagsTest, Csv) {
+  std::ostringstream output;
+  RunWriter("csv", output);
+  EXPECT_EQ(output.str(), R"(key,name,tag
+0,,[]
+100,foo,"[aaa, zzz]"
+200,bar,[bbb]
+)");
+}
+
 TEST(MakeWriterFromFlagsTest, Json) {
   // ExecuteQueryWriteJson has better tests
   std::ostringstream output;
@@ -432,6 +442,23 @@ TEST(MakeTableFromCsvFile, Read) {
                              Value::String("867.5309")}});
 }
 
+TEST(MakeTableFromCsvFile, ReadPrunedColumnsTwice) {
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<const Table> table,
+                       MakeTableFromCsvFile("pruned", CsvFilePath()));
+  for (int scan = 0; scan < 2; ++scan) {
+    ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                         table->CreateEvaluatorTableIterator({2}));
+    ASSERT_EQ(iter->NumColumns(), 1);
+    EXPECT_EQ(iter->GetColumnName(0), "col3");
+    ASSERT_TRUE(iter->NextRow());
+    EXPECT_EQ(iter->GetValue(0), Value::String("123.456"));
+    ASSERT_TRUE(iter->NextRow());
+    EXPECT_EQ(iter->GetValue(0), Value::String("867.5309"));
+    EXPECT_FALSE(iter->NextRow());
+    ZETASQL_EXPECT_OK(iter->Status());
+  }
+}
+
 static std::string TextProtoFilePath() {
   return zetasql_base::JoinPath(TestDataDir(), "KitchenSinkPB.textproto");
 }
@@ -110,4 +110,37 @@ absl::Status ExecuteQueryStreamWriter::ExecutedExpression(
   return absl::OkStatus();
 }
 
+absl::Status ExecuteQueryCsvWriter::executed(
+    const ResolvedNode& ast, std::unique_ptr<EvaluatorTableIterator> iter) {
+  buffer_.clear();
+  buffer_.reserve(kBufferSize);
+  for (int i = 0; i < iter->NumColumns(); ++i) {
+    if (i > 0) buffer_.push_back(',');
+    AppendCsvField(iter->GetColumnName(i), &buffer_);
+  }
+  buffer_.push_back('\n');
+
+  while (iter->NextRow()) {
+    for (int i = 0; i < iter->NumColumns(); ++i) {
+      if (i > 0) buffer_.push_back(',');
+      AppendCsvField(iter->GetValue(i), &buffer_);
+    }
+    buffer_.push_back('\n');
+    if (buffer_.size() >= kBufferSize) {
+      ZETASQL_RETURN_IF_ERROR(Flush());
+    }
+  }
+  ZETASQL_RETURN_IF_ERROR(iter->Status());
+  return Flush();
+}
+
+absl::Status ExecuteQueryCsvWriter::Flush() {
+  stream().write(buffer_.data(), buffer_.size());
+  buffer_.clear();
+  if (!stream()) {
+    return absl::InternalError("Failed to write CSV output");
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace zetasql
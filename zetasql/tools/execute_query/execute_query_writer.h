@@ -17,9 +17,11 @@
 #ifndef ZETASQL_TOOLS_EXECUTE_QUERY_EXECUTE_QUERY_WRITER_H_
 #define ZETASQL_TOOLS_EXECUTE_QUERY_EXECUTE_QUERY_WRITER_H_
 
+#include <cstddef>
 #include <iosfwd>
 #include <memory>
 #include <ostream>
+#include <string>
 
 #include "zetasql/public/evaluator_table_iterator.h"
 #include "zetasql/resolved_ast/resolved_node.h"
@@ -94,10 +96,36 @@ class ExecuteQueryStreamWriter : public ExecuteQueryWriter {
     return absl::OkStatus();
   }
 
+  std::ostream& stream() { return stream_; }
+
  private:
   std::ostream& stream_;
 };
 
+// Writes query results to an output stream as CSV, with a header row of column
+// names and '\n' line endings. Unlike ExecuteQueryStreamWriter, rows are not
+// loaded into memory: each row is formatted into a reusable buffer as soon as
+// it is read, and the buffer is written out whenever it reaches kBufferSize
+// bytes. Everything other than query results is written as by
+// ExecuteQueryStreamWriter.
+class ExecuteQueryCsvWriter : public ExecuteQueryStreamWriter {
+ public:
+  static constexpr size_t kBufferSize = 1 << 20;
+
+  explicit ExecuteQueryCsvWriter(std::ostream& out)
+      : ExecuteQueryStreamWriter(out) {}
+  ExecuteQueryCsvWriter(const ExecuteQueryCsvWriter&) = delete;
+  ExecuteQueryCsvWriter& operator=(const ExecuteQueryCsvWriter&) = delete;
+
+  absl::Status executed(const ResolvedNode& ast,
+                        std::unique_ptr<EvaluatorTableIterator> iter) override;
+
+ private:
+  absl::Status Flush();
+
+  std::string buffer_;
+};
+
 }  // namespace zetasql
 
 #endif  // ZETASQL_TOOLS_EXECUTE_QUERY_EXECUTE_QUERY_WRITER_H_
@@ -92,4 +92,28 @@ TEST(ExecuteQueryStreamWriterTest, Executed) {
 )");
 }
 
+TEST(ExecuteQueryCsvWriterTest, Executed) {
+  SimpleCatalog catalog("simple_catalog");
+  TypeFactory type_factory;
+  std::unique_ptr<const AnalyzerOutput> analyzer_output;
+  ZETASQL_EXPECT_OK(AnalyzeStatement("SELECT 1", {}, &catalog, &type_factory,
+                             &analyzer_output));
+  SimpleTable test_table{
+      "TestTable", {{"id", types::Int64Type()}, {"a,b", types::StringType()}}};
+  test_table.SetContents({{values::Int64(1), values::String("plain")},
+                          {values::Int64(2), values::String("say \"hi\"")},
+                          {values::Int64(3), values::String("two\nlines")},
+                          {values::NullInt64(), values::NullString()}});
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       test_table.CreateEvaluatorTableIterator({0, 1}));
+  std::ostringstream output;
+  ZETASQL_EXPECT_OK(ExecuteQueryCsvWriter{output}.executed(
+      *analyzer_output->resolved_statement(), std::move(iter)));
+  EXPECT_EQ(output.str(), "id,\"a,b\"\n"
+                          "1,plain\n"
+                          "2,\"say \"\"hi\"\"\"\n"
+                          "3,\"two\nlines\"\n"
+                          ",\n");
+}
+
 }  // namespace zetasql
@@ -26,7 +26,9 @@
 #include "zetasql/public/strings.h"
 #include "zetasql/reference_impl/type_helpers.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/span.h"
 
 namespace zetasql {
@@ -418,4 +420,29 @@ std::string OutputPrettyStyleExpressionResult(const zetasql::Value& result,
   return output;
 }
 
+void AppendCsvField(absl::string_view field, std::string* out) {
+  if (field.find_first_of(",\"\r\n") == absl::string_view::npos) {
+    out->append(field);
+    return;
+  }
+  out->push_back('"');
+  for (const char c : field) {
+    if (c == '"') out->push_back('"');
+    out->push_back(c);
+  }
+  out->push_back('"');
+}
+
+void AppendCsvField(const zetasql::Value& value, std::string* out) {
+  if (value.is_null()) return;
+  // Avoid formatting the most common types into a temporary string.
+  if (value.type()->IsString()) {
+    AppendCsvField(value.string_value(), out);
+  } else if (value.type()->IsInt64()) {
+    absl::StrAppend(out, value.int64_value());
+  } else {
+    AppendCsvField(ValueToOutputString(value, /*escape_strings=*/false), out);
+  }
+}
+
 }  // namespace zetasql
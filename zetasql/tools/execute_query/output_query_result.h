@@ -23,6 +23,7 @@
 #include "zetasql/public/value.h"
 #include "zetasql/reference_impl/operator.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
+#include "absl/strings/string_view.h"
 
 namespace zetasql {
 
@@ -69,6 +70,15 @@ std::string OutputPrettyStyleQueryResult(
 std::string OutputPrettyStyleExpressionResult(const zetasql::Value& result,
                                               bool include_box = true);
 
+// Appends `field` to `out` as a CSV field, as specified by RFC 4180: fields
+// containing commas, double quotes or line breaks are enclosed in double
+// quotes, with double quotes escaped by doubling them.
+void AppendCsvField(absl::string_view field, std::string* out);
+
+// Appends `value` to `out` as a CSV field. Strings are written unescaped,
+// NULLs as empty fields, and other values as in OutputPrettyStyleQueryResult().
+void AppendCsvField(const zetasql::Value& value, std::string* out);
+
 }  // namespace zetasql
 
 #endif  // ZETASQL_TOOLS_EXECUTE_QUERY_OUTPUT_QUERY_RESULT_H_
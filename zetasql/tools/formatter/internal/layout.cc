@@ -17,6 +17,7 @@
 #include "zetasql/tools/formatter/internal/layout.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstddef>
 #include <deque>
@@ -25,6 +26,7 @@
 #include <ostream>
 #include <queue>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -216,6 +218,13 @@ StmtLayout::StmtLayout(const TokenizedStmt& parsed_sql,
   // Explicit cast is ok, because if we have more than 2^32 chunks,
   // nothing will work anyhow.
   lines_.insert(Line(0, static_cast<int>(chunks_.size())));
+  chunk_offsets_.reserve(chunks_.size() + 1);
+  chunk_offsets_.push_back(0);
+  for (const Chunk& chunk : chunks_) {
+    chunk_offsets_.push_back(chunk_offsets_.back() +
+                             (chunk.StartsWithSpace() ? 1 : 0) +
+                             chunk.PrintableLength(/*is_line_end=*/false));
+  }
 }
 
 bool StmtLayout::Empty() const { return chunks_.empty(); }
@@ -410,41 +419,43 @@ absl::Status StmtLayout::ValidateLine(int* start, int* end) const {
       absl::StrCat("Invalid line: ", absl::StrJoin(errors, "; ")));
 }
 
-int StmtLayout::PrintableLineLength(const Line& line) const {
-  int i = line.start;
-  int line_length = chunks_[i].ChunkBlock()->Level();
-  line_length += chunks_[i].PrintableLength(i + 1 == line.end);
-
-  while (++i < line.end) {
-    if (chunks_[i].StartsWithSpace()) {
-      line_length += 1;
-    }
-    line_length += chunks_[i].PrintableLength(i + 1 == line.end);
+int StmtLayout::LineLengthThroughChunk(const Line& line, int index) const {
+  const Chunk& first = chunks_[line.start];
+  // The first chunk of a line is indented instead of preceded by a space.
+  int line_length = first.ChunkBlock()->Level() + chunk_offsets_[index + 1] -
+                    chunk_offsets_[line.start] -
+                    (first.StartsWithSpace() ? 1 : 0);
+  if (index + 1 == line.end) {
+    // The last chunk may print differently at the end of the line, e.g., an
+    // end of line comment gets an extra space.
+    line_length += chunks_[index].PrintableLength(/*is_line_end=*/true) -
+                   chunks_[index].PrintableLength(/*is_line_end=*/false);
   }
-
   return line_length;
 }
 
+int StmtLayout::PrintableLineLength(const Line& line) const {
+  return LineLengthThroughChunk(line, line.end - 1);
+}
+
 int StmtLayout::FirstChunkEndingAfterColumn(const Line& line,
                                             int column) const {
-  // This function could be sped up and made O(1) if we use a pre-computed table
-  // of distances from the start. But one would need to be super careful when
-  // pre-computing because comments can include their own newline characters and
-  // could throw this computation off. For now, the current implementation
-  // formats 36MB (200k lines) of SQL in 26 seconds on a standard workstation,
-  // so optimization is not needed yet.
-  int i = line.start;
-  int line_length = chunks_[i].ChunkBlock()->Level();
-  line_length += chunks_[i].PrintableLength(i + 1 == line.end);
-
-  while (line_length <= column && ++i < line.end) {
-    if (chunks_[i].StartsWithSpace()) {
-      line_length += 1;
-    }
-    line_length += chunks_[i].PrintableLength(i + 1 == line.end);
-  }
-
-  return i;
+  // Lengths only grow along the line, so the chunks before the last one can
+  // be binary searched in `chunk_offsets_`: chunk i ends after `column` iff
+  // chunk_offsets_[i + 1] exceeds `threshold`.
+  const Chunk& first = chunks_[line.start];
+  const int threshold = column - first.ChunkBlock()->Level() +
+                        chunk_offsets_[line.start] +
+                        (first.StartsWithSpace() ? 1 : 0);
+  auto it = std::upper_bound(chunk_offsets_.begin() + line.start + 1,
+                             chunk_offsets_.begin() + line.end, threshold);
+  if (it != chunk_offsets_.begin() + line.end) {
+    return static_cast<int>(it - chunk_offsets_.begin()) - 1;
+  }
+  if (LineLengthThroughChunk(line, line.end - 1) > column) {
+    return line.end - 1;
+  }
+  return line.end;
 }
 
 bool StmtLayout::IsLineLengthOverLimit(const Line& line) const {
@@ -522,8 +533,33 @@ std::string FileLayout::PrintableString() const {
 }
 
 void FileLayout::BestLayout() {
-  for (const auto& layout : Parts()) {
-    layout->BestLayout();
+  const int num_parts = static_cast<int>(layout_parts_.size());
+  const int num_threads = std::min(options_.NumThreads(), num_parts);
+  if (num_threads <= 1) {
+    for (const auto& layout : Parts()) {
+      layout->BestLayout();
+    }
+    return;
+  }
+
+  // Each part is laid out independently of the others, and only reads the
+  // chunks of its own statement, so the parts can be handed out to threads.
+  std::atomic<int> next_part{0};
+  auto lay_out_parts = [&]() {
+    for (int part = next_part.fetch_add(1, std::memory_order_relaxed);
+         part < num_parts;
+         part = next_part.fetch_add(1, std::memory_order_relaxed)) {
+      layout_parts_[part]->BestLayout();
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  for (int i = 1; i < num_threads; ++i) {
+    threads.emplace_back(lay_out_parts);
+  }
+  lay_out_parts();
+  for (std::thread& thread : threads) {
+    thread.join();
   }
 }
 
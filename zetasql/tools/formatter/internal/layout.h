@@ -330,9 +330,18 @@ class StmtLayout : public Layout {
   // Transforms layout by removing line breaks that can be skipped.
   void PruneLineBreaks();
 
+  // Returns the printed length of `line` up to and including the chunk at
+  // `index`, which must be within the line.
+  int LineLengthThroughChunk(const Line& line, int index) const;
+
   const std::vector<Chunk>& chunks_;
   FormatterOptions options_;
 
+  // chunk_offsets_[i] is the printable length of chunks [0, i), each with its
+  // leading space and as if none of them ended a line. Line lengths are
+  // computed from it without walking the line.
+  std::vector<int> chunk_offsets_;
+
   LinesT lines_;
 };
 